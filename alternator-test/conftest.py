@@ -77,6 +77,19 @@ def dynamodb(request):
             region_name='us-east-1', aws_access_key_id='alternator', aws_secret_access_key='secret_pass',
             config=botocore.client.Config(retries={"max_attempts": 3}))
 
+# "dynamodbstreams" fixture: set up a client object for the DynamoDB Streams
+# API, which is served on the same endpoint as the DynamoDB API.
+@pytest.fixture(scope="session")
+def dynamodbstreams(request):
+    if request.config.getoption('aws'):
+        return boto3.client('dynamodbstreams')
+    else:
+        local_url = 'https://localhost:8043' if request.config.getoption('https') else 'http://localhost:8000'
+        verify = not request.config.getoption('https')
+        return boto3.client('dynamodbstreams', endpoint_url=local_url, verify=verify,
+            region_name='us-east-1', aws_access_key_id='alternator', aws_secret_access_key='secret_pass',
+            config=botocore.client.Config(retries={"max_attempts": 3}))
+
 # "test_table" fixture: Create and return a temporary table to be used in tests
 # that need a table to work on. The table is automatically deleted at the end.
 # We use scope="session" so that all tests will reuse the same client object.
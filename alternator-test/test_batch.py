@@ -305,3 +305,25 @@ def test_batch_get_item_projection_expression(test_table):
         got_items = reply['Responses'][test_table.name]
         expected_items = [{k: item[k] for k in wanted if k in item} for item in items]
         assert multiset(got_items) == multiset(expected_items)
+
+# Test BatchGetItem of several items of the same partition, some of them
+# missing, mixed with items of other partitions. Nothing failed to be
+# read, so UnprocessedKeys is empty.
+def test_batch_get_item_same_partition(test_table):
+    p = random_string()
+    items = [{'p': p, 'c': random_string(), 'val': random_string()} for i in range(5)]
+    items += [{'p': random_string(), 'c': random_string(), 'val': random_string()} for i in range(3)]
+    with test_table.batch_writer() as batch:
+        for item in items:
+            batch.put_item(item)
+    keys = [{k: x[k] for k in ('p', 'c')} for x in items]
+    keys.append({'p': p, 'c': random_string()})
+    reply = test_table.meta.client.batch_get_item(RequestItems = {test_table.name: {'Keys': keys, 'ConsistentRead': True}})
+    assert multiset(reply['Responses'][test_table.name]) == multiset(items)
+    assert reply['UnprocessedKeys'] == {}
+
+# DynamoDB rejects a BatchGetItem which asks for the same key twice.
+def test_batch_get_item_duplicate_key(test_table_s):
+    p = random_string()
+    with pytest.raises(ClientError, match='ValidationException.*duplicates'):
+        test_table_s.meta.client.batch_get_item(RequestItems = {test_table_s.name: {'Keys': [{'p': p}, {'p': p}]}})
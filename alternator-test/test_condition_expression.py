@@ -1314,13 +1314,13 @@ def test_update_condition_unused_entries_succeeded(test_table_s):
             ExpressionAttributeNames={'#name2': 'b', '#name3': 'c'})
 
 # Test a bunch of cases with permissive write isolation levels,
-# i.e. LWT_ALWAYS, LWT_RMW_ONLY and UNSAFE_RMW.
+# i.e. LWT_ALWAYS, LWT_RMW_ONLY, UNSAFE_RMW and LEADER_RMW.
 # These test cases make sense only for alternator, so they're skipped
 # when run on AWS
 def test_condition_expression_with_permissive_write_isolation(scylla_only, dynamodb, test_table_s):
     def do_test_with_permissive_isolation_levels(test_case, table, *args):
         try:
-            for isolation in ['a', 'o', 'u']:
+            for isolation in ['a', 'o', 'u', 'l']:
                 set_write_isolation(table, isolation)
                 test_case(table, *args)
         finally:
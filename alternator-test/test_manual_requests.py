@@ -112,3 +112,12 @@ def test_incorrect_json(dynamodb, test_table):
         req = get_signed_request(dynamodb, 'PutItem', incorrect_req)
         response = requests.post(req.url, headers=req.headers, data=req.body, verify=False)
         assert validate_resp(response.text)
+
+# Test that an unknown operation in X-Amz-Target is refused, including names
+# which only differ from a known operation in case or by a prefix.
+def test_unknown_operation(dynamodb):
+    for op in ['NoSuchOperation', 'putitem', 'PutItemX', 'Put']:
+        req = get_signed_request(dynamodb, op, '{}')
+        response = requests.post(req.url, headers=req.headers, data=req.body, verify=False)
+        assert response.status_code == 400
+        assert 'UnknownOperationException' in response.text
@@ -239,7 +239,6 @@ def test_scan_select(filled_test_table):
 # a scan into multiple parts, and that these parts are in fact disjoint,
 # and their union is the entire contents of the table. We do not actually
 # try to run these queries in *parallel* in this test.
-@pytest.mark.xfail(reason="parallel scan not supported yet")
 def test_scan_parallel(filled_test_table):
     test_table, items = filled_test_table
     for nsegments in [1, 2, 17]:
@@ -250,3 +249,28 @@ def test_scan_parallel(filled_test_table):
         # The following comparison verifies that each of the expected item
         # in items was returned in one - and just one - of the segments.
         assert multiset(items) == multiset(got_items)
+
+# Same as above, but with small pages, so every segment is read in several
+# requests, each resuming from the previous LastEvaluatedKey.
+def test_scan_parallel_paging(filled_test_table):
+    test_table, items = filled_test_table
+    got_items = []
+    for segment in range(3):
+        got_items.extend(full_scan(test_table, TotalSegments=3, Segment=segment, Limit=7))
+    assert multiset(items) == multiset(got_items)
+
+# Segment and TotalSegments must come together, and Segment must be one of
+# the TotalSegments segments.
+def test_scan_parallel_incorrect(filled_test_table):
+    test_table, items = filled_test_table
+    with pytest.raises(ClientError, match='ValidationException'):
+        full_scan(test_table, TotalSegments=2)
+    with pytest.raises(ClientError, match='ValidationException'):
+        full_scan(test_table, Segment=0)
+    with pytest.raises(ClientError, match='ValidationException'):
+        full_scan(test_table, TotalSegments=0, Segment=0)
+    with pytest.raises(ClientError, match='ValidationException'):
+        full_scan(test_table, TotalSegments=1000001, Segment=0)
+    for segment in [-1, 2]:
+        with pytest.raises(ClientError, match='ValidationException'):
+            full_scan(test_table, TotalSegments=2, Segment=segment)
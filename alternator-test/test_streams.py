@@ -0,0 +1,194 @@
+# -*- coding: utf-8 -*-
+# Copyright 2020 ScyllaDB
+#
+# This file is part of Scylla.
+#
+# Scylla is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Scylla is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+
+# Tests for DynamoDB Streams: the StreamSpecification of CreateTable and
+# DescribeTable, and the ListStreams, DescribeStream, GetShardIterator and
+# GetRecords operations.
+
+import pytest
+import time
+from botocore.exceptions import ClientError
+from util import create_test_table, random_string
+
+def create_stream_table(dynamodb, view_type):
+    return create_test_table(dynamodb,
+        StreamSpecification={'StreamEnabled': True, 'StreamViewType': view_type},
+        KeySchema=[ { 'AttributeName': 'p', 'KeyType': 'HASH' },
+                    { 'AttributeName': 'c', 'KeyType': 'RANGE' } ],
+        AttributeDefinitions=[ { 'AttributeName': 'p', 'AttributeType': 'S' },
+                               { 'AttributeName': 'c', 'AttributeType': 'S' } ])
+
+@pytest.fixture(scope="module")
+def stream_table_keys_only(dynamodb):
+    table = create_stream_table(dynamodb, 'KEYS_ONLY')
+    yield table
+    table.delete()
+
+@pytest.fixture(scope="module")
+def stream_table_images(dynamodb):
+    table = create_stream_table(dynamodb, 'NEW_AND_OLD_IMAGES')
+    yield table
+    table.delete()
+
+def stream_arn(table):
+    return table.meta.client.describe_table(TableName=table.name)['Table']['LatestStreamArn']
+
+def list_shards(dynamodbstreams, arn):
+    shards = []
+    kwargs = {'StreamArn': arn}
+    while True:
+        desc = dynamodbstreams.describe_stream(**kwargs)['StreamDescription']
+        shards.extend(desc['Shards'])
+        if not 'LastEvaluatedShardId' in desc:
+            return shards
+        kwargs['ExclusiveStartShardId'] = desc['LastEvaluatedShardId']
+
+# Returns an iterator for every open shard of the stream, starting right
+# now. The shards without an EndingSequenceNumber belong to the current
+# CDC generation.
+def latest_iterators(dynamodbstreams, arn):
+    return [dynamodbstreams.get_shard_iterator(StreamArn=arn, ShardId=shard['ShardId'],
+                ShardIteratorType='LATEST')['ShardIterator']
+            for shard in list_shards(dynamodbstreams, arn)
+            if not 'EndingSequenceNumber' in shard['SequenceNumberRange']]
+
+# Reads the records from the given iterators until at least n were found,
+# or a timeout passed.
+def read_records(dynamodbstreams, iterators, n, timeout=10):
+    records = []
+    end = time.time() + timeout
+    while len(records) < n and time.time() < end:
+        next_iterators = []
+        for it in iterators:
+            got = dynamodbstreams.get_records(ShardIterator=it)
+            records.extend(got['Records'])
+            next_iterators.append(got['NextShardIterator'])
+        iterators = next_iterators
+    return records
+
+def test_describe_table_stream(stream_table_keys_only):
+    got = stream_table_keys_only.meta.client.describe_table(TableName=stream_table_keys_only.name)['Table']
+    assert got['StreamSpecification'] == {'StreamEnabled': True, 'StreamViewType': 'KEYS_ONLY'}
+    assert 'LatestStreamArn' in got
+    assert 'LatestStreamLabel' in got
+
+def test_list_streams(dynamodbstreams, stream_table_keys_only):
+    arn = stream_arn(stream_table_keys_only)
+    got = dynamodbstreams.list_streams(TableName=stream_table_keys_only.name)['Streams']
+    assert len(got) == 1
+    assert got[0]['StreamArn'] == arn
+    assert got[0]['TableName'] == stream_table_keys_only.name
+    # Paging through all streams finds this one too.
+    arns = []
+    kwargs = {'Limit': 1}
+    while True:
+        got = dynamodbstreams.list_streams(**kwargs)
+        arns.extend(s['StreamArn'] for s in got['Streams'])
+        if not 'LastEvaluatedStreamArn' in got:
+            break
+        kwargs['ExclusiveStartStreamArn'] = got['LastEvaluatedStreamArn']
+    assert arn in arns
+
+# The CDC log behind a stream is not a table of its own.
+def test_list_tables_hides_stream(dynamodb, stream_table_keys_only):
+    names = []
+    kwargs = {}
+    while True:
+        got = dynamodb.meta.client.list_tables(**kwargs)
+        names.extend(got['TableNames'])
+        if not 'LastEvaluatedTableName' in got:
+            break
+        kwargs['ExclusiveStartTableName'] = got['LastEvaluatedTableName']
+    assert stream_table_keys_only.name in names
+    assert not any(name.startswith(stream_table_keys_only.name) and name != stream_table_keys_only.name for name in names)
+
+def test_describe_stream(dynamodbstreams, stream_table_keys_only):
+    arn = stream_arn(stream_table_keys_only)
+    desc = dynamodbstreams.describe_stream(StreamArn=arn)['StreamDescription']
+    assert desc['StreamArn'] == arn
+    assert desc['StreamStatus'] == 'ENABLED'
+    assert desc['StreamViewType'] == 'KEYS_ONLY'
+    assert desc['TableName'] == stream_table_keys_only.name
+    assert len(list_shards(dynamodbstreams, arn)) > 0
+
+def test_describe_stream_bad_arn(scylla_only, dynamodbstreams):
+    with pytest.raises(ClientError, match='ResourceNotFoundException'):
+        dynamodbstreams.describe_stream(StreamArn='00000000-0000-0000-0000-000000000000')
+
+def test_get_shard_iterator_bad_type(dynamodbstreams, stream_table_keys_only):
+    arn = stream_arn(stream_table_keys_only)
+    shard = list_shards(dynamodbstreams, arn)[0]
+    with pytest.raises(ClientError, match='ValidationException'):
+        dynamodbstreams.get_shard_iterator(StreamArn=arn, ShardId=shard['ShardId'],
+            ShardIteratorType='AT_SEQUENCE_NUMBER', SequenceNumber='dog')
+
+def test_get_records_keys_only(scylla_only, dynamodbstreams, stream_table_keys_only):
+    arn = stream_arn(stream_table_keys_only)
+    iterators = latest_iterators(dynamodbstreams, arn)
+    p = random_string()
+    stream_table_keys_only.put_item(Item={'p': p, 'c': 'x', 'a': 1})
+    stream_table_keys_only.update_item(Key={'p': p, 'c': 'x'}, AttributeUpdates={'a': {'Value': 2, 'Action': 'PUT'}})
+    stream_table_keys_only.delete_item(Key={'p': p, 'c': 'x'})
+    records = [r for r in read_records(dynamodbstreams, iterators, 3) if r['dynamodb']['Keys']['p']['S'] == p]
+    # Without the old image, Alternator can't tell a new item from a
+    # modified one, and reports both as MODIFY.
+    assert [r['eventName'] for r in records] == ['MODIFY', 'MODIFY', 'REMOVE']
+    for r in records:
+        assert r['dynamodb']['Keys'] == {'p': {'S': p}, 'c': {'S': 'x'}}
+        assert not 'NewImage' in r['dynamodb']
+        assert not 'OldImage' in r['dynamodb']
+        assert r['dynamodb']['StreamViewType'] == 'KEYS_ONLY'
+    seqs = [int(r['dynamodb']['SequenceNumber']) for r in records]
+    assert seqs == sorted(seqs)
+
+def test_get_records_images(dynamodbstreams, stream_table_images):
+    arn = stream_arn(stream_table_images)
+    iterators = latest_iterators(dynamodbstreams, arn)
+    p = random_string()
+    stream_table_images.put_item(Item={'p': p, 'c': 'x', 'a': 1})
+    stream_table_images.put_item(Item={'p': p, 'c': 'x', 'b': 'hi'})
+    stream_table_images.delete_item(Key={'p': p, 'c': 'x'})
+    records = [r for r in read_records(dynamodbstreams, iterators, 3) if r['dynamodb']['Keys']['p']['S'] == p]
+    assert [r['eventName'] for r in records] == ['INSERT', 'MODIFY', 'REMOVE']
+    assert not 'OldImage' in records[0]['dynamodb']
+    assert records[0]['dynamodb']['NewImage']['a'] == {'N': '1'}
+    assert records[1]['dynamodb']['OldImage']['a'] == {'N': '1'}
+    assert records[1]['dynamodb']['NewImage']['b'] == {'S': 'hi'}
+    assert records[2]['dynamodb']['OldImage']['b'] == {'S': 'hi'}
+    assert not 'NewImage' in records[2]['dynamodb']
+
+# Iterators at and after a sequence number start reading at the record with
+# this sequence number, or at the one which follows it. Alternator accepts
+# the sequence number on any shard, where DynamoDB would insist on its own.
+def test_get_records_at_sequence_number(scylla_only, dynamodbstreams, stream_table_keys_only):
+    arn = stream_arn(stream_table_keys_only)
+    shards = [s for s in list_shards(dynamodbstreams, arn) if not 'EndingSequenceNumber' in s['SequenceNumberRange']]
+    iterators = latest_iterators(dynamodbstreams, arn)
+    p = random_string()
+    stream_table_keys_only.put_item(Item={'p': p, 'c': 'x'})
+    stream_table_keys_only.put_item(Item={'p': p, 'c': 'y'})
+    records = [r for r in read_records(dynamodbstreams, iterators, 2) if r['dynamodb']['Keys']['p']['S'] == p]
+    assert len(records) == 2
+    seq = records[0]['dynamodb']['SequenceNumber']
+    for shard in shards:
+        for (type, first) in [('AT_SEQUENCE_NUMBER', 'x'), ('AFTER_SEQUENCE_NUMBER', 'y')]:
+            it = dynamodbstreams.get_shard_iterator(StreamArn=arn, ShardId=shard['ShardId'],
+                ShardIteratorType=type, SequenceNumber=seq)['ShardIterator']
+            got = [r for r in dynamodbstreams.get_records(ShardIterator=it)['Records'] if r['dynamodb']['Keys']['p']['S'] == p]
+            if got:
+                assert got[0]['dynamodb']['Keys']['c']['S'] == first
@@ -232,9 +232,8 @@ def test_create_table_billing_mode_errors(dynamodb, test_table):
             KeySchema=[{ 'AttributeName': 'p', 'KeyType': 'HASH' }],
             AttributeDefinitions=[{ 'AttributeName': 'p', 'AttributeType': 'S' }])
 
-# Even before Alternator gains full support for the DynamoDB stream API
-# and CreateTable's StreamSpecification option, we should support the
-# options which mean it is turned *off*.
+# CreateTable's StreamSpecification option should also accept the options
+# which mean streams are turned *off*.
 def test_table_streams_off(dynamodb):
     # If StreamSpecification is given, but has StreamEnabled=false, it's as
     # if StreamSpecification was missing. StreamViewType isn't needed.
@@ -253,7 +252,6 @@ def test_table_streams_off(dynamodb):
     # Unfortunately, boto3 doesn't allow us to pass StreamSpecification=None.
     # This is what we had in issue #5796.
 
-@pytest.mark.xfail(reason="streams not yet implemented")
 def test_table_streams_on(dynamodb):
     table = create_test_table(dynamodb,
         StreamSpecification={'StreamEnabled': True, 'StreamViewType': 'OLD_IMAGE'},
@@ -151,7 +151,7 @@ def test_tag_resource_incorrect(test_table):
 def test_tag_resource_write_isolation_values(scylla_only, test_table):
     got = test_table.meta.client.describe_table(TableName=test_table.name)['Table']
     arn =  got['TableArn']
-    for i in ['f', 'forbid', 'forbid_rmw', 'a', 'always', 'always_use_lwt', 'o', 'only_rmw_uses_lwt', 'u', 'unsafe', 'unsafe_rmw']:
+    for i in ['f', 'forbid', 'forbid_rmw', 'a', 'always', 'always_use_lwt', 'o', 'only_rmw_uses_lwt', 'u', 'unsafe', 'unsafe_rmw', 'l', 'leader_rmw']:
         test_table.meta.client.tag_resource(ResourceArn=arn, Tags=[{'Key':'system:write_isolation', 'Value':i}])
     with pytest.raises(ClientError, match='ValidationException'):
         test_table.meta.client.tag_resource(ResourceArn=arn, Tags=[{'Key':'system:write_isolation', 'Value':'bah'}])
@@ -0,0 +1,91 @@
+# -*- coding: utf-8 -*-
+# Copyright 2020 ScyllaDB
+#
+# This file is part of Scylla.
+#
+# Scylla is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Scylla is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+
+# Tests for the Time To Live (TTL) feature: UpdateTimeToLive,
+# DescribeTimeToLive, and the expiration of items.
+
+import pytest
+import time
+from botocore.exceptions import ClientError
+from util import create_test_table, random_string
+
+# A fresh table for each test, as DynamoDB does not allow changing the TTL
+# setting of a table again shortly after it was changed.
+@pytest.fixture(scope="function")
+def ttl_table(dynamodb):
+    table = create_test_table(dynamodb,
+        KeySchema=[ { 'AttributeName': 'p', 'KeyType': 'HASH' } ],
+        AttributeDefinitions=[ { 'AttributeName': 'p', 'AttributeType': 'S' } ])
+    yield table
+    table.delete()
+
+def test_describe_ttl_without_ttl(ttl_table):
+    got = ttl_table.meta.client.describe_time_to_live(TableName=ttl_table.name)
+    assert got['TimeToLiveDescription']['TimeToLiveStatus'] == 'DISABLED'
+
+def test_ttl_enable_disable(scylla_only, ttl_table):
+    client = ttl_table.meta.client
+    spec = {'AttributeName': 'expiration', 'Enabled': True}
+    got = client.update_time_to_live(TableName=ttl_table.name, TimeToLiveSpecification=spec)
+    assert got['TimeToLiveSpecification'] == spec
+    got = client.describe_time_to_live(TableName=ttl_table.name)['TimeToLiveDescription']
+    assert got['TimeToLiveStatus'] == 'ENABLED'
+    assert got['AttributeName'] == 'expiration'
+    with pytest.raises(ClientError, match='ValidationException'):
+        client.update_time_to_live(TableName=ttl_table.name, TimeToLiveSpecification=spec)
+    # Disabling requires naming the current TTL attribute
+    with pytest.raises(ClientError, match='ValidationException'):
+        client.update_time_to_live(TableName=ttl_table.name,
+            TimeToLiveSpecification={'AttributeName': 'other', 'Enabled': False})
+    client.update_time_to_live(TableName=ttl_table.name,
+        TimeToLiveSpecification={'AttributeName': 'expiration', 'Enabled': False})
+    got = client.describe_time_to_live(TableName=ttl_table.name)['TimeToLiveDescription']
+    assert got['TimeToLiveStatus'] == 'DISABLED'
+    with pytest.raises(ClientError, match='ValidationException'):
+        client.update_time_to_live(TableName=ttl_table.name,
+            TimeToLiveSpecification={'AttributeName': 'expiration', 'Enabled': False})
+
+def test_ttl_missing_specification(ttl_table):
+    with pytest.raises(ClientError, match='ValidationException'):
+        ttl_table.meta.client.update_time_to_live(TableName=ttl_table.name,
+            TimeToLiveSpecification={'Enabled': True})
+
+# DynamoDB may take up to 48 hours to delete an expired item, so this test
+# is Scylla-only. It relies on the test server scanning for expired items
+# every second (see --alternator-ttl-period-in-seconds in "run").
+def test_ttl_expiration(scylla_only, ttl_table):
+    ttl_table.meta.client.update_time_to_live(TableName=ttl_table.name,
+        TimeToLiveSpecification={'AttributeName': 'expiration', 'Enabled': True})
+    now = int(time.time())
+    expired = random_string()
+    live = random_string()
+    not_a_number = random_string()
+    too_old = random_string()
+    ttl_table.put_item(Item={'p': expired, 'expiration': now - 60})
+    ttl_table.put_item(Item={'p': live, 'expiration': now + 3600})
+    ttl_table.put_item(Item={'p': not_a_number, 'expiration': 'dog'})
+    # ignored, as it's more than five years in the past
+    ttl_table.put_item(Item={'p': too_old, 'expiration': now - 6 * 365 * 24 * 3600})
+    deadline = time.time() + 30
+    while time.time() < deadline:
+        if not 'Item' in ttl_table.get_item(Key={'p': expired}, ConsistentRead=True):
+            break
+        time.sleep(0.5)
+    assert not 'Item' in ttl_table.get_item(Key={'p': expired}, ConsistentRead=True)
+    for p in [live, not_a_number, too_old]:
+        assert 'Item' in ttl_table.get_item(Key={'p': p}, ConsistentRead=True)
@@ -23,6 +23,7 @@
 #include "log.hh"
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <gnutls/crypto.h>
 #include <seastar/util/defer.hh>
 #include "hashers.hh"
@@ -56,6 +57,33 @@ static hmac_sha256_digest get_signature_key(std::string_view key, std::string_vi
     return signing;
 }
 
+// Deriving the signing key takes four HMAC computations, but the key only
+// depends on the secret, date, region and service, so it is the same for
+// all requests of a user on a given day. The keys derived recently are
+// cached per shard. The secret is part of the cache key, so a changed
+// password never reuses a stale signing key; old dates simply age out as
+// the cache is cleared whenever it fills up.
+class signing_key_cache {
+    static constexpr size_t max_entries = 1024;
+    std::unordered_map<std::string, hmac_sha256_digest> _keys;
+public:
+    hmac_sha256_digest get(std::string_view key, std::string_view date_stamp, std::string_view region_name, std::string_view service_name) {
+        std::string cache_key = fmt::format("{}\n{}\n{}\n{}", date_stamp, region_name, service_name, key);
+        auto it = _keys.find(cache_key);
+        if (it != _keys.end()) {
+            return it->second;
+        }
+        if (_keys.size() >= max_entries) {
+            _keys.clear();
+        }
+        auto signing_key = get_signature_key(key, date_stamp, region_name, service_name);
+        _keys.emplace(std::move(cache_key), signing_key);
+        return signing_key;
+    }
+};
+
+static thread_local signing_key_cache signing_keys;
+
 static std::string apply_sha256(std::string_view msg) {
     sha256_hasher hasher;
     hasher.update(msg.data(), msg.size());
@@ -117,7 +145,7 @@ std::string get_signature(std::string_view access_key_id, std::string_view secre
     std::string credential_scope = fmt::format("{}/{}/{}/aws4_request", datestamp, region, service);
     std::string string_to_sign = fmt::format("{}\n{}\n{}\n{}", algorithm, amz_date, credential_scope,  apply_sha256(canonical_request));
 
-    hmac_sha256_digest signing_key = get_signature_key(secret_access_key, datestamp, region, service);
+    hmac_sha256_digest signing_key = signing_keys.get(secret_access_key, datestamp, region, service);
     hmac_sha256_digest signature = hmac_sha256(std::string_view(signing_key.data(), signing_key.size()), string_to_sign);
 
     return to_hex(bytes_view(reinterpret_cast<const int8_t*>(signature.data()), signature.size()));
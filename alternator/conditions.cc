@@ -67,10 +67,10 @@ comparison_operator_type get_comparison_operator(const rjson::value& comparison_
     return it->second;
 }
 
-static ::shared_ptr<cql3::restrictions::single_column_restriction::contains> make_map_element_restriction(const column_definition& cdef, std::string_view key, const rjson::value& value) {
+static ::shared_ptr<cql3::restrictions::single_column_restriction::contains> make_map_element_restriction(const column_definition& cdef, std::string_view key, const rjson::value& value, compact_attributes compact) {
     bytes raw_key = utf8_type->from_string(sstring_view(key.data(), key.size()));
     auto key_value = ::make_shared<cql3::constants::value>(cql3::raw_value::make_value(std::move(raw_key)));
-    bytes raw_value = serialize_item(value);
+    bytes raw_value = serialize_item(value, compact);
     auto entry_value = ::make_shared<cql3::constants::value>(cql3::raw_value::make_value(std::move(raw_value)));
     return make_shared<cql3::restrictions::single_column_restriction::contains>(cdef, std::move(key_value), std::move(entry_value));
 }
@@ -81,7 +81,7 @@ static ::shared_ptr<cql3::restrictions::single_column_restriction::EQ> make_key_
     return make_shared<cql3::restrictions::single_column_restriction::EQ>(cdef, std::move(restriction_value));
 }
 
-::shared_ptr<cql3::restrictions::statement_restrictions> get_filtering_restrictions(schema_ptr schema, const column_definition& attrs_col, const rjson::value& query_filter) {
+::shared_ptr<cql3::restrictions::statement_restrictions> get_filtering_restrictions(schema_ptr schema, const column_definition& attrs_col, const rjson::value& query_filter, compact_attributes compact) {
     clogger.trace("Getting filtering restrictions for: {}", rjson::print(query_filter));
     auto filtering_restrictions = ::make_shared<cql3::restrictions::statement_restrictions>(schema, true);
     for (auto it = query_filter.MemberBegin(); it != query_filter.MemberEnd(); ++it) {
@@ -103,7 +103,7 @@ ::shared_ptr<cql3::restrictions::statement_restrictions> get_filtering_restricti
             filtering_restrictions->add_restriction(make_key_eq_restriction(*cdef, attr_list[0]), false, true);
         } else {
             // Regular column restriction
-            filtering_restrictions->add_restriction(make_map_element_restriction(attrs_col, column_name, attr_list[0]), false, true);
+            filtering_restrictions->add_restriction(make_map_element_restriction(attrs_col, column_name, attr_list[0], compact), false, true);
         }
 
     }
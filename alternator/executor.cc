@@ -52,13 +52,28 @@
 #include "utils/overloaded_functor.hh"
 #include "seastar/json/json_elements.hh"
 #include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/algorithm/cxx11/all_of.hpp>
 #include "collection_mutation.hh"
 #include "db/query_context.hh"
 #include "schema.hh"
 #include "alternator/tags_extension.hh"
 #include "alternator/rmw_operation.hh"
+#include "alternator/expiration.hh"
 
 #include <boost/range/adaptors.hpp>
+#include <boost/range/join.hpp>
+#include <boost/range/algorithm/sort.hpp>
+#include <boost/range/algorithm/find_if.hpp>
+#include "message/messaging_service.hh"
+#include "gms/gossiper.hh"
+#include "db/consistency_level.hh"
+#include "utils/fb_utilities.hh"
+#include "cdc/log.hh"
+#include "cdc/cdc_extension.hh"
+#include "db/system_distributed_keyspace.hh"
+#include "cql3/query_processor.hh"
+#include "cql3/untyped_result_set.hh"
+#include "utils/UUID_gen.hh"
 
 logging::logger elogger("alternator-executor");
 
@@ -83,6 +98,21 @@ struct make_jsonable : public json::jsonable {
         return rjson::print(_value);
     }
 };
+// Returns a response whose body is printed directly to the connection's
+// output stream, in chunks, rather than into one string. Used for the
+// possibly large results of Query and Scan.
+static executor::request_return_type make_streamed(rjson::value&& value) {
+    return json::json_return_type([value = make_lw_shared<rjson::value>(std::move(value))] (output_stream<char>&& os) {
+        return do_with(std::move(os), [value] (output_stream<char>& os) {
+            return rjson::print(*value, os).then([&os] {
+                return os.flush();
+            }).finally([&os] {
+                return os.close();
+            });
+        });
+    });
+}
+
 struct json_string : public json::jsonable {
     std::string _value;
 public:
@@ -99,6 +129,64 @@ static void supplement_table_info(rjson::value& descr, const schema& schema) {
     rjson::set(descr, "TableId", rjson::from_string(schema_id_str));
 }
 
+// Alternator Streams are implemented on top of CDC. The StreamViewType of
+// a stream decides which of the CDC images are written to the log: the old
+// image is CDC's preimage and the new image is its postimage.
+static std::optional<std::map<sstring, sstring>> cdc_options_for_stream_view_type(std::string_view view_type) {
+    std::map<sstring, sstring> options{{"enabled", "true"}};
+    if (view_type == "NEW_IMAGE") {
+        options.emplace("postimage", "true");
+    } else if (view_type == "OLD_IMAGE") {
+        options.emplace("preimage", "true");
+    } else if (view_type == "NEW_AND_OLD_IMAGES") {
+        options.emplace("preimage", "true");
+        options.emplace("postimage", "true");
+    } else if (view_type != "KEYS_ONLY") {
+        return {};
+    }
+    return options;
+}
+
+static std::string_view stream_view_type(const cdc::options& options) {
+    if (options.preimage() && options.postimage()) {
+        return "NEW_AND_OLD_IMAGES";
+    } else if (options.preimage()) {
+        return "OLD_IMAGE";
+    } else if (options.postimage()) {
+        return "NEW_IMAGE";
+    }
+    return "KEYS_ONLY";
+}
+
+// The CDC log table of a base table with a stream enabled, or nullptr.
+static schema_ptr stream_log_schema(const database& db, const schema& base) {
+    if (!base.cdc_options().enabled()) {
+        return nullptr;
+    }
+    auto log_name = cdc::log_name(base.cf_name());
+    if (!db.has_schema(base.ks_name(), log_name)) {
+        return nullptr;
+    }
+    return db.find_schema(base.ks_name(), log_name);
+}
+
+// The ARN and label of a stream are both the id of its CDC log table.
+static void add_stream_info(rjson::value& descr, const database& db, const schema& schema, bool with_specification) {
+    schema_ptr log_schema = stream_log_schema(db, schema);
+    if (!log_schema) {
+        return;
+    }
+    if (with_specification) {
+        rjson::value stream_specification = rjson::empty_object();
+        rjson::set(stream_specification, "StreamEnabled", rjson::value(true));
+        rjson::set(stream_specification, "StreamViewType", rjson::from_string(stream_view_type(schema.cdc_options())));
+        rjson::set(descr, "StreamSpecification", std::move(stream_specification));
+    }
+    auto arn = log_schema->id().to_sstring();
+    rjson::set(descr, "LatestStreamArn", rjson::from_string(arn));
+    rjson::set(descr, "LatestStreamLabel", rjson::from_string(arn));
+}
+
 // We would have liked to support table names up to 255 bytes, like DynamoDB.
 // But Scylla creates a directory whose name is the table's name plus 33
 // bytes (dash and UUID), and since directory names are limited to 255 bytes,
@@ -385,6 +473,8 @@ future<executor::request_return_type> executor::describe_table(client_state& cli
     }
     rjson::set(table_description, "AttributeDefinitions", std::move(attribute_definitions));
 
+    add_stream_info(table_description, _proxy.get_db().local(), *schema, true);
+
     // FIXME: still missing some response fields (issue #5026)
 
     rjson::value response = rjson::empty_object();
@@ -550,6 +640,7 @@ static void validate_tags(const std::map<sstring, sstring>& tags) {
         "a", "always", "always_use_lwt",
         "o", "only_rmw_uses_lwt",
         "u", "unsafe", "unsafe_rmw",
+        "l", "leader_rmw",
     };
     auto it = tags.find(rmw_operation::WRITE_ISOLATION_TAG_KEY);
     if (it != tags.end()) {
@@ -681,6 +772,72 @@ future<executor::request_return_type> executor::list_tags_of_resource(client_sta
     return make_ready_future<executor::request_return_type>(make_jsonable(std::move(ret)));
 }
 
+// A table's TTL attribute is kept in the TTL_TAG_KEY tag, which the
+// expiration_service looks for.
+future<executor::request_return_type> executor::update_time_to_live(client_state& client_state, service_permit permit, rjson::value request) {
+    _stats.api_operations.update_time_to_live++;
+
+    return seastar::async([this, request = std::move(request)] () mutable -> request_return_type {
+        schema_ptr schema = get_table(_proxy, request);
+        const rjson::value* spec = rjson::find(request, "TimeToLiveSpecification");
+        if (!spec || !spec->IsObject()) {
+            return api_error("ValidationException", "UpdateTimeToLive requires a TimeToLiveSpecification object");
+        }
+        const rjson::value* enabled = rjson::find(*spec, "Enabled");
+        const rjson::value* attribute_name = rjson::find(*spec, "AttributeName");
+        if (!enabled || !enabled->IsBool()) {
+            return api_error("ValidationException", "TimeToLiveSpecification requires a boolean Enabled");
+        }
+        if (!attribute_name || !attribute_name->IsString() || attribute_name->GetStringLength() == 0) {
+            return api_error("ValidationException", "TimeToLiveSpecification requires a non-empty AttributeName string");
+        }
+        std::string_view name(attribute_name->GetString(), attribute_name->GetStringLength());
+        std::map<sstring, sstring> tags_map = get_tags_of_table(schema);
+        auto current = tags_map.find(TTL_TAG_KEY);
+        if (enabled->GetBool()) {
+            if (current != tags_map.end()) {
+                return api_error("ValidationException", "TimeToLive is already enabled");
+            }
+            rjson::value tag = rjson::empty_object();
+            rjson::set(tag, "Key", rjson::from_string(std::string_view(TTL_TAG_KEY)));
+            rjson::set(tag, "Value", rjson::from_string(name));
+            rjson::value tags = rjson::empty_array();
+            rjson::push_back(tags, std::move(tag));
+            update_tags(tags, schema, std::move(tags_map), update_tags_action::add_tags).get();
+        } else {
+            if (current == tags_map.end()) {
+                return api_error("ValidationException", "TimeToLive is already disabled");
+            }
+            if (current->second != name) {
+                return api_error("ValidationException", format("The TTL attribute is {}, not {}", current->second, name));
+            }
+            rjson::value tags = rjson::empty_array();
+            rjson::push_back(tags, rjson::from_string(std::string_view(TTL_TAG_KEY)));
+            update_tags(tags, schema, std::move(tags_map), update_tags_action::delete_tags).get();
+        }
+        rjson::value response = rjson::empty_object();
+        rjson::set(response, "TimeToLiveSpecification", rjson::copy(*spec));
+        return make_jsonable(std::move(response));
+    });
+}
+
+future<executor::request_return_type> executor::describe_time_to_live(client_state& client_state, service_permit permit, rjson::value request) {
+    _stats.api_operations.describe_time_to_live++;
+    schema_ptr schema = get_table(_proxy, request);
+    const std::map<sstring, sstring>& tags_map = get_tags_of_table(schema);
+    rjson::value desc = rjson::empty_object();
+    auto it = tags_map.find(TTL_TAG_KEY);
+    if (it == tags_map.end()) {
+        rjson::set(desc, "TimeToLiveStatus", "DISABLED");
+    } else {
+        rjson::set(desc, "TimeToLiveStatus", "ENABLED");
+        rjson::set(desc, "AttributeName", rjson::from_string(it->second));
+    }
+    rjson::value response = rjson::empty_object();
+    rjson::set(response, "TimeToLiveDescription", std::move(desc));
+    return make_ready_future<executor::request_return_type>(make_jsonable(std::move(response)));
+}
+
 future<executor::request_return_type> executor::create_table(client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value request) {
     _stats.api_operations.create_table++;
     elogger.trace("Creating table {}", request);
@@ -828,8 +985,9 @@ future<executor::request_return_type> executor::create_table(client_state& clien
     if (rjson::find(request, "SSESpecification")) {
         return make_ready_future<request_return_type>(api_error("ValidationException", "SSESpecification: configuring encryption-at-rest is not yet supported."));
     }
-    // We don't yet support streams (CDC), but a StreamSpecification asking
-    // *not* to use streams should be accepted:
+    schema::extensions_map extensions{{sstring(tags_extension::NAME), ::make_shared<tags_extension>()}};
+    // Streams are implemented on top of CDC: enabling a stream enables CDC
+    // on the table, with the pre- and post-images the view type asks for.
     rjson::value* stream_specification = rjson::find(request, "StreamSpecification");
     if (stream_specification && stream_specification->IsObject()) {
         rjson::value* stream_enabled = rjson::find(*stream_specification, "StreamEnabled");
@@ -837,12 +995,21 @@ future<executor::request_return_type> executor::create_table(client_state& clien
             return make_ready_future<request_return_type>(api_error("ValidationException", "StreamSpecification needs boolean StreamEnabled"));
         }
         if (stream_enabled->GetBool()) {
-            // TODO: support streams
-            return make_ready_future<request_return_type>(api_error("ValidationException", "StreamSpecification: streams (CDC) is not yet supported."));
+            if (!_proxy.get_db().local().features().cluster_supports_cdc()) {
+                return make_ready_future<request_return_type>(api_error("ValidationException",
+                        "StreamSpecification: streams (CDC) are not enabled in this cluster. Enable the experimental 'cdc' feature first."));
+            }
+            std::string view_type = get_string_attribute(*stream_specification, "StreamViewType", "");
+            auto cdc_options = cdc_options_for_stream_view_type(view_type);
+            if (!cdc_options) {
+                return make_ready_future<request_return_type>(api_error("ValidationException",
+                        format("StreamSpecification: invalid StreamViewType '{}'", view_type)));
+            }
+            extensions.emplace(sstring(cdc::cdc_extension::NAME), ::make_shared<cdc::cdc_extension>(std::move(*cdc_options)));
         }
     }
 
-    builder.set_extensions(schema::extensions_map{{sstring(tags_extension::NAME), ::make_shared<tags_extension>()}});
+    builder.set_extensions(extensions);
     schema_ptr schema = builder.build();
     auto where_clause_it = where_clauses.begin();
     for (auto& view_builder : view_builders) {
@@ -872,9 +1039,10 @@ future<executor::request_return_type> executor::create_table(client_state& clien
                 if (rjson::find(table_info, "Tags")) {
                     f = add_tags(_proxy, schema, table_info);
                 }
-                return f.then([table_info = std::move(table_info), schema] () mutable {
+                return f.then([this, table_info = std::move(table_info), schema] () mutable {
                     rjson::value status = rjson::empty_object();
                     supplement_table_info(table_info, *schema);
+                    add_stream_info(table_info, _proxy.get_db().local(), *schema, false);
                     rjson::set(status, "TableDescription", std::move(table_info));
                     return make_ready_future<executor::request_return_type>(make_jsonable(std::move(status)));
                 });
@@ -959,6 +1127,12 @@ static void validate_value(const rjson::value& v, const char* caller) {
     }
 }
 
+// Attribute values may be written in the compact encoding once every node
+// in the cluster can read it.
+static compact_attributes compact_attributes_supported(service::storage_proxy& proxy) {
+    return compact_attributes(proxy.features().cluster_supports_alternator_compact_attributes());
+}
+
 // The put_or_delete_item class builds the mutations needed by the PutItem and
 // DeleteItem operations - either as stand-alone commands or part of a list
 // of commands in BatchWriteItems.
@@ -985,7 +1159,7 @@ class put_or_delete_item {
     struct delete_item {};
     struct put_item {};
     put_or_delete_item(const rjson::value& key, schema_ptr schema, delete_item);
-    put_or_delete_item(const rjson::value& item, schema_ptr schema, put_item);
+    put_or_delete_item(const rjson::value& item, schema_ptr schema, put_item, compact_attributes compact);
     // put_or_delete_item doesn't keep a reference to schema (so it can be
     // moved between shards for LWT) so it needs to be given again to build():
     mutation build(schema_ptr schema, api::timestamp_type ts);
@@ -998,7 +1172,7 @@ put_or_delete_item::put_or_delete_item(const rjson::value& key, schema_ptr schem
     check_key(key, schema);
 }
 
-put_or_delete_item::put_or_delete_item(const rjson::value& item, schema_ptr schema, put_item)
+put_or_delete_item::put_or_delete_item(const rjson::value& item, schema_ptr schema, put_item, compact_attributes compact)
         : _pk(pk_from_json(item, schema)), _ck(ck_from_json(item, schema)) {
     _cells = std::vector<cell>();
     _cells->reserve(item.MemberCount());
@@ -1007,8 +1181,7 @@ put_or_delete_item::put_or_delete_item(const rjson::value& item, schema_ptr sche
         validate_value(it->value, "PutItem");
         const column_definition* cdef = schema->get_column_definition(column_name);
         if (!cdef) {
-            bytes value = serialize_item(it->value);
-            _cells->push_back({std::move(column_name), serialize_item(it->value)});
+            _cells->push_back({std::move(column_name), serialize_item(it->value, compact)});
         } else if (!cdef->is_primary_key()) {
             // Fixed-type regular column can be used for GSI key
             _cells->push_back({std::move(column_name),
@@ -1136,6 +1309,7 @@ rmw_operation::rmw_operation(service::storage_proxy& proxy, rjson::value&& reque
     , _schema(get_table(proxy, _request))
     , _write_isolation(get_write_isolation_for_schema(_schema))
     , _returnvalues(parse_returnvalues(_request))
+    , _compact_attributes(compact_attributes_supported(proxy))
 {
     // _pk and _ck will be assigned later, by the subclass's constructor
     // (each operation puts the key in a slightly different location in
@@ -1168,6 +1342,8 @@ rmw_operation::write_isolation rmw_operation::get_write_isolation_for_schema(sch
         return write_isolation::LWT_RMW_ONLY;
     case 'u':
         return write_isolation::UNSAFE_RMW;
+    case 'l':
+        return write_isolation::LEADER_RMW;
     default:
         // In case of an incorrect tag, fall back to the safest option: LWT_ALWAYS
         return write_isolation::LWT_ALWAYS;
@@ -1185,11 +1361,14 @@ rmw_operation::write_isolation rmw_operation::get_write_isolation_for_schema(sch
 std::optional<shard_id> rmw_operation::shard_for_execute(bool needs_read_before_write) {
     if (_write_isolation == write_isolation::FORBID_RMW ||
         (_write_isolation == write_isolation::LWT_RMW_ONLY && !needs_read_before_write) ||
+        (_write_isolation == write_isolation::LEADER_RMW && !needs_read_before_write) ||
         _write_isolation == write_isolation::UNSAFE_RMW) {
         return {};
     }
-    // If we're still here, cas() *will* be called by execute(), so let's
-    // find the appropriate shard to run it on:
+    // If we're still here, cas() *may* be called by execute(), so let's
+    // find the appropriate shard to run it on. A LEADER_RMW operation only
+    // uses cas() as a fallback, but its per-token lock lives on the same
+    // shard too:
     auto token = dht::get_token(*_schema, _pk);
     auto desired_shard = service::storage_proxy::cas_shard(*_schema, token);
     if (desired_shard == this_shard_id()) {
@@ -1214,6 +1393,112 @@ static future<executor::request_return_type> rmw_operation_return(rjson::value&&
     return make_ready_future<executor::request_return_type>(make_jsonable(std::move(ret)));
 }
 
+// The leader of a LEADER_RMW operation is the first natural endpoint of the
+// token (as ordered by the replication strategy) in the local DC, so all
+// coordinators agree on it as long as they agree on the topology. While the
+// token range is moving, or the leader is considered down, there is no
+// leader and the operation fails with a retryable error.
+static std::optional<gms::inet_address> rmw_leader(service::storage_proxy& proxy, const schema& s, const dht::token& token) {
+    auto& ks = proxy.get_db().local().find_keyspace(s.ks_name());
+    if (!proxy.get_token_metadata().pending_endpoints_for(token, s.ks_name()).empty()) {
+        return {};
+    }
+    for (const gms::inet_address& ep : ks.get_replication_strategy().get_natural_endpoints(token)) {
+        if (db::is_local(ep)) {
+            if (!gms::get_local_gossiper().is_alive(ep)) {
+                return {};
+            }
+            return ep;
+        }
+    }
+    return {};
+}
+
+// Serializes the LEADER_RMW operations of a token on its leader.
+// Modeled after paxos_state::key_lock_map: a semaphore per locked token,
+// dropped when the last holder releases it.
+class leader_rmw_locks {
+    using semaphore = basic_semaphore<semaphore_default_exception_factory, db::timeout_clock>;
+    std::unordered_map<dht::token, semaphore> _locks;
+public:
+    template<typename Func>
+    futurize_t<std::result_of_t<Func()>> with_locked_key(const dht::token& key, db::timeout_clock::time_point timeout, Func func) {
+        auto& sem = _locks.try_emplace(key, 1).first->second;
+        return with_semaphore(sem, 1, timeout - db::timeout_clock::now(), std::move(func)).finally([key, this] {
+            auto it = _locks.find(key);
+            if (it != _locks.end() && it->second.current() == 1) {
+                _locks.erase(it);
+            }
+        });
+    }
+};
+
+// Locks are local to the shard owning (as per cas_shard()) the token.
+static thread_local leader_rmw_locks leader_locks;
+
+future<executor::request_return_type> rmw_operation::execute_on_leader(service::storage_proxy& proxy,
+        service::client_state& client_state,
+        tracing::trace_state_ptr trace_state,
+        service_permit permit,
+        stats& stats) {
+    stats.write_using_leader_rmw++;
+    auto timeout = default_timeout();
+    return leader_locks.with_locked_key(dht::get_token(*_schema, _pk), timeout,
+            [this, &proxy, &client_state, &stats, timeout, trace_state = std::move(trace_state), permit = std::move(permit)] () mutable {
+        return get_previous_item(proxy, client_state, schema(), _pk, _ck, permit, stats).then(
+                [this, &proxy, timeout, trace_state = std::move(trace_state), permit] (std::unique_ptr<rjson::value> previous_item) mutable {
+            // The lock is held until the write is acknowledged, so the next
+            // operation on the item reads its result. The timestamps of the
+            // shard's writes grow monotonically, so they are also ordered.
+            std::optional<mutation> m = apply(std::move(previous_item), api::new_timestamp());
+            if (!m) {
+                return make_ready_future<executor::request_return_type>(api_error("ConditionalCheckFailedException", "Failed condition."));
+            }
+            return proxy.mutate(std::vector<mutation>{std::move(*m)}, db::consistency_level::LOCAL_QUORUM, timeout, trace_state, std::move(permit)).then([this] () mutable {
+                return rmw_operation_return(std::move(_return_attributes));
+            });
+        });
+    });
+}
+
+// The response to an ALTERNATOR_FORWARD_RMW request: a JSON object holding
+// either the "Body" of the reply to a successful operation, or the "Error"
+// returned by a failed one.
+static sstring forwarded_rmw_response(const executor::request_return_type& ret) {
+    rjson::value response = rjson::empty_object();
+    std::visit(overloaded_functor {
+        [&] (const json::json_return_type& r) {
+            rjson::set(response, "Body", rjson::from_string(r._res));
+        },
+        [&] (const api_error& e) {
+            rjson::value error = rjson::empty_object();
+            rjson::set(error, "Type", rjson::from_string(e._type));
+            rjson::set(error, "Message", rjson::from_string(e._msg));
+            rjson::set(error, "Status", rjson::value(int(e._http_code)));
+            rjson::set(response, "Error", std::move(error));
+        }
+    }, ret);
+    return sstring(rjson::print(response));
+}
+
+static executor::request_return_type parse_forwarded_rmw_response(const sstring& s) {
+    rjson::value response = rjson::parse(s);
+    if (const rjson::value* error = rjson::find(response, "Error")) {
+        return api_error(rjson::get(*error, "Type").GetString(), rjson::get(*error, "Message").GetString(),
+                api_error::status_type(rjson::get(*error, "Status").GetInt()));
+    }
+    const rjson::value& body = rjson::get(response, "Body");
+    return json_string(std::string(body.GetString(), body.GetStringLength()));
+}
+
+future<executor::request_return_type> rmw_operation::forward_to_leader(gms::inet_address leader, stats& stats) {
+    stats.leader_rmw_forwarded++;
+    return netw::get_local_messaging_service().send_alternator_forward_rmw(leader, default_timeout(),
+            operation_name(), sstring(rjson::print(_request))).then([] (sstring response) {
+        return parse_forwarded_rmw_response(response);
+    });
+}
+
 future<executor::request_return_type> rmw_operation::execute(service::storage_proxy& proxy,
         service::client_state& client_state,
         tracing::trace_state_ptr trace_state,
@@ -1239,6 +1524,31 @@ future<executor::request_return_type> rmw_operation::execute(service::storage_pr
                 });
             });
         }
+        if (_write_isolation == write_isolation::LEADER_RMW) {
+            // The leader's lock and LWT do not serialize against each other,
+            // so LEADER_RMW operations never fall back to LWT: while there
+            // is no agreed leader they fail, and the client retries them.
+            if (!proxy.features().cluster_supports_alternator_leader_rmw()) {
+                throw api_error("ValidationException", "Write isolation leader_rmw is not supported by all nodes in the cluster");
+            }
+            auto leader = rmw_leader(proxy, *_schema, dht::get_token(*_schema, _pk));
+            if (!leader) {
+                stats.leader_rmw_unavailable++;
+                throw api_error("InternalServerError", "No leader is available for the item, retry the request",
+                        api_error::status_type::internal_server_error);
+            }
+            if (utils::fb_utilities::is_me(*leader)) {
+                return execute_on_leader(proxy, client_state, std::move(trace_state), std::move(permit), stats);
+            }
+            if (_forwarded) {
+                // The nodes disagree about the leader, e.g. during a
+                // topology change. Forwarding again could loop.
+                stats.leader_rmw_unavailable++;
+                throw api_error("InternalServerError", "The leader of the item has changed, retry the request",
+                        api_error::status_type::internal_server_error);
+            }
+            return forward_to_leader(*leader, stats);
+        }
     } else if (_write_isolation != write_isolation::LWT_ALWAYS) {
         std::optional<mutation> m = apply(nullptr, api::new_timestamp());
         assert(m); // !needs_read_before_write, so apply() did not check a condition
@@ -1318,7 +1628,7 @@ class put_item_operation : public rmw_operation {
     parsed::condition_expression _condition_expression;
     put_item_operation(service::storage_proxy& proxy, rjson::value&& request)
         : rmw_operation(proxy, std::move(request))
-        , _mutation_builder(rjson::get(_request, "Item"), schema(), put_or_delete_item::put_item{}) {
+        , _mutation_builder(rjson::get(_request, "Item"), schema(), put_or_delete_item::put_item{}, _compact_attributes) {
         _pk = _mutation_builder.pk();
         _ck = _mutation_builder.ck();
         if (_returnvalues != returnvalues::NONE && _returnvalues != returnvalues::ALL_OLD) {
@@ -1326,11 +1636,14 @@ class put_item_operation : public rmw_operation {
         }
         _condition_expression = get_parsed_condition_expression(_request);
     }
-    bool needs_read_before_write() const {
+    virtual bool needs_read_before_write() const override {
         return _request.HasMember("Expected") ||
                check_needs_read_before_write(_condition_expression) ||
                _returnvalues == returnvalues::ALL_OLD;
     }
+    virtual const char* operation_name() const override {
+        return "PutItem";
+    }
     virtual std::optional<mutation> apply(std::unique_ptr<rjson::value> previous_item, api::timestamp_type ts) override {
         std::unordered_set<std::string> used_attribute_values;
         std::unordered_set<std::string> used_attribute_names;
@@ -1404,11 +1717,14 @@ class delete_item_operation : public rmw_operation {
         }
         _condition_expression = get_parsed_condition_expression(_request);
     }
-    bool needs_read_before_write() const {
+    virtual bool needs_read_before_write() const override {
         return _request.HasMember("Expected") ||
                 check_needs_read_before_write(_condition_expression) ||
                 _returnvalues == returnvalues::ALL_OLD;
     }
+    virtual const char* operation_name() const override {
+        return "DeleteItem";
+    }
     virtual std::optional<mutation> apply(std::unique_ptr<rjson::value> previous_item, api::timestamp_type ts) override {
         std::unordered_set<std::string> used_attribute_values;
         std::unordered_set<std::string> used_attribute_names;
@@ -1566,12 +1882,21 @@ static future<> do_batch_write(service::storage_proxy& proxy,
         return rmw_operation::get_write_isolation_for_schema(schema) == rmw_operation::write_isolation::LWT_ALWAYS;
     });
     if (!needs_lwt) {
-        // Do a normal write, without LWT:
+        // Do a normal write, without LWT. Items of the same partition are
+        // joined into one mutation, so each partition is written once.
         std::vector<mutation> mutations;
         mutations.reserve(mutation_builders.size());
+        std::unordered_map<schema_decorated_key, size_t, schema_decorated_key_hash, schema_decorated_key_equal>
+            partitions(1, schema_decorated_key_hash{}, schema_decorated_key_equal{});
         api::timestamp_type now = api::new_timestamp();
         for (auto& b : mutation_builders) {
-            mutations.push_back(b.second.build(b.first, now));
+            auto m = b.second.build(b.first, now);
+            auto [it, inserted] = partitions.emplace(schema_decorated_key{b.first, m.decorated_key()}, mutations.size());
+            if (inserted) {
+                mutations.push_back(std::move(m));
+            } else {
+                mutations[it->second].apply(std::move(m));
+            }
         }
         return proxy.mutate(std::move(mutations),
                 db::consistency_level::LOCAL_QUORUM,
@@ -1648,7 +1973,7 @@ future<executor::request_return_type> executor::batch_write_item(client_state& c
                 const rjson::value& put_request = r->value;
                 const rjson::value& item = put_request["Item"];
                 mutation_builders.emplace_back(schema, put_or_delete_item(
-                        item, schema, put_or_delete_item::put_item{}));
+                        item, schema, put_or_delete_item::put_item{}, compact_attributes_supported(_proxy)));
                 auto mut_key = std::make_pair(mutation_builders.back().second.pk(), mutation_builders.back().second.ck());
                 if (used_keys.count(mut_key) > 0) {
                     return make_ready_future<request_return_type>(api_error("ValidationException", "Provided list of item keys contains duplicates"));
@@ -2330,7 +2655,10 @@ class update_item_operation  : public rmw_operation {
     update_item_operation(service::storage_proxy& proxy, rjson::value&& request);
     virtual ~update_item_operation() = default;
     virtual std::optional<mutation> apply(std::unique_ptr<rjson::value> previous_item, api::timestamp_type ts) override;
-    bool needs_read_before_write() const;
+    virtual bool needs_read_before_write() const override;
+    virtual const char* operation_name() const override {
+        return "UpdateItem";
+    }
 };
 
 update_item_operation::update_item_operation(service::storage_proxy& proxy, rjson::value&& update_info)
@@ -2431,7 +2759,7 @@ update_item_operation::apply(std::unique_ptr<rjson::value> previous_item, api::t
             bytes column_value = get_key_from_typed_value(json_value, *cdef);
             row.cells().apply(*cdef, atomic_cell::make_live(*cdef->type, ts, column_value));
         } else {
-            attrs_collector.put(std::move(column_name), serialize_item(json_value), ts);
+            attrs_collector.put(std::move(column_name), serialize_item(json_value, _compact_attributes), ts);
         }
     };
     bool any_deletes = false;
@@ -2636,6 +2964,42 @@ future<executor::request_return_type> executor::update_item(client_state& client
     });
 }
 
+// Executes a read-modify-write operation forwarded to this node by another
+// coordinator, because this node is the operation's leader (see LEADER_RMW).
+future<sstring> executor::execute_forwarded_rmw(sstring op_name, rjson::value request) {
+    shared_ptr<rmw_operation> op;
+    try {
+        if (op_name == "PutItem") {
+            op = make_shared<put_item_operation>(_proxy, std::move(request));
+        } else if (op_name == "DeleteItem") {
+            op = make_shared<delete_item_operation>(_proxy, std::move(request));
+        } else if (op_name == "UpdateItem") {
+            op = make_shared<update_item_operation>(_proxy, std::move(request));
+        } else {
+            throw api_error("ValidationException", format("Unsupported forwarded operation {}", op_name));
+        }
+    } catch (api_error& e) {
+        return make_ready_future<sstring>(forwarded_rmw_response(std::move(e)));
+    }
+    op->set_forwarded();
+    const bool needs_read_before_write = op->needs_read_before_write();
+    if (auto shard = op->shard_for_execute(needs_read_before_write); shard) {
+        _stats.shard_bounce_for_lwt++;
+        return container().invoke_on(*shard, _ssg, [op_name = std::move(op_name), request = std::move(*op).move_request()] (executor& e) mutable {
+            return e.execute_forwarded_rmw(std::move(op_name), std::move(request));
+        });
+    }
+    return futurize_invoke([this, op, needs_read_before_write] {
+        return op->execute(_proxy, service::client_state::for_internal_calls(), tracing::trace_state_ptr(), empty_service_permit(), needs_read_before_write, _stats);
+    }).then_wrapped([op] (future<request_return_type> f) {
+        try {
+            return forwarded_rmw_response(f.get0());
+        } catch (api_error& e) {
+            return forwarded_rmw_response(std::move(e));
+        }
+    });
+}
+
 // Check according to the request's "ConsistentRead" field, which consistency
 // level we need to use for the read. The field can be True for strongly
 // consistent reads, or False for eventually consistent reads, or if this
@@ -2697,6 +3061,12 @@ future<executor::request_return_type> executor::get_item(client_state& client_st
     });
 }
 
+static rjson::value describe_multi_item(schema_ptr schema,
+        const query::partition_slice& slice,
+        const cql3::selection::selection& selection,
+        const query::result& query_result,
+        const std::unordered_set<std::string>& attrs_to_get);
+
 future<executor::request_return_type> executor::batch_get_item(client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value request) {
     // FIXME: In this implementation, an unbounded batch size can cause
     // unbounded response JSON object to be buffered in memory, unbounded
@@ -2708,18 +3078,24 @@ future<executor::request_return_type> executor::batch_get_item(client_state& cli
 
     // We need to validate all the parameters before starting any asynchronous
     // query, and fail the entire request on any parse error. So we parse all
-    // the input into our own vector "requests".
+    // the input into our own vector "requests". The requested items of each
+    // partition are grouped, so they are all read with a single query.
     struct table_requests {
         schema_ptr schema;
         db::consistency_level cl;
         std::unordered_set<std::string> attrs_to_get;
-        struct single_request {
+        // The table's request without its keys, returned with the keys
+        // which could not be read in UnprocessedKeys.
+        rjson::value unprocessed;
+        struct partition_request {
             partition_key pk;
-            clustering_key ck;
+            std::vector<clustering_key> cks;
+            std::vector<rjson::value> keys;
         };
-        std::vector<single_request> requests;
+        std::vector<partition_request> requests;
     };
     std::vector<table_requests> requests;
+    requests.reserve(request_items.MemberCount());
 
     for (auto it = request_items.MemberBegin(); it != request_items.MemberEnd(); ++it) {
         table_requests rs;
@@ -2727,61 +3103,110 @@ future<executor::request_return_type> executor::batch_get_item(client_state& cli
         tracing::add_table_name(trace_state, sstring(executor::KEYSPACE_NAME_PREFIX) + rs.schema->cf_name(), rs.schema->cf_name());
         rs.cl = get_read_consistency(it->value);
         rs.attrs_to_get = calculate_attrs_to_get(it->value);
+        rs.unprocessed = rjson::copy(it->value);
+        rjson::remove_member(rs.unprocessed, "Keys");
+        std::unordered_map<partition_key, size_t, partition_key::hashing, partition_key::equality> partitions(
+                1, partition_key::hashing(*rs.schema), partition_key::equality(*rs.schema));
+        std::unordered_set<primary_key, primary_key_hash, primary_key_equal> used_keys(
+                1, primary_key_hash{rs.schema}, primary_key_equal{rs.schema});
         auto& keys = (it->value)["Keys"];
         for (const rjson::value& key : keys.GetArray()) {
-            rs.requests.push_back({pk_from_json(key, rs.schema), ck_from_json(key, rs.schema)});
+            auto pk = pk_from_json(key, rs.schema);
+            auto ck = ck_from_json(key, rs.schema);
             check_key(key, rs.schema);
+            if (!used_keys.insert(std::make_pair(pk, ck)).second) {
+                return make_ready_future<request_return_type>(api_error("ValidationException", "Provided list of item keys contains duplicates"));
+            }
+            auto [p, inserted] = partitions.emplace(pk, rs.requests.size());
+            if (inserted) {
+                rs.requests.push_back({std::move(pk), {}, {}});
+            }
+            rs.requests[p->second].cks.push_back(std::move(ck));
+            rs.requests[p->second].keys.push_back(rjson::copy(key));
         }
         requests.emplace_back(std::move(rs));
     }
 
-    // If got here, all "requests" are valid, so let's start them all
-    // in parallel. The requests object are then immediately destroyed.
-    std::vector<future<std::tuple<std::string, std::optional<rjson::value>>>> response_futures;
-    for (const auto& rs : requests) {
-        for (const auto &r : rs.requests) {
-            dht::partition_range_vector partition_ranges{dht::partition_range(dht::decorate_key(*rs.schema, std::move(r.pk)))};
+    // If got here, all "requests" are valid, so let's start them all in
+    // parallel. A read which fails because the cluster is overloaded or
+    // unavailable doesn't fail the whole request: its keys are returned in
+    // UnprocessedKeys, for the client to retry.
+    struct partition_read {
+        const table_requests* table;
+        table_requests::partition_request* partition;
+        std::optional<rjson::value> items;
+        std::exception_ptr error;
+    };
+    return do_with(std::move(requests), std::vector<partition_read>(), [this, &client_state, permit = std::move(permit)] (std::vector<table_requests>& requests, std::vector<partition_read>& reads) {
+        for (auto& rs : requests) {
+            for (auto& r : rs.requests) {
+                reads.push_back({&rs, &r, std::nullopt, nullptr});
+            }
+        }
+        return parallel_for_each(reads, [this, &client_state, &permit] (partition_read& read) {
+            auto& rs = *read.table;
+            auto& r = *read.partition;
+            dht::partition_range_vector partition_ranges{dht::partition_range(dht::decorate_key(*rs.schema, r.pk))};
             std::vector<query::clustering_range> bounds;
             if (rs.schema->clustering_key_size() == 0) {
                 bounds.push_back(query::clustering_range::make_open_ended_both_sides());
             } else {
-                bounds.push_back(query::clustering_range::make_singular(std::move(r.ck)));
+                std::sort(r.cks.begin(), r.cks.end(), clustering_key::less_compare(*rs.schema));
+                for (auto& ck : r.cks) {
+                    bounds.push_back(query::clustering_range::make_singular(std::move(ck)));
+                }
             }
             auto regular_columns = boost::copy_range<query::column_id_vector>(
                     rs.schema->regular_columns() | boost::adaptors::transformed([] (const column_definition& cdef) { return cdef.id; }));
             auto selection = cql3::selection::selection::wildcard(rs.schema);
             auto partition_slice = query::partition_slice(std::move(bounds), {}, std::move(regular_columns), selection->get_query_options());
             auto command = ::make_lw_shared<query::read_command>(rs.schema->id(), rs.schema->version(), partition_slice, query::max_partitions);
-            future<std::tuple<std::string, std::optional<rjson::value>>> f = _proxy.query(rs.schema, std::move(command), std::move(partition_ranges), rs.cl, service::storage_proxy::coordinator_query_options(default_timeout(), permit, client_state)).then(
-                    [schema = rs.schema, partition_slice = std::move(partition_slice), selection = std::move(selection), attrs_to_get = rs.attrs_to_get] (service::storage_proxy::coordinator_query_result qr) mutable {
-                std::optional<rjson::value> json = describe_single_item(schema, partition_slice, *selection, *qr.query_result, std::move(attrs_to_get));
-                return make_ready_future<std::tuple<std::string, std::optional<rjson::value>>>(
-                        std::make_tuple(schema->cf_name(), std::move(json)));
+            return _proxy.query(rs.schema, std::move(command), std::move(partition_ranges), rs.cl, service::storage_proxy::coordinator_query_options(default_timeout(), permit, client_state)).then_wrapped(
+                    [&read, partition_slice = std::move(partition_slice), selection = std::move(selection)] (future<service::storage_proxy::coordinator_query_result> f) {
+                try {
+                    auto qr = f.get0();
+                    read.items = describe_multi_item(read.table->schema, partition_slice, *selection, *qr.query_result, read.table->attrs_to_get);
+                } catch (exceptions::cassandra_exception&) {
+                    read.error = std::current_exception();
+                }
             });
-            response_futures.push_back(std::move(f));
-        }
-    }
-
-    // Wait for all requests to complete, and then return the response.
-    // FIXME: If one of the requests failed this will fail the entire request.
-    // What we should do instead is to return the failed key in the array
-    // UnprocessedKeys (which the BatchGetItem API supports) and let the user
-    // try again. Note that simply a missing key is *not* an error (we already
-    // handled it above), but this case does include things like timeouts,
-    // unavailable CL, etc.
-    return when_all_succeed(response_futures.begin(), response_futures.end()).then(
-            [] (std::vector<std::tuple<std::string, std::optional<rjson::value>>> responses) {
-        rjson::value response = rjson::empty_object();
-        rjson::set(response, "Responses", rjson::empty_object());
-        for (auto& t : responses) {
-            if (!response["Responses"].HasMember(std::get<0>(t).c_str())) {
-                rjson::set_with_string_name(response["Responses"], std::get<0>(t), rjson::empty_array());
+        }).then([&requests, &reads] {
+            // Unprocessed keys are only meaningful if some were processed,
+            // otherwise fail the request with the first error.
+            if (!reads.empty() && boost::algorithm::all_of(reads, [] (const partition_read& read) { return bool(read.error); })) {
+                return make_exception_future<executor::request_return_type>(reads.front().error);
             }
-            if (std::get<1>(t)) {
-                rjson::push_back(response["Responses"][std::get<0>(t)], std::move(*std::get<1>(t)));
+            rjson::value response = rjson::empty_object();
+            rjson::value responses = rjson::empty_object();
+            rjson::value unprocessed_keys = rjson::empty_object();
+            for (auto& rs : requests) {
+                if (!rjson::find(responses, rs.schema->cf_name())) {
+                    rjson::set_with_string_name(responses, rs.schema->cf_name(), rjson::empty_array());
+                }
             }
-        }
-        return make_ready_future<executor::request_return_type>(make_jsonable(std::move(response)));
+            for (auto& read : reads) {
+                std::string_view table_name = read.table->schema->cf_name();
+                if (read.items) {
+                    rjson::value& items = rjson::get(responses, table_name);
+                    for (auto& item : read.items->GetArray()) {
+                        rjson::push_back(items, std::move(item));
+                    }
+                } else {
+                    if (!rjson::find(unprocessed_keys, table_name)) {
+                        rjson::value table_unprocessed = rjson::copy(read.table->unprocessed);
+                        rjson::set(table_unprocessed, "Keys", rjson::empty_array());
+                        rjson::set_with_string_name(unprocessed_keys, table_name, std::move(table_unprocessed));
+                    }
+                    rjson::value& keys = rjson::get(rjson::get(unprocessed_keys, table_name), "Keys");
+                    for (auto& key : read.partition->keys) {
+                        rjson::push_back(keys, std::move(key));
+                    }
+                }
+            }
+            rjson::set(response, "Responses", std::move(responses));
+            rjson::set(response, "UnprocessedKeys", std::move(unprocessed_keys));
+            return make_ready_future<executor::request_return_type>(make_jsonable(std::move(response)));
+        });
     });
 }
 
@@ -2846,6 +3271,20 @@ class describe_items_visitor {
     }
 };
 
+// Describes all the items of a partition read by BatchGetItem.
+static rjson::value describe_multi_item(schema_ptr schema,
+        const query::partition_slice& slice,
+        const cql3::selection::selection& selection,
+        const query::result& query_result,
+        const std::unordered_set<std::string>& attrs_to_get) {
+    cql3::selection::result_set_builder builder(selection, gc_clock::now(), cql_serialization_format::latest());
+    query::result_view::consume(query_result, slice, cql3::selection::result_set_builder::visitor(builder, *schema, selection));
+    auto result_set = builder.build();
+    describe_items_visitor visitor(selection.get_columns(), attrs_to_get);
+    result_set->visit(visitor);
+    return std::move(visitor).get_items();
+}
+
 static rjson::value describe_items(schema_ptr schema, const query::partition_slice& slice, const cql3::selection::selection& selection, std::unique_ptr<cql3::result_set> result_set, std::unordered_set<std::string>&& attrs_to_get) {
     describe_items_visitor visitor(selection.get_columns(), attrs_to_get);
     result_set->visit(visitor);
@@ -2935,15 +3374,35 @@ static future<executor::request_return_type> do_query(schema_ptr schema,
         if (paging_state) {
             rjson::set(items, "LastEvaluatedKey", encode_paging_state(*schema, *paging_state));
         }
-        return make_ready_future<executor::request_return_type>(make_jsonable(std::move(items)));
+        return make_ready_future<executor::request_return_type>(make_streamed(std::move(items)));
     });
 }
 
+// DynamoDB's limit on TotalSegments.
+static constexpr int max_scan_segments = 1000000;
+
+// Returns the token range scanned by the given segment of a parallel scan.
+// The token ring is split into total_segments contiguous, equally sized
+// ranges, so the segments are disjoint and together cover the whole table.
+// Each page of a segment's scan repeats Segment and TotalSegments, so the
+// LastEvaluatedKey needs no extra state to resume within the segment.
+static dht::partition_range get_scan_segment_range(int segment, int total_segments) {
+    auto segment_start = [total_segments] (int i) -> std::optional<dht::partition_range::bound> {
+        if (i == 0 || i == total_segments) {
+            return std::nullopt;
+        }
+        // Tokens are offset from the minimum int64, which is not a valid token.
+        uint64_t offset = (std::numeric_limits<uint64_t>::max() / total_segments) * i;
+        auto t = dht::token::from_int64(int64_t(offset + uint64_t(std::numeric_limits<int64_t>::min())));
+        return dht::partition_range::bound(dht::ring_position::starting_at(t));
+    };
+    return dht::partition_range(segment_start(segment), segment_start(segment + 1));
+}
+
 // TODO(sarna):
 // 1. Paging must have 1MB boundary according to the docs. IIRC we do have a replica-side reply size limit though - verify.
 // 2. Filtering - by passing appropriately created restrictions to pager as a last parameter
 // 3. Proper timeouts instead of gc_clock::now() and db::no_timeout
-// 4. Implement parallel scanning via Segments
 future<executor::request_return_type> executor::scan(client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value request) {
     _stats.api_operations.scan++;
     elogger.trace("Scanning {}", request);
@@ -2954,10 +3413,19 @@ future<executor::request_return_type> executor::scan(client_state& client_state,
         return make_ready_future<request_return_type>(api_error("ValidationException",
                 "FilterExpression is not yet implemented in alternator"));
     }
-    if (get_int_attribute(request, "Segment") || get_int_attribute(request, "TotalSegments")) {
-        // FIXME: need to support parallel scan. See issue #5059.
+    auto segment = get_int_attribute(request, "Segment");
+    auto total_segments = get_int_attribute(request, "TotalSegments");
+    if (bool(segment) != bool(total_segments)) {
+        return make_ready_future<request_return_type>(api_error("ValidationException",
+                "Segment and TotalSegments must be specified together"));
+    }
+    if (total_segments && (*total_segments < 1 || *total_segments > max_scan_segments)) {
+        return make_ready_future<request_return_type>(api_error("ValidationException",
+                format("TotalSegments must be between 1 and {}, got {}", max_scan_segments, *total_segments)));
+    }
+    if (segment && (*segment < 0 || *segment >= *total_segments)) {
         return make_ready_future<request_return_type>(api_error("ValidationException",
-                "Scan Segment/TotalSegments is not yet implemented in alternator"));
+                format("Segment must be between 0 and TotalSegments - 1 ({}), got {}", *total_segments - 1, *segment)));
     }
 
     rjson::value* exclusive_start_key = rjson::find(request, "ExclusiveStartKey");
@@ -2982,10 +3450,35 @@ future<executor::request_return_type> executor::scan(client_state& client_state,
     ::shared_ptr<cql3::restrictions::statement_restrictions> filtering_restrictions;
     if (scan_filter) {
         const cql3::query_options query_options = cql3::query_options(cl, infinite_timeout_config, std::vector<cql3::raw_value>{});
-        filtering_restrictions = get_filtering_restrictions(schema, attrs_column(*schema), *scan_filter);
+        filtering_restrictions = get_filtering_restrictions(schema, attrs_column(*schema), *scan_filter, compact_attributes_supported(_proxy));
         partition_ranges = filtering_restrictions->get_partition_key_ranges(query_options);
         ck_bounds = filtering_restrictions->get_clustering_bounds(query_options);
     }
+    if (segment) {
+        auto segment_range = get_scan_segment_range(*segment, *total_segments);
+        dht::ring_position_comparator cmp(*schema);
+        if (exclusive_start_key) {
+            auto dk = dht::decorate_key(*schema, pk_from_json(*exclusive_start_key, schema));
+            if (!segment_range.contains(dht::ring_position(dk), cmp)) {
+                return make_ready_future<request_return_type>(api_error("ValidationException",
+                        format("ExclusiveStartKey does not belong to Segment {}", *segment)));
+            }
+        }
+        dht::partition_range_vector segment_ranges;
+        for (auto& pr : partition_ranges) {
+            if (auto r = pr.intersection(segment_range, cmp)) {
+                segment_ranges.push_back(std::move(*r));
+            }
+        }
+        if (segment_ranges.empty()) {
+            rjson::value items = rjson::empty_object();
+            rjson::set(items, "Items", rjson::empty_array());
+            rjson::set(items, "Count", rjson::value(0));
+            rjson::set(items, "ScannedCount", rjson::value(0));
+            return make_ready_future<request_return_type>(make_jsonable(std::move(items)));
+        }
+        partition_ranges = std::move(segment_ranges);
+    }
     return do_query(schema, exclusive_start_key, std::move(partition_ranges), std::move(ck_bounds), std::move(attrs_to_get), limit, cl, std::move(filtering_restrictions), client_state, _stats.cql_stats, trace_state, std::move(permit));
 }
 
@@ -3462,7 +3955,7 @@ future<executor::request_return_type> executor::query(client_state& client_state
 
     ::shared_ptr<cql3::restrictions::statement_restrictions> filtering_restrictions;
     if (query_filter) {
-        filtering_restrictions = get_filtering_restrictions(schema, attrs_column(*schema), *query_filter);
+        filtering_restrictions = get_filtering_restrictions(schema, attrs_column(*schema), *query_filter, compact_attributes_supported(_proxy));
         auto pk_defs = filtering_restrictions->get_partition_key_restrictions()->get_column_defs();
         auto ck_defs = filtering_restrictions->get_clustering_columns_restrictions()->get_column_defs();
         if (!pk_defs.empty()) {
@@ -3494,7 +3987,8 @@ future<executor::request_return_type> executor::list_tables(client_state& client
     auto table_names = _proxy.get_db().local().get_column_families()
             | boost::adaptors::map_values
             | boost::adaptors::filtered([] (const lw_shared_ptr<table>& t) {
-                        return t->schema()->ks_name().find(KEYSPACE_NAME_PREFIX) == 0 && !t->schema()->is_view();
+                        return t->schema()->ks_name().find(KEYSPACE_NAME_PREFIX) == 0 && !t->schema()->is_view()
+                                && !cdc::is_log_for_some_table(t->schema()->ks_name(), t->schema()->cf_name());
                     })
             | boost::adaptors::transformed([] (const lw_shared_ptr<table>& t) {
                         return t->schema()->cf_name();
@@ -3550,6 +4044,602 @@ future<executor::request_return_type> executor::describe_endpoints(client_state&
     return make_ready_future<executor::request_return_type>(make_jsonable(std::move(response)));
 }
 
+// Alternator Streams
+//
+// The stream of a table is its CDC log. CDC writes each change of a base
+// partition into one of the streams of the current CDC generation, and the
+// stream ids are chosen so that a stream's partition of the log is owned
+// by the same replicas and shard as the base partitions written to it.
+// Every (generation, stream id) pair is exposed as one DynamoDB shard, so
+// GetRecords reads a single partition of the log, and it is executed on the
+// shard owning that partition.
+//
+// A position in a shard is the clustering key of a log row, (cdc$time,
+// cdc$batch_seq_no). SequenceNumber encodes it as a decimal string which
+// sorts like the position itself: the timestamp of the timeuuid, followed by
+// its clock sequence and node (20 digits) and by the batch sequence number
+// (10 digits).
+
+struct stream_position {
+    utils::UUID time;
+    int32_t batch_seq_no = 0;
+};
+
+static sstring sequence_number(const stream_position& p) {
+    return format("{:d}{:020d}{:010d}", p.time.timestamp(), uint64_t(p.time.get_least_significant_bits()), uint32_t(p.batch_seq_no));
+}
+
+static std::optional<stream_position> parse_sequence_number(std::string_view s) {
+    static constexpr size_t suffix_digits = 30;
+    if (s.size() <= suffix_digits || s.size() > suffix_digits + 18 || !std::all_of(s.begin(), s.end(), ::isdigit)) {
+        return {};
+    }
+    uint64_t timestamp = std::stoull(std::string(s.substr(0, s.size() - suffix_digits)));
+    uint64_t lsb = std::stoull(std::string(s.substr(s.size() - suffix_digits, 20)));
+    uint64_t batch_seq_no = std::stoull(std::string(s.substr(s.size() - 10)));
+    if (timestamp >= (uint64_t(1) << 60) || batch_seq_no > uint64_t(std::numeric_limits<int32_t>::max())) {
+        return {};
+    }
+    // The inverse of utils::UUID::timestamp() (for a version 1 UUID).
+    uint64_t msb = ((timestamp & 0xffffffff) << 32) | (((timestamp >> 32) & 0xffff) << 16) | 0x1000 | ((timestamp >> 48) & 0xfff);
+    return stream_position{utils::UUID(int64_t(msb), int64_t(lsb)), int32_t(batch_seq_no)};
+}
+
+// The first position of a generation.
+static stream_position generation_start(db_clock::time_point generation) {
+    return stream_position{utils::UUID_gen::min_time_UUID(generation.time_since_epoch().count()), 0};
+}
+
+// A shard of a stream: a CDC stream id of a given CDC generation.
+// Its ShardId is 'H', the generation's timestamp in milliseconds and the
+// stream id, both in hex.
+struct stream_shard {
+    db_clock::time_point generation;
+    cdc::stream_id id;
+};
+
+static sstring shard_id(const stream_shard& shard) {
+    return format("H{:x}:{}", shard.generation.time_since_epoch().count(), to_hex(shard.id.to_bytes()));
+}
+
+static std::optional<stream_shard> parse_shard_id(std::string_view s) {
+    auto colon = s.find(':');
+    if (s.size() < 2 || s[0] != 'H' || colon == std::string_view::npos || colon == 1) {
+        return {};
+    }
+    try {
+        auto ms = std::stoull(std::string(s.substr(1, colon - 1)), nullptr, 16);
+        bytes id = from_hex(sstring_view(s.data() + colon + 1, s.size() - colon - 1));
+        if (id.size() != 16) {
+            return {};
+        }
+        return stream_shard{db_clock::time_point(db_clock::duration(ms)), cdc::stream_id(std::move(id))};
+    } catch (...) {
+        return {};
+    }
+}
+
+// A shard iterator names a shard of a stream and a position in it, with
+// the record at that position either included or not.
+struct shard_iterator {
+    utils::UUID arn;
+    stream_shard shard;
+    stream_position position;
+    bool inclusive;
+};
+
+static sstring shard_iterator_string(const shard_iterator& it) {
+    return format("{}|{}|{}|{}", it.arn, shard_id(it.shard), sequence_number(it.position), it.inclusive ? 'i' : 'e');
+}
+
+static shard_iterator parse_shard_iterator(const rjson::value& request) {
+    const rjson::value* it = rjson::find(request, "ShardIterator");
+    if (!it || !it->IsString()) {
+        throw api_error("ValidationException", "Missing ShardIterator");
+    }
+    std::string_view s(it->GetString(), it->GetStringLength());
+    std::vector<std::string_view> parts;
+    for (size_t pos = 0;;) {
+        auto next = s.find('|', pos);
+        parts.push_back(s.substr(pos, next == std::string_view::npos ? next : next - pos));
+        if (next == std::string_view::npos) {
+            break;
+        }
+        pos = next + 1;
+    }
+    if (parts.size() == 4 && (parts[3] == "i" || parts[3] == "e")) {
+        auto shard = parse_shard_id(parts[1]);
+        auto position = parse_sequence_number(parts[2]);
+        if (shard && position) {
+            try {
+                return shard_iterator{utils::UUID(sstring_view(parts[0].data(), parts[0].size())), std::move(*shard), *position, parts[3] == "i"};
+            } catch (...) {
+                // fall through to the error below
+            }
+        }
+    }
+    throw api_error("ValidationException", format("Invalid ShardIterator: {}", s));
+}
+
+static utils::UUID get_stream_arn(const rjson::value& request) {
+    const rjson::value* arn = rjson::find(request, "StreamArn");
+    if (!arn || !arn->IsString()) {
+        throw api_error("ValidationException", "Missing StreamArn");
+    }
+    try {
+        return utils::UUID(sstring_view(arn->GetString(), arn->GetStringLength()));
+    } catch (...) {
+        throw api_error("ResourceNotFoundException", format("Requested resource not found: Stream {} not found", arn->GetString()));
+    }
+}
+
+// Finds the CDC log table a StreamArn refers to and the Alternator table
+// it is the log of, returned in this order.
+static std::pair<schema_ptr, schema_ptr> get_stream(const database& db, const utils::UUID& arn) {
+    try {
+        schema_ptr log_schema = db.find_schema(arn);
+        const auto& ks_name = log_schema->ks_name();
+        if (ks_name.find(executor::KEYSPACE_NAME_PREFIX) == 0 && cdc::is_log_for_some_table(ks_name, log_schema->cf_name())) {
+            // An Alternator table is the only table of its keyspace, which
+            // is named after it.
+            schema_ptr base = db.find_schema(ks_name, ks_name.substr(strlen(executor::KEYSPACE_NAME_PREFIX)));
+            return {std::move(log_schema), std::move(base)};
+        }
+    } catch (no_such_column_family&) {
+    }
+    throw api_error("ResourceNotFoundException", format("Requested resource not found: Stream {} not found", arn));
+}
+
+static int get_limit(const rjson::value& request, int default_limit, int max_limit) {
+    const rjson::value* limit = rjson::find(request, "Limit");
+    if (!limit) {
+        return default_limit;
+    }
+    if (!limit->IsInt() || limit->GetInt() < 1 || limit->GetInt() > max_limit) {
+        throw api_error("ValidationException", format("Limit must be greater than 0 and no greater than {}", max_limit));
+    }
+    return limit->GetInt();
+}
+
+future<executor::request_return_type> executor::list_streams(client_state& client_state, service_permit permit, rjson::value request) {
+    _stats.api_operations.list_streams++;
+    elogger.trace("Listing streams {}", request);
+
+    int limit = get_limit(request, 100, 100);
+    sstring exclusive_start(get_string_attribute(request, "ExclusiveStartStreamArn", ""));
+    std::vector<std::pair<schema_ptr, schema_ptr>> streams;
+    auto& db = _proxy.get_db().local();
+    if (rjson::find(request, "TableName")) {
+        schema_ptr base = get_table(_proxy, request);
+        if (schema_ptr log_schema = stream_log_schema(db, *base)) {
+            streams.emplace_back(std::move(log_schema), std::move(base));
+        }
+    } else {
+        for (auto& cf : db.get_column_families()) {
+            const schema_ptr& base = cf.second->schema();
+            if (base->ks_name().find(KEYSPACE_NAME_PREFIX) != 0 || base->is_view()) {
+                continue;
+            }
+            if (schema_ptr log_schema = stream_log_schema(db, *base)) {
+                streams.emplace_back(std::move(log_schema), base);
+            }
+        }
+    }
+    // Tables are kept in an unordered map, so sort the streams to page
+    // through them consistently.
+    boost::sort(streams, [] (const auto& a, const auto& b) { return a.first->id().to_sstring() < b.first->id().to_sstring(); });
+
+    rjson::value streams_json = rjson::empty_array();
+    auto it = streams.begin();
+    if (!exclusive_start.empty()) {
+        it = std::find_if(it, streams.end(), [&] (const auto& s) { return s.first->id().to_sstring() > exclusive_start; });
+    }
+    for (; it != streams.end() && limit > 0; ++it, --limit) {
+        rjson::value stream = rjson::empty_object();
+        auto arn = it->first->id().to_sstring();
+        rjson::set(stream, "StreamArn", rjson::from_string(arn));
+        rjson::set(stream, "StreamLabel", rjson::from_string(arn));
+        rjson::set(stream, "TableName", rjson::from_string(it->second->cf_name()));
+        rjson::push_back(streams_json, std::move(stream));
+    }
+    rjson::value response = rjson::empty_object();
+    if (it != streams.end()) {
+        rjson::set(response, "LastEvaluatedStreamArn", rjson::copy(streams_json[streams_json.Size() - 1]["StreamArn"]));
+    }
+    rjson::set(response, "Streams", std::move(streams_json));
+    return make_ready_future<executor::request_return_type>(make_jsonable(std::move(response)));
+}
+
+struct stream_generation {
+    db_clock::time_point time;
+    std::vector<cdc::stream_id> streams;
+};
+
+static const timeout_config stream_generations_timeout_config = [] {
+    const auto t = 10s;
+    return timeout_config{ t, t, t, t, t, t, t };
+}();
+
+// Reads the CDC generations, oldest first, from the user-facing
+// description of CDC streams. The table is written only when a generation
+// starts or expires, so reading it at CL=ONE is good enough.
+static future<std::vector<stream_generation>> get_stream_generations() {
+    static const sstring query = format("SELECT time, streams FROM {}.{}",
+            db::system_distributed_keyspace::NAME, db::system_distributed_keyspace::CDC_DESC);
+    return cql3::get_query_processor().local().execute_internal(query, db::consistency_level::ONE,
+            stream_generations_timeout_config, {}, true).then([] (::shared_ptr<cql3::untyped_result_set> rs) {
+        std::vector<stream_generation> generations;
+        for (const auto& row : *rs) {
+            stream_generation g{row.get_as<db_clock::time_point>("time"), {}};
+            if (row.has("streams")) {
+                std::vector<bytes> ids;
+                row.get_set_data<bytes>("streams", std::back_inserter(ids), bytes_type);
+                g.streams = boost::copy_range<std::vector<cdc::stream_id>>(ids
+                        | boost::adaptors::transformed([] (bytes& id) { return cdc::stream_id(std::move(id)); }));
+                boost::sort(g.streams);
+            }
+            generations.push_back(std::move(g));
+        }
+        boost::sort(generations, [] (const stream_generation& a, const stream_generation& b) { return a.time < b.time; });
+        return generations;
+    });
+}
+
+future<executor::request_return_type> executor::describe_stream(client_state& client_state, service_permit permit, rjson::value request) {
+    _stats.api_operations.describe_stream++;
+    elogger.trace("Describing stream {}", request);
+
+    auto arn = get_stream_arn(request);
+    auto [log_schema, base] = get_stream(_proxy.get_db().local(), arn);
+    int limit = get_limit(request, 100, 100);
+    std::string exclusive_start = get_string_attribute(request, "ExclusiveStartShardId", "");
+
+    return get_stream_generations().then([arn, base = std::move(base), limit, exclusive_start = std::move(exclusive_start)] (std::vector<stream_generation> generations) mutable {
+        rjson::value description = rjson::empty_object();
+        rjson::set(description, "StreamArn", rjson::from_string(arn.to_sstring()));
+        rjson::set(description, "StreamLabel", rjson::from_string(arn.to_sstring()));
+        rjson::set(description, "StreamStatus", "ENABLED");
+        rjson::set(description, "StreamViewType", rjson::from_string(stream_view_type(base->cdc_options())));
+        rjson::set(description, "TableName", rjson::from_string(base->cf_name()));
+        std::unordered_map<std::string,std::string> key_attribute_types;
+        describe_key_schema(description, *base, key_attribute_types);
+
+        // The shards of a generation are open until the next generation
+        // starts. Older shards are kept in the list, until CDC's TTL removes
+        // their records, so that a reader can finish consuming them.
+        rjson::value shards = rjson::empty_array();
+        bool skipping = !exclusive_start.empty();
+        sstring last_sid;
+        bool more = false;
+        for (auto g = generations.begin(); g != generations.end() && !more; ++g) {
+            auto next = std::next(g);
+            for (const auto& id : g->streams) {
+                auto sid = shard_id(stream_shard{g->time, id});
+                if (skipping) {
+                    skipping = sid != exclusive_start;
+                    continue;
+                }
+                if (limit == 0) {
+                    more = true;
+                    break;
+                }
+                rjson::value range = rjson::empty_object();
+                rjson::set(range, "StartingSequenceNumber", rjson::from_string(sequence_number(generation_start(g->time))));
+                if (next != generations.end()) {
+                    rjson::set(range, "EndingSequenceNumber", rjson::from_string(sequence_number(generation_start(next->time))));
+                }
+                rjson::value shard = rjson::empty_object();
+                rjson::set(shard, "ShardId", rjson::from_string(sid));
+                rjson::set(shard, "SequenceNumberRange", std::move(range));
+                rjson::push_back(shards, std::move(shard));
+                last_sid = std::move(sid);
+                --limit;
+            }
+        }
+        rjson::set(description, "Shards", std::move(shards));
+        if (more) {
+            rjson::set(description, "LastEvaluatedShardId", rjson::from_string(last_sid));
+        }
+        rjson::value response = rjson::empty_object();
+        rjson::set(response, "StreamDescription", std::move(description));
+        return make_ready_future<executor::request_return_type>(make_jsonable(std::move(response)));
+    });
+}
+
+future<executor::request_return_type> executor::get_shard_iterator(client_state& client_state, service_permit permit, rjson::value request) {
+    _stats.api_operations.get_shard_iterator++;
+    elogger.trace("Getting shard iterator {}", request);
+
+    auto arn = get_stream_arn(request);
+    get_stream(_proxy.get_db().local(), arn);
+    std::string sid = get_string_attribute(request, "ShardId", "");
+    auto shard = parse_shard_id(sid);
+    if (!shard) {
+        return make_ready_future<request_return_type>(api_error("ResourceNotFoundException",
+                format("Requested resource not found: Shard {} not found", sid)));
+    }
+    std::string type = get_string_attribute(request, "ShardIteratorType", "");
+    std::optional<stream_position> position;
+    bool inclusive = true;
+    if (type == "TRIM_HORIZON") {
+        position = generation_start(shard->generation);
+    } else if (type == "LATEST") {
+        position = stream_position{utils::UUID_gen::get_time_UUID(), 0};
+        inclusive = false;
+    } else if (type == "AT_SEQUENCE_NUMBER" || type == "AFTER_SEQUENCE_NUMBER") {
+        std::string seq = get_string_attribute(request, "SequenceNumber", "");
+        position = parse_sequence_number(seq);
+        if (!position) {
+            return make_ready_future<request_return_type>(api_error("ValidationException",
+                    format("Invalid SequenceNumber '{}' for ShardIteratorType {}", seq, type)));
+        }
+        inclusive = type == "AT_SEQUENCE_NUMBER";
+    } else {
+        return make_ready_future<request_return_type>(api_error("ValidationException",
+                format("Invalid ShardIteratorType '{}'", type)));
+    }
+    rjson::value response = rjson::empty_object();
+    rjson::set(response, "ShardIterator", rjson::from_string(shard_iterator_string(shard_iterator{arn, std::move(*shard), *position, inclusive})));
+    return make_ready_future<executor::request_return_type>(make_jsonable(std::move(response)));
+}
+
+// One change to an item, built from the consecutive log rows of one
+// cdc$time with the same base key: the optional preimage, the delta and
+// the optional postimage.
+struct stream_record {
+    stream_position first;
+    stream_position last;
+    std::vector<bytes_opt> key;
+    rjson::value keys = rjson::empty_object();
+    std::optional<rjson::value> old_image;
+    std::optional<rjson::value> new_image;
+    std::optional<cdc::operation> operation;
+    size_t size = 0;
+};
+
+// Where the columns of a base table and of CDC's metadata are in the rows
+// of a log read with a wildcard selection.
+struct log_row_layout {
+    size_t time;
+    size_t batch_seq_no;
+    size_t operation;
+    // Key columns of the base table, followed by its other non-:attrs
+    // columns (the sort keys of LSIs), with their base definitions.
+    std::vector<std::pair<size_t, const column_definition*>> columns;
+    size_t key_columns;
+    std::optional<size_t> attrs;
+
+    log_row_layout(const schema& base, const cql3::selection::selection& selection) {
+        const auto& selected = selection.get_columns();
+        auto index_of = [&] (const sstring& name) {
+            auto it = boost::find_if(selected, [&] (const column_definition* c) { return c->name_as_text() == name; });
+            if (it == selected.end()) {
+                throw api_error("InternalServerError", format("Column {} is missing from the log of {}", name, base.cf_name()));
+            }
+            return size_t(it - selected.begin());
+        };
+        time = index_of(cdc::log_meta_column_name("time"));
+        batch_seq_no = index_of(cdc::log_meta_column_name("batch_seq_no"));
+        operation = index_of(cdc::log_meta_column_name("operation"));
+        for (const column_definition& cdef : boost::range::join(base.partition_key_columns(), base.clustering_key_columns())) {
+            columns.emplace_back(index_of(cdc::log_data_column_name(cdef.name_as_text())), &cdef);
+        }
+        key_columns = columns.size();
+        for (const column_definition& cdef : base.regular_columns()) {
+            if (cdef.name_as_text() == executor::ATTRS_COLUMN_NAME) {
+                attrs = index_of(cdc::log_data_column_name(cdef.name_as_text()));
+            } else {
+                columns.emplace_back(index_of(cdc::log_data_column_name(cdef.name_as_text())), &cdef);
+            }
+        }
+    }
+};
+
+// Converts the base columns of a log row to a DynamoDB item.
+static rjson::value log_row_to_item(const std::vector<bytes_opt>& row, const log_row_layout& layout, const column_definition& attrs_cdef, bool keys_only) {
+    rjson::value item = rjson::empty_object();
+    size_t n = keys_only ? layout.key_columns : layout.columns.size();
+    for (size_t i = 0; i < n; ++i) {
+        auto& [idx, cdef] = layout.columns[i];
+        if (row[idx]) {
+            rjson::value field = rjson::empty_object();
+            rjson::set_with_string_name(field, type_to_string(cdef->type), json_key_column_value(*row[idx], *cdef));
+            rjson::set_with_string_name(item, cdef->name_as_text(), std::move(field));
+        }
+    }
+    if (!keys_only && layout.attrs && row[*layout.attrs]) {
+        auto deserialized = attrs_cdef.type->deserialize(*row[*layout.attrs], cql_serialization_format::latest());
+        for (auto& entry : value_cast<map_type_impl::native_type>(deserialized)) {
+            rjson::set_with_string_name(item, value_cast<sstring>(entry.first), deserialize_item(value_cast<bytes>(entry.second)));
+        }
+    }
+    return item;
+}
+
+static std::vector<stream_record> parse_log_rows(const schema& base, const schema& log_schema, const cql3::selection::selection& selection, const cql3::result_set& result_set) {
+    log_row_layout layout(base, selection);
+    const column_definition& attrs_cdef = *log_schema.get_column_definition(to_bytes(executor::ATTRS_COLUMN_NAME));
+    std::vector<stream_record> records;
+    for (const auto& row : result_set.rows()) {
+        stream_position position{
+            value_cast<utils::UUID>(timeuuid_type->deserialize(*row[layout.time])),
+            value_cast<int32_t>(int32_type->deserialize(*row[layout.batch_seq_no]))
+        };
+        auto key = boost::copy_range<std::vector<bytes_opt>>(layout.columns
+                | boost::adaptors::sliced(0, layout.key_columns)
+                | boost::adaptors::transformed([&] (const std::pair<size_t, const column_definition*>& c) { return row[c.first]; }));
+        if (records.empty() || records.back().first.time != position.time || records.back().key != key) {
+            records.emplace_back();
+            records.back().first = position;
+            records.back().key = std::move(key);
+            records.back().keys = log_row_to_item(row, layout, attrs_cdef, true);
+        }
+        stream_record& record = records.back();
+        record.last = position;
+        for (const bytes_opt& cell : row) {
+            record.size += cell ? cell->size() : 0;
+        }
+        auto op = cdc::operation(value_cast<int8_t>(byte_type->deserialize(*row[layout.operation])));
+        switch (op) {
+        case cdc::operation::pre_image:
+            record.old_image = log_row_to_item(row, layout, attrs_cdef, false);
+            break;
+        case cdc::operation::post_image:
+            record.new_image = log_row_to_item(row, layout, attrs_cdef, false);
+            break;
+        default:
+            record.operation = op;
+            break;
+        }
+    }
+    return records;
+}
+
+// PutItem replaces an item by deleting it with a timestamp just before the
+// one of the new data, and CDC logs the two parts separately. Merges such a
+// pair back into the single change the user made.
+static std::vector<stream_record> merge_replacements(std::vector<stream_record> records) {
+    std::vector<stream_record> merged;
+    for (auto& record : records) {
+        if (!merged.empty()) {
+            stream_record& prev = merged.back();
+            if (prev.operation == cdc::operation::row_delete && prev.key == record.key
+                    && (record.operation == cdc::operation::insert || record.operation == cdc::operation::update)
+                    && utils::UUID_gen::micros_timestamp(record.first.time) == utils::UUID_gen::micros_timestamp(prev.first.time) + 1) {
+                prev.last = record.last;
+                prev.operation = record.operation;
+                prev.new_image = std::move(record.new_image);
+                if (!prev.old_image) {
+                    prev.old_image = std::move(record.old_image);
+                }
+                prev.size += record.size;
+                continue;
+            }
+        }
+        merged.push_back(std::move(record));
+    }
+    return merged;
+}
+
+static std::optional<rjson::value> record_to_json(stream_record& record, const schema& base) {
+    const cdc::options& options = base.cdc_options();
+    std::string_view event_name;
+    switch (record.operation.value_or(cdc::operation::pre_image)) {
+    case cdc::operation::update:
+    case cdc::operation::insert:
+        // Every Alternator write creates a row marker, so whether the item
+        // existed before is only known from the preimage. Without one, a
+        // write is reported as a modification.
+        event_name = options.preimage() && !record.old_image ? "INSERT" : "MODIFY";
+        break;
+    case cdc::operation::row_delete:
+    case cdc::operation::partition_delete:
+        event_name = "REMOVE";
+        record.new_image.reset();
+        break;
+    default:
+        // Range deletions can't be made through the DynamoDB API.
+        return {};
+    }
+    auto seq = sequence_number(record.first);
+    rjson::value dynamodb = rjson::empty_object();
+    rjson::set(dynamodb, "ApproximateCreationDateTime", rjson::value(utils::UUID_gen::unix_timestamp_in_sec(record.first.time).count()));
+    rjson::set(dynamodb, "Keys", std::move(record.keys));
+    if (record.new_image && options.postimage()) {
+        rjson::set(dynamodb, "NewImage", std::move(*record.new_image));
+    }
+    if (record.old_image && options.preimage()) {
+        rjson::set(dynamodb, "OldImage", std::move(*record.old_image));
+    }
+    rjson::set(dynamodb, "SequenceNumber", rjson::from_string(seq));
+    rjson::set(dynamodb, "SizeBytes", rjson::value(record.size));
+    rjson::set(dynamodb, "StreamViewType", rjson::from_string(stream_view_type(options)));
+    rjson::value json = rjson::empty_object();
+    rjson::set(json, "eventID", rjson::from_string(seq));
+    rjson::set(json, "eventName", rjson::from_string(event_name));
+    rjson::set(json, "eventSource", "scylladb:alternator");
+    rjson::set(json, "eventVersion", "1.1");
+    rjson::set(json, "dynamodb", std::move(dynamodb));
+    return json;
+}
+
+// A record is at most six log rows: a preimage, delta and postimage for
+// each of the two parts of a PutItem.
+static constexpr uint32_t max_log_rows_per_record = 6;
+
+future<executor::request_return_type> executor::get_records(client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value request) {
+    _stats.api_operations.get_records++;
+    elogger.trace("Getting records {}", request);
+
+    auto iterator = parse_shard_iterator(request);
+    auto [log_schema, base] = get_stream(_proxy.get_db().local(), iterator.arn);
+    int limit = get_limit(request, 1000, 1000);
+
+    auto dk = dht::decorate_key(*log_schema, iterator.shard.id.to_partition_key(*log_schema));
+    // The log partition is owned by one shard; reading it from there saves
+    // the replica read from crossing shards.
+    auto shard = dht::shard_of(*log_schema, dk.token());
+    if (shard != this_shard_id()) {
+        _stats.api_operations.get_records--; // uncount on this shard, will be counted in other shard
+        _stats.shard_bounce_for_streams++;
+        return container().invoke_on(shard, _ssg,
+                [request = std::move(request), cs = client_state.move_to_other_shard(), gt = tracing::global_trace_state_ptr(trace_state), permit = std::move(permit)]
+                (executor& e) mutable {
+            return do_with(cs.get(), [&e, request = std::move(request), trace_state = tracing::trace_state_ptr(gt)]
+                                     (service::client_state& client_state) mutable {
+                return e.get_records(client_state, std::move(trace_state), empty_service_permit(), std::move(request));
+            });
+        });
+    }
+    tracing::add_table_name(trace_state, log_schema->ks_name(), log_schema->cf_name());
+
+    auto start = clustering_key_prefix::from_exploded(*log_schema,
+            {timeuuid_type->decompose(iterator.position.time), int32_type->decompose(iterator.position.batch_seq_no)});
+    std::vector<query::clustering_range> bounds{
+            query::clustering_range::make_starting_with(query::clustering_range::bound(std::move(start), iterator.inclusive))};
+    auto regular_columns = boost::copy_range<query::column_id_vector>(
+            log_schema->regular_columns() | boost::adaptors::transformed([] (const column_definition& cdef) { return cdef.id; }));
+    auto selection = cql3::selection::selection::wildcard(log_schema);
+    auto partition_slice = query::partition_slice(std::move(bounds), {}, std::move(regular_columns), selection->get_query_options());
+    uint32_t row_limit = limit * max_log_rows_per_record;
+    auto command = ::make_lw_shared<query::read_command>(log_schema->id(), log_schema->version(), partition_slice, row_limit);
+
+    return _proxy.query(log_schema, std::move(command), {dht::partition_range(dk)}, db::consistency_level::LOCAL_QUORUM,
+            service::storage_proxy::coordinator_query_options(default_timeout(), std::move(permit), client_state)).then(
+            [log_schema = log_schema, base = base, iterator = std::move(iterator), partition_slice = std::move(partition_slice),
+             selection = std::move(selection), limit, row_limit] (service::storage_proxy::coordinator_query_result qr) mutable {
+        cql3::selection::result_set_builder builder(*selection, gc_clock::now(), cql_serialization_format::latest());
+        query::result_view::consume(*qr.query_result, partition_slice, cql3::selection::result_set_builder::visitor(builder, *log_schema, *selection));
+        auto result_set = builder.build();
+        bool truncated = result_set->size() >= row_limit;
+        auto records = merge_replacements(parse_log_rows(*base, *log_schema, *selection, *result_set));
+        // When the read stopped at the row limit, the last record may be
+        // missing some of its rows, so leave it for the next call.
+        if (truncated && records.size() > 1) {
+            records.pop_back();
+        }
+        if (records.size() > size_t(limit)) {
+            records.erase(records.begin() + limit, records.end());
+        }
+
+        rjson::value records_json = rjson::empty_array();
+        for (auto& record : records) {
+            if (auto json = record_to_json(record, *base)) {
+                rjson::push_back(records_json, std::move(*json));
+            }
+        }
+        // Shards are never closed, so there always is a next iterator.
+        if (!records.empty()) {
+            iterator.position = records.back().last;
+            iterator.inclusive = false;
+        }
+        rjson::value response = rjson::empty_object();
+        rjson::set(response, "Records", std::move(records_json));
+        rjson::set(response, "NextShardIterator", rjson::from_string(shard_iterator_string(iterator)));
+        return make_ready_future<executor::request_return_type>(make_jsonable(std::move(response)));
+    });
+}
+
 static std::map<sstring, sstring> get_network_topology_options(int rf) {
     std::map<sstring, sstring> options;
     sstring rf_str = std::to_string(rf);
@@ -3597,9 +4687,21 @@ tracing::trace_state_ptr executor::maybe_trace_query(client_state& client_state,
 }
 
 future<> executor::start() {
-    // Currently, nothing to do on initialization. We delay the keyspace
-    // creation (create_keyspace()) until a table is actually created.
+    // We delay the keyspace creation (create_keyspace()) until a table is
+    // actually created, so the only thing to do on initialization is to
+    // accept read-modify-write operations forwarded to this node as their
+    // leader.
+    netw::get_local_messaging_service().register_alternator_forward_rmw(
+            [this] (const rpc::client_info&, rpc::opt_time_point, sstring op, sstring request) {
+        return futurize_invoke([&] {
+            return execute_forwarded_rmw(std::move(op), rjson::parse(request));
+        });
+    });
     return make_ready_future<>();
 }
 
+future<> executor::stop() {
+    return netw::get_local_messaging_service().unregister_alternator_forward_rmw();
+}
+
 }
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <seastar/core/sleep.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/core/metrics.hh>
+#include <boost/range/adaptors.hpp>
+
+#include "alternator/expiration.hh"
+#include "alternator/executor.hh"
+#include "alternator/serialization.hh"
+#include "alternator/tags_extension.hh"
+#include "alternator/error.hh"
+#include "service/storage_proxy.hh"
+#include "service/pager/query_pagers.hh"
+#include "service/query_state.hh"
+#include "cql3/selection/selection.hh"
+#include "cql3/result_set.hh"
+#include "cql3/query_options.hh"
+#include "database.hh"
+#include "types/map.hh"
+#include "dht/sharder.hh"
+#include "utils/fb_utilities.hh"
+#include "log.hh"
+
+namespace alternator {
+
+static logging::logger tlogger("alternator-ttl");
+
+// Like DynamoDB, ignore expiration times more than five years in the past,
+// which are probably not in seconds.
+static constexpr std::chrono::seconds max_expired_age = std::chrono::hours(24 * 365 * 5);
+
+// The number of rows read by each page of a scan.
+static constexpr uint32_t scan_page_size = 1000;
+// The timeout of each read of a page, and of each write of its deletions.
+static constexpr std::chrono::seconds scan_timeout(10);
+
+expiration_service::expiration_service(service::storage_proxy& proxy, std::chrono::seconds period)
+    : _proxy(proxy)
+    , _period(period)
+{
+    namespace sm = seastar::metrics;
+    _metrics.add_group("alternator", {
+        sm::make_total_operations("expiration_scan_passes", _stats.scan_passes,
+                sm::description("number of passes over all the tables with a TTL attribute")),
+        sm::make_total_operations("expiration_scan_table", _stats.scan_table,
+                sm::description("number of table scans looking for expired items")),
+        sm::make_total_operations("expiration_items_deleted", _stats.items_deleted,
+                sm::description("number of expired items deleted")),
+    });
+}
+
+future<> expiration_service::start() {
+    _end = run();
+    return make_ready_future<>();
+}
+
+future<> expiration_service::stop() {
+    _abort_source.request_abort();
+    return std::move(_end);
+}
+
+static std::optional<sstring> ttl_attribute(const schema& s) {
+    auto it = s.extensions().find(tags_extension::NAME);
+    if (it == s.extensions().end()) {
+        return {};
+    }
+    const auto& tags = static_pointer_cast<tags_extension>(it->second)->tags();
+    auto tag = tags.find(TTL_TAG_KEY);
+    if (tag == tags.end()) {
+        return {};
+    }
+    return tag->second;
+}
+
+// Whether the serialized value of a TTL attribute holds an expiration time
+// which is already in the past. Values which are not numbers never expire.
+static bool is_expired(bytes_view serialized, const big_decimal& now, const big_decimal& oldest) {
+    rjson::value v = deserialize_item(serialized);
+    if (!rjson::find(v, "N")) {
+        return false;
+    }
+    try {
+        big_decimal expiration = unwrap_number(v, "TTL attribute");
+        return expiration <= now && expiration > oldest;
+    } catch (api_error&) {
+        return false;
+    }
+}
+
+future<> expiration_service::run() {
+    return seastar::async([this] {
+        while (!_abort_source.abort_requested()) {
+            auto start = lowres_clock::now();
+            // Collect the tables first, as the list may change while scanning.
+            std::vector<std::pair<schema_ptr, sstring>> tables;
+            for (auto& cf : _proxy.get_db().local().get_column_families()) {
+                schema_ptr s = cf.second->schema();
+                if (s->is_view() || s->ks_name().find(executor::KEYSPACE_NAME_PREFIX) != 0) {
+                    continue;
+                }
+                if (auto attribute_name = ttl_attribute(*s)) {
+                    tables.emplace_back(std::move(s), std::move(*attribute_name));
+                }
+            }
+            for (auto& [s, attribute_name] : tables) {
+                if (_abort_source.abort_requested()) {
+                    break;
+                }
+                try {
+                    scan_table(s, attribute_name);
+                } catch (...) {
+                    tlogger.warn("Failed to delete expired items of {}.{}: {}", s->ks_name(), s->cf_name(), std::current_exception());
+                }
+            }
+            ++_stats.scan_passes;
+            auto elapsed = lowres_clock::now() - start;
+            if (elapsed < _period) {
+                try {
+                    sleep_abortable(_period - elapsed, _abort_source).get();
+                } catch (const sleep_aborted&) {
+                }
+            }
+        }
+    });
+}
+
+void expiration_service::scan_table(schema_ptr s, const sstring& attribute_name) {
+    ++_stats.scan_table;
+    auto& ks = _proxy.get_db().local().find_keyspace(s->ks_name());
+    auto ranges = ks.get_replication_strategy().get_primary_ranges_within_dc(utils::fb_utilities::get_broadcast_address());
+    for (auto& range : ranges) {
+        dht::selective_token_range_sharder sharder(s->get_sharder(), std::move(range), this_shard_id());
+        while (auto shard_range = sharder.next()) {
+            if (_abort_source.abort_requested()) {
+                return;
+            }
+            scan_token_range(s, attribute_name, std::move(*shard_range));
+        }
+    }
+}
+
+void expiration_service::scan_token_range(schema_ptr s, const sstring& attribute_name, dht::token_range range) {
+    auto selection = cql3::selection::selection::wildcard(s);
+    auto regular_columns = boost::copy_range<query::column_id_vector>(
+            s->regular_columns() | boost::adaptors::transformed([] (const column_definition& cdef) { return cdef.id; }));
+    auto slice = query::partition_slice({query::clustering_range::make_open_ended_both_sides()}, {}, std::move(regular_columns), selection->get_query_options());
+    auto command = make_lw_shared<query::read_command>(s->id(), s->version(), std::move(slice), query::max_partitions);
+    command->slice.options.set<query::partition_slice::option::allow_short_read>();
+    service::query_state query_state(service::client_state::for_internal_calls(), tracing::trace_state_ptr(), empty_service_permit());
+    // This node is a replica of the scanned range, so LOCAL_ONE usually
+    // reads only local data. An item which isn't expired yet in this
+    // replica's data is found by a later pass.
+    cql3::query_options query_options(db::consistency_level::LOCAL_ONE, infinite_timeout_config, std::vector<cql3::raw_value>{});
+    auto pager = service::pager::query_pagers::pager(s, selection, query_state, query_options, command,
+            {dht::to_partition_range(std::move(range))}, _cql_stats);
+
+    const auto& columns = selection->get_columns();
+    while (!pager->is_exhausted() && !_abort_source.abort_requested()) {
+        auto rs = pager->fetch_page(scan_page_size, gc_clock::now(), db::timeout_clock::now() + scan_timeout).get0();
+        auto now_seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+        big_decimal now(0, now_seconds.count());
+        big_decimal oldest(0, (now_seconds - max_expired_age).count());
+        std::vector<mutation> deletions;
+        for (const std::vector<bytes_opt>& row : rs->rows()) {
+            std::vector<bytes> pk;
+            std::vector<bytes> ck;
+            bool expired = false;
+            for (size_t i = 0; i < columns.size(); ++i) {
+                const column_definition& cdef = *columns[i];
+                if (!row[i]) {
+                    continue;
+                }
+                if (cdef.is_partition_key()) {
+                    pk.push_back(*row[i]);
+                } else if (cdef.is_clustering_key()) {
+                    ck.push_back(*row[i]);
+                } else if (cdef.name_as_text() == executor::ATTRS_COLUMN_NAME) {
+                    auto attrs = value_cast<map_type_impl::native_type>(cdef.type->deserialize(*row[i], cql_serialization_format::latest()));
+                    for (const auto& attr : attrs) {
+                        if (value_cast<sstring>(attr.first) == attribute_name) {
+                            expired = is_expired(value_cast<bytes>(attr.second), now, oldest);
+                            break;
+                        }
+                    }
+                }
+            }
+            if (expired) {
+                mutation m(s, partition_key::from_exploded(*s, std::move(pk)));
+                auto& deleted = m.partition().clustered_row(*s, ck.empty() ? clustering_key::make_empty() : clustering_key::from_exploded(*s, std::move(ck)));
+                deleted.apply(tombstone(api::new_timestamp(), gc_clock::now()));
+                deletions.push_back(std::move(m));
+            }
+            seastar::thread::maybe_yield();
+        }
+        if (!deletions.empty()) {
+            auto count = deletions.size();
+            _proxy.mutate(std::move(deletions), db::consistency_level::LOCAL_QUORUM, db::timeout_clock::now() + scan_timeout,
+                    tracing::trace_state_ptr(), empty_service_permit()).get();
+            _stats.items_deleted += count;
+        }
+    }
+}
+
+}
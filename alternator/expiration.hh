@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <seastar/core/sharded.hh>
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/metrics_registration.hh>
+#include "seastarx.hh"
+#include "schema_fwd.hh"
+#include "dht/token.hh"
+#include "cql3/stats.hh"
+
+namespace service {
+class storage_proxy;
+}
+
+namespace alternator {
+
+// The tag holding the name of a table's TTL attribute, set (and removed) by
+// UpdateTimeToLive. Items whose TTL attribute holds a number of seconds
+// since the epoch which is already in the past are deleted.
+static constexpr auto TTL_TAG_KEY = "system:ttl_attribute";
+
+// A background service deleting expired items from the tables with a TTL
+// attribute. Every shard periodically scans the token ranges for which
+// this node is the primary replica in its DC, restricted to the tokens
+// owned by the shard, so each item is checked by a single shard of a
+// single node per DC, usually reading only local data. Expired items are
+// deleted by ordinary writes.
+//
+// The service should be started in a low priority (maintenance)
+// scheduling group, which the scans inherit.
+class expiration_service : public seastar::peering_sharded_service<expiration_service> {
+    service::storage_proxy& _proxy;
+    std::chrono::seconds _period;
+    abort_source _abort_source;
+    future<> _end = make_ready_future<>();
+    cql3::cql_stats _cql_stats;
+    struct stats {
+        uint64_t scan_passes = 0;
+        uint64_t scan_table = 0;
+        uint64_t items_deleted = 0;
+    } _stats;
+    seastar::metrics::metric_groups _metrics;
+
+    future<> run();
+    // Must be called in a seastar thread.
+    void scan_table(schema_ptr s, const sstring& attribute_name);
+    void scan_token_range(schema_ptr s, const sstring& attribute_name, dht::token_range range);
+public:
+    expiration_service(service::storage_proxy& proxy, std::chrono::seconds period);
+    future<> start();
+    future<> stop();
+};
+
+}
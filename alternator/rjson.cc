@@ -23,6 +23,7 @@
 #include "error.hh"
 #include <seastar/core/print.hh>
 #include <seastar/core/thread.hh>
+#include <array>
 
 namespace rjson {
 
@@ -47,7 +48,8 @@ struct guarded_yieldable_json_handler : public Handler {
     using handler_base = Handler;
 
     explicit guarded_yieldable_json_handler(size_t max_nested_level) : _max_nested_level(max_nested_level) {}
-    guarded_yieldable_json_handler(string_buffer& buf, size_t max_nested_level)
+    template <typename Buffer>
+    guarded_yieldable_json_handler(Buffer& buf, size_t max_nested_level)
             : handler_base(buf), _max_nested_level(max_nested_level) {}
 
     void Parse(const char* str, size_t length) {
@@ -128,6 +130,47 @@ std::string print(const rjson::value& value) {
     return std::string(buffer.GetString());
 }
 
+/*
+ * A rapidjson output stream writing to a seastar output_stream in chunks
+ * of chunk_size bytes, so that printing a large document neither builds
+ * it in a contiguous buffer nor holds more than one chunk of it. Must be
+ * used in a seastar thread, as a full chunk waits to be written out.
+ */
+class output_stream_buffer {
+    static constexpr size_t chunk_size = 8192;
+    seastar::output_stream<char>& _os;
+    std::array<char, chunk_size> _buf;
+    size_t _pos = 0;
+public:
+    using Ch = char;
+
+    explicit output_stream_buffer(seastar::output_stream<char>& os) : _os(os) {}
+
+    void Put(Ch c) {
+        if (_pos == chunk_size) {
+            Flush();
+        }
+        _buf[_pos++] = c;
+    }
+
+    void Flush() {
+        if (_pos) {
+            _os.write(_buf.data(), _pos).get();
+            _pos = 0;
+        }
+    }
+};
+
+future<> print(const rjson::value& value, seastar::output_stream<char>& os) {
+    return seastar::async([&value, &os] {
+        output_stream_buffer buf(os);
+        using stream_writer = rapidjson::Writer<output_stream_buffer, encoding, encoding, allocator>;
+        guarded_yieldable_json_handler<stream_writer, true> writer(buf, 39);
+        value.Accept(writer);
+        buf.Flush();
+    });
+}
+
 rjson::value copy(const rjson::value& value) {
     return rjson::value(value, the_allocator);
 }
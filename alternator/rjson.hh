@@ -67,6 +67,8 @@ class error : public std::exception {
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/error/en.h>
 #include <seastar/core/sstring.hh>
+#include <seastar/core/iostream.hh>
+#include <seastar/core/future.hh>
 #include "seastarx.hh"
 
 namespace rjson {
@@ -104,6 +106,12 @@ inline rjson::value empty_string() {
 // The representation is dense - without any redundant indentation.
 std::string print(const rjson::value& value);
 
+// Writes the JSON value to the output stream, with the same syntax as
+// print(), without first printing it into a string. Long documents are
+// written in chunks, yielding in between. The value and the stream must
+// be kept alive until the returned future resolves.
+future<> print(const rjson::value& value, seastar::output_stream<char>& os);
+
 // Returns a string_view to the string held in a JSON value (which is
 // assumed to hold a string, i.e., v.IsString() == true). This is a view
 // to the existing data - no copying is done.
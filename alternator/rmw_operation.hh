@@ -26,6 +26,7 @@
 #include <service/storage_proxy.hh>
 #include "rjson.hh"
 #include "executor.hh"
+#include "serialization.hh"
 
 namespace alternator {
 
@@ -56,8 +57,17 @@ class rmw_operation : public service::cas_request, public enable_shared_from_thi
     // * The UNSAFE_RMW option does read-modify-write operations as separate
     //   read and write. It is unsafe - concurrent RMW operations are not
     //   isolated at all. This option will likely be removed in the future.
+    // * The LEADER_RMW option runs RMW operations on a leader replica of the
+    //   item's partition - the first replica in the local DC - which
+    //   serializes them with a per-token lock and writes the result as an
+    //   ordinary quorum write. Coordinators forward RMW requests to the
+    //   leader, and fail with a retryable error while the choice of leader
+    //   is unclear (the leader is down, or the token range is moving) -
+    //   never falling back to LWT, which the leader's lock does not
+    //   serialize against. Like LWT_RMW_ONLY, write-only operations are
+    //   ordinary quorum writes.
     enum class write_isolation {
-        FORBID_RMW, LWT_ALWAYS, LWT_RMW_ONLY, UNSAFE_RMW
+        FORBID_RMW, LWT_ALWAYS, LWT_RMW_ONLY, UNSAFE_RMW, LEADER_RMW
     };
     static constexpr auto WRITE_ISOLATION_TAG_KEY = "system:write_isolation";
 
@@ -84,6 +94,18 @@ class rmw_operation : public service::cas_request, public enable_shared_from_thi
     // the values which are to be returned in the "Attributes" field.
     // The default null JSON means do not return an Attributes field at all.
     rjson::value _return_attributes;
+    // Whether new attribute values may use the compact encoding.
+    compact_attributes _compact_attributes;
+    // Set when the operation was forwarded to this node as the leader of a
+    // LEADER_RMW table, so it is never forwarded again.
+    bool _forwarded = false;
+private:
+    future<executor::request_return_type> execute_on_leader(service::storage_proxy& proxy,
+            service::client_state& client_state,
+            tracing::trace_state_ptr trace_state,
+            service_permit permit,
+            stats& stats);
+    future<executor::request_return_type> forward_to_leader(gms::inet_address leader, stats& stats);
 public:
     // The constructor of a rmw_operation subclass should parse the request
     // and try to discover as many input errors as it can before really
@@ -99,10 +121,15 @@ class rmw_operation : public service::cas_request, public enable_shared_from_thi
     virtual std::optional<mutation> apply(std::unique_ptr<rjson::value> previous_item, api::timestamp_type ts) = 0;
     // Convert the above apply() into the signature needed by cas_request:
     virtual std::optional<mutation> apply(query::result& qr, const query::partition_slice& slice, api::timestamp_type ts) override;
+    // Whether the operation needs to read the item's previous value.
+    virtual bool needs_read_before_write() const = 0;
+    // The name of the operation in the DynamoDB API, e.g., "PutItem".
+    virtual const char* operation_name() const = 0;
     virtual ~rmw_operation() = default;
     schema_ptr schema() const { return _schema; }
     const rjson::value& request() const { return _request; }
     rjson::value&& move_request() && { return std::move(_request); }
+    void set_forwarded() { _forwarded = true; }
     future<executor::request_return_type> execute(service::storage_proxy& proxy,
             service::client_state& client_state,
             tracing::trace_state_ptr trace_state,
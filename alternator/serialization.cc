@@ -26,6 +26,8 @@
 #include "rapidjson/writer.h"
 #include "concrete_types.hh"
 #include "cql3/type_json.hh"
+#include "bytes_ostream.hh"
+#include "vint-serialization.hh"
 
 static logging::logger slogger("alternator-serialization");
 
@@ -61,28 +63,122 @@ type_representation represent_type(alternator_type atype) {
 
 struct from_json_visitor {
     const rjson::value& v;
-    bytes_ostream& bo;
+    bytes& out;
 
-    void operator()(const reversed_type_impl& t) const { visit(*t.underlying_type(), from_json_visitor{v, bo}); };
+    void operator()(const reversed_type_impl& t) const { visit(*t.underlying_type(), from_json_visitor{v, out}); };
     void operator()(const string_type_impl& t) {
-        bo.write(t.from_string(sstring_view(v.GetString(), v.GetStringLength())));
+        out = t.from_string(sstring_view(v.GetString(), v.GetStringLength()));
     }
     void operator()(const bytes_type_impl& t) const {
-        bo.write(base64_decode(v));
+        out = base64_decode(v);
     }
     void operator()(const boolean_type_impl& t) const {
-        bo.write(boolean_type->decompose(v.GetBool()));
+        out = boolean_type->decompose(v.GetBool());
     }
     void operator()(const decimal_type_impl& t) const {
-        bo.write(t.from_string(sstring_view(v.GetString(), v.GetStringLength())));
+        out = t.from_string(sstring_view(v.GetString(), v.GetStringLength()));
     }
     // default
     void operator()(const abstract_type& t) const {
-        bo.write(from_json_object(t, Json::Value(rjson::print(v)), cql_serialization_format::internal()));
+        out = from_json_object(t, Json::Value(rjson::print(v)), cql_serialization_format::internal());
     }
 };
 
-bytes serialize_item(const rjson::value& item) {
+static bytes scalar_to_bytes(data_type dtype, const rjson::value& v) {
+    bytes value;
+    visit(*dtype, from_json_visitor{v, value});
+    return value;
+}
+
+static void write_vint(bytes_ostream& out, uint64_t v) {
+    unsigned_vint::serialize(v, out.write_place_holder(unsigned_vint::serialized_size(v)));
+}
+
+static void write_chunk(bytes_ostream& out, bytes_view v) {
+    write_vint(out, v.size());
+    out.write(v);
+}
+
+static void write_tag(bytes_ostream& out, alternator_type atype) {
+    *out.write_place_holder(1) = int8_t(atype);
+}
+
+static alternator_type compact_type_from_string(std::string_view type) {
+    static thread_local const std::unordered_map<std::string_view, alternator_type> compact_types = {
+        {"L", alternator_type::L},
+        {"M", alternator_type::M},
+        {"SS", alternator_type::SS},
+        {"NS", alternator_type::NS},
+        {"BS", alternator_type::BS},
+        {"NULL", alternator_type::NUL},
+    };
+    auto it = compact_types.find(type);
+    if (it == compact_types.end()) {
+        throw api_error("ValidationException", format("Unknown attribute type {}", type));
+    }
+    return it->second;
+}
+
+// Writes a value in the compact encoding, in which every value delimits
+// itself: its type tag is followed by the length-prefixed serialization of
+// a scalar, or by the number of elements of a set, list or map and then
+// the elements themselves (map elements are preceded by their
+// length-prefixed name). Lengths and counts are unsigned vints.
+static void write_compact(const rjson::value& item, bytes_ostream& out) {
+    if (!item.IsObject() || item.MemberCount() != 1) {
+        throw api_error("ValidationException", format("An item can contain only one attribute definition: {}", item));
+    }
+    auto it = item.MemberBegin();
+    auto ident = rjson::to_string_view(it->name);
+    const rjson::value& v = it->value;
+    type_info scalar = type_info_from_string(std::string(ident));
+    if (scalar.atype != alternator_type::NOT_SUPPORTED_YET) {
+        write_tag(out, scalar.atype);
+        write_chunk(out, scalar_to_bytes(scalar.dtype, v));
+        return;
+    }
+    auto atype = compact_type_from_string(ident);
+    write_tag(out, atype);
+    switch (atype) {
+    case alternator_type::NUL:
+        return;
+    case alternator_type::L:
+        if (!v.IsArray()) {
+            throw api_error("ValidationException", format("Improperly formatted list: {}", item));
+        }
+        write_vint(out, v.Size());
+        for (auto& element : v.GetArray()) {
+            write_compact(element, out);
+        }
+        return;
+    case alternator_type::M:
+        if (!v.IsObject()) {
+            throw api_error("ValidationException", format("Improperly formatted map: {}", item));
+        }
+        write_vint(out, v.MemberCount());
+        for (auto m = v.MemberBegin(); m != v.MemberEnd(); ++m) {
+            auto name = rjson::to_string_view(m->name);
+            write_chunk(out, bytes_view(reinterpret_cast<const int8_t*>(name.data()), name.size()));
+            write_compact(m->value, out);
+        }
+        return;
+    default: {
+        // One of the sets, whose elements are all of the scalar type named
+        // by the first letter of the set type.
+        if (!v.IsArray()) {
+            throw api_error("ValidationException", format("Improperly formatted set: {}", item));
+        }
+        auto element_type = type_info_from_string(std::string(ident.substr(0, 1))).dtype;
+        write_vint(out, v.Size());
+        for (auto& element : v.GetArray()) {
+            write_chunk(out, scalar_to_bytes(element_type, element));
+        }
+        return;
+    }
+    }
+}
+
+bytes serialize_item(const rjson::value& item, compact_attributes compact) {
     if (item.IsNull() || item.MemberCount() != 1) {
         throw api_error("ValidationException", format("An item can contain only one attribute definition: {}", item));
     }
@@ -90,15 +186,22 @@ bytes serialize_item(const rjson::value& item) {
     type_info type_info = type_info_from_string(it->name.GetString()); // JSON keys are guaranteed to be strings
 
     if (type_info.atype == alternator_type::NOT_SUPPORTED_YET) {
+        if (compact) {
+            bytes_ostream out;
+            write_compact(item, out);
+            return bytes(out.linearize());
+        }
         slogger.trace("Non-optimal serialization of type {}", it->name.GetString());
         return bytes{int8_t(type_info.atype)} + to_bytes(rjson::print(item));
     }
 
-    bytes_ostream bo;
-    bo.write(bytes{int8_t(type_info.atype)});
-    visit(*type_info.dtype, from_json_visitor{it->value, bo});
-
-    return bytes(bo.linearize());
+    // Items can be as large as 400KB, so prepend the type to the value with
+    // a single copy.
+    bytes value = scalar_to_bytes(type_info.dtype, it->value);
+    bytes serialized(bytes::initialized_later(), value.size() + 1);
+    serialized[0] = int8_t(type_info.atype);
+    std::copy(value.begin(), value.end(), serialized.begin() + 1);
+    return serialized;
 }
 
 struct to_json_visitor {
@@ -125,8 +228,95 @@ struct to_json_visitor {
     }
 };
 
-rjson::value deserialize_item(bytes_view bv) {
+static rjson::value scalar_to_json(alternator_type atype, bytes_view bv) {
     rjson::value deserialized(rapidjson::kObjectType);
+    type_representation type_representation = represent_type(atype);
+    visit(*type_representation.dtype, to_json_visitor{deserialized, type_representation.ident, bv});
+    return deserialized;
+}
+
+[[noreturn]] static void throw_truncated() {
+    throw api_error("ValidationException", "Serialized value truncated");
+}
+
+static uint64_t read_vint(bytes_view& bv) {
+    if (bv.empty() || bv.size() < unsigned_vint::serialized_size_from_first_byte(bv[0])) {
+        throw_truncated();
+    }
+    auto v = unsigned_vint::deserialize(bv);
+    bv.remove_prefix(unsigned_vint::serialized_size(v));
+    return v;
+}
+
+static bytes_view read_chunk(bytes_view& bv) {
+    auto size = read_vint(bv);
+    if (bv.size() < size) {
+        throw_truncated();
+    }
+    auto chunk = bv.substr(0, size);
+    bv.remove_prefix(size);
+    return chunk;
+}
+
+static rjson::value read_compact(bytes_view& bv);
+
+// Reads the rest of a value written by write_compact(), after its tag.
+static rjson::value read_compact(alternator_type atype, bytes_view& bv) {
+    rjson::value ret = rjson::empty_object();
+    switch (atype) {
+    case alternator_type::S:
+    case alternator_type::B:
+    case alternator_type::BOOL:
+    case alternator_type::N:
+        return scalar_to_json(atype, read_chunk(bv));
+    case alternator_type::NUL:
+        rjson::set(ret, "NULL", rjson::value(true));
+        return ret;
+    case alternator_type::L: {
+        rjson::value list = rjson::empty_array();
+        for (auto n = read_vint(bv); n > 0; --n) {
+            rjson::push_back(list, read_compact(bv));
+        }
+        rjson::set(ret, "L", std::move(list));
+        return ret;
+    }
+    case alternator_type::M: {
+        rjson::value map = rjson::empty_object();
+        for (auto n = read_vint(bv); n > 0; --n) {
+            auto name = read_chunk(bv);
+            rjson::set_with_string_name(map, std::string_view(reinterpret_cast<const char*>(name.data()), name.size()), read_compact(bv));
+        }
+        rjson::set(ret, "M", std::move(map));
+        return ret;
+    }
+    case alternator_type::SS:
+    case alternator_type::NS:
+    case alternator_type::BS: {
+        auto element_type = atype == alternator_type::SS ? alternator_type::S
+                : atype == alternator_type::NS ? alternator_type::N : alternator_type::B;
+        rjson::value set = rjson::empty_array();
+        for (auto n = read_vint(bv); n > 0; --n) {
+            rjson::value element = scalar_to_json(element_type, read_chunk(bv));
+            rjson::push_back(set, std::move(element.MemberBegin()->value));
+        }
+        rjson::set_with_string_name(ret, represent_type(element_type).ident + "S", std::move(set));
+        return ret;
+    }
+    default:
+        throw std::runtime_error(format("Unknown alternator type {}", int8_t(atype)));
+    }
+}
+
+static rjson::value read_compact(bytes_view& bv) {
+    if (bv.empty()) {
+        throw_truncated();
+    }
+    alternator_type atype = alternator_type(bv[0]);
+    bv.remove_prefix(1);
+    return read_compact(atype, bv);
+}
+
+rjson::value deserialize_item(bytes_view bv) {
     if (bv.empty()) {
         throw api_error("ValidationException", "Serialized value empty");
     }
@@ -134,14 +324,18 @@ rjson::value deserialize_item(bytes_view bv) {
     alternator_type atype = alternator_type(bv[0]);
     bv.remove_prefix(1);
 
-    if (atype == alternator_type::NOT_SUPPORTED_YET) {
+    switch (atype) {
+    case alternator_type::S:
+    case alternator_type::B:
+    case alternator_type::BOOL:
+    case alternator_type::N:
+        return scalar_to_json(atype, bv);
+    case alternator_type::NOT_SUPPORTED_YET:
         slogger.trace("Non-optimal deserialization of alternator type {}", int8_t(atype));
         return rjson::parse(std::string_view(reinterpret_cast<const char *>(bv.data()), bv.size()));
+    default:
+        return read_compact(atype, bv);
     }
-    type_representation type_representation = represent_type(atype);
-    visit(*type_representation.dtype, to_json_visitor{deserialized, type_representation.ident, bv});
-
-    return deserialized;
 }
 
 std::string type_to_string(data_type type) {
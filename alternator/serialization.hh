@@ -23,6 +23,7 @@
 
 #include <string>
 #include <string_view>
+#include <seastar/util/bool_class.hh>
 #include "types.hh"
 #include "schema_fwd.hh"
 #include "keys.hh"
@@ -31,8 +32,13 @@
 
 namespace alternator {
 
+// The type tag which starts every serialized attribute value. S, B, BOOL
+// and N values are followed by their CQL serialization. NOT_SUPPORTED_YET
+// values are followed by the DynamoDB JSON of the whole value, which was
+// the only encoding of all other types before the compact encoding (see
+// serialize_item()) and remains readable.
 enum class alternator_type : int8_t {
-    S, B, BOOL, N, NOT_SUPPORTED_YET
+    S, B, BOOL, N, NOT_SUPPORTED_YET, L, M, SS, NS, BS, NUL
 };
 
 struct type_info {
@@ -48,7 +54,12 @@ struct type_representation {
 type_info type_info_from_string(std::string type);
 type_representation represent_type(alternator_type atype);
 
-bytes serialize_item(const rjson::value& item);
+// Whether serialize_item() may use the compact binary encoding for lists,
+// maps, sets and nulls. It must not be used before all nodes can read it,
+// see gms::feature_service::cluster_supports_alternator_compact_attributes().
+using compact_attributes = bool_class<class compact_attributes_tag>;
+
+bytes serialize_item(const rjson::value& item, compact_attributes compact);
 rjson::value deserialize_item(bytes_view bv);
 
 std::string type_to_string(data_type type);
@@ -23,6 +23,7 @@
 #include "log.hh"
 #include <seastar/http/function_handlers.hh>
 #include <seastar/json/json_elements.hh>
+#include <seastar/core/bitops.hh>
 #include <seastarx.hh>
 #include "error.hh"
 #include "rjson.hh"
@@ -59,6 +60,66 @@ inline std::vector<std::string_view> split(std::string_view text, char separator
     return tokens;
 }
 
+// Compares ASCII strings ignoring case, as HTTP header names are compared.
+static bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [] (char x, char y) {
+        return ::tolower(static_cast<unsigned char>(x)) == ::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+static uint64_t hash_operation(std::string_view name, uint64_t seed) {
+    // FNV-1a, followed by the finalizer of murmur3 to spread the bits of
+    // the short names over the whole word.
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    for (char c : name) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+size_t server::alternator_callbacks_map::slot_of(std::string_view name) const {
+    return hash_operation(name, _seed) & (_slots.size() - 1);
+}
+
+server::alternator_callbacks_map::alternator_callbacks_map(std::initializer_list<std::pair<std::string_view, alternator_callback>> callbacks) {
+    static constexpr unsigned attempts_per_size = 1000;
+    assert(callbacks.size() < empty_slot);
+    for (auto& [name, callback] : callbacks) {
+        _entries.push_back(entry{name, callback});
+    }
+    // A table with four times as many slots as names finds a collision-free
+    // seed within a few attempts; grow it if we were unlucky.
+    for (size_t size = std::max<size_t>(8, size_t(1) << log2ceil(_entries.size() * 4)); ; size *= 2) {
+        for (unsigned attempt = 0; attempt < attempts_per_size; ++attempt) {
+            _seed = attempt;
+            _slots.assign(size, empty_slot);
+            bool collision = false;
+            for (size_t i = 0; i < _entries.size() && !collision; ++i) {
+                auto& slot = _slots[slot_of(_entries[i].name)];
+                collision = slot != empty_slot;
+                assert(!collision || _entries[slot].name != _entries[i].name);
+                slot = i;
+            }
+            if (!collision) {
+                return;
+            }
+        }
+    }
+}
+
+const server::alternator_callback* server::alternator_callbacks_map::find(std::string_view name) const {
+    auto i = _slots[slot_of(name)];
+    if (i == empty_slot || _entries[i].name != name) {
+        return nullptr;
+    }
+    return &_entries[i].callback;
+}
+
 // DynamoDB HTTP error responses are structured as follows
 // https://docs.aws.amazon.com/amazondynamodb/latest/developerguide/Programming.Errors.html
 // Our handlers throw an exception to report an error. If the exception
@@ -236,13 +297,15 @@ future<> server::verify_signature(const request& req) {
     for (const auto& header : signed_headers) {
         signed_headers_map.emplace(header, std::string_view());
     }
+    // Signed header names are in lower case, and there are only a few of
+    // them, so match them against the request's headers in place rather
+    // than building a lower-case copy of every header name.
     for (auto& header : req._headers) {
-        std::string header_str;
-        header_str.resize(header.first.size());
-        std::transform(header.first.begin(), header.first.end(), header_str.begin(), ::tolower);
-        auto it = signed_headers_map.find(header_str);
-        if (it != signed_headers_map.end()) {
-            it->second = std::string_view(header.second);
+        for (auto& signed_header : signed_headers_map) {
+            if (iequals(header.first, signed_header.first)) {
+                signed_header.second = std::string_view(header.second);
+                break;
+            }
         }
     }
 
@@ -268,25 +331,35 @@ future<> server::verify_signature(const request& req) {
     });
 }
 
+// Target consists of Dynamo API version followed by a dot '.' and operation
+// type (e.g. DynamoDB_20120810.CreateTable). The returned view points into
+// the request's headers, so it is valid as long as the request is.
+static std::string_view get_operation(const request& req) {
+    auto it = req._headers.find(TARGET);
+    if (it == req._headers.end()) {
+        return {};
+    }
+    std::string_view target(it->second);
+    auto dot = target.rfind('.');
+    return dot == std::string_view::npos ? target : target.substr(dot + 1);
+}
+
 future<executor::request_return_type> server::handle_api_request(std::unique_ptr<request>&& req) {
     _executor._stats.total_operations++;
-    sstring target = req->get_header(TARGET);
-    std::vector<std::string_view> split_target = split(target, '.');
-    //NOTICE(sarna): Target consists of Dynamo API version followed by a dot '.' and operation type (e.g. CreateTable)
-    std::string op = split_target.empty() ? std::string() : std::string(split_target.back());
+    std::string_view op = get_operation(*req);
     slogger.trace("Request: {} {}", op, req->content);
     return verify_signature(*req).then([this, op, req = std::move(req)] () mutable {
-        auto callback_it = _callbacks.find(op);
-        if (callback_it == _callbacks.end()) {
+        const alternator_callback* callback = _callbacks.find(op);
+        if (!callback) {
             _executor._stats.unsupported_operations++;
             throw api_error("UnknownOperationException",
                     format("Unsupported operation {}", op));
         }
-        return with_gate(_pending_requests, [this, callback_it = std::move(callback_it), op = std::move(op), req = std::move(req)] () mutable {
+        return with_gate(_pending_requests, [this, callback, op, req = std::move(req)] () mutable {
             //FIXME: Client state can provide more context, e.g. client's endpoint address
             // We use unique_ptr because client_state cannot be moved or copied
             return do_with(std::make_unique<executor::client_state>(executor::client_state::internal_tag()),
-                    [this, callback_it = std::move(callback_it), op = std::move(op), req = std::move(req)] (std::unique_ptr<executor::client_state>& client_state) mutable {
+                    [this, callback, op, req = std::move(req)] (std::unique_ptr<executor::client_state>& client_state) mutable {
                 tracing::trace_state_ptr trace_state = executor::maybe_trace_query(*client_state, op, req->content);
                 tracing::trace(trace_state, op);
                 // JSON parsing can allocate up to roughly 2x the size of the raw document, + a couple of bytes for maintenance.
@@ -297,10 +370,10 @@ future<executor::request_return_type> server::handle_api_request(std::unique_ptr
                 if (_memory_limiter->waiters()) {
                     ++_executor._stats.requests_blocked_memory;
                 }
-                return units_fut.then([this, callback_it = std::move(callback_it), &client_state, trace_state, req = std::move(req)] (semaphore_units<> units) mutable {
-                    return _json_parser.parse(req->content).then([this, callback_it = std::move(callback_it), &client_state, trace_state,
+                return units_fut.then([this, callback, &client_state, trace_state, req = std::move(req)] (semaphore_units<> units) mutable {
+                    return _json_parser.parse(req->content).then([this, callback, &client_state, trace_state,
                             units = std::move(units), req = std::move(req)] (rjson::value json_request) mutable {
-                        return callback_it->second(_executor, *client_state, trace_state, make_service_permit(std::move(units)), std::move(json_request), std::move(req)).finally([trace_state] {});
+                        return (*callback)(_executor, *client_state, trace_state, make_service_permit(std::move(units)), std::move(json_request), std::move(req)).finally([trace_state] {});
                     });
                 });
             });
@@ -389,6 +462,24 @@ server::server(executor& exec)
         {"ListTagsOfResource", [] (executor& e, executor::client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value json_request, std::unique_ptr<request> req) {
             return e.list_tags_of_resource(client_state, std::move(permit), std::move(json_request));
         }},
+        {"UpdateTimeToLive", [] (executor& e, executor::client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value json_request, std::unique_ptr<request> req) {
+            return e.update_time_to_live(client_state, std::move(permit), std::move(json_request));
+        }},
+        {"DescribeTimeToLive", [] (executor& e, executor::client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value json_request, std::unique_ptr<request> req) {
+            return e.describe_time_to_live(client_state, std::move(permit), std::move(json_request));
+        }},
+        {"ListStreams", [] (executor& e, executor::client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value json_request, std::unique_ptr<request> req) {
+            return e.list_streams(client_state, std::move(permit), std::move(json_request));
+        }},
+        {"DescribeStream", [] (executor& e, executor::client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value json_request, std::unique_ptr<request> req) {
+            return e.describe_stream(client_state, std::move(permit), std::move(json_request));
+        }},
+        {"GetShardIterator", [] (executor& e, executor::client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value json_request, std::unique_ptr<request> req) {
+            return e.get_shard_iterator(client_state, std::move(permit), std::move(json_request));
+        }},
+        {"GetRecords", [] (executor& e, executor::client_state& client_state, tracing::trace_state_ptr trace_state, service_permit permit, rjson::value json_request, std::unique_ptr<request> req) {
+            return e.get_records(client_state, std::move(trace_state), std::move(permit), std::move(json_request));
+        }},
     } {
 }
 
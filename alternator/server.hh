@@ -26,6 +26,8 @@
 #include <seastar/http/httpd.hh>
 #include <seastar/net/tls.hh>
 #include <optional>
+#include <limits>
+#include <vector>
 #include <alternator/auth.hh>
 #include <utils/small_vector.hh>
 #include <seastar/core/units.hh>
@@ -36,7 +38,27 @@ class server {
     static constexpr size_t content_length_limit = 16*MB;
     using alternator_callback = std::function<future<executor::request_return_type>(executor&, executor::client_state&,
             tracing::trace_state_ptr, service_permit, rjson::value, std::unique_ptr<request>)>;
-    using alternator_callbacks_map = std::unordered_map<std::string_view, alternator_callback>;
+
+    // Maps the operation names of X-Amz-Target to their callbacks. The set
+    // of names is fixed, so the table uses a perfect hash: its seed is
+    // chosen to give every name a slot of its own, and a lookup hashes the
+    // name once and compares it to the single candidate in its slot.
+    class alternator_callbacks_map {
+        struct entry {
+            std::string_view name;
+            alternator_callback callback;
+        };
+        static constexpr uint8_t empty_slot = std::numeric_limits<uint8_t>::max();
+        std::vector<entry> _entries;
+        std::vector<uint8_t> _slots;
+        uint64_t _seed = 0;
+    private:
+        size_t slot_of(std::string_view name) const;
+    public:
+        alternator_callbacks_map(std::initializer_list<std::pair<std::string_view, alternator_callback>> callbacks);
+        // Returns nullptr for an unknown operation.
+        const alternator_callback* find(std::string_view name) const;
+    };
 
     http_server _http_server;
     http_server _https_server;
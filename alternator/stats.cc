@@ -51,11 +51,15 @@ stats::stats() : api_operations{} {
             OPERATION(describe_global_table, "DescribeGlobalTable")
             OPERATION(describe_global_table_settings, "DescribeGlobalTableSettings")
             OPERATION(describe_limits, "DescribeLimits")
+            OPERATION(describe_stream, "DescribeStream")
             OPERATION(describe_table, "DescribeTable")
             OPERATION(describe_time_to_live, "DescribeTimeToLive")
             OPERATION(get_item, "GetItem")
+            OPERATION(get_records, "GetRecords")
+            OPERATION(get_shard_iterator, "GetShardIterator")
             OPERATION(list_backups, "ListBackups")
             OPERATION(list_global_tables, "ListGlobalTables")
+            OPERATION(list_streams, "ListStreams")
             OPERATION(list_tables, "ListTables")
             OPERATION(list_tags_of_resource, "ListTagsOfResource")
             OPERATION(put_item, "PutItem")
@@ -89,6 +93,14 @@ stats::stats() : api_operations{} {
                     seastar::metrics::description("number of writes that used LWT")),
             seastar::metrics::make_total_operations("shard_bounce_for_lwt", shard_bounce_for_lwt,
                     seastar::metrics::description("number writes that had to be bounced from this shard because of LWT requirements")),
+            seastar::metrics::make_total_operations("write_using_leader_rmw", write_using_leader_rmw,
+                    seastar::metrics::description("number of read-modify-write operations serialized on this shard as their leader")),
+            seastar::metrics::make_total_operations("leader_rmw_forwarded", leader_rmw_forwarded,
+                    seastar::metrics::description("number of read-modify-write operations forwarded to their leader replica")),
+            seastar::metrics::make_total_operations("leader_rmw_unavailable", leader_rmw_unavailable,
+                    seastar::metrics::description("number of read-modify-write operations failed because no leader replica was agreed on")),
+            seastar::metrics::make_total_operations("shard_bounce_for_streams", shard_bounce_for_streams,
+                    seastar::metrics::description("number of GetRecords requests bounced from this shard to the shard owning the stream")),
             seastar::metrics::make_total_operations("requests_blocked_memory", requests_blocked_memory,
                     seastar::metrics::description("Counts a number of requests blocked due to memory pressure.")),
             seastar::metrics::make_total_operations("filtered_rows_read_total", cql_stats.filtered_rows_read_total,
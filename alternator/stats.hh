@@ -52,11 +52,15 @@ class stats {
         uint64_t describe_global_table = 0;
         uint64_t describe_global_table_settings = 0;
         uint64_t describe_limits = 0;
+        uint64_t describe_stream = 0;
         uint64_t describe_table = 0;
         uint64_t describe_time_to_live = 0;
         uint64_t get_item = 0;
+        uint64_t get_records = 0;
+        uint64_t get_shard_iterator = 0;
         uint64_t list_backups = 0;
         uint64_t list_global_tables = 0;
+        uint64_t list_streams = 0;
         uint64_t list_tables = 0;
         uint64_t list_tags_of_resource = 0;
         uint64_t put_item = 0;
@@ -86,6 +90,10 @@ class stats {
     uint64_t reads_before_write = 0;
     uint64_t write_using_lwt = 0;
     uint64_t shard_bounce_for_lwt = 0;
+    uint64_t write_using_leader_rmw = 0;
+    uint64_t leader_rmw_forwarded = 0;
+    uint64_t leader_rmw_unavailable = 0;
+    uint64_t shard_bounce_for_streams = 0;
     uint64_t requests_blocked_memory = 0;
     // CQL-derived stats
     cql3::cql_stats cql_stats;
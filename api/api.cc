@@ -37,6 +37,7 @@
 #include "compaction_manager.hh"
 #include "hinted_handoff.hh"
 #include "error_injection.hh"
+#include "cdc.hh"
 #include <seastar/http/exception.hh>
 #include "stream_manager.hh"
 #include "system.hh"
@@ -167,6 +168,9 @@ future<> set_server_done(http_context& ctx) {
         rb->register_function(r, "error_injection",
                 "The error injection API");
         set_error_injection(ctx, r);
+        rb->register_function(r, "cdc",
+                "The CDC API");
+        set_cdc(ctx, r);
     });
 }
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "api/cdc.hh"
+#include "api/api-doc/cdc.json.hh"
+#include "api/column_family.hh"
+
+#include "cdc/log.hh"
+#include "cdc/shard_changes.hh"
+#include "cql3/result_set.hh"
+#include "cql3/type_json.hh"
+#include "database.hh"
+#include "utils/UUID_gen.hh"
+
+namespace api {
+
+namespace hc = httpd::cdc_json;
+
+static std::optional<utils::UUID> time_param(const request& req, const sstring& name) {
+    auto param = req.get_query_param(name);
+    if (param.empty()) {
+        return std::nullopt;
+    }
+    try {
+        auto time = utils::UUID(param);
+        if (time.is_timestamp()) {
+            return time;
+        }
+    } catch (...) {
+    }
+    throw bad_param_exception(format("{} ({}): should be a time UUID", name, param));
+}
+
+void set_cdc(http_context& ctx, routes& r) {
+    hc::get_shard_changes.set(r, [&ctx] (std::unique_ptr<request> req) {
+        auto [ks, cf] = parse_fully_qualified_cf_name(req->param["name"]);
+        api::req_param<unsigned> shard(*req, "shard", 0);
+        api::req_param<uint32_t> limit(*req, "limit", 1000);
+        auto after = time_param(*req, "after");
+        auto before = time_param(*req, "before");
+        if (shard.param.empty()) {
+            throw bad_param_exception("shard: missing parameter");
+        }
+        if (shard.value >= smp::count) {
+            throw bad_param_exception(format("shard ({}): there are only {} shards", shard.value, smp::count));
+        }
+        if (!ctx.db.local().has_schema(ks, cf) || !ctx.db.local().find_schema(ks, cf)->cdc_options().enabled()) {
+            throw bad_param_exception(format("Table '{}:{}' not found or without CDC enabled", ks, cf));
+        }
+        return ctx.db.invoke_on(shard.value, [ks = ks, cf = cf, after, before, limit = limit.value] (database& db) {
+            auto log_schema = db.find_schema(ks, cdc::log_name(cf));
+            return cdc::read_shard_changes(db, log_schema, after, before, limit).then([] (cdc::shard_changes page) {
+                hc::cdc_changes res;
+                auto& names = page.rows->get_metadata().get_names();
+                for (auto& row : page.rows->rows()) {
+                    hc::cdc_change change;
+                    for (size_t i = 0; i < names.size(); ++i) {
+                        hc::cdc_change_column column;
+                        column.name = names[i]->name->text();
+                        column.value = to_json_string(*names[i]->type, row[i]);
+                        change.columns.push(column);
+                    }
+                    res.changes.push(change);
+                }
+                if (page.last_time) {
+                    res.last_time = page.last_time->to_sstring();
+                }
+                return res;
+            });
+        }).then([] (hc::cdc_changes res) {
+            return make_ready_future<json::json_return_type>(std::move(res));
+        });
+    });
+}
+
+}
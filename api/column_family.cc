@@ -23,8 +23,14 @@
 #include "api/api-doc/column_family.json.hh"
 #include <vector>
 #include <seastar/http/exception.hh>
+#include <boost/lexical_cast.hpp>
+#include <boost/range/adaptor/map.hpp>
+#include <boost/range/algorithm/copy.hpp>
+#include <boost/range/algorithm/find.hpp>
+#include <boost/range/algorithm/find_if.hpp>
 #include "sstables/sstables.hh"
 #include "utils/estimated_histogram.hh"
+#include "utils/decaying_histogram.hh"
 #include <algorithm>
 #include "db/system_keyspace_view_types.hh"
 #include "db/data_listeners.hh"
@@ -88,6 +94,96 @@ future<json::json_return_type>  get_cf_stats(http_context& ctx,
     }, std::plus<int64_t>());
 }
 
+// The metrics of /column_family/metrics/bulk, in the order they are reported in
+// when none are requested. Each is summed over the shards, like the per-table
+// endpoint of the same name.
+using bulk_metric = std::function<int64_t(column_family&)>;
+
+static const std::vector<std::pair<sstring, bulk_metric>>& bulk_metrics() {
+    static const std::vector<std::pair<sstring, bulk_metric>> metrics = {
+        {"memtable_columns_count", [] (column_family& cf) { return int64_t(cf.active_memtable().partition_count()); }},
+        {"memtable_off_heap_size", [] (column_family& cf) { return int64_t(cf.active_memtable().region().occupancy().total_space()); }},
+        {"memtable_live_data_size", [] (column_family& cf) { return int64_t(cf.active_memtable().region().occupancy().used_space()); }},
+        {"all_memtables_off_heap_size", [] (column_family& cf) { return int64_t(cf.occupancy().total_space()); }},
+        {"all_memtables_live_data_size", [] (column_family& cf) { return int64_t(cf.occupancy().used_space()); }},
+        {"memtable_switch_count", [] (column_family& cf) { return cf.get_stats().memtable_switch_count; }},
+        {"read", [] (column_family& cf) { return cf.get_stats().reads.hist.count; }},
+        {"read_latency", [] (column_family& cf) { return int64_t(cf.get_stats().reads.hist.count / 1000.0 * cf.get_stats().reads.hist.mean); }},
+        {"write", [] (column_family& cf) { return cf.get_stats().writes.hist.count; }},
+        {"write_latency", [] (column_family& cf) { return int64_t(cf.get_stats().writes.hist.count / 1000.0 * cf.get_stats().writes.hist.mean); }},
+        {"pending_flushes", [] (column_family& cf) { return cf.get_stats().pending_flushes; }},
+        {"pending_compactions", [] (column_family& cf) { return int64_t(cf.get_compaction_strategy().estimated_pending_compactions(cf)); }},
+        {"live_ss_table_count", [] (column_family& cf) { return cf.get_stats().live_sstable_count; }},
+        {"live_disk_space_used", [] (column_family& cf) { return cf.get_stats().live_disk_space_used; }},
+        {"total_disk_space_used", [] (column_family& cf) { return cf.get_stats().total_disk_space_used; }},
+    };
+    return metrics;
+}
+
+struct bulk_metrics_of_table {
+    sstring ks;
+    sstring cf;
+    std::vector<int64_t> values;
+};
+
+// Collects the metrics of all tables in a single pass over the shards, instead
+// of one per table and metric.
+static future<json::json_return_type> get_bulk_metrics(http_context& ctx, const std::vector<sstring>& names, std::vector<sstring> keyspaces) {
+    std::vector<bulk_metric> metrics;
+    if (names.empty()) {
+        boost::copy(bulk_metrics() | boost::adaptors::map_values, std::back_inserter(metrics));
+    }
+    for (auto& name : names) {
+        auto it = boost::find_if(bulk_metrics(), [&name] (auto& m) { return m.first == name; });
+        if (it == bulk_metrics().end()) {
+            throw bad_param_exception(format("Unknown metric '{}'", name));
+        }
+        metrics.push_back(it->second);
+    }
+    using result_type = std::unordered_map<utils::UUID, bulk_metrics_of_table>;
+    return ctx.db.map_reduce0([metrics = std::move(metrics), keyspaces = std::move(keyspaces)] (database& db) {
+        result_type res;
+        for (auto& [uuid, cf] : db.get_column_families()) {
+            auto& s = *cf->schema();
+            if (!keyspaces.empty() && boost::find(keyspaces, s.ks_name()) == keyspaces.end()) {
+                continue;
+            }
+            auto& table = res[uuid];
+            table.ks = s.ks_name();
+            table.cf = s.cf_name();
+            table.values.reserve(metrics.size());
+            for (auto& m : metrics) {
+                table.values.push_back(m(*cf));
+            }
+        }
+        return res;
+    }, result_type(), [] (result_type a, result_type b) {
+        for (auto& [uuid, table] : b) {
+            auto it = a.find(uuid);
+            if (it == a.end()) {
+                a.emplace(uuid, std::move(table));
+                continue;
+            }
+            for (size_t i = 0; i < table.values.size(); ++i) {
+                it->second.values[i] += table.values[i];
+            }
+        }
+        return a;
+    }).then([] (result_type res) {
+        // The JSON of each table is generated while the response is written.
+        auto tables = boost::copy_range<std::vector<bulk_metrics_of_table>>(res | boost::adaptors::map_values);
+        return make_ready_future<json::json_return_type>(stream_range_as_array(std::move(tables), [] (const bulk_metrics_of_table& table) {
+            cf::column_family_metrics m;
+            m.ks = table.ks;
+            m.cf = table.cf;
+            for (auto v : table.values) {
+                m.values.push(v);
+            }
+            return m;
+        }));
+    });
+}
+
 static future<json::json_return_type>  get_cf_stats_count(http_context& ctx, const sstring& name,
         utils::timed_rate_moving_average_and_histogram column_family_stats::*f) {
     return map_reduce_cf(ctx, name, int64_t(0), [f](const column_family& cf) {
@@ -316,6 +412,10 @@ void set_column_family(http_context& ctx, routes& r) {
             return res;
         });
 
+    cf::get_bulk_metrics.set(r, [&ctx] (std::unique_ptr<request> req) {
+        return get_bulk_metrics(ctx, split(req->get_query_param("metrics"), ","), split(req->get_query_param("kn"), ","));
+    });
+
     cf::get_column_family_name_keyspace.set(r, [&ctx] (const_req req){
         vector<sstring> res;
         for (auto i = ctx.db.local().get_keyspaces().cbegin(); i!=  ctx.db.local().get_keyspaces().cend(); i++) {
@@ -894,17 +994,25 @@ void set_column_family(http_context& ctx, routes& r) {
     });
 
     cf::get_read_latency_estimated_histogram.set(r, [&ctx](std::unique_ptr<request> req) {
-        return map_reduce_cf(ctx, req->param["name"], utils::estimated_histogram(0), [](column_family& cf) {
-            return cf.get_stats().estimated_read;
+        return map_reduce_cf_raw(ctx, req->param["name"], utils::decaying_latency_histogram(), [](column_family& cf) {
+            return cf.get_stats().decaying_read;
         },
-        utils::estimated_histogram_merge, utils_json::estimated_histogram());
+        utils::decaying_latency_histogram_merge).then([] (const utils::decaying_latency_histogram& val) {
+            utils_json::estimated_histogram res;
+            res = val.to_estimated_histogram();
+            return make_ready_future<json::json_return_type>(res);
+        });
     });
 
     cf::get_write_latency_estimated_histogram.set(r, [&ctx](std::unique_ptr<request> req) {
-        return map_reduce_cf(ctx, req->param["name"], utils::estimated_histogram(0), [](column_family& cf) {
-            return cf.get_stats().estimated_write;
+        return map_reduce_cf_raw(ctx, req->param["name"], utils::decaying_latency_histogram(), [](column_family& cf) {
+            return cf.get_stats().decaying_write;
         },
-        utils::estimated_histogram_merge, utils_json::estimated_histogram());
+        utils::decaying_latency_histogram_merge).then([] (const utils::decaying_latency_histogram& val) {
+            utils_json::estimated_histogram res;
+            res = val.to_estimated_histogram();
+            return make_ready_future<json::json_return_type>(res);
+        });
     });
 
     cf::set_compaction_strategy_class.set(r, [&ctx](std::unique_ptr<request> req) {
@@ -1004,5 +1112,21 @@ void set_column_family(http_context& ctx, routes& r) {
             return make_ready_future<json::json_return_type>(json_void());
         });
     });
+
+    cf::offload_cold_sstables.set(r, [&ctx](std::unique_ptr<request> req) {
+        auto uuid = get_uuid(req->param["name"], ctx.db.local());
+        std::chrono::seconds older_than;
+        try {
+            older_than = std::chrono::seconds(boost::lexical_cast<int64_t>(req->get_query_param("older_than")));
+        } catch (boost::bad_lexical_cast&) {
+            throw bad_param_exception(format("Invalid value of older_than: '{}'", req->get_query_param("older_than")));
+        }
+        auto max_timestamp = api::new_timestamp() - std::chrono::duration_cast<std::chrono::microseconds>(older_than).count();
+        return ctx.db.map_reduce0([uuid, max_timestamp] (database& db) {
+            return db.find_column_family(uuid).offload_cold_sstables(max_timestamp);
+        }, size_t(0), std::plus<size_t>()).then([] (size_t moved) {
+            return make_ready_future<json::json_return_type>(moved);
+        });
+    });
 }
 }
@@ -31,6 +31,7 @@ namespace api {
 
 void set_column_family(http_context& ctx, routes& r);
 
+std::tuple<sstring, sstring> parse_fully_qualified_cf_name(sstring name);
 const utils::UUID& get_uuid(const sstring& name, const database& db);
 future<> foreach_column_family(http_context& ctx, const sstring& name, std::function<void(column_family&)> f);
 
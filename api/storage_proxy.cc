@@ -126,6 +126,16 @@ static future<json::json_return_type>  sum_estimated_histogram(http_context& ctx
     });
 }
 
+static future<json::json_return_type>  sum_decaying_histogram(http_context& ctx, utils::decaying_latency_histogram service::storage_proxy_stats::stats::*f) {
+
+    return two_dimensional_map_reduce(ctx.sp, f, utils::decaying_latency_histogram_merge,
+            utils::decaying_latency_histogram()).then([](const utils::decaying_latency_histogram& val) {
+        utils_json::estimated_histogram res;
+        res = val.to_estimated_histogram();
+        return make_ready_future<json::json_return_type>(res);
+    });
+}
+
 static future<json::json_return_type>  total_latency(http_context& ctx, utils::timed_rate_moving_average_and_histogram service::storage_proxy_stats::stats::*f) {
     return two_dimensional_map_reduce(ctx.sp, [f] (service::storage_proxy_stats::stats& stats) {
             return (stats.*f).hist.mean * (stats.*f).hist.count;
@@ -477,14 +487,14 @@ void set_storage_proxy(http_context& ctx, routes& r) {
     });
 
     sp::get_read_estimated_histogram.set(r, [&ctx](std::unique_ptr<request> req) {
-        return sum_estimated_histogram(ctx, &service::storage_proxy_stats::stats::estimated_read);
+        return sum_decaying_histogram(ctx, &service::storage_proxy_stats::stats::decaying_read);
     });
 
     sp::get_read_latency.set(r, [&ctx](std::unique_ptr<request> req) {
         return total_latency(ctx, &service::storage_proxy_stats::stats::read);
     });
     sp::get_write_estimated_histogram.set(r, [&ctx](std::unique_ptr<request> req) {
-        return sum_estimated_histogram(ctx, &service::storage_proxy_stats::stats::estimated_write);
+        return sum_decaying_histogram(ctx, &service::storage_proxy_stats::stats::decaying_write);
     });
 
     sp::get_write_latency.set(r, [&ctx](std::unique_ptr<request> req) {
@@ -619,10 +619,14 @@ void set_storage_service(http_context& ctx, routes& r) {
     ss::load_new_ss_tables.set(r, [&ctx](std::unique_ptr<request> req) {
         auto ks = validate_keyspace(ctx, req->param);
         auto cf = req->get_query_param("cf");
+        auto load_and_stream = strcasecmp(req->get_query_param("load_and_stream").c_str(), "true") == 0;
         // No need to add the keyspace, since all we want is to avoid always sending this to the same
         // CPU. Even then I am being overzealous here. This is not something that happens all the time.
         auto coordinator = std::hash<sstring>()(cf) % smp::count;
-        return service::get_storage_service().invoke_on(coordinator, [ks = std::move(ks), cf = std::move(cf)] (service::storage_service& s) {
+        return service::get_storage_service().invoke_on(coordinator, [ks = std::move(ks), cf = std::move(cf), load_and_stream] (service::storage_service& s) {
+            if (load_and_stream) {
+                return s.load_and_stream_new_sstables(ks, cf);
+            }
             return s.load_new_sstables(ks, cf);
         }).then_wrapped([] (auto&& f) {
             if (f.failed()) {
@@ -1026,6 +1030,15 @@ void set_snapshot(http_context& ctx, routes& r) {
         });
     });
 
+    ss::backup_snapshot.set(r, [](std::unique_ptr<request> req) {
+        auto tag = req->get_query_param("tag");
+        auto destination = req->get_query_param("destination");
+        std::vector<sstring> keynames = split(req->get_query_param("kn"), ",");
+        return service::get_local_storage_service().backup_snapshot(tag, keynames, destination).then([] (uint64_t copied) {
+            return make_ready_future<json::json_return_type>(int64_t(copied));
+        });
+    });
+
     ss::scrub.set(r, wrap_ks_cf(ctx, [] (http_context& ctx, std::unique_ptr<request> req, sstring keyspace, std::vector<sstring> column_families) {
         const auto skip_corrupted = req_param<bool>(*req, "skip_corrupted", false);
 
@@ -20,15 +20,26 @@
  */
 
 #include "api/api-doc/system.json.hh"
+#include "api/api-doc/utils.json.hh"
 #include "api/api.hh"
 
+#include <boost/range/irange.hpp>
 #include <seastar/http/exception.hh>
 #include "log.hh"
+#include "utils/latency_sampler.hh"
 
 namespace api {
 
 namespace hs = httpd::system_json;
 
+static utils::latency_stage parse_latency_stage(const sstring& name) {
+    auto stage = utils::latency_stage_from_string(name);
+    if (!stage) {
+        throw bad_param_exception("Unknown stage " + name);
+    }
+    return *stage;
+}
+
 void set_system(http_context& ctx, routes& r) {
     hs::get_system_uptime.set(r, [](const_req req) {
         return std::chrono::duration_cast<std::chrono::milliseconds>(engine().uptime()).count();
@@ -69,6 +80,33 @@ void set_system(http_context& ctx, routes& r) {
         }
         return json::json_void();
     });
+
+    hs::get_latency_breakdown_histogram.set(r, [](std::unique_ptr<request> req) {
+        auto stage = parse_latency_stage(req->param["stage"]);
+        return map_reduce(boost::irange(0u, smp::count), [stage] (unsigned shard) {
+            return smp::submit_to(shard, [stage] {
+                return utils::local_latency_sampler().histogram(stage);
+            });
+        }, utils::estimated_histogram(), utils::estimated_histogram_merge).then([] (const utils::estimated_histogram& val) {
+            httpd::utils_json::estimated_histogram res;
+            res = val;
+            return make_ready_future<json::json_return_type>(res);
+        });
+    });
+
+    hs::get_latency_breakdown_recent.set(r, [](std::unique_ptr<request> req) {
+        auto stage = parse_latency_stage(req->param["stage"]);
+        return map_reduce(boost::irange(0u, smp::count), [stage] (unsigned shard) {
+            return smp::submit_to(shard, [stage] {
+                return utils::local_latency_sampler().recent(stage);
+            });
+        }, std::vector<uint32_t>(), [] (std::vector<uint32_t> a, const std::vector<uint32_t>& b) {
+            a.insert(a.end(), b.begin(), b.end());
+            return a;
+        }).then([] (std::vector<uint32_t> samples) {
+            return make_ready_future<json::json_return_type>(std::vector<int64_t>(samples.begin(), samples.end()));
+        });
+    });
 }
 
 }
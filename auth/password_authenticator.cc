@@ -59,6 +59,7 @@
 #include "service/migration_manager.hh"
 #include "utils/class_registrator.hh"
 #include "database.hh"
+#include "hashers.hh"
 
 namespace auth {
 
@@ -86,10 +87,60 @@ static thread_local auto rng_for_salt = std::default_random_engine(std::random_d
 password_authenticator::~password_authenticator() {
 }
 
+static bytes make_digest_key() {
+    std::random_device rd;
+    bytes key(bytes::initialized_later(), 32);
+    for (auto& b : key) {
+        b = int8_t(rd());
+    }
+    return key;
+}
+
 password_authenticator::password_authenticator(cql3::query_processor& qp, ::service::migration_manager& mm)
     : _qp(qp)
     , _migration_manager(mm)
-    , _stopped(make_ready_future<>()) {
+    , _stopped(make_ready_future<>())
+    , _digest_key(make_digest_key()) {
+}
+
+bytes password_authenticator::password_digest(std::string_view password) const {
+    sha256_hasher hasher;
+    hasher.update(reinterpret_cast<const char*>(_digest_key.data()), _digest_key.size());
+    hasher.update(password.data(), password.size());
+    return hasher.finalize();
+}
+
+bool password_authenticator::verified_recently(const sstring& role_name, const bytes& digest) const {
+    auto it = _verified_credentials.find(role_name);
+    if (it == _verified_credentials.end()) {
+        return false;
+    }
+    if (it->second.expiry <= lowres_clock::now()) {
+        _verified_credentials.erase(it);
+        return false;
+    }
+    return it->second.password_digest == digest;
+}
+
+void password_authenticator::remember_verified(const sstring& role_name, bytes digest) const {
+    const auto& cfg = _qp.db().get_config();
+    const auto validity = std::chrono::milliseconds(cfg.credentials_validity_in_ms());
+    const size_t max_entries = cfg.credentials_cache_max_entries();
+    if (validity.count() == 0 || max_entries == 0) {
+        return;
+    }
+
+    const auto now = lowres_clock::now();
+    if (_verified_credentials.size() >= max_entries && !_verified_credentials.count(role_name)) {
+        // Make room by dropping the expired entries, or an arbitrary one if none has expired yet.
+        for (auto it = _verified_credentials.begin(); it != _verified_credentials.end();) {
+            it = it->second.expiry <= now ? _verified_credentials.erase(it) : std::next(it);
+        }
+        if (_verified_credentials.size() >= max_entries) {
+            _verified_credentials.erase(_verified_credentials.begin());
+        }
+    }
+    _verified_credentials[role_name] = verified_credentials{std::move(digest), now + validity};
 }
 
 static bool has_salted_hash(const cql3::untyped_result_set_row& row) {
@@ -225,6 +276,11 @@ future<authenticated_user> password_authenticator::authenticate(
     auto& username = credentials.at(USERNAME_KEY);
     auto& password = credentials.at(PASSWORD_KEY);
 
+    auto digest = password_digest(password);
+    if (verified_recently(username, digest)) {
+        return make_ready_future<authenticated_user>(username);
+    }
+
     // Here was a thread local, explicit cache of prepared statement. In normal execution this is
     // fine, but since we in testing set up and tear down system over and over, we'd start using
     // obsolete prepared statements pretty quickly.
@@ -242,7 +298,7 @@ future<authenticated_user> password_authenticator::authenticate(
                 internal_distributed_timeout_config(),
                 {username},
                 true);
-    }).then_wrapped([=](future<::shared_ptr<cql3::untyped_result_set>> f) {
+    }).then_wrapped([=, digest = std::move(digest)](future<::shared_ptr<cql3::untyped_result_set>> f) {
         try {
             auto res = f.get0();
             auto salted_hash = std::optional<sstring>();
@@ -252,6 +308,7 @@ future<authenticated_user> password_authenticator::authenticate(
             if (!salted_hash || !passwords::check(password, *salted_hash)) {
                 throw exceptions::authentication_exception("Username and/or password are incorrect");
             }
+            remember_verified(username, digest);
             return make_ready_future<authenticated_user>(username);
         } catch (std::system_error &) {
             std::throw_with_nested(exceptions::authentication_exception("Could not verify password"));
@@ -291,7 +348,9 @@ future<> password_authenticator::alter(std::string_view role_name, const authent
             query,
             consistency_for_user(role_name),
             internal_distributed_timeout_config(),
-            {passwords::hash(*options.password, rng_for_salt), sstring(role_name)}).discard_result();
+            {passwords::hash(*options.password, rng_for_salt), sstring(role_name)}).discard_result().finally([this, role_name = sstring(role_name)] {
+        forget_verified(role_name);
+    });
 }
 
 future<> password_authenticator::drop(std::string_view name) const {
@@ -303,7 +362,9 @@ future<> password_authenticator::drop(std::string_view name) const {
     return _qp.execute_internal(
             query, consistency_for_user(name),
             internal_distributed_timeout_config(),
-            {sstring(name)}).discard_result();
+            {sstring(name)}).discard_result().finally([this, name = sstring(name)] {
+        forget_verified(name);
+    });
 }
 
 future<custom_options> password_authenticator::query_custom_options(std::string_view role_name) const {
@@ -41,7 +41,10 @@
 
 #pragma once
 
+#include <unordered_map>
+
 #include <seastar/core/abort_source.hh>
+#include <seastar/core/lowres_clock.hh>
 
 #include "auth/authenticator.hh"
 #include "cql3/query_processor.hh"
@@ -60,6 +63,17 @@ class password_authenticator : public authenticator {
     future<> _stopped;
     seastar::abort_source _as;
 
+    // Recently verified credentials, by role name. A login with the same password skips both the read of the
+    // salted hash and the (deliberately expensive) password hashing. Changes of the password and dropped roles
+    // remove the entry on the local shard; other shards and nodes pick them up once it expires.
+    struct verified_credentials {
+        bytes password_digest;
+        lowres_clock::time_point expiry;
+    };
+    mutable std::unordered_map<sstring, verified_credentials> _verified_credentials;
+    // Random, so that the cached digests are of no use outside of this shard.
+    bytes _digest_key;
+
 public:
     static db::consistency_level consistency_for_user(std::string_view role_name);
 
@@ -99,6 +113,16 @@ class password_authenticator : public authenticator {
     future<> migrate_legacy_metadata() const;
 
     future<> create_default_if_missing() const;
+
+    bytes password_digest(std::string_view password) const;
+
+    bool verified_recently(const sstring& role_name, const bytes& digest) const;
+
+    void remember_verified(const sstring& role_name, bytes digest) const;
+
+    void forget_verified(std::string_view role_name) const {
+        _verified_credentials.erase(sstring(role_name));
+    }
 };
 
 }
@@ -31,6 +31,9 @@ permissions_cache::permissions_cache(const permissions_cache_config& c, service&
         : _cache(c.max_entries, c.validity_period, c.update_period, log, [&ser, &log](const key_type& k) {
               log.debug("Refreshing permissions for {}", k.first);
               return ser.get_uncached_permissions(k.first, k.second);
+          }, [&ser] () -> cache_type& {
+              // Every key is owned by a single shard, which is the only one querying the authorizer for it.
+              return ser.container().local()._permissions_cache->_cache;
           }) {
 }
 
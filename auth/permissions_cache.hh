@@ -64,10 +64,9 @@ struct permissions_cache_config final {
 };
 
 class permissions_cache final {
-    using cache_type = utils::loading_cache<
+    using cache_type = utils::shard_owned_loading_cache<
             std::pair<role_or_anonymous, resource>,
             permission_set,
-            utils::loading_cache_reload_enabled::yes,
             utils::simple_entry_size<permission_set>,
             utils::tuple_hash>;
 
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "auth/service_level.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <seastar/core/print.hh>
+
+namespace auth {
+
+service_level_controller::level_shares
+service_level_controller::parse_levels(const std::unordered_map<sstring, sstring>& levels) {
+    level_shares result;
+    result.reserve(levels.size());
+
+    for (auto&& [name, value] : levels) {
+        unsigned long shares;
+        try {
+            shares = std::stoul(std::string(value));
+        } catch (const std::logic_error&) {
+            throw std::invalid_argument(format("Invalid shares for service level {}: {}", name, value));
+        }
+        if (shares < 1 || shares > 1000) {
+            throw std::invalid_argument(format("Shares of service level {} must be between 1 and 1000, got {}", name, shares));
+        }
+        result.emplace_back(name, unsigned(shares));
+    }
+
+    // Keep the order of the scheduling groups stable across shards and restarts.
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+service_level_controller::service_level_controller(
+        std::vector<service_level> levels,
+        const std::unordered_map<sstring, sstring>& role_levels,
+        seastar::scheduling_group default_sg)
+            : _levels(std::move(levels))
+            , _default_sg(default_sg) {
+    for (auto&& [role, level] : role_levels) {
+        auto it = std::find_if(_levels.begin(), _levels.end(), [&level = level] (const service_level& sl) {
+            return sl.name == level;
+        });
+        if (it == _levels.end()) {
+            throw std::invalid_argument(format("Role {} is attached to an unknown service level {}", role, level));
+        }
+        _role_levels.emplace(role, it - _levels.begin());
+    }
+}
+
+seastar::scheduling_group
+service_level_controller::scheduling_group_for(const std::optional<authenticated_user>& user) const noexcept {
+    if (!user || !user->name) {
+        return _default_sg;
+    }
+
+    auto it = _role_levels.find(*user->name);
+    return it == _role_levels.end() ? _default_sg : _levels[it->second].sg;
+}
+
+}
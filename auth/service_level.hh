@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <seastar/core/scheduling.hh>
+#include <seastar/core/sstring.hh>
+
+#include "auth/authenticated_user.hh"
+#include "seastarx.hh"
+
+namespace auth {
+
+///
+/// A named workload class. The CQL statements of the roles attached to a service level run in its scheduling
+/// group, and the reads they issue on the local replica are admitted by a reader semaphore of their own.
+///
+struct service_level {
+    sstring name;
+    unsigned shares;
+    seastar::scheduling_group sg;
+};
+
+///
+/// Maps logged-in roles to the scheduling group of their service level.
+///
+/// The mapping is immutable, so a single instance may be shared by all shards.
+///
+class service_level_controller final {
+    std::vector<service_level> _levels;
+    std::unordered_map<sstring, size_t> _role_levels;
+    seastar::scheduling_group _default_sg;
+
+public:
+    using level_shares = std::vector<std::pair<sstring, unsigned>>;
+
+    ///
+    /// Parses the `service_levels` configuration option (level name to shares).
+    ///
+    /// \throws std::invalid_argument if shares are not in [1, 1000].
+    ///
+    static level_shares parse_levels(const std::unordered_map<sstring, sstring>&);
+
+    ///
+    /// \param role_levels maps role names to level names.
+    /// \param default_sg the scheduling group of statements issued by roles without a service level.
+    ///
+    /// \throws std::invalid_argument if a role is attached to an unknown level.
+    ///
+    service_level_controller(
+            std::vector<service_level> levels,
+            const std::unordered_map<sstring, sstring>& role_levels,
+            seastar::scheduling_group default_sg);
+
+    const std::vector<service_level>& levels() const noexcept {
+        return _levels;
+    }
+
+    seastar::scheduling_group scheduling_group_for(const std::optional<authenticated_user>&) const noexcept;
+};
+
+}
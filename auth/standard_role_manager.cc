@@ -249,9 +249,26 @@ future<> standard_role_manager::start() {
     });
 }
 
+standard_role_manager::standard_role_manager(cql3::query_processor& qp, ::service::migration_manager& mm)
+        : _qp(qp)
+        , _migration_manager(mm)
+        , _stopped(make_ready_future<>())
+        , _granted_roles_cache(
+                qp.db().get_config().roles_cache_max_entries(),
+                std::chrono::milliseconds(qp.db().get_config().roles_validity_in_ms()),
+                std::chrono::milliseconds(qp.db().get_config().roles_update_interval_in_ms()),
+                log,
+                [this](const sstring& role_name) {
+                    log.debug("Refreshing granted roles of {}", role_name);
+                    return query_granted_uncached(role_name, recursive_role_query::yes);
+                }) {
+}
+
 future<> standard_role_manager::stop() {
     _as.request_abort();
-    return _stopped.handle_exception_type([] (const sleep_aborted&) { }).handle_exception_type([](const abort_requested_exception&) {});;
+    return _stopped.handle_exception_type([] (const sleep_aborted&) { }).handle_exception_type([](const abort_requested_exception&) {}).then([this] {
+        return _granted_roles_cache.stop();
+    });
 }
 
 future<> standard_role_manager::create_or_replace(std::string_view role_name, const role_config& c) const {
@@ -369,6 +386,8 @@ future<> standard_role_manager::drop(std::string_view role_name) const {
 
         return when_all_succeed(revoke_from_members(), revoke_members_of()).then([delete_role = std::move(delete_role)] {
             return delete_role();
+        }).finally([this] {
+            invalidate_granted_roles();
         });
     });
 }
@@ -416,7 +435,9 @@ standard_role_manager::modify_membership(
         return make_ready_future<>();
     };
 
-    return when_all_succeed(modify_roles(), modify_role_members());
+    return when_all_succeed(modify_roles(), modify_role_members()).finally([this] {
+        invalidate_granted_roles();
+    });
 }
 
 future<>
@@ -492,6 +513,14 @@ static future<> collect_roles(
 }
 
 future<role_set> standard_role_manager::query_granted(std::string_view grantee_name, recursive_role_query m) const {
+    if (m == recursive_role_query::yes) {
+        return _granted_roles_cache.get(sstring(grantee_name));
+    }
+
+    return query_granted_uncached(grantee_name, m);
+}
+
+future<role_set> standard_role_manager::query_granted_uncached(std::string_view grantee_name, recursive_role_query m) const {
     const bool recurse = (m == recursive_role_query::yes);
 
     return do_with(
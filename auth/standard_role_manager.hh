@@ -31,6 +31,7 @@
 #include <seastar/core/sstring.hh>
 
 #include "seastarx.hh"
+#include "utils/loading_cache.hh"
 
 namespace cql3 {
 class query_processor;
@@ -50,12 +51,13 @@ class standard_role_manager final : public role_manager {
     future<> _stopped;
     seastar::abort_source _as;
 
+    // Roles granted to a role, directly or transitively. Every authorization check needs them, and resolving
+    // them takes a query per level of the role graph.
+    using granted_roles_cache = utils::loading_cache<sstring, role_set, utils::loading_cache_reload_enabled::yes>;
+    mutable granted_roles_cache _granted_roles_cache;
+
 public:
-    standard_role_manager(cql3::query_processor& qp, ::service::migration_manager& mm)
-            : _qp(qp)
-            , _migration_manager(mm)
-            , _stopped(make_ready_future<>()) {
-    }
+    standard_role_manager(cql3::query_processor&, ::service::migration_manager&);
 
     virtual std::string_view qualified_java_name() const noexcept override;
 
@@ -99,6 +101,14 @@ class standard_role_manager final : public role_manager {
     future<> create_or_replace(std::string_view role_name, const role_config&) const;
 
     future<> modify_membership(std::string_view role_name, std::string_view grantee_name, membership_change) const;
+
+    future<role_set> query_granted_uncached(std::string_view grantee_name, recursive_role_query) const;
+
+    // Any membership change can affect the transitive grants of any role, so all of them are dropped. Other
+    // shards and nodes pick the change up once their entries are refreshed.
+    void invalidate_granted_roles() const {
+        _granted_roles_cache.remove_if([] (const role_set&) { return true; });
+    }
 };
 
 }
@@ -26,6 +26,7 @@
 #include <seastar/core/file.hh>
 #include <chrono>
 #include <cmath>
+#include <optional>
 
 #include "seastarx.hh"
 
@@ -103,6 +104,9 @@ class backlog_controller {
 public:
     backlog_controller(backlog_controller&&) = default;
     float backlog_of_shares(float shares) const;
+    // Stops following the backlog and gives the group the maximum shares of
+    // the controller until shutdown, to get rid of the backlog quickly.
+    void set_max_shares();
     seastar::scheduling_group sg() {
         return _scheduling_group;
     }
@@ -135,16 +139,43 @@ class flush_controller : public backlog_controller {
     {}
 };
 
+// compaction CPU and I/O controller.
+//
+// The shares follow the backlog, and are optionally scaled by a second feedback input: the
+// pressure on foreground latencies, the ratio of the observed latencies to their targets, or
+// nothing if no target is set, which resets the scale.
+// While it is above 1, the latency objectives are at risk and the scale is decreased
+// multiplicatively at every adjustment; while it is below latency_headroom, it is increased
+// again. The scale stays within [min_latency_scale, max_latency_scale], so that a backlog
+// keeps being drained under latency pressure, if more slowly, and the scaled shares never
+// exceed the maximum output of the control points.
 class compaction_controller : public backlog_controller {
 public:
     static constexpr unsigned normalization_factor = 30;
     static constexpr float disable_backlog = std::numeric_limits<double>::infinity();
     static constexpr float backlog_disabled(float backlog) { return std::isinf(backlog); }
+    static constexpr float min_latency_scale = 0.25;
+    static constexpr float max_latency_scale = 2;
+    static constexpr float latency_scale_decrease = 0.8;
+    static constexpr float latency_scale_increase = 1.05;
+    static constexpr float latency_headroom = 0.5;
+private:
+    std::function<std::optional<float>()> _latency_pressure;
+    float _latency_scale = 1;
+protected:
+    virtual void update_controller(float shares) override;
+public:
     compaction_controller(seastar::scheduling_group sg, const ::io_priority_class& iop, float static_shares) : backlog_controller(sg, iop, static_shares) {}
-    compaction_controller(seastar::scheduling_group sg, const ::io_priority_class& iop, std::chrono::milliseconds interval, std::function<float()> current_backlog)
+    compaction_controller(seastar::scheduling_group sg, const ::io_priority_class& iop, std::chrono::milliseconds interval, std::function<float()> current_backlog,
+            std::function<std::optional<float>()> latency_pressure = {})
         : backlog_controller(sg, iop, std::move(interval),
           std::vector<backlog_controller::control_point>({{0.0, 50}, {1.5, 100} , {normalization_factor, 1000}}),
           std::move(current_backlog)
         )
+        , _latency_pressure(std::move(latency_pressure))
     {}
+
+    float latency_scale() const {
+        return _latency_scale;
+    }
 };
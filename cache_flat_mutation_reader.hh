@@ -85,6 +85,8 @@ class cache_flat_mutation_reader final : public flat_mutation_reader::impl {
 
     state _state = state::before_static_row;
     lw_shared_ptr<read_context> _read_context;
+    // The LRU segment into which this reader links rows it populates or reads.
+    lru_segment _lru_segment;
     partition_snapshot_row_cursor _next_row;
     bool _next_row_in_range = false;
 
@@ -132,6 +134,10 @@ class cache_flat_mutation_reader final : public flat_mutation_reader::impl {
     void maybe_add_to_cache(const clustering_row& cr);
     void maybe_add_to_cache(const range_tombstone& rt);
     void maybe_add_to_cache(const static_row& sr);
+    // Drops from a freshly populated row the data shadowed by tombstones and
+    // turns expired cells into tombstones. Never purges tombstones, so the
+    // cached partition reads the same, only smaller.
+    void compact_for_cache(deletable_row& row, row_tombstone tomb);
     void maybe_set_static_row_continuous();
     void finish_reader() {
         push_mutation_fragment(partition_end());
@@ -139,6 +145,7 @@ class cache_flat_mutation_reader final : public flat_mutation_reader::impl {
         _state = state::end_of_stream;
     }
     void touch_partition();
+    void add_to_lru(rows_entry&);
 public:
     cache_flat_mutation_reader(schema_ptr s,
                                dht::decorated_key dk,
@@ -156,6 +163,7 @@ class cache_flat_mutation_reader final : public flat_mutation_reader::impl {
         , _lower_bound(position_in_partition::before_all_clustered_rows())
         , _upper_bound(position_in_partition_view::before_all_clustered_rows())
         , _read_context(std::move(ctx))
+        , _lru_segment(_snp->tracker()->segment_for(*_schema, dk, _read_context->is_range_query()))
         , _next_row(*_schema, *_snp)
     {
         clogger.trace("csm {}: table={}.{}", this, _schema->ks_name(), _schema->cf_name());
@@ -208,7 +216,14 @@ future<> cache_flat_mutation_reader::process_static_row(db::timeout_clock::time_
 
 inline
 void cache_flat_mutation_reader::touch_partition() {
-    _snp->touch();
+    _snp->touch(_lru_segment);
+}
+
+inline
+void cache_flat_mutation_reader::add_to_lru(rows_entry& e) {
+    // Older versions must be evicted before newer ones, which can be
+    // guaranteed for the probationary segment only when there are none.
+    _snp->tracker()->insert(e, _snp->version_count() == 1 ? _lru_segment : lru_segment::main);
 }
 
 inline
@@ -347,13 +362,13 @@ future<> cache_flat_mutation_reader::read_from_underlying(db::timeout_clock::tim
                         if (query::is_single_row(*_schema, *_ck_ranges_curr)) {
                             with_allocator(_snp->region().allocator(), [&] {
                                 auto e = alloc_strategy_unique_ptr<rows_entry>(
-                                    current_allocator().construct<rows_entry>(_ck_ranges_curr->start()->value()));
+                                    current_allocator().construct<rows_entry>(*_schema, _ck_ranges_curr->start()->value()));
                                 // Use _next_row iterator only as a hint, because there could be insertions after _upper_bound.
                                 auto insert_result = rows.insert_check(_next_row.get_iterator_in_latest_version(), *e, less);
                                 auto inserted = insert_result.second;
                                 auto it = insert_result.first;
                                 if (inserted) {
-                                    _snp->tracker()->insert(*e);
+                                    add_to_lru(*e);
                                     e.release();
                                     auto next = std::next(it);
                                     it->set_continuous(next->continuous());
@@ -369,7 +384,7 @@ future<> cache_flat_mutation_reader::read_from_underlying(db::timeout_clock::tim
                                 auto inserted = insert_result.second;
                                 if (inserted) {
                                     clogger.trace("csm {}: inserted dummy at {}", this, _upper_bound);
-                                    _snp->tracker()->insert(*e);
+                                    add_to_lru(*e);
                                     e.release();
                                 } else {
                                     clogger.trace("csm {}: mark {} as continuous", this, insert_result.first->position());
@@ -414,7 +429,7 @@ bool cache_flat_mutation_reader::ensure_population_lower_bound() {
             auto inserted = insert_result.second;
             if (inserted) {
                 clogger.trace("csm {}: inserted lower bound dummy at {}", this, e->position());
-                _snp->tracker()->insert(*e);
+                add_to_lru(*e);
                 e.release();
             }
         });
@@ -463,12 +478,22 @@ void cache_flat_mutation_reader::maybe_add_to_cache(const clustering_row& cr) {
         }
         auto new_entry = alloc_strategy_unique_ptr<rows_entry>(
             current_allocator().construct<rows_entry>(*_schema, cr.key(), cr.tomb(), cr.marker(), cr.cells()));
+        if (_snp->tracker()->compact_on_population()) {
+            row_tombstone tomb = cr.tomb();
+            tomb.apply(_snp->partition_tombstone());
+            tomb.apply(mp.row_tombstones().search_tombstone_covering(*_schema, cr.key()));
+            compact_for_cache(new_entry->row(), tomb);
+        }
+        if (!_read_context->digest_requested()) {
+            // Packing drops the cell hashes, keep them for digest reads.
+            new_entry->row().cells().pack(*_schema, column_kind::regular_column);
+        }
         new_entry->set_continuous(false);
         auto it = _next_row.iterators_valid() ? _next_row.get_iterator_in_latest_version()
                                               : mp.clustered_rows().lower_bound(cr.key(), less);
         auto insert_result = mp.clustered_rows().insert_check(it, *new_entry, less);
         if (insert_result.second) {
-            _snp->tracker()->insert(*new_entry);
+            add_to_lru(*new_entry);
             new_entry.release();
         }
         it = insert_result.first;
@@ -496,13 +521,13 @@ inline
 void cache_flat_mutation_reader::start_reading_from_underlying() {
     clogger.trace("csm {}: start_reading_from_underlying(), range=[{}, {})", this, _lower_bound, _next_row_in_range ? _next_row.position() : _upper_bound);
     _state = state::move_to_underlying;
-    _next_row.touch();
+    _next_row.touch(_lru_segment);
 }
 
 inline
 void cache_flat_mutation_reader::copy_from_cache_to_buffer() {
     clogger.trace("csm {}: copy_from_cache, next={}, next_row_in_range={}", this, _next_row.position(), _next_row_in_range);
-    _next_row.touch();
+    _next_row.touch(_lru_segment);
     position_in_partition_view next_lower_bound = _next_row.dummy() ? _next_row.position() : position_in_partition_view::after_key(_next_row.key());
     for (auto &&rts : _snp->range_tombstones(_lower_bound, _next_row_in_range ? next_lower_bound : _upper_bound)) {
         position_in_partition::less_compare less(*_schema);
@@ -571,10 +596,13 @@ void cache_flat_mutation_reader::move_to_range(query::clustering_row_ranges::con
                 clogger.trace("csm {}: insert dummy at {}", this, _lower_bound);
                 auto it = with_allocator(_lsa_manager.region().allocator(), [&] {
                     auto& rows = _snp->version()->partition().clustered_rows();
-                    auto new_entry = current_allocator().construct<rows_entry>(*_schema, _lower_bound, is_dummy::yes, is_continuous::no);
-                    return rows.insert_before(_next_row.get_iterator_in_latest_version(), *new_entry);
+                    auto new_entry = alloc_strategy_unique_ptr<rows_entry>(
+                        current_allocator().construct<rows_entry>(*_schema, _lower_bound, is_dummy::yes, is_continuous::no));
+                    auto it = rows.insert_before(_next_row.get_iterator_in_latest_version(), *new_entry);
+                    new_entry.release();
+                    return it;
                 });
-                _snp->tracker()->insert(*it);
+                add_to_lru(*it);
                 _last_row = partition_snapshot_row_weakref(*_snp, it, true);
             } else {
                 _read_context->cache().on_mispopulate();
@@ -674,13 +702,27 @@ void cache_flat_mutation_reader::maybe_add_to_cache(const static_row& sr) {
             if (_read_context->digest_requested()) {
                 sr.cells().prepare_hash(*_schema, column_kind::static_column);
             }
-            _snp->version()->partition().static_row().apply(*_schema, column_kind::static_column, sr.cells());
+            auto& static_row = _snp->version()->partition().static_row();
+            static_row.apply(*_schema, column_kind::static_column, sr.cells());
+            if (_snp->tracker()->compact_on_population()) {
+                static_row.compact_and_expire(*_schema, column_kind::static_column, row_tombstone(_snp->partition_tombstone()),
+                        gc_clock::now(), always_gc, gc_clock::time_point::min());
+            }
         });
     } else {
         _read_context->cache().on_mispopulate();
     }
 }
 
+inline
+void cache_flat_mutation_reader::compact_for_cache(deletable_row& row, row_tombstone tomb) {
+    // With gc_before at the minimum nothing is old enough to be purged.
+    auto now = gc_clock::now();
+    auto gc_before = gc_clock::time_point::min();
+    row.marker().compact_and_expire(tomb.tomb(), now, always_gc, gc_before);
+    row.cells().compact_and_expire(*_schema, column_kind::regular_column, tomb, now, always_gc, gc_before, row.marker());
+}
+
 inline
 void cache_flat_mutation_reader::maybe_set_static_row_continuous() {
     if (can_populate()) {
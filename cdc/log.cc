@@ -111,6 +111,10 @@ cdc::stats::stats() {
                         sm::description(format("number of {} preimage queries performed", kind)),
                         {}),
 
+                sm::make_total_operations("preimage_local_reads_" + kind, counters.preimage_local_reads,
+                        sm::description(format("number of {} preimage queries served by the local replica", kind)),
+                        {}),
+
                 sm::make_total_operations("operations_with_preimage_" + kind, counters.with_preimage_count,
                         sm::description(format("number of {} operations that included preimage", kind)),
                         {}),
@@ -1290,10 +1294,24 @@ class transformer final {
         auto partition_slice = query::partition_slice(std::move(bounds), std::move(static_columns), std::move(regular_columns), std::move(opts));
         auto command = ::make_lw_shared<query::read_command>(_schema->id(), _schema->version(), partition_slice, row_limit);
 
-        return _ctx._proxy.query(_schema, std::move(command), std::move(partition_ranges), cl, service::storage_proxy::coordinator_query_options(default_timeout(), empty_service_permit(), client_state)).then(
-                [s = _schema, partition_slice = std::move(partition_slice), selection = std::move(selection)] (service::storage_proxy::coordinator_query_result qr) -> lw_shared_ptr<cql3::untyped_result_set> {
+        auto f = make_ready_future<foreign_ptr<lw_shared_ptr<query::result>>>();
+        auto& db = _ctx._proxy.get_db().local();
+        if (db.get_config().cdc_local_preimage_reads() && _ctx._proxy.is_local_replica(db.find_keyspace(_schema->ks_name()), m.token())) {
+            // The base write will be applied on this node too, so read the
+            // preimage from its own replica instead of paying for a
+            // coordinator read at cl.
+            ++_ctx._proxy.get_cdc_stats().counters_total.preimage_local_reads;
+            f = _ctx._proxy.query_local_replica(_schema, std::move(command), partition_ranges.front(), default_timeout());
+        } else {
+            f = _ctx._proxy.query(_schema, std::move(command), std::move(partition_ranges), cl, service::storage_proxy::coordinator_query_options(default_timeout(), empty_service_permit(), client_state)).then(
+                    [] (service::storage_proxy::coordinator_query_result qr) {
+                return std::move(qr.query_result);
+            });
+        }
+        return f.then(
+                [s = _schema, partition_slice = std::move(partition_slice), selection = std::move(selection)] (foreign_ptr<lw_shared_ptr<query::result>> qr) -> lw_shared_ptr<cql3::untyped_result_set> {
                     cql3::selection::result_set_builder builder(*selection, gc_clock::now(), cql_serialization_format::latest());
-                    query::result_view::consume(*qr.query_result, partition_slice, cql3::selection::result_set_builder::visitor(builder, *s, *selection));
+                    query::result_view::consume(*qr, partition_slice, cql3::selection::result_set_builder::visitor(builder, *s, *selection));
                     auto result_set = builder.build();
                     if (!result_set || result_set->empty()) {
                         return {};
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <seastar/core/thread.hh>
+
+#include "cdc/shard_changes.hh"
+#include "cdc/log.hh"
+#include "cql3/result_set.hh"
+#include "cql3/selection/selection.hh"
+#include "database.hh"
+#include "db/config.hh"
+#include "db/token_shards_virtual_reader.hh"
+#include "query-result-reader.hh"
+#include "utils/UUID_gen.hh"
+
+namespace cdc {
+
+shard_changes::shard_changes() = default;
+shard_changes::shard_changes(shard_changes&&) noexcept = default;
+shard_changes::~shard_changes() = default;
+
+static size_t log_column_index(const cql3::selection::selection& selection, const schema& s, std::string_view name) {
+    auto* cdef = s.get_column_definition(to_bytes(log_meta_column_name(name)));
+    if (!cdef) {
+        throw std::invalid_argument(format("{}.{} is not a CDC log table", s.ks_name(), s.cf_name()));
+    }
+    return selection.index_of(*cdef);
+}
+
+static std::optional<query::clustering_range::bound> time_bound(const schema& s, const std::optional<utils::UUID>& time) {
+    if (!time) {
+        return std::nullopt;
+    }
+    return query::clustering_range::bound(clustering_key_prefix::from_exploded(s, {timeuuid_type->decompose(*time)}), false);
+}
+
+future<shard_changes> read_shard_changes(database& db, schema_ptr s,
+        std::optional<utils::UUID> after, std::optional<utils::UUID> before, uint32_t limit) {
+    return seastar::async([&db, s = std::move(s), after, before, limit] {
+        auto selection = cql3::selection::selection::wildcard(s);
+        const auto stream_idx = log_column_index(*selection, *s, "stream_id");
+        const auto time_idx = log_column_index(*selection, *s, "time");
+        const auto seq_idx = log_column_index(*selection, *s, "batch_seq_no");
+
+        dht::partition_range_vector ranges;
+        for (auto& sr : db::token_shards::local_shard_ranges(db, s->get_sharder())) {
+            if (sr.shard == this_shard_id()) {
+                ranges.push_back(dht::to_partition_range(std::move(sr.range)));
+            }
+        }
+
+        query::column_id_vector static_columns, regular_columns;
+        for (const column_definition& c : s->static_columns()) {
+            static_columns.push_back(c.id);
+        }
+        for (const column_definition& c : s->regular_columns()) {
+            regular_columns.push_back(c.id);
+        }
+        std::vector<query::clustering_range> bounds{query::clustering_range(time_bound(*s, after), time_bound(*s, before))};
+        query::partition_slice slice(std::move(bounds), std::move(static_columns), std::move(regular_columns), selection->get_query_options());
+
+        auto time_of = [time_idx] (const std::vector<bytes_opt>& row) -> bytes_view {
+            return *row[time_idx];
+        };
+        auto time_less = [] (bytes_view a, bytes_view b) {
+            return timeuuid_type->compare(a, b) < 0;
+        };
+
+        const auto max_size = db.get_config().max_memory_for_unlimited_query();
+        const auto timeout = db::timeout_clock::now() + std::chrono::milliseconds(db.get_config().range_request_timeout_in_ms());
+
+        // Each stream is read up to partition_row_limit rows. Streams which
+        // reach it may have more changes, so only the changes strictly older
+        // than the last change read from any of them are known to be complete.
+        uint32_t partition_row_limit = std::max(limit, 1u);
+        while (true) {
+            slice.set_partition_row_limit(partition_row_limit);
+            query::read_command cmd(s->id(), s->version(), slice, query::max_rows);
+            auto result = db.query(s, cmd, query::result_options::only_result(), ranges, nullptr, max_size, timeout).get0();
+            if (result->is_short_read()) {
+                throw std::runtime_error(format("Changes of {}.{} on shard {} exceed {} bytes, lower the limit",
+                        s->ks_name(), s->cf_name(), this_shard_id(), max_size));
+            }
+
+            cql3::selection::result_set_builder builder(*selection, gc_clock::now(), cql_serialization_format::latest());
+            query::result_view::consume(*result, slice, cql3::selection::result_set_builder::visitor(builder, *s, *selection));
+            auto rs = builder.build();
+
+            // Rows come grouped by stream.
+            std::optional<bytes> complete_before;
+            auto& rows = rs->rows();
+            for (auto it = rows.begin(); it != rows.end();) {
+                auto end = std::find_if(it, rows.end(), [&] (const std::vector<bytes_opt>& row) {
+                    return *row[stream_idx] != *(*it)[stream_idx];
+                });
+                if (uint32_t(end - it) >= partition_row_limit) {
+                    auto last = time_of(*std::prev(end));
+                    if (!complete_before || time_less(last, *complete_before)) {
+                        complete_before = bytes(last);
+                    }
+                }
+                it = end;
+            }
+
+            rs->sort([&] (const std::vector<bytes_opt>& a, const std::vector<bytes_opt>& b) {
+                auto c = timeuuid_type->compare(time_of(a), time_of(b));
+                if (c == 0) {
+                    c = compare_unsigned(*a[stream_idx], *b[stream_idx]);
+                }
+                if (c == 0) {
+                    c = int32_type->compare(*a[seq_idx], *b[seq_idx]);
+                }
+                return c < 0;
+            });
+
+            size_t keep = rows.size();
+            if (complete_before) {
+                keep = std::find_if(rows.begin(), rows.end(), [&] (const std::vector<bytes_opt>& row) {
+                    return !time_less(time_of(row), *complete_before);
+                }) - rows.begin();
+                if (keep == 0) {
+                    // A single change has more than partition_row_limit rows.
+                    partition_row_limit *= 2;
+                    continue;
+                }
+            }
+            if (keep > limit) {
+                auto end = std::max<size_t>(limit, 1);
+                while (end < keep && time_of(rows[end]) == time_of(rows[end - 1])) {
+                    ++end;
+                }
+                keep = end;
+            }
+            rs->trim(keep);
+
+            shard_changes page;
+            if (keep) {
+                page.last_time = utils::UUID_gen::get_UUID(bytes(time_of(rows[keep - 1])));
+            }
+            page.rows = std::move(rs);
+            return page;
+        }
+    });
+}
+
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <seastar/core/future.hh>
+
+#include "database_fwd.hh"
+#include "schema_fwd.hh"
+#include "utils/UUID.hh"
+
+namespace cql3 {
+class result_set;
+}
+
+namespace cdc {
+
+// A page of the changes of a CDC log table stored on one shard.
+struct shard_changes {
+    // Rows of the log with the columns of SELECT *, sorted by
+    // (time, stream_id, batch_seq_no).
+    std::unique_ptr<cql3::result_set> rows;
+    // Time of the last change of the page. Passing it as `after` reads the
+    // next page. Disengaged if the page is empty.
+    std::optional<utils::UUID> last_time;
+
+    shard_changes();
+    shard_changes(shard_changes&&) noexcept;
+    ~shard_changes();
+};
+
+// Reads, with a single read of the current shard, the changes the shard holds
+// for the streams in the primary token ranges of this node, so that reading
+// every shard of every node returns each change once. Only changes with a time
+// greater than `after` and less than `before` are returned, oldest first.
+//
+// The page holds at most `limit` rows, plus the remaining rows of the change
+// the limit falls in: the rows of a change are never split between pages.
+future<shard_changes> read_shard_changes(database& db, schema_ptr log_schema,
+        std::optional<utils::UUID> after, std::optional<utils::UUID> before, uint32_t limit);
+
+}
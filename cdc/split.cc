@@ -262,16 +262,15 @@ bool should_split(const mutation& base_mutation, const schema& base_schema) {
         }
 
         cell.as_collection_mutation().with_deserialized(*cdef.type, [&] (collection_mutation_view_description mview) {
-            auto desc = mview.materialize(*cdef.type);
-            for (auto& [k, v]: desc.cells) {
+            for (auto& [k, v]: mview.cells) {
                 if (check_or_set(v.timestamp(), v.is_live_and_has_ttl() ? v.ttl() : gc_clock::duration(0))) {
                     should_split = true;
                     return;
                 }
             }
 
-            if (desc.tomb) {
-                if (check_or_set(desc.tomb.timestamp, gc_clock::duration(0))) {
+            if (mview.tomb) {
+                if (check_or_set(mview.tomb.timestamp, gc_clock::duration(0))) {
                     should_split = true;
                     return;
                 }
@@ -368,9 +367,13 @@ bool should_split(const mutation& base_mutation, const schema& base_schema) {
         }
     }
 
-    if (p.partition_tombstone().timestamp != api::missing_timestamp
-            && (!p.row_tombstones().empty() || had_static_row || had_clustered_row)) {
-        return true;
+    if (p.partition_tombstone().timestamp != api::missing_timestamp) {
+        if (!p.row_tombstones().empty() || had_static_row || had_clustered_row) {
+            return true;
+        }
+
+        // A lone partition deletion is a single change
+        found_ts = p.partition_tombstone().timestamp;
     }
 
     // A mutation with no timestamp will be split into 0 mutations
@@ -31,6 +31,9 @@ class mutation;
 
 namespace cdc {
 
+// Whether base_mutation holds more than one change (e.g. cells with different
+// timestamps or TTLs) and has to go through for_each_change(). Mutations which
+// don't are transformed into a log mutation directly.
 bool should_split(const mutation& base_mutation, const schema& base_schema);
 void for_each_change(const mutation& base_mutation, const schema_ptr& base_schema,
         seastar::noncopyable_function<void(mutation, api::timestamp_type, bytes, int&)>);
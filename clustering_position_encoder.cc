@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "clustering_position_encoder.hh"
+
+namespace {
+
+// Header bytes of components. The bound weights of positions, which follow
+// the last component, sort below or above all of these, inverted included.
+constexpr uint8_t empty_value = 0x20;
+constexpr uint8_t non_empty_value = 0x30;
+
+uint8_t weight_byte(bound_weight w) {
+    switch (w) {
+    case bound_weight::before_all_prefixed: return 0x10;
+    case bound_weight::equal: return 0x18;
+    case bound_weight::after_all_prefixed: return 0xf0;
+    }
+    abort();
+}
+
+void append(clustering_position_encoder::buffer& out, uint8_t b) {
+    out.push_back(bytes::value_type(b));
+}
+
+}
+
+std::optional<clustering_position_encoder::component>
+clustering_position_encoder::component_for(const abstract_type& t, bool reversed) {
+    switch (t.get_kind()) {
+    case abstract_type::kind::reversed:
+        return component_for(*t.underlying_type(), !reversed);
+    case abstract_type::kind::byte:
+        return component{component_kind::signed_integer, 1, reversed};
+    case abstract_type::kind::short_kind:
+        return component{component_kind::signed_integer, 2, reversed};
+    case abstract_type::kind::int32:
+        return component{component_kind::signed_integer, 4, reversed};
+    case abstract_type::kind::long_kind:
+    case abstract_type::kind::time:
+    case abstract_type::kind::timestamp:
+        return component{component_kind::signed_integer, 8, reversed};
+    case abstract_type::kind::simple_date:
+        return component{component_kind::unsigned_integer, 4, reversed};
+    case abstract_type::kind::boolean:
+        return component{component_kind::boolean, 1, reversed};
+    case abstract_type::kind::timeuuid:
+        return component{component_kind::timeuuid, 16, reversed};
+    default:
+        if (t.is_byte_order_comparable()) {
+            return component{component_kind::bytes, 0, reversed};
+        }
+        return std::nullopt;
+    }
+}
+
+std::unique_ptr<const clustering_position_encoder>
+clustering_position_encoder::make(const std::vector<data_type>& types) {
+    std::vector<component> components;
+    components.reserve(types.size());
+    for (auto&& t : types) {
+        auto c = component_for(*t, false);
+        if (!c) {
+            return nullptr;
+        }
+        components.push_back(*c);
+    }
+    return std::unique_ptr<const clustering_position_encoder>(new clustering_position_encoder(std::move(components)));
+}
+
+bool clustering_position_encoder::encode_component(const component& c, bytes_view v, buffer& out) {
+    auto start = out.size();
+    if (v.empty()) {
+        append(out, empty_value);
+    } else {
+        append(out, non_empty_value);
+        switch (c.kind) {
+        case component_kind::signed_integer:
+            if (v.size() != c.fixed_size) {
+                return false;
+            }
+            append(out, uint8_t(v[0]) ^ 0x80);
+            for (auto b : v.substr(1)) {
+                out.push_back(b);
+            }
+            break;
+        case component_kind::unsigned_integer:
+            if (v.size() != c.fixed_size) {
+                return false;
+            }
+            for (auto b : v) {
+                out.push_back(b);
+            }
+            break;
+        case component_kind::boolean:
+            if (v.size() != c.fixed_size) {
+                return false;
+            }
+            append(out, v[0] != 0);
+            break;
+        case component_kind::timeuuid:
+            if (v.size() != c.fixed_size) {
+                return false;
+            }
+            // The timestamp, most significant bits first, as compared by
+            // timeuuid_compare_bytes(), then the bytes compared as signed.
+            append(out, uint8_t(v[6]) & 0x0f);
+            for (auto i : {7, 4, 5, 0, 1, 2, 3}) {
+                out.push_back(v[i]);
+            }
+            for (auto b : v) {
+                append(out, uint8_t(b) ^ 0x80);
+            }
+            break;
+        case component_kind::bytes:
+            for (auto b : v) {
+                out.push_back(b);
+                if (b == 0) {
+                    append(out, 0xff);
+                }
+            }
+            append(out, 0);
+            append(out, 0);
+            break;
+        }
+    }
+    if (c.reversed) {
+        for (auto i = start; i < out.size(); ++i) {
+            out[i] = ~out[i];
+        }
+    }
+    return true;
+}
+
+bool clustering_position_encoder::encode(position_in_partition_view pos, buffer& out) const {
+    auto& key = pos.key();
+    if (key.representation().is_fragmented()) {
+        return false;
+    }
+    auto c = _components.begin();
+    for (bytes_view v : key.components()) {
+        if (c == _components.end() || !encode_component(*c++, v, out)) {
+            return false;
+        }
+    }
+    append(out, weight_byte(pos.get_bound_weight()));
+    return true;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "types.hh"
+#include "position_in_partition.hh"
+#include "utils/small_vector.hh"
+
+// Byte-comparable encoding of positions in the clustered region
+//
+// Maps a position to a byte string such that compare_unsigned() orders the
+// encodings of two positions the same way as position_in_partition::tri_compare
+// orders the positions, so that comparing them doesn't involve decoding the
+// key components.
+//
+// Each component is encoded as a header byte, which orders empty values
+// before non-empty ones, followed by the value mapped to an order-preserving,
+// prefix-free byte string:
+//  - signed integers (tinyint, smallint, int, bigint, time, timestamp) as
+//    big-endian with the sign bit flipped;
+//  - unsigned integers (date) and booleans as big-endian;
+//  - timeuuid as its reordered timestamp followed by the bytes of the
+//    uuid with sign bits flipped, mirroring how they are compared;
+//  - types compared as unsigned byte strings (ascii, text, blob, inet,
+//    duration) with 0x00 escaped as 0x00 0xff and terminated by 0x00 0x00.
+// Components of reversed types have all their bytes, header included, inverted.
+// The encoding ends with a byte for the bound weight, which orders prefixes
+// before or after all the keys they prefix.
+//
+// Only schemas whose clustering columns all have the encoding get an
+// encoder, see schema::clustering_position_encoder().
+class clustering_position_encoder {
+public:
+    using buffer = utils::small_vector<bytes::value_type, 64>;
+private:
+    enum class component_kind : uint8_t {
+        signed_integer,
+        unsigned_integer,
+        boolean,
+        timeuuid,
+        bytes,
+    };
+    struct component {
+        component_kind kind;
+        uint8_t fixed_size;
+        bool reversed;
+    };
+    std::vector<component> _components;
+private:
+    explicit clustering_position_encoder(std::vector<component> components) : _components(std::move(components)) { }
+
+    static std::optional<component> component_for(const abstract_type& t, bool reversed);
+    static bool encode_component(const component& c, bytes_view v, buffer& out);
+public:
+    // Returns an encoder for clustering keys of the given types, or nullptr
+    // if some of them have no byte-comparable encoding.
+    static std::unique_ptr<const clustering_position_encoder> make(const std::vector<data_type>& types);
+
+    // Appends the encoding of a position in the clustered region to out.
+    // Returns false, leaving out in unspecified state, if the position can't
+    // be encoded, e.g. because its key is malformed or fragmented.
+    bool encode(position_in_partition_view pos, buffer& out) const;
+};
@@ -25,6 +25,7 @@
 #include <seastar/util/noncopyable_function.hh>
 
 #include "schema_fwd.hh"
+#include "gc_clock.hh"
 #include "sstables/shared_sstable.hh"
 #include "exceptions/exceptions.hh"
 #include "sstables/compaction_backlog_manager.hh"
@@ -44,6 +45,7 @@ enum class compaction_strategy_type {
     leveled,
     date_tiered,
     time_window,
+    incremental,
 };
 
 class compaction_strategy_impl;
@@ -66,6 +68,8 @@ class compaction_strategy {
     compaction_strategy& operator=(compaction_strategy&&);
 
     // Return a list of sstables to be compacted after applying the strategy.
+    // Repaired and unrepaired sstables are never compacted together, so that
+    // incremental repair doesn't have to read repaired data again.
     compaction_descriptor get_sstables_for_compaction(column_family& cfs, std::vector<shared_sstable> candidates);
 
     compaction_descriptor get_major_compaction_job(column_family& cf, std::vector<shared_sstable> candidates);
@@ -85,6 +89,14 @@ class compaction_strategy {
     // Return true if compaction strategy doesn't care if a sstable belonging to partial sstable run is compacted.
     bool can_compact_partial_runs() const;
 
+    // Return the deletion time before which a sstable is fully expired, and can be
+    // dropped by compaction without being read if it doesn't shadow older data.
+    gc_clock::time_point expired_sstables_gc_before(const schema& s) const;
+
+    // Return if tombstones are purged based on the repair history of their token range
+    // instead of gc_grace_seconds.
+    bool repair_based_tombstone_gc() const;
+
     // An estimation of number of compaction for strategy to be satisfied.
     int64_t estimated_pending_compactions(column_family& cf) const;
 
@@ -102,6 +114,8 @@ class compaction_strategy {
             return "DateTieredCompactionStrategy";
         case compaction_strategy_type::time_window:
             return "TimeWindowCompactionStrategy";
+        case compaction_strategy_type::incremental:
+            return "IncrementalCompactionStrategy";
         default:
             throw std::runtime_error("Invalid Compaction Strategy");
         }
@@ -122,6 +136,8 @@ class compaction_strategy {
             return compaction_strategy_type::date_tiered;
         } else if (short_name == "TimeWindowCompactionStrategy") {
             return compaction_strategy_type::time_window;
+        } else if (short_name == "IncrementalCompactionStrategy") {
+            return compaction_strategy_type::incremental;
         } else {
             throw exceptions::configuration_exception(format("Unable to find compaction strategy class '{}'", name));
         }
@@ -140,6 +156,10 @@ class compaction_strategy {
     uint64_t adjust_partition_estimate(const mutation_source_metadata& ms_meta, uint64_t partition_estimate);
 
     reader_consumer make_interposer_consumer(const mutation_source_metadata& ms_meta, reader_consumer end_consumer);
+
+    // Tells whether the output of the compaction is expected to be rarely read,
+    // so that it can be placed on slower storage.
+    bool is_cold_output(const compaction_descriptor& descriptor) const;
 };
 
 // Creates a compaction_strategy object from one of the strategies available.
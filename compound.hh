@@ -24,6 +24,7 @@
 #include "types.hh"
 #include <iosfwd>
 #include <algorithm>
+#include <array>
 #include <vector>
 #include <boost/range/iterator_range.hpp>
 #include <boost/range/adaptor/transformed.hpp>
@@ -37,6 +38,10 @@ template<allow_prefixes AllowPrefixes = allow_prefixes::no>
 class compound_type final {
 private:
     const std::vector<data_type> _types;
+    // The comparators of _types, resolved once for the schema the compound
+    // belongs to, which the key comparisons use instead of dispatching on
+    // each component's type.
+    const std::vector<compiled_tri_comparator> _comparators;
     const bool _byte_order_equal;
     const bool _byte_order_comparable;
     const bool _is_reversed;
@@ -48,6 +53,9 @@ class compound_type final {
 
     compound_type(std::vector<data_type> types)
         : _types(std::move(types))
+        , _comparators(boost::copy_range<std::vector<compiled_tri_comparator>>(_types | boost::adaptors::transformed([] (const data_type& t) {
+                return t->compile_tri_comparator();
+            })))
         , _byte_order_equal(std::all_of(_types.begin(), _types.end(), [] (auto t) {
                 return t->is_byte_order_equal();
             }))
@@ -61,6 +69,11 @@ class compound_type final {
         return _types;
     }
 
+    // Comparators of the components, in the same order as types().
+    const std::vector<compiled_tri_comparator>& comparators() const {
+        return _comparators;
+    }
+
     bool is_singular() const {
         return _types.size() == 1;
     }
@@ -211,11 +224,66 @@ class compound_type final {
                 return compare_unsigned(b1, b2);
             }
         }
-        return lexicographical_tri_compare(_types.begin(), _types.end(),
-            begin(b1), end(b1), begin(b2), end(b2), [] (auto&& type, auto&& v1, auto&& v2) {
-                return type->compare(v1, v2);
+        return lexicographical_tri_compare(_comparators.begin(), _comparators.end(),
+            begin(b1), end(b1), begin(b2), end(b2), [] (const compiled_tri_comparator& cmp, bytes_view v1, bytes_view v2) {
+                return cmp(v1, v2);
             });
     }
+    // Compares serialized compounds which may be fragmented, without
+    // linearizing them. Components are compared by abstract_type::compare()
+    // on fragment ranges, so only components of types which are not byte
+    // order comparable and straddle a fragment boundary are ever copied.
+    template<typename FragmentedBuffer1, typename FragmentedBuffer2,
+             typename = std::enable_if_t<is_fragment_range_v<FragmentedBuffer1> && is_fragment_range_v<FragmentedBuffer2>>>
+    int compare(const FragmentedBuffer1& b1, const FragmentedBuffer2& b2) {
+        if (_byte_order_comparable) {
+            if (_is_reversed) {
+                return compare_unsigned(b2, b1);
+            } else {
+                return compare_unsigned(b1, b2);
+            }
+        }
+        fragment_range_cursor<FragmentedBuffer1> c1(b1);
+        fragment_range_cursor<FragmentedBuffer2> c2(b2);
+        for (auto&& type : _types) {
+            if (c1.empty() || c2.empty()) {
+                break;
+            }
+            auto v1 = read_component(c1);
+            auto v2 = read_component(c2);
+            if (auto c = type->compare(v1, v2)) {
+                return c;
+            }
+        }
+        return int(!c1.empty()) - int(!c2.empty());
+    }
+    template<typename FragmentedBuffer1, typename FragmentedBuffer2,
+             typename = std::enable_if_t<is_fragment_range_v<FragmentedBuffer1> && is_fragment_range_v<FragmentedBuffer2>>>
+    bool equal(const FragmentedBuffer1& b1, const FragmentedBuffer2& b2) {
+        if (_byte_order_equal) {
+            return compare_unsigned(b1, b2) == 0;
+        }
+        return compare(b1, b2) == 0;
+    }
+private:
+    template<typename FragmentedBuffer>
+    static auto read_component(fragment_range_cursor<FragmentedBuffer>& c) {
+        if (c.size_bytes() < sizeof(size_type)) {
+            throw_with_backtrace<marshal_exception>(format("compound_type - not enough bytes for component length, got {:d}", c.size_bytes()));
+        }
+        std::array<bytes_view::value_type, sizeof(size_type)> len_bytes;
+        auto out = len_bytes.begin();
+        for (bytes_view fragment : c.read(sizeof(size_type))) {
+            out = std::copy(fragment.begin(), fragment.end(), out);
+        }
+        bytes_view len_view(len_bytes.data(), len_bytes.size());
+        auto len = read_simple<size_type>(len_view);
+        if (c.size_bytes() < len) {
+            throw_with_backtrace<marshal_exception>(format("compound_type - not enough bytes, expected {:d}, got {:d}", len, c.size_bytes()));
+        }
+        return c.read(len);
+    }
+public:
     // Retruns true iff given prefix has no missing components
     bool is_full(bytes_view v) const {
         assert(AllowPrefixes == allow_prefixes::yes);
@@ -19,9 +19,10 @@
  * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <lz4.h>
-#include <zlib.h>
 #include <snappy-c.h>
+#include "libdeflate/libdeflate.h"
 
 #include "compress.hh"
 #include "utils/class_registrator.hh"
@@ -50,7 +51,25 @@ class snappy_processor: public compressor {
     size_t compress_max_size(size_t input_len) const override;
 };
 
+// Produces and consumes zlib-wrapped deflate streams, like zlib's
+// deflate() and inflate() and Cassandra's DeflateCompressor, using
+// libdeflate's whole-buffer API, which is much faster for chunk-sized
+// inputs. The (de)compressor state is allocated once per shard.
 class deflate_processor: public compressor {
+    // Same as zlib's Z_DEFAULT_COMPRESSION.
+    static constexpr int compression_level = 6;
+
+    struct compressor_deleter {
+        void operator()(libdeflate_compressor* c) const { libdeflate_free_compressor(c); }
+    };
+    struct decompressor_deleter {
+        void operator()(libdeflate_decompressor* d) const { libdeflate_free_decompressor(d); }
+    };
+    mutable std::unique_ptr<libdeflate_compressor, compressor_deleter> _compressor;
+    mutable std::unique_ptr<libdeflate_decompressor, decompressor_deleter> _decompressor;
+
+    libdeflate_compressor* get_compressor() const;
+    libdeflate_decompressor* get_decompressor() const;
 public:
     using compressor::compressor;
 
@@ -111,6 +130,7 @@ const sstring compression_parameters::SSTABLE_COMPRESSION = "sstable_compression
 const sstring compression_parameters::CHUNK_LENGTH_KB = "chunk_length_in_kb";
 const sstring compression_parameters::CHUNK_LENGTH_KB_ERR = "chunk_length_kb";
 const sstring compression_parameters::CRC_CHECK_CHANCE = "crc_check_chance";
+const sstring compression_parameters::AUTO = "auto";
 
 compression_parameters::compression_parameters()
     : compression_parameters(compressor::lz4)
@@ -124,7 +144,9 @@ compression_parameters::compression_parameters(compressor_ptr c)
 {}
 
 compression_parameters::compression_parameters(const std::map<sstring, sstring>& options) {
-    _compressor = compressor::create(options);
+    auto name = options.find(SSTABLE_COMPRESSION);
+    _auto = name != options.end() && name->second == AUTO;
+    _compressor = _auto ? compressor::lz4 : compressor::create(options);
 
     validate_options(options);
 
@@ -172,7 +194,7 @@ std::map<sstring, sstring> compression_parameters::get_options() const {
     }
     auto opts = _compressor->options();
 
-    opts.emplace(compression_parameters::SSTABLE_COMPRESSION, _compressor->name());
+    opts.emplace(compression_parameters::SSTABLE_COMPRESSION, _auto ? AUTO : _compressor->name());
     if (_chunk_length) {
         opts.emplace(sstring(CHUNK_LENGTH_KB), std::to_string(_chunk_length.value() / 1024));
     }
@@ -185,13 +207,57 @@ std::map<sstring, sstring> compression_parameters::get_options() const {
 bool compression_parameters::operator==(const compression_parameters& other) const {
     return _compressor == other._compressor
            && _chunk_length == other._chunk_length
-           && _crc_check_chance == other._crc_check_chance;
+           && _crc_check_chance == other._crc_check_chance
+           && _auto == other._auto;
 }
 
 bool compression_parameters::operator!=(const compression_parameters& other) const {
     return !(*this == other);
 }
 
+compression_parameters compression_parameters::with_chunk_length(int32_t chunk_length) const {
+    auto p = *this;
+    p._chunk_length = chunk_length;
+    return p;
+}
+
+std::vector<compressor_ptr> compression_parameters::auto_candidates() {
+    std::vector<compressor_ptr> candidates{compressor::lz4};
+    auto no_options = [] (const sstring&) -> compressor::opt_string { return std::nullopt; };
+    candidates.push_back(compressor::create("ZstdCompressor", no_options));
+    candidates.push_back(compressor::deflate);
+    return candidates;
+}
+
+compressor_ptr compression_parameters::choose_compressor(const std::vector<temporary_buffer<char>>& samples) {
+    auto candidates = auto_candidates();
+    std::vector<size_t> sizes;
+    std::vector<char> out;
+    for (auto& c : candidates) {
+        size_t size = 0;
+        for (auto& buf : samples) {
+            out.resize(c->compress_max_size(buf.size()));
+            size += c->compress(buf.get(), buf.size(), out.data(), out.size());
+        }
+        sizes.push_back(size);
+    }
+    auto best = *std::min_element(sizes.begin(), sizes.end());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (sizes[i] <= best + best / 10) {
+            return candidates[i];
+        }
+    }
+    return candidates.front();
+}
+
+int32_t compression_parameters::auto_chunk_length(uint64_t read_size) {
+    int32_t chunk_length = AUTO_MIN_CHUNK_LENGTH;
+    while (chunk_length < AUTO_MAX_CHUNK_LENGTH && uint64_t(chunk_length) < read_size) {
+        chunk_length *= 2;
+    }
+    return chunk_length;
+}
+
 void compression_parameters::validate_options(const std::map<sstring, sstring>& options) {
     // currently, there are no options specific to a particular compressor
     static std::set<sstring> keywords({
@@ -262,26 +328,32 @@ size_t lz4_processor::compress_max_size(size_t input_len) const {
     return LZ4_COMPRESSBOUND(input_len) + 4;
 }
 
+libdeflate_compressor* deflate_processor::get_compressor() const {
+    if (!_compressor) {
+        _compressor.reset(libdeflate_alloc_compressor(compression_level));
+        if (!_compressor) {
+            throw std::bad_alloc();
+        }
+    }
+    return _compressor.get();
+}
+
+libdeflate_decompressor* deflate_processor::get_decompressor() const {
+    if (!_decompressor) {
+        _decompressor.reset(libdeflate_alloc_decompressor());
+        if (!_decompressor) {
+            throw std::bad_alloc();
+        }
+    }
+    return _decompressor.get();
+}
+
 size_t deflate_processor::uncompress(const char* input,
                 size_t input_len, char* output, size_t output_len) const {
-    z_stream zs;
-    zs.zalloc = Z_NULL;
-    zs.zfree = Z_NULL;
-    zs.opaque = Z_NULL;
-    zs.avail_in = 0;
-    zs.next_in = Z_NULL;
-    if (inflateInit(&zs) != Z_OK) {
-        throw std::runtime_error("deflate uncompression init failure");
-    }
-    // yuck, zlib is not const-correct, and also uses unsigned char while we use char :-(
-    zs.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(input));
-    zs.avail_in = input_len;
-    zs.next_out = reinterpret_cast<unsigned char*>(output);
-    zs.avail_out = output_len;
-    auto res = inflate(&zs, Z_FINISH);
-    inflateEnd(&zs);
-    if (res == Z_STREAM_END) {
-        return output_len - zs.avail_out;
+    size_t actual_len;
+    auto res = libdeflate_zlib_decompress(get_decompressor(), input, input_len, output, output_len, &actual_len);
+    if (res == LIBDEFLATE_SUCCESS) {
+        return actual_len;
     } else {
         throw std::runtime_error("deflate uncompression failure");
     }
@@ -289,41 +361,16 @@ size_t deflate_processor::uncompress(const char* input,
 
 size_t deflate_processor::compress(const char* input,
                 size_t input_len, char* output, size_t output_len) const {
-    z_stream zs;
-    zs.zalloc = Z_NULL;
-    zs.zfree = Z_NULL;
-    zs.opaque = Z_NULL;
-    zs.avail_in = 0;
-    zs.next_in = Z_NULL;
-    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) {
-        throw std::runtime_error("deflate compression init failure");
-    }
-    zs.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(input));
-    zs.avail_in = input_len;
-    zs.next_out = reinterpret_cast<unsigned char*>(output);
-    zs.avail_out = output_len;
-    auto res = ::deflate(&zs, Z_FINISH);
-    deflateEnd(&zs);
-    if (res == Z_STREAM_END) {
-        return output_len - zs.avail_out;
+    auto res = libdeflate_zlib_compress(get_compressor(), input, input_len, output, output_len);
+    if (res != 0) {
+        return res;
     } else {
         throw std::runtime_error("deflate compression failure");
     }
 }
 
 size_t deflate_processor::compress_max_size(size_t input_len) const {
-    z_stream zs;
-    zs.zalloc = Z_NULL;
-    zs.zfree = Z_NULL;
-    zs.opaque = Z_NULL;
-    zs.avail_in = 0;
-    zs.next_in = Z_NULL;
-    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) {
-        throw std::runtime_error("deflate compression init failure");
-    }
-    auto res = deflateBound(&zs, input_len);
-    deflateEnd(&zs);
-    return res;
+    return libdeflate_zlib_compress_bound(get_compressor(), input_len);
 }
 
 size_t snappy_processor::uncompress(const char* input, size_t input_len,
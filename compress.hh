@@ -23,10 +23,12 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 #include <seastar/core/future.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/sstring.hh>
+#include <seastar/core/temporary_buffer.hh>
 
 #include "exceptions/exceptions.hh"
 
@@ -64,6 +66,30 @@ class compressor {
      */
     virtual std::map<sstring, sstring> options() const;
 
+    /**
+     * Returns how much uncompressed data the compressor wants to see before
+     * the first chunk is compressed, in order to train a dictionary on it.
+     * Zero means the compressor does not use dictionaries.
+     */
+    virtual size_t dictionary_sample_size() const {
+        return 0;
+    }
+    /**
+     * Returns how much memory train() allocates, on top of the samples.
+     */
+    virtual size_t dictionary_training_memory() const {
+        return 0;
+    }
+    /**
+     * Trains a dictionary on the given chunks. Returns the options to be
+     * appended to the compression metadata of the sstable being written,
+     * so that the compressor created from that metadata uses the dictionary.
+     * Returns no options if a dictionary could not be trained.
+     */
+    virtual std::map<sstring, sstring> train(const std::vector<temporary_buffer<char>>& samples) const {
+        return {};
+    }
+
     /**
      * Compressor class name.
      */
@@ -100,19 +126,45 @@ class compression_parameters {
     static const sstring CHUNK_LENGTH_KB;
     static const sstring CHUNK_LENGTH_KB_ERR;
     static const sstring CRC_CHECK_CHANCE;
+    // Value of SSTABLE_COMPRESSION selecting the adaptive mode, in which the
+    // compressor of each sstable is chosen by measuring how well the
+    // candidates compress its first chunks, and, unless CHUNK_LENGTH_KB is
+    // given, compaction chooses the chunk length from the size of the reads
+    // of the table. See auto_candidates() and auto_chunk_length().
+    static const sstring AUTO;
+
+    static constexpr int32_t AUTO_MIN_CHUNK_LENGTH = 4 * 1024;
+    static constexpr int32_t AUTO_MAX_CHUNK_LENGTH = 64 * 1024;
 private:
     compressor_ptr _compressor;
     std::optional<int> _chunk_length;
     std::optional<double> _crc_check_chance;
+    bool _auto = false;
 public:
     compression_parameters();
     compression_parameters(compressor_ptr);
     compression_parameters(const std::map<sstring, sstring>& options);
     ~compression_parameters();
 
+    // In the adaptive mode, the compressor used until one is chosen.
     compressor_ptr get_compressor() const { return _compressor; }
     int32_t chunk_length() const { return _chunk_length.value_or(int(DEFAULT_CHUNK_LENGTH)); }
     double crc_check_chance() const { return _crc_check_chance.value_or(double(DEFAULT_CRC_CHECK_CHANCE)); }
+    bool is_auto() const { return _auto; }
+    // True if the chunk length is left to compaction to choose.
+    bool is_auto_chunk_length() const { return _auto && !_chunk_length; }
+
+    // A copy of these parameters with the given chunk length.
+    compression_parameters with_chunk_length(int32_t chunk_length) const;
+
+    // The compressors the adaptive mode chooses from, cheapest to decompress first.
+    static std::vector<compressor_ptr> auto_candidates();
+    // Chooses the compressor compressing the samples to the smallest size,
+    // give or take 10%, preferring the cheaper candidates.
+    static compressor_ptr choose_compressor(const std::vector<temporary_buffer<char>>& samples);
+    // Chooses a chunk length for reads of typically read_size bytes: the
+    // smallest power of two holding them, within the AUTO_*_CHUNK_LENGTH bounds.
+    static int32_t auto_chunk_length(uint64_t read_size);
 
     void validate();
     std::map<sstring, sstring> get_options() const;
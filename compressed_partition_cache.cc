@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+
+#include "compressed_partition_cache.hh"
+#include "compress.hh"
+#include "frozen_mutation.hh"
+
+compressed_partition_cache::~compressed_partition_cache() {
+    _lru.clear();
+    for (auto& [id, t] : _tables) {
+        t.entries.clear_and_dispose([this] (entry* e) { dispose(e); });
+    }
+}
+
+compressed_partition_cache::table_entries* compressed_partition_cache::find_table(const schema& s) noexcept {
+    auto i = _tables.find(s.id());
+    return i == _tables.end() ? nullptr : &i->second;
+}
+
+const compressed_partition_cache::table_entries* compressed_partition_cache::find_table(const schema& s) const noexcept {
+    auto i = _tables.find(s.id());
+    return i == _tables.end() ? nullptr : &i->second;
+}
+
+void compressed_partition_cache::dispose(entry* e) noexcept {
+    // The data must be freed by the allocator of the region, the rest of
+    // the entry by the standard one.
+    with_allocator(_region.allocator(), [e] {
+        e->data = managed_bytes();
+    });
+    delete e;
+}
+
+void compressed_partition_cache::erase(table_entries& t, entries_type::iterator i) noexcept {
+    _memory -= i->memory_usage();
+    _lru.erase(_lru.iterator_to(*i));
+    t.entries.erase_and_dispose(i, [this] (entry* e) { dispose(e); });
+}
+
+void compressed_partition_cache::maybe_drop_table(table_entries& t) noexcept {
+    if (t.entries.empty() && !t.updates_in_progress) {
+        _tables.erase(t.id);
+    }
+}
+
+bool compressed_partition_cache::evict_some() noexcept {
+    if (_lru.empty()) {
+        return false;
+    }
+    auto& e = _lru.back();
+    auto& t = _tables.at(e.schema->id());
+    erase(t, t.entries.iterator_to(e));
+    ++_stats.evictions;
+    maybe_drop_table(t);
+    return true;
+}
+
+void compressed_partition_cache::evict_to(size_t memory) noexcept {
+    while (_memory > memory && evict_some()) { }
+}
+
+void compressed_partition_cache::clear() noexcept {
+    evict_to(0);
+}
+
+void compressed_partition_cache::set_max_memory(size_t bytes) noexcept {
+    _max_memory = bytes;
+    evict_to(_max_memory);
+}
+
+void compressed_partition_cache::insert(schema_ptr s, const dht::decorated_key& dk, const mutation_partition& mp) {
+    if (!accepts(*s)) {
+        return;
+    }
+    auto t = find_table(*s);
+
+    auto fm = freeze(mutation(s, dk, mp));
+    auto rep = fm.representation();
+    auto in = rep.linearize();
+    auto& lz4 = *compressor::lz4;
+    bytes out(bytes::initialized_later(), lz4.compress_max_size(in.size()));
+    auto len = lz4.compress(reinterpret_cast<const char*>(in.data()), in.size(), reinterpret_cast<char*>(out.begin()), out.size());
+    // Don't let a single partition take over the tier.
+    if (len > _max_memory / 16) {
+        return;
+    }
+
+    if (!t) {
+        t = &_tables.try_emplace(s->id(), s).first->second;
+    }
+    auto e = std::make_unique<entry>(dk, std::move(s), in.size());
+    // Nothing below may throw once the entry holds memory of the region.
+    e->data = with_allocator(_region.allocator(), [&] {
+        return managed_bytes(bytes_view(out.begin(), len));
+    });
+    auto i = t->entries.find(dk, t->entries.key_comp());
+    if (i != t->entries.end()) {
+        erase(*t, i);
+    }
+    _memory += e->memory_usage();
+    _lru.push_front(*e);
+    t->entries.insert(*e.release());
+    ++_stats.insertions;
+    evict_to(_max_memory);
+}
+
+std::optional<mutation> compressed_partition_cache::take(const schema_ptr& s, const dht::decorated_key& dk) {
+    auto t = find_table(*s);
+    if (!t) {
+        return std::nullopt;
+    }
+    auto i = t->entries.find(dk, t->entries.key_comp());
+    if (i == t->entries.end()) {
+        return std::nullopt;
+    }
+    // Copied out in one go, the region can't be compacted in between.
+    bytes in(bytes::initialized_later(), i->data.size());
+    auto in_end = in.begin();
+    for (bytes_view frag : i->data.fragments()) {
+        in_end = std::copy(frag.begin(), frag.end(), in_end);
+    }
+    auto& lz4 = *compressor::lz4;
+    bytes out(bytes::initialized_later(), i->uncompressed_size);
+    lz4.uncompress(reinterpret_cast<const char*>(in.begin()), in.size(), reinterpret_cast<char*>(out.begin()), out.size());
+    bytes_ostream rep;
+    rep.write(out);
+    auto m = frozen_mutation(std::move(rep)).unfreeze(i->schema);
+    m.upgrade(s);
+    erase(*t, i);
+    ++_stats.hits;
+    maybe_drop_table(*t);
+    return m;
+}
+
+bool compressed_partition_cache::accepts(const schema& s) const noexcept {
+    auto t = find_table(s);
+    return enabled() && !(t && t->updates_in_progress);
+}
+
+bool compressed_partition_cache::contains(const schema& s, const dht::decorated_key& dk) const noexcept {
+    auto t = find_table(s);
+    return t && t->entries.find(dk, t->entries.key_comp()) != t->entries.end();
+}
+
+bool compressed_partition_cache::has_entries(const schema& s) const noexcept {
+    auto t = find_table(s);
+    return t && !t->entries.empty();
+}
+
+void compressed_partition_cache::invalidate(const schema& s, const dht::decorated_key& dk) noexcept {
+    auto t = find_table(s);
+    if (!t) {
+        return;
+    }
+    auto i = t->entries.find(dk, t->entries.key_comp());
+    if (i != t->entries.end()) {
+        erase(*t, i);
+        ++_stats.invalidations;
+        maybe_drop_table(*t);
+    }
+}
+
+void compressed_partition_cache::invalidate(const schema& s, const dht::partition_range& range) noexcept {
+    auto t = find_table(s);
+    if (!t) {
+        return;
+    }
+    dht::ring_position_comparator cmp(s);
+    auto start = dht::ring_position_view::for_range_start(range);
+    auto end = dht::ring_position_view::for_range_end(range);
+    auto i = t->entries.begin();
+    while (i != t->entries.end() && cmp(i->key, end) < 0) {
+        if (cmp(i->key, start) >= 0) {
+            erase(*t, i++);
+            ++_stats.invalidations;
+        } else {
+            ++i;
+        }
+    }
+    maybe_drop_table(*t);
+}
+
+void compressed_partition_cache::invalidate(const schema& s) noexcept {
+    auto t = find_table(s);
+    if (!t) {
+        return;
+    }
+    while (!t->entries.empty()) {
+        erase(*t, t->entries.begin());
+        ++_stats.invalidations;
+    }
+    maybe_drop_table(*t);
+}
+
+void compressed_partition_cache::pause_insertions(const schema& s) {
+    auto t = find_table(s);
+    if (!t) {
+        t = &_tables.try_emplace(s.id(), s.shared_from_this()).first->second;
+    }
+    ++t->updates_in_progress;
+}
+
+void compressed_partition_cache::resume_insertions(const schema& s) noexcept {
+    auto t = find_table(s);
+    if (t) {
+        --t->updates_in_progress;
+        maybe_drop_table(*t);
+    }
+}
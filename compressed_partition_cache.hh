@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <optional>
+#include <unordered_map>
+
+#include <boost/intrusive/list.hpp>
+#include <boost/intrusive/set.hpp>
+
+#include "dht/i_partitioner.hh"
+#include "mutation.hh"
+#include "schema.hh"
+#include "utils/UUID.hh"
+#include "utils/logalloc.hh"
+#include "utils/managed_bytes.hh"
+
+namespace bi = boost::intrusive;
+
+// Second tier of the row cache, owned by cache_tracker.
+//
+// Holds complete partitions as LZ4-compressed frozen mutations, so that
+// partitions evicted from the row cache can be brought back without reading
+// sstables. The compressed data is allocated in the cache's LSA region; the
+// entries indexing it are small and live in standard memory. Partitions are
+// moved here from the cold end of the row cache's LRU when the cache is
+// evicting, and moved back into the row cache by single-partition reads which
+// miss it. Entries are evicted in LRU order once the tier exceeds its memory
+// limit, and by the cache's reclaimer once the cache itself is empty.
+//
+// The tier must stay coherent with the row cache: every key which is updated
+// or invalidated in the cache is invalidated here too, and no partitions are
+// inserted for a table while its cache is being updated.
+class compressed_partition_cache {
+public:
+    struct stats {
+        uint64_t insertions = 0;
+        uint64_t hits = 0;
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0;
+    };
+private:
+    struct entry {
+        dht::decorated_key key;
+        // The schema the partition was frozen with.
+        schema_ptr schema;
+        // Allocated in the region, see dispose().
+        managed_bytes data;
+        size_t uncompressed_size;
+        bi::set_member_hook<> set_link;
+        bi::list_member_hook<> lru_link;
+
+        entry(dht::decorated_key key, schema_ptr s, size_t uncompressed_size)
+            : key(std::move(key)), schema(std::move(s)), uncompressed_size(uncompressed_size) { }
+        size_t memory_usage() const noexcept {
+            return sizeof(entry) + key.external_memory_usage() + data.external_memory_usage();
+        }
+    };
+    struct key_less {
+        dht::decorated_key::less_comparator cmp;
+        bool operator()(const entry& a, const entry& b) const { return cmp(a.key, b.key); }
+        bool operator()(const dht::decorated_key& a, const entry& b) const { return cmp(a, b.key); }
+        bool operator()(const entry& a, const dht::decorated_key& b) const { return cmp(a.key, b); }
+    };
+    using entries_type = bi::set<entry,
+        bi::member_hook<entry, bi::set_member_hook<>, &entry::set_link>,
+        bi::compare<key_less>,
+        bi::constant_time_size<false>>;
+    struct table_entries {
+        utils::UUID id;
+        entries_type entries;
+        unsigned updates_in_progress = 0;
+
+        explicit table_entries(schema_ptr s) : id(s->id()), entries(key_less{dht::decorated_key::less_comparator(std::move(s))}) { }
+    };
+    using lru_type = bi::list<entry,
+        bi::member_hook<entry, bi::list_member_hook<>, &entry::lru_link>,
+        bi::constant_time_size<false>>;
+
+    logalloc::region& _region;
+    std::unordered_map<utils::UUID, table_entries> _tables;
+    lru_type _lru;
+    size_t _max_memory = 0;
+    size_t _memory = 0;
+    stats _stats;
+private:
+    table_entries* find_table(const schema&) noexcept;
+    const table_entries* find_table(const schema&) const noexcept;
+    void dispose(entry*) noexcept;
+    void erase(table_entries&, entries_type::iterator) noexcept;
+    void maybe_drop_table(table_entries&) noexcept;
+    void evict_to(size_t memory) noexcept;
+public:
+    // The data is allocated in region, which must be the cache's.
+    explicit compressed_partition_cache(logalloc::region& region) : _region(region) { }
+    compressed_partition_cache(const compressed_partition_cache&) = delete;
+    ~compressed_partition_cache();
+
+    // Zero disables the tier.
+    void set_max_memory(size_t bytes) noexcept;
+    bool enabled() const noexcept {
+        return _max_memory != 0;
+    }
+    // Whether insert() would store a partition of the table.
+    bool accepts(const schema& s) const noexcept;
+
+    // Stores a copy of the complete partition mp, replacing the stored
+    // one if any. Does nothing if insertions are paused for the table.
+    void insert(schema_ptr s, const dht::decorated_key& dk, const mutation_partition& mp);
+    // Removes the partition from the tier and returns it, upgraded to s.
+    std::optional<mutation> take(const schema_ptr& s, const dht::decorated_key& dk);
+    bool contains(const schema& s, const dht::decorated_key& dk) const noexcept;
+    bool has_entries(const schema& s) const noexcept;
+
+    void invalidate(const schema& s, const dht::decorated_key& dk) noexcept;
+    void invalidate(const schema& s, const dht::partition_range& range) noexcept;
+    // Invalidates all partitions of the table.
+    void invalidate(const schema& s) noexcept;
+    // Evicts the least recently inserted partition. Returns false if the
+    // tier is empty.
+    bool evict_some() noexcept;
+    void clear() noexcept;
+
+    // Insertions for the table are refused between these calls, which
+    // bracket updates of its cache.
+    void pause_insertions(const schema& s);
+    void resume_insertions(const schema& s) noexcept;
+
+    size_t memory_used() const noexcept {
+        return _memory;
+    }
+    const stats& get_stats() const noexcept {
+        return _stats;
+    }
+};
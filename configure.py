@@ -272,9 +272,11 @@ scylla_tests = set([
     'test/boost/anchorless_list_test',
     'test/boost/auth_passwords_test',
     'test/boost/auth_resource_test',
+    'test/boost/auth_service_level_test',
     'test/boost/auth_test',
     'test/boost/batchlog_manager_test',
     'test/boost/big_decimal_test',
+    'test/boost/bloom_filter_test',
     'test/boost/broken_sstable_test',
     'test/boost/bytes_ostream_test',
     'test/boost/cache_flat_mutation_reader_test',
@@ -313,14 +315,17 @@ scylla_tests = set([
     'test/boost/flat_mutation_reader_test',
     'test/boost/flush_queue_test',
     'test/boost/fragmented_temporary_buffer_test',
+    'test/boost/frequency_sketch_test',
     'test/boost/frozen_mutation_test',
     'test/boost/gossip_test',
     'test/boost/gossiping_property_file_snitch_test',
     'test/boost/hash_test',
     'test/boost/idl_test',
     'test/boost/input_stream_test',
+    'test/boost/intrusive_btree_test',
     'test/boost/json_cql_query_test',
     'test/boost/keys_test',
+    'test/boost/latency_sampler_test',
     'test/boost/like_matcher_test',
     'test/boost/limiting_data_source_test',
     'test/boost/linearizing_input_stream_test',
@@ -366,6 +371,11 @@ scylla_tests = set([
     'test/boost/sstable_conforms_to_mutation_source_test',
     'test/boost/sstable_resharding_test',
     'test/boost/sstable_test',
+    'test/boost/sstable_trie_index_test',
+    'test/boost/sstable_clustering_ranges_test',
+    'test/boost/sstable_summary_entries_test',
+    'test/boost/sstable_partitioned_filter_test',
+    'test/boost/index_page_cache_test',
     'test/boost/storage_proxy_test',
     'test/boost/top_k_test',
     'test/boost/transport_test',
@@ -393,11 +403,15 @@ scylla_tests = set([
     'test/manual/streaming_histogram_test',
     'test/manual/sstable_scan_footprint_test',
     'test/perf/memory_footprint_test',
+    'test/perf/perf_alternator',
     'test/perf/perf_cache_eviction',
+    'test/perf/perf_commitlog',
     'test/perf/perf_cql_parser',
     'test/perf/perf_fast_forward',
     'test/perf/perf_hash',
+    'test/perf/perf_lsa',
     'test/perf/perf_mutation',
+    'test/perf/perf_repair',
     'test/perf/perf_row_cache_update',
     'test/perf/perf_simple_query',
     'test/perf/perf_sstable',
@@ -409,8 +423,10 @@ scylla_tests = set([
 
 perf_tests = set([
     'test/perf/perf_mutation_readers',
+    'test/perf/perf_cdc',
     'test/perf/perf_checksum',
     'test/perf/perf_mutation_fragment',
+    'test/perf/perf_repair_hash',
     'test/perf/perf_idl',
     'test/perf/perf_vint',
 ])
@@ -506,6 +522,7 @@ scylla_core = (['database.cc',
                 'mutation_fragment.cc',
                 'partition_version.cc',
                 'row_cache.cc',
+                'compressed_partition_cache.cc',
                 'canonical_mutation.cc',
                 'frozen_mutation.cc',
                 'memtable.cc',
@@ -526,6 +543,7 @@ scylla_core = (['database.cc',
                 'mutation_query.cc',
                 'json.cc',
                 'keys.cc',
+                'clustering_position_encoder.cc',
                 'counters.cc',
                 'compress.cc',
                 'zstd.cc',
@@ -534,12 +552,19 @@ scylla_core = (['database.cc',
                 'sstables/sstables_manager.cc',
                 'sstables/mc/writer.cc',
                 'sstables/sstable_version.cc',
+                'sstables/trie_index.cc',
+                'sstables/clustering_ranges.cc',
+                'sstables/summary_entries.cc',
+                'sstables/filter_partition_cache.cc',
+                'sstables/partitioned_filter.cc',
+                'sstables/index_page_cache.cc',
                 'sstables/compress.cc',
                 'sstables/partition.cc',
                 'sstables/compaction.cc',
                 'sstables/compaction_strategy.cc',
                 'sstables/size_tiered_compaction_strategy.cc',
                 'sstables/leveled_compaction_strategy.cc',
+                'sstables/incremental_compaction_strategy.cc',
                 'sstables/compaction_manager.cc',
                 'sstables/integrity_checked_file_impl.cc',
                 'sstables/prepended_input_stream.cc',
@@ -550,6 +575,7 @@ scylla_core = (['database.cc',
                 'transport/messages/result_message.cc',
                 'cdc/log.cc',
                 'cdc/split.cc',
+                'cdc/shard_changes.cc',
                 'cdc/generation.cc',
                 'cdc/metadata.cc',
                 'cql3/type_json.cc',
@@ -565,6 +591,7 @@ scylla_core = (['database.cc',
                 'cql3/tuples.cc',
                 'cql3/maps.cc',
                 'cql3/functions/user_function.cc',
+                'cql3/functions/user_aggregate.cc',
                 'cql3/functions/functions.cc',
                 'cql3/functions/aggregate_fcts.cc',
                 'cql3/functions/castas_fcts.cc',
@@ -576,12 +603,14 @@ scylla_core = (['database.cc',
                 'cql3/statements/create_view_statement.cc',
                 'cql3/statements/create_type_statement.cc',
                 'cql3/statements/create_function_statement.cc',
+                'cql3/statements/create_aggregate_statement.cc',
                 'cql3/statements/drop_index_statement.cc',
                 'cql3/statements/drop_keyspace_statement.cc',
                 'cql3/statements/drop_table_statement.cc',
                 'cql3/statements/drop_view_statement.cc',
                 'cql3/statements/drop_type_statement.cc',
                 'cql3/statements/drop_function_statement.cc',
+                'cql3/statements/drop_aggregate_statement.cc',
                 'cql3/statements/schema_altering_statement.cc',
                 'cql3/statements/ks_prop_defs.cc',
                 'cql3/statements/function_statement.cc',
@@ -624,6 +653,7 @@ scylla_core = (['database.cc',
                 'service/priority_manager.cc',
                 'service/migration_manager.cc',
                 'service/storage_proxy.cc',
+                'service/forward_service.cc',
                 'service/paxos/proposal.cc',
                 'service/paxos/prepare_response.cc',
                 'service/paxos/paxos_state.cc',
@@ -642,6 +672,7 @@ scylla_core = (['database.cc',
                 'cql3/untyped_result_set.cc',
                 'cql3/selection/abstract_function_selector.cc',
                 'cql3/selection/simple_selector.cc',
+                'cql3/selection/term_selector.cc',
                 'cql3/selection/selectable.cc',
                 'cql3/selection/selector_factories.cc',
                 'cql3/selection/selection.cc',
@@ -653,6 +684,8 @@ scylla_core = (['database.cc',
                 'db/system_keyspace.cc',
                 'db/system_distributed_keyspace.cc',
                 'db/size_estimates_virtual_reader.cc',
+                'db/token_shards_virtual_reader.cc',
+                'db/top_partitions_virtual_reader.cc',
                 'db/schema_tables.cc',
                 'db/cql_type_parser.cc',
                 'db/legacy_schema_migrator.cc',
@@ -660,6 +693,12 @@ scylla_core = (['database.cc',
                 'db/commitlog/commitlog_replayer.cc',
                 'db/commitlog/commitlog_entry.cc',
                 'db/data_listeners.cc',
+                'db/cache_warmer.cc',
+                'db/snapshot_backup.cc',
+                'db/bulk_ingest.cc',
+                'db/counter_cache.cc',
+                'db/repair_history.cc',
+                'db/rate_limiter.cc',
                 'db/hints/manager.cc',
                 'db/hints/resource_manager.cc',
                 'db/config.cc',
@@ -676,6 +715,11 @@ scylla_core = (['database.cc',
                 'utils/UUID_gen.cc',
                 'utils/i_filter.cc',
                 'utils/bloom_filter.cc',
+                'utils/xor_filter.cc',
+                'utils/iblt.cc',
+                'utils/activity.cc',
+                'utils/latency_sampler.cc',
+                'utils/frequency_sketch.cc',
                 'utils/bloom_calculations.cc',
                 'utils/rate_limiter.cc',
                 'utils/file_lock.cc',
@@ -719,6 +763,7 @@ scylla_core = (['database.cc',
                 'locator/ec2_multi_region_snitch.cc',
                 'locator/gce_snitch.cc',
                 'message/messaging_service.cc',
+                'message/rpc_zstd_compressor.cc',
                 'service/client_state.cc',
                 'service/migration_task.cc',
                 'service/storage_service.cc',
@@ -758,6 +803,7 @@ scylla_core = (['database.cc',
                 'auth/permission.cc',
                 'auth/permissions_cache.cc',
                 'auth/service.cc',
+                'auth/service_level.cc',
                 'auth/standard_role_manager.cc',
                 'auth/transitional.cc',
                 'auth/authentication_options.cc',
@@ -765,6 +811,7 @@ scylla_core = (['database.cc',
                 'auth/sasl_challenge.cc',
                 'tracing/tracing.cc',
                 'tracing/trace_keyspace_helper.cc',
+                'tracing/trace_file_helper.cc',
                 'tracing/trace_state.cc',
                 'tracing/tracing_backend_registry.cc',
                 'tracing/traced_file.cc',
@@ -826,6 +873,8 @@ api = ['api/api.cc',
        'api/api-doc/config.json',
         'api/error_injection.cc',
         'api/api-doc/error_injection.json',
+        'api/cdc.cc',
+        'api/api-doc/cdc.json',
        ]
 
 alternator = [
@@ -839,6 +888,7 @@ alternator = [
        'alternator/conditions.cc',
        'alternator/rjson.cc',
        'alternator/auth.cc',
+       'alternator/expiration.cc',
 ]
 
 redis = [
@@ -883,6 +933,7 @@ idls = ['idl/gossip_digest.idl.hh',
         'idl/view.idl.hh',
         'idl/messaging_service.idl.hh',
         'idl/paxos.idl.hh',
+        'idl/forward_request.idl.hh',
         ]
 
 headers = find_headers('.', excluded_dirs=['idl', 'build', 'seastar', '.git'])
@@ -924,6 +975,7 @@ pure_boost_tests = set([
     'test/boost/dynamic_bitset_test',
     'test/boost/enum_option_test',
     'test/boost/enum_set_test',
+    'test/boost/frequency_sketch_test',
     'test/boost/idl_test',
     'test/boost/keys_test',
     'test/boost/like_matcher_test',
@@ -947,10 +999,14 @@ tests_not_using_seastar_test_framework = set([
     'test/manual/gossip',
     'test/manual/message',
     'test/perf/memory_footprint_test',
+    'test/perf/perf_alternator',
     'test/perf/perf_cache_eviction',
+    'test/perf/perf_commitlog',
     'test/perf/perf_cql_parser',
     'test/perf/perf_hash',
+    'test/perf/perf_lsa',
     'test/perf/perf_mutation',
+    'test/perf/perf_repair',
     'test/perf/perf_row_cache_update',
     'test/perf/perf_sstable',
     'test/unit/lsa_async_eviction_test',
@@ -1001,6 +1057,7 @@ deps['test/boost/log_heap_test'] = ['test/boost/log_heap_test.cc']
 deps['test/boost/anchorless_list_test'] = ['test/boost/anchorless_list_test.cc']
 deps['test/perf/perf_fast_forward'] += ['release.cc']
 deps['test/perf/perf_simple_query'] += ['release.cc']
+deps['test/perf/perf_alternator'] += alternator
 deps['test/boost/meta_test'] = ['test/boost/meta_test.cc']
 deps['test/manual/imr_test'] = ['test/manual/imr_test.cc', 'utils/logalloc.cc', 'utils/dynamic_bitset.cc']
 deps['test/boost/reusable_buffer_test'] = [
@@ -44,6 +44,7 @@ options {
 #include "cql3/statements/create_view_statement.hh"
 #include "cql3/statements/create_type_statement.hh"
 #include "cql3/statements/create_function_statement.hh"
+#include "cql3/statements/create_aggregate_statement.hh"
 #include "cql3/statements/drop_type_statement.hh"
 #include "cql3/statements/alter_type_statement.hh"
 #include "cql3/statements/property_definitions.hh"
@@ -51,6 +52,7 @@ options {
 #include "cql3/statements/drop_table_statement.hh"
 #include "cql3/statements/drop_view_statement.hh"
 #include "cql3/statements/drop_function_statement.hh"
+#include "cql3/statements/drop_aggregate_statement.hh"
 #include "cql3/statements/truncate_statement.hh"
 #include "cql3/statements/raw/update_statement.hh"
 #include "cql3/statements/raw/insert_statement.hh"
@@ -356,10 +358,8 @@ cqlStatement returns [std::unique_ptr<raw::parsed_statement> stmt]
     | st27=dropTypeStatement           { $stmt = std::move(st27); }
     | st28=createFunctionStatement     { $stmt = std::move(st28); }
     | st29=dropFunctionStatement       { $stmt = std::move(st29); }
-#if 0
-    | st30=createAggregateStatement    { $stmt = st30; }
-    | st31=dropAggregateStatement      { $stmt = st31; }
-#endif
+    | st30=createAggregateStatement    { $stmt = std::move(st30); }
+    | st31=dropAggregateStatement      { $stmt = std::move(st31); }
     | st32=createViewStatement         { $stmt = std::move(st32); }
     | st33=alterViewStatement          { $stmt = std::move(st33); }
     | st34=dropViewStatement           { $stmt = std::move(st34); }
@@ -433,11 +433,19 @@ unaliasedSelector returns [shared_ptr<selectable::raw> s]
        | K_TTL       '(' c=cident ')'              { tmp = make_shared<selectable::writetime_or_ttl::raw>(c, false); }
        | f=functionName args=selectionFunctionArgs { tmp = ::make_shared<selectable::with_function::raw>(std::move(f), std::move(args)); }
        | K_CAST      '(' arg=unaliasedSelector K_AS t=native_type ')'  { tmp = ::make_shared<selectable::with_cast::raw>(std::move(arg), std::move(t)); }
+       | l=selectionLiteral                        { tmp = ::make_shared<selectable::with_term::raw>(std::move(l)); }
        )
        ( '.' fi=cident { tmp = make_shared<selectable::with_field_selection::raw>(std::move(tmp), std::move(fi)); } )*
     { $s = tmp; }
     ;
 
+selectionLiteral returns [shared_ptr<cql3::constants::literal> constant]
+    : t=STRING_LITERAL { $constant = cql3::constants::literal::string(sstring{$t.text}); }
+    | t=INTEGER        { $constant = cql3::constants::literal::integer(sstring{$t.text}); }
+    | t=FLOAT          { $constant = cql3::constants::literal::floating_point(sstring{$t.text}); }
+    | t=BOOLEAN        { $constant = cql3::constants::literal::bool_(sstring{$t.text}); }
+    ;
+
 selectionFunctionArgs returns [std::vector<shared_ptr<selectable::raw>> a]
     : '(' ')'
     | '(' s1=unaliasedSelector { a.push_back(std::move(s1)); }
@@ -643,56 +651,62 @@ batchStatementObjective returns [std::unique_ptr<cql3::statements::raw::modifica
     | d=deleteStatement  { $statement = std::move(d); }
     ;
 
-#if 0
-createAggregateStatement returns [CreateAggregateStatement expr]
+createAggregateStatement returns [std::unique_ptr<cql3::statements::create_aggregate_statement> expr]
     @init {
-        boolean orReplace = false;
-        boolean ifNotExists = false;
+        bool or_replace = false;
+        bool if_not_exists = false;
 
-        List<CQL3Type.Raw> argsTypes = new ArrayList<>();
+        std::vector<shared_ptr<cql3_type::raw>> arg_types;
+        std::optional<sstring> rfunc;
+        std::optional<sstring> ffunc;
+        ::shared_ptr<cql3::term::raw> ival;
     }
-    : K_CREATE (K_OR K_REPLACE { orReplace = true; })?
-      K_AGGREGATE
-      (K_IF K_NOT K_EXISTS { ifNotExists = true; })?
+    : K_CREATE
+        // "OR REPLACE" and "IF NOT EXISTS" cannot be used together
+        ((K_OR K_REPLACE { or_replace = true; } K_AGGREGATE)
+         | (K_AGGREGATE K_IF K_NOT K_EXISTS { if_not_exists = true; })
+         | K_AGGREGATE)
       fn=functionName
       '('
         (
-          v=comparatorType { argsTypes.add(v); }
-          ( ',' v=comparatorType { argsTypes.add(v); } )*
+          v=comparatorType { arg_types.push_back(v); }
+          ( ',' v=comparatorType { arg_types.push_back(v); } )*
         )?
       ')'
       K_SFUNC sfunc = allowedFunctionName
       K_STYPE stype = comparatorType
       (
-        K_FINALFUNC ffunc = allowedFunctionName
+        K_REDUCEFUNC r = allowedFunctionName { rfunc = r; }
+      )?
+      (
+        K_FINALFUNC f = allowedFunctionName { ffunc = f; }
       )?
       (
-        K_INITCOND ival = term
+        K_INITCOND i = term { ival = i; }
       )?
-      { $expr = new CreateAggregateStatement(fn, argsTypes, sfunc, stype, ffunc, ival, orReplace, ifNotExists); }
+      { $expr = std::make_unique<cql3::statements::create_aggregate_statement>(std::move(fn), std::move(arg_types), std::move(sfunc), std::move(stype), std::move(rfunc), std::move(ffunc), std::move(ival), or_replace, if_not_exists); }
     ;
 
-dropAggregateStatement returns [DropAggregateStatement expr]
+dropAggregateStatement returns [std::unique_ptr<cql3::statements::drop_aggregate_statement> expr]
     @init {
-        boolean ifExists = false;
-        List<CQL3Type.Raw> argsTypes = new ArrayList<>();
-        boolean argsPresent = false;
+        bool if_exists = false;
+        std::vector<shared_ptr<cql3_type::raw>> arg_types;
+        bool args_present = false;
     }
     : K_DROP K_AGGREGATE
-      (K_IF K_EXISTS { ifExists = true; } )?
+      (K_IF K_EXISTS { if_exists = true; } )?
       fn=functionName
       (
         '('
           (
-            v=comparatorType { argsTypes.add(v); }
-            ( ',' v=comparatorType { argsTypes.add(v); } )*
+            v=comparatorType { arg_types.push_back(v); }
+            ( ',' v=comparatorType { arg_types.push_back(v); } )*
           )?
         ')'
-        { argsPresent = true; }
+        { args_present = true; }
       )?
-      { $expr = new DropAggregateStatement(fn, argsTypes, argsPresent, ifExists); }
+      { $expr = std::make_unique<cql3::statements::drop_aggregate_statement>(std::move(fn), std::move(arg_types), args_present, if_exists); }
     ;
-#endif
 
 createFunctionStatement returns [std::unique_ptr<cql3::statements::create_function_statement> expr]
     @init {
@@ -828,12 +842,14 @@ createIndexStatement returns [std::unique_ptr<create_index_statement> expr]
         bool if_not_exists = false;
         auto name = ::make_shared<cql3::index_name>();
         std::vector<::shared_ptr<index_target::raw>> targets;
+        std::vector<::shared_ptr<cql3::column_identifier::raw>> included_columns;
     }
     : K_CREATE (K_CUSTOM { props->is_custom = true; })? K_INDEX (K_IF K_NOT K_EXISTS { if_not_exists = true; } )?
         (idxName[*name])? K_ON cf=columnFamilyName '(' (target1=indexIdent { targets.emplace_back(target1); } (',' target2=indexIdent { targets.emplace_back(target2); } )*)? ')'
+        (K_INCLUDE '(' c1=cident { included_columns.push_back(c1); } (',' cn=cident { included_columns.push_back(cn); } )* ')')?
         (K_USING cls=STRING_LITERAL { props->custom_class = sstring{$cls.text}; })?
         (K_WITH properties[*props])?
-      { $expr = std::make_unique<create_index_statement>(cf, name, targets, props, if_not_exists); }
+      { $expr = std::make_unique<create_index_statement>(cf, name, targets, props, if_not_exists, std::move(included_columns)); }
     ;
 
 indexIdent returns [::shared_ptr<index_target::raw> id]
@@ -1747,6 +1763,7 @@ basic_unreserved_keyword returns [sstring str]
         | K_AGGREGATE
         | K_SFUNC
         | K_STYPE
+        | K_REDUCEFUNC
         | K_FINALFUNC
         | K_INITCOND
         | K_RETURNS
@@ -1760,6 +1777,7 @@ basic_unreserved_keyword returns [sstring str]
         | K_PER
         | K_PARTITION
         | K_GROUP
+        | K_INCLUDE
         ) { $str = $k.text; }
     ;
 
@@ -1888,6 +1906,7 @@ K_FUNCTION:    F U N C T I O N;
 K_AGGREGATE:   A G G R E G A T E;
 K_SFUNC:       S F U N C;
 K_STYPE:       S T Y P E;
+K_REDUCEFUNC:  R E D U C E F U N C;
 K_FINALFUNC:   F I N A L F U N C;
 K_INITCOND:    I N I T C O N D;
 K_RETURNS:     R E T U R N S;
@@ -1913,6 +1932,8 @@ K_SCYLLA_COUNTER_SHARD_LIST: S C Y L L A '_' C O U N T E R '_' S H A R D '_' L I
 
 K_GROUP:       G R O U P;
 
+K_INCLUDE:     I N C L U D E;
+
 K_LIKE:        L I K E;
 
 // Case-insensitive alpha characters
@@ -40,11 +40,17 @@
  */
 
 
+#include <cstring>
+#include <sstream>
 #include "utils/big_decimal.hh"
 #include "aggregate_fcts.hh"
 #include "functions.hh"
 #include "native_aggregate_function.hh"
 #include "exceptions/exceptions.hh"
+#include "sstables/hyperloglog.hh"
+#include "utils/murmur_hash.hh"
+#include "utils/tdigest.hh"
+#include "utils/serialization.hh"
 
 using namespace cql3;
 using namespace functions;
@@ -52,7 +58,7 @@ using namespace aggregate_fcts;
 
 namespace {
 class impl_count_function : public aggregate_function::aggregate {
-    int64_t _count;
+    int64_t _count = 0;
 public:
     virtual void reset() override {
         _count = 0;
@@ -63,6 +69,14 @@ class impl_count_function : public aggregate_function::aggregate {
     virtual void add_input(cql_serialization_format sf, const std::vector<opt_bytes>& values) override {
         ++_count;
     }
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        return compute(sf);
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        if (state) {
+            _count += value_cast<int64_t>(long_type->deserialize(*state));
+        }
+    }
 };
 
 class count_rows_function final : public native_aggregate_function {
@@ -76,8 +90,30 @@ class count_rows_function final : public native_aggregate_function {
     }
 };
 
+static boost::multiprecision::cpp_int to_cpp_int(__int128 x) {
+    boost::multiprecision::cpp_int ret = int64_t(x >> 64);
+    ret <<= 64;
+    ret += uint64_t(x);
+    return ret;
+}
+
+// Reads a serialized varint (big-endian two's complement) if it fits in 128 bits.
+static std::optional<__int128> read_int128_varint(bytes_view v) {
+    if (v.empty() || v.size() > sizeof(__int128)) {
+        return std::nullopt;
+    }
+    unsigned __int128 u = v.front() < 0 ? ~static_cast<unsigned __int128>(0) : 0;
+    for (uint8_t b : v) {
+        u = (u << 8) | b;
+    }
+    return static_cast<__int128>(u);
+}
+
 // We need a wider accumulator for sum and average,
-// since summing the inputs can overflow the input type
+// since summing the inputs can overflow the input type.
+// The state of an accumulator, for partial aggregation, is the sum
+// serialized as a value of the input type, or as a varint for the wider
+// integral accumulator.
 template <typename T>
 struct accumulator_for;
 
@@ -92,6 +128,22 @@ struct int128_accumulator_for {
         }
         return ret;
     }
+
+    static void add(type& acc, bytes_view v) {
+        acc += value_cast<T>(data_type_for<T>()->deserialize(v));
+    }
+
+    static bytes state(type acc) {
+        return varint_type->decompose(utils::multiprecision_int(to_cpp_int(acc)));
+    }
+
+    static void merge(type& acc, bytes_view state) {
+        auto x = read_int128_varint(state);
+        if (!x) {
+            throw marshal_exception("sum state does not fit in 128 bits");
+        }
+        acc += *x;
+    }
 };
 
 template <typename T>
@@ -101,6 +153,18 @@ struct same_type_accumulator_for {
     static T narrow(type acc) {
         return acc;
     }
+
+    static void add(type& acc, bytes_view v) {
+        acc += value_cast<T>(data_type_for<T>()->deserialize(v));
+    }
+
+    static bytes state(type acc) {
+        return data_type_for<T>()->decompose(acc);
+    }
+
+    static void merge(type& acc, bytes_view state) {
+        add(acc, state);
+    }
 };
 
 template <typename T>
@@ -109,6 +173,129 @@ struct accumulator_for : public std::conditional_t<std::is_integral_v<T>,
                                                    same_type_accumulator_for<T>>
 { };
 
+// Multiplies x by 10^n, unless the result overflows.
+static bool rescale_int128(__int128& x, int64_t n) {
+    if (x == 0) {
+        return true;
+    }
+    __int128 r = x;
+    for (; n > 0; --n) {
+        if (__builtin_mul_overflow(r, 10, &r)) {
+            return false;
+        }
+    }
+    x = r;
+    return true;
+}
+
+// Sums varints in a 128-bit integer, read straight from their serialized
+// form, until the sum overflows it; from then on in a multiprecision_int.
+class varint_accumulator {
+    __int128 _small = 0;
+    std::optional<utils::multiprecision_int> _big;
+public:
+    void add(bytes_view v) {
+        if (!_big) {
+            if (auto x = read_int128_varint(v)) {
+                __int128 sum;
+                if (!__builtin_add_overflow(_small, *x, &sum)) {
+                    _small = sum;
+                    return;
+                }
+            }
+            _big = utils::multiprecision_int(to_cpp_int(_small));
+        }
+        *_big += value_cast<utils::multiprecision_int>(varint_type->deserialize(v));
+    }
+    utils::multiprecision_int get() const {
+        return _big ? *_big : utils::multiprecision_int(to_cpp_int(_small));
+    }
+};
+
+// Sums decimals as a 128-bit unscaled value with a scale shared by all
+// inputs, rescaling the sum or the input to the larger scale like
+// big_decimal::operator+= does, until that overflows; from then on in a
+// big_decimal.
+class decimal_accumulator {
+    int32_t _scale = 0;
+    __int128 _small = 0;
+    std::optional<big_decimal> _big;
+
+    bool add_small(bytes_view v) {
+        if (v.size() <= sizeof(int32_t)) {
+            return false;
+        }
+        auto scale = read_simple<int32_t>(v);
+        auto x = read_int128_varint(v);
+        if (!x) {
+            return false;
+        }
+        auto sum = _small;
+        if (!rescale_int128(sum, int64_t(scale) - _scale) || !rescale_int128(*x, int64_t(_scale) - scale)
+                || __builtin_add_overflow(sum, *x, &sum)) {
+            return false;
+        }
+        _small = sum;
+        _scale = std::max(_scale, scale);
+        return true;
+    }
+public:
+    void add(bytes_view v) {
+        if (!_big) {
+            if (add_small(v)) {
+                return;
+            }
+            _big = big_decimal(_scale, to_cpp_int(_small));
+        }
+        *_big += value_cast<big_decimal>(decimal_type->deserialize(v));
+    }
+    big_decimal get() const {
+        return _big ? *_big : big_decimal(_scale, to_cpp_int(_small));
+    }
+};
+
+template <>
+struct accumulator_for<utils::multiprecision_int> {
+    using type = varint_accumulator;
+
+    static utils::multiprecision_int narrow(const type& acc) {
+        return acc.get();
+    }
+
+    static void add(type& acc, bytes_view v) {
+        acc.add(v);
+    }
+
+    static bytes state(const type& acc) {
+        return varint_type->decompose(acc.get());
+    }
+
+    static void merge(type& acc, bytes_view state) {
+        acc.add(state);
+    }
+};
+
+template <>
+struct accumulator_for<big_decimal> {
+    using type = decimal_accumulator;
+
+    static big_decimal narrow(const type& acc) {
+        return acc.get();
+    }
+
+    static void add(type& acc, bytes_view v) {
+        acc.add(v);
+    }
+
+    static bytes state(const type& acc) {
+        return decimal_type->decompose(acc.get());
+    }
+
+    static void merge(type& acc, bytes_view state) {
+        acc.add(state);
+    }
+};
+
 template <typename Type>
 class impl_sum_function_for final : public aggregate_function::aggregate {
     using accumulator_type = typename accumulator_for<Type>::type;
@@ -124,7 +311,15 @@ class impl_sum_function_for final : public aggregate_function::aggregate {
         if (!values[0]) {
             return;
         }
-        _sum += value_cast<Type>(data_type_for<Type>()->deserialize(*values[0]));
+        accumulator_for<Type>::add(_sum, *values[0]);
+    }
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        return accumulator_for<Type>::state(_sum);
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        if (state) {
+            accumulator_for<Type>::merge(_sum, *state);
+        }
     }
 };
 
@@ -153,11 +348,19 @@ class impl_div_for_avg {
     }
 };
 
+template <>
+class impl_div_for_avg<utils::multiprecision_int> {
+public:
+    static utils::multiprecision_int div(const varint_accumulator& x, const int64_t y) {
+        return x.get() / y;
+    }
+};
+
 template <>
 class impl_div_for_avg<big_decimal> {
 public:
-    static big_decimal div(const big_decimal& x, const int64_t y) {
-        return x.div(y, big_decimal::rounding_mode::HALF_EVEN);
+    static big_decimal div(const decimal_accumulator& x, const int64_t y) {
+        return x.get().div(y, big_decimal::rounding_mode::HALF_EVEN);
     }
 };
 
@@ -182,7 +385,24 @@ class impl_avg_function_for final : public aggregate_function::aggregate {
             return;
         }
         ++_count;
-        _sum += value_cast<Type>(data_type_for<Type>()->deserialize(*values[0]));
+        accumulator_for<Type>::add(_sum, *values[0]);
+    }
+    // The state is the count followed by the state of the sum.
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        auto sum = accumulator_for<Type>::state(_sum);
+        bytes ret(bytes::initialized_later(), sizeof(int64_t) + sum.size());
+        auto out = ret.begin();
+        write<int64_t>(out, _count);
+        std::copy(sum.begin(), sum.end(), out);
+        return ret;
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        if (!state) {
+            return;
+        }
+        bytes_view v = *state;
+        _count += read_simple<int64_t>(v);
+        accumulator_for<Type>::merge(_sum, v);
     }
 };
 
@@ -265,6 +485,12 @@ class impl_max_function_for final : public aggregate_function::aggregate {
             _max = max_wrapper(*_max, val);
         }
     }
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        return compute(sf);
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        add_input(sf, {state});
+    }
 };
 
 /// The same as `impl_max_function_for' but without knowledge of `Type'.
@@ -286,6 +512,12 @@ class impl_max_dynamic_function final : public aggregate_function::aggregate {
             _max = val;
         }
     }
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        return _max;
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        add_input(sf, {state});
+    }
 };
 
 template <typename Type>
@@ -356,6 +588,12 @@ class impl_min_function_for final : public aggregate_function::aggregate {
             _min = min_wrapper(*_min, val);
         }
     }
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        return compute(sf);
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        add_input(sf, {state});
+    }
 };
 
 /// The same as `impl_min_function_for' but without knowledge of `Type'.
@@ -377,6 +615,12 @@ class impl_min_dynamic_function final : public aggregate_function::aggregate {
             _min = val;
         }
     }
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        return _min;
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        add_input(sf, {state});
+    }
 };
 
 template <typename Type>
@@ -425,6 +669,14 @@ class impl_count_function_for final : public aggregate_function::aggregate {
         }
         ++_count;
     }
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        return compute(sf);
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        if (state) {
+            _count += value_cast<int64_t>(long_type->deserialize(*state));
+        }
+    }
 };
 
 template <typename Type>
@@ -446,6 +698,149 @@ template <typename Type>
 static shared_ptr<aggregate_function> make_count_function() {
     return make_shared<count_function_for<Type>>();
 }
+
+/// Estimates the number of distinct non-null values with a HyperLogLog sketch
+/// over the hashes of their serialized form. The sketch takes 2^14 bytes
+/// regardless of the input size and has a standard error below 1%.
+class impl_approx_count_distinct_function final : public aggregate_function::aggregate {
+    static constexpr uint8_t register_bits = 14;
+    hll::HyperLogLog _hll{register_bits};
+public:
+    virtual void reset() override {
+        _hll.clear();
+    }
+    virtual opt_bytes compute(cql_serialization_format sf) override {
+        return long_type->decompose(int64_t(std::llround(_hll.estimate())));
+    }
+    virtual void add_input(cql_serialization_format sf, const std::vector<opt_bytes>& values) override {
+        if (!values[0]) {
+            return;
+        }
+        std::array<uint64_t, 2> hash;
+        utils::murmur_hash::hash3_x64_128(bytes_view(*values[0]), 0, hash);
+        _hll.offer_hashed(hash[0]);
+    }
+    // The state is the sketch as dumped by HyperLogLog::dump().
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        std::ostringstream os;
+        _hll.dump(os);
+        auto s = os.str();
+        return bytes(reinterpret_cast<const int8_t*>(s.data()), s.size());
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        if (!state) {
+            return;
+        }
+        std::istringstream is(std::string(reinterpret_cast<const char*>(state->data()), state->size()));
+        hll::HyperLogLog other;
+        other.restore(is);
+        _hll.merge(other);
+    }
+};
+
+class approx_count_distinct_function final : public native_aggregate_function {
+public:
+    approx_count_distinct_function(data_type input_type)
+        : native_aggregate_function("approx_count_distinct", long_type, { input_type }) {}
+    virtual std::unique_ptr<aggregate> new_aggregate() override {
+        return std::make_unique<impl_approx_count_distinct_function>();
+    }
+};
+
+template <typename CharOutputIterator>
+static void write_double(CharOutputIterator& out, double d) {
+    int64_t i;
+    std::memcpy(&i, &d, sizeof(i));
+    write<int64_t>(out, i);
+}
+
+static double read_double(bytes_view& v) {
+    auto i = read_simple<int64_t>(v);
+    double d;
+    std::memcpy(&d, &i, sizeof(d));
+    return d;
+}
+
+/// Estimates the given percentile of the non-null values with a t-digest.
+/// The percentile, a fraction between 0 and 1, is taken from the first row.
+template <typename Type>
+class impl_approx_percentile_function_for final : public aggregate_function::aggregate {
+    utils::tdigest _digest;
+    std::optional<double> _percentile;
+public:
+    virtual void reset() override {
+        _digest.clear();
+        _percentile = {};
+    }
+    virtual opt_bytes compute(cql_serialization_format sf) override {
+        if (!_percentile || _digest.total_weight() == 0) {
+            return {};
+        }
+        return double_type->decompose(_digest.quantile(*_percentile));
+    }
+    virtual void add_input(cql_serialization_format sf, const std::vector<opt_bytes>& values) override {
+        if (!_percentile) {
+            auto p = values[1] ? value_cast<double>(double_type->deserialize(*values[1])) : -1.0;
+            if (!(p >= 0 && p <= 1)) {
+                throw exceptions::invalid_request_exception("approx_percentile() requires a percentile between 0 and 1");
+            }
+            _percentile = p;
+        }
+        if (!values[0]) {
+            return;
+        }
+        _digest.add(static_cast<double>(value_cast<Type>(data_type_for<Type>()->deserialize(*values[0]))));
+    }
+    // The state is the percentile (NaN until the first row), the extremes of
+    // the digest and then the mean and weight of each centroid.
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        auto& centroids = _digest.centroids();
+        bytes ret(bytes::initialized_later(), sizeof(double) * (3 + 2 * centroids.size()));
+        auto out = ret.begin();
+        write_double(out, _percentile.value_or(std::numeric_limits<double>::quiet_NaN()));
+        write_double(out, _digest.min());
+        write_double(out, _digest.max());
+        for (auto& c : centroids) {
+            write_double(out, c.mean);
+            write_double(out, c.weight);
+        }
+        return ret;
+    }
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        if (!state) {
+            return;
+        }
+        bytes_view v = *state;
+        auto p = read_double(v);
+        if (!_percentile && !std::isnan(p)) {
+            _percentile = p;
+        }
+        auto min = read_double(v);
+        auto max = read_double(v);
+        std::vector<utils::tdigest::centroid> centroids;
+        centroids.reserve(v.size() / (2 * sizeof(double)));
+        while (!v.empty()) {
+            auto mean = read_double(v);
+            centroids.push_back({mean, read_double(v)});
+        }
+        _digest.merge(centroids, min, max);
+    }
+};
+
+template <typename Type>
+class approx_percentile_function_for final : public native_aggregate_function {
+public:
+    approx_percentile_function_for()
+        : native_aggregate_function("approx_percentile", double_type, { data_type_for<Type>(), double_type }) {}
+    virtual std::unique_ptr<aggregate> new_aggregate() override {
+        return std::make_unique<impl_approx_percentile_function_for<Type>>();
+    }
+};
+
+template <typename Type>
+static shared_ptr<aggregate_function> make_approx_percentile_function() {
+    return make_shared<approx_percentile_function_for<Type>>();
+}
 }
 
 shared_ptr<aggregate_function>
@@ -556,4 +951,16 @@ void cql3::functions::add_agg_functions(declared_t& funcs) {
     declare(make_avg_function<double>());
     declare(make_avg_function<utils::multiprecision_int>());
     declare(make_avg_function<big_decimal>());
+
+    for (auto& type : {byte_type, short_type, int32_type, long_type, varint_type, decimal_type, float_type, double_type,
+            utf8_type, ascii_type, simple_date_type, timestamp_type, timeuuid_type, time_type, uuid_type, bytes_type,
+            boolean_type, inet_addr_type}) {
+        declare(make_shared<approx_count_distinct_function>(type));
+    }
+    declare(make_approx_percentile_function<int8_t>());
+    declare(make_approx_percentile_function<int16_t>());
+    declare(make_approx_percentile_function<int32_t>());
+    declare(make_approx_percentile_function<int64_t>());
+    declare(make_approx_percentile_function<float>());
+    declare(make_approx_percentile_function<double>());
 }
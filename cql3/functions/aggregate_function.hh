@@ -43,6 +43,7 @@
 
 #include "function.hh"
 #include <optional>
+#include <stdexcept>
 
 namespace cql3 {
 namespace functions {
@@ -62,6 +63,16 @@ class aggregate_function : public virtual function {
      */
     virtual std::unique_ptr<aggregate> new_aggregate() = 0;
 
+    /**
+     * Checks if the state of the aggregates of this function can be taken
+     * with <code>aggregate::get_state()</code> and merged into another
+     * aggregate, so that parts of the input can be aggregated separately,
+     * e.g. by the replicas of different token ranges.
+     */
+    virtual bool is_reducible() const {
+        return false;
+    }
+
     /**
      * An aggregation operation.
      */
@@ -91,6 +102,23 @@ class aggregate_function : public virtual function {
          * Reset this aggregate.
          */
         virtual void reset() = 0;
+
+        /**
+         * Returns the serialized state of this aggregate, which
+         * <code>merge_state()</code> of another aggregate of the same
+         * function accepts. Only supported if the function is reducible.
+         */
+        virtual opt_bytes get_state(cql_serialization_format sf) {
+            throw std::logic_error("aggregate does not support partial aggregation");
+        }
+
+        /**
+         * Merges the state of another aggregate of the same function into
+         * this one, as if this aggregate had seen its input too.
+         */
+        virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) {
+            throw std::logic_error("aggregate does not support partial aggregation");
+        }
     };
 };
 
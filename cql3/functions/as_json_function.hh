@@ -69,9 +69,17 @@ namespace functions {
 class as_json_function : public scalar_function {
     std::vector<sstring> _selector_names;
     std::vector<data_type> _selector_types;
+    // The '"name": ' prefix of every selector, computed once rather than
+    // for every row.
+    std::vector<sstring> _encoded_names;
 public:
     as_json_function(std::vector<sstring>&& selector_names, std::vector<data_type> selector_types)
         : _selector_names(std::move(selector_names)), _selector_types(std::move(selector_types)) {
+        _encoded_names.reserve(_selector_names.size());
+        for (auto& name : _selector_names) {
+            bool has_any_upper = boost::algorithm::any_of(name, [](unsigned char c) { return std::isupper(c); });
+            _encoded_names.push_back(has_any_upper ? sstring("\"\\\"") + name + "\\\"\": " : sstring("\"") + name + "\": ");
+        }
     }
 
     virtual bool requires_thread() const;
@@ -83,18 +91,8 @@ class as_json_function : public scalar_function {
             if (i > 0) {
                 encoded_row.write(", ", 2);
             }
-            bool has_any_upper = boost::algorithm::any_of(_selector_names[i], [](unsigned char c) { return std::isupper(c); });
-            encoded_row.write("\"", 1);
-            if (has_any_upper) {
-                encoded_row.write("\\\"", 2);
-            }
-            encoded_row.write(_selector_names[i].c_str(), _selector_names[i].size());
-            if (has_any_upper) {
-                encoded_row.write("\\\"", 2);
-            }
-            encoded_row.write("\": ", 3);
-            sstring row_sstring = to_json_string(*_selector_types[i], parameters[i]);
-            encoded_row.write(row_sstring.c_str(), row_sstring.size());
+            encoded_row.write(_encoded_names[i].c_str(), _encoded_names[i].size());
+            write_json(*_selector_types[i], parameters[i], encoded_row);
         }
         encoded_row.write("}", 1);
         return bytes(encoded_row.linearize());
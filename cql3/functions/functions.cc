@@ -36,6 +36,9 @@
 #include "types/user.hh"
 #include "concrete_types.hh"
 #include "as_json_function.hh"
+#include "user_aggregate.hh"
+
+#include <boost/range/adaptor/map.hpp>
 
 namespace std {
 std::ostream& operator<<(std::ostream& os, const std::vector<data_type>& arg_types) {
@@ -135,12 +138,47 @@ void functions::replace_function(shared_ptr<function> func) {
     with_udf_iter(func->name(), func->arg_types(), [func] (functions::declared_t::iterator i) {
         i->second = std::move(func);
     });
+    // Aggregates hold on to their state, reduce and final functions, so rebuild
+    // the ones using the replaced function.
+    auto user_func = dynamic_pointer_cast<user_function>(func);
+    if (!user_func) {
+        return;
+    }
+    auto replaced = [&] (const shared_ptr<user_function>& f) {
+        return f && f->name() == user_func->name() && type_equals(f->arg_types(), user_func->arg_types()) ? user_func : f;
+    };
+    for (auto& fptr : _declared | boost::adaptors::map_values) {
+        auto aggregate = dynamic_pointer_cast<user_aggregate>(fptr);
+        if (!aggregate) {
+            continue;
+        }
+        auto sfunc = replaced(aggregate->sfunc());
+        auto reducefunc = replaced(aggregate->reducefunc());
+        auto finalfunc = replaced(aggregate->finalfunc());
+        if (sfunc != aggregate->sfunc() || reducefunc != aggregate->reducefunc() || finalfunc != aggregate->finalfunc()) {
+            fptr = ::make_shared<user_aggregate>(aggregate->name(), aggregate->initcond(), aggregate->initcond_cql(),
+                    std::move(sfunc), std::move(reducefunc), std::move(finalfunc));
+        }
+    }
 }
 
 void functions::remove_function(const function_name& name, const std::vector<data_type>& arg_types) {
     with_udf_iter(name, arg_types, [] (functions::declared_t::iterator i) { _declared.erase(i); });
 }
 
+shared_ptr<user_aggregate> functions::used_by_user_aggregate(const function_name& name, const std::vector<data_type>& arg_types) {
+    auto uses = [&] (const shared_ptr<user_function>& f) {
+        return f && f->name() == name && type_equals(f->arg_types(), arg_types);
+    };
+    for (auto& fptr : _declared | boost::adaptors::map_values) {
+        auto aggregate = dynamic_pointer_cast<user_aggregate>(fptr);
+        if (aggregate && (uses(aggregate->sfunc()) || uses(aggregate->reducefunc()) || uses(aggregate->finalfunc()))) {
+            return aggregate;
+        }
+    }
+    return nullptr;
+}
+
 shared_ptr<column_specification>
 functions::make_arg_spec(const sstring& receiver_ks, const sstring& receiver_cf,
         const function& fun, size_t i) {
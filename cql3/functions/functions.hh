@@ -61,6 +61,8 @@ namespace functions {
     using declared_t = std::unordered_multimap<function_name, shared_ptr<function>>;
     void add_agg_functions(declared_t& funcs);
 
+class user_aggregate;
+
 class functions {
     using declared_t = cql3::functions::declared_t;
     static thread_local declared_t _declared;
@@ -96,6 +98,9 @@ class functions {
     static void add_function(shared_ptr<function>);
     static void replace_function(shared_ptr<function>);
     static void remove_function(const function_name& name, const std::vector<data_type>& arg_types);
+    // Returns a user defined aggregate using the given function as its state
+    // or final function, or nullptr if there is none.
+    static shared_ptr<user_aggregate> used_by_user_aggregate(const function_name& name, const std::vector<data_type>& arg_types);
 private:
     template <typename F>
     static void with_udf_iter(const function_name& name, const std::vector<data_type>& arg_types, F&& f);
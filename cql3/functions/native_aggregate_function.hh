@@ -63,6 +63,10 @@ class native_aggregate_function : public native_function, public aggregate_funct
     virtual bool is_aggregate() const override final {
         return true;
     }
+
+    virtual bool is_reducible() const override {
+        return true;
+    }
 };
 
 }
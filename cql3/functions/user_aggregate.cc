@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "user_aggregate.hh"
+
+#include <algorithm>
+
+namespace cql3 {
+namespace functions {
+
+namespace {
+
+// Keeps the state in native form between rows and runs the state function
+// in an interpreter loaded once per aggregation, so a row only costs the
+// conversion of its own arguments.
+class user_aggregate_state final : public aggregate_function::aggregate {
+    const user_aggregate& _agg;
+    std::optional<lua::loaded_script> _sfunc_script;
+    data_value _state;
+    std::vector<data_value> _args;
+public:
+    explicit user_aggregate_state(const user_aggregate& agg)
+        : _agg(agg)
+        , _state(initial_state()) {
+    }
+
+    virtual void add_input(cql_serialization_format sf, const std::vector<opt_bytes>& values) override {
+        const auto& sfunc = *_agg.sfunc();
+        const auto& types = sfunc.arg_types();
+        if (values.size() + 1 != types.size()) {
+            throw std::logic_error("Wrong number of parameters");
+        }
+        if (!sfunc.called_on_null_input()) {
+            if (_state.is_null() || std::any_of(values.begin(), values.end(), [] (const opt_bytes& v) { return !v; })) {
+                _state = data_value::make_null(_agg.state_type());
+                return;
+            }
+        }
+        if (!_sfunc_script) {
+            _sfunc_script.emplace(sfunc.bitcode(), sfunc.runtime_config());
+        }
+        _args.clear();
+        _args.push_back(std::move(_state));
+        for (size_t i = 0; i < values.size(); ++i) {
+            const auto& type = types[i + 1];
+            _args.push_back(values[i] ? type->deserialize(*values[i]) : data_value::make_null(type));
+        }
+        _state = _sfunc_script->run(_args, _agg.state_type()).get0();
+    }
+
+    virtual opt_bytes compute(cql_serialization_format sf) override {
+        auto state = _state.serialize();
+        if (!_agg.finalfunc()) {
+            return state;
+        }
+        return _agg.finalfunc()->execute(sf, {std::move(state)});
+    }
+
+    virtual void reset() override {
+        _state = initial_state();
+    }
+
+    virtual opt_bytes get_state(cql_serialization_format sf) override {
+        return _state.serialize();
+    }
+
+    virtual void merge_state(cql_serialization_format sf, const opt_bytes& state) override {
+        auto reduced = _agg.reducefunc()->execute(sf, {_state.serialize(), state});
+        _state = reduced ? _agg.state_type()->deserialize(*reduced) : data_value::make_null(_agg.state_type());
+    }
+private:
+    data_value initial_state() const {
+        const auto& initcond = _agg.initcond();
+        return initcond ? _agg.state_type()->deserialize(*initcond) : data_value::make_null(_agg.state_type());
+    }
+};
+
+}
+
+user_aggregate::user_aggregate(function_name fname, bytes_opt initcond, std::optional<sstring> initcond_cql,
+        ::shared_ptr<user_function> sfunc, ::shared_ptr<user_function> reducefunc, ::shared_ptr<user_function> finalfunc)
+    : abstract_function(std::move(fname),
+            std::vector<data_type>(sfunc->arg_types().begin() + 1, sfunc->arg_types().end()),
+            finalfunc ? finalfunc->return_type() : sfunc->return_type())
+    , _initcond(std::move(initcond))
+    , _initcond_cql(std::move(initcond_cql))
+    , _sfunc(std::move(sfunc))
+    , _reducefunc(std::move(reducefunc))
+    , _finalfunc(std::move(finalfunc)) {
+}
+
+std::unique_ptr<aggregate_function::aggregate> user_aggregate::new_aggregate() {
+    return std::make_unique<user_aggregate_state>(*this);
+}
+
+bool user_aggregate::is_reducible() const { return bool(_reducefunc); }
+
+bool user_aggregate::is_pure() const { return true; }
+
+bool user_aggregate::is_native() const { return false; }
+
+bool user_aggregate::is_aggregate() const { return true; }
+
+bool user_aggregate::requires_thread() const { return true; }
+
+}
+}
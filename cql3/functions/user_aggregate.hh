@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "abstract_function.hh"
+#include "aggregate_function.hh"
+#include "user_function.hh"
+
+namespace cql3 {
+namespace functions {
+
+// An aggregate defined with CREATE AGGREGATE, folding the rows with a user
+// defined state function and optionally transforming the resulting state
+// with a user defined final function. With a reduce function, which merges
+// two states into one, the aggregate is reducible.
+class user_aggregate final : public abstract_function, public aggregate_function {
+    bytes_opt _initcond;
+    // The INITCOND as written in CREATE AGGREGATE, kept for the schema.
+    std::optional<sstring> _initcond_cql;
+    ::shared_ptr<user_function> _sfunc;
+    ::shared_ptr<user_function> _reducefunc;
+    ::shared_ptr<user_function> _finalfunc;
+public:
+    user_aggregate(function_name fname, bytes_opt initcond, std::optional<sstring> initcond_cql,
+            ::shared_ptr<user_function> sfunc, ::shared_ptr<user_function> reducefunc, ::shared_ptr<user_function> finalfunc);
+
+    const bytes_opt& initcond() const { return _initcond; }
+    const std::optional<sstring>& initcond_cql() const { return _initcond_cql; }
+    const ::shared_ptr<user_function>& sfunc() const { return _sfunc; }
+    const ::shared_ptr<user_function>& reducefunc() const { return _reducefunc; }
+    const ::shared_ptr<user_function>& finalfunc() const { return _finalfunc; }
+    const data_type& state_type() const { return _sfunc->return_type(); }
+
+    virtual std::unique_ptr<aggregate> new_aggregate() override;
+    virtual bool is_reducible() const override;
+    virtual bool is_pure() const override;
+    virtual bool is_native() const override;
+    virtual bool is_aggregate() const override;
+    virtual bool requires_thread() const override;
+};
+
+}
+}
@@ -59,6 +59,10 @@ class user_function final : public abstract_function, public scalar_function {
 
     bool called_on_null_input() const { return _called_on_null_input; }
 
+    lua::bitcode_view bitcode() const { return lua::bitcode_view{_bitcode}; }
+
+    const lua::runtime_config& runtime_config() const { return _cfg; }
+
     virtual bool is_pure() const override;
     virtual bool is_native() const override;
     virtual bool is_aggregate() const override;
@@ -46,6 +46,8 @@
 #include "cql3/CqlParser.hpp"
 #include "cql3/error_collector.hh"
 #include "cql3/statements/batch_statement.hh"
+#include "cql3/statements/modification_statement.hh"
+#include "cql3/statements/select_statement.hh"
 #include "cql3/util.hh"
 #include "cql3/untyped_result_set.hh"
 #include "db/config.hh"
@@ -97,7 +99,8 @@ query_processor::query_processor(service::storage_proxy& proxy, database& db, se
         , _authorized_prepared_cache(std::min(std::chrono::milliseconds(_db.get_config().permissions_validity_in_ms()),
                                               std::chrono::duration_cast<std::chrono::milliseconds>(prepared_statements_cache::entry_expiry)),
                                      std::chrono::milliseconds(_db.get_config().permissions_update_interval_in_ms()),
-                                     mcfg.authorized_prepared_cache_size, authorized_prepared_statements_cache_log) {
+                                     mcfg.authorized_prepared_cache_size, authorized_prepared_statements_cache_log)
+        , _unprepared_cache(prep_cache_log, mcfg.unprepared_statement_cache_size) {
     namespace sm = seastar::metrics;
     namespace stm = statements;
     using clevel = db::consistency_level;
@@ -115,6 +118,18 @@ query_processor::query_processor(service::storage_proxy& proxy, database& db, se
         "statements_prepared",
         _stats.prepare_invocations,
         sm::description("Counts the total number of parsed CQL requests.")));
+    qp_group.push_back(sm::make_derive(
+        "unprepared_cache_hits",
+        _stats.unprepared_cache_hits,
+        sm::description("Counts unprepared CQL requests which reused the statement cached by an earlier request with the same query string.")));
+    qp_group.push_back(sm::make_derive(
+        "unprepared_cache_misses",
+        _stats.unprepared_cache_misses,
+        sm::description("Counts cacheable unprepared CQL requests which had to be parsed.")));
+    qp_group.push_back(sm::make_gauge(
+        "unprepared_cache_size",
+        [this] { return _unprepared_cache.size(); },
+        sm::description("A number of entries in the unprepared statements cache.")));
     for (auto cl = size_t(clevel::MIN_VALUE); cl <= size_t(clevel::MAX_VALUE); ++cl) {
         qp_group.push_back(
             sm::make_derive(
@@ -380,6 +395,26 @@ query_processor::query_processor(service::storage_proxy& proxy, database& db, se
                             _cql_stats.secondary_index_rows_read,
                             sm::description("Counts the total number of rows read during CQL requests performed using secondary indexes.")),
 
+                    sm::make_derive(
+                            "secondary_index_covered_reads",
+                            _cql_stats.secondary_index_covered_reads,
+                            sm::description("Counts the total number of CQL read requests served from a secondary index without reading the base table.")),
+
+                    sm::make_derive(
+                            "secondary_index_intersections",
+                            _cql_stats.secondary_index_intersections,
+                            sm::description("Counts the total number of posting lists of other secondary indexes read to prune the keys of a secondary index read.")),
+
+                    sm::make_derive(
+                            "secondary_index_intersections_skipped",
+                            _cql_stats.secondary_index_intersections_skipped,
+                            sm::description("Counts the total number of posting list intersections abandoned because the other index value was too common.")),
+
+                    sm::make_derive(
+                            "secondary_index_keys_pruned",
+                            _cql_stats.secondary_index_keys_pruned,
+                            sm::description("Counts the total number of keys read from a secondary index and dropped by a posting list intersection, before reading the base table.")),
+
                     // read requests that required ALLOW FILTERING
                     sm::make_derive(
                             "filtered_read_requests",
@@ -424,6 +459,11 @@ query_processor::query_processor(service::storage_proxy& proxy, database& db, se
                             _cql_stats.select_partition_range_scan_no_bypass_cache,
                             sm::description("Counts the number of SELECT query executions requiring partition range scan without BYPASS CACHE option.")),
 
+                    sm::make_derive(
+                            "select_parallelized_aggregates",
+                            _cql_stats.select_parallelized_aggregates,
+                            sm::description("Counts the number of aggregate SELECT query executions scanning token ranges in parallel.")),
+
                     sm::make_derive(
                             "authorized_prepared_statements_cache_evictions",
                             [] { return authorized_prepared_statements_cache::shard_stats().authorized_prepared_statements_cache_evictions; },
@@ -468,23 +508,60 @@ query_processor::~query_processor() {
 
 future<> query_processor::stop() {
     return _mnotifier.unregister_listener(_migration_subscriber.get()).then([this] {
-        return _authorized_prepared_cache.stop().finally([this] { return _prepared_cache.stop(); });
+        return _authorized_prepared_cache.stop().finally([this] {
+            return _prepared_cache.stop();
+        }).finally([this] {
+            return _unprepared_cache.stop();
+        });
     });
 }
 
+// Only statements which naive clients repeat, with values bound to markers,
+// are worth caching: a statement with literals instead would mostly churn
+// the cache.
+static bool is_cacheable_unprepared(const cql_statement& stmt) {
+    return stmt.get_bound_terms() > 0
+            && (dynamic_cast<const statements::select_statement*>(&stmt)
+                || dynamic_cast<const statements::modification_statement*>(&stmt)
+                || dynamic_cast<const statements::batch_statement*>(&stmt));
+}
+
 future<::shared_ptr<result_message>>
 query_processor::execute_direct(const sstring_view& query_string, service::query_state& query_state, query_options& options) {
     log.trace("execute_direct: \"{}\"", query_string);
+    auto& client_state = query_state.get_client_state();
+    auto cache_key = compute_id(query_string, client_state.get_raw_keyspace());
+    auto it = _unprepared_cache.find(cache_key);
+    if (it != _unprepared_cache.end()) {
+        ++_stats.unprepared_cache_hits;
+        tracing::trace(query_state.get_trace_state(), "Using a cached statement");
+        return execute_direct_statement(**it, query_state, options);
+    }
     tracing::trace(query_state.get_trace_state(), "Parsing a statement");
-    auto p = get_statement(query_string, query_state.get_client_state());
-    auto cql_statement = p->statement;
+    auto p = get_statement(query_string, client_state);
+    if (!is_cacheable_unprepared(*p->statement)) {
+        return execute_direct_statement(*p, query_state, options);
+    }
+    ++_stats.unprepared_cache_misses;
+    return _unprepared_cache.get(cache_key, [p = std::move(p)] () mutable {
+        return make_ready_future<std::unique_ptr<statements::prepared_statement>>(std::move(p));
+    }).then([this, &query_state, &options] (statements::prepared_statement::checked_weak_ptr cached) {
+        return execute_direct_statement(*cached, query_state, options);
+    }).handle_exception_type([this, query_string = sstring(query_string), &query_state, &options] (prepared_statements_cache::statement_is_too_big&) {
+        return execute_direct_statement(*get_statement(query_string, query_state.get_client_state()), query_state, options);
+    });
+}
+
+future<::shared_ptr<result_message>>
+query_processor::execute_direct_statement(const statements::prepared_statement& p, service::query_state& query_state, query_options& options) {
+    auto cql_statement = p.statement;
     if (cql_statement->get_bound_terms() != options.get_values_count()) {
         const auto msg = format("Invalid amount of bind variables: expected {:d} received {:d}",
                 cql_statement->get_bound_terms(),
                 options.get_values_count());
         throw exceptions::invalid_request_exception(msg);
     }
-    options.prepare(p->bound_names);
+    options.prepare(p.bound_names);
 
     warn(unimplemented::cause::METRICS);
 #if 0
@@ -949,6 +1026,9 @@ void query_processor::migration_subscriber::remove_invalid_prepared_statements(
     _qp->_prepared_cache.remove_if([&] (::shared_ptr<cql_statement> stmt) {
         return this->should_invalidate(ks_name, cf_name, stmt);
     });
+    _qp->_unprepared_cache.remove_if([&] (::shared_ptr<cql_statement> stmt) {
+        return this->should_invalidate(ks_name, cf_name, stmt);
+    });
 }
 
 bool query_processor::migration_subscriber::should_invalidate(
@@ -108,6 +108,7 @@ class query_processor {
     struct memory_config {
         size_t prepared_statment_cache_size = 0;
         size_t authorized_prepared_cache_size = 0;
+        size_t unprepared_statement_cache_size = 0;
     };
 
 private:
@@ -119,6 +120,8 @@ class query_processor {
 
     struct stats {
         uint64_t prepare_invocations = 0;
+        uint64_t unprepared_cache_hits = 0;
+        uint64_t unprepared_cache_misses = 0;
         uint64_t queries_by_cl[size_t(db::consistency_level::MAX_VALUE) + 1] = {};
     } _stats;
 
@@ -131,6 +134,10 @@ class query_processor {
 
     prepared_statements_cache _prepared_cache;
     authorized_prepared_statements_cache _authorized_prepared_cache;
+    // Statements of QUERY requests, parsed and prepared once for all
+    // executions. Kept apart from _prepared_cache, so that ad-hoc queries
+    // never evict statements which clients prepared explicitly.
+    prepared_statements_cache _unprepared_cache;
 
     // A map for prepared statements used internally (which we don't want to mix with user statement, in particular we
     // don't bother with expiration on those.
@@ -206,6 +213,13 @@ class query_processor {
             const std::string_view& query_string,
             service::query_state& query_state,
             query_options& options);
+private:
+    future<::shared_ptr<cql_transport::messages::result_message>>
+    execute_direct_statement(
+            const statements::prepared_statement& p,
+            service::query_state& query_state,
+            query_options& options);
+public:
 
     future<::shared_ptr<untyped_result_set>>
     execute_internal(const sstring& query_string, const std::initializer_list<data_value>& values = { }) {
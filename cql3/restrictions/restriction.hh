@@ -170,6 +170,19 @@ class restriction {
         return std::move(vec[0]);
     }
 
+    /**
+     * Like value(), but the value is stored in the temporaries of the given
+     * query_options, so the returned view is valid for as long as they are
+     * and no per-restriction copy has to be made.
+     */
+    virtual std::optional<bytes_view> value_view(const query_options& options) const {
+        auto val = value(options);
+        if (!val) {
+            return {};
+        }
+        return options.linearize(*options.make_temporary(raw_value::make_value(std::move(*val))).data());
+    }
+
     /**
      * Whether the specified row satisfied this restriction.
      * Assumes the row is live, but not all cells. If a cell
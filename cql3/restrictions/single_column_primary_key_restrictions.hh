@@ -47,6 +47,7 @@
 #include "cql3/restrictions/primary_key_restrictions.hh"
 #include "cql3/restrictions/single_column_restrictions.hh"
 #include "cql3/cql_config.hh"
+#include "utils/small_vector.hh"
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/range/adaptor/filtered.hpp>
@@ -229,30 +230,21 @@ class single_column_primary_key_restrictions : public primary_key_restrictions<V
 
         if (_restrictions->is_all_eq()) {
             ranges.reserve(1);
-            if (_restrictions->size() == 1) {
-                auto&& e = *_restrictions->restrictions().begin();
-                const column_definition* def = e.first;
-                auto&& r = e.second;
-                auto&& val = r->value(options);
-                if (!val) {
-                    throw exceptions::invalid_request_exception(sprint(invalid_null_msg, def->name_as_text()));
-                }
-                ranges.emplace_back(range_type::make_singular(ValueType::from_single_value(*_schema, std::move(*val))));
-                return ranges;
-            }
-            std::vector<bytes> components;
+            // The bound values live in the temporaries of options, so the key
+            // is serialized straight from them without copying each component.
+            utils::small_vector<bytes_view, 8> components;
             components.reserve(_restrictions->size());
             for (auto&& e : _restrictions->restrictions()) {
                 const column_definition* def = e.first;
                 auto&& r = e.second;
                 assert(components.size() == _schema->position(*def));
-                auto&& val = r->value(options);
+                auto val = r->value_view(options);
                 if (!val) {
                     throw exceptions::invalid_request_exception(sprint(invalid_null_msg, def->name_as_text()));
                 }
-                components.emplace_back(std::move(*val));
+                components.emplace_back(*val);
             }
-            ranges.emplace_back(range_type::make_singular(ValueType::from_exploded(*_schema, std::move(components))));
+            ranges.emplace_back(range_type::make_singular(ValueType::from_exploded(components)));
             return ranges;
         }
 
@@ -346,6 +338,10 @@ class single_column_primary_key_restrictions : public primary_key_restrictions<V
 public:
     std::vector<bounds_range_type> bounds_ranges(const query_options& options) const override;
 
+    // The partition keys of bounds_ranges() before they are decorated, for
+    // callers which compute the tokens of many keys together.
+    std::vector<ValueType> singular_keys(const query_options& options) const;
+
     std::vector<bytes_opt> values(const query_options& options) const override {
         auto src = values_as_keys(options);
         std::vector<bytes_opt> res;
@@ -411,19 +407,33 @@ class single_column_primary_key_restrictions : public primary_key_restrictions<V
 };
 
 template<>
-inline dht::partition_range_vector
-single_column_primary_key_restrictions<partition_key>::bounds_ranges(const query_options& options) const {
-    dht::partition_range_vector ranges;
-    ranges.reserve(size());
-    for (query::range<partition_key>& r : compute_bounds(options)) {
+inline std::vector<partition_key>
+single_column_primary_key_restrictions<partition_key>::singular_keys(const query_options& options) const {
+    std::vector<partition_key> keys;
+    auto bounds = compute_bounds(options);
+    keys.reserve(bounds.size());
+    for (query::range<partition_key>& r : bounds) {
         if (!r.is_singular()) {
             throw exceptions::invalid_request_exception("Range queries on partition key values not supported.");
         }
-        ranges.emplace_back(std::move(r).transform(
-            [this] (partition_key&& k) -> query::ring_position {
-                auto token = dht::get_token(*_schema, k);
-                return { std::move(token), std::move(k) };
-            }));
+        std::move(r).transform([&keys] (partition_key&& k) {
+            keys.push_back(std::move(k));
+            return 0;
+        });
+    }
+    return keys;
+}
+
+template<>
+inline dht::partition_range_vector
+single_column_primary_key_restrictions<partition_key>::bounds_ranges(const query_options& options) const {
+    auto keys = singular_keys(options);
+    // An IN restriction may name many partitions; hash them in one go.
+    auto tokens = dht::get_tokens(*_schema, std::vector<partition_key_view>(keys.begin(), keys.end()));
+    dht::partition_range_vector ranges;
+    ranges.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ranges.emplace_back(dht::partition_range::make_singular(query::ring_position(std::move(tokens[i]), std::move(keys[i]))));
     }
     return ranges;
 }
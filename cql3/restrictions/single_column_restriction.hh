@@ -156,6 +156,14 @@ class single_column_restriction::EQ final : public single_column_restriction {
         return to_bytes_opt(_value->bind_and_get(options));
     }
 
+    virtual std::optional<bytes_view> value_view(const query_options& options) const override {
+        auto val = _value->bind_and_get(options).data();
+        if (!val) {
+            return {};
+        }
+        return options.linearize(*val);
+    }
+
     virtual sstring to_string() const override {
         return format("EQ({})", _value->to_string());
     }
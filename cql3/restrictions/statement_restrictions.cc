@@ -387,6 +387,27 @@ std::pair<std::optional<secondary_index::index>, ::shared_ptr<cql3::restrictions
     return {chosen_index, chosen_index_restrictions};
 }
 
+std::vector<std::pair<secondary_index::index, ::shared_ptr<single_column_restriction>>> statement_restrictions::find_intersectable_idxs(
+        secondary_index::secondary_index_manager& sim, const secondary_index::index& chosen) const {
+    std::vector<std::pair<secondary_index::index, ::shared_ptr<single_column_restriction>>> intersectable;
+    for (const auto& index : sim.list_indexes()) {
+        if (index.metadata().name() == chosen.metadata().name() || score(index) == 0) {
+            continue;
+        }
+        for (auto&& cdef : _nonprimary_key_restrictions->get_column_defs()) {
+            if (!cdef->is_regular() || !index.depends_on(*cdef) || chosen.depends_on(*cdef)) {
+                continue;
+            }
+            auto restr = dynamic_pointer_cast<single_column_restriction>(_nonprimary_key_restrictions->get_restriction(*cdef));
+            if (restr && restr->is_EQ() && restr->is_supported_by(index)) {
+                intersectable.emplace_back(index, std::move(restr));
+                break;
+            }
+        }
+    }
+    return intersectable;
+}
+
 std::vector<const column_definition*> statement_restrictions::get_column_defs_for_filtering(database& db) const {
     std::vector<const column_definition*> column_defs_for_filtering;
     if (need_filtering()) {
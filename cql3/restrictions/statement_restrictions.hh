@@ -199,6 +199,15 @@ class statement_restrictions {
      */
     std::pair<std::optional<secondary_index::index>, ::shared_ptr<cql3::restrictions::restrictions>> find_idx(secondary_index::secondary_index_manager& sim) const;
 
+    /**
+     * Determines the indexes, other than the chosen one, whose posting lists can be intersected
+     * with the posting list of the chosen index.
+     * @param chosen - the index returned by find_idx()
+     * @return The indexes supporting an EQ restriction on a regular column, each paired with that restriction.
+     */
+    std::vector<std::pair<secondary_index::index, ::shared_ptr<single_column_restriction>>> find_intersectable_idxs(
+            secondary_index::secondary_index_manager& sim, const secondary_index::index& chosen) const;
+
     /**
      * Checks if the partition key has some unrestricted components.
      * @return <code>true</code> if the partition key has some unrestricted components, <code>false</code> otherwise.
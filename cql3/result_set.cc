@@ -40,6 +40,7 @@
  */
 
 #include "cql3/result_set.hh"
+#include "hashers.hh"
 
 namespace cql3 {
 
@@ -66,6 +67,26 @@ void metadata::add_non_serialized_column(::shared_ptr<column_specification> name
     _column_info->_names.emplace_back(std::move(name));
 }
 
+const bytes& metadata::metadata_id() const {
+    if (!_column_info->_metadata_id) {
+        md5_hasher h;
+        auto feed = [&h] (const sstring& s) {
+            h.update(s.data(), s.size());
+            // Separates the strings, so that ("ab", "c") and ("a", "bc") differ.
+            h.update("", 1);
+        };
+        for (uint32_t i = 0; i < column_count(); ++i) {
+            auto& name = _column_info->_names[i];
+            feed(name->ks_name);
+            feed(name->cf_name);
+            feed(name->name->text());
+            feed(name->type->name());
+        }
+        _column_info->_metadata_id = h.finalize();
+    }
+    return *_column_info->_metadata_id;
+}
+
 bool metadata::all_in_same_cf() const {
     if (_flags.contains<flag::NO_METADATA>()) {
         return false;
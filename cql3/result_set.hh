@@ -42,6 +42,7 @@
 #pragma once
 
 #include <deque>
+#include <optional>
 #include <vector>
 #include "enum_set.hh"
 #include "service/pager/paging_state.hh"
@@ -60,12 +61,14 @@ class metadata {
         GLOBAL_TABLES_SPEC = 0,
         HAS_MORE_PAGES = 1,
         NO_METADATA = 2,
+        METADATA_CHANGED = 3,
     };
 
     using flag_enum = super_enum<flag,
         flag::GLOBAL_TABLES_SPEC,
         flag::HAS_MORE_PAGES,
-        flag::NO_METADATA>;
+        flag::NO_METADATA,
+        flag::METADATA_CHANGED>;
 
     using flag_enum_set = enum_set<flag_enum>;
 
@@ -76,6 +79,9 @@ class metadata {
     // (CASSANDRA-4911). So the serialization code will exclude any columns in name whose index is >= columnCount.
         std::vector<::shared_ptr<column_specification>> _names;
         uint32_t _column_count;
+        // Digest of the serialized columns, computed on first use. Shared by
+        // all result sets of a prepared statement, since they share column_info.
+        mutable std::optional<bytes> _metadata_id;
 
         column_info(std::vector<::shared_ptr<column_specification>> names, uint32_t column_count)
             : _names(std::move(names))
@@ -123,6 +129,10 @@ class metadata {
     const std::vector<::shared_ptr<column_specification>>& get_names() const {
         return _column_info->_names;
     }
+
+    // Identifies the columns of the result, as sent to the client, so that
+    // a client which already knows them can be spared the metadata.
+    const bytes& metadata_id() const;
 };
 
 ::shared_ptr<const cql3::metadata> make_empty_metadata();
@@ -41,6 +41,7 @@
 #include "aggregate_function_selector.hh"
 #include "scalar_function_selector.hh"
 #include "to_string.hh"
+#include "query-request.hh"
 
 namespace cql3 {
 
@@ -101,6 +102,31 @@ abstract_function_selector::new_factory(shared_ptr<functions::function> fun, sha
         virtual bool is_aggregate_selector_factory() const override {
             return _fun->is_aggregate() || _factories->contains_only_aggregate_functions();
         }
+
+        virtual std::optional<query::aggregate_call> to_aggregate_call() const override {
+            auto agg = dynamic_pointer_cast<functions::aggregate_function>(_fun);
+            if (!agg || !agg->is_reducible()) {
+                return std::nullopt;
+            }
+            query::aggregate_call call;
+            call.function_keyspace = _fun->name().keyspace;
+            call.function_name = _fun->name().name;
+            for (auto&& type : _fun->arg_types()) {
+                call.argument_types.push_back(type->name());
+            }
+            for (auto&& factory : *_factories) {
+                auto arg = factory->to_aggregate_call();
+                if (!arg || !arg->function_name.empty()) {
+                    return std::nullopt;
+                }
+                call.arguments.push_back(arg->arguments.front());
+                if (!arg->constants.empty()) {
+                    call.constants.resize(call.arguments.size());
+                    call.constants.back() = arg->constants.front();
+                }
+            }
+            return call;
+        }
     };
 
     return make_shared<fun_selector_factory>(std::move(fun), std::move(factories));
@@ -30,6 +30,7 @@
 #include "cql3/functions/aggregate_fcts.hh"
 #include "abstract_function_selector.hh"
 #include "writetime_or_ttl_selector.hh"
+#include "term_selector.hh"
 
 namespace cql3 {
 
@@ -83,6 +84,15 @@ selectable::with_function::new_selector_factory(database& db, schema_ptr s, std:
         throw exceptions::invalid_request_exception(format("Unknown function {} called in selection clause", _function_name));
     }
 
+    // Literal arguments take the type of the parameter they are passed to.
+    size_t i = 0;
+    for (auto&& factory : *factories) {
+        if (auto term = dynamic_pointer_cast<term_selector_factory>(factory)) {
+            term->bind(db, s->ks_name(), functions::functions::make_arg_spec(s->ks_name(), s->cf_name(), *fun, i));
+        }
+        ++i;
+    }
+
     return abstract_function_selector::new_factory(std::move(fun), std::move(factories));
 }
 
@@ -200,6 +210,26 @@ selectable::with_cast::raw::processes_selection() const {
     return true;
 }
 
+shared_ptr<selector::factory>
+selectable::with_term::new_selector_factory(database& db, schema_ptr s, std::vector<const column_definition*>& defs) {
+    return ::make_shared<term_selector_factory>(_raw);
+}
+
+sstring
+selectable::with_term::to_string() const {
+    return _raw->to_string();
+}
+
+shared_ptr<selectable>
+selectable::with_term::raw::prepare(const schema& s) const {
+    return ::make_shared<selectable::with_term>(_raw);
+}
+
+bool
+selectable::with_term::raw::processes_selection() const {
+    return true;
+}
+
 std::ostream & operator<<(std::ostream &os, const selectable& s) {
     return os << s.to_string();
 }
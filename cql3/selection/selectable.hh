@@ -48,6 +48,7 @@
 #include "cql3/cql3_type.hh"
 #include "cql3/functions/function.hh"
 #include "cql3/functions/function_name.hh"
+#include "cql3/term.hh"
 
 namespace cql3 {
 
@@ -88,6 +89,8 @@ class selectable {
     class with_field_selection;
 
     class with_cast;
+
+    class with_term;
 };
 
 std::ostream & operator<<(std::ostream &os, const selectable& s);
@@ -162,6 +165,27 @@ class selectable::with_cast : public selectable {
     };
 };
 
+class selectable::with_term : public selectable {
+    ::shared_ptr<term::raw> _raw;
+public:
+    explicit with_term(::shared_ptr<term::raw> raw)
+        : _raw(std::move(raw)) {
+    }
+
+    virtual sstring to_string() const override;
+
+    virtual shared_ptr<selector::factory> new_selector_factory(database& db, schema_ptr s, std::vector<const column_definition*>& defs) override;
+    class raw : public selectable::raw {
+        ::shared_ptr<term::raw> _raw;
+    public:
+        explicit raw(::shared_ptr<term::raw> raw)
+                : _raw(std::move(raw)) {
+        }
+        virtual shared_ptr<selectable> prepare(const schema& s) const override;
+        virtual bool processes_selection() const override;
+    };
+};
+
 }
 
 }
@@ -42,6 +42,7 @@
 #include <boost/range/adaptors.hpp>
 #include <boost/range/algorithm/equal.hpp>
 #include <boost/range/algorithm/transform.hpp>
+#include <boost/algorithm/cxx11/any_of.hpp>
 
 #include "cql3/selection/selection.hh"
 #include "cql3/selection/selector_factories.hh"
@@ -175,6 +176,14 @@ class selection_with_processing : public selection {
     virtual bool is_aggregate() const override {
         return _factories->does_aggregation();
     }
+
+    virtual bool contains_only_aggregate_functions() const override {
+        return _factories->contains_only_aggregate_functions();
+    }
+
+    virtual std::optional<std::vector<query::aggregate_call>> get_aggregate_calls() const override {
+        return _factories->to_aggregate_calls();
+    }
 protected:
     class selectors_with_processing : public selectors {
     private:
@@ -403,7 +412,120 @@ result_set_builder::restrictions_filter::restrictions_filter(::shared_ptr<restri
     , _per_partition_remaining(_per_partition_limit)
     , _rows_fetched_for_last_partition(rows_fetched_for_last_partition)
     , _last_pkey(std::move(last_pkey))
-{ }
+{
+    auto compile = [this] (const restrictions::single_column_restrictions::restrictions_map& restrictions) {
+        for (auto&& [cdef, restriction] : restrictions) {
+            auto& predicates = [&] () -> column_predicates& {
+                switch (cdef->kind) {
+                case column_kind::partition_key: return _partition_key_predicates;
+                case column_kind::clustering_key: return _clustering_key_predicates;
+                case column_kind::static_column: return _static_predicates;
+                default: return _regular_predicates;
+                }
+            }();
+            if (predicates.size() <= cdef->id) {
+                predicates.resize(cdef->id + 1);
+            }
+            predicates[cdef->id] = column_predicate::compile(*restriction, _options);
+        }
+    };
+    compile(_restrictions->get_non_pk_restriction());
+    if (!_skip_pk_restrictions) {
+        compile(_restrictions->get_single_column_partition_key_restrictions());
+    }
+    if (!_skip_ck_restrictions && !_restrictions->get_clustering_columns_restrictions()->is_multi_column()) {
+        compile(_restrictions->get_single_column_clustering_key_restrictions());
+    }
+}
+
+result_set_builder::restrictions_filter::column_predicate
+result_set_builder::restrictions_filter::column_predicate::compile(const restrictions::single_column_restriction& r, const query_options& options) {
+    column_predicate p;
+    p.restriction = &r;
+    auto& type = r.get_column_def().type;
+    if (type->is_counter()) {
+        // Left to the restriction, which refuses counters.
+        return p;
+    }
+    if (r.is_EQ()) {
+        auto value = r.value(options);
+        if (!value) {
+            p.op = kind::never;
+            return p;
+        }
+        p.op = kind::eq;
+        p.type = type;
+        p.byte_order_equal = type->is_byte_order_equal();
+        p.operands.push_back(std::move(*value));
+    } else if (r.is_IN()) {
+        p.op = kind::in;
+        p.type = type;
+        p.byte_order_equal = type->is_byte_order_equal();
+        for (auto&& value : r.values(options)) {
+            if (value) {
+                p.operands.push_back(std::move(*value));
+            }
+        }
+        if (p.byte_order_equal) {
+            std::sort(p.operands.begin(), p.operands.end(), [] (const bytes& a, const bytes& b) {
+                return compare_unsigned(a, b) < 0;
+            });
+        }
+    } else if (r.is_slice()) {
+        p.op = kind::slice;
+        p.type = type->underlying_type();
+        p.byte_order_comparable = p.type->is_byte_order_comparable();
+        // A bound bound to null doesn't restrict, like in to_range().
+        if (r.has_bound(statements::bound::START)) {
+            p.start = r.bounds(statements::bound::START, options)[0];
+            p.start_inclusive = r.is_inclusive(statements::bound::START);
+        }
+        if (r.has_bound(statements::bound::END)) {
+            p.end = r.bounds(statements::bound::END, options)[0];
+            p.end_inclusive = r.is_inclusive(statements::bound::END);
+        }
+    }
+    return p;
+}
+
+bool result_set_builder::restrictions_filter::column_predicate::matches(bytes_view data, const query_options& options) const {
+    switch (op) {
+    case kind::never:
+        return false;
+    case kind::eq:
+        return byte_order_equal ? data == bytes_view(operands[0]) : type->compare(operands[0], data) == 0;
+    case kind::in:
+        if (byte_order_equal) {
+            return std::binary_search(operands.begin(), operands.end(), data, [] (bytes_view a, bytes_view b) {
+                return compare_unsigned(a, b) < 0;
+            });
+        }
+        return boost::algorithm::any_of(operands, [&] (const bytes& operand) {
+            return type->compare(operand, data) == 0;
+        });
+    case kind::slice: {
+        auto compare = [this] (bytes_view a, bytes_view b) {
+            return byte_order_comparable ? compare_unsigned(a, b) : type->compare(a, b);
+        };
+        if (start) {
+            auto c = compare(data, *start);
+            if (c < 0 || (c == 0 && !start_inclusive)) {
+                return false;
+            }
+        }
+        if (end) {
+            auto c = compare(data, *end);
+            if (c > 0 || (c == 0 && !end_inclusive)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    case kind::generic:
+        break;
+    }
+    return restriction->is_satisfied_by(data, options);
+}
 
 bool result_set_builder::restrictions_filter::do_filter(const selection& selection,
                                                          const std::vector<bytes>& partition_key,
@@ -425,7 +547,9 @@ bool result_set_builder::restrictions_filter::do_filter(const selection& selecti
 
     auto static_row_iterator = static_row.iterator();
     auto row_iterator = row ? std::optional<query::result_row_view::iterator_type>(row->iterator()) : std::nullopt;
-    auto non_pk_restrictions_map = _restrictions->get_non_pk_restriction();
+    auto predicate_of = [] (const column_predicates& predicates, const column_definition& cdef) -> const column_predicate* {
+        return cdef.id < predicates.size() && predicates[cdef.id] ? &*predicates[cdef.id] : nullptr;
+    };
     for (auto&& cdef : selection.get_columns()) {
         switch (cdef->kind) {
         case column_kind::static_column:
@@ -444,18 +568,17 @@ bool result_set_builder::restrictions_filter::do_filter(const selection& selecti
                     result_view_opt = cell->value();
                 }
             }
-            auto restr_it = non_pk_restrictions_map.find(cdef);
-            if (restr_it == non_pk_restrictions_map.end()) {
+            auto predicate = predicate_of(cdef->kind == column_kind::static_column ? _static_predicates : _regular_predicates, *cdef);
+            if (!predicate) {
                 continue;
             }
-            restrictions::single_column_restriction& restriction = *restr_it->second;
             bool regular_restriction_matches;
             if (result_view_opt) {
-                regular_restriction_matches = result_view_opt->with_linearized([&restriction, this](bytes_view data) {
-                    return restriction.is_satisfied_by(data, _options);
+                regular_restriction_matches = result_view_opt->with_linearized([predicate, this](bytes_view data) {
+                    return predicate->matches(data, _options);
                 });
             } else {
-                regular_restriction_matches = restriction.is_satisfied_by(bytes(), _options);
+                regular_restriction_matches = predicate->matches(bytes_view(), _options);
             }
             if (!regular_restriction_matches) {
                 _current_static_row_does_not_match = (cdef->kind == column_kind::static_column);
@@ -467,14 +590,12 @@ bool result_set_builder::restrictions_filter::do_filter(const selection& selecti
             if (_skip_pk_restrictions) {
                 continue;
             }
-            auto partition_key_restrictions_map = _restrictions->get_single_column_partition_key_restrictions();
-            auto restr_it = partition_key_restrictions_map.find(cdef);
-            if (restr_it == partition_key_restrictions_map.end()) {
+            auto predicate = predicate_of(_partition_key_predicates, *cdef);
+            if (!predicate) {
                 continue;
             }
-            restrictions::single_column_restriction& restriction = *restr_it->second;
             const bytes& value_to_check = partition_key[cdef->id];
-            bool pk_restriction_matches = restriction.is_satisfied_by(value_to_check, _options);
+            bool pk_restriction_matches = predicate->matches(value_to_check, _options);
             if (!pk_restriction_matches) {
                 _current_partition_key_does_not_match = true;
                 return false;
@@ -485,17 +606,15 @@ bool result_set_builder::restrictions_filter::do_filter(const selection& selecti
             if (_skip_ck_restrictions) {
                 continue;
             }
-            auto clustering_key_restrictions_map = _restrictions->get_single_column_clustering_key_restrictions();
-            auto restr_it = clustering_key_restrictions_map.find(cdef);
-            if (restr_it == clustering_key_restrictions_map.end()) {
+            auto predicate = predicate_of(_clustering_key_predicates, *cdef);
+            if (!predicate) {
                 continue;
             }
             if (clustering_key.empty()) {
                 return false;
             }
-            restrictions::single_column_restriction& restriction = *restr_it->second;
             const bytes& value_to_check = clustering_key[cdef->id];
-            bool pk_restriction_matches = restriction.is_satisfied_by(value_to_check, _options);
+            bool pk_restriction_matches = predicate->matches(value_to_check, _options);
             if (!pk_restriction_matches) {
                 return false;
             }
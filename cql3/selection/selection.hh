@@ -58,6 +58,7 @@ class query_options;
 
 namespace restrictions {
 class statement_restrictions;
+class single_column_restriction;
 }
 
 namespace selection {
@@ -217,6 +218,23 @@ class selection {
 
     virtual bool is_aggregate() const = 0;
 
+    /**
+     * Checks if every selected value is computed by aggregating the rows, so
+     * that the result doesn't depend on the order in which they are visited.
+     */
+    virtual bool contains_only_aggregate_functions() const {
+        return false;
+    }
+
+    /**
+     * Describes the selected values for partial aggregation on the replicas,
+     * if the selection aggregates and each value is a plain column or a
+     * reducible aggregate function of plain columns.
+     */
+    virtual std::optional<std::vector<query::aggregate_call>> get_aggregate_calls() const {
+        return std::nullopt;
+    }
+
     /**
      * Checks that selectors are either all aggregates or that none of them is.
      *
@@ -284,6 +302,34 @@ class result_set_builder {
         }
     };
     class restrictions_filter {
+        // A single column restriction compiled for evaluation on serialized
+        // values: the operands are bound once per filter rather than once per
+        // row, and they are compared to the values as plain bytes when the
+        // type allows it. Restrictions without a compiled form are evaluated
+        // by the restriction itself.
+        struct column_predicate {
+            enum class kind : uint8_t { never, eq, in, slice, generic };
+            kind op = kind::generic;
+            const restrictions::single_column_restriction* restriction = nullptr;
+            data_type type;
+            // Equal values have equal representations (eq and in).
+            bool byte_order_equal = false;
+            // Values are ordered like their representations (slice).
+            bool byte_order_comparable = false;
+            // eq: the value; in: the values, sorted by compare_unsigned()
+            // when byte_order_equal.
+            std::vector<bytes> operands;
+            std::optional<bytes> start;
+            bool start_inclusive = false;
+            std::optional<bytes> end;
+            bool end_inclusive = false;
+
+            static column_predicate compile(const restrictions::single_column_restriction& r, const query_options& options);
+            bool matches(bytes_view data, const query_options& options) const;
+        };
+        // Indexed by column id, one vector per column kind.
+        using column_predicates = std::vector<std::optional<column_predicate>>;
+
         ::shared_ptr<restrictions::statement_restrictions> _restrictions;
         const query_options& _options;
         const bool _skip_pk_restrictions;
@@ -298,6 +344,10 @@ class result_set_builder {
         mutable uint32_t _rows_fetched_for_last_partition;
         mutable std::optional<partition_key> _last_pkey;
         mutable bool _is_first_partition_on_page = true;
+        column_predicates _partition_key_predicates;
+        column_predicates _clustering_key_predicates;
+        column_predicates _static_predicates;
+        column_predicates _regular_predicates;
     public:
         explicit restrictions_filter(::shared_ptr<restrictions::statement_restrictions> restrictions,
                 const query_options& options,
@@ -323,6 +373,10 @@ class result_set_builder {
     void add_collection(const column_definition& def, bytes_view c);
     void new_row();
     std::unique_ptr<result_set> build();
+    // Whether any row has been fed to the builder.
+    bool has_input() const {
+        return bool(current);
+    }
     api::timestamp_type timestamp_of(size_t idx);
     int32_t ttl_of(size_t idx);
 
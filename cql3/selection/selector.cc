@@ -21,6 +21,7 @@
 
 #include "selector.hh"
 #include "cql3/column_identifier.hh"
+#include "query-request.hh"
 
 namespace cql3 {
 
@@ -34,6 +35,11 @@ selector::factory::get_column_specification(const schema& schema) const {
         get_return_type());
 }
 
+std::optional<query::aggregate_call>
+selector::factory::to_aggregate_call() const {
+    return std::nullopt;
+}
+
 bool selector::requires_thread() const { return false; }
 }
 
@@ -42,11 +42,16 @@
 #pragma once
 
 #include <vector>
+#include <optional>
 #include "cql3/assignment_testable.hh"
 #include "types.hh"
 #include "schema_fwd.hh"
 #include "counters.hh"
 
+namespace query {
+struct aggregate_call;
+}
+
 namespace cql3 {
 
 namespace selection {
@@ -195,6 +200,14 @@ class selector::factory {
      * @return the selector output type
      */
     virtual data_type get_return_type() const = 0;
+
+    /**
+     * Describes the selectors created by this factory for partial aggregation on the replicas,
+     * if they are a plain column or a reducible aggregate function of plain columns.
+     *
+     * @return the call computing the selector output, or an empty optional
+     */
+    virtual std::optional<query::aggregate_call> to_aggregate_call() const;
 };
 
 }
@@ -43,6 +43,7 @@
 #include "cql3/selection/simple_selector.hh"
 #include "cql3/selection/selectable.hh"
 #include "cql3/query_options.hh"
+#include "query-request.hh"
 
 namespace cql3 {
 
@@ -92,6 +93,22 @@ std::vector<::shared_ptr<selector>> selector_factories::new_instances() const {
     return r;
 }
 
+std::optional<std::vector<query::aggregate_call>> selector_factories::to_aggregate_calls() const {
+    if (!does_aggregation()) {
+        return std::nullopt;
+    }
+    std::vector<query::aggregate_call> calls;
+    calls.reserve(_factories.size());
+    for (auto&& f : _factories) {
+        auto call = f->to_aggregate_call();
+        if (!call) {
+            return std::nullopt;
+        }
+        calls.push_back(std::move(*call));
+    }
+    return calls;
+}
+
 std::vector<sstring> selector_factories::get_column_names() const {
     std::vector<sstring> r;
     r.reserve(_factories.size());
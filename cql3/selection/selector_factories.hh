@@ -170,6 +170,14 @@ class selector_factories {
      * @return a list of column names
      */
     std::vector<sstring> get_column_names() const;
+
+    /**
+     * Describes the selectors for partial aggregation on the replicas, if they do
+     * aggregation and each is a plain column or a reducible aggregate function of plain columns.
+     *
+     * @return the calls computing the output of each selector, or an empty optional
+     */
+    std::optional<std::vector<query::aggregate_call>> to_aggregate_calls() const;
 };
 
 }
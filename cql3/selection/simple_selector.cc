@@ -40,6 +40,7 @@
  */
 
 #include "cql3/selection/simple_selector.hh"
+#include "query-request.hh"
 
 namespace cql3 {
 
@@ -50,6 +51,11 @@ simple_selector_factory::new_instance() const {
     return ::make_shared<simple_selector>(_column_name, _idx, _type);
 }
 
+std::optional<query::aggregate_call>
+simple_selector_factory::to_aggregate_call() const {
+    return query::aggregate_call{sstring(), sstring(), {}, {_idx}};
+}
+
 }
 
 }
@@ -69,6 +69,8 @@ class simple_selector_factory : public selector::factory {
     }
 
     virtual ::shared_ptr<selector> new_instance() const override;
+
+    virtual std::optional<query::aggregate_call> to_aggregate_call() const override;
 };
 
 class simple_selector : public selector {
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cql3/selection/term_selector.hh"
+#include "cql3/query_options.hh"
+#include "exceptions/exceptions.hh"
+#include "query-request.hh"
+
+namespace cql3 {
+
+namespace selection {
+
+static exceptions::invalid_request_exception untyped_literal(const term::raw& raw) {
+    return exceptions::invalid_request_exception(
+            format("Cannot infer the type of {} in the selection clause; literals may only be passed to functions", raw.to_string()));
+}
+
+void
+term_selector_factory::bind(database& db, const sstring& keyspace, ::shared_ptr<column_specification> receiver) {
+    auto prepared = _raw->prepare(db, keyspace, receiver);
+    _value = to_bytes_opt(prepared->bind_and_get(query_options::DEFAULT));
+    _type = receiver->type;
+}
+
+data_type
+term_selector_factory::get_return_type() const {
+    if (!_type) {
+        throw untyped_literal(*_raw);
+    }
+    return _type;
+}
+
+::shared_ptr<selector>
+term_selector_factory::new_instance() const {
+    return ::make_shared<term_selector>(_raw, _type, _value);
+}
+
+std::optional<query::aggregate_call>
+term_selector_factory::to_aggregate_call() const {
+    if (!_type) {
+        return std::nullopt;
+    }
+    return query::aggregate_call{sstring(), sstring(), {}, {0}, {_value}};
+}
+
+data_type
+term_selector::get_type() const {
+    if (!_type) {
+        throw untyped_literal(*_raw);
+    }
+    return _type;
+}
+
+}
+
+}
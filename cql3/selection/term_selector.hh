@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "cql3/selection/selector.hh"
+#include "cql3/term.hh"
+
+namespace cql3 {
+
+namespace selection {
+
+/**
+ * Creates selectors yielding a literal from the selection clause, e.g. the
+ * percentile in <code>approx_percentile(v, 0.5)</code>. A literal has no type
+ * of its own: it takes the type of the function parameter it is passed to,
+ * once the function is resolved, see <code>bind()</code>.
+ */
+class term_selector_factory : public selector::factory {
+    ::shared_ptr<term::raw> _raw;
+    data_type _type;
+    bytes_opt _value;
+public:
+    explicit term_selector_factory(::shared_ptr<term::raw> raw)
+        : _raw(std::move(raw))
+    { }
+
+    /**
+     * Gives the literal the type of the specified receiver and computes its value.
+     */
+    void bind(database& db, const sstring& keyspace, ::shared_ptr<column_specification> receiver);
+
+    virtual sstring column_name() const override {
+        return _raw->to_string();
+    }
+
+    virtual data_type get_return_type() const override;
+
+    virtual ::shared_ptr<selector> new_instance() const override;
+
+    virtual std::optional<query::aggregate_call> to_aggregate_call() const override;
+};
+
+class term_selector : public selector {
+    ::shared_ptr<term::raw> _raw;
+    data_type _type;
+    bytes_opt _value;
+public:
+    term_selector(::shared_ptr<term::raw> raw, data_type type, bytes_opt value)
+        : _raw(std::move(raw))
+        , _type(std::move(type))
+        , _value(std::move(value))
+    { }
+
+    virtual void add_input(cql_serialization_format sf, result_set_builder& rs) override {
+    }
+
+    virtual bytes_opt get_output(cql_serialization_format sf) override {
+        return _value;
+    }
+
+    virtual void reset() override {
+    }
+
+    virtual data_type get_type() const override;
+
+    virtual assignment_testable::test_result test_assignment(database& db, const sstring& keyspace, ::shared_ptr<column_specification> receiver) const override {
+        return _raw->test_assignment(db, keyspace, std::move(receiver));
+    }
+
+    virtual sstring assignment_testable_source_context() const override {
+        return _raw->to_string();
+    }
+};
+
+}
+
+}
@@ -185,18 +185,44 @@ const std::vector<batch_statement::single_statement>& batch_statement::get_state
 
 future<std::vector<mutation>> batch_statement::get_mutations(service::storage_proxy& storage, const query_options& options,
         db::timeout_clock::time_point timeout, bool local, api::timestamp_type now, service::query_state& query_state) const {
-    // Do not process in parallel because operations like list append/prepend depend on execution order.
     using mutation_set_type = std::unordered_set<mutation, mutation_hash_by_key, mutation_equals_by_key>;
-    return do_with(mutation_set_type(), [this, &storage, &options, timeout, now, local, &query_state] (auto& result) mutable {
+    std::vector<modification_statement::json_cache_opt> json_caches;
+    std::vector<std::vector<partition_key>> key_values;
+    json_caches.reserve(_statements.size());
+    key_values.reserve(_statements.size());
+    for (size_t i = 0; i < _statements.size(); ++i) {
+        auto&& statement_options = options.for_statement(i);
+        json_caches.push_back(_statements[i].statement->maybe_prepare_json_cache(statement_options));
+        key_values.push_back(_statements[i].statement->build_partition_key_values(statement_options, json_caches.back()));
+    }
+    // The statements of a batch mostly write to the same table, so the tokens
+    // of the keys of each run of statements on one table are computed together.
+    std::vector<dht::partition_range_vector> keys(_statements.size());
+    for (size_t begin = 0, end; begin < _statements.size(); begin = end) {
+        const schema& s = *_statements[begin].statement->s;
+        std::vector<partition_key_view> views;
+        for (end = begin; end < _statements.size() && _statements[end].statement->s.get() == &s; ++end) {
+            views.insert(views.end(), key_values[end].begin(), key_values[end].end());
+        }
+        auto tokens = dht::get_tokens(s, views);
+        auto token = tokens.begin();
+        for (size_t i = begin; i < end; ++i) {
+            keys[i] = modification_statement::decorate_partition_keys(std::move(key_values[i]), token);
+        }
+    }
+    // Do not process in parallel because operations like list append/prepend depend on execution order.
+    return do_with(mutation_set_type(), std::move(keys), std::move(json_caches), [this, &storage, &options, timeout, now, local, &query_state]
+            (auto& result, std::vector<dht::partition_range_vector>& keys, std::vector<modification_statement::json_cache_opt>& json_caches) mutable {
         result.reserve(_statements.size());
         return do_for_each(boost::make_counting_iterator<size_t>(0),
                            boost::make_counting_iterator<size_t>(_statements.size()),
-                           [this, &storage, &options, now, local, &result, timeout, &query_state] (size_t i) {
+                           [this, &storage, &options, now, local, &result, timeout, &query_state, &keys, &json_caches] (size_t i) {
             auto&& statement = _statements[i].statement;
             statement->inc_cql_stats(query_state.get_client_state().is_internal());
             auto&& statement_options = options.for_statement(i);
             auto timestamp = _attrs->get_timestamp(now, statement_options);
-            return statement->get_mutations(storage, statement_options, timeout, local, timestamp, query_state).then([&result] (auto&& more) {
+            return statement->get_mutations(storage, statement_options, timeout, local, timestamp, query_state,
+                    std::move(keys[i]), std::move(json_caches[i])).then([&result] (auto&& more) {
                 for (auto&& m : more) {
                     // We want unordered_set::try_emplace(), but we don't have it
                     auto pos = result.find(m);
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "cql3/statements/create_aggregate_statement.hh"
+#include "cql3/functions/functions.hh"
+#include "cql3/query_options.hh"
+#include "prepared_statement.hh"
+#include "service/migration_manager.hh"
+#include "service/storage_proxy.hh"
+#include "gms/feature_service.hh"
+#include "database.hh"
+
+namespace cql3 {
+
+namespace statements {
+
+bytes_opt create_aggregate_statement::prepare_initcond(database& db, const sstring& keyspace, const term::raw& ival,
+        data_type state_type) {
+    auto receiver = ::make_shared<column_specification>(keyspace, "", ::make_shared<column_identifier>("initcond", true),
+            std::move(state_type));
+    auto value = ival.prepare(db, keyspace, receiver)->bind_and_get(query_options::DEFAULT);
+    if (value.is_unset_value()) {
+        throw exceptions::invalid_request_exception("INITCOND must not be unset");
+    }
+    return to_bytes_opt(value);
+}
+
+void create_aggregate_statement::create(service::storage_proxy& proxy, functions::function* old) const {
+    if (old && !dynamic_cast<functions::user_aggregate*>(old)) {
+        throw exceptions::invalid_request_exception(format("Cannot replace '{}' which is not a user defined aggregate", *old));
+    }
+    data_type state_type = prepare_type(proxy, *_stype);
+
+    std::vector<data_type> sfunc_arg_types{state_type};
+    sfunc_arg_types.insert(sfunc_arg_types.end(), _arg_types.begin(), _arg_types.end());
+    functions::function_name sfunc_name(_name.keyspace, _sfunc);
+    auto sfunc = dynamic_pointer_cast<functions::user_function>(functions::functions::find(sfunc_name, sfunc_arg_types));
+    if (!sfunc) {
+        throw exceptions::invalid_request_exception(format("State function {}({}) doesn't exist", sfunc_name, sfunc_arg_types));
+    }
+    if (sfunc->return_type() != state_type) {
+        throw exceptions::invalid_request_exception(format("State function {} must return {}, not {}",
+                sfunc_name, state_type->as_cql3_type().to_string(), sfunc->return_type()->as_cql3_type().to_string()));
+    }
+
+    shared_ptr<functions::user_function> reducefunc;
+    if (_rfunc) {
+        // The reduce function is kept in a table older nodes don't know.
+        if (!proxy.features().cluster_supports_parallelized_aggregation()) {
+            throw exceptions::invalid_request_exception("REDUCEFUNC is not supported until all nodes are upgraded");
+        }
+        functions::function_name rfunc_name(_name.keyspace, *_rfunc);
+        reducefunc = dynamic_pointer_cast<functions::user_function>(functions::functions::find(rfunc_name, {state_type, state_type}));
+        if (!reducefunc) {
+            throw exceptions::invalid_request_exception(format("Reduce function {}({}, {}) doesn't exist", rfunc_name,
+                    state_type->as_cql3_type().to_string(), state_type->as_cql3_type().to_string()));
+        }
+        if (reducefunc->return_type() != state_type) {
+            throw exceptions::invalid_request_exception(format("Reduce function {} must return {}, not {}",
+                    rfunc_name, state_type->as_cql3_type().to_string(), reducefunc->return_type()->as_cql3_type().to_string()));
+        }
+    }
+
+    shared_ptr<functions::user_function> finalfunc;
+    if (_ffunc) {
+        functions::function_name ffunc_name(_name.keyspace, *_ffunc);
+        finalfunc = dynamic_pointer_cast<functions::user_function>(functions::functions::find(ffunc_name, {state_type}));
+        if (!finalfunc) {
+            throw exceptions::invalid_request_exception(format("Final function {}({}) doesn't exist",
+                    ffunc_name, state_type->as_cql3_type().to_string()));
+        }
+    }
+
+    bytes_opt initcond;
+    std::optional<sstring> initcond_cql;
+    if (_ival) {
+        initcond = prepare_initcond(proxy.get_db().local(), _name.keyspace, *_ival, state_type);
+        initcond_cql = _ival->to_string();
+    }
+
+    _aggregate = ::make_shared<functions::user_aggregate>(_name, std::move(initcond), std::move(initcond_cql),
+            std::move(sfunc), std::move(reducefunc), std::move(finalfunc));
+}
+
+std::unique_ptr<prepared_statement> create_aggregate_statement::prepare(database& db, cql_stats& stats) {
+    return std::make_unique<prepared_statement>(make_shared<create_aggregate_statement>(*this));
+}
+
+future<shared_ptr<cql_transport::event::schema_change>> create_aggregate_statement::announce_migration(
+        service::storage_proxy& proxy, bool is_local_only) const {
+    if (!_aggregate) {
+        return make_ready_future<::shared_ptr<cql_transport::event::schema_change>>();
+    }
+    return service::get_local_migration_manager().announce_new_aggregate(_aggregate, is_local_only).then([this] {
+        return create_schema_change(*_aggregate, true);
+    });
+}
+
+create_aggregate_statement::create_aggregate_statement(functions::function_name name,
+        std::vector<shared_ptr<cql3_type::raw>> arg_types, sstring sfunc, shared_ptr<cql3_type::raw> stype,
+        std::optional<sstring> rfunc, std::optional<sstring> ffunc, ::shared_ptr<term::raw> ival, bool or_replace, bool if_not_exists)
+    : create_function_statement_base(std::move(name), std::move(arg_types), or_replace, if_not_exists),
+      _sfunc(std::move(sfunc)), _stype(std::move(stype)), _rfunc(std::move(rfunc)), _ffunc(std::move(ffunc)), _ival(std::move(ival)) {}
+}
+}
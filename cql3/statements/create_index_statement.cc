@@ -62,12 +62,14 @@ create_index_statement::create_index_statement(::shared_ptr<cf_name> name,
                                                ::shared_ptr<index_name> index_name,
                                                std::vector<::shared_ptr<index_target::raw>> raw_targets,
                                                ::shared_ptr<index_prop_defs> properties,
-                                               bool if_not_exists)
+                                               bool if_not_exists,
+                                               std::vector<::shared_ptr<column_identifier::raw>> raw_included_columns)
     : schema_altering_statement(name)
     , _index_name(index_name->get_idx())
     , _raw_targets(raw_targets)
     , _properties(properties)
     , _if_not_exists(if_not_exists)
+    , _raw_included_columns(std::move(raw_included_columns))
 {
 }
 
@@ -165,6 +167,8 @@ create_index_statement::validate(service::storage_proxy& proxy, const service::c
         }
     }
 
+    validate_included_columns(*schema, targets);
+
     if (db.existing_index_names(keyspace()).count(_index_name) > 0) {
         if (_if_not_exists) {
             return;
@@ -270,6 +274,35 @@ void create_index_statement::validate_targets_for_multi_column_index(std::vector
     }
 }
 
+void create_index_statement::validate_included_columns(const schema& schema, const std::vector<::shared_ptr<index_target>>& targets) const
+{
+    if (_raw_included_columns.empty()) {
+        return;
+    }
+    if (_properties->is_custom) {
+        throw exceptions::invalid_request_exception("CUSTOM indexes cannot include columns");
+    }
+    std::unordered_set<sstring> columns;
+    for (auto& raw_column : _raw_included_columns) {
+        auto column = raw_column->prepare_column_identifier(schema);
+        auto cd = schema.get_column_definition(column->name());
+        if (!cd) {
+            throw exceptions::invalid_request_exception(format("No column definition found for included column {}", column->to_string()));
+        }
+        if (!cd->is_regular()) {
+            throw exceptions::invalid_request_exception(format("Cannot include column {} in index: only regular columns can be included", column->to_string()));
+        }
+        for (auto& target : targets) {
+            if (target->as_string() == cd->name_as_text()) {
+                throw exceptions::invalid_request_exception(format("Cannot include indexed column {} in index", column->to_string()));
+            }
+        }
+        if (!columns.emplace(cd->name_as_text()).second) {
+            throw exceptions::invalid_request_exception(format("Duplicate included column {}", column->to_string()));
+        }
+    }
+}
+
 future<::shared_ptr<cql_transport::event::schema_change>>
 create_index_statement::announce_migration(service::storage_proxy& proxy, bool is_local_only) const {
     if (!proxy.features().cluster_supports_indexes()) {
@@ -299,6 +332,13 @@ create_index_statement::announce_migration(service::storage_proxy& proxy, bool i
     } else {
         kind = schema->is_compound() ? index_metadata_kind::composites : index_metadata_kind::keys;
     }
+    if (!_raw_included_columns.empty()) {
+        auto included_columns = boost::copy_range<std::vector<::shared_ptr<column_identifier>>>(_raw_included_columns
+                | boost::adaptors::transformed([&schema] (const ::shared_ptr<column_identifier::raw>& raw_column) {
+            return raw_column->prepare_column_identifier(*schema);
+        }));
+        index_options.emplace(index_target::included_columns_option_name, secondary_index::target_parser::serialize_included_columns(included_columns));
+    }
     auto index = make_index_metadata(targets, accepted_name, kind, index_options);
     auto existing_index = schema->find_index_noname(index);
     if (existing_index) {
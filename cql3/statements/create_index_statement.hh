@@ -70,12 +70,14 @@ class create_index_statement : public schema_altering_statement {
     const std::vector<::shared_ptr<index_target::raw>> _raw_targets;
     const ::shared_ptr<index_prop_defs> _properties;
     const bool _if_not_exists;
+    const std::vector<::shared_ptr<column_identifier::raw>> _raw_included_columns;
     cql_stats* _cql_stats = nullptr;
 
 public:
     create_index_statement(::shared_ptr<cf_name> name, ::shared_ptr<index_name> index_name,
             std::vector<::shared_ptr<index_target::raw>> raw_targets,
-            ::shared_ptr<index_prop_defs> properties, bool if_not_exists);
+            ::shared_ptr<index_prop_defs> properties, bool if_not_exists,
+            std::vector<::shared_ptr<column_identifier::raw>> raw_included_columns = {});
 
     future<> check_access(service::storage_proxy& proxy, const service::client_state& state) const override;
     void validate(service::storage_proxy&, const service::client_state& state) const override;
@@ -90,6 +92,7 @@ class create_index_statement : public schema_altering_statement {
                                                                   const index_target& target) const;
     void validate_target_column_is_map_if_index_involves_keys(bool is_map, const index_target& target) const;
     void validate_targets_for_multi_column_index(std::vector<::shared_ptr<index_target>> targets) const;
+    void validate_included_columns(const schema& schema, const std::vector<::shared_ptr<index_target>>& targets) const;
     static index_metadata make_index_metadata(const std::vector<::shared_ptr<index_target>>& targets,
                                               const sstring& name,
                                               index_metadata_kind kind,
@@ -41,6 +41,10 @@ future<shared_ptr<cql_transport::event::schema_change>> drop_function_statement:
     if (!user_func) {
         throw exceptions::invalid_request_exception(format("'{}' is not a user defined function", _func));
     }
+    if (auto aggregate = functions::functions::used_by_user_aggregate(user_func->name(), user_func->arg_types())) {
+        throw exceptions::invalid_request_exception(format("Cannot drop user function '{}' because it is used by aggregate '{}'",
+                *user_func, aggregate->name()));
+    }
     return service::get_local_migration_manager().announce_function_drop(user_func, is_local_only).then([this] {
         return create_schema_change(*_func, false);
     });
@@ -52,6 +52,7 @@ using db::index::secondary_index;
 
 const sstring index_target::target_option_name = "target";
 const sstring index_target::custom_index_option_name = "class_name";
+const sstring index_target::included_columns_option_name = "included_columns";
 
 sstring index_target::as_string() const {
     struct as_string_visitor {
@@ -44,6 +44,7 @@
 #include "cql3/statements/raw/modification_statement.hh"
 #include "cql3/statements/prepared_statement.hh"
 #include "cql3/restrictions/single_column_restriction.hh"
+#include "cql3/restrictions/single_column_primary_key_restrictions.hh"
 #include "validation.hh"
 #include "db/consistency_level_validations.hh"
 #include <seastar/core/shared_ptr.hh>
@@ -156,9 +157,15 @@ future<> modification_statement::check_access(service::storage_proxy& proxy, con
 
 future<std::vector<mutation>>
 modification_statement::get_mutations(service::storage_proxy& proxy, const query_options& options, db::timeout_clock::time_point timeout, bool local, int64_t now, service::query_state& qs) const {
-    auto cl = options.get_consistency();
     auto json_cache = maybe_prepare_json_cache(options);
     auto keys = build_partition_keys(options, json_cache);
+    return get_mutations(proxy, options, timeout, local, now, qs, std::move(keys), std::move(json_cache));
+}
+
+future<std::vector<mutation>>
+modification_statement::get_mutations(service::storage_proxy& proxy, const query_options& options, db::timeout_clock::time_point timeout, bool local, int64_t now, service::query_state& qs,
+        dht::partition_range_vector keys, json_cache_opt json_cache) const {
+    auto cl = options.get_consistency();
     auto ranges = create_clustering_ranges(options, json_cache);
     auto f = make_ready_future<update_parameters::prefetch_data>(s);
 
@@ -237,7 +244,7 @@ std::vector<mutation> modification_statement::apply_updates(
     mutations.reserve(keys.size());
     for (auto key : keys) {
         // We know key.start() must be defined since we only allow EQ relations on the partition key.
-        mutations.emplace_back(s, std::move(*key.start()->value().key()));
+        mutations.emplace_back(s, key.start()->value().as_decorated_key());
         auto& m = mutations.back();
         for (auto&& r : ranges) {
             this->add_update_for_key(m, r, params, json_cache);
@@ -262,15 +269,41 @@ modification_statement::create_clustering_ranges(const query_options& options, c
     return _restrictions->get_clustering_bounds(options);
 }
 
-dht::partition_range_vector
-modification_statement::build_partition_keys(const query_options& options, const json_cache_opt& json_cache) const {
-    auto keys = _restrictions->get_partition_key_restrictions()->bounds_ranges(options);
+std::vector<partition_key>
+modification_statement::build_partition_key_values(const query_options& options, const json_cache_opt& json_cache) const {
+    auto pk_restrictions = _restrictions->get_partition_key_restrictions();
+    std::vector<partition_key> keys;
+    if (auto single_column = dynamic_pointer_cast<cql3::restrictions::single_column_partition_key_restrictions>(pk_restrictions)) {
+        keys = single_column->singular_keys(options);
+    } else {
+        for (auto&& r : pk_restrictions->bounds_ranges(options)) {
+            keys.push_back(*r.start()->value().key());
+        }
+    }
     for (auto const& k : keys) {
-        validation::validate_cql_key(s, *k.start()->value().key());
+        validation::validate_cql_key(s, k);
     }
     return keys;
 }
 
+dht::partition_range_vector
+modification_statement::build_partition_keys(const query_options& options, const json_cache_opt& json_cache) const {
+    auto keys = build_partition_key_values(options, json_cache);
+    auto tokens = dht::get_tokens(*s, std::vector<partition_key_view>(keys.begin(), keys.end()));
+    auto token = tokens.begin();
+    return decorate_partition_keys(std::move(keys), token);
+}
+
+dht::partition_range_vector
+modification_statement::decorate_partition_keys(std::vector<partition_key> keys, std::vector<dht::token>::iterator& tokens) {
+    dht::partition_range_vector ranges;
+    ranges.reserve(keys.size());
+    for (auto& key : keys) {
+        ranges.emplace_back(dht::partition_range::make_singular(query::ring_position(std::move(*tokens++), std::move(key))));
+    }
+    return ranges;
+}
+
 struct modification_statement_executor {
     static auto get() { return &modification_statement::do_execute; }
 };
@@ -212,7 +212,13 @@ class modification_statement : public cql_statement_opt_metadata {
             const column_set& mask, bool is_applied,
             const update_parameters::prefetch_data& rows);
 public:
-    virtual dht::partition_range_vector build_partition_keys(const query_options& options, const json_cache_opt& json_cache) const;
+    // The validated partition keys the statement applies to, before their
+    // tokens are computed.
+    virtual std::vector<partition_key> build_partition_key_values(const query_options& options, const json_cache_opt& json_cache) const;
+    dht::partition_range_vector build_partition_keys(const query_options& options, const json_cache_opt& json_cache) const;
+    // Pairs each of keys with the token at `tokens`, advancing it, so that
+    // the tokens of many keys can be computed together.
+    static dht::partition_range_vector decorate_partition_keys(std::vector<partition_key> keys, std::vector<dht::token>::iterator& tokens);
     virtual query::clustering_row_ranges create_clustering_ranges(const query_options& options, const json_cache_opt& json_cache) const;
 
 private:
@@ -294,6 +300,9 @@ class modification_statement : public cql_statement_opt_metadata {
      * @throws invalid_request_exception on invalid requests
      */
     future<std::vector<mutation>> get_mutations(service::storage_proxy& proxy, const query_options& options, db::timeout_clock::time_point timeout, bool local, int64_t now, service::query_state& qs) const;
+    // As above, for keys and a json cache the caller has already built.
+    future<std::vector<mutation>> get_mutations(service::storage_proxy& proxy, const query_options& options, db::timeout_clock::time_point timeout, bool local, int64_t now, service::query_state& qs,
+            dht::partition_range_vector keys, json_cache_opt json_cache) const;
 
     virtual json_cache_opt maybe_prepare_json_cache(const query_options& options) const;
 protected:
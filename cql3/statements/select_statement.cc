@@ -52,6 +52,7 @@
 #include "query-result-reader.hh"
 #include "query_result_merger.hh"
 #include "service/pager/query_pagers.hh"
+#include "service/forward_service.hh"
 #include <seastar/core/execution_stage.hh>
 #include "view_info.hh"
 #include "partition_slice_builder.hh"
@@ -60,6 +61,11 @@
 #include "db/consistency_level_validations.hh"
 #include "database.hh"
 #include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/algorithm/cxx11/all_of.hpp>
+#include <boost/algorithm/cxx11/none_of.hpp>
+#include <boost/range/algorithm_ext/erase.hpp>
+#include <boost/range/irange.hpp>
+#include <boost/range/adaptor/transformed.hpp>
 
 bool is_system_keyspace(const sstring& name);
 
@@ -321,6 +327,9 @@ select_statement::do_execute(service::storage_proxy& proxy,
 
     auto command = ::make_lw_shared<query::read_command>(_schema->id(), _schema->version(),
         make_partition_slice(options), limit, now, tracing::make_trace_info(state.get_trace_state()), query::max_partitions, utils::UUID(), options.get_timestamp(state));
+    if (restrictions_need_filtering && proxy.get_db().local().features().cluster_supports_replica_filtering()) {
+        command->slice.set_filters(make_replica_filters(command->slice, options));
+    }
 
     int32_t page_size = options.get_page_size();
 
@@ -358,6 +367,10 @@ select_statement::do_execute(service::storage_proxy& proxy,
     }
 
     command->slice.options.set<query::partition_slice::option::allow_short_read>();
+    if (can_parallelize_aggregate(proxy, options, restrictions_need_filtering, key_ranges)) {
+        return execute_parallel_aggregate(proxy, command, std::move(key_ranges), state, options, now, page_size);
+    }
+
     auto timeout_duration = options.get_timeout_config().*get_timeout_config_selector();
     auto p = service::pager::query_pagers::pager(_schema, _selection,
             state, options, command, std::move(key_ranges), _stats, restrictions_need_filtering ? _restrictions : nullptr);
@@ -427,6 +440,263 @@ select_statement::do_execute(service::storage_proxy& proxy,
             });
 }
 
+// Translates the restrictions on selected non-primary-key columns which a
+// replica can evaluate by itself into filters of the read command, so that
+// it sends back only the rows which may match. The restrictions are still
+// evaluated on the results, so anything not understood is simply left out.
+query::column_filters select_statement::make_replica_filters(const query::partition_slice& slice, const query_options& options) const {
+    auto make_filter = [&] (const column_definition& cdef, const restrictions::single_column_restriction& r) -> std::optional<query::column_filter> {
+        if (!cdef.is_atomic() || cdef.is_counter() || !(cdef.is_static() || cdef.is_regular())) {
+            return std::nullopt;
+        }
+        auto& selected = cdef.is_static() ? slice.static_columns : slice.regular_columns;
+        if (std::find(selected.begin(), selected.end(), cdef.id) == selected.end()) {
+            return std::nullopt;
+        }
+        query::column_filter f{cdef.is_static(), cdef.id, {}, nonwrapping_range<bytes>::make_open_ended_both_sides()};
+        if (r.is_EQ() || r.is_IN()) {
+            for (auto&& v : r.values(options)) {
+                if (!v) {
+                    return std::nullopt;
+                }
+                f.values.push_back(std::move(*v));
+            }
+            if (f.values.empty()) {
+                return std::nullopt;
+            }
+        } else if (r.is_slice()) {
+            std::optional<nonwrapping_range<bytes>::bound> bounds[2];
+            for (auto b : {statements::bound::START, statements::bound::END}) {
+                if (!r.has_bound(b)) {
+                    continue;
+                }
+                auto v = std::move(r.bounds(b, options).front());
+                if (!v) {
+                    return std::nullopt;
+                }
+                bounds[statements::get_idx(b)].emplace(std::move(*v), r.is_inclusive(b));
+            }
+            f.range = nonwrapping_range<bytes>(std::move(bounds[0]), std::move(bounds[1]));
+        } else {
+            return std::nullopt;
+        }
+        return f;
+    };
+
+    query::column_filters filters;
+    for (auto&& [cdef, r] : _restrictions->get_non_pk_restriction()) {
+        if (auto f = make_filter(*cdef, *r)) {
+            filters.push_back(std::move(*f));
+        }
+    }
+    // Each replica filters its own, possibly stale, version of a row. With a
+    // single restricted column, the replica holding the newest value returns
+    // the row if it matches and the digests mismatch whenever the replicas
+    // disagree. With several columns, replicas holding different parts of the
+    // row could all reject it, so unless a single replica is read, only one
+    // filter is sent.
+    auto cl = options.get_consistency();
+    if (filters.size() > 1 && cl != db::consistency_level::ONE && cl != db::consistency_level::LOCAL_ONE) {
+        filters.resize(1);
+    }
+    return filters;
+}
+
+bool select_statement::can_parallelize_aggregate(service::storage_proxy& proxy, const query_options& options,
+        bool restrictions_need_filtering, const dht::partition_range_vector& key_ranges) const {
+    // Scanning token ranges concurrently feeds the rows to the aggregates out
+    // of order, which is only invisible when all selected values are
+    // aggregates and there is no grouping. GROUP BY always covers the whole
+    // partition key, so groups never span ranges and each range can be
+    // aggregated on its own. Groups may still span pages of a range, which
+    // the range's builder, or its replica, sees in order and merges. In
+    // both cases no LIMIT may cut the rows short.
+    // Filtering is left to the sequential path, and so are scans of single
+    // partitions, which have nothing to split. So are user functions, unless
+    // they are reducible aggregates computed by the replicas, which run
+    // them in a thread.
+    return (has_group_by() || _selection->contains_only_aggregate_functions())
+            && !_limit && !_per_partition_limit
+            && !restrictions_need_filtering
+            && !options.get_paging_state()
+            && (!_selection->new_selectors()->requires_thread() || can_forward_aggregate(proxy))
+            && std::none_of(key_ranges.begin(), key_ranges.end(), [] (const dht::partition_range& r) {
+                return query::is_single_partition(r);
+            });
+}
+
+// When the whole cluster supports it and the selection can be described as
+// a forward_request, the replicas of the scanned ranges compute partial
+// aggregates, see service/forward_service.hh.
+//
+// Otherwise splits the scan of an aggregate query at vnode boundaries into up to
+// PARALLEL_AGGREGATE_CONCURRENCY groups of contiguous ranges, each paged
+// by its own pager, so the replicas of different parts of the ring work on it
+// at the same time. All pagers feed the same result_set_builder: without a
+// thread each page is consumed atomically, so the aggregates see whole rows.
+// With GROUP BY each pager has a builder of its own, and their rows are
+// concatenated in ring order.
+future<shared_ptr<cql_transport::messages::result_message>>
+select_statement::execute_parallel_aggregate(service::storage_proxy& proxy,
+        lw_shared_ptr<query::read_command> cmd, dht::partition_range_vector&& partition_ranges, service::query_state& state,
+        const query_options& options, gc_clock::time_point now, int32_t page_size) const {
+    if (can_forward_aggregate(proxy)) {
+        return execute_forwarded_aggregate(proxy, make_forward_request(*cmd, partition_ranges, options, page_size),
+                state, options, now);
+    }
+
+    auto& ks = proxy.get_db().local().find_keyspace(keyspace());
+    auto local = ks.get_replication_strategy().get_type() == locator::replication_strategy_type::local;
+    service::query_ranges_to_vnodes_generator ranges_to_vnodes(proxy.get_token_metadata(), _schema, std::move(partition_ranges), local);
+    dht::partition_range_vector vnodes;
+    while (!ranges_to_vnodes.empty()) {
+        auto ranges = ranges_to_vnodes(1024);
+        std::move(ranges.begin(), ranges.end(), std::back_inserter(vnodes));
+    }
+
+    auto groups = std::min(vnodes.size(), PARALLEL_AGGREGATE_CONCURRENCY);
+    std::vector<::shared_ptr<service::pager::query_pager>> pagers;
+    pagers.reserve(groups);
+    for (size_t i = 0; i < groups; ++i) {
+        auto begin = vnodes.begin() + i * vnodes.size() / groups;
+        auto end = vnodes.begin() + (i + 1) * vnodes.size() / groups;
+        pagers.push_back(service::pager::query_pagers::pager(_schema, _selection, state, options,
+                make_lw_shared<query::read_command>(*cmd), dht::partition_range_vector(begin, end), _stats));
+    }
+    ++_stats.select_parallelized_aggregates;
+
+    auto timeout_duration = options.get_timeout_config().*get_timeout_config_selector();
+    if (has_group_by()) {
+        return execute_parallel_group_by(std::move(pagers), options, now, page_size);
+    }
+    return do_with(
+            cql3::selection::result_set_builder(*_selection, now,
+                    options.get_cql_serialization_format(), *_group_by_cell_indices),
+            std::move(pagers),
+            [this, page_size, now, timeout_duration] (auto& builder, auto& pagers) {
+                return parallel_for_each(pagers, [&builder, page_size, now, timeout_duration] (auto& p) {
+                    return do_until([p] { return p->is_exhausted(); }, [p, &builder, page_size, now, timeout_duration] {
+                        auto timeout = db::timeout_clock::now() + timeout_duration;
+                        return p->fetch_page(builder, page_size, now, timeout);
+                    });
+                }).then([this, &builder] {
+                    auto rs = builder.build();
+                    update_stats_rows_read(rs->size());
+                    auto msg = ::make_shared<cql_transport::messages::result_message::rows>(result(std::move(rs)));
+                    return shared_ptr<cql_transport::messages::result_message>(std::move(msg));
+                });
+            });
+}
+
+future<shared_ptr<cql_transport::messages::result_message>>
+select_statement::execute_parallel_group_by(std::vector<::shared_ptr<service::pager::query_pager>> pagers,
+        const query_options& options, gc_clock::time_point now, int32_t page_size) const {
+    std::vector<cql3::selection::result_set_builder> builders;
+    builders.reserve(pagers.size());
+    for (size_t i = 0; i < pagers.size(); ++i) {
+        builders.emplace_back(*_selection, now, options.get_cql_serialization_format(), *_group_by_cell_indices);
+    }
+
+    auto timeout_duration = options.get_timeout_config().*get_timeout_config_selector();
+    return do_with(std::move(builders), std::move(pagers),
+            [this, page_size, now, timeout_duration] (auto& builders, auto& pagers) {
+                return parallel_for_each(boost::irange(size_t(0), pagers.size()), [&builders, &pagers, page_size, now, timeout_duration] (size_t i) {
+                    auto p = pagers[i];
+                    return do_until([p] { return p->is_exhausted(); }, [p, &builder = builders[i], page_size, now, timeout_duration] {
+                        auto timeout = db::timeout_clock::now() + timeout_duration;
+                        return p->fetch_page(builder, page_size, now, timeout);
+                    });
+                }).then([this, &builders] {
+                    // A builder which saw no rows still yields a row of
+                    // aggregates over nothing, which only the sequential path
+                    // would return, and only for an empty result.
+                    std::unique_ptr<cql3::result_set> rs;
+                    for (auto& builder : builders) {
+                        if (!builder.has_input()) {
+                            continue;
+                        }
+                        auto part = builder.build();
+                        if (!rs) {
+                            rs = std::move(part);
+                            continue;
+                        }
+                        for (auto& row : part->rows()) {
+                            rs->add_row(row);
+                        }
+                    }
+                    if (!rs) {
+                        rs = builders.front().build();
+                    }
+                    update_stats_rows_read(rs->size());
+                    auto msg = ::make_shared<cql_transport::messages::result_message::rows>(result(std::move(rs)));
+                    return shared_ptr<cql_transport::messages::result_message>(std::move(msg));
+                });
+            });
+}
+
+// Describes the query for partial aggregation on the replicas, if every
+// selected value is a plain column or a reducible aggregate of plain
+// columns. With GROUP BY, the coordinator orders the groups returned by
+// different replicas by the partition key, so the GROUP BY cells must start
+// with it.
+bool select_statement::can_forward_aggregate(service::storage_proxy& proxy) const {
+    if (!proxy.get_db().local().features().cluster_supports_parallelized_aggregation() || !_selection->get_aggregate_calls()) {
+        return false;
+    }
+    if (has_group_by()) {
+        auto& columns = _selection->get_columns();
+        if (_group_by_cell_indices->size() < _schema->partition_key_size()) {
+            return false;
+        }
+        for (size_t i = 0; i < _schema->partition_key_size(); ++i) {
+            auto def = columns[(*_group_by_cell_indices)[i]];
+            if (!def->is_partition_key() || def->id != i) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+query::forward_request
+select_statement::make_forward_request(const query::read_command& cmd, const dht::partition_range_vector& partition_ranges,
+        const query_options& options, int32_t page_size) const {
+    auto& columns = _selection->get_columns();
+    return query::forward_request{cmd, partition_ranges, options.get_consistency(), uint32_t(page_size),
+            boost::copy_range<std::vector<sstring>>(columns | boost::adaptors::transformed([] (const column_definition* def) {
+                return def->name_as_text();
+            })),
+            std::move(*_selection->get_aggregate_calls()),
+            boost::copy_range<std::vector<uint32_t>>(*_group_by_cell_indices)};
+}
+
+future<shared_ptr<cql_transport::messages::result_message>>
+select_statement::execute_forwarded_aggregate(service::storage_proxy& proxy, query::forward_request req,
+        service::query_state& state, const query_options& options, gc_clock::time_point now) const {
+    ++_stats.select_parallelized_aggregates;
+    auto timeout = db::timeout_clock::now() + options.get_timeout_config().*get_timeout_config_selector();
+    auto sf = options.get_cql_serialization_format();
+    return service::dispatch_forward_request(proxy, _schema, std::move(req), timeout, state.get_trace_state()).then(
+            [this, now, sf] (std::vector<std::vector<bytes_opt>> rows) {
+        if (!rows.empty()) {
+            auto rs = std::make_unique<cql3::result_set>(::make_shared<cql3::metadata>(*_selection->get_result_metadata()));
+            for (auto& row : rows) {
+                rs->add_row(std::move(row));
+            }
+            return make_ready_future<std::unique_ptr<cql3::result_set>>(std::move(rs));
+        }
+        // Without any rows the result is what the sequential path returns
+        // for an empty table: nothing, or a row of aggregates over nothing.
+        return do_with(cql3::selection::result_set_builder(*_selection, now, sf, *_group_by_cell_indices), [] (auto& builder) {
+            return builder.with_thread_if_needed([&builder] { return builder.build(); });
+        });
+    }).then([this] (std::unique_ptr<cql3::result_set> rs) {
+        update_stats_rows_read(rs->size());
+        auto msg = ::make_shared<cql_transport::messages::result_message::rows>(result(std::move(rs)));
+        return shared_ptr<cql_transport::messages::result_message>(std::move(msg));
+    });
+}
+
 template<typename KeyType>
 GCC6_CONCEPT(
     requires (std::is_same_v<KeyType, partition_key> || std::is_same_v<KeyType, clustering_key_prefix>)
@@ -573,39 +843,62 @@ indexed_table_select_statement::do_execute_base_query(
     auto cmd = prepare_command_for_base_query(options, state, now, bool(paging_state));
     auto timeout = db::timeout_clock::now() + options.get_timeout_config().*get_timeout_config_selector();
 
+    // The rows of a partition are adjacent in the posting list, so they
+    // can be gathered into a single read of that partition.
+    struct partition_rows {
+        dht::decorated_key partition;
+        std::vector<query::clustering_range> row_ranges;
+    };
+    std::vector<partition_rows> partitions;
+    for (auto& key : primary_keys) {
+        if (partitions.empty() || !partitions.back().partition.equal(*_schema, key.partition)) {
+            partitions.push_back(partition_rows{std::move(key.partition), {}});
+        }
+        if (key.clustering) {
+            partitions.back().row_ranges.push_back(query::clustering_range::make_singular(std::move(key.clustering)));
+        }
+    }
+    auto comparer = position_in_partition::less_compare(*_schema);
+    for (auto& p : partitions) {
+        std::sort(p.row_ranges.begin(), p.row_ranges.end(), [&comparer] (const query::clustering_range& lhs, const query::clustering_range& rhs) {
+            return comparer(position_in_partition_view::for_range_start(lhs), position_in_partition_view::for_range_start(rhs));
+        });
+        if (_is_reversed) {
+            std::reverse(p.row_ranges.begin(), p.row_ranges.end());
+        }
+    }
+
     struct base_query_state {
         query::result_merger merger;
-        std::vector<primary_key> primary_keys;
-        std::vector<primary_key>::iterator current_primary_key;
-        base_query_state(uint32_t row_limit, std::vector<primary_key>&& keys)
+        std::vector<partition_rows> partitions;
+        std::vector<partition_rows>::iterator current_partition;
+        base_query_state(uint32_t row_limit, std::vector<partition_rows>&& partitions_)
                 : merger(row_limit, query::max_partitions)
-                , primary_keys(std::move(keys))
-                , current_primary_key(primary_keys.begin())
+                , partitions(std::move(partitions_))
+                , current_partition(partitions.begin())
                 {}
         base_query_state(base_query_state&&) = default;
         base_query_state(const base_query_state&) = delete;
     };
 
-    base_query_state query_state{cmd->row_limit, std::move(primary_keys)};
+    base_query_state query_state{cmd->row_limit, std::move(partitions)};
     return do_with(std::move(query_state), [this, &proxy, &state, &options, cmd, timeout] (auto&& query_state) {
         auto &merger = query_state.merger;
-        auto &keys = query_state.primary_keys;
-        auto &key_it = query_state.current_primary_key;
+        auto &keys = query_state.partitions;
+        auto &key_it = query_state.current_partition;
         return repeat([this, &keys, &key_it, &merger, &proxy, &state, &options, cmd, timeout]() {
-            // Starting with 1 key, we check if the result was a short read, and if not,
-            // we continue exponentially, asking for 2x more key than before
+            // Starting with 1 partition, we check if the result was a short read, and if not,
+            // we continue exponentially, asking for 2x more partitions than before
+            if (key_it == keys.end()) {
+                return make_ready_future<stop_iteration>(stop_iteration::yes);
+            }
             auto key_it_end = std::min(key_it + std::distance(keys.begin(), key_it) + 1, keys.end());
-            auto command = ::make_lw_shared<query::read_command>(*cmd);
 
             query::result_merger oneshot_merger(cmd->row_limit, query::max_partitions);
             return map_reduce(key_it, key_it_end, [this, &proxy, &state, &options, cmd, timeout] (auto& key) {
                 auto command = ::make_lw_shared<query::read_command>(*cmd);
-                // for each partition, read just one clustering row (TODO: can
-                // get all needed rows of one partition at once.)
-                command->slice._row_ranges.clear();
-                if (key.clustering) {
-                    command->slice._row_ranges.push_back(query::clustering_range::make_singular(key.clustering));
-                }
+                // for each partition, read just the clustering rows found in the index
+                command->slice._row_ranges = key.row_ranges;
                 return proxy.query(_schema, command, {dht::partition_range::make_singular(key.partition)}, options.get_consistency(), {timeout, state.get_permit(), state.get_client_state(), state.get_trace_state()})
                 .then([] (service::storage_proxy::coordinator_query_result qr) {
                     return std::move(qr.query_result);
@@ -792,6 +1085,12 @@ indexed_table_select_statement::prepare(database& db,
     sstring index_table_name = im.name() + "_index";
     schema_ptr view_schema = db.find_schema(schema->ks_name(), index_table_name);
 
+    std::vector<intersected_index> intersected_indexes;
+    for (auto&& [index, restriction] : restrictions->find_intersectable_idxs(sim, *index_opt)) {
+        auto other_view_schema = db.find_schema(schema->ks_name(), index.metadata().name() + "_index");
+        intersected_indexes.push_back(intersected_index{std::move(index), std::move(restriction), std::move(other_view_schema)});
+    }
+
     return ::make_shared<cql3::statements::indexed_table_select_statement>(
             schema,
             bound_terms,
@@ -806,7 +1105,8 @@ indexed_table_select_statement::prepare(database& db,
             stats,
             *index_opt,
             std::move(used_index_restrictions),
-            view_schema);
+            view_schema,
+            std::move(intersected_indexes));
 
 }
 
@@ -822,11 +1122,14 @@ indexed_table_select_statement::indexed_table_select_statement(schema_ptr schema
                                                            cql_stats &stats,
                                                            const secondary_index::index& index,
                                                            ::shared_ptr<restrictions::restrictions> used_index_restrictions,
-                                                           schema_ptr view_schema)
+                                                           schema_ptr view_schema,
+                                                           std::vector<intersected_index> intersected_indexes)
     : select_statement{schema, bound_terms, parameters, selection, restrictions, group_by_cell_indices, is_reversed, ordering_comparator, limit, per_partition_limit, stats}
     , _index{index}
     , _used_index_restrictions(used_index_restrictions)
     , _view_schema(view_schema)
+    , _intersected_indexes(std::move(intersected_indexes))
+    , _covering_selection(make_covering_selection())
 {
     if (_index.metadata().local()) {
         _get_partition_ranges_for_posting_list = [this] (const query_options& options) { return get_partition_ranges_for_local_index_posting_list(options); };
@@ -837,6 +1140,32 @@ indexed_table_select_statement::indexed_table_select_statement(schema_ptr schema
     }
 }
 
+::shared_ptr<selection::selection> indexed_table_select_statement::make_covering_selection() const {
+    if (_index.included_columns().empty() || !_selection->is_trivial() || _selection->is_aggregate() || has_group_by()
+            || _parameters->is_distinct() || _per_partition_limit || _is_reversed || needs_post_query_ordering()) {
+        return nullptr;
+    }
+    // Reading the index view only applies the restriction on the indexed
+    // column (and, for a local index, the one on the partition key), so the
+    // query must not have any other.
+    if (_restrictions->need_filtering()
+            || !_restrictions->get_clustering_columns_restrictions()->empty()
+            || _restrictions->get_non_pk_restriction().size() != 1
+            || (!_index.metadata().local() && !_restrictions->get_partition_key_restrictions()->empty())) {
+        return nullptr;
+    }
+    std::vector<const column_definition*> columns;
+    columns.reserve(_selection->get_column_count());
+    for (const column_definition* cdef : _selection->get_columns()) {
+        const column_definition* view_cdef = _view_schema->get_column_definition(cdef->name());
+        if (!view_cdef || view_cdef->is_view_virtual()) {
+            return nullptr;
+        }
+        columns.push_back(view_cdef);
+    }
+    return selection::selection::for_columns(_view_schema, std::move(columns));
+}
+
 template<typename KeyType>
 GCC6_CONCEPT(
     requires (std::is_same_v<KeyType, partition_key> || std::is_same_v<KeyType, clustering_key_prefix>)
@@ -903,6 +1232,21 @@ lw_shared_ptr<const service::pager::paging_state> indexed_table_select_statement
     return std::move(paging_state_copy);
 }
 
+// A prefetched index page may still be using the query options, so it has to
+// resolve before the failure of the base query can be propagated.
+template <typename... T>
+static future<stop_iteration> discard_prefetched_index_page(std::optional<future<T...>>& page, std::exception_ptr ep) {
+    if (!page) {
+        return make_exception_future<stop_iteration>(std::move(ep));
+    }
+    auto f = std::move(*page);
+    page.reset();
+    return f.then_wrapped([ep = std::move(ep)] (future<T...> f) mutable {
+        f.ignore_ready_future();
+        return make_exception_future<stop_iteration>(std::move(ep));
+    });
+}
+
 future<shared_ptr<cql_transport::messages::result_message>>
 indexed_table_select_statement::do_execute(service::storage_proxy& proxy,
                              service::query_state& state,
@@ -927,6 +1271,10 @@ indexed_table_select_statement::do_execute(service::storage_proxy& proxy,
 
     _stats.unpaged_select_queries(_ks_sel) += options.get_page_size() <= 0;
 
+    if (_covering_selection) {
+        return execute_covered_query(proxy, state, options, now);
+    }
+
     // Secondary index search has two steps: 1. use the index table to find a
     // list of primary keys matching the query. 2. read the rows matching
     // these primary keys from the base table and return the selected columns.
@@ -970,11 +1318,17 @@ indexed_table_select_statement::do_execute(service::storage_proxy& proxy,
     const bool aggregate = _selection->is_aggregate() || has_group_by();
     if (aggregate) {
         const bool restrictions_need_filtering = _restrictions->need_filtering();
+        using index_page_paging_state = lw_shared_ptr<const service::pager::paging_state>;
         return do_with(cql3::selection::result_set_builder(*_selection, now, options.get_cql_serialization_format()), std::make_unique<cql3::query_options>(cql3::query_options(options)),
-                [this, &options, &proxy, &state, now, whole_partitions, partition_slices, restrictions_need_filtering] (cql3::selection::result_set_builder& builder, std::unique_ptr<cql3::query_options>& internal_options) {
+                std::optional<future<dht::partition_range_vector, index_page_paging_state>>(), std::optional<future<std::vector<primary_key>, index_page_paging_state>>(),
+                [this, &options, &proxy, &state, now, whole_partitions, partition_slices, restrictions_need_filtering] (cql3::selection::result_set_builder& builder, std::unique_ptr<cql3::query_options>& internal_options,
+                        std::optional<future<dht::partition_range_vector, index_page_paging_state>>& next_partition_ranges,
+                        std::optional<future<std::vector<primary_key>, index_page_paging_state>>& next_primary_keys) {
             // page size is set to the internal count page size, regardless of the user-provided value
             internal_options.reset(new cql3::query_options(std::move(internal_options), options.get_paging_state(), DEFAULT_COUNT_PAGE_SIZE));
-            return repeat([this, &builder, &options, &internal_options, &proxy, &state, now, whole_partitions, partition_slices, restrictions_need_filtering] () {
+            // While the base rows of a page are fetched, the next page is already
+            // read from the index (next_partition_ranges, next_primary_keys).
+            return repeat([this, &builder, &options, &internal_options, &proxy, &state, now, whole_partitions, partition_slices, restrictions_need_filtering, &next_partition_ranges, &next_primary_keys] () {
                 auto consume_results = [this, &builder, &options, &internal_options, restrictions_need_filtering] (foreign_ptr<lw_shared_ptr<query::result>> results, lw_shared_ptr<query::read_command> cmd) {
                     if (restrictions_need_filtering) {
                         query::result_view::consume(*results, cmd->slice, cql3::selection::result_set_builder::visitor(builder, *_schema, *_selection,
@@ -985,21 +1339,41 @@ indexed_table_select_statement::do_execute(service::storage_proxy& proxy,
                 };
 
                 if (whole_partitions || partition_slices) {
-                    return find_index_partition_ranges(proxy, state, *internal_options).then(
-                            [this, now, &state, &internal_options, &proxy, consume_results = std::move(consume_results)] (dht::partition_range_vector partition_ranges, lw_shared_ptr<const service::pager::paging_state> paging_state) {
+                    auto page = next_partition_ranges ? std::move(*next_partition_ranges) : find_index_partition_ranges(proxy, state, *internal_options);
+                    next_partition_ranges.reset();
+                    return std::move(page).then(
+                            [this, now, &state, &internal_options, &proxy, &next_partition_ranges, consume_results = std::move(consume_results)] (dht::partition_range_vector partition_ranges, lw_shared_ptr<const service::pager::paging_state> paging_state) {
                         bool has_more_pages = paging_state && paging_state->get_remaining() > 0;
                         internal_options.reset(new cql3::query_options(std::move(internal_options), paging_state ? make_lw_shared<service::pager::paging_state>(*paging_state) : nullptr));
-                        return do_execute_base_query(proxy, std::move(partition_ranges), state, *internal_options, now, std::move(paging_state)).then(consume_results).then([has_more_pages] {
-                            return stop_iteration(!has_more_pages);
+                        if (has_more_pages) {
+                            next_partition_ranges = find_index_partition_ranges(proxy, state, *internal_options);
+                        }
+                        return futurize_invoke([&] {
+                            return do_execute_base_query(proxy, std::move(partition_ranges), state, *internal_options, now, std::move(paging_state));
+                        }).then(consume_results).then_wrapped([has_more_pages, &next_partition_ranges] (future<> f) {
+                            if (f.failed()) {
+                                return discard_prefetched_index_page(next_partition_ranges, f.get_exception());
+                            }
+                            return make_ready_future<stop_iteration>(stop_iteration(!has_more_pages));
                         });
                     });
                 } else {
-                    return find_index_clustering_rows(proxy, state, *internal_options).then(
-                            [this, now, &state, &internal_options, &proxy, consume_results = std::move(consume_results)] (std::vector<primary_key> primary_keys, lw_shared_ptr<const service::pager::paging_state> paging_state) {
+                    auto page = next_primary_keys ? std::move(*next_primary_keys) : find_index_clustering_rows(proxy, state, *internal_options);
+                    next_primary_keys.reset();
+                    return std::move(page).then(
+                            [this, now, &state, &internal_options, &proxy, &next_primary_keys, consume_results = std::move(consume_results)] (std::vector<primary_key> primary_keys, lw_shared_ptr<const service::pager::paging_state> paging_state) {
                         bool has_more_pages = paging_state && paging_state->get_remaining() > 0;
                         internal_options.reset(new cql3::query_options(std::move(internal_options), paging_state ? make_lw_shared<service::pager::paging_state>(*paging_state) : nullptr));
-                        return this->do_execute_base_query(proxy, std::move(primary_keys), state, *internal_options, now, std::move(paging_state)).then(consume_results).then([has_more_pages] {
-                            return stop_iteration(!has_more_pages);
+                        if (has_more_pages) {
+                            next_primary_keys = find_index_clustering_rows(proxy, state, *internal_options);
+                        }
+                        return futurize_invoke([&] {
+                            return this->do_execute_base_query(proxy, std::move(primary_keys), state, *internal_options, now, std::move(paging_state));
+                        }).then(consume_results).then_wrapped([has_more_pages, &next_primary_keys] (future<> f) {
+                            if (f.failed()) {
+                                return discard_prefetched_index_page(next_primary_keys, f.get_exception());
+                            }
+                            return make_ready_future<stop_iteration>(stop_iteration(!has_more_pages));
                         });
                     });
                 }
@@ -1126,6 +1500,30 @@ indexed_table_select_statement::read_posting_list(service::storage_proxy& proxy,
                   gc_clock::time_point now,
                   db::timeout_clock::time_point timeout,
                   bool include_base_clustering_key) const
+{
+    std::vector<const column_definition*> columns;
+    for (const column_definition& cdef : _schema->partition_key_columns()) {
+        columns.emplace_back(_view_schema->get_column_definition(cdef.name()));
+    }
+    if (include_base_clustering_key) {
+        for (const column_definition& cdef : _schema->clustering_key_columns()) {
+            columns.emplace_back(_view_schema->get_column_definition(cdef.name()));
+        }
+    }
+    auto selection = selection::selection::for_columns(_view_schema, columns);
+    return read_index_view(proxy, options, limit, state, now, timeout, std::move(selection));
+}
+
+// Reads the rows of the index view matching the indexed column restriction,
+// and returns the columns of `selection` (a selection on the view).
+future<::shared_ptr<cql_transport::messages::result_message::rows>>
+indexed_table_select_statement::read_index_view(service::storage_proxy& proxy,
+                  const query_options& options,
+                  int32_t limit,
+                  service::query_state& state,
+                  gc_clock::time_point now,
+                  db::timeout_clock::time_point timeout,
+                  ::shared_ptr<selection::selection> selection) const
 {
     dht::partition_range_vector partition_ranges = _get_partition_ranges_for_posting_list(options);
     auto partition_slice = _get_partition_slice_for_posting_list(options);
@@ -1141,17 +1539,6 @@ indexed_table_select_statement::read_posting_list(service::storage_proxy& proxy,
             utils::UUID(),
             options.get_timestamp(state));
 
-    std::vector<const column_definition*> columns;
-    for (const column_definition& cdef : _schema->partition_key_columns()) {
-        columns.emplace_back(_view_schema->get_column_definition(cdef.name()));
-    }
-    if (include_base_clustering_key) {
-        for (const column_definition& cdef : _schema->clustering_key_columns()) {
-            columns.emplace_back(_view_schema->get_column_definition(cdef.name()));
-        }
-    }
-    auto selection = selection::selection::for_columns(_view_schema, columns);
-
     int32_t page_size = options.get_page_size();
     if (page_size <= 0 || !service::pager::query_pagers::may_need_paging(*_view_schema, page_size, *cmd, partition_ranges)) {
         return proxy.query(_view_schema, cmd, std::move(partition_ranges), options.get_consistency(), {timeout, state.get_permit(), state.get_client_state(), state.get_trace_state()})
@@ -1172,6 +1559,31 @@ indexed_table_select_statement::read_posting_list(service::storage_proxy& proxy,
     });
 }
 
+// The selected columns are all included in the index view, so the query is
+// answered by the view alone. The rows read from it are in the order of the
+// selection, and only need the result metadata of the base table query.
+future<shared_ptr<cql_transport::messages::result_message>>
+indexed_table_select_statement::execute_covered_query(service::storage_proxy& proxy,
+                                                      service::query_state& state,
+                                                      const query_options& options,
+                                                      gc_clock::time_point now) const
+{
+    ++_stats.secondary_index_covered_reads;
+    auto timeout = db::timeout_clock::now() + options.get_timeout_config().*get_timeout_config_selector();
+    return read_index_view(proxy, options, get_limit(options), state, now, timeout, _covering_selection).then(
+            [this] (::shared_ptr<cql_transport::messages::result_message::rows> rows) {
+        auto rs = std::make_unique<result_set>(::make_shared<metadata>(*_selection->get_result_metadata()));
+        for (auto& row : rows->rs().result_set().rows()) {
+            rs->add_row(row);
+        }
+        if (auto paging_state = rows->rs().get_metadata().paging_state()) {
+            rs->get_metadata().maybe_set_paging_state(std::move(paging_state));
+        }
+        update_stats_rows_read(rs->size());
+        return shared_ptr<cql_transport::messages::result_message>(::make_shared<cql_transport::messages::result_message::rows>(result(std::move(rs))));
+    });
+}
+
 // Note: the partitions keys returned by this function are sorted
 // in token order. See issue #3423.
 future<dht::partition_range_vector, lw_shared_ptr<const service::pager::paging_state>>
@@ -1182,10 +1594,10 @@ indexed_table_select_statement::find_index_partition_ranges(service::storage_pro
     auto now = gc_clock::now();
     auto timeout = db::timeout_clock::now() + options.get_timeout_config().*get_timeout_config_selector();
     return read_posting_list(proxy, options, get_limit(options), state, now, timeout, false).then(
-            [this, now, &options] (::shared_ptr<cql_transport::messages::result_message::rows> rows) {
+            [this, now, &options, &proxy, &state] (::shared_ptr<cql_transport::messages::result_message::rows> rows) {
         auto rs = cql3::untyped_result_set(rows);
-        dht::partition_range_vector partition_ranges;
-        partition_ranges.reserve(rs.size());
+        std::vector<primary_key> partition_keys;
+        partition_keys.reserve(rs.size());
         // We are reading the list of primary keys as rows of a single
         // partition (in the index view), so they are sorted in
         // lexicographical order (N.B. this is NOT token order!). We need
@@ -1206,11 +1618,18 @@ indexed_table_select_statement::find_index_partition_ranges(service::storage_pro
                 continue;
             }
             last_dk = dk;
-            auto range = dht::partition_range::make_singular(dk);
-            partition_ranges.emplace_back(range);
+            partition_keys.emplace_back(primary_key{std::move(dk), clustering_key_prefix::make_empty()});
         }
         auto paging_state = rows->rs().get_metadata().paging_state();
-        return make_ready_future<dht::partition_range_vector, lw_shared_ptr<const service::pager::paging_state>>(std::move(partition_ranges), std::move(paging_state));
+        return intersect_posting_lists(proxy, state, options, std::move(partition_keys), false).then(
+                [paging_state = std::move(paging_state)] (std::vector<primary_key> partition_keys) mutable {
+            dht::partition_range_vector partition_ranges;
+            partition_ranges.reserve(partition_keys.size());
+            for (auto& key : partition_keys) {
+                partition_ranges.emplace_back(dht::partition_range::make_singular(std::move(key.partition)));
+            }
+            return make_ready_future<dht::partition_range_vector, lw_shared_ptr<const service::pager::paging_state>>(std::move(partition_ranges), std::move(paging_state));
+        });
     });
 }
 
@@ -1222,7 +1641,7 @@ indexed_table_select_statement::find_index_clustering_rows(service::storage_prox
     auto now = gc_clock::now();
     auto timeout = db::timeout_clock::now() + options.get_timeout_config().*get_timeout_config_selector();
     return read_posting_list(proxy, options, get_limit(options), state, now, timeout, true).then(
-            [this, now, &options] (::shared_ptr<cql_transport::messages::result_message::rows> rows) {
+            [this, now, &options, &proxy, &state] (::shared_ptr<cql_transport::messages::result_message::rows> rows) {
 
         auto rs = cql3::untyped_result_set(rows);
         std::vector<primary_key> primary_keys;
@@ -1241,7 +1660,141 @@ indexed_table_select_statement::find_index_clustering_rows(service::storage_prox
             primary_keys.emplace_back(primary_key{std::move(dk), std::move(ck)});
         }
         auto paging_state = rows->rs().get_metadata().paging_state();
-        return make_ready_future<std::vector<indexed_table_select_statement::primary_key>, lw_shared_ptr<const service::pager::paging_state>>(std::move(primary_keys), std::move(paging_state));
+        return intersect_posting_lists(proxy, state, options, std::move(primary_keys), true).then(
+                [paging_state = std::move(paging_state)] (std::vector<primary_key> primary_keys) mutable {
+            return make_ready_future<std::vector<indexed_table_select_statement::primary_key>, lw_shared_ptr<const service::pager::paging_state>>(std::move(primary_keys), std::move(paging_state));
+        });
+    });
+}
+
+future<std::vector<indexed_table_select_statement::primary_key>>
+indexed_table_select_statement::intersect_posting_lists(service::storage_proxy& proxy,
+                                                        service::query_state& state,
+                                                        const query_options& options,
+                                                        std::vector<primary_key> keys,
+                                                        bool include_base_clustering_key) const
+{
+    if (_intersected_indexes.empty() || keys.empty()) {
+        return make_ready_future<std::vector<primary_key>>(std::move(keys));
+    }
+    return do_with(std::move(keys), _intersected_indexes.begin(), [this, &proxy, &state, &options, include_base_clustering_key] (std::vector<primary_key>& keys, auto& it) {
+        return repeat([this, &proxy, &state, &options, include_base_clustering_key, &keys, &it] {
+            if (it == _intersected_indexes.end() || keys.empty()) {
+                return make_ready_future<stop_iteration>(stop_iteration::yes);
+            }
+            const intersected_index& other = *it++;
+            return intersect_posting_list(proxy, state, options, other, std::move(keys), include_base_clustering_key).then([&keys] (std::vector<primary_key> remaining) {
+                keys = std::move(remaining);
+                return stop_iteration::no;
+            });
+        }).then([&keys] {
+            return std::move(keys);
+        });
+    });
+}
+
+// Reads the part of the posting list of `other` which can contain `keys`, and
+// drops the keys it doesn't contain. `keys` come in the order of the posting
+// list of _index, that is they are either sorted by token (global index) or
+// all belong to a single base partition (local index).
+future<std::vector<indexed_table_select_statement::primary_key>>
+indexed_table_select_statement::intersect_posting_list(service::storage_proxy& proxy,
+                                                       service::query_state& state,
+                                                       const query_options& options,
+                                                       const intersected_index& other,
+                                                       std::vector<primary_key> keys,
+                                                       bool include_base_clustering_key) const
+{
+    const schema_ptr& view_schema = other.view_schema;
+    bytes_opt value = other.restriction->value(options);
+    if (!value) {
+        return make_ready_future<std::vector<primary_key>>(std::move(keys));
+    }
+
+    dht::partition_range_vector partition_ranges;
+    query::clustering_range range = query::clustering_range::make_open_ended_both_sides();
+    if (other.index.metadata().local()) {
+        // A local index can only be consulted for keys of a single partition.
+        const auto& pk = keys.front().partition;
+        if (!boost::algorithm::all_of(keys, [&] (const primary_key& key) { return key.partition.equal(*_schema, pk); })) {
+            return make_ready_future<std::vector<primary_key>>(std::move(keys));
+        }
+        partition_ranges.emplace_back(dht::partition_range::make_singular(dht::decorate_key(*view_schema, pk.key())));
+        range = query::clustering_range::make_singular(clustering_key_prefix::from_exploded(*view_schema, {*value}));
+    } else {
+        // Entries of a global index are sorted by the token of the base
+        // partition, so only the token range spanned by the keys is read.
+        auto [min, max] = std::minmax_element(keys.begin(), keys.end(), [] (const primary_key& a, const primary_key& b) {
+            return a.partition.token() < b.partition.token();
+        });
+        auto pk = partition_key::from_single_value(*view_schema, *value);
+        partition_ranges.emplace_back(dht::partition_range::make_singular(dht::decorate_key(*view_schema, pk)));
+        range = query::clustering_range::make(
+                {clustering_key_prefix::from_exploded(*view_schema, {min->partition.token().data()}), true},
+                {clustering_key_prefix::from_exploded(*view_schema, {max->partition.token().data()}), true});
+    }
+
+    std::vector<const column_definition*> columns;
+    for (const column_definition& cdef : _schema->partition_key_columns()) {
+        columns.emplace_back(view_schema->get_column_definition(cdef.name()));
+    }
+    if (include_base_clustering_key) {
+        for (const column_definition& cdef : _schema->clustering_key_columns()) {
+            columns.emplace_back(view_schema->get_column_definition(cdef.name()));
+        }
+    }
+    auto selection = selection::selection::for_columns(view_schema, columns);
+
+    const uint32_t row_limit = std::max<uint64_t>(min_intersection_rows, uint64_t(keys.size()) * intersection_rows_per_key);
+    auto now = gc_clock::now();
+    auto timeout = db::timeout_clock::now() + options.get_timeout_config().*get_timeout_config_selector();
+    auto cmd = ::make_lw_shared<query::read_command>(
+            view_schema->id(),
+            view_schema->version(),
+            partition_slice_builder(*view_schema).with_range(std::move(range)).build(),
+            row_limit,
+            now,
+            tracing::make_trace_info(state.get_trace_state()),
+            query::max_partitions,
+            utils::UUID(),
+            options.get_timestamp(state));
+
+    ++_stats.secondary_index_intersections;
+    return proxy.query(view_schema, cmd, std::move(partition_ranges), options.get_consistency(), {timeout, state.get_permit(), state.get_client_state(), state.get_trace_state()})
+    .then([this, now, &options, view_schema, cmd, row_limit, selection = std::move(selection), keys = std::move(keys), include_base_clustering_key]
+            (service::storage_proxy::coordinator_query_result qr) mutable {
+        cql3::selection::result_set_builder builder(*selection, now, options.get_cql_serialization_format());
+        query::result_view::consume(*qr.query_result, cmd->slice, cql3::selection::result_set_builder::visitor(builder, *view_schema, *selection));
+        auto rs = builder.build();
+        if (rs->size() >= row_limit || qr.query_result->is_short_read()) {
+            ++_stats.secondary_index_intersections_skipped;
+            return std::move(keys);
+        }
+
+        std::unordered_map<partition_key, std::vector<clustering_key_prefix>, partition_key::hashing, partition_key::equality> found(
+                rs->size(), partition_key::hashing(*_schema), partition_key::equality(*_schema));
+        const size_t pk_size = _schema->partition_key_size();
+        for (auto& row : rs->rows()) {
+            auto pk = partition_key::from_range(boost::make_iterator_range(row.begin(), row.begin() + pk_size) | boost::adaptors::transformed([] (const bytes_opt& b) { return *b; }));
+            auto& cks = found[std::move(pk)];
+            if (include_base_clustering_key) {
+                cks.emplace_back(clustering_key_prefix::from_range(boost::make_iterator_range(row.begin() + pk_size, row.end()) | boost::adaptors::transformed([] (const bytes_opt& b) { return *b; })));
+            }
+        }
+
+        clustering_key_prefix::equality ck_eq(*_schema);
+        const size_t keys_before = keys.size();
+        boost::remove_erase_if(keys, [&] (const primary_key& key) {
+            auto it = found.find(key.partition.key());
+            if (it == found.end()) {
+                return true;
+            }
+            return include_base_clustering_key && boost::algorithm::none_of(it->second, [&] (const clustering_key_prefix& ck) {
+                return ck_eq(ck, key.clustering);
+            });
+        });
+        _stats.secondary_index_keys_pruned += keys_before - keys.size();
+        return std::move(keys);
     });
 }
 
@@ -55,6 +55,10 @@
 #include "validation.hh"
 #include "transport/messages/result_message.hh"
 
+namespace service::pager {
+class query_pager;
+}
+
 namespace cql3 {
 
 namespace statements {
@@ -69,6 +73,8 @@ class select_statement : public cql_statement {
     using parameters = raw::select_statement::parameters;
     using ordering_comparator_type = raw::select_statement::ordering_comparator_type;
     static constexpr int DEFAULT_COUNT_PAGE_SIZE = 10000;
+    // The number of token ranges an aggregate query scans at the same time.
+    static constexpr size_t PARALLEL_AGGREGATE_CONCURRENCY = 16;
 protected:
     static thread_local const lw_shared_ptr<const parameters> _default_parameters;
     schema_ptr _schema;
@@ -156,6 +162,20 @@ protected :
         return do_get_limit(options, _per_partition_limit);
     }
     bool needs_post_query_ordering() const;
+    query::column_filters make_replica_filters(const query::partition_slice& slice, const query_options& options) const;
+    bool can_parallelize_aggregate(service::storage_proxy& proxy, const query_options& options,
+            bool restrictions_need_filtering, const dht::partition_range_vector& key_ranges) const;
+    future<::shared_ptr<cql_transport::messages::result_message>> execute_parallel_aggregate(service::storage_proxy& proxy,
+            lw_shared_ptr<query::read_command> cmd, dht::partition_range_vector&& partition_ranges, service::query_state& state,
+            const query_options& options, gc_clock::time_point now, int32_t page_size) const;
+    future<::shared_ptr<cql_transport::messages::result_message>> execute_parallel_group_by(
+            std::vector<::shared_ptr<service::pager::query_pager>> pagers,
+            const query_options& options, gc_clock::time_point now, int32_t page_size) const;
+    bool can_forward_aggregate(service::storage_proxy& proxy) const;
+    query::forward_request make_forward_request(const query::read_command& cmd,
+            const dht::partition_range_vector& partition_ranges, const query_options& options, int32_t page_size) const;
+    future<::shared_ptr<cql_transport::messages::result_message>> execute_forwarded_aggregate(service::storage_proxy& proxy,
+            query::forward_request req, service::query_state& state, const query_options& options, gc_clock::time_point now) const;
     virtual void update_stats_rows_read(int64_t rows_read) const {
         _stats.rows_read += rows_read;
     }
@@ -177,9 +197,29 @@ class primary_key_select_statement : public select_statement {
 };
 
 class indexed_table_select_statement : public select_statement {
+public:
+    // Another index restricted by an EQ relation of the statement. The keys read
+    // from the posting list of _index are checked against its posting list before
+    // the base rows are fetched, instead of fetching them only to filter them out.
+    struct intersected_index {
+        secondary_index::index index;
+        ::shared_ptr<restrictions::single_column_restriction> restriction;
+        schema_ptr view_schema;
+    };
+    // The posting list of an intersected index is read with a row limit of
+    // intersection_rows_per_key times the number of keys being checked (but no
+    // less than min_intersection_rows). If the limit is hit, the value is too
+    // common for the intersection to pay off and the keys are left as they are.
+    static constexpr uint32_t intersection_rows_per_key = 4;
+    static constexpr uint32_t min_intersection_rows = 1000;
+private:
     secondary_index::index _index;
     ::shared_ptr<restrictions::restrictions> _used_index_restrictions;
     schema_ptr _view_schema;
+    std::vector<intersected_index> _intersected_indexes;
+    // Selects the columns of _selection from the index view, when the view includes
+    // all of them and the query can be answered without reading the base table.
+    ::shared_ptr<selection::selection> _covering_selection;
     noncopyable_function<dht::partition_range_vector(const query_options&)> _get_partition_ranges_for_posting_list;
     noncopyable_function<query::partition_slice(const query_options&)> _get_partition_slice_for_posting_list;
 public:
@@ -209,7 +249,8 @@ class indexed_table_select_statement : public select_statement {
                                    cql_stats &stats,
                                    const secondary_index::index& index,
                                    ::shared_ptr<restrictions::restrictions> used_index_restrictions,
-                                   schema_ptr view_schema);
+                                   schema_ptr view_schema,
+                                   std::vector<intersected_index> intersected_indexes = {});
 
 private:
     virtual future<::shared_ptr<cql_transport::messages::result_message>> do_execute(service::storage_proxy& proxy,
@@ -226,6 +267,21 @@ class indexed_table_select_statement : public select_statement {
                                                                 service::query_state& state,
                                                                 const query_options& options) const;
 
+    // Drops the keys missing from the posting list of any of _intersected_indexes.
+    // With include_base_clustering_key unset, keys are matched by partition only.
+    future<std::vector<primary_key>> intersect_posting_lists(service::storage_proxy& proxy,
+                                                             service::query_state& state,
+                                                             const query_options& options,
+                                                             std::vector<primary_key> keys,
+                                                             bool include_base_clustering_key) const;
+
+    future<std::vector<primary_key>> intersect_posting_list(service::storage_proxy& proxy,
+                                                            service::query_state& state,
+                                                            const query_options& options,
+                                                            const intersected_index& other,
+                                                            std::vector<primary_key> keys,
+                                                            bool include_base_clustering_key) const;
+
     future<shared_ptr<cql_transport::messages::result_message>>
     process_base_query_results(
             foreign_ptr<lw_shared_ptr<query::result>> results,
@@ -259,11 +315,10 @@ class indexed_table_select_statement : public select_statement {
     // Function for fetching the selected columns from a list of clustering rows.
     // It is currently used only in our Secondary Index implementation - ordinary
     // CQL SELECT statements do not have the syntax to request a list of rows.
-    // FIXME: The current implementation is very inefficient - it requests each
-    // row separately (and, incrementally, in parallel). Even multiple rows from a single
-    // partition are requested separately. This last case can be easily improved,
-    // but to implement the general case (multiple rows from multiple partitions)
-    // efficiently, we will need more support from other layers.
+    // Rows of a single partition are requested together, with one clustering
+    // range per row, and the partitions are requested (incrementally) in parallel.
+    // FIXME: to read rows from multiple partitions with a single request,
+    // we will need more support from other layers.
     // Keys are ordered in token order (see #3423)
     future<foreign_ptr<lw_shared_ptr<query::result>>, lw_shared_ptr<query::read_command>>
     do_execute_base_query(
@@ -296,6 +351,23 @@ class indexed_table_select_statement : public select_statement {
             db::timeout_clock::time_point timeout,
             bool include_base_clustering_key) const;
 
+    future<::shared_ptr<cql_transport::messages::result_message::rows>> read_index_view(
+            service::storage_proxy& proxy,
+            const query_options& options,
+            int32_t limit,
+            service::query_state& state,
+            gc_clock::time_point now,
+            db::timeout_clock::time_point timeout,
+            ::shared_ptr<selection::selection> selection) const;
+
+    ::shared_ptr<selection::selection> make_covering_selection() const;
+
+    future<shared_ptr<cql_transport::messages::result_message>> execute_covered_query(
+            service::storage_proxy& proxy,
+            service::query_state& state,
+            const query_options& options,
+            gc_clock::time_point now) const;
+
     dht::partition_range_vector get_partition_ranges_for_local_index_posting_list(const query_options& options) const;
     dht::partition_range_vector get_partition_ranges_for_global_index_posting_list(const query_options& options) const;
 
@@ -246,9 +246,8 @@ insert_prepared_json_statement::execute_set_value(mutation& m, const clustering_
     ));
 }
 
-dht::partition_range_vector
-insert_prepared_json_statement::build_partition_keys(const query_options& options, const json_cache_opt& json_cache) const {
-    dht::partition_range_vector ranges;
+std::vector<partition_key>
+insert_prepared_json_statement::build_partition_key_values(const query_options& options, const json_cache_opt& json_cache) const {
     std::vector<bytes_opt> exploded;
     for (const auto& def : s->partition_key_columns()) {
         auto json_value = json_cache->find(def.name_as_text());
@@ -257,10 +256,9 @@ insert_prepared_json_statement::build_partition_keys(const query_options& option
         }
         exploded.emplace_back(json_value->second);
     }
-    auto pkey = partition_key::from_optional_exploded(*s, std::move(exploded));
-    auto k = query::range<query::ring_position>::make_singular(dht::decorate_key(*s, std::move(pkey)));
-    ranges.emplace_back(std::move(k));
-    return ranges;
+    std::vector<partition_key> keys;
+    keys.push_back(partition_key::from_optional_exploded(*s, std::move(exploded)));
+    return keys;
 }
 
 query::clustering_row_ranges insert_prepared_json_statement::create_clustering_ranges(const query_options& options, const json_cache_opt& json_cache) const {
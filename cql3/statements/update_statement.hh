@@ -102,7 +102,7 @@ class insert_prepared_json_statement : public update_statement {
 private:
     virtual void execute_operations_for_key(mutation& m, const clustering_key_prefix& prefix, const update_parameters& params, const json_cache_opt& json_cache) const override;
 
-    virtual dht::partition_range_vector build_partition_keys(const query_options& options, const json_cache_opt& json_cache) const override;
+    virtual std::vector<partition_key> build_partition_key_values(const query_options& options, const json_cache_opt& json_cache) const override;
 
     virtual query::clustering_row_ranges create_clustering_ranges(const query_options& options, const json_cache_opt& json_cache) const override;
 
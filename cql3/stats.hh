@@ -80,6 +80,10 @@ struct cql_stats {
     int64_t secondary_index_drops = 0;
     int64_t secondary_index_reads = 0;
     int64_t secondary_index_rows_read = 0;
+    int64_t secondary_index_covered_reads = 0;
+    int64_t secondary_index_intersections = 0;
+    int64_t secondary_index_intersections_skipped = 0;
+    int64_t secondary_index_keys_pruned = 0;
 
     int64_t filtered_reads = 0;
     int64_t filtered_rows_matched_total = 0;
@@ -89,6 +93,7 @@ struct cql_stats {
     int64_t select_allow_filtering = 0;
     int64_t select_partition_range_scan = 0;
     int64_t select_partition_range_scan_no_bypass_cache = 0;
+    int64_t select_parallelized_aggregates = 0;
 
 private:
     uint64_t _unpaged_select_queries[(size_t)ks_selector::SIZE] = {0ul};
@@ -30,9 +30,7 @@
 #include "types/user.hh"
 #include "types/listlike_partial_deserializing_iterator.hh"
 
-static sstring quote_json_string(const sstring& s) {
-    return json::value_to_quoted_string(s);
-}
+#include <fmt/format.h>
 
 static bytes from_json_object_aux(const map_type_impl& t, const Json::Value& value, cql_serialization_format sf) {
     if (!value.isObject()) {
@@ -236,183 +234,249 @@ template <typename T> static T compose_value(const integer_type_impl<T>& t, byte
     return read_be<T>(reinterpret_cast<const char*>(bv.data()));
 }
 
-static sstring to_json_string_aux(const map_type_impl& t, bytes_view bv) {
-    std::ostringstream out;
+static void write(bytes_ostream& out, std::string_view s) {
+    out.write(s.data(), s.size());
+}
+
+// Writes s as a quoted JSON string, escaping it the same way as
+// json::value_to_quoted_string().
+static void write_quoted(bytes_ostream& out, std::string_view s) {
+    static constexpr char hex[] = "0123456789ABCDEF";
+    out.write("\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c != '"' && c != '\\' && (c < 0 || c > 0x1F)) {
+            continue;
+        }
+        out.write(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+        case '"': write(out, "\\\""); break;
+        case '\\': write(out, "\\\\"); break;
+        case '\b': write(out, "\\b"); break;
+        case '\f': write(out, "\\f"); break;
+        case '\n': write(out, "\\n"); break;
+        case '\r': write(out, "\\r"); break;
+        case '\t': write(out, "\\t"); break;
+        default: {
+            char escaped[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+            out.write(escaped, sizeof(escaped));
+        }
+        }
+    }
+    out.write(s.data() + run, s.size() - run);
+    out.write("\"", 1);
+}
+
+static void write_quoted(bytes_ostream& out, bytes_view bv) {
+    write_quoted(out, std::string_view(reinterpret_cast<const char*>(bv.data()), bv.size()));
+}
+
+// Writes a serialized uuid in its canonical quoted form without going
+// through an intermediate string.
+static void write_quoted_uuid(bytes_ostream& out, bytes_view bv) {
+    static constexpr char hex[] = "0123456789abcdef";
+    char buf[38];
+    char* p = buf;
+    *p++ = '"';
+    for (size_t i = 0; i < 16; ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            *p++ = '-';
+        }
+        auto b = uint8_t(bv[i]);
+        *p++ = hex[b >> 4];
+        *p++ = hex[b & 0xf];
+    }
+    *p++ = '"';
+    out.write(buf, p - buf);
+}
+
+static void write_json_aux(const map_type_impl& t, bytes_view bv, bytes_ostream& out) {
     auto sf = cql_serialization_format::internal();
+    auto keys_type = t.get_keys_type()->underlying_type();
+    bool keys_are_strings = dynamic_cast<const string_type_impl*>(keys_type.get());
 
-    out << '{';
+    out.write("{", 1);
     auto size = read_collection_size(bv, sf);
     for (int i = 0; i < size; ++i) {
         auto kb = read_collection_value(bv, sf);
         auto vb = read_collection_value(bv, sf);
 
         if (i > 0) {
-            out << ", ";
+            write(out, ", ");
         }
 
         // Valid keys in JSON map must be quoted strings
-        sstring string_key = to_json_string(*t.get_keys_type(), kb);
-        bool is_unquoted = string_key.empty() || string_key[0] != '"';
-        if (is_unquoted) {
-            out << '"';
-        }
-        out << string_key;
-        if (is_unquoted) {
-            out << '"';
-        }
-        out << ": ";
-        out << to_json_string(*t.get_values_type(), vb);
-    }
-    out << '}';
-    return out.str();
-}
-
-static sstring to_json_string_aux(const set_type_impl& t, bytes_view bv) {
-    using llpdi = listlike_partial_deserializing_iterator;
-    std::ostringstream out;
-    bool first = true;
-    auto sf = cql_serialization_format::internal();
-    out << '[';
-    std::for_each(llpdi::begin(bv, sf), llpdi::end(bv, sf), [&first, &out, &t] (bytes_view e) {
-        if (first) {
-            first = false;
+        if (keys_are_strings) {
+            write_quoted(out, kb);
         } else {
-            out << ", ";
+            bytes_ostream key;
+            write_json(*keys_type, kb, key);
+            auto key_json = key.linearize();
+            bool is_unquoted = key_json.empty() || key_json[0] != '"';
+            if (is_unquoted) {
+                out.write("\"", 1);
+            }
+            out.write(key_json);
+            if (is_unquoted) {
+                out.write("\"", 1);
+            }
         }
-        out << to_json_string(*t.get_elements_type(), e);
-    });
-    out << ']';
-    return out.str();
+        write(out, ": ");
+        write_json(*t.get_values_type(), vb, out);
+    }
+    out.write("}", 1);
 }
 
-static sstring to_json_string_aux(const list_type_impl& t, bytes_view bv) {
+static void write_json_aux(const listlike_collection_type_impl& t, bytes_view bv, bytes_ostream& out) {
     using llpdi = listlike_partial_deserializing_iterator;
-    std::ostringstream out;
     bool first = true;
     auto sf = cql_serialization_format::internal();
-    out << '[';
+    out.write("[", 1);
     std::for_each(llpdi::begin(bv, sf), llpdi::end(bv, sf), [&first, &out, &t] (bytes_view e) {
         if (first) {
             first = false;
         } else {
-            out << ", ";
+            write(out, ", ");
         }
-        out << to_json_string(*t.get_elements_type(), e);
+        write_json(*t.get_elements_type(), e, out);
     });
-    out << ']';
-    return out.str();
+    out.write("]", 1);
 }
 
-static sstring to_json_string_aux(const tuple_type_impl& t, bytes_view bv) {
-    std::ostringstream out;
-    out << '[';
+static void write_json_aux(const tuple_type_impl& t, bytes_view bv, bytes_ostream& out) {
+    out.write("[", 1);
 
     auto ti = t.all_types().begin();
     auto vi = tuple_deserializing_iterator::start(bv);
     while (ti != t.all_types().end() && vi != tuple_deserializing_iterator::finish(bv)) {
         if (ti != t.all_types().begin()) {
-            out << ", ";
+            write(out, ", ");
         }
         if (*vi) {
-            // TODO(sarna): We can avoid copying if to_json_string accepted bytes_view
-            out << to_json_string(**ti, **vi);
+            write_json(**ti, **vi, out);
         } else {
-            out << "null";
+            write(out, "null");
         }
         ++ti;
         ++vi;
     }
 
-    out << ']';
-    return out.str();
+    out.write("]", 1);
 }
 
-static sstring to_json_string_aux(const user_type_impl& t, bytes_view bv) {
-    std::ostringstream out;
-    out << '{';
+static void write_json_aux(const user_type_impl& t, bytes_view bv, bytes_ostream& out) {
+    out.write("{", 1);
 
     auto ti = t.all_types().begin();
     auto vi = tuple_deserializing_iterator::start(bv);
     int i = 0;
     while (ti != t.all_types().end() && vi != tuple_deserializing_iterator::finish(bv)) {
         if (ti != t.all_types().begin()) {
-            out << ", ";
+            write(out, ", ");
         }
-        out << quote_json_string(t.field_name_as_string(i)) << ": ";
+        write_quoted(out, t.field_name_as_string(i));
+        write(out, ": ");
         if (*vi) {
-            //TODO(sarna): We can avoid copying if to_json_string accepted bytes_view
-            out << to_json_string(**ti, **vi);
+            write_json(**ti, **vi, out);
         } else {
-            out << "null";
+            write(out, "null");
         }
         ++ti;
         ++i;
         ++vi;
     }
 
-    out << '}';
-    return out.str();
+    out.write("}", 1);
 }
 
 namespace {
-struct to_json_string_visitor {
+struct write_json_visitor {
     bytes_view bv;
-    sstring operator()(const reversed_type_impl& t) { return to_json_string(*t.underlying_type(), bv); }
-    template <typename T> sstring operator()(const integer_type_impl<T>& t) { return to_sstring(compose_value(t, bv)); }
-    template <typename T> sstring operator()(const floating_type_impl<T>& t) {
+    bytes_ostream& out;
+    void operator()(const reversed_type_impl& t) { write_json(*t.underlying_type(), bv, out); }
+    template <typename T> void operator()(const integer_type_impl<T>& t) {
+        fmt::format_int v(compose_value(t, bv));
+        out.write(v.data(), v.size());
+    }
+    template <typename T> void operator()(const floating_type_impl<T>& t) {
         if (bv.empty()) {
             throw exceptions::invalid_request_exception("Cannot create JSON string - deserialization error");
         }
         auto v = t.deserialize(bv);
         T d = value_cast<T>(v);
         if (std::isnan(d) || std::isinf(d)) {
-            return "null";
-        }
-        return to_sstring(d);
-    }
-    sstring operator()(const uuid_type_impl& t) { return quote_json_string(t.to_string(bv)); }
-    sstring operator()(const inet_addr_type_impl& t) { return quote_json_string(t.to_string(bv)); }
-    sstring operator()(const string_type_impl& t) { return quote_json_string(t.to_string(bv)); }
-    sstring operator()(const bytes_type_impl& t) { return quote_json_string("0x" + t.to_string(bv)); }
-    sstring operator()(const boolean_type_impl& t) { return t.to_string(bv); }
-    sstring operator()(const timestamp_date_base_class& t) { return quote_json_string(t.to_string(bv)); }
-    sstring operator()(const timeuuid_type_impl& t) { return quote_json_string(t.to_string(bv)); }
-    sstring operator()(const map_type_impl& t) { return to_json_string_aux(t, bv); }
-    sstring operator()(const set_type_impl& t) { return to_json_string_aux(t, bv); }
-    sstring operator()(const list_type_impl& t) { return to_json_string_aux(t, bv); }
-    sstring operator()(const tuple_type_impl& t) { return to_json_string_aux(t, bv); }
-    sstring operator()(const user_type_impl& t) { return to_json_string_aux(t, bv); }
-    sstring operator()(const simple_date_type_impl& t) { return quote_json_string(t.to_string(bv)); }
-    sstring operator()(const time_type_impl& t) { return t.to_string(bv); }
-    sstring operator()(const empty_type_impl& t) { return "null"; }
-    sstring operator()(const duration_type_impl& t) {
+            write(out, "null");
+            return;
+        }
+        write(out, to_sstring(d));
+    }
+    void operator()(const uuid_type_impl& t) {
+        if (bv.size() == 16) {
+            write_quoted_uuid(out, bv);
+        } else {
+            write_quoted(out, t.to_string(bv));
+        }
+    }
+    void operator()(const timeuuid_type_impl& t) {
+        if (bv.size() == 16) {
+            write_quoted_uuid(out, bv);
+        } else {
+            write_quoted(out, t.to_string(bv));
+        }
+    }
+    void operator()(const inet_addr_type_impl& t) { write_quoted(out, t.to_string(bv)); }
+    void operator()(const string_type_impl& t) {
+        // Validated on write, so the serialized form is already the text.
+        write_quoted(out, bv);
+    }
+    void operator()(const bytes_type_impl& t) { write_quoted(out, "0x" + t.to_string(bv)); }
+    void operator()(const boolean_type_impl& t) { write(out, t.to_string(bv)); }
+    void operator()(const timestamp_date_base_class& t) { write_quoted(out, t.to_string(bv)); }
+    void operator()(const map_type_impl& t) { write_json_aux(t, bv, out); }
+    void operator()(const set_type_impl& t) { write_json_aux(t, bv, out); }
+    void operator()(const list_type_impl& t) { write_json_aux(t, bv, out); }
+    void operator()(const tuple_type_impl& t) { write_json_aux(t, bv, out); }
+    void operator()(const user_type_impl& t) { write_json_aux(t, bv, out); }
+    void operator()(const simple_date_type_impl& t) { write_quoted(out, t.to_string(bv)); }
+    void operator()(const time_type_impl& t) { write(out, t.to_string(bv)); }
+    void operator()(const empty_type_impl& t) { write(out, "null"); }
+    void operator()(const duration_type_impl& t) {
         auto v = t.deserialize(bv);
         if (v.is_null()) {
             throw exceptions::invalid_request_exception("Cannot create JSON string - deserialization error");
         }
-        return quote_json_string(t.to_string(bv));
+        write_quoted(out, t.to_string(bv));
     }
-    sstring operator()(const counter_type_impl& t) {
+    void operator()(const counter_type_impl& t) {
         // It will be called only from cql3 layer while processing query results.
-        return to_json_string(*counter_cell_view::total_value_type(), bv);
+        write_json(*counter_cell_view::total_value_type(), bv, out);
     }
-    sstring operator()(const decimal_type_impl& t) {
+    void operator()(const decimal_type_impl& t) {
         if (bv.empty()) {
             throw exceptions::invalid_request_exception("Cannot create JSON string - deserialization error");
         }
         auto v = t.deserialize(bv);
-        return value_cast<big_decimal>(v).to_string();
+        write(out, value_cast<big_decimal>(v).to_string());
     }
-    sstring operator()(const varint_type_impl& t) {
+    void operator()(const varint_type_impl& t) {
         if (bv.empty()) {
             throw exceptions::invalid_request_exception("Cannot create JSON string - deserialization error");
         }
         auto v = t.deserialize(bv);
-        return value_cast<utils::multiprecision_int>(v).str();
+        write(out, value_cast<utils::multiprecision_int>(v).str());
     }
 };
 }
 
+void write_json(const abstract_type& t, bytes_view bv, bytes_ostream& out) {
+    visit(t, write_json_visitor{bv, out});
+}
+
 sstring to_json_string(const abstract_type& t, bytes_view bv) {
-    return visit(t, to_json_string_visitor{bv});
+    bytes_ostream out;
+    write_json(t, bv, out);
+    auto linearized = out.linearize();
+    return sstring(reinterpret_cast<const char*>(linearized.data()), linearized.size());
 }
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "types.hh"
+#include "bytes_ostream.hh"
 
 namespace Json {
 class Value;
@@ -29,6 +30,17 @@ class Value;
 
 bytes from_json_object(const abstract_type &t, const Json::Value& value, cql_serialization_format sf);
 sstring to_json_string(const abstract_type &t, bytes_view bv);
+
+// Appends the JSON representation of a serialized value to out, without
+// building intermediate strings for each nested value.
+void write_json(const abstract_type& t, bytes_view bv, bytes_ostream& out);
+inline void write_json(const abstract_type& t, const bytes_opt& b, bytes_ostream& out) {
+    if (b) {
+        write_json(t, bytes_view(*b), out);
+    } else {
+        out.write("null", 4);
+    }
+}
 inline sstring to_json_string(const abstract_type &t, const bytes& b) {
     return to_json_string(t, bytes_view(b));
 }
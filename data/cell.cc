@@ -32,21 +32,6 @@ thread_local imr::alloc::lsa_migrate_fn<data::cell::external_chunk,
 
 int compare_unsigned(data::value_view lhs, data::value_view rhs) noexcept
 {
-    auto it1 = lhs.begin();
-    auto it2 = rhs.begin();
-    while (it1 != lhs.end() && it2 != rhs.end()) {
-        auto r = ::compare_unsigned(*it1, *it2);
-        if (r) {
-            return r;
-        }
-        ++it1;
-        ++it2;
-    }
-    if (it1 != lhs.end()) {
-        return 1;
-    } else if (it2 != rhs.end()) {
-        return -1;
-    }
-    return 0;
+    return compare_unsigned<data::value_view, data::value_view>(lhs, rhs);
 }
 
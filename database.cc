@@ -57,6 +57,7 @@
 #include <boost/range/algorithm/sort.hpp>
 #include <boost/range/adaptor/map.hpp>
 #include "frozen_mutation.hh"
+#include "exceptions/exceptions.hh"
 #include <seastar/core/do_with.hh>
 #include "service/migration_manager.hh"
 #include "service/storage_service.hh"
@@ -65,6 +66,7 @@
 #include <seastar/core/fstream.hh>
 #include <seastar/core/enum.hh>
 #include "utils/latency.hh"
+#include "utils/latency_sampler.hh"
 #include "schema_registry.hh"
 #include "service/priority_manager.hh"
 #include "cell_locking.hh"
@@ -112,11 +114,25 @@ make_flush_controller(const db::config& cfg, seastar::scheduling_group sg, const
 
 inline
 std::unique_ptr<compaction_manager>
-make_compaction_manager(const db::config& cfg, database_config& dbcfg) {
+make_compaction_manager(const db::config& cfg, database_config& dbcfg, ::cf_stats& stats) {
     if (cfg.compaction_static_shares() > 0) {
         return std::make_unique<compaction_manager>(dbcfg.compaction_scheduling_group, service::get_local_compaction_priority(), dbcfg.available_memory, cfg.compaction_static_shares());
     }
-    return std::make_unique<compaction_manager>(dbcfg.compaction_scheduling_group, service::get_local_compaction_priority(), dbcfg.available_memory);
+    // The pressure is the largest ratio of the 99th percentile of a local latency to its target.
+    auto latency_pressure = [&cfg, &stats] () -> std::optional<float> {
+        auto read_target = cfg.compaction_read_latency_target_us();
+        auto write_target = cfg.compaction_write_latency_target_us();
+        if (!read_target && !write_target) {
+            return std::nullopt;
+        }
+        auto pressure = [] (utils::decaying_latency_histogram& latencies, uint32_t target) -> float {
+            auto p99 = target ? latencies.percentile(0.99) : std::nullopt;
+            return p99 ? float(p99->count()) / target : 0;
+        };
+        return std::max(pressure(stats.decaying_read, read_target), pressure(stats.decaying_write, write_target));
+    };
+    return std::make_unique<compaction_manager>(dbcfg.compaction_scheduling_group, service::get_local_compaction_priority(), dbcfg.available_memory,
+            std::move(latency_pressure));
 }
 
 lw_shared_ptr<keyspace_metadata>
@@ -197,7 +213,7 @@ database::database(const db::config& cfg, database_config dbcfg, service::migrat
     , _mutation_query_stage()
     , _apply_stage("db_apply", &database::do_apply)
     , _version(empty_version)
-    , _compaction_manager(make_compaction_manager(_cfg, dbcfg))
+    , _compaction_manager(make_compaction_manager(_cfg, dbcfg, _cf_stats))
     , _enable_incremental_backups(cfg.incremental_backups())
     , _querier_cache(_read_concurrency_sem, dbcfg.available_memory * 0.04)
     , _large_data_handler(std::make_unique<db::cql_table_large_data_handler>(_cfg.compaction_large_partition_warning_threshold_mb()*1024*1024,
@@ -209,14 +225,34 @@ database::database(const db::config& cfg, database_config dbcfg, service::migrat
     , _system_sstables_manager(std::make_unique<sstables::sstables_manager>(*_nop_large_data_handler, _cfg, feat))
     , _result_memory_limiter(dbcfg.available_memory / 10)
     , _data_listeners(std::make_unique<db::data_listeners>(*this))
+    , _continuous_toppartitions(std::make_unique<db::continuous_toppartitions_listener>(*this, db::continuous_toppartitions_listener::config{
+            _cfg.toppartitions_sampling_ratio, _cfg.toppartitions_window_in_s, _cfg.toppartitions_capacity}))
     , _mnotifier(mn)
     , _feat(feat)
     , _token_metadata(tm)
 {
     local_schema_registry().init(*this); // TODO: we're never unbound.
+    for (auto sg : dbcfg.service_level_scheduling_groups) {
+        _service_level_read_concurrency_sems.push_back(scheduling_group_semaphore{sg,
+                std::make_unique<reader_concurrency_semaphore>(max_count_concurrent_reads,
+                        max_memory_concurrent_reads(),
+                        format("_read_concurrency_sem[{}]", sg.name()),
+                        max_inactive_queue_length(),
+                        [this] {
+                            ++_stats->sstable_read_queue_overloaded;
+                        })});
+    }
     setup_metrics();
 
     _row_cache_tracker.set_compaction_scheduling_group(dbcfg.memory_compaction_scheduling_group);
+    _row_cache_tracker.set_table_quota_fraction(cfg.table_memory_quota_fraction());
+    _row_cache_tracker.set_compact_on_population(cfg.compact_cache_on_population());
+    _row_cache_tracker.set_compressed_tier_size(size_t(cfg.compressed_cache_size_in_mb()) * 1024 * 1024);
+    _dirty_memory_manager.set_table_quota_fraction(cfg.table_memory_quota_fraction());
+    _user_sstables_manager->set_index_page_cache(&_index_page_cache);
+    _system_sstables_manager->set_index_page_cache(&_index_page_cache);
+    _user_sstables_manager->set_filter_partition_cache(&_filter_partition_cache);
+    _system_sstables_manager->set_filter_partition_cache(&_filter_partition_cache);
 
     dblog.debug("Row: max_vector_size: {}, internal_count: {}", size_t(row::max_vector_size), size_t(row::internal_count));
 
@@ -279,6 +315,31 @@ void backlog_controller::update_controller(float shares) {
     _inflight_update = engine().update_shares_for_class(_io_priority, uint32_t(shares));
 }
 
+void backlog_controller::set_max_shares() {
+    _update_timer.cancel();
+    auto shares = _control_points.empty() ? 1000.0f : _control_points.back().output;
+    _scheduling_group.set_shares(shares);
+    // Unlike update_controller(), there is no next adjustment to catch up, so chain the update.
+    _inflight_update = _inflight_update.then([this, shares] {
+        return engine().update_shares_for_class(_io_priority, uint32_t(shares));
+    });
+}
+
+void compaction_controller::update_controller(float shares) {
+    auto pressure = _latency_pressure ? _latency_pressure() : std::nullopt;
+    if (!pressure) {
+        _latency_scale = 1;
+    } else if (*pressure > 1) {
+        _latency_scale = std::max(_latency_scale * latency_scale_decrease, min_latency_scale);
+    } else if (*pressure < latency_headroom) {
+        _latency_scale = std::min(_latency_scale * latency_scale_increase, max_latency_scale);
+    }
+    if (_latency_scale != 1) {
+        shares = std::min(shares * _latency_scale, _control_points.back().output);
+    }
+    backlog_controller::update_controller(shares);
+}
+
 void
 dirty_memory_manager::setup_collectd(sstring namestr) {
     namespace sm = seastar::metrics;
@@ -291,6 +352,15 @@ dirty_memory_manager::setup_collectd(sstring namestr) {
 
         sm::make_gauge(namestr +"_virtual_dirty_bytes", [this] { return virtual_dirty_memory(); },
                        sm::description("Holds the size of used memory in bytes. Compare it to \"dirty_bytes\" to see how many memory is wasted (neither used nor available).")),
+
+        sm::make_derive(namestr + "_writes_throttled_by_table_quota", [this] { return _writes_throttled_by_quota; },
+                       sm::description("Counts writes which had to wait because their table held more than its share of dirty memory.")),
+
+        sm::make_derive(namestr + "_writes_shed", [this] { return _writes_shed; },
+                       sm::description("Counts writes which were rejected before being applied, because dirty memory throttling would have made them miss their timeout.")),
+
+        sm::make_gauge(namestr + "_write_delay_estimate", [this] { return std::chrono::duration_cast<std::chrono::microseconds>(_write_delay_estimate).count(); },
+                       sm::description("Moving average of the time in microseconds writes waited for dirty memory.")),
     });
 }
 
@@ -371,9 +441,18 @@ database::setup_metrics() {
         sm::make_derive("total_writes_timedout", _stats->total_writes_timedout,
                        sm::description("Counts write operations failed due to a timeout. A positive value is a sign of storage being overloaded.")),
 
+        sm::make_derive("total_writes_shed", _stats->total_writes_shed,
+                       sm::description("Counts write operations rejected before being applied, because they were expected to miss their timeout.")),
+
+        sm::make_derive("total_writes_rate_limited", _stats->total_writes_rate_limited,
+                       sm::description("Counts write operations rejected before being applied, because their partition exceeded the per-partition write rate limit of the table.")),
+
         sm::make_derive("total_reads", _stats->total_reads,
                        sm::description("Counts the total number of successful reads on this shard.")),
 
+        sm::make_derive("total_reads_rate_limited", _stats->total_reads_rate_limited,
+                       sm::description("Counts read operations rejected before being executed, because their partition exceeded the per-partition read rate limit of the table.")),
+
         sm::make_derive("total_reads_failed", _stats->total_reads_failed,
                        sm::description("Counts the total number of failed read operations. "
                                        "Add the total_reads to this value to get the total amount of reads issued on this shard.")),
@@ -387,9 +466,15 @@ database::setup_metrics() {
         sm::make_derive("querier_cache_misses", _querier_cache.get_stats().misses,
                        sm::description("Counts querier cache lookups that failed to find a cached querier")),
 
+        sm::make_derive("querier_cache_range_mismatch_misses", _querier_cache.get_stats().range_mismatch_misses,
+                       sm::description("Counts querier cache misses where queriers were cached for the query but none matched its range(s)")),
+
         sm::make_derive("querier_cache_drops", _querier_cache.get_stats().drops,
                        sm::description("Counts querier cache lookups that found a cached querier but had to drop it due to position mismatch")),
 
+        sm::make_derive("querier_cache_schema_version_drops", _querier_cache.get_stats().schema_version_drops,
+                       sm::description("Counts querier cache drops caused by the schema having changed since the querier was cached")),
+
         sm::make_derive("querier_cache_time_based_evictions", _querier_cache.get_stats().time_based_evictions,
                        sm::description("Counts querier cache entries that timed out and were evicted.")),
 
@@ -432,6 +517,10 @@ database::setup_metrics() {
                                        " to be able to admit new ones, if there is a shortage of permits."),
                        {user_label_instance}),
 
+        sm::make_derive("paused_reads_memory_based_evictions", _read_concurrency_sem.get_inactive_read_stats().memory_based_evictions,
+                       sm::description("The number of paused reads evicted because the shard was running low on memory."),
+                       {user_label_instance}),
+
         sm::make_gauge("active_reads", [this] { return max_count_streaming_concurrent_reads - _streaming_concurrency_sem.available_resources().count; },
                        sm::description("Holds the number of currently active read operations issued on behalf of streaming "),
                        {streaming_label_instance}),
@@ -457,6 +546,10 @@ database::setup_metrics() {
                                        " to be able to admit new ones, if there is a shortage of permits."),
                        {streaming_label_instance}),
 
+        sm::make_derive("paused_reads_memory_based_evictions", _streaming_concurrency_sem.get_inactive_read_stats().memory_based_evictions,
+                       sm::description("The number of paused streaming reads evicted because the shard was running low on memory."),
+                       {streaming_label_instance}),
+
         sm::make_gauge("active_reads", [this] { return max_count_system_concurrent_reads - _system_read_concurrency_sem.available_resources().count; },
                        sm::description("Holds the number of currently active read operations from \"system\" keyspace tables. "),
                        {system_label_instance}),
@@ -481,6 +574,10 @@ database::setup_metrics() {
                                        " to be able to admit new ones, if there is a shortage of permits."),
                        {system_label_instance}),
 
+        sm::make_derive("paused_reads_memory_based_evictions", _system_read_concurrency_sem.get_inactive_read_stats().memory_based_evictions,
+                       sm::description("The number of paused system reads evicted because the shard was running low on memory."),
+                       {system_label_instance}),
+
         sm::make_gauge("total_result_bytes", [this] { return get_result_memory_limiter().total_used_memory(); },
                        sm::description("Holds the current amount of memory used for results.")),
 
@@ -502,12 +599,30 @@ database::setup_metrics() {
         sm::make_derive("multishard_query_failed_reader_saves", _stats->multishard_query_failed_reader_saves,
                        sm::description("The number of times the saving of a shard reader failed.")),
 
+        sm::make_derive("multishard_query_evicted_reader_saves", _stats->multishard_query_evicted_reader_saves,
+                       sm::description("The number of times a shard reader couldn't be saved because it was evicted while paused.")),
+
         sm::make_total_operations("counter_cell_lock_acquisition", _cl_stats->lock_acquisitions,
                                  sm::description("The number of acquired counter cell locks.")),
 
         sm::make_queue_length("counter_cell_lock_pending", _cl_stats->operations_waiting_for_lock,
                              sm::description("The number of counter updates waiting for a lock.")),
 
+        sm::make_derive("counter_cache_hits", [this] { return _counter_cache.get_stats().hits; },
+                       sm::description("The number of counter updates which found the local shards of all their cells in the counter cache and skipped the read.")),
+
+        sm::make_derive("counter_cache_misses", [this] { return _counter_cache.get_stats().misses; },
+                       sm::description("The number of counter updates which had to read the current counter state.")),
+
+        sm::make_derive("counter_cache_evictions", [this] { return _counter_cache.get_stats().evictions; },
+                       sm::description("The number of partitions evicted from the counter cache.")),
+
+        sm::make_derive("counter_cache_invalidations", [this] { return _counter_cache.get_stats().invalidations; },
+                       sm::description("The number of partitions invalidated in the counter cache by deletions, schema changes, truncation and sstable loading.")),
+
+        sm::make_gauge("counter_cache_bytes", [this] { return _counter_cache.get_stats().bytes; },
+                       sm::description("The memory used by the counter cache.")),
+
         sm::make_counter("large_partition_exceeding_threshold", [this] { return _large_data_handler->stats().partitions_bigger_than_threshold; },
             sm::description("Number of large partitions exceeding compaction_large_partition_warning_threshold_mb. "
                 "Large partitions have performance impact and should be avoided, check the documentation for details.")),
@@ -524,6 +639,14 @@ database::setup_metrics() {
         sm::make_total_operations("total_view_updates_failed_remote", _cf_stats.total_view_updates_failed_remote,
                 sm::description("Total number of view updates generated for tables and failed to be sent to remote replicas.")),
     });
+    for (auto& sls : _service_level_read_concurrency_sems) {
+        _metrics.add_group("database", {
+            sm::make_gauge("queued_reads", [sem = sls.semaphore.get()] { return sem->waiters(); },
+                           sm::description("Holds the number of currently queued read operations."),
+                           {class_label(sls.sg.name())}),
+        });
+    }
+
     if (this_shard_id() == 0) {
         _metrics.add_group("database", {
                 sm::make_derive("schema_changed", _schema_change_count,
@@ -536,6 +659,9 @@ database::~database() {
     _read_concurrency_sem.clear_inactive_reads();
     _streaming_concurrency_sem.clear_inactive_reads();
     _system_read_concurrency_sem.clear_inactive_reads();
+    for (auto& sls : _service_level_read_concurrency_sems) {
+        sls.semaphore->clear_inactive_reads();
+    }
 }
 
 void database::update_version(const utils::UUID& version) {
@@ -604,6 +730,15 @@ future<> database::parse_system_tables(distributed<service::storage_proxy>& prox
             }
             return make_ready_future<>();
         });
+    }).then([&proxy, this] {
+        return do_parse_schema_tables(proxy, db::schema_tables::AGGREGATES, [this, &proxy] (schema_result_value_type& v) {
+            return read_schema_partition_for_keyspace(proxy, db::schema_tables::SCYLLA_AGGREGATES, v.first).then([this, &v] (schema_result_value_type scylla) {
+                auto&& user_aggregates = create_aggregates_from_schema_partition(*this, v.second, scylla.second);
+                for (auto&& aggregate : user_aggregates) {
+                    cql3::functions::functions::add_function(aggregate);
+                }
+            });
+        });
     }).then([&proxy, this] {
         return do_parse_schema_tables(proxy, db::schema_tables::TABLES, [this, &proxy] (schema_result_value_type &v) {
             return create_tables_from_tables_partition(proxy, v.second).then([this] (std::map<sstring, schema_ptr> tables) {
@@ -720,6 +855,10 @@ bool database::update_column_family(schema_ptr new_schema) {
     auto s = local_schema_registry().learn(new_schema);
     s->registry_entry()->mark_synced();
     cfm.set_schema(s);
+    if (columns_changed) {
+        // Cached cells are identified by column id.
+        _counter_cache.invalidate(s->id());
+    }
     find_keyspace(s->ks_name()).metadata()->add_or_update_column_family(s);
     if (s->is_view()) {
         try {
@@ -736,6 +875,7 @@ void database::remove(const column_family& cf) {
     auto s = cf.schema();
     auto& ks = find_keyspace(s->ks_name());
     _querier_cache.evict_all_for_table(s->id());
+    _counter_cache.invalidate(s->id());
     _column_families.erase(s->id());
     ks.metadata()->remove_column_family(s);
     _ks_cf_to_uuid.erase(std::make_pair(s->ks_name(), s->cf_name()));
@@ -901,19 +1041,31 @@ keyspace::make_column_family_config(const schema& s, const database& db) const {
     for (auto& extra : _config.all_datadirs) {
         cfg.all_datadirs.push_back(column_family_directory(extra, s.cf_name(), s.id()));
     }
+    for (auto& slow : _config.slow_datadirs) {
+        cfg.slow_datadirs.push_back(column_family_directory(slow, s.cf_name(), s.id()));
+    }
     cfg.datadir = cfg.all_datadirs[0];
     cfg.enable_disk_reads = _config.enable_disk_reads;
     cfg.enable_disk_writes = _config.enable_disk_writes;
     cfg.enable_commitlog = _config.enable_commitlog;
     cfg.enable_cache = _config.enable_cache;
     cfg.enable_dangerous_direct_import_of_cassandra_counters = _config.enable_dangerous_direct_import_of_cassandra_counters;
+    cfg.shared_sstable_reshard_threshold = _config.shared_sstable_reshard_threshold;
     cfg.compaction_enforce_min_threshold = _config.compaction_enforce_min_threshold;
+    cfg.compaction_max_parallel_subranges = _config.compaction_max_parallel_subranges;
+    cfg.memtable_flush_max_parallel_subranges = _config.memtable_flush_max_parallel_subranges;
+    cfg.repair_tombstone_gc_propagation_delay_in_s = db_config.repair_tombstone_gc_propagation_delay_in_s;
     cfg.dirty_memory_manager = _config.dirty_memory_manager;
     cfg.streaming_dirty_memory_manager = _config.streaming_dirty_memory_manager;
     cfg.read_concurrency_semaphore = _config.read_concurrency_semaphore;
     cfg.streaming_read_concurrency_semaphore = _config.streaming_read_concurrency_semaphore;
+    cfg.scheduling_group_semaphores = _config.scheduling_group_semaphores;
     cfg.cf_stats = _config.cf_stats;
     cfg.enable_incremental_backups = _config.enable_incremental_backups;
+    auto name = format("{}.{}", s.ks_name(), s.cf_name());
+    cfg.append_only_ingest = boost::algorithm::any_of(db_config.append_only_ingest_tables(), [&name] (const sstring& t) {
+        return t == name;
+    });
     cfg.compaction_scheduling_group = _config.compaction_scheduling_group;
     cfg.memory_compaction_scheduling_group = _config.memory_compaction_scheduling_group;
     cfg.memtable_scheduling_group = _config.memtable_scheduling_group;
@@ -1169,17 +1321,28 @@ future<lw_shared_ptr<query::result>, cache_temperature>
 database::query(schema_ptr s, const query::read_command& cmd, query::result_options opts, const dht::partition_range_vector& ranges,
                 tracing::trace_state_ptr trace_state, uint64_t max_result_size, db::timeout_clock::time_point timeout) {
     column_family& cf = find_column_family(cmd.cf_id);
+    if (auto limit = s->per_partition_rate_limit_options().max_reads_per_second(); limit && ranges.size() == 1 && ranges.front().is_singular()) {
+        auto& token = ranges.front().start()->value().token();
+        if (_rate_limiter.increase(db::rate_limiter::op_type::read, s->id(), token) > *limit) {
+            ++_stats->total_reads_failed;
+            ++_stats->total_reads_rate_limited;
+            return make_exception_future<lw_shared_ptr<query::result>, cache_temperature>(
+                    exceptions::rate_limit_exception(s->ks_name(), s->cf_name(), "read"));
+        }
+    }
     query::querier_cache_context cache_ctx(_querier_cache, cmd.query_uuid, cmd.is_first_page);
-    return _data_query_stage(&cf,
-            std::move(s),
-            seastar::cref(cmd),
-            opts,
-            seastar::cref(ranges),
-            std::move(trace_state),
-            seastar::ref(get_result_memory_limiter()),
-            max_result_size,
-            timeout,
-            std::move(cache_ctx)).then_wrapped([this, s = _stats, hit_rate = cf.get_global_cache_hit_rate(), op = cf.read_in_progress()] (auto f) {
+    return utils::sample_latency(utils::latency_stage::replica_read, [&] {
+        return _data_query_stage(&cf,
+                std::move(s),
+                seastar::cref(cmd),
+                opts,
+                seastar::cref(ranges),
+                std::move(trace_state),
+                seastar::ref(get_result_memory_limiter()),
+                max_result_size,
+                timeout,
+                std::move(cache_ctx));
+    }).then_wrapped([this, s = _stats, hit_rate = cf.get_global_cache_hit_rate(), op = cf.read_in_progress()] (auto f) {
         if (f.failed()) {
             ++s->total_reads_failed;
             return make_exception_future<lw_shared_ptr<query::result>, cache_temperature>(f.get_exception());
@@ -1192,23 +1355,55 @@ database::query(schema_ptr s, const query::read_command& cmd, query::result_opti
     });
 }
 
+future<std::vector<lw_shared_ptr<query::result>>, cache_temperature>
+database::query_partitions(schema_ptr s, const query::read_command& cmd, const dht::partition_range_vector& ranges,
+                           tracing::trace_state_ptr trace_state, uint64_t max_result_size, db::timeout_clock::time_point timeout) {
+    column_family& cf = find_column_family(cmd.cf_id);
+    if (auto limit = s->per_partition_rate_limit_options().max_reads_per_second()) {
+        for (auto& pr : ranges) {
+            auto& token = pr.start()->value().token();
+            if (_rate_limiter.increase(db::rate_limiter::op_type::read, s->id(), token) > *limit) {
+                ++_stats->total_reads_failed;
+                ++_stats->total_reads_rate_limited;
+                return make_exception_future<std::vector<lw_shared_ptr<query::result>>, cache_temperature>(
+                        exceptions::rate_limit_exception(s->ks_name(), s->cf_name(), "read"));
+            }
+        }
+    }
+    return utils::sample_latency(utils::latency_stage::replica_read, [&] {
+        return cf.query_partitions(std::move(s), cmd, ranges, std::move(trace_state), get_result_memory_limiter(), max_result_size, timeout);
+    }).then_wrapped([this, s = _stats, hit_rate = cf.get_global_cache_hit_rate(), op = cf.read_in_progress()] (auto f) {
+        if (f.failed()) {
+            ++s->total_reads_failed;
+            return make_exception_future<std::vector<lw_shared_ptr<query::result>>, cache_temperature>(f.get_exception());
+        } else {
+            ++s->total_reads;
+            auto results = f.get0();
+            s->short_data_queries += !results.empty() && results.back()->is_short_read();
+            return make_ready_future<std::vector<lw_shared_ptr<query::result>>, cache_temperature>(std::move(results), hit_rate);
+        }
+    });
+}
+
 future<reconcilable_result, cache_temperature>
 database::query_mutations(schema_ptr s, const query::read_command& cmd, const dht::partition_range& range,
                           query::result_memory_accounter&& accounter, tracing::trace_state_ptr trace_state, db::timeout_clock::time_point timeout) {
     column_family& cf = find_column_family(cmd.cf_id);
     query::querier_cache_context cache_ctx(_querier_cache, cmd.query_uuid, cmd.is_first_page);
-    return _mutation_query_stage(std::move(s),
-            cf.as_mutation_source(),
-            seastar::cref(range),
-            seastar::cref(cmd.slice),
-            cmd.row_limit,
-            cmd.partition_limit,
-            cmd.timestamp,
-            timeout,
-            cf.get_config().max_memory_for_unlimited_query,
-            std::move(accounter),
-            std::move(trace_state),
-            std::move(cache_ctx)).then_wrapped([this, s = _stats, hit_rate = cf.get_global_cache_hit_rate(), op = cf.read_in_progress()] (auto f) {
+    return utils::sample_latency(utils::latency_stage::replica_read, [&] {
+        return _mutation_query_stage(std::move(s),
+                cf.as_mutation_source(),
+                seastar::cref(range),
+                seastar::cref(cmd.slice),
+                cmd.row_limit,
+                cmd.partition_limit,
+                cmd.timestamp,
+                timeout,
+                cf.get_config().max_memory_for_unlimited_query,
+                std::move(accounter),
+                std::move(trace_state),
+                std::move(cache_ctx));
+    }).then_wrapped([this, s = _stats, hit_rate = cf.get_global_cache_hit_rate(), op = cf.read_in_progress()] (auto f) {
         if (f.failed()) {
             ++s->total_reads_failed;
             return make_exception_future<reconcilable_result, cache_temperature>(f.get_exception());
@@ -1322,16 +1517,24 @@ future<mutation> database::do_apply_counter_update(column_family& cf, const froz
             // deltas to counter shards. To do that, we need to read the current
             // counter state for each modified cell...
 
-            tracing::trace(trace_state, "Reading counter values from the CF");
-            return counter_write_query(m_schema, cf.as_mutation_source(), m.decorated_key(), slice, trace_state)
-                    .then([this, &cf, &m, m_schema, timeout, trace_state] (auto mopt) {
+            // ...unless the counter cache has the local shards of all of them.
+            auto read_state = [&] () -> future<mutation_opt> {
+                if (auto cached = _counter_cache.get_local_shards(m)) {
+                    tracing::trace(trace_state, "Counter values found in the counter cache");
+                    return make_ready_future<mutation_opt>(std::move(cached));
+                }
+                tracing::trace(trace_state, "Reading counter values from the CF");
+                return counter_write_query(m_schema, cf.as_mutation_source(), m.decorated_key(), slice, trace_state);
+            };
+            return read_state().then([this, &cf, &m, m_schema, timeout, trace_state] (auto mopt) {
                 // ...now, that we got existing state of all affected counter
                 // cells we can look for our shard in each of them, increment
                 // its clock and apply the delta.
                 transform_counter_updates_to_shards(m, mopt ? &*mopt : nullptr, cf.failed_counter_applies_to_memtable());
                 tracing::trace(trace_state, "Applying counter update");
                 return this->apply_with_commitlog(cf, m, timeout);
-            }).then([&m] {
+            }).then([this, &m] {
+                _counter_cache.populate(m);
                 return std::move(m);
             });
         });
@@ -1373,20 +1576,69 @@ future<> memtable_list::request_flush() {
 }
 
 lw_shared_ptr<memtable> memtable_list::new_memtable() {
-    return make_lw_shared<memtable>(_current_schema(), *_dirty_memory_manager, _table_stats, this, _compaction_scheduling_group);
+    auto mt = make_lw_shared<memtable>(_current_schema(), *_dirty_memory_manager, _table_stats, this, _compaction_scheduling_group);
+    mt->set_append_only_ingest(_append_only_ingest);
+    return mt;
 }
 
 future<flush_permit> flush_permit::reacquire_sstable_write_permit() && {
     return _manager->get_flush_permit(std::move(_background_permit));
 }
 
+size_t memtable_list::virtual_dirty_memory() const {
+    size_t size = 0;
+    for (auto& m : _memtables) {
+        size += m->virtual_dirty_size();
+    }
+    return size;
+}
+
 future<> dirty_memory_manager::flush_one(memtable_list& mtlist, flush_permit&& permit) {
     return mtlist.seal_active_memtable_immediate(std::move(permit)).handle_exception([this, schema = mtlist.back()->schema()] (std::exception_ptr ep) {
         dblog.error("Failed to flush memtable, {}:{} - {}", schema->ks_name(), schema->cf_name(), ep);
         return make_exception_future<>(ep);
+    }).finally([this] {
+        _quota_relief.broadcast();
+    });
+}
+
+bool dirty_memory_manager::over_quota(const memtable_list& mtlist) const {
+    return _table_quota_fraction && mtlist.virtual_dirty_memory() > throttle_threshold() * _table_quota_fraction;
+}
+
+memtable_list* dirty_memory_manager::largest_over_quota() {
+    if (!_table_quota_fraction) {
+        return nullptr;
+    }
+    memtable_list* largest = nullptr;
+    size_t largest_size = throttle_threshold() * _table_quota_fraction;
+    for (memtable_list* mtlist : _memtable_lists) {
+        auto size = mtlist->virtual_dirty_memory();
+        if (size > largest_size && mtlist->may_flush() && mtlist->active_memtable().region().evictable_occupancy()) {
+            largest = mtlist;
+            largest_size = size;
+        }
+    }
+    return largest;
+}
+
+future<> dirty_memory_manager::wait_for_quota(const memtable_list& mtlist, db::timeout_clock::time_point timeout) {
+    auto permitted = [this, &mtlist] {
+        return !has_pressure() || !over_quota(mtlist) || _db_shutdown_requested;
+    };
+    if (permitted()) {
+        return make_ready_future<>();
+    }
+    ++_writes_throttled_by_quota;
+    return _quota_relief.wait(timeout, std::move(permitted)).handle_exception_type([] (const condition_variable_timed_out&) {
+        return make_exception_future<>(timed_out_error());
     });
 }
 
+void dirty_memory_manager::stop_reclaiming() noexcept {
+    _quota_relief.broadcast();
+}
+
 future<> dirty_memory_manager::flush_when_needed() {
     if (!_db) {
         return make_ready_future<>();
@@ -1413,6 +1665,13 @@ future<> dirty_memory_manager::flush_when_needed() {
                 // memtable. The advantage of doing this is that this is objectively the one that will
                 // release the biggest amount of memory and is less likely to be generating tiny
                 // SSTables.
+                //
+                // Tables over their quota go first though, even if their memtables are not the
+                // largest, so that they don't hold back writes to other tables for long.
+                if (auto over_quota = largest_over_quota()) {
+                    (void)this->flush_one(*over_quota, std::move(permit));
+                    return make_ready_future<>();
+                }
                 memtable& candidate_memtable = memtable::from_region(*(this->_virtual_region_group.get_largest_region()));
                 memtable_list& mtlist = *(candidate_memtable.get_memtable_list());
 
@@ -1449,15 +1708,23 @@ future<> database::apply_in_memory(const frozen_mutation& m, schema_ptr m_schema
 
     data_listeners().on_write(m_schema, m);
 
-    return cf.dirty_memory_region_group().run_when_memory_available([this, &m, m_schema = std::move(m_schema), h = std::move(h), &cf]() mutable {
-        cf.apply(m, m_schema, std::move(h));
-    }, timeout);
+    auto start = db::timeout_clock::now();
+    return cf.wait_for_dirty_memory_quota(timeout).then([this, &m, m_schema = std::move(m_schema), h = std::move(h), &cf, timeout, start] () mutable {
+        return cf.dirty_memory_region_group().run_when_memory_available([this, &m, m_schema = std::move(m_schema), h = std::move(h), &cf, start]() mutable {
+            cf.record_write_delay(db::timeout_clock::now() - start);
+            cf.apply(m, m_schema, std::move(h));
+        }, timeout);
+    });
 }
 
 future<> database::apply_in_memory(const mutation& m, column_family& cf, db::rp_handle&& h, db::timeout_clock::time_point timeout) {
-    return cf.dirty_memory_region_group().run_when_memory_available([this, &m, &cf, h = std::move(h)]() mutable {
-        cf.apply(m, std::move(h));
-    }, timeout);
+    auto start = db::timeout_clock::now();
+    return cf.wait_for_dirty_memory_quota(timeout).then([this, &m, &cf, h = std::move(h), timeout, start] () mutable {
+        return cf.dirty_memory_region_group().run_when_memory_available([this, &m, &cf, h = std::move(h), start]() mutable {
+            cf.record_write_delay(db::timeout_clock::now() - start);
+            cf.apply(m, std::move(h));
+        }, timeout);
+    });
 }
 
 future<mutation> database::apply_counter_update(schema_ptr s, const frozen_mutation& m, db::timeout_clock::time_point timeout, tracing::trace_state_ptr trace_state) {
@@ -1528,6 +1795,10 @@ future<> database::do_apply(schema_ptr s, const frozen_mutation& m, db::timeout_
 
     sync = sync || db::commitlog::force_sync(s->wait_for_sync_to_commitlog());
 
+    if (s->is_counter()) {
+        _counter_cache.on_write(*s, m);
+    }
+
     // Signal to view building code that a write is in progress,
     // so it knows when new writes start being sent to a new view.
     auto op = cf.write_in_progress();
@@ -1575,7 +1846,26 @@ future<> database::apply(schema_ptr s, const frozen_mutation& m, db::commitlog::
         update_write_metrics_for_timed_out_write();
         return make_exception_future<>(timed_out_error{});
     }
-    return update_write_metrics(_apply_stage(this, std::move(s), seastar::cref(m), timeout, sync));
+    if (_cfg.write_shedding_enabled() && timeout != db::no_timeout) {
+        auto it = _column_families.find(m.column_family_id());
+        if (it != _column_families.end() && it->second->write_would_miss_deadline(timeout)) {
+            ++_stats->total_writes;
+            ++_stats->total_writes_failed;
+            ++_stats->total_writes_shed;
+            return make_exception_future<>(replica_overloaded_exception());
+        }
+    }
+    if (auto limit = s->per_partition_rate_limit_options().max_writes_per_second()) {
+        if (_rate_limiter.increase(db::rate_limiter::op_type::write, s->id(), dht::get_token(*s, m.key())) > *limit) {
+            ++_stats->total_writes;
+            ++_stats->total_writes_failed;
+            ++_stats->total_writes_rate_limited;
+            return make_exception_future<>(exceptions::rate_limit_exception(s->ks_name(), s->cf_name(), "write"));
+        }
+    }
+    return update_write_metrics(utils::sample_latency(utils::latency_stage::replica_write, [&] {
+        return _apply_stage(this, std::move(s), seastar::cref(m), timeout, sync);
+    }));
 }
 
 future<> database::apply_hint(schema_ptr s, const frozen_mutation& m, db::timeout_clock::time_point timeout) {
@@ -1596,6 +1886,10 @@ future<> database::apply_streaming_mutation(schema_ptr s, utils::UUID plan_id, c
         return _streaming_dirty_memory_manager.region_group().run_when_memory_available([this, &m, plan_id, fragmented, s = std::move(s)] {
             auto uuid = m.column_family_id();
             auto& cf = find_column_family(uuid);
+            if (s->is_counter()) {
+                // Streamed cells may carry shards of this node's counter id.
+                _counter_cache.invalidate(uuid, m.key().representation());
+            }
             cf.apply_streaming_mutation(s, plan_id, std::move(m), fragmented);
         }, db::no_timeout);
     });
@@ -1609,6 +1903,14 @@ database::make_keyspace_config(const keyspace_metadata& ksm) {
         for (auto& extra : _cfg.data_file_directories()) {
             cfg.all_datadirs.push_back(format("{}/{}", extra, ksm.name()));
         }
+        // Only directories which are loaded on startup can hold sstables,
+        // and the first one receives new sstables.
+        auto& dirs = _cfg.data_file_directories();
+        for (size_t i = 1; i < dirs.size(); ++i) {
+            if (boost::algorithm::any_of_equal(_cfg.slow_data_file_directories(), dirs[i])) {
+                cfg.slow_datadirs.push_back(format("{}/{}", dirs[i], ksm.name()));
+            }
+        }
         cfg.enable_disk_writes = !_cfg.enable_in_memory_data_store();
         cfg.enable_disk_reads = true; // we allways read from disk
         cfg.enable_commitlog = ksm.durable_writes() && _cfg.enable_commitlog() && !_cfg.enable_in_memory_data_store();
@@ -1622,11 +1924,15 @@ database::make_keyspace_config(const keyspace_metadata& ksm) {
         cfg.enable_cache = false;
     }
     cfg.enable_dangerous_direct_import_of_cassandra_counters = _cfg.enable_dangerous_direct_import_of_cassandra_counters();
+    cfg.shared_sstable_reshard_threshold = _cfg.shared_sstable_reshard_threshold();
     cfg.compaction_enforce_min_threshold = _cfg.compaction_enforce_min_threshold;
+    cfg.compaction_max_parallel_subranges = _cfg.compaction_max_parallel_subranges;
+    cfg.memtable_flush_max_parallel_subranges = _cfg.memtable_flush_max_parallel_subranges;
     cfg.dirty_memory_manager = &_dirty_memory_manager;
     cfg.streaming_dirty_memory_manager = &_streaming_dirty_memory_manager;
     cfg.read_concurrency_semaphore = &_read_concurrency_sem;
     cfg.streaming_read_concurrency_semaphore = &_streaming_concurrency_sem;
+    cfg.scheduling_group_semaphores = &_service_level_read_concurrency_sems;
     cfg.cf_stats = &_cf_stats;
     cfg.enable_incremental_backups = _enable_incremental_backups;
 
@@ -1772,6 +2078,13 @@ database::stop() {
     });
 }
 
+void database::expedite_flushes() {
+    _system_dirty_memory_manager.unserialize_flushes();
+    _dirty_memory_manager.unserialize_flushes();
+    _streaming_dirty_memory_manager.unserialize_flushes();
+    _memtable_controller.set_max_shares();
+}
+
 future<> database::flush_all_memtables() {
     return parallel_for_each(_column_families, [this] (auto& cfp) {
         return cfp.second->flush();
@@ -1819,6 +2132,7 @@ future<> database::truncate(const keyspace& ks, column_family& cf, timestamp_fun
                     }
                     return f.then([this, &cf, truncated_at, low_mark, should_flush] {
                         return cf.discard_sstables(truncated_at).then([this, &cf, truncated_at, low_mark, should_flush](db::replay_position rp) {
+                            _counter_cache.invalidate(cf.schema()->id());
                             // TODO: indexes.
                             // Note: since discard_sstables was changed to only count tables owned by this shard,
                             // we can get zero rp back. Changed assert, and ensure we save at least low_mark.
@@ -1866,6 +2180,21 @@ static sstring get_snapshot_table_dir_prefix(const sstring& table_name) {
 
 // For the filesystem operations, this code will assume that all keyspaces are visible in all shards
 // (as we have been doing for a lot of the other operations, like the snapshot itself).
+// Removes the snapshot named *tag_ptr from snapshots_dir, or all of them if the tag is empty.
+static future<> remove_snapshots(fs::path snapshots_dir, lw_shared_ptr<sstring> tag_ptr, lw_shared_ptr<lister::dir_entry_types> dirs_only_entries_ptr) {
+    if (tag_ptr->empty()) {
+        dblog.info("Removing {}", snapshots_dir.native());
+        // kill the whole "snapshots" subdirectory
+        return lister::rmdir(std::move(snapshots_dir));
+    } else {
+        return lister::scan_dir(std::move(snapshots_dir), *dirs_only_entries_ptr, [tag_ptr] (fs::path parent_dir, directory_entry de) {
+            fs::path snapshot_dir(parent_dir / de.name);
+            dblog.info("Removing {}", snapshot_dir.native());
+            return lister::rmdir(std::move(snapshot_dir));
+        }, [tag_ptr] (const fs::path& parent_dir, const directory_entry& dir_entry) { return dir_entry.name == *tag_ptr; });
+    }
+}
+
 future<> database::clear_snapshot(sstring tag, std::vector<sstring> keyspace_names, const sstring& table_name) {
     std::vector<sstring> data_dirs = _cfg.data_file_directories();
     lw_shared_ptr<lister::dir_entry_types> dirs_only_entries_ptr = make_lw_shared<lister::dir_entry_types>({ directory_entry_type::directory });
@@ -1899,6 +2228,9 @@ future<> database::clear_snapshot(sstring tag, std::vector<sstring> keyspace_nam
         //  |          |- ...
         //  |        |- <snapshot name2>
         //  |        |- ...
+        //  |     |- cold
+        //  |        |- snapshots
+        //  |           |- ...
         //  |  |- <column family name2>
         //  |  |- ...
         //  |- <keyspace name2>
@@ -1908,21 +2240,16 @@ future<> database::clear_snapshot(sstring tag, std::vector<sstring> keyspace_nam
             // KS directory
             return lister::scan_dir(parent_dir / de.name, *dirs_only_entries_ptr, [this, tag_ptr, dirs_only_entries_ptr] (fs::path parent_dir, directory_entry de) mutable {
                 // CF directory
-                return lister::scan_dir(parent_dir / de.name, *dirs_only_entries_ptr, [this, tag_ptr, dirs_only_entries_ptr] (fs::path parent_dir, directory_entry de) mutable {
-                    // "snapshots" directory
-                    fs::path snapshots_dir(parent_dir / de.name);
-                    if (tag_ptr->empty()) {
-                        dblog.info("Removing {}", snapshots_dir.native());
-                        // kill the whole "snapshots" subdirectory
-                        return lister::rmdir(std::move(snapshots_dir));
-                    } else {
-                        return lister::scan_dir(std::move(snapshots_dir), *dirs_only_entries_ptr, [this, tag_ptr] (fs::path parent_dir, directory_entry de) {
-                            fs::path snapshot_dir(parent_dir / de.name);
-                            dblog.info("Removing {}", snapshot_dir.native());
-                            return lister::rmdir(std::move(snapshot_dir));
-                        }, [tag_ptr] (const fs::path& parent_dir, const directory_entry& dir_entry) { return dir_entry.name == *tag_ptr; });
+                return lister::scan_dir(parent_dir / de.name, *dirs_only_entries_ptr, [tag_ptr, dirs_only_entries_ptr] (fs::path parent_dir, directory_entry de) mutable {
+                    if (de.name == "cold") {
+                        // Offloaded sstables have their snapshots in cold/snapshots
+                        return lister::scan_dir(parent_dir / de.name, *dirs_only_entries_ptr, [tag_ptr, dirs_only_entries_ptr] (fs::path parent_dir, directory_entry de) {
+                            return remove_snapshots(parent_dir / de.name, tag_ptr, dirs_only_entries_ptr);
+                        }, [] (const fs::path& parent_dir, const directory_entry& dir_entry) { return dir_entry.name == "snapshots"; });
                     }
-                 }, [] (const fs::path& parent_dir, const directory_entry& dir_entry) { return dir_entry.name == "snapshots"; });
+                    // "snapshots" directory
+                    return remove_snapshots(parent_dir / de.name, tag_ptr, dirs_only_entries_ptr);
+                 }, [] (const fs::path& parent_dir, const directory_entry& dir_entry) { return dir_entry.name == "snapshots" || dir_entry.name == "cold"; });
             }, table_filter);
         }, *filter);
     });
@@ -1990,7 +2317,7 @@ template <typename T>
 using foreign_unique_ptr = foreign_ptr<std::unique_ptr<T>>;
 
 flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db, schema_ptr schema,
-        std::function<std::optional<dht::partition_range>()> range_generator) {
+        std::function<std::optional<dht::partition_range>()> range_generator, bool unrepaired_only) {
     class streaming_reader_lifecycle_policy
             : public reader_lifecycle_policy
             , public enable_shared_from_this<streaming_reader_lifecycle_policy> {
@@ -2000,9 +2327,11 @@ flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db,
             reader_concurrency_semaphore* semaphore;
         };
         distributed<database>& _db;
+        bool _unrepaired_only;
         std::vector<reader_context> _contexts;
     public:
-        explicit streaming_reader_lifecycle_policy(distributed<database>& db) : _db(db), _contexts(smp::count) {
+        streaming_reader_lifecycle_policy(distributed<database>& db, bool unrepaired_only)
+                : _db(db), _unrepaired_only(unrepaired_only), _contexts(smp::count) {
         }
         virtual flat_mutation_reader create_reader(
                 schema_ptr schema,
@@ -2018,6 +2347,9 @@ flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db,
             _contexts[shard].read_operation = make_foreign(std::make_unique<utils::phased_barrier::operation>(cf.read_in_progress()));
             _contexts[shard].semaphore = &cf.streaming_read_concurrency_semaphore();
 
+            if (_unrepaired_only) {
+                return cf.make_unrepaired_streaming_reader(std::move(schema), *_contexts[shard].range, slice, fwd_mr);
+            }
             return cf.make_streaming_reader(std::move(schema), *_contexts[shard].range, slice, fwd_mr);
         }
         virtual void destroy_reader(shard_id shard, future<stopped_reader> reader_fut) noexcept override {
@@ -2034,7 +2366,7 @@ flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db,
             return *_contexts[this_shard_id()].semaphore;
         }
     };
-    auto ms = mutation_source([&db] (schema_ptr s,
+    auto ms = mutation_source([&db, unrepaired_only] (schema_ptr s,
             reader_permit,
             const dht::partition_range& pr,
             const query::partition_slice& ps,
@@ -2042,7 +2374,7 @@ flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db,
             tracing::trace_state_ptr trace_state,
             streamed_mutation::forwarding,
             mutation_reader::forwarding fwd_mr) {
-        return make_multishard_combining_reader(make_shared<streaming_reader_lifecycle_policy>(db), std::move(s), pr, ps, pc,
+        return make_multishard_combining_reader(make_shared<streaming_reader_lifecycle_policy>(db, unrepaired_only), std::move(s), pr, ps, pc,
                 std::move(trace_state), fwd_mr);
     });
     auto&& full_slice = schema->full_slice();
@@ -70,9 +70,17 @@
 #include "utils/exponential_backoff_retry.hh"
 #include "utils/histogram.hh"
 #include "utils/estimated_histogram.hh"
+#include "utils/decaying_histogram.hh"
+#include "utils/activity.hh"
 #include "sstables/sstable_set.hh"
 #include "sstables/progress_monitor.hh"
 #include "sstables/version.hh"
+#include "sstables/index_page_cache.hh"
+#include "sstables/filter_partition_cache.hh"
+#include "sstables/hyperloglog.hh"
+#include "db/counter_cache.hh"
+#include "db/repair_history.hh"
+#include "db/rate_limiter.hh"
 #include <seastar/core/rwlock.hh>
 #include <seastar/core/shared_future.hh>
 #include <seastar/core/metrics_registration.hh>
@@ -124,6 +132,7 @@ class compaction_descriptor;
 class compaction_completion_desc;
 class foreign_sstable_open_info;
 class sstables_manager;
+class sstable_writer_config;
 
 }
 
@@ -140,6 +149,7 @@ class config;
 class extensions;
 class rp_handle;
 class data_listeners;
+class continuous_toppartitions_listener;
 class large_data_handler;
 
 namespace system_keyspace {
@@ -149,6 +159,13 @@ void make(database& db, bool durable, bool volatile_testing_only);
 
 class mutation_reordered_with_truncate_exception : public std::exception {};
 
+// A write was rejected before being applied, because the replica is too
+// overloaded to apply it before its timeout.
+class replica_overloaded_exception : public std::runtime_error {
+public:
+    replica_overloaded_exception() : std::runtime_error("Write rejected: the replica can't apply it before its timeout") {}
+};
+
 using shared_memtable = lw_shared_ptr<memtable>;
 class memtable_list;
 
@@ -183,6 +200,7 @@ class memtable_list {
     std::optional<shared_promise<>> _flush_coalescing;
     seastar::scheduling_group _compaction_scheduling_group;
     table_stats& _table_stats;
+    bool _append_only_ingest = false;
 public:
     memtable_list(
             seal_immediate_fn_type seal_immediate_fn,
@@ -199,6 +217,9 @@ class memtable_list {
         , _compaction_scheduling_group(compaction_scheduling_group)
         , _table_stats(table_stats) {
         add_memtable();
+        if (_dirty_memory_manager) {
+            _dirty_memory_manager->register_memtable_list(*this);
+        }
     }
 
     memtable_list(
@@ -216,6 +237,14 @@ class memtable_list {
         : memtable_list({}, {}, std::move(cs), dirty_memory_manager, table_stats, compaction_scheduling_group) {
     }
 
+    memtable_list(const memtable_list&) = delete;
+
+    ~memtable_list() {
+        if (_dirty_memory_manager) {
+            _dirty_memory_manager->unregister_memtable_list(*this);
+        }
+    }
+
     bool may_flush() const {
         return bool(_seal_immediate_fn);
     }
@@ -279,6 +308,16 @@ class memtable_list {
         _memtables.emplace_back(new_memtable());
     }
 
+    // Makes the active memtable and the ones added later buffer the writes,
+    // see memtable::set_append_only_ingest().
+    void set_append_only_ingest(bool enabled) {
+        _append_only_ingest = enabled;
+        active_memtable().set_append_only_ingest(enabled);
+    }
+
+    // Memory used by the memtables which is not yet accounted as flushed.
+    size_t virtual_dirty_memory() const;
+
     logalloc::region_group& region_group() {
         return _dirty_memory_manager->region_group();
     }
@@ -323,6 +362,11 @@ struct cf_stats {
     uint64_t total_view_updates_pushed_remote = 0;
     uint64_t total_view_updates_failed_local = 0;
     uint64_t total_view_updates_failed_remote = 0;
+
+    // Local read and write latencies of all tables of the shard, which
+    // the compaction controller tries to keep under their targets.
+    utils::decaying_latency_histogram decaying_read;
+    utils::decaying_latency_histogram decaying_write;
 };
 
 class table;
@@ -356,27 +400,55 @@ struct table_stats {
     utils::estimated_histogram estimated_cas_propose;
     utils::estimated_histogram estimated_cas_commit;
     utils::estimated_histogram estimated_sstable_per_read{35};
+    // Read amplification of the reads that selected at least one sstable, see sstable_read_stats.
+    utils::estimated_histogram estimated_sstables_filtered_by_bloom_filter_per_read{35};
+    utils::estimated_histogram estimated_sstables_filtered_by_clustering_filter_per_read{35};
+    utils::estimated_histogram estimated_sstable_bytes_per_read;
+    // Memory footprint of the data these reads produced, which the adaptive
+    // compression mode sizes the chunks of the sstables of the table after.
+    utils::estimated_histogram estimated_sstable_read_size;
+    // Decaying counterparts of estimated_read and estimated_write, for
+    // percentiles that reflect recent latencies.
+    utils::decaying_latency_histogram decaying_read;
+    utils::decaying_latency_histogram decaying_write;
     utils::timed_rate_moving_average_and_histogram tombstone_scanned;
     utils::timed_rate_moving_average_and_histogram live_scanned;
-    utils::estimated_histogram estimated_coordinator_read;
+    utils::decaying_latency_histogram coordinator_read_latency;
+    utils::stall_stats stalls;
+};
+
+// The reader admission semaphore dedicated to the reads issued from a
+// scheduling group, see database_config::service_level_scheduling_groups.
+struct scheduling_group_semaphore {
+    seastar::scheduling_group sg;
+    std::unique_ptr<reader_concurrency_semaphore> semaphore;
 };
 
 class table : public enable_lw_shared_from_this<table> {
 public:
     struct config {
         std::vector<sstring> all_datadirs;
+        // The entries of all_datadirs on slower devices, see db::config::slow_data_file_directories.
+        std::vector<sstring> slow_datadirs;
         sstring datadir;
         bool enable_disk_writes = true;
         bool enable_disk_reads = true;
         bool enable_cache = true;
         bool enable_commitlog = true;
         bool enable_incremental_backups = false;
+        // See db::config::append_only_ingest_tables.
+        bool append_only_ingest = false;
         utils::updateable_value<bool> compaction_enforce_min_threshold{false};
+        utils::updateable_value<uint32_t> compaction_max_parallel_subranges{1};
+        utils::updateable_value<uint32_t> memtable_flush_max_parallel_subranges{1};
+        utils::updateable_value<uint32_t> repair_tombstone_gc_propagation_delay_in_s{10800};
         bool enable_dangerous_direct_import_of_cassandra_counters = false;
+        uint32_t shared_sstable_reshard_threshold = 1;
         ::dirty_memory_manager* dirty_memory_manager = &default_dirty_memory_manager;
         ::dirty_memory_manager* streaming_dirty_memory_manager = &default_dirty_memory_manager;
         reader_concurrency_semaphore* read_concurrency_semaphore;
         reader_concurrency_semaphore* streaming_read_concurrency_semaphore;
+        const std::vector<scheduling_group_semaphore>* scheduling_group_semaphores = nullptr;
         ::cf_stats* cf_stats = nullptr;
         seastar::scheduling_group memtable_scheduling_group;
         seastar::scheduling_group memtable_to_cache_scheduling_group;
@@ -483,6 +555,32 @@ class table : public enable_lw_shared_from_this<table> {
     // sstables that should not be compacted (e.g. because they need to be used
     // to generate view updates later)
     std::unordered_map<uint64_t, sstables::shared_sstable> _sstables_staging;
+    // Partition count and size estimates for the token ranges queried through
+    // system.size_estimates, keyed by the (exclusive) start and (inclusive) end
+    // of the possibly wrapping range. Entries are updated when an sstable is
+    // added and dropped whenever sstables are removed from the set.
+    struct range_size_estimate {
+        dht::token_range_vector ranges;
+        int64_t partitions_count = 0;
+        utils::estimated_histogram partition_size{0};
+    };
+    mutable std::map<std::pair<dht::token, dht::token>, range_size_estimate> _size_estimates;
+    // Union of the partition key cardinality sketches of the sstables, and the
+    // sum of their own estimates. The summary-based counts above add up the
+    // partitions of every sstable, so they are scaled by the ratio of the two
+    // to count partitions present in several sstables once. Built on the first
+    // estimate, then maintained and dropped along with _size_estimates.
+    struct sstables_cardinality {
+        std::optional<hll::HyperLogLog> merged;
+        double sum = 0;
+        // Cleared if some sstable has no sketch that can be merged with the others.
+        bool usable = true;
+
+        void add(const sstables::sstable& sst);
+        // The estimated fraction of the partitions of the sstables which are distinct.
+        double distinct_ratio() const;
+    };
+    mutable std::optional<sstables_cardinality> _sstables_cardinality;
     // Control background fibers waiting for sstables to be deleted
     seastar::gate _sstable_deletion_gate;
     // This semaphore ensures that an operation like snapshot won't have its selected
@@ -504,6 +602,8 @@ class table : public enable_lw_shared_from_this<table> {
     compaction_manager& _compaction_manager;
     secondary_index::secondary_index_manager _index_manager;
     int _compaction_disabled = 0;
+    // Spreads cold compaction output over _config.slow_datadirs.
+    unsigned _next_slow_datadir = 0;
     utils::phased_barrier _flush_barrier;
     seastar::gate _streaming_flush_gate;
     std::vector<view_ptr> _views;
@@ -516,6 +616,10 @@ class table : public enable_lw_shared_from_this<table> {
     // recalculated periodically
     cache_temperature _global_cache_hit_rate = cache_temperature(0.0f);
 
+    // True while the cache of this shard is being populated with partitions
+    // saved before a restart, see db::cache_warmer.
+    bool _cache_warming_up = false;
+
     // holds cache hit rates per each node in a cluster
     // may not have information for some node, since it fills
     // in dynamically
@@ -531,7 +635,12 @@ class table : public enable_lw_shared_from_this<table> {
 
     double _cached_percentile = -1;
     lowres_clock::time_point _percentile_cache_timestamp;
-    std::chrono::milliseconds _percentile_cache_value;
+    std::optional<std::chrono::microseconds> _percentile_cache_value;
+
+    // Earned by reads which may speculate and spent by speculative retries,
+    // see try_consume_speculative_retry().
+    static constexpr double max_speculative_retry_credits = 10;
+    double _speculative_retry_credits = max_speculative_retry_credits;
 
     // Phaser used to synchronize with in-progress writes. This is useful for code that,
     // after some modification, needs to ensure that news writes will see it before
@@ -545,11 +654,34 @@ class table : public enable_lw_shared_from_this<table> {
     // This field cashes the last truncation time for the table.
     // The master resides in system.truncated table
     db_clock::time_point _truncated_at = db_clock::time_point::min();
+    db::repair_history _repair_history;
 
     bool _is_bootstrap_or_replace = false;
 public:
     future<> add_sstable_and_update_cache(sstables::shared_sstable sst);
     future<> move_sstables_from_staging(std::vector<sstables::shared_sstable>);
+    // Copies the sstables holding only data written before max_timestamp to
+    // cold_dir() and replaces them with the copies. Returns the number of
+    // sstables which were moved.
+    future<size_t> offload_cold_sstables(api::timestamp_type max_timestamp);
+    // Marks the data of the unrepaired sstables with the given generations
+    // which lies in ranges as repaired at repaired_at. Sstables entirely in
+    // ranges are marked in place, those only partly in ranges anticompacted.
+    future<> mark_sstables_repaired(std::unordered_set<int64_t> generations, dht::token_range_vector ranges, uint64_t repaired_at);
+    // Records that all replicas of ranges were repaired by a repair started at repair_time.
+    void record_repair(const dht::token_range_vector& ranges, gc_clock::time_point repair_time);
+    // The deletion time before which tombstones of the token, or of the whole range, may be
+    // purged by a compaction running at compaction_time. With tombstone_gc = repair, it's the
+    // time the last repair of the token started, minus tombstone_gc_propagation_delay(),
+    // provided it was recorded. Otherwise it is gc_grace_seconds before compaction_time.
+    gc_clock::time_point get_gc_before(const dht::token& t, gc_clock::time_point compaction_time) const;
+    gc_clock::time_point get_gc_before(const dht::token_range& range, gc_clock::time_point compaction_time) const;
+    // How long before a repair started a tombstone must have been written to be
+    // covered by it. Writes in flight, or landing on a replica after the repair
+    // read it, may not have been synced.
+    gc_clock::duration tombstone_gc_propagation_delay() const {
+        return std::chrono::seconds(_config.repair_tombstone_gc_propagation_delay_in_s());
+    }
     sstables::shared_sstable get_staging_sstable(uint64_t generation) {
         auto it = _sstables_staging.find(generation);
         return it != _sstables_staging.end() ? it->second : nullptr;
@@ -582,7 +714,9 @@ class table : public enable_lw_shared_from_this<table> {
     // Doesn't trigger compaction.
     // Strong exception guarantees.
     void add_sstable(sstables::shared_sstable sstable, const std::vector<unsigned>& shards_for_the_sstable);
-    static void add_sstable_to_backlog_tracker(compaction_backlog_tracker& tracker, sstables::shared_sstable sstable);
+    void add_sstable_to_backlog_tracker(compaction_backlog_tracker& tracker, sstables::shared_sstable sstable);
+    void add_sstable_to_size_estimates(const sstables::shared_sstable& sst);
+    void drop_size_estimates() noexcept;
     // returns an empty pointer if sstable doesn't belong to current shard.
     future<sstables::shared_sstable> open_sstable(sstables::foreign_sstable_open_info info, sstring dir,
         int64_t generation, sstables::sstable_version_types v, sstables::sstable_format_types f);
@@ -590,8 +724,15 @@ class table : public enable_lw_shared_from_this<table> {
     lw_shared_ptr<memtable> new_memtable();
     lw_shared_ptr<memtable> new_streaming_memtable();
     future<stop_iteration> try_flush_memtable_to_sstable(lw_shared_ptr<memtable> memt, sstable_write_permit&& permit);
+    // Writes the memtable through the compaction strategy's interposer, which may
+    // split it into several sstables, e.g. one per time window with TWCS.
+    // Every sstable started is appended to ssts, also when the write fails.
+    // Only the first sstable holds the permit.
+    // Caller must keep mt and ssts alive.
+    future<> write_memtable_to_sstables(memtable& mt, std::vector<monitored_sstable>& ssts, sstable_write_permit&& permit,
+        sstables::sstable_writer_config cfg, const io_priority_class& pc);
     // Caller must keep m alive.
-    future<> update_cache(lw_shared_ptr<memtable> m, sstables::shared_sstable sst);
+    future<> update_cache(lw_shared_ptr<memtable> m, std::vector<sstables::shared_sstable> ssts);
     struct merge_comparator;
 
     // update the sstable generation, making sure that new new sstables don't overwrite this one.
@@ -640,7 +781,8 @@ class table : public enable_lw_shared_from_this<table> {
                                         const io_priority_class& pc,
                                         tracing::trace_state_ptr trace_state,
                                         streamed_mutation::forwarding fwd,
-                                        mutation_reader::forwarding fwd_mr) const;
+                                        mutation_reader::forwarding fwd_mr,
+                                        reader_permit permit = no_reader_permit()) const;
 
     snapshot_source sstables_as_snapshot_source();
     partition_presence_checker make_partition_presence_checker(lw_shared_ptr<sstables::sstable_set>);
@@ -655,10 +797,30 @@ class table : public enable_lw_shared_from_this<table> {
         return _config.datadir;
     }
 
+    // Sstables which are rarely read can be moved here, see offload_cold_sstables().
+    // It's loaded like dir() on startup and may be a mount point of cheaper storage.
+    sstring cold_dir() const {
+        return _config.datadir + "/cold";
+    }
+
     logalloc::region_group& dirty_memory_region_group() const {
         return _config.dirty_memory_manager->region_group();
     }
 
+    // Resolves when writes to this table are not held back by its share of dirty memory.
+    future<> wait_for_dirty_memory_quota(db::timeout_clock::time_point timeout) const {
+        return _config.dirty_memory_manager->wait_for_quota(*_memtables, timeout);
+    }
+
+    // See dirty_memory_manager::write_would_miss_deadline().
+    bool write_would_miss_deadline(db::timeout_clock::time_point timeout) const {
+        return _config.dirty_memory_manager->write_would_miss_deadline(timeout);
+    }
+
+    void record_write_delay(db::timeout_clock::duration delay) const {
+        _config.dirty_memory_manager->record_write_delay(delay);
+    }
+
     // Used for asynchronous operations that may defer and need to guarantee that the column
     // family will be alive until their termination
     template<typename Func, typename Futurator = futurize<std::result_of_t<Func()>>, typename... Args>
@@ -699,15 +861,18 @@ class table : public enable_lw_shared_from_this<table> {
     // Mutations returned by the reader will all have given schema.
     // If I/O needs to be issued to read anything in the specified range, the operations
     // will be scheduled under the priority class given by pc.
+    // The sstable reads are admitted under the permit, when one is given,
+    // instead of waiting for admission of their own.
     flat_mutation_reader make_reader(schema_ptr schema,
             const dht::partition_range& range,
             const query::partition_slice& slice,
             const io_priority_class& pc = default_priority_class(),
             tracing::trace_state_ptr trace_state = nullptr,
             streamed_mutation::forwarding fwd = streamed_mutation::forwarding::no,
-            mutation_reader::forwarding fwd_mr = mutation_reader::forwarding::yes) const;
-    flat_mutation_reader make_reader_excluding_sstable(schema_ptr schema,
-            sstables::shared_sstable sst,
+            mutation_reader::forwarding fwd_mr = mutation_reader::forwarding::yes,
+            reader_permit permit = no_reader_permit()) const;
+    flat_mutation_reader make_reader_excluding_sstables(schema_ptr schema,
+            std::vector<sstables::shared_sstable> excluded_sstables,
             const dht::partition_range& range,
             const query::partition_slice& slice,
             const io_priority_class& pc = default_priority_class(),
@@ -728,6 +893,12 @@ class table : public enable_lw_shared_from_this<table> {
     flat_mutation_reader make_streaming_reader(schema_ptr schema,
             const dht::partition_range_vector& ranges) const;
 
+    // Like the above, but doesn't read from the excluded sstables, e.g.
+    // because their files were already streamed as a whole.
+    flat_mutation_reader make_streaming_reader(schema_ptr schema,
+            const dht::partition_range_vector& ranges,
+            std::unordered_set<sstables::shared_sstable> excluded) const;
+
     // Single range overload.
     flat_mutation_reader make_streaming_reader(schema_ptr schema, const dht::partition_range& range,
             const query::partition_slice& slice,
@@ -737,13 +908,22 @@ class table : public enable_lw_shared_from_this<table> {
         return make_streaming_reader(schema, range, schema->full_slice());
     }
 
+    // Like the single range overload, but doesn't read from repaired sstables.
+    // Used by incremental repair.
+    flat_mutation_reader make_unrepaired_streaming_reader(schema_ptr schema, const dht::partition_range& range,
+            const query::partition_slice& slice,
+            mutation_reader::forwarding fwd_mr = mutation_reader::forwarding::no) const;
+
     sstables::shared_sstable make_streaming_sstable_for_write(std::optional<sstring> subdir = {});
     sstables::shared_sstable make_streaming_staging_sstable() {
         return make_streaming_sstable_for_write("staging");
     }
 
     mutation_source as_mutation_source() const;
-    mutation_source as_mutation_source_excluding(sstables::shared_sstable sst) const;
+    mutation_source as_mutation_source_excluding(std::vector<sstables::shared_sstable> excluded_sstables) const;
+    // Like as_mutation_source(), but the readers are admitted under the
+    // given permit, instead of each waiting for admission.
+    mutation_source as_admitted_mutation_source(reader_permit permit) const;
 
     void set_virtual_reader(mutation_source virtual_reader) {
         _virtual_reader = std::move(virtual_reader);
@@ -799,6 +979,20 @@ class table : public enable_lw_shared_from_this<table> {
         db::timeout_clock::time_point timeout,
         query::querier_cache_context cache_ctx = { });
 
+    // Reads the given partitions, each a singular range, in the given order
+    // and returns one result per partition. Unlike query(), all of them are
+    // read under a single admission to the read concurrency semaphore and a
+    // single result memory accounter, and cmd's limits apply to all of them
+    // together: once a limit is reached or a read is short, the remaining
+    // partitions are not read and have no result.
+    future<std::vector<lw_shared_ptr<query::result>>> query_partitions(schema_ptr,
+        const query::read_command& cmd,
+        const dht::partition_range_vector& ranges,
+        tracing::trace_state_ptr trace_state,
+        query::result_memory_limiter& memory_limiter,
+        uint64_t max_result_size,
+        db::timeout_clock::time_point timeout);
+
     void start();
     future<> stop();
     future<> flush();
@@ -882,6 +1076,10 @@ class table : public enable_lw_shared_from_this<table> {
         return _config.compaction_enforce_min_threshold || _is_bootstrap_or_replace;
     }
 
+    unsigned compaction_max_parallel_subranges() const {
+        return _config.compaction_max_parallel_subranges();
+    }
+
     unsigned min_compaction_threshold() {
         // During receiving stream operations, the less we compact the faster streaming is. For
         // bootstrap and replace thereThere are no readers so it is fine to be less aggressive with
@@ -907,6 +1105,10 @@ class table : public enable_lw_shared_from_this<table> {
     lw_shared_ptr<const sstable_list> get_sstables_including_compacted_undeleted() const;
     const std::vector<sstables::shared_sstable>& compacted_undeleted_sstables() const;
     std::vector<sstables::shared_sstable> select_sstables(const dht::partition_range& range) const;
+    // Returns the estimated partitions count and mean partition size of the wrapping
+    // token range (start, end], computed from the sstable statistics and cardinality
+    // sketches and cached until the set of sstables shrinks.
+    std::pair<int64_t, int64_t> estimate_partitions(const dht::token& start, const dht::token& end) const;
     std::vector<sstables::shared_sstable> candidates_for_compaction() const;
     std::vector<sstables::shared_sstable> sstables_need_rewrite() const;
     size_t sstables_count() const;
@@ -930,6 +1132,11 @@ class table : public enable_lw_shared_from_this<table> {
         return _stats;
     }
 
+    // Tags work of the given type on this table for reactor stall attribution.
+    utils::activity make_activity(utils::activity_type type) const {
+        return utils::activity{type, &_stats.stalls};
+    }
+
     const db::view::stats& get_view_stats() const {
         return _view_stats;
     }
@@ -954,6 +1161,14 @@ class table : public enable_lw_shared_from_this<table> {
         _global_cache_hit_rate = rate;
     }
 
+    bool cache_warming_up() const {
+        return _cache_warming_up;
+    }
+
+    void set_cache_warming_up(bool value) {
+        _cache_warming_up = value;
+    }
+
     void set_hit_rate(gms::inet_address addr, cache_temperature rate);
     cache_hit_rate get_hit_rate(gms::inet_address addr);
     void drop_hit_rate(gms::inet_address addr);
@@ -990,9 +1205,25 @@ class table : public enable_lw_shared_from_this<table> {
     const std::vector<view_ptr>& views() const;
     future<row_locker::lock_holder> push_view_replica_updates(const schema_ptr& s, const frozen_mutation& fm, db::timeout_clock::time_point timeout) const;
     future<row_locker::lock_holder> push_view_replica_updates(const schema_ptr& s, mutation&& m, db::timeout_clock::time_point timeout) const;
-    future<row_locker::lock_holder> stream_view_replica_updates(const schema_ptr& s, mutation&& m, db::timeout_clock::time_point timeout, sstables::shared_sstable excluded_sstable) const;
+    future<row_locker::lock_holder> stream_view_replica_updates(const schema_ptr& s, mutation&& m, db::timeout_clock::time_point timeout, std::vector<sstables::shared_sstable> excluded_sstables) const;
     void add_coordinator_read_latency(utils::estimated_histogram::duration latency);
-    std::chrono::milliseconds get_coordinator_read_latency_percentile(double percentile);
+    // Returns nothing until reads of the table were measured.
+    std::optional<std::chrono::microseconds> get_coordinator_read_latency_percentile(double percentile);
+
+    // Speculative retries are limited to the given fraction of the reads
+    // which may speculate, plus a small burst: every such read earns that
+    // fraction of a retry, and a retry is allowed only if a whole one was
+    // earned.
+    void earn_speculative_retry(double budget) {
+        _speculative_retry_credits = std::min(_speculative_retry_credits + budget, max_speculative_retry_credits);
+    }
+    bool try_consume_speculative_retry() {
+        if (_speculative_retry_credits < 1) {
+            return false;
+        }
+        _speculative_retry_credits -= 1;
+        return true;
+    }
 
     secondary_index::secondary_index_manager& get_index_manager() {
         return _index_manager;
@@ -1012,6 +1243,10 @@ class table : public enable_lw_shared_from_this<table> {
         return *_config.read_concurrency_semaphore;
     }
 
+    // The semaphore admitting user reads issued from the given scheduling
+    // group: the one of its service level, if any, the default otherwise.
+    reader_concurrency_semaphore* read_concurrency_semaphore_for(seastar::scheduling_group sg) const;
+
     reader_concurrency_semaphore& streaming_read_concurrency_semaphore() {
         return *_config.streaming_read_concurrency_semaphore;
     }
@@ -1170,6 +1405,8 @@ class keyspace {
 public:
     struct config {
         std::vector<sstring> all_datadirs;
+        // The entries of all_datadirs on slower devices.
+        std::vector<sstring> slow_datadirs;
         sstring datadir;
         bool enable_commitlog = true;
         bool enable_disk_reads = true;
@@ -1177,11 +1414,15 @@ class keyspace {
         bool enable_cache = true;
         bool enable_incremental_backups = false;
         utils::updateable_value<bool> compaction_enforce_min_threshold{false};
+        utils::updateable_value<uint32_t> compaction_max_parallel_subranges{1};
+        utils::updateable_value<uint32_t> memtable_flush_max_parallel_subranges{1};
         bool enable_dangerous_direct_import_of_cassandra_counters = false;
+        uint32_t shared_sstable_reshard_threshold = 1;
         ::dirty_memory_manager* dirty_memory_manager = &default_dirty_memory_manager;
         ::dirty_memory_manager* streaming_dirty_memory_manager = &default_dirty_memory_manager;
         reader_concurrency_semaphore* read_concurrency_semaphore;
         reader_concurrency_semaphore* streaming_read_concurrency_semaphore;
+        const std::vector<scheduling_group_semaphore>* scheduling_group_semaphores = nullptr;
         ::cf_stats* cf_stats = nullptr;
         seastar::scheduling_group memtable_scheduling_group;
         seastar::scheduling_group memtable_to_cache_scheduling_group;
@@ -1265,6 +1506,12 @@ struct database_config {
     seastar::scheduling_group memory_compaction_scheduling_group;
     seastar::scheduling_group statement_scheduling_group;
     seastar::scheduling_group streaming_scheduling_group;
+    // Copying snapshots to a backup destination, see db/snapshot_backup.hh.
+    seastar::scheduling_group backup_scheduling_group;
+    // Scheduling groups of the service levels. Reads issued from one of
+    // these are admitted by a semaphore of their own instead of sharing the
+    // one of the statement group.
+    std::vector<seastar::scheduling_group> service_level_scheduling_groups;
     size_t available_memory;
 };
 
@@ -1291,15 +1538,18 @@ class database {
     size_t max_memory_streaming_concurrent_reads() { return _dbcfg.available_memory * 0.02; }
     static constexpr size_t max_count_system_concurrent_reads{10};
     size_t max_memory_system_concurrent_reads() { return _dbcfg.available_memory * 0.02; };
-    static constexpr size_t max_concurrent_sstable_loads() { return 3; }
+    size_t max_concurrent_sstable_loads() const { return std::max(_cfg.sstable_load_concurrency(), 1u); }
     size_t max_memory_pending_view_updates() const { return _dbcfg.available_memory * 0.1; }
 
     struct db_stats {
         uint64_t total_writes = 0;
         uint64_t total_writes_failed = 0;
         uint64_t total_writes_timedout = 0;
+        uint64_t total_writes_shed = 0;
+        uint64_t total_writes_rate_limited = 0;
         uint64_t total_reads = 0;
         uint64_t total_reads_failed = 0;
+        uint64_t total_reads_rate_limited = 0;
         uint64_t sstable_read_queue_overloaded = 0;
 
         uint64_t short_data_queries = 0;
@@ -1309,6 +1559,7 @@ class database {
         uint64_t multishard_query_unpopped_bytes = 0;
         uint64_t multishard_query_failed_reader_stops = 0;
         uint64_t multishard_query_failed_reader_saves = 0;
+        uint64_t multishard_query_evicted_reader_saves = 0;
     };
 
     lw_shared_ptr<db_stats> _stats;
@@ -1326,12 +1577,17 @@ class database {
     reader_concurrency_semaphore _read_concurrency_sem;
     reader_concurrency_semaphore _streaming_concurrency_sem;
     reader_concurrency_semaphore _system_read_concurrency_sem;
+    std::vector<scheduling_group_semaphore> _service_level_read_concurrency_sems;
 
     named_semaphore _sstable_load_concurrency_sem{max_concurrent_sstable_loads(), named_semaphore_exception_factory{"sstable load concurrency"}};
 
     db::timeout_semaphore _view_update_concurrency_sem{max_memory_pending_view_updates()};
 
     cache_tracker _row_cache_tracker;
+    sstables::index_page_cache _index_page_cache;
+    sstables::filter_partition_cache _filter_partition_cache{size_t(_cfg.bloom_filter_partition_cache_size_in_mb()) * 1024 * 1024 / smp::count};
+    db::counter_cache _counter_cache{size_t(_cfg.counter_cache_size_in_mb()) * 1024 * 1024 / smp::count};
+    db::rate_limiter _rate_limiter;
 
     inheriting_concrete_execution_stage<future<lw_shared_ptr<query::result>>,
         column_family*,
@@ -1378,6 +1634,7 @@ class database {
 
     friend db::data_listeners;
     std::unique_ptr<db::data_listeners> _data_listeners;
+    std::unique_ptr<db::continuous_toppartitions_listener> _continuous_toppartitions;
 
     service::migration_notifier& _mnotifier;
     gms::feature_service& _feat;
@@ -1426,6 +1683,7 @@ class database {
     ~database();
 
     cache_tracker& row_cache_tracker() { return _row_cache_tracker; }
+    db::counter_cache& get_counter_cache() { return _counter_cache; }
 
     void update_version(const utils::UUID& version);
 
@@ -1436,6 +1694,7 @@ class database {
     }
 
     seastar::scheduling_group get_streaming_scheduling_group() const { return _dbcfg.streaming_scheduling_group; }
+    seastar::scheduling_group get_backup_scheduling_group() const { return _dbcfg.backup_scheduling_group; }
     size_t get_available_memory() const { return _dbcfg.available_memory; }
 
     compaction_manager& get_compaction_manager() {
@@ -1497,6 +1756,11 @@ class database {
     future<lw_shared_ptr<query::result>, cache_temperature> query(schema_ptr, const query::read_command& cmd, query::result_options opts,
                                                                   const dht::partition_range_vector& ranges, tracing::trace_state_ptr trace_state,
                                                                   uint64_t max_result_size, db::timeout_clock::time_point timeout);
+    // Reads each of the partitions, given as singular ranges, into a result
+    // of its own, see table::query_partitions().
+    future<std::vector<lw_shared_ptr<query::result>>, cache_temperature> query_partitions(schema_ptr, const query::read_command& cmd,
+                                                                  const dht::partition_range_vector& ranges, tracing::trace_state_ptr trace_state,
+                                                                  uint64_t max_result_size, db::timeout_clock::time_point timeout);
     future<reconcilable_result, cache_temperature> query_mutations(schema_ptr, const query::read_command& cmd, const dht::partition_range& range,
                                                 query::result_memory_accounter&& accounter, tracing::trace_state_ptr trace_state,
                                                 db::timeout_clock::time_point timeout);
@@ -1570,6 +1834,9 @@ class database {
     }
 
     future<> flush_all_memtables();
+    // Makes the following flushes run concurrently and with the maximum shares.
+    // Meant for draining, once no more writes are coming in.
+    void expedite_flushes();
 
     // See #937. Truncation now requires a callback to get a time stamp
     // that must be guaranteed to be the same for all shards.
@@ -1622,6 +1889,10 @@ class database {
         return *_data_listeners;
     }
 
+    const db::continuous_toppartitions_listener& continuous_toppartitions() const {
+        return *_continuous_toppartitions;
+    }
+
     bool supports_infinite_bound_range_deletions() {
         return _supports_infinite_bound_range_deletions;
     }
@@ -1632,10 +1903,11 @@ future<> stop_database(sharded<database>& db);
 
 // Creates a streaming reader that reads from all shards.
 //
-// Shard readers are created via `table::make_streaming_reader()`.
+// Shard readers are created via `table::make_streaming_reader()`, or via
+// `table::make_unrepaired_streaming_reader()` if unrepaired_only is set.
 // Range generator must generate disjoint, monotonically increasing ranges.
 flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db, schema_ptr schema,
-        std::function<std::optional<dht::partition_range>()> range_generator);
+        std::function<std::optional<dht::partition_range>()> range_generator, bool unrepaired_only = false);
 
 future<utils::UUID> update_schema_version(distributed<service::storage_proxy>& proxy, db::schema_features);
 future<> announce_schema_version(utils::UUID schema_version);
@@ -177,9 +177,91 @@ db_clock::duration db::batchlog_manager::get_batch_log_timeout() const {
     return _write_request_timeout * 2;
 }
 
-future<> db::batchlog_manager::replay_all_failed_batches() {
+future<> db::batchlog_manager::replay_batch(utils::UUID id, db_clock::time_point written_at, bytes data) {
     typedef db_clock::rep clock_type;
 
+    blogger.debug("Replaying batch {}", id);
+
+    auto fms = make_lw_shared<std::deque<canonical_mutation>>();
+    auto in = ser::as_input_stream(data);
+    while (in.size()) {
+        fms->emplace_back(ser::deserialize(in, boost::type<canonical_mutation>()));
+    }
+
+    return map_reduce(*fms, [this, written_at] (canonical_mutation& fm) {
+        return system_keyspace::get_truncated_at(fm.column_family_id()).then([written_at, &fm] (db_clock::time_point t) ->
+                std::optional<std::reference_wrapper<canonical_mutation>> {
+            if (written_at > t) {
+                return { std::ref(fm) };
+            } else {
+                return {};
+            }
+        });
+    },
+    std::vector<mutation>(),
+    [this] (std::vector<mutation> mutations, std::optional<std::reference_wrapper<canonical_mutation>> fm) {
+        if (fm) {
+            schema_ptr s = _qp.db().find_schema(fm.value().get().column_family_id());
+            mutations.emplace_back(fm.value().get().to_mutation(s));
+        }
+        return mutations;
+    }).then([this, id, written_at, fms] (std::vector<mutation> mutations) {
+        if (mutations.empty()) {
+            return make_ready_future<>();
+        }
+        const auto ttl = [this, &mutations, written_at]() -> clock_type {
+            /*
+             * Calculate ttl for the mutations' hints (and reduce ttl by the time the mutations spent in the batchlog).
+             * This ensures that deletes aren't "undone" by an old batch replay.
+             */
+            auto unadjusted_ttl = std::numeric_limits<gc_clock::rep>::max();
+            warn(unimplemented::cause::HINT);
+#if 0
+            for (auto& m : *mutations) {
+                unadjustedTTL = Math.min(unadjustedTTL, HintedHandOffManager.calculateHintTTL(mutation));
+            }
+#endif
+            return unadjusted_ttl - std::chrono::duration_cast<gc_clock::duration>(db_clock::now() - written_at).count();
+        }();
+
+        if (ttl <= 0) {
+            return make_ready_future<>();
+        }
+        // Origin does the send manually, however I can't see a super great reason to do so.
+        // Our normal write path does not add much redundancy to the dispatch, and rate is handled after send
+        // in both cases.
+        // FIXME: verify that the above is reasonably true.
+        _stats.write_attempts += mutations.size();
+        // #1222 - change cl level to ALL, emulating origins behaviour of sending/hinting
+        // to all natural end points.
+        // Note however that origin uses hints here, and actually allows for this
+        // send to partially or wholly fail in actually sending stuff. Since we don't
+        // have hints (yet), send with CL=ALL, and hope we can re-do this soon.
+        // See below, we use retry on write failure.
+        return _qp.proxy().mutate(std::move(mutations), db::consistency_level::ALL, db::no_timeout, nullptr, empty_service_permit());
+    }).then_wrapped([this, id](future<> batch_result) {
+        try {
+            batch_result.get();
+        } catch (no_such_keyspace& ex) {
+            // should probably ignore and drop the batch
+        } catch (...) {
+            // timeout, overload etc.
+            // Do _not_ remove the batch, assuning we got a node write error.
+            // Since we don't have hints (which origin is satisfied with),
+            // we have to resort to keeping this batch to next lap.
+            return make_ready_future<>();
+        }
+        // delete batch
+        auto schema = _qp.db().find_schema(system_keyspace::NAME, system_keyspace::BATCHLOG);
+        auto key = partition_key::from_singular(*schema, id);
+        mutation m(schema, key);
+        auto now = service::client_state(service::client_state::internal_tag()).get_timestamp();
+        m.partition().apply_delete(*schema, clustering_key_prefix::make_empty(), tombstone(now, gc_clock::now()));
+        return _qp.proxy().mutate_locally(m);
+    });
+}
+
+future<> db::batchlog_manager::replay_all_failed_batches() {
     // rate limit is in bytes per second. Uses Double.MAX_VALUE if disabled (set to 0 in cassandra.yaml).
     // max rate is scaled by the number of nodes in the cluster (same as for HHOM - see CASSANDRA-5272).
     auto throttle = _replay_rate / _qp.proxy().get_token_metadata().get_all_endpoints_count();
@@ -208,89 +290,20 @@ future<> db::batchlog_manager::replay_all_failed_batches() {
         }
 
         auto data = row.get_blob("data");
-
-        blogger.debug("Replaying batch {}", id);
-
-        auto fms = make_lw_shared<std::deque<canonical_mutation>>();
-        auto in = ser::as_input_stream(data);
-        while (in.size()) {
-            fms->emplace_back(ser::deserialize(in, boost::type<canonical_mutation>()));
-        }
-
         auto size = data.size();
 
-        return map_reduce(*fms, [this, written_at] (canonical_mutation& fm) {
-            return system_keyspace::get_truncated_at(fm.column_family_id()).then([written_at, &fm] (db_clock::time_point t) ->
-                    std::optional<std::reference_wrapper<canonical_mutation>> {
-                if (written_at > t) {
-                    return { std::ref(fm) };
-                } else {
-                    return {};
-                }
-            });
-        },
-        std::vector<mutation>(),
-        [this] (std::vector<mutation> mutations, std::optional<std::reference_wrapper<canonical_mutation>> fm) {
-            if (fm) {
-                schema_ptr s = _qp.db().find_schema(fm.value().get().column_family_id());
-                mutations.emplace_back(fm.value().get().to_mutation(s));
-            }
-            return mutations;
-        }).then([this, id, limiter, written_at, size, fms] (std::vector<mutation> mutations) {
-            if (mutations.empty()) {
-                return make_ready_future<>();
-            }
-            const auto ttl = [this, &mutations, written_at]() -> clock_type {
-                /*
-                 * Calculate ttl for the mutations' hints (and reduce ttl by the time the mutations spent in the batchlog).
-                 * This ensures that deletes aren't "undone" by an old batch replay.
-                 */
-                auto unadjusted_ttl = std::numeric_limits<gc_clock::rep>::max();
-                warn(unimplemented::cause::HINT);
-#if 0
-                for (auto& m : *mutations) {
-                    unadjustedTTL = Math.min(unadjustedTTL, HintedHandOffManager.calculateHintTTL(mutation));
-                }
-#endif
-                return unadjusted_ttl - std::chrono::duration_cast<gc_clock::duration>(db_clock::now() - written_at).count();
-            }();
-
-            if (ttl <= 0) {
-                return make_ready_future<>();
-            }
-            // Origin does the send manually, however I can't see a super great reason to do so.
-            // Our normal write path does not add much redundancy to the dispatch, and rate is handled after send
-            // in both cases.
-            // FIXME: verify that the above is reasonably true.
-            return limiter->reserve(size).then([this, mutations = std::move(mutations), id] {
-                _stats.write_attempts += mutations.size();
-                // #1222 - change cl level to ALL, emulating origins behaviour of sending/hinting
-                // to all natural end points.
-                // Note however that origin uses hints here, and actually allows for this
-                // send to partially or wholly fail in actually sending stuff. Since we don't
-                // have hints (yet), send with CL=ALL, and hope we can re-do this soon.
-                // See below, we use retry on write failure.
-                return _qp.proxy().mutate(mutations, db::consistency_level::ALL, db::no_timeout, nullptr, empty_service_permit());
+        // The replay of a batch, including the deserialization of its
+        // mutations and the removal of its batchlog entry, runs on the
+        // shard owning the entry, so that all shards share the work of
+        // a large batchlog. The rate limit stays global to this replay.
+        auto schema = _qp.db().find_schema(system_keyspace::NAME, system_keyspace::BATCHLOG);
+        auto shard = dht::shard_of(*schema, dht::get_token(*schema, partition_key::from_singular(*schema, id)));
+        return limiter->reserve(size).then([id, written_at, shard, data = std::move(data)] () mutable {
+            return get_batchlog_manager().invoke_on(shard, [id, written_at, data = std::move(data)] (batchlog_manager& bm) mutable {
+                return with_gate(bm._gate, [&bm, id, written_at, data = std::move(data)] () mutable {
+                    return bm.replay_batch(id, written_at, std::move(data));
+                });
             });
-        }).then_wrapped([this, id](future<> batch_result) {
-            try {
-                batch_result.get();
-            } catch (no_such_keyspace& ex) {
-                // should probably ignore and drop the batch
-            } catch (...) {
-                // timeout, overload etc.
-                // Do _not_ remove the batch, assuning we got a node write error.
-                // Since we don't have hints (which origin is satisfied with),
-                // we have to resort to keeping this batch to next lap.
-                return make_ready_future<>();
-            }
-            // delete batch
-            auto schema = _qp.db().find_schema(system_keyspace::NAME, system_keyspace::BATCHLOG);
-            auto key = partition_key::from_singular(*schema, id);
-            mutation m(schema, key);
-            auto now = service::client_state(service::client_state::internal_tag()).get_timestamp();
-            m.partition().apply_delete(*schema, clustering_key_prefix::make_empty(), tombstone(now, gc_clock::now()));
-            return _qp.proxy().mutate_locally(m);
         });
     };
 
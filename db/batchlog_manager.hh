@@ -90,6 +90,9 @@ class batchlog_manager {
     std::default_random_engine _e1{std::random_device{}()};
 
     future<> replay_all_failed_batches();
+    // Replays a single batch and removes it from the batchlog if successful.
+    // Must be called on the shard owning the batchlog entry.
+    future<> replay_batch(utils::UUID id, db_clock::time_point written_at, bytes data);
 public:
     // Takes a QP, not a distributes. Because this object is supposed
     // to be per shard and does no dispatching beyond delegating the the
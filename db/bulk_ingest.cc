@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "db/bulk_ingest.hh"
+#include "database.hh"
+#include "mutation_reader.hh"
+#include "mutation_writer/multishard_writer.hh"
+#include "service/priority_manager.hh"
+#include "sstables/sstables.hh"
+#include "log.hh"
+
+namespace db {
+
+static logging::logger blogger("bulk_ingest");
+
+bulk_ingester::bulk_ingester(distributed<database>& db, schema_ptr s, size_t buffer_limit)
+        : _db(db)
+        , _schema(std::move(s))
+        , _buffer_limit(buffer_limit)
+        , _buffer(dht::decorated_key::less_comparator(_schema)) {
+    auto& cf = _db.local().find_column_family(_schema);
+    if (_schema->is_counter()) {
+        throw std::invalid_argument(format("Bulk ingestion into counter table {}.{} is not supported", _schema->ks_name(), _schema->cf_name()));
+    }
+    if (!cf.views().empty()) {
+        throw std::invalid_argument(format("Bulk ingestion into table {}.{} with materialized views is not supported", _schema->ks_name(), _schema->cf_name()));
+    }
+}
+
+future<> bulk_ingester::add(mutation m) {
+    if (m.schema()->version() != _schema->version()) {
+        m.upgrade(_schema);
+    }
+    _buffered_bytes += m.partition().external_memory_usage(*_schema) + m.decorated_key().memory_usage();
+    auto i = _buffer.find(m.decorated_key());
+    if (i == _buffer.end()) {
+        auto dk = m.decorated_key();
+        _buffer.emplace(std::move(dk), std::move(m));
+    } else {
+        i->second.apply(std::move(m));
+    }
+    if (_buffered_bytes < _buffer_limit) {
+        return make_ready_future<>();
+    }
+    return flush();
+}
+
+future<> bulk_ingester::flush() {
+    if (_buffer.empty()) {
+        return make_ready_future<>();
+    }
+    std::vector<mutation> muts;
+    muts.reserve(_buffer.size());
+    for (auto& [dk, m] : _buffer) {
+        muts.push_back(std::move(m));
+    }
+    _buffer.clear();
+    _buffered_bytes = 0;
+    auto partitions = muts.size();
+    blogger.debug("Writing {} partitions of {}.{} to sstables", partitions, _schema->ks_name(), _schema->cf_name());
+    auto op = _db.local().find_column_family(_schema).stream_in_progress();
+    return mutation_writer::distribute_reader_and_consume_on_shards(_schema, flat_mutation_reader_from_mutations(std::move(muts)),
+            [&db = _db, partitions] (flat_mutation_reader reader) {
+        auto cf = db.local().find_column_family(reader.schema()).shared_from_this();
+        auto metadata = mutation_source_metadata{};
+        auto& cs = cf->get_compaction_strategy();
+        auto estimated_partitions = cs.adjust_partition_estimate(metadata, partitions);
+        auto consumer = cs.make_interposer_consumer(metadata, [cf, estimated_partitions] (flat_mutation_reader reader) {
+            auto sst = cf->make_streaming_sstable_for_write();
+            schema_ptr s = reader.schema();
+            auto& pc = service::get_local_streaming_write_priority();
+            return sst->write_components(std::move(reader), std::max(1ul, estimated_partitions), s,
+                    cf->get_sstables_manager().configure_writer(), encoding_stats{}, pc).then([sst] {
+                return sst->open_data();
+            }).then([cf, sst] {
+                return cf->add_sstable_and_update_cache(sst);
+            });
+        });
+        return consumer(std::move(reader));
+    }, std::move(op)).discard_result();
+}
+
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <map>
+
+#include <seastar/core/sharded.hh>
+
+#include "seastarx.hh"
+#include "database_fwd.hh"
+#include "mutation.hh"
+
+namespace db {
+
+// Loads data into a table by writing sstables directly, bypassing the
+// commitlog and memtables, for bulk loads such as migrations and backfills.
+//
+// Mutations may be added in any order. They are merged and sorted in memory,
+// and each time the buffer reaches buffer_limit bytes it is written out as
+// one sstable per shard owning some of the buffered partitions. Overlapping
+// sstables from successive spills are merged by regular compaction.
+//
+// Data is durable and visible to reads once the future returned by add()
+// which triggered the spill, or by flush(), resolves. Added mutations which
+// weren't flushed yet are lost on a crash.
+//
+// Tables with counters or materialized views are rejected, since their
+// writes can't be applied without going through the regular write path.
+class bulk_ingester {
+    using buffer_type = std::map<dht::decorated_key, mutation, dht::decorated_key::less_comparator>;
+    distributed<database>& _db;
+    schema_ptr _schema;
+    size_t _buffer_limit;
+    buffer_type _buffer;
+    size_t _buffered_bytes = 0;
+public:
+    static constexpr size_t default_buffer_limit = 64 * 1024 * 1024;
+
+    bulk_ingester(distributed<database>& db, schema_ptr s, size_t buffer_limit = default_buffer_limit);
+
+    future<> add(mutation m);
+    // Writes all buffered mutations to sstables.
+    future<> flush();
+
+    size_t buffered_bytes() const {
+        return _buffered_bytes;
+    }
+};
+
+}
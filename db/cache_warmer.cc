@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/range/adaptor/map.hpp>
+
+#include <seastar/core/fstream.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/util/defer.hh>
+
+#include "db/cache_warmer.hh"
+#include "database.hh"
+#include "service/priority_manager.hh"
+#include "utils/crc.hh"
+#include "utils/serialization.hh"
+#include "log.hh"
+
+namespace db {
+
+static logging::logger cwlogger("cache_warmer");
+
+// Layout of a saved keys file, with big-endian integers:
+//
+//   magic (u32), version (u32), number of keys (u32),
+//   for each key: length (u32) and the partition key in its serialized form,
+//   crc32 of all the preceding bytes (u32).
+//
+// Keys are ordered from the hottest.
+static constexpr uint32_t saved_keys_magic = 0x484b4559; // "HKEY"
+static constexpr uint32_t saved_keys_version = 1;
+
+bytes serialize_saved_keys(const std::vector<dht::decorated_key>& keys) {
+    size_t size = 4 * sizeof(uint32_t);
+    for (auto&& dk : keys) {
+        size += sizeof(uint32_t) + dk.key().representation().size();
+    }
+    bytes b(bytes::initialized_later(), size);
+    auto out = b.begin();
+    write<uint32_t>(out, saved_keys_magic);
+    write<uint32_t>(out, saved_keys_version);
+    write<uint32_t>(out, keys.size());
+    for (auto&& dk : keys) {
+        auto r = dk.key().representation();
+        write<uint32_t>(out, r.size());
+        out = std::copy(r.begin(), r.end(), out);
+    }
+    utils::crc32 crc;
+    crc.process(reinterpret_cast<const uint8_t*>(b.data()), size - sizeof(uint32_t));
+    write<uint32_t>(out, crc.get());
+    return b;
+}
+
+std::vector<partition_key> deserialize_saved_keys(bytes_view v) {
+    if (v.size() < sizeof(uint32_t)) {
+        throw std::runtime_error(format("Saved keys truncated to {:d} bytes", v.size()));
+    }
+    utils::crc32 crc;
+    crc.process(reinterpret_cast<const uint8_t*>(v.data()), v.size() - sizeof(uint32_t));
+    auto checksum = v.substr(v.size() - sizeof(uint32_t));
+    if (read_simple<uint32_t>(checksum) != crc.get()) {
+        throw std::runtime_error("Saved keys checksum mismatch");
+    }
+    v.remove_suffix(sizeof(uint32_t));
+
+    auto magic = read_simple<uint32_t>(v);
+    auto version = read_simple<uint32_t>(v);
+    if (magic != saved_keys_magic || version != saved_keys_version) {
+        throw std::runtime_error(format("Unsupported saved keys format: magic {:#x}, version {:d}", magic, version));
+    }
+    auto count = read_simple<uint32_t>(v);
+    std::vector<partition_key> keys;
+    keys.reserve(std::min<size_t>(count, v.size() / sizeof(uint32_t)));
+    for (uint32_t i = 0; i < count; ++i) {
+        auto len = read_simple<uint32_t>(v);
+        keys.push_back(partition_key::from_bytes(read_simple_bytes(v, len)));
+    }
+    if (!v.empty()) {
+        throw std::runtime_error(format("{:d} trailing bytes after saved keys", v.size()));
+    }
+    return keys;
+}
+
+cache_warmer::cache_warmer(distributed<database>& db, cache_warmer_config cfg)
+    : _db(db)
+    , _cfg(std::move(cfg))
+    , _timer([this] {
+        // Do it in the background.
+        (void)save().handle_exception([] (auto ep) {
+            cwlogger.warn("Failed to save hot keys: {}", ep);
+        }).finally([this] {
+            arm_timer();
+        });
+    })
+{ }
+
+sstring cache_warmer::keys_directory() const {
+    return format("{}/{}", _cfg.saved_caches_directory, this_shard_id());
+}
+
+sstring cache_warmer::keys_file(const schema& s) const {
+    return format("{}/{}-{}-{}-RowCacheKeys.db", keys_directory(), s.ks_name(), s.cf_name(), s.id());
+}
+
+bool cache_warmer::is_cached(const table& t) const {
+    return t.get_config().enable_cache && !is_internal_keyspace(t.schema()->ks_name());
+}
+
+void cache_warmer::arm_timer() {
+    if (!_stopped && _cfg.save_period.count() && _cfg.keys_to_save) {
+        _timer.arm(_cfg.save_period);
+    }
+}
+
+void cache_warmer::save_keys(table& t) {
+    auto s = t.schema();
+    auto path = keys_file(*s);
+    auto keys = t.get_row_cache().hottest_keys(_cfg.keys_to_save);
+    if (keys.empty()) {
+        if (file_exists(path).get0()) {
+            remove_file(path).get();
+        }
+        return;
+    }
+    auto data = with_linearized_managed_bytes([&] {
+        return serialize_saved_keys(keys);
+    });
+
+    // Replace the file atomically, so that a crash doesn't leave a partial one behind.
+    auto tmp_path = path + ".tmp";
+    auto f = open_file_dma(tmp_path, open_flags::wo | open_flags::create | open_flags::truncate).get0();
+    auto out = make_file_output_stream(std::move(f));
+    std::exception_ptr ex;
+    try {
+        out.write(reinterpret_cast<const char*>(data.data()), data.size()).get();
+        out.flush().get();
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    out.close().get();
+    if (ex) {
+        std::rethrow_exception(ex);
+    }
+    rename_file(tmp_path, path).get();
+    sync_directory(keys_directory()).get();
+    cwlogger.debug("Saved {:d} keys of {}.{}", keys.size(), s->ks_name(), s->cf_name());
+}
+
+future<> cache_warmer::save() {
+    return with_gate(_gate, [this] {
+        return with_semaphore(_save_sem, 1, [this] {
+            return with_scheduling_group(_cfg.scheduling_group, [this] {
+                return seastar::async([this] {
+                    auto tables = boost::copy_range<std::vector<lw_shared_ptr<table>>>(_db.local().get_column_families() | boost::adaptors::map_values);
+                    for (auto& t : tables) {
+                        if (!is_cached(*t) || !_db.local().column_family_exists(t->schema()->id())) {
+                            continue;
+                        }
+                        try {
+                            save_keys(*t);
+                        } catch (...) {
+                            cwlogger.warn("Failed to save hot keys of {}.{}: {}", t->schema()->ks_name(), t->schema()->cf_name(), std::current_exception());
+                        }
+                    }
+                });
+            });
+        });
+    });
+}
+
+void cache_warmer::warm_up(table& t, const std::vector<partition_key>& keys) {
+    auto s = t.schema();
+    auto& pc = service::get_local_streaming_read_priority();
+    size_t partitions = 0;
+    for (auto&& key : keys) {
+        if (_stopped || !_db.local().column_family_exists(s->id())) {
+            break;
+        }
+        auto dk = dht::decorate_key(*s, key);
+        if (dht::shard_of(*s, dk.token()) != this_shard_id()) {
+            continue;
+        }
+        auto pr = dht::partition_range::make_singular(dk);
+        auto rd = t.make_reader(s, pr, s->full_slice(), pc);
+        while (rd(db::no_timeout).get0()) { }
+        ++partitions;
+    }
+    cwlogger.debug("Read {:d} saved partitions of {}.{} into cache", partitions, s->ks_name(), s->cf_name());
+}
+
+void cache_warmer::warm_up_all() {
+    struct saved {
+        lw_shared_ptr<table> t;
+        std::vector<partition_key> keys;
+    };
+    std::vector<saved> tables;
+    for (auto& t : _db.local().get_column_families() | boost::adaptors::map_values) {
+        if (!is_cached(*t)) {
+            continue;
+        }
+        auto path = keys_file(*t->schema());
+        try {
+            if (!file_exists(path).get0()) {
+                continue;
+            }
+            auto f = open_file_dma(path, open_flags::ro).get0();
+            auto size = f.size().get0();
+            auto in = make_file_input_stream(std::move(f));
+            auto buf = in.read_exactly(size).finally([&in] {
+                return in.close();
+            }).get0();
+            auto keys = deserialize_saved_keys(bytes_view(reinterpret_cast<const int8_t*>(buf.get()), buf.size()));
+            if (!keys.empty()) {
+                tables.push_back(saved{t, std::move(keys)});
+            }
+        } catch (...) {
+            cwlogger.warn("Ignoring saved keys in {}: {}", path, std::current_exception());
+        }
+        seastar::thread::maybe_yield();
+    }
+    if (tables.empty()) {
+        return;
+    }
+
+    for (auto& e : tables) {
+        e.t->set_cache_warming_up(true);
+    }
+    auto clear_warming_up = defer([&] {
+        for (auto& e : tables) {
+            e.t->set_cache_warming_up(false);
+        }
+    });
+    cwlogger.info("Warming up cache of {:d} tables", tables.size());
+    for (auto& e : tables) {
+        try {
+            warm_up(*e.t, e.keys);
+        } catch (...) {
+            cwlogger.warn("Failed to warm up cache of {}.{}: {}", e.t->schema()->ks_name(), e.t->schema()->cf_name(), std::current_exception());
+        }
+        e.t->set_cache_warming_up(false);
+        e.keys = {};
+    }
+    cwlogger.info("Cache warm-up {}", _stopped ? "aborted" : "done");
+}
+
+future<> cache_warmer::start() {
+    _warm_up = with_gate(_gate, [this] {
+        return with_scheduling_group(_cfg.scheduling_group, [this] {
+            return seastar::async([this] {
+                warm_up_all();
+            });
+        });
+    }).handle_exception([] (auto ep) {
+        cwlogger.warn("Cache warm-up failed: {}", ep);
+    });
+    arm_timer();
+    return make_ready_future<>();
+}
+
+future<> cache_warmer::stop() {
+    if (_stopped) {
+        return make_ready_future<>();
+    }
+    _stopped = true;
+    _timer.cancel();
+    return std::exchange(_warm_up, make_ready_future<>()).then([this] {
+        if (!_cfg.save_period.count() || !_cfg.keys_to_save) {
+            return make_ready_future<>();
+        }
+        return save().handle_exception([] (auto ep) {
+            cwlogger.warn("Failed to save hot keys: {}", ep);
+        });
+    }).then([this] {
+        return _gate.close();
+    });
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/scheduling.hh>
+
+#include "seastarx.hh"
+#include "database_fwd.hh"
+#include "dht/i_partitioner.hh"
+
+namespace db {
+
+struct cache_warmer_config {
+    sstring saved_caches_directory;
+    // How often the keys are saved, zero disables saving.
+    std::chrono::seconds save_period;
+    // The number of keys saved per table and shard.
+    size_t keys_to_save;
+    seastar::scheduling_group scheduling_group;
+};
+
+// Shortens the time it takes for the row cache to warm up after a restart.
+//
+// The keys of the hottest partitions in the cache of each table are saved
+// periodically and on shutdown, in a file per table in a per-shard
+// subdirectory of saved_caches_directory. On startup, the saved partitions
+// are read into cache in the background, in a dedicated scheduling group.
+// Until that is done for a table, the shard reports the table's cache as
+// cold, so that heat-weighted load balancing doesn't direct reads to it
+// early.
+//
+// Keys which no longer belong to the shard which saved them, e.g. because
+// the shard count changed, are skipped.
+class cache_warmer {
+    distributed<database>& _db;
+    cache_warmer_config _cfg;
+    timer<lowres_clock> _timer;
+    semaphore _save_sem{1};
+    seastar::gate _gate;
+    bool _stopped = false;
+    future<> _warm_up = make_ready_future<>();
+private:
+    sstring keys_directory() const;
+    sstring keys_file(const schema&) const;
+    bool is_cached(const table&) const;
+    void save_keys(table&);
+    void warm_up(table&, const std::vector<partition_key>&);
+    void warm_up_all();
+    void arm_timer();
+public:
+    cache_warmer(distributed<database>& db, cache_warmer_config cfg);
+
+    // Starts warming up caches in the background and saving keys periodically.
+    future<> start();
+    // Waits for the warm-up to finish or be aborted, and saves the keys once more.
+    future<> stop();
+
+    // Saves the keys of all tables of this shard.
+    future<> save();
+};
+
+// Serialized form of a list of keys, see cache_warmer.cc.
+bytes serialize_saved_keys(const std::vector<dht::decorated_key>&);
+std::vector<partition_key> deserialize_saved_keys(bytes_view);
+
+}
@@ -73,6 +73,7 @@
 #include "utils/crc.hh"
 #include "utils/runtime.hh"
 #include "utils/flush_queue.hh"
+#include "utils/fragment_range.hh"
 #include "log.hh"
 #include "commitlog_entry.hh"
 #include "commitlog_extensions.hh"
@@ -114,6 +115,60 @@ class crc32_nbo {
     }
 };
 
+/*
+ * Compressed entries have entry_compressed_flag set in their size field and
+ * their data is made of a byte identifying the compressor, the size of the
+ * uncompressed data and the compressed data. The compressor is recorded in
+ * every entry so that replay doesn't depend on the configuration.
+ */
+static constexpr uint32_t entry_compressed_flag = 1u << 31;
+static constexpr size_t compressed_entry_header_size = sizeof(uint8_t) + sizeof(uint32_t);
+// Smaller entries rarely shrink by more than the header.
+static constexpr size_t min_compressed_entry_size = 256;
+// Compression works on contiguous buffers, don't allocate large ones.
+static constexpr size_t max_compressed_entry_size = 128 * 1024;
+
+static const std::array<sstring, 4> entry_compressor_names = {
+    "LZ4Compressor",
+    "SnappyCompressor",
+    "DeflateCompressor",
+    "ZstdCompressor",
+};
+
+static uint8_t entry_compressor_id(const compressor& c) {
+    for (size_t i = 0; i < entry_compressor_names.size(); ++i) {
+        if (c.name() == compressor::namespace_prefix + entry_compressor_names[i]) {
+            return i + 1;
+        }
+    }
+    throw std::invalid_argument(format("Unsupported commitlog compressor: {}", c.name()));
+}
+
+static compressor_ptr entry_compressor_of(uint8_t id) {
+    if (id < 1 || id > entry_compressor_names.size()) {
+        throw std::runtime_error(format("Unknown commitlog entry compressor {:d}", id));
+    }
+    return compressor::create(entry_compressor_names[id - 1], [] (const sstring&) { return compressor::opt_string(); });
+}
+
+static fragmented_temporary_buffer uncompress_entry(const fragmented_temporary_buffer& buf) {
+    return with_linearized(fragmented_temporary_buffer::view(buf), [] (bytes_view data) {
+        if (data.size() < compressed_entry_header_size) {
+            throw std::runtime_error("Truncated compressed commitlog entry");
+        }
+        auto c = entry_compressor_of(read_simple<uint8_t>(data));
+        auto size = read_simple<uint32_t>(data);
+        temporary_buffer<char> out(size);
+        auto len = c->uncompress(reinterpret_cast<const char*>(data.data()), data.size(), out.get_write(), size);
+        if (len != size) {
+            throw std::runtime_error(format("Compressed commitlog entry of {:d} bytes uncompressed to {:d}", size, len));
+        }
+        std::vector<temporary_buffer<char>> fragments;
+        fragments.push_back(std::move(out));
+        return fragmented_temporary_buffer(std::move(fragments), size);
+    });
+}
+
 class db::cf_holder {
 public:
     virtual ~cf_holder() {};
@@ -132,6 +187,8 @@ db::commitlog::config db::commitlog::config::from_db_config(const db::config& cf
     c.extensions = &cfg.extensions();
     c.reuse_segments = cfg.commitlog_reuse_segments();
     c.use_o_dsync = cfg.commitlog_use_o_dsync();
+    c.commitlog_sync_batch_window_in_ms = cfg.commitlog_sync_batch_window_in_ms();
+    c.entry_compressor = compressor::create(cfg.commitlog_compression(), [] (const sstring&) { return compressor::opt_string(); });
 
     return c;
 }
@@ -201,6 +258,8 @@ class db::commitlog::segment_manager : public ::enable_shared_from_this<segment_
     // Divide the size-on-disk threshold by #cpus used, since we assume
     // we distribute stuff more or less equally across shards.
     const uint64_t max_disk_size; // per-shard
+    // Recorded in compressed entries, zero if entries are not compressed.
+    const uint8_t entry_compressor_id;
 
     bool _shutdown = false;
     std::optional<shared_promise<>> _shutdown_promise = {};
@@ -261,10 +320,61 @@ class db::commitlog::segment_manager : public ::enable_shared_from_this<segment_
         uint64_t buffer_list_bytes = 0;
         uint64_t total_size_on_disk = 0;
         uint64_t requests_blocked_memory = 0;
+        uint64_t group_commits = 0;
+        uint64_t group_commit_writes = 0;
+        uint64_t compressed_entries = 0;
+        uint64_t bytes_saved_by_compression = 0;
+        uint64_t flush_requests = 0;
     };
 
     stats totals;
 
+    // Group commit state of BATCH mode, see segment::batch_cycle().
+    using latency_clock_type = std::chrono::steady_clock;
+    // Moving average of the latency of file flushes.
+    std::chrono::microseconds _flush_latency{0};
+    // How long the first write of a group waits for others to join it.
+    std::chrono::microseconds _batch_window{0};
+    // Writes waiting for their batch to be flushed.
+    unsigned _batch_writes_in_flight = 0;
+
+    void account_flush_latency(std::chrono::microseconds latency) {
+        _flush_latency = _flush_latency.count() ? (_flush_latency * 7 + latency) / 8 : latency;
+    }
+
+    // Grouping never makes a write wait longer than a flush takes.
+    std::chrono::microseconds max_batch_window() const {
+        return std::min<std::chrono::microseconds>(std::chrono::milliseconds(cfg.commitlog_sync_batch_window_in_ms), _flush_latency);
+    }
+
+    std::chrono::microseconds batch_window() {
+        if (!_batch_window.count() && _batch_writes_in_flight > 1) {
+            // Writes are queueing behind each other's flushes, start
+            // grouping them.
+            _batch_window = max_batch_window() / 4;
+        }
+        return std::min(_batch_window, max_batch_window());
+    }
+
+    // Shutdown closes this gate before closing the segments.
+    seastar::gate& group_commit_gate() {
+        return _gate;
+    }
+
+    // Grows the window additively while groups gather concurrent writes and
+    // halves it when a write ends up alone, so that sequential writers don't
+    // pay for the wait.
+    void adjust_batch_window(unsigned group_writes) {
+        ++totals.group_commits;
+        totals.group_commit_writes += group_writes;
+        if (group_writes > 1) {
+            auto step = std::max<std::chrono::microseconds>(max_batch_window() / 4, std::chrono::microseconds(1));
+            _batch_window = std::min(_batch_window + step, max_batch_window());
+        } else {
+            _batch_window /= 2;
+        }
+    }
+
     size_t pending_allocations() const {
         return _request_controller.waiters();
     }
@@ -465,6 +575,10 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
 
     std::unordered_set<table_schema_version> _known_schema_versions;
 
+    // The batch window currently open on this segment, if any.
+    lw_shared_ptr<shared_promise<sseg_ptr>> _group_commit;
+    unsigned _group_commit_writes = 0;
+
     friend std::ostream& operator<<(std::ostream&, const segment&);
     friend class segment_manager;
 
@@ -639,13 +753,16 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
                 clogger.trace("{} already synced! ({} < {})", *this, pos, _flush_pos);
                 return make_ready_future<>();
             }
-            return _file.flush().then_wrapped([this, pos](future<> f) {
+            auto start = segment_manager::latency_clock_type::now();
+            return _file.flush().then_wrapped([this, pos, start](future<> f) {
                 try {
                     f.get();
                     // TODO: retry/ignore/fail/stop - optional behaviour in origin.
                     // we fast-fail the whole commit.
                     _flush_pos = std::max(pos, _flush_pos);
                     ++_segment_manager->totals.flush_count;
+                    _segment_manager->account_flush_latency(std::chrono::duration_cast<std::chrono::microseconds>(
+                            segment_manager::latency_clock_type::now() - start));
                     clogger.trace("{} synced to {}", *this, _flush_pos);
                 } catch (...) {
                     clogger.error("Failed to flush commits to disk: {}", std::current_exception());
@@ -793,6 +910,51 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
     }
 
     future<sseg_ptr> batch_cycle(timeout_clock::time_point timeout) {
+        if (_segment_manager->cfg.mode != sync_mode::BATCH) {
+            return do_batch_cycle(timeout);
+        }
+        /**
+         * Group commit: while writes keep arriving concurrently, the first
+         * write of a group holds the sync back for a short window (see
+         * segment_manager::batch_window()) so that a single write and flush
+         * covers all writes which joined in the meantime. None of them is
+         * acknowledged before the flush, so durability is that of a sync
+         * per write.
+         */
+        auto me = shared_from_this();
+        ++_segment_manager->_batch_writes_in_flight;
+        auto f = make_ready_future<sseg_ptr>();
+        if (_group_commit) {
+            ++_group_commit_writes;
+            f = with_timeout(timeout, _group_commit->get_shared_future());
+        } else if (auto window = _segment_manager->batch_window(); window.count() && !_segment_manager->group_commit_gate().is_closed()) {
+            _group_commit = make_lw_shared<shared_promise<sseg_ptr>>();
+            _group_commit_writes = 1;
+            f = with_timeout(timeout, _group_commit->get_shared_future());
+            // Shutdown waits for the gate, the group will be flushed before
+            // the segments are closed.
+            (void)with_gate(_segment_manager->group_commit_gate(), [me, window] {
+                return seastar::sleep(window).then([me] {
+                    auto pr = std::exchange(me->_group_commit, {});
+                    me->_segment_manager->adjust_batch_window(std::exchange(me->_group_commit_writes, 0));
+                    return me->do_batch_cycle(db::no_timeout).then_wrapped([pr] (future<sseg_ptr> f) {
+                        if (f.failed()) {
+                            pr->set_exception(f.get_exception());
+                        } else {
+                            pr->set_value(f.get0());
+                        }
+                    });
+                });
+            });
+        } else {
+            f = do_batch_cycle(timeout);
+        }
+        return f.finally([me] {
+            --me->_segment_manager->_batch_writes_in_flight;
+        });
+    }
+
+    future<sseg_ptr> do_batch_cycle(timeout_clock::time_point timeout) {
         /**
          * For batch mode we force a write "immediately".
          * However, we first wait for all previous writes/flushes
@@ -844,8 +1006,8 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
             });
         }
 
-        const auto size = writer->size(*this);
-        const auto s = size + entry_overhead_size; // total size
+        auto size = writer->size(*this);
+        auto s = size + entry_overhead_size; // total size
         auto ep = _segment_manager->sanity_check_size(s);
         if (ep) {
             return make_exception_future<rp_handle>(std::move(ep));
@@ -873,6 +1035,22 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
             }
         }
 
+        // The entry is serialized in advance when compressed, so that its
+        // size is known. Compression only ever shrinks it, so all the checks
+        // above hold.
+        std::optional<temporary_buffer<char>> payload;
+        bool compressed = false;
+        if (_segment_manager->entry_compressor_id && size >= min_compressed_entry_size && size <= max_compressed_entry_size) {
+            payload = compress_entry(*writer, size);
+            compressed = payload->size() < size;
+            if (compressed) {
+                ++_segment_manager->totals.compressed_entries;
+                _segment_manager->totals.bytes_saved_by_compression += size - payload->size();
+                size = payload->size();
+                s = size + entry_overhead_size;
+            }
+        }
+
         size_t buf_memory = s;
         if (_buffer.empty()) {
             new_buffer(s);
@@ -894,17 +1072,23 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
         auto out = _buffer_ostream.write_substream(s);
         crc32_nbo crc;
 
-        write<uint32_t>(out, s);
-        crc.process(uint32_t(s));
+        const auto size_field = compressed ? uint32_t(s) | entry_compressed_flag : uint32_t(s);
+        write<uint32_t>(out, size_field);
+        crc.process(size_field);
         write<uint32_t>(out, crc.checksum());
 
         // actual data
         auto entry_out = out.write_substream(size);
-        auto entry_data = entry_out.to_input_stream();
-        writer->write(*this, entry_out);
-        entry_data.with_stream([&] (auto data_str) {
-            crc.process_fragmented(ser::buffer_view<typename std::vector<temporary_buffer<char>>::iterator>(data_str));
-        });
+        if (payload) {
+            entry_out.write(payload->get(), size);
+            crc.process_bytes(payload->get(), size);
+        } else {
+            auto entry_data = entry_out.to_input_stream();
+            writer->write(*this, entry_out);
+            entry_data.with_stream([&] (auto data_str) {
+                crc.process_fragmented(ser::buffer_view<typename std::vector<temporary_buffer<char>>::iterator>(data_str));
+            });
+        }
 
         write<uint32_t>(out, crc.checksum());
 
@@ -929,6 +1113,35 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
         }
     }
 
+    /**
+     * Serializes the entry and compresses it. Returns the serialized,
+     * uncompressed entry if compression doesn't make it smaller.
+     */
+    temporary_buffer<char> compress_entry(entry_writer& writer, size_t size) {
+        auto& c = *_segment_manager->cfg.entry_compressor;
+        temporary_buffer<char> raw_buf(size);
+        const char* data = raw_buf.get();
+        std::vector<temporary_buffer<char>> fragments;
+        fragments.push_back(std::move(raw_buf));
+        fragmented_temporary_buffer raw(std::move(fragments), size);
+        auto raw_out = raw.get_ostream();
+        writer.write(*this, raw_out);
+
+        temporary_buffer<char> out(compressed_entry_header_size + c.compress_max_size(size));
+        auto p = out.get_write();
+        *p++ = _segment_manager->entry_compressor_id;
+        auto be_size = net::hton(uint32_t(size));
+        std::copy_n(reinterpret_cast<const char*>(&be_size), sizeof(be_size), p);
+        auto len = compressed_entry_header_size + c.compress(data, size, p + sizeof(be_size), out.size() - compressed_entry_header_size);
+        if (len >= size) {
+            temporary_buffer<char> uncompressed(size);
+            std::copy_n(data, size, uncompressed.get_write());
+            return uncompressed;
+        }
+        out.trim(len);
+        return out;
+    }
+
     position_type position() const {
         return position_type(_file_pos + buffer_position());
     }
@@ -1035,6 +1248,7 @@ db::commitlog::segment_manager::segment_manager(config c)
     , max_size(std::min<size_t>(std::numeric_limits<position_type>::max(), std::max<size_t>(cfg.commitlog_segment_size_in_mb, 1) * 1024 * 1024))
     , max_mutation_size(max_size >> 1)
     , max_disk_size(size_t(std::ceil(cfg.commitlog_total_space_in_mb / double(smp::count))) * 1024 * 1024)
+    , entry_compressor_id(cfg.entry_compressor ? ::entry_compressor_id(*cfg.entry_compressor) : 0)
     , _flush_semaphore(cfg.max_active_flushes)
     // That is enough concurrency to allow for our largest mutation (max_mutation_size), plus
     // an existing in-flight buffer. Since we'll force the cycling() of any buffer that is bigger
@@ -1216,6 +1430,22 @@ void db::commitlog::segment_manager::create_counters(const sstring& metrics_cate
 
         sm::make_gauge("memory_buffer_bytes", totals.buffer_list_bytes,
                        sm::description("Holds the total number of bytes in internal memory buffers.")),
+
+        sm::make_derive("group_commits", totals.group_commits,
+                       sm::description("Counts a number of batch mode syncs which were held back for other writes to join them.")),
+
+        sm::make_derive("compressed_entries", totals.compressed_entries,
+                       sm::description("Counts a number of entries written compressed.")),
+
+        sm::make_derive("bytes_saved_by_compression", totals.bytes_saved_by_compression,
+                       sm::description("Counts a number of bytes entries were shrunk by compression.")),
+
+        sm::make_derive("group_commit_writes", totals.group_commit_writes,
+                       sm::description("Counts a number of writes covered by group commits. "
+                                       "Divide this value by \"group_commits\" to get the average number of writes per group.")),
+
+        sm::make_derive("flush_requests", totals.flush_requests,
+                       sm::description("Counts a number of table flushes requested to free segments when the disk usage exceeded the threshold.")),
     });
 }
 
@@ -1236,15 +1466,28 @@ void db::commitlog::segment_manager::flush_segments(bool force) {
         high = replay_position(high.id + 1, 0);
     }
 
-    // Now get a set of used CF ids:
-    std::unordered_set<cf_id_type> ids;
-    std::for_each(_segments.begin(), _segments.end() - 1, [&ids](sseg_ptr& s) {
-        for (auto& id : s->_cf_dirty | boost::adaptors::map_keys) {
-            ids.insert(id);
+    // Now get the CF ids pinning the closed segments, oldest segment first.
+    // Unless forced, only the tables holding back the oldest segments are
+    // flushed, as many as it takes for deleting these segments to bring the
+    // disk usage back under the limit. Tables only dirty in newer segments
+    // are left to fill their memtables.
+    std::vector<cf_id_type> ids;
+    std::unordered_set<cf_id_type> seen;
+    uint64_t releasable = 0;
+    for (auto i = _segments.begin(); i != _segments.end() - 1; ++i) {
+        if (!force && max_disk_size != 0 && totals.total_size_on_disk - releasable < max_disk_size) {
+            break;
         }
-    });
+        for (auto& id : (*i)->_cf_dirty | boost::adaptors::map_keys) {
+            if (seen.insert(id).second) {
+                ids.push_back(id);
+            }
+        }
+        releasable += (*i)->size_on_disk();
+    }
+    totals.flush_requests += ids.size();
 
-    clogger.debug("Flushing ({}) to {}", force, high);
+    clogger.debug("Flushing ({}) {} tables to {}", force, ids.size(), high);
 
     // For each CF id: for each callback c: call c(id, high)
     for (auto& f : callbacks) {
@@ -2051,6 +2294,9 @@ db::commitlog::read_log_file(const sstring& filename, const sstring& pfx, seasta
                 crc32_nbo crc;
                 crc.process(size);
 
+                const bool compressed = size & entry_compressed_flag;
+                size &= ~entry_compressed_flag;
+
                 if (size < 3 * sizeof(uint32_t) || checksum != crc.checksum()) {
                     auto slack = next - pos;
                     if (size != 0) {
@@ -2061,7 +2307,7 @@ db::commitlog::read_log_file(const sstring& filename, const sstring& pfx, seasta
                     return skip(slack);
                 }
 
-                return frag_reader.read_exactly(fin, size - entry_header_size).then([this, size, crc = std::move(crc), rp](fragmented_temporary_buffer buf) mutable {
+                return frag_reader.read_exactly(fin, size - entry_header_size).then([this, size, compressed, crc = std::move(crc), rp](fragmented_temporary_buffer buf) mutable {
                     advance(buf);
 
                     auto in = buf.get_istream();
@@ -2081,6 +2327,16 @@ db::commitlog::read_log_file(const sstring& filename, const sstring& pfx, seasta
                         return make_ready_future<>();
                     }
 
+                    if (compressed) {
+                        try {
+                            buf = uncompress_entry(buf);
+                        } catch (...) {
+                            clogger.debug("Segment entry at {} failed to uncompress: {}. Skipping {} bytes", rp, std::current_exception(), size);
+                            corrupt_size += size;
+                            return make_ready_future<>();
+                        }
+                    }
+
                     return s.produce({std::move(buf), rp}).handle_exception([this](auto ep) {
                         return fail();
                     });
@@ -2146,6 +2402,10 @@ uint64_t db::commitlog::get_total_size() const {
     return _segment_manager->totals.total_size;
 }
 
+uint64_t db::commitlog::get_bytes_written() const {
+    return _segment_manager->totals.bytes_written;
+}
+
 uint64_t db::commitlog::get_completed_tasks() const {
     return _segment_manager->totals.allocation_count;
 }
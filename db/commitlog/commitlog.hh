@@ -47,6 +47,7 @@
 #include <seastar/core/stream.hh>
 #include "replay_position.hh"
 #include "commitlog_entry.hh"
+#include "compress.hh"
 #include "db/timeout_clock.hh"
 #include "utils/fragmented_temporary_buffer.hh"
 
@@ -124,6 +125,9 @@ class commitlog {
         uint64_t commitlog_total_space_in_mb = 0;
         uint64_t commitlog_segment_size_in_mb = 32;
         uint64_t commitlog_sync_period_in_ms = 10 * 1000; //TODO: verify default!
+        // Upper bound of the adaptive group commit window of BATCH mode.
+        // Zero disables group commit.
+        uint64_t commitlog_sync_batch_window_in_ms = 0;
         // Max number of segments to keep in pre-alloc reserve.
         // Not (yet) configurable from scylla.conf.
         uint64_t max_reserve_segments = 12;
@@ -139,6 +143,8 @@ class commitlog {
         bool use_o_dsync = false;
 
         const db::extensions * extensions = nullptr;
+        // Compresses entries when set.
+        compressor_ptr entry_compressor;
     };
 
     struct descriptor {
@@ -290,6 +296,7 @@ class commitlog {
     future<> delete_segments(std::vector<sstring>) const;
 
     uint64_t get_total_size() const;
+    uint64_t get_bytes_written() const;
     uint64_t get_completed_tasks() const;
     uint64_t get_flush_count() const;
     uint64_t get_pending_tasks() const;
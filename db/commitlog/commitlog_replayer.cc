@@ -47,6 +47,10 @@
 
 #include <seastar/core/future.hh>
 #include <seastar/core/sharded.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics.hh>
+#include <seastar/core/memory.hh>
 
 #include "commitlog.hh"
 #include "commitlog_replayer.hh"
@@ -63,9 +67,28 @@
 
 static logging::logger rlogger("commitlog_replayer");
 
+namespace sm = seastar::metrics;
+
 class db::commitlog_replayer::impl {
-    struct column_mappings {
+    // Segments of each shard are replayed concurrently, and the mutations
+    // read from them are forwarded to the shards owning them in batches.
+    static constexpr size_t max_concurrent_segments = 4;
+    static constexpr size_t max_batch_mutations = 128;
+    static constexpr size_t max_batch_bytes = 1024 * 1024;
+
+    struct local_state {
         std::unordered_map<table_schema_version, column_mapping> map;
+        // Bounds the memory of the entries read but not applied yet.
+        const size_t memory_budget;
+        semaphore memory;
+        semaphore segments{max_concurrent_segments};
+
+        uint64_t segments_total = 0;
+        uint64_t segments_replayed = 0;
+        uint64_t bytes_read = 0;
+        sm::metric_groups metrics;
+
+        local_state();
         future<> stop() { return make_ready_future<>(); }
     };
 
@@ -74,7 +97,7 @@ class db::commitlog_replayer::impl {
     // this one is special since it is thread local.
     // Should actually make sharded::local a const function (it does
     // not modify content), but...
-    mutable seastar::sharded<column_mappings> _column_mappings;
+    mutable seastar::sharded<local_state> _local_state;
 
     friend class db::commitlog_replayer;
 public:
@@ -105,13 +128,38 @@ class db::commitlog_replayer::impl {
     // move start/stop of the thread local bookkeep to "top level"
     // and also make sure to assert on it actually being started.
     future<> start() {
-        return _column_mappings.start();
+        return _local_state.start();
     }
     future<> stop() {
-        return _column_mappings.stop();
+        return _local_state.stop();
     }
 
-    future<> process(stats*, commitlog::buffer_and_replay_position buf_rp) const;
+    // An entry read from a segment, to be applied on the shard owning it.
+    struct entry {
+        commitlog_entry_reader cer;
+        // The column mapping of the entry, owned by the reading shard.
+        const column_mapping* src_cm;
+        replay_position rp;
+    };
+
+    struct batch {
+        std::vector<entry> entries;
+        std::vector<semaphore_units<>> units;
+        size_t bytes = 0;
+    };
+
+    // The replay of a single segment.
+    struct segment_replay {
+        stats s;
+        std::vector<batch> batches{smp::count};
+        seastar::gate pending;
+    };
+
+    future<> process(segment_replay&, commitlog::buffer_and_replay_position buf_rp) const;
+    void add_entry(segment_replay&, commitlog::buffer_and_replay_position buf_rp, semaphore_units<> units) const;
+    void send_batch(segment_replay&, unsigned shard) const;
+    void send_batches(segment_replay&) const;
+    future<> apply(database& db, entry& e) const;
     future<stats> recover(sstring file, const sstring& fname_prefix) const;
 
     typedef std::unordered_map<utils::UUID, replay_position> rp_map;
@@ -143,6 +191,25 @@ db::commitlog_replayer::impl::impl(seastar::sharded<database>& db)
     : _db(db)
 {}
 
+db::commitlog_replayer::impl::local_state::local_state()
+    : memory_budget(std::max<size_t>(memory::stats().total_memory() / 16, max_batch_bytes))
+    , memory(memory_budget)
+{
+    metrics.add_group("commitlog_replay", {
+        sm::make_gauge("segments_total", segments_total,
+                       sm::description("Holds the number of commitlog segments to be replayed by this shard.")),
+
+        sm::make_derive("segments_replayed", segments_replayed,
+                       sm::description("Counts the number of commitlog segments replayed by this shard.")),
+
+        sm::make_derive("bytes_read", bytes_read,
+                       sm::description("Counts the number of bytes of entries read from commitlog segments by this shard.")),
+
+        sm::make_gauge("pending_bytes", [this] { return memory_budget - memory.available_units(); },
+                       sm::description("Holds the number of bytes of entries read by this shard but not applied yet.")),
+    });
+}
+
 future<> db::commitlog_replayer::impl::init() {
     return _db.map_reduce([this](shard_rpm_map map) {
         for (auto& p1 : map) {
@@ -208,7 +275,7 @@ future<> db::commitlog_replayer::impl::init() {
 
 future<db::commitlog_replayer::impl::stats>
 db::commitlog_replayer::impl::recover(sstring file, const sstring& fname_prefix) const {
-    assert(_column_mappings.local_is_initialized());
+    assert(_local_state.local_is_initialized());
 
     replay_position rp{commitlog::descriptor(file, fname_prefix)};
     auto gp = min_pos(rp.shard_id());
@@ -222,31 +289,51 @@ db::commitlog_replayer::impl::recover(sstring file, const sstring& fname_prefix)
         p = gp.pos;
     }
 
-    auto s = make_lw_shared<stats>();
+    auto sr = make_lw_shared<segment_replay>();
     auto& exts = _db.local().extensions();
 
     return db::commitlog::read_log_file(file, fname_prefix, service::get_local_commitlog_priority(),
-            std::bind(&impl::process, this, s.get(), std::placeholders::_1),
-            p, &exts).then_wrapped([s](future<> f) {
-        try {
-            f.get();
-        } catch (commitlog::segment_data_corruption_error& e) {
-            s->corrupt_bytes += e.bytes();
-        } catch (...) {
-            throw;
-        }
-        return make_ready_future<stats>(*s);
+            [this, sr] (commitlog::buffer_and_replay_position buf_rp) {
+                return process(*sr, std::move(buf_rp));
+            },
+            p, &exts).then_wrapped([this, sr](future<> f) {
+        send_batches(*sr);
+        return sr->pending.close().then([sr, f = std::move(f)] () mutable {
+            try {
+                f.get();
+            } catch (commitlog::segment_data_corruption_error& e) {
+                sr->s.corrupt_bytes += e.bytes();
+            } catch (...) {
+                throw;
+            }
+            return make_ready_future<stats>(sr->s);
+        });
     });
 }
 
-future<> db::commitlog_replayer::impl::process(stats* s, commitlog::buffer_and_replay_position buf_rp) const {
+future<> db::commitlog_replayer::impl::process(segment_replay& sr, commitlog::buffer_and_replay_position buf_rp) const {
+    auto& local = _local_state.local();
+    local.bytes_read += buf_rp.buffer.size_bytes();
+    auto size = std::min(buf_rp.buffer.size_bytes(), local.memory_budget);
+    if (local.memory.available_units() < ssize_t(size)) {
+        // Entries waiting for their batch to fill up hold memory too, send
+        // them so that it's released.
+        send_batches(sr);
+    }
+    return get_units(local.memory, size).then([this, &sr, buf_rp = std::move(buf_rp)] (semaphore_units<> units) mutable {
+        add_entry(sr, std::move(buf_rp), std::move(units));
+    });
+}
+
+void db::commitlog_replayer::impl::add_entry(segment_replay& sr, commitlog::buffer_and_replay_position buf_rp, semaphore_units<> units) const {
     auto&& [buf, rp] = buf_rp;
+    auto* s = &sr.s;
     try {
 
         commitlog_entry_reader cer(buf);
         auto& fm = cer.mutation();
 
-        auto& local_cm = _column_mappings.local().map;
+        auto& local_cm = _local_state.local().map;
         auto cm_it = local_cm.find(fm.schema_version());
         if (cm_it == local_cm.end()) {
             if (!cer.get_column_mapping()) {
@@ -261,7 +348,7 @@ future<> db::commitlog_replayer::impl::process(stats* s, commitlog::buffer_and_r
         if (rp < min_pos(shard_id)) {
             rlogger.trace("entry {} is less than global min position. skipping", rp);
             s->skipped_mutations++;
-            return make_ready_future<>();
+            return;
         }
 
         auto uuid = fm.column_family_id();
@@ -269,54 +356,17 @@ future<> db::commitlog_replayer::impl::process(stats* s, commitlog::buffer_and_r
         if (rp <= cf_rp) {
             rlogger.trace("entry {} at {} is younger than recorded replay position {}. skipping", fm.column_family_id(), rp, cf_rp);
             s->skipped_mutations++;
-            return make_ready_future<>();
+            return;
         }
 
         auto shard = _db.local().shard_of(fm);
-        return _db.invoke_on(shard, [this, cer = std::move(cer), &src_cm, rp, shard, s] (database& db) mutable -> future<> {
-            auto& fm = cer.mutation();
-            // TODO: might need better verification that the deserialized mutation
-            // is schema compatible. My guess is that just applying the mutation
-            // will not do this.
-            auto& cf = db.find_column_family(fm.column_family_id());
-
-            if (rlogger.is_enabled(logging::log_level::debug)) {
-                rlogger.debug("replaying at {} v={} {}:{} at {}", fm.column_family_id(), fm.schema_version(),
-                        cf.schema()->ks_name(), cf.schema()->cf_name(), rp);
-            }
-            // Removed forwarding "new" RP. Instead give none/empty.
-            // This is what origin does, and it should be fine.
-            // The end result should be that once sstables are flushed out
-            // their "replay_position" attribute will be empty, which is
-            // lower than anything the new session will produce.
-            if (cf.schema()->version() != fm.schema_version()) {
-                auto& local_cm = _column_mappings.local().map;
-                auto cm_it = local_cm.find(fm.schema_version());
-                if (cm_it == local_cm.end()) {
-                    cm_it = local_cm.emplace(fm.schema_version(), src_cm).first;
-                }
-                const column_mapping& cm = cm_it->second;
-                mutation m(cf.schema(), fm.decorated_key(*cf.schema()));
-                converting_mutation_partition_applier v(cm, *cf.schema(), m.partition());
-                fm.partition().accept(cm, v);
-                return do_with(std::move(m), [&db, &cf] (mutation m) {
-                    return db.apply_in_memory(m, cf, db::rp_handle(), db::no_timeout);
-                });
-            } else {
-                return do_with(std::move(cer).mutation(), [&](const frozen_mutation& m) {
-                    return db.apply_in_memory(m, cf.schema(), db::rp_handle(), db::no_timeout);
-                });
-            }
-        }).then_wrapped([s] (future<> f) {
-            try {
-                f.get();
-                s->applied_mutations++;
-            } catch (...) {
-                s->invalid_mutations++;
-                // TODO: write mutation to file like origin.
-                rlogger.warn("error replaying: {}", std::current_exception());
-            }
-        });
+        auto& b = sr.batches[shard];
+        b.bytes += buf.size_bytes();
+        b.entries.push_back(entry{std::move(cer), &src_cm, rp});
+        b.units.push_back(std::move(units));
+        if (b.entries.size() >= max_batch_mutations || b.bytes >= max_batch_bytes) {
+            send_batch(sr, shard);
+        }
     } catch (no_such_column_family&) {
         // No such CF now? Origin just ignores this.
     } catch (...) {
@@ -324,8 +374,82 @@ future<> db::commitlog_replayer::impl::process(stats* s, commitlog::buffer_and_r
         // TODO: write mutation to file like origin.
         rlogger.warn("error replaying: {}", std::current_exception());
     }
+}
+
+void db::commitlog_replayer::impl::send_batch(segment_replay& sr, unsigned shard) const {
+    auto b = std::exchange(sr.batches[shard], {});
+    if (b.entries.empty()) {
+        return;
+    }
+    // Waited for by recover(), through the gate.
+    (void)with_gate(sr.pending, [this, &sr, shard, b = std::move(b)] () mutable {
+        auto count = b.entries.size();
+        return _db.invoke_on(shard, [this, entries = std::move(b.entries)] (database& db) mutable {
+            return do_with(std::move(entries), stats(), [this, &db] (std::vector<entry>& entries, stats& s) {
+                return do_for_each(entries, [this, &db, &s] (entry& e) {
+                    return apply(db, e).then_wrapped([&s] (future<> f) {
+                        try {
+                            f.get();
+                            s.applied_mutations++;
+                        } catch (...) {
+                            s.invalid_mutations++;
+                            // TODO: write mutation to file like origin.
+                            rlogger.warn("error replaying: {}", std::current_exception());
+                        }
+                    });
+                }).then([&s] {
+                    return s;
+                });
+            });
+        }).then_wrapped([&sr, count, units = std::move(b.units)] (future<stats> f) {
+            try {
+                sr.s += f.get0();
+            } catch (...) {
+                sr.s.invalid_mutations += count;
+                rlogger.warn("error replaying: {}", std::current_exception());
+            }
+        });
+    });
+}
+
+void db::commitlog_replayer::impl::send_batches(segment_replay& sr) const {
+    for (unsigned shard = 0; shard < smp::count; ++shard) {
+        send_batch(sr, shard);
+    }
+}
 
-    return make_ready_future<>();
+future<> db::commitlog_replayer::impl::apply(database& db, entry& e) const {
+    auto& fm = e.cer.mutation();
+    // TODO: might need better verification that the deserialized mutation
+    // is schema compatible. My guess is that just applying the mutation
+    // will not do this.
+    auto& cf = db.find_column_family(fm.column_family_id());
+
+    if (rlogger.is_enabled(logging::log_level::debug)) {
+        rlogger.debug("replaying at {} v={} {}:{} at {}", fm.column_family_id(), fm.schema_version(),
+                cf.schema()->ks_name(), cf.schema()->cf_name(), e.rp);
+    }
+    // Removed forwarding "new" RP. Instead give none/empty.
+    // This is what origin does, and it should be fine.
+    // The end result should be that once sstables are flushed out
+    // their "replay_position" attribute will be empty, which is
+    // lower than anything the new session will produce.
+    if (cf.schema()->version() != fm.schema_version()) {
+        auto& local_cm = _local_state.local().map;
+        auto cm_it = local_cm.find(fm.schema_version());
+        if (cm_it == local_cm.end()) {
+            cm_it = local_cm.emplace(fm.schema_version(), *e.src_cm).first;
+        }
+        const column_mapping& cm = cm_it->second;
+        mutation m(cf.schema(), fm.decorated_key(*cf.schema()));
+        converting_mutation_partition_applier v(cm, *cf.schema(), m.partition());
+        fm.partition().accept(cm, v);
+        return do_with(std::move(m), [&db, &cf] (mutation m) {
+            return db.apply_in_memory(m, cf, db::rp_handle(), db::no_timeout);
+        });
+    } else {
+        return db.apply_in_memory(fm, cf.schema(), db::rp_handle(), db::no_timeout);
+    }
 }
 
 db::commitlog_replayer::commitlog_replayer(seastar::sharded<database>& db)
@@ -366,24 +490,25 @@ future<> db::commitlog_replayer::recover(std::vector<sstring> files, sstring fna
             return map_reduce(smp::all_cpus(), [this, map, &fname_prefix] (unsigned id) {
                 return smp::submit_to(id, [this, id, map, &fname_prefix] () {
                     auto total = ::make_lw_shared<impl::stats>();
-                    // TODO: or something. For now, we do this serialized per shard,
-                    // to reduce mutation congestion. We could probably (says avi)
-                    // do 2 segments in parallel or something, but lets use this first.
                     auto range = map->equal_range(id);
-                    return do_for_each(range.first, range.second, [this, total, &fname_prefix] (const std::pair<unsigned, sstring>& p) {
-                        auto&f = p.second;
-                        rlogger.debug("Replaying {}", f);
-                        return _impl->recover(f, fname_prefix).then([f, total](impl::stats stats) {
-                            if (stats.corrupt_bytes != 0) {
-                                rlogger.warn("Corrupted file: {}. {} bytes skipped.", f, stats.corrupt_bytes);
-                            }
-                            rlogger.debug("Log replay of {} complete, {} replayed mutations ({} invalid, {} skipped)"
-                                            , f
-                                            , stats.applied_mutations
-                                            , stats.invalid_mutations
-                                            , stats.skipped_mutations
-                            );
-                            *total += stats;
+                    auto& local = _impl->_local_state.local();
+                    local.segments_total += std::distance(range.first, range.second);
+                    return parallel_for_each(range.first, range.second, [this, total, &local, &fname_prefix] (const std::pair<const unsigned, sstring>& p) {
+                        return with_semaphore(local.segments, 1, [this, total, &local, &fname_prefix, &f = p.second] {
+                            rlogger.debug("Replaying {}", f);
+                            return _impl->recover(f, fname_prefix).then([f, total, &local](impl::stats stats) {
+                                if (stats.corrupt_bytes != 0) {
+                                    rlogger.warn("Corrupted file: {}. {} bytes skipped.", f, stats.corrupt_bytes);
+                                }
+                                rlogger.debug("Log replay of {} complete, {} replayed mutations ({} invalid, {} skipped)"
+                                                , f
+                                                , stats.applied_mutations
+                                                , stats.invalid_mutations
+                                                , stats.skipped_mutations
+                                );
+                                *total += stats;
+                                ++local.segments_replayed;
+                            });
                         });
                     }).then([total] {
                         return make_ready_future<impl::stats>(*total);
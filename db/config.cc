@@ -197,8 +197,22 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "If set to higher than 0, ignore the controller's output and set the memtable shares statically. Do not set this unless you know what you are doing and suspect a problem in the controller. This option will be retired when the controller reaches more maturity")
     , compaction_static_shares(this, "compaction_static_shares", value_status::Used, 0,
         "If set to higher than 0, ignore the controller's output and set the compaction shares statically. Do not set this unless you know what you are doing and suspect a problem in the controller. This option will be retired when the controller reaches more maturity")
+    , compaction_read_latency_target_us(this, "compaction_read_latency_target_us", liveness::LiveUpdate, value_status::Used, 0,
+        "If set to higher than 0, the compaction controller lowers the compaction shares it derived from the backlog, by up to 4 times, while the 99th percentile of the local read latency of the shard exceeds this many microseconds, and raises them, by up to 2 times, while it stays under half of it. 0 (default) disables the latency feedback")
+    , compaction_write_latency_target_us(this, "compaction_write_latency_target_us", liveness::LiveUpdate, value_status::Used, 0,
+        "Like compaction_read_latency_target_us, for the 99th percentile of the local write latency of the shard. 0 (default) disables the latency feedback")
     , compaction_enforce_min_threshold(this, "compaction_enforce_min_threshold", liveness::LiveUpdate, value_status::Used, false,
         "If set to true, enforce the min_threshold option for compactions strictly. If false (default), Scylla may decide to compact even if below min_threshold")
+    , compaction_max_parallel_subranges(this, "compaction_max_parallel_subranges", liveness::LiveUpdate, value_status::Used, 1,
+        "Maximum number of disjoint token sub-ranges a large regular compaction is split into and compacted concurrently, with each sub-range receiving at least 1GB of input. Splitting trades extra index reads for a faster drain of large compactions on otherwise idle resources. 1 (default) disables splitting.")
+    , repair_tombstone_gc_propagation_delay_in_s(this, "repair_tombstone_gc_propagation_delay_in_s", liveness::LiveUpdate, value_status::Used, 10800,
+        "For tables with tombstone_gc = repair, a repair allows purging only the tombstones written this many seconds before it started. This covers writes still in flight, or reaching a replica after the repair read it, and clock skew between the nodes. The default matches max_hint_window_in_ms.")
+    , incremental_repair_session_timeout_in_s(this, "incremental_repair_session_timeout_in_s", liveness::LiveUpdate, value_status::Used, 86400,
+        "Time in seconds after which a replica drops an incremental repair session the repair master didn't finish, for instance because it died. The sstables recorded by the session stay unrepaired. Must exceed the duration of the longest repair.")
+    , memtable_flush_max_parallel_subranges(this, "memtable_flush_max_parallel_subranges", liveness::LiveUpdate, value_status::Used, 4,
+        "Maximum number of disjoint token sub-ranges a large memtable is split into and flushed concurrently, into sstables forming a single run, with each sub-range holding at least 128MB. Dirty memory is released as fast as all sub-ranges are written, which shortens write throttling during ingest bursts. 1 disables splitting.")
+    , shared_sstable_reshard_threshold(this, "shared_sstable_reshard_threshold", value_status::Used, 1,
+        "Shared sstables, which hold data of several shards (e.g. after the shard count changed, or when loading sstables written by another node), are resharded in the background when owned by more than this many shards. Shared sstables owned by fewer shards are served as they are, and every owner rewrites its part with regular compaction instead; the files are deleted once all owners did. Their releases are kept in a released/ directory next to the sstables, and reads skip the data of the owners which released them, also after the shard count changed. Experimental: there is no background pass reshaping the remaining shared sstables, so space is only reclaimed as fast as regular compaction picks them. 1 (default) disables this and reshards all shared sstables.")
     /* Initialization properties */
     /* The minimal properties needed for configuring a cluster. */
     , cluster_name(this, "cluster_name", value_status::Used, "",
@@ -226,12 +240,16 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "The directory where the commit log is stored. For optimal write performance, it is recommended the commit log be on a separate disk partition (ideally, a separate physical device) from the data file directories.")
     , data_file_directories(this, "data_file_directories", value_status::Used, { },
         "The directory location where table data (SSTables) is stored")
+    , slow_data_file_directories(this, "slow_data_file_directories", value_status::Used, { },
+        "Entries of data_file_directories which are on slower devices. The output of compactions which the compaction strategy expects to be rarely read, like old TWCS windows and LCS levels past L1, is placed in them. New sstables always go to the first entry of data_file_directories, which shouldn't be listed here.")
     , hints_directory(this, "hints_directory", value_status::Used, "",
         "The directory where hints files are stored if hinted handoff is enabled.")
     , view_hints_directory(this, "view_hints_directory", value_status::Used, "",
         "The directory where materialized-view updates are stored while a view replica is unreachable.")
-    , saved_caches_directory(this, "saved_caches_directory", value_status::Unused, "",
-        "The directory location where table key and row caches are stored.")
+    , saved_caches_directory(this, "saved_caches_directory", value_status::Used, "",
+        "The directory location where the keys of the hottest row cache partitions are stored.")
+    , tracing_file_directory(this, "tracing_file_directory", value_status::Used, "",
+        "The directory where the trace_file_helper tracing backend writes the tracing records.")
     /* Commonly used properties */
     /* Properties most frequently used when configuring Scylla. */
     /* Before starting a node for the first time, you should carefully evaluate your requirements. */
@@ -320,6 +338,8 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     , snapshot_before_compaction(this, "snapshot_before_compaction", value_status::Unused, false,
         "Enable or disable taking a snapshot before each compaction. This option is useful to back up data when there is a data format change. Be careful using this option because Cassandra does not clean up older snapshots automatically.\n"
         "Related information: Configuring compaction")
+    , snapshot_backup_throughput_mb_per_sec(this, "snapshot_backup_throughput_mb_per_sec", liveness::LiveUpdate, value_status::Used, 0,
+        "Throttles the copying of snapshot files to a backup destination (see the storage_service/backup REST call) to the given total throughput in MB per second for the node. The copy runs in a low priority scheduling group regardless. To disable throttling set to 0.")
     /* Common fault detection setting */
     , phi_convict_threshold(this, "phi_convict_threshold", value_status::Used, 8,
         "Adjusts the sensitivity of the failure detector on an exponential scale. Generally this setting never needs adjusting.\n"
@@ -341,7 +361,7 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "Controls how long the system waits for other writes before performing a sync in \"periodic\" mode.")
     /* Note: does not exist on the listing page other than in above comment, wtf? */
     , commitlog_sync_batch_window_in_ms(this, "commitlog_sync_batch_window_in_ms", value_status::Used, 10000,
-        "Controls how long the system waits for other writes before performing a sync in \"batch\" mode.")
+        "Controls how long the system waits for other writes before performing a sync in \"batch\" mode. The wait adapts to the concurrency of writes and never exceeds the latency of a sync; this is its upper bound, 0 disables waiting.")
     , commitlog_total_space_in_mb(this, "commitlog_total_space_in_mb", value_status::Used, -1,
         "Total space used for commitlogs. If the used space goes above this value, Scylla rounds up to the next nearest segment multiple and flushes memtables to disk for the oldest commitlog segments, removing those log segments. This reduces the amount of data to replay on startup, and prevents infrequently-updated tables from indefinitely keeping commitlog segments. A small total commitlog space tends to cause more flush activity on less-active tables.\n"
         "Related information: Configuring memtable throughput")
@@ -349,6 +369,9 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "Whether or not to re-use commitlog segments when finished instead of deleting them. Can improve commitlog latency on some file systems.\n")
     , commitlog_use_o_dsync(this, "commitlog_use_o_dsync", value_status::Used, true,
         "Whether or not to use O_DSYNC mode for commitlog segments IO. Can improve commitlog latency on some file systems.\n")
+    , commitlog_compression(this, "commitlog_compression", value_status::Used, "",
+        "Compressor of commitlog entries: LZ4Compressor, SnappyCompressor, DeflateCompressor or ZstdCompressor. Empty disables compression.\n"
+        "Reduces the bandwidth commitlog writes take and the space they take within commitlog_total_space_in_mb, at the cost of CPU. Segments written with compression can only be replayed by versions supporting it.")
     /* Compaction settings */
     /* Related information: Configuring compaction */
     , compaction_preheat_key_cache(this, "compaction_preheat_key_cache", value_status::Unused, true,
@@ -397,6 +420,10 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "Throttles all outbound streaming file transfers on a node to the specified throughput. Cassandra does mostly sequential I/O when streaming data during bootstrap or repair, which can lead to saturating the network connection and degrading client (RPC) performance.")
     , inter_dc_stream_throughput_outbound_megabits_per_sec(this, "inter_dc_stream_throughput_outbound_megabits_per_sec", value_status::Unused, 0,
         "Throttles all streaming file transfer between the data centers. This setting allows throttles streaming throughput betweens data centers in addition to throttling all network stream traffic as configured with stream_throughput_outbound_megabits_per_sec.")
+    , enable_sstable_file_streaming(this, "enable_sstable_file_streaming", liveness::LiveUpdate, value_status::Used, true,
+        "When streaming for bootstrap, decommission, removenode or rebuild, send the files of sstables whose token range lies entirely within a streamed range as they are, instead of reading and re-writing their content. The receiver adopts them as if they were uploaded, resharding them if needed.")
+    , stream_max_parallel_sources(this, "stream_max_parallel_sources", value_status::Used, 16,
+        "The maximum number of nodes a bootstrapping, rebuilding or leaving node streams with at the same time. Ranges are spread evenly over all the replicas owning them, so raising this lets large clusters take part in streaming, at the cost of memory for the concurrent streams.")
     , trickle_fsync(this, "trickle_fsync", value_status::Unused, false,
         "When doing sequential writing, enabling this option tells fsync to force the operating system to flush the dirty buffers at a set interval trickle_fsync_interval_in_kb. Enable this parameter to avoid sudden dirty buffer flushing from impacting read latencies. Recommended to use on SSDs, but not on HDDs.")
     , trickle_fsync_interval_in_kb(this, "trickle_fsync_interval_in_kb", value_status::Unused, 10240,
@@ -444,12 +471,12 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     , key_cache_size_in_mb(this, "key_cache_size_in_mb", value_status::Unused, 100,
         "A global cache setting for tables. It is the maximum size of the key cache in memory. To disable set to 0.\n"
         "Related information: nodetool setcachecapacity.")
-    , row_cache_keys_to_save(this, "row_cache_keys_to_save", value_status::Unused, 0,
-        "Number of keys from the row cache to save.")
+    , row_cache_keys_to_save(this, "row_cache_keys_to_save", value_status::Used, 10000,
+        "Number of keys of the hottest partitions in the row cache to save, per table and shard. The saved partitions are read into cache on start up. To disable set to 0.")
     , row_cache_size_in_mb(this, "row_cache_size_in_mb", value_status::Unused, 0,
         "Maximum size of the row cache in memory. Row cache can save more time than key_cache_size_in_mb, but is space-intensive because it contains the entire row. Use the row cache only for hot rows or static rows. If you reduce the size, you may not get you hottest keys loaded on start up.")
-    , row_cache_save_period(this, "row_cache_save_period", value_status::Unused, 0,
-        "Duration in seconds that rows are saved in cache. Caches are saved to saved_caches_directory.")
+    , row_cache_save_period(this, "row_cache_save_period", value_status::Used, 3600,
+        "Duration in seconds between saves of the hottest row cache keys. Keys are also saved on shutdown. Caches are saved to saved_caches_directory. To disable set to 0.")
     , memory_allocator(this, "memory_allocator", value_status::Invalid, "NativeAllocator",
         "The off-heap memory allocator. In addition to caches, this property affects storage engine meta data. Supported values:\n"
         "\tNativeAllocator\n"
@@ -459,8 +486,8 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     /* Counter caches properties */
     /* Counter cache helps to reduce counter locks' contention for hot counter cells. In case of RF = 1 a counter cache hit will cause Cassandra to skip the read before write entirely. With RF > 1 a counter cache hit will still help to reduce the duration of the lock hold, helping with hot counter cell updates, but will not allow skipping the read entirely. Only the local (clock, count) tuple of a counter cell is kept in memory, not the whole counter, so it's relatively cheap. */
     /* Note: Reducing the size counter cache may result in not getting the hottest keys loaded on start-up. */
-    , counter_cache_size_in_mb(this, "counter_cache_size_in_mb", value_status::Unused, 0,
-        "When no value is specified a minimum of 2.5% of Heap or 50MB. If you perform counter deletes and rely on low gc_grace_seconds, you should disable the counter cache. To disable, set to 0")
+    , counter_cache_size_in_mb(this, "counter_cache_size_in_mb", value_status::Used, 50,
+        "The memory, divided between shards, used to cache the local shards of counter cells so that counter updates can skip reading the current counter state. Cached partitions are invalidated by deletions, truncation, schema changes and loading of new sstables. To disable, set to 0")
     , counter_cache_save_period(this, "counter_cache_save_period", value_status::Unused, 7200,
         "Duration after which Cassandra should save the counter cache (keys only). Caches are saved to saved_caches_directory.")
     , counter_cache_keys_to_save(this, "counter_cache_keys_to_save", value_status::Unused, 0,
@@ -486,9 +513,30 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     , write_request_timeout_in_ms(this, "write_request_timeout_in_ms", value_status::Used, 2000,
         "The time in milliseconds that the coordinator waits for write operations to complete.\n"
         "Related information: About hinted handoff writes")
+    , write_coalescing_window_in_us(this, "write_coalescing_window_in_us", liveness::LiveUpdate, value_status::Used, 0,
+        "The time in microseconds during which the coordinator collects the writes sent to the same replica, to send them in a single message. "
+        "Trades a little write latency for less messaging overhead under high rates of small writes. 0 sends every write immediately.")
+    , counter_update_coalescing_window_in_us(this, "counter_update_coalescing_window_in_us", liveness::LiveUpdate, value_status::Used, 0,
+        "The time in microseconds during which the counter update leader collects the increments to the same partition of the tables listed in counter_update_coalescing_tables, to apply and replicate them as a single update. "
+        "Trades a little counter write latency for much higher throughput on hot counters. 0 applies every update on its own.")
+    , counter_update_coalescing_tables(this, "counter_update_coalescing_tables", value_status::Used, {},
+        "The counter tables, given as keyspace.table, whose updates are coalesced by the leader (see counter_update_coalescing_window_in_us).")
+    , append_only_ingest_tables(this, "append_only_ingest_tables", value_status::Used, {},
+        "The tables, given as keyspace.table, whose memtables buffer the writes in arrival order and insert them in token order, in bulk, before the memtable is read or flushed. "
+        "Suits append-only ingestion, such as time series, where most writes create a new partition or row; reads of the memtable pay for the buffered writes' insertion.")
+    , deferred_read_repair(this, "deferred_read_repair", liveness::LiveUpdate, value_status::Used, false,
+        "When a read at ONE, LOCAL_ONE or LOCAL_QUORUM finds replicas disagreeing, return the reconciled result without waiting for the read repair writes. These are queued instead, merged by partition, and sent in the background at the rate of deferred_read_repair_rate. Reads at other consistency levels always wait for read repair, so that they stay monotonic.")
+    , deferred_read_repair_rate(this, "deferred_read_repair_rate", liveness::LiveUpdate, value_status::Used, 1000,
+        "The maximum number of partitions per second and shard repaired by deferred read repair (see deferred_read_repair).")
+    , write_shedding_enabled(this, "write_shedding_enabled", liveness::LiveUpdate, value_status::Used, true,
+        "Reject writes on a replica, before applying them, when memtable flushing holds writes back for longer than their remaining timeout. "
+        "Such writes would time out at the coordinator anyway, and rejecting them early saves the memory and CPU they would take.")
     , request_timeout_in_ms(this, "request_timeout_in_ms", value_status::Used, 10000,
         "The default timeout for other, miscellaneous operations.\n"
         "Related information: About hinted handoff writes")
+    , latency_breakdown_sample_period(this, "latency_breakdown_sample_period", value_status::Used, 1000,
+        "Sample the latency of one in this many executions of each request processing stage (transport, coordinator, read admission, sstable reads and replica). "
+        "The samples are exposed as the latency_breakdown metrics and through the REST API. Set to 0 to disable sampling.")
     /* Inter-node settings */
     , cross_node_timeout(this, "cross_node_timeout", value_status::Unused, false,
         "Enable or disable operation timeout information exchange between nodes (to accurately measure request timeouts). If disabled Cassandra assumes the request was forwarded to the replica instantly by the coordinator.\n"
@@ -509,9 +557,19 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "\n"
         "\tall: All traffic is compressed.\n"
         "\tdc : Traffic between data centers is compressed.\n"
+        "\track : Traffic between racks is compressed.\n"
         "\tnone : No compression.")
+    , internode_compression_zstd(this, "internode_compression_zstd", value_status::Used, "none",
+        "Controls which of the links compressed according to internode_compression use zstd rather than lz4. zstd compresses better, at the cost of more CPU, which pays off on links where bandwidth is scarce. Nodes not supporting zstd keep using lz4. The valid values are:\n"
+        "\n"
+        "\tall: All compressed traffic uses zstd.\n"
+        "\tdc : Compressed traffic between data centers uses zstd.\n"
+        "\track : Compressed traffic between racks uses zstd.\n"
+        "\tnone : Compressed traffic uses lz4.")
     , inter_dc_tcp_nodelay(this, "inter_dc_tcp_nodelay", value_status::Used, false,
         "Enable or disable tcp_nodelay for inter-data center communication. When disabled larger, but fewer, network packets are sent. This reduces overhead from the TCP protocol itself. However, if cross data-center responses are blocked, it will increase latency.")
+    , internode_shard_aware_connections(this, "internode_shard_aware_connections", value_status::Used, false,
+        "Open the connections carrying mutations and reads to each remote shard separately (one per source and destination shard pair), and send each request over the connection of the shard owning its token. This saves the replica from forwarding the request to the owning shard, at the cost of more connections: each local shard opens one per shard of each node, using local ports from 49152-65535. Connections which can't get a free port of the right shard fall back to a kernel-chosen port, and aren't shard-aware.")
     , streaming_socket_timeout_in_ms(this, "streaming_socket_timeout_in_ms", value_status::Unused, 0,
         "Enable or disable socket timeout for streaming operations. When a timeout occurs during streaming, streaming is retried from the start of the current file. Avoid setting this value too low, as it can result in a significant amount of data re-streaming.")
     /* Native transport (CQL Binary Protocol) */
@@ -525,6 +583,10 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "for native_transport_port. Setting native_transport_port_ssl to a different value"
         "from native_transport_port will use encryption for native_transport_port_ssl while"
         "keeping native_transport_port unencrypted")
+    , native_shard_aware_transport_port(this, "native_shard_aware_transport_port", value_status::Used, 19042,
+        "Like native_transport_port, but clients are forwarded to specific shards, based on the client-side port numbers.")
+    , native_shard_aware_transport_port_ssl(this, "native_shard_aware_transport_port_ssl", value_status::Used, 19142,
+        "Like native_transport_port_ssl, but clients are forwarded to specific shards, based on the client-side port numbers.")
     , native_transport_max_threads(this, "native_transport_max_threads", value_status::Invalid, 128,
         "The maximum number of thread handling requests. The meaning is the same as rpc_max_threads.\n"
         "Default is different (128 versus unlimited).\n"
@@ -559,10 +621,17 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "\tYour own RPC server: You must provide a fully-qualified class name of an o.a.c.t.TServerFactory that can create a server instance.")
     , cache_hit_rate_read_balancing(this, "cache_hit_rate_read_balancing", value_status::Used, true,
         "This boolean controls whether the replicas for read query will be choosen based on cache hit ratio")
+    , latency_read_balancing(this, "latency_read_balancing", liveness::LiveUpdate, value_status::Used, true,
+        "This boolean controls whether reads with a consistency level below ALL prefer the replicas which have been answering faster, "
+        "as measured by each coordinator shard. See dynamic_snitch_badness_threshold.")
+    , speculative_retry_budget(this, "speculative_retry_budget", liveness::LiveUpdate, value_status::Used, 0.1,
+        "The largest fraction of the reads of a table which may send a speculative retry (see the speculative_retry table option), "
+        "measured per coordinator shard with a small allowance for bursts. Limits the extra load speculative retries add when replicas slow down. "
+        "A value of 1 does not limit speculative retries.")
     /* Advanced fault detection settings */
     /* Settings to handle poorly performing or failing nodes. */
-    , dynamic_snitch_badness_threshold(this, "dynamic_snitch_badness_threshold", value_status::Unused, 0,
-        "Sets the performance threshold for dynamically routing requests away from a poorly performing node. A value of 0.2 means Cassandra continues to prefer the static snitch values until the node response time is 20% worse than the best performing node. Until the threshold is reached, incoming client requests are statically routed to the closest replica (as determined by the snitch). Having requests consistently routed to a given replica can help keep a working set of data hot when read repair is less than 1.")
+    , dynamic_snitch_badness_threshold(this, "dynamic_snitch_badness_threshold", liveness::LiveUpdate, value_status::Used, 1,
+        "Sets the performance threshold for dynamically routing reads away from a poorly performing node (see latency_read_balancing). A value of 0.2 means the static snitch order is preferred until the node's score (its response time, scaled by its outstanding reads) is 20% worse than that of the best performing node of the same datacenter. Until the threshold is reached, reads are statically routed to the closest replica (as determined by the snitch). Having requests consistently routed to a given replica can help keep a working set of data hot.")
     , dynamic_snitch_reset_interval_in_ms(this, "dynamic_snitch_reset_interval_in_ms", value_status::Unused, 60000,
         "Time interval in milliseconds to reset all node scores, which allows a bad node to recover.")
     , dynamic_snitch_update_interval_in_ms(this, "dynamic_snitch_update_interval_in_ms", value_status::Unused, 100,
@@ -577,6 +646,14 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "Related information: Failure detection and recovery")
     , max_hints_delivery_threads(this, "max_hints_delivery_threads", value_status::Invalid, 2,
         "Number of threads with which to deliver hints. In multiple data-center deployments, consider increasing this number because cross data-center handoff is generally slower.")
+    , hints_compression(this, "hints_compression", value_status::Used, "",
+        "Compressor of hint entries: LZ4Compressor, SnappyCompressor, DeflateCompressor or ZstdCompressor. Empty disables compression.\n"
+        "Reduces the disk space hints take during a long outage of a node, at the cost of CPU. Hints written with compression can only be replayed by versions supporting it.")
+    , hints_replay_batch_size(this, "hints_replay_batch_size", liveness::LiveUpdate, value_status::Used, 64,
+        "The number of hints read from a hints file before they are sent. Hints of the batch which update the same partition are merged into one mutation, "
+        "and the writes of the batch are started together. 1 sends hints one by one.")
+    , hints_replay_max_mutations_per_second(this, "hints_replay_max_mutations_per_second", liveness::LiveUpdate, value_status::Used, 0,
+        "Maximum number of mutations per second each shard sends when replaying hints, to limit the impact of hint replay on live traffic. 0 means unlimited.")
     , batchlog_replay_throttle_in_kb(this, "batchlog_replay_throttle_in_kb", value_status::Unused, 1024,
         "Total maximum throttle. Throttling is reduced proportionally to the number of nodes in the cluster.")
     /* Request scheduler properties */
@@ -596,6 +673,10 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "\tthrottle_limit: The number of in-flight requests per client. Requests beyond this limit are queued up until running requests complete. Recommended value is ((concurrent_reads + concurrent_writes) × 2)\n"
         "\tdefault_weight: (Default: 1 **)  How many requests are handled during each turn of the RoundRobin.\n"
         "\tweights: (Default: Keyspace: 1)  Takes a list of keyspaces. It sets how many requests are handled during each turn of the RoundRobin, based on the request_scheduler_id.")
+    , service_levels(this, "service_levels", value_status::Used, {},
+        "Workload classes, each with its own CPU scheduling group and reader admission queue. Maps the name of a service level to the CPU shares of its scheduling group (1-1000); CQL statements which are not attached to a service level run in the statement group, which has 1000 shares. Requires cpu_scheduler to be enabled.")
+    , role_service_levels(this, "role_service_levels", value_status::Used, {},
+        "Attaches roles to service levels. Maps a role name to the name of a service level defined in service_levels.")
     /* Thrift interface properties */
     /* Legacy API for older clients. CQL is a simpler and better API for Scylla. */
     , thrift_framed_transport_size_in_mb(this, "thrift_framed_transport_size_in_mb", value_status::Unused, 15,
@@ -632,6 +713,16 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "Refresh interval for permissions cache (if enabled). After this interval, cache entries become eligible for refresh. An async reload is scheduled every permissions_update_interval_in_ms time period and the old value is returned until it completes. If permissions_validity_in_ms has a non-zero value, then this property must also have a non-zero value. It's recommended to set this value to be at least 3 times smaller than the permissions_validity_in_ms.")
     , permissions_cache_max_entries(this, "permissions_cache_max_entries", value_status::Used, 1000,
         "Maximum cached permission entries. Must have a non-zero value if permissions caching is enabled (see a permissions_validity_in_ms description).")
+    , roles_validity_in_ms(this, "roles_validity_in_ms", value_status::Used, 10000,
+        "How long the roles granted to a role remain valid in the cache. The cached value is evicted under the same conditions as cached permissions (see the permissions_validity_in_ms description). Roles caching is disabled when this property is set to 0.")
+    , roles_update_interval_in_ms(this, "roles_update_interval_in_ms", value_status::Used, 2000,
+        "Refresh interval for the roles cache (if enabled). An entry read after this interval is reloaded in the background and the old value is returned until the reload completes. If roles_validity_in_ms has a non-zero value, then this property must also have a non-zero value.")
+    , roles_cache_max_entries(this, "roles_cache_max_entries", value_status::Used, 1000,
+        "Maximum cached role entries. Must have a non-zero value if roles caching is enabled (see the roles_validity_in_ms description).")
+    , credentials_validity_in_ms(this, "credentials_validity_in_ms", value_status::Used, 2000,
+        "How long successfully verified credentials of PasswordAuthenticator remain valid in the cache. A cached login skips both the read of the salted hash and the password hashing. Changes made on other shards or nodes, such as a new password or a dropped role, may take this long to apply. Credentials caching is disabled when this property is set to 0.")
+    , credentials_cache_max_entries(this, "credentials_cache_max_entries", value_status::Used, 1000,
+        "Maximum cached credentials entries per shard (see the credentials_validity_in_ms description).")
     , server_encryption_options(this, "server_encryption_options", value_status::Used, {/*none*/},
         "Enable or disable inter-node encryption. You must also generate keys and provide the appropriate key and trust store locations and passwords. The available options are:\n"
         "\n"
@@ -666,6 +757,17 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "The SSL port for encrypted communication. Unused unless enabled in encryption_options.")
     , enable_in_memory_data_store(this, "enable_in_memory_data_store", value_status::Used, false, "Enable in memory mode (system tables are always persisted)")
     , enable_cache(this, "enable_cache", value_status::Used, true, "Enable cache")
+    , enable_index_cache(this, "enable_index_cache", liveness::LiveUpdate, value_status::Used, true,
+        "Keep recently read pages of sstable index files, including promoted index blocks, in an evictable in-memory cache")
+    , enable_partitioned_bloom_filters(this, "enable_partitioned_bloom_filters", value_status::Used, false,
+        "Don't keep split-block Bloom filters larger than 64kB in memory. Their token-range partitions are loaded on demand into an evictable cache, bounded by bloom_filter_partition_cache_size_in_mb. "
+        "Until a partition is loaded, lookups falling into it consult the index. Applies to sstables opened after the change")
+    , bloom_filter_partition_cache_size_in_mb(this, "bloom_filter_partition_cache_size_in_mb", value_status::Used, 1024,
+        "Memory used to cache partitions of Bloom filters loaded on demand, divided evenly among shards")
+    , defer_sstable_filter_loading(this, "defer_sstable_filter_loading", value_status::Used, true,
+        "Don't wait for the Bloom filters of sstables found at startup before serving: they are read in the background, and until then reads of those sstables consult the index")
+    , sstable_load_concurrency(this, "sstable_load_concurrency", value_status::Used, 8,
+        "The maximum number of sstables each shard opens concurrently at startup")
     , enable_commitlog(this, "enable_commitlog", value_status::Used, true, "Enable commitlog")
     , volatile_system_keyspace_for_testing(this, "volatile_system_keyspace_for_testing", value_status::Used, false, "Don't persist system keyspace - testing only!")
     , api_port(this, "api_port", value_status::Used, 10000, "Http Rest API port")
@@ -690,31 +792,60 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     , developer_mode(this, "developer_mode", value_status::Used, false, "Relax environment checks. Setting to true can reduce performance and reliability significantly.")
     , skip_wait_for_gossip_to_settle(this, "skip_wait_for_gossip_to_settle", value_status::Used, -1, "An integer to configure the wait for gossip to settle. -1: wait normally, 0: do not wait at all, n: wait for at most n polls. Same as -Dcassandra.skip_wait_for_gossip_to_settle in cassandra.")
     , force_gossip_generation(this, "force_gossip_generation", liveness::LiveUpdate, value_status::Used, -1 , "Force gossip to use the generation number provided by user")
+    , gossip_full_digest_interval(this, "gossip_full_digest_interval", liveness::LiveUpdate, value_status::Used, 10,
+        "Gossip rounds to a peer only carry the digests of the endpoints whose state the peer isn't known to have, and every n-th round to it carries all of them. Set to 1 to always send all digests.")
+    , direct_failure_detector_ping_interval_in_ms(this, "direct_failure_detector_ping_interval_in_ms", liveness::LiveUpdate, value_status::Used, 500,
+        "Interval between rounds of direct pings to all live nodes, which mark a node down after direct_failure_detector_convict_threshold consecutive rounds without a reply, without waiting for the gossip heartbeat based failure detector. Set to 0 to disable direct pings.")
+    , direct_failure_detector_ping_timeout_in_ms(this, "direct_failure_detector_ping_timeout_in_ms", liveness::LiveUpdate, value_status::Used, 1000,
+        "Time a node has to answer a direct ping.")
+    , direct_failure_detector_convict_threshold(this, "direct_failure_detector_convict_threshold", liveness::LiveUpdate, value_status::Used, 3,
+        "The number of consecutive unanswered direct pings after which a node is marked down.")
     , experimental(this, "experimental", value_status::Used, false, "Set to true to unlock all experimental features.")
     , experimental_features(this, "experimental_features", value_status::Used, {}, "Unlock experimental features provided as the option arguments (possible values: 'lwt', 'cdc', 'udf'). Can be repeated.")
     , lsa_reclamation_step(this, "lsa_reclamation_step", value_status::Used, 1, "Minimum number of segments to reclaim in a single step")
+    , lsa_background_reclaim_free_memory_fraction(this, "lsa_background_reclaim_free_memory_fraction", value_status::Used, 0.02,
+        "Fraction of shard memory which LSA tries to keep free by compacting and evicting in a low priority background task, so that allocations rarely have to reclaim memory themselves. Set to 0 to disable.")
     , prometheus_port(this, "prometheus_port", value_status::Used, 9180, "Prometheus port, set to zero to disable")
     , prometheus_address(this, "prometheus_address", value_status::Used, "0.0.0.0", "Prometheus listening address")
     , prometheus_prefix(this, "prometheus_prefix", value_status::Used, "scylla", "Set the prefix of the exported Prometheus metrics. Changing this will break Scylla's dashboard compatibility, do not change unless you know what you are doing.")
     , abort_on_lsa_bad_alloc(this, "abort_on_lsa_bad_alloc", value_status::Used, false, "Abort when allocation in LSA region fails")
     , murmur3_partitioner_ignore_msb_bits(this, "murmur3_partitioner_ignore_msb_bits", value_status::Used, 12, "Number of most siginificant token bits to ignore in murmur3 partitioner; increase for very large clusters")
     , virtual_dirty_soft_limit(this, "virtual_dirty_soft_limit", value_status::Used, 0.6, "Soft limit of virtual dirty memory expressed as a portion of the hard limit")
+    , table_memory_quota_fraction(this, "table_memory_quota_fraction", value_status::Used, 0,
+        "Soft quota of a single table, as a fraction of the dirty memory hard limit and of the partitions cached on a shard. Under dirty memory pressure, tables over their quota are flushed and have their writes throttled before others. Rows read into cache by tables over their cache quota are evicted first. Set to 0 to disable.")
+    , compressed_cache_size_in_mb(this, "compressed_cache_size_in_mb", value_status::Used, 0,
+        "Per-shard limit, in megabytes, of the row cache memory holding compressed copies of partitions evicted from the cache. Single-partition reads that miss the cache are served from these copies instead of sstables. Set to 0 to disable.")
+    , compact_cache_on_population(this, "compact_cache_on_population", value_status::Used, true,
+        "Compact rows read into the row cache from sstables: drop the data shadowed by tombstones and turn expired cells into tombstones, so that cached partitions of delete-heavy tables are smaller and cheaper to read. Tombstones are kept.")
     , sstable_summary_ratio(this, "sstable_summary_ratio", value_status::Used, 0.0005, "Enforces that 1 byte of summary is written for every N (2000 by default) "
         "bytes written to data file. Value must be between 0 and 1.")
     , large_memory_allocation_warning_threshold(this, "large_memory_allocation_warning_threshold", value_status::Used, size_t(1) << 20, "Warn about memory allocations above this size; set to zero to disable")
     , enable_deprecated_partitioners(this, "enable_deprecated_partitioners", value_status::Used, false, "Enable the byteordered and random partitioners. These partitioners are deprecated and will be removed in a future version.")
     , enable_keyspace_column_family_metrics(this, "enable_keyspace_column_family_metrics", value_status::Used, false, "Enable per keyspace and per column family metrics reporting")
+    , enable_stall_attribution(this, "enable_stall_attribution", value_status::Used, false,
+        "Measure how long reads, writes, flushes, compactions, repairs and view building of each table run without yielding, and log those running for longer than --blocked-reactor-notify-ms, along with their table. Also adds the per-table reactor_stalls and reactor_stall_time_ms metrics. Costs a clock read at each switch between tables or activities.")
     , enable_sstable_data_integrity_check(this, "enable_sstable_data_integrity_check", value_status::Used, false, "Enable interposer which checks for integrity of every sstable write."
         " Performance is affected to some extent as a result. Useful to help debugging problems that may arise at another layers.")
+    , enable_sstable_digest_verification(this, "enable_sstable_digest_verification", liveness::LiveUpdate, value_status::Used, true,
+        "Verify the full checksum (Digest) of an sstable's data file whenever a read, such as a compaction, goes through the whole file."
+        " A mismatching sstable is quarantined: it is no longer compacted, so that corrupted data isn't rewritten into new sstables.")
     , enable_sstable_key_validation(this, "enable_sstable_key_validation", value_status::Used, ENABLE_SSTABLE_KEY_VALIDATION, "Enable validation of partition and clustering keys monotonicity"
         " Performance is affected to some extent as a result. Useful to help debugging problems that may arise at another layers.")
     , cpu_scheduler(this, "cpu_scheduler", value_status::Used, true, "Enable cpu scheduling")
     , view_building(this, "view_building", value_status::Used, true, "Enable view building; should only be set to false when the node is experience issues due to view building")
     , enable_sstables_mc_format(this, "enable_sstables_mc_format", value_status::Used, true, "Enable SSTables 'mc' format to be used as the default file format")
+    , enable_sstables_split_block_bloom_filter(this, "enable_sstables_split_block_bloom_filter", value_status::Used, false, "Write Bloom filters of new 'mc' SSTables in the cache-line blocked (split-block) layout, which is cheaper to probe."
+        " Such SSTables cannot be read by Cassandra nor by Scylla versions without support for this layout.")
+    , enable_sstables_xor_filter(this, "enable_sstables_xor_filter", value_status::Used, false, "Use static xor filters instead of Bloom filters for new 'mc' SSTables with a moderate number of partitions, which take less memory for the same false positive rate."
+        " Such SSTables cannot be read by Cassandra nor by Scylla versions without support for xor filters.")
+    , enable_sstables_trie_index(this, "enable_sstables_trie_index", value_status::Used, false, "Write a TrieIndex component, a page-aware trie of partition tokens, for new 'mc' SSTables."
+        " Single partition reads use it to find out that a partition is absent without reading the index. Other readers ignore the component.")
     , enable_dangerous_direct_import_of_cassandra_counters(this, "enable_dangerous_direct_import_of_cassandra_counters", value_status::Used, false, "Only turn this option on if you want to import tables from Cassandra containing counters, and you are SURE that no counters in that table were created in a version earlier than Cassandra 2.1."
         " It is not enough to have ever since upgraded to newer versions of Cassandra. If you EVER used a version earlier than 2.1 in the cluster where these SSTables come from, DO NOT TURN ON THIS OPTION! You will corrupt your data. You have been warned.")
     , enable_shard_aware_drivers(this, "enable_shard_aware_drivers", value_status::Used, true, "Enable native transport drivers to use connection-per-shard for better performance")
     , enable_ipv6_dns_lookup(this, "enable_ipv6_dns_lookup", value_status::Used, false, "Use IPv6 address resolution")
+    , cdc_local_preimage_reads(this, "cdc_local_preimage_reads", liveness::LiveUpdate, value_status::Used, false, "Read CDC preimages from the local replica, at consistency level ONE, whenever the coordinator of the write is a replica of the base partition."
+        " This saves a LOCAL_QUORUM read per write to tables with preimage or postimage enabled, at the cost of a preimage that may miss writes not yet replicated to this node.")
     , abort_on_internal_error(this, "abort_on_internal_error", liveness::LiveUpdate, value_status::Used, false, "Abort the server instead of throwing exception when internal invariants are violated")
     , max_partition_key_restrictions_per_query(this, "max_partition_key_restrictions_per_query", liveness::LiveUpdate, value_status::Used, 100,
             "Maximum number of distinct partition keys restrictions per query. This limit places a bound on the size of IN tuples, "
@@ -724,6 +855,27 @@ db::config::config(std::shared_ptr<db::extensions> exts)
             "especially when multiple clustering key columns have IN restrictions. Increasing this value can result in server instability.")
     , max_memory_for_unlimited_query(this, "max_memory_for_unlimited_query", liveness::LiveUpdate, value_status::Used, size_t(1) << 20,
             "Maximum amount of memory a query, whose memory consumption is not naturally limited, is allowed to consume, e.g. non-paged and reverse queries.")
+    , range_scan_memory_budget(this, "range_scan_memory_budget", liveness::LiveUpdate, value_status::Used, size_t(10) << 20,
+            "Maximum amount of memory the replies of the vnode ranges a range scan reads concurrently are expected to take on the coordinator. "
+            "The concurrency of range scans is limited so that it is not exceeded.")
+    , page_size_in_bytes(this, "page_size_in_bytes", liveness::LiveUpdate, value_status::Used, 0,
+            "Maximum size of a page of a paged query, in bytes. The number of rows requested for each page is lowered "
+            "according to the size of the rows of the previous pages, so that pages of large rows don't exceed it. "
+            "0 means pages are only limited by their number of rows and the replicas' result size limit.")
+    , toppartitions_sampling_ratio(this, "toppartitions_sampling_ratio", liveness::LiveUpdate, value_status::Used, 0,
+            "Continuously track the hottest partitions of every table, sampling one in this many reads and writes. "
+            "The results are in system.top_partitions. 0 disables continuous tracking.")
+    , toppartitions_window_in_s(this, "toppartitions_window_in_s", liveness::LiveUpdate, value_status::Used, 60,
+            "Length of the windows of continuous top partitions tracking. The reported rankings cover the last complete window and the current one.")
+    , toppartitions_capacity(this, "toppartitions_capacity", liveness::LiveUpdate, value_status::Used, 256,
+            "Number of partitions tracked by each ranking of each table by continuous top partitions tracking, per shard.")
+    , tracing_backend(this, "tracing_backend", value_status::Used, "trace_keyspace_helper",
+            "Where tracing records are written:\n"
+            "\n"
+            "\ttrace_keyspace_helper : To the tables of the system_traces keyspace.\n"
+            "\ttrace_file_helper : To a ring buffer file per shard in tracing_file_directory, without going through the storage proxy.")
+    , tracing_file_size_in_mb(this, "tracing_file_size_in_mb", value_status::Used, 64,
+            "Size of the ring buffer file of each shard of the trace_file_helper tracing backend. Once full, the oldest records are overwritten.")
     , enable_3_1_0_compatibility_mode(this, "enable_3_1_0_compatibility_mode", value_status::Used, false,
         "Set to true if the cluster was initially installed from 3.1.0. If it was upgraded from an earlier version,"
         " or installed from a later version, leave this set to false. This adjusts the communication protocol to"
@@ -736,6 +888,7 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     , alternator_https_port(this, "alternator_https_port", value_status::Used, 0, "Alternator API HTTPS port")
     , alternator_address(this, "alternator_address", value_status::Used, "0.0.0.0", "Alternator API listening address")
     , alternator_enforce_authorization(this, "alternator_enforce_authorization", value_status::Used, false, "Enforce checking the authorization header for every request in Alternator")
+    , alternator_ttl_period_in_seconds(this, "alternator_ttl_period_in_seconds", value_status::Used, 60 * 60 * 24, "The time in seconds between the starts of two scans for expired items of the Alternator tables with a TTL attribute")
     , abort_on_ebadf(this, "abort_on_ebadf", value_status::Used, true, "Abort the server on incorrect file descriptor access. Throws exception when disabled.")
     , redis_port(this, "redis_port", value_status::Used, 0, "Port on which the REDIS transport listens for clients.")
     , redis_ssl_port(this, "redis_ssl_port", value_status::Used, 0, "Port on which the REDIS TLS native transport listens for clients.")
@@ -772,6 +925,7 @@ void db::config::setup_directories() {
     maybe_in_workdir(hints_directory, "hints");
     maybe_in_workdir(view_hints_directory, "view_hints");
     maybe_in_workdir(saved_caches_directory, "saved_caches");
+    maybe_in_workdir(tracing_file_directory, "traces");
 }
 
 void db::config::maybe_in_workdir(named_value<sstring>& to, const char* sub) {
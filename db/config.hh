@@ -121,7 +121,14 @@ class config : public utils::config_file {
     named_value<bool> auto_adjust_flush_quota;
     named_value<float> memtable_flush_static_shares;
     named_value<float> compaction_static_shares;
+    named_value<uint32_t> compaction_read_latency_target_us;
+    named_value<uint32_t> compaction_write_latency_target_us;
     named_value<bool> compaction_enforce_min_threshold;
+    named_value<uint32_t> compaction_max_parallel_subranges;
+    named_value<uint32_t> repair_tombstone_gc_propagation_delay_in_s;
+    named_value<uint32_t> incremental_repair_session_timeout_in_s;
+    named_value<uint32_t> memtable_flush_max_parallel_subranges;
+    named_value<uint32_t> shared_sstable_reshard_threshold;
     named_value<sstring> cluster_name;
     named_value<sstring> listen_address;
     named_value<sstring> listen_interface;
@@ -129,9 +136,11 @@ class config : public utils::config_file {
     named_value<sstring> work_directory;
     named_value<sstring> commitlog_directory;
     named_value<string_list> data_file_directories;
+    named_value<string_list> slow_data_file_directories;
     named_value<sstring> hints_directory;
     named_value<sstring> view_hints_directory;
     named_value<sstring> saved_caches_directory;
+    named_value<sstring> tracing_file_directory;
     named_value<sstring> commit_failure_policy;
     named_value<sstring> disk_failure_policy;
     named_value<sstring> endpoint_snitch;
@@ -150,6 +159,7 @@ class config : public utils::config_file {
     named_value<uint32_t> concurrent_counter_writes;
     named_value<bool> incremental_backups;
     named_value<bool> snapshot_before_compaction;
+    named_value<uint32_t> snapshot_backup_throughput_mb_per_sec;
     named_value<uint32_t> phi_convict_threshold;
     named_value<sstring> commitlog_sync;
     named_value<uint32_t> commitlog_segment_size_in_mb;
@@ -158,6 +168,7 @@ class config : public utils::config_file {
     named_value<int64_t> commitlog_total_space_in_mb;
     named_value<bool> commitlog_reuse_segments;
     named_value<bool> commitlog_use_o_dsync;
+    named_value<sstring> commitlog_compression;
     named_value<bool> compaction_preheat_key_cache;
     named_value<uint32_t> concurrent_compactors;
     named_value<uint32_t> in_memory_compaction_limit_in_mb;
@@ -178,6 +189,8 @@ class config : public utils::config_file {
     named_value<double> reduce_cache_sizes_at;
     named_value<uint32_t> stream_throughput_outbound_megabits_per_sec;
     named_value<uint32_t> inter_dc_stream_throughput_outbound_megabits_per_sec;
+    named_value<bool> enable_sstable_file_streaming;
+    named_value<uint32_t> stream_max_parallel_sources;
     named_value<bool> trickle_fsync;
     named_value<uint32_t> trickle_fsync_interval_in_kb;
     named_value<bool> auto_bootstrap;
@@ -208,16 +221,28 @@ class config : public utils::config_file {
     named_value<uint32_t> cas_contention_timeout_in_ms;
     named_value<uint32_t> truncate_request_timeout_in_ms;
     named_value<uint32_t> write_request_timeout_in_ms;
+    named_value<uint32_t> write_coalescing_window_in_us;
+    named_value<uint32_t> counter_update_coalescing_window_in_us;
+    named_value<string_list> counter_update_coalescing_tables;
+    named_value<string_list> append_only_ingest_tables;
+    named_value<bool> deferred_read_repair;
+    named_value<uint32_t> deferred_read_repair_rate;
+    named_value<bool> write_shedding_enabled;
     named_value<uint32_t> request_timeout_in_ms;
+    named_value<uint32_t> latency_breakdown_sample_period;
     named_value<bool> cross_node_timeout;
     named_value<uint32_t> internode_send_buff_size_in_bytes;
     named_value<uint32_t> internode_recv_buff_size_in_bytes;
     named_value<sstring> internode_compression;
+    named_value<sstring> internode_compression_zstd;
     named_value<bool> inter_dc_tcp_nodelay;
+    named_value<bool> internode_shard_aware_connections;
     named_value<uint32_t> streaming_socket_timeout_in_ms;
     named_value<bool> start_native_transport;
     named_value<uint16_t> native_transport_port;
     named_value<uint16_t> native_transport_port_ssl;
+    named_value<uint16_t> native_shard_aware_transport_port;
+    named_value<uint16_t> native_shard_aware_transport_port_ssl;
     named_value<uint32_t> native_transport_max_threads;
     named_value<uint32_t> native_transport_max_frame_size_in_mb;
     named_value<sstring> broadcast_rpc_address;
@@ -230,6 +255,8 @@ class config : public utils::config_file {
     named_value<uint32_t> rpc_send_buff_size_in_bytes;
     named_value<sstring> rpc_server_type;
     named_value<bool> cache_hit_rate_read_balancing;
+    named_value<bool> latency_read_balancing;
+    named_value<double> speculative_retry_budget;
     named_value<double> dynamic_snitch_badness_threshold;
     named_value<uint32_t> dynamic_snitch_reset_interval_in_ms;
     named_value<uint32_t> dynamic_snitch_update_interval_in_ms;
@@ -237,10 +264,15 @@ class config : public utils::config_file {
     named_value<uint32_t> hinted_handoff_throttle_in_kb;
     named_value<uint32_t> max_hint_window_in_ms;
     named_value<uint32_t> max_hints_delivery_threads;
+    named_value<sstring> hints_compression;
+    named_value<uint32_t> hints_replay_batch_size;
+    named_value<uint32_t> hints_replay_max_mutations_per_second;
     named_value<uint32_t> batchlog_replay_throttle_in_kb;
     named_value<sstring> request_scheduler;
     named_value<sstring> request_scheduler_id;
     named_value<string_map> request_scheduler_options;
+    named_value<string_map> service_levels;
+    named_value<string_map> role_service_levels;
     named_value<uint32_t> thrift_framed_transport_size_in_mb;
     named_value<uint32_t> thrift_max_message_length_in_mb;
     named_value<sstring> authenticator;
@@ -250,11 +282,21 @@ class config : public utils::config_file {
     named_value<uint32_t> permissions_validity_in_ms;
     named_value<uint32_t> permissions_update_interval_in_ms;
     named_value<uint32_t> permissions_cache_max_entries;
+    named_value<uint32_t> roles_validity_in_ms;
+    named_value<uint32_t> roles_update_interval_in_ms;
+    named_value<uint32_t> roles_cache_max_entries;
+    named_value<uint32_t> credentials_validity_in_ms;
+    named_value<uint32_t> credentials_cache_max_entries;
     named_value<string_map> server_encryption_options;
     named_value<string_map> client_encryption_options;
     named_value<uint32_t> ssl_storage_port;
     named_value<bool> enable_in_memory_data_store;
     named_value<bool> enable_cache;
+    named_value<bool> enable_index_cache;
+    named_value<bool> enable_partitioned_bloom_filters;
+    named_value<uint32_t> bloom_filter_partition_cache_size_in_mb;
+    named_value<bool> defer_sstable_filter_loading;
+    named_value<uint32_t> sstable_load_concurrency;
     named_value<bool> enable_commitlog;
     named_value<bool> volatile_system_keyspace_for_testing;
     named_value<uint16_t> api_port;
@@ -279,31 +321,52 @@ class config : public utils::config_file {
     named_value<bool> developer_mode;
     named_value<int32_t> skip_wait_for_gossip_to_settle;
     named_value<int32_t> force_gossip_generation;
+    named_value<uint32_t> gossip_full_digest_interval;
+    named_value<uint32_t> direct_failure_detector_ping_interval_in_ms;
+    named_value<uint32_t> direct_failure_detector_ping_timeout_in_ms;
+    named_value<uint32_t> direct_failure_detector_convict_threshold;
     named_value<bool> experimental;
     named_value<std::vector<enum_option<experimental_features_t>>> experimental_features;
     named_value<size_t> lsa_reclamation_step;
+    named_value<double> lsa_background_reclaim_free_memory_fraction;
     named_value<uint16_t> prometheus_port;
     named_value<sstring> prometheus_address;
     named_value<sstring> prometheus_prefix;
     named_value<bool> abort_on_lsa_bad_alloc;
     named_value<unsigned> murmur3_partitioner_ignore_msb_bits;
     named_value<double> virtual_dirty_soft_limit;
+    named_value<double> table_memory_quota_fraction;
+    named_value<uint32_t> compressed_cache_size_in_mb;
+    named_value<bool> compact_cache_on_population;
     named_value<double> sstable_summary_ratio;
     named_value<size_t> large_memory_allocation_warning_threshold;
     named_value<bool> enable_deprecated_partitioners;
     named_value<bool> enable_keyspace_column_family_metrics;
+    named_value<bool> enable_stall_attribution;
     named_value<bool> enable_sstable_data_integrity_check;
+    named_value<bool> enable_sstable_digest_verification;
     named_value<bool> enable_sstable_key_validation;
     named_value<bool> cpu_scheduler;
     named_value<bool> view_building;
     named_value<bool> enable_sstables_mc_format;
+    named_value<bool> enable_sstables_split_block_bloom_filter;
+    named_value<bool> enable_sstables_xor_filter;
+    named_value<bool> enable_sstables_trie_index;
     named_value<bool> enable_dangerous_direct_import_of_cassandra_counters;
     named_value<bool> enable_shard_aware_drivers;
     named_value<bool> enable_ipv6_dns_lookup;
+    named_value<bool> cdc_local_preimage_reads;
     named_value<bool> abort_on_internal_error;
     named_value<uint32_t> max_partition_key_restrictions_per_query;
     named_value<uint32_t> max_clustering_key_restrictions_per_query;
     named_value<uint64_t> max_memory_for_unlimited_query;
+    named_value<uint64_t> range_scan_memory_budget;
+    named_value<uint64_t> page_size_in_bytes;
+    named_value<uint32_t> toppartitions_sampling_ratio;
+    named_value<uint32_t> toppartitions_window_in_s;
+    named_value<uint32_t> toppartitions_capacity;
+    named_value<sstring> tracing_backend;
+    named_value<uint32_t> tracing_file_size_in_mb;
     named_value<bool> enable_3_1_0_compatibility_mode;
     named_value<bool> enable_user_defined_functions;
     named_value<unsigned> user_defined_function_time_limit_ms;
@@ -314,6 +377,7 @@ class config : public utils::config_file {
     named_value<uint16_t> alternator_https_port;
     named_value<sstring> alternator_address;
     named_value<bool> alternator_enforce_authorization;
+    named_value<uint32_t> alternator_ttl_period_in_seconds;
     named_value<bool> abort_on_ebadf;
 
     named_value<uint16_t> redis_port;
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "db/counter_cache.hh"
+#include "counters.hh"
+#include "mutation.hh"
+#include "frozen_mutation.hh"
+#include "mutation_partition_view.hh"
+
+namespace db {
+
+// Detects writes deleting counter cells, which the cache can't follow.
+class counter_deletion_detector final : public mutation_partition_view_virtual_visitor {
+public:
+    bool found = false;
+
+    virtual void accept_partition_tombstone(tombstone t) override {
+        found |= bool(t);
+    }
+    virtual void accept_static_cell(column_id, atomic_cell ac) override {
+        found |= !ac.is_live();
+    }
+    virtual void accept_static_cell(column_id, collection_mutation_view) override { }
+    virtual void accept_row_tombstone(range_tombstone) override {
+        found = true;
+    }
+    virtual void accept_row(position_in_partition_view, row_tombstone rt, row_marker, is_dummy, is_continuous) override {
+        found |= bool(rt);
+    }
+    virtual void accept_row_cell(column_id, atomic_cell ac) override {
+        found |= !ac.is_live();
+    }
+    virtual void accept_row_cell(column_id, collection_mutation_view) override { }
+};
+
+counter_cache::counter_cache(size_t max_bytes)
+    : _max_bytes(max_bytes)
+{ }
+
+counter_cache::~counter_cache() {
+    clear();
+}
+
+size_t counter_cache::cell_memory_usage(const cell_key& k) {
+    // Approximates the hash table node and the bucket pointing to it.
+    return sizeof(std::pair<const cell_key, local_shard>) + 2 * sizeof(void*) + k.clustering_key.size();
+}
+
+counter_cache::partition* counter_cache::find(const utils::UUID& table, bytes_view key) {
+    auto table_it = _tables.find(table);
+    if (table_it == _tables.end()) {
+        return nullptr;
+    }
+    auto it = table_it->second.find(bytes(key));
+    return it != table_it->second.end() ? &it->second : nullptr;
+}
+
+void counter_cache::erase(table_partitions& partitions, table_partitions::iterator it) noexcept {
+    _stats.bytes -= it->second.bytes;
+    partitions.erase(it);
+}
+
+void counter_cache::evict() noexcept {
+    while (_stats.bytes > _max_bytes && !_lru.empty()) {
+        auto& p = _lru.back();
+        auto table_it = _tables.find(p.table);
+        auto& partitions = table_it->second;
+        erase(partitions, partitions.find(p.key));
+        if (partitions.empty()) {
+            _tables.erase(table_it);
+        }
+        ++_stats.evictions;
+    }
+}
+
+std::optional<mutation> counter_cache::get_local_shards(const mutation& m) {
+    if (!enabled()) {
+        return {};
+    }
+    auto& s = *m.schema();
+    auto p = find(s.id(), m.key().representation());
+    if (!p) {
+        ++_stats.misses;
+        return {};
+    }
+
+    mutation state(m.schema(), m.decorated_key());
+    auto fill = [&] (column_kind kind, bytes_view ck, const row& cells, auto&& state_cells) {
+        bool all_cached = true;
+        cells.for_each_cell_until([&] (column_id id, const atomic_cell_or_collection& c) {
+            auto& cdef = s.column_at(kind, id);
+            auto acv = c.as_atomic_cell(cdef);
+            if (!acv.is_live()) {
+                return stop_iteration::no;
+            }
+            auto it = p->cells.find(cell_key{kind, id, bytes(ck)});
+            if (it == p->cells.end()) {
+                all_cached = false;
+                return stop_iteration::yes;
+            }
+            auto cs = counter_shard(counter_id::local(), it->second.value, it->second.logical_clock);
+            state_cells().apply(cdef, counter_cell_builder::from_single_shard(acv.timestamp(), cs));
+            return stop_iteration::no;
+        });
+        return all_cached;
+    };
+
+    bool all_cached = fill(column_kind::static_column, bytes_view(), m.partition().static_row().get(), [&] () -> row& {
+        return state.partition().static_row().maybe_create();
+    });
+    for (auto& cr : m.partition().clustered_rows()) {
+        if (!all_cached) {
+            break;
+        }
+        all_cached = fill(column_kind::regular_column, cr.key().representation(), cr.row().cells(), [&] () -> row& {
+            return state.partition().clustered_row(s, cr.key()).cells();
+        });
+    }
+    if (!all_cached) {
+        ++_stats.misses;
+        return {};
+    }
+    p->lru_link.unlink();
+    _lru.push_front(*p);
+    ++_stats.hits;
+    return state;
+}
+
+void counter_cache::populate(const mutation& m) noexcept {
+    if (!enabled()) {
+        return;
+    }
+    auto& s = *m.schema();
+    try {
+        auto& partitions = _tables[s.id()];
+        auto key = bytes(m.key().representation());
+        auto [it, inserted] = partitions.try_emplace(key);
+        auto& p = it->second;
+        if (inserted) {
+            p.table = s.id();
+            p.key = std::move(key);
+            p.bytes = sizeof(std::pair<const bytes, partition>) + 2 * sizeof(void*) + 2 * p.key.size();
+            _stats.bytes += p.bytes;
+        }
+        p.lru_link.unlink();
+        _lru.push_front(p);
+
+        auto add = [&] (column_kind kind, bytes_view ck, const row& cells) {
+            cells.for_each_cell([&] (column_id id, const atomic_cell_or_collection& c) {
+                auto& cdef = s.column_at(kind, id);
+                auto acv = c.as_atomic_cell(cdef);
+                if (!acv.is_live()) {
+                    return;
+                }
+                counter_cell_view::with_linearized(acv, [&] (counter_cell_view ccv) {
+                    auto cs = ccv.local_shard();
+                    if (!cs) {
+                        return;
+                    }
+                    auto k = cell_key{kind, id, bytes(ck)};
+                    auto size = cell_memory_usage(k);
+                    auto [cell_it, cell_inserted] = p.cells.insert_or_assign(std::move(k), local_shard{cs->value(), cs->logical_clock()});
+                    if (cell_inserted) {
+                        p.bytes += size;
+                        _stats.bytes += size;
+                    }
+                });
+            });
+        };
+        add(column_kind::static_column, bytes_view(), m.partition().static_row().get());
+        for (auto& cr : m.partition().clustered_rows()) {
+            add(column_kind::regular_column, cr.key().representation(), cr.row().cells());
+        }
+        ++_stats.populations;
+    } catch (...) {
+        // The partition could be left with stale shards of the cells which
+        // weren't updated.
+        try {
+            invalidate(s.id(), m.key().representation());
+        } catch (...) {
+            invalidate(s.id());
+        }
+    }
+    evict();
+}
+
+void counter_cache::on_write(const schema& s, const frozen_mutation& m) {
+    if (!find(s.id(), m.key().representation())) {
+        return;
+    }
+    counter_deletion_detector detector;
+    m.partition().accept(s.get_column_mapping(), detector);
+    if (detector.found) {
+        invalidate(s.id(), m.key().representation());
+    }
+}
+
+void counter_cache::invalidate(const utils::UUID& table, bytes_view key) {
+    auto table_it = _tables.find(table);
+    if (table_it == _tables.end()) {
+        return;
+    }
+    auto& partitions = table_it->second;
+    auto it = partitions.find(bytes(key));
+    if (it != partitions.end()) {
+        erase(partitions, it);
+        ++_stats.invalidations;
+    }
+    if (partitions.empty()) {
+        _tables.erase(table_it);
+    }
+}
+
+void counter_cache::invalidate(const utils::UUID& table) noexcept {
+    auto table_it = _tables.find(table);
+    if (table_it == _tables.end()) {
+        return;
+    }
+    auto& partitions = table_it->second;
+    _stats.invalidations += partitions.size();
+    while (!partitions.empty()) {
+        erase(partitions, partitions.begin());
+    }
+    _tables.erase(table_it);
+}
+
+void counter_cache::clear() noexcept {
+    while (!_tables.empty()) {
+        invalidate(_tables.begin()->first);
+    }
+}
+
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <optional>
+#include <unordered_map>
+
+#include <boost/intrusive/list.hpp>
+
+#include "bytes.hh"
+#include "schema_fwd.hh"
+#include "utils/UUID.hh"
+
+class mutation;
+class frozen_mutation;
+
+namespace db {
+
+// Shard-local cache of the local shards of counter cells.
+//
+// Before a counter update is applied on the leader replica, its deltas are
+// turned into the leader's counter shard, which requires the current value
+// and logical clock of that shard for every modified cell (the leader read).
+// The cache keeps the (value, clock) pair of recently updated cells so that
+// updates whose cells are all cached skip the read. It is populated with the
+// shards produced by successful updates, and partitions are evicted in LRU
+// order once its memory exceeds the limit.
+//
+// The cache must be accessed only with the counter cell locks of the updated
+// cells held. Entries are invalidated whenever the local shards could change
+// other than by an update: counter deletions, schema changes, truncation,
+// streaming and loading of new sstables.
+class counter_cache {
+public:
+    struct stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t populations = 0;
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0;
+        uint64_t bytes = 0;
+    };
+private:
+    struct cell_key {
+        column_kind kind;
+        column_id id;
+        // Empty for static cells.
+        bytes clustering_key;
+
+        bool operator==(const cell_key& o) const {
+            return kind == o.kind && id == o.id && clustering_key == o.clustering_key;
+        }
+    };
+    struct cell_key_hash {
+        size_t operator()(const cell_key& k) const {
+            return std::hash<bytes_view>()(k.clustering_key) ^ (size_t(k.id) << 1) ^ size_t(k.kind);
+        }
+    };
+    struct bytes_hash {
+        size_t operator()(const bytes& b) const {
+            return std::hash<bytes_view>()(b);
+        }
+    };
+    struct local_shard {
+        int64_t value;
+        int64_t logical_clock;
+    };
+    using lru_link_type = boost::intrusive::list_member_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+    struct partition {
+        utils::UUID table;
+        bytes key;
+        std::unordered_map<cell_key, local_shard, cell_key_hash> cells;
+        size_t bytes = 0;
+        lru_link_type lru_link;
+    };
+    using lru_type = boost::intrusive::list<partition,
+        boost::intrusive::member_hook<partition, lru_link_type, &partition::lru_link>,
+        boost::intrusive::constant_time_size<false>>;
+    using table_partitions = std::unordered_map<bytes, partition, bytes_hash>;
+
+    std::unordered_map<utils::UUID, table_partitions> _tables;
+    lru_type _lru;
+    size_t _max_bytes;
+    stats _stats;
+private:
+    static size_t cell_memory_usage(const cell_key&);
+    partition* find(const utils::UUID& table, bytes_view key);
+    void erase(table_partitions& partitions, table_partitions::iterator it) noexcept;
+    void evict() noexcept;
+public:
+    // A zero limit disables the cache.
+    explicit counter_cache(size_t max_bytes);
+    ~counter_cache();
+    counter_cache(const counter_cache&) = delete;
+
+    void set_max_bytes(size_t max_bytes) {
+        _max_bytes = max_bytes;
+        evict();
+    }
+    bool enabled() const {
+        return _max_bytes > 0;
+    }
+
+    // Returns a mutation holding, for each live cell of the counter update m,
+    // a counter cell made of just the cached local shard, suitable as the
+    // current state for transform_counter_updates_to_shards().
+    // Returns a disengaged optional if any of the cells isn't cached.
+    std::optional<mutation> get_local_shards(const mutation& m);
+
+    // Caches the local shards of the cells of m, a counter update already
+    // transformed to shards and applied.
+    void populate(const mutation& m) noexcept;
+
+    // Must be called for writes to counter tables other than counter
+    // updates, invalidates the partition if the write deletes anything.
+    void on_write(const schema& s, const frozen_mutation& m);
+
+    void invalidate(const utils::UUID& table, bytes_view key);
+    void invalidate(const utils::UUID& table) noexcept;
+    void clear() noexcept;
+
+    const stats& get_stats() const { return _stats; }
+};
+
+}
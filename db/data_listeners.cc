@@ -19,6 +19,8 @@
  * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <seastar/core/metrics.hh>
+
 #include "db/data_listeners.hh"
 #include "database.hh"
 #include "db_clock.hh"
@@ -121,6 +123,151 @@ toppartitions_data_listener::localize(const global_top_k::results& r) {
     return n;
 }
 
+static constexpr std::array<std::string_view, continuous_toppartitions_listener::ranking_count> ranking_names = {
+    "reads",
+    "writes",
+    "write_bytes",
+};
+
+std::string_view continuous_toppartitions_listener::to_string(ranking r) {
+    return ranking_names[size_t(r)];
+}
+
+continuous_toppartitions_listener::continuous_toppartitions_listener(database& db, config cfg)
+        : _db(db)
+        , _cfg(std::move(cfg))
+        , _window_timer([this] { rotate_window(); })
+        , _sampling_ratio_observer(_cfg.sampling_ratio.observe([this] (uint32_t ratio) { update_installation(ratio); })) {
+    namespace sm = seastar::metrics;
+    _metrics.add_group("database", {
+        sm::make_derive("toppartitions_sampled_reads", _stats.sampled_reads,
+                sm::description("Number of queries sampled by continuous top partitions tracking")),
+        sm::make_derive("toppartitions_sampled_writes", _stats.sampled_writes,
+                sm::description("Number of writes sampled by continuous top partitions tracking")),
+        sm::make_gauge("toppartitions_hottest_reads", [this] { return hottest_in_previous_window(ranking::reads); },
+                sm::description("Estimated number of reads of the most read partition of this shard in the last complete window")),
+        sm::make_gauge("toppartitions_hottest_writes", [this] { return hottest_in_previous_window(ranking::writes); },
+                sm::description("Estimated number of writes to the most written partition of this shard in the last complete window")),
+        sm::make_gauge("toppartitions_hottest_write_bytes", [this] { return hottest_in_previous_window(ranking::write_bytes); },
+                sm::description("Estimated number of bytes written to the partition of this shard with the most bytes written in the last complete window")),
+    });
+    update_installation(_cfg.sampling_ratio());
+}
+
+continuous_toppartitions_listener::~continuous_toppartitions_listener() {
+    update_installation(0);
+}
+
+void continuous_toppartitions_listener::update_installation(uint32_t sampling_ratio) {
+    bool enable = sampling_ratio != 0;
+    if (enable == _installed) {
+        return;
+    }
+    if (enable) {
+        dblog.info("Continuous top partitions tracking enabled, sampling 1 in {} operations", sampling_ratio);
+        _db.data_listeners().install(this);
+        _window_length = std::chrono::seconds(std::max(_cfg.window_in_s(), 1u));
+        _window_timer.arm_periodic(_window_length);
+    } else {
+        dblog.info("Continuous top partitions tracking disabled");
+        _db.data_listeners().uninstall(this);
+        _window_timer.cancel();
+        _current.clear();
+        _previous.clear();
+    }
+    _installed = enable;
+}
+
+void continuous_toppartitions_listener::rotate_window() {
+    _previous = std::exchange(_current, window{});
+    // Pick up changes of the window length.
+    auto length = std::chrono::seconds(std::max(_cfg.window_in_s(), 1u));
+    if (length != _window_length) {
+        _window_length = length;
+        _window_timer.rearm_periodic(_window_length);
+    }
+}
+
+continuous_toppartitions_listener::table_counters& continuous_toppartitions_listener::counters_for(const schema_ptr& s) {
+    auto it = _current.find(s->id());
+    if (it == _current.end()) {
+        it = _current.emplace(std::piecewise_construct, std::forward_as_tuple(s->id()),
+                std::forward_as_tuple(s, std::max(_cfg.capacity(), 1u))).first;
+    }
+    return it->second;
+}
+
+flat_mutation_reader continuous_toppartitions_listener::on_read(const schema_ptr& s, const dht::partition_range& range,
+        const query::partition_slice& slice, flat_mutation_reader&& rd) {
+    auto ratio = _cfg.sampling_ratio();
+    if (!ratio || ++_reads % ratio) {
+        return std::move(rd);
+    }
+    ++_stats.sampled_reads;
+    return make_filtering_reader(std::move(rd), [zis = this->weak_from_this(), s, ratio] (const dht::decorated_key& dk) {
+        // The query may outlive the listener, or the window it was sampled in.
+        if (zis) {
+            zis->counters_for(s).top[size_t(ranking::reads)].append(toppartitions_item_key{s, dk}, ratio);
+        }
+        return true;
+    });
+}
+
+void continuous_toppartitions_listener::on_write(const schema_ptr& s, const frozen_mutation& m) {
+    auto ratio = _cfg.sampling_ratio();
+    if (!ratio || ++_writes % ratio) {
+        return;
+    }
+    ++_stats.sampled_writes;
+    auto& counters = counters_for(s);
+    auto key = toppartitions_item_key{s, m.decorated_key(*s)};
+    auto bytes = std::min<uint64_t>(uint64_t(m.representation().size()) * ratio, std::numeric_limits<unsigned>::max());
+    counters.top[size_t(ranking::writes)].append(key, ratio);
+    counters.top[size_t(ranking::write_bytes)].append(std::move(key), bytes);
+}
+
+uint64_t continuous_toppartitions_listener::hottest_in_previous_window(ranking r) const {
+    uint64_t hottest = 0;
+    for (auto&& [id, counters] : _previous) {
+        auto top = counters.top[size_t(r)].top(1);
+        if (!top.empty()) {
+            hottest = std::max<uint64_t>(hottest, top.front().count);
+        }
+    }
+    return hottest;
+}
+
+std::vector<continuous_toppartitions_listener::table_rankings> continuous_toppartitions_listener::top(size_t k) const {
+    std::unordered_map<utils::UUID, std::pair<const table_counters*, const table_counters*>> tables;
+    for (auto&& [id, counters] : _previous) {
+        tables[id].first = &counters;
+    }
+    for (auto&& [id, counters] : _current) {
+        tables[id].second = &counters;
+    }
+    std::vector<table_rankings> result;
+    result.reserve(tables.size());
+    for (auto&& [id, windows] : tables) {
+        auto [previous, current] = windows;
+        auto& s = (current ? current : previous)->schema;
+        table_rankings tr{s->ks_name(), s->cf_name()};
+        for (size_t r = 0; r < ranking_count; ++r) {
+            // Windows are disjoint, so merging their rankings sums the counts of each partition.
+            top_k merged(std::max(_cfg.capacity(), 1u));
+            for (auto w : {previous, current}) {
+                if (w) {
+                    merged.append(w->top[r].top(w->top[r].capacity()));
+                }
+            }
+            for (auto&& e : merged.top(k)) {
+                tr.rankings[r].push_back(partition_count{sstring(e.item), this_shard_id(), e.count, e.error});
+            }
+        }
+        result.push_back(std::move(tr));
+    }
+    return result;
+}
+
 toppartitions_query::toppartitions_query(distributed<database>& xdb, sstring ks, sstring cf,
         std::chrono::milliseconds duration, size_t list_size, size_t capacity)
         : _xdb(xdb), _ks(ks), _cf(cf), _duration(duration), _list_size(list_size), _capacity(capacity),
@@ -30,9 +30,16 @@
 #include "flat_mutation_reader.hh"
 #include "mutation_reader.hh"
 #include "frozen_mutation.hh"
+#include <seastar/core/timer.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
+
 #include "utils/top_k.hh"
+#include "utils/updateable_value.hh"
 #include "schema_registry.hh"
 
+#include <array>
+#include <unordered_map>
 #include <vector>
 #include <set>
 
@@ -153,6 +160,93 @@ class toppartitions_data_listener : public data_listener, public weakly_referenc
     future<> stop();
 };
 
+// Continuously tracks the hottest partitions of all tables of this shard.
+//
+// Unlike toppartitions_data_listener, which counts every operation on one
+// table for the duration of a toppartitions query, this listener samples one
+// in sampling_ratio queries and writes and weighs the sampled ones
+// accordingly, so that it is cheap enough to be left enabled. Counts are
+// kept in windows of window_in_s seconds, and the reported rankings merge
+// the last complete window with the current one.
+class continuous_toppartitions_listener : public data_listener, public weakly_referencable<continuous_toppartitions_listener> {
+public:
+    using top_k = toppartitions_data_listener::top_k;
+
+    enum class ranking {
+        reads,
+        writes,
+        write_bytes,
+    };
+    static constexpr size_t ranking_count = size_t(ranking::write_bytes) + 1;
+    static std::string_view to_string(ranking);
+
+    struct config {
+        // 0 disables tracking.
+        utils::updateable_value<uint32_t> sampling_ratio;
+        utils::updateable_value<uint32_t> window_in_s;
+        // Number of partitions tracked by each ranking of each table.
+        utils::updateable_value<uint32_t> capacity;
+    };
+
+    struct partition_count {
+        sstring key;
+        shard_id shard;
+        uint64_t count;
+        uint64_t error;
+    };
+
+    struct table_rankings {
+        sstring ks_name;
+        sstring cf_name;
+        std::array<std::vector<partition_count>, ranking_count> rankings;
+    };
+
+    struct stats {
+        uint64_t sampled_reads = 0;
+        uint64_t sampled_writes = 0;
+    };
+private:
+    struct table_counters {
+        schema_ptr schema;
+        std::array<top_k, ranking_count> top;
+
+        table_counters(schema_ptr s, size_t capacity)
+            : schema(std::move(s)), top{top_k(capacity), top_k(capacity), top_k(capacity)} { }
+    };
+    using window = std::unordered_map<utils::UUID, table_counters>;
+
+    database& _db;
+    config _cfg;
+    window _current;
+    window _previous;
+    uint64_t _reads = 0;
+    uint64_t _writes = 0;
+    stats _stats;
+    bool _installed = false;
+    std::chrono::seconds _window_length{0};
+    timer<lowres_clock> _window_timer;
+    utils::observer<uint32_t> _sampling_ratio_observer;
+    seastar::metrics::metric_groups _metrics;
+private:
+    table_counters& counters_for(const schema_ptr& s);
+    void update_installation(uint32_t sampling_ratio);
+    void rotate_window();
+    uint64_t hottest_in_previous_window(ranking r) const;
+public:
+    continuous_toppartitions_listener(database& db, config cfg);
+    ~continuous_toppartitions_listener();
+
+    virtual flat_mutation_reader on_read(const schema_ptr& s, const dht::partition_range& range,
+            const query::partition_slice& slice, flat_mutation_reader&& rd) override;
+
+    virtual void on_write(const schema_ptr& s, const frozen_mutation& m) override;
+
+    // The hottest partitions of each tracked table, at most k per ranking, hottest first.
+    std::vector<table_rankings> top(size_t k) const;
+
+    const stats& get_stats() const { return _stats; }
+};
+
 class toppartitions_query {
     distributed<database>& _xdb;
     sstring _ks;
@@ -87,6 +87,9 @@ void manager::register_metrics(const sstring& group_name) {
 
         sm::make_derive("corrupted_files", _stats.corrupted_files,
                         sm::description("Number of hints files that were discarded during sending because the file was corrupted.")),
+
+        sm::make_derive("merged", _stats.merged,
+                        sm::description("Number of hints that were merged during sending with another hint for the same partition.")),
     });
 }
 
@@ -322,6 +325,7 @@ future<db::commitlog> manager::end_point_hints_manager::add_store() noexcept {
             cfg.commitlog_total_space_in_mb = resource_manager::max_hints_per_ep_size_mb;
             cfg.fname_prefix = manager::FILENAME_PREFIX;
             cfg.extensions = &_shard_manager.local_db().extensions();
+            cfg.entry_compressor = compressor::create(_shard_manager.local_db().get_config().hints_compression(), [] (const sstring&) { return compressor::opt_string(); });
 
             // HH doesn't utilize the flow that benefits from reusing segments.
             // Therefore let's simply disable it to avoid any possible confusion.
@@ -396,20 +400,6 @@ future<timespec> manager::end_point_hints_manager::sender::get_last_file_modific
     });
 }
 
-future<> manager::end_point_hints_manager::sender::do_send_one_mutation(frozen_mutation_and_schema m, const std::vector<gms::inet_address>& natural_endpoints) noexcept {
-    return futurize_invoke([this, m = std::move(m), &natural_endpoints] () mutable -> future<> {
-        // The fact that we send with CL::ALL in both cases below ensures that new hints are not going
-        // to be generated as a result of hints sending.
-        if (boost::range::find(natural_endpoints, end_point_key()) != natural_endpoints.end()) {
-            manager_logger.trace("Sending directly to {}", end_point_key());
-            return _proxy.send_hint_to_endpoint(std::move(m), end_point_key());
-        } else {
-            manager_logger.trace("Endpoints set has changed and {} is no longer a replica. Mutating from scratch...", end_point_key());
-            return _proxy.send_hint_to_all_replicas(std::move(m));
-        }
-    });
-}
-
 bool manager::end_point_hints_manager::sender::can_send() noexcept {
     if (stopping() && !draining()) {
         return false;
@@ -672,60 +662,176 @@ void manager::end_point_hints_manager::sender::start() {
     });
 }
 
-future<> manager::end_point_hints_manager::sender::send_one_mutation(frozen_mutation_and_schema m) {
-    keyspace& ks = _db.find_keyspace(m.s->ks_name());
-    auto& rs = ks.get_replication_strategy();
-    auto token = dht::get_token(*m.s, m.fm.key());
-    std::vector<gms::inet_address> natural_endpoints = rs.get_natural_endpoints(std::move(token));
+size_t manager::end_point_hints_manager::sender::replay_batch_size() const {
+    return std::max<size_t>(_db.get_config().hints_replay_batch_size(), 1);
+}
 
-    return do_send_one_mutation(std::move(m), natural_endpoints);
+future<> manager::end_point_hints_manager::sender::throttle_replay(size_t mutations) {
+    using namespace std::literals::chrono_literals;
+    auto send_tp = _resource_manager.reserve_replay_slot(mutations, _db.get_config().hints_replay_max_mutations_per_second());
+    // Sleep in short steps so that stop() doesn't have to wait for a slow replay.
+    return do_until([this, send_tp] { return clock::now() >= send_tp || (stopping() && !draining()); }, [send_tp] {
+        return sleep(std::min<clock::duration>(send_tp - clock::now(), 100ms));
+    });
 }
 
-future<> manager::end_point_hints_manager::sender::send_one_hint(lw_shared_ptr<send_one_file_ctx> ctx_ptr, fragmented_temporary_buffer buf, db::replay_position rp, gc_clock::duration secs_since_file_mod, const sstring& fname) {
-    return _resource_manager.get_send_units_for(buf.size_bytes()).then([this, secs_since_file_mod, &fname, buf = std::move(buf), rp, ctx_ptr] (auto units) mutable {
-        // Future is waited on indirectly in `send_one_file()` (via `ctx_ptr->file_send_gate`).
-        (void)with_gate(ctx_ptr->file_send_gate, [this, secs_since_file_mod, &fname, buf = std::move(buf), rp, ctx_ptr] () mutable {
-            try {
-                try {
-                    ctx_ptr->rps_set.emplace(rp);
-                } catch (...) {
-                    // if we failed to insert the rp into the set then its contents can't be trusted and we have to re-send the current file from the beginning
-                    ctx_ptr->state.set(send_state::restart_segment);
-                    ctx_ptr->state.set(send_state::segment_replay_failed);
-                    return make_ready_future<>();
-                }
+std::vector<manager::end_point_hints_manager::sender::merged_hint>
+manager::end_point_hints_manager::sender::merge_hints(lw_shared_ptr<send_one_file_ctx> ctx_ptr, std::vector<hint_entry>& hints, gc_clock::duration secs_since_file_mod, const sstring& fname) {
+    struct decoded_hint {
+        frozen_mutation_and_schema m;
+        dht::decorated_key dk;
+        db::replay_position rp;
+    };
+
+    std::vector<decoded_hint> decoded;
+    decoded.reserve(hints.size());
+    for (auto& h : hints) {
+        try {
+            auto m = this->get_mutation(ctx_ptr, h.buf);
+            gc_clock::duration gc_grace_sec = m.s->gc_grace_seconds();
 
-                auto m = this->get_mutation(ctx_ptr, buf);
-                gc_clock::duration gc_grace_sec = m.s->gc_grace_seconds();
+            // The hint is too old - drop it.
+            //
+            // Files are aggregated for at most manager::hints_timer_period therefore the oldest hint there is
+            // (last_modification - manager::hints_timer_period) old.
+            if (gc_clock::now().time_since_epoch() - secs_since_file_mod > gc_grace_sec - manager::hints_flush_period) {
+                ctx_ptr->rps_set.erase(h.rp);
+                continue;
+            }
 
-                // The hint is too old - drop it.
-                //
-                // Files are aggregated for at most manager::hints_timer_period therefore the oldest hint there is
-                // (last_modification - manager::hints_timer_period) old.
-                if (gc_clock::now().time_since_epoch() - secs_since_file_mod > gc_grace_sec - manager::hints_flush_period) {
-                    return make_ready_future<>();
-                }
+            auto dk = m.fm.decorated_key(*m.s);
+            decoded.push_back(decoded_hint{std::move(m), std::move(dk), h.rp});
+            continue;
+
+        // ignore these errors and move on - probably this hint is too old and the KS/CF has been deleted...
+        } catch (no_such_column_family& e) {
+            manager_logger.debug("send_hints(): no_such_column_family: {}", e.what());
+        } catch (no_such_keyspace& e) {
+            manager_logger.debug("send_hints(): no_such_keyspace: {}", e.what());
+        } catch (no_column_mapping& e) {
+            manager_logger.debug("send_hints(): {} at {}: {}", fname, h.rp, e.what());
+        }
+        ctx_ptr->rps_set.erase(h.rp);
+        ++this->shard_stats().discarded;
+    }
 
-                return this->send_one_mutation(std::move(m)).then([this, rp, ctx_ptr] {
-                    ctx_ptr->rps_set.erase(rp);
-                    ++this->shard_stats().sent;
-                }).handle_exception([this, ctx_ptr] (auto eptr) {
-                    manager_logger.trace("send_one_hint(): failed to send to {}: {}", end_point_key(), eptr);
-                    ctx_ptr->state.set(send_state::segment_replay_failed);
-                });
+    // Mutations are commutative, so the order in which they are sent doesn't matter.
+    // Sort them to bring together the hints for the same partition.
+    auto same_table = [] (const decoded_hint& a, const decoded_hint& b) {
+        return a.m.s->id() == b.m.s->id() && a.m.s->version() == b.m.s->version();
+    };
+    std::sort(decoded.begin(), decoded.end(), [] (const decoded_hint& a, const decoded_hint& b) {
+        if (a.m.s->id() != b.m.s->id()) {
+            return a.m.s->id() < b.m.s->id();
+        }
+        if (a.m.s->version() != b.m.s->version()) {
+            return a.m.s->version() < b.m.s->version();
+        }
+        return a.dk.less_compare(*a.m.s, b.dk);
+    });
 
-            // ignore these errors and move on - probably this hint is too old and the KS/CF has been deleted...
-            } catch (no_such_column_family& e) {
-                manager_logger.debug("send_hints(): no_such_column_family: {}", e.what());
-                ++this->shard_stats().discarded;
-            } catch (no_such_keyspace& e) {
-                manager_logger.debug("send_hints(): no_such_keyspace: {}", e.what());
-                ++this->shard_stats().discarded;
-            } catch (no_column_mapping& e) {
-                manager_logger.debug("send_hints(): {} at {}: {}", fname, rp, e.what());
-                ++this->shard_stats().discarded;
+    std::vector<merged_hint> merged;
+    merged.reserve(decoded.size());
+    for (auto it = decoded.begin(); it != decoded.end();) {
+        auto next = std::find_if(std::next(it), decoded.end(), [&] (const decoded_hint& h) {
+            return !same_table(*it, h) || !it->dk.equal(*it->m.s, h.dk);
+        });
+        if (std::next(it) == next) {
+            merged.push_back(merged_hint{std::move(it->m), {it->rp}});
+        } else {
+            mutation m = it->m.fm.unfreeze(it->m.s);
+            std::vector<db::replay_position> rps{it->rp};
+            for (auto i = std::next(it); i != next; ++i) {
+                m.apply(i->m.fm.unfreeze(i->m.s));
+                rps.push_back(i->rp);
             }
-            return make_ready_future<>();
+            this->shard_stats().merged += rps.size() - 1;
+            merged.push_back(merged_hint{{freeze(m), it->m.s}, std::move(rps)});
+        }
+        it = next;
+    }
+    return merged;
+}
+
+void manager::end_point_hints_manager::sender::on_hints_sent(send_one_file_ctx& ctx, const std::vector<db::replay_position>& rps, future<> f) noexcept {
+    if (f.failed()) {
+        manager_logger.trace("send_hints(): failed to send to {}: {}", end_point_key(), f.get_exception());
+        ctx.state.set(send_state::segment_replay_failed);
+        return;
+    }
+    for (auto& rp : rps) {
+        ctx.rps_set.erase(rp);
+    }
+    this->shard_stats().sent += rps.size();
+}
+
+future<> manager::end_point_hints_manager::sender::send_merged_hints(lw_shared_ptr<send_one_file_ctx> ctx_ptr, std::vector<merged_hint> hints) {
+    // The sender may have been stopped while the hints were throttled.
+    if (stopping() && !draining()) {
+        ctx_ptr->state.set(send_state::segment_replay_failed);
+        return make_ready_future<>();
+    }
+
+    std::vector<frozen_mutation_and_schema> direct;
+    std::vector<db::replay_position> direct_rps;
+    std::vector<merged_hint> rerouted;
+    for (auto& h : hints) {
+        try {
+            auto& rs = _db.find_keyspace(h.m.s->ks_name()).get_replication_strategy();
+            std::vector<gms::inet_address> natural_endpoints = rs.get_natural_endpoints(dht::get_token(*h.m.s, h.m.fm.key()));
+            if (boost::range::find(natural_endpoints, end_point_key()) != natural_endpoints.end()) {
+                direct_rps.insert(direct_rps.end(), h.rps.begin(), h.rps.end());
+                direct.push_back(std::move(h.m));
+            } else {
+                rerouted.push_back(std::move(h));
+            }
+        } catch (no_such_keyspace& e) {
+            manager_logger.debug("send_hints(): no_such_keyspace: {}", e.what());
+            for (auto& rp : h.rps) {
+                ctx_ptr->rps_set.erase(rp);
+            }
+            this->shard_stats().discarded += h.rps.size();
+        }
+    }
+
+    // The fact that we send with CL::ALL in both cases below ensures that new hints are not going
+    // to be generated as a result of hints sending.
+    auto direct_sent = make_ready_future<>();
+    if (!direct.empty()) {
+        manager_logger.trace("Sending {} hints directly to {}", direct.size(), end_point_key());
+        direct_sent = _proxy.send_hints_to_endpoint(std::move(direct), end_point_key()).then_wrapped([this, ctx_ptr, rps = std::move(direct_rps)] (future<> f) {
+            on_hints_sent(*ctx_ptr, rps, std::move(f));
+        });
+    }
+    return do_with(std::move(rerouted), [this, ctx_ptr] (std::vector<merged_hint>& rerouted) {
+        return parallel_for_each(rerouted, [this, ctx_ptr] (merged_hint& h) {
+            manager_logger.trace("Endpoints set has changed and {} is no longer a replica. Mutating from scratch...", end_point_key());
+            return _proxy.send_hint_to_all_replicas(std::move(h.m)).then_wrapped([this, ctx_ptr, &h] (future<> f) {
+                on_hints_sent(*ctx_ptr, h.rps, std::move(f));
+            });
+        });
+    }).then([direct_sent = std::move(direct_sent)] () mutable {
+        return std::move(direct_sent);
+    });
+}
+
+future<> manager::end_point_hints_manager::sender::send_hints(lw_shared_ptr<send_one_file_ctx> ctx_ptr, gc_clock::duration secs_since_file_mod, const sstring& fname) {
+    auto hints = std::exchange(ctx_ptr->pending_hints, {});
+    size_t size = 0;
+    for (auto& h : hints) {
+        size += h.buf.size_bytes();
+    }
+    return _resource_manager.get_send_units_for(size).then([this, secs_since_file_mod, &fname, hints = std::move(hints), ctx_ptr] (auto units) mutable {
+        // Future is waited on indirectly in `send_one_file()` (via `ctx_ptr->file_send_gate`).
+        (void)with_gate(ctx_ptr->file_send_gate, [this, secs_since_file_mod, &fname, hints = std::move(hints), ctx_ptr] () mutable {
+            auto merged = this->merge_hints(ctx_ptr, hints, secs_since_file_mod, fname);
+            auto mutations = merged.size();
+            return this->throttle_replay(mutations).then([this, ctx_ptr, merged = std::move(merged)] () mutable {
+                return this->send_merged_hints(std::move(ctx_ptr), std::move(merged));
+            });
+        }).handle_exception([this, ctx_ptr] (auto eptr) {
+            manager_logger.trace("send_hints(): failed to send to {}: {}", end_point_key(), eptr);
+            ctx_ptr->state.set(send_state::segment_replay_failed);
         }).finally([units = std::move(units), ctx_ptr] {});
     }).handle_exception([this, ctx_ptr] (auto eptr) {
         manager_logger.trace("send_one_file(): Hmmm. Something bad had happend: {}", eptr);
@@ -755,7 +861,20 @@ bool manager::end_point_hints_manager::sender::send_one_file(const sstring& fnam
             }
 
             return flush_maybe().finally([this, ctx_ptr, buf = std::move(buf), rp, secs_since_file_mod, &fname] () mutable {
-                return send_one_hint(std::move(ctx_ptr), std::move(buf), rp, secs_since_file_mod, fname);
+                try {
+                    ctx_ptr->rps_set.emplace(rp);
+                } catch (...) {
+                    // if we failed to insert the rp into the set then its contents can't be trusted and we have to re-send the current file from the beginning
+                    ctx_ptr->state.set(send_state::restart_segment);
+                    ctx_ptr->state.set(send_state::segment_replay_failed);
+                    return make_ready_future<>();
+                }
+
+                ctx_ptr->pending_hints.push_back(hint_entry{std::move(buf), rp});
+                if (ctx_ptr->pending_hints.size() < replay_batch_size()) {
+                    return make_ready_future<>();
+                }
+                return send_hints(std::move(ctx_ptr), secs_since_file_mod, fname);
             });
         }, _last_not_complete_rp.pos, &_db.extensions()).get();
     } catch (db::commitlog::segment_error& ex) {
@@ -767,6 +886,11 @@ bool manager::end_point_hints_manager::sender::send_one_file(const sstring& fnam
         ctx_ptr->state.set(send_state::segment_replay_failed);
     }
 
+    // send the hints of the last, incomplete batch
+    if (!ctx_ptr->pending_hints.empty() && (draining() || !ctx_ptr->state.contains(send_state::segment_replay_failed))) {
+        send_hints(ctx_ptr, secs_since_file_mod, fname).get();
+    }
+
     // wait till all background hints sending is complete
     ctx_ptr->file_send_gate.close().get();
 
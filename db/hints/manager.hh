@@ -62,6 +62,7 @@ class manager : public service::endpoint_lifecycle_subscriber {
         uint64_t sent = 0;
         uint64_t discarded = 0;
         uint64_t corrupted_files = 0;
+        uint64_t merged = 0;
     };
 
     // map: shard -> segments
@@ -104,6 +105,17 @@ class manager : public service::endpoint_lifecycle_subscriber {
                 send_state::segment_replay_failed,
                 send_state::restart_segment>>;
 
+            struct hint_entry {
+                fragmented_temporary_buffer buf;
+                db::replay_position rp;
+            };
+
+            // A mutation merging all hints of a replay batch that update the same partition.
+            struct merged_hint {
+                frozen_mutation_and_schema m;
+                std::vector<db::replay_position> rps;
+            };
+
             struct send_one_file_ctx {
                 send_one_file_ctx(std::unordered_map<table_schema_version, column_mapping>& last_schema_ver_to_column_mapping)
                     : schema_ver_to_column_mapping(last_schema_ver_to_column_mapping)
@@ -111,6 +123,7 @@ class manager : public service::endpoint_lifecycle_subscriber {
                 std::unordered_map<table_schema_version, column_mapping>& schema_ver_to_column_mapping;
                 seastar::gate file_send_gate;
                 std::unordered_set<db::replay_position> rps_set; // number of elements in this set is never going to be greater than the maximum send queue length
+                std::vector<hint_entry> pending_hints; // hints read from the file and not sent yet
                 send_state_set state;
             };
 
@@ -193,20 +206,50 @@ class manager : public service::endpoint_lifecycle_subscriber {
                 return _ep_manager.replay_allowed();
             }
 
-            /// \brief Try to send one hint read from the file.
+            /// \brief Send the hints of the replay batch collected in \ref send_one_file_ctx::pending_hints.
             ///  - Limit the maximum memory size of hints "in the air" and the maximum total number of hints "in the air".
             ///  - Discard the hints that are older than the grace seconds value of the corresponding table.
+            ///  - Merge the hints that update the same partition.
+            ///
+            /// The replay positions of the hints are expected to be in the _rps_set already. If sending fails we are
+            /// going to set send_state::segment_replay_failed in the ctx_ptr->state, otherwise the replay positions
+            /// are going to be removed from the _rps_set.
             ///
-            /// If sending fails we are going to clear the state::segment_replay_ok in the _state and \ref rp is going to be stored in the _rps_set.
-            /// If sending is successful then \ref rp is going to be removed from the _rps_set.
+            /// \param ctx_ptr shared pointer to the file sending context
+            /// \param secs_since_file_mod last modification time stamp (in seconds since Epoch) of the current hints file
+            /// \param fname name of the hints file the hints were read from
+            /// \return future that resolves when next hints may be sent
+            future<> send_hints(lw_shared_ptr<send_one_file_ctx> ctx_ptr, gc_clock::duration secs_since_file_mod, const sstring& fname);
+
+            /// \brief Restore the mutations of a replay batch, dropping the hints which can't or shouldn't be sent,
+            /// and merge the mutations of the same partition.
             ///
             /// \param ctx_ptr shared pointer to the file sending context
-            /// \param buf buffer representing the hint
-            /// \param rp replay position of this hint in the file (see commitlog for more details on "replay position")
+            /// \param hints the hints of the replay batch
             /// \param secs_since_file_mod last modification time stamp (in seconds since Epoch) of the current hints file
-            /// \param fname name of the hints file this hint was read from
-            /// \return future that resolves when next hint may be sent
-            future<> send_one_hint(lw_shared_ptr<send_one_file_ctx> ctx_ptr, fragmented_temporary_buffer buf, db::replay_position rp, gc_clock::duration secs_since_file_mod, const sstring& fname);
+            /// \param fname name of the hints file the hints were read from
+            /// \return The mutations to send, sorted by table and partition.
+            std::vector<merged_hint> merge_hints(lw_shared_ptr<send_one_file_ctx> ctx_ptr, std::vector<hint_entry>& hints, gc_clock::duration secs_since_file_mod, const sstring& fname);
+
+            /// \brief Send the mutations of a replay batch.
+            ///
+            /// The mutations for which the original destination end point is still a replica are sent directly to it,
+            /// all together, the others are executed "from scratch" with CL=ALL.
+            ///
+            /// \param ctx_ptr shared pointer to the file sending context
+            /// \param hints mutations to send
+            /// \return Ready, never exceptional, future when all mutations were sent.
+            future<> send_merged_hints(lw_shared_ptr<send_one_file_ctx> ctx_ptr, std::vector<merged_hint> hints);
+
+            /// \brief Account for the result of sending the hints at the given replay positions.
+            void on_hints_sent(send_one_file_ctx& ctx, const std::vector<db::replay_position>& rps, future<> f) noexcept;
+
+            /// \brief Wait until the given number of mutations may be sent without exceeding
+            /// the hints_replay_max_mutations_per_second limit, or until the sender is stopped.
+            future<> throttle_replay(size_t mutations);
+
+            /// \return The number of hints read from a file before they are sent.
+            size_t replay_batch_size() const;
 
             /// \brief Send all hint from a single file and delete it after it has been successfully sent.
             /// Send all hints from the given file. If we failed to send the current segment we will pick up in the next
@@ -233,22 +276,6 @@ class manager : public service::endpoint_lifecycle_subscriber {
             /// \return
             const column_mapping& get_column_mapping(lw_shared_ptr<send_one_file_ctx> ctx_ptr, const frozen_mutation& fm, const hint_entry_reader& hr);
 
-            /// \brief Perform a single mutation send atempt.
-            ///
-            /// If the original destination end point is still a replica for the given mutation - send the mutation directly
-            /// to it, otherwise execute the mutation "from scratch" with CL=ALL.
-            ///
-            /// \param m mutation to send
-            /// \param natural_endpoints current replicas for the given mutation
-            /// \return future that resolves when the operation is complete
-            future<> do_send_one_mutation(frozen_mutation_and_schema m, const std::vector<gms::inet_address>& natural_endpoints) noexcept;
-
-            /// \brief Send one mutation out.
-            ///
-            /// \param m mutation to send
-            /// \return future that resolves when the mutation sending processing is complete.
-            future<> send_one_mutation(frozen_mutation_and_schema m);
-
             /// \brief Get the last modification time stamp for a given file.
             /// \param fname File name
             /// \return The last modification time stamp for \param fname.
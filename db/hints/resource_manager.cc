@@ -60,6 +60,16 @@ future<semaphore_units<named_semaphore::exception_factory>> resource_manager::ge
     return get_units(_send_limiter, hint_memory_budget);
 }
 
+lowres_clock::time_point resource_manager::reserve_replay_slot(size_t mutations, uint32_t max_per_second) noexcept {
+    auto now = lowres_clock::now();
+    if (!max_per_second) {
+        return now;
+    }
+    auto send_tp = std::max(now, _next_replay_tp);
+    _next_replay_tp = send_tp + std::chrono::duration_cast<lowres_clock::duration>(std::chrono::duration<double>(double(mutations) / max_per_second));
+    return send_tp;
+}
+
 const std::chrono::seconds space_watchdog::_watchdog_period = std::chrono::seconds(1);
 
 space_watchdog::space_watchdog(shard_managers_set& managers, per_device_limits_map& per_device_limits_map)
@@ -27,6 +27,7 @@
 #include <seastar/core/gate.hh>
 #include <seastar/core/memory.hh>
 #include <seastar/core/future.hh>
+#include <seastar/core/lowres_clock.hh>
 #include "seastarx.hh"
 #include <unordered_set>
 #include <gms/gossiper.hh>
@@ -118,6 +119,7 @@ class resource_manager {
     const size_t _max_send_in_flight_memory;
     const size_t _min_send_hint_budget;
     seastar::named_semaphore _send_limiter;
+    lowres_clock::time_point _next_replay_tp;
 
     space_watchdog::shard_managers_set _shard_managers;
     space_watchdog::per_device_limits_map _per_device_limits_map;
@@ -141,6 +143,13 @@ class resource_manager {
 
     future<semaphore_units<named_semaphore::exception_factory>> get_send_units_for(size_t buf_size);
 
+    /// \brief Reserve a slot for sending replayed mutations, so that the shard sends at most
+    /// \ref max_per_second replayed mutations per second.
+    /// \param mutations the number of mutations to be sent
+    /// \param max_per_second the rate limit, 0 means unlimited
+    /// \return The time point at which the mutations may be sent.
+    lowres_clock::time_point reserve_replay_slot(size_t mutations, uint32_t max_per_second) noexcept;
+
     future<> start(shared_ptr<service::storage_proxy> proxy_ptr, shared_ptr<gms::gossiper> gossiper_ptr, shared_ptr<service::storage_service> ss_ptr);
     void allow_replaying() noexcept;
     future<> stop() noexcept;
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "serializer.hh"
+#include "db/extensions.hh"
+#include "db/per_partition_rate_limit_options.hh"
+#include "schema.hh"
+
+namespace db {
+
+class per_partition_rate_limit_extension : public schema_extension {
+    per_partition_rate_limit_options _options;
+public:
+    static constexpr auto NAME = "per_partition_rate_limit";
+
+    per_partition_rate_limit_extension() = default;
+    explicit per_partition_rate_limit_extension(const std::map<sstring, sstring>& map) : _options(map) {}
+    explicit per_partition_rate_limit_extension(const bytes& b) : _options(deserialize(b)) {}
+    explicit per_partition_rate_limit_extension(const sstring& s) {
+        throw std::logic_error("Cannot create per-partition rate limit info from string");
+    }
+    bytes serialize() const override {
+        return ser::serialize_to_buffer<bytes>(_options.to_map());
+    }
+    static std::map<sstring, sstring> deserialize(const bytes_view& buffer) {
+        return ser::deserialize_from_buffer(buffer, boost::type<std::map<sstring, sstring>>());
+    }
+    const per_partition_rate_limit_options& get_options() const {
+        return _options;
+    }
+};
+
+}
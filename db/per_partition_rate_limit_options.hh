@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <map>
+#include <optional>
+#include <seastar/core/sstring.hh>
+#include "seastarx.hh"
+
+namespace db {
+
+// Per-table limits, enforced by each replica shard, of the rate at which a
+// single partition may be read or written.
+class per_partition_rate_limit_options final {
+    std::optional<uint32_t> _max_reads_per_second;
+    std::optional<uint32_t> _max_writes_per_second;
+public:
+    static constexpr auto max_reads_per_second_key = "max_reads_per_second";
+    static constexpr auto max_writes_per_second_key = "max_writes_per_second";
+
+    per_partition_rate_limit_options() = default;
+    per_partition_rate_limit_options(const std::map<sstring, sstring>& map);
+
+    std::map<sstring, sstring> to_map() const;
+
+    std::optional<uint32_t> max_reads_per_second() const { return _max_reads_per_second; }
+    std::optional<uint32_t> max_writes_per_second() const { return _max_writes_per_second; }
+
+    bool operator==(const per_partition_rate_limit_options& o) const {
+        return _max_reads_per_second == o._max_reads_per_second && _max_writes_per_second == o._max_writes_per_second;
+    }
+    bool operator!=(const per_partition_rate_limit_options& o) const {
+        return !(*this == o);
+    }
+};
+
+}
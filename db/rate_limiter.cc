@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "db/rate_limiter.hh"
+#include "db/per_partition_rate_limit_options.hh"
+#include "exceptions/exceptions.hh"
+
+namespace db {
+
+static_assert((rate_limiter::width & (rate_limiter::width - 1)) == 0, "width must be a power of two");
+
+// The finalizer of murmur3, spreads the bits of k over the whole result.
+static uint64_t mix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb93fe53b9a63ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+rate_limiter::rate_limiter(std::chrono::milliseconds window)
+    : _counters(depth * width)
+    , _window(window)
+    , _window_start(clock_type::now())
+{ }
+
+uint32_t rate_limiter::increase(op_type op, const utils::UUID& table, const dht::token& token) {
+    auto now = clock_type::now();
+    if (now - _window_start >= _window) {
+        std::fill(_counters.begin(), _counters.end(), 0);
+        _window_start = now;
+    }
+
+    auto h = mix(table.get_most_significant_bits() ^ mix(table.get_least_significant_bits()
+            ^ mix(uint64_t(dht::token_ordinal(token)) ^ uint64_t(op))));
+    std::array<uint32_t*, depth> counters;
+    uint32_t min = std::numeric_limits<uint32_t>::max();
+    for (size_t row = 0; row < depth; ++row) {
+        // Each row hashes with a different seed.
+        auto idx = mix(h + row * 0x9e3779b97f4a7c15ULL) & (width - 1);
+        counters[row] = &_counters[row * width + idx];
+        min = std::min(min, *counters[row]);
+    }
+    if (min == std::numeric_limits<uint32_t>::max()) {
+        return min;
+    }
+    for (auto c : counters) {
+        if (*c == min) {
+            ++*c;
+        }
+    }
+    return min + 1;
+}
+
+static uint32_t parse_limit(const sstring& key, const sstring& value) {
+    try {
+        size_t pos;
+        auto limit = std::stoll(value, &pos);
+        if (pos == value.size() && limit > 0 && limit <= std::numeric_limits<uint32_t>::max()) {
+            return limit;
+        }
+    } catch (const std::logic_error&) {
+        // fall through
+    }
+    throw exceptions::configuration_exception(
+            format("Invalid per_partition_rate_limit option: {} must be a positive integer, got '{}'", key, value));
+}
+
+per_partition_rate_limit_options::per_partition_rate_limit_options(const std::map<sstring, sstring>& map) {
+    for (auto& [key, value] : map) {
+        if (key == max_reads_per_second_key) {
+            _max_reads_per_second = parse_limit(key, value);
+        } else if (key == max_writes_per_second_key) {
+            _max_writes_per_second = parse_limit(key, value);
+        } else {
+            throw exceptions::configuration_exception("Invalid per_partition_rate_limit option: " + key);
+        }
+    }
+}
+
+std::map<sstring, sstring> per_partition_rate_limit_options::to_map() const {
+    std::map<sstring, sstring> map;
+    if (_max_reads_per_second) {
+        map.emplace(max_reads_per_second_key, std::to_string(*_max_reads_per_second));
+    }
+    if (_max_writes_per_second) {
+        map.emplace(max_writes_per_second_key, std::to_string(*_max_writes_per_second));
+    }
+    return map;
+}
+
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <seastar/core/lowres_clock.hh>
+
+#include "dht/token.hh"
+#include "utils/UUID.hh"
+#include "seastarx.hh"
+
+namespace db {
+
+// Shard-local, approximate count of the operations each partition received
+// in the current time window, used to enforce per-partition rate limits.
+//
+// The counts are kept in a count-min sketch: every (table, token, operation)
+// key maps to one counter in each of the rows, and its count is estimated by
+// the smallest of them. Collisions can only make an estimate too high, so the
+// memory used is fixed no matter how many partitions are accessed and a hot
+// partition is never missed; a cold one is overestimated only when many hot
+// partitions share its counters. Only the counters at the minimum are
+// increased (conservative update), which keeps the overestimation down.
+// All counters are cleared when a new window starts.
+class rate_limiter {
+public:
+    enum class op_type : uint8_t {
+        read,
+        write,
+    };
+    using clock_type = lowres_clock;
+
+    static constexpr size_t depth = 4;
+    static constexpr size_t width = 4096;
+private:
+    std::vector<uint32_t> _counters;
+    std::chrono::milliseconds _window;
+    clock_type::time_point _window_start;
+public:
+    explicit rate_limiter(std::chrono::milliseconds window = std::chrono::seconds(1));
+
+    // Accounts one operation and returns the estimated number of operations
+    // of the same type the partition received in the current window,
+    // including this one.
+    uint32_t increase(op_type op, const utils::UUID& table, const dht::token& token);
+};
+
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <boost/icl/interval_set.hpp>
+
+#include "db/repair_history.hh"
+#include "locator/token_metadata.hh"
+
+namespace db {
+
+void repair_history::record(const dht::token_range& range, gc_clock::time_point repair_time) {
+    _repaired_at += std::make_pair(locator::token_metadata::range_to_interval(range), repair_time);
+}
+
+std::optional<gc_clock::time_point> repair_history::repaired_at(const dht::token& t) const {
+    auto it = _repaired_at.find(t);
+    if (it == _repaired_at.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::optional<gc_clock::time_point> repair_history::repaired_at(const dht::token_range& range) const {
+    auto interval = locator::token_metadata::range_to_interval(range);
+    boost::icl::interval_set<dht::token> covered;
+    std::optional<gc_clock::time_point> oldest;
+    auto [begin, end] = _repaired_at.equal_range(interval);
+    for (auto it = begin; it != end; ++it) {
+        covered += it->first;
+        oldest = oldest ? std::min(*oldest, it->second) : it->second;
+    }
+    if (!boost::icl::contains(covered, interval)) {
+        return std::nullopt;
+    }
+    return oldest;
+}
+
+}
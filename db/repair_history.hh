@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <optional>
+
+#include <boost/icl/interval_map.hpp>
+
+#include "dht/i_partitioner.hh"
+#include "gc_clock.hh"
+
+namespace db {
+
+// Shard-local record of when each token range of a table was last repaired.
+//
+// A repair which synchronized all replicas of a range makes every tombstone
+// written before it started present on all of them, so such tombstones can
+// be purged without waiting for gc_grace_seconds. Only successful repairs of
+// all replicas are recorded; a range repaired several times keeps the latest
+// start time. The history lives in memory only, and is empty after restart.
+class repair_history {
+    using token_interval_map = boost::icl::interval_map<dht::token, gc_clock::time_point,
+            boost::icl::partial_absorber, std::less, boost::icl::inplace_max>;
+    token_interval_map _repaired_at;
+public:
+    void record(const dht::token_range& range, gc_clock::time_point repair_time);
+
+    // The start time of the last repair of the token, if any.
+    std::optional<gc_clock::time_point> repaired_at(const dht::token& t) const;
+
+    // The oldest of the last repairs over the whole range, if all of it was repaired.
+    std::optional<gc_clock::time_point> repaired_at(const dht::token_range& range) const;
+
+    bool empty() const {
+        return _repaired_at.empty();
+    }
+};
+
+}
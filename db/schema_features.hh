@@ -35,6 +35,9 @@ enum class schema_feature {
     COMPUTED_COLUMNS,
     CDC_OPTIONS,
     PER_TABLE_PARTITIONERS,
+    // When set, the reduce functions of user defined aggregates are kept
+    // in system_schema.scylla_aggregates.
+    SCYLLA_AGGREGATES,
 };
 
 using schema_features = enum_set<super_enum<schema_feature,
@@ -42,7 +45,8 @@ using schema_features = enum_set<super_enum<schema_feature,
     schema_feature::DIGEST_INSENSITIVE_TO_EXPIRY,
     schema_feature::COMPUTED_COLUMNS,
     schema_feature::CDC_OPTIONS,
-    schema_feature::PER_TABLE_PARTITIONERS
+    schema_feature::PER_TABLE_PARTITIONERS,
+    schema_feature::SCYLLA_AGGREGATES
     >>;
 
 }
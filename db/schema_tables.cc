@@ -91,6 +91,7 @@
 #include "index/target_parser.hh"
 #include "service/storage_service.hh"
 #include "lua.hh"
+#include "cql3/statements/create_aggregate_statement.hh"
 
 using namespace db::system_keyspace;
 using namespace std::chrono_literals;
@@ -166,6 +167,8 @@ struct user_types_to_drop final {
     schema_result after);
 
 static void merge_functions(distributed<service::storage_proxy>& proxy, schema_result before, schema_result after);
+static void merge_aggregates(distributed<service::storage_proxy>& proxy, schema_result before, schema_result after,
+        schema_result scylla_before, schema_result scylla_after);
 
 static future<> do_merge_schema(distributed<service::storage_proxy>&, std::vector<mutation>, bool do_flush);
 
@@ -616,6 +619,34 @@ schema_ptr aggregates() {
     return schema;
 }
 
+// The properties of user defined aggregates Cassandra doesn't have, kept out
+// of "aggregates" so that its schema stays the same as in Cassandra. Only
+// aggregates with such a property have a row here.
+schema_ptr scylla_aggregates() {
+    static thread_local auto schema = [] {
+        schema_builder builder(make_lw_shared(::schema(generate_legacy_id(NAME, SCYLLA_AGGREGATES), NAME, SCYLLA_AGGREGATES,
+        // partition key
+        {{"keyspace_name", utf8_type}},
+        // clustering key
+        {{"aggregate_name", utf8_type}, {"argument_types", list_type_impl::get_instance(utf8_type, false)}},
+        // regular columns
+        {
+         {"reduce_func", utf8_type},
+        },
+        // static columns
+        {},
+        // regular column name type
+        utf8_type,
+        // comment
+        "scylla specific properties of user defined aggregates"
+        )));
+        builder.set_gc_grace_seconds(schema_gc_grace);
+        builder.with_version(generate_schema_version(builder.uuid()));
+        return builder.build();
+    }();
+    return schema;
+}
+
 }
 
 #if 0
@@ -849,19 +880,66 @@ static utils::UUID table_id_from_mutations(const schema_mutations& sm) {
     return table_row.get_nonnull<utils::UUID>("id");
 }
 
+// Maps names of keyspaces touched by a schema change to the names of their
+// tables and views it may affect, or to std::nullopt if it may affect all of them.
+using affected_tables = std::map<sstring, std::optional<std::set<sstring>>>;
+
+static bool is_table_scoped(const schema& s) {
+    // The partition key of all schema tables is the keyspace name, and the
+    // first clustering column of the ones describing tables and views is
+    // the table or view name.
+    return s.cf_name() != KEYSPACES && s.cf_name() != TYPES && s.cf_name() != FUNCTIONS && s.cf_name() != AGGREGATES;
+}
+
+static affected_tables get_affected_tables(const std::vector<mutation>& mutations) {
+    affected_tables result;
+    for (auto&& m : mutations) {
+        const schema& s = *m.schema();
+        auto keyspace_name = value_cast<sstring>(utf8_type->deserialize(m.key().get_component(s, 0)));
+        auto& tables = result.try_emplace(std::move(keyspace_name), std::set<sstring>()).first->second;
+        if (!tables || !is_table_scoped(s)) {
+            continue;
+        }
+        auto& p = m.partition();
+        if (p.partition_tombstone() || !p.row_tombstones().empty()) {
+            tables = std::nullopt;
+            continue;
+        }
+        for (auto&& row : p.clustered_rows()) {
+            auto table_name = value_cast<sstring>(utf8_type->deserialize(row.key().get_component(s, 0)));
+            tables->insert(std::move(table_name));
+        }
+    }
+    return result;
+}
+
 // Call inside a seastar thread
 static
 std::map<utils::UUID, schema_mutations>
-read_tables_for_keyspaces(distributed<service::storage_proxy>& proxy, const std::set<sstring>& keyspace_names, schema_ptr s)
+read_tables_for_keyspaces(distributed<service::storage_proxy>& proxy, const affected_tables& affected, schema_ptr s)
 {
     std::map<utils::UUID, schema_mutations> result;
-    for (auto&& keyspace_name : keyspace_names) {
-        for (auto&& table_name : read_table_names_of_keyspace(proxy, keyspace_name, s).get0()) {
-            auto qn = qualified_name(keyspace_name, table_name);
-            auto muts = read_table_mutations(proxy, qn, s).get0();
-            auto id = table_id_from_mutations(muts);
-            result.emplace(std::move(id), std::move(muts));
+    for (auto&& [keyspace_name, tables] : affected) {
+        std::vector<sstring> table_names;
+        if (tables) {
+            if (tables->empty()) {
+                continue;
+            }
+            auto all = read_table_names_of_keyspace(proxy, keyspace_name, s).get0();
+            std::copy_if(all.begin(), all.end(), std::back_inserter(table_names), [&tables = *tables] (const sstring& name) {
+                return tables.count(name);
+            });
+        } else {
+            table_names = read_table_names_of_keyspace(proxy, keyspace_name, s).get0();
         }
+        parallel_for_each(table_names, [&, &keyspace_name = keyspace_name] (const sstring& table_name) {
+            return do_with(qualified_name(keyspace_name, table_name), [&] (const qualified_name& qn) {
+                return read_table_mutations(proxy, qn, s).then([&result] (schema_mutations muts) {
+                    auto id = table_id_from_mutations(muts);
+                    result.emplace(std::move(id), std::move(muts));
+                });
+            });
+        }).get();
     }
     return result;
 }
@@ -905,9 +983,11 @@ static future<> do_merge_schema(distributed<service::storage_proxy>& proxy, std:
    return seastar::async([&proxy, mutations = std::move(mutations), do_flush] () mutable {
        slogger.trace("do_merge_schema: {}", mutations);
        schema_ptr s = keyspaces();
-       // compare before/after schemas of the affected keyspaces only
+       // compare before/after schemas of the affected keyspaces only,
+       // and of the affected tables when the change is confined to some
        std::set<sstring> keyspaces;
        std::set<utils::UUID> column_families;
+       auto affected = get_affected_tables(mutations);
        for (auto&& mutation : mutations) {
            keyspaces.emplace(value_cast<sstring>(utf8_type->deserialize(mutation.key().get_component(*s, 0))));
            column_families.emplace(mutation.column_family_id());
@@ -918,13 +998,12 @@ static future<> do_merge_schema(distributed<service::storage_proxy>& proxy, std:
 
        // current state of the schema
        auto&& old_keyspaces = read_schema_for_keyspaces(proxy, KEYSPACES, keyspaces).get0();
-       auto&& old_column_families = read_tables_for_keyspaces(proxy, keyspaces, tables());
+       auto&& old_column_families = read_tables_for_keyspaces(proxy, affected, tables());
        auto&& old_types = read_schema_for_keyspaces(proxy, TYPES, keyspaces).get0();
-       auto&& old_views = read_tables_for_keyspaces(proxy, keyspaces, views());
+       auto&& old_views = read_tables_for_keyspaces(proxy, affected, views());
        auto old_functions = read_schema_for_keyspaces(proxy, FUNCTIONS, keyspaces).get0();
-#if 0 // not in 2.1.8
-       /*auto& old_aggregates = */read_schema_for_keyspaces(proxy, AGGREGATES, keyspaces).get0();
-#endif
+       auto old_aggregates = read_schema_for_keyspaces(proxy, AGGREGATES, keyspaces).get0();
+       auto old_scylla_aggregates = read_schema_for_keyspaces(proxy, SCYLLA_AGGREGATES, keyspaces).get0();
 
        proxy.local().mutate_locally(std::move(mutations)).get0();
 
@@ -939,13 +1018,12 @@ static future<> do_merge_schema(distributed<service::storage_proxy>& proxy, std:
 
        // with new data applied
        auto&& new_keyspaces = read_schema_for_keyspaces(proxy, KEYSPACES, keyspaces).get0();
-       auto&& new_column_families = read_tables_for_keyspaces(proxy, keyspaces, tables());
+       auto&& new_column_families = read_tables_for_keyspaces(proxy, affected, tables());
        auto&& new_types = read_schema_for_keyspaces(proxy, TYPES, keyspaces).get0();
-       auto&& new_views = read_tables_for_keyspaces(proxy, keyspaces, views());
+       auto&& new_views = read_tables_for_keyspaces(proxy, affected, views());
        auto new_functions = read_schema_for_keyspaces(proxy, FUNCTIONS, keyspaces).get0();
-#if 0 // not in 2.1.8
-       /*auto& new_aggregates = */read_schema_for_keyspaces(proxy, AGGREGATES, keyspaces).get0();
-#endif
+       auto new_aggregates = read_schema_for_keyspaces(proxy, AGGREGATES, keyspaces).get0();
+       auto new_scylla_aggregates = read_schema_for_keyspaces(proxy, SCYLLA_AGGREGATES, keyspaces).get0();
 
        std::set<sstring> keyspaces_to_drop = merge_keyspaces(proxy, std::move(old_keyspaces), std::move(new_keyspaces)).get0();
        auto types_to_drop = merge_types(proxy, std::move(old_types), std::move(new_types));
@@ -953,9 +1031,8 @@ static future<> do_merge_schema(distributed<service::storage_proxy>& proxy, std:
             std::move(old_column_families), std::move(new_column_families),
             std::move(old_views), std::move(new_views));
        merge_functions(proxy, std::move(old_functions), std::move(new_functions));
-#if 0
-       mergeAggregates(oldAggregates, newAggregates);
-#endif
+       merge_aggregates(proxy, std::move(old_aggregates), std::move(new_aggregates),
+            std::move(old_scylla_aggregates), std::move(new_scylla_aggregates));
        types_to_drop.drop();
 
        proxy.local().get_db().invoke_on_all([keyspaces_to_drop = std::move(keyspaces_to_drop)] (database& db) {
@@ -1294,61 +1371,6 @@ static std::vector<data_type> read_arg_types(const query::result_set_row& row, c
     return arg_types;
 }
 
-#if 0
-    // see the comments for mergeKeyspaces()
-    private static void mergeAggregates(Map<DecoratedKey, ColumnFamily> before, Map<DecoratedKey, ColumnFamily> after)
-    {
-        List<UDAggregate> created = new ArrayList<>();
-        List<UDAggregate> altered = new ArrayList<>();
-        List<UDAggregate> dropped = new ArrayList<>();
-
-        MapDifference<DecoratedKey, ColumnFamily> diff = Maps.difference(before, after);
-
-        // New keyspace with functions
-        for (Map.Entry<DecoratedKey, ColumnFamily> entry : diff.entriesOnlyOnRight().entrySet())
-            if (entry.getValue().hasColumns())
-                created.addAll(createAggregatesFromAggregatesPartition(new Row(entry.getKey(), entry.getValue())).values());
-
-        for (Map.Entry<DecoratedKey, MapDifference.ValueDifference<ColumnFamily>> entry : diff.entriesDiffering().entrySet())
-        {
-            ColumnFamily pre = entry.getValue().leftValue();
-            ColumnFamily post = entry.getValue().rightValue();
-
-            if (pre.hasColumns() && post.hasColumns())
-            {
-                MapDifference<ByteBuffer, UDAggregate> delta =
-                    Maps.difference(createAggregatesFromAggregatesPartition(new Row(entry.getKey(), pre)),
-                                    createAggregatesFromAggregatesPartition(new Row(entry.getKey(), post)));
-
-                dropped.addAll(delta.entriesOnlyOnLeft().values());
-                created.addAll(delta.entriesOnlyOnRight().values());
-                Iterables.addAll(altered, Iterables.transform(delta.entriesDiffering().values(), new Function<MapDifference.ValueDifference<UDAggregate>, UDAggregate>()
-                {
-                    public UDAggregate apply(MapDifference.ValueDifference<UDAggregate> pair)
-                    {
-                        return pair.rightValue();
-                    }
-                }));
-            }
-            else if (pre.hasColumns())
-            {
-                dropped.addAll(createAggregatesFromAggregatesPartition(new Row(entry.getKey(), pre)).values());
-            }
-            else if (post.hasColumns())
-            {
-                created.addAll(createAggregatesFromAggregatesPartition(new Row(entry.getKey(), post)).values());
-            }
-        }
-
-        for (UDAggregate udf : created)
-            Schema.instance.addAggregate(udf);
-        for (UDAggregate udf : altered)
-            Schema.instance.updateAggregate(udf);
-        for (UDAggregate udf : dropped)
-            Schema.instance.dropAggregate(udf);
-    }
-#endif
-
 static shared_ptr<cql3::functions::user_function> create_func(database& db, const query::result_set_row& row) {
     cql3::functions::function_name name{
             row.get_nonnull<sstring>("keyspace_name"), row.get_nonnull<sstring>("function_name")};
@@ -1374,16 +1396,19 @@ static shared_ptr<cql3::functions::user_function> create_func(database& db, cons
 }
 
 static void merge_functions(distributed<service::storage_proxy>& proxy, schema_result before, schema_result after,
-        std::function<shared_ptr<cql3::functions::function>(database& db, const query::result_set_row& row)> create) {
+        std::function<shared_ptr<cql3::functions::function>(database& db, const query::result_set_row& row)> create,
+        const char* name_column = "function_name") {
     auto diff = diff_rows(proxy, before, after);
 
-    proxy.local().get_db().invoke_on_all([&diff, create] (database& db) {
+    proxy.local().get_db().invoke_on_all([&diff, create, name_column] (database& db) {
         for (const auto& val : diff.created) {
             cql3::functions::functions::add_function(create(db, *val));
         }
         for (const auto& val : diff.dropped) {
-            auto func = create(db, *val);
-            cql3::functions::functions::remove_function(func->name(), func->arg_types());
+            // Don't recreate the dropped function, the functions an
+            // aggregate refers to may be gone already.
+            cql3::functions::function_name name{val->get_nonnull<sstring>("keyspace_name"), val->get_nonnull<sstring>(name_column)};
+            cql3::functions::functions::remove_function(name, read_arg_types(*val, name.keyspace));
         }
         for (const auto& val : diff.altered) {
             cql3::functions::functions::replace_function(create(db, *val));
@@ -1395,6 +1420,98 @@ static void merge_functions(distributed<service::storage_proxy>& proxy, schema_r
     return merge_functions(proxy, before, after, create_func);
 }
 
+static shared_ptr<cql3::functions::user_function> find_aggregate_function(const sstring& keyspace, const sstring& name,
+        const std::vector<data_type>& arg_types) {
+    cql3::functions::function_name fname{keyspace, name};
+    auto func = dynamic_pointer_cast<cql3::functions::user_function>(cql3::functions::functions::find(fname, arg_types));
+    if (!func) {
+        throw std::runtime_error(format("Function {}({}) used by an aggregate doesn't exist", fname, arg_types));
+    }
+    return func;
+}
+
+// The reduce functions of the aggregates in scylla_aggregates rows, by the
+// keyspace, name and argument types of the aggregate.
+using reduce_funcs_map = std::map<std::tuple<sstring, sstring, std::vector<sstring>>, sstring>;
+
+static reduce_funcs_map::key_type aggregate_key(const query::result_set_row& row) {
+    return {row.get_nonnull<sstring>("keyspace_name"), row.get_nonnull<sstring>("aggregate_name"),
+            get_list<sstring>(row, "argument_types")};
+}
+
+static void add_reduce_funcs(reduce_funcs_map& reduce_funcs, const query::result_set& rows) {
+    for (const auto& row : rows.rows()) {
+        if (auto reduce_func = row.get<sstring>("reduce_func")) {
+            reduce_funcs.emplace(aggregate_key(row), std::move(*reduce_func));
+        }
+    }
+}
+
+static shared_ptr<cql3::functions::user_aggregate> create_aggregate(database& db, const query::result_set_row& row,
+        const reduce_funcs_map& reduce_funcs) {
+    cql3::functions::function_name name{
+            row.get_nonnull<sstring>("keyspace_name"), row.get_nonnull<sstring>("aggregate_name")};
+    auto arg_types = read_arg_types(row, name.keyspace);
+    data_type state_type = db::cql_type_parser::parse(name.keyspace, row.get_nonnull<sstring>("state_type"));
+
+    std::vector<data_type> sfunc_arg_types{state_type};
+    sfunc_arg_types.insert(sfunc_arg_types.end(), arg_types.begin(), arg_types.end());
+    auto sfunc = find_aggregate_function(name.keyspace, row.get_nonnull<sstring>("state_func"), sfunc_arg_types);
+    shared_ptr<cql3::functions::user_function> reducefunc;
+    auto reduce_func = reduce_funcs.find(aggregate_key(row));
+    if (reduce_func != reduce_funcs.end()) {
+        reducefunc = find_aggregate_function(name.keyspace, reduce_func->second, {state_type, state_type});
+    }
+    shared_ptr<cql3::functions::user_function> finalfunc;
+    if (auto final_func = row.get<sstring>("final_func")) {
+        finalfunc = find_aggregate_function(name.keyspace, *final_func, {state_type});
+    }
+
+    bytes_opt initcond;
+    auto initcond_cql = row.get<sstring>("initcond");
+    if (initcond_cql) {
+        auto ival = cql3::util::do_with_parser(*initcond_cql, std::mem_fn(&cql3_parser::CqlParser::term));
+        initcond = cql3::statements::create_aggregate_statement::prepare_initcond(db, name.keyspace, *ival, state_type);
+    }
+
+    return ::make_shared<cql3::functions::user_aggregate>(std::move(name), std::move(initcond), std::move(initcond_cql),
+            std::move(sfunc), std::move(reducefunc), std::move(finalfunc));
+}
+
+static void merge_aggregates(distributed<service::storage_proxy>& proxy, schema_result before, schema_result after,
+        schema_result scylla_before, schema_result scylla_after) {
+    reduce_funcs_map reduce_funcs;
+    for (auto& p : scylla_after) {
+        add_reduce_funcs(reduce_funcs, *p.second);
+    }
+    auto create = [&reduce_funcs] (database& db, const query::result_set_row& row) {
+        return create_aggregate(db, row, reduce_funcs);
+    };
+    merge_functions(proxy, before, after, create, "aggregate_name");
+
+    // An aggregate whose reduce function alone changed has identical rows in
+    // "aggregates", so rebuild it here.
+    auto scylla_diff = diff_rows(proxy, scylla_before, scylla_after);
+    std::set<reduce_funcs_map::key_type> changed;
+    for (auto rows : {&scylla_diff.created, &scylla_diff.altered, &scylla_diff.dropped}) {
+        for (auto row : *rows) {
+            changed.insert(aggregate_key(*row));
+        }
+    }
+    if (changed.empty()) {
+        return;
+    }
+    proxy.local().get_db().invoke_on_all([&after, &changed, &create] (database& db) {
+        for (auto& p : after) {
+            for (const auto& row : p.second->rows()) {
+                if (changed.count(aggregate_key(row))) {
+                    cql3::functions::functions::replace_function(create(db, row));
+                }
+            }
+        }
+    }).get();
+}
+
 template<typename... Args>
 void set_cell_or_clustered(mutation& m, const clustering_key & ckey, Args && ...args) {
     m.set_clustered_cell(ckey, std::forward<Args>(args)...);
@@ -1555,6 +1672,17 @@ std::vector<shared_ptr<cql3::functions::user_function>> create_functions_from_sc
     return ret;
 }
 
+std::vector<shared_ptr<cql3::functions::user_aggregate>> create_aggregates_from_schema_partition(
+        database& db, lw_shared_ptr<query::result_set> result, lw_shared_ptr<query::result_set> scylla_result) {
+    reduce_funcs_map reduce_funcs;
+    add_reduce_funcs(reduce_funcs, *scylla_result);
+    std::vector<shared_ptr<cql3::functions::user_aggregate>> ret;
+    for (const auto& row : result->rows()) {
+        ret.emplace_back(create_aggregate(db, row, reduce_funcs));
+    }
+    return ret;
+}
+
 /*
  * User type metadata serialization/deserialization
  */
@@ -1684,6 +1812,51 @@ std::vector<mutation> make_drop_function_mutations(shared_ptr<cql3::functions::u
     return make_drop_function_mutations(functions(), *func, timestamp);
 }
 
+/*
+ * UDA metadata serialization/deserialization.
+ */
+
+std::vector<mutation> make_create_aggregate_mutations(schema_features features, shared_ptr<cql3::functions::user_aggregate> aggregate,
+        api::timestamp_type timestamp) {
+    schema_ptr s = aggregates();
+    auto p = get_mutation(s, *aggregate);
+    mutation& m = p.first;
+    clustering_key& ckey = p.second;
+    if (aggregate->finalfunc()) {
+        m.set_clustered_cell(ckey, "final_func", aggregate->finalfunc()->name().name, timestamp);
+    }
+    if (aggregate->initcond_cql()) {
+        m.set_clustered_cell(ckey, "initcond", *aggregate->initcond_cql(), timestamp);
+    }
+    m.set_clustered_cell(ckey, "return_type", aggregate->return_type()->as_cql3_type().to_string(), timestamp);
+    m.set_clustered_cell(ckey, "state_func", aggregate->sfunc()->name().name, timestamp);
+    m.set_clustered_cell(ckey, "state_type", aggregate->state_type()->as_cql3_type().to_string(), timestamp);
+    std::vector<mutation> mutations{std::move(m)};
+
+    // Nodes without the feature don't have scylla_aggregates.
+    if (features.contains<schema_feature::SCYLLA_AGGREGATES>()) {
+        if (aggregate->reducefunc()) {
+            auto sp = get_mutation(scylla_aggregates(), *aggregate);
+            sp.first.set_clustered_cell(sp.second, "reduce_func", aggregate->reducefunc()->name().name, timestamp);
+            mutations.push_back(std::move(sp.first));
+        } else {
+            // Replacing an aggregate may drop its reduce function.
+            auto dropped = make_drop_function_mutations(scylla_aggregates(), *aggregate, timestamp);
+            std::move(dropped.begin(), dropped.end(), std::back_inserter(mutations));
+        }
+    }
+    return mutations;
+}
+
+std::vector<mutation> make_drop_aggregate_mutations(schema_features features, shared_ptr<cql3::functions::user_aggregate> aggregate, api::timestamp_type timestamp) {
+    auto mutations = make_drop_function_mutations(aggregates(), *aggregate, timestamp);
+    if (features.contains<schema_feature::SCYLLA_AGGREGATES>()) {
+        auto dropped = make_drop_function_mutations(scylla_aggregates(), *aggregate, timestamp);
+        std::move(dropped.begin(), dropped.end(), std::back_inserter(mutations));
+    }
+    return mutations;
+}
+
 /*
  * Table metadata serialization/deserialization.
  */
@@ -2897,6 +3070,9 @@ std::vector<schema_ptr> all_tables(schema_features features) {
     if (features.contains<schema_feature::COMPUTED_COLUMNS>()) {
         result.emplace_back(computed_columns());
     }
+    if (features.contains<schema_feature::SCYLLA_AGGREGATES>()) {
+        result.emplace_back(scylla_aggregates());
+    }
     return result;
 }
 
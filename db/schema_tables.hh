@@ -43,6 +43,7 @@
 #include "service/storage_proxy.hh"
 #include "mutation.hh"
 #include "cql3/functions/user_function.hh"
+#include "cql3/functions/user_aggregate.hh"
 #include "schema_fwd.hh"
 #include "schema_features.hh"
 #include "hashing.hh"
@@ -109,6 +110,7 @@ static constexpr auto AGGREGATES = "aggregates";
 static constexpr auto INDEXES = "indexes";
 static constexpr auto VIEW_VIRTUAL_COLUMNS = "view_virtual_columns"; // Scylla specific
 static constexpr auto COMPUTED_COLUMNS = "computed_columns"; // Scylla specific
+static constexpr auto SCYLLA_AGGREGATES = "scylla_aggregates"; // Scylla specific
 
 schema_ptr columns();
 schema_ptr view_virtual_columns();
@@ -118,6 +120,7 @@ schema_ptr tables();
 schema_ptr scylla_tables(schema_features features = schema_features::full());
 schema_ptr views();
 schema_ptr computed_columns();
+schema_ptr scylla_aggregates();
 
 }
 
@@ -188,6 +191,14 @@ std::vector<mutation> make_create_function_mutations(shared_ptr<cql3::functions:
 
 std::vector<mutation> make_drop_function_mutations(shared_ptr<cql3::functions::user_function> func, api::timestamp_type timestamp);
 
+// scylla_result holds the scylla_aggregates partition of the same keyspace.
+std::vector<shared_ptr<cql3::functions::user_aggregate>> create_aggregates_from_schema_partition(database& db, lw_shared_ptr<query::result_set> result,
+        lw_shared_ptr<query::result_set> scylla_result);
+
+std::vector<mutation> make_create_aggregate_mutations(schema_features features, shared_ptr<cql3::functions::user_aggregate> aggregate, api::timestamp_type timestamp);
+
+std::vector<mutation> make_drop_aggregate_mutations(schema_features features, shared_ptr<cql3::functions::user_aggregate> aggregate, api::timestamp_type timestamp);
+
 std::vector<mutation> make_drop_type_mutations(lw_shared_ptr<keyspace_metadata> keyspace, user_type type, api::timestamp_type timestamp);
 
 void add_type_to_schema_mutation(user_type type, api::timestamp_type timestamp, std::vector<mutation>& mutations);
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+
+#include <seastar/core/fstream.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/thread.hh>
+
+#include "db/snapshot_backup.hh"
+#include "database.hh"
+#include "disk-error-handler.hh"
+#include "lister.hh"
+#include "service/priority_manager.hh"
+#include "log.hh"
+
+namespace db {
+
+static logging::logger bklogger("snapshot_backup");
+
+future<> bandwidth_limiter::consume(size_t bytes) {
+    auto rate = _rate();
+    if (!rate) {
+        return make_ready_future<>();
+    }
+    auto now = clock::now();
+    _next = std::max(_next, now) + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(double(bytes) / rate));
+    if (_next <= now) {
+        return make_ready_future<>();
+    }
+    return sleep(_next - now);
+}
+
+// Copies src to dst through dst.tmp, waiting for the limiter before writing each buffer.
+// Must be called in a thread.
+static uint64_t copy_file(const fs::path& src, const fs::path& dst, bandwidth_limiter& limiter) {
+    auto tmp = dst.native() + ".tmp";
+    auto in = io_check([&src] { return open_file_dma(src.native(), open_flags::ro); }).get0();
+    auto out = io_check([&tmp] { return open_file_dma(tmp, open_flags::wo | open_flags::create | open_flags::truncate); }).get0();
+    file_input_stream_options in_opts;
+    in_opts.io_priority_class = service::get_local_streaming_read_priority();
+    file_output_stream_options out_opts;
+    out_opts.io_priority_class = service::get_local_streaming_write_priority();
+    auto is = make_file_input_stream(std::move(in), 0, in_opts);
+    auto os = make_file_output_stream(std::move(out), out_opts);
+    uint64_t copied = 0;
+    std::exception_ptr ex;
+    try {
+        for (auto buf = is.read().get0(); !buf.empty(); buf = is.read().get0()) {
+            limiter.consume(buf.size()).get();
+            os.write(buf.get(), buf.size()).get();
+            copied += buf.size();
+        }
+        os.flush().get();
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    is.close().get();
+    os.close().get();
+    if (ex) {
+        std::rethrow_exception(std::move(ex));
+    }
+    io_check([&tmp, &dst] { return rename_file(tmp, dst.native()); }).get();
+    return copied;
+}
+
+static bool is_snapshot_metadata(const sstring& name) {
+    return name == "manifest.json" || name == "schema.cql";
+}
+
+future<uint64_t> backup_snapshot(table& t, sstring tag, sstring destination, bandwidth_limiter& limiter) {
+    return seastar::async([&t, tag = std::move(tag), destination = std::move(destination), &limiter] {
+        auto& s = *t.schema();
+        auto table_dir = fs::path(destination.c_str()) / fs::path(s.ks_name().c_str()) / fs::path(t.dir().c_str()).filename();
+        auto manifest_dir = table_dir / "snapshots" / fs::path(tag.c_str());
+
+        // The snapshot links to the sstables of a table are spread over the
+        // same directories as the sstables, see table::snapshot().
+        std::vector<sstring> dirs = t.get_config().all_datadirs;
+        dirs.push_back(t.cold_dir());
+
+        std::vector<fs::path> metadata;
+        uint64_t copied = 0;
+        uint64_t skipped = 0;
+        bool found = false;
+        for (auto& dir : dirs) {
+            auto snapshot_dir = fs::path(dir.c_str()) / "snapshots" / fs::path(tag.c_str());
+            if (!io_check([&snapshot_dir] { return file_exists(snapshot_dir.native()); }).get0()) {
+                continue;
+            }
+            if (!found) {
+                io_check([&table_dir] { return recursive_touch_directory(table_dir.native()); }).get();
+                found = true;
+            }
+            std::vector<sstring> names;
+            lister::scan_dir(snapshot_dir, { directory_entry_type::regular }, [&names] (fs::path, directory_entry de) {
+                names.push_back(de.name);
+                return make_ready_future<>();
+            }).get();
+            for (auto& name : names) {
+                auto src = snapshot_dir / fs::path(name.c_str());
+                if (is_snapshot_metadata(name)) {
+                    metadata.push_back(std::move(src));
+                    continue;
+                }
+                auto dst = table_dir / fs::path(name.c_str());
+                auto size = io_check(file_size, src.native()).get0();
+                if (io_check([&dst] { return file_exists(dst.native()); }).get0()
+                        && io_check(file_size, dst.native()).get0() == size) {
+                    ++skipped;
+                    continue;
+                }
+                copied += copy_file(src, dst, limiter);
+            }
+        }
+        if (!found) {
+            bklogger.debug("Table {}.{} has no snapshot {}", s.ks_name(), s.cf_name(), tag);
+            return copied;
+        }
+        io_check(sync_directory, table_dir.native()).get();
+
+        io_check([&manifest_dir] { return recursive_touch_directory(manifest_dir.native()); }).get();
+        // Write the manifest last, it marks the backup as complete.
+        std::stable_partition(metadata.begin(), metadata.end(), [] (const fs::path& p) { return p.filename() != "manifest.json"; });
+        for (auto& src : metadata) {
+            copied += copy_file(src, manifest_dir / src.filename(), limiter);
+        }
+        io_check(sync_directory, manifest_dir.native()).get();
+
+        bklogger.info("Backed up snapshot {} of {}.{} to {}: copied {} bytes, skipped {} files which were already there",
+                tag, s.ks_name(), s.cf_name(), table_dir.native(), copied, skipped);
+        return copied;
+    });
+}
+
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+#include <seastar/core/future.hh>
+#include <seastar/core/sstring.hh>
+
+#include "seastarx.hh"
+#include "database_fwd.hh"
+
+namespace db {
+
+// Spreads the consumption of bytes over time so that it doesn't exceed a
+// rate. The rate, in bytes per second, is queried on each consume(), so it
+// can follow a live-updatable option; zero means unlimited.
+class bandwidth_limiter {
+    using clock = std::chrono::steady_clock;
+    std::function<uint64_t()> _rate;
+    clock::time_point _next = clock::now();
+public:
+    explicit bandwidth_limiter(std::function<uint64_t()> rate) : _rate(std::move(rate)) { }
+
+    // Resolves when the bytes may be consumed without exceeding the rate.
+    future<> consume(size_t bytes);
+};
+
+// Copies the snapshot `tag` of a table to destination/<keyspace>/<table directory>,
+// which is usually a mount point of the backup store.
+//
+// The sstable files of all snapshots of the table share that directory. Since
+// sstable file names are never reused within a table, files which are already
+// there with the right size were uploaded by an earlier backup and are
+// skipped, so only the sstables which are new since then are copied. Files are
+// copied under a temporary name and renamed when complete. The manifest and
+// the schema of the snapshot go to its snapshots/<tag> subdirectory and are
+// copied last, so a backup with a manifest is complete.
+//
+// All copying is paced by the limiter. Returns the number of bytes copied.
+future<uint64_t> backup_snapshot(table&, sstring tag, sstring destination, bandwidth_limiter&);
+
+}
@@ -75,6 +75,8 @@
 #include "message/messaging_service.hh"
 #include "mutation_query.hh"
 #include "db/size_estimates_virtual_reader.hh"
+#include "db/token_shards_virtual_reader.hh"
+#include "db/top_partitions_virtual_reader.hh"
 #include "db/timeout_clock.hh"
 #include "sstables/sstables.hh"
 #include "db/view/build_progress_virtual_reader.hh"
@@ -82,8 +84,12 @@
 #include "index/built_indexes_virtual_reader.hh"
 
 #include "idl/frozen_mutation.dist.hh"
+#include "idl/token.dist.hh"
+#include "idl/range.dist.hh"
 #include "serializer_impl.hh"
 #include "idl/frozen_mutation.dist.impl.hh"
+#include "idl/token.dist.impl.hh"
+#include "idl/range.dist.impl.hh"
 #include <boost/algorithm/cxx11/any_of.hpp>
 
 using days = std::chrono::duration<int, std::ratio<24 * 3600>>;
@@ -535,6 +541,41 @@ static schema_ptr large_cells() {
     return large_cells;
 }
 
+static schema_ptr token_shards() {
+    static thread_local auto token_shards = [] {
+        auto id = generate_legacy_id(NAME, TOKEN_SHARDS);
+        return schema_builder(NAME, TOKEN_SHARDS, id)
+                .with_column("shard", int32_type, column_kind::partition_key)
+                .with_column("range_start", long_type, column_kind::clustering_key)
+                .with_column("range_end", long_type)
+                .set_comment("primary token ranges of the local node, split by the shard owning them")
+                .set_gc_grace_seconds(0)
+                .with_version(generate_schema_version(id))
+                .build();
+    }();
+    return token_shards;
+}
+
+static schema_ptr top_partitions() {
+    static thread_local auto top_partitions = [] {
+        auto id = generate_legacy_id(NAME, TOP_PARTITIONS);
+        return schema_builder(NAME, TOP_PARTITIONS, id)
+                .with_column("keyspace_name", utf8_type, column_kind::partition_key)
+                .with_column("table_name", utf8_type, column_kind::partition_key)
+                .with_column("ranking", utf8_type, column_kind::clustering_key)
+                .with_column("rank", int32_type, column_kind::clustering_key)
+                .with_column("partition_key", utf8_type)
+                .with_column("shard", int32_type)
+                .with_column("count", long_type)
+                .with_column("error", long_type)
+                .set_comment("hottest partitions of each table, sampled continuously")
+                .set_gc_grace_seconds(0)
+                .with_version(generate_schema_version(id))
+                .build();
+    }();
+    return top_partitions;
+}
+
 /*static*/ schema_ptr scylla_local() {
     static thread_local auto scylla_local = [] {
         schema_builder builder(make_lw_shared(schema(generate_legacy_id(NAME, SCYLLA_LOCAL), NAME, SCYLLA_LOCAL,
@@ -1847,10 +1888,10 @@ std::vector<schema_ptr> all_tables() {
                     peers(), peer_events(), range_xfers(),
                     compactions_in_progress(), compaction_history(),
                     sstable_activity(), clients(), size_estimates(), large_partitions(), large_rows(), large_cells(),
-                    scylla_local(), v3::views_builds_in_progress(), v3::built_views(),
+                    scylla_local(), token_shards(), top_partitions(), v3::views_builds_in_progress(), v3::built_views(),
                     v3::scylla_views_builds_in_progress(),
                     v3::truncated(),
-                    v3::cdc_local(),
+                    v3::cdc_local(), v3::available_ranges(),
     });
     // legacy schema
     r.insert(r.end(), {
@@ -1867,6 +1908,12 @@ static void maybe_add_virtual_reader(schema_ptr s, database& db) {
     if (s.get() == size_estimates().get()) {
         db.find_column_family(s).set_virtual_reader(mutation_source(db::size_estimates::virtual_reader()));
     }
+    if (s.get() == token_shards().get()) {
+        db.find_column_family(s).set_virtual_reader(mutation_source(db::token_shards::virtual_reader(db)));
+    }
+    if (s.get() == top_partitions().get()) {
+        db.find_column_family(s).set_virtual_reader(mutation_source(db::top_partitions::virtual_reader()));
+    }
     if (s.get() == v3::views_builds_in_progress().get()) {
         db.find_column_family(s).set_virtual_reader(mutation_source(db::view::build_progress_virtual_reader(db)));
     }
@@ -2141,6 +2188,36 @@ future<> remove_view_build_progress(sstring ks_name, sstring view_name) {
             int32_t(this_shard_id())).discard_result();
 }
 
+future<std::unordered_set<dht::token_range>> get_available_ranges(sstring ks_name) {
+    sstring req = format("SELECT ranges FROM system.{} WHERE keyspace_name = ?", v3::AVAILABLE_RANGES);
+    return execute_cql(req, std::move(ks_name)).then([] (::shared_ptr<cql3::untyped_result_set> cql_result) {
+        std::unordered_set<dht::token_range> ranges;
+        if (!cql_result->empty() && cql_result->one().has("ranges")) {
+            auto blob = cql_result->one().get_blob("ranges");
+            auto cdef = v3::available_ranges()->get_column_definition("ranges");
+            auto deserialized = cdef->type->deserialize(blob);
+            for (auto& r : value_cast<set_type_impl::native_type>(deserialized)) {
+                ranges.insert(ser::deserialize_from_buffer(value_cast<bytes>(r), boost::type<dht::token_range>()));
+            }
+        }
+        return ranges;
+    });
+}
+
+future<> update_available_ranges(sstring ks_name, const dht::token_range_vector& ranges) {
+    sstring req = format("UPDATE system.{} SET ranges = ranges + ? WHERE keyspace_name = ?", v3::AVAILABLE_RANGES);
+    auto set_type = set_type_impl::get_instance(bytes_type, true);
+    set_type_impl::native_type rset;
+    for (auto& r : ranges) {
+        rset.push_back(data_value(ser::serialize_to_buffer<bytes>(r)));
+    }
+    return execute_cql(req, make_set_value(set_type, std::move(rset)), std::move(ks_name)).discard_result();
+}
+
+future<> remove_available_ranges(sstring ks_name) {
+    return execute_cql(format("DELETE FROM system.{} WHERE keyspace_name = ?", v3::AVAILABLE_RANGES), std::move(ks_name)).discard_result();
+}
+
 future<> mark_view_as_built(sstring ks_name, sstring view_name) {
     return execute_cql(
             format("INSERT INTO system.{} (keyspace_name, view_name) VALUES (?, ?)", v3::BUILT_VIEWS),
@@ -97,6 +97,8 @@ static constexpr auto LARGE_PARTITIONS = "large_partitions";
 static constexpr auto LARGE_ROWS = "large_rows";
 static constexpr auto LARGE_CELLS = "large_cells";
 static constexpr auto SCYLLA_LOCAL = "scylla_local";
+static constexpr auto TOKEN_SHARDS = "token_shards";
+static constexpr auto TOP_PARTITIONS = "top_partitions";
 extern const char *const CLIENTS;
 
 namespace v3 {
@@ -641,6 +643,11 @@ future<> remove_built_view(sstring ks_name, sstring view_name);
 future<std::vector<view_name>> load_built_views();
 future<std::vector<view_build_progress>> load_view_build_progress();
 
+// Ranges of a keyspace already synced by an interrupted node operation
+future<std::unordered_set<dht::token_range>> get_available_ranges(sstring ks_name);
+future<> update_available_ranges(sstring ks_name, const dht::token_range_vector& ranges);
+future<> remove_available_ranges(sstring ks_name);
+
 // Paxos related functions
 future<service::paxos::paxos_state> load_paxos_state(const partition_key& key, schema_ptr s, gc_clock::time_point now,
         db::timeout_clock::time_point timeout);
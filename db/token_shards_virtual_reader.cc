@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/range/algorithm/sort.hpp>
+
+#include "database.hh"
+#include "dht/sharder.hh"
+#include "mutation.hh"
+#include "utils/fb_utilities.hh"
+
+#include "db/token_shards_virtual_reader.hh"
+
+namespace db {
+
+namespace token_shards {
+
+std::vector<shard_range> local_shard_ranges(database& db, const dht::sharder& sharder) {
+    auto& tm = db.get_token_metadata();
+    auto tokens = tm.get_tokens(utils::fb_utilities::get_broadcast_address());
+    auto ranges = tm.get_primary_ranges_for(std::unordered_set<dht::token>(tokens.begin(), tokens.end()));
+    // Primary ranges are disjoint, so ordering them by start token is enough.
+    auto start_of = [] (const dht::token_range& r) {
+        return r.start() ? dht::token_ordinal(r.start()->value()) : std::numeric_limits<int64_t>::min();
+    };
+    boost::sort(ranges, [&start_of] (const dht::token_range& a, const dht::token_range& b) {
+        return start_of(a) < start_of(b);
+    });
+    std::vector<shard_range> result;
+    for (shard_id shard = 0; shard < sharder.shard_count(); ++shard) {
+        for (auto& r : ranges) {
+            auto range_sharder = dht::selective_token_range_sharder(sharder, r, shard);
+            while (auto sr = range_sharder.next()) {
+                result.push_back(shard_range{shard, std::move(*sr)});
+            }
+        }
+    }
+    return result;
+}
+
+// Converts the bounds of a token range to the (start, end] form used by CQL token restrictions.
+static std::pair<int64_t, int64_t> to_cql_bounds(const dht::token_range& r) {
+    constexpr auto min = std::numeric_limits<int64_t>::min();
+    constexpr auto max = std::numeric_limits<int64_t>::max();
+    int64_t start = min;
+    if (r.start() && !r.start()->value().is_minimum()) {
+        start = dht::token_ordinal(r.start()->value());
+        if (r.start()->is_inclusive() && start != min) {
+            --start;
+        }
+    }
+    int64_t end = max;
+    if (r.end() && !r.end()->value().is_maximum()) {
+        end = dht::token_ordinal(r.end()->value());
+        if (!r.end()->is_inclusive()) {
+            --end;
+        }
+    }
+    return {start, end};
+}
+
+flat_mutation_reader virtual_reader::operator()(schema_ptr schema,
+        reader_permit,
+        const dht::partition_range& range,
+        const query::partition_slice& slice,
+        const io_priority_class& pc,
+        tracing::trace_state_ptr trace_state,
+        streamed_mutation::forwarding fwd,
+        mutation_reader::forwarding fwd_mr) {
+    auto& range_end = *schema->get_column_definition("range_end");
+    auto ts = api::new_timestamp();
+    std::vector<mutation> mutations;
+    for (auto& sr : local_shard_ranges(_db, schema->get_sharder())) {
+        auto pk = partition_key::from_single_value(*schema, int32_type->decompose(int32_t(sr.shard)));
+        auto dk = dht::decorate_key(*schema, std::move(pk));
+        // Partitions of the table are distributed between shards like any other.
+        if (dht::shard_of(*schema, dk.token()) != this_shard_id()) {
+            continue;
+        }
+        if (mutations.empty() || !mutations.back().decorated_key().equal(*schema, dk)) {
+            mutations.emplace_back(schema, std::move(dk));
+        }
+        auto [start, end] = to_cql_bounds(sr.range);
+        if (start >= end) {
+            continue;
+        }
+        auto ck = clustering_key::from_single_value(*schema, long_type->decompose(start));
+        mutations.back().set_clustered_cell(ck, range_end, atomic_cell::make_live(*long_type, ts, long_type->decompose(end)));
+    }
+    boost::sort(mutations, [less = dht::decorated_key::less_comparator(schema)] (const mutation& a, const mutation& b) {
+        return less(a.decorated_key(), b.decorated_key());
+    });
+    return flat_mutation_reader_from_mutations(std::move(mutations), range, slice, fwd);
+}
+
+} // namespace token_shards
+
+} // namespace db
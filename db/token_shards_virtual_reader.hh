@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "database_fwd.hh"
+#include "dht/i_partitioner.hh"
+#include "flat_mutation_reader.hh"
+#include "mutation_reader.hh"
+#include "query-request.hh"
+#include "tracing/trace_state.hh"
+
+namespace db {
+
+namespace token_shards {
+
+struct shard_range {
+    shard_id shard;
+    dht::token_range range;
+};
+
+// Returns the primary token ranges of the local node split at shard
+// boundaries, ordered by shard and then by token.
+std::vector<shard_range> local_shard_ranges(database& db, const dht::sharder& sharder);
+
+// Reader for system.token_shards.
+//
+// Each partition belongs to a shard and lists the primary token ranges of the
+// local node the shard owns as (range_start, range_end] rows, so that a scan
+// restricted to one of them is served by a single shard.
+class virtual_reader {
+    database& _db;
+public:
+    explicit virtual_reader(database& db) : _db(db) { }
+    flat_mutation_reader operator()(schema_ptr schema,
+            reader_permit,
+            const dht::partition_range& range,
+            const query::partition_slice& slice,
+            const io_priority_class& pc,
+            tracing::trace_state_ptr trace_state,
+            streamed_mutation::forwarding fwd,
+            mutation_reader::forwarding fwd_mr);
+};
+
+} // namespace token_shards
+
+} // namespace db
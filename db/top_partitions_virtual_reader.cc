@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/range/algorithm/sort.hpp>
+#include <map>
+
+#include "database.hh"
+#include "db/data_listeners.hh"
+#include "mutation.hh"
+#include "service/storage_proxy.hh"
+
+#include "db/top_partitions_virtual_reader.hh"
+
+namespace db {
+
+namespace top_partitions {
+
+using listener = continuous_toppartitions_listener;
+
+// Merges the per-shard rankings of each table, keeping the max_rank hottest
+// partitions of each ranking.
+static std::vector<listener::table_rankings> merge(std::vector<listener::table_rankings> from_shards) {
+    std::map<std::pair<sstring, sstring>, listener::table_rankings> merged;
+    for (auto& tr : from_shards) {
+        auto [it, inserted] = merged.try_emplace({tr.ks_name, tr.cf_name});
+        auto& dst = it->second;
+        if (inserted) {
+            dst.ks_name = tr.ks_name;
+            dst.cf_name = tr.cf_name;
+        }
+        for (size_t r = 0; r < listener::ranking_count; ++r) {
+            std::move(tr.rankings[r].begin(), tr.rankings[r].end(), std::back_inserter(dst.rankings[r]));
+        }
+    }
+    std::vector<listener::table_rankings> result;
+    result.reserve(merged.size());
+    for (auto& [name, tr] : merged) {
+        for (auto& ranking : tr.rankings) {
+            boost::sort(ranking, [] (const listener::partition_count& a, const listener::partition_count& b) {
+                return a.count > b.count;
+            });
+            if (ranking.size() > max_rank) {
+                ranking.resize(max_rank);
+            }
+        }
+        result.push_back(std::move(tr));
+    }
+    return result;
+}
+
+static std::vector<mutation> make_mutations(const schema_ptr& schema, const std::vector<listener::table_rankings>& tables) {
+    auto& partition_key_col = *schema->get_column_definition("partition_key");
+    auto& shard_col = *schema->get_column_definition("shard");
+    auto& count_col = *schema->get_column_definition("count");
+    auto& error_col = *schema->get_column_definition("error");
+    auto ts = api::new_timestamp();
+    std::vector<mutation> mutations;
+    for (auto& tr : tables) {
+        auto pk = partition_key::from_exploded(*schema, {utf8_type->decompose(tr.ks_name), utf8_type->decompose(tr.cf_name)});
+        auto dk = dht::decorate_key(*schema, std::move(pk));
+        // Partitions of the table are distributed between shards like any other.
+        if (dht::shard_of(*schema, dk.token()) != this_shard_id()) {
+            continue;
+        }
+        mutation m(schema, std::move(dk));
+        for (size_t r = 0; r < listener::ranking_count; ++r) {
+            auto ranking = utf8_type->decompose(sstring(listener::to_string(listener::ranking(r))));
+            int32_t rank = 0;
+            for (auto& pc : tr.rankings[r]) {
+                auto ck = clustering_key::from_exploded(*schema, {ranking, int32_type->decompose(++rank)});
+                m.set_clustered_cell(ck, partition_key_col, atomic_cell::make_live(*utf8_type, ts, utf8_type->decompose(pc.key)));
+                m.set_clustered_cell(ck, shard_col, atomic_cell::make_live(*int32_type, ts, int32_type->decompose(int32_t(pc.shard))));
+                m.set_clustered_cell(ck, count_col, atomic_cell::make_live(*long_type, ts, long_type->decompose(int64_t(pc.count))));
+                m.set_clustered_cell(ck, error_col, atomic_cell::make_live(*long_type, ts, long_type->decompose(int64_t(pc.error))));
+            }
+        }
+        mutations.push_back(std::move(m));
+    }
+    boost::sort(mutations, [less = dht::decorated_key::less_comparator(schema)] (const mutation& a, const mutation& b) {
+        return less(a.decorated_key(), b.decorated_key());
+    });
+    return mutations;
+}
+
+class top_partitions_mutation_reader final : public flat_mutation_reader::impl {
+    const dht::partition_range* _prange;
+    const query::partition_slice& _slice;
+    streamed_mutation::forwarding _fwd;
+    flat_mutation_reader_opt _reader;
+private:
+    future<> ensure_reader() {
+        if (_reader) {
+            return make_ready_future<>();
+        }
+        return service::get_local_storage_proxy().get_db().map_reduce0([] (const database& db) {
+            return db.continuous_toppartitions().top(max_rank);
+        }, std::vector<listener::table_rankings>(), [] (std::vector<listener::table_rankings> acc, std::vector<listener::table_rankings> shard) {
+            std::move(shard.begin(), shard.end(), std::back_inserter(acc));
+            return acc;
+        }).then([this] (std::vector<listener::table_rankings> from_shards) {
+            _reader = flat_mutation_reader_from_mutations(make_mutations(_schema, merge(std::move(from_shards))), *_prange, _slice, _fwd);
+        });
+    }
+public:
+    top_partitions_mutation_reader(schema_ptr schema, const dht::partition_range& prange, const query::partition_slice& slice,
+            streamed_mutation::forwarding fwd)
+        : impl(std::move(schema))
+        , _prange(&prange)
+        , _slice(slice)
+        , _fwd(fwd)
+    { }
+
+    virtual future<> fill_buffer(db::timeout_clock::time_point timeout) override {
+        if (is_buffer_full()) {
+            return make_ready_future<>();
+        }
+        return ensure_reader().then([this, timeout] {
+            return _reader->fill_buffer(timeout).then([this] {
+                _end_of_stream = _reader->is_end_of_stream();
+                _reader->move_buffer_content_to(*this);
+            });
+        });
+    }
+    virtual void next_partition() override {
+        clear_buffer_to_next_partition();
+        if (is_buffer_empty() && _reader) {
+            _reader->next_partition();
+            _end_of_stream = _reader->is_end_of_stream() && _reader->is_buffer_empty();
+        }
+    }
+    virtual future<> fast_forward_to(const dht::partition_range& pr, db::timeout_clock::time_point timeout) override {
+        clear_buffer();
+        _end_of_stream = false;
+        _prange = &pr;
+        if (!_reader) {
+            // The reader will be created for the new range.
+            return make_ready_future<>();
+        }
+        return _reader->fast_forward_to(pr, timeout);
+    }
+    virtual future<> fast_forward_to(position_range pr, db::timeout_clock::time_point timeout) override {
+        forward_buffer_to(pr.start());
+        _end_of_stream = false;
+        return ensure_reader().then([this, pr = std::move(pr), timeout] () mutable {
+            return _reader->fast_forward_to(std::move(pr), timeout);
+        });
+    }
+    virtual size_t buffer_size() const override {
+        if (_reader) {
+            return flat_mutation_reader::impl::buffer_size() + _reader->buffer_size();
+        }
+        return flat_mutation_reader::impl::buffer_size();
+    }
+};
+
+flat_mutation_reader virtual_reader::operator()(schema_ptr schema,
+        reader_permit,
+        const dht::partition_range& range,
+        const query::partition_slice& slice,
+        const io_priority_class& pc,
+        tracing::trace_state_ptr trace_state,
+        streamed_mutation::forwarding fwd,
+        mutation_reader::forwarding fwd_mr) {
+    return make_flat_mutation_reader<top_partitions_mutation_reader>(std::move(schema), range, slice, fwd);
+}
+
+} // namespace top_partitions
+
+} // namespace db
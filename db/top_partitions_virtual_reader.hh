@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "database_fwd.hh"
+#include "dht/i_partitioner.hh"
+#include "flat_mutation_reader.hh"
+#include "mutation_reader.hh"
+#include "query-request.hh"
+#include "tracing/trace_state.hh"
+
+namespace db {
+
+namespace top_partitions {
+
+// Number of partitions listed for each ranking of each table.
+static constexpr size_t max_rank = 100;
+
+// Reader for system.top_partitions.
+//
+// Lists the hottest partitions of every table, as continuously sampled by
+// continuous_toppartitions_listener on all shards. Each partition of the
+// virtual table is a (keyspace_name, table_name) pair with one row per
+// (ranking, rank). The rankings are collected from all shards when the
+// reader is first filled.
+struct virtual_reader {
+    flat_mutation_reader operator()(schema_ptr schema,
+            reader_permit,
+            const dht::partition_range& range,
+            const query::partition_slice& slice,
+            const io_priority_class& pc,
+            tracing::trace_state_ptr trace_state,
+            streamed_mutation::forwarding fwd,
+            mutation_reader::forwarding fwd_mr);
+};
+
+} // namespace top_partitions
+
+} // namespace db
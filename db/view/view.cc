@@ -51,6 +51,7 @@
 #include <boost/range/adaptors.hpp>
 
 #include <seastar/core/future-util.hh>
+#include <seastar/util/noncopyable_function.hh>
 
 #include "database.hh"
 #include "clustering_bounds_comparator.hh"
@@ -1078,12 +1079,11 @@ future<> mutate_MV(
 {
     auto fs = std::make_unique<std::vector<future<>>>();
     fs->reserve(view_updates.size());
-    for (frozen_mutation_and_schema& mut : view_updates) {
-        auto view_token = dht::get_token(*mut.s, mut.fm.key());
-        auto& keyspace_name = mut.s->ks_name();
-        auto paired_endpoint = get_view_natural_endpoint(keyspace_name, base_token, view_token);
-        auto pending_endpoints = service::get_local_storage_service().get_token_metadata().pending_endpoints_for(view_token, keyspace_name);
-        auto maybe_account_failure = [&stats, &cf_stats, units = pending_view_updates.split(mut.fm.representation().size())] (
+    // Updates going to a remote paired endpoint only, grouped by the endpoint so that
+    // each group is sent in one batch.
+    std::unordered_map<gms::inet_address, std::vector<frozen_mutation_and_schema>> remote_updates;
+    auto make_failure_accounter = [&stats, &cf_stats] (db::timeout_semaphore_units units) {
+        return [&stats, &cf_stats, units = std::move(units)] (
                 future<>&& f,
                 gms::inet_address target,
                 bool is_local,
@@ -1100,6 +1100,12 @@ future<> mutate_MV(
                 return make_ready_future<>();
             }
         };
+    };
+    for (frozen_mutation_and_schema& mut : view_updates) {
+        auto view_token = dht::get_token(*mut.s, mut.fm.key());
+        auto& keyspace_name = mut.s->ks_name();
+        auto paired_endpoint = get_view_natural_endpoint(keyspace_name, base_token, view_token);
+        auto pending_endpoints = service::get_local_storage_service().get_token_metadata().pending_endpoints_for(view_token, keyspace_name);
         if (paired_endpoint) {
             // When paired endpoint is the local node, we can just apply
             // the mutation locally, unless there are pending endpoints, in
@@ -1114,6 +1120,12 @@ future<> mutate_MV(
             cf_stats.total_view_updates_pushed_local += is_endpoint_local;
             cf_stats.total_view_updates_pushed_remote += updates_pushed_remote;
 
+            if (!is_endpoint_local && pending_endpoints.empty()) {
+                remote_updates[*paired_endpoint].push_back(std::move(mut));
+                continue;
+            }
+
+            auto maybe_account_failure = make_failure_accounter(pending_view_updates.split(mut.fm.representation().size()));
             if (is_endpoint_local && pending_endpoints.empty()) {
                 // Note that we start here an asynchronous apply operation, and
                 // do not wait for it to complete.
@@ -1171,6 +1183,7 @@ future<> mutate_MV(
             // if HH is enabled at the coordinator, the update will either make it there before the range movement
             // finishes, or later to this node when it becomes a natural endpoint for the token. We still ensure we
             // send to any pending view endpoints though.
+            auto maybe_account_failure = make_failure_accounter(pending_view_updates.split(mut.fm.representation().size()));
             auto updates_pushed_remote = pending_endpoints.size();
             stats.view_updates_pushed_remote += updates_pushed_remote;
             cf_stats.total_view_updates_pushed_remote += updates_pushed_remote;
@@ -1196,6 +1209,37 @@ future<> mutate_MV(
             }
         }
     }
+    for (auto& batch : remote_updates) {
+        auto target = batch.first;
+        auto& updates = batch.second;
+        size_t size = 0;
+        for (auto& mut : updates) {
+            size += mut.fm.representation().size();
+        }
+        auto maybe_account_failure = make_failure_accounter(pending_view_updates.split(size));
+        auto updates_pushed_remote = updates.size();
+        vlogger.debug("Sending {} view updates to endpoint {}", updates_pushed_remote, target);
+        // The updates are sent together, so that the storage proxy can send them in a single message.
+        future<> view_update = service::get_local_storage_proxy().send_to_endpoint(
+                std::move(updates),
+                target,
+                { },
+                db::write_type::VIEW,
+                stats,
+                allow_hints).then_wrapped(
+                        [target,
+                         updates_pushed_remote,
+                         maybe_account_failure = std::move(maybe_account_failure)] (future<>&& f) mutable {
+            return maybe_account_failure(std::move(f), target, false, updates_pushed_remote);
+        });
+        if (wait_for_all) {
+            fs->push_back(std::move(view_update));
+        } else {
+            // The update is sent to background in order to preserve availability,
+            // its parallelism is limited by view_update_concurrency_semaphore
+            (void)view_update;
+        }
+    }
     auto f = seastar::when_all_succeed(fs->begin(), fs->end());
     return f.finally([fs = std::move(fs)] { });
 }
@@ -1609,6 +1653,36 @@ future<> view_builder::do_build_step() {
     });
 }
 
+// The view updates of a build step which are being propagated.
+// Called in the context of a seastar::thread.
+class view_builder::pending_flushes {
+    seastar::semaphore _sem{max_concurrent_flushes};
+    std::vector<future<>> _flushes;
+public:
+    // Starts a flush once fewer than max_concurrent_flushes are in progress.
+    void start(noncopyable_function<future<>()> flush) {
+        auto units = get_units(_sem, 1).get0();
+        _flushes.push_back(futurize_invoke(std::move(flush)).finally([units = std::move(units)] { }));
+    }
+
+    // Waits for all the flushes started so far, rethrowing the first failure.
+    void wait() {
+        auto flushes = std::exchange(_flushes, {});
+        std::exception_ptr ex;
+        for (auto& f : when_all(flushes.begin(), flushes.end()).get0()) {
+            if (f.failed()) {
+                auto e = f.get_exception();
+                if (!ex) {
+                    ex = std::move(e);
+                }
+            }
+        }
+        if (ex) {
+            std::rethrow_exception(std::move(ex));
+        }
+    }
+};
+
 // Called in the context of a seastar::thread.
 class view_builder::consumer {
 public:
@@ -1640,6 +1714,7 @@ class view_builder::consumer {
 private:
     view_builder& _builder;
     build_step& _step;
+    pending_flushes& _flushes;
     built_views _built_views;
     std::vector<view_ptr> _views_to_build;
     std::deque<mutation_fragment> _fragments;
@@ -1654,9 +1729,10 @@ class view_builder::consumer {
     // beyond our limit on mutation size (by default 32 MB).
     size_t _fragments_memory_usage = 0;
 public:
-    consumer(view_builder& builder, build_step& step)
+    consumer(view_builder& builder, build_step& step, pending_flushes& flushes)
             : _builder(builder)
             , _step(step)
+            , _flushes(flushes)
             , _built_views{step} {
         if (!step.current_key.key().is_empty(*_step.reader.schema())) {
             load_views_to_build();
@@ -1735,10 +1811,12 @@ class view_builder::consumer {
         _builder._as.check();
         if (!_fragments.empty()) {
             _fragments.push_front(partition_start(_step.current_key, tombstone()));
-            _step.base->populate_views(
-                    _views_to_build,
-                    _step.current_token(),
-                    make_flat_mutation_reader_from_fragments(_step.base->schema(), std::move(_fragments))).get();
+            _flushes.start([base = _step.base,
+                            views = _views_to_build,
+                            token = _step.current_token(),
+                            reader = make_flat_mutation_reader_from_fragments(_step.base->schema(), std::move(_fragments))] () mutable {
+                return base->populate_views(std::move(views), std::move(token), std::move(reader));
+            });
             _fragments.clear();
             _fragments_memory_usage = 0;
         }
@@ -1772,15 +1850,29 @@ class view_builder::consumer {
 
 // Called in the context of a seastar::thread.
 void view_builder::execute(build_step& step, exponential_backoff_retry r) {
-    auto consumer = compact_for_query<emit_only_live_rows::yes, view_builder::consumer>(
+    pending_flushes flushes;
+    auto consumer = activity_tagging_consumer(compact_for_query<emit_only_live_rows::yes, view_builder::consumer>(
             *step.reader.schema(),
             gc_clock::now(),
             step.pslice,
             batch_size,
             query::max_partitions,
-            view_builder::consumer{*this, step});
-    consumer.consume_new_partition(step.current_key); // Initialize the state in case we're resuming a partition
-    auto built = step.reader.consume_in_thread(std::move(consumer), db::no_timeout);
+            view_builder::consumer{*this, step, flushes}), step.base->make_activity(utils::activity_type::view_build));
+    auto built = [&] {
+        try {
+            consumer.consume_new_partition(step.current_key); // Initialize the state in case we're resuming a partition
+            return step.reader.consume_in_thread(std::move(consumer), db::no_timeout);
+        } catch (...) {
+            try {
+                flushes.wait();
+            } catch (...) {
+                // The failure of the step is reported instead.
+            }
+            throw;
+        }
+    }();
+    // The progress of the views must not be recorded before the updates are propagated.
+    flushes.wait();
 
     _as.check();
 
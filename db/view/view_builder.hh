@@ -64,7 +64,8 @@ namespace db::view {
  *
  * We aim to be resource-conscious. On a given shard, at any given moment, we consume at most
  * from one reader. We also strive for fairness, in that each build step inserts entries for
- * the views of a different base. Each build step reads and generates updates for batch_size rows.
+ * the views of a different base. Each build step reads and generates updates for batch_size rows,
+ * propagating the updates of up to max_concurrent_flushes groups of rows at the same time.
  *
  * We lack a controller, which could potentially allow us to go faster (to execute multiple steps at
  * the same time, or consume more rows per batch), and also which would apply backpressure, so we
@@ -172,6 +173,10 @@ class view_builder final : public service::migration_listener::only_view_notific
     // collected batch_memory_max bytes, we can process the rows read so far.
     static constexpr size_t batch_size = 128;
     static constexpr size_t batch_memory_max = 1024*1024;
+    // The view updates of the rows read so far are propagated while the
+    // following rows are read, up to max_concurrent_flushes batches at once.
+    // Progress is only recorded once all the batches of a step are propagated.
+    static constexpr size_t max_concurrent_flushes = 4;
 
 public:
     view_builder(database&, db::system_distributed_keyspace&, service::migration_notifier&);
@@ -208,6 +213,7 @@ class view_builder final : public service::migration_listener::only_view_notific
     future<> maybe_mark_view_as_built(view_ptr, dht::token);
 
     struct consumer;
+    class pending_flushes;
 };
 
 }
@@ -19,43 +19,82 @@
  * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/algorithm/min_element.hpp>
+#include <boost/range/numeric.hpp>
+#include <seastar/core/metrics.hh>
+#include <unordered_set>
+
 #include "view_update_generator.hh"
+#include "mutation_reader.hh"
 
 static logging::logger vug_logger("view_update_generator");
 
 namespace db::view {
 
+view_update_generator::view_update_generator(database& db) : _db(db) {
+    setup_metrics();
+}
+
+bool view_update_generator::process_staging_sstables(lw_shared_ptr<table> t, const std::vector<sstables::shared_sstable>& ssts) {
+    try {
+        schema_ptr s = t->schema();
+        std::vector<flat_mutation_reader> readers;
+        readers.reserve(ssts.size());
+        for (auto& sst : ssts) {
+            readers.push_back(sst->read_rows_flat(s, no_reader_permit()));
+        }
+        flat_mutation_reader staging_sstable_reader = make_combined_reader(s, std::move(readers));
+        auto result = staging_sstable_reader.consume_in_thread(view_updating_consumer(s, _db, ssts, _as), db::no_timeout);
+        return result == stop_iteration::no;
+    } catch (...) {
+        vug_logger.warn("Processing {} staging sstables of {}.{} failed: {}. Will retry...",
+                ssts.size(), t->schema()->ks_name(), t->schema()->cf_name(), std::current_exception());
+        return false;
+    }
+}
+
 future<> view_update_generator::start() {
     thread_attributes attr;
     attr.sched_group = _db.get_streaming_scheduling_group();
-    _started = seastar::async(std::move(attr), [this]() mutable {
+    _started = seastar::async(attr, [this, attr]() mutable {
         while (!_as.abort_requested()) {
             if (_sstables_with_tables.empty()) {
                 _pending_sstables.wait().get();
             }
-            while (!_sstables_with_tables.empty()) {
-                auto& [sst, t] = _sstables_with_tables.front();
-                try {
-                    schema_ptr s = t->schema();
-                    flat_mutation_reader staging_sstable_reader = sst->read_rows_flat(s, no_reader_permit());
-                    auto result = staging_sstable_reader.consume_in_thread(view_updating_consumer(s, _db, sst, _as), db::no_timeout);
-                    if (result == stop_iteration::yes) {
-                        break;
-                    }
-                } catch (...) {
-                    vug_logger.warn("Processing {} failed: {}. Will retry...", sst->get_filename(), std::current_exception());
-                    break;
-                }
-                try {
-                    // collect all staging sstables to move in a map, grouped by table.
-                    _sstables_to_move[t].push_back(sst);
-                } catch (...) {
-                    // Move from staging will be retried upon restart.
-                    vug_logger.warn("Moving {} from staging failed: {}. Ignoring...", sst->get_filename(), std::current_exception());
-                }
-                _registration_sem.signal();
-                _sstables_with_tables.pop_front();
+            // Process together the staging sstables queued for the same table, so that a partition
+            // present in several of them is read from the base table once and generates a single
+            // set of view updates. The sstables of different tables are processed concurrently.
+            std::unordered_map<lw_shared_ptr<table>, std::vector<sstables::shared_sstable>> batches;
+            for (auto& e : _sstables_with_tables) {
+                batches[e.t].push_back(e.sst);
             }
+            std::unordered_set<sstables::shared_sstable> processed;
+            parallel_for_each(batches, [this, attr, &processed] (auto& batch) {
+                return seastar::async(attr, [this, &batch, &processed] {
+                    auto& [t, ssts] = batch;
+                    if (!process_staging_sstables(t, ssts)) {
+                        return;
+                    }
+                    for (auto& sst : ssts) {
+                        try {
+                            // collect all staging sstables to move in a map, grouped by table.
+                            _sstables_to_move[t].push_back(sst);
+                        } catch (...) {
+                            // Move from staging will be retried upon restart.
+                            vug_logger.warn("Moving {} from staging failed: {}. Ignoring...", sst->get_filename(), std::current_exception());
+                        }
+                        processed.insert(sst);
+                    }
+                });
+            }).get();
+            // Sstables registered in the meantime stay queued.
+            auto it = std::remove_if(_sstables_with_tables.begin(), _sstables_with_tables.end(), [&processed] (const sstable_with_table& e) {
+                return processed.count(e.sst);
+            });
+            _sstables_with_tables.erase(it, _sstables_with_tables.end());
+            _processed_sstables += processed.size();
+            _registration_sem.signal(processed.size());
             // For each table, move the processed staging sstables into the table's base dir.
             for (auto it = _sstables_to_move.begin(); it != _sstables_to_move.end(); ) {
                 auto& [t, sstables] = *it;
@@ -72,6 +111,34 @@ future<> view_update_generator::start() {
     return make_ready_future<>();
 }
 
+void view_update_generator::setup_metrics() {
+    namespace sm = seastar::metrics;
+
+    _metrics.add_group("view_update_generator", {
+        sm::make_gauge("pending_registrations", sm::description("Number of staging sstables waiting for their view updates to be generated."),
+                [this] { return _sstables_with_tables.size(); }),
+
+        sm::make_gauge("pending_bytes", sm::description("Total size of the data of the staging sstables waiting for their view updates to be generated."),
+                [this] {
+                    return boost::accumulate(_sstables_with_tables | boost::adaptors::transformed([] (const sstable_with_table& e) {
+                        return e.sst->data_size();
+                    }), uint64_t(0));
+                }),
+
+        sm::make_gauge("oldest_pending_seconds", sm::description("Time for which the oldest staging sstable waiting for its view updates to be generated has been waiting."),
+                [this] {
+                    if (_sstables_with_tables.empty()) {
+                        return int64_t(0);
+                    }
+                    auto oldest = *boost::min_element(_sstables_with_tables | boost::adaptors::transformed(std::mem_fn(&sstable_with_table::registered_at)));
+                    return int64_t(std::chrono::duration_cast<std::chrono::seconds>(lowres_clock::now() - oldest).count());
+                }),
+
+        sm::make_derive("processed_sstables", _processed_sstables,
+                sm::description("Number of staging sstables whose view updates were generated.")),
+    });
+}
+
 future<> view_update_generator::stop() {
     _as.request_abort();
     _pending_sstables.signal();
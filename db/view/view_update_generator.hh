@@ -27,6 +27,8 @@
 
 #include <seastar/core/abort_source.hh>
 #include <seastar/core/condition-variable.hh>
+#include <seastar/core/lowres_clock.hh>
+#include <seastar/core/metrics_registration.hh>
 #include <seastar/core/semaphore.hh>
 
 namespace db::view {
@@ -41,18 +43,25 @@ class view_update_generator {
     struct sstable_with_table {
         sstables::shared_sstable sst;
         lw_shared_ptr<table> t;
+        lowres_clock::time_point registered_at = lowres_clock::now();
         sstable_with_table(sstables::shared_sstable sst, lw_shared_ptr<table> t) : sst(std::move(sst)), t(std::move(t)) { }
     };
     std::deque<sstable_with_table> _sstables_with_tables;
     std::unordered_map<lw_shared_ptr<table>, std::vector<sstables::shared_sstable>> _sstables_to_move;
+    uint64_t _processed_sstables = 0;
+    seastar::metrics::metric_groups _metrics;
 public:
-    view_update_generator(database& db) : _db(db) { }
+    view_update_generator(database& db);
 
     future<> start();
     future<> stop();
     future<> register_staging_sstable(sstables::shared_sstable sst, lw_shared_ptr<table> table);
 private:
     bool should_throttle() const;
+    void setup_metrics();
+    // Generates the view updates of the given staging sstables of t.
+    // Returns whether they were all processed.
+    bool process_staging_sstables(lw_shared_ptr<table> t, const std::vector<sstables::shared_sstable>& ssts);
 };
 
 }
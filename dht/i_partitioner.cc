@@ -175,6 +175,18 @@ unsigned shard_of(const schema& s, const token& t) {
     return s.get_sharder().shard_of(t);
 }
 
+std::optional<unsigned> single_shard_of(const schema& s, const partition_range& pr) {
+    if (pr.is_singular()) {
+        return shard_of(s, pr.start()->value().token());
+    }
+    auto sharder = ring_position_range_sharder(s.get_sharder(), pr);
+    auto first = sharder.next(s);
+    if (!first || sharder.next(s)) {
+        return std::nullopt;
+    }
+    return first->shard;
+}
+
 std::optional<dht::token_range>
 selective_token_range_sharder::next() {
     if (_done) {
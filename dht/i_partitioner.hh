@@ -182,6 +182,19 @@ class i_partitioner {
     virtual token get_token(const schema& s, partition_key_view key) const = 0;
     virtual token get_token(const sstables::key_view& key) const = 0;
 
+    /**
+     * @return the tokens of keys, as get_token() would compute them one by one.
+     * Partitioners may compute them faster in bulk.
+     */
+    virtual std::vector<token> get_tokens(const schema& s, const std::vector<partition_key_view>& keys) const {
+        std::vector<token> tokens;
+        tokens.reserve(keys.size());
+        for (auto&& key : keys) {
+            tokens.push_back(get_token(s, key));
+        }
+        return tokens;
+    }
+
     // FIXME: token.tokenFactory
     //virtual token.tokenFactory gettokenFactory() = 0;
 
@@ -629,6 +642,8 @@ class partition_ranges_view {
 std::ostream& operator<<(std::ostream& out, partition_ranges_view v);
 
 unsigned shard_of(const schema&, const token&);
+// Returns the shard owning all of the given range, if a single shard does.
+std::optional<unsigned> single_shard_of(const schema&, const partition_range&);
 inline decorated_key decorate_key(const schema& s, const partition_key& key) {
     return s.get_partitioner().decorate_key(s, key);
 }
@@ -640,6 +655,10 @@ inline token get_token(const schema& s, partition_key_view key) {
     return s.get_partitioner().get_token(s, key);
 }
 
+inline std::vector<token> get_tokens(const schema& s, const std::vector<partition_key_view>& keys) {
+    return s.get_partitioner().get_tokens(s, keys);
+}
+
 dht::partition_range to_partition_range(dht::token_range);
 dht::partition_range_vector to_partition_ranges(const dht::token_range_vector& ranges);
 
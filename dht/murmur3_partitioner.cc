@@ -56,6 +56,37 @@ murmur3_partitioner::get_token(const schema& s, partition_key_view key) const {
     return get_token(hash[0]);
 }
 
+std::vector<token>
+murmur3_partitioner::get_tokens(const schema& s, const std::vector<partition_key_view>& keys) const {
+    std::vector<bytes_view> legacy_keys;
+    legacy_keys.reserve(keys.size());
+    // The legacy form of a compound key has to be linearized to be hashed in
+    // bulk; that of a single-component key is the component itself.
+    std::vector<bytes> linearized;
+    if (s.partition_key_size() == 1) {
+        for (auto&& key : keys) {
+            legacy_keys.push_back(*key.begin(s));
+        }
+    } else {
+        linearized.reserve(keys.size());
+        for (auto&& key : keys) {
+            auto&& legacy = key.legacy_form(s);
+            bytes b(bytes::initialized_later(), legacy.size());
+            std::copy_n(legacy.begin(), b.size(), b.begin());
+            linearized.push_back(std::move(b));
+            legacy_keys.push_back(linearized.back());
+        }
+    }
+    std::vector<std::array<uint64_t, 2>> hashes;
+    utils::murmur_hash::hash3_x64_128(legacy_keys, 0, hashes);
+    std::vector<token> tokens;
+    tokens.reserve(hashes.size());
+    for (auto&& hash : hashes) {
+        tokens.push_back(get_token(hash[0]));
+    }
+    return tokens;
+}
+
 using registry = class_registrator<i_partitioner, murmur3_partitioner>;
 static registry registrator("org.apache.cassandra.dht.Murmur3Partitioner");
 static registry registrator_short_name("Murmur3Partitioner");
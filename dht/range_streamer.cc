@@ -61,10 +61,12 @@ range_streamer::get_range_fetch_map(const std::unordered_map<dht::token_range, s
                                     const std::unordered_set<std::unique_ptr<i_source_filter>>& source_filters,
                                     const sstring& keyspace) {
     std::unordered_map<inet_address, dht::token_range_vector> range_fetch_map_map;
+    auto& snitch = locator::i_endpoint_snitch::get_local_snitch_ptr();
     for (auto x : ranges_with_sources) {
         const dht::token_range& range_ = x.first;
         const std::vector<inet_address>& addresses = x.second;
         bool found_source = false;
+        std::optional<inet_address> chosen;
         for (auto address : addresses) {
             if (address == utils::fb_utilities::get_broadcast_address()) {
                 // If localhost is a source, we have found one, but we don't add it to the map to avoid streaming locally
@@ -85,9 +87,23 @@ range_streamer::get_range_fetch_map(const std::unordered_map<dht::token_range, s
                 continue;
             }
 
-            range_fetch_map_map[address].push_back(range_);
+            // The sources are sorted by proximity. Among those in the same
+            // data center as the closest one, prefer the one streaming the
+            // fewest ranges, so that all replicas take part.
+            if (!chosen) {
+                chosen = address;
+            } else if (snitch->get_datacenter(address) != snitch->get_datacenter(*chosen)) {
+                break;
+            } else if (_nr_ranges_per_source[address] < _nr_ranges_per_source[*chosen]) {
+                chosen = address;
+            }
+        }
+
+        if (chosen) {
+            // ensure we only stream from one other node for each range
+            range_fetch_map_map[*chosen].push_back(range_);
+            _nr_ranges_per_source[*chosen]++;
             found_source = true;
-            break; // ensure we only stream from one other node for each range
         }
 
         if (!found_source) {
@@ -371,6 +387,10 @@ size_t range_streamer::nr_ranges_to_stream() {
 }
 
 
+size_t range_streamer::max_parallel_sources(distributed<database>& db) {
+    return std::max(db.local().get_config().stream_max_parallel_sources(), uint32_t(1));
+}
+
 bool range_streamer::use_strict_consistency() {
     return service::get_local_storage_service().db().local().get_config().consistent_rangemovement();
 }
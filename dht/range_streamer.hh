@@ -109,7 +109,8 @@ class range_streamer {
         , _address(address)
         , _description(std::move(description))
         , _reason(reason)
-        , _stream_plan(_description) {
+        , _stream_plan(_description)
+        , _limiter(max_parallel_sources(db)) {
         _abort_source.check();
     }
 
@@ -146,11 +147,13 @@ class range_streamer {
      *                      here, we always exclude ourselves.
      * @return
      */
-    static std::unordered_map<inet_address, dht::token_range_vector>
+    std::unordered_map<inet_address, dht::token_range_vector>
     get_range_fetch_map(const std::unordered_map<dht::token_range, std::vector<inet_address>>& ranges_with_sources,
                         const std::unordered_set<std::unique_ptr<i_source_filter>>& source_filters,
                         const sstring& keyspace);
 
+    static size_t max_parallel_sources(distributed<database>& db);
+
 #if 0
 
     // For testing purposes
@@ -180,8 +183,11 @@ class range_streamer {
     // Number of tx and rx ranges added
     unsigned _nr_tx_added = 0;
     unsigned _nr_rx_added = 0;
+    // Number of ranges of all keyspaces assigned to each source, used to
+    // spread the ranges over the replicas owning them.
+    std::unordered_map<inet_address, size_t> _nr_ranges_per_source;
     // Limit the number of nodes to stream in parallel to reduce memory pressure with large cluster.
-    seastar::semaphore _limiter{16};
+    seastar::semaphore _limiter;
 };
 
 } // dht
@@ -166,4 +166,15 @@ inline bool operator<=(const token& t1, const token& t2) { return std::rel_ops::
 inline bool operator>=(const token& t1, const token& t2) { return std::rel_ops::operator>=(t1, t2); }
 std::ostream& operator<<(std::ostream& out, const token& t);
 
+// Maps tokens to integers so that t1 < t2 implies ordinal(t1) <= ordinal(t2).
+// The maximum token shares its ordinal with the greatest key token, so equal
+// ordinals don't imply equal tokens.
+inline int64_t token_ordinal(const token& t) noexcept {
+    switch (t._kind) {
+    case token::kind::before_all_keys: return std::numeric_limits<int64_t>::min();
+    case token::kind::after_all_keys: return std::numeric_limits<int64_t>::max();
+    default: return t._data;
+    }
+}
+
 } // namespace dht
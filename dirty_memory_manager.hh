@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <boost/intrusive/parent_from_member.hpp>
 #include <seastar/core/condition-variable.hh>
 #include <seastar/core/future.hh>
@@ -28,8 +29,10 @@
 #include <seastar/core/semaphore.hh>
 #include "database_fwd.hh"
 #include "utils/logalloc.hh"
+#include "db/timeout_clock.hh"
 
 class dirty_memory_manager;
+class memtable_list;
 
 class sstable_write_permit final {
     friend class dirty_memory_manager;
@@ -99,6 +102,7 @@ class dirty_memory_manager: public logalloc::region_group_reclaimer {
     // is mostly about dangling continuations. So that doesn't have to be a small number.
     static constexpr unsigned _max_background_work = 20;
     semaphore _background_work_flush_serializer = { _max_background_work };
+    bool _flushes_unserialized = false;
     condition_variable _should_flush;
     int64_t _dirty_bytes_released_pre_accounted = 0;
 
@@ -113,6 +117,22 @@ class dirty_memory_manager: public logalloc::region_group_reclaimer {
 
     unsigned _extraneous_flushes = 0;
 
+    // Memtable lists using this manager, for enforcing per-table quotas.
+    std::vector<memtable_list*> _memtable_lists;
+    // Fraction of the virtual dirty limit a single table may use before it
+    // is flushed and throttled ahead of others. Zero disables quotas.
+    double _table_quota_fraction = 0;
+    // Signalled when tables may have dropped below their quota.
+    condition_variable _quota_relief;
+    uint64_t _writes_throttled_by_quota = 0;
+
+    // Moving average of the time recent writes waited for dirty memory.
+    db::timeout_clock::duration _write_delay_estimate = db::timeout_clock::duration::zero();
+    uint64_t _writes_shed = 0;
+
+    memtable_list* largest_over_quota();
+    virtual void stop_reclaiming() noexcept override;
+
     seastar::metrics::metric_groups _metrics;
 public:
     void setup_collectd(sstring namestr);
@@ -189,6 +209,7 @@ class dirty_memory_manager: public logalloc::region_group_reclaimer {
         _real_region_group.update(delta);
         _virtual_region_group.update(-delta);
         _dirty_bytes_released_pre_accounted += delta;
+        _quota_relief.broadcast();
     }
 
     void pin_real_dirty_memory(int64_t delta) {
@@ -215,6 +236,17 @@ class dirty_memory_manager: public logalloc::region_group_reclaimer {
         });
     }
 
+    // Lets flushes write their data concurrently, up to the cap on background
+    // work. This is for when no more writes are coming in, e.g. when draining:
+    // nothing waits on the memory of a particular memtable, and flushing
+    // everything in parallel is faster.
+    void unserialize_flushes() {
+        if (!_flushes_unserialized) {
+            _flushes_unserialized = true;
+            _flush_serializer.signal(_max_background_work - 1);
+        }
+    }
+
     bool has_extraneous_flushes_requested() const {
         return _extraneous_flushes > 0;
     }
@@ -226,6 +258,53 @@ class dirty_memory_manager: public logalloc::region_group_reclaimer {
     void finish_extraneous_flush() {
         --_extraneous_flushes;
     }
+
+    // Per-table soft quotas
+    // ---------------------
+    // A table whose memtables hold more than the given fraction of the
+    // virtual dirty hard limit is over its quota. Under soft pressure, such
+    // tables are flushed before the one holding the largest memtable, and
+    // writes to them wait until they are back within their quota, so that
+    // a single table can't throttle writes to all the others.
+    void set_table_quota_fraction(double fraction) {
+        _table_quota_fraction = fraction;
+    }
+
+    bool over_quota(const memtable_list&) const;
+
+    // Resolves when writes to the memtable list are not held back by its quota.
+    future<> wait_for_quota(const memtable_list&, db::timeout_clock::time_point timeout);
+
+    // Deadline-aware write shedding
+    // -----------------------------
+    // A write held back by dirty memory throttling for longer than its timeout
+    // only wastes memory and CPU: the coordinator has given up on it by the
+    // time it is applied. While writes are throttled, a write whose remaining
+    // time is shorter than the recent average wait is expected to miss its
+    // deadline, and may be rejected before it queues up.
+    void record_write_delay(db::timeout_clock::duration delay) noexcept {
+        _write_delay_estimate = (_write_delay_estimate * 7 + delay) / 8;
+    }
+
+    bool write_would_miss_deadline(db::timeout_clock::time_point timeout) noexcept {
+        if (!under_pressure() && !_virtual_region_group.blocked_requests()) {
+            return false;
+        }
+        if (db::timeout_clock::now() + _write_delay_estimate <= timeout) {
+            return false;
+        }
+        ++_writes_shed;
+        return true;
+    }
+
+    void register_memtable_list(memtable_list& mtlist) {
+        _memtable_lists.push_back(&mtlist);
+    }
+
+    void unregister_memtable_list(memtable_list& mtlist) {
+        _memtable_lists.erase(std::remove(_memtable_lists.begin(), _memtable_lists.end(), &mtlist), _memtable_lists.end());
+        _quota_relief.broadcast();
+    }
 private:
     future<flush_permit> get_flush_permit(semaphore_units<>&& background_permit) {
         return get_units(_flush_serializer, 1).then([this, background_permit = std::move(background_permit)] (auto&& units) mutable {
@@ -38,6 +38,10 @@
 #include <unordered_map>
 #include <boost/range/adaptor/map.hpp>
 #include "db/view/view_update_generator.hh"
+#include "message/messaging_service.hh"
+#include "streaming/stream_mutation_fragments_cmd.hh"
+#include "frozen_mutation.hh"
+#include "utils/UUID_gen.hh"
 
 extern logging::logger dblog;
 
@@ -317,7 +321,16 @@ future<> distributed_loader::open_sstable(distributed<database>& db, sstables::e
             auto& cf = local.find_column_family(comps.ks, comps.cf);
 
             auto sst = cf.make_sstable(comps.sstdir, comps.generation, comps.version, comps.format);
-            auto f = sst->load(pc).then([sst = std::move(sst)] {
+            auto f = sst->load(pc, local.get_config().defer_sstable_filter_loading()).then([sst] {
+                return sst->load_released_owners();
+            }).then([sst] {
+                if (!sst->get_shards_for_this_sstable().empty() || !sst->has_released_owners()) {
+                    return make_ready_future<>();
+                }
+                // All owners released the sstable, but we crashed before deleting it.
+                dblog.info("Shared sstable {} was released by all its owners, deleting", sst->get_filename());
+                return sst->unlink();
+            }).then([sst = std::move(sst)] {
                 return sst->load_shared_components();
             });
             return f.then([&db, comps = std::move(comps), func = std::move(func)] (sstables::sstable_open_info info) {
@@ -331,9 +344,11 @@ future<> distributed_loader::open_sstable(distributed<database>& db, sstables::e
                     shards_interested_in_this_sstable.insert(shard_responsible_for_generation);
 
                     return invoke_shards_with_ptr(std::move(shards_interested_in_this_sstable), db, std::move(info.components),
-                            [owners = info.owners, data = info.data.dup(), index = info.index.dup(), comps, func] (database& db, auto components) {
+                            [owners = info.owners, data = info.data.dup(), index = info.index.dup(), released = info.released, comps, func] (database& db, auto components) {
                         auto& cf = db.find_column_family(comps.ks, comps.cf);
-                        return func(cf, sstables::foreign_sstable_open_info{std::move(components), owners, data, index});
+                        sstables::foreign_sstable_open_info info{std::move(components), owners, data, index};
+                        info.released = released;
+                        return func(cf, std::move(info));
                     });
                 });
             });
@@ -507,6 +522,7 @@ future<> distributed_loader::load_new_sstables(distributed<database>& db, distri
     }).then([&db, &view_update_generator, ks, cf] {
         return db.invoke_on_all([&view_update_generator, ks = std::move(ks), cfname = std::move(cf)] (database& db) {
             auto& cf = db.find_column_family(ks, cfname);
+            db.get_counter_cache().invalidate(cf.schema()->id());
             return cf.get_row_cache().invalidate([&view_update_generator, &cf] () noexcept {
                 // FIXME: this is not really noexcept, but we need to provide strong exception guarantees.
                 // atomically load all opened sstables into column family.
@@ -540,6 +556,162 @@ future<> distributed_loader::load_new_sstables(distributed<database>& db, distri
     });
 }
 
+// Sends mutation fragments to a single replica with STREAM_MUTATION_FRAGMENTS.
+class load_and_stream_sink {
+    using sink_type = rpc::sink<frozen_mutation_fragment, streaming::stream_mutation_fragments_cmd>;
+    gms::inet_address _peer;
+    sink_type _sink;
+    future<> _status_op;
+    bool _got_error_from_peer = false;
+public:
+    load_and_stream_sink(gms::inet_address peer, sink_type sink, rpc::source<int32_t> source)
+        : _peer(peer)
+        , _sink(std::move(sink))
+        , _status_op(make_ready_future<>()) {
+        _status_op = repeat([this, source] () mutable {
+            return source().then([this] (std::optional<std::tuple<int32_t>> status_opt) {
+                if (status_opt) {
+                    _got_error_from_peer = std::get<0>(*status_opt) == -1;
+                    return stop_iteration::no;
+                }
+                return stop_iteration::yes;
+            });
+        });
+    }
+    load_and_stream_sink(load_and_stream_sink&&) = delete;
+
+    future<> send(const frozen_mutation_fragment& fmf) {
+        if (_got_error_from_peer) {
+            return make_exception_future<>(std::runtime_error(format("Peer {} failed to process mutation fragments", _peer)));
+        }
+        return _sink(fmf, streaming::stream_mutation_fragments_cmd::mutation_fragment_data);
+    }
+
+    // Must be called once, with whether the sender succeeded.
+    future<> finish(bool failed) {
+        auto cmd = failed ? streaming::stream_mutation_fragments_cmd::error : streaming::stream_mutation_fragments_cmd::end_of_stream;
+        return _sink(frozen_mutation_fragment(bytes_ostream()), cmd).finally([this] {
+            return _sink.close();
+        }).finally([this] {
+            return std::move(_status_op);
+        }).then([this] {
+            if (_got_error_from_peer) {
+                throw std::runtime_error(format("Peer {} failed to process mutation fragments", _peer));
+            }
+        });
+    }
+};
+
+// Reads the given sstables of the upload directory on this shard and streams
+// every partition to its current replicas. Must be called in a seastar thread.
+static void load_and_stream_on_shard(database& db, sstring ks_name, sstring cf_name, utils::UUID plan_id, const std::vector<sstables::entry_descriptor>& descriptors) {
+    auto& cf = db.find_column_family(ks_name, cf_name);
+    auto& ks = db.find_keyspace(ks_name);
+    auto s = cf.schema();
+    auto upload_dir = cf.dir() + "/upload";
+
+    auto sstables = make_lw_shared(cf.get_compaction_strategy().make_sstable_set(s));
+    uint64_t estimated_partitions = 0;
+    for (auto& comps : descriptors) {
+        auto sst = cf.make_sstable(upload_dir, comps.generation, comps.version, comps.format,
+            [] (disk_error_signal_type&) { return error_handler_for_upload_dir(); });
+        sst->load(service::get_local_streaming_read_priority()).get();
+        if (s->is_counter() && !sst->has_scylla_component() && !db.get_config().enable_dangerous_direct_import_of_cassandra_counters()) {
+            throw std::runtime_error("Direct loading non-Scylla SSTables containing counters is not supported. Use sstableloader instead.");
+        }
+        estimated_partitions += sst->get_estimated_key_count();
+        sstables->insert(std::move(sst));
+    }
+    if (descriptors.empty()) {
+        return;
+    }
+    dblog.info("load_and_stream: streaming {} sstables of {}.{}, estimated_partitions={}", descriptors.size(), ks_name, cf_name, estimated_partitions);
+
+    auto reader = make_range_sstable_reader(s, no_reader_permit(), std::move(sstables), query::full_partition_range, s->full_slice(),
+            service::get_local_streaming_read_priority(), nullptr, streamed_mutation::forwarding::no, mutation_reader::forwarding::no);
+    std::unordered_map<gms::inet_address, std::unique_ptr<load_and_stream_sink>> sinks;
+    std::vector<load_and_stream_sink*> current_replicas;
+    uint64_t partitions = 0;
+    auto get_sink = [&] (gms::inet_address ep) {
+        auto it = sinks.find(ep);
+        if (it == sinks.end()) {
+            // Sent with the repair reason, so that the replicas generate view updates like for uploaded sstables.
+            auto [sink, source] = netw::get_local_messaging_service().make_sink_and_source_for_stream_mutation_fragments(s->version(), plan_id, s->id(),
+                    estimated_partitions, streaming::stream_reason::repair, netw::messaging_service::msg_addr{ep, 0}).get();
+            it = sinks.emplace(ep, std::make_unique<load_and_stream_sink>(ep, std::move(sink), std::move(source))).first;
+        }
+        return it->second.get();
+    };
+
+    std::exception_ptr ep;
+    try {
+        while (auto mf = reader(db::no_timeout).get0()) {
+            if (mf->is_partition_start()) {
+                ++partitions;
+                current_replicas.clear();
+                for (auto& replica : ks.get_replication_strategy().get_natural_endpoints(mf->as_partition_start().key().token())) {
+                    current_replicas.push_back(get_sink(replica));
+                }
+            }
+            auto fmf = freeze(*s, *mf);
+            parallel_for_each(current_replicas, [&fmf] (load_and_stream_sink* sink) {
+                return sink->send(fmf);
+            }).get();
+        }
+    } catch (...) {
+        ep = std::current_exception();
+    }
+    parallel_for_each(sinks, [failed = bool(ep), &ep] (auto& x) {
+        return x.second->finish(failed).handle_exception([failed, &ep] (std::exception_ptr e) {
+            if (!failed) {
+                ep = e;
+            }
+        });
+    }).get();
+    if (ep) {
+        std::rethrow_exception(ep);
+    }
+    dblog.info("load_and_stream: streamed {} partitions of {}.{} to {} nodes", partitions, ks_name, cf_name, sinks.size());
+}
+
+future<> distributed_loader::load_and_stream(distributed<database>& db, sstring ks_name, sstring cf_name) {
+    return seastar::async([&db, ks_name = std::move(ks_name), cf_name = std::move(cf_name)] {
+        auto& cf = db.local().find_column_family(ks_name, cf_name);
+        if (cf.schema()->is_view()) {
+            throw std::runtime_error("Loading Materialized View SSTables is not supported. Re-create the view instead.");
+        }
+        auto upload_dir = fs::path(cf.dir()) / "upload";
+        verify_owner_and_mode(upload_dir).get();
+        std::vector<sstables::entry_descriptor> descriptors;
+        lister::scan_dir(upload_dir, { directory_entry_type::regular }, [&descriptors] (fs::path parent_dir, directory_entry de) {
+            auto comps = sstables::entry_descriptor::make_descriptor(parent_dir.native(), de.name);
+            if (comps.component == component_type::TOC) {
+                descriptors.push_back(std::move(comps));
+            }
+            return make_ready_future<>();
+        }, &column_family::manifest_json_filter).get();
+
+        // The sstables may hold data of any token, so they're spread evenly
+        // and every shard streams the whole content of its share.
+        std::vector<std::vector<sstables::entry_descriptor>> per_shard(smp::count);
+        for (size_t i = 0; i < descriptors.size(); ++i) {
+            per_shard[i % smp::count].push_back(descriptors[i]);
+        }
+        auto plan_id = utils::UUID_gen::get_time_UUID();
+        db.invoke_on_all([&per_shard, plan_id, ks_name, cf_name] (database& db) {
+            return seastar::async([&db, descriptors = per_shard[this_shard_id()], plan_id, ks_name, cf_name] {
+                load_and_stream_on_shard(db, ks_name, cf_name, plan_id, descriptors);
+            });
+        }).get();
+
+        // Everything is with the replicas now.
+        parallel_for_each(descriptors, [] (const sstables::entry_descriptor& comps) {
+            auto toc = sstables::sstable::filename(comps.sstdir, comps.ks, comps.cf, comps.version, comps.generation, comps.format, component_type::TOC);
+            return sstables::remove_by_toc_name(std::move(toc), error_handler_for_upload_dir());
+        }).get();
+    });
+}
+
 future<sstables::entry_descriptor> distributed_loader::probe_file(distributed<database>& db, sstring sstdir, sstring fname) {
     using namespace sstables;
 
@@ -757,6 +929,7 @@ future<> distributed_loader::populate_column_family(distributed<database>& db, s
             if (exists) {
                 handle_sstables_pending_delete(pending_delete_dir).get();
             }
+            sstables::consolidate_release_logs(sstdir).get();
         }
         // Second pass, cleanup sstables with temporary TOCs and load the rest.
         do_populate_column_family(db, std::move(sstdir), std::move(ks), std::move(cf)).get();
@@ -784,6 +957,13 @@ future<> distributed_loader::populate_keyspace(distributed<database>& db, sstrin
                 dblog.info("Keyspace {}: Reading CF {} id={} version={}", ks_name, cfname, uuid, s->version());
                 return ks.make_directory_for_column_family(cfname, uuid).then([&db, sstdir, uuid, ks_name, cfname] {
                     return distributed_loader::populate_column_family(db, sstdir + "/staging", ks_name, cfname);
+                }).then([sstdir] {
+                    return file_exists(sstdir + "/cold");
+                }).then([&db, sstdir, ks_name, cfname] (bool has_cold_dir) {
+                    if (!has_cold_dir) {
+                        return make_ready_future<>();
+                    }
+                    return distributed_loader::populate_column_family(db, sstdir + "/cold", ks_name, cfname);
                 }).then([&db, sstdir, uuid, ks_name, cfname] {
                     return distributed_loader::populate_column_family(db, sstdir, ks_name, cfname);
                 }).handle_exception([ks_name, cfname, sstdir](std::exception_ptr eptr) {
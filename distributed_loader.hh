@@ -64,6 +64,10 @@ class distributed_loader {
     static future<> load_new_sstables(distributed<database>& db, distributed<db::view::view_update_generator>& view_update_generator,
             sstring ks, sstring cf, std::vector<sstables::entry_descriptor> new_tables);
     static future<std::vector<sstables::entry_descriptor>> flush_upload_dir(distributed<database>& db, distributed<db::system_distributed_keyspace>& sys_dist_ks, sstring ks_name, sstring cf_name);
+    // Streams the content of the sstables found in the upload directory of the table to
+    // the current replicas of each partition, then removes them from the upload directory.
+    // Unlike load_new_sstables(), this doesn't require the sstables to be owned by this node.
+    static future<> load_and_stream(distributed<database>& db, sstring ks_name, sstring cf_name);
     static future<sstables::entry_descriptor> probe_file(distributed<database>& db, sstring sstdir, sstring fname);
     static future<> populate_column_family(distributed<database>& db, sstring sstdir, sstring ks, sstring cf);
     static future<> populate_keyspace(distributed<database>& db, sstring datadir, sstring ks_name);
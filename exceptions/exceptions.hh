@@ -71,6 +71,7 @@ enum class exception_code : int32_t {
     // Scylla-specific codes
     // Allocated backwards from 0x1aff-0x1a01 to minimize the chance of collision with Cassandra.
     OVERFLOW_ERROR  = 0x1aff,
+    RATE_LIMIT_ERROR = 0x1afe,
 
     // 2xx: problem validating the request
     SYNTAX_ERROR    = 0x2000,
@@ -222,6 +223,14 @@ class overflow_error_exception: public cassandra_exception {
         : cassandra_exception(exception_code::OVERFLOW_ERROR, std::move(msg)) {}
 };
 
+// An operation was rejected by a replica because its partition exceeded
+// the per-partition rate limit of the table.
+class rate_limit_exception : public cassandra_exception {
+public:
+    rate_limit_exception(const sstring& ks, const sstring& cf, const char* op) noexcept
+        : cassandra_exception(exception_code::RATE_LIMIT_ERROR, prepare_message("Per-partition %s rate limit exceeded for %s.%s", op, ks, cf)) {}
+};
+
 struct overloaded_exception : public cassandra_exception {
     overloaded_exception(size_t c) noexcept :
         cassandra_exception(exception_code::OVERLOADED, prepare_message("Too many in flight hints: %lu", c)) {}
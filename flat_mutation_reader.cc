@@ -59,15 +59,62 @@ void flat_mutation_reader::impl::clear_buffer_to_next_partition() {
     _buffer_size = compute_buffer_size(*_schema, _buffer);
 }
 
-flat_mutation_reader make_reversing_reader(flat_mutation_reader& original, size_t max_memory_consumption) {
+flat_mutation_reader make_reversing_reader(flat_mutation_reader& original, size_t max_memory_consumption,
+        uint64_t max_live_rows_per_partition, gc_clock::time_point query_time) {
     class partition_reversing_mutation_reader final : public flat_mutation_reader::impl {
+        struct window_entry {
+            mutation_fragment mf;
+            bool live;
+        };
         flat_mutation_reader* _source;
         range_tombstone_list _range_tombstones;
-        std::stack<mutation_fragment> _mutation_fragments;
+        // The rows of the current partition, in source order. Only the tail
+        // holding the last _max_live_rows live rows is kept.
+        std::deque<window_entry> _mutation_fragments;
         mutation_fragment_opt _partition_end;
+        tombstone _partition_tombstone;
         size_t _stack_size = 0;
         const size_t _max_stack_size;
+        const uint64_t _max_live_rows;
+        const gc_clock::time_point _query_time;
+        uint64_t _live_rows = 0;
     private:
+        void pop_front() {
+            auto& e = _mutation_fragments.front();
+            _stack_size -= e.mf.memory_usage(*_schema);
+            _live_rows -= e.live;
+            _mutation_fragments.pop_front();
+        }
+        // Rows before the last _max_live_rows live rows are never emitted,
+        // as the consumer stops at that many live rows of the reversed
+        // partition, so they are dropped. So are the dead rows preceding
+        // the first kept live row.
+        void trim_window() {
+            while (_live_rows > _max_live_rows) {
+                pop_front();
+            }
+            if (_live_rows < _max_live_rows) {
+                return;
+            }
+            while (!_mutation_fragments.empty() && !_mutation_fragments.front().live) {
+                pop_front();
+            }
+        }
+        void push_row(mutation_fragment mf) {
+            bool live = false;
+            if (_max_live_rows != std::numeric_limits<uint64_t>::max()) {
+                auto& cr = mf.as_clustering_row();
+                auto t = _partition_tombstone;
+                t.apply(_range_tombstones.search_tombstone_covering(*_schema, cr.key()));
+                live = cr.is_live(*_schema, t, _query_time);
+            }
+            _stack_size += mf.memory_usage(*_schema);
+            _mutation_fragments.push_back(window_entry{std::move(mf), live});
+            _live_rows += live;
+            if (live) {
+                trim_window();
+            }
+        }
         stop_iteration emit_partition() {
             auto emit_range_tombstone = [&] {
                 auto it = std::prev(_range_tombstones.tombstones().end());
@@ -78,13 +125,14 @@ flat_mutation_reader make_reversing_reader(flat_mutation_reader& original, size_
             };
             position_in_partition::less_compare cmp(*_schema);
             while (!_mutation_fragments.empty() && !is_buffer_full()) {
-                auto& mf = _mutation_fragments.top();
+                auto& mf = _mutation_fragments.back().mf;
                 if (!_range_tombstones.empty() && !cmp(_range_tombstones.tombstones().rbegin()->end_position(), mf.position())) {
                     emit_range_tombstone();
                 } else {
                     _stack_size -= mf.memory_usage(*_schema);
+                    _live_rows -= _mutation_fragments.back().live;
                     push_mutation_fragment(std::move(mf));
-                    _mutation_fragments.pop();
+                    _mutation_fragments.pop_back();
                 }
             }
             while (!_range_tombstones.empty() && !is_buffer_full()) {
@@ -106,7 +154,10 @@ flat_mutation_reader make_reversing_reader(flat_mutation_reader& original, size_
             }
             while (!_source->is_buffer_empty() && !is_buffer_full()) {
                 auto mf = _source->pop_mutation_fragment();
-                if (mf.is_partition_start() || mf.is_static_row()) {
+                if (mf.is_partition_start()) {
+                    _partition_tombstone = mf.as_partition_start().partition_tombstone();
+                    push_mutation_fragment(std::move(mf));
+                } else if (mf.is_static_row()) {
                     push_mutation_fragment(std::move(mf));
                 } else if (mf.is_end_of_partition()) {
                     _partition_end = std::move(mf);
@@ -116,8 +167,7 @@ flat_mutation_reader make_reversing_reader(flat_mutation_reader& original, size_
                 } else if (mf.is_range_tombstone()) {
                     _range_tombstones.apply(*_schema, std::move(mf.as_range_tombstone()));
                 } else {
-                    _mutation_fragments.emplace(std::move(mf));
-                    _stack_size += _mutation_fragments.top().memory_usage(*_schema);
+                    push_row(std::move(mf));
                     if (_stack_size >= _max_stack_size) {
                         const partition_key* key = nullptr;
                         auto it = buffer().end();
@@ -138,11 +188,14 @@ flat_mutation_reader make_reversing_reader(flat_mutation_reader& original, size_
             return make_ready_future<stop_iteration>(is_buffer_full());
         }
     public:
-        explicit partition_reversing_mutation_reader(flat_mutation_reader& mr, size_t max_stack_size)
+        partition_reversing_mutation_reader(flat_mutation_reader& mr, size_t max_stack_size, uint64_t max_live_rows,
+                gc_clock::time_point query_time)
             : flat_mutation_reader::impl(mr.schema())
             , _source(&mr)
             , _range_tombstones(*_schema)
             , _max_stack_size(max_stack_size)
+            , _max_live_rows(max_live_rows)
+            , _query_time(query_time)
         { }
 
         virtual future<> fill_buffer(db::timeout_clock::time_point timeout) override {
@@ -163,8 +216,7 @@ flat_mutation_reader make_reversing_reader(flat_mutation_reader& original, size_
             clear_buffer_to_next_partition();
             if (is_buffer_empty() && !is_end_of_stream()) {
                 while (!_mutation_fragments.empty()) {
-                    _stack_size -= _mutation_fragments.top().memory_usage(*_schema);
-                    _mutation_fragments.pop();
+                    pop_front();
                 }
                 _range_tombstones.clear();
                 _partition_end = std::nullopt;
@@ -184,7 +236,8 @@ flat_mutation_reader make_reversing_reader(flat_mutation_reader& original, size_
         }
     };
 
-    return make_flat_mutation_reader<partition_reversing_mutation_reader>(original, max_memory_consumption);
+    return make_flat_mutation_reader<partition_reversing_mutation_reader>(original, max_memory_consumption,
+            max_live_rows_per_partition, query_time);
 }
 
 template<typename Source>
@@ -214,6 +267,52 @@ flat_mutation_reader make_delegating_reader(flat_mutation_reader& r) {
     return make_flat_mutation_reader<delegating_reader<reference_wrapper<flat_mutation_reader>>>(ref(r));
 }
 
+flat_mutation_reader make_activity_tagging_reader(flat_mutation_reader r, utils::activity a) {
+    if (!utils::stall_attribution_enabled()) {
+        return r;
+    }
+    class reader : public flat_mutation_reader::impl {
+        flat_mutation_reader _underlying;
+        utils::activity _activity;
+    public:
+        reader(flat_mutation_reader r, utils::activity a) : impl(r.schema()), _underlying(std::move(r)), _activity(a) { }
+        virtual future<> fill_buffer(db::timeout_clock::time_point timeout) override {
+            if (is_buffer_full()) {
+                return make_ready_future<>();
+            }
+            utils::activity_scope scope(_activity);
+            return _underlying.fill_buffer(timeout).then([this] {
+                _end_of_stream = _underlying.is_end_of_stream();
+                _underlying.move_buffer_content_to(*this);
+            });
+        }
+        virtual future<> fast_forward_to(position_range pr, db::timeout_clock::time_point timeout) override {
+            _end_of_stream = false;
+            forward_buffer_to(pr.start());
+            utils::activity_scope scope(_activity);
+            return _underlying.fast_forward_to(std::move(pr), timeout);
+        }
+        virtual void next_partition() override {
+            clear_buffer_to_next_partition();
+            if (is_buffer_empty()) {
+                utils::activity_scope scope(_activity);
+                _underlying.next_partition();
+            }
+            _end_of_stream = _underlying.is_end_of_stream() && _underlying.is_buffer_empty();
+        }
+        virtual future<> fast_forward_to(const dht::partition_range& pr, db::timeout_clock::time_point timeout) override {
+            _end_of_stream = false;
+            clear_buffer();
+            utils::activity_scope scope(_activity);
+            return _underlying.fast_forward_to(pr, timeout);
+        }
+        virtual size_t buffer_size() const override {
+            return flat_mutation_reader::impl::buffer_size() + _underlying.buffer_size();
+        }
+    };
+    return make_flat_mutation_reader<reader>(std::move(r), a);
+}
+
 flat_mutation_reader make_forwardable(flat_mutation_reader m) {
     class reader : public flat_mutation_reader::impl {
         flat_mutation_reader _underlying;
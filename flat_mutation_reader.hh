@@ -28,6 +28,7 @@
 #include "position_in_partition.hh"
 #include "mutation_fragment.hh"
 #include "tracing/trace_state.hh"
+#include "utils/activity.hh"
 
 #include <seastar/util/gcc6-concepts.hh>
 #include <seastar/core/thread.hh>
@@ -48,6 +49,15 @@ GCC6_CONCEPT(
     }
 )
 
+GCC6_CONCEPT(
+    template<typename Consumer>
+    concept bool FlatMutationReaderBatchConsumer() {
+        return requires(Consumer c, circular_buffer<mutation_fragment>& batch) {
+            { c(batch) } -> stop_iteration;
+        };
+    }
+)
+
 GCC6_CONCEPT(
     template<typename T>
     concept bool FlattenedConsumer() {
@@ -113,6 +123,24 @@ class flat_mutation_reader final {
         const circular_buffer<mutation_fragment>& buffer() const {
             return _buffer;
         }
+        // Appends a batch of fragments, such as a whole buffer of another
+        // reader, to the buffer. Swaps the buffers when this one is empty.
+        // Leaves fragments empty.
+        void push_mutation_fragments(circular_buffer<mutation_fragment>&& fragments) {
+            size_t size = 0;
+            for (auto& mf : fragments) {
+                size += mf.memory_usage(*_schema);
+            }
+            if (_buffer.empty()) {
+                std::swap(_buffer, fragments);
+            } else {
+                seastar::memory::on_alloc_point(); // for exception safety tests
+                _buffer.reserve(_buffer.size() + fragments.size());
+                std::move(fragments.begin(), fragments.end(), std::back_inserter(_buffer));
+                fragments.clear();
+            }
+            _buffer_size += size;
+        }
     public:
         impl(schema_ptr s) : _schema(std::move(s)) { }
         virtual ~impl() {}
@@ -160,7 +188,49 @@ class flat_mutation_reader final {
                     return fill_buffer(timeout);
                 }
 
-                _consume_done = consumer(pop_mutation_fragment()) == stop_iteration::yes;
+                // Drain the buffer without going through the loop for every
+                // fragment. The buffer is bounded, so is the time spent here.
+                // The consumer may call next_partition(), so the emptiness
+                // of the buffer is checked before every fragment.
+                do {
+                    _consume_done = consumer(pop_mutation_fragment()) == stop_iteration::yes;
+                } while (!_consume_done && !is_buffer_empty());
+
+                return make_ready_future<>();
+            });
+        }
+
+        template<typename Consumer>
+        GCC6_CONCEPT(
+            requires FlatMutationReaderBatchConsumer<Consumer>()
+        )
+        // Like consume_pausable(), but hands the consumer whole buffers of
+        // fragments at a time, so that readers transforming or forwarding the
+        // stream can work on the buffer as a whole instead of fragment by
+        // fragment.
+        // The consumer removes the fragments it takes from the front of the
+        // batch; those it leaves in the batch go back to the buffer and are
+        // the next ones in the stream.
+        // The consumer may call next_partition() on the reader only if it
+        // leaves the batch empty.
+        // Stops when consumer returns stop_iteration::yes or end of stream is reached.
+        future<> consume_batches_pausable(Consumer consumer, db::timeout_clock::time_point timeout) {
+            _consume_done = false;
+            return do_until([this] { return (is_end_of_stream() && is_buffer_empty()) || _consume_done; },
+                            [this, consumer = std::move(consumer), timeout] () mutable {
+                if (is_buffer_empty()) {
+                    return fill_buffer(timeout);
+                }
+
+                auto batch = std::exchange(_buffer, {});
+                _buffer_size = 0;
+                _consume_done = consumer(batch) == stop_iteration::yes;
+                if (!batch.empty()) {
+                    push_mutation_fragments(std::move(batch));
+                } else if (_buffer.empty()) {
+                    // Keep the capacity of the buffer for the next fill.
+                    std::swap(_buffer, batch);
+                }
 
                 return make_ready_future<>();
             });
@@ -338,6 +408,14 @@ class flat_mutation_reader final {
         return _impl->consume_pausable(std::move(consumer), timeout);
     }
 
+    template <typename Consumer>
+    GCC6_CONCEPT(
+        requires FlatMutationReaderBatchConsumer<Consumer>()
+    )
+    auto consume_batches_pausable(Consumer consumer, db::timeout_clock::time_point timeout) {
+        return _impl->consume_batches_pausable(std::move(consumer), timeout);
+    }
+
     template <typename Consumer>
     GCC6_CONCEPT(
         requires FlattenedConsumer<Consumer>()
@@ -562,8 +640,13 @@ flat_mutation_reader transform(flat_mutation_reader r, T t) {
         T _t;
         struct consumer {
             transforming_reader* _owner;
-            stop_iteration operator()(mutation_fragment&& mf) {
-                _owner->push_mutation_fragment(_owner->_t(std::move(mf)));
+            // The fragments are transformed in place and the whole batch
+            // becomes the buffer of this reader.
+            stop_iteration operator()(circular_buffer<mutation_fragment>& batch) {
+                for (auto& mf : batch) {
+                    mf = _owner->_t(std::move(mf));
+                }
+                _owner->push_mutation_fragments(std::move(batch));
                 return stop_iteration(_owner->is_buffer_full());
             }
         };
@@ -577,7 +660,7 @@ flat_mutation_reader transform(flat_mutation_reader r, T t) {
             if (_end_of_stream) {
                 return make_ready_future<>();
             }
-            return _reader.consume_pausable(consumer{this}, timeout).then([this] {
+            return _reader.consume_batches_pausable(consumer{this}, timeout).then([this] {
                 if (_reader.is_end_of_stream() && _reader.is_buffer_empty()) {
                     _end_of_stream = true;
                 }
@@ -646,6 +729,40 @@ class delegating_reader : public flat_mutation_reader::impl {
 };
 flat_mutation_reader make_delegating_reader(flat_mutation_reader&);
 
+// Runs the synchronous part of the underlying reader's work, i.e. whatever
+// it does before its first continuation is deferred, under the given
+// activity, so that reactor stalls are attributed to it. See utils/activity.hh.
+// Returns the reader as is when stall attribution is disabled.
+flat_mutation_reader make_activity_tagging_reader(flat_mutation_reader r, utils::activity a);
+
+// Wraps a flattened consumer, running each of its calls under the given activity.
+template <typename Consumer>
+class activity_tagging_consumer {
+    Consumer _consumer;
+    utils::activity _activity;
+public:
+    activity_tagging_consumer(Consumer consumer, utils::activity a)
+        : _consumer(std::move(consumer)), _activity(a) { }
+
+    void consume_new_partition(const dht::decorated_key& dk) {
+        utils::activity_scope scope(_activity);
+        _consumer.consume_new_partition(dk);
+    }
+    template <typename Fragment>
+    decltype(auto) consume(Fragment&& f) {
+        utils::activity_scope scope(_activity);
+        return _consumer.consume(std::forward<Fragment>(f));
+    }
+    decltype(auto) consume_end_of_partition() {
+        utils::activity_scope scope(_activity);
+        return _consumer.consume_end_of_partition();
+    }
+    decltype(auto) consume_end_of_stream() {
+        utils::activity_scope scope(_activity);
+        return _consumer.consume_end_of_stream();
+    }
+};
+
 flat_mutation_reader make_forwardable(flat_mutation_reader m);
 
 flat_mutation_reader make_nonforwardable(flat_mutation_reader, bool);
@@ -744,10 +861,17 @@ make_generating_reader(schema_ptr s, std::function<future<mutation_fragment_opt>
 ///     into memory, before reversing them. Since partitions can be larger than
 ///     the available memory, we need to enforce a limit on memory consumption.
 ///     If the read uses more memory then this limit, the read is aborted.
+/// \param max_live_rows_per_partition the number of live rows of a reversed
+///     partition the consumer can take at most, e.g. the row limit of a page.
+///     Only rows from the last that many live rows (as of query_time) on are
+///     kept, so reading the latest rows of a large partition needs memory for
+///     just those rows.
 ///
 /// FIXME: reversing should be done in the sstable layer, see #1413.
 flat_mutation_reader
-make_reversing_reader(flat_mutation_reader& original, size_t max_memory_consumption);
+make_reversing_reader(flat_mutation_reader& original, size_t max_memory_consumption,
+        uint64_t max_live_rows_per_partition = std::numeric_limits<uint64_t>::max(),
+        gc_clock::time_point query_time = gc_clock::time_point::min());
 
 /// Low level fragment stream validator.
 ///
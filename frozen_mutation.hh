@@ -126,5 +126,13 @@ class frozen_mutation_fragment {
     mutation_fragment unfreeze(const schema& s);
 };
 
+// Unfreezes the representation of a frozen_mutation_fragment in place, e.g.
+// one read through the view of a larger message.
+mutation_fragment unfreeze_mutation_fragment(const schema& s, utils::input_stream representation);
+
+// Unfreezes many fragments at once, computing the tokens of all their
+// partition keys in one go.
+std::vector<mutation_fragment> unfreeze(const schema& s, const std::vector<frozen_mutation_fragment>& fmfs);
+
 frozen_mutation_fragment freeze(const schema& s, const mutation_fragment& mf);
 
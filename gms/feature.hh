@@ -140,6 +140,14 @@ extern const std::string_view NONFROZEN_UDTS;
 extern const std::string_view HINTED_HANDOFF_SEPARATE_CONNECTION;
 extern const std::string_view LWT;
 extern const std::string_view PER_TABLE_PARTITIONERS;
+extern const std::string_view STREAM_SSTABLE_FILES;
+extern const std::string_view REPLICA_FILTERING;
+extern const std::string_view MUTATION_BATCHES;
+extern const std::string_view ALTERNATOR_COMPACT_ATTRIBUTES;
+extern const std::string_view ALTERNATOR_LEADER_RMW;
+extern const std::string_view INCREMENTAL_REPAIR;
+extern const std::string_view PARALLELIZED_AGGREGATION;
+extern const std::string_view GROUPED_PARTITION_READS;
 
 }
 
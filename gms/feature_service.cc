@@ -54,6 +54,14 @@ constexpr std::string_view features::NONFROZEN_UDTS = "NONFROZEN_UDTS";
 constexpr std::string_view features::HINTED_HANDOFF_SEPARATE_CONNECTION = "HINTED_HANDOFF_SEPARATE_CONNECTION";
 constexpr std::string_view features::LWT = "LWT";
 constexpr std::string_view features::PER_TABLE_PARTITIONERS = "PER_TABLE_PARTITIONERS";
+constexpr std::string_view features::STREAM_SSTABLE_FILES = "STREAM_SSTABLE_FILES";
+constexpr std::string_view features::REPLICA_FILTERING = "REPLICA_FILTERING";
+constexpr std::string_view features::MUTATION_BATCHES = "MUTATION_BATCHES";
+constexpr std::string_view features::ALTERNATOR_COMPACT_ATTRIBUTES = "ALTERNATOR_COMPACT_ATTRIBUTES";
+constexpr std::string_view features::ALTERNATOR_LEADER_RMW = "ALTERNATOR_LEADER_RMW";
+constexpr std::string_view features::INCREMENTAL_REPAIR = "INCREMENTAL_REPAIR";
+constexpr std::string_view features::PARALLELIZED_AGGREGATION = "PARALLELIZED_AGGREGATION";
+constexpr std::string_view features::GROUPED_PARTITION_READS = "GROUPED_PARTITION_READS";
 
 static logging::logger logger("features");
 
@@ -87,7 +95,15 @@ feature_service::feature_service(feature_config cfg) : _config(cfg)
         , _nonfrozen_udts(*this, features::NONFROZEN_UDTS)
         , _hinted_handoff_separate_connection(*this, features::HINTED_HANDOFF_SEPARATE_CONNECTION)
         , _lwt_feature(*this, features::LWT)
-        , _per_table_partitioners_feature(*this, features::PER_TABLE_PARTITIONERS) {
+        , _per_table_partitioners_feature(*this, features::PER_TABLE_PARTITIONERS)
+        , _stream_sstable_files_feature(*this, features::STREAM_SSTABLE_FILES)
+        , _replica_filtering_feature(*this, features::REPLICA_FILTERING)
+        , _mutation_batches_feature(*this, features::MUTATION_BATCHES)
+        , _alternator_compact_attributes_feature(*this, features::ALTERNATOR_COMPACT_ATTRIBUTES)
+        , _alternator_leader_rmw_feature(*this, features::ALTERNATOR_LEADER_RMW)
+        , _incremental_repair_feature(*this, features::INCREMENTAL_REPAIR)
+        , _parallelized_aggregation_feature(*this, features::PARALLELIZED_AGGREGATION)
+        , _grouped_partition_reads_feature(*this, features::GROUPED_PARTITION_READS) {
 }
 
 feature_config feature_config_from_db_config(db::config& cfg) {
@@ -162,6 +178,14 @@ std::set<std::string_view> feature_service::known_feature_set() {
         gms::features::UNBOUNDED_RANGE_TOMBSTONES,
         gms::features::HINTED_HANDOFF_SEPARATE_CONNECTION,
         gms::features::PER_TABLE_PARTITIONERS,
+        gms::features::STREAM_SSTABLE_FILES,
+        gms::features::REPLICA_FILTERING,
+        gms::features::MUTATION_BATCHES,
+        gms::features::ALTERNATOR_COMPACT_ATTRIBUTES,
+        gms::features::ALTERNATOR_LEADER_RMW,
+        gms::features::INCREMENTAL_REPAIR,
+        gms::features::PARALLELIZED_AGGREGATION,
+        gms::features::GROUPED_PARTITION_READS,
     };
 
     if (_config.enable_sstables_mc_format) {
@@ -221,6 +245,7 @@ db::schema_features feature_service::cluster_schema_features() const {
     f.set_if<db::schema_feature::COMPUTED_COLUMNS>(bool(_computed_columns));
     f.set_if<db::schema_feature::CDC_OPTIONS>(bool(_cdc_feature));
     f.set_if<db::schema_feature::PER_TABLE_PARTITIONERS>(bool(_per_table_partitioners_feature));
+    f.set_if<db::schema_feature::SCYLLA_AGGREGATES>(bool(_parallelized_aggregation_feature));
     return f;
 }
 
@@ -253,6 +278,14 @@ void feature_service::enable(const std::set<std::string_view>& list) {
         std::ref(_hinted_handoff_separate_connection),
         std::ref(_lwt_feature),
         std::ref(_per_table_partitioners_feature),
+        std::ref(_stream_sstable_files_feature),
+        std::ref(_replica_filtering_feature),
+        std::ref(_mutation_batches_feature),
+        std::ref(_alternator_compact_attributes_feature),
+        std::ref(_alternator_leader_rmw_feature),
+        std::ref(_incremental_repair_feature),
+        std::ref(_parallelized_aggregation_feature),
+        std::ref(_grouped_partition_reads_feature),
     })
     {
         if (list.count(f.name())) {
@@ -96,6 +96,14 @@ class feature_service final {
     gms::feature _hinted_handoff_separate_connection;
     gms::feature _lwt_feature;
     gms::feature _per_table_partitioners_feature;
+    gms::feature _stream_sstable_files_feature;
+    gms::feature _replica_filtering_feature;
+    gms::feature _mutation_batches_feature;
+    gms::feature _alternator_compact_attributes_feature;
+    gms::feature _alternator_leader_rmw_feature;
+    gms::feature _incremental_repair_feature;
+    gms::feature _parallelized_aggregation_feature;
+    gms::feature _grouped_partition_reads_feature;
 
 public:
     bool cluster_supports_range_tombstones() const {
@@ -166,6 +174,10 @@ class feature_service final {
         return _per_table_partitioners_feature;
     }
 
+    bool cluster_supports_stream_sstable_files() const {
+        return bool(_stream_sstable_files_feature);
+    }
+
     bool cluster_supports_row_level_repair() const {
         return bool(_row_level_repair_feature);
     }
@@ -204,6 +216,34 @@ class feature_service final {
     bool cluster_supports_lwt() const {
         return bool(_lwt_feature);
     }
+
+    bool cluster_supports_replica_filtering() const {
+        return bool(_replica_filtering_feature);
+    }
+
+    bool cluster_supports_mutation_batches() const {
+        return bool(_mutation_batches_feature);
+    }
+
+    bool cluster_supports_alternator_compact_attributes() const {
+        return bool(_alternator_compact_attributes_feature);
+    }
+
+    bool cluster_supports_alternator_leader_rmw() const {
+        return bool(_alternator_leader_rmw_feature);
+    }
+
+    bool cluster_supports_incremental_repair() const {
+        return bool(_incremental_repair_feature);
+    }
+
+    const feature& cluster_supports_parallelized_aggregation() const {
+        return _parallelized_aggregation_feature;
+    }
+
+    bool cluster_supports_grouped_partition_reads() const {
+        return bool(_grouped_partition_reads_feature);
+    }
 };
 
 } // namespace gms
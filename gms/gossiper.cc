@@ -61,6 +61,7 @@
 #include <chrono>
 #include "db/config.hh"
 #include <boost/range/algorithm/set_algorithm.hpp>
+#include <boost/range/irange.hpp>
 #include <boost/range/adaptors.hpp>
 
 namespace gms {
@@ -130,13 +131,15 @@ gossiper::gossiper(abort_source& as, feature_service& features, locator::token_m
         , _cfg(cfg)
         , _fd(cfg.phi_convict_threshold(),
                 std::chrono::milliseconds(cfg.fd_initial_value_ms()),
-                std::chrono::milliseconds(cfg.fd_max_interval_ms())) {
+                std::chrono::milliseconds(cfg.fd_max_interval_ms()))
+        , _liveness(make_foreign(lw_shared_ptr<const liveness_snapshot>(make_lw_shared<liveness_snapshot>()))) {
     // Gossiper's stuff below runs only on CPU0
     if (this_shard_id() != 0) {
         return;
     }
 
     _scheduled_gossip_task.set_callback([this] { run(); });
+    _direct_fd_timer.set_callback([this] { direct_fd_ping(); });
     // half of QUARATINE_DELAY, to ensure _just_removed_endpoints has enough leeway to prevent re-gossip
     fat_client_timeout = quarantine_delay() / 2;
     /* register with the Failure Detector for receiving Failure detector events */
@@ -276,13 +279,17 @@ future<> gossiper::handle_syn_msg(msg_addr from, gossip_digest_syn syn_msg) {
 future<> gossiper::do_send_ack_msg(msg_addr from, gossip_digest_syn syn_msg) {
     return futurize_invoke([this, from, syn_msg = std::move(syn_msg)] () mutable {
         auto g_digest_list = syn_msg.get_gossip_digests();
+        record_peer_view(from.addr, g_digest_list);
         do_sort(g_digest_list);
         utils::chunked_vector<gossip_digest> delta_gossip_digest_list;
         std::map<inet_address, endpoint_state> delta_ep_state_map;
         this->examine_gossiper(g_digest_list, delta_gossip_digest_list, delta_ep_state_map);
         gms::gossip_digest_ack ack_msg(std::move(delta_gossip_digest_list), std::move(delta_ep_state_map));
         logger.debug("Calling do_send_ack_msg to node {}, syn_msg={}, ack_msg={}", from, syn_msg, ack_msg);
-        return this->ms().send_gossip_digest_ack(from, std::move(ack_msg));
+        auto sent = digests_of(ack_msg.get_endpoint_state_map());
+        return this->ms().send_gossip_digest_ack(from, std::move(ack_msg)).then([this, from, sent = std::move(sent)] {
+            record_peer_view(from.addr, sent, true);
+        });
     });
 }
 
@@ -314,6 +321,10 @@ future<> gossiper::handle_ack_msg(msg_addr id, gossip_digest_ack ack_msg) {
 
     auto g_digest_list = ack_msg.get_gossip_digest_list();
     auto& ep_state_map = ack_msg.get_endpoint_state_map();
+    if (!is_in_shadow_round()) {
+        record_peer_view(id.addr, g_digest_list);
+        record_peer_view(id.addr, digests_of(ep_state_map), true);
+    }
 
     auto f = make_ready_future<>();
     if (ep_state_map.size() > 0) {
@@ -391,7 +402,10 @@ future<> gossiper::do_send_ack2_msg(msg_addr from, utils::chunked_vector<gossip_
         }
         gms::gossip_digest_ack2 ack2_msg(std::move(delta_ep_state_map));
         logger.debug("Calling do_send_ack2_msg to node {}, ack_msg_digest={}, ack2_msg={}", from, ack_msg_digest, ack2_msg);
-        return this->ms().send_gossip_digest_ack2(from, std::move(ack2_msg));
+        auto sent = digests_of(ack2_msg.get_endpoint_state_map());
+        return this->ms().send_gossip_digest_ack2(from, std::move(ack2_msg)).then([this, from, sent = std::move(sent)] {
+            record_peer_view(from.addr, sent, true);
+        });
     });
 }
 
@@ -515,7 +529,7 @@ future<> gossiper::send_gossip(gossip_digest_syn message, std::set<inet_address>
     auto id = get_msg_addr(to);
     logger.trace("Sending a GossipDigestSyn to {} ...", id);
     _gossiped_to_seed = _seeds.count(to);
-    return ms().send_gossip_digest_syn(id, std::move(message)).handle_exception([id] (auto ep) {
+    return ms().send_gossip_digest_syn(id, delta_syn_for(to, message)).handle_exception([id] (auto ep) {
         // It is normal to reach here because it is normal that a node
         // tries to send a SYN message to a peer node which is down before
         // failure_detector thinks that peer node is down.
@@ -523,6 +537,46 @@ future<> gossiper::send_gossip(gossip_digest_syn message, std::set<inet_address>
     });
 }
 
+void gossiper::record_peer_view(inet_address peer, const utils::chunked_vector<gossip_digest>& digests, bool sent) {
+    auto& view = _peer_views[peer].versions;
+    for (auto& d : digests) {
+        auto v = std::make_pair(d.get_generation(), d.get_max_version());
+        auto [it, inserted] = view.emplace(d.get_endpoint(), v);
+        // The peer may have learned of a newer version from someone else.
+        if (!inserted && (!sent || it->second < v)) {
+            it->second = v;
+        }
+    }
+}
+
+utils::chunked_vector<gossip_digest> gossiper::digests_of(const std::map<inet_address, endpoint_state>& states) {
+    utils::chunked_vector<gossip_digest> digests;
+    for (auto& [ep, state] : states) {
+        digests.emplace_back(ep, state.get_heart_beat_state().get_generation(), get_max_endpoint_state_version(state));
+    }
+    return digests;
+}
+
+gossip_digest_syn gossiper::delta_syn_for(inet_address peer, const gossip_digest_syn& message) {
+    auto& view = _peer_views[peer];
+    auto interval = std::max(_cfg.gossip_full_digest_interval(), 1u);
+    if (view.rounds++ % interval == 0 || view.versions.empty()) {
+        return message;
+    }
+    // An empty digest list asks for a shadow round, and the local node's
+    // heartbeat changes every round anyway, so it's always kept.
+    auto self = get_broadcast_address();
+    utils::chunked_vector<gossip_digest> digests;
+    for (auto& d : message.get_gossip_digests()) {
+        auto it = view.versions.find(d.get_endpoint());
+        if (d.get_endpoint() == self || it == view.versions.end()
+                || it->second != std::make_pair(d.get_generation(), d.get_max_version())) {
+            digests.push_back(d);
+        }
+    }
+    logger.trace("Sending {} of {} digests to {}", digests.size(), message.get_gossip_digests().size(), peer);
+    return gossip_digest_syn(message.cluster_id(), message.partioner(), std::move(digests));
+}
 
 void gossiper::notify_failure_detector(inet_address endpoint, const endpoint_state& remote_endpoint_state) {
     /*
@@ -574,6 +628,17 @@ future<> gossiper::apply_state_locally(std::map<inet_address, endpoint_state> ma
                 logger.trace("Ignoring gossip for {} because it is quarantined", ep);
                 return make_ready_future<>();
             }
+            // Most of the states received on a large cluster are already
+            // known, skip them before paying for a thread and the lock.
+            if (auto* es = this->get_endpoint_state_for_endpoint_ptr(ep)) {
+                const endpoint_state& remote_state = map[ep];
+                if (es->get_heart_beat_state().get_generation() == remote_state.get_heart_beat_state().get_generation()
+                        && this->get_max_endpoint_state_version(remote_state) <= this->get_max_endpoint_state_version(*es)
+                        && (es->is_alive() || this->is_dead_state(*es))) {
+                    logger.trace("Ignoring already known state of {}", ep);
+                    return make_ready_future<>();
+                }
+            }
           return seastar::with_semaphore(_apply_state_locally_semaphore, 1, [this, &ep, &map] () mutable {
             return seastar::async([this, &ep, &map] () mutable {
                 /*
@@ -652,6 +717,7 @@ void gossiper::remove_endpoint(inet_address endpoint) {
     _ack_handlers.erase(endpoint);
     quarantine_endpoint(endpoint);
     logger.debug("removing endpoint {}", endpoint);
+    maybe_publish_liveness().get();
 }
 
 // Runs inside seastar::async context
@@ -803,41 +869,11 @@ void gossiper::run() {
             }
 
             //
-            // Gossiper task runs only on CPU0:
-            //
-            //    - If endpoint_state_map or _live_endpoints have changed - duplicate
-            //      them across all other shards.
-            //    - Reschedule the gossiper only after execution on all nodes is done.
+            // Gossiper task runs only on CPU0. Liveness changes are published
+            // as they happen, this only catches the ones made elsewhere.
+            // Reschedule the gossiper only after all shards applied them.
             //
-            bool live_endpoint_changed = (_live_endpoints != _shadow_live_endpoints);
-            bool unreachable_endpoint_changed = (_unreachable_endpoints != _shadow_unreachable_endpoints);
-
-            if (live_endpoint_changed || unreachable_endpoint_changed) {
-                if (live_endpoint_changed) {
-                    _shadow_live_endpoints = _live_endpoints;
-                }
-
-                if (unreachable_endpoint_changed) {
-                    _shadow_unreachable_endpoints = _unreachable_endpoints;
-                }
-
-                _the_gossiper.invoke_on_all([this, live_endpoint_changed, unreachable_endpoint_changed, es = endpoint_state_map] (gossiper& local_gossiper) {
-                    // Don't copy gossiper(CPU0) maps into themselves!
-                    if (this_shard_id() != 0) {
-                        if (live_endpoint_changed) {
-                            local_gossiper._live_endpoints = _shadow_live_endpoints;
-                        }
-
-                        if (unreachable_endpoint_changed) {
-                            local_gossiper._unreachable_endpoints = _shadow_unreachable_endpoints;
-                        }
-
-                        for (auto&& e : es) {
-                            local_gossiper.endpoint_state_map[e.first].set_alive(e.second.is_alive());
-                        }
-                    }
-                }).get();
-            }
+            maybe_publish_liveness().get();
     }).then_wrapped([this] (auto&& f) {
         try {
             f.get();
@@ -891,7 +927,8 @@ future<> gossiper::unregister_(shared_ptr<i_endpoint_state_change_subscriber> su
 }
 
 std::set<inet_address> gossiper::get_live_members() {
-    std::set<inet_address> live_members(_live_endpoints.begin(), _live_endpoints.end());
+    auto& live = liveness().live;
+    std::set<inet_address> live_members(live.begin(), live.end());
     auto myip = get_broadcast_address();
     logger.debug("live_members before={}", live_members);
     live_members.insert(myip);
@@ -915,7 +952,7 @@ std::set<inet_address> gossiper::get_live_token_owners() {
 
 std::set<inet_address> gossiper::get_unreachable_token_owners() {
     std::set<inet_address> token_owners;
-    for (auto&& x : _unreachable_endpoints) {
+    for (auto&& x : liveness().unreachable) {
         auto& endpoint = x.first;
         if (_token_metadata.is_member(endpoint)) {
             token_owners.insert(endpoint);
@@ -926,8 +963,9 @@ std::set<inet_address> gossiper::get_unreachable_token_owners() {
 
 // Return downtime in microseconds
 int64_t gossiper::get_endpoint_downtime(inet_address ep) {
-    auto it = _unreachable_endpoints.find(ep);
-    if (it != _unreachable_endpoints.end()) {
+    auto& unreachable = liveness().unreachable;
+    auto it = unreachable.find(ep);
+    if (it != unreachable.end()) {
         auto& downtime = it->second;
         return std::chrono::duration_cast<std::chrono::microseconds>(now() - downtime).count();
     } else {
@@ -935,6 +973,77 @@ int64_t gossiper::get_endpoint_downtime(inet_address ep) {
     }
 }
 
+void gossiper::arm_direct_fd_timer() {
+    auto interval = _cfg.direct_failure_detector_ping_interval_in_ms();
+    // Checked again after a while in case the option is enabled at runtime.
+    _direct_fd_timer.arm(interval ? std::chrono::milliseconds(interval) : INTERVAL);
+}
+
+void gossiper::direct_fd_ping() {
+    if (!is_enabled()) {
+        return;
+    }
+    if (!_cfg.direct_failure_detector_ping_interval_in_ms()) {
+        _direct_fd_failures.clear();
+        arm_direct_fd_timer();
+        return;
+    }
+    auto timeout = std::chrono::milliseconds(std::max(_cfg.direct_failure_detector_ping_timeout_in_ms(), 1u));
+    auto threshold = std::max(_cfg.direct_failure_detector_convict_threshold(), 1u);
+    auto start = lowres_clock::now();
+    auto live_endpoints = boost::copy_range<std::vector<inet_address>>(_live_endpoints);
+    // Forget endpoints which are not live any more.
+    std::unordered_set<inet_address> live(live_endpoints.begin(), live_endpoints.end());
+    for (auto it = _direct_fd_failures.begin(); it != _direct_fd_failures.end();) {
+        it = live.count(it->first) ? std::next(it) : _direct_fd_failures.erase(it);
+    }
+    (void)do_with(std::move(live_endpoints), std::vector<inet_address>(), [this, timeout, threshold] (auto& endpoints, auto& unanswered) {
+        return parallel_for_each(endpoints, [this, timeout, &unanswered] (inet_address ep) {
+            return ms().send_gossip_echo(get_msg_addr(ep), timeout).then_wrapped([ep, &unanswered] (future<> f) {
+                if (f.failed()) {
+                    logger.debug("Direct ping to {} failed: {}", ep, f.get_exception());
+                    unanswered.push_back(ep);
+                }
+            });
+        }).then([this, threshold, &endpoints, &unanswered] {
+            std::unordered_set<inet_address> failed(unanswered.begin(), unanswered.end());
+            std::vector<inet_address> to_convict;
+            for (auto& ep : endpoints) {
+                if (!failed.count(ep)) {
+                    _direct_fd_failures.erase(ep);
+                } else if (++_direct_fd_failures[ep] >= threshold) {
+                    to_convict.push_back(ep);
+                }
+            }
+            return to_convict;
+        });
+    }).then([this, start, timeout] (std::vector<inet_address> to_convict) {
+        // A round taking much longer than the timeout means this node
+        // stalled, and the pings may have failed because of that.
+        if (to_convict.empty() || lowres_clock::now() - start > 2 * timeout + INTERVAL) {
+            return make_ready_future<>();
+        }
+        return with_semaphore(_callback_running, 1, [this, to_convict = std::move(to_convict)] () mutable {
+            return seastar::async([this, to_convict = std::move(to_convict)] () mutable {
+                for (auto& ep : to_convict) {
+                    if (!is_enabled()) {
+                        return;
+                    }
+                    logger.info("Convicting {}: no reply to {} direct pings in a row", ep, _direct_fd_failures[ep]);
+                    _direct_fd_failures.erase(ep);
+                    convict(ep, fd().get_phi_convict_threshold());
+                }
+            });
+        });
+    }).handle_exception([] (std::exception_ptr ep) {
+        logger.warn("Direct failure detector round failed: {}", ep);
+    }).finally([this, g = this->shared_from_this()] {
+        if (is_enabled()) {
+            arm_direct_fd_timer();
+        }
+    });
+}
+
 // Depends on
 // - on_dead callbacks
 // It is called from failure_detector
@@ -959,13 +1068,13 @@ void gossiper::convict(inet_address endpoint, double phi) {
 
 std::set<inet_address> gossiper::get_unreachable_members() {
     std::set<inet_address> ret;
-    for (auto&& x : _unreachable_endpoints) {
+    for (auto&& x : liveness().unreachable) {
         ret.insert(x.first);
     }
     return ret;
 }
 
-int gossiper::get_max_endpoint_state_version(endpoint_state state) {
+int gossiper::get_max_endpoint_state_version(const endpoint_state& state) {
     int max_version = state.get_heart_beat_state().get_heart_beat_version();
     for (auto& entry : state.get_application_state_map()) {
         auto& value = entry.second;
@@ -981,7 +1090,9 @@ void gossiper::evict_from_membership(inet_address endpoint) {
     container().invoke_on_all([endpoint] (auto& g) {
         g.endpoint_state_map.erase(endpoint);
     }).get();
+    maybe_publish_liveness().get();
     _expire_time_endpoint_map.erase(endpoint);
+    _peer_views.erase(endpoint);
     fd().remove(endpoint);
     quarantine_endpoint(endpoint);
     logger.debug("evicting {} from gossip", endpoint);
@@ -1066,6 +1177,37 @@ future<> gossiper::replicate(inet_address ep, application_state key, const versi
     });
 }
 
+future<> gossiper::maybe_publish_liveness() {
+    auto snapshot = make_lw_shared<liveness_snapshot>();
+    snapshot->live = _live_endpoints;
+    snapshot->unreachable = _unreachable_endpoints;
+    for (auto& [ep, state] : endpoint_state_map) {
+        snapshot->alive.emplace(ep, state.is_alive());
+    }
+    auto& current = liveness();
+    if (snapshot->live == current.live && snapshot->unreachable == current.unreachable && snapshot->alive == current.alive) {
+        return make_ready_future<>();
+    }
+    snapshot->version = ++_liveness_version;
+    lw_shared_ptr<const liveness_snapshot> published = std::move(snapshot);
+    _liveness = make_foreign(published);
+    return parallel_for_each(boost::irange(1u, smp::count), [this, published] (unsigned shard) {
+        return container().invoke_on(shard, [snapshot = make_foreign(published)] (gossiper& g) mutable {
+            g.apply_liveness(std::move(snapshot));
+        });
+    });
+}
+
+void gossiper::apply_liveness(foreign_ptr<lw_shared_ptr<const liveness_snapshot>> snapshot) {
+    if (snapshot->version <= liveness().version) {
+        return;
+    }
+    for (auto& [ep, alive] : snapshot->alive) {
+        endpoint_state_map[ep].set_alive(alive);
+    }
+    _liveness = std::move(snapshot);
+}
+
 future<> gossiper::advertise_removing(inet_address endpoint, utils::UUID host_id, utils::UUID local_host_id) {
     return seastar::async([this, g = this->shared_from_this(), endpoint, host_id, local_host_id] {
         auto& state = get_endpoint_state(endpoint);
@@ -1293,6 +1435,8 @@ future<> gossiper::reset_endpoint_state_map() {
     _live_endpoints_just_added.clear();
     return container().invoke_on_all([] (gossiper& g) {
         g.endpoint_state_map.clear();
+    }).then([this] {
+        return maybe_publish_liveness();
     });
 }
 
@@ -1449,22 +1593,28 @@ void gossiper::real_mark_alive(inet_address addr, endpoint_state& local_state) {
 
     auto it_ = std::find(_live_endpoints.begin(), _live_endpoints.end(), addr);
     bool was_live = it_ != _live_endpoints.end();
-    if (was_live) {
-        return;
-    }
+    if (!was_live) {
+        _live_endpoints.push_back(addr);
 
-    _live_endpoints.push_back(addr);
+        auto it = std::find(_live_endpoints_just_added.begin(), _live_endpoints_just_added.end(), addr);
+        if (it == _live_endpoints_just_added.end()) {
+            _live_endpoints_just_added.push_back(addr);
+        }
+    }
 
-    auto it = std::find(_live_endpoints_just_added.begin(), _live_endpoints_just_added.end(), addr);
-    if (it == _live_endpoints_just_added.end()) {
-        _live_endpoints_just_added.push_back(addr);
+    // Subscribers expect every shard to see the endpoint as UP. Copy the state
+    // first, local_state may go away while we wait.
+    auto state = local_state;
+    maybe_publish_liveness().get();
+    if (was_live) {
+        return;
     }
 
     if (!_in_shadow_round) {
         logger.info("InetAddress {} is now UP, status = {}", addr, status);
     }
 
-    _subscribers.for_each([addr, local_state] (auto& subscriber) {
+    _subscribers.for_each([addr, local_state = std::move(state)] (auto& subscriber) {
         subscriber->on_alive(addr, local_state);
         logger.trace("Notified {}", subscriber.get());
     });
@@ -1474,11 +1624,14 @@ void gossiper::real_mark_alive(inet_address addr, endpoint_state& local_state) {
 void gossiper::mark_dead(inet_address addr, endpoint_state& local_state) {
     logger.trace("marking as down {}", addr);
     local_state.mark_dead();
+    _peer_views.erase(addr);
     _live_endpoints.resize(std::distance(_live_endpoints.begin(), std::remove(_live_endpoints.begin(), _live_endpoints.end(), addr)));
     _live_endpoints_just_added.remove(addr);
     _unreachable_endpoints[addr] = now();
     logger.info("InetAddress {} is now DOWN, status = {}", addr, get_gossip_status(local_state));
-    _subscribers.for_each([addr, local_state] (auto& subscriber) {
+    auto state = local_state;
+    maybe_publish_liveness().get();
+    _subscribers.for_each([addr, local_state = std::move(state)] (auto& subscriber) {
         subscriber->on_dead(addr, local_state);
         logger.trace("Notified {}", subscriber.get());
     });
@@ -1496,6 +1649,7 @@ void gossiper::handle_major_state_change(inet_address ep, const endpoint_state&
     }
     logger.trace("Adding endpoint state for {}, status = {}", ep, get_gossip_status(eps));
     endpoint_state_map[ep] = eps;
+    _peer_views.erase(ep);
     replicate(ep, eps).get();
 
     if (_in_shadow_round) {
@@ -1748,6 +1902,7 @@ future<> gossiper::start_gossiping(int generation_nbr, std::map<application_stat
             _enabled = true;
             _nr_run = 0;
             _scheduled_gossip_task.arm(INTERVAL);
+            arm_direct_fd_timer();
             return make_ready_future<>();
         });
     });
@@ -1836,6 +1991,7 @@ void gossiper::add_saved_endpoint(inet_address ep) {
     endpoint_state_map[ep] = ep_state;
     replicate(ep, ep_state).get();
     _unreachable_endpoints[ep] = now();
+    maybe_publish_liveness().get();
     logger.trace("Adding saved endpoint {} {}", ep, ep_state.get_heart_beat_state().get_generation());
 }
 
@@ -1960,6 +2116,7 @@ future<> gossiper::do_stop_gossiping() {
         // Set disable flag and cancel the timer makes sure gossip loop will not be scheduled
         _enabled = false;
         _scheduled_gossip_task.cancel();
+        _direct_fd_timer.cancel();
         // Take the semaphore makes sure existing gossip loop is finished
         seastar::with_semaphore(_callback_running, 1, [] {
             logger.info("Disable and wait for gossip loop finished");
@@ -97,6 +97,14 @@ struct ack_msg_pending {
     std::optional<utils::chunked_vector<gossip_digest>> ack_msg_digest;
 };
 
+// The state of each endpoint a peer is known to have, as a (generation,
+// max version) pair, learned from the digests and states exchanged with
+// it. Gossip rounds to the peer skip the digests matching it.
+struct peer_view {
+    std::unordered_map<inet_address, std::pair<int, int>> versions;
+    unsigned rounds = 0;
+};
+
 /**
  * This module is responsible for Gossiping information for the local endpoint. This abstraction
  * maintains the list of live and dead endpoints. Periodically i.e. every 1 second this module
@@ -133,6 +141,10 @@ class gossiper : public i_failure_detection_event_listener, public seastar::asyn
     msg_addr get_msg_addr(inet_address to);
     void do_sort(utils::chunked_vector<gossip_digest>& g_digest_list);
     timer<lowres_clock> _scheduled_gossip_task;
+    // Pings live endpoints directly, see direct_fd_ping()
+    timer<lowres_clock> _direct_fd_timer;
+    // Consecutive unanswered direct pings per endpoint
+    std::unordered_map<inet_address, unsigned> _direct_fd_failures;
     bool _enabled = false;
     std::set<inet_address> _seeds_from_config;
     sstring _cluster_name;
@@ -140,6 +152,7 @@ class gossiper : public i_failure_detection_event_listener, public seastar::asyn
     semaphore _apply_state_locally_semaphore{100};
     std::unordered_map<gms::inet_address, syn_msg_pending> _syn_handlers;
     std::unordered_map<gms::inet_address, ack_msg_pending> _ack_handlers;
+    std::unordered_map<gms::inet_address, peer_view> _peer_views;
 public:
     sstring get_cluster_name();
     sstring get_partitioner_name();
@@ -219,10 +232,37 @@ class gossiper : public i_failure_detection_event_listener, public seastar::asyn
 
     clk::time_point _last_processed_message_at = now();
 
-    std::unordered_map<inet_address, clk::time_point> _shadow_unreachable_endpoints;
-    utils::chunked_vector<inet_address> _shadow_live_endpoints;
+    // Liveness of the cluster as decided by shard 0, which runs the failure
+    // detection. The snapshot is immutable: shard 0 builds a new one on every
+    // change and shares it with all shards, so that readers on any shard see a
+    // consistent state without reaching out to shard 0. Shards apply only
+    // snapshots newer than the one they have, publications may be reordered.
+    struct liveness_snapshot {
+        uint64_t version = 0;
+        utils::chunked_vector<inet_address> live;
+        std::unordered_map<inet_address, clk::time_point> unreachable;
+        std::unordered_map<inet_address, bool> alive;
+    };
+    foreign_ptr<lw_shared_ptr<const liveness_snapshot>> _liveness;
+    uint64_t _liveness_version = 0;
+
+    const liveness_snapshot& liveness() const {
+        return *_liveness;
+    }
+    // Publishes the current liveness to all shards if it differs from the
+    // last published snapshot. Must be called on shard 0 after every change
+    // of _live_endpoints, _unreachable_endpoints or of the alive flags; once
+    // it resolves, every shard sees the change.
+    future<> maybe_publish_liveness();
+    void apply_liveness(foreign_ptr<lw_shared_ptr<const liveness_snapshot>> snapshot);
 
     void run();
+    // Sends an echo to every live endpoint and convicts the ones which
+    // failed to answer direct_failure_detector_convict_threshold rounds
+    // in a row, which detects crashed nodes much sooner than the phi
+    // accrual failure detector, fed by gossip rounds, does.
+    void direct_fd_ping();
+    void arm_direct_fd_timer();
     // Replicates given endpoint_state to all other shards.
     // The state state doesn't have to be kept alive around until completes.
     future<> replicate(inet_address, const endpoint_state&);
@@ -284,7 +324,7 @@ class gossiper : public i_failure_detection_event_listener, public seastar::asyn
      * @param ep_state
      * @return
      */
-    int get_max_endpoint_state_version(endpoint_state state);
+    int get_max_endpoint_state_version(const endpoint_state& state);
 
 
 private:
@@ -388,6 +428,14 @@ class gossiper : public i_failure_detection_event_listener, public seastar::asyn
      * @return true if the chosen endpoint is also a seed.
      */
     future<> send_gossip(gossip_digest_syn message, std::set<inet_address> epset);
+    // Records the versions the peer has, as it advertised them, or as sent
+    // to it, in which case it has at least those.
+    void record_peer_view(inet_address peer, const utils::chunked_vector<gossip_digest>& digests, bool sent = false);
+    utils::chunked_vector<gossip_digest> digests_of(const std::map<inet_address, endpoint_state>& states);
+    // Leaves out of the digests those matching what the peer is known to
+    // have, except for the local node and once every gossip_full_digest_interval
+    // rounds to the peer.
+    gossip_digest_syn delta_syn_for(inet_address peer, const gossip_digest_syn& message);
 
     /* Sends a Gossip message to a live member */
     future<> do_gossip_to_live_member(gossip_digest_syn message, inet_address ep);
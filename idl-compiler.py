@@ -770,6 +770,13 @@ def param_view_type(lst):
     return lst[0] + join_template_view(lst[1])
 
 
+def member_view_type(lst):
+    # Vector members of views are deserialized lazily.
+    if not isinstance(lst, str) and lst[0] == "std::vector":
+        return "ser::vector_deserializer" + join_template_view(lst[1])
+    return param_view_type(lst)
+
+
 read_sizes = set()
 
 
@@ -833,7 +840,7 @@ def add_view(hout, info):
     for m in members:
         name = get_member_name(m["name"])
         local_names[name] = "this->" + name + "()"
-        full_type = param_view_type(m["type"])
+        full_type = member_view_type(m["type"])
         if "attribute" in m:
             deflt = m["default"][0] if "default" in m else param_type(m["type"]) + "()"
             if deflt in local_names:
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+namespace query {
+
+struct aggregate_call {
+    sstring function_keyspace;
+    sstring function_name;
+    std::vector<sstring> argument_types;
+    std::vector<uint32_t> arguments;
+    std::vector<std::optional<bytes>> constants;
+};
+
+struct forward_request {
+    query::read_command cmd;
+    std::vector<nonwrapping_range<dht::ring_position>> ranges;
+    db::consistency_level cl;
+    uint32_t page_size;
+    std::vector<sstring> columns;
+    std::vector<query::aggregate_call> calls;
+    std::vector<uint32_t> group_by;
+};
+
+struct partial_aggregates {
+    std::vector<std::optional<bytes>> key;
+    std::vector<std::optional<bytes>> states;
+};
+
+struct forward_result {
+    std::vector<query::partial_aggregates> groups;
+};
+
+}
@@ -56,6 +56,13 @@ struct partition_key_and_mutation_fragments {
     std::list<frozen_mutation_fragment> get_mutation_fragments();
 };
 
+// partition_key_and_mutation_fragments as received from a peer, read in
+// place. A frozen_mutation_fragment is serialized as its representation.
+struct partition_key_and_frozen_fragments stub [[writable]] {
+    partition_key key;
+    std::vector<bytes> mutation_fragments;
+};
+
 class repair_sync_boundary {
     dht::decorated_key pk;
     position_in_partition position;
@@ -72,6 +79,14 @@ struct get_sync_boundary_response {
 enum class row_level_diff_detect_algorithm : uint8_t {
     send_full_set,
     send_full_set_rpc_stream,
+    send_iblt_rpc_stream,
+};
+
+struct repair_hash_sketch {
+    uint64_t seed;
+    std::vector<int32_t> counts;
+    std::vector<uint64_t> key_sums;
+    std::vector<uint64_t> hash_sums;
 };
 
 enum class repair_stream_cmd : uint8_t {
@@ -94,3 +109,9 @@ struct repair_row_on_wire_with_cmd {
     repair_stream_cmd cmd;
     partition_key_and_mutation_fragments row;
 };
+
+// repair_row_on_wire_with_cmd as received from a peer, read in place.
+struct frozen_repair_row_on_wire_with_cmd stub [[writable]] {
+    repair_stream_cmd cmd;
+    partition_key_and_frozen_fragments row;
+};
@@ -30,6 +30,13 @@ class specific_ranges {
     std::vector<nonwrapping_range<clustering_key_prefix>> ranges();
 };
 
+class column_filter {
+    bool is_static;
+    uint32_t id;
+    std::vector<bytes> values;
+    nonwrapping_range<bytes> range;
+};
+
 class partition_slice {
     std::vector<nonwrapping_range<clustering_key_prefix>> default_row_ranges();
     utils::small_vector<uint32_t, 8> static_columns;
@@ -38,6 +45,7 @@ class partition_slice {
     std::unique_ptr<query::specific_ranges> get_specific_ranges();
     cql_serialization_format cql_format();
     uint32_t partition_row_limit() [[version 1.3]] = std::numeric_limits<uint32_t>::max();
+    std::vector<query::column_filter> filters() [[version 4.2]] = std::vector<query::column_filter>();
 };
 
 class read_command {
@@ -50,6 +58,7 @@ class read_command {
     uint32_t partition_limit [[version 1.3]] = std::numeric_limits<uint32_t>::max();
     utils::UUID query_uuid [[version 2.2]] = utils::UUID();
     bool is_first_page [[version 2.2]] = false;
+    uint64_t max_result_size [[version 4.2]] = std::numeric_limits<uint64_t>::max();
 };
 
 }
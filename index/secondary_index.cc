@@ -181,4 +181,28 @@ sstring target_parser::serialize_targets(const std::vector<::shared_ptr<cql3::st
     return json::to_sstring(json_map);
 }
 
+std::vector<sstring> target_parser::parse_included_columns(const index_metadata& im) {
+    auto it = im.options().find(cql3::statements::index_target::included_columns_option_name);
+    if (it == im.options().end()) {
+        return {};
+    }
+    Json::Value json_value;
+    if (!json::to_json_value(it->second, json_value) || !json_value.isArray()) {
+        throw exceptions::configuration_exception(format("Unable to parse included columns for index {} ({})", im.name(), it->second));
+    }
+    std::vector<sstring> columns;
+    for (auto c = json_value.begin(); c != json_value.end(); ++c) {
+        columns.emplace_back(c->asString());
+    }
+    return columns;
+}
+
+sstring target_parser::serialize_included_columns(const std::vector<::shared_ptr<cql3::column_identifier>>& columns) {
+    Json::Value json_array(Json::arrayValue);
+    for (const auto& column : columns) {
+        json_array.append(Json::Value(column->to_string()));
+    }
+    return json::to_sstring(json_array);
+}
+
 }
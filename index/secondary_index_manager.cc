@@ -58,6 +58,7 @@ namespace secondary_index {
 index::index(const sstring& target_column, const index_metadata& im)
     : _target_column{target_column}
     , _im{im}
+    , _included_columns{target_parser::parse_included_columns(im)}
 {}
 
 bool index::depends_on(const column_definition& cdef) const {
@@ -159,8 +160,19 @@ view_ptr secondary_index_manager::create_view_for_index(const index_metadata& im
         }
         builder.with_column(col.name(), col.type, column_kind::clustering_key);
     }
+    auto included_columns = target_parser::parse_included_columns(im);
+    for (auto& name : included_columns) {
+        const column_definition* def = schema->get_column_definition(utf8_type->decompose(name));
+        if (!def || !def->is_regular()) {
+            throw std::runtime_error(format("Column {} included in index {} is not a regular column", name, im.name()));
+        }
+        builder.with_column(def->name(), def->type, column_kind::regular_column);
+    }
     if (index_target->is_primary_key()) {
         for (auto& def : schema->regular_columns()) {
+            if (boost::algorithm::any_of_equal(included_columns, def.name_as_text())) {
+                continue;
+            }
             db::view::create_virtual_column(builder, def.name(), def.type);
         }
     }
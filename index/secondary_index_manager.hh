@@ -62,6 +62,7 @@ sstring index_name_from_table_name(const sstring& table_name);
 class index {
     sstring _target_column;
     index_metadata _im;
+    std::vector<sstring> _included_columns;
 public:
     index(const sstring& target_column, const index_metadata& im);
     bool depends_on(const column_definition& cdef) const;
@@ -70,6 +71,11 @@ class index {
     const sstring& target_column() const {
         return _target_column;
     }
+    /// Non-key columns stored in the index view, so that queries selecting
+    /// only them can be served without reading the base table.
+    const std::vector<sstring>& included_columns() const {
+        return _included_columns;
+    }
 };
 
 class secondary_index_manager {
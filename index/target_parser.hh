@@ -63,6 +63,12 @@ struct target_parser {
     static sstring get_target_column_name_from_string(const sstring& targets);
 
     static sstring serialize_targets(const std::vector<::shared_ptr<cql3::statements::index_target>>& targets);
+
+    // The names of the columns stored in the index view in addition to the
+    // keys (CREATE INDEX ... INCLUDE (...)), from the included_columns option.
+    static std::vector<sstring> parse_included_columns(const index_metadata& im);
+
+    static sstring serialize_included_columns(const std::vector<::shared_ptr<cql3::column_identifier>>& columns);
 };
 
 }
@@ -71,12 +71,18 @@ void init_ms_fd_gossiper(sharded<gms::gossiper>& gossiper
         ew = encrypt_what::rack;
     }
 
-    compress_what cw = compress_what::none;
-    if (ms_compress == "all") {
-        cw = compress_what::all;
-    } else if (ms_compress == "dc") {
-        cw = compress_what::dc;
-    }
+    auto parse_compress_what = [] (const sstring& what) {
+        if (what == "all") {
+            return compress_what::all;
+        } else if (what == "dc") {
+            return compress_what::dc;
+        } else if (what == "rack") {
+            return compress_what::rack;
+        }
+        return compress_what::none;
+    };
+    compress_what cw = parse_compress_what(ms_compress);
+    compress_what zstd_cw = parse_compress_what(cfg.internode_compression_zstd());
 
     tcp_nodelay_what tndw = tcp_nodelay_what::all;
     if (!tcp_nodelay_inter_dc) {
@@ -115,7 +121,7 @@ void init_ms_fd_gossiper(sharded<gms::gossiper>& gossiper
     scfg.statement = scheduling_config.statement;
     scfg.streaming = scheduling_config.streaming;
     scfg.gossip = scheduling_config.gossip;
-    netw::get_messaging_service().start(listen, storage_port, ew, cw, tndw, ssl_storage_port, creds, mcfg, scfg, sltba, listen_now).get();
+    netw::get_messaging_service().start(listen, storage_port, ew, cw, zstd_cw, tndw, cfg.internode_shard_aware_connections(), ssl_storage_port, creds, mcfg, scfg, sltba, listen_now).get();
 
     // #293 - do not stop anything
     //engine().at_exit([] { return netw::get_messaging_service().stop(); });
@@ -171,6 +171,28 @@ class compound_wrapper {
     static inline const auto& get_compound_type(const schema& s) {
         return TopLevel::get_compound_type(s);
     }
+
+    // Fragmented keys are compared fragment by fragment, so that comparing
+    // them doesn't linearize them.
+    static bool is_fragmented(const managed_bytes& b) { return b.is_fragmented(); }
+    static bool is_fragmented(bytes_view) { return false; }
+    static auto fragments(const managed_bytes& b) { return b.fragments(); }
+    static auto fragments(bytes_view b) { return single_fragment_range(b); }
+
+    template<typename Compound, typename Representation1, typename Representation2>
+    static int compare(Compound& t, const Representation1& r1, const Representation2& r2) {
+        if (__builtin_expect(is_fragmented(r1) || is_fragmented(r2), false)) {
+            return t->compare(fragments(r1), fragments(r2));
+        }
+        return t->compare(bytes_view(r1), bytes_view(r2));
+    }
+    template<typename Compound, typename Representation1, typename Representation2>
+    static bool equal(Compound& t, const Representation1& r1, const Representation2& r2) {
+        if (__builtin_expect(is_fragmented(r1) || is_fragmented(r2), false)) {
+            return t->equal(fragments(r1), fragments(r2));
+        }
+        return t->equal(bytes_view(r1), bytes_view(r2));
+    }
 public:
     struct with_schema_wrapper {
         with_schema_wrapper(const schema& s, const TopLevel& key) : s(s), key(key) {}
@@ -251,13 +273,13 @@ class compound_wrapper {
         typename TopLevel::compound _t;
         tri_compare(const schema& s) : _t(get_compound_type(s)) {}
         int operator()(const TopLevel& k1, const TopLevel& k2) const {
-            return _t->compare(k1.representation(), k2.representation());
+            return compare(_t, k1.representation(), k2.representation());
         }
         int operator()(const TopLevelView& k1, const TopLevel& k2) const {
-            return _t->compare(k1.representation(), k2.representation());
+            return compare(_t, k1.representation(), k2.representation());
         }
         int operator()(const TopLevel& k1, const TopLevelView& k2) const {
-            return _t->compare(k1.representation(), k2.representation());
+            return compare(_t, k1.representation(), k2.representation());
         }
     };
 
@@ -265,13 +287,13 @@ class compound_wrapper {
         typename TopLevel::compound _t;
         less_compare(const schema& s) : _t(get_compound_type(s)) {}
         bool operator()(const TopLevel& k1, const TopLevel& k2) const {
-            return _t->less(k1.representation(), k2.representation());
+            return compare(_t, k1.representation(), k2.representation()) < 0;
         }
         bool operator()(const TopLevelView& k1, const TopLevel& k2) const {
-            return _t->less(k1.representation(), k2.representation());
+            return compare(_t, k1.representation(), k2.representation()) < 0;
         }
         bool operator()(const TopLevel& k1, const TopLevelView& k2) const {
-            return _t->less(k1.representation(), k2.representation());
+            return compare(_t, k1.representation(), k2.representation()) < 0;
         }
     };
 
@@ -290,22 +312,22 @@ class compound_wrapper {
         typename TopLevel::compound _t;
         equality(const schema& s) : _t(get_compound_type(s)) {}
         bool operator()(const TopLevel& o1, const TopLevel& o2) const {
-            return _t->equal(o1.representation(), o2.representation());
+            return equal(_t, o1.representation(), o2.representation());
         }
         bool operator()(const TopLevelView& o1, const TopLevel& o2) const {
-            return _t->equal(o1.representation(), o2.representation());
+            return equal(_t, o1.representation(), o2.representation());
         }
         bool operator()(const TopLevel& o1, const TopLevelView& o2) const {
-            return _t->equal(o1.representation(), o2.representation());
+            return equal(_t, o1.representation(), o2.representation());
         }
     };
 
     bool equal(const schema& s, const TopLevel& other) const {
-        return get_compound_type(s)->equal(representation(), other.representation());
+        return equal(get_compound_type(s), representation(), other.representation());
     }
 
     bool equal(const schema& s, const TopLevelView& other) const {
-        return get_compound_type(s)->equal(representation(), other.representation());
+        return equal(get_compound_type(s), representation(), other.representation());
     }
 
     operator bytes_view() const {
@@ -212,6 +212,23 @@ abstract_replication_strategy::get_address_ranges(token_metadata& tm) const {
     return ret;
 }
 
+future<std::unordered_multimap<inet_address, dht::token_range>>
+abstract_replication_strategy::get_address_ranges(token_metadata& tm, std::unordered_set<inet_address> endpoints) const {
+    return do_with(std::unordered_multimap<inet_address, dht::token_range>(), std::move(endpoints), [this, &tm] (auto& ret, auto& endpoints) {
+        return do_for_each(tm.sorted_tokens(), [this, &tm, &ret, &endpoints] (const token& t) {
+            for (auto ep : calculate_natural_endpoints(t, tm)) {
+                if (endpoints.count(ep)) {
+                    for (auto&& rng : tm.get_primary_ranges_for(t)) {
+                        ret.emplace(ep, std::move(rng));
+                    }
+                }
+            }
+        }).then([&ret] {
+            return std::move(ret);
+        });
+    });
+}
+
 std::unordered_map<dht::token_range, std::vector<inet_address>>
 abstract_replication_strategy::get_range_addresses(token_metadata& tm) const {
     std::unordered_map<dht::token_range, std::vector<inet_address>> ret;
@@ -120,6 +120,11 @@ class abstract_replication_strategy {
 
     std::unordered_multimap<inet_address, dht::token_range> get_address_ranges(token_metadata& tm) const;
 
+    // Like get_address_ranges(), restricted to the given endpoints, and
+    // preemptible, so that large rings don't stall the reactor.
+    // tm must not change until the returned future resolves.
+    future<std::unordered_multimap<inet_address, dht::token_range>> get_address_ranges(token_metadata& tm, std::unordered_set<inet_address> endpoints) const;
+
     std::unordered_map<dht::token_range, std::vector<inet_address>> get_range_addresses(token_metadata& tm) const;
 
     dht::token_range_vector get_pending_address_ranges(token_metadata& tm, token pending_token, inet_address pending_address);
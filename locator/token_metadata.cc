@@ -46,6 +46,37 @@ static void remove_by_value(C& container, V value) {
     }
 }
 
+// The sorted tokens of the ring, immutable once built.
+//
+// Clones made on the same shard (clone_only_token_map() and friends, which
+// are taken on every topology change) share them through share(), instead
+// of copying and sorting the whole ring again. Copying makes a deep copy,
+// since token_metadata is copied across shards, where the reference count
+// of a lw_shared_ptr must not be touched.
+class sorted_tokens_ptr {
+    lw_shared_ptr<const std::vector<token>> _tokens;
+    struct share_tag {};
+    sorted_tokens_ptr(share_tag, lw_shared_ptr<const std::vector<token>> tokens) : _tokens(std::move(tokens)) {}
+public:
+    explicit sorted_tokens_ptr(std::vector<token> tokens = {})
+        : _tokens(make_lw_shared<std::vector<token>>(std::move(tokens))) {}
+    sorted_tokens_ptr(const sorted_tokens_ptr& o)
+        : _tokens(make_lw_shared<std::vector<token>>(*o._tokens)) {}
+    sorted_tokens_ptr(sorted_tokens_ptr&&) noexcept = default;
+    sorted_tokens_ptr& operator=(const sorted_tokens_ptr& o) {
+        return *this = sorted_tokens_ptr(o);
+    }
+    sorted_tokens_ptr& operator=(sorted_tokens_ptr&&) noexcept = default;
+
+    // Only valid on the current shard.
+    sorted_tokens_ptr share() const {
+        return sorted_tokens_ptr(share_tag{}, _tokens);
+    }
+    const std::vector<token>& get() const {
+        return *_tokens;
+    }
+};
+
 class token_metadata_impl final {
 public:
     using UUID = utils::UUID;
@@ -69,18 +100,20 @@ class token_metadata_impl final {
     std::unordered_map<sstring, std::unordered_map<range<token>, std::unordered_set<inet_address>>> _pending_ranges_map;
     std::unordered_map<sstring, boost::icl::interval_map<token, std::unordered_set<inet_address>>> _pending_ranges_interval_map;
 
-    std::vector<token> _sorted_tokens;
+    sorted_tokens_ptr _sorted_tokens;
 
     topology _topology;
 
     long _ring_version = 0;
 
     std::vector<token> sort_tokens();
+    void update_sorted_tokens(std::vector<token> added);
 
     using tokens_iterator = tokens_iterator_impl;
 
 public:
     token_metadata_impl(std::unordered_map<token, inet_address> token_to_endpoint_map, std::unordered_map<inet_address, utils::UUID> endpoints_map, topology topology);
+    token_metadata_impl(std::unordered_map<token, inet_address> token_to_endpoint_map, std::unordered_map<inet_address, utils::UUID> endpoints_map, topology topology, sorted_tokens_ptr sorted_tokens);
     token_metadata_impl() {};
     const std::vector<token>& sorted_tokens() const;
     void update_normal_token(token token, inet_address endpoint);
@@ -369,7 +402,7 @@ class token_metadata_impl final {
      * bootstrap tokens and leaving endpoints are not included in the copy.
      */
     token_metadata_impl clone_only_token_map() {
-        return token_metadata_impl(this->_token_to_endpoint_map, this->_endpoint_to_host_id_map, this->_topology);
+        return token_metadata_impl(this->_token_to_endpoint_map, this->_endpoint_to_host_id_map, this->_topology, _sorted_tokens.share());
     }
 #if 0
 
@@ -483,7 +516,7 @@ class token_metadata_impl final {
         abstract_replication_strategy& strategy,
         lw_shared_ptr<std::unordered_multimap<range<token>, inet_address>> new_pending_ranges,
         lw_shared_ptr<token_metadata> all_left_metadata);
-    void calculate_pending_ranges_for_bootstrap(
+    future<> calculate_pending_ranges_for_bootstrap(
         abstract_replication_strategy& strategy,
         lw_shared_ptr<std::unordered_multimap<range<token>, inet_address>> new_pending_ranges,
         lw_shared_ptr<token_metadata> all_left_metadata);
@@ -948,8 +981,11 @@ token_metadata_impl::ring_range(const token& start, bool include_min) const {
 }
 
 token_metadata_impl::token_metadata_impl(std::unordered_map<token, inet_address> token_to_endpoint_map, std::unordered_map<inet_address, utils::UUID> endpoints_map, topology topology) :
-    _token_to_endpoint_map(token_to_endpoint_map), _endpoint_to_host_id_map(endpoints_map), _topology(topology) {
-    _sorted_tokens = sort_tokens();
+    _token_to_endpoint_map(token_to_endpoint_map), _endpoint_to_host_id_map(endpoints_map), _sorted_tokens(sort_tokens()), _topology(topology) {
+}
+
+token_metadata_impl::token_metadata_impl(std::unordered_map<token, inet_address> token_to_endpoint_map, std::unordered_map<inet_address, utils::UUID> endpoints_map, topology topology, sorted_tokens_ptr sorted_tokens) :
+    _token_to_endpoint_map(std::move(token_to_endpoint_map)), _endpoint_to_host_id_map(std::move(endpoints_map)), _sorted_tokens(std::move(sorted_tokens)), _topology(std::move(topology)) {
 }
 
 std::vector<token> token_metadata_impl::sort_tokens() {
@@ -965,8 +1001,26 @@ std::vector<token> token_metadata_impl::sort_tokens() {
     return sorted;
 }
 
+// Brings _sorted_tokens up to date with _token_to_endpoint_map, given the
+// tokens added to the map, in O(n + k log k) instead of sorting the ring.
+void token_metadata_impl::update_sorted_tokens(std::vector<token> added) {
+    std::sort(added.begin(), added.end());
+    const auto& old = _sorted_tokens.get();
+    std::vector<token> kept;
+    kept.reserve(old.size());
+    for (auto& t : old) {
+        if (_token_to_endpoint_map.count(t)) {
+            kept.push_back(t);
+        }
+    }
+    std::vector<token> sorted;
+    sorted.reserve(_token_to_endpoint_map.size());
+    std::set_union(kept.begin(), kept.end(), added.begin(), added.end(), std::back_inserter(sorted));
+    _sorted_tokens = sorted_tokens_ptr(std::move(sorted));
+}
+
 const std::vector<token>& token_metadata_impl::sorted_tokens() const {
-    return _sorted_tokens;
+    return _sorted_tokens.get();
 }
 
 std::vector<token> token_metadata_impl::get_tokens(const inet_address& addr) const {
@@ -1009,6 +1063,7 @@ void token_metadata_impl::update_normal_tokens(const std::unordered_map<inet_add
     }
 
     bool should_sort_tokens = false;
+    std::vector<token> added;
     for (auto&& i : endpoint_tokens) {
         inet_address endpoint = i.first;
         const auto& tokens = i.second;
@@ -1022,6 +1077,7 @@ void token_metadata_impl::update_normal_tokens(const std::unordered_map<inet_add
         for(auto it = _token_to_endpoint_map.begin(), ite = _token_to_endpoint_map.end(); it != ite;) {
             if(it->second == endpoint) {
                 it = _token_to_endpoint_map.erase(it);
+                should_sort_tokens = true;
             } else {
                 ++it;
             }
@@ -1034,7 +1090,10 @@ void token_metadata_impl::update_normal_tokens(const std::unordered_map<inet_add
         for (const token& t : tokens)
         {
             auto prev = _token_to_endpoint_map.insert(std::pair<token, inet_address>(t, endpoint));
-            should_sort_tokens |= prev.second; // new token inserted -> sort
+            if (prev.second) {
+                added.push_back(t);
+                should_sort_tokens = true;
+            }
             if (prev.first->second != endpoint) {
                 tlogger.warn("Token {} changing ownership from {} to {}", t, prev.first->second, endpoint);
                 prev.first->second = endpoint;
@@ -1043,26 +1102,27 @@ void token_metadata_impl::update_normal_tokens(const std::unordered_map<inet_add
     }
 
     if (should_sort_tokens) {
-        _sorted_tokens = sort_tokens();
+        update_sorted_tokens(std::move(added));
     }
 }
 
 size_t token_metadata_impl::first_token_index(const token& start) const {
-    if (_sorted_tokens.empty()) {
+    auto& sorted = _sorted_tokens.get();
+    if (sorted.empty()) {
         auto msg = format("sorted_tokens is empty in first_token_index!");
         tlogger.error("{}", msg);
         throw std::runtime_error(msg);
     }
-    auto it = std::lower_bound(_sorted_tokens.begin(), _sorted_tokens.end(), start);
-    if (it == _sorted_tokens.end()) {
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), start);
+    if (it == sorted.end()) {
         return 0;
     } else {
-        return std::distance(_sorted_tokens.begin(), it);
+        return std::distance(sorted.begin(), it);
     }
 }
 
 const token& token_metadata_impl::first_token(const token& start) const {
-    return _sorted_tokens[first_token_index(start)];
+    return _sorted_tokens.get()[first_token_index(start)];
 }
 
 std::optional<inet_address> token_metadata_impl::get_endpoint(const token& token) const {
@@ -1086,7 +1146,7 @@ void token_metadata_impl::debug_show() {
             fmt::print("inet_address={}, uuid={}\n", x.first, x.second);
         }
         fmt::print("Sorted Token\n");
-        for (auto x : _sorted_tokens) {
+        for (auto x : _sorted_tokens.get()) {
             fmt::print("token={}\n", x);
         }
     });
@@ -1227,7 +1287,7 @@ void token_metadata_impl::remove_endpoint(inet_address endpoint) {
     _topology.remove_endpoint(endpoint);
     _leaving_endpoints.erase(endpoint);
     _endpoint_to_host_id_map.erase(endpoint);
-    _sorted_tokens = sort_tokens();
+    update_sorted_tokens({});
     invalidate_cached_rings();
 }
 
@@ -1366,21 +1426,20 @@ future<> token_metadata_impl::calculate_pending_ranges_for_leaving(
         abstract_replication_strategy& strategy,
         lw_shared_ptr<std::unordered_multimap<range<token>, inet_address>> new_pending_ranges,
         lw_shared_ptr<token_metadata> all_left_metadata) {
-    std::unordered_multimap<inet_address, dht::token_range> address_ranges = strategy.get_address_ranges(unpimplified_this);
-    // get all ranges that will be affected by leaving nodes
-    std::unordered_set<range<token>> affected_ranges;
-    for (auto endpoint : _leaving_endpoints) {
-        auto r = address_ranges.equal_range(endpoint);
-        for (auto x = r.first; x != r.second; x++) {
-            affected_ranges.emplace(x->second);
-        }
-    }
-    // for each of those ranges, find what new nodes will be responsible for the range when
-    // all leaving nodes are gone.
+    // The ranges are computed on a clone, which shares the sorted tokens and
+    // won't change while the computation yields.
     auto metadata = token_metadata(std::make_unique<token_metadata_impl>(clone_only_token_map())); // don't do this in the loop! #7758
-    auto affected_ranges_size = affected_ranges.size();
-    tlogger.debug("In calculate_pending_ranges: affected_ranges.size={} stars", affected_ranges_size);
-    return do_with(std::move(metadata), std::move(affected_ranges), [&strategy, new_pending_ranges, all_left_metadata, affected_ranges_size] (auto& metadata, auto& affected_ranges) {
+    return do_with(std::move(metadata), std::unordered_set<range<token>>(), [this, &strategy, new_pending_ranges, all_left_metadata] (auto& metadata, auto& affected_ranges) {
+      return strategy.get_address_ranges(metadata, _leaving_endpoints).then([&metadata, &affected_ranges, &strategy, new_pending_ranges, all_left_metadata] (
+              std::unordered_multimap<inet_address, dht::token_range> address_ranges) {
+        // get all ranges that will be affected by leaving nodes
+        for (auto& x : address_ranges) {
+            affected_ranges.emplace(x.second);
+        }
+        // for each of those ranges, find what new nodes will be responsible for the range when
+        // all leaving nodes are gone.
+        auto affected_ranges_size = affected_ranges.size();
+        tlogger.debug("In calculate_pending_ranges: affected_ranges.size={} stars", affected_ranges_size);
         return do_for_each(affected_ranges, [&metadata, &strategy, new_pending_ranges, all_left_metadata] (auto& r) {
             auto t = r.end() ? r.end()->value() : dht::maximum_token();
             auto current_endpoints = strategy.calculate_natural_endpoints(t, metadata);
@@ -1396,10 +1455,11 @@ future<> token_metadata_impl::calculate_pending_ranges_for_leaving(
         }).finally([affected_ranges_size] {
             tlogger.debug("In calculate_pending_ranges: affected_ranges.size={} ends", affected_ranges_size);
         });
+      });
     });
 }
 
-void token_metadata_impl::calculate_pending_ranges_for_bootstrap(
+future<> token_metadata_impl::calculate_pending_ranges_for_bootstrap(
         abstract_replication_strategy& strategy,
         lw_shared_ptr<std::unordered_multimap<range<token>, inet_address>> new_pending_ranges,
         lw_shared_ptr<token_metadata> all_left_metadata) {
@@ -1417,17 +1477,19 @@ void token_metadata_impl::calculate_pending_ranges_for_bootstrap(
         auto& t = x.second;
         tmp[addr].insert(t);
     }
-    for (auto& x : tmp) {
-        auto& endpoint = x.first;
-        auto& tokens = x.second;
-        all_left_metadata->update_normal_tokens(tokens, endpoint);
-        for (auto& x : strategy.get_address_ranges(*all_left_metadata)) {
-            if (x.first == endpoint) {
-                new_pending_ranges->emplace(x.second, endpoint);
-            }
-        }
-        all_left_metadata->remove_endpoint(endpoint);
-    }
+    return do_with(std::move(tmp), [&strategy, new_pending_ranges, all_left_metadata] (auto& tmp) {
+        return do_for_each(tmp, [&strategy, new_pending_ranges, all_left_metadata] (auto& x) {
+            auto& endpoint = x.first;
+            auto& tokens = x.second;
+            all_left_metadata->update_normal_tokens(tokens, endpoint);
+            return strategy.get_address_ranges(*all_left_metadata, {endpoint}).then([new_pending_ranges, all_left_metadata, endpoint] (auto address_ranges) {
+                for (auto& x : address_ranges) {
+                    new_pending_ranges->emplace(x.second, endpoint);
+                }
+                all_left_metadata->remove_endpoint(endpoint);
+            });
+        });
+    });
 }
 
 future<> token_metadata_impl::calculate_pending_ranges(
@@ -1444,11 +1506,11 @@ future<> token_metadata_impl::calculate_pending_ranges(
     // Copy of metadata reflecting the situation after all leave operations are finished.
     auto all_left_metadata = make_lw_shared<token_metadata>(std::make_unique<token_metadata_impl>(clone_after_all_left()));
 
-    return calculate_pending_ranges_for_leaving(unpimplified_this, strategy, new_pending_ranges, all_left_metadata).then([this, keyspace_name, &strategy, new_pending_ranges, all_left_metadata] {
+    return calculate_pending_ranges_for_leaving(unpimplified_this, strategy, new_pending_ranges, all_left_metadata).then([this, &strategy, new_pending_ranges, all_left_metadata] {
         // At this stage newPendingRanges has been updated according to leave operations. We can
         // now continue the calculation by checking bootstrapping nodes.
-        calculate_pending_ranges_for_bootstrap(strategy, new_pending_ranges, all_left_metadata);
-
+        return calculate_pending_ranges_for_bootstrap(strategy, new_pending_ranges, all_left_metadata);
+    }).then([this, keyspace_name, new_pending_ranges] {
         // At this stage newPendingRanges has been updated according to leaving and bootstrapping nodes.
         set_pending_ranges(keyspace_name, std::move(*new_pending_ranges));
 
@@ -1814,12 +1876,12 @@ token_metadata::calculate_pending_ranges_for_leaving(
     return _impl->calculate_pending_ranges_for_leaving(*this, strategy, std::move(new_pending_ranges), std::move(all_left_metadata));
 }
 
-void
+future<>
 token_metadata::calculate_pending_ranges_for_bootstrap(
         abstract_replication_strategy& strategy,
         lw_shared_ptr<std::unordered_multimap<range<token>, inet_address>> new_pending_ranges,
         lw_shared_ptr<token_metadata> all_left_metadata) {
-    _impl->calculate_pending_ranges_for_bootstrap(strategy, std::move(new_pending_ranges), std::move(all_left_metadata));
+    return _impl->calculate_pending_ranges_for_bootstrap(strategy, std::move(new_pending_ranges), std::move(all_left_metadata));
 }
 
 token
@@ -892,17 +892,21 @@ static data_value convert_from_lua(lua_slice_state &l, const data_type& type) {
     return ::visit(*type, from_lua_visitor{l});
 }
 
-static bytes_opt convert_return(lua_slice_state &l, const data_type& return_type) {
-    int num_return_vals = lua_gettop(l);
+// The values returned by the script are the ones above stack_base.
+static data_value convert_return_value(lua_slice_state &l, const data_type& return_type, int stack_base = 0) {
+    int num_return_vals = lua_gettop(l) - stack_base;
     if (num_return_vals != 1) {
         throw exceptions::invalid_request_exception(
             format("{} values returned, expected {}", num_return_vals, 1));
     }
+    return convert_from_lua(l, return_type);
+}
 
+static bytes_opt convert_return(lua_slice_state &l, const data_type& return_type) {
     // FIXME: It should be possible to avoid creating the data_value,
     // or even better, change the function::execute interface to
     // return a data_value instead of bytes_opt.
-    return convert_from_lua(l, return_type).serialize();
+    return convert_return_value(l, return_type).serialize();
 }
 
 static void push_sstring(lua_slice_state& l, const sstring& v) {
@@ -1065,23 +1069,14 @@ lua::runtime_config lua::make_runtime_config(const db::config& config) {
     return lua::runtime_config{std::move(timeout_in_ms), std::move(max_bytes), std::move(max_contiguous)};
 }
 
-// run the script for at most max_instructions
-future<bytes_opt> lua::run_script(lua::bitcode_view bitcode, const std::vector<data_value>& values, data_type return_type, const lua::runtime_config& cfg) {
-    lua_slice_state l = load_script(cfg, bitcode);
-    unsigned nargs = values.size();
-    if (!lua_checkstack(l, nargs)) {
-        throw std::runtime_error("could push args to the stack");
-    }
-    for (const data_value& arg : values) {
-        push_argument(l, arg);
-    }
-
+template <typename T, typename Convert>
+static future<T> resume_script(lua_slice_state& l, unsigned nargs, const lua::runtime_config& cfg, Convert convert) {
     // We don't update the timeout once we start executing the function
     using millisecond = std::chrono::duration<double, std::milli>;
     using duration = std::chrono::system_clock::duration;
     duration elapsed{0};
     duration timeout = std::chrono::duration_cast<duration>(millisecond(cfg.timeout_in_ms));
-    return repeat_until_value([l = std::move(l), elapsed, return_type, nargs, timeout = std::move(timeout)] () mutable {
+    return repeat_until_value([&l, elapsed, nargs, timeout = std::move(timeout), convert = std::move(convert)] () mutable {
         // Set the hook before resuming. We have to do it here since the hook can reset itself
         // if it detects we are spending too much time in C.
         // The hook will be called after 1000 instructions.
@@ -1089,7 +1084,7 @@ future<bytes_opt> lua::run_script(lua::bitcode_view bitcode, const std::vector<d
         auto start = ::now();
         switch (lua_resume(l, nullptr, nargs)) {
         case LUA_OK:
-            return make_ready_future<std::optional<bytes_opt>>(convert_return(l, return_type));
+            return make_ready_future<std::optional<T>>(convert(l));
         case LUA_YIELD: {
             nargs = 0;
             elapsed += ::now() - start;
@@ -1097,7 +1092,7 @@ future<bytes_opt> lua::run_script(lua::bitcode_view bitcode, const std::vector<d
                 millisecond ms = elapsed;
                 throw exceptions::invalid_request_exception(format("lua execution timeout: {}ms elapsed", ms.count()));
             }
-            return make_ready_future<std::optional<bytes_opt>>(std::nullopt);
+            return make_ready_future<std::optional<T>>(std::nullopt);
         }
         default:
             throw exceptions::invalid_request_exception(std::string("lua execution failed: ") +
@@ -1105,3 +1100,62 @@ future<bytes_opt> lua::run_script(lua::bitcode_view bitcode, const std::vector<d
         }
     });
 }
+
+// run the script for at most max_instructions
+future<bytes_opt> lua::run_script(lua::bitcode_view bitcode, const std::vector<data_value>& values, data_type return_type, const lua::runtime_config& cfg) {
+    lua_slice_state l = load_script(cfg, bitcode);
+    unsigned nargs = values.size();
+    if (!lua_checkstack(l, nargs)) {
+        throw std::runtime_error("could push args to the stack");
+    }
+    for (const data_value& arg : values) {
+        push_argument(l, arg);
+    }
+
+    return do_with(std::move(l), [nargs, return_type = std::move(return_type), &cfg] (lua_slice_state& l) {
+        return resume_script<bytes_opt>(l, nargs, cfg, [return_type] (lua_slice_state& l) {
+            return convert_return(l, return_type);
+        });
+    });
+}
+
+namespace lua {
+
+// The loaded chunk is kept at the bottom of the stack and a copy of it is
+// resumed for every run. A coroutine that has returned can be resumed
+// again with a new function.
+struct loaded_script_state {
+    runtime_config cfg;
+    lua_slice_state l;
+
+    loaded_script_state(bitcode_view bitcode, const runtime_config& cfg_)
+        : cfg(cfg_)
+        , l(load_script(cfg, bitcode)) {
+    }
+};
+
+}
+
+lua::loaded_script::loaded_script(bitcode_view bitcode, const runtime_config& cfg)
+    : _state(std::make_unique<loaded_script_state>(bitcode, cfg)) {
+}
+
+lua::loaded_script::loaded_script(loaded_script&&) noexcept = default;
+
+lua::loaded_script::~loaded_script() = default;
+
+future<data_value> lua::loaded_script::run(const std::vector<data_value>& values, const data_type& return_type) {
+    auto& l = _state->l;
+    lua_settop(l, 1);
+    unsigned nargs = values.size();
+    if (!lua_checkstack(l, nargs + 1)) {
+        throw std::runtime_error("could push args to the stack");
+    }
+    lua_pushvalue(l, 1);
+    for (const data_value& arg : values) {
+        push_argument(l, arg);
+    }
+    return resume_script<data_value>(l, nargs, _state->cfg, [return_type] (lua_slice_state& l) {
+        return convert_return_value(l, return_type, 1);
+    });
+}
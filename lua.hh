@@ -43,4 +43,22 @@ runtime_config make_runtime_config(const db::config& config);
 sstring compile(const runtime_config& cfg, const std::vector<sstring>& arg_names, sstring script);
 seastar::future<bytes_opt> run_script(bitcode_view bitcode, const std::vector<data_value>& values,
                                       data_type return_type, const runtime_config& cfg);
+
+struct loaded_script_state;
+
+// A script loaded into an interpreter once and then run any number of
+// times, sparing the creation of a new interpreter for every call. The
+// result is returned in native form, so that callers chaining calls
+// (like user defined aggregates) don't pay for serializing it.
+//
+// Runs must not overlap and the object must outlive the returned futures.
+class loaded_script {
+    std::unique_ptr<loaded_script_state> _state;
+public:
+    loaded_script(bitcode_view bitcode, const runtime_config& cfg);
+    loaded_script(loaded_script&&) noexcept;
+    ~loaded_script();
+
+    seastar::future<data_value> run(const std::vector<data_value>& values, const data_type& return_type);
+};
 }
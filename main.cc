@@ -31,6 +31,7 @@
 #include "db/extensions.hh"
 #include "db/legacy_schema_migrator.hh"
 #include "service/storage_service.hh"
+#include "auth/service_level.hh"
 #include "service/migration_manager.hh"
 #include "service/load_meter.hh"
 #include "service/view_update_backlog_broker.hh"
@@ -43,6 +44,8 @@
 #include "db/commitlog/commitlog_replayer.hh"
 #include "db/view/view_builder.hh"
 #include "utils/runtime.hh"
+#include "utils/latency_sampler.hh"
+#include "utils/activity.hh"
 #include "log.hh"
 #include "utils/directories.hh"
 #include "debug.hh"
@@ -65,6 +68,7 @@
 
 #include "db/view/view_update_generator.hh"
 #include "service/cache_hitrate_calculator.hh"
+#include "db/cache_warmer.hh"
 #include "sstables/compaction_manager.hh"
 #include "sstables/sstables.hh"
 #include "gms/feature_service.hh"
@@ -73,9 +77,11 @@
 #include "connection_notifier.hh"
 
 #include "alternator/server.hh"
+#include "alternator/expiration.hh"
 #include "redis/service.hh"
 #include "cdc/log.hh"
 #include "cdc/cdc_extension.hh"
+#include "db/per_partition_rate_limit_extension.hh"
 #include "alternator/tags_extension.hh"
 
 namespace fs = std::filesystem;
@@ -435,6 +441,7 @@ int main(int ac, char** av) {
     auto ext = std::make_shared<db::extensions>();
     ext->add_schema_extension<alternator::tags_extension>(alternator::tags_extension::NAME);
     ext->add_schema_extension<cdc::cdc_extension>(cdc::cdc_extension::NAME);
+    ext->add_schema_extension<db::per_partition_rate_limit_extension>(db::per_partition_rate_limit_extension::NAME);
 
     auto cfg = make_lw_shared<db::config>(ext);
     auto init = app.get_options_description().add_options();
@@ -655,6 +662,11 @@ int main(int ac, char** av) {
                 smp::invoke_on_all([] { engine().set_strict_dma(false); }).get();
             }
 
+            if (cfg->enable_stall_attribution()) {
+                auto stall_threshold = std::chrono::milliseconds(opts["blocked-reactor-notify-ms"].as<unsigned>());
+                smp::invoke_on_all([stall_threshold] { utils::enable_stall_attribution(stall_threshold); }).get();
+            }
+
             auto abort_on_internal_error_observer = cfg->abort_on_internal_error.observe([] (bool val) {
                 set_abort_on_internal_error(val);
             });
@@ -683,7 +695,13 @@ int main(int ac, char** av) {
             supervisor::notify("creating tracing");
             tracing::backend_registry tracing_backend_registry;
             tracing::register_tracing_keyspace_backend(tracing_backend_registry);
-            tracing::tracing::create_tracing(tracing_backend_registry, "trace_keyspace_helper").get();
+            tracing::register_tracing_file_backend(tracing_backend_registry, cfg->tracing_file_directory(), uint64_t(cfg->tracing_file_size_in_mb()) << 20);
+            tracing::tracing::create_tracing(tracing_backend_registry, cfg->tracing_backend()).get();
+            smp::invoke_on_all([period = cfg->latency_breakdown_sample_period()] {
+                auto& sampler = utils::local_latency_sampler();
+                sampler.register_metrics();
+                sampler.set_sample_period(period);
+            }).get();
             supervisor::notify("creating snitch");
             i_endpoint_snitch::create_snitch(cfg->endpoint_snitch()).get();
             // #293 - do not stop anything
@@ -717,8 +735,15 @@ int main(int ac, char** av) {
             // #293 - do not stop anything
             //engine().at_exit([]{ return gms::get_gossiper().stop(); });
             supervisor::notify("initializing storage service");
+            auto statement_scheduling_group = make_sched_group("statement", 1000);
+            std::vector<auth::service_level> levels;
+            for (auto&& [name, shares] : auth::service_level_controller::parse_levels(cfg->service_levels())) {
+                levels.push_back(auth::service_level{name, shares, make_sched_group("sl:" + name, shares)});
+            }
+            auth::service_level_controller service_levels(std::move(levels), cfg->role_service_levels(), statement_scheduling_group);
             service::storage_service_config sscfg;
             sscfg.available_memory = memory::stats().total_memory();
+            sscfg.service_levels = &service_levels;
             service::init_storage_service(stop_signal.as_sharded_abort_source(), db, gossiper, auth_service, sys_dist_ks, view_update_generator, feature_service, sscfg, mm_notifier, token_metadata).get();
             supervisor::notify("starting per-shard database core");
 
@@ -727,9 +752,15 @@ int main(int ac, char** av) {
             dbcfg.compaction_scheduling_group = make_sched_group("compaction", 1000);
             dbcfg.memory_compaction_scheduling_group = make_sched_group("mem_compaction", 1000);
             dbcfg.streaming_scheduling_group = maintenance_scheduling_group;
-            dbcfg.statement_scheduling_group = make_sched_group("statement", 1000);
+            dbcfg.statement_scheduling_group = statement_scheduling_group;
+            if (cfg->cpu_scheduler()) {
+                for (auto& sl : service_levels.levels()) {
+                    dbcfg.service_level_scheduling_groups.push_back(sl.sg);
+                }
+            }
             dbcfg.memtable_scheduling_group = make_sched_group("memtable", 1000);
             dbcfg.memtable_to_cache_scheduling_group = make_sched_group("memtable_to_cache", 200);
+            dbcfg.backup_scheduling_group = make_sched_group("backup", 50);
             dbcfg.available_memory = memory::stats().total_memory();
             db.start(std::ref(*cfg), dbcfg, std::ref(mm_notifier), std::ref(feature_service), std::ref(token_metadata)).get();
             start_large_data_handler(db).get();
@@ -834,7 +865,7 @@ int main(int ac, char** av) {
                 mm.stop().get();
             });
             supervisor::notify("starting query processor");
-            cql3::query_processor::memory_config qp_mcfg = {memory::stats().total_memory() / 256, memory::stats().total_memory() / 2560};
+            cql3::query_processor::memory_config qp_mcfg = {memory::stats().total_memory() / 256, memory::stats().total_memory() / 2560, memory::stats().total_memory() / 2560};
             qp.start(std::ref(proxy), std::ref(db), std::ref(mm_notifier), qp_mcfg, std::ref(cql_config)).get();
             // #293 - do not stop anything
             // engine().at_exit([&qp] { return qp.stop(); });
@@ -1018,6 +1049,19 @@ int main(int ac, char** av) {
                 load_meter.exit().get();
             });
 
+            supervisor::notify("starting cache warmer");
+            db::cache_warmer_config cw_cfg;
+            cw_cfg.saved_caches_directory = cfg->saved_caches_directory();
+            cw_cfg.save_period = std::chrono::seconds(cfg->row_cache_save_period());
+            cw_cfg.keys_to_save = cfg->row_cache_keys_to_save();
+            cw_cfg.scheduling_group = make_sched_group("cache_warmup", 100);
+            static sharded<db::cache_warmer> cache_warmer;
+            cache_warmer.start(std::ref(db), std::move(cw_cfg)).get();
+            auto stop_cache_warmer = defer_verbose_shutdown("cache warmer", [] {
+                cache_warmer.stop().get();
+            });
+            cache_warmer.invoke_on_all(&db::cache_warmer::start).get();
+
             supervisor::notify("starting cf cache hit rate calculator");
             cf_cache_hitrate_calculator.start(std::ref(db)).get();
             auto stop_cache_hitrate_calculator = defer_verbose_shutdown("cf cache hit rate calculator",
@@ -1078,6 +1122,7 @@ int main(int ac, char** av) {
             if (cfg->alternator_port() || cfg->alternator_https_port()) {
                 static sharded<alternator::executor> alternator_executor;
                 static sharded<alternator::server> alternator_server;
+                static sharded<alternator::expiration_service> alternator_expiration;
 
                 net::inet_address addr;
                 try {
@@ -1092,6 +1137,7 @@ int main(int ac, char** av) {
                 c.max_nonlocal_requests = 5000;
                 smp_service_group ssg = create_smp_service_group(c).get0();
                 alternator_executor.start(std::ref(proxy), std::ref(mm), ssg).get();
+                alternator_executor.invoke_on_all(&alternator::executor::start).get();
                 alternator_server.start(std::ref(alternator_executor)).get();
                 std::optional<uint16_t> alternator_port;
                 if (cfg->alternator_port()) {
@@ -1126,7 +1172,14 @@ int main(int ac, char** av) {
                         return server.init(addr, alternator_port, alternator_https_port, creds, alternator_enforce_authorization, &ss.service_memory_limiter());
                     });
                 }).get();
+                alternator_expiration.start(std::ref(proxy), std::chrono::seconds(cfg->alternator_ttl_period_in_seconds())).get();
+                // The scans for expired items run in the background, at the
+                // low priority of the maintenance scheduling group.
+                with_scheduling_group(dbcfg.streaming_scheduling_group, [] {
+                    return alternator_expiration.invoke_on_all(&alternator::expiration_service::start);
+                }).get();
                 auto stop_alternator = [ssg] {
+                    alternator_expiration.stop().get();
                     alternator_server.stop().get();
                     alternator_executor.stop().get();
                     destroy_smp_service_group(ssg).get();
@@ -1150,6 +1203,18 @@ int main(int ac, char** av) {
             smp::invoke_on_all([&cfg] () {
                 return logalloc::shard_tracker().set_reclamation_step(cfg->lsa_reclamation_step());
             }).get();
+            if (cfg->lsa_background_reclaim_free_memory_fraction() > 0) {
+                auto background_reclaim_sg = make_sched_group("background_reclaim", 50);
+                smp::invoke_on_all([&cfg, background_reclaim_sg] {
+                    auto goal = size_t(memory::stats().total_memory() * cfg->lsa_background_reclaim_free_memory_fraction());
+                    logalloc::shard_tracker().start_background_reclaim(background_reclaim_sg, goal);
+                }).get();
+            }
+            auto stop_background_reclaim = defer_verbose_shutdown("background memory reclaimer", [] {
+                smp::invoke_on_all([] {
+                    return logalloc::shard_tracker().stop_background_reclaim();
+                }).get();
+            });
             if (cfg->abort_on_lsa_bad_alloc()) {
                 smp::invoke_on_all([&cfg]() {
                     return logalloc::shard_tracker().enable_abort_on_bad_alloc();
@@ -117,7 +117,6 @@ memtable::memtable(schema_ptr schema, dirty_memory_manager& dmm, table_stats& ta
         , _cleaner(*this, no_cache_tracker, table_stats.memtable_app_stats, compaction_scheduling_group)
         , _memtable_list(memtable_list)
         , _schema(std::move(schema))
-        , partitions(memtable_entry::compare(_schema))
         , _table_stats(table_stats) {
 }
 
@@ -137,14 +136,21 @@ uint64_t memtable::dirty_size() const {
     return occupancy().total_space();
 }
 
+uint64_t memtable::virtual_dirty_size() const {
+    auto size = dirty_size();
+    return size - std::min(size, _flushed_memory);
+}
+
 void memtable::clear() noexcept {
     auto dirty_before = dirty_size();
     with_allocator(allocator(), [this] {
+        clear_pending();
         partitions.clear_and_dispose([this] (memtable_entry* e) {
             e->partition().evict(_cleaner);
             current_deleter<memtable_entry>()(e);
         });
     });
+    _partition_count = 0;
     remove_flushed_memory(dirty_before - dirty_size());
 }
 
@@ -153,7 +159,21 @@ future<> memtable::clear_gently() noexcept {
         auto t = std::make_unique<seastar::thread>([this] {
             auto& alloc = allocator();
 
+            _merging_runs = 0;
+            _merge_pos.clear();
+            _merge_heap.clear();
+            _pending_count = 0;
+            while (!_pending_runs.empty()) {
+                auto dirty_before = dirty_size();
+                with_allocator(alloc, [&] () noexcept {
+                    _pending_runs.pop_back();
+                });
+                remove_flushed_memory(dirty_before - dirty_size());
+                seastar::thread::maybe_yield();
+            }
+
             auto p = std::move(partitions);
+            _partition_count = 0;
             while (!p.empty()) {
                 auto dirty_before = dirty_size();
                 with_allocator(alloc, [&] () noexcept {
@@ -180,26 +200,6 @@ future<> memtable::clear_gently() noexcept {
     });
 }
 
-partition_entry&
-memtable::find_or_create_partition_slow(partition_key_view key) {
-    assert(!reclaiming_enabled());
-
-    // FIXME: Perform lookup using std::pair<token, partition_key_view>
-    // to avoid unconditional copy of the partition key.
-    // We can't do it right now because std::map<> which holds
-    // partitions doesn't support heterogeneous lookup.
-    // We could switch to boost::intrusive_map<> similar to what we have for row keys.
-    auto& outer = current_allocator();
-    return with_allocator(standard_allocator(), [&, this] () -> partition_entry& {
-        auto dk = dht::decorate_key(*_schema, key);
-        return with_allocator(outer, [&dk, this] () -> partition_entry& {
-          return with_linearized_managed_bytes([&] () -> partition_entry& {
-            return find_or_create_partition(dk);
-          });
-        });
-    });
-}
-
 partition_entry&
 memtable::find_or_create_partition(const dht::decorated_key& key) {
     assert(!reclaiming_enabled());
@@ -207,11 +207,12 @@ memtable::find_or_create_partition(const dht::decorated_key& key) {
     // call lower_bound so we have a hint for the insert, just in case.
     auto i = partitions.lower_bound(key, memtable_entry::compare(_schema));
     if (i == partitions.end() || !key.equal(*_schema, i->key())) {
-        memtable_entry* entry = current_allocator().construct<memtable_entry>(
-            _schema, dht::decorated_key(key), mutation_partition(_schema));
+        auto entry = alloc_strategy_unique_ptr<memtable_entry>(current_allocator().construct<memtable_entry>(
+            _schema, dht::decorated_key(key), mutation_partition(_schema)));
         partitions.insert_before(i, *entry);
+        ++_partition_count;
         ++_table_stats.memtable_partition_insertions;
-        return entry->partition();
+        return entry.release()->partition();
     } else {
         ++_table_stats.memtable_partition_hits;
         upgrade_entry(*i);
@@ -219,6 +220,46 @@ memtable::find_or_create_partition(const dht::decorated_key& key) {
     return i->partition();
 }
 
+memtable::partitions_type::iterator
+memtable::lower_bound_from(partitions_type::iterator hint, const dht::decorated_key& key) {
+    // Writes applied in token order mostly land at the hint or right after it.
+    auto less = memtable_entry::compare(_schema);
+    if (hint == partitions.end() || !less(*hint, key)) {
+        if (hint == partitions.begin() || less(*std::prev(hint), key)) {
+            return hint;
+        }
+    } else if (auto next = std::next(hint); next == partitions.end() || !less(*next, key)) {
+        return next;
+    }
+    return partitions.lower_bound(key, less);
+}
+
+memtable::partitions_type::iterator
+memtable::apply_partition(partitions_type::iterator pos, const dht::decorated_key& key, mutation_partition&& mp, const schema& mp_schema) {
+    assert(!reclaiming_enabled());
+
+    auto i = pos;
+    if (i == partitions.end() || !key.equal(*_schema, i->key())) {
+        // The partition built for the write becomes the entry, instead of
+        // being merged into an empty one.
+        if (mp_schema.version() != _schema->version()) {
+            mp.upgrade(mp_schema, *_schema);
+        }
+        _table_stats.memtable_app_stats.row_writes += mp.row_count();
+        auto entry = alloc_strategy_unique_ptr<memtable_entry>(current_allocator().construct<memtable_entry>(
+            _schema, dht::decorated_key(key), std::move(mp)));
+        auto inserted = partitions.insert_before(i, *entry);
+        ++_partition_count;
+        ++_table_stats.memtable_partition_insertions;
+        entry.release();
+        return inserted;
+    }
+    ++_table_stats.memtable_partition_hits;
+    upgrade_entry(*i);
+    i->partition().apply(*_schema, std::move(mp), mp_schema, _table_stats.memtable_app_stats);
+    return i;
+}
+
 boost::iterator_range<memtable::partitions_type::const_iterator>
 memtable::slice(const dht::partition_range& range) const {
     if (query::is_single_partition(range)) {
@@ -554,9 +595,9 @@ class flush_reader final : public flat_mutation_reader::impl, private iterator_r
     flat_mutation_reader_opt _partition_reader;
     flush_memory_accounter _flushed_memory;
 public:
-    flush_reader(schema_ptr s, lw_shared_ptr<memtable> m)
+    flush_reader(schema_ptr s, lw_shared_ptr<memtable> m, const dht::partition_range& range = query::full_partition_range)
         : impl(s)
-        , iterator_reader(std::move(s), m, query::full_partition_range)
+        , iterator_reader(std::move(s), m, range)
         , _flushed_memory(*m)
     {}
     flush_reader(const flush_reader&) = delete;
@@ -642,6 +683,7 @@ memtable::make_flat_reader(schema_ptr s,
                       tracing::trace_state_ptr trace_state_ptr,
                       streamed_mutation::forwarding fwd,
                       mutation_reader::forwarding fwd_mr) {
+    apply_pending();
     if (query::is_single_partition(range) && !fwd_mr) {
         const query::ring_position& pos = range.start()->value();
         auto snp = _read_section(*this, [&] () -> partition_snapshot_ptr {
@@ -677,13 +719,45 @@ memtable::make_flat_reader(schema_ptr s,
 
 flat_mutation_reader
 memtable::make_flush_reader(schema_ptr s, const io_priority_class& pc) {
+    return make_flush_reader(std::move(s), query::full_partition_range, pc);
+}
+
+flat_mutation_reader
+memtable::make_flush_reader(schema_ptr s, const dht::partition_range& range, const io_priority_class& pc) {
+    apply_pending();
     if (group()) {
-        return make_flat_mutation_reader<flush_reader>(s, shared_from_this());
+        return make_flat_mutation_reader<flush_reader>(s, shared_from_this(), range);
     } else {
         auto& full_slice = s->full_slice();
         return make_flat_mutation_reader<scanning_reader>(std::move(s), shared_from_this(),
-            query::full_partition_range, full_slice, pc, mutation_reader::forwarding::no);
+            range, full_slice, pc, mutation_reader::forwarding::no);
+    }
+}
+
+dht::partition_range_vector
+memtable::split_for_flush(unsigned n) const {
+    if (n <= 1 || partitions.empty()) {
+        return {query::full_partition_range};
+    }
+    // Murmur3 tokens are spread evenly, so equal token spans hold similar
+    // amounts of data.
+    auto first = dht::token_ordinal(partitions.begin()->key().token());
+    auto last = dht::token_ordinal(partitions.rbegin()->key().token());
+    auto span = uint64_t(last) - uint64_t(first);
+    auto step = span / n;
+    if (!step) {
+        return {query::full_partition_range};
+    }
+    dht::partition_range_vector ranges;
+    ranges.reserve(n);
+    std::optional<dht::partition_range::bound> start;
+    for (unsigned i = 1; i < n; ++i) {
+        auto split = dht::token(dht::token::kind::key, int64_t(uint64_t(first) + step * i));
+        auto end = dht::partition_range::bound(dht::ring_position::ending_at(split), true);
+        ranges.emplace_back(std::exchange(start, dht::partition_range::bound(dht::ring_position::ending_at(split), false)), std::move(end));
     }
+    ranges.emplace_back(std::move(start), std::nullopt);
+    return ranges;
 }
 
 void
@@ -719,23 +793,200 @@ memtable::apply(const mutation& m, db::rp_handle&& h) {
     update(std::move(h));
 }
 
+memtable::partitions_type::iterator
+memtable::apply_frozen(partitions_type::iterator hint, const frozen_mutation& m, const schema_ptr& m_schema) {
+    // The partition is built straight from the serialized form,
+    // without going through a mutation.
+    mutation_partition mp(m_schema);
+    partition_builder pb(*m_schema, mp);
+    m.partition().accept(*m_schema, pb);
+    _stats_collector.update(*m_schema, mp);
+    if (m_schema->version() == _schema->version()) {
+        mp.pack_rows(*m_schema);
+    }
+    auto& outer = current_allocator();
+    return with_allocator(standard_allocator(), [&] {
+        auto dk = dht::decorate_key(*_schema, m.key());
+        return with_allocator(outer, [&] {
+            return apply_partition(lower_bound_from(hint, dk), dk, std::move(mp), *m_schema);
+        });
+    });
+}
+
 void
 memtable::apply(const frozen_mutation& m, const schema_ptr& m_schema, db::rp_handle&& h) {
-    with_allocator(allocator(), [this, &m, &m_schema] {
-        _allocating_section(*this, [&, this] {
-          with_linearized_managed_bytes([&] {
-            auto& p = find_or_create_partition_slow(m.key());
-            mutation_partition mp(m_schema);
-            partition_builder pb(*m_schema, mp);
-            m.partition().accept(*m_schema, pb);
-            _stats_collector.update(*m_schema, mp);
-            p.apply(*_schema, std::move(mp), *m_schema, _table_stats.memtable_app_stats);
-          });
+    if (_append_only_ingest) {
+        append_pending(m, m_schema);
+    } else {
+        with_allocator(allocator(), [this, &m, &m_schema] {
+            _allocating_section(*this, [&, this] {
+              with_linearized_managed_bytes([&] {
+                apply_frozen(partitions.end(), m, m_schema);
+              });
+            });
         });
-    });
+    }
     update(std::move(h));
 }
 
+// Buffered writes per run. A run is sorted at once, and the merge started
+// by a write advances by one run's worth.
+static constexpr size_t pending_run_size = 4096;
+// Runs buffered before the writes start merging them in.
+static constexpr size_t max_pending_runs = 16;
+// Buffered writes inserted per allocating section.
+static constexpr size_t pending_apply_batch = 128;
+
+static uint64_t pending_key(dht::token t) {
+    return uint64_t(dht::token_ordinal(t)) ^ (uint64_t(1) << 63);
+}
+
+// LSD radix sort on 8-bit digits, skipping the digits all keys share.
+// Stable, so that the writes to a partition keep their order.
+static void sort_pending_run(std::vector<memtable::pending_write>& run) {
+    std::vector<memtable::pending_write> tmp(run.size());
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        std::array<size_t, 256> count{};
+        for (auto& w : run) {
+            ++count[(w.key >> shift) & 0xff];
+        }
+        if (std::find(count.begin(), count.end(), run.size()) != count.end()) {
+            continue;
+        }
+        size_t offset = 0;
+        for (auto& c : count) {
+            offset += std::exchange(c, offset);
+        }
+        for (auto& w : run) {
+            tmp[count[(w.key >> shift) & 0xff]++] = std::move(w);
+        }
+        run.swap(tmp);
+    }
+}
+
+void
+memtable::append_pending(const frozen_mutation& m, const schema_ptr& m_schema) {
+    if (_merging_runs || _pending_runs.size() >= max_pending_runs) {
+        // Keeps the buffer bounded, at the cost of one run's worth of
+        // insertions per filled run.
+        if (_pending_runs.back().size() == pending_run_size) {
+            apply_some_pending(pending_run_size, false);
+        }
+    }
+    if (_pending_runs.empty() || _pending_runs.size() <= _merging_runs || _pending_runs.back().size() == pending_run_size) {
+        _pending_runs.emplace_back();
+        _pending_runs.back().reserve(pending_run_size);
+    }
+    auto& run = _pending_runs.back();
+    auto& rep = m.representation();
+    std::optional<bytes_ostream> linearized;
+    bytes_view v = rep.is_linearized() ? rep.view() : linearized.emplace(rep).linearize();
+    run.push_back(pending_write{pending_key(m.decorated_key(*m_schema).token()), m_schema, {}});
+    try {
+        with_allocator(allocator(), [&] {
+            _allocating_section(*this, [&] {
+                run.back().data = managed_bytes(v);
+            });
+        });
+    } catch (...) {
+        run.pop_back();
+        throw;
+    }
+    ++_pending_count;
+    if (run.size() == pending_run_size) {
+        sort_pending_run(run);
+    }
+}
+
+stop_iteration
+memtable::apply_some_pending(size_t limit, bool preemptible) {
+    if (!_merging_runs) {
+        if (!_pending_count) {
+            return stop_iteration::yes;
+        }
+        if (_pending_runs.back().size() < pending_run_size) {
+            sort_pending_run(_pending_runs.back());
+        }
+        _merging_runs = _pending_runs.size();
+        _merge_pos.assign(_merging_runs, 0);
+        for (size_t r = 0; r < _merging_runs; ++r) {
+            // A run is left empty by a write which failed to be buffered.
+            if (!_pending_runs[r].empty()) {
+                _merge_heap.emplace_back(_pending_runs[r].front().key, r);
+            }
+        }
+        std::make_heap(_merge_heap.begin(), _merge_heap.end(), std::greater<>());
+    }
+    while (!_merge_heap.empty() && limit) {
+        with_allocator(allocator(), [&] {
+            _allocating_section(*this, [&] {
+              with_linearized_managed_bytes([&] {
+                // Partition iterators are valid until the region is compacted,
+                // so the hint doesn't outlive the allocating section.
+                auto hint = partitions.end();
+                for (size_t n = 0; n < pending_apply_batch && limit && !_merge_heap.empty(); ++n, --limit) {
+                    auto r = _merge_heap.front().second;
+                    auto& w = _pending_runs[r][_merge_pos[r]];
+                    auto& outer = current_allocator();
+                    with_allocator(standard_allocator(), [&] {
+                        bytes_ostream b;
+                        for (bytes_view frag : w.data.fragments()) {
+                            b.write(frag);
+                        }
+                        frozen_mutation fm(std::move(b));
+                        with_allocator(outer, [&] {
+                            hint = apply_frozen(hint, fm, w.schema);
+                        });
+                    });
+                    w.data = managed_bytes();
+                    w.schema = nullptr;
+                    --_pending_count;
+                    std::pop_heap(_merge_heap.begin(), _merge_heap.end(), std::greater<>());
+                    _merge_heap.pop_back();
+                    if (++_merge_pos[r] < _pending_runs[r].size()) {
+                        _merge_heap.emplace_back(_pending_runs[r][_merge_pos[r]].key, r);
+                        std::push_heap(_merge_heap.begin(), _merge_heap.end(), std::greater<>());
+                    }
+                }
+              });
+            });
+        });
+        if (preemptible && need_preempt()) {
+            break;
+        }
+    }
+    if (!_merge_heap.empty()) {
+        return stop_iteration::no;
+    }
+    with_allocator(allocator(), [&] {
+        _pending_runs.erase(_pending_runs.begin(), _pending_runs.begin() + _merging_runs);
+    });
+    _merging_runs = 0;
+    _merge_pos.clear();
+    return stop_iteration(!_pending_count);
+}
+
+void
+memtable::apply_pending() {
+    while (apply_some_pending(std::numeric_limits<size_t>::max(), false) == stop_iteration::no) { }
+}
+
+future<>
+memtable::apply_pending_gently() {
+    return repeat([self = shared_from_this()] {
+        return self->apply_some_pending(std::numeric_limits<size_t>::max(), true);
+    });
+}
+
+void
+memtable::clear_pending() noexcept {
+    _pending_runs.clear();
+    _pending_count = 0;
+    _merging_runs = 0;
+    _merge_pos.clear();
+    _merge_heap.clear();
+}
+
 logalloc::occupancy_stats memtable::occupancy() const {
     return logalloc::region::occupancy();
 }
@@ -754,18 +1005,15 @@ mutation_source memtable::as_data_source() {
 }
 
 size_t memtable::partition_count() const {
-    return partitions.size();
+    return _partition_count;
 }
 
 memtable_entry::memtable_entry(memtable_entry&& o) noexcept
-    : _link()
+    : _link(std::move(o._link))
     , _schema(std::move(o._schema))
     , _key(std::move(o._key))
     , _pe(std::move(o._pe))
 {
-    using container_type = memtable::partitions_type;
-    container_type::node_algorithms::replace_node(o._link.this_ptr(), _link.this_ptr());
-    container_type::node_algorithms::init(o._link.this_ptr());
 }
 
 stop_iteration memtable_entry::clear_gently() noexcept {
@@ -37,6 +37,7 @@
 #include "flat_mutation_reader.hh"
 #include "mutation_cleaner.hh"
 #include "sstables/types.hh"
+#include "utils/intrusive_btree.hh"
 
 class frozen_mutation;
 
@@ -44,7 +45,7 @@ class frozen_mutation;
 namespace bi = boost::intrusive;
 
 class memtable_entry {
-    bi::set_member_hook<> _link;
+    intrusive_b::keyed_member_hook _link;
     schema_ptr _schema;
     dht::decorated_key _key;
     partition_entry _pe;
@@ -117,6 +118,20 @@ class memtable_entry {
         }
     };
 
+    // Inline key of the entries in memtable::partitions_type, so that
+    // lookups compare tokens without dereferencing the entries.
+    struct token_of {
+        int64_t operator()(const memtable_entry& e) const noexcept {
+            return dht::token_ordinal(e._key.token());
+        }
+        int64_t operator()(const dht::decorated_key& k) const noexcept {
+            return dht::token_ordinal(k.token());
+        }
+        int64_t operator()(const dht::ring_position& k) const noexcept {
+            return dht::token_ordinal(k.token());
+        }
+    };
+
     friend std::ostream& operator<<(std::ostream&, const memtable_entry&);
 };
 
@@ -126,9 +141,16 @@ struct table_stats;
 // Managed by lw_shared_ptr<>.
 class memtable final : public enable_lw_shared_from_this<memtable>, private logalloc::region {
 public:
-    using partitions_type = bi::set<memtable_entry,
-        bi::member_hook<memtable_entry, bi::set_member_hook<>, &memtable_entry::_link>,
-        bi::compare<memtable_entry::compare>>;
+    using partitions_type = intrusive_b::keyed_tree<memtable_entry, &memtable_entry::_link, memtable_entry::token_of>;
+
+    // A write buffered by the append-only ingest mode.
+    struct pending_write {
+        // Token ordinal with the sign bit flipped, which orders as an unsigned integer.
+        uint64_t key;
+        schema_ptr schema;
+        // Serialized frozen_mutation, allocated in the region.
+        managed_bytes data;
+    };
 private:
     dirty_memory_manager& _dirty_mgr;
     mutation_cleaner _cleaner;
@@ -137,6 +159,8 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
     logalloc::allocating_section _read_section;
     logalloc::allocating_section _allocating_section;
     partitions_type partitions;
+    // partitions_type doesn't keep track of its size.
+    size_t _partition_count = 0;
     db::replay_position _replay_position;
     db::rp_set _rp_set;
     // mutation source to which reads fall-back after mark_flushed()
@@ -148,6 +172,17 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
     mutation_source_opt _underlying;
     uint64_t _flushed_memory = 0;
     table_stats& _table_stats;
+    // See set_append_only_ingest().
+    bool _append_only_ingest = false;
+    // Buffered writes, in runs of up to pending_run_size. A run is sorted by
+    // token once it is full, or when the merge of the runs starts.
+    std::vector<std::vector<pending_write>> _pending_runs;
+    size_t _pending_count = 0;
+    // The merge of the first _merging_runs runs in progress, as a min-heap
+    // of their next keys and the position reached in each run.
+    size_t _merging_runs = 0;
+    std::vector<size_t> _merge_pos;
+    std::vector<std::pair<uint64_t, size_t>> _merge_heap;
 
     class memtable_encoding_stats_collector : public encoding_stats_collector {
     private:
@@ -180,7 +215,22 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
 private:
     boost::iterator_range<partitions_type::const_iterator> slice(const dht::partition_range& r) const;
     partition_entry& find_or_create_partition(const dht::decorated_key& key);
-    partition_entry& find_or_create_partition_slow(partition_key_view key);
+    // Returns the first partition not less than key, starting the search at hint.
+    partitions_type::iterator lower_bound_from(partitions_type::iterator hint, const dht::decorated_key& key);
+    // Inserts mp as a new partition before pos, the lower bound of key, or
+    // applies it to the partition at pos. Returns the partition.
+    // Must be called under allocating section of the region.
+    partitions_type::iterator apply_partition(partitions_type::iterator pos, const dht::decorated_key& key,
+            mutation_partition&& mp, const schema& mp_schema);
+    // Applies m, looking its partition up from hint.
+    // Must be called under allocating section of the region.
+    partitions_type::iterator apply_frozen(partitions_type::iterator hint, const frozen_mutation& m, const schema_ptr& m_schema);
+    void append_pending(const frozen_mutation& m, const schema_ptr& m_schema);
+    // Applies up to limit buffered writes in token order, fewer if preemptible
+    // and preemption is requested.
+    stop_iteration apply_some_pending(size_t limit, bool preemptible);
+    // Must be called under the region's allocator.
+    void clear_pending() noexcept;
     void upgrade_entry(memtable_entry&);
     void add_flushed_memory(uint64_t);
     void remove_flushed_memory(uint64_t);
@@ -204,6 +254,22 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
     // The mutation is upgraded to current schema.
     void apply(const frozen_mutation& m, const schema_ptr& m_schema, db::rp_handle&& = {});
 
+    // In the append-only ingest mode, frozen mutations are buffered in arrival
+    // order and inserted into the partition tree in token order, in bulk, when
+    // the memtable is read or flushed, so that each insertion continues the
+    // previous one's search instead of starting from the root. Writes which
+    // are not appends pay only the buffering.
+    void set_append_only_ingest(bool enabled) noexcept {
+        _append_only_ingest = enabled;
+    }
+    bool has_pending_writes() const noexcept {
+        return _pending_count;
+    }
+    // Inserts the buffered writes.
+    void apply_pending();
+    // Inserts the buffered writes without consuming the whole CPU.
+    future<> apply_pending_gently();
+
     static memtable& from_region(logalloc::region& r) {
         return static_cast<memtable&>(r);
     }
@@ -263,11 +329,21 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
 
     flat_mutation_reader make_flush_reader(schema_ptr, const io_priority_class& pc);
 
+    // Reads only the partitions in the range, which must outlive the reader.
+    // The ranges of concurrent flush readers of a memtable must not overlap.
+    flat_mutation_reader make_flush_reader(schema_ptr, const dht::partition_range&, const io_priority_class& pc);
+
+    // Splits the ring into at most n disjoint ranges covering the memtable,
+    // by dividing the token span of its partitions evenly.
+    dht::partition_range_vector split_for_flush(unsigned n) const;
+
     mutation_source as_data_source();
 
-    bool empty() const { return partitions.empty(); }
+    bool empty() const { return partitions.empty() && !_pending_count; }
     void mark_flushed(mutation_source) noexcept;
     bool is_flushed() const;
+    // Memory occupied by the memtable less the part already written by a flush.
+    uint64_t virtual_dirty_size() const;
     void on_detach_from_region_group() noexcept;
     void revert_flushed_memory() noexcept;
 
@@ -20,6 +20,7 @@
  */
 
 #include "message/messaging_service.hh"
+#include "message/rpc_zstd_compressor.hh"
 #include <seastar/core/distributed.hh>
 #include "gms/failure_detector.hh"
 #include "gms/gossiper.hh"
@@ -63,6 +64,7 @@
 #include "idl/mutation.dist.hh"
 #include "idl/messaging_service.dist.hh"
 #include "idl/paxos.dist.hh"
+#include "idl/forward_request.dist.hh"
 #include "serializer_impl.hh"
 #include "serialization_visitors.hh"
 #include "idl/consistency_level.dist.impl.hh"
@@ -85,6 +87,7 @@
 #include "idl/mutation.dist.impl.hh"
 #include "idl/messaging_service.dist.impl.hh"
 #include "idl/paxos.dist.impl.hh"
+#include "idl/forward_request.dist.impl.hh"
 #include <seastar/rpc/lz4_compressor.hh>
 #include <seastar/rpc/lz4_fragmented_compressor.hh>
 #include <seastar/rpc/multi_algo_compressor_factory.hh>
@@ -92,10 +95,15 @@
 #include "partition_range_compat.hh"
 #include <boost/range/adaptor/filtered.hpp>
 #include <boost/range/adaptor/indirected.hpp>
+#include <random>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
 #include "frozen_mutation.hh"
 #include "flat_mutation_reader.hh"
 #include "streaming/stream_manager.hh"
 #include "streaming/stream_mutation_fragments_cmd.hh"
+#include "streaming/stream_sstable_files_cmd.hh"
 
 namespace netw {
 
@@ -139,10 +147,19 @@ using namespace std::chrono_literals;
 
 static rpc::lz4_fragmented_compressor::factory lz4_fragmented_compressor_factory;
 static rpc::lz4_compressor::factory lz4_compressor_factory;
+static rpc_zstd_compressor::factory zstd_compressor_factory;
 static rpc::multi_algo_compressor_factory compressor_factory {
     &lz4_fragmented_compressor_factory,
     &lz4_compressor_factory,
 };
+// The server picks the first algorithm of the client's list it supports, so
+// listing zstd first makes it preferred, while nodes not supporting it
+// still fall back to lz4. The servers accept all algorithms.
+static rpc::multi_algo_compressor_factory zstd_preferring_compressor_factory {
+    &zstd_compressor_factory,
+    &lz4_fragmented_compressor_factory,
+    &lz4_compressor_factory,
+};
 
 struct messaging_service::rpc_protocol_wrapper : public rpc_protocol { using rpc_protocol::rpc_protocol; };
 
@@ -224,6 +241,11 @@ void messaging_service::foreach_client(std::function<void(const msg_addr& id, co
             f(i->first, i->second);
         }
     }
+    for (auto& clients : _shard_clients) {
+        for (auto i = clients.cbegin(); i != clients.cend(); i++) {
+            f(i->first, i->second);
+        }
+    }
 }
 
 void messaging_service::foreach_server_connection_stats(std::function<void(const rpc::client_info&, const rpc::stats&)>&& f) const {
@@ -278,7 +300,7 @@ future<> messaging_service::unregister_handler(messaging_verb verb) {
 }
 
 messaging_service::messaging_service(gms::inet_address ip, uint16_t port, bool listen_now)
-    : messaging_service(std::move(ip), port, encrypt_what::none, compress_what::none, tcp_nodelay_what::all, 0, nullptr, memory_config{1'000'000},
+    : messaging_service(std::move(ip), port, encrypt_what::none, compress_what::none, compress_what::none, tcp_nodelay_what::all, 0, nullptr, memory_config{1'000'000},
             scheduling_config{}, false, listen_now)
 {}
 
@@ -296,7 +318,7 @@ void messaging_service::start_listen() {
     bool listen_to_bc = _should_listen_to_broadcast_address && _listen_address != utils::fb_utilities::get_broadcast_address();
     rpc::server_options so;
     if (_compress_what != compress_what::none) {
-        so.compressor_factory = &compressor_factory;
+        so.compressor_factory = &zstd_preferring_compressor_factory;
     }
     so.load_balancing_algorithm = server_socket::load_balancing_algorithm::port;
 
@@ -351,7 +373,9 @@ messaging_service::messaging_service(gms::inet_address ip
         , uint16_t port
         , encrypt_what ew
         , compress_what cw
+        , compress_what zstd_cw
         , tcp_nodelay_what tnw
+        , bool shard_aware_connections
         , uint16_t ssl_port
         , std::shared_ptr<seastar::tls::credentials_builder> credentials
         , messaging_service::memory_config mcfg
@@ -363,7 +387,9 @@ messaging_service::messaging_service(gms::inet_address ip
     , _ssl_port(ssl_port)
     , _encrypt_what(ew)
     , _compress_what(cw)
+    , _zstd_compress_what(zstd_cw)
     , _tcp_nodelay_what(tnw)
+    , _shard_aware_connections(shard_aware_connections)
     , _should_listen_to_broadcast_address(sltba)
     , _rpc(new rpc_protocol_wrapper(serializer { }))
     , _credentials(credentials ? credentials->build_server_credentials() : nullptr)
@@ -417,11 +443,14 @@ future<> messaging_service::stop_nontls_server() {
 }
 
 future<> messaging_service::stop_client() {
-    return parallel_for_each(_clients, [] (auto& m) {
-        return parallel_for_each(m, [] (std::pair<const msg_addr, shard_info>& c) {
-            return c.second.rpc_client->stop();
+    auto stop_all = [] (auto& maps) {
+        return parallel_for_each(maps, [] (auto& m) {
+            return parallel_for_each(m, [] (std::pair<const msg_addr, shard_info>& c) {
+                return c.second.rpc_client->stop();
+            });
         });
-    });
+    };
+    return when_all(stop_all(_clients), stop_all(_shard_clients)).discard_result();
 }
 
 future<> messaging_service::stop() {
@@ -438,9 +467,11 @@ static constexpr unsigned do_get_rpc_client_idx(messaging_verb verb) {
     switch (verb) {
     case messaging_verb::CLIENT_ID:
     case messaging_verb::MUTATION:
+    case messaging_verb::MUTATIONS:
     case messaging_verb::READ_DATA:
     case messaging_verb::READ_MUTATION_DATA:
     case messaging_verb::READ_DIGEST:
+    case messaging_verb::READ_DATA_PARTITIONS:
     case messaging_verb::GOSSIP_DIGEST_ACK:
     case messaging_verb::DEFINITIONS_UPDATE:
     case messaging_verb::TRUNCATE:
@@ -453,6 +484,8 @@ static constexpr unsigned do_get_rpc_client_idx(messaging_verb verb) {
     case messaging_verb::PAXOS_ACCEPT:
     case messaging_verb::PAXOS_LEARN:
     case messaging_verb::PAXOS_PRUNE:
+    case messaging_verb::ALTERNATOR_FORWARD_RMW:
+    case messaging_verb::FORWARD_REQUEST:
         return 0;
     // GET_SCHEMA_VERSION is sent from read/mutate verbs so should be
     // sent on a different connection to avoid potential deadlocks
@@ -472,6 +505,7 @@ static constexpr unsigned do_get_rpc_client_idx(messaging_verb verb) {
     case messaging_verb::REPLICATION_FINISHED:
     case messaging_verb::REPAIR_CHECKSUM_RANGE:
     case messaging_verb::STREAM_MUTATION_FRAGMENTS:
+    case messaging_verb::STREAM_SSTABLE_FILES:
     case messaging_verb::REPAIR_ROW_LEVEL_START:
     case messaging_verb::REPAIR_ROW_LEVEL_STOP:
     case messaging_verb::REPAIR_GET_FULL_ROW_HASHES:
@@ -485,6 +519,10 @@ static constexpr unsigned do_get_rpc_client_idx(messaging_verb verb) {
     case messaging_verb::REPAIR_GET_ROW_DIFF_WITH_RPC_STREAM:
     case messaging_verb::REPAIR_PUT_ROW_DIFF_WITH_RPC_STREAM:
     case messaging_verb::REPAIR_GET_FULL_ROW_HASHES_WITH_RPC_STREAM:
+    case messaging_verb::REPAIR_GET_ROW_HASH_SKETCH:
+    case messaging_verb::REPAIR_PREPARE_INCREMENTAL:
+    case messaging_verb::REPAIR_FINISH_INCREMENTAL:
+    case messaging_verb::REPAIR_UPDATE_HISTORY:
     case messaging_verb::HINT_MUTATION:
         return 2;
     case messaging_verb::MUTATION_DONE:
@@ -509,6 +547,104 @@ static unsigned get_rpc_client_idx(messaging_verb verb) {
     return s_rpc_client_idx_table[static_cast<size_t>(verb)];
 }
 
+// Verbs which, with shard-aware connections, are sent over the connection
+// landing on the destination shard named by msg_addr::cpu_id.
+static bool is_shard_aware_verb(messaging_verb verb) {
+    switch (verb) {
+    case messaging_verb::MUTATION:
+    case messaging_verb::READ_DATA:
+    case messaging_verb::READ_MUTATION_DATA:
+    case messaging_verb::READ_DIGEST:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The sharding the given node advertises through gossip, if it does.
+static std::optional<std::pair<unsigned, unsigned>> remote_sharding(gms::inet_address ep) {
+    auto& g = gms::get_local_gossiper();
+    auto shard_count = g.get_application_state_ptr(ep, gms::application_state::SHARD_COUNT);
+    auto ignore_msb = g.get_application_state_ptr(ep, gms::application_state::IGNORE_MSB_BITS);
+    if (!shard_count || !ignore_msb) {
+        return std::nullopt;
+    }
+    try {
+        return std::make_pair(unsigned(std::stoul(shard_count->value)), unsigned(std::stoul(ignore_msb->value)));
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+// Checks that a connection can be bound to the port, so that a port taken by
+// another socket doesn't fail the connection and the RPCs queued on it. The
+// port may still be taken between the check and the connect, which
+// max_shard_bind_failures takes care of.
+static bool can_bind_local_port(const socket_address& addr) {
+    int fd = ::socket(addr.u.sa.sa_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    auto ok = ::bind(fd, &addr.as_posix_sockaddr(), addr.length()) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// The server accepts connections on the shard given by the client port modulo
+// its shard count (load_balancing_algorithm::port), so binding to a port
+// congruent to dst_shard makes the connection land there. Tries a few random
+// such ports and returns an unbound address, letting the kernel choose the
+// port, when none of them is free.
+static socket_address pick_local_address(net::inet_address any, unsigned dst_shard, unsigned shard_count) {
+    static constexpr unsigned min_port = 49152;
+    static constexpr unsigned max_port = 65536;
+    static constexpr unsigned max_attempts = 8;
+    static thread_local std::default_random_engine re{std::random_device{}()};
+    auto first = (min_port + shard_count - 1) / shard_count * shard_count + dst_shard;
+    if (first >= max_port) {
+        return socket_address();
+    }
+    auto candidates = (max_port - 1 - first) / shard_count + 1;
+    std::uniform_int_distribution<unsigned> dist(0, candidates - 1);
+    for (unsigned attempt = 0; attempt < max_attempts; ++attempt) {
+        auto addr = socket_address(any, first + dist(re) * shard_count);
+        if (can_bind_local_port(addr)) {
+            return addr;
+        }
+    }
+    mlogger.debug("No free local port for a connection to shard {} of {}, not binding", dst_shard, shard_count);
+    return socket_address();
+}
+
+msg_addr messaging_service::addr_for_token(gms::inet_address ep, const dht::token& t) const {
+    if (!_shard_aware_connections) {
+        return msg_addr{ep, 0};
+    }
+    auto sharding = remote_sharding(ep);
+    if (!sharding || sharding->first == 0) {
+        return msg_addr{ep, 0};
+    }
+    // Nodes of a cluster mostly share a handful of shardings, so build each once.
+    static thread_local std::map<std::pair<unsigned, unsigned>, std::unique_ptr<dht::sharder>> sharders;
+    auto it = sharders.find(*sharding);
+    if (it == sharders.end()) {
+        it = sharders.emplace(*sharding, std::make_unique<dht::sharder>(sharding->first, sharding->second)).first;
+    }
+    return msg_addr{ep, it->second->shard_of(t)};
+}
+
+messaging_service::clients_map& messaging_service::clients_for(messaging_verb verb, msg_addr id) {
+    if (_shard_aware_connections && is_shard_aware_verb(verb)) {
+        if (id.cpu_id >= _shard_clients.size()) {
+            _shard_clients.resize(id.cpu_id + 1);
+        }
+        return _shard_clients[id.cpu_id];
+    }
+    return _clients[get_rpc_client_idx(verb)];
+}
+
 scheduling_group
 messaging_service::scheduling_group_for_verb(messaging_verb verb) const {
     static const scheduling_group scheduling_config::*idx_to_group[] = {
@@ -566,13 +702,17 @@ void messaging_service::cache_preferred_ip(gms::inet_address ep, gms::inet_addre
 shared_ptr<messaging_service::rpc_protocol_client_wrapper> messaging_service::get_rpc_client(messaging_verb verb, msg_addr id) {
     assert(!_stopping);
     auto idx = get_rpc_client_idx(verb);
-    auto it = _clients[idx].find(id);
+    auto& clients = clients_for(verb, id);
+    auto it = clients.find(id);
 
-    if (it != _clients[idx].end()) {
+    if (it != clients.end()) {
         auto c = it->second.rpc_client;
         if (!c->error()) {
             return c;
         }
+        if (it->second.bound_local_port) {
+            ++_shard_bind_failures[id.addr];
+        }
         remove_error_rpc_client(verb, id);
     }
 
@@ -594,19 +734,27 @@ shared_ptr<messaging_service::rpc_protocol_client_wrapper> messaging_service::ge
                         != snitch_ptr->get_rack(utils::fb_utilities::get_broadcast_address());
     }();
 
-    auto must_compress = [&id, this] {
-        if (_compress_what == compress_what::none) {
+    auto applies = [&id] (compress_what what) {
+        if (what == compress_what::none) {
             return false;
         }
 
-        if (_compress_what == compress_what::dc) {
-            auto& snitch_ptr = locator::i_endpoint_snitch::get_local_snitch_ptr();
+        auto& snitch_ptr = locator::i_endpoint_snitch::get_local_snitch_ptr();
+        if (what == compress_what::dc) {
             return snitch_ptr->get_datacenter(id.addr)
                             != snitch_ptr->get_datacenter(utils::fb_utilities::get_broadcast_address());
         }
+        if (what == compress_what::rack) {
+            return snitch_ptr->get_datacenter(id.addr)
+                            != snitch_ptr->get_datacenter(utils::fb_utilities::get_broadcast_address())
+                    || snitch_ptr->get_rack(id.addr)
+                            != snitch_ptr->get_rack(utils::fb_utilities::get_broadcast_address());
+        }
 
         return true;
-    }();
+    };
+    auto must_compress = applies(_compress_what);
+    auto prefer_zstd = must_compress && applies(_zstd_compress_what);
 
     auto must_tcp_nodelay = [&] {
         if (idx == 1) {
@@ -620,26 +768,43 @@ shared_ptr<messaging_service::rpc_protocol_client_wrapper> messaging_service::ge
         return true;
     }();
 
-    auto remote_addr = socket_address(get_preferred_ip(id.addr), must_encrypt ? _ssl_port : _port);
+    auto remote_ip = get_preferred_ip(id.addr);
+    auto remote_addr = socket_address(remote_ip, must_encrypt ? _ssl_port : _port);
+
+    socket_address local_addr;
+    bool bound_local_port = false;
+    // Connections bound to a chosen port failing repeatedly may be caused by
+    // port collisions rather than by the remote node, so fall back to letting
+    // the kernel choose the port, giving up the shard-awareness.
+    if (_shard_aware_connections && is_shard_aware_verb(verb) && _shard_bind_failures[id.addr] < max_shard_bind_failures) {
+        auto sharding = remote_sharding(id.addr);
+        if (sharding && sharding->first) {
+            auto any = remote_ip.addr().in_family() == net::inet_address::family::INET6
+                    ? net::inet_address(::in6addr_any) : net::inet_address(::in_addr{INADDR_ANY});
+            local_addr = pick_local_address(any, id.cpu_id % sharding->first, sharding->first);
+            bound_local_port = local_addr.port() != 0;
+        }
+    }
 
     rpc::client_options opts;
     // send keepalive messages each minute if connection is idle, drop connection after 10 failures
     opts.keepalive = std::optional<net::tcp_keepalive_params>({60s, 60s, 10});
     if (must_compress) {
-        opts.compressor_factory = &compressor_factory;
+        opts.compressor_factory = prefer_zstd ? &zstd_preferring_compressor_factory : &compressor_factory;
     }
     opts.tcp_nodelay = must_tcp_nodelay;
     opts.reuseaddr = true;
 
     auto client = must_encrypt ?
                     ::make_shared<rpc_protocol_client_wrapper>(*_rpc, std::move(opts),
-                                    remote_addr, socket_address(), _credentials) :
+                                    remote_addr, local_addr, _credentials) :
                     ::make_shared<rpc_protocol_client_wrapper>(*_rpc, std::move(opts),
-                                    remote_addr);
+                                    remote_addr, local_addr);
 
-    auto res = _clients[idx].emplace(id, shard_info(std::move(client)));
+    auto res = clients.emplace(id, shard_info(std::move(client)));
     assert(res.second);
     it = res.first;
+    it->second.bound_local_port = bound_local_port;
     uint32_t src_cpu_id = this_shard_id();
     // No reply is received, nothing to wait for.
     (void)_rpc->make_client<rpc::no_wait_type(gms::inet_address, uint32_t, uint64_t)>(messaging_verb::CLIENT_ID)(*it->second.rpc_client, utils::fb_utilities::get_broadcast_address(), src_cpu_id,
@@ -677,7 +842,7 @@ bool messaging_service::remove_rpc_client_one(clients_map& clients, msg_addr id,
 }
 
 void messaging_service::remove_error_rpc_client(messaging_verb verb, msg_addr id) {
-    if (remove_rpc_client_one(_clients[get_rpc_client_idx(verb)], id, true)) {
+    if (remove_rpc_client_one(clients_for(verb, id), id, true)) {
         for (auto&& cb : _connection_drop_notifiers) {
             cb(id.addr);
         }
@@ -688,6 +853,10 @@ void messaging_service::remove_rpc_client(msg_addr id) {
     for (auto& c : _clients) {
         remove_rpc_client_one(c, id, false);
     }
+    for (auto& c : _shard_clients) {
+        remove_rpc_client_one(c, id, false);
+    }
+    _shard_bind_failures.erase(id.addr);
 }
 
 std::unique_ptr<messaging_service::rpc_protocol_wrapper>& messaging_service::rpc() {
@@ -718,6 +887,31 @@ void messaging_service::register_stream_mutation_fragments(std::function<future<
     register_handler(this, messaging_verb::STREAM_MUTATION_FRAGMENTS, std::move(func));
 }
 
+rpc::sink<int32_t> messaging_service::make_sink_for_stream_sstable_files(rpc::source<sstring, bytes, streaming::stream_sstable_files_cmd>& source) {
+    return source.make_sink<netw::serializer, int32_t>();
+}
+
+future<rpc::sink<sstring, bytes, streaming::stream_sstable_files_cmd>, rpc::source<int32_t>>
+messaging_service::make_sink_and_source_for_stream_sstable_files(utils::UUID schema_id, utils::UUID plan_id, utils::UUID cf_id, streaming::stream_reason reason, sstring version, sstring format, msg_addr id) {
+    using sink_type = rpc::sink<sstring, bytes, streaming::stream_sstable_files_cmd>;
+    if (is_stopping()) {
+        return make_exception_future<sink_type, rpc::source<int32_t>>(rpc::closed_error());
+    }
+    auto rpc_client = get_rpc_client(messaging_verb::STREAM_SSTABLE_FILES, id);
+    return rpc_client->make_stream_sink<netw::serializer, sstring, bytes, streaming::stream_sstable_files_cmd>().then([this, plan_id, schema_id, cf_id, reason, version = std::move(version), format = std::move(format), rpc_client] (sink_type sink) mutable {
+        auto rpc_handler = rpc()->make_client<rpc::source<int32_t> (utils::UUID, utils::UUID, utils::UUID, streaming::stream_reason, sstring, sstring, sink_type)>(messaging_verb::STREAM_SSTABLE_FILES);
+        return rpc_handler(*rpc_client , plan_id, schema_id, cf_id, reason, std::move(version), std::move(format), sink).then_wrapped([sink, rpc_client] (future<rpc::source<int32_t>> source) mutable {
+            return (source.failed() ? sink.close() : make_ready_future<>()).then([sink = std::move(sink), source = std::move(source)] () mutable {
+                return make_ready_future<sink_type, rpc::source<int32_t>>(std::move(sink), std::move(source.get0()));
+            });
+        });
+    });
+}
+
+void messaging_service::register_stream_sstable_files(std::function<future<rpc::sink<int32_t>> (const rpc::client_info& cinfo, UUID plan_id, UUID schema_id, UUID cf_id, streaming::stream_reason reason, sstring version, sstring format, rpc::source<sstring, bytes, streaming::stream_sstable_files_cmd> source)>&& func) {
+    register_handler(this, messaging_verb::STREAM_SSTABLE_FILES, std::move(func));
+}
+
 template<class SinkType, class SourceType>
 future<rpc::sink<SinkType>, rpc::source<SourceType>>
 do_make_sink_source(messaging_verb verb, uint32_t repair_meta_id, shared_ptr<messaging_service::rpc_protocol_client_wrapper> rpc_client, std::unique_ptr<messaging_service::rpc_protocol_wrapper>& rpc) {
@@ -732,14 +926,14 @@ do_make_sink_source(messaging_verb verb, uint32_t repair_meta_id, shared_ptr<mes
 }
 
 // Wrapper for REPAIR_GET_ROW_DIFF_WITH_RPC_STREAM
-future<rpc::sink<repair_hash_with_cmd>, rpc::source<repair_row_on_wire_with_cmd>>
+future<rpc::sink<repair_hash_with_cmd>, rpc::source<frozen_repair_row_on_wire_with_cmd>>
 messaging_service::make_sink_and_source_for_repair_get_row_diff_with_rpc_stream(uint32_t repair_meta_id, msg_addr id) {
     auto verb = messaging_verb::REPAIR_GET_ROW_DIFF_WITH_RPC_STREAM;
     if (is_stopping()) {
-        return make_exception_future<rpc::sink<repair_hash_with_cmd>, rpc::source<repair_row_on_wire_with_cmd>>(rpc::closed_error());
+        return make_exception_future<rpc::sink<repair_hash_with_cmd>, rpc::source<frozen_repair_row_on_wire_with_cmd>>(rpc::closed_error());
     }
     auto rpc_client = get_rpc_client(verb, id);
-    return do_make_sink_source<repair_hash_with_cmd, repair_row_on_wire_with_cmd>(verb, repair_meta_id, std::move(rpc_client), rpc());
+    return do_make_sink_source<repair_hash_with_cmd, frozen_repair_row_on_wire_with_cmd>(verb, repair_meta_id, std::move(rpc_client), rpc());
 }
 
 rpc::sink<repair_row_on_wire_with_cmd> messaging_service::make_sink_for_repair_get_row_diff_with_rpc_stream(rpc::source<repair_hash_with_cmd>& source) {
@@ -761,11 +955,11 @@ messaging_service::make_sink_and_source_for_repair_put_row_diff_with_rpc_stream(
     return do_make_sink_source<repair_row_on_wire_with_cmd, repair_stream_cmd>(verb, repair_meta_id, std::move(rpc_client), rpc());
 }
 
-rpc::sink<repair_stream_cmd> messaging_service::make_sink_for_repair_put_row_diff_with_rpc_stream(rpc::source<repair_row_on_wire_with_cmd>& source) {
+rpc::sink<repair_stream_cmd> messaging_service::make_sink_for_repair_put_row_diff_with_rpc_stream(rpc::source<frozen_repair_row_on_wire_with_cmd>& source) {
     return source.make_sink<netw::serializer, repair_stream_cmd>();
 }
 
-void messaging_service::register_repair_put_row_diff_with_rpc_stream(std::function<future<rpc::sink<repair_stream_cmd>> (const rpc::client_info& cinfo, uint32_t repair_meta_id, rpc::source<repair_row_on_wire_with_cmd> source)>&& func) {
+void messaging_service::register_repair_put_row_diff_with_rpc_stream(std::function<future<rpc::sink<repair_stream_cmd>> (const rpc::client_info& cinfo, uint32_t repair_meta_id, rpc::source<frozen_repair_row_on_wire_with_cmd> source)>&& func) {
     register_handler(this, messaging_verb::REPAIR_PUT_ROW_DIFF_WITH_RPC_STREAM, std::move(func));
 }
 
@@ -920,7 +1114,11 @@ future<> messaging_service::unregister_gossip_echo() {
     return unregister_handler(netw::messaging_verb::GOSSIP_ECHO);
 }
 future<> messaging_service::send_gossip_echo(msg_addr id) {
-    return send_message_timeout<void>(this, messaging_verb::GOSSIP_ECHO, std::move(id), 3000ms);
+    return send_gossip_echo(std::move(id), 3000ms);
+}
+
+future<> messaging_service::send_gossip_echo(msg_addr id, std::chrono::milliseconds timeout) {
+    return send_message_timeout<void>(this, messaging_verb::GOSSIP_ECHO, std::move(id), timeout);
 }
 
 void messaging_service::register_gossip_shutdown(std::function<rpc::no_wait_type (inet_address from)>&& func) {
@@ -1003,6 +1201,19 @@ future<> messaging_service::send_mutation(msg_addr id, clock_type::time_point ti
         std::move(reply_to), shard, std::move(response_id), std::move(trace_info));
 }
 
+void messaging_service::register_mutations(std::function<future<rpc::no_wait_type> (const rpc::client_info&, rpc::opt_time_point, std::vector<frozen_mutation> fms,
+    inet_address reply_to, unsigned shard, std::vector<response_id_type> response_ids, std::optional<tracing::trace_info> trace_info)>&& func) {
+    register_handler(this, netw::messaging_verb::MUTATIONS, std::move(func));
+}
+future<> messaging_service::unregister_mutations() {
+    return unregister_handler(netw::messaging_verb::MUTATIONS);
+}
+future<> messaging_service::send_mutations(msg_addr id, clock_type::time_point timeout, const std::vector<std::reference_wrapper<const frozen_mutation>>& fms,
+    inet_address reply_to, unsigned shard, std::vector<response_id_type> response_ids, std::optional<tracing::trace_info> trace_info) {
+    return send_message_oneway_timeout(this, timeout, messaging_verb::MUTATIONS, std::move(id), fms,
+        std::move(reply_to), shard, std::move(response_ids), std::move(trace_info));
+}
+
 void messaging_service::register_counter_mutation(std::function<future<> (const rpc::client_info&, rpc::opt_time_point, std::vector<frozen_mutation> fms, db::consistency_level cl, std::optional<tracing::trace_info> trace_info)>&& func) {
     register_handler(this, netw::messaging_verb::COUNTER_MUTATION, std::move(func));
 }
@@ -1043,6 +1254,16 @@ future<rpc::tuple<query::result, rpc::optional<cache_temperature>>> messaging_se
     return send_message_timeout<future<rpc::tuple<query::result, rpc::optional<cache_temperature>>>>(this, messaging_verb::READ_DATA, std::move(id), timeout, cmd, pr, da);
 }
 
+void messaging_service::register_read_data_partitions(std::function<future<rpc::tuple<std::vector<query::result>, cache_temperature>> (const rpc::client_info&, rpc::opt_time_point t, query::read_command cmd, dht::partition_range_vector ranges)>&& func) {
+    register_handler(this, netw::messaging_verb::READ_DATA_PARTITIONS, std::move(func));
+}
+future<> messaging_service::unregister_read_data_partitions() {
+    return unregister_handler(netw::messaging_verb::READ_DATA_PARTITIONS);
+}
+future<rpc::tuple<std::vector<query::result>, cache_temperature>> messaging_service::send_read_data_partitions(msg_addr id, clock_type::time_point timeout, const query::read_command& cmd, const dht::partition_range_vector& ranges) {
+    return send_message_timeout<future<rpc::tuple<std::vector<query::result>, cache_temperature>>>(this, messaging_verb::READ_DATA_PARTITIONS, std::move(id), timeout, cmd, ranges);
+}
+
 void messaging_service::register_get_schema_version(std::function<future<frozen_schema>(unsigned, table_schema_version)>&& func) {
     register_handler(this, netw::messaging_verb::GET_SCHEMA_VERSION, std::move(func));
 }
@@ -1136,6 +1357,17 @@ future<std::unordered_set<repair_hash>> messaging_service::send_repair_get_full_
     return send_message<future<std::unordered_set<repair_hash>>>(this, messaging_verb::REPAIR_GET_FULL_ROW_HASHES, std::move(id), repair_meta_id);
 }
 
+// Wrapper for REPAIR_GET_ROW_HASH_SKETCH
+void messaging_service::register_repair_get_row_hash_sketch(std::function<future<repair_hash_sketch> (const rpc::client_info& cinfo, uint32_t repair_meta_id, uint32_t cells, uint64_t seed)>&& func) {
+    register_handler(this, messaging_verb::REPAIR_GET_ROW_HASH_SKETCH, std::move(func));
+}
+future<> messaging_service::unregister_repair_get_row_hash_sketch() {
+    return unregister_handler(messaging_verb::REPAIR_GET_ROW_HASH_SKETCH);
+}
+future<repair_hash_sketch> messaging_service::send_repair_get_row_hash_sketch(msg_addr id, uint32_t repair_meta_id, uint32_t cells, uint64_t seed) {
+    return send_message<future<repair_hash_sketch>>(this, messaging_verb::REPAIR_GET_ROW_HASH_SKETCH, std::move(id), repair_meta_id, cells, seed);
+}
+
 // Wrapper for REPAIR_GET_COMBINED_ROW_HASH
 void messaging_service::register_repair_get_combined_row_hash(std::function<future<get_combined_row_hash_response> (const rpc::client_info& cinfo, uint32_t repair_meta_id, std::optional<repair_sync_boundary> common_sync_boundary)>&& func) {
     register_handler(this, messaging_verb::REPAIR_GET_COMBINED_ROW_HASH, std::move(func));
@@ -1164,12 +1396,12 @@ void messaging_service::register_repair_get_row_diff(std::function<future<repair
 future<> messaging_service::unregister_repair_get_row_diff() {
     return unregister_handler(messaging_verb::REPAIR_GET_ROW_DIFF);
 }
-future<repair_rows_on_wire> messaging_service::send_repair_get_row_diff(msg_addr id, uint32_t repair_meta_id, std::unordered_set<repair_hash> set_diff, bool needs_all_rows) {
-    return send_message<future<repair_rows_on_wire>>(this, messaging_verb::REPAIR_GET_ROW_DIFF, std::move(id), repair_meta_id, std::move(set_diff), needs_all_rows);
+future<frozen_repair_rows_on_wire> messaging_service::send_repair_get_row_diff(msg_addr id, uint32_t repair_meta_id, std::unordered_set<repair_hash> set_diff, bool needs_all_rows) {
+    return send_message<future<frozen_repair_rows_on_wire>>(this, messaging_verb::REPAIR_GET_ROW_DIFF, std::move(id), repair_meta_id, std::move(set_diff), needs_all_rows);
 }
 
 // Wrapper for REPAIR_PUT_ROW_DIFF
-void messaging_service::register_repair_put_row_diff(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, repair_rows_on_wire row_diff)>&& func) {
+void messaging_service::register_repair_put_row_diff(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, frozen_repair_rows_on_wire row_diff)>&& func) {
     register_handler(this, messaging_verb::REPAIR_PUT_ROW_DIFF, std::move(func));
 }
 future<> messaging_service::unregister_repair_put_row_diff() {
@@ -1180,14 +1412,14 @@ future<> messaging_service::send_repair_put_row_diff(msg_addr id, uint32_t repai
 }
 
 // Wrapper for REPAIR_ROW_LEVEL_START
-void messaging_service::register_repair_row_level_start(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version)>&& func) {
+void messaging_service::register_repair_row_level_start(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, rpc::optional<bool> incremental)>&& func) {
     register_handler(this, messaging_verb::REPAIR_ROW_LEVEL_START, std::move(func));
 }
 future<> messaging_service::unregister_repair_row_level_start() {
     return unregister_handler(messaging_verb::REPAIR_ROW_LEVEL_START);
 }
-future<> messaging_service::send_repair_row_level_start(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version) {
-    return send_message<void>(this, messaging_verb::REPAIR_ROW_LEVEL_START, std::move(id), repair_meta_id, std::move(keyspace_name), std::move(cf_name), std::move(range), algo, max_row_buf_size, seed, remote_shard, remote_shard_count, remote_ignore_msb, std::move(remote_partitioner_name), std::move(schema_version));
+future<> messaging_service::send_repair_row_level_start(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, bool incremental) {
+    return send_message<void>(this, messaging_verb::REPAIR_ROW_LEVEL_START, std::move(id), repair_meta_id, std::move(keyspace_name), std::move(cf_name), std::move(range), algo, max_row_buf_size, seed, remote_shard, remote_shard_count, remote_ignore_msb, std::move(remote_partitioner_name), std::move(schema_version), incremental);
 }
 
 // Wrapper for REPAIR_ROW_LEVEL_STOP
@@ -1234,6 +1466,39 @@ future<std::vector<row_level_diff_detect_algorithm>> messaging_service::send_rep
     return send_message<future<std::vector<row_level_diff_detect_algorithm>>>(this, messaging_verb::REPAIR_GET_DIFF_ALGORITHMS, std::move(id));
 }
 
+// Wrapper for REPAIR_PREPARE_INCREMENTAL
+void messaging_service::register_repair_prepare_incremental(std::function<future<> (const rpc::client_info& cinfo, utils::UUID session, sstring keyspace_name, std::vector<sstring> cf_names)>&& func) {
+    register_handler(this, messaging_verb::REPAIR_PREPARE_INCREMENTAL, std::move(func));
+}
+future<> messaging_service::unregister_repair_prepare_incremental() {
+    return unregister_handler(messaging_verb::REPAIR_PREPARE_INCREMENTAL);
+}
+future<> messaging_service::send_repair_prepare_incremental(msg_addr id, utils::UUID session, sstring keyspace_name, std::vector<sstring> cf_names) {
+    return send_message<void>(this, messaging_verb::REPAIR_PREPARE_INCREMENTAL, std::move(id), session, std::move(keyspace_name), std::move(cf_names));
+}
+
+// Wrapper for REPAIR_FINISH_INCREMENTAL
+void messaging_service::register_repair_finish_incremental(std::function<future<> (const rpc::client_info& cinfo, utils::UUID session, dht::token_range_vector ranges, uint64_t repaired_at)>&& func) {
+    register_handler(this, messaging_verb::REPAIR_FINISH_INCREMENTAL, std::move(func));
+}
+future<> messaging_service::unregister_repair_finish_incremental() {
+    return unregister_handler(messaging_verb::REPAIR_FINISH_INCREMENTAL);
+}
+future<> messaging_service::send_repair_finish_incremental(msg_addr id, utils::UUID session, dht::token_range_vector ranges, uint64_t repaired_at) {
+    return send_message<void>(this, messaging_verb::REPAIR_FINISH_INCREMENTAL, std::move(id), session, std::move(ranges), repaired_at);
+}
+
+// Wrapper for REPAIR_UPDATE_HISTORY
+void messaging_service::register_repair_update_history(std::function<future<> (const rpc::client_info& cinfo, sstring keyspace_name, std::vector<sstring> cf_names, dht::token_range_vector ranges, gc_clock::time_point repair_time)>&& func) {
+    register_handler(this, messaging_verb::REPAIR_UPDATE_HISTORY, std::move(func));
+}
+future<> messaging_service::unregister_repair_update_history() {
+    return unregister_handler(messaging_verb::REPAIR_UPDATE_HISTORY);
+}
+future<> messaging_service::send_repair_update_history(msg_addr id, sstring keyspace_name, std::vector<sstring> cf_names, dht::token_range_vector ranges, gc_clock::time_point repair_time) {
+    return send_message<void>(this, messaging_verb::REPAIR_UPDATE_HISTORY, std::move(id), std::move(keyspace_name), std::move(cf_names), std::move(ranges), repair_time);
+}
+
 void
 messaging_service::register_paxos_prepare(std::function<future<foreign_ptr<std::unique_ptr<service::paxos::prepare_response>>>(
         const rpc::client_info&, rpc::opt_time_point, query::read_command cmd, partition_key key, utils::UUID ballot,
@@ -1308,4 +1573,24 @@ future<> messaging_service::send_hint_mutation(msg_addr id, clock_type::time_poi
         std::move(reply_to), shard, std::move(response_id), std::move(trace_info));
 }
 
+void messaging_service::register_alternator_forward_rmw(std::function<future<sstring> (const rpc::client_info& cinfo, rpc::opt_time_point timeout, sstring op, sstring request)>&& func) {
+    register_handler(this, messaging_verb::ALTERNATOR_FORWARD_RMW, std::move(func));
+}
+future<> messaging_service::unregister_alternator_forward_rmw() {
+    return unregister_handler(messaging_verb::ALTERNATOR_FORWARD_RMW);
+}
+future<sstring> messaging_service::send_alternator_forward_rmw(gms::inet_address peer, clock_type::time_point timeout, const sstring& op, const sstring& request) {
+    return send_message_timeout<sstring>(this, messaging_verb::ALTERNATOR_FORWARD_RMW, netw::msg_addr(peer), timeout, op, request);
+}
+
+void messaging_service::register_forward_request(std::function<future<query::forward_result> (const rpc::client_info& cinfo, rpc::opt_time_point timeout, query::forward_request req)>&& func) {
+    register_handler(this, messaging_verb::FORWARD_REQUEST, std::move(func));
+}
+future<> messaging_service::unregister_forward_request() {
+    return unregister_handler(messaging_verb::FORWARD_REQUEST);
+}
+future<query::forward_result> messaging_service::send_forward_request(msg_addr id, clock_type::time_point timeout, const query::forward_request& req) {
+    return send_message_timeout<query::forward_result>(this, messaging_verb::FORWARD_REQUEST, std::move(id), timeout, req);
+}
+
 } // namespace net
@@ -37,6 +37,7 @@
 #include "digest_algorithm.hh"
 #include "streaming/stream_reason.hh"
 #include "streaming/stream_mutation_fragments_cmd.hh"
+#include "streaming/stream_sstable_files_cmd.hh"
 #include "cache_temperature.hh"
 #include "service/paxos/prepare_response.hh"
 
@@ -80,6 +81,8 @@ namespace query {
     using partition_range = dht::partition_range;
     class read_command;
     class result;
+    struct forward_request;
+    struct forward_result;
 }
 
 namespace compat {
@@ -140,7 +143,16 @@ enum class messaging_verb : int32_t {
     PAXOS_LEARN = 41,
     HINT_MUTATION = 42,
     PAXOS_PRUNE = 43,
-    LAST = 44,
+    STREAM_SSTABLE_FILES = 44,
+    MUTATIONS = 45,
+    REPAIR_GET_ROW_HASH_SKETCH = 46,
+    ALTERNATOR_FORWARD_RMW = 47,
+    REPAIR_PREPARE_INCREMENTAL = 48,
+    REPAIR_FINISH_INCREMENTAL = 49,
+    REPAIR_UPDATE_HISTORY = 50,
+    FORWARD_REQUEST = 51,
+    READ_DATA_PARTITIONS = 52,
+    LAST = 53,
 };
 
 } // namespace netw
@@ -181,6 +193,8 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     struct shard_info {
         shard_info(shared_ptr<rpc_protocol_client_wrapper>&& client);
         shared_ptr<rpc_protocol_client_wrapper> rpc_client;
+        // Set if the connection's local port was chosen to reach a given shard.
+        bool bound_local_port = false;
         rpc::stats get_stats() const;
     };
 
@@ -205,6 +219,7 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
 
     enum class compress_what {
         none,
+        rack,
         dc,
         all,
     };
@@ -230,7 +245,11 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     uint16_t _ssl_port;
     encrypt_what _encrypt_what;
     compress_what _compress_what;
+    // The links, among the compressed ones, which prefer zstd to lz4.
+    compress_what _zstd_compress_what;
     tcp_nodelay_what _tcp_nodelay_what;
+    // Whether mutations and reads travel over per-destination-shard connections.
+    bool _shard_aware_connections;
     bool _should_listen_to_broadcast_address;
     // map: Node broadcast address -> Node internal IP for communication within the same data center
     std::unordered_map<gms::inet_address, gms::inet_address> _preferred_ip_cache;
@@ -239,6 +258,12 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     ::shared_ptr<seastar::tls::server_credentials> _credentials;
     std::array<std::unique_ptr<rpc_protocol_server_wrapper>, 2> _server_tls;
     std::array<clients_map, 4> _clients;
+    // Shard-aware statement connections, indexed by the destination shard.
+    std::vector<clients_map> _shard_clients;
+    // Failed connections bound to a chosen local port, by node. Reset when the
+    // node's connections are dropped.
+    std::unordered_map<gms::inet_address, unsigned> _shard_bind_failures;
+    static constexpr unsigned max_shard_bind_failures = 3;
     uint64_t _dropped_messages[static_cast<int32_t>(messaging_verb::LAST)] = {};
     bool _stopping = false;
     std::list<std::function<void(gms::inet_address ep)>> _connection_drop_notifiers;
@@ -249,8 +274,8 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
 public:
     messaging_service(gms::inet_address ip = gms::inet_address("0.0.0.0"),
             uint16_t port = 7000, bool listen_now = true);
-    messaging_service(gms::inet_address ip, uint16_t port, encrypt_what, compress_what, tcp_nodelay_what,
-            uint16_t ssl_port, std::shared_ptr<seastar::tls::credentials_builder>,
+    messaging_service(gms::inet_address ip, uint16_t port, encrypt_what, compress_what, compress_what zstd_cw, tcp_nodelay_what,
+            bool shard_aware_connections, uint16_t ssl_port, std::shared_ptr<seastar::tls::credentials_builder>,
             memory_config mcfg, scheduling_config scfg, bool sltba = false, bool listen_now = true);
     ~messaging_service();
 public:
@@ -290,15 +315,24 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     rpc::sink<int32_t> make_sink_for_stream_mutation_fragments(rpc::source<frozen_mutation_fragment, rpc::optional<streaming::stream_mutation_fragments_cmd>>& source);
     future<rpc::sink<frozen_mutation_fragment, streaming::stream_mutation_fragments_cmd>, rpc::source<int32_t>> make_sink_and_source_for_stream_mutation_fragments(utils::UUID schema_id, utils::UUID plan_id, utils::UUID cf_id, uint64_t estimated_partitions, streaming::stream_reason reason, msg_addr id);
 
+    // Wrapper for STREAM_SSTABLE_FILES
+    // Streams the component files of a single sstable as (component name, data) chunks, the components being sent one after another.
+    // The receiver rejects the stream by failing the handler, e.g. if its schema version differs, in which case the sender streams the
+    // sstable's content with STREAM_MUTATION_FRAGMENTS instead. Otherwise the status code sent by the receiver has the same meaning as
+    // for STREAM_MUTATION_FRAGMENTS.
+    void register_stream_sstable_files(std::function<future<rpc::sink<int32_t>> (const rpc::client_info& cinfo, UUID plan_id, UUID schema_id, UUID cf_id, streaming::stream_reason reason, sstring version, sstring format, rpc::source<sstring, bytes, streaming::stream_sstable_files_cmd> source)>&& func);
+    rpc::sink<int32_t> make_sink_for_stream_sstable_files(rpc::source<sstring, bytes, streaming::stream_sstable_files_cmd>& source);
+    future<rpc::sink<sstring, bytes, streaming::stream_sstable_files_cmd>, rpc::source<int32_t>> make_sink_and_source_for_stream_sstable_files(utils::UUID schema_id, utils::UUID plan_id, utils::UUID cf_id, streaming::stream_reason reason, sstring version, sstring format, msg_addr id);
+
     // Wrapper for REPAIR_GET_ROW_DIFF_WITH_RPC_STREAM
-    future<rpc::sink<repair_hash_with_cmd>, rpc::source<repair_row_on_wire_with_cmd>> make_sink_and_source_for_repair_get_row_diff_with_rpc_stream(uint32_t repair_meta_id, msg_addr id);
+    future<rpc::sink<repair_hash_with_cmd>, rpc::source<frozen_repair_row_on_wire_with_cmd>> make_sink_and_source_for_repair_get_row_diff_with_rpc_stream(uint32_t repair_meta_id, msg_addr id);
     rpc::sink<repair_row_on_wire_with_cmd> make_sink_for_repair_get_row_diff_with_rpc_stream(rpc::source<repair_hash_with_cmd>& source);
     void register_repair_get_row_diff_with_rpc_stream(std::function<future<rpc::sink<repair_row_on_wire_with_cmd>> (const rpc::client_info& cinfo, uint32_t repair_meta_id, rpc::source<repair_hash_with_cmd> source)>&& func);
 
     // Wrapper for REPAIR_PUT_ROW_DIFF_WITH_RPC_STREAM
     future<rpc::sink<repair_row_on_wire_with_cmd>, rpc::source<repair_stream_cmd>> make_sink_and_source_for_repair_put_row_diff_with_rpc_stream(uint32_t repair_meta_id, msg_addr id);
-    rpc::sink<repair_stream_cmd> make_sink_for_repair_put_row_diff_with_rpc_stream(rpc::source<repair_row_on_wire_with_cmd>& source);
-    void register_repair_put_row_diff_with_rpc_stream(std::function<future<rpc::sink<repair_stream_cmd>> (const rpc::client_info& cinfo, uint32_t repair_meta_id, rpc::source<repair_row_on_wire_with_cmd> source)>&& func);
+    rpc::sink<repair_stream_cmd> make_sink_for_repair_put_row_diff_with_rpc_stream(rpc::source<frozen_repair_row_on_wire_with_cmd>& source);
+    void register_repair_put_row_diff_with_rpc_stream(std::function<future<rpc::sink<repair_stream_cmd>> (const rpc::client_info& cinfo, uint32_t repair_meta_id, rpc::source<frozen_repair_row_on_wire_with_cmd> source)>&& func);
 
     // Wrapper for REPAIR_GET_FULL_ROW_HASHES_WITH_RPC_STREAM
     future<rpc::sink<repair_stream_cmd>, rpc::source<repair_hash_with_cmd>> make_sink_and_source_for_repair_get_full_row_hashes_with_rpc_stream(uint32_t repair_meta_id, msg_addr id);
@@ -321,6 +355,11 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     future<> unregister_repair_get_full_row_hashes();
     future<std::unordered_set<repair_hash>> send_repair_get_full_row_hashes(msg_addr id, uint32_t repair_meta_id);
 
+    // Wrapper for REPAIR_GET_ROW_HASH_SKETCH
+    void register_repair_get_row_hash_sketch(std::function<future<repair_hash_sketch> (const rpc::client_info& cinfo, uint32_t repair_meta_id, uint32_t cells, uint64_t seed)>&& func);
+    future<> unregister_repair_get_row_hash_sketch();
+    future<repair_hash_sketch> send_repair_get_row_hash_sketch(msg_addr id, uint32_t repair_meta_id, uint32_t cells, uint64_t seed);
+
     // Wrapper for REPAIR_GET_COMBINED_ROW_HASH
     void register_repair_get_combined_row_hash(std::function<future<get_combined_row_hash_response> (const rpc::client_info& cinfo, uint32_t repair_meta_id, std::optional<repair_sync_boundary> common_sync_boundary)>&& func);
     future<> unregister_repair_get_combined_row_hash();
@@ -334,17 +373,17 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     // Wrapper for REPAIR_GET_ROW_DIFF
     void register_repair_get_row_diff(std::function<future<repair_rows_on_wire> (const rpc::client_info& cinfo, uint32_t repair_meta_id, std::unordered_set<repair_hash> set_diff, bool needs_all_rows)>&& func);
     future<> unregister_repair_get_row_diff();
-    future<repair_rows_on_wire> send_repair_get_row_diff(msg_addr id, uint32_t repair_meta_id, std::unordered_set<repair_hash> set_diff, bool needs_all_rows);
+    future<frozen_repair_rows_on_wire> send_repair_get_row_diff(msg_addr id, uint32_t repair_meta_id, std::unordered_set<repair_hash> set_diff, bool needs_all_rows);
 
     // Wrapper for REPAIR_PUT_ROW_DIFF
-    void register_repair_put_row_diff(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, repair_rows_on_wire row_diff)>&& func);
+    void register_repair_put_row_diff(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, frozen_repair_rows_on_wire row_diff)>&& func);
     future<> unregister_repair_put_row_diff();
     future<> send_repair_put_row_diff(msg_addr id, uint32_t repair_meta_id, repair_rows_on_wire row_diff);
 
     // Wrapper for REPAIR_ROW_LEVEL_START
-    void register_repair_row_level_start(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version)>&& func);
+    void register_repair_row_level_start(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, rpc::optional<bool> incremental)>&& func);
     future<> unregister_repair_row_level_start();
-    future<> send_repair_row_level_start(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version);
+    future<> send_repair_row_level_start(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, bool incremental);
 
     // Wrapper for REPAIR_ROW_LEVEL_STOP
     void register_repair_row_level_stop(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range)>&& func);
@@ -366,10 +405,26 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     future<> unregister_repair_get_diff_algorithms();
     future<std::vector<row_level_diff_detect_algorithm>> send_repair_get_diff_algorithms(msg_addr id);
 
+    // Wrapper for REPAIR_PREPARE_INCREMENTAL
+    void register_repair_prepare_incremental(std::function<future<> (const rpc::client_info& cinfo, utils::UUID session, sstring keyspace_name, std::vector<sstring> cf_names)>&& func);
+    future<> unregister_repair_prepare_incremental();
+    future<> send_repair_prepare_incremental(msg_addr id, utils::UUID session, sstring keyspace_name, std::vector<sstring> cf_names);
+
+    // Wrapper for REPAIR_FINISH_INCREMENTAL
+    void register_repair_finish_incremental(std::function<future<> (const rpc::client_info& cinfo, utils::UUID session, dht::token_range_vector ranges, uint64_t repaired_at)>&& func);
+    future<> unregister_repair_finish_incremental();
+    future<> send_repair_finish_incremental(msg_addr id, utils::UUID session, dht::token_range_vector ranges, uint64_t repaired_at);
+
+    // Wrapper for REPAIR_UPDATE_HISTORY
+    void register_repair_update_history(std::function<future<> (const rpc::client_info& cinfo, sstring keyspace_name, std::vector<sstring> cf_names, dht::token_range_vector ranges, gc_clock::time_point repair_time)>&& func);
+    future<> unregister_repair_update_history();
+    future<> send_repair_update_history(msg_addr id, sstring keyspace_name, std::vector<sstring> cf_names, dht::token_range_vector ranges, gc_clock::time_point repair_time);
+
     // Wrapper for GOSSIP_ECHO verb
     void register_gossip_echo(std::function<future<> ()>&& func);
     future<> unregister_gossip_echo();
     future<> send_gossip_echo(msg_addr id);
+    future<> send_gossip_echo(msg_addr id, std::chrono::milliseconds timeout);
 
     // Wrapper for GOSSIP_SHUTDOWN
     void register_gossip_shutdown(std::function<rpc::no_wait_type (inet_address from)>&& func);
@@ -413,6 +468,15 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     future<> send_mutation(msg_addr id, clock_type::time_point timeout, const frozen_mutation& fm, std::vector<inet_address> forward,
         inet_address reply_to, unsigned shard, response_id_type response_id, std::optional<tracing::trace_info> trace_info = std::nullopt);
 
+    // Wrapper for MUTATIONS
+    // Carries several mutations for the same replica, each completed with
+    // its own MUTATION_DONE/MUTATION_FAILED reply. Mutations are not forwarded.
+    void register_mutations(std::function<future<rpc::no_wait_type> (const rpc::client_info&, rpc::opt_time_point, std::vector<frozen_mutation> fms,
+        inet_address reply_to, unsigned shard, std::vector<response_id_type> response_ids, std::optional<tracing::trace_info> trace_info)>&& func);
+    future<> unregister_mutations();
+    future<> send_mutations(msg_addr id, clock_type::time_point timeout, const std::vector<std::reference_wrapper<const frozen_mutation>>& fms,
+        inet_address reply_to, unsigned shard, std::vector<response_id_type> response_ids, std::optional<tracing::trace_info> trace_info = std::nullopt);
+
     // Wrapper for COUNTER_MUTATION
     void register_counter_mutation(std::function<future<> (const rpc::client_info&, rpc::opt_time_point, std::vector<frozen_mutation> fms, db::consistency_level cl, std::optional<tracing::trace_info> trace_info)>&& func);
     future<> unregister_counter_mutation();
@@ -434,6 +498,12 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     future<> unregister_read_data();
     future<rpc::tuple<query::result, rpc::optional<cache_temperature>>> send_read_data(msg_addr id, clock_type::time_point timeout, const query::read_command& cmd, const dht::partition_range& pr, query::digest_algorithm da);
 
+    // Wrapper for READ_DATA_PARTITIONS. Reads several partitions, each a
+    // singular range, into one result per partition, in the given order.
+    void register_read_data_partitions(std::function<future<rpc::tuple<std::vector<query::result>, cache_temperature>> (const rpc::client_info&, rpc::opt_time_point timeout, query::read_command cmd, dht::partition_range_vector ranges)>&& func);
+    future<> unregister_read_data_partitions();
+    future<rpc::tuple<std::vector<query::result>, cache_temperature>> send_read_data_partitions(msg_addr id, clock_type::time_point timeout, const query::read_command& cmd, const dht::partition_range_vector& ranges);
+
     // Wrapper for GET_SCHEMA_VERSION
     void register_get_schema_version(std::function<future<frozen_schema>(unsigned, table_schema_version)>&& func);
     future<> unregister_get_schema_version();
@@ -508,10 +578,29 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     future<> send_hint_mutation(msg_addr id, clock_type::time_point timeout, const frozen_mutation& fm, std::vector<inet_address> forward,
         inet_address reply_to, unsigned shard, response_id_type response_id, std::optional<tracing::trace_info> trace_info = std::nullopt);
 
+    // Wrapper for ALTERNATOR_FORWARD_RMW. Carries an Alternator operation
+    // name and its request JSON; returns a JSON with either the response
+    // body or the error.
+    void register_alternator_forward_rmw(std::function<future<sstring> (const rpc::client_info& cinfo, rpc::opt_time_point timeout, sstring op, sstring request)>&& func);
+    future<> unregister_alternator_forward_rmw();
+    future<sstring> send_alternator_forward_rmw(gms::inet_address peer, clock_type::time_point timeout, const sstring& op, const sstring& request);
+
+    // Wrapper for FORWARD_REQUEST. Asks a node to compute the partial
+    // aggregates of a read over some of its token ranges.
+    void register_forward_request(std::function<future<query::forward_result> (const rpc::client_info& cinfo, rpc::opt_time_point timeout, query::forward_request req)>&& func);
+    future<> unregister_forward_request();
+    future<query::forward_result> send_forward_request(msg_addr id, clock_type::time_point timeout, const query::forward_request& req);
+
     void foreach_server_connection_stats(std::function<void(const rpc::client_info&, const rpc::stats&)>&& f) const;
 private:
     bool remove_rpc_client_one(clients_map& clients, msg_addr id, bool dead_only);
+    clients_map& clients_for(messaging_verb verb, msg_addr id);
 public:
+    // Returns the address to send a mutation or a read of the partition with
+    // the given token to: with shard-aware connections, the cpu_id is the
+    // shard of ep owning the token, so that the request travels over the
+    // connection landing on that shard.
+    msg_addr addr_for_token(gms::inet_address ep, const dht::token& t) const;
     // Return rpc::protocol::client for a shard which is a ip + cpuid pair.
     shared_ptr<rpc_protocol_client_wrapper> get_rpc_client(messaging_verb verb, msg_addr id);
     void remove_error_rpc_client(messaging_verb verb, msg_addr id);
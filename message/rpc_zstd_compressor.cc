@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <array>
+
+#include <seastar/core/byteorder.hh>
+
+#include "message/rpc_zstd_compressor.hh"
+#include "seastarx.hh"
+#include "zstd/lib/zstd.h"
+
+namespace netw {
+
+using namespace seastar::rpc;
+
+static constexpr size_t header_size = sizeof(uint32_t);
+
+namespace {
+
+struct cctx_deleter {
+    void operator()(ZSTD_CCtx* ctx) const { ZSTD_freeCCtx(ctx); }
+};
+
+struct dctx_deleter {
+    void operator()(ZSTD_DCtx* ctx) const { ZSTD_freeDCtx(ctx); }
+};
+
+}
+
+// Shared by all connections of the shard. Frames are (de)compressed in one
+// go, without preemption, so a context is never used by two frames at once.
+static thread_local std::unique_ptr<ZSTD_CCtx, cctx_deleter> cctx;
+static thread_local std::unique_ptr<ZSTD_DCtx, dctx_deleter> dctx;
+
+static ZSTD_CCtx* get_cctx() {
+    if (!cctx) {
+        cctx.reset(ZSTD_createCCtx());
+        if (!cctx) {
+            throw std::bad_alloc();
+        }
+        ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, rpc_zstd_compressor::compression_level);
+    }
+    return cctx.get();
+}
+
+static ZSTD_DCtx* get_dctx() {
+    if (!dctx) {
+        dctx.reset(ZSTD_createDCtx());
+        if (!dctx) {
+            throw std::bad_alloc();
+        }
+    }
+    return dctx.get();
+}
+
+template <typename Func>
+static void for_each_fragment(std::variant<std::vector<temporary_buffer<char>>, temporary_buffer<char>>& bufs, Func&& func) {
+    if (auto* single = std::get_if<temporary_buffer<char>>(&bufs)) {
+        func(*single);
+    } else {
+        for (auto& b : std::get<std::vector<temporary_buffer<char>>>(bufs)) {
+            func(b);
+        }
+    }
+}
+
+std::unique_ptr<compressor> rpc_zstd_compressor::factory::negotiate(sstring feature, bool is_server) const {
+    return feature == _name ? std::make_unique<rpc_zstd_compressor>() : nullptr;
+}
+
+snd_buf rpc_zstd_compressor::compress(size_t head_space, snd_buf data) {
+    auto ctx = get_cctx();
+    ZSTD_CCtx_reset(ctx, ZSTD_reset_session_only);
+    ZSTD_CCtx_setPledgedSrcSize(ctx, data.size);
+
+    // Enough for the whole output, so that the common case of a small
+    // message fits in a single buffer.
+    const size_t bound = head_space + header_size + ZSTD_compressBound(data.size);
+    std::vector<temporary_buffer<char>> chunks;
+    size_t size = 0;
+    ZSTD_outBuffer out{nullptr, 0, 0};
+    auto next_chunk = [&] {
+        if (!chunks.empty()) {
+            chunks.back().trim(out.pos);
+            size += out.pos;
+        }
+        auto chunk_size = std::min(snd_buf::chunk_size, bound > size ? bound - size : snd_buf::chunk_size);
+        chunks.emplace_back(chunk_size);
+        out = ZSTD_outBuffer{chunks.back().get_write(), chunks.back().size(), 0};
+    };
+    next_chunk();
+    out.pos = head_space + header_size;
+
+    auto compress_fragment = [&] (const char* p, size_t n, ZSTD_EndDirective mode) {
+        ZSTD_inBuffer in{p, n, 0};
+        size_t ret;
+        do {
+            if (out.pos == out.size) {
+                next_chunk();
+            }
+            ret = ZSTD_compressStream2(ctx, &out, &in, mode);
+            if (ZSTD_isError(ret)) {
+                throw std::runtime_error(format("RPC frame zstd compression failure: {}", ZSTD_getErrorName(ret)));
+            }
+        } while (mode == ZSTD_e_end ? ret != 0 : in.pos < in.size);
+    };
+    for_each_fragment(data.bufs, [&] (temporary_buffer<char>& b) {
+        compress_fragment(b.get(), b.size(), ZSTD_e_continue);
+    });
+    compress_fragment(nullptr, 0, ZSTD_e_end);
+    chunks.back().trim(out.pos);
+    size += out.pos;
+
+    write_le<uint32_t>(chunks.front().get_write() + head_space, data.size);
+    if (chunks.size() == 1) {
+        return snd_buf(std::move(chunks.front()));
+    }
+    snd_buf ret;
+    ret.size = size;
+    ret.bufs = std::move(chunks);
+    return ret;
+}
+
+rcv_buf rpc_zstd_compressor::decompress(rcv_buf data) {
+    if (data.size < header_size) {
+        throw std::runtime_error(format("Truncated zstd RPC frame of {:d} bytes", data.size));
+    }
+    auto ctx = get_dctx();
+    ZSTD_DCtx_reset(ctx, ZSTD_reset_session_only);
+
+    std::array<char, header_size> header;
+    size_t header_pos = 0;
+    uint32_t expected = 0;
+    std::vector<temporary_buffer<char>> chunks;
+    size_t chunk = 0;
+    size_t size = 0;
+    ZSTD_outBuffer out{nullptr, 0, 0};
+    size_t ret = 1;
+
+    auto allocate = [&] {
+        expected = read_le<uint32_t>(header.data());
+        for (size_t left = expected; left;) {
+            auto n = std::min(left, snd_buf::chunk_size);
+            chunks.emplace_back(n);
+            left -= n;
+        }
+        if (!chunks.empty()) {
+            out = ZSTD_outBuffer{chunks.front().get_write(), chunks.front().size(), 0};
+        }
+    };
+    auto decompress_fragment = [&] (const char* p, size_t n) {
+        ZSTD_inBuffer in{p, n, 0};
+        while (in.pos < in.size) {
+            if (out.pos == out.size && chunk + 1 < chunks.size()) {
+                size += out.pos;
+                ++chunk;
+                out = ZSTD_outBuffer{chunks[chunk].get_write(), chunks[chunk].size(), 0};
+            }
+            auto in_pos = in.pos;
+            auto out_pos = out.pos;
+            ret = ZSTD_decompressStream(ctx, &out, &in);
+            if (ZSTD_isError(ret)) {
+                throw std::runtime_error(format("RPC frame zstd decompression failure: {}", ZSTD_getErrorName(ret)));
+            }
+            if (in.pos == in_pos && out.pos == out_pos) {
+                throw std::runtime_error(format("zstd RPC frame exceeds its declared size of {:d} bytes", expected));
+            }
+        }
+    };
+    for_each_fragment(data.bufs, [&] (temporary_buffer<char>& b) {
+        auto p = b.get();
+        auto n = b.size();
+        if (header_pos < header_size) {
+            auto h = std::min(n, header_size - header_pos);
+            std::copy_n(p, h, header.data() + header_pos);
+            header_pos += h;
+            p += h;
+            n -= h;
+            if (header_pos == header_size) {
+                allocate();
+            }
+        }
+        if (n) {
+            decompress_fragment(p, n);
+        }
+    });
+    size += out.pos;
+    if (ret != 0 || size != expected) {
+        throw std::runtime_error(format("Truncated zstd RPC frame: got {:d} of {:d} bytes", size, expected));
+    }
+
+    if (chunks.size() == 1) {
+        return rcv_buf(std::move(chunks.front()));
+    }
+    rcv_buf result;
+    result.size = size;
+    result.bufs = std::move(chunks);
+    return result;
+}
+
+sstring rpc_zstd_compressor::name() const {
+    return factory{}.supported();
+}
+
+}
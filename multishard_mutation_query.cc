@@ -448,6 +448,10 @@ future<> read_context::save_reader(shard_id shard, const dht::decorated_key& las
             flat_mutation_reader_opt reader = try_resume(rm.rparts->semaphore, std::move(*rm.handle));
 
             if (!reader) {
+                // Evicted while paused, the next page will have to create a
+                // new reader on this shard.
+                tracing::trace(gts.get(), "Reader on shard {} was evicted before it could be saved", shard);
+                ++db.get_stats().multishard_query_evicted_reader_saves;
                 return;
             }
 
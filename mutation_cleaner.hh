@@ -30,7 +30,8 @@ class mutation_cleaner;
 
 class mutation_cleaner_impl final {
     using snapshot_list = boost::intrusive::slist<partition_snapshot,
-        boost::intrusive::member_hook<partition_snapshot, boost::intrusive::slist_member_hook<>, &partition_snapshot::_cleaner_hook>>;
+        boost::intrusive::member_hook<partition_snapshot, boost::intrusive::slist_member_hook<>, &partition_snapshot::_cleaner_hook>,
+        boost::intrusive::cache_last<true>>;
     struct worker {
         condition_variable cv;
         snapshot_list snapshots;
@@ -71,6 +72,7 @@ class mutation_cleaner_impl final {
     bool empty() const noexcept { return _versions.empty(); }
     future<> drain();
     void merge_and_destroy(partition_snapshot&) noexcept;
+    size_t pending_version_merges() const noexcept;
     void set_scheduling_group(seastar::scheduling_group sg) {
         _scheduling_group = sg;
         _worker_state->cv.broadcast();
@@ -99,7 +101,14 @@ void mutation_cleaner_impl::merge_and_destroy(partition_snapshot& ps) noexcept {
         // The snapshot must not be reachable by partitino_entry::read() after this,
         // which is ensured by slide_to_oldest() == stop_iteration::no.
         ps.migrate(&_region, _cleaner);
-        _worker_state->snapshots.push_front(ps);
+        // Partitions which accumulated the most versions are the most
+        // expensive to read, so they jump the queue.
+        auto& snapshots = _worker_state->snapshots;
+        if (snapshots.empty() || ps.mergeable_version_count() > snapshots.front().mergeable_version_count()) {
+            snapshots.push_front(ps);
+        } else {
+            snapshots.push_back(ps);
+        }
         _worker_state->cv.signal();
     }
 }
@@ -178,6 +187,11 @@ class mutation_cleaner final {
         return _impl->drain();
     }
 
+    // Returns the number of partition versions waiting to be merged by the background worker.
+    size_t pending_version_merges() const noexcept {
+        return _impl->pending_version_merges();
+    }
+
     // Will merge given snapshot using partition_snapshot::merge_partition_versions() and then destroys it
     // using destroy_from_this(), possibly deferring in between.
     // This instance becomes the sole owner of the partition_snapshot object, the caller should not destroy it
@@ -133,6 +133,8 @@ class compact_mutation_state {
     const schema& _schema;
     gc_clock::time_point _query_time;
     gc_clock::time_point _gc_before;
+    // If set, the gc_before of each partition, which then doesn't follow gc_grace_seconds.
+    std::function<gc_clock::time_point(const dht::decorated_key&)> _get_gc_before;
     std::function<api::timestamp_type(const dht::decorated_key&)> _get_max_purgeable;
     can_gc_fn _can_gc;
     api::timestamp_type _max_purgeable = api::missing_timestamp;
@@ -154,6 +156,15 @@ class compact_mutation_state {
 
     std::optional<static_row> _last_static_row;
 
+    // Filters of a data query, see query::partition_slice::filters().
+    bool _has_static_filters{};
+    bool _has_regular_filters{};
+    bool _static_row_matches{};
+    // With filters on regular columns, a static row is emitted only along
+    // with the first matching clustering row.
+    std::optional<static_row> _pending_static_row;
+    tombstone _pending_static_row_tombstone;
+
     std::unique_ptr<mutation_compactor_garbage_collector> _collector;
 private:
     static constexpr bool only_live() {
@@ -163,6 +174,16 @@ class compact_mutation_state {
         return SSTableCompaction == compact_for_sstables::yes;
     }
 
+    bool has_filters() const {
+        return _has_static_filters || _has_regular_filters;
+    }
+
+    bool matches_filters(bool is_static, const row& cells) const {
+        return std::all_of(_slice.filters().begin(), _slice.filters().end(), [&] (const query::column_filter& f) {
+            return f.is_static != is_static || f.matches(_schema, cells, _query_time);
+        });
+    }
+
     template <typename GCConsumer>
     void partition_is_not_empty_for_gc_consumer(GCConsumer& gc_consumer) {
         if (_empty_partition_in_gc_consumer) {
@@ -230,13 +251,20 @@ class compact_mutation_state {
         , _last_dk({dht::token(), partition_key::make_empty()})
     {
         static_assert(!sstable_compaction(), "This constructor cannot be used for sstable compaction.");
+        if (only_live()) {
+            for (auto& f : _slice.filters()) {
+                (f.is_static ? _has_static_filters : _has_regular_filters) = true;
+            }
+        }
     }
 
     compact_mutation_state(const schema& s, gc_clock::time_point compaction_time,
-            std::function<api::timestamp_type(const dht::decorated_key&)> get_max_purgeable)
+            std::function<api::timestamp_type(const dht::decorated_key&)> get_max_purgeable,
+            std::function<gc_clock::time_point(const dht::decorated_key&)> get_gc_before = {})
         : _schema(s)
         , _query_time(compaction_time)
         , _gc_before(saturating_subtract(_query_time, s.gc_grace_seconds()))
+        , _get_gc_before(std::move(get_gc_before))
         , _get_max_purgeable(std::move(get_max_purgeable))
         , _can_gc([this] (tombstone t) { return can_gc(t); })
         , _slice(s.full_slice())
@@ -261,7 +289,12 @@ class compact_mutation_state {
         _range_tombstones.clear();
         _current_partition_limit = std::min(_row_limit, _partition_row_limit);
         _max_purgeable = api::missing_timestamp;
+        if (_get_gc_before) {
+            _gc_before = _get_gc_before(dk);
+        }
         _last_static_row.reset();
+        _static_row_matches = !_has_static_filters;
+        _pending_static_row.reset();
     }
 
     template <typename Consumer, typename GCConsumer>
@@ -299,9 +332,20 @@ class compact_mutation_state {
             });
         }
         _static_row_live = is_live;
-        if (is_live || (!only_live() && !sr.empty())) {
+        if (_has_static_filters) {
+            _static_row_matches = is_live && matches_filters(true, sr.cells());
+            _static_row_live = _static_row_matches;
+        }
+        if (_has_regular_filters && _static_row_live) {
+            // The static row doesn't make a result row of its own.
+            _static_row_live = false;
+            _pending_static_row.emplace(std::move(sr));
+            _pending_static_row_tombstone = current_tombstone;
+            return stop_iteration::no;
+        }
+        if (_static_row_live || (!only_live() && !sr.empty())) {
             partition_is_not_empty(consumer);
-            return consumer.consume(std::move(sr), current_tombstone, is_live);
+            return consumer.consume(std::move(sr), current_tombstone, _static_row_live);
         }
         return stop_iteration::no;
     }
@@ -344,8 +388,15 @@ class compact_mutation_state {
         }
 
         if (only_live() && is_live) {
+            if (has_filters() && (!_static_row_matches || !matches_filters(false, cr.cells()))) {
+                return stop_iteration::no;
+            }
             partition_is_not_empty(consumer);
-            auto stop = consumer.consume(std::move(cr), t, true);
+            auto stop = stop_iteration::no;
+            if (_pending_static_row) {
+                stop = consumer.consume(std::move(*std::exchange(_pending_static_row, {})), _pending_static_row_tombstone, true);
+            }
+            stop = consumer.consume(std::move(cr), t, true) || stop;
             if (++_rows_in_current_partition == _current_partition_limit) {
                 return stop_iteration::yes;
             }
@@ -453,6 +504,7 @@ class compact_mutation_state {
         _current_partition_limit = std::min(_row_limit, _partition_row_limit);
         _query_time = query_time;
         _gc_before = saturating_subtract(query_time, _schema.gc_grace_seconds());
+        _pending_static_row.reset();
 
         if ((next_fragment_kind == mutation_fragment::kind::clustering_row || next_fragment_kind == mutation_fragment::kind::range_tombstone)
                 && _last_static_row) {
@@ -498,8 +550,9 @@ class compact_mutation {
     }
 
     compact_mutation(const schema& s, gc_clock::time_point compaction_time,
-            std::function<api::timestamp_type(const dht::decorated_key&)> get_max_purgeable, Consumer consumer, GCConsumer gc_consumer = GCConsumer())
-        : _state(make_lw_shared<compact_mutation_state<OnlyLive, SSTableCompaction>>(s, compaction_time, get_max_purgeable))
+            std::function<api::timestamp_type(const dht::decorated_key&)> get_max_purgeable, Consumer consumer, GCConsumer gc_consumer = GCConsumer(),
+            std::function<gc_clock::time_point(const dht::decorated_key&)> get_gc_before = {})
+        : _state(make_lw_shared<compact_mutation_state<OnlyLive, SSTableCompaction>>(s, compaction_time, get_max_purgeable, std::move(get_gc_before)))
         , _consumer(std::move(consumer))
         , _gc_consumer(std::move(gc_consumer)) {
     }
@@ -271,9 +271,7 @@ mutation_fragment_opt range_tombstone_stream::get_next()
 }
 
 void range_tombstone_stream::forward_to(position_in_partition_view pos) {
-    _list.erase_where([this, &pos] (const range_tombstone& rt) {
-        return !_cmp(pos, rt.end_position());
-    });
+    _list.erase_before(_schema, pos);
 }
 
 void range_tombstone_stream::apply(const range_tombstone_list& list, const query::clustering_range& range, bool trim_front) {
@@ -32,7 +32,7 @@
 #include "mutation_query.hh"
 #include "service/priority_manager.hh"
 #include "mutation_compactor.hh"
-#include "intrusive_set_external_comparator.hh"
+#include "utils/intrusive_btree.hh"
 #include "counters.hh"
 #include "row_cache.hh"
 #include "view_info.hh"
@@ -180,7 +180,9 @@ mutation_partition::mutation_partition(const mutation_partition& x, const schema
     try {
         for(auto&& r : ck_ranges) {
             for (const rows_entry& e : x.range(schema, r)) {
-                _rows.insert(_rows.end(), *current_allocator().construct<rows_entry>(schema, e), rows_entry::compare(schema));
+                auto ce = alloc_strategy_unique_ptr<rows_entry>(current_allocator().construct<rows_entry>(schema, e));
+                _rows.insert(_rows.end(), *ce, rows_entry::compare(schema));
+                ce.release();
             }
             for (auto&& rt : x._row_tombstones.slice(schema, r)) {
                 _row_tombstones.apply(schema, rt);
@@ -247,8 +249,10 @@ mutation_partition::operator=(mutation_partition&& x) noexcept {
 void mutation_partition::ensure_last_dummy(const schema& s) {
     check_schema(s);
     if (_rows.empty() || !_rows.rbegin()->is_last_dummy()) {
-        _rows.insert_before(_rows.end(),
-            *current_allocator().construct<rows_entry>(s, rows_entry::last_dummy_tag(), is_continuous::yes));
+        auto e = alloc_strategy_unique_ptr<rows_entry>(
+            current_allocator().construct<rows_entry>(s, rows_entry::last_dummy_tag(), is_continuous::yes));
+        _rows.insert_before(_rows.end(), *e);
+        e.release();
     }
 }
 
@@ -332,11 +336,15 @@ stop_iteration mutation_partition::apply_monotonically(const schema& s, mutation
       try {
         rows_entry& src_e = *p_i;
         if (i != _rows.end() && less(*i, src_e)) {
-            i = _rows.lower_bound(src_e, less);
+            // Rows appended after the last one, as time series writes are,
+            // don't need a lookup.
+            i = less(*std::prev(_rows.end()), src_e) ? _rows.end() : _rows.lower_bound(src_e, less);
         }
         if (i == _rows.end() || less(src_e, *i)) {
-            p_i = p._rows.erase(p_i);
+            // Inserting moves src_e out of p once it can no longer fail.
+            auto next_p_i = std::next(p_i);
             auto src_i = _rows.insert_before(i, src_e);
+            p_i = next_p_i;
             // When falling into a continuous range, preserve continuity.
             if (i != _rows.end() && i->continuous()) {
                 src_e.set_continuous(true);
@@ -526,7 +534,7 @@ void mutation_partition::apply_insert(const schema& s, clustering_key_view key,
 }
 void mutation_partition::insert_row(const schema& s, const clustering_key& key, deletable_row&& row) {
     auto e = alloc_strategy_unique_ptr<rows_entry>(
-        current_allocator().construct<rows_entry>(key, std::move(row)));
+        current_allocator().construct<rows_entry>(s, key, std::move(row)));
     _rows.insert(_rows.end(), *e, rows_entry::compare(s));
     e.release();
 }
@@ -542,7 +550,7 @@ void mutation_partition::insert_row(const schema& s, const clustering_key& key,
 const row*
 mutation_partition::find_row(const schema& s, const clustering_key& key) const {
     check_schema(s);
-    auto i = _rows.find(key, rows_entry::compare(s));
+    auto i = _rows.find(rows_entry::encoded_position(s, position_in_partition_view::for_key(key)), rows_entry::compare(s));
     if (i == _rows.end()) {
         return nullptr;
     }
@@ -552,10 +560,11 @@ mutation_partition::find_row(const schema& s, const clustering_key& key) const {
 deletable_row&
 mutation_partition::clustered_row(const schema& s, clustering_key&& key) {
     check_schema(s);
-    auto i = _rows.find(key, rows_entry::compare(s));
+    rows_entry::encoded_position pos(s, position_in_partition_view::for_key(key));
+    auto i = _rows.find(pos, rows_entry::compare(s));
     if (i == _rows.end()) {
         auto e = alloc_strategy_unique_ptr<rows_entry>(
-            current_allocator().construct<rows_entry>(std::move(key)));
+            current_allocator().construct<rows_entry>(std::move(key), pos));
         i = _rows.insert(i, *e, rows_entry::compare(s));
         e.release();
     }
@@ -565,10 +574,11 @@ mutation_partition::clustered_row(const schema& s, clustering_key&& key) {
 deletable_row&
 mutation_partition::clustered_row(const schema& s, const clustering_key& key) {
     check_schema(s);
-    auto i = _rows.find(key, rows_entry::compare(s));
+    rows_entry::encoded_position pos(s, position_in_partition_view::for_key(key));
+    auto i = _rows.find(pos, rows_entry::compare(s));
     if (i == _rows.end()) {
         auto e = alloc_strategy_unique_ptr<rows_entry>(
-            current_allocator().construct<rows_entry>(key));
+            current_allocator().construct<rows_entry>(clustering_key(key), pos));
         i = _rows.insert(i, *e, rows_entry::compare(s));
         e.release();
     }
@@ -581,7 +591,7 @@ mutation_partition::clustered_row(const schema& s, clustering_key_view key) {
     auto i = _rows.find(key, rows_entry::compare(s));
     if (i == _rows.end()) {
         auto e = alloc_strategy_unique_ptr<rows_entry>(
-            current_allocator().construct<rows_entry>(key));
+            current_allocator().construct<rows_entry>(s, key));
         i = _rows.insert(i, *e, rows_entry::compare(s));
         e.release();
     }
@@ -591,7 +601,7 @@ mutation_partition::clustered_row(const schema& s, clustering_key_view key) {
 deletable_row&
 mutation_partition::clustered_row(const schema& s, position_in_partition_view pos, is_dummy dummy, is_continuous continuous) {
     check_schema(s);
-    auto i = _rows.find(pos, rows_entry::compare(s));
+    auto i = _rows.find(rows_entry::encoded_position(s, pos), rows_entry::compare(s));
     if (i == _rows.end()) {
         auto e = alloc_strategy_unique_ptr<rows_entry>(
             current_allocator().construct<rows_entry>(s, pos, dummy, continuous));
@@ -607,7 +617,7 @@ mutation_partition::lower_bound(const schema& schema, const query::clustering_ra
     if (!r.start()) {
         return std::cbegin(_rows);
     }
-    return _rows.lower_bound(position_in_partition_view::for_range_start(r), rows_entry::compare(schema));
+    return _rows.lower_bound(rows_entry::encoded_position(schema, position_in_partition_view::for_range_start(r)), rows_entry::compare(schema));
 }
 
 mutation_partition::rows_type::const_iterator
@@ -616,7 +626,7 @@ mutation_partition::upper_bound(const schema& schema, const query::clustering_ra
     if (!r.end()) {
         return std::cend(_rows);
     }
-    return _rows.lower_bound(position_in_partition_view::for_range_end(r), rows_entry::compare(schema));
+    return _rows.lower_bound(rows_entry::encoded_position(schema, position_in_partition_view::for_range_end(r)), rows_entry::compare(schema));
 }
 
 boost::iterator_range<mutation_partition::rows_type::const_iterator>
@@ -785,7 +795,59 @@ struct appending_hash<row> {
     }
 };
 
+// Layout of a packed row:
+//
+//   uint8_t flags
+//   uint8_t number of column ids covered by the presence bitmap
+//   uint8_t presence bitmap, (number of column ids + 7) / 8 bytes
+//   int64_t timestamps, just one when packed_row_shared_timestamp is set,
+//           otherwise one per present cell
+//   values of the present cells, in column id order, each taking exactly
+//           the fixed size of its column's type
+//
+// Value lengths aren't stored, so a packed row can only be decoded using the
+// schema it was packed with.
+static constexpr uint8_t packed_row_shared_timestamp = 1;
+
+static size_t packed_row_bitmap_size(size_t columns) {
+    return (columns + 7) / 8;
+}
+
+// Calls func(column_id, api::timestamp_type, bytes_view value) for each cell
+// of a packed row.
+template<typename Func>
+static void for_each_packed_cell(const schema& s, column_kind kind, const managed_bytes& packed, Func&& func) {
+    bytes_view data = packed;
+    auto flags = uint8_t(data[0]);
+    auto columns = uint8_t(data[1]);
+    auto bitmap = data.data() + 2;
+    auto timestamps = bitmap + packed_row_bitmap_size(columns);
+    auto is_present = [bitmap] (column_id id) {
+        return (uint8_t(bitmap[id / 8]) >> (id % 8)) & 1;
+    };
+    unsigned present = 0;
+    for (column_id id = 0; id < columns; ++id) {
+        present += is_present(id);
+    }
+    auto values = timestamps + sizeof(api::timestamp_type) * (flags & packed_row_shared_timestamp ? 1 : present);
+    unsigned idx = 0;
+    for (column_id id = 0; id < columns; ++id) {
+        if (!is_present(id)) {
+            continue;
+        }
+        api::timestamp_type ts;
+        std::memcpy(&ts, timestamps + sizeof(ts) * (flags & packed_row_shared_timestamp ? 0 : idx), sizeof(ts));
+        auto size = *s.column_at(kind, id).type->value_length_if_fixed();
+        func(id, ts, bytes_view(values, size));
+        values += size;
+        ++idx;
+    }
+}
+
 cell_hash_opt row::cell_hash_for(column_id id) const {
+    if (_type == storage_type::packed) {
+        return cell_hash_opt();
+    }
     if (_type == storage_type::vector) {
         return id < max_vector_size && _storage.vector.present.test(id) ? _storage.vector.v[id].hash : cell_hash_opt();
     }
@@ -797,6 +859,10 @@ cell_hash_opt row::cell_hash_for(column_id id) const {
 }
 
 void row::prepare_hash(const schema& s, column_kind kind) const {
+    if (_type == storage_type::packed) {
+        // Packed rows don't keep cell hashes, they are computed when needed.
+        return;
+    }
     // const to avoid removing const qualifiers on the read path
     for_each_cell([&s, kind] (column_id id, const cell_and_hash& c_a_h) {
         if (!c_a_h.hash) {
@@ -808,6 +874,9 @@ void row::prepare_hash(const schema& s, column_kind kind) const {
 }
 
 void row::clear_hash() const {
+    if (_type == storage_type::packed) {
+        return;
+    }
     for_each_cell([] (column_id, const cell_and_hash& c_a_h) {
         c_a_h.hash = { };
     });
@@ -981,6 +1050,11 @@ operator<<(std::ostream& os, const row::printer& p) {
         );
     };
 
+    if (p._row._type == row::storage_type::packed) {
+        row unpacked(p._schema, p._kind, p._row);
+        return os << row::printer(p._schema, p._kind, unpacked);
+    }
+
     sstring cells;
     switch (p._row._type) {
     case row::storage_type::set:
@@ -989,6 +1063,8 @@ operator<<(std::ostream& os, const row::printer& p) {
     case row::storage_type::vector:
         cells = ::join(",", prefixed("\n      ", p._row.get_range_vector() | boost::adaptors::transformed(add_printer)));
         break;
+    case row::storage_type::packed:
+        break;
     }
     return fmt_print(os, "{{row: {}}}", cells);
 }
@@ -1208,6 +1284,7 @@ row::apply_monotonically(const column_definition& column, atomic_cell_or_collect
                   && std::is_nothrow_move_assignable<atomic_cell_or_collection>::value,
                   "noexcept required for atomicity");
 
+    assert(_type != storage_type::packed);
     // our mutations are not yet immutable
     auto id = column.id;
     if (_type == storage_type::vector && id < max_vector_size) {
@@ -1241,6 +1318,7 @@ row::apply_monotonically(const column_definition& column, atomic_cell_or_collect
 
 void
 row::append_cell(column_id id, atomic_cell_or_collection value) {
+    assert(_type != storage_type::packed);
     if (_type == storage_type::vector && id < max_vector_size) {
         if (_storage.vector.v.size() > id) {
             on_internal_error(mplog, format("Attempted to append cell#{} to row already having {} cells", id, _storage.vector.v.size()));
@@ -1260,6 +1338,7 @@ row::append_cell(column_id id, atomic_cell_or_collection value) {
 
 const cell_and_hash*
 row::find_cell_and_hash(column_id id) const {
+    assert(_type != storage_type::packed);
     if (_type == storage_type::vector) {
         if (id >= _storage.vector.v.size() || !_storage.vector.present.test(id)) {
             return nullptr;
@@ -1282,7 +1361,9 @@ row::find_cell(column_id id) const {
 
 size_t row::external_memory_usage(const schema& s, column_kind kind) const {
     size_t mem = 0;
-    if (_type == storage_type::vector) {
+    if (_type == storage_type::packed) {
+        mem += _storage.packed.external_memory_usage();
+    } else if (_type == storage_type::vector) {
         mem += _storage.vector.v.used_space_external_memory_usage();
         column_id id = 0;
         for (auto&& c_a_h : _storage.vector.v) {
@@ -1298,8 +1379,28 @@ size_t row::external_memory_usage(const schema& s, column_kind kind) const {
     return mem;
 }
 
+void rows_entry::encode_position(const schema& s) {
+    auto encoder = s.clustering_position_encoder();
+    if (!encoder) {
+        return;
+    }
+    clustering_position_encoder::buffer buf;
+    if (encoder->encode(position(), buf)) {
+        _encoded_position = managed_bytes(bytes_view(buf.data(), buf.size()));
+    }
+}
+
+rows_entry::encoded_position::encoded_position(const schema& s, position_in_partition_view pos)
+    : _position(pos)
+{
+    auto encoder = s.clustering_position_encoder();
+    if (encoder && !encoder->encode(pos, _encoded)) {
+        _encoded.clear();
+    }
+}
+
 size_t rows_entry::memory_usage(const schema& s) const {
-    size_t size = 0;
+    size_t size = _encoded_position.external_memory_usage();
     if (!dummy()) {
         size += key().external_memory_usage();
     }
@@ -1315,6 +1416,7 @@ size_t mutation_partition::external_memory_usage(const schema& s) const {
     for (auto& clr : clustered_rows()) {
         sum += clr.memory_usage(s);
     }
+    sum += clustered_rows().external_memory_usage();
 
     for (auto& rtb : row_tombstones()) {
         sum += rtb.memory_usage(s);
@@ -1478,6 +1580,14 @@ deletable_row::is_live(const schema& s, tombstone base_tombstone, gc_clock::time
 
 bool
 row::is_live(const schema& s, column_kind kind, tombstone base_tombstone, gc_clock::time_point query_time) const {
+    if (_type == storage_type::packed) {
+        // All cells of a packed row are live and don't expire.
+        bool any_live = false;
+        for_each_packed_cell(s, kind, _storage.packed, [&] (column_id, api::timestamp_type ts, bytes_view) {
+            any_live |= ts > base_tombstone.timestamp;
+        });
+        return any_live;
+    }
     return has_any_live_data(s, kind, *this, base_tombstone, query_time);
 }
 
@@ -1514,6 +1624,7 @@ mutation_partition::row_count() const {
 rows_entry::rows_entry(rows_entry&& o) noexcept
     : _link(std::move(o._link))
     , _key(std::move(o._key))
+    , _encoded_position(std::move(o._encoded_position))
     , _row(std::move(o._row))
     , _lru_link()
     , _flags(std::move(o._flags))
@@ -1529,7 +1640,16 @@ row::row(const schema& s, column_kind kind, const row& o)
     : _type(o._type)
     , _size(o._size)
 {
-    if (_type == storage_type::vector) {
+    if (_type == storage_type::packed) {
+        _type = storage_type::vector;
+        new (&_storage.vector) vector_storage;
+        try {
+            o.unpack_into(s, kind, _storage.vector);
+        } catch (...) {
+            _storage.vector.~vector_storage();
+            throw;
+        }
+    } else if (_type == storage_type::vector) {
         auto& other_vec = o._storage.vector;
         auto& vec = *new (&_storage.vector) vector_storage;
         try {
@@ -1562,6 +1682,8 @@ row::row(const schema& s, column_kind kind, const row& o)
 row::~row() {
     if (_type == storage_type::vector) {
         _storage.vector.~vector_storage();
+    } else if (_type == storage_type::packed) {
+        _storage.packed.~managed_bytes();
     } else {
         _storage.set.clear_and_dispose(current_deleter<cell_entry>());
         _storage.set.~map_type();
@@ -1591,6 +1713,90 @@ const atomic_cell_or_collection& row::cell_at(column_id id) const {
     return *cell;
 }
 
+bool row::pack(const schema& s, column_kind kind) noexcept {
+    if (_type != storage_type::vector || empty()) {
+        return _type == storage_type::packed;
+    }
+    auto& vec = _storage.vector;
+    size_t values_size = 0;
+    std::optional<api::timestamp_type> shared_ts;
+    bool timestamps_match = true;
+    for (auto id : bitsets::for_each_set(vec.present)) {
+        auto& cdef = s.column_at(kind, id);
+        auto fixed_size = cdef.type->value_length_if_fixed();
+        if (!cdef.is_atomic() || cdef.is_counter() || !fixed_size) {
+            return false;
+        }
+        auto cell = vec.v[id].cell.as_atomic_cell(cdef);
+        if (!cell.is_live() || cell.is_live_and_has_ttl() || cell.value().size_bytes() != *fixed_size) {
+            return false;
+        }
+        if (!shared_ts) {
+            shared_ts = cell.timestamp();
+        }
+        timestamps_match &= *shared_ts == cell.timestamp();
+        values_size += *fixed_size;
+    }
+
+    auto columns = vec.v.size();
+    size_t timestamps = timestamps_match ? 1 : _size;
+    auto size = 2 + packed_row_bitmap_size(columns) + sizeof(api::timestamp_type) * timestamps + values_size;
+    if (managed_bytes::external_memory_usage_for(size) >= external_memory_usage(s, kind)) {
+        return false;
+    }
+    try {
+        managed_bytes packed(managed_bytes::initialized_later(), size);
+        auto out = packed.data();
+        std::fill_n(out, 2 + packed_row_bitmap_size(columns), 0);
+        out[0] = timestamps_match ? packed_row_shared_timestamp : 0;
+        out[1] = columns;
+        auto bitmap = out + 2;
+        auto ts_out = bitmap + packed_row_bitmap_size(columns);
+        auto value_out = ts_out + sizeof(api::timestamp_type) * timestamps;
+        if (timestamps_match) {
+            std::memcpy(ts_out, &*shared_ts, sizeof(api::timestamp_type));
+        }
+        for (auto id : bitsets::for_each_set(vec.present)) {
+            auto& cdef = s.column_at(kind, id);
+            auto cell = vec.v[id].cell.as_atomic_cell(cdef);
+            bitmap[id / 8] = uint8_t(bitmap[id / 8]) | (1 << (id % 8));
+            if (!timestamps_match) {
+                auto ts = cell.timestamp();
+                std::memcpy(ts_out, &ts, sizeof(ts));
+                ts_out += sizeof(ts);
+            }
+            auto value = cell.value().first_fragment();
+            value_out = std::copy(value.begin(), value.end(), value_out);
+        }
+        vec.~vector_storage();
+        new (&_storage.packed) managed_bytes(std::move(packed));
+        _type = storage_type::packed;
+        return true;
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+}
+
+void row::unpack_into(const schema& s, column_kind kind, vector_storage& vec) const {
+    assert(_type == storage_type::packed);
+    for_each_packed_cell(s, kind, _storage.packed, [&] (column_id id, api::timestamp_type ts, bytes_view value) {
+        vec.v.resize(id);
+        vec.v.emplace_back(atomic_cell::make_live(*s.column_at(kind, id).type, ts, value), cell_hash_opt());
+        vec.present.set(id);
+    });
+}
+
+void row::unpack(const schema& s, column_kind kind) {
+    if (_type != storage_type::packed) {
+        return;
+    }
+    vector_storage vec;
+    unpack_into(s, kind, vec);
+    _storage.packed.~managed_bytes();
+    new (&_storage.vector) vector_storage(std::move(vec));
+    _type = storage_type::vector;
+}
+
 void row::vector_to_set()
 {
     assert(_type == storage_type::vector);
@@ -1645,6 +1851,12 @@ bool row::equal(column_kind kind, const schema& this_schema, const row& other, c
     if (size() != other.size()) {
         return false;
     }
+    if (_type == storage_type::packed) {
+        return row(this_schema, kind, *this).equal(kind, this_schema, other, other_schema);
+    }
+    if (other._type == storage_type::packed) {
+        return equal(kind, this_schema, row(other_schema, kind, other), other_schema);
+    }
 
     auto cells_equal = [&] (std::pair<column_id, const atomic_cell_or_collection&> c1,
                             std::pair<column_id, const atomic_cell_or_collection&> c2) {
@@ -1668,6 +1880,12 @@ row::row(row&& other) noexcept
     : _type(other._type), _size(other._size) {
     if (_type == storage_type::vector) {
         new (&_storage.vector) vector_storage(std::move(other._storage.vector));
+    } else if (_type == storage_type::packed) {
+        new (&_storage.packed) managed_bytes(std::move(other._storage.packed));
+        // Leave other as an empty regular row, it may be applied to later.
+        other._storage.packed.~managed_bytes();
+        new (&other._storage.vector) vector_storage;
+        other._type = storage_type::vector;
     } else {
         new (&_storage.set) map_type(std::move(other._storage.set));
     }
@@ -1686,6 +1904,11 @@ void row::apply(const schema& s, column_kind kind, const row& other) {
     if (other.empty()) {
         return;
     }
+    if (other._type == storage_type::packed) {
+        apply_monotonically(s, kind, row(s, kind, other));
+        return;
+    }
+    unpack(s, kind);
     if (other._type == storage_type::vector) {
         reserve(other._storage.vector.v.size() - 1);
     } else {
@@ -1704,6 +1927,12 @@ void row::apply_monotonically(const schema& s, column_kind kind, row&& other) {
     if (other.empty()) {
         return;
     }
+    if (empty() && other._type == storage_type::packed) {
+        *this = std::move(other);
+        return;
+    }
+    unpack(s, kind);
+    other.unpack(s, kind);
     if (other._type == storage_type::vector) {
         reserve(other._storage.vector.v.size() - 1);
     } else {
@@ -1739,6 +1968,7 @@ bool row::compact_and_expire(
     if (dead_marker_shadows_row(s, kind, marker)) {
         tomb.apply(shadowable_tombstone(api::max_timestamp, gc_clock::time_point::max()), row_marker());
     }
+    unpack(s, kind);
     bool any_live = false;
     remove_if([&] (column_id id, atomic_cell_or_collection& c) {
         bool erase = false;
@@ -1844,6 +2074,9 @@ deletable_row deletable_row::difference(const schema& s, column_kind kind, const
 
 row row::difference(const schema& s, column_kind kind, const row& other) const
 {
+    if (_type == storage_type::packed || other._type == storage_type::packed) {
+        return row(s, kind, *this).difference(s, kind, row(s, kind, other));
+    }
     row r;
     with_both_ranges(other, [&] (auto this_range, auto other_range) {
         auto it = other_range.begin();
@@ -1946,14 +2179,19 @@ void mutation_partition::accept(const schema& s, mutation_partition_visitor& v)
     for (const rows_entry& e : _rows) {
         const deletable_row& dr = e.row();
         v.accept_row(e.position(), dr.deleted_at(), dr.marker(), e.dummy(), e.continuous());
-        dr.cells().for_each_cell([&] (column_id id, const atomic_cell_or_collection& cell) {
+        auto accept_cell = [&] (column_id id, const atomic_cell_or_collection& cell) {
             const column_definition& def = s.regular_column_at(id);
             if (def.is_atomic()) {
                 v.accept_row_cell(id, cell.as_atomic_cell(def));
             } else {
                 v.accept_row_cell(id, cell.as_collection_mutation());
             }
-        });
+        };
+        if (dr.cells().is_packed()) {
+            row(s, column_kind::regular_column, dr.cells()).for_each_cell(accept_cell);
+        } else {
+            dr.cells().for_each_cell(accept_cell);
+        }
     }
 }
 
@@ -1967,6 +2205,13 @@ mutation_partition::upgrade(const schema& old_schema, const schema& new_schema)
     *this = std::move(tmp);
 }
 
+void mutation_partition::pack_rows(const schema& s) noexcept {
+    check_schema(s);
+    for (rows_entry& e : _rows) {
+        e.row().cells().pack(s, column_kind::regular_column);
+    }
+}
+
 // Adds mutation to query::result.
 class mutation_querier {
     const schema& _schema;
@@ -2354,8 +2599,10 @@ mutation_partition::mutation_partition(mutation_partition::incomplete_tag, const
     , _schema_version(s.version())
 #endif
 {
-    _rows.insert_before(_rows.end(),
-        *current_allocator().construct<rows_entry>(s, rows_entry::last_dummy_tag(), is_continuous::no));
+    auto e = alloc_strategy_unique_ptr<rows_entry>(
+        current_allocator().construct<rows_entry>(s, rows_entry::last_dummy_tag(), is_continuous::no));
+    _rows.insert_before(_rows.end(), *e);
+    e.release();
 }
 
 bool mutation_partition::is_fully_continuous() const {
@@ -2392,13 +2639,18 @@ void mutation_partition::set_continuity(const schema& s, const position_range& p
 
     auto end = _rows.lower_bound(pr.end(), less);
     if (end == _rows.end() || less(pr.end(), end->position())) {
-        end = _rows.insert_before(end, *current_allocator().construct<rows_entry>(s, pr.end(), is_dummy::yes,
+        auto e = alloc_strategy_unique_ptr<rows_entry>(current_allocator().construct<rows_entry>(s, pr.end(), is_dummy::yes,
             end == _rows.end() ? is_continuous::yes : end->continuous()));
+        end = _rows.insert_before(end, *e);
+        e.release();
     }
 
     auto i = _rows.lower_bound(pr.start(), less);
     if (less(pr.start(), i->position())) {
-        i = _rows.insert_before(i, *current_allocator().construct<rows_entry>(s, pr.start(), is_dummy::yes, i->continuous()));
+        auto e = alloc_strategy_unique_ptr<rows_entry>(
+            current_allocator().construct<rows_entry>(s, pr.start(), is_dummy::yes, i->continuous()));
+        i = _rows.insert_before(i, *e);
+        e.release();
     }
 
     assert(i != end);
@@ -2631,14 +2883,29 @@ stop_iteration mutation_cleaner_impl::merge_some() noexcept {
     if (_worker_state->snapshots.empty()) {
         return stop_iteration::yes;
     }
-    partition_snapshot& snp = _worker_state->snapshots.front();
+    auto& snapshots = _worker_state->snapshots;
+    partition_snapshot& snp = snapshots.front();
     if (merge_some(snp) == stop_iteration::yes) {
-        _worker_state->snapshots.pop_front();
+        snapshots.pop_front();
         lw_shared_ptr<partition_snapshot>::dispose(&snp);
+    } else {
+        // merge_partition_versions() resumes where it left off, so rotate
+        // the snapshot to the back to let the other partitions make progress
+        // instead of having a single large one monopolize the worker.
+        snapshots.pop_front();
+        snapshots.push_back(snp);
     }
     return stop_iteration::no;
 }
 
+size_t mutation_cleaner_impl::pending_version_merges() const noexcept {
+    size_t count = 0;
+    for (const partition_snapshot& snp : _worker_state->snapshots) {
+        count += snp.mergeable_version_count();
+    }
+    return count;
+}
+
 future<> mutation_cleaner_impl::drain() {
     return repeat([this] {
         return merge_some();
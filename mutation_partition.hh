@@ -36,6 +36,7 @@
 #include "tombstone.hh"
 #include "keys.hh"
 #include "position_in_partition.hh"
+#include "clustering_position_encoder.hh"
 #include "atomic_cell_or_collection.hh"
 #include "query-result.hh"
 #include "mutation_partition_view.hh"
@@ -44,10 +45,11 @@
 #include "hashing_partition_visitor.hh"
 #include "range_tombstone_list.hh"
 #include "clustering_key_filter.hh"
-#include "intrusive_set_external_comparator.hh"
+#include "utils/intrusive_btree.hh"
 #include "utils/with_relational_operators.hh"
 #include "utils/preempt.hh"
 #include "utils/managed_ref.hh"
+#include "utils/managed_bytes.hh"
 
 class mutation_fragment;
 class clustering_row;
@@ -98,6 +100,11 @@ class compaction_garbage_collector;
 //
 // Can be used as a range of row::cell_entry.
 //
+// Rows held by the memtable and the cache can be packed (see pack()), which
+// stores all cells in a single buffer. A packed row supports only the
+// operations which are given the schema; accessing its cells directly
+// requires unpacking it first, and copying it yields an unpacked row.
+//
 class row {
 
     class cell_entry {
@@ -144,6 +151,7 @@ class row {
     enum class storage_type {
         vector,
         set,
+        packed,
     };
     storage_type _type = storage_type::vector;
     size_type _size = 0;
@@ -175,6 +183,7 @@ class row {
         ~storage() { }
         map_type set;
         vector_storage vector;
+        managed_bytes packed;
     } _storage;
 public:
     row();
@@ -184,6 +193,19 @@ class row {
     row& operator=(row&& other) noexcept;
     size_t size() const { return _size; }
     bool empty() const { return _size == 0; }
+    bool is_packed() const { return _type == storage_type::packed; }
+
+    // Packs the row into a single buffer holding a presence bitmap, the
+    // timestamps (just one if all cells share it) and the values of its
+    // cells. Only rows made solely of live, non-expiring cells of fixed-size
+    // types can be packed, and only if that saves memory. Cached cell hashes
+    // are dropped.
+    // Returns true iff the row is packed. Leaves the row unchanged on failure.
+    bool pack(const schema&, column_kind) noexcept;
+
+    // Converts a packed row back to the regular representation.
+    // Strong exception guarantees.
+    void unpack(const schema&, column_kind);
 
     void reserve(column_id);
 
@@ -196,6 +218,7 @@ class row {
 private:
     template<typename Func>
     void remove_if(Func&& func) {
+        assert(_type != storage_type::packed);
         if (_type == storage_type::vector) {
             for (unsigned i = 0; i < _storage.vector.v.size(); i++) {
                 if (!_storage.vector.present.test(i)) {
@@ -243,6 +266,9 @@ class row {
 
     void vector_to_set();
 
+    // Fills vec with the cells of this packed row.
+    void unpack_into(const schema&, column_kind, vector_storage& vec) const;
+
     template<typename Func>
     void consume_with(Func&&);
 
@@ -262,6 +288,7 @@ class row {
     // noexcept if Func doesn't throw.
     template<typename Func>
     void for_each_cell(Func&& func) {
+        assert(_type != storage_type::packed);
         if (_type == storage_type::vector) {
             for (auto i : bitsets::for_each_set(_storage.vector.present)) {
                 maybe_invoke_with_hash(func, i, _storage.vector.v[i]);
@@ -275,6 +302,7 @@ class row {
 
     template<typename Func>
     void for_each_cell(Func&& func) const {
+        assert(_type != storage_type::packed);
         if (_type == storage_type::vector) {
             for (auto i : bitsets::for_each_set(_storage.vector.present)) {
                 maybe_invoke_with_hash(func, i, _storage.vector.v[i]);
@@ -288,6 +316,7 @@ class row {
 
     template<typename Func>
     void for_each_cell_until(Func&& func) const {
+        assert(_type != storage_type::packed);
         if (_type == storage_type::vector) {
             for (auto i : bitsets::for_each_set(_storage.vector.present)) {
                 if (maybe_invoke_with_hash(func, i, _storage.vector.v[i]) == stop_iteration::yes) {
@@ -998,12 +1027,22 @@ class deletable_row final {
 
 class cache_tracker;
 
+// Segments of the cache LRU, see cache_tracker.
+enum class lru_segment {
+    main,
+    probationary,
+};
+
 class rows_entry {
     using lru_link_type = bi::list_member_hook<bi::link_mode<bi::auto_unlink>>;
     friend class cache_tracker;
     friend class size_calculator;
-    intrusive_set_external_comparator_member_hook _link;
+    intrusive_b::member_hook _link;
     clustering_key _key;
+    // Byte-comparable encoding of position(), see clustering_position_encoder.
+    // Empty if the schema has no encoder or the position couldn't be encoded,
+    // in which case comparisons decode the key.
+    managed_bytes _encoded_position;
     deletable_row _row;
     lru_link_type _lru_link;
     struct flags {
@@ -1015,10 +1054,26 @@ class rows_entry {
         // Marks a dummy entry which is after_all_clustered_rows() position.
         // Needed so that eviction, which can't use comparators, can check if it's dealing with it.
         bool _last_dummy : 1;
-        flags() : _before_ck(0), _after_ck(0), _continuous(true), _dummy(false), _last_dummy(false) { }
+        // Set when linked into the probationary segment of the cache LRU.
+        bool _probationary : 1;
+        flags() : _before_ck(0), _after_ck(0), _continuous(true), _dummy(false), _last_dummy(false), _probationary(false) { }
     } _flags{};
     friend class mutation_partition;
+    void encode_position(const schema& s);
 public:
+    // A position together with its byte-comparable encoding, for lookups
+    // which compare one position with many entries.
+    class encoded_position {
+        position_in_partition_view _position;
+        clustering_position_encoder::buffer _encoded;
+    public:
+        // Refers to pos, which must outlive the object.
+        encoded_position(const schema& s, position_in_partition_view pos);
+        position_in_partition_view position() const { return _position; }
+        // Empty if the position couldn't be encoded.
+        bytes_view encoded() const { return bytes_view(_encoded.data(), _encoded.size()); }
+    };
+
     struct last_dummy_tag {};
     explicit rows_entry(clustering_key&& key)
         : _key(std::move(key))
@@ -1026,6 +1081,22 @@ class rows_entry {
     explicit rows_entry(const clustering_key& key)
         : _key(key)
     { }
+    rows_entry(const schema& s, clustering_key&& key)
+        : _key(std::move(key))
+    {
+        encode_position(s);
+    }
+    rows_entry(const schema& s, const clustering_key& key)
+        : _key(key)
+    {
+        encode_position(s);
+    }
+    // Takes the encoding of the position from pos, which must be the
+    // encoded_position of key.
+    rows_entry(clustering_key&& key, const encoded_position& pos)
+        : _key(std::move(key))
+        , _encoded_position(pos.encoded())
+    { }
     rows_entry(const schema& s, position_in_partition_view pos, is_dummy dummy, is_continuous continuous)
         : _key(pos.key())
     {
@@ -1034,6 +1105,7 @@ class rows_entry {
         _flags._continuous = bool(continuous);
         _flags._before_ck = pos.is_before_key();
         _flags._after_ck = pos.is_after_key();
+        encode_position(s);
     }
     rows_entry(const schema& s, last_dummy_tag, is_continuous continuous)
         : rows_entry(s, position_in_partition_view::after_all_clustered_rows(), is_dummy::yes, continuous)
@@ -1041,15 +1113,25 @@ class rows_entry {
     rows_entry(const clustering_key& key, deletable_row&& row)
         : _key(key), _row(std::move(row))
     { }
+    rows_entry(const schema& s, const clustering_key& key, deletable_row&& row)
+        : _key(key), _row(std::move(row))
+    {
+        encode_position(s);
+    }
     rows_entry(const schema& s, const clustering_key& key, const deletable_row& row)
         : _key(key), _row(s, row)
-    { }
+    {
+        encode_position(s);
+    }
     rows_entry(const schema& s, const clustering_key& key, row_tombstone tomb, const row_marker& marker, const row& row)
         : _key(key), _row(s, tomb, marker, row)
-    { }
+    {
+        encode_position(s);
+    }
     rows_entry(rows_entry&& o) noexcept;
     rows_entry(const schema& s, const rows_entry& e)
         : _key(e._key)
+        , _encoded_position(e._encoded_position)
         , _row(s, e._row)
         , _flags(e._flags)
     { }
@@ -1090,9 +1172,33 @@ class rows_entry {
     struct tri_compare {
         position_in_partition::tri_compare _c;
         explicit tri_compare(const schema& s) : _c(s) {}
+        static int compare_encoded(const managed_bytes& a, const managed_bytes& b) {
+            if (__builtin_expect(a.is_fragmented() || b.is_fragmented(), false)) {
+                return compare_unsigned(a.fragments(), b.fragments());
+            }
+            return compare_unsigned(bytes_view(a), bytes_view(b));
+        }
+        static int compare_encoded(const managed_bytes& a, bytes_view b) {
+            if (__builtin_expect(a.is_fragmented(), false)) {
+                return compare_unsigned(a.fragments(), single_fragment_range(b));
+            }
+            return compare_unsigned(bytes_view(a), b);
+        }
         int operator()(const rows_entry& e1, const rows_entry& e2) const {
+            if (!e1._encoded_position.empty() && !e2._encoded_position.empty()) {
+                return compare_encoded(e1._encoded_position, e2._encoded_position);
+            }
             return _c(e1.position(), e2.position());
         }
+        int operator()(const rows_entry& e, const encoded_position& p) const {
+            if (!e._encoded_position.empty() && !p.encoded().empty()) {
+                return compare_encoded(e._encoded_position, p.encoded());
+            }
+            return _c(e.position(), p.position());
+        }
+        int operator()(const encoded_position& p, const rows_entry& e) const {
+            return -(*this)(e, p);
+        }
         int operator()(const clustering_key& key, const rows_entry& e) const {
             return _c(position_in_partition_view::for_key(key), e.position());
         }
@@ -1115,6 +1221,12 @@ class rows_entry {
         bool operator()(const rows_entry& e1, const rows_entry& e2) const {
             return _c(e1, e2) < 0;
         }
+        bool operator()(const rows_entry& e, const encoded_position& p) const {
+            return _c(e, p) < 0;
+        }
+        bool operator()(const encoded_position& p, const rows_entry& e) const {
+            return _c(p, e) < 0;
+        }
         bool operator()(const clustering_key& key, const rows_entry& e) const {
             return _c(key, e) < 0;
         }
@@ -1206,7 +1318,7 @@ struct mutation_application_stats {
 // in the doc in partition_version.hh.
 class mutation_partition final {
 public:
-    using rows_type = intrusive_set_external_comparator<rows_entry, &rows_entry::_link>;
+    using rows_type = intrusive_b::tree<rows_entry, &rows_entry::_link>;
     friend class rows_entry;
     friend class size_calculator;
 private:
@@ -1361,6 +1473,9 @@ class mutation_partition final {
     //
     // Strong exception guarantees.
     void upgrade(const schema& old_schema, const schema& new_schema);
+
+    // Packs the cells of clustering rows, where possible. See row::pack().
+    void pack_rows(const schema&) noexcept;
 private:
     void insert_row(const schema& s, const clustering_key& key, deletable_row&& row);
     void insert_row(const schema& s, const clustering_key& key, const deletable_row& row);
@@ -292,8 +292,13 @@ mutation_partition_view mutation_partition_view::from_view(ser::mutation_partiti
 
 mutation_fragment frozen_mutation_fragment::unfreeze(const schema& s)
 {
-    auto in = ser::as_input_stream(_bytes);
-    auto view = ser::deserialize(in, boost::type<ser::mutation_fragment_view>());
+    return unfreeze_mutation_fragment(s, ser::as_input_stream(_bytes));
+}
+
+// The key of a partition_start is decorated with dkey when it is given, so
+// that the tokens of many fragments can be computed together.
+static mutation_fragment unfreeze_mutation_fragment(const schema& s, ser::mutation_fragment_view view, std::optional<dht::decorated_key> dkey)
+{
     return seastar::visit(view.fragment(),
         [&] (ser::clustering_row_view crv) {
             class clustering_row_builder {
@@ -340,8 +345,10 @@ mutation_fragment frozen_mutation_fragment::unfreeze(const schema& s)
             return mutation_fragment(range_tombstone(rt));
         },
         [&] (ser::partition_start_view ps) {
-            auto dkey = dht::decorate_key(s, ps.key());
-            return mutation_fragment(partition_start(std::move(dkey), ps.partition_tombstone()));
+            if (!dkey) {
+                dkey = dht::decorate_key(s, ps.key());
+            }
+            return mutation_fragment(partition_start(std::move(*dkey), ps.partition_tombstone()));
         },
         [] (partition_end) {
             return mutation_fragment(partition_end());
@@ -351,3 +358,42 @@ mutation_fragment frozen_mutation_fragment::unfreeze(const schema& s)
         }
     );
 }
+
+mutation_fragment unfreeze_mutation_fragment(const schema& s, utils::input_stream in)
+{
+    auto view = ser::deserialize(in, boost::type<ser::mutation_fragment_view>());
+    return unfreeze_mutation_fragment(s, std::move(view), std::nullopt);
+}
+
+std::vector<mutation_fragment> unfreeze(const schema& s, const std::vector<frozen_mutation_fragment>& fmfs)
+{
+    std::vector<ser::mutation_fragment_view> views;
+    std::vector<size_t> partition_starts;
+    std::vector<partition_key> keys;
+    views.reserve(fmfs.size());
+    for (auto& fmf : fmfs) {
+        auto in = ser::as_input_stream(fmf.representation());
+        views.push_back(ser::deserialize(in, boost::type<ser::mutation_fragment_view>()));
+        seastar::visit(views.back().fragment(),
+            [&] (ser::partition_start_view ps) {
+                partition_starts.push_back(views.size() - 1);
+                keys.push_back(ps.key());
+            },
+            [] (auto&&) { }
+        );
+    }
+    auto tokens = dht::get_tokens(s, std::vector<partition_key_view>(keys.begin(), keys.end()));
+
+    std::vector<mutation_fragment> mfs;
+    mfs.reserve(views.size());
+    size_t next = 0;
+    for (size_t i = 0; i < views.size(); ++i) {
+        std::optional<dht::decorated_key> dkey;
+        if (next < partition_starts.size() && partition_starts[next] == i) {
+            dkey.emplace(std::move(tokens[next]), std::move(keys[next]));
+            ++next;
+        }
+        mfs.push_back(unfreeze_mutation_fragment(s, std::move(views[i]), std::move(dkey)));
+    }
+    return mfs;
+}
@@ -121,6 +121,16 @@ class mutation_fragment_merger {
         });
     }
 
+    // Passes the fragments which need no merging straight from the
+    // producer to the consumer, bypassing operator(). Such fragments are
+    // available only when no batch is pending.
+    template <typename Consumer>
+    void consume_unmerged(Consumer&& consumer) {
+        if (empty()) {
+            _producer.consume_single_reader_fragments(consumer);
+        }
+    }
+
     void next_partition() {
         _producer.next_partition();
     }
@@ -236,6 +246,12 @@ class mutation_reader_merger {
     // Produces the next batch of mutation-fragments of the same
     // position.
     future<mutation_fragment_batch> operator()(db::timeout_clock::time_point timeout);
+    // When a single reader owns the current partition, moves the fragments
+    // it has buffered to consumer, until consumer returns stop_iteration::yes
+    // or the partition ends. This avoids one operator() call, and its
+    // continuation, per fragment.
+    template <typename Consumer>
+    void consume_single_reader_fragments(Consumer& consumer);
     void next_partition();
     future<> fast_forward_to(const dht::partition_range& pr, db::timeout_clock::time_point timeout);
     future<> fast_forward_to(position_range pr, db::timeout_clock::time_point timeout);
@@ -441,6 +457,20 @@ mutation_reader_merger::mutation_reader_merger(schema_ptr schema,
     maybe_add_readers(std::nullopt);
 }
 
+template <typename Consumer>
+void mutation_reader_merger::consume_single_reader_fragments(Consumer& consumer) {
+    while (_single_reader.reader != reader_iterator{} && !_single_reader.reader->is_buffer_empty()) {
+        auto mf = _single_reader.reader->pop_mutation_fragment();
+        _single_reader.last_kind = mf.mutation_fragment_kind();
+        if (mf.is_end_of_partition()) {
+            _next.emplace_back(std::exchange(_single_reader.reader, {}), mutation_fragment::kind::partition_end);
+        }
+        if (consumer(std::move(mf))) {
+            return;
+        }
+    }
+}
+
 future<mutation_reader_merger::mutation_fragment_batch> mutation_reader_merger::operator()(db::timeout_clock::time_point timeout) {
     // Avoid merging-related logic if we know that only a single reader owns
     // current partition.
@@ -579,6 +609,13 @@ combined_mutation_reader::combined_mutation_reader(schema_ptr schema,
 
 future<> combined_mutation_reader::fill_buffer(db::timeout_clock::time_point timeout) {
     return repeat([this, timeout] {
+        _producer.consume_unmerged([this] (mutation_fragment&& mf) {
+            push_mutation_fragment(std::move(mf));
+            return stop_iteration(is_buffer_full());
+        });
+        if (is_buffer_full()) {
+            return make_ready_future<stop_iteration>(stop_iteration::yes);
+        }
         return _producer(timeout).then([this] (mutation_fragment_opt mfo) {
             if (!mfo) {
                 _end_of_stream = true;
@@ -982,10 +1019,30 @@ flat_mutation_reader make_foreign_reader(schema_ptr schema,
 
 namespace {
 
+// Bounds of the buffers a shard reader has its remote reader fill. The
+// minimum is the default buffer size of flat_mutation_reader::impl.
+static constexpr size_t min_remote_buffer_size = 8 * 1024;
+static constexpr size_t max_remote_buffer_size = 256 * 1024;
+// A remote buffer may use at most this fraction of the memory the semaphore of
+// the remote shard has left for reads.
+static constexpr size_t remote_buffer_memory_share = 16;
+
+size_t remote_buffer_budget(const reader_concurrency_semaphore& semaphore) {
+    const auto memory = semaphore.available_resources().memory;
+    if (memory <= 0) {
+        return min_remote_buffer_size;
+    }
+    return std::clamp(size_t(memory) / remote_buffer_memory_share, min_remote_buffer_size, max_remote_buffer_size);
+}
+
 // A special-purpose shard reader.
 //
 // Shard reader manages a reader located on a remote shard. It transparently
-// supports read-ahead (background fill_buffer() calls).
+// supports read-ahead (background fill_buffer() calls). The size of the
+// buffers the remote reader fills adapts to the consumer: it grows when the
+// consumer has to wait for a buffer and shrinks when buffered data is thrown
+// away. It never exceeds the budget derived from the memory the remote shard's
+// reader semaphore has available.
 // This reader is not for general use, it was designed to serve the
 // multishard_combining_reader.
 // Although it implements the flat_mutation_reader:impl interface it cannot be
@@ -995,11 +1052,14 @@ class shard_reader : public enable_lw_shared_from_this<shard_reader>, public fla
     struct fill_buffer_result {
         foreign_ptr<std::unique_ptr<const circular_buffer<mutation_fragment>>> buffer;
         bool end_of_stream = false;
+        // The largest buffer the remote shard's semaphore allows for now.
+        size_t buffer_budget = min_remote_buffer_size;
 
         fill_buffer_result() = default;
-        fill_buffer_result(circular_buffer<mutation_fragment> buffer, bool end_of_stream)
+        fill_buffer_result(circular_buffer<mutation_fragment> buffer, bool end_of_stream, size_t buffer_budget)
             : buffer(make_foreign(std::make_unique<const circular_buffer<mutation_fragment>>(std::move(buffer))))
-            , end_of_stream(end_of_stream) {
+            , end_of_stream(end_of_stream)
+            , buffer_budget(buffer_budget) {
         }
     };
 
@@ -1045,7 +1105,8 @@ class shard_reader : public enable_lw_shared_from_this<shard_reader>, public fla
                 const io_priority_class& pc,
                 tracing::trace_state_ptr trace_state,
                 mutation_reader::forwarding fwd_mr);
-        future<fill_buffer_result> fill_buffer(const dht::partition_range& pr, bool pending_next_partition, db::timeout_clock::time_point timeout);
+        future<fill_buffer_result> fill_buffer(const dht::partition_range& pr, bool pending_next_partition, size_t max_buffer_size,
+                db::timeout_clock::time_point timeout);
         future<> fast_forward_to(const dht::partition_range& pr, db::timeout_clock::time_point timeout);
         reader_concurrency_semaphore::inactive_read_handle inactive_read_handle() && {
             return std::move(_irh);
@@ -1064,6 +1125,8 @@ class shard_reader : public enable_lw_shared_from_this<shard_reader>, public fla
     bool _stopped = false;
     std::optional<future<>> _read_ahead;
     foreign_ptr<std::unique_ptr<remote_reader>> _reader;
+    size_t _remote_buffer_size = min_remote_buffer_size;
+    size_t _remote_buffer_budget = min_remote_buffer_size;
 
 private:
     future<> do_fill_buffer(db::timeout_clock::time_point timeout);
@@ -1110,6 +1173,22 @@ class shard_reader : public enable_lw_shared_from_this<shard_reader>, public fla
     bool is_read_ahead_in_progress() const {
         return _read_ahead.has_value();
     }
+    bool is_read_ahead_ready() const {
+        return _read_ahead && _read_ahead->available();
+    }
+    // False until the first buffer fill is started.
+    bool is_created() const {
+        return _reader || _read_ahead;
+    }
+    // The consumer had to wait for a buffer: have larger ones filled, within
+    // the budget last reported by the remote shard.
+    void grow_remote_buffer() {
+        _remote_buffer_size = std::max(std::min(_remote_buffer_size * 2, _remote_buffer_budget), _remote_buffer_size);
+    }
+    // Buffered data was thrown away: have smaller buffers filled.
+    void shrink_remote_buffer() {
+        _remote_buffer_size = std::max(_remote_buffer_size / 2, min_remote_buffer_size);
+    }
 };
 
 void shard_reader::stop() noexcept {
@@ -1342,22 +1421,24 @@ shard_reader::remote_reader::remote_reader(
 }
 
 future<shard_reader::fill_buffer_result> shard_reader::remote_reader::fill_buffer(const dht::partition_range& pr, bool pending_next_partition,
-        db::timeout_clock::time_point timeout) {
+        size_t max_buffer_size, db::timeout_clock::time_point timeout) {
     // We could have missed a `fast_forward_to()` if the reader wasn't created yet.
     _pr = &pr;
     if (pending_next_partition) {
         _next_position_in_partition = position_in_partition::for_partition_start();
     }
     return do_with(resume_or_create_reader(), circular_buffer<mutation_fragment>{},
-            [this, pending_next_partition, timeout] (flat_mutation_reader& reader, circular_buffer<mutation_fragment>& buffer) mutable {
+            [this, pending_next_partition, max_buffer_size, timeout] (flat_mutation_reader& reader, circular_buffer<mutation_fragment>& buffer) mutable {
+        const auto budget = remote_buffer_budget(_lifecycle_policy.semaphore());
+        reader.set_max_buffer_size(std::min(max_buffer_size, budget));
         if (pending_next_partition) {
             reader.next_partition();
         }
 
-        return fill_buffer(reader, buffer, timeout).then([this, &reader, &buffer] {
+        return fill_buffer(reader, buffer, timeout).then([this, &reader, &buffer, budget] {
             const auto eos = reader.is_end_of_stream() && reader.is_buffer_empty();
             _irh = _lifecycle_policy.pause(std::move(reader));
-            return fill_buffer_result(std::move(buffer), eos);
+            return fill_buffer_result(std::move(buffer), eos, budget);
         });
     });
 }
@@ -1383,6 +1464,7 @@ future<> shard_reader::remote_reader::fast_forward_to(const dht::partition_range
 future<> shard_reader::do_fill_buffer(db::timeout_clock::time_point timeout) {
     auto fill_buf_fut = make_ready_future<fill_buffer_result>();
     const auto pending_next_partition = std::exchange(_pending_next_partition, false);
+    const auto max_buffer_size = _remote_buffer_size;
 
     struct reader_and_buffer_fill_result {
         foreign_ptr<std::unique_ptr<remote_reader>> reader;
@@ -1390,9 +1472,9 @@ future<> shard_reader::do_fill_buffer(db::timeout_clock::time_point timeout) {
     };
 
     if (!_reader) {
-        fill_buf_fut = smp::submit_to(_shard, [this, gs = global_schema_ptr(_schema), pending_next_partition, timeout] {
+        fill_buf_fut = smp::submit_to(_shard, [this, gs = global_schema_ptr(_schema), pending_next_partition, max_buffer_size, timeout] {
             auto rreader = make_foreign(std::make_unique<remote_reader>(gs.get(), *_lifecycle_policy, *_pr, _ps, _pc, _trace_state, _fwd_mr));
-            auto f = rreader->fill_buffer(*_pr, pending_next_partition, timeout);
+            auto f = rreader->fill_buffer(*_pr, pending_next_partition, max_buffer_size, timeout);
             return f.then([rreader = std::move(rreader)] (fill_buffer_result res) mutable {
                 return make_ready_future<reader_and_buffer_fill_result>(reader_and_buffer_fill_result{std::move(rreader), std::move(res)});
             });
@@ -1401,13 +1483,15 @@ future<> shard_reader::do_fill_buffer(db::timeout_clock::time_point timeout) {
             return std::move(res.result);
         });
     } else {
-        fill_buf_fut = smp::submit_to(_shard, [this, pending_next_partition, timeout] () mutable {
-            return _reader->fill_buffer(*_pr, pending_next_partition, timeout);
+        fill_buf_fut = smp::submit_to(_shard, [this, pending_next_partition, max_buffer_size, timeout] () mutable {
+            return _reader->fill_buffer(*_pr, pending_next_partition, max_buffer_size, timeout);
         });
     }
 
     return fill_buf_fut.then([this, zis = shared_from_this()] (fill_buffer_result res) mutable {
         _end_of_stream = res.end_of_stream;
+        _remote_buffer_budget = res.buffer_budget;
+        _remote_buffer_size = std::min(_remote_buffer_size, _remote_buffer_budget);
         for (const auto& mf : *res.buffer) {
             push_mutation_fragment(mutation_fragment(*_schema, mf));
         }
@@ -1442,6 +1526,9 @@ future<> shard_reader::fast_forward_to(const dht::partition_range& pr, db::timeo
     }
 
     _end_of_stream = false;
+    if (!is_buffer_empty() || _read_ahead) {
+        shrink_remote_buffer();
+    }
     clear_buffer();
 
     auto f = _read_ahead ? *std::exchange(_read_ahead, std::nullopt) : make_ready_future<>();
@@ -1490,6 +1577,9 @@ class multishard_combining_reader : public flat_mutation_reader::impl {
 
     void on_partition_range_change(const dht::partition_range& pr);
     bool maybe_move_to_next_shard(const dht::token* const t = nullptr);
+    // Starts filling the buffer of the shard to be read after the current one,
+    // if the data buffered on the current shard can't complete our buffer.
+    void read_ahead_next_shard(db::timeout_clock::time_point timeout);
     future<> handle_empty_reader_buffer(db::timeout_clock::time_point timeout);
 
 public:
@@ -1557,6 +1647,16 @@ bool multishard_combining_reader::maybe_move_to_next_shard(const dht::token* con
     return true;
 }
 
+void multishard_combining_reader::read_ahead_next_shard(db::timeout_clock::time_point timeout) {
+    if (_shard_selection_min_heap.empty() || is_buffer_full()) {
+        return;
+    }
+    const auto& reader = *_shard_readers[_current_shard];
+    if (buffer_size() + reader.buffer_size() < max_buffer_size_in_bytes) {
+        _shard_readers[_shard_selection_min_heap.front().shard]->read_ahead(timeout);
+    }
+}
+
 future<> multishard_combining_reader::handle_empty_reader_buffer(db::timeout_clock::time_point timeout) {
     auto& reader = *_shard_readers[_current_shard];
 
@@ -1565,11 +1665,18 @@ future<> multishard_combining_reader::handle_empty_reader_buffer(db::timeout_clo
             _end_of_stream = true;
         } else {
             maybe_move_to_next_shard();
+            read_ahead_next_shard(timeout);
         }
         return make_ready_future<>();
     } else if (reader.is_read_ahead_in_progress()) {
+        if (!reader.is_read_ahead_ready()) {
+            reader.grow_remote_buffer();
+        }
         return reader.fill_buffer(timeout);
     } else {
+        if (reader.is_created()) {
+            reader.grow_remote_buffer();
+        }
         // If we crossed shards and the next reader has an empty buffer we
         // double concurrency so the next time we cross shards we will have
         // more chances of hitting the reader's buffer.
@@ -1623,6 +1730,7 @@ future<> multishard_combining_reader::fill_buffer(db::timeout_clock::time_point
 
         while (!reader.is_buffer_empty() && !is_buffer_full()) {
             if (const auto& mf = reader.peek_buffer(); mf.is_partition_start() && maybe_move_to_next_shard(&mf.as_partition_start().key().token())) {
+                read_ahead_next_shard(timeout);
                 return make_ready_future<>();
             }
             push_mutation_fragment(reader.pop_mutation_fragment());
@@ -1665,6 +1773,9 @@ class inactive_shard_read : public reader_concurrency_semaphore::inactive_read {
     virtual void evict() override {
         _reader = {};
     }
+    virtual size_t memory_usage() const noexcept override {
+        return _reader ? _reader->buffer_size() : 0;
+    }
 };
 
 }
@@ -99,21 +99,40 @@ class filtering_reader : public flat_mutation_reader::impl {
         , _filter(std::forward<MutationFilter>(filter)) {
     }
     virtual future<> fill_buffer(db::timeout_clock::time_point timeout) override {
-        return do_until([this] { return is_buffer_full() || is_end_of_stream(); }, [this, timeout] {
-            return _rd.fill_buffer(timeout).then([this] {
-                while (!_rd.is_buffer_empty()) {
-                    auto mf = _rd.pop_mutation_fragment();
-                    if (mf.is_partition_start()) {
-                        auto& dk = mf.as_partition_start().key();
-                        if (!_filter(dk)) {
-                            _rd.next_partition();
-                            continue;
-                        }
-                    }
-                    push_mutation_fragment(std::move(mf));
-                }
-                _end_of_stream = _rd.is_end_of_stream();
+        if (_end_of_stream) {
+            return make_ready_future<>();
+        }
+        return _rd.consume_batches_pausable([this] (circular_buffer<mutation_fragment>& batch) {
+            auto rejected = std::find_if(batch.begin(), batch.end(), [this] (const mutation_fragment& mf) {
+                return mf.is_partition_start() && !_filter(mf.as_partition_start().key());
             });
+            // As long as the filter keeps every partition, the batch is
+            // taken over as a whole.
+            if (rejected == batch.end()) {
+                push_mutation_fragments(std::move(batch));
+                return stop_iteration(is_buffer_full());
+            }
+            for (auto it = batch.begin(); it != rejected; ++it) {
+                push_mutation_fragment(std::move(*it));
+            }
+            bool skipping = true;
+            for (auto it = std::next(rejected); it != batch.end(); ++it) {
+                if (skipping) {
+                    skipping = !it->is_end_of_partition();
+                } else if (it->is_partition_start() && !_filter(it->as_partition_start().key())) {
+                    skipping = true;
+                } else {
+                    push_mutation_fragment(std::move(*it));
+                }
+            }
+            batch.clear();
+            if (skipping) {
+                // The rest of the rejected partition isn't read at all.
+                _rd.next_partition();
+            }
+            return stop_iteration(is_buffer_full());
+        }, timeout).then([this] {
+            _end_of_stream = _rd.is_end_of_stream() && _rd.is_buffer_empty();
         });
     }
     virtual void next_partition() override {
@@ -254,6 +254,21 @@ unsigned partition_snapshot::version_count()
     return count;
 }
 
+unsigned partition_snapshot::mergeable_version_count() const noexcept {
+    auto& v = version();
+    if (v.is_unique_owner()) {
+        return 0;
+    }
+    unsigned count = 0;
+    for (auto prev = v->prev(); prev; prev = prev->prev()) {
+        ++count;
+        if (prev->is_referenced()) {
+            break;
+        }
+    }
+    return count;
+}
+
 partition_entry::partition_entry(mutation_partition mp)
 {
     auto new_version = current_allocator().construct<partition_version>(std::move(mp));
@@ -577,6 +592,7 @@ coroutine partition_entry::apply_to_incomplete(const schema& s,
                             src_cur.consume_row([&](deletable_row&& row) {
                                 e.row().apply_monotonically(s, std::move(row));
                             });
+                            e.row().cells().pack(s, column_kind::regular_column);
                         } else {
                             tracker.on_row_dropped_from_memtable();
                         }
@@ -676,7 +692,7 @@ partition_snapshot::range_tombstones()
         position_in_partition_view::after_all_clustered_rows());
 }
 
-void partition_snapshot::touch() noexcept {
+void partition_snapshot::touch(lru_segment segment) noexcept {
     // Eviction assumes that older versions are evicted before newer so only the latest snapshot
     // can be touched.
     if (_tracker && at_latest_version()) {
@@ -684,7 +700,7 @@ void partition_snapshot::touch() noexcept {
         assert(!rows.empty());
         rows_entry& last_dummy = *rows.rbegin();
         assert(last_dummy.is_last_dummy());
-        _tracker->touch(last_dummy);
+        _tracker->touch(last_dummy, segment);
     }
 }
 
@@ -362,7 +362,7 @@ class partition_snapshot : public enable_lw_shared_from_this<partition_snapshot>
     stop_iteration slide_to_oldest() noexcept;
 
     // Brings the snapshot to the front of the LRU.
-    void touch() noexcept;
+    void touch(lru_segment = lru_segment::main) noexcept;
 
     // Must be called after snapshot's original region is merged into a different region
     // before the original region is destroyed, unless the snapshot is destroyed earlier.
@@ -387,6 +387,10 @@ class partition_snapshot : public enable_lw_shared_from_this<partition_snapshot>
 
     unsigned version_count();
 
+    // Returns the number of versions merge_partition_versions() still has
+    // to merge into the version pointed to by this snapshot.
+    unsigned mergeable_version_count() const noexcept;
+
     bool at_latest_version() const {
         return _entry != nullptr;
     }
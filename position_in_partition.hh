@@ -374,9 +374,9 @@ class position_in_partition {
             if (!a._ck) {
                 return 0;
             }
-            auto&& types = _s.clustering_key_type()->types();
-            auto cmp = [&] (const data_type& t, bytes_view c1, bytes_view c2) { return t->compare(c1, c2); };
-            return lexicographical_tri_compare(types.begin(), types.end(),
+            auto&& comparators = _s.clustering_key_type()->comparators();
+            auto cmp = [] (const compiled_tri_comparator& t, bytes_view c1, bytes_view c2) { return t(c1, c2); };
+            return lexicographical_tri_compare(comparators.begin(), comparators.end(),
                 a._ck->begin(_s), a._ck->end(_s),
                 b._ck->begin(_s), b._ck->end(_s),
                 cmp, a.relation(), b.relation());
@@ -393,10 +393,10 @@ class position_in_partition {
             if (!a._ck) {
                 return 0;
             }
-            auto&& types = _s.clustering_key_type()->types();
+            auto&& comparators = _s.clustering_key_type()->comparators();
             auto b_values = b.values();
-            auto cmp = [&] (const data_type& t, bytes_view c1, bytes_view c2) { return t->compare(c1, c2); };
-            return lexicographical_tri_compare(types.begin(), types.end(),
+            auto cmp = [] (const compiled_tri_comparator& t, bytes_view c1, bytes_view c2) { return t(c1, c2); };
+            return lexicographical_tri_compare(comparators.begin(), comparators.end(),
                 a._ck->begin(_s), a._ck->end(_s),
                 b_values.begin(), b_values.end(),
                 cmp, a.relation(), relation_for_lower_bound(b));
@@ -410,11 +410,11 @@ class position_in_partition {
             if (a.is_static() != b.is_static()) {
                 return a.is_static() ? -1 : 1;
             }
-            auto&& types = _s.clustering_key_type()->types();
+            auto&& comparators = _s.clustering_key_type()->comparators();
             auto a_values = a.values();
             auto b_values = b.values();
-            auto cmp = [&] (const data_type& t, bytes_view c1, bytes_view c2) { return t->compare(c1, c2); };
-            return lexicographical_tri_compare(types.begin(), types.end(),
+            auto cmp = [] (const compiled_tri_comparator& t, bytes_view c1, bytes_view c2) { return t(c1, c2); };
+            return lexicographical_tri_compare(comparators.begin(), comparators.end(),
                 a_values.begin(), a_values.end(),
                 b_values.begin(), b_values.end(),
                 cmp,
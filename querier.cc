@@ -196,8 +196,8 @@ void querier_cache::scan_cache_entries() {
     }
 }
 
-static querier_cache::entries::iterator find_querier(querier_cache::entries& entries, querier_cache::index& index, utils::UUID key,
-        dht::partition_ranges_view ranges, tracing::trace_state_ptr trace_state) {
+static querier_cache::entries::iterator find_querier(querier_cache::entries& entries, querier_cache::index& index, querier_cache::stats& stats,
+        utils::UUID key, dht::partition_ranges_view ranges, tracing::trace_state_ptr trace_state) {
     const auto queriers = index.equal_range(key);
 
     if (queriers.first == index.end()) {
@@ -211,6 +211,7 @@ static querier_cache::entries::iterator find_querier(querier_cache::entries& ent
 
     if (it == queriers.second) {
         tracing::trace(trace_state, "Found cached querier(s) for key {} but none matches the query range(s) {}", key, ranges);
+        ++stats.range_mismatch_misses;
         return entries.end();
     }
     tracing::trace(trace_state, "Found cached querier for key {} and range(s) {}", key, ranges);
@@ -241,6 +242,9 @@ class querier_inactive_read : public reader_concurrency_semaphore::inactive_read
         ++_stats.resource_based_evictions;
         --_stats.population;
     }
+    virtual size_t memory_usage() const noexcept override {
+        return _pos->memory_usage();
+    }
 };
 
 template <typename Querier>
@@ -322,7 +326,7 @@ static std::optional<Querier> lookup_querier(
         dht::partition_ranges_view ranges,
         const query::partition_slice& slice,
         tracing::trace_state_ptr trace_state) {
-    auto it = find_querier(entries, index, key, ranges, trace_state);
+    auto it = find_querier(entries, index, stats, key, ranges, trace_state);
     ++stats.lookups;
     if (it == entries.end()) {
         ++stats.misses;
@@ -342,6 +346,9 @@ static std::optional<Querier> lookup_querier(
 
     tracing::trace(trace_state, "Dropping querier because {}", cannot_use_reason(can_be_used));
     ++stats.drops;
+    if (can_be_used == can_use::no_schema_version_mismatch) {
+        ++stats.schema_version_drops;
+    }
     return std::nullopt;
 }
 
@@ -96,9 +96,12 @@ auto consume_page(flat_mutation_reader& reader,
                 compaction_state,
                 clustering_position_tracker(std::move(consumer), last_ckey));
 
-        auto consume = [&reader, &slice, reader_consumer = std::move(reader_consumer), timeout, reverse_read_max_memory] () mutable {
+        auto consume = [&reader, &slice, reader_consumer = std::move(reader_consumer), timeout, reverse_read_max_memory,
+                row_limit, query_time] () mutable {
             if (slice.options.contains(query::partition_slice::option::reversed)) {
-                return do_with(make_reversing_reader(reader, reverse_read_max_memory),
+                // The page can't take more rows than this from any partition.
+                auto max_rows = std::min<uint64_t>(row_limit, slice.partition_row_limit());
+                return do_with(make_reversing_reader(reader, reverse_read_max_memory, max_rows, query_time),
                         [reader_consumer = std::move(reader_consumer), timeout] (flat_mutation_reader& reversing_reader) mutable {
                     return reversing_reader.consume(std::move(reader_consumer), timeout);
                 });
@@ -319,9 +322,15 @@ class querier_cache {
         uint64_t lookups = 0;
         // The subset of lookups that missed.
         uint64_t misses = 0;
+        // The subset of misses where queriers were cached for the key but
+        // none of them matched the query range(s).
+        uint64_t range_mismatch_misses = 0;
         // The subset of lookups that hit but the looked up querier had to be
         // dropped due to position mismatch.
         uint64_t drops = 0;
+        // The subset of drops caused by the schema having changed since the
+        // querier was cached.
+        uint64_t schema_version_drops = 0;
         // The number of queriers evicted due to their TTL expiring.
         uint64_t time_based_evictions = 0;
         // The number of queriers evicted to free up resources to be able to
@@ -30,8 +30,11 @@
 #include "range.hh"
 #include "tracing/tracing.hh"
 #include "utils/small_vector.hh"
+#include "gc_clock.hh"
+#include "db/consistency_level_type.hh"
 
 class position_in_partition_view;
+class row;
 
 namespace query {
 
@@ -118,6 +121,27 @@ class specific_ranges {
 
 constexpr auto max_rows = std::numeric_limits<uint32_t>::max();
 
+// A restriction on the value of an atomic static or regular column, which
+// the replica applies to the rows of a data query before counting them
+// towards the limits, so that non-matching rows are not sent back. The
+// coordinator still evaluates the statement's restrictions on the results, so
+// a filter must never reject a row which the restrictions would accept.
+struct column_filter {
+    bool is_static;
+    column_id id;
+    // When not empty, the value must be equal to one of these.
+    std::vector<bytes> values;
+    // The value must lie in this range.
+    nonwrapping_range<bytes> range;
+
+    // A missing or dead cell never matches.
+    bool matches(const schema&, const row& cells, gc_clock::time_point now) const;
+
+    friend std::ostream& operator<<(std::ostream& out, const column_filter& f);
+};
+
+using column_filters = std::vector<column_filter>;
+
 // Specifies subset of rows, columns and cell attributes to be returned in a query.
 // Can be accessed across cores.
 // Schema-dependent.
@@ -139,6 +163,11 @@ class partition_slice {
         // key restrictions and the partition doesn't have any rows matching
         // the restrictions, see #589. This flag overrides this behavior.
         always_return_static_content,
+        // Set by the replica for reads whose rows are used only through the
+        // selected columns, e.g. data queries not going through the cache.
+        // The sstable reader may then skip the values of the other columns,
+        // producing cells with empty values. Never sent over the wire.
+        skip_unselected_cells,
     };
     using option_set = enum_set<super_enum<option,
         option::send_clustering_key,
@@ -152,7 +181,8 @@ class partition_slice {
         option::allow_short_read,
         option::with_digest,
         option::bypass_cache,
-        option::always_return_static_content>>;
+        option::always_return_static_content,
+        option::skip_unselected_cells>>;
     clustering_row_ranges _row_ranges;
 public:
     column_id_vector static_columns; // TODO: consider using bitmap
@@ -162,12 +192,14 @@ class partition_slice {
     std::unique_ptr<specific_ranges> _specific_ranges;
     cql_serialization_format _cql_format;
     uint32_t _partition_row_limit;
+    column_filters _filters;
 public:
     partition_slice(clustering_row_ranges row_ranges, column_id_vector static_columns,
         column_id_vector regular_columns, option_set options,
         std::unique_ptr<specific_ranges> specific_ranges = nullptr,
         cql_serialization_format = cql_serialization_format::internal(),
-        uint32_t partition_row_limit = max_rows);
+        uint32_t partition_row_limit = max_rows,
+        column_filters filters = {});
     partition_slice(clustering_row_ranges ranges, const schema& schema, const column_set& mask, option_set options);
     partition_slice(const partition_slice&);
     partition_slice(partition_slice&&);
@@ -199,6 +231,15 @@ class partition_slice {
     void set_partition_row_limit(uint32_t limit) {
         _partition_row_limit = limit;
     }
+    // Rows of a data query are returned only if they match all filters.
+    // Must only be set when all replicas support it, see
+    // gms::feature_service::cluster_supports_replica_filtering().
+    const column_filters& filters() const {
+        return _filters;
+    }
+    void set_filters(column_filters filters) {
+        _filters = std::move(filters);
+    }
 
     friend std::ostream& operator<<(std::ostream& out, const partition_slice& ps);
     friend std::ostream& operator<<(std::ostream& out, const specific_ranges& ps);
@@ -231,6 +272,11 @@ class read_command {
     // to avoid doing work normally done on paged requests, e.g. attempting to
     // reused suspended readers.
     bool is_first_page;
+    // The maximum size of the result, in bytes, the replicas should return.
+    // Reads allowing short results stop early when reaching it, paged reads
+    // use it to bound the size of pages. The replicas always enforce their
+    // own limit as well.
+    uint64_t max_result_size;
     api::timestamp_type read_timestamp; // not serialized
 public:
     read_command(utils::UUID cf_id,
@@ -242,6 +288,7 @@ class read_command {
                  uint32_t partition_limit = max_partitions,
                  utils::UUID query_uuid = utils::UUID(),
                  bool is_first_page = false,
+                 uint64_t max_result_size = std::numeric_limits<uint64_t>::max(),
                  api::timestamp_type rt = api::new_timestamp())
         : cf_id(std::move(cf_id))
         , schema_version(std::move(schema_version))
@@ -252,10 +299,50 @@ class read_command {
         , partition_limit(partition_limit)
         , query_uuid(query_uuid)
         , is_first_page(is_first_page)
+        , max_result_size(max_result_size)
         , read_timestamp(rt)
     { }
 
     friend std::ostream& operator<<(std::ostream& out, const read_command& r);
 };
 
+// One output column of an aggregate query computed by the replicas of its
+// token ranges (see service/forward_service.hh): either a reducible
+// aggregate function over columns of the read, or a plain column, which
+// yields its first value in each group.
+struct aggregate_call {
+    sstring function_keyspace;
+    sstring function_name; // empty for a plain column
+    std::vector<sstring> argument_types;
+    std::vector<uint32_t> arguments; // indexes into forward_request::columns
+    // The values of the literal arguments, which replace their columns; may
+    // be shorter than arguments.
+    std::vector<bytes_opt> constants;
+};
+
+// A request to compute the partial aggregates of a read over some of its
+// token ranges.
+struct forward_request {
+    read_command cmd;
+    dht::partition_range_vector ranges;
+    db::consistency_level cl;
+    uint32_t page_size;
+    std::vector<sstring> columns; // the columns of the selection, in order
+    std::vector<aggregate_call> calls;
+    std::vector<uint32_t> group_by; // indexes into columns of the GROUP BY cells
+};
+
+// The values of the GROUP BY cells of a group, empty without GROUP BY, and
+// the state of each call over the rows of the group.
+struct partial_aggregates {
+    std::vector<bytes_opt> key;
+    std::vector<bytes_opt> states;
+};
+
+// Groups come in ring order. Without GROUP BY all rows belong to the same
+// group, and a node which read no rows returns no group at all.
+struct forward_result {
+    std::vector<partial_aggregates> groups;
+};
+
 }
@@ -72,13 +72,11 @@ class result_row_view {
     result_row_view(ser::qr_row_view v) : _v(v) {}
 
     class iterator_type {
-        using cells_vec = std::vector<std::optional<ser::qr_cell_view>>;
-        cells_vec _cells;
+        using cells_vec = ser::vector_deserializer<std::optional<ser::qr_cell_view>>;
         cells_vec::iterator _i;
     public:
         iterator_type(ser::qr_row_view v)
-            : _cells(v.cells())
-            , _i(_cells.begin())
+            : _i(v.cells().begin())
         { }
         std::optional<result_atomic_cell_view> next_atomic_cell() {
             auto cell_opt = *_i++;
@@ -199,7 +197,7 @@ class result_view {
 
     std::tuple<uint32_t, uint32_t> count_partitions_and_rows() const {
         auto&& ps = _v.partitions();
-        auto rows = boost::accumulate(ps | boost::adaptors::transformed([] (auto& p) {
+        auto rows = boost::accumulate(ps | boost::adaptors::transformed([] (const auto& p) {
             return std::max(p.rows().size(), size_t(1));
         }), uint32_t(0));
         return std::make_tuple(ps.size(), rows);
@@ -208,7 +206,7 @@ class result_view {
     std::tuple<partition_key, std::optional<clustering_key>>
     get_last_partition_and_clustering_key() const {
         auto ps = _v.partitions();
-        auto& p = ps.back();
+        auto p = ps.back();
         auto rs = p.rows();
         return { p.key().value(), !rs.empty() ? rs.back().key() : std::optional<clustering_key>() };
     }
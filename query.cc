@@ -29,6 +29,7 @@
 #include "mutation_partition_serializer.hh"
 #include "query-result-reader.hh"
 #include "query_result_merger.hh"
+#include "mutation_partition.hh"
 
 namespace query {
 
@@ -54,6 +55,9 @@ std::ostream& operator<<(std::ostream& out, const partition_slice& ps) {
     out << ", options=" << format("{:x}", ps.options.mask()); // FIXME: pretty print options
     out << ", cql_format=" << ps.cql_format();
     out << ", partition_row_limit=" << ps._partition_row_limit;
+    if (!ps._filters.empty()) {
+        out << ", filters=[" << join(", ", ps._filters) << "]";
+    }
     return out << "}";
 }
 
@@ -64,13 +68,40 @@ std::ostream& operator<<(std::ostream& out, const read_command& r) {
         << ", slice=" << r.slice << ""
         << ", limit=" << r.row_limit
         << ", timestamp=" << r.timestamp.time_since_epoch().count() << "}"
-        << ", partition_limit=" << r.partition_limit << "}";
+        << ", partition_limit=" << r.partition_limit
+        << ", max_result_size=" << r.max_result_size << "}";
 }
 
 std::ostream& operator<<(std::ostream& out, const specific_ranges& s) {
     return out << "{" << s._pk << " : " << join(", ", s._ranges) << "}";
 }
 
+bool column_filter::matches(const schema& s, const row& cells, gc_clock::time_point now) const {
+    auto* cell = cells.find_cell(id);
+    if (!cell) {
+        return false;
+    }
+    auto& cdef = s.column_at(is_static ? column_kind::static_column : column_kind::regular_column, id);
+    auto c = cell->as_atomic_cell(cdef);
+    if (c.is_dead(now)) {
+        return false;
+    }
+    auto value = c.value().linearize();
+    auto& type = *cdef.type;
+    if (!values.empty() && std::none_of(values.begin(), values.end(), [&] (const bytes& v) { return type.compare(v, value) == 0; })) {
+        return false;
+    }
+    return range.contains(value, type.as_tri_comparator());
+}
+
+std::ostream& operator<<(std::ostream& out, const column_filter& f) {
+    out << "{" << (f.is_static ? "static" : "regular") << " column " << f.id;
+    if (!f.values.empty()) {
+        out << " in [" << join(", ", f.values) << "]";
+    }
+    return out << " within " << f.range << "}";
+}
+
 void trim_clustering_row_ranges_to(const schema& s, clustering_row_ranges& ranges, position_in_partition_view pos, bool reversed) {
     auto cmp = [reversed, cmp = position_in_partition::composite_tri_compare(s)] (const auto& a, const auto& b) {
         return reversed ? cmp(b, a) : cmp(a, b);
@@ -115,7 +146,8 @@ partition_slice::partition_slice(clustering_row_ranges row_ranges,
     option_set options,
     std::unique_ptr<specific_ranges> specific_ranges,
     cql_serialization_format cql_format,
-    uint32_t partition_row_limit)
+    uint32_t partition_row_limit,
+    column_filters filters)
     : _row_ranges(std::move(row_ranges))
     , static_columns(std::move(static_columns))
     , regular_columns(std::move(regular_columns))
@@ -123,6 +155,7 @@ partition_slice::partition_slice(clustering_row_ranges row_ranges,
     , _specific_ranges(std::move(specific_ranges))
     , _cql_format(std::move(cql_format))
     , _partition_row_limit(partition_row_limit)
+    , _filters(std::move(filters))
 {}
 
 partition_slice::partition_slice(clustering_row_ranges ranges, const schema& s, const column_set& columns, option_set options)
@@ -153,6 +186,7 @@ partition_slice::partition_slice(const partition_slice& s)
     , _specific_ranges(s._specific_ranges ? std::make_unique<specific_ranges>(*s._specific_ranges) : nullptr)
     , _cql_format(s._cql_format)
     , _partition_row_limit(s._partition_row_limit)
+    , _filters(s._filters)
 {}
 
 partition_slice::~partition_slice()
@@ -301,4 +335,24 @@ foreign_ptr<lw_shared_ptr<query::result>> result_merger::get() {
     return make_foreign(make_lw_shared<query::result>(std::move(w), is_short_read, row_count, partition_count));
 }
 
+std::vector<lw_shared_ptr<query::result>> split_result(const query::result& r, const std::vector<result_part_end>& ends) {
+    std::vector<lw_shared_ptr<query::result>> parts;
+    parts.reserve(ends.size());
+    auto pvs = ser::query_result_view{ser::as_input_stream(r.buf())}.partitions();
+    auto it = pvs.begin();
+    result_part_end start{0, 0};
+    for (auto& end : ends) {
+        bytes_ostream w;
+        auto partitions = ser::writer_of_query_result<bytes_ostream>(w).start_partitions();
+        for (auto i = start.partitions; i < end.partitions; ++i) {
+            partitions.add(*it++);
+        }
+        std::move(partitions).end_partitions().end_query_result();
+        auto is_short_read = &end == &ends.back() ? r.is_short_read() : short_read::no;
+        parts.push_back(make_lw_shared<query::result>(std::move(w), is_short_read, end.rows - start.rows, end.partitions - start.partitions));
+        start = end;
+    }
+    return parts;
+}
+
 }
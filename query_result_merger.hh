@@ -55,4 +55,17 @@ class result_merger {
     foreign_ptr<lw_shared_ptr<query::result>> get();
 };
 
+// The extent of one part of a result, as the partition and row counts of
+// the result up to the end of that part.
+struct result_part_end {
+    uint32_t partitions;
+    uint32_t rows;
+};
+
+// Splits a result built from several consecutive reads into one result per
+// read, given where each read ended. The parts are meant to be fed into a
+// result_merger, interleaved with parts of other results. Only the last part
+// is a short read, if the whole result is one.
+std::vector<lw_shared_ptr<query::result>> split_result(const query::result& r, const std::vector<result_part_end>& ends);
+
 }
@@ -281,6 +281,16 @@ range_tombstone_list range_tombstone_list::difference(const schema& s, const ran
     return diff;
 }
 
+void range_tombstone_list::erase_before(const schema& s, position_in_partition_view pos) {
+    // Ends are ordered like starts, since the tombstones don't overlap, so
+    // the ones ending at or before pos are a prefix of the list.
+    position_in_partition::less_compare less(s);
+    auto first_kept = _tombstones.upper_bound(pos, [less] (position_in_partition_view p, const range_tombstone& rt) {
+        return less(p, rt.end_position());
+    });
+    _tombstones.erase_and_dispose(_tombstones.begin(), first_kept, current_deleter<range_tombstone>());
+}
+
 stop_iteration range_tombstone_list::clear_gently() noexcept {
     auto del = current_deleter<range_tombstone>();
     auto i = _tombstones.begin();
@@ -438,12 +448,45 @@ bool range_tombstone_list::equal(const schema& s, const range_tombstone_list& ot
 }
 
 stop_iteration range_tombstone_list::apply_monotonically(const schema& s, range_tombstone_list&& list, is_preemptible preemptible) {
+    bound_view::compare less(s);
     auto del = current_deleter<range_tombstone>();
+    // Where the last entry moved over was inserted. Since the entries of list
+    // are ordered and don't overlap, it is also where the next one goes if
+    // that ends before it, so runs of entries falling into the same gap of
+    // this list need a single lookup.
+    std::optional<range_tombstones_type::iterator> hint;
     auto it = list.begin();
     while (it != list.end()) {
-        // FIXME: Optimize by stealing the entry
-        apply_monotonically(s, *it);
-        it = list._tombstones.erase_and_dispose(it, del);
+        auto start_bound = it->start_bound();
+        auto end_bound = it->end_bound();
+        auto pos = hint && (*hint == _tombstones.end() || less(end_bound, (*hint)->start_bound()))
+            ? *hint
+            : _tombstones.upper_bound(start_bound, [less] (auto&& sb, auto&& rt) {
+                  return less(sb, rt.end_bound());
+              });
+        auto mergeable_with_prev = [&] {
+            if (pos == _tombstones.begin()) {
+                return false;
+            }
+            auto& prev = *std::prev(pos);
+            return prev.tomb == it->tomb && prev.end_bound().adjacent(s, start_bound);
+        };
+        auto overlaps_or_mergeable_with_next = [&] {
+            if (pos == _tombstones.end()) {
+                return false;
+            }
+            return !less(end_bound, pos->start_bound()) || (pos->tomb == it->tomb && end_bound.adjacent(s, pos->start_bound()));
+        };
+        if (!overlaps_or_mergeable_with_next() && !mergeable_with_prev()) {
+            // The entry lands in a gap, so it is moved over as is, which can't fail.
+            auto& rt = *it;
+            it = list._tombstones.erase(it);
+            hint = std::next(_tombstones.insert_before(pos, rt));
+        } else {
+            hint = std::nullopt;
+            apply_monotonically(s, *it);
+            it = list._tombstones.erase_and_dispose(it, del);
+        }
         if (preemptible && need_preempt()) {
             return stop_iteration::no;
         }
@@ -177,6 +177,9 @@ class range_tombstone_list final {
             }
         }
     }
+    // Erases the range tombstones ending at or before pos. Takes logarithmic
+    // time plus the time to dispose of the erased tombstones.
+    void erase_before(const schema& s, position_in_partition_view pos);
     void clear() {
         _tombstones.clear_and_dispose(current_deleter<range_tombstone>());
     }
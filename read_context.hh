@@ -125,6 +125,8 @@ class read_context final : public enable_lw_shared_from_this<read_context> {
     const io_priority_class& _pc;
     tracing::trace_state_ptr _trace_state;
     mutation_reader::forwarding _fwd_mr;
+    // Passed to the underlying readers, which are then admitted under it.
+    reader_permit _permit;
     bool _range_query;
     // When reader enters a partition, it must be set up for reading that
     // partition from the underlying mutation source (_underlying) in one of two ways:
@@ -148,7 +150,8 @@ class read_context final : public enable_lw_shared_from_this<read_context> {
             const query::partition_slice& slice,
             const io_priority_class& pc,
             tracing::trace_state_ptr trace_state,
-            mutation_reader::forwarding fwd_mr)
+            mutation_reader::forwarding fwd_mr,
+            reader_permit permit = no_reader_permit())
         : _cache(cache)
         , _schema(std::move(schema))
         , _range(range)
@@ -156,6 +159,7 @@ class read_context final : public enable_lw_shared_from_this<read_context> {
         , _pc(pc)
         , _trace_state(std::move(trace_state))
         , _fwd_mr(fwd_mr)
+        , _permit(std::move(permit))
         , _range_query(!range.is_singular() || !range.start()->value().has_key())
         , _underlying(_cache, *this)
     {
@@ -181,6 +185,7 @@ class read_context final : public enable_lw_shared_from_this<read_context> {
     const io_priority_class& pc() const { return _pc; }
     tracing::trace_state_ptr trace_state() const { return _trace_state; }
     mutation_reader::forwarding fwd_mr() const { return _fwd_mr; }
+    const reader_permit& permit() const { return _permit; }
     bool is_range_query() const { return _range_query; }
     autoupdating_underlying_reader& underlying() { return _underlying; }
     row_cache::phase_type phase() const { return _phase; }
@@ -24,6 +24,7 @@
 
 #include "reader_concurrency_semaphore.hh"
 #include "utils/exceptions.hh"
+#include "utils/latency_sampler.hh"
 
 
 reader_permit::impl::impl(reader_concurrency_semaphore& semaphore, reader_resources base_cost) : semaphore(semaphore), base_cost(base_cost) {
@@ -139,8 +140,46 @@ bool reader_concurrency_semaphore::try_evict_one_inactive_read() {
     return true;
 }
 
+size_t reader_concurrency_semaphore::evict_largest_inactive_read() {
+    auto it = std::max_element(_inactive_reads.begin(), _inactive_reads.end(), [] (const auto& a, const auto& b) {
+        return a.second->memory_usage() < b.second->memory_usage();
+    });
+    auto ir = std::move(it->second);
+    _inactive_reads.erase(it);
+    auto freed = ir->memory_usage();
+    ir->evict();
+    --_inactive_read_stats.population;
+    return freed;
+}
+
+size_t reader_concurrency_semaphore::evict_inactive_reads_for_memory(size_t memory) {
+    size_t freed = 0;
+    while (freed < memory && !_inactive_reads.empty()) {
+        freed += evict_largest_inactive_read();
+        ++_inactive_read_stats.memory_based_evictions;
+    }
+    return freed;
+}
+
+memory::reclaiming_result reader_concurrency_semaphore::reclaim(memory::reclaimer::request r) noexcept {
+    if (_inactive_reads.empty()) {
+        return memory::reclaiming_result::reclaimed_nothing;
+    }
+    // Paused reads are the cheapest memory to give back: they are recreated
+    // on their next page, at the cost of some extra reads.
+    evict_inactive_reads_for_memory(std::max(r.bytes_to_reclaim, size_t(1)));
+    return memory::reclaiming_result::reclaimed_something;
+}
+
 future<reader_permit> reader_concurrency_semaphore::wait_admission(size_t memory,
         db::timeout_clock::time_point timeout) {
+    return utils::sample_latency(utils::latency_stage::read_admission, [this, memory, timeout] {
+        return do_wait_admission(memory, timeout);
+    });
+}
+
+future<reader_permit> reader_concurrency_semaphore::do_wait_admission(size_t memory,
+        db::timeout_clock::time_point timeout) {
     if (_wait_list.size() >= _max_queue_length) {
         if (_prethrow_action) {
             _prethrow_action();
@@ -152,12 +191,19 @@ future<reader_permit> reader_concurrency_semaphore::wait_admission(size_t memory
     auto r = resources(1, static_cast<ssize_t>(memory));
     auto it = _inactive_reads.begin();
     while (!may_proceed(r) && it != _inactive_reads.end()) {
-        auto ir = std::move(it->second);
-        it = _inactive_reads.erase(it);
-        ir->evict();
+        if (_resources.count >= r.count) {
+            // Short on memory only, evict the reads holding the most of it
+            // instead of the oldest ones.
+            evict_largest_inactive_read();
+            it = _inactive_reads.begin();
+        } else {
+            auto ir = std::move(it->second);
+            it = _inactive_reads.erase(it);
+            ir->evict();
+            --_inactive_read_stats.population;
+        }
 
         ++_inactive_read_stats.permit_based_evictions;
-        --_inactive_read_stats.population;
     }
     if (may_proceed(r)) {
         _resources -= r;
@@ -186,6 +232,13 @@ class tracking_file_impl : public file_impl {
         , _permit(std::move(permit)) {
     }
 
+    void account_read(size_t size) {
+        if (auto* stats = _permit.read_stats()) {
+            stats->bytes_read += size;
+            ++stats->read_requests;
+        }
+    }
+
     tracking_file_impl(const tracking_file_impl&) = delete;
     tracking_file_impl& operator=(const tracking_file_impl&) = delete;
     tracking_file_impl(tracking_file_impl&&) = default;
@@ -200,11 +253,17 @@ class tracking_file_impl : public file_impl {
     }
 
     virtual future<size_t> read_dma(uint64_t pos, void* buffer, size_t len, const io_priority_class& pc) override {
-        return get_file_impl(_tracked_file)->read_dma(pos, buffer, len, pc);
+        return get_file_impl(_tracked_file)->read_dma(pos, buffer, len, pc).then([this] (size_t size) {
+            account_read(size);
+            return size;
+        });
     }
 
     virtual future<size_t> read_dma(uint64_t pos, std::vector<iovec> iov, const io_priority_class& pc) override {
-        return get_file_impl(_tracked_file)->read_dma(pos, iov, pc);
+        return get_file_impl(_tracked_file)->read_dma(pos, iov, pc).then([this] (size_t size) {
+            account_read(size);
+            return size;
+        });
     }
 
     virtual future<> flush(void) override {
@@ -245,6 +304,7 @@ class tracking_file_impl : public file_impl {
 
     virtual future<temporary_buffer<uint8_t>> dma_read_bulk(uint64_t offset, size_t range_size, const io_priority_class& pc) override {
         return get_file_impl(_tracked_file)->dma_read_bulk(offset, range_size, pc).then([this, units = _permit.get_memory_units(range_size)] (temporary_buffer<uint8_t> buf) {
+            account_read(buf.size());
             if (_permit) {
                 buf = make_tracked_temporary_buffer(std::move(buf), _permit);
             }
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <seastar/core/future.hh>
+#include <seastar/core/memory.hh>
 #include "db/timeout_clock.hh"
 #include "reader_permit.hh"
 
@@ -50,6 +51,8 @@ using namespace seastar;
 /// type `std::runtime_error` is thrown. Optionally, some additional
 /// code can be executed just before throwing (`prethrow_action` 
 /// constructor parameter).
+/// Inactive reads are evicted to make room for new ones, and also when the
+/// allocator runs low on memory, largest first.
 class reader_concurrency_semaphore {
 public:
     using resources = reader_resources;
@@ -59,6 +62,10 @@ class reader_concurrency_semaphore {
     class inactive_read {
     public:
         virtual void evict() = 0;
+        // The amount of memory evicting the read would free, best effort.
+        virtual size_t memory_usage() const noexcept {
+            return 0;
+        }
         virtual ~inactive_read() = default;
     };
 
@@ -86,6 +93,8 @@ class reader_concurrency_semaphore {
     struct inactive_read_stats {
         // The number of inactive reads evicted to free up permits.
         uint64_t permit_based_evictions = 0;
+        // The number of inactive reads evicted because the shard was low on memory.
+        uint64_t memory_based_evictions = 0;
         // The number of inactive reads currently registered.
         uint64_t population = 0;
     };
@@ -118,6 +127,7 @@ class reader_concurrency_semaphore {
     uint64_t _next_id = 1;
     std::map<uint64_t, std::unique_ptr<inactive_read>> _inactive_reads;
     inactive_read_stats _inactive_read_stats;
+    memory::reclaimer _reclaimer;
 
 private:
     bool has_available_units(const resources& r) const {
@@ -137,6 +147,13 @@ class reader_concurrency_semaphore {
     void signal_memory(size_t memory) noexcept {
         signal(resources(0, static_cast<ssize_t>(memory)));
     }
+
+    future<reader_permit> do_wait_admission(size_t memory, db::timeout_clock::time_point timeout);
+
+    // Evicts the inactive read with the largest memory footprint, the oldest
+    // one among equals.
+    size_t evict_largest_inactive_read();
+    memory::reclaiming_result reclaim(memory::reclaimer::request r) noexcept;
 public:
     struct no_limits { };
 
@@ -149,7 +166,8 @@ class reader_concurrency_semaphore {
         , _wait_list(expiry_handler(name))
         , _name(std::move(name))
         , _max_queue_length(max_queue_length)
-        , _prethrow_action(std::move(prethrow_action)) {}
+        , _prethrow_action(std::move(prethrow_action))
+        , _reclaimer([this] (memory::reclaimer::request r) { return reclaim(r); }, memory::reclaimer_scope::async) {}
 
     /// Create a semaphore with practically unlimited count and memory.
     ///
@@ -169,7 +187,7 @@ class reader_concurrency_semaphore {
     /// Register an inactive read.
     ///
     /// The semaphore will evict this read when there is a shortage of
-    /// permits. This might be immediate, during this register call.
+    /// permits or of memory. This might be immediate, during this register call.
     /// Clients can use the returned handle to unregister the read, when it
     /// stops being inactive and hence evictable.
     ///
@@ -191,6 +209,13 @@ class reader_concurrency_semaphore {
     /// (if there was no reader to evict).
     bool try_evict_one_inactive_read();
 
+    /// Evict inactive reads, largest first, until at least `memory` bytes
+    /// are freed, as estimated by inactive_read::memory_usage(), or there
+    /// are none left.
+    ///
+    /// Returns the estimated amount of memory freed.
+    size_t evict_inactive_reads_for_memory(size_t memory);
+
     void clear_inactive_reads() {
         _inactive_reads.clear();
     }
@@ -59,10 +59,27 @@ struct reader_resources {
 
 class reader_concurrency_semaphore;
 
+// Read amplification of the sstable reads done under a permit, i.e. by all
+// the sstable readers of a single read of a table on a shard.
+struct sstable_read_stats {
+    // Sstables overlapping the token range of the read.
+    uint64_t sstables_selected = 0;
+    // Sstables skipped because their Bloom filter excluded the key.
+    uint64_t sstables_filtered_by_bloom_filter = 0;
+    // Sstables skipped because their clustering ranges don't overlap the slice.
+    uint64_t sstables_filtered_by_clustering_filter = 0;
+    // Sstables a reader was created for.
+    uint64_t sstables_read = 0;
+    // Bytes, and read requests, of the data and index files of these sstables.
+    uint64_t bytes_read = 0;
+    uint64_t read_requests = 0;
+};
+
 class reader_permit {
     struct impl {
         reader_concurrency_semaphore& semaphore;
         reader_resources base_cost;
+        sstable_read_stats read_stats;
 
         impl(reader_concurrency_semaphore& semaphore, reader_resources base_cost);
         ~impl();
@@ -108,6 +125,11 @@ class reader_permit {
 
     memory_units get_memory_units(size_t memory = 0);
     void release();
+
+    // Null for no_reader_permit().
+    sstable_read_stats* read_stats() {
+        return _impl ? &_impl->read_stats : nullptr;
+    }
 };
 
 reader_permit no_reader_permit();
@@ -0,0 +1,72 @@
+#
+# Copyright (C) 2020 ScyllaDB
+#
+#
+# This file is part of Scylla.
+#
+# Scylla is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Scylla is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+import time
+import redis
+import logging
+from util import random_string, connect
+
+logger = logging.getLogger('redis-test')
+
+def test_hset_hdel_counts():
+    r = connect()
+    key = random_string(10)
+
+    assert r.execute_command('HSET', key, 'a', '1', 'b', '2') == 2
+    # Only the new field is counted.
+    assert r.execute_command('HSET', key, 'b', '3', 'c', '4') == 1
+    assert r.hget(key, 'b') == '3'
+    # Only the fields which existed are counted.
+    assert r.hdel(key, 'a', 'x') == 1
+    assert r.hdel(key, 'a') == 0
+    assert r.hgetall(key) == {'b': '3', 'c': '4'}
+
+def test_push_returns_length():
+    r = connect()
+    key = random_string(10)
+
+    assert r.rpush(key, 'a', 'b') == 2
+    assert r.lpush(key, 'c') == 3
+    assert r.lrange(key, 0, -1) == ['c', 'a', 'b']
+
+def test_sadd_counts():
+    r = connect()
+    key = random_string(10)
+
+    assert r.sadd(key, 'a', 'b', 'a') == 2
+    assert r.sadd(key, 'b', 'c') == 1
+    assert sorted(r.smembers(key)) == ['a', 'b', 'c']
+
+def test_expire_structures():
+    r = connect()
+    key = random_string(10)
+
+    assert r.expire(key, 1) == False
+    r.execute_command('HSET', key, 'a', '1')
+    r.rpush(key, 'x')
+    assert r.expire(key, 1) == True
+    assert r.hget(key, 'a') == '1'
+    time.sleep(2)
+    assert r.hget(key, 'a') == None
+    assert r.lrange(key, 0, -1) == []
+    assert r.exists(key) == 0
+    # Writes after the expiration form a new key.
+    assert r.execute_command('HSET', key, 'b', '2') == 1
+    assert r.hgetall(key) == {'b': '2'}
@@ -50,7 +50,27 @@ class abstract_command : public enable_shared_from_this<abstract_command> {
     }
     virtual ~abstract_command() {};
 
+    // How a pipelined command may be grouped with its neighbours.
+    enum class pipelining {
+        // Runs alone, once all the commands before it have completed.
+        barrier,
+        // Runs concurrently with the adjacent reads.
+        read,
+        // The mutations of adjacent writes are submitted together,
+        // see make_mutations() and written().
+        write,
+    };
+
     virtual future<redis_message> execute(service::storage_proxy&, redis::redis_options&, service_permit permit) = 0;
+    virtual pipelining pipelining_kind() const { return pipelining::barrier; }
+    // For pipelining::write commands: the mutations execute() would apply,
+    // and the reply once they have been applied.
+    virtual std::vector<mutation> make_mutations(service::storage_proxy&, redis::redis_options&) {
+        throw std::logic_error("command cannot be batched");
+    }
+    virtual future<redis_message> written() {
+        throw std::logic_error("command cannot be batched");
+    }
     const bytes& name() const { return _name; }
 };
 
@@ -38,6 +38,19 @@ shared_ptr<abstract_command> command_factory::create(service::storage_proxy& pro
         { "set",  [] (service::storage_proxy& proxy, request&& req) { return commands::set::prepare(proxy, std::move(req)); } }, 
         { "del",  [] (service::storage_proxy& proxy, request&& req) { return commands::del::prepare(proxy, std::move(req)); } }, 
         { "echo",  [] (service::storage_proxy& proxy, request&& req) { return commands::echo::prepare(proxy, std::move(req)); } },
+        { "mget",  [] (service::storage_proxy& proxy, request&& req) { return commands::mget::prepare(proxy, std::move(req)); } },
+        { "mset",  [] (service::storage_proxy& proxy, request&& req) { return commands::mset::prepare(proxy, std::move(req)); } },
+        { "exists",  [] (service::storage_proxy& proxy, request&& req) { return commands::exists::prepare(proxy, std::move(req)); } },
+        { "hset",  [] (service::storage_proxy& proxy, request&& req) { return commands::hset::prepare(proxy, std::move(req)); } },
+        { "hget",  [] (service::storage_proxy& proxy, request&& req) { return commands::hget::prepare(proxy, std::move(req)); } },
+        { "hgetall",  [] (service::storage_proxy& proxy, request&& req) { return commands::hgetall::prepare(proxy, std::move(req)); } },
+        { "hdel",  [] (service::storage_proxy& proxy, request&& req) { return commands::hdel::prepare(proxy, std::move(req)); } },
+        { "lpush",  [] (service::storage_proxy& proxy, request&& req) { return commands::push::prepare(proxy, std::move(req), true); } },
+        { "rpush",  [] (service::storage_proxy& proxy, request&& req) { return commands::push::prepare(proxy, std::move(req), false); } },
+        { "lrange",  [] (service::storage_proxy& proxy, request&& req) { return commands::lrange::prepare(proxy, std::move(req)); } },
+        { "sadd",  [] (service::storage_proxy& proxy, request&& req) { return commands::sadd::prepare(proxy, std::move(req)); } },
+        { "smembers",  [] (service::storage_proxy& proxy, request&& req) { return commands::smembers::prepare(proxy, std::move(req)); } },
+        { "expire",  [] (service::storage_proxy& proxy, request&& req) { return commands::expire::prepare(proxy, std::move(req)); } },
         { "lolwut", [] (service::storage_proxy& proxy, request&& req) { return commands::lolwut::prepare(proxy, std::move(req)); } },
     };
     auto&& command = _commands.find(req._command);
@@ -31,11 +31,78 @@
 #include "redis/query_utils.hh"
 #include "redis/mutation_utils.hh"
 #include "redis/lolwut.hh"
+#include "redis/keyspace_utils.hh"
+#include "query-request.hh"
+#include "mutation.hh"
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/algorithm/count_if.hpp>
+#include <unordered_set>
+#include <functional>
 
 namespace redis {
 
 namespace commands {
 
+static bytes_view view_of(const argument& a) {
+    return to_bytes_view(a);
+}
+
+static bytes_view view_of(const bytes& b) {
+    return b;
+}
+
+template <typename T>
+static std::vector<bytes_view> to_bytes_views(const std::vector<T>& values) {
+    return boost::copy_range<std::vector<bytes_view>>(values | boost::adaptors::transformed([] (const T& v) { return view_of(v); }));
+}
+
+template <typename T, typename U>
+static std::vector<std::pair<bytes_view, bytes_view>> to_bytes_views(const std::vector<std::pair<T, U>>& values) {
+    return boost::copy_range<std::vector<std::pair<bytes_view, bytes_view>>>(values | boost::adaptors::transformed([] (const std::pair<T, U>& v) {
+        return std::make_pair(view_of(v.first), view_of(v.second));
+    }));
+}
+
+static long parse_long(const argument& b, const bytes& command) {
+    try {
+        return std::stol(std::string(b.get(), b.size()));
+    } catch (...) {
+        throw invalid_arguments_exception(command);
+    }
+}
+
+static bool is_due(std::optional<api::timestamp_type> expiration) {
+    return expiration && *expiration <= api::new_timestamp();
+}
+
+// Applies the expiration EXPIRE set on the structures stored under key, if
+// it has passed.
+static future<> expire_if_due(service::storage_proxy& proxy, redis::redis_options& options, bytes_view key, service_permit permit) {
+    return redis::read_expiration(proxy, options, key, permit).then([&proxy, &options, key, permit] (std::optional<api::timestamp_type> expiration) {
+        if (!is_due(expiration)) {
+            return make_ready_future<>();
+        }
+        return redis::write_mutations(proxy, options, redis::make_expired_mutations(proxy, options, key, *expiration), permit);
+    });
+}
+
+// Runs read, a read of a structure stored under key, along with the read of
+// the key's expiration. If the expiration has passed, it is applied and the
+// read is repeated, so that expired data is never returned.
+template <typename T>
+static future<T> read_unexpired(service::storage_proxy& proxy, redis::redis_options& options, bytes_view key, service_permit permit,
+        std::function<future<T> ()> read) {
+    return when_all_succeed(redis::read_expiration(proxy, options, key, permit), read()).then(
+            [&proxy, &options, key, permit, read] (std::optional<api::timestamp_type> expiration, T result) {
+        if (!is_due(expiration)) {
+            return make_ready_future<T>(std::move(result));
+        }
+        return redis::write_mutations(proxy, options, redis::make_expired_mutations(proxy, options, key, *expiration), permit).then([read] {
+            return read();
+        });
+    });
+}
+
 shared_ptr<abstract_command> get::prepare(service::storage_proxy& proxy, request&& req) {
     if (req.arguments_size() != 1) {
         throw wrong_arguments_exception(1, req.arguments_size(), req._command);
@@ -44,7 +111,7 @@ shared_ptr<abstract_command> get::prepare(service::storage_proxy& proxy, request
 }
 
 future<redis_message> get::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
-    return redis::read_strings(proxy, options, _key, permit).then([] (auto result) {
+    return redis::read_strings(proxy, options, to_bytes_view(_key), permit).then([] (auto result) {
         if (result->has_result()) {
             return redis_message::make_strings_result(std::move(result->result()));
         }
@@ -61,11 +128,21 @@ shared_ptr<abstract_command> set::prepare(service::storage_proxy& proxy, request
 }
 
 future<redis_message> set::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
-    return redis::write_strings(proxy, options, std::move(_key), std::move(_data), _ttl, permit).then([] {
+    return redis::write_strings(proxy, options, to_bytes_view(_key), to_bytes_view(_data), _ttl, permit).then([] {
         return redis_message::ok();
     });
 }
 
+std::vector<mutation> set::make_mutations(service::storage_proxy& proxy, redis::redis_options& options) {
+    std::vector<mutation> mutations;
+    mutations.push_back(redis::make_strings_mutation(proxy, options, to_bytes_view(_key), to_bytes_view(_data), _ttl));
+    return mutations;
+}
+
+future<redis_message> set::written() {
+    return redis_message::ok();
+}
+
 shared_ptr<abstract_command> del::prepare(service::storage_proxy& proxy, request&& req) {
     if (req.arguments_size() == 0) {
         throw wrong_number_of_arguments_exception(req._command);
@@ -76,18 +153,365 @@ shared_ptr<abstract_command> del::prepare(service::storage_proxy& proxy, request
 future<redis_message> del::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
     //FIXME: We should return the count of the actually deleted keys.
     auto size = _keys.size();
-    return redis::delete_objects(proxy, options, std::move(_keys), permit).then([size] {
+    return redis::delete_objects(proxy, options, to_bytes_views(_keys), permit).then([size] {
        return redis_message::number(size);
     });
 }
 
+std::vector<mutation> del::make_mutations(service::storage_proxy& proxy, redis::redis_options& options) {
+    return redis::make_delete_mutations(proxy, options, to_bytes_views(_keys));
+}
+
+future<redis_message> del::written() {
+    return redis_message::number(_keys.size());
+}
+
+shared_ptr<abstract_command> mget::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() == 0) {
+        throw wrong_number_of_arguments_exception(req._command);
+    }
+    return seastar::make_shared<mget> (std::move(req._command), std::move(req._args));
+}
+
+future<redis_message> mget::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    return redis::read_partitions(proxy, options, redis::STRINGs, to_bytes_views(_keys), 1, permit).then([this] (auto result) {
+        auto& partitions = result->partitions();
+        std::vector<std::optional<bytes>> values;
+        values.reserve(_keys.size());
+        for (auto& key : _keys) {
+            auto it = partitions.find(bytes(to_bytes_view(key)));
+            if (it != partitions.end() && it->second.has_result()) {
+                values.emplace_back(it->second.rows().front().second);
+            } else {
+                values.emplace_back(std::nullopt);
+            }
+        }
+        return redis_message::make_nullable_array_result(std::move(values));
+    });
+}
+
+shared_ptr<abstract_command> mset::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() == 0 || req.arguments_size() % 2 != 0) {
+        throw wrong_number_of_arguments_exception(req._command);
+    }
+    std::vector<std::pair<bytes, bytes>> pairs;
+    pairs.reserve(req.arguments_size() / 2);
+    for (size_t i = 0; i < req.arguments_size(); i += 2) {
+        pairs.emplace_back(std::move(req._args[i]), std::move(req._args[i + 1]));
+    }
+    return seastar::make_shared<mset> (std::move(req._command), std::move(pairs));
+}
+
+future<redis_message> mset::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    return redis::write_mutations(proxy, options, make_mutations(proxy, options), permit).then([this] {
+        return written();
+    });
+}
+
+std::vector<mutation> mset::make_mutations(service::storage_proxy& proxy, redis::redis_options& options) {
+    std::vector<mutation> mutations;
+    mutations.reserve(_pairs.size());
+    for (auto& pair : _pairs) {
+        mutations.push_back(redis::make_strings_mutation(proxy, options, to_bytes_view(pair.first), to_bytes_view(pair.second), 0));
+    }
+    return mutations;
+}
+
+future<redis_message> mset::written() {
+    return redis_message::ok();
+}
+
+shared_ptr<abstract_command> exists::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() == 0) {
+        throw wrong_number_of_arguments_exception(req._command);
+    }
+    return seastar::make_shared<exists> (std::move(req._command), std::move(req._args));
+}
+
+future<redis_message> exists::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    static const std::vector<sstring> tables { redis::STRINGs, redis::LISTs, redis::HASHes, redis::SETs, redis::ZSETs };
+    auto found = make_lw_shared<std::unordered_set<bytes>>();
+    auto keys = to_bytes_views(_keys);
+    auto unique_keys = std::unordered_set<bytes_view>(keys.begin(), keys.end());
+    return parallel_for_each(unique_keys, [&proxy, &options, permit] (bytes_view key) {
+        return expire_if_due(proxy, options, key, permit);
+    }).then([this, &proxy, &options, permit, found] {
+        return parallel_for_each(tables, [this, &proxy, &options, permit, found] (const sstring& cf_name) {
+            return redis::read_partitions(proxy, options, cf_name, to_bytes_views(_keys), 1, permit).then([found] (auto result) {
+                for (auto& partition : result->partitions()) {
+                    if (partition.second.has_result()) {
+                        found->insert(partition.first);
+                    }
+                }
+            });
+        });
+    }).then([this, found] {
+        // Like Redis, a key given several times is counted several times.
+        auto count = boost::count_if(_keys, [&found] (const argument& key) { return found->count(bytes(to_bytes_view(key))); });
+        return redis_message::number(count);
+    });
+}
+
+shared_ptr<abstract_command> hset::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() < 3 || req.arguments_size() % 2 == 0) {
+        throw wrong_number_of_arguments_exception(req._command);
+    }
+    std::vector<std::pair<bytes, bytes>> fields;
+    fields.reserve(req.arguments_size() / 2);
+    for (size_t i = 1; i < req.arguments_size(); i += 2) {
+        fields.emplace_back(std::move(req._args[i]), std::move(req._args[i + 1]));
+    }
+    return seastar::make_shared<hset> (std::move(req._command), std::move(req._args[0]), std::move(fields));
+}
+
+future<redis_message> hset::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    auto fields = boost::copy_range<std::vector<bytes_view>>(_fields | boost::adaptors::transformed([] (const std::pair<argument, argument>& f) {
+        return view_of(f.first);
+    }));
+    // The reply counts the fields which did not exist, so they are read first.
+    return read_unexpired<lw_shared_ptr<rows_result>>(proxy, options, to_bytes_view(_key), permit, [this, &proxy, &options, permit, fields] {
+        return redis::read_rows(proxy, options, redis::HASHes, to_bytes_view(_key), fields, permit);
+    }).then([this, &proxy, &options, permit, fields] (lw_shared_ptr<rows_result> existing) {
+        auto added = std::unordered_set<bytes_view>(fields.begin(), fields.end()).size() - existing->rows().size();
+        auto m = redis::make_rows_mutation(proxy, options, redis::HASHes, to_bytes_view(_key), to_bytes_views(_fields), 0);
+        return redis::write_mutations(proxy, options, std::vector<mutation>{std::move(m)}, permit).then([added] {
+            return redis_message::number(added);
+        });
+    });
+}
+
+shared_ptr<abstract_command> hget::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() != 2) {
+        throw wrong_arguments_exception(2, req.arguments_size(), req._command);
+    }
+    return seastar::make_shared<hget> (std::move(req._command), std::move(req._args[0]), std::move(req._args[1]));
+}
+
+future<redis_message> hget::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    return read_unexpired<lw_shared_ptr<rows_result>>(proxy, options, to_bytes_view(_key), permit, [this, &proxy, &options, permit] {
+        return redis::read_rows(proxy, options, redis::HASHes, to_bytes_view(_key), to_bytes_view(_field), 1, false, permit);
+    }).then([] (auto result) {
+        if (result->has_result()) {
+            return redis_message::make_strings_result(std::move(result->rows().front().second));
+        }
+        return redis_message::nil();
+    });
+}
+
+shared_ptr<abstract_command> hgetall::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() != 1) {
+        throw wrong_arguments_exception(1, req.arguments_size(), req._command);
+    }
+    return seastar::make_shared<hgetall> (std::move(req._command), std::move(req._args[0]));
+}
+
+future<redis_message> hgetall::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    return read_unexpired<lw_shared_ptr<rows_result>>(proxy, options, to_bytes_view(_key), permit, [this, &proxy, &options, permit] {
+        return redis::read_rows(proxy, options, redis::HASHes, to_bytes_view(_key), std::nullopt, query::max_rows, false, permit);
+    }).then([] (auto result) {
+        std::vector<bytes> results;
+        results.reserve(result->rows().size() * 2);
+        for (auto& row : result->rows()) {
+            results.push_back(std::move(row.first));
+            results.push_back(std::move(row.second));
+        }
+        return redis_message::make_array_result(std::move(results));
+    });
+}
+
+shared_ptr<abstract_command> hdel::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() < 2) {
+        throw wrong_number_of_arguments_exception(req._command);
+    }
+    auto key = std::move(req._args[0]);
+    req._args.erase(req._args.begin());
+    return seastar::make_shared<hdel> (std::move(req._command), std::move(key), std::move(req._args));
+}
+
+future<redis_message> hdel::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    // The reply counts the fields which existed, so they are read first.
+    return read_unexpired<lw_shared_ptr<rows_result>>(proxy, options, to_bytes_view(_key), permit, [this, &proxy, &options, permit] {
+        return redis::read_rows(proxy, options, redis::HASHes, to_bytes_view(_key), to_bytes_views(_fields), permit);
+    }).then([this, &proxy, &options, permit] (lw_shared_ptr<rows_result> existing) {
+        auto removed = existing->rows().size();
+        if (!removed) {
+            return redis_message::zero();
+        }
+        auto m = redis::make_rows_tombstone(proxy, options, redis::HASHes, to_bytes_view(_key), to_bytes_views(_fields));
+        return redis::write_mutations(proxy, options, std::vector<mutation>{std::move(m)}, permit).then([removed] {
+            return redis_message::number(removed);
+        });
+    });
+}
+
+shared_ptr<abstract_command> push::prepare(service::storage_proxy& proxy, request&& req, bool front) {
+    if (req.arguments_size() < 2) {
+        throw wrong_number_of_arguments_exception(req._command);
+    }
+    auto key = std::move(req._args[0]);
+    req._args.erase(req._args.begin());
+    return seastar::make_shared<push> (std::move(req._command), front, std::move(key), std::move(req._args));
+}
+
+future<redis_message> push::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    std::vector<bytes> positions;
+    std::vector<std::pair<bytes_view, bytes_view>> rows;
+    positions.reserve(_elements.size());
+    rows.reserve(_elements.size());
+    for (size_t i = 0; i < _elements.size(); ++i) {
+        positions.push_back(redis::make_list_position(_front, i));
+        rows.emplace_back(positions.back(), to_bytes_view(_elements[i]));
+    }
+    auto m = redis::make_rows_mutation(proxy, options, redis::LISTs, to_bytes_view(_key), rows, 0);
+    // The reply is the length of the list, counted once the elements are in.
+    return redis::write_mutations(proxy, options, std::vector<mutation>{std::move(m)}, permit).then([this, &proxy, &options, permit] {
+        return read_unexpired<uint64_t>(proxy, options, to_bytes_view(_key), permit, [this, &proxy, &options, permit] {
+            return redis::count_rows(proxy, options, redis::LISTs, to_bytes_view(_key), permit);
+        });
+    }).then([] (uint64_t length) {
+        return redis_message::number(length);
+    });
+}
+
+shared_ptr<abstract_command> lrange::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() != 3) {
+        throw wrong_arguments_exception(3, req.arguments_size(), req._command);
+    }
+    auto start = parse_long(req._args[1], req._command);
+    auto stop = parse_long(req._args[2], req._command);
+    return seastar::make_shared<lrange> (std::move(req._command), std::move(req._args[0]), start, stop);
+}
+
+future<redis_message> lrange::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    // Only read the rows we need: a prefix of the list if both indexes count
+    // from the front, and a (reversed) suffix if both count from the back.
+    uint32_t row_limit = query::max_rows;
+    bool reversed = false;
+    if (_start >= 0 && _stop >= 0) {
+        row_limit = std::min<long>(_stop, query::max_rows - 1) + 1;
+    } else if (_start < 0 && _stop < 0) {
+        row_limit = std::min<long>(-_start, query::max_rows);
+        reversed = true;
+    }
+    return read_unexpired<lw_shared_ptr<rows_result>>(proxy, options, to_bytes_view(_key), permit, [this, &proxy, &options, permit, row_limit, reversed] {
+        return redis::read_rows(proxy, options, redis::LISTs, to_bytes_view(_key), std::nullopt, row_limit, reversed, permit);
+    }).then([this, reversed] (auto result) {
+        auto& rows = result->rows();
+        if (reversed) {
+            std::reverse(rows.begin(), rows.end());
+        }
+        long size = rows.size();
+        long start = _start < 0 ? std::max(size + _start, 0L) : _start;
+        long stop = _stop < 0 ? size + _stop : std::min(_stop, size - 1);
+        std::vector<bytes> results;
+        for (long i = start; i <= stop; ++i) {
+            results.push_back(std::move(rows[i].second));
+        }
+        return redis_message::make_array_result(std::move(results));
+    });
+}
+
+shared_ptr<abstract_command> sadd::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() < 2) {
+        throw wrong_number_of_arguments_exception(req._command);
+    }
+    auto key = std::move(req._args[0]);
+    req._args.erase(req._args.begin());
+    return seastar::make_shared<sadd> (std::move(req._command), std::move(key), std::move(req._args));
+}
+
+future<redis_message> sadd::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    // The reply counts the members which were not in the set, so they are read first.
+    return read_unexpired<lw_shared_ptr<rows_result>>(proxy, options, to_bytes_view(_key), permit, [this, &proxy, &options, permit] {
+        return redis::read_rows(proxy, options, redis::SETs, to_bytes_view(_key), to_bytes_views(_members), permit);
+    }).then([this, &proxy, &options, permit] (lw_shared_ptr<rows_result> existing) {
+        std::vector<std::pair<bytes_view, bytes_view>> rows;
+        rows.reserve(_members.size());
+        for (auto& member : _members) {
+            rows.emplace_back(to_bytes_view(member), bytes_view());
+        }
+        auto members = to_bytes_views(_members);
+        auto added = std::unordered_set<bytes_view>(members.begin(), members.end()).size() - existing->rows().size();
+        auto m = redis::make_rows_mutation(proxy, options, redis::SETs, to_bytes_view(_key), rows, 0);
+        return redis::write_mutations(proxy, options, std::vector<mutation>{std::move(m)}, permit).then([added] {
+            return redis_message::number(added);
+        });
+    });
+}
+
+shared_ptr<abstract_command> smembers::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() != 1) {
+        throw wrong_arguments_exception(1, req.arguments_size(), req._command);
+    }
+    return seastar::make_shared<smembers> (std::move(req._command), std::move(req._args[0]));
+}
+
+future<redis_message> smembers::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    return read_unexpired<lw_shared_ptr<rows_result>>(proxy, options, to_bytes_view(_key), permit, [this, &proxy, &options, permit] {
+        return redis::read_rows(proxy, options, redis::SETs, to_bytes_view(_key), std::nullopt, query::max_rows, false, permit);
+    }).then([] (auto result) {
+        std::vector<bytes> results;
+        results.reserve(result->rows().size());
+        for (auto& row : result->rows()) {
+            results.push_back(std::move(row.first));
+        }
+        return redis_message::make_array_result(std::move(results));
+    });
+}
+
+shared_ptr<abstract_command> expire::prepare(service::storage_proxy& proxy, request&& req) {
+    if (req.arguments_size() != 2) {
+        throw wrong_arguments_exception(2, req.arguments_size(), req._command);
+    }
+    auto ttl = parse_long(req._args[1], req._command);
+    return seastar::make_shared<expire> (std::move(req._command), std::move(req._args[0]), ttl);
+}
+
+future<redis_message> expire::execute(service::storage_proxy& proxy, redis::redis_options& options, service_permit permit) {
+    static const std::vector<sstring> row_tables { redis::LISTs, redis::HASHes, redis::SETs, redis::ZSETs };
+    auto key = to_bytes_view(_key);
+    auto structures = make_lw_shared<bool>(false);
+    return expire_if_due(proxy, options, key, permit).then([&proxy, &options, key, permit, structures] {
+        // Only whether the structures exist matters, the first row tells.
+        return parallel_for_each(row_tables, [&proxy, &options, key, permit, structures] (const sstring& cf_name) {
+            return redis::read_rows(proxy, options, cf_name, key, std::nullopt, 1, false, permit).then([structures] (auto result) {
+                *structures |= result->has_result();
+            });
+        });
+    }).then([&proxy, &options, key, permit] {
+        return redis::read_strings(proxy, options, key, permit);
+    }).then([this, &proxy, &options, key, permit, structures] (lw_shared_ptr<strings_result> strings) {
+        if (!strings->has_result() && !*structures) {
+            return redis_message::zero();
+        }
+        std::vector<mutation> mutations;
+        if (_ttl <= 0) {
+            mutations = redis::make_delete_mutations(proxy, options, {key});
+        } else {
+            // A string is a single cell, given the TTL. The rows of the
+            // structures are left alone: their expiration is recorded once
+            // for the key, and applied by the first read after it passed.
+            if (strings->has_result()) {
+                mutations.push_back(redis::make_strings_mutation(proxy, options, key, strings->result(), _ttl));
+            }
+            if (*structures) {
+                auto expiration = api::new_timestamp() + std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::seconds(_ttl)).count();
+                mutations.push_back(redis::make_expiration_mutation(proxy, options, key, expiration));
+            }
+        }
+        return redis::write_mutations(proxy, options, std::move(mutations), permit).then([] {
+            return redis_message::one();
+        });
+    });
+}
+
 shared_ptr<abstract_command> select::prepare(service::storage_proxy& proxy, request&& req) {
     if (req.arguments_size() != 1) {
         throw wrong_arguments_exception(1, req.arguments_size(), req._command);
     }
     long index = -1;
     try {
-        index = std::stol(std::string(reinterpret_cast<const char*>(req._args[0].data()), req._args[0].size()));
+        index = std::stol(std::string(req._args[0].get(), req._args[0].size()));
     }
     catch (...) {
         throw invalid_db_index_exception();
@@ -127,7 +551,7 @@ shared_ptr<abstract_command> echo::prepare(service::storage_proxy& proxy, reques
 }
 
 future<redis_message> echo::execute(service::storage_proxy&, redis::redis_options&, service_permit) {
-    return redis_message::make_strings_result(std::move(_str));
+    return redis_message::make_strings_result(bytes(to_bytes_view(_str)));
 }
 
 shared_ptr<abstract_command> lolwut::prepare(service::storage_proxy& proxy, request&& req) {
@@ -136,15 +560,15 @@ shared_ptr<abstract_command> lolwut::prepare(service::storage_proxy& proxy, requ
     int squares_per_col = 12;
     try {
         if (req.arguments_size() >= 1) {
-            cols = std::stoi(std::string(reinterpret_cast<const char*>(req._args[0].data()), req._args[0].size()));
+            cols = std::stoi(std::string(req._args[0].get(), req._args[0].size()));
             cols = std::clamp(cols, 1, 1000);
         }
         if (req.arguments_size() >= 2) {
-            squares_per_row = std::stoi(std::string(reinterpret_cast<const char*>(req._args[1].data()), req._args[1].size()));
+            squares_per_row = std::stoi(std::string(req._args[1].get(), req._args[1].size()));
             squares_per_row = std::clamp(squares_per_row, 1, 200);
         }
         if (req.arguments_size() >= 3) {
-            squares_per_col = std::stoi(std::string(reinterpret_cast<const char*>(req._args[2].data()), req._args[2].size()));
+            squares_per_col = std::stoi(std::string(req._args[2].get(), req._args[2].size()));
             squares_per_col = std::clamp(squares_per_col, 1, 200);
        }
     } catch (...) {
@@ -29,37 +29,187 @@ namespace redis {
 namespace commands {
 
 class get : public abstract_command {
-    bytes _key;
+    argument _key;
 public:
     static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
-    get(bytes&& name, bytes&& key) 
+    get(bytes&& name, argument&& key) 
         : abstract_command(std::move(name)) 
         , _key(std::move(key)) {
     }
     virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
 };
 
 class set : public abstract_command {
-    bytes _key;
-    bytes _data;
+    argument _key;
+    argument _data;
     long _ttl = 0;
 public:
     static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
-    set(bytes&& name, bytes&& key, bytes&& data, long ttl) 
+    set(bytes&& name, argument&& key, argument&& data, long ttl) 
         : abstract_command(std::move(name)) 
         , _key(std::move(key))
         , _data(std::move(data))
         , _ttl(ttl) {
     }
-    set(bytes&& name, bytes&& key, bytes&& data) : set(std::move(name), std::move(key), std::move(data), 0) {}
+    set(bytes&& name, argument&& key, argument&& data) : set(std::move(name), std::move(key), std::move(data), 0) {}
     virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::write; }
+    virtual std::vector<mutation> make_mutations(service::storage_proxy&, redis_options&) override;
+    virtual future<redis_message> written() override;
 };
 
 class del : public abstract_command {
-    std::vector<bytes> _keys;
+    std::vector<argument> _keys;
 public:
     static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
-    del(bytes&& name, std::vector<bytes>&& keys) : abstract_command(std::move(name)), _keys(std::move(keys)) {} 
+    del(bytes&& name, std::vector<argument>&& keys) : abstract_command(std::move(name)), _keys(std::move(keys)) {} 
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::write; }
+    virtual std::vector<mutation> make_mutations(service::storage_proxy&, redis_options&) override;
+    virtual future<redis_message> written() override;
+};
+
+class mget : public abstract_command {
+    std::vector<argument> _keys;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    mget(bytes&& name, std::vector<argument>&& keys) : abstract_command(std::move(name)), _keys(std::move(keys)) {}
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
+};
+
+class mset : public abstract_command {
+    std::vector<std::pair<argument, argument>> _pairs;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    mset(bytes&& name, std::vector<std::pair<argument, argument>>&& pairs) : abstract_command(std::move(name)), _pairs(std::move(pairs)) {}
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::write; }
+    virtual std::vector<mutation> make_mutations(service::storage_proxy&, redis_options&) override;
+    virtual future<redis_message> written() override;
+};
+
+class exists : public abstract_command {
+    std::vector<argument> _keys;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    exists(bytes&& name, std::vector<argument>&& keys) : abstract_command(std::move(name)), _keys(std::move(keys)) {}
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
+};
+
+class hset : public abstract_command {
+    argument _key;
+    std::vector<std::pair<argument, argument>> _fields;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    hset(bytes&& name, argument&& key, std::vector<std::pair<argument, argument>>&& fields)
+        : abstract_command(std::move(name))
+        , _key(std::move(key))
+        , _fields(std::move(fields)) {
+    }
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+};
+
+class hget : public abstract_command {
+    argument _key;
+    argument _field;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    hget(bytes&& name, argument&& key, argument&& field)
+        : abstract_command(std::move(name))
+        , _key(std::move(key))
+        , _field(std::move(field)) {
+    }
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
+};
+
+class hgetall : public abstract_command {
+    argument _key;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    hgetall(bytes&& name, argument&& key) : abstract_command(std::move(name)), _key(std::move(key)) {}
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
+};
+
+class hdel : public abstract_command {
+    argument _key;
+    std::vector<argument> _fields;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    hdel(bytes&& name, argument&& key, std::vector<argument>&& fields)
+        : abstract_command(std::move(name))
+        , _key(std::move(key))
+        , _fields(std::move(fields)) {
+    }
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+};
+
+// LPUSH (front = true) and RPUSH.
+class push : public abstract_command {
+    bool _front;
+    argument _key;
+    std::vector<argument> _elements;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req, bool front);
+    push(bytes&& name, bool front, argument&& key, std::vector<argument>&& elements)
+        : abstract_command(std::move(name))
+        , _front(front)
+        , _key(std::move(key))
+        , _elements(std::move(elements)) {
+    }
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+};
+
+class lrange : public abstract_command {
+    argument _key;
+    long _start;
+    long _stop;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    lrange(bytes&& name, argument&& key, long start, long stop)
+        : abstract_command(std::move(name))
+        , _key(std::move(key))
+        , _start(start)
+        , _stop(stop) {
+    }
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
+};
+
+class sadd : public abstract_command {
+    argument _key;
+    std::vector<argument> _members;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    sadd(bytes&& name, argument&& key, std::vector<argument>&& members)
+        : abstract_command(std::move(name))
+        , _key(std::move(key))
+        , _members(std::move(members)) {
+    }
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+};
+
+class smembers : public abstract_command {
+    argument _key;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    smembers(bytes&& name, argument&& key) : abstract_command(std::move(name)), _key(std::move(key)) {}
+    virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
+};
+
+// EXPIRE rewrites the key with the new TTL: it reads before it writes, so it
+// is not atomic with respect to concurrent writes of the key.
+class expire : public abstract_command {
+    argument _key;
+    long _ttl;
+public:
+    static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
+    expire(bytes&& name, argument&& key, long ttl) : abstract_command(std::move(name)), _key(std::move(key)), _ttl(ttl) {}
     virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
 };
 
@@ -68,14 +218,16 @@ class unknown : public abstract_command {
     static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
     unknown(bytes&& name) : abstract_command(std::move(name)) {}
     virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
 };
 
 class echo : public abstract_command {
-    bytes _str;
+    argument _str;
 public:
     static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
-    echo(bytes&& name, bytes&& str) : abstract_command(std::move(name)) , _str(std::move(str)) {}
+    echo(bytes&& name, argument&& str) : abstract_command(std::move(name)) , _str(std::move(str)) {}
     virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
 };
 
 class ping : public abstract_command {
@@ -83,6 +235,7 @@ class ping : public abstract_command {
     static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
     ping(bytes&& name) : abstract_command(std::move(name)) {}
     virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
 };
 
 class select : public abstract_command {
@@ -99,6 +252,7 @@ class lolwut : public abstract_command {
     static shared_ptr<abstract_command> prepare(service::storage_proxy& proxy, request&& req);
     lolwut(bytes&& name, const int cols, const int squares_per_row, const int squares_per_col) : abstract_command(std::move(name)), _cols(cols), _squares_per_row(squares_per_row), _squares_per_col(squares_per_col) {}
     virtual future<redis_message> execute(service::storage_proxy&, redis_options&, service_permit) override;
+    virtual pipelining pipelining_kind() const override { return pipelining::read; }
 };
 
 }
@@ -148,6 +148,27 @@ schema_ptr zsets_schema(sstring ks_name) {
     return builder.build(schema_builder::compact_storage::yes);
 }
 
+schema_ptr expirations_schema(sstring ks_name) {
+     schema_builder builder(make_lw_shared(schema(generate_legacy_id(ks_name, redis::EXPIRATIONs), ks_name, redis::EXPIRATIONs,
+     // partition key
+     {{"pkey", utf8_type}},
+     // clustering key
+     {},
+     // regular columns
+     {{"data", long_type}},
+     // static columns
+     {},
+     // regular column name type
+     utf8_type,
+     // comment
+     "save key expiration times for redis"
+    )));
+    builder.set_gc_grace_seconds(0);
+    builder.with(schema_builder::compact_storage::yes);
+    builder.with_version(db::system_keyspace::generate_schema_version(builder.uuid()));
+    return builder.build(schema_builder::compact_storage::yes);
+}
+
 future<> create_keyspace_if_not_exists_impl(db::config& config, int default_replication_factor) {
     auto keyspace_replication_strategy_options = config.redis_keyspace_replication_strategy_options();
     if (keyspace_replication_strategy_options.count("class") == 0) {
@@ -187,7 +208,8 @@ future<> create_keyspace_if_not_exists_impl(db::config& config, int default_repl
                 table_gen(ks_name, redis::LISTs, lists_schema(ks_name)),
                 table_gen(ks_name, redis::SETs, sets_schema(ks_name)),
                 table_gen(ks_name, redis::HASHes, hashes_schema(ks_name)),
-                table_gen(ks_name, redis::ZSETs, zsets_schema(ks_name))
+                table_gen(ks_name, redis::ZSETs, zsets_schema(ks_name)),
+                table_gen(ks_name, redis::EXPIRATIONs, expirations_schema(ks_name))
             ).then([] {
                 return make_ready_future<>();
             });
@@ -35,6 +35,8 @@ static constexpr auto LISTs           = "LISTs";
 static constexpr auto HASHes          = "HASHes";
 static constexpr auto SETs            = "SETs";
 static constexpr auto ZSETs           = "ZSETs";
+// When the LISTs, HASHes, SETs and ZSETs stored under a key expire, see EXPIRE.
+static constexpr auto EXPIRATIONs     = "EXPIRATIONs";
 
 future<> maybe_create_keyspace(db::config& cfg);
 
@@ -29,6 +29,8 @@
 #include "redis/options.hh"
 #include "mutation.hh"
 #include "service_permit.hh"
+#include "utils/UUID_gen.hh"
+#include "utils/serialization.hh"
 
 using namespace seastar;
 
@@ -51,43 +53,115 @@ atomic_cell make_cell(const schema_ptr schema,
     return atomic_cell::make_live(type, api::new_timestamp(), value, atomic_cell::collection_member::no);
 }  
 
-mutation make_mutation(service::storage_proxy& proxy, const redis_options& options, bytes&& key, bytes&& data, long ttl) {
+mutation make_strings_mutation(service::storage_proxy& proxy, const redis_options& options, bytes_view key, bytes_view data, long ttl) {
     auto schema = get_schema(proxy, options.get_keyspace_name(), redis::STRINGs);
     const column_definition& column = *schema->get_column_definition(redis::DATA_COLUMN_NAME);
-    auto pkey = partition_key::from_single_value(*schema, key);
+    auto pkey = partition_key::from_single_value(*schema, bytes(key));
     auto m = mutation(schema, std::move(pkey));
     auto cell = make_cell(schema, *(column.type.get()), data, ttl);
     m.set_clustered_cell(clustering_key::make_empty(), column, std::move(cell));
     return m;
 }
 
-future<> write_strings(service::storage_proxy& proxy, redis::redis_options& options, bytes&& key, bytes&& data, long ttl, service_permit permit) {
+future<> write_mutations(service::storage_proxy& proxy, redis::redis_options& options, std::vector<mutation>&& mutations, service_permit permit) {
     db::timeout_clock::time_point timeout = db::timeout_clock::now() + options.get_write_timeout();
-    auto m = make_mutation(proxy, options, std::move(key), std::move(data), ttl);
     auto write_consistency_level = options.get_write_consistency_level();
-    return proxy.mutate(std::vector<mutation> {std::move(m)}, write_consistency_level, timeout, nullptr, permit);
+    return proxy.mutate(std::move(mutations), write_consistency_level, timeout, nullptr, permit);
 }
 
+future<> write_strings(service::storage_proxy& proxy, redis::redis_options& options, bytes_view key, bytes_view data, long ttl, service_permit permit) {
+    auto m = make_strings_mutation(proxy, options, key, data, ttl);
+    return write_mutations(proxy, options, std::vector<mutation> {std::move(m)}, permit);
+}
 
-mutation make_tombstone(service::storage_proxy& proxy, const redis_options& options, const sstring& cf_name, const bytes& key) {
+mutation make_rows_mutation(service::storage_proxy& proxy, const redis_options& options, const sstring& cf_name, bytes_view key,
+        const std::vector<std::pair<bytes_view, bytes_view>>& rows, long ttl) {
     auto schema = get_schema(proxy, options.get_keyspace_name(), cf_name);
-    auto pkey = partition_key::from_single_value(*schema, key);
+    // SETs have no data column, only the hidden value column of compact storage.
+    auto data_column = schema->get_column_definition(redis::DATA_COLUMN_NAME);
+    const column_definition& column = data_column ? *data_column : schema->regular_column_at(0);
+    auto pkey = partition_key::from_single_value(*schema, bytes(key));
     auto m = mutation(schema, std::move(pkey));
-    m.partition().apply(tombstone { api::new_timestamp(), gc_clock::now() }); 
+    for (auto& row : rows) {
+        auto cell = make_cell(schema, *(column.type.get()), data_column ? row.second : bytes_view(), ttl);
+        m.set_clustered_cell(clustering_key::from_single_value(*schema, bytes(row.first)), column, std::move(cell));
+    }
     return m;
 }
 
-future<> delete_objects(service::storage_proxy& proxy, redis::redis_options& options, std::vector<bytes>&& keys, service_permit permit) {
-    db::timeout_clock::time_point timeout = db::timeout_clock::now() + options.get_write_timeout();
-    auto write_consistency_level = options.get_write_consistency_level();
-    std::vector<sstring> tables { redis::STRINGs, redis::LISTs, redis::HASHes, redis::SETs, redis::ZSETs }; 
-    auto remove = [&proxy, timeout, write_consistency_level, permit, &options, keys = std::move(keys)] (const sstring& cf_name) {
-        return parallel_for_each(keys.begin(), keys.end(), [&proxy, timeout, write_consistency_level, &options, permit, cf_name] (const bytes& key) {
-            auto m = make_tombstone(proxy, options, cf_name, key);
-            return proxy.mutate(std::vector<mutation> {std::move(m)}, write_consistency_level, timeout, nullptr, permit);
-        });
-    };  
-    return parallel_for_each(tables.begin(), tables.end(), remove);
+mutation make_rows_tombstone(service::storage_proxy& proxy, const redis_options& options, const sstring& cf_name, bytes_view key, const std::vector<bytes_view>& ckeys) {
+    auto schema = get_schema(proxy, options.get_keyspace_name(), cf_name);
+    auto pkey = partition_key::from_single_value(*schema, bytes(key));
+    auto m = mutation(schema, std::move(pkey));
+    auto t = tombstone { api::new_timestamp(), gc_clock::now() };
+    for (auto& ckey : ckeys) {
+        m.partition().apply_delete(*schema, clustering_key::from_single_value(*schema, bytes(ckey)), t);
+    }
+    return m;
+}
+
+bytes make_list_position(bool front, size_t index) {
+    // The clustering key of a LISTs element: an 8 byte big-endian position,
+    // which moves away from the middle of the key space with time in the
+    // direction of the push, then the index of the element within its
+    // command, and a time UUID making concurrent pushes unique.
+    static constexpr uint64_t middle = uint64_t(1) << 63;
+    uint64_t now = api::new_timestamp();
+    uint64_t position = front ? middle - now : middle + now;
+    uint32_t order = front ? std::numeric_limits<uint32_t>::max() - index : index;
+    auto uuid = utils::UUID_gen::get_time_UUID();
+    bytes b(bytes::initialized_later(), sizeof(position) + sizeof(order) + 16);
+    auto out = b.begin();
+    write<uint64_t>(out, position);
+    write<uint32_t>(out, order);
+    write<int64_t>(out, uuid.get_most_significant_bits());
+    write<int64_t>(out, uuid.get_least_significant_bits());
+    return b;
+}
+
+mutation make_tombstone(service::storage_proxy& proxy, const redis_options& options, const sstring& cf_name, bytes_view key,
+        api::timestamp_type timestamp = api::new_timestamp()) {
+    auto schema = get_schema(proxy, options.get_keyspace_name(), cf_name);
+    auto pkey = partition_key::from_single_value(*schema, bytes(key));
+    auto m = mutation(schema, std::move(pkey));
+    m.partition().apply(tombstone { timestamp, gc_clock::now() });
+    return m;
+}
+
+std::vector<mutation> make_delete_mutations(service::storage_proxy& proxy, const redis_options& options, const std::vector<bytes_view>& keys) {
+    std::vector<mutation> mutations;
+    mutations.reserve(keys.size() * 6);
+    for (auto& cf_name : { redis::STRINGs, redis::LISTs, redis::HASHes, redis::SETs, redis::ZSETs, redis::EXPIRATIONs }) {
+        for (auto& key : keys) {
+            mutations.push_back(make_tombstone(proxy, options, cf_name, key));
+        }
+    }
+    return mutations;
+}
+
+mutation make_expiration_mutation(service::storage_proxy& proxy, const redis_options& options, bytes_view key, api::timestamp_type expiration) {
+    auto schema = get_schema(proxy, options.get_keyspace_name(), redis::EXPIRATIONs);
+    const column_definition& column = *schema->get_column_definition(redis::DATA_COLUMN_NAME);
+    auto pkey = partition_key::from_single_value(*schema, bytes(key));
+    auto m = mutation(schema, std::move(pkey));
+    auto cell = make_cell(schema, *(column.type.get()), long_type->decompose(int64_t(expiration)), 0);
+    m.set_clustered_cell(clustering_key::make_empty(), column, std::move(cell));
+    return m;
+}
+
+std::vector<mutation> make_expired_mutations(service::storage_proxy& proxy, const redis_options& options, bytes_view key, api::timestamp_type expiration) {
+    // Tombstones timestamped with the expiration time delete what was
+    // written before it, including the expiration itself, and nothing
+    // written since.
+    std::vector<mutation> mutations;
+    for (auto& cf_name : { redis::LISTs, redis::HASHes, redis::SETs, redis::ZSETs, redis::EXPIRATIONs }) {
+        mutations.push_back(make_tombstone(proxy, options, cf_name, key, expiration));
+    }
+    return mutations;
+}
+
+future<> delete_objects(service::storage_proxy& proxy, redis::redis_options& options, const std::vector<bytes_view>& keys, service_permit permit) {
+    return write_mutations(proxy, options, make_delete_mutations(proxy, options, keys), permit);
 }
 
 }
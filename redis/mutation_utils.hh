@@ -21,6 +21,7 @@
 
 #pragma once
 #include "types.hh"
+#include "timestamp.hh"
 
 class service_permit;
 
@@ -33,7 +34,27 @@ namespace redis {
 
 class redis_options;
 
-future<> write_strings(service::storage_proxy& proxy, redis::redis_options& options, bytes&& key, bytes&& data, long ttl, service_permit permit);
-future<> delete_objects(service::storage_proxy& proxy, redis::redis_options& options, std::vector<bytes>&& keys, service_permit permit);
+mutation make_strings_mutation(service::storage_proxy& proxy, const redis::redis_options& options, bytes_view key, bytes_view data, long ttl);
+// Writes the given (clustering key, data) rows of a HASHes, LISTs or SETs
+// structure. The data is ignored for SETs.
+mutation make_rows_mutation(service::storage_proxy& proxy, const redis::redis_options& options, const sstring& cf_name, bytes_view key,
+        const std::vector<std::pair<bytes_view, bytes_view>>& rows, long ttl);
+mutation make_rows_tombstone(service::storage_proxy& proxy, const redis::redis_options& options, const sstring& cf_name, bytes_view key, const std::vector<bytes_view>& ckeys);
+// The clustering key of the index-th element pushed by a LPUSH (front) or
+// RPUSH command, keeping the LISTs table in list order.
+bytes make_list_position(bool front, size_t index);
+std::vector<mutation> make_delete_mutations(service::storage_proxy& proxy, const redis::redis_options& options, const std::vector<bytes_view>& keys);
+// Makes the LISTs, HASHes, SETs and ZSETs stored under key expire at the
+// given time. Reads apply the expiration with make_expired_mutations() once
+// it has passed, a single cell is written until then.
+mutation make_expiration_mutation(service::storage_proxy& proxy, const redis::redis_options& options, bytes_view key, api::timestamp_type expiration);
+// Deletes what was written to the structures stored under key before it
+// expired, along with the expiration.
+std::vector<mutation> make_expired_mutations(service::storage_proxy& proxy, const redis::redis_options& options, bytes_view key, api::timestamp_type expiration);
+// Submits all the mutations in a single storage_proxy::mutate() call.
+future<> write_mutations(service::storage_proxy& proxy, redis::redis_options& options, std::vector<mutation>&& mutations, service_permit permit);
+
+future<> write_strings(service::storage_proxy& proxy, redis::redis_options& options, bytes_view key, bytes_view data, long ttl, service_permit permit);
+future<> delete_objects(service::storage_proxy& proxy, redis::redis_options& options, const std::vector<bytes_view>& keys, service_permit permit);
 
 }
@@ -40,8 +40,8 @@ action mark {
 }
 
 action start_blob {
-    g.mark_start(p);
     _size_left = _arg_size;
+    _arg = temporary_buffer<char>();
 }
 
 action start_command {
@@ -51,10 +51,11 @@ action start_command {
 
 action advance_blob {
     auto len = std::min(static_cast<uint32_t>(pe - p), _size_left);
+    append_arg(p, len);
     _size_left -= len;
     p += len;
     if (_size_left == 0) {
-      _req._args.push_back(str());
+      _req._args.push_back(std::move(_arg));
       p--;
       fret;
     }
@@ -73,6 +74,12 @@ action advance_command {
     p--;
 }
 
+action check_complete {
+    if (_req._args.size() == _req._args_count) {
+        _req._state = request_state::ok;
+        fbreak;
+    }
+}
 
 crlf = '\r\n';
 u32 = digit+ >{ _u32 = 0;}  ${ _u32 *= 10; _u32 += fc - '0';};
@@ -81,7 +88,7 @@ blob := any+ >start_blob $advance_blob;
 command := any+ >start_command $advance_command;
 arg = '$' u32 crlf ${ _arg_size = _u32;};
 
-main := (args_count (arg @{fcall command; } crlf) (arg @{fcall blob; } crlf)+) ${_req._state = request_state::ok;} >eof{_req._state = request_state::eof;};
+main := (args_count (arg @{fcall command; } crlf @check_complete) (arg @{fcall blob; } crlf @check_complete)*) >eof{_req._state = request_state::eof;};
 
 prepush {
     prepush();
@@ -100,7 +107,30 @@ public:
     uint32_t _u32;
     uint32_t _arg_size;
     uint32_t _size_left;
+private:
+    // The buffer being parsed, if any, and the argument being received.
+    temporary_buffer<char>* _input = nullptr;
+    temporary_buffer<char> _arg;
+
+    // An argument received in one piece shares the input buffer. One which
+    // spans several buffers is copied into a buffer of its final size.
+    void append_arg(const char* p, uint32_t len) {
+        if (_size_left == _arg_size) {
+            if (len == _arg_size && _input) {
+                _arg = _input->share(p - _input->get(), len);
+                return;
+            }
+            _arg = temporary_buffer<char>(_arg_size);
+        }
+        std::copy_n(p, len, _arg.get_write() + (_arg_size - _size_left));
+    }
 public:
+    // Sets the buffer which the next parse() calls are given a part of, so
+    // that arguments can share it instead of being copied.
+    void set_input(temporary_buffer<char>* input) {
+        _input = input;
+    }
+
     virtual void init() {
         init_base();
         _req._state = request_state::error;
@@ -26,6 +26,9 @@
 #include "timeout_config.hh"
 #include "redis/options.hh"
 #include "service_permit.hh"
+#include "redis/mutation_utils.hh"
+#include "mutation.hh"
+#include <seastar/core/future-util.hh>
 
 namespace redis {
 
@@ -59,4 +62,103 @@ future<redis_message> query_processor::process(request&& req, redis::redis_optio
     });
 }
 
+struct pipelined_command {
+    shared_ptr<abstract_command> command;
+    // Set instead of command if the request could not be prepared.
+    std::exception_ptr error;
+
+    abstract_command::pipelining kind() const {
+        return command ? command->pipelining_kind() : abstract_command::pipelining::read;
+    }
+};
+
+struct pipeline_state {
+    std::vector<pipelined_command> commands;
+    std::vector<future<redis_message>> replies;
+    size_t next = 0;
+};
+
+static future<redis_message> execute_one(service::storage_proxy& proxy, pipelined_command& c, redis::redis_options& opts, service_permit permit) {
+    if (c.error) {
+        return make_exception_future<redis_message>(c.error);
+    }
+    return futurize_invoke([&proxy, &c, &opts, permit] {
+        return c.command->execute(proxy, seastar::ref(opts), permit);
+    });
+}
+
+future<std::vector<future<redis_message>>> query_processor::process_pipeline(std::vector<request>&& reqs, redis::redis_options& opts, service_permit permit) {
+    return with_gate(_pending_command_gate, [this, reqs = std::move(reqs), &opts, permit] () mutable {
+        pipeline_state state;
+        state.commands.reserve(reqs.size());
+        state.replies.reserve(reqs.size());
+        for (auto& req : reqs) {
+            try {
+                state.commands.push_back({command_factory::create(_proxy, std::move(req)), nullptr});
+            } catch (...) {
+                state.commands.push_back({nullptr, std::current_exception()});
+            }
+        }
+        return do_with(std::move(state), [this, &opts, permit] (pipeline_state& st) {
+            return repeat([this, &st, &opts, permit] {
+                if (st.next == st.commands.size()) {
+                    return make_ready_future<stop_iteration>(stop_iteration::yes);
+                }
+                auto begin = st.next;
+                auto kind = st.commands[begin].kind();
+                auto end = begin + 1;
+                if (kind != abstract_command::pipelining::barrier) {
+                    while (end < st.commands.size() && st.commands[end].kind() == kind) {
+                        ++end;
+                    }
+                }
+                st.next = end;
+                future<> f = make_ready_future<>();
+                switch (kind) {
+                case abstract_command::pipelining::barrier:
+                    f = execute_one(_proxy, st.commands[begin], opts, permit).then_wrapped([&st] (future<redis_message> r) {
+                        st.replies.push_back(std::move(r));
+                    });
+                    break;
+                case abstract_command::pipelining::read: {
+                    std::vector<future<redis_message>> reads;
+                    reads.reserve(end - begin);
+                    for (auto i = begin; i != end; ++i) {
+                        reads.push_back(execute_one(_proxy, st.commands[i], opts, permit));
+                    }
+                    f = when_all(reads.begin(), reads.end()).then([&st] (std::vector<future<redis_message>> results) {
+                        for (auto& r : results) {
+                            st.replies.push_back(std::move(r));
+                        }
+                    });
+                    break;
+                }
+                case abstract_command::pipelining::write:
+                    f = futurize_invoke([this, &st, &opts, permit, begin, end] {
+                        std::vector<mutation> mutations;
+                        for (auto i = begin; i != end; ++i) {
+                            auto m = st.commands[i].command->make_mutations(_proxy, opts);
+                            std::move(m.begin(), m.end(), std::back_inserter(mutations));
+                        }
+                        return redis::write_mutations(_proxy, opts, std::move(mutations), permit);
+                    }).then_wrapped([&st, begin, end] (future<> written) {
+                        auto ep = written.failed() ? written.get_exception() : nullptr;
+                        for (auto i = begin; i != end; ++i) {
+                            st.replies.push_back(ep ? make_exception_future<redis_message>(ep) : futurize_invoke([&st, i] {
+                                return st.commands[i].command->written();
+                            }));
+                        }
+                    });
+                    break;
+                }
+                return f.then([] {
+                    return stop_iteration::no;
+                });
+            }).then([&st] {
+                return std::move(st.replies);
+            });
+        });
+    });
+}
+
 }
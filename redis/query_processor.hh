@@ -25,6 +25,7 @@
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/gate.hh>
 #include <seastar/core/metrics_registration.hh>
+#include <vector>
 
 
 using namespace seastar;
@@ -62,6 +63,12 @@ class query_processor {
     }
 
     future<redis_message> process(request&&, redis_options&, service_permit);
+    // Processes the requests of a pipeline, preserving their semantic order:
+    // adjacent reads run concurrently and the mutations of adjacent writes
+    // are submitted in a single storage_proxy::mutate() call. Commands which
+    // depend on the connection state, such as SELECT, run alone.
+    // Returns the (ready) outcome of each request, in order.
+    future<std::vector<future<redis_message>>> process_pipeline(std::vector<request>&&, redis_options&, service_permit);
 
     future<> start();
     future<> stop();
@@ -31,8 +31,55 @@
 #include "gc_clock.hh"
 #include "service_permit.hh"
 #include "redis/keyspace_utils.hh"
+#include "database.hh"
+#include <seastar/core/future-util.hh>
+#include <unordered_set>
 
 namespace redis {
+
+using query_results = std::vector<foreign_ptr<lw_shared_ptr<query::result>>>;
+
+// Queries the given singular partition ranges. With CL=ONE or LOCAL_ONE the
+// partitions this node is a replica of are read straight from the shard
+// owning them, and the remaining ones go through the coordinator in a single
+// storage_proxy::query() call.
+static future<query_results> query_partitions(service::storage_proxy& proxy, const redis_options& options, schema_ptr schema,
+        const query::read_command& cmd, dht::partition_range_vector&& partition_ranges, service_permit permit) {
+    auto read_consistency_level = options.get_read_consistency_level();
+    db::timeout_clock::time_point timeout = db::timeout_clock::now() + options.get_read_timeout();
+    dht::partition_range_vector local_ranges;
+    dht::partition_range_vector remote_ranges;
+    if (read_consistency_level == db::consistency_level::ONE || read_consistency_level == db::consistency_level::LOCAL_ONE) {
+        auto& ks = proxy.get_db().local().find_keyspace(schema->ks_name());
+        for (auto& pr : partition_ranges) {
+            auto& ranges = proxy.is_local_replica(ks, pr.start()->value().token()) ? local_ranges : remote_ranges;
+            ranges.push_back(std::move(pr));
+        }
+    } else {
+        remote_ranges = std::move(partition_ranges);
+    }
+    auto results = make_lw_shared<query_results>();
+    auto local = parallel_for_each(local_ranges, [&proxy, schema, &cmd, timeout, results] (const dht::partition_range& pr) {
+        return proxy.query_local_replica(schema, make_lw_shared<query::read_command>(cmd), pr, timeout).then([results] (auto result) {
+            results->push_back(std::move(result));
+        });
+    });
+    auto remote = make_ready_future<>();
+    if (!remote_ranges.empty()) {
+        remote = proxy.query(schema, make_lw_shared<query::read_command>(cmd), std::move(remote_ranges), read_consistency_level,
+                {timeout, permit, service::client_state::for_internal_calls()}).then([results] (service::storage_proxy::coordinator_query_result qr) {
+            results->push_back(std::move(qr.query_result));
+        });
+    }
+    return when_all_succeed(std::move(local), std::move(remote)).then([results] {
+        return std::move(*results);
+    });
+}
+
+static dht::partition_range make_partition_range(const schema& schema, bytes_view key) {
+    auto pkey = partition_key::from_single_value(schema, bytes(key));
+    return dht::partition_range::make_singular(dht::decorate_key(schema, std::move(pkey)));
+}
 class strings_result_builder {
     lw_shared_ptr<strings_result> _data;
     const query::partition_slice& _partition_slice;
@@ -69,23 +116,186 @@ class strings_result_builder {
     void accept_partition_end(const query::result_row_view& static_row) {}
 };
 
-future<lw_shared_ptr<strings_result>> read_strings(service::storage_proxy& proxy, const redis_options& options, const bytes& key, service_permit permit) {
-    auto schema = get_schema(proxy, options.get_keyspace_name(), redis::STRINGs);
+// Reads the data column of a table without clustering key, like STRINGs.
+static future<lw_shared_ptr<strings_result>> read_data(service::storage_proxy& proxy, const redis_options& options, const sstring& cf_name,
+        bytes_view key, service_permit permit) {
+    auto schema = get_schema(proxy, options.get_keyspace_name(), cf_name);
     auto ps = partition_slice_builder(*schema).build();
-    query::read_command cmd(schema->id(), schema->version(), ps, 1, gc_clock::now(), std::nullopt, 1); 
-    auto pkey = partition_key::from_single_value(*schema, key);
-    auto partition_range = dht::partition_range::make_singular(dht::decorate_key(*schema, std::move(pkey)));
+    query::read_command cmd(schema->id(), schema->version(), ps, 1, gc_clock::now(), std::nullopt, 1);
     dht::partition_range_vector partition_ranges;
-    partition_ranges.emplace_back(std::move(partition_range));
-    auto read_consistency_level = options.get_read_consistency_level();
-    db::timeout_clock::time_point timeout = db::timeout_clock::now() + options.get_read_timeout();
-    return proxy.query(schema, make_lw_shared(std::move(cmd)), std::move(partition_ranges), read_consistency_level, {timeout, permit, service::client_state::for_internal_calls()}).then([ps, schema] (auto qr) {
-        return query::result_view::do_with(*qr.query_result, [&] (query::result_view v) {
-            auto pd = make_lw_shared<strings_result>();
-            v.consume(ps, strings_result_builder(pd, schema, ps));
-            return pd;
-        }); 
-    }); 
+    partition_ranges.emplace_back(make_partition_range(*schema, key));
+    return query_partitions(proxy, options, schema, cmd, std::move(partition_ranges), permit).then([ps, schema] (query_results results) {
+        auto pd = make_lw_shared<strings_result>();
+        for (auto& result : results) {
+            query::result_view::do_with(*result, [&] (query::result_view v) {
+                v.consume(ps, strings_result_builder(pd, schema, ps));
+            });
+        }
+        return pd;
+    });
+}
+
+future<lw_shared_ptr<strings_result>> read_strings(service::storage_proxy& proxy, const redis_options& options, bytes_view key, service_permit permit) {
+    return read_data(proxy, options, redis::STRINGs, key, permit);
+}
+
+future<std::optional<api::timestamp_type>> read_expiration(service::storage_proxy& proxy, const redis_options& options, bytes_view key, service_permit permit) {
+    return read_data(proxy, options, redis::EXPIRATIONs, key, permit).then([] (lw_shared_ptr<strings_result> result) -> std::optional<api::timestamp_type> {
+        if (!result->has_result()) {
+            return std::nullopt;
+        }
+        return value_cast<int64_t>(long_type->deserialize_value(result->result()));
+    });
+}
+
+// The clustering key and the data column of a result row.
+static std::pair<bytes, bytes> make_row(const schema& schema, const query::partition_slice& ps, const clustering_key& key, const query::result_row_view& row) {
+    bytes data;
+    auto row_iterator = row.iterator();
+    for (auto&& id : ps.regular_columns) {
+        auto& col = schema.regular_column_at(id);
+        auto cell = row_iterator.next_atomic_cell();
+        if (cell && col.name_as_text() == redis::DATA_COLUMN_NAME) {
+            cell->value().with_linearized([&data] (bytes_view cell_view) {
+                data = bytes(cell_view);
+            });
+        }
+    }
+    auto ckey = key.explode(schema);
+    return { ckey.empty() ? bytes() : std::move(ckey.front()), std::move(data) };
+}
+
+class rows_result_builder {
+    lw_shared_ptr<rows_result> _data;
+    const query::partition_slice& _partition_slice;
+    const schema_ptr _schema;
+public:
+    rows_result_builder(lw_shared_ptr<rows_result> data, const schema_ptr schema, const query::partition_slice& ps)
+        : _data(data)
+        , _partition_slice(ps)
+        , _schema(schema)
+    {
+    }
+    void accept_new_partition(const partition_key& key, uint32_t row_count) {}
+    void accept_new_partition(uint32_t row_count) {}
+    void accept_new_row(const clustering_key& key, const query::result_row_view& static_row, const query::result_row_view& row)
+    {
+        _data->_rows.push_back(make_row(*_schema, _partition_slice, key, row));
+    }
+    void accept_new_row(const query::result_row_view& static_row, const query::result_row_view& row) {}
+    void accept_partition_end(const query::result_row_view& static_row) {}
+};
+
+static future<lw_shared_ptr<rows_result>> query_rows(service::storage_proxy& proxy, const redis_options& options, schema_ptr schema, bytes_view key,
+        query::partition_slice ps, uint32_t row_limit, service_permit permit) {
+    query::read_command cmd(schema->id(), schema->version(), ps, row_limit, gc_clock::now(), std::nullopt, 1);
+    dht::partition_range_vector partition_ranges;
+    partition_ranges.emplace_back(make_partition_range(*schema, key));
+    return query_partitions(proxy, options, schema, cmd, std::move(partition_ranges), permit).then([ps, schema] (query_results results) {
+        auto pd = make_lw_shared<rows_result>();
+        for (auto& result : results) {
+            query::result_view::do_with(*result, [&] (query::result_view v) {
+                v.consume(ps, rows_result_builder(pd, schema, ps));
+            });
+        }
+        return pd;
+    });
+}
+
+future<lw_shared_ptr<rows_result>> read_rows(service::storage_proxy& proxy, const redis_options& options, const sstring& cf_name, bytes_view key,
+        std::optional<bytes_view> ckey, uint32_t row_limit, bool reversed, service_permit permit) {
+    auto schema = get_schema(proxy, options.get_keyspace_name(), cf_name);
+    auto builder = partition_slice_builder(*schema);
+    if (ckey) {
+        builder.with_range(query::clustering_range::make_singular(clustering_key::from_single_value(*schema, bytes(*ckey))));
+    }
+    if (reversed) {
+        builder.reversed();
+    }
+    return query_rows(proxy, options, schema, key, builder.build(), row_limit, permit);
+}
+
+future<lw_shared_ptr<rows_result>> read_rows(service::storage_proxy& proxy, const redis_options& options, const sstring& cf_name, bytes_view key,
+        const std::vector<bytes_view>& ckeys, service_permit permit) {
+    if (ckeys.empty()) {
+        return make_ready_future<lw_shared_ptr<rows_result>>(make_lw_shared<rows_result>());
+    }
+    auto schema = get_schema(proxy, options.get_keyspace_name(), cf_name);
+    // The ranges of a slice must be sorted and must not overlap.
+    std::vector<clustering_key> keys;
+    keys.reserve(ckeys.size());
+    for (auto& ckey : ckeys) {
+        keys.push_back(clustering_key::from_single_value(*schema, bytes(ckey)));
+    }
+    std::sort(keys.begin(), keys.end(), clustering_key::less_compare(*schema));
+    keys.erase(std::unique(keys.begin(), keys.end(), clustering_key::equality(*schema)), keys.end());
+    std::vector<query::clustering_range> ranges;
+    ranges.reserve(keys.size());
+    for (auto& ckey : keys) {
+        ranges.push_back(query::clustering_range::make_singular(std::move(ckey)));
+    }
+    auto row_limit = ranges.size();
+    auto ps = partition_slice_builder(*schema).with_ranges(std::move(ranges)).build();
+    return query_rows(proxy, options, schema, key, std::move(ps), row_limit, permit);
+}
+
+future<uint64_t> count_rows(service::storage_proxy& proxy, const redis_options& options, const sstring& cf_name, bytes_view key, service_permit permit) {
+    auto schema = get_schema(proxy, options.get_keyspace_name(), cf_name);
+    auto ps = partition_slice_builder(*schema).with_no_regular_columns().build();
+    return query_rows(proxy, options, schema, key, std::move(ps), query::max_rows, permit).then([] (lw_shared_ptr<rows_result> result) {
+        return uint64_t(result->rows().size());
+    });
+}
+
+class partitions_result_builder {
+    lw_shared_ptr<partitions_result> _data;
+    const query::partition_slice& _partition_slice;
+    const schema_ptr _schema;
+    rows_result* _current = nullptr;
+public:
+    partitions_result_builder(lw_shared_ptr<partitions_result> data, const schema_ptr schema, const query::partition_slice& ps)
+        : _data(data)
+        , _partition_slice(ps)
+        , _schema(schema)
+    {
+    }
+    void accept_new_partition(const partition_key& key, uint32_t row_count) {
+        _current = &_data->_partitions[key.explode(*_schema).front()];
+    }
+    void accept_new_partition(uint32_t row_count) {}
+    void accept_new_row(const clustering_key& key, const query::result_row_view& static_row, const query::result_row_view& row)
+    {
+        _current->_rows.push_back(make_row(*_schema, _partition_slice, key, row));
+    }
+    void accept_new_row(const query::result_row_view& static_row, const query::result_row_view& row) {}
+    void accept_partition_end(const query::result_row_view& static_row) {}
+};
+
+future<lw_shared_ptr<partitions_result>> read_partitions(service::storage_proxy& proxy, const redis_options& options, const sstring& cf_name,
+        const std::vector<bytes_view>& keys, uint32_t partition_row_limit, service_permit permit) {
+    auto schema = get_schema(proxy, options.get_keyspace_name(), cf_name);
+    auto ps = partition_slice_builder(*schema).build();
+    ps.set_partition_row_limit(partition_row_limit);
+    std::unordered_set<bytes_view> unique_keys(keys.begin(), keys.end());
+    query::read_command cmd(schema->id(), schema->version(), ps, query::max_rows, gc_clock::now(), std::nullopt, unique_keys.size());
+    dht::partition_range_vector partition_ranges;
+    partition_ranges.reserve(unique_keys.size());
+    for (auto& key : unique_keys) {
+        partition_ranges.emplace_back(make_partition_range(*schema, key));
+    }
+    // Singular ranges must be sorted for the coordinator to merge their results.
+    std::sort(partition_ranges.begin(), partition_ranges.end(), [&schema] (const dht::partition_range& a, const dht::partition_range& b) {
+        return a.start()->value().less_compare(*schema, b.start()->value());
+    });
+    return query_partitions(proxy, options, schema, cmd, std::move(partition_ranges), permit).then([ps, schema] (query_results results) {
+        auto pd = make_lw_shared<partitions_result>();
+        for (auto& result : results) {
+            query::result_view::do_with(*result, [&] (query::result_view v) {
+                v.consume(ps, partitions_result_builder(pd, schema, ps));
+            });
+        }
+        return pd;
+    });
 }
 
 }
@@ -24,6 +24,10 @@
 #include "seastar/core/shared_ptr.hh"
 #include "seastar/core/future.hh"
 #include "bytes.hh"
+#include "timestamp.hh"
+#include <optional>
+#include <vector>
+#include <unordered_map>
 
 using namespace seastar;
 
@@ -45,6 +49,43 @@ struct strings_result {
     bool has_result() const { return _has_result; }
 };
 
-future<lw_shared_ptr<strings_result>> read_strings(service::storage_proxy&, const redis_options&, const bytes&, service_permit);
+future<lw_shared_ptr<strings_result>> read_strings(service::storage_proxy&, const redis_options&, bytes_view key, service_permit);
+
+// The time at which the structures stored under key expire, if EXPIRE set one.
+future<std::optional<api::timestamp_type>> read_expiration(service::storage_proxy&, const redis_options&, bytes_view key, service_permit);
+
+// The rows of a HASHes, LISTs or SETs structure, in clustering order: the
+// clustering key (field, list position or member) and the data column, which
+// is empty for SETs.
+struct rows_result {
+    std::vector<std::pair<bytes, bytes>> _rows;
+    std::vector<std::pair<bytes, bytes>>& rows() { return _rows; }
+    bool has_result() const { return !_rows.empty(); }
+};
+
+// Reads the rows of the structure stored under key in cf_name, or only the
+// one with the given clustering key. With reversed set, the last row_limit
+// rows are returned in reverse clustering order.
+future<lw_shared_ptr<rows_result>> read_rows(service::storage_proxy&, const redis_options&, const sstring& cf_name, bytes_view key,
+        std::optional<bytes_view> ckey, uint32_t row_limit, bool reversed, service_permit);
+// Reads the rows with the given clustering keys, which may repeat.
+future<lw_shared_ptr<rows_result>> read_rows(service::storage_proxy&, const redis_options&, const sstring& cf_name, bytes_view key,
+        const std::vector<bytes_view>& ckeys, service_permit);
+// The number of rows of the structure stored under key in cf_name. Only
+// the clustering keys are read.
+future<uint64_t> count_rows(service::storage_proxy&, const redis_options&, const sstring& cf_name, bytes_view key, service_permit);
+
+// The rows of several partitions of a structure table, by key. Keys which
+// do not exist are absent.
+struct partitions_result {
+    std::unordered_map<bytes, rows_result> _partitions;
+    std::unordered_map<bytes, rows_result>& partitions() { return _partitions; }
+};
+
+// Reads the partitions of the given keys of cf_name, at most
+// partition_row_limit rows of each, with a single coordinator query for the
+// keys which are not read locally.
+future<lw_shared_ptr<partitions_result>> read_partitions(service::storage_proxy&, const redis_options&, const sstring& cf_name,
+        const std::vector<bytes_view>& keys, uint32_t partition_row_limit, service_permit);
 
 }
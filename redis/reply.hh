@@ -27,6 +27,8 @@
 #include <seastar/core/print.hh>
 #include "seastar/core/scattered_message.hh"
 #include "redis/exceptions.hh"
+#include <optional>
+#include <vector>
 
 using namespace seastar;
 
@@ -78,6 +80,27 @@ class redis_message final {
         write_bytes(m, result);
         return make_ready_future<redis_message>(m);
     }
+    static future<redis_message> make_array_result(std::vector<bytes> results) {
+        auto m = make_lw_shared<scattered_message<char>> ();
+        m->append(sprint("*%d\r\n", results.size()));
+        for (auto& b : results) {
+            write_bytes(m, b);
+        }
+        return make_ready_future<redis_message>(m);
+    }
+    // Like make_array_result(), with nil for disengaged values.
+    static future<redis_message> make_nullable_array_result(std::vector<std::optional<bytes>> results) {
+        auto m = make_lw_shared<scattered_message<char>> ();
+        m->append(sprint("*%d\r\n", results.size()));
+        for (auto& b : results) {
+            if (b) {
+                write_bytes(m, *b);
+            } else {
+                m->append_static("$-1\r\n");
+            }
+        }
+        return make_ready_future<redis_message>(m);
+    }
     static future<redis_message> unknown(const bytes& name) {
         return from_exception(make_message("-ERR unknown command '%s'\r\n", to_sstring(name)));
     }
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <vector>
+#include <seastar/core/temporary_buffer.hh>
 #include "bytes.hh"
 
 namespace redis {
@@ -32,11 +33,19 @@ namespace redis {
     ok, 
 };
 
+using argument = seastar::temporary_buffer<char>;
+
+inline bytes_view to_bytes_view(const argument& b) {
+    return bytes_view(reinterpret_cast<const bytes_view::value_type*>(b.get()), b.size());
+}
+
 struct request {
     request_state _state; 
     bytes _command;
     uint32_t _args_count;
-    std::vector<bytes> _args;
+    // The arguments share the buffers they were received in whenever they
+    // were received in one piece, and are only copied into mutations.
+    std::vector<argument> _args;
     size_t arguments_size() const { return _args.size(); }
     size_t total_request_size() const {
         size_t r = 0;
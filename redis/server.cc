@@ -123,11 +123,9 @@ future<> redis_server::do_accepts(int which, bool keepalive, socket_address serv
     });
 }
 
-future<redis_server::result> redis_server::connection::process_request_one(redis::request&& request, redis::redis_options& opts, service_permit permit) {
-    return futurize_invoke([this, request = std::move(request), &opts, permit] () mutable {
-        return _server._query_processor.local().process(std::move(request), seastar::ref(opts), permit).then([] (auto&& message) {
-            return make_ready_future<redis_server::result> (std::move(message));
-        });
+future<std::vector<future<redis::redis_message>>> redis_server::connection::process_requests(std::vector<redis::request>&& requests, redis::redis_options& opts, service_permit permit) {
+    return futurize_invoke([this, requests = std::move(requests), &opts, permit] () mutable {
+        return _server._query_processor.local().process_pipeline(std::move(requests), seastar::ref(opts), permit);
     });
 }
 
@@ -139,6 +137,7 @@ redis_server::connection::connection(redis_server& server, socket_address server
     , _write_buf(_fd.output())
     , _options(server._config._read_consistency_level, server._config._write_consistency_level, server._config._timeout_config, server._auth_service, addr, server._total_redis_db_count)
 {
+    _parser.init();
     ++_server._stats._total_connections;
     ++_server._stats._current_connections;
     _server._connections_list.push_back(*this);
@@ -190,10 +189,10 @@ future<> redis_server::connection::shutdown()
     return make_ready_future<>();
 }
 
-thread_local redis_server::connection::execution_stage_type redis_server::connection::_process_request_stage {"redis_transport", &connection::process_request_one};
+thread_local redis_server::connection::execution_stage_type redis_server::connection::_process_request_stage {"redis_transport", &connection::process_requests};
 
-future<redis_server::result> redis_server::connection::process_request_internal() {
-    return _process_request_stage(this, std::move(_parser.get_request()), seastar::ref(_options), empty_service_permit());
+future<std::vector<future<redis::redis_message>>> redis_server::connection::process_request_internal(std::vector<redis::request>&& requests) {
+    return _process_request_stage(this, std::move(requests), seastar::ref(_options), empty_service_permit());
 }
 
 void redis_server::connection::write_reply(const redis_exception& e)
@@ -208,48 +207,112 @@ void redis_server::connection::write_reply(const redis_exception& e)
     });
 }
 
-void redis_server::connection::write_reply(redis_server::result result)
+static future<redis::redis_message> to_reply(future<redis::redis_message> f) {
+    try {
+        return make_ready_future<redis::redis_message>(f.get0());
+    } catch (redis_exception& e) {
+        return redis::redis_message::exception(e);
+    } catch (std::exception& e) {
+        return redis::redis_message::exception(sstring(e.what()));
+    } catch (...) {
+        return redis::redis_message::exception(sstring("Unknown exception"));
+    }
+}
+
+void redis_server::connection::write_replies(std::vector<future<redis::redis_message>> replies)
 {
-    _ready_to_respond = _ready_to_respond.then([this, result = std::move(result)] () mutable {
-        auto m = result.make_message();
-        return _write_buf.write(std::move(*m)).then([this] {
-            return _write_buf.flush();
+    _ready_to_respond = _ready_to_respond.then([this, replies = std::move(replies)] () mutable {
+        return do_with(std::move(replies), [this] (std::vector<future<redis::redis_message>>& replies) {
+            return do_for_each(replies, [this] (future<redis::redis_message>& reply) {
+                return to_reply(std::move(reply)).then([this] (redis::redis_message m) {
+                    return _write_buf.write(std::move(*m.message()));
+                });
+            }).then([this] {
+                return _write_buf.flush();
+            });
         });
     });
 }
-future<> redis_server::connection::process_request() {
-    _parser.init();
-    return _read_buf.consume(_parser).then([this] {
-        if (_parser.eof()) {
-            return make_ready_future<>();
-        }
-        ++_server._stats._requests_serving;
-        _pending_requests_gate.enter();
-        utils::latency_counter lc;
-        lc.start();
-        auto leave = defer([this] { _pending_requests_gate.leave(); });
-        return process_request_internal().then([this, leave = std::move(leave), lc = std::move(lc)] (auto&& result) mutable {
-            --_server._stats._requests_serving;
-            try {
-                write_reply(std::move(result));
-                ++_server._stats._requests_served;
-                _server._stats._requests.mark(lc.stop().latency());
-                if (lc.is_start()) {
-                    _server._stats._estimated_requests_latency.add(lc.latency(), _server._stats._requests.hist.count);
+
+// Feeds the parser with the input received so far and collects every
+// complete request in it, so that pipelined requests are processed as one
+// batch and answered with a single flush. Stops once at least one request is
+// available and the buffered input is exhausted; a request which continues
+// past the buffer is kept in the parser and completed by the next batch.
+class request_batch_consumer {
+    redis_protocol_parser& _parser;
+    std::vector<redis::request>& _requests;
+    size_t _max_requests;
+public:
+    using unconsumed_remainder = std::optional<temporary_buffer<char>>;
+
+    request_batch_consumer(redis_protocol_parser& parser, std::vector<redis::request>& requests, size_t max_requests)
+        : _parser(parser), _requests(requests), _max_requests(max_requests) {
+    }
+
+    future<unconsumed_remainder> operator()(temporary_buffer<char> buf) {
+        char* p = buf.get_write();
+        char* pe = p + buf.size();
+        char* eof = buf.empty() ? pe : nullptr;
+        _parser.set_input(&buf);
+        auto reset_input = defer([this] { _parser.set_input(nullptr); });
+        while (true) {
+            char* parsed = _parser.parse(p, pe, eof);
+            if (!parsed) {
+                if (_requests.empty()) {
+                    return make_ready_future<unconsumed_remainder>();
                 }
-            } catch (...) {
-                logging.error("request processing failed: {}", std::current_exception());
+                return make_ready_future<unconsumed_remainder>(temporary_buffer<char>());
             }
+            if (_parser.eof()) {
+                return make_ready_future<unconsumed_remainder>(temporary_buffer<char>());
+            }
+            _requests.push_back(std::move(_parser.get_request()));
+            _parser.init();
+            p = parsed;
+            if (p == pe || _requests.size() >= _max_requests) {
+                buf.trim_front(p - buf.get());
+                return make_ready_future<unconsumed_remainder>(std::move(buf));
+            }
+        }
+    }
+};
+
+future<> redis_server::connection::process_request() {
+    return do_with(std::vector<redis::request>(), [this] (std::vector<redis::request>& requests) {
+        return _read_buf.consume(request_batch_consumer(_parser, requests, max_pipelined_requests)).then([this, &requests] {
+            if (requests.empty()) {
+                return make_ready_future<>();
+            }
+            auto count = requests.size();
+            _server._stats._requests_serving += count;
+            if (count > 1) {
+                _server._stats._requests_pipelined += count;
+            }
+            _pending_requests_gate.enter();
+            utils::latency_counter lc;
+            lc.start();
+            auto leave = defer([this] { _pending_requests_gate.leave(); });
+            return process_request_internal(std::move(requests)).then([this, count, leave = std::move(leave), lc = std::move(lc)] (auto&& replies) mutable {
+                _server._stats._requests_serving -= count;
+                try {
+                    write_replies(std::move(replies));
+                    _server._stats._requests_served += count;
+                    auto latency = lc.stop().latency();
+                    for (size_t i = 0; i < count; ++i) {
+                        _server._stats._requests.mark(latency);
+                    }
+                    if (lc.is_start()) {
+                        _server._stats._estimated_requests_latency.add(lc.latency(), _server._stats._requests.hist.count);
+                    }
+                } catch (...) {
+                    logging.error("request processing failed: {}", std::current_exception());
+                }
+            });
         });
     });
 }
 
-static inline bytes_view to_bytes_view(temporary_buffer<char>& b)
-{
-    using byte = bytes_view::value_type;
-    return bytes_view(reinterpret_cast<const byte*>(b.get()), b.size());
-}
-
 }
 
 db::consistency_level make_consistency_level(const sstring& level)
@@ -102,6 +102,8 @@ class redis_server {
         redis::redis_options _options;
         future<> _ready_to_respond = make_ready_future<>();
         unsigned _request_cpu = 0;
+        // Upper bound on the number of pipelined requests processed together.
+        static constexpr size_t max_pipelined_requests = 1024;
     private:
         enum class tracing_request_type : uint8_t {
             not_requested,
@@ -110,9 +112,9 @@ class redis_server {
         };  
 
         using execution_stage_type = inheriting_concrete_execution_stage<
-                future<redis_server::result>,
+                future<std::vector<future<redis::redis_message>>>,
                 redis_server::connection*,
-                redis::request&&,
+                std::vector<redis::request>&&,
                 redis::redis_options&,
                 service_permit
         >;
@@ -123,13 +125,13 @@ class redis_server {
         future<> process();
         future<> process_request();
         void write_reply(const redis_exception&);
-        void write_reply(redis_server::result result);
+        void write_replies(std::vector<future<redis::redis_message>> replies);
         future<> shutdown();
     private:
         const ::timeout_config& timeout_config() { return _server.timeout_config(); }
         friend class process_request_executor;
-        future<result> process_request_one(redis::request&& request, redis::redis_options&, service_permit permit);
-        future<result> process_request_internal();
+        future<std::vector<future<redis::redis_message>>> process_requests(std::vector<redis::request>&& requests, redis::redis_options&, service_permit permit);
+        future<std::vector<future<redis::redis_message>>> process_request_internal(std::vector<redis::request>&& requests);
     };
 
 private:
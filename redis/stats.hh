@@ -50,6 +50,7 @@ class stats {
     uint64_t _connections = 0;
     uint64_t _requests_served = 0;
     uint64_t _requests_serving = 0;
+    uint64_t _requests_pipelined = 0;
     uint64_t _total_connections = 0;
     uint64_t _current_connections = 0;
     uint64_t _connections_being_accepted = 0;
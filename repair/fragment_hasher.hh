@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "schema.hh"
+#include "mutation_fragment.hh"
+#include "atomic_cell_hash.hh"
+#include "hashing.hh"
+
+#include <seastar/util/variant_utils.hh>
+
+// Feeds the content of mutation fragments to a hasher, computing the
+// repair_hash of rows in row level repair. Nodes compare these hashes, so
+// what is fed must not change. Use a buffered_xx_hasher (xx_hasher.hh)
+// rather than an xx_hasher, which pays for every small update.
+template <typename H>
+GCC6_CONCEPT(requires Hasher<H>())
+class fragment_hasher {
+    const schema& _schema;
+    H& _hasher;
+private:
+    void consume_cell(const column_definition& col, const atomic_cell_or_collection& cell) {
+        feed_hash(_hasher, col.kind);
+        feed_hash(_hasher, col.id);
+        feed_hash(_hasher, cell, col);
+    }
+public:
+    explicit fragment_hasher(const schema& s, H& h)
+        : _schema(s), _hasher(h) { }
+
+    void hash(const mutation_fragment& mf) {
+        mf.visit(seastar::make_visitor(
+            [&] (const clustering_row& cr) {
+                consume(cr);
+            },
+            [&] (const static_row& sr) {
+                consume(sr);
+            },
+            [&] (const range_tombstone& rt) {
+                consume(rt);
+            },
+            [&] (const partition_start& ps) {
+                consume(ps);
+            },
+            [&] (const partition_end& pe) {
+                throw std::runtime_error("partition_end is not expected");
+            }
+        ));
+    }
+
+private:
+
+    void consume(const tombstone& t) {
+        feed_hash(_hasher, t);
+    }
+
+    void consume(const static_row& sr) {
+        sr.cells().for_each_cell([&] (column_id id, const atomic_cell_or_collection& cell) {
+            auto&& col = _schema.static_column_at(id);
+            consume_cell(col, cell);
+        });
+    }
+
+    void consume(const clustering_row& cr) {
+        feed_hash(_hasher, cr.key(), _schema);
+        feed_hash(_hasher, cr.tomb());
+        feed_hash(_hasher, cr.marker());
+        cr.cells().for_each_cell([&] (column_id id, const atomic_cell_or_collection& cell) {
+            auto&& col = _schema.regular_column_at(id);
+            consume_cell(col, cell);
+        });
+    }
+
+    void consume(const range_tombstone& rt) {
+        feed_hash(_hasher, rt.start, _schema);
+        feed_hash(_hasher, rt.start_kind);
+        feed_hash(_hasher, rt.tomb);
+        feed_hash(_hasher, rt.end, _schema);
+        feed_hash(_hasher, rt.end_kind);
+    }
+
+    void consume(const partition_start& ps) {
+        feed_hash(_hasher, ps.key().key(), _schema);
+        if (ps.partition_tombstone()) {
+            consume(ps.partition_tombstone());
+        }
+    }
+};
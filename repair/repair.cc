@@ -36,6 +36,7 @@
 #include "database.hh"
 #include "hashers.hh"
 #include "locator/network_topology_strategy.hh"
+#include "db/system_keyspace.hh"
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -73,6 +74,8 @@ std::ostream& operator<<(std::ostream& out, row_level_diff_detect_algorithm algo
         return out << "send_full_set";
     case row_level_diff_detect_algorithm::send_full_set_rpc_stream:
         return out << "send_full_set_rpc_stream";
+    case row_level_diff_detect_algorithm::send_iblt_rpc_stream:
+        return out << "send_iblt_rpc_stream";
     };
     return out << "unknown";
 }
@@ -1079,6 +1082,8 @@ void repair_stats::add(const repair_stats& o) {
     round_nr_fast_path_same_combined_hashes += o.round_nr_fast_path_same_combined_hashes;
     round_nr_slow_path += o.round_nr_slow_path;
     rpc_call_nr += o.rpc_call_nr;
+    sketch_decoded_nr += o.sketch_decoded_nr;
+    sketch_failed_nr += o.sketch_failed_nr;
     tx_hashes_nr += o.tx_hashes_nr;
     rx_hashes_nr += o.rx_hashes_nr;
     tx_row_nr += o.tx_row_nr;
@@ -1114,12 +1119,14 @@ sstring repair_stats::get_stats() {
             row_from_disk_rows_per_sec[x.first] = 0;
         }
     }
-    return format("round_nr={}, round_nr_fast_path_already_synced={}, round_nr_fast_path_same_combined_hashes={}, round_nr_slow_path={}, rpc_call_nr={}, tx_hashes_nr={}, rx_hashes_nr={}, duration={} seconds, tx_row_nr={}, rx_row_nr={}, tx_row_bytes={}, rx_row_bytes={}, row_from_disk_bytes={}, row_from_disk_nr={}, row_from_disk_bytes_per_sec={} MiB/s, row_from_disk_rows_per_sec={} Rows/s, tx_row_nr_peer={}, rx_row_nr_peer={}",
+    return format("round_nr={}, round_nr_fast_path_already_synced={}, round_nr_fast_path_same_combined_hashes={}, round_nr_slow_path={}, rpc_call_nr={}, sketch_decoded_nr={}, sketch_failed_nr={}, tx_hashes_nr={}, rx_hashes_nr={}, duration={} seconds, tx_row_nr={}, rx_row_nr={}, tx_row_bytes={}, rx_row_bytes={}, row_from_disk_bytes={}, row_from_disk_nr={}, row_from_disk_bytes_per_sec={} MiB/s, row_from_disk_rows_per_sec={} Rows/s, tx_row_nr_peer={}, rx_row_nr_peer={}",
             round_nr,
             round_nr_fast_path_already_synced,
             round_nr_fast_path_same_combined_hashes,
             round_nr_slow_path,
             rpc_call_nr,
+            sketch_decoded_nr,
+            sketch_failed_nr,
             tx_hashes_nr,
             rx_hashes_nr,
             duration,
@@ -1163,6 +1170,9 @@ struct repair_options {
     // The node starting the repair must be in the data center; Issuing a
     // repair to a data center other than the named one returns an error.
     std::vector<sstring> data_centers;
+    // If incremental is true, only data which wasn't repaired yet is read,
+    // and the data repaired successfully is marked as repaired afterwards.
+    bool incremental = false;
 
     repair_options(std::unordered_map<sstring, sstring> options) {
         bool_opt(primary_range, options, PRIMARY_RANGE_KEY);
@@ -1170,13 +1180,11 @@ struct repair_options {
         list_opt(column_families, options, COLUMNFAMILIES_KEY);
         list_opt(hosts, options, HOSTS_KEY);
         list_opt(data_centers, options, DATACENTERS_KEY);
-        // We currently do not support incremental repair. We could probably
-        // ignore this option as it is just an optimization, but for now,
-        // let's make it an error.
-        bool incremental = false;
         bool_opt(incremental, options, INCREMENTAL_KEY);
-        if (incremental) {
-            throw std::runtime_error("unsupported incremental repair");
+        // Data marked as repaired is never compared again, so all replicas
+        // must take part in an incremental repair.
+        if (incremental && (!hosts.empty() || !data_centers.empty())) {
+            throw std::runtime_error("incremental repair cannot be restricted to hosts or data centers");
         }
         // We do not currently support the distinction between "parallel" and
         // "sequential" repair, and operate the same for both.
@@ -1452,34 +1460,91 @@ static int do_repair_start(seastar::sharded<database>& db, sstring keyspace,
         return id;
     }
 
+    if (options.incremental && !db.local().features().cluster_supports_row_level_repair()) {
+        throw std::runtime_error("incremental repair requires row level repair");
+    }
+    if (options.incremental && !db.local().features().cluster_supports_incremental_repair()) {
+        throw std::runtime_error("incremental repair is not supported by all nodes of the cluster");
+    }
+
+    // All replicas of the repaired ranges. With incremental repair, they
+    // record their unrepaired sstables before the repair, and mark them as
+    // repaired once it succeeded. A successful repair which isn't restricted
+    // to some hosts or data centers is recorded in their repair history.
+    std::vector<gms::inet_address> all_nodes;
+    auto all_replicas = options.data_centers.empty() && options.hosts.empty();
+    if (options.incremental || all_replicas) {
+        std::unordered_set<gms::inet_address> nodes{utils::fb_utilities::get_broadcast_address()};
+        for (auto& range : ranges) {
+            auto neighbors = get_neighbors(db.local(), keyspace, range, options.data_centers, options.hosts);
+            nodes.insert(neighbors.begin(), neighbors.end());
+        }
+        all_nodes.assign(nodes.begin(), nodes.end());
+    }
+
     // Do it in the background.
     (void)repair_tracker().run(id, [&db, id, keyspace = std::move(keyspace),
-            cfs = std::move(cfs), ranges = std::move(ranges), options = std::move(options)] () mutable {
-        std::vector<future<>> repair_results;
-        repair_results.reserve(smp::count);
-        for (auto shard : boost::irange(unsigned(0), smp::count)) {
-            auto f = db.invoke_on(shard, [&db, keyspace, cfs, id, ranges,
-                    data_centers = options.data_centers, hosts = options.hosts] (database& localdb) mutable {
-                auto ri = make_lw_shared<repair_info>(db,
-                        std::move(keyspace), std::move(ranges), std::move(cfs),
-                        id, std::move(data_centers), std::move(hosts));
-                return repair_ranges(ri);
-            });
-            repair_results.push_back(std::move(f));
-        }
-        return when_all(repair_results.begin(), repair_results.end()).then([id] (std::vector<future<>> results) mutable {
-            std::vector<sstring> errors;
-            for (unsigned shard = 0; shard < results.size(); shard++) {
-                auto& f = results[shard];
-                if (f.failed()) {
-                    auto ep = f.get_exception();
-                    errors.push_back(format("shard {}: {}", shard, ep));
+            cfs = std::move(cfs), ranges = std::move(ranges), options = std::move(options),
+            all_nodes = std::move(all_nodes), all_replicas] () mutable {
+        auto session = utils::make_random_uuid();
+        auto repaired_at = uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(db_clock::now().time_since_epoch()).count());
+        auto repair_time = gc_clock::now();
+        auto prepared = options.incremental
+                ? prepare_incremental_repair(session, keyspace, cfs, all_nodes)
+                : make_ready_future<>();
+        return prepared.then([&db, id, keyspace, cfs, ranges, data_centers = options.data_centers, hosts = options.hosts,
+                incremental = options.incremental] {
+            std::vector<future<>> repair_results;
+            repair_results.reserve(smp::count);
+            for (auto shard : boost::irange(unsigned(0), smp::count)) {
+                auto f = db.invoke_on(shard, [&db, keyspace, cfs, id, ranges, data_centers, hosts, incremental] (database& localdb) mutable {
+                    auto ri = make_lw_shared<repair_info>(db,
+                            std::move(keyspace), std::move(ranges), std::move(cfs),
+                            id, std::move(data_centers), std::move(hosts));
+                    ri->incremental = incremental;
+                    return repair_ranges(ri);
+                });
+                repair_results.push_back(std::move(f));
+            }
+            return when_all(repair_results.begin(), repair_results.end()).then([id] (std::vector<future<>> results) mutable {
+                std::vector<sstring> errors;
+                for (unsigned shard = 0; shard < results.size(); shard++) {
+                    auto& f = results[shard];
+                    if (f.failed()) {
+                        auto ep = f.get_exception();
+                        errors.push_back(format("shard {}: {}", shard, ep));
+                    }
                 }
+                if (!errors.empty()) {
+                    return make_exception_future<>(std::runtime_error(format("{}", errors)));
+                }
+                return make_ready_future<>();
+            });
+        }).then_wrapped([id, session, repaired_at, incremental = options.incremental, ranges, all_nodes] (future<> f) mutable {
+            if (!incremental) {
+                return f;
             }
-            if (!errors.empty()) {
-                return make_exception_future<>(std::runtime_error(format("{}", errors)));
+            // A failed repair only drops the recorded sstables, leaving them unrepaired.
+            return finish_incremental_repair(session, std::move(all_nodes), std::move(ranges), f.failed() ? 0 : repaired_at).then_wrapped([id, f = std::move(f)] (future<> finished) mutable {
+                if (finished.failed()) {
+                    auto ep = finished.get_exception();
+                    rlogger.warn("repair id {} failed to mark the repaired sstables: {}", id, ep);
+                    if (!f.failed()) {
+                        return make_exception_future<>(std::move(ep));
+                    }
+                }
+                return std::move(f);
+            });
+        }).then([id, keyspace = std::move(keyspace), cfs = std::move(cfs), ranges = std::move(ranges), all_nodes = std::move(all_nodes),
+                all_replicas, repair_time] () mutable {
+            // Any failed or skipped range fails the repair, so all replicas of all ranges are in sync now.
+            if (!all_replicas) {
+                return make_ready_future<>();
             }
-            return make_ready_future<>();
+            return update_repair_history(std::move(keyspace), std::move(cfs), std::move(all_nodes), std::move(ranges), repair_time).handle_exception([id] (std::exception_ptr ep) {
+                // Tombstones of the ranges are then purged after gc_grace_seconds, as usual.
+                rlogger.warn("repair id {} failed to update the repair history: {}", id, ep);
+            });
         });
     }).handle_exception([id] (std::exception_ptr ep) {
         rlogger.info("repair_tracker run for repair id {} failed: {}", id, ep);
@@ -1578,6 +1643,48 @@ future<> sync_data_using_repair(seastar::sharded<database>& db,
     });
 }
 
+// The number of ranges synced between two updates of the progress of a
+// node operation.
+static constexpr size_t node_ops_ranges_per_batch = 16;
+
+// Like sync_data_using_repair(), but records the ranges synced so far in
+// system.available_ranges, so that a node operation restarted after a
+// failure (e.g. a resumed bootstrap) skips them. Must be called in a
+// seastar thread. The recorded progress is removed by
+// remove_node_ops_progress() once the whole operation succeeds.
+static void sync_data_using_repair_resumable(seastar::sharded<database>& db,
+        const sstring& op,
+        const sstring& keyspace,
+        dht::token_range_vector ranges,
+        std::unordered_map<dht::token_range, repair_neighbors> neighbors) {
+    auto available = db::system_keyspace::get_available_ranges(keyspace).get0();
+    if (!available.empty()) {
+        auto nr_ranges = ranges.size();
+        boost::remove_erase_if(ranges, [&available] (const dht::token_range& r) {
+            return available.count(r);
+        });
+        rlogger.info("{}: keyspace={}, skipped {} out of {} ranges synced before", op, keyspace, nr_ranges - ranges.size(), nr_ranges);
+    }
+    for (size_t i = 0; i < ranges.size(); i += node_ops_ranges_per_batch) {
+        dht::token_range_vector batch(ranges.begin() + i, ranges.begin() + std::min(ranges.size(), i + node_ops_ranges_per_batch));
+        std::unordered_map<dht::token_range, repair_neighbors> batch_neighbors;
+        for (auto& r : batch) {
+            auto it = neighbors.find(r);
+            if (it != neighbors.end()) {
+                batch_neighbors.emplace(r, std::move(it->second));
+            }
+        }
+        sync_data_using_repair(db, keyspace, batch, std::move(batch_neighbors)).get();
+        db::system_keyspace::update_available_ranges(keyspace, batch).get();
+    }
+}
+
+static void remove_node_ops_progress(const std::vector<sstring>& keyspaces) {
+    for (auto& keyspace : keyspaces) {
+        db::system_keyspace::remove_available_ranges(keyspace).get();
+    }
+}
+
 future<> bootstrap_with_repair(seastar::sharded<database>& db, locator::token_metadata tm, std::unordered_set<dht::token> bootstrap_tokens) {
     using inet_address = gms::inet_address;
     return seastar::async([&db, tm = std::move(tm), tokens = std::move(bootstrap_tokens)] () mutable {
@@ -1716,9 +1823,10 @@ future<> bootstrap_with_repair(seastar::sharded<database>& db, locator::token_me
                 }
             }
             auto nr_ranges = desired_ranges.size();
-            sync_data_using_repair(db, keyspace_name, std::move(desired_ranges), std::move(range_sources)).get();
+            sync_data_using_repair_resumable(db, "bootstrap_with_repair", keyspace_name, std::move(desired_ranges), std::move(range_sources));
             rlogger.info("bootstrap_with_repair: finished with keyspace={}, nr_ranges={}", keyspace_name, nr_ranges);
         }
+        remove_node_ops_progress(keyspaces);
         rlogger.info("bootstrap_with_repair: finished with keyspaces={}", keyspaces);
     });
 }
@@ -1921,9 +2029,10 @@ future<> do_rebuild_replace_with_repair(seastar::sharded<database>& db, locator:
                 }
             }
             auto nr_ranges = ranges.size();
-            sync_data_using_repair(db, keyspace_name, std::move(ranges), std::move(range_sources)).get();
+            sync_data_using_repair_resumable(db, op, keyspace_name, std::move(ranges), std::move(range_sources));
             rlogger.info("{}: finished with keyspace={}, source_dc={}, nr_ranges={}", op, keyspace_name, source_dc, nr_ranges);
         }
+        remove_node_ops_progress(keyspaces);
         rlogger.info("{}: finished with keyspaces={}, source_dc={}", op, keyspaces, source_dc);
     });
 }
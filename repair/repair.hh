@@ -32,6 +32,7 @@
 #include "flat_mutation_reader.hh"
 #include "utils/UUID.hh"
 #include "streaming/stream_plan.hh"
+#include "serializer.hh"
 
 class repair_exception : public std::exception {
 private:
@@ -134,6 +135,9 @@ class repair_stats {
 
     uint64_t rpc_call_nr = 0;
 
+    uint64_t sketch_decoded_nr = 0;
+    uint64_t sketch_failed_nr = 0;
+
     uint64_t tx_hashes_nr = 0;
     uint64_t rx_hashes_nr = 0;
 
@@ -204,6 +208,8 @@ class repair_info {
     repair_stats _stats;
     bool _row_level_repair;
     uint64_t _sub_ranges_nr = 0;
+    // Whether this is an incremental repair, which reads only unrepaired sstables.
+    bool incremental = false;
 public:
     repair_info(seastar::sharded<database>& db_,
             const sstring& keyspace_,
@@ -347,6 +353,15 @@ struct get_sync_boundary_response {
 // Return value of the REPAIR_GET_COMBINED_ROW_HASH RPC verb
 using get_combined_row_hash_response = repair_hash;
 
+// Return value of the REPAIR_GET_ROW_HASH_SKETCH RPC verb: the cells of
+// a utils::iblt of the row hashes in the working row buf.
+struct repair_hash_sketch {
+    uint64_t seed;
+    std::vector<int32_t> counts;
+    std::vector<uint64_t> key_sums;
+    std::vector<uint64_t> hash_sums;
+};
+
 struct node_repair_meta_id {
     gms::inet_address ip;
     uint32_t repair_meta_id;
@@ -377,6 +392,15 @@ class partition_key_and_mutation_fragments {
 using repair_row_on_wire = partition_key_and_mutation_fragments;
 using repair_rows_on_wire = std::list<partition_key_and_mutation_fragments>;
 
+namespace ser {
+struct partition_key_and_frozen_fragments_view;
+struct frozen_repair_row_on_wire_with_cmd_view;
+}
+
+// Repair rows as received from a peer. They stay serialized and are read
+// through views, rather than allocating every partition key and fragment.
+using frozen_repair_rows_on_wire = ser::frozen_view<ser::vector_deserializer<ser::partition_key_and_frozen_fragments_view>>;
+
 enum class repair_stream_cmd : uint8_t {
     error,
     hash_data,
@@ -398,9 +422,14 @@ struct repair_row_on_wire_with_cmd {
     repair_row_on_wire row;
 };
 
+using frozen_repair_row_on_wire_with_cmd = ser::frozen_view<ser::frozen_repair_row_on_wire_with_cmd_view>;
+
 enum class row_level_diff_detect_algorithm : uint8_t {
     send_full_set,
     send_full_set_rpc_stream,
+    // Like send_full_set_rpc_stream, but first tries to reconcile the row
+    // hashes with an invertible Bloom lookup table (see utils/iblt.hh).
+    send_iblt_rpc_stream,
 };
 
 std::ostream& operator<<(std::ostream& out, row_level_diff_detect_algorithm algo);
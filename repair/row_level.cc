@@ -29,8 +29,10 @@
 #include "dht/sharder.hh"
 #include "to_string.hh"
 #include "xx_hasher.hh"
+#include "repair/fragment_hasher.hh"
 #include "utils/UUID.hh"
 #include "utils/hash.hh"
+#include "utils/iblt.hh"
 #include "service/priority_manager.hh"
 #include "db/view/view_update_checks.hh"
 #include "database.hh"
@@ -47,6 +49,18 @@
 #include "gms/gossiper.hh"
 #include "repair/row_level.hh"
 #include "mutation_source_metadata.hh"
+#include "idl/keys.dist.hh"
+#include "idl/token.dist.hh"
+#include "idl/ring_position.dist.hh"
+#include "idl/frozen_mutation.dist.hh"
+#include "idl/partition_checksum.dist.hh"
+#include "serializer_impl.hh"
+#include "serialization_visitors.hh"
+#include "idl/keys.dist.impl.hh"
+#include "idl/token.dist.impl.hh"
+#include "idl/ring_position.dist.impl.hh"
+#include "idl/frozen_mutation.dist.impl.hh"
+#include "idl/partition_checksum.dist.impl.hh"
 
 extern logging::logger rlogger;
 
@@ -126,9 +140,35 @@ class sink_source_for_repair {
 };
 
 using sink_source_for_get_full_row_hashes = sink_source_for_repair<repair_stream_cmd, repair_hash_with_cmd>;
-using sink_source_for_get_row_diff = sink_source_for_repair<repair_hash_with_cmd, repair_row_on_wire_with_cmd>;
+using sink_source_for_get_row_diff = sink_source_for_repair<repair_hash_with_cmd, frozen_repair_row_on_wire_with_cmd>;
 using sink_source_for_put_row_diff = sink_source_for_repair<repair_row_on_wire_with_cmd, repair_stream_cmd>;
 
+// Collects the rows of REPAIR_GET_ROW_DIFF_WITH_RPC_STREAM or
+// REPAIR_PUT_ROW_DIFF_WITH_RPC_STREAM, which arrive one per message, into
+// the serialized form of the repair_rows_on_wire they were taken from.
+class frozen_repair_rows_builder {
+    bytes_ostream _rows;
+    bytes_ostream::place_holder<uint32_t> _count_ph;
+    uint32_t _count = 0;
+public:
+    frozen_repair_rows_builder() : _count_ph(_rows.write_place_holder<uint32_t>()) { }
+    // The place holder points into the first chunk of _rows, which moves
+    // along with it.
+    frozen_repair_rows_builder(frozen_repair_rows_builder&&) = default;
+    frozen_repair_rows_builder& operator=(frozen_repair_rows_builder&&) = default;
+
+    void add(ser::partition_key_and_frozen_fragments_view row) {
+        ser::serialize(_rows, row);
+        ++_count;
+    }
+
+    frozen_repair_rows_on_wire build() && {
+        auto out = _count_ph.get_stream();
+        ser::serialize(out, _count);
+        return frozen_repair_rows_on_wire(std::move(_rows));
+    }
+};
+
 struct row_level_repair_metrics {
     seastar::metrics::metric_groups _metrics;
     uint64_t tx_row_nr{0};
@@ -168,6 +208,7 @@ static const std::vector<row_level_diff_detect_algorithm>& suportted_diff_detect
     static std::vector<row_level_diff_detect_algorithm> _algorithms = {
         row_level_diff_detect_algorithm::send_full_set,
         row_level_diff_detect_algorithm::send_full_set_rpc_stream,
+        row_level_diff_detect_algorithm::send_iblt_rpc_stream,
     };
     return _algorithms;
 };
@@ -211,90 +252,48 @@ static uint64_t get_random_seed() {
     return random_dist(random_engine);
 }
 
+// Bounds the memory a REPAIR_GET_ROW_HASH_SKETCH request can make a
+// follower allocate.
+static constexpr uint32_t max_row_hash_sketch_cells = 1 << 20;
+
+static repair_hash_sketch to_repair_hash_sketch(const utils::iblt& sketch) {
+    repair_hash_sketch s{sketch.seed(), {}, {}, {}};
+    s.counts.reserve(sketch.cells().size());
+    s.key_sums.reserve(sketch.cells().size());
+    s.hash_sums.reserve(sketch.cells().size());
+    for (auto& c : sketch.cells()) {
+        s.counts.push_back(c.count);
+        s.key_sums.push_back(c.key_sum);
+        s.hash_sums.push_back(c.hash_sum);
+    }
+    return s;
+}
+
+static utils::iblt from_repair_hash_sketch(const repair_hash_sketch& s) {
+    if (s.key_sums.size() != s.counts.size() || s.hash_sums.size() != s.counts.size()) {
+        throw std::runtime_error(format("Got inconsistent row hash sketch: counts={}, key_sums={}, hash_sums={}",
+                s.counts.size(), s.key_sums.size(), s.hash_sums.size()));
+    }
+    std::vector<utils::iblt::cell> cells;
+    cells.reserve(s.counts.size());
+    for (size_t i = 0; i < s.counts.size(); ++i) {
+        cells.push_back(utils::iblt::cell{s.counts[i], s.key_sums[i], s.hash_sums[i]});
+    }
+    return utils::iblt(s.seed, std::move(cells));
+}
+
 class decorated_key_with_hash {
 public:
     dht::decorated_key dk;
     repair_hash hash;
     decorated_key_with_hash(const schema& s, dht::decorated_key key, uint64_t seed)
         : dk(key) {
-        xx_hasher h(seed);
+        buffered_xx_hasher h(seed);
         feed_hash(h, dk.key(), s);
         hash = repair_hash(h.finalize_uint64());
     }
 };
 
-class fragment_hasher {
-    const schema& _schema;
-    xx_hasher& _hasher;
-private:
-    void consume_cell(const column_definition& col, const atomic_cell_or_collection& cell) {
-        feed_hash(_hasher, col.kind);
-        feed_hash(_hasher, col.id);
-        feed_hash(_hasher, cell, col);
-    }
-public:
-    explicit fragment_hasher(const schema&s, xx_hasher& h)
-        : _schema(s), _hasher(h) { }
-
-    void hash(const mutation_fragment& mf) {
-        mf.visit(seastar::make_visitor(
-            [&] (const clustering_row& cr) {
-                consume(cr);
-            },
-            [&] (const static_row& sr) {
-                consume(sr);
-            },
-            [&] (const range_tombstone& rt) {
-                consume(rt);
-            },
-            [&] (const partition_start& ps) {
-                consume(ps);
-            },
-            [&] (const partition_end& pe) {
-                throw std::runtime_error("partition_end is not expected");
-            }
-        ));
-    }
-
-private:
-
-    void consume(const tombstone& t) {
-        feed_hash(_hasher, t);
-    }
-
-    void consume(const static_row& sr) {
-        sr.cells().for_each_cell([&] (column_id id, const atomic_cell_or_collection& cell) {
-            auto&& col = _schema.static_column_at(id);
-            consume_cell(col, cell);
-        });
-    }
-
-    void consume(const clustering_row& cr) {
-        feed_hash(_hasher, cr.key(), _schema);
-        feed_hash(_hasher, cr.tomb());
-        feed_hash(_hasher, cr.marker());
-        cr.cells().for_each_cell([&] (column_id id, const atomic_cell_or_collection& cell) {
-            auto&& col = _schema.regular_column_at(id);
-            consume_cell(col, cell);
-        });
-    }
-
-    void consume(const range_tombstone& rt) {
-        feed_hash(_hasher, rt.start, _schema);
-        feed_hash(_hasher, rt.start_kind);
-        feed_hash(_hasher, rt.tomb);
-        feed_hash(_hasher, rt.end, _schema);
-        feed_hash(_hasher, rt.end_kind);
-    }
-
-    void consume(const partition_start& ps) {
-        feed_hash(_hasher, ps.key().key(), _schema);
-        if (ps.partition_tombstone()) {
-            consume(ps.partition_tombstone());
-        }
-    }
-};
-
 class repair_row {
     std::optional<frozen_mutation_fragment> _fm;
     lw_shared_ptr<const decorated_key_with_hash> _dk_with_hash;
@@ -384,30 +383,36 @@ using is_local_reader = bool_class<class is_local_reader_tag>;
             const dht::sharder& remote_sharder,
             unsigned remote_shard,
             uint64_t seed,
-            is_local_reader local_reader)
+            is_local_reader local_reader,
+            bool unrepaired_only)
             : _schema(s)
             , _range(dht::to_partition_range(range))
             , _sharder(remote_sharder, range, remote_shard)
             , _seed(seed)
             , _local_read_op(local_reader ? std::optional(cf.read_in_progress()) : std::nullopt)
-            , _reader(make_reader(db, cf, local_reader)) {
+            , _reader(make_reader(db, cf, local_reader, unrepaired_only)) {
     }
 
 private:
     flat_mutation_reader
     make_reader(seastar::sharded<database>& db,
             column_family& cf,
-            is_local_reader local_reader) {
+            is_local_reader local_reader,
+            bool unrepaired_only) {
+        auto activity = cf.make_activity(utils::activity_type::repair);
         if (local_reader) {
-            return cf.make_streaming_reader(_schema, _range);
+            if (unrepaired_only) {
+                return make_activity_tagging_reader(cf.make_unrepaired_streaming_reader(_schema, _range, _schema->full_slice()), activity);
+            }
+            return make_activity_tagging_reader(cf.make_streaming_reader(_schema, _range), activity);
         }
-        return make_multishard_streaming_reader(db, _schema, [this] {
+        return make_activity_tagging_reader(make_multishard_streaming_reader(db, _schema, [this] {
             auto shard_range = _sharder.next();
             if (shard_range) {
                 return std::optional<dht::partition_range>(dht::to_partition_range(*shard_range));
             }
             return std::optional<dht::partition_range>();
-        });
+        }, unrepaired_only), activity);
     }
 
 public:
@@ -639,6 +644,12 @@ class repair_meta {
     bool use_rpc_stream() const {
         return is_rpc_stream_supported(_algo);
     }
+    bool use_row_hash_sketch() const {
+        return _algo == row_level_diff_detect_algorithm::send_iblt_rpc_stream;
+    }
+    size_t working_row_buf_nr() const {
+        return _working_row_buf.size();
+    }
 
 public:
     repair_meta(
@@ -652,7 +663,8 @@ class repair_meta {
             repair_master master,
             uint32_t repair_meta_id,
             shard_config master_node_shard_config,
-            size_t nr_peer_nodes = 1)
+            size_t nr_peer_nodes = 1,
+            bool incremental = false)
             : _db(db)
             , _cf(cf)
             , _schema(s)
@@ -676,7 +688,8 @@ class repair_meta {
                     _remote_sharder,
                     _master_node_shard_config.shard,
                     _seed,
-                    repair_reader::is_local_reader(_repair_master || _same_sharding_config)
+                    repair_reader::is_local_reader(_repair_master || _same_sharding_config),
+                    incremental
               )
             , _repair_writer(_schema, _estimated_partitions, _nr_peer_nodes)
             , _sink_source_for_get_full_row_hashes(_repair_meta_id, _nr_peer_nodes,
@@ -728,7 +741,8 @@ class repair_meta {
             uint64_t max_row_buf_size,
             uint64_t seed,
             shard_config master_node_shard_config,
-            table_schema_version schema_version) {
+            table_schema_version schema_version,
+            bool incremental) {
         return service::get_schema_for_write(schema_version, {from, src_cpu_id}).then([from,
                 repair_meta_id,
                 range,
@@ -736,7 +750,8 @@ class repair_meta {
                 max_row_buf_size,
                 seed,
                 master_node_shard_config,
-                schema_version] (schema_ptr s) {
+                schema_version,
+                incremental] (schema_ptr s) {
             auto& db = service::get_local_storage_proxy().get_db();
             auto& cf = db.local().find_column_family(s->id());
             node_repair_meta_id id{from, repair_meta_id};
@@ -749,7 +764,9 @@ class repair_meta {
                     seed,
                     repair_meta::repair_master::no,
                     repair_meta_id,
-                    std::move(master_node_shard_config));
+                    std::move(master_node_shard_config),
+                    1,
+                    incremental);
             bool insertion = repair_meta_map().emplace(id, rm).second;
             if (!insertion) {
                 rlogger.warn("insert_repair_meta: repair_meta_id {} for node {} already exists, replace existing one", id.repair_meta_id, id.ip);
@@ -971,8 +988,8 @@ class repair_meta {
     }
 
     repair_hash do_hash_for_mf(const decorated_key_with_hash& dk_with_hash, const mutation_fragment& mf) {
-        xx_hasher h(_seed);
-        fragment_hasher fh(*_schema, h);
+        buffered_xx_hasher h(_seed);
+        fragment_hasher<buffered_xx_hasher> fh(*_schema, h);
         fh.hash(mf);
         feed_hash(h, dk_with_hash.hash.hash);
         return repair_hash(h.finalize_uint64());
@@ -1017,6 +1034,7 @@ class repair_meta {
                 }
                 _gate.check();
                 return _repair_reader.read_mutation_fragment().then([this, &cur_size, &new_rows_size, &cur_rows] (mutation_fragment_opt mfopt) mutable {
+                    utils::activity_scope activity(_cf.make_activity(utils::activity_type::repair));
                     return handle_mutation_fragment(std::move(mfopt), cur_size, new_rows_size, cur_rows);
                 });
             }).then([&cur_rows, &new_rows_size] () mutable {
@@ -1164,9 +1182,9 @@ class repair_meta {
 
     // Give a list of rows, apply the rows to disk and update the _working_row_buf and _peer_row_hash_sets if requested
     // Must run inside a seastar thread
-    void apply_rows_on_master_in_thread(repair_rows_on_wire rows, gms::inet_address from, update_working_row_buf update_buf,
+    void apply_rows_on_master_in_thread(frozen_repair_rows_on_wire rows, gms::inet_address from, update_working_row_buf update_buf,
             update_peer_row_hash_sets update_hash_set, unsigned node_idx = 0) {
-        if (rows.empty()) {
+        if (rows.view().empty()) {
             return;
         }
         auto row_diff = to_repair_rows_list(rows).get0();
@@ -1202,11 +1220,12 @@ class repair_meta {
     }
 
     future<>
-    apply_rows_on_follower(repair_rows_on_wire rows) {
-        if (rows.empty()) {
+    apply_rows_on_follower(frozen_repair_rows_on_wire rows) {
+        if (rows.view().empty()) {
             return make_ready_future<>();
         }
-        return to_repair_rows_list(rows).then([this] (std::list<repair_row> row_diff) {
+        return do_with(std::move(rows), [this] (frozen_repair_rows_on_wire& rows) {
+          return to_repair_rows_list(rows).then([this] (std::list<repair_row> row_diff) {
             return do_with(std::move(row_diff), [this] (std::list<repair_row>& row_diff) {
                 unsigned node_idx = 0;
                 _repair_writer.create_writer(_db, node_idx);
@@ -1219,6 +1238,7 @@ class repair_meta {
                     return _repair_writer.do_write(node_idx, std::move(dk_with_hash), std::move(mf));
                 });
             });
+          });
         });
     }
 
@@ -1247,33 +1267,52 @@ class repair_meta {
         });
     };
 
-    future<std::list<repair_row>> to_repair_rows_list(repair_rows_on_wire rows) {
-        return do_with(std::move(rows), std::list<repair_row>(), lw_shared_ptr<const decorated_key_with_hash>(), lw_shared_ptr<mutation_fragment>(), position_in_partition::tri_compare(*_schema),
-          [this] (repair_rows_on_wire& rows, std::list<repair_row>& row_list, lw_shared_ptr<const decorated_key_with_hash>& dk_ptr, lw_shared_ptr<mutation_fragment>& last_mf, position_in_partition::tri_compare& cmp) mutable {
-            return do_for_each(rows, [this, &dk_ptr, &row_list, &last_mf, &cmp] (partition_key_and_mutation_fragments& x) mutable {
-                dht::decorated_key dk = dht::decorate_key(*_schema, x.get_key());
+    // The rows must stay alive until the returned future resolves. They are
+    // read in place, and only the fragments the master keeps are copied.
+    future<std::list<repair_row>> to_repair_rows_list(const frozen_repair_rows_on_wire& frozen_rows) {
+        auto rows = frozen_rows.view();
+        std::vector<partition_key> keys;
+        keys.reserve(rows.size());
+        for (auto&& x : rows) {
+            keys.push_back(x.key());
+        }
+        // Compute the tokens of all partitions in one go.
+        auto tokens = dht::get_tokens(*_schema, boost::copy_range<std::vector<partition_key_view>>(keys
+                | boost::adaptors::transformed([] (const partition_key& key) -> partition_key_view { return key; })));
+        return do_with(std::move(rows), std::move(keys), std::list<repair_row>(), lw_shared_ptr<const decorated_key_with_hash>(), lw_shared_ptr<mutation_fragment>(), position_in_partition::tri_compare(*_schema),
+                std::move(tokens), size_t(0),
+          [this] (ser::vector_deserializer<ser::partition_key_and_frozen_fragments_view>& rows, std::vector<partition_key>& keys, std::list<repair_row>& row_list,
+                lw_shared_ptr<const decorated_key_with_hash>& dk_ptr, lw_shared_ptr<mutation_fragment>& last_mf, position_in_partition::tri_compare& cmp,
+                std::vector<dht::token>& tokens, size_t& row_idx) mutable {
+            return do_for_each(rows, [this, &keys, &dk_ptr, &row_list, &last_mf, &cmp, &tokens, &row_idx] (ser::partition_key_and_frozen_fragments_view x) mutable {
+                dht::decorated_key dk{std::move(tokens[row_idx]), std::move(keys[row_idx])};
+                ++row_idx;
                 if (!(dk_ptr && dk_ptr->dk.equal(*_schema, dk))) {
                     dk_ptr = make_lw_shared<const decorated_key_with_hash>(*_schema, dk, _seed);
                 }
+                auto fragments = x.mutation_fragments();
                 if (_repair_master) {
-                    return do_for_each(x.get_mutation_fragments(), [this, &dk_ptr, &row_list] (frozen_mutation_fragment& fmf) mutable {
+                    return do_for_each(fragments.begin(), fragments.end(), [this, &dk_ptr, &row_list] (auto fmf) mutable {
                         _metrics.rx_row_nr += 1;
-                        _metrics.rx_row_bytes += fmf.representation().size();
+                        _metrics.rx_row_bytes += fmf.stream().size();
                         // Keep the mutation_fragment in repair_row as an
                         // optimization to avoid unfreeze again when
                         // mutation_fragment is needed by _repair_writer.do_write()
                         // to apply the repair_row to disk
-                        auto mf = make_lw_shared<mutation_fragment>(fmf.unfreeze(*_schema));
+                        auto mf = make_lw_shared<mutation_fragment>(unfreeze_mutation_fragment(*_schema, fmf.stream()));
                         auto hash = do_hash_for_mf(*dk_ptr, *mf);
                         position_in_partition pos(mf->position());
-                        row_list.push_back(repair_row(std::move(fmf), std::move(pos), dk_ptr, std::move(hash), std::move(mf)));
+                        // The master sends the row on to other followers, so
+                        // it needs a copy of its own.
+                        frozen_mutation_fragment frozen(bytes_ostream(std::move(fmf)));
+                        row_list.push_back(repair_row(std::move(frozen), std::move(pos), dk_ptr, std::move(hash), std::move(mf)));
                     });
                 } else {
                     last_mf = {};
-                    return do_for_each(x.get_mutation_fragments(), [this, &dk_ptr, &row_list, &last_mf, &cmp] (frozen_mutation_fragment& fmf) mutable {
+                    return do_for_each(fragments.begin(), fragments.end(), [this, &dk_ptr, &row_list, &last_mf, &cmp] (auto fmf) mutable {
                         _metrics.rx_row_nr += 1;
-                        _metrics.rx_row_bytes += fmf.representation().size();
-                        auto mf = make_lw_shared<mutation_fragment>(fmf.unfreeze(*_schema));
+                        _metrics.rx_row_bytes += fmf.stream().size();
+                        auto mf = make_lw_shared<mutation_fragment>(unfreeze_mutation_fragment(*_schema, fmf.stream()));
                         // If the mutation_fragment has the same position as
                         // the last mutation_fragment, it means they are the
                         // same row with different contents. We can not feed
@@ -1379,6 +1418,87 @@ class repair_meta {
         });
     }
 
+private:
+    // Build an IBLT of the row hashes in _working_row_buf
+    future<utils::iblt>
+    make_row_hash_sketch(size_t cells, uint64_t seed) {
+        return working_row_hashes().then([cells, seed] (std::unordered_set<repair_hash> hashes) {
+            return do_with(std::move(hashes), utils::iblt(cells, seed), [] (std::unordered_set<repair_hash>& hashes, utils::iblt& sketch) {
+                return do_for_each(hashes, [&sketch] (const repair_hash& h) {
+                    sketch.insert(h.hash);
+                }).then([&sketch] {
+                    return std::move(sketch);
+                });
+            });
+        });
+    }
+
+public:
+    // RPC API
+    // Return an IBLT of the hashes of the rows in _working_row_buf
+    future<repair_hash_sketch>
+    get_row_hash_sketch(gms::inet_address remote_node, uint32_t cells, uint64_t seed) {
+        if (remote_node == _myip) {
+            return get_row_hash_sketch_handler(cells, seed);
+        }
+        return netw::get_local_messaging_service().send_repair_get_row_hash_sketch(msg_addr(remote_node),
+                _repair_meta_id, cells, seed).then([this, remote_node] (repair_hash_sketch sketch) {
+            rlogger.debug("Got row hash sketch from peer={}, cells={}", remote_node, sketch.counts.size());
+            stats().rpc_call_nr++;
+            return sketch;
+        });
+    }
+
+    // RPC handler
+    future<repair_hash_sketch>
+    get_row_hash_sketch_handler(uint32_t cells, uint64_t seed) {
+        return with_gate(_gate, [this, cells, seed] {
+            return make_row_hash_sketch(std::min(cells, max_row_hash_sketch_cells), seed).then([] (utils::iblt sketch) {
+                return to_repair_hash_sketch(sketch);
+            });
+        });
+    }
+
+    // Find the hashes of the rows in the _working_row_buf of remote_node by
+    // subtracting an IBLT of the local row hashes from one of the remote
+    // row hashes. The sketch is sized for expected_diff differing rows.
+    // Returns std::nullopt if the difference could not be decoded, in which
+    // case the caller falls back to fetching the full row hashes.
+    future<std::optional<std::unordered_set<repair_hash>>>
+    get_row_hashes_with_sketch(gms::inet_address remote_node, size_t expected_diff) {
+        auto cells = std::min(utils::iblt::cells_for(expected_diff), size_t(max_row_hash_sketch_cells));
+        auto seed = get_random_seed();
+        return get_row_hash_sketch(remote_node, cells, seed).then([this, remote_node] (repair_hash_sketch s) {
+            auto remote = from_repair_hash_sketch(s);
+            return make_row_hash_sketch(remote.cells().size(), remote.seed()).then([this, remote_node, remote = std::move(remote)] (utils::iblt local) mutable {
+                remote.subtract(local);
+                auto diff = remote.decode();
+                if (!diff) {
+                    rlogger.debug("Failed to decode row hash sketch of peer={}, cells={}", remote_node, remote.cells().size());
+                    return make_ready_future<std::optional<std::unordered_set<repair_hash>>>(std::nullopt);
+                }
+                return working_row_hashes().then([remote_node, diff = std::move(*diff)] (std::unordered_set<repair_hash> hashes) {
+                    // A decoded difference is wrong only if the check hashes
+                    // of several keys collided, but verify what we can.
+                    for (auto h : diff.removed) {
+                        if (!hashes.erase(repair_hash(h))) {
+                            rlogger.debug("Row hash sketch of peer={} removes unknown hash={}", remote_node, h);
+                            return std::optional<std::unordered_set<repair_hash>>();
+                        }
+                    }
+                    for (auto h : diff.added) {
+                        if (!hashes.emplace(h).second) {
+                            rlogger.debug("Row hash sketch of peer={} adds known hash={}", remote_node, h);
+                            return std::optional<std::unordered_set<repair_hash>>();
+                        }
+                    }
+                    rlogger.debug("Decoded row hash sketch of peer={}, added={}, removed={}", remote_node, diff.added.size(), diff.removed.size());
+                    return std::optional<std::unordered_set<repair_hash>>(std::move(hashes));
+                });
+            });
+        });
+    }
+
     // RPC API
     // Return the combined hashes of the current working row buf
     future<get_combined_row_hash_response>
@@ -1408,7 +1528,8 @@ class repair_meta {
 
     // RPC API
     future<>
-    repair_row_level_start(gms::inet_address remote_node, sstring ks_name, sstring cf_name, dht::token_range range, table_schema_version schema_version) {
+    repair_row_level_start(gms::inet_address remote_node, sstring ks_name, sstring cf_name, dht::token_range range, table_schema_version schema_version,
+            bool incremental) {
         if (remote_node == _myip) {
             return make_ready_future<>();
         }
@@ -1422,21 +1543,21 @@ class repair_meta {
         return netw::get_local_messaging_service().send_repair_row_level_start(msg_addr(remote_node),
                 _repair_meta_id, std::move(ks_name), std::move(cf_name), std::move(range), _algo, _max_row_buf_size, _seed,
                 _master_node_shard_config.shard, _master_node_shard_config.shard_count, _master_node_shard_config.ignore_msb,
-                remote_partitioner_name, std::move(schema_version));
+                remote_partitioner_name, std::move(schema_version), incremental);
     }
 
     // RPC handler
     static future<>
     repair_row_level_start_handler(gms::inet_address from, uint32_t src_cpu_id, uint32_t repair_meta_id, sstring ks_name, sstring cf_name,
             dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size,
-            uint64_t seed, shard_config master_node_shard_config, table_schema_version schema_version) {
+            uint64_t seed, shard_config master_node_shard_config, table_schema_version schema_version, bool incremental) {
         if (!_sys_dist_ks->local_is_initialized() || !_view_update_generator->local_is_initialized()) {
             return make_exception_future<>(std::runtime_error(format("Node {} is not fully initialized for repair, try again later",
                     utils::fb_utilities::get_broadcast_address())));
         }
         rlogger.debug(">>> Started Row Level Repair (Follower): local={}, peers={}, repair_meta_id={}, keyspace={}, cf={}, schema_version={}, range={}, seed={}, max_row_buf_siz={}",
             utils::fb_utilities::get_broadcast_address(), from, repair_meta_id, ks_name, cf_name, schema_version, range, seed, max_row_buf_size);
-        return insert_repair_meta(from, src_cpu_id, repair_meta_id, std::move(range), algo, max_row_buf_size, seed, std::move(master_node_shard_config), std::move(schema_version));
+        return insert_repair_meta(from, src_cpu_id, repair_meta_id, std::move(range), algo, max_row_buf_size, seed, std::move(master_node_shard_config), std::move(schema_version), incremental);
     }
 
     // RPC API
@@ -1524,9 +1645,9 @@ class repair_meta {
                 _metrics.tx_hashes_nr += set_diff.size();
             }
             stats().rpc_call_nr++;
-            repair_rows_on_wire rows = netw::get_local_messaging_service().send_repair_get_row_diff(msg_addr(remote_node),
+            frozen_repair_rows_on_wire rows = netw::get_local_messaging_service().send_repair_get_row_diff(msg_addr(remote_node),
                     _repair_meta_id, std::move(set_diff), bool(needs_all_rows)).get0();
-            if (!rows.empty()) {
+            if (!rows.view().empty()) {
                 apply_rows_on_master_in_thread(std::move(rows), remote_node, update_working_row_buf::yes, update_peer_row_hash_sets::no, node_idx);
             }
         }
@@ -1538,9 +1659,9 @@ class repair_meta {
             return;
         }
         stats().rpc_call_nr++;
-        repair_rows_on_wire rows = netw::get_local_messaging_service().send_repair_get_row_diff(msg_addr(remote_node),
+        frozen_repair_rows_on_wire rows = netw::get_local_messaging_service().send_repair_get_row_diff(msg_addr(remote_node),
                 _repair_meta_id, {}, bool(needs_all_rows_t::yes)).get0();
-        if (!rows.empty()) {
+        if (!rows.view().empty()) {
             apply_rows_on_master_in_thread(std::move(rows), remote_node, update_working_row_buf::yes, update_peer_row_hash_sets::yes, node_idx);
         }
     }
@@ -1552,23 +1673,24 @@ class repair_meta {
             gms::inet_address remote_node,
             unsigned node_idx,
             rpc::sink<repair_hash_with_cmd>& sink,
-            rpc::source<repair_row_on_wire_with_cmd>& source) {
-        repair_rows_on_wire current_rows;
+            rpc::source<frozen_repair_row_on_wire_with_cmd>& source) {
+        frozen_repair_rows_builder current_rows;
         for (;;) {
-            std::optional<std::tuple<repair_row_on_wire_with_cmd>> row_opt = source().get0();
+            std::optional<std::tuple<frozen_repair_row_on_wire_with_cmd>> row_opt = source().get0();
             if (row_opt) {
                 if (inject_rpc_stream_error) {
                     throw std::runtime_error("get_row_diff: Inject sender error in source loop");
                 }
-                auto row = std::move(std::get<0>(row_opt.value()));
-                if (row.cmd == repair_stream_cmd::row_data) {
+                auto row = std::get<0>(row_opt.value()).view();
+                auto cmd = row.cmd();
+                if (cmd == repair_stream_cmd::row_data) {
                     rlogger.trace("get_row_diff: Got repair_row_on_wire with data");
-                    current_rows.push_back(std::move(row.row));
-                } else if (row.cmd == repair_stream_cmd::end_of_current_rows) {
+                    current_rows.add(row.row());
+                } else if (cmd == repair_stream_cmd::end_of_current_rows) {
                     rlogger.trace("get_row_diff: Got repair_row_on_wire with nullopt");
-                    apply_rows_on_master_in_thread(std::move(current_rows), remote_node, update_working_row_buf::yes, update_hash_set, node_idx);
+                    apply_rows_on_master_in_thread(std::move(current_rows).build(), remote_node, update_working_row_buf::yes, update_hash_set, node_idx);
                     break;
-                } else if (row.cmd == repair_stream_cmd::error) {
+                } else if (cmd == repair_stream_cmd::error) {
                     throw std::runtime_error("get_row_diff: Peer failed to process");
                 } else {
                     throw std::runtime_error("get_row_diff: Got unexpected repair_stream_cmd");
@@ -1630,7 +1752,7 @@ class repair_meta {
             stats().rpc_call_nr++;
             auto f = _sink_source_for_get_row_diff.get_sink_source(remote_node, node_idx).get();
             rpc::sink<repair_hash_with_cmd>& sink = std::get<0>(f);
-            rpc::source<repair_row_on_wire_with_cmd>& source = std::get<1>(f);
+            rpc::source<frozen_repair_row_on_wire_with_cmd>& source = std::get<1>(f);
             auto sink_op = get_row_diff_sink_op(std::move(set_diff), needs_all_rows, sink, remote_node);
             get_row_diff_source_op(update_hash_set, remote_node, node_idx, sink, source);
             sink_op.get();
@@ -1758,7 +1880,7 @@ class repair_meta {
     }
 
     // RPC handler
-    future<> put_row_diff_handler(repair_rows_on_wire rows, gms::inet_address from) {
+    future<> put_row_diff_handler(frozen_repair_rows_on_wire rows, gms::inet_address from) {
         return with_gate(_gate, [this, rows = std::move(rows)] () mutable {
             return apply_rows_on_follower(std::move(rows));
         });
@@ -1819,18 +1941,19 @@ static future<stop_iteration> repair_put_row_diff_with_rpc_stream_process_op(
         uint32_t src_cpu_id,
         uint32_t repair_meta_id,
         rpc::sink<repair_stream_cmd> sink,
-        rpc::source<repair_row_on_wire_with_cmd> source,
+        rpc::source<frozen_repair_row_on_wire_with_cmd> source,
         bool& error,
-        repair_rows_on_wire& current_rows,
-        std::optional<std::tuple<repair_row_on_wire_with_cmd>> row_opt) {
-    auto row = std::move(std::get<0>(row_opt.value()));
-    if (row.cmd == repair_stream_cmd::row_data) {
+        frozen_repair_rows_builder& current_rows,
+        std::optional<std::tuple<frozen_repair_row_on_wire_with_cmd>> row_opt) {
+    auto row = std::get<0>(row_opt.value()).view();
+    auto cmd = row.cmd();
+    if (cmd == repair_stream_cmd::row_data) {
         rlogger.trace("Got repair_rows_on_wire from peer={}, got row_data", from);
-        current_rows.push_back(std::move(row.row));
+        current_rows.add(row.row());
         return make_ready_future<stop_iteration>(stop_iteration::no);
-    } else if (row.cmd == repair_stream_cmd::end_of_current_rows) {
+    } else if (cmd == repair_stream_cmd::end_of_current_rows) {
         rlogger.trace("Got repair_rows_on_wire from peer={}, got end_of_current_rows", from);
-        auto fp = make_foreign(std::make_unique<repair_rows_on_wire>(std::move(current_rows)));
+        auto fp = make_foreign(std::make_unique<frozen_repair_rows_on_wire>(std::exchange(current_rows, {}).build()));
         return smp::submit_to(src_cpu_id % smp::count, [from, repair_meta_id, fp = std::move(fp)] () mutable {
             auto rm = repair_meta::get_repair_meta(from, repair_meta_id);
             if (fp.get_owner_shard() == this_shard_id()) {
@@ -1931,10 +2054,10 @@ static future<> repair_put_row_diff_with_rpc_stream_handler(
         uint32_t src_cpu_id,
         uint32_t repair_meta_id,
         rpc::sink<repair_stream_cmd> sink,
-        rpc::source<repair_row_on_wire_with_cmd> source) {
-    return do_with(false, repair_rows_on_wire(), [from, src_cpu_id, repair_meta_id, sink, source] (bool& error, repair_rows_on_wire& current_rows) mutable {
+        rpc::source<frozen_repair_row_on_wire_with_cmd> source) {
+    return do_with(false, frozen_repair_rows_builder(), [from, src_cpu_id, repair_meta_id, sink, source] (bool& error, frozen_repair_rows_builder& current_rows) mutable {
         return repeat([from, src_cpu_id, repair_meta_id, sink, source, &current_rows, &error] () mutable {
-            return source().then([from, src_cpu_id, repair_meta_id, sink, source, &current_rows, &error] (std::optional<std::tuple<repair_row_on_wire_with_cmd>> row_opt) mutable {
+            return source().then([from, src_cpu_id, repair_meta_id, sink, source, &current_rows, &error] (std::optional<std::tuple<frozen_repair_row_on_wire_with_cmd>> row_opt) mutable {
                 if (row_opt) {
                     if (error) {
                         return make_ready_future<stop_iteration>(stop_iteration::no);
@@ -2007,6 +2130,121 @@ static future<> repair_get_full_row_hashes_with_rpc_stream_handler(
     });
 }
 
+// Unrepaired sstables of the tables taking part in each incremental repair
+// session, recorded on every shard when the session starts. Only those are
+// marked as repaired when it finishes, since sstables written later may hold
+// data the repair didn't read.
+using incremental_repair_sstables = std::unordered_map<utils::UUID, std::unordered_set<int64_t>>;
+struct incremental_repair_session {
+    incremental_repair_sstables tables;
+    // A session the master never finishes, because it died, is dropped
+    // after incremental_repair_session_timeout_in_s.
+    lowres_clock::time_point expiry;
+};
+static thread_local std::unordered_map<utils::UUID, incremental_repair_session> incremental_repair_sessions;
+
+static void drop_expired_incremental_repair_sessions() {
+    auto now = lowres_clock::now();
+    for (auto it = incremental_repair_sessions.begin(); it != incremental_repair_sessions.end();) {
+        if (it->second.expiry <= now) {
+            rlogger.warn("Dropping incremental repair session {}, which its master didn't finish", it->first);
+            it = incremental_repair_sessions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+static future<> prepare_incremental_repair_locally(utils::UUID session, sstring keyspace, std::vector<sstring> cfs) {
+    return service::get_local_storage_proxy().get_db().invoke_on_all([session, keyspace, cfs] (database& db) {
+        drop_expired_incremental_repair_sessions();
+        auto& s = incremental_repair_sessions[session];
+        s.expiry = lowres_clock::now() + std::chrono::seconds(db.get_config().incremental_repair_session_timeout_in_s());
+        auto& tables = s.tables;
+        for (auto& cf_name : cfs) {
+            auto& cf = db.find_column_family(keyspace, cf_name);
+            auto& generations = tables[cf.schema()->id()];
+            for (auto& sst : *cf.get_sstables()) {
+                if (!sst->is_repaired()) {
+                    generations.insert(sst->generation());
+                }
+            }
+        }
+    });
+}
+
+static future<> finish_incremental_repair_locally(utils::UUID session, dht::token_range_vector ranges, uint64_t repaired_at) {
+    return service::get_local_storage_proxy().get_db().invoke_on_all([session, ranges = std::move(ranges), repaired_at] (database& db) {
+        auto it = incremental_repair_sessions.find(session);
+        if (it == incremental_repair_sessions.end()) {
+            if (repaired_at) {
+                rlogger.warn("Incremental repair session {} expired before it finished, its sstables stay unrepaired", session);
+            }
+            return make_ready_future<>();
+        }
+        auto tables = std::move(it->second.tables);
+        incremental_repair_sessions.erase(it);
+        if (!repaired_at) {
+            return make_ready_future<>();
+        }
+        return do_with(std::move(tables), ranges, [&db, repaired_at] (incremental_repair_sstables& tables, dht::token_range_vector& ranges) {
+            return parallel_for_each(tables, [&db, &ranges, repaired_at] (auto& table) {
+                // The table was dropped in the meantime.
+                if (!db.column_family_exists(table.first)) {
+                    return make_ready_future<>();
+                }
+                return db.find_column_family(table.first).mark_sstables_repaired(std::move(table.second), ranges, repaired_at);
+            });
+        });
+    });
+}
+
+future<> prepare_incremental_repair(utils::UUID session, sstring keyspace, std::vector<sstring> cfs, std::vector<gms::inet_address> nodes) {
+    return do_with(std::move(nodes), [session, keyspace = std::move(keyspace), cfs = std::move(cfs)] (std::vector<gms::inet_address>& nodes) {
+        return parallel_for_each(nodes, [session, &keyspace, &cfs] (const gms::inet_address& node) {
+            if (node == utils::fb_utilities::get_broadcast_address()) {
+                return prepare_incremental_repair_locally(session, keyspace, cfs);
+            }
+            return netw::get_local_messaging_service().send_repair_prepare_incremental(netw::msg_addr(node), session, keyspace, cfs);
+        });
+    });
+}
+
+future<> finish_incremental_repair(utils::UUID session, std::vector<gms::inet_address> nodes, dht::token_range_vector ranges, uint64_t repaired_at) {
+    return do_with(std::move(nodes), std::move(ranges), [session, repaired_at] (std::vector<gms::inet_address>& nodes, dht::token_range_vector& ranges) {
+        return parallel_for_each(nodes, [session, &ranges, repaired_at] (const gms::inet_address& node) {
+            if (node == utils::fb_utilities::get_broadcast_address()) {
+                return finish_incremental_repair_locally(session, ranges, repaired_at);
+            }
+            return netw::get_local_messaging_service().send_repair_finish_incremental(netw::msg_addr(node), session, ranges, repaired_at);
+        });
+    });
+}
+
+static future<> update_repair_history_locally(sstring keyspace, std::vector<sstring> cfs, dht::token_range_vector ranges, gc_clock::time_point repair_time) {
+    return service::get_local_storage_proxy().get_db().invoke_on_all([keyspace, cfs, ranges, repair_time] (database& db) {
+        for (auto& cf_name : cfs) {
+            // The table was dropped in the meantime.
+            if (!db.has_schema(keyspace, cf_name)) {
+                continue;
+            }
+            db.find_column_family(keyspace, cf_name).record_repair(ranges, repair_time);
+        }
+    });
+}
+
+future<> update_repair_history(sstring keyspace, std::vector<sstring> cfs, std::vector<gms::inet_address> nodes, dht::token_range_vector ranges, gc_clock::time_point repair_time) {
+    return do_with(std::move(nodes), std::move(keyspace), std::move(cfs), std::move(ranges), [repair_time] (std::vector<gms::inet_address>& nodes,
+            sstring& keyspace, std::vector<sstring>& cfs, dht::token_range_vector& ranges) {
+        return parallel_for_each(nodes, [&keyspace, &cfs, &ranges, repair_time] (const gms::inet_address& node) {
+            if (node == utils::fb_utilities::get_broadcast_address()) {
+                return update_repair_history_locally(keyspace, cfs, ranges, repair_time);
+            }
+            return netw::get_local_messaging_service().send_repair_update_history(netw::msg_addr(node), keyspace, cfs, ranges, repair_time);
+        });
+    });
+}
+
 future<> repair_init_messaging_service_handler(repair_service& rs, distributed<db::system_distributed_keyspace>& sys_dist_ks, distributed<db::view::view_update_generator>& view_update_generator) {
     _sys_dist_ks = &sys_dist_ks;
     _view_update_generator = &view_update_generator;
@@ -2022,7 +2260,7 @@ future<> repair_init_messaging_service_handler(repair_service& rs, distributed<d
             });
             return make_ready_future<rpc::sink<repair_row_on_wire_with_cmd>>(sink);
         });
-        ms.register_repair_put_row_diff_with_rpc_stream([&ms] (const rpc::client_info& cinfo, uint64_t repair_meta_id, rpc::source<repair_row_on_wire_with_cmd> source) {
+        ms.register_repair_put_row_diff_with_rpc_stream([&ms] (const rpc::client_info& cinfo, uint64_t repair_meta_id, rpc::source<frozen_repair_row_on_wire_with_cmd> source) {
             auto src_cpu_id = cinfo.retrieve_auxiliary<uint32_t>("src_cpu_id");
             auto from = cinfo.retrieve_auxiliary<gms::inet_address>("baddr");
             auto sink = ms.make_sink_for_repair_put_row_diff_with_rpc_stream(source);
@@ -2055,6 +2293,14 @@ future<> repair_init_messaging_service_handler(repair_service& rs, distributed<d
                 });
             }) ;
         });
+        ms.register_repair_get_row_hash_sketch([] (const rpc::client_info& cinfo, uint32_t repair_meta_id, uint32_t cells, uint64_t seed) {
+            auto src_cpu_id = cinfo.retrieve_auxiliary<uint32_t>("src_cpu_id");
+            auto from = cinfo.retrieve_auxiliary<gms::inet_address>("baddr");
+            return smp::submit_to(src_cpu_id % smp::count, [from, repair_meta_id, cells, seed] {
+                auto rm = repair_meta::get_repair_meta(from, repair_meta_id);
+                return rm->get_row_hash_sketch_handler(cells, seed);
+            });
+        });
         ms.register_repair_get_combined_row_hash([] (const rpc::client_info& cinfo, uint32_t repair_meta_id,
                 std::optional<repair_sync_boundary> common_sync_boundary) {
             auto src_cpu_id = cinfo.retrieve_auxiliary<uint32_t>("src_cpu_id");
@@ -2092,10 +2338,10 @@ future<> repair_init_messaging_service_handler(repair_service& rs, distributed<d
             });
         });
         ms.register_repair_put_row_diff([] (const rpc::client_info& cinfo, uint32_t repair_meta_id,
-                repair_rows_on_wire row_diff) {
+                frozen_repair_rows_on_wire row_diff) {
             auto src_cpu_id = cinfo.retrieve_auxiliary<uint32_t>("src_cpu_id");
             auto from = cinfo.retrieve_auxiliary<gms::inet_address>("baddr");
-            auto fp = make_foreign(std::make_unique<repair_rows_on_wire>(std::move(row_diff)));
+            auto fp = make_foreign(std::make_unique<frozen_repair_rows_on_wire>(std::move(row_diff)));
             return smp::submit_to(src_cpu_id % smp::count, [from, repair_meta_id, fp = std::move(fp)] () mutable {
                 auto rm = repair_meta::get_repair_meta(from, repair_meta_id);
                 if (fp.get_owner_shard() == this_shard_id()) {
@@ -2107,15 +2353,17 @@ future<> repair_init_messaging_service_handler(repair_service& rs, distributed<d
         });
         ms.register_repair_row_level_start([] (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring ks_name,
                 sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed,
-                unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version) {
+                unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version,
+                rpc::optional<bool> incremental) {
             auto src_cpu_id = cinfo.retrieve_auxiliary<uint32_t>("src_cpu_id");
             auto from = cinfo.retrieve_auxiliary<gms::inet_address>("baddr");
             return smp::submit_to(src_cpu_id % smp::count, [from, src_cpu_id, repair_meta_id, ks_name, cf_name,
-                    range, algo, max_row_buf_size, seed, remote_shard, remote_shard_count, remote_ignore_msb, schema_version] () mutable {
+                    range, algo, max_row_buf_size, seed, remote_shard, remote_shard_count, remote_ignore_msb, schema_version,
+                    incremental = incremental.value_or(false)] () mutable {
                 return repair_meta::repair_row_level_start_handler(from, src_cpu_id, repair_meta_id, std::move(ks_name),
                         std::move(cf_name), std::move(range), algo, max_row_buf_size, seed,
                         shard_config{remote_shard, remote_shard_count, remote_ignore_msb},
-                        schema_version);
+                        schema_version, incremental);
             });
         });
         ms.register_repair_row_level_stop([] (const rpc::client_info& cinfo, uint32_t repair_meta_id,
@@ -2145,6 +2393,16 @@ future<> repair_init_messaging_service_handler(repair_service& rs, distributed<d
         ms.register_repair_get_diff_algorithms([] (const rpc::client_info& cinfo) {
             return make_ready_future<std::vector<row_level_diff_detect_algorithm>>(suportted_diff_detect_algorithms());
         });
+        ms.register_repair_prepare_incremental([] (const rpc::client_info& cinfo, utils::UUID session, sstring ks_name, std::vector<sstring> cf_names) {
+            return prepare_incremental_repair_locally(session, std::move(ks_name), std::move(cf_names));
+        });
+        ms.register_repair_finish_incremental([] (const rpc::client_info& cinfo, utils::UUID session, dht::token_range_vector ranges, uint64_t repaired_at) {
+            return finish_incremental_repair_locally(session, std::move(ranges), repaired_at);
+        });
+        ms.register_repair_update_history([] (const rpc::client_info& cinfo, sstring ks_name, std::vector<sstring> cf_names,
+                dht::token_range_vector ranges, gc_clock::time_point repair_time) {
+            return update_repair_history_locally(std::move(ks_name), std::move(cf_names), std::move(ranges), repair_time);
+        });
     });
 }
 
@@ -2197,6 +2455,11 @@ class row_level_repair {
     // the next repair.
     uint64_t _seed;
 
+    // The number of differing rows each peer's row hash sketch is sized
+    // for, adapted to the differences decoded in previous rounds.
+    static constexpr size_t initial_expected_row_hash_diff = 64;
+    std::unordered_map<gms::inet_address, size_t> _expected_row_hash_diffs;
+
 public:
     row_level_repair(repair_info& ri,
             sstring cf_name,
@@ -2359,16 +2622,40 @@ class row_level_repair {
                 continue;
             }
 
-            rlogger.debug("Before master.get_full_row_hashes for node {}, hash_sets={}",
-                node, master.peer_row_hash_sets(node_idx).size());
-            // Ask the peer to send the full list hashes in the working row buf.
-            if (master.use_rpc_stream()) {
-                master.peer_row_hash_sets(node_idx) = master.get_full_row_hashes_with_rpc_stream(node, node_idx).get0();
-            } else {
-                master.peer_row_hash_sets(node_idx) = master.get_full_row_hashes(node).get0();
+            // Try to reconcile the row hashes with a sketch sized for the
+            // expected difference, if it is smaller than the hashes.
+            bool reconciled = false;
+            if (master.use_row_hash_sketch()) {
+                auto it = _expected_row_hash_diffs.try_emplace(node, initial_expected_row_hash_diff).first;
+                auto cells = utils::iblt::cells_for(it->second);
+                if (cells * sizeof(utils::iblt::cell) < master.working_row_buf_nr() * sizeof(repair_hash)) {
+                    auto hashes = master.get_row_hashes_with_sketch(node, it->second).get0();
+                    if (hashes) {
+                        auto local_hashes = master.working_row_hashes().get0();
+                        auto diff = repair_meta::get_set_diff(*hashes, local_hashes).size() + repair_meta::get_set_diff(local_hashes, *hashes).size();
+                        it->second = std::max(initial_expected_row_hash_diff, 2 * diff);
+                        master.stats().sketch_decoded_nr++;
+                        master.peer_row_hash_sets(node_idx) = std::move(*hashes);
+                        reconciled = true;
+                    } else {
+                        it->second *= 4;
+                        master.stats().sketch_failed_nr++;
+                    }
+                }
+            }
+
+            if (!reconciled) {
+                rlogger.debug("Before master.get_full_row_hashes for node {}, hash_sets={}",
+                    node, master.peer_row_hash_sets(node_idx).size());
+                // Ask the peer to send the full list hashes in the working row buf.
+                if (master.use_rpc_stream()) {
+                    master.peer_row_hash_sets(node_idx) = master.get_full_row_hashes_with_rpc_stream(node, node_idx).get0();
+                } else {
+                    master.peer_row_hash_sets(node_idx) = master.get_full_row_hashes(node).get0();
+                }
+                rlogger.debug("After master.get_full_row_hashes for node {}, hash_sets={}",
+                    node, master.peer_row_hash_sets(node_idx).size());
             }
-            rlogger.debug("After master.get_full_row_hashes for node {}, hash_sets={}",
-                node, master.peer_row_hash_sets(node_idx).size());
 
             // With hashes of rows from peer node, we can figure out
             // what rows repair master is missing. Note we get missing
@@ -2445,7 +2732,8 @@ class row_level_repair {
                     repair_meta::repair_master::yes,
                     repair_meta_id,
                     std::move(master_node_shard_config),
-                    _all_live_peer_nodes.size());
+                    _all_live_peer_nodes.size(),
+                    _ri.incremental);
 
             // All nodes including the node itself.
             _all_nodes.insert(_all_nodes.begin(), master.myip());
@@ -2458,7 +2746,7 @@ class row_level_repair {
             nodes_to_stop.reserve(_all_nodes.size());
             try {
                 parallel_for_each(_all_nodes, [&, this] (const gms::inet_address& node) {
-                    return master.repair_row_level_start(node, _ri.keyspace, _cf_name, _range, schema_version).then([&] () {
+                    return master.repair_row_level_start(node, _ri.keyspace, _cf_name, _range, schema_version, _ri.incremental).then([&] () {
                         nodes_to_stop.push_back(node);
                         return master.repair_get_estimated_partitions(node).then([this, node] (uint64_t partitions) {
                             rlogger.trace("Get repair_get_estimated_partitions for node={}, estimated_partitions={}", node, partitions);
@@ -53,3 +53,13 @@ future<> repair_cf_range_row_level(repair_info& ri,
         const std::vector<gms::inet_address>& all_peer_nodes);
 
 future<> shutdown_all_row_level_repair();
+
+// Incremental repair: each of the nodes records the unrepaired sstables of
+// the tables, and when the repair succeeded (repaired_at != 0) marks their
+// data in the ranges as repaired. Otherwise the records are just dropped.
+future<> prepare_incremental_repair(utils::UUID session, sstring keyspace, std::vector<sstring> cfs, std::vector<gms::inet_address> nodes);
+future<> finish_incremental_repair(utils::UUID session, std::vector<gms::inet_address> nodes, dht::token_range_vector ranges, uint64_t repaired_at);
+
+// Records on each of the nodes that all replicas of the ranges of the tables
+// were repaired by a repair started at repair_time, see db::repair_history.
+future<> update_repair_history(sstring keyspace, std::vector<sstring> cfs, std::vector<gms::inet_address> nodes, dht::token_range_vector ranges, gc_clock::time_point repair_time);
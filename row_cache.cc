@@ -47,18 +47,29 @@ using namespace cache;
 flat_mutation_reader
 row_cache::create_underlying_reader(read_context& ctx, mutation_source& src, const dht::partition_range& pr) {
     ctx.on_underlying_created();
-    return src.make_reader(_schema, no_reader_permit(), pr, ctx.slice(), ctx.pc(), ctx.trace_state(), streamed_mutation::forwarding::yes);
+    return src.make_reader(_schema, ctx.permit(), pr, ctx.slice(), ctx.pc(), ctx.trace_state(), streamed_mutation::forwarding::yes);
 }
 
 static thread_local mutation_application_stats dummy_app_stats;
 
+// Counters per row of the frequency sketch, 128 KiB per shard. The sketch
+// should be able to tell apart at least as many partitions as a shard
+// typically caches.
+static constexpr size_t frequency_sketch_width = 64 * 1024;
+
+// Range scans link rows of partitions less popular than that into the
+// probationary segment of the LRU.
+static constexpr unsigned main_segment_min_frequency = 2;
+
 cache_tracker::cache_tracker()
     : cache_tracker(dummy_app_stats)
 {}
 
 cache_tracker::cache_tracker(mutation_application_stats& app_stats)
-    : _garbage(_region, this, app_stats)
+    : _sketch(frequency_sketch_width)
+    , _garbage(_region, this, app_stats)
     , _memtable_cleaner(_region, nullptr, app_stats)
+    , _compressed_tier(_region)
 {
     setup_metrics();
 
@@ -76,8 +87,14 @@ cache_tracker::cache_tracker(mutation_application_stats& app_stats)
                 _memtable_cleaner.clear_some();
                 return memory::reclaiming_result::reclaimed_something;
             }
+            if (!_probation_lru.empty()) {
+                _probation_lru.back().on_evicted(*this);
+                return memory::reclaiming_result::reclaimed_something;
+            }
             if (_lru.empty()) {
-                return memory::reclaiming_result::reclaimed_nothing;
+                // The tier holds partitions evicted earlier, so it goes last.
+                return _compressed_tier.evict_some() ? memory::reclaiming_result::reclaimed_something
+                        : memory::reclaiming_result::reclaimed_nothing;
             }
             _lru.back().on_evicted(*this);
             return memory::reclaiming_result::reclaimed_something;
@@ -96,6 +113,101 @@ cache_tracker::~cache_tracker() {
     clear();
 }
 
+// How often the compressed tier is fed, and the most partitions moved into it per round.
+static constexpr auto demotion_period = std::chrono::milliseconds(100);
+static constexpr size_t max_demoted_partitions = 256;
+
+void cache_tracker::set_compressed_tier_size(size_t bytes) {
+    _compressed_tier.set_max_memory(bytes);
+    if (!bytes) {
+        _demotion_timer.cancel();
+        return;
+    }
+    if (!_demotion_timer.armed()) {
+        _demotion_timer.set_callback([this] {
+            // Feed the tier at the pace the cache is evicting partitions.
+            auto evicted = _stats.partition_evictions - _partition_evictions_at_last_demotion;
+            if (evicted) {
+                demote_cold_partitions(std::min(size_t(evicted), max_demoted_partitions));
+            }
+            // Demotion evicts too, don't count that towards the next round.
+            _partition_evictions_at_last_demotion = _stats.partition_evictions;
+        });
+        _partition_evictions_at_last_demotion = _stats.partition_evictions;
+        _demotion_timer.arm_periodic(demotion_period);
+    }
+}
+
+// Returns the cache entry owning the row, or nullptr if its partition can't
+// be moved into the compressed tier.
+static cache_entry* demotable_entry_of(rows_entry& row) noexcept {
+    auto& pv = partition_version::container_of(mutation_partition::container_of(mutation_partition::rows_type::container_of(row)));
+    if (!pv.is_referenced_from_entry()) {
+        return nullptr;
+    }
+    auto& pe = partition_entry::container_of(pv);
+    if (pe.is_locked()) {
+        return nullptr;
+    }
+    auto& ce = cache_entry::container_of(pe);
+    return ce.is_dummy_entry() ? nullptr : &ce;
+}
+
+// Does the eviction the reclaimer would do next, ahead of it, moving
+// complete partitions into the compressed tier instead of dropping them.
+// Rows of partitions which can't be moved are evicted as usual. Stops when
+// the task quota is used up, the rest is left to the next round.
+void cache_tracker::demote_cold_partitions(size_t max_partitions) noexcept {
+    size_t demoted = 0;
+    // Bounds the work spent on partitions which turn out to be incomplete.
+    size_t max_attempts = max_partitions * 4;
+    for (size_t attempts = 0; demoted < max_partitions && attempts < max_attempts && !need_preempt(); ++attempts) {
+        try {
+            auto& lru = _probation_lru.empty() ? _lru : _probation_lru;
+            if (lru.empty()) {
+                return;
+            }
+            std::optional<mutation> m;
+            {
+                // The rows are read in place, so they must not move. The lock
+                // is held for a single partition, the compression below may
+                // reclaim from the cache.
+                logalloc::reclaim_lock rl(_region);
+                auto& row = lru.back();
+                auto ce = demotable_entry_of(row);
+                if (ce && !_compressed_tier.accepts(*ce->schema())) {
+                    // The table's cache is being updated, try next round.
+                    return;
+                }
+                if (ce) {
+                    auto mp = with_linearized_managed_bytes([&] {
+                        return ce->partition().squashed(*ce->schema());
+                    });
+                    if (mp.is_fully_continuous()) {
+                        m.emplace(ce->schema(), ce->key(), std::move(mp));
+                    }
+                }
+                with_allocator(_region.allocator(), [&] {
+                    with_linearized_managed_bytes([&] {
+                        if (m) {
+                            ce->on_evicted(*this);
+                        } else {
+                            row.on_evicted(*this);
+                        }
+                    });
+                });
+            }
+            if (m) {
+                _compressed_tier.insert(m->schema(), m->decorated_key(), m->partition());
+                ++demoted;
+            }
+        } catch (...) {
+            clogger.debug("Failed to move partitions to the compressed tier: {}", std::current_exception());
+            return;
+        }
+    }
+}
+
 void cache_tracker::set_compaction_scheduling_group(seastar::scheduling_group sg) {
     _memtable_cleaner.set_scheduling_group(sg);
     _garbage.set_scheduling_group(sg);
@@ -118,9 +230,20 @@ cache_tracker::setup_metrics() {
         sm::make_derive("static_row_insertions", sm::description("total number of static rows added to cache"), _stats.static_row_insertions),
         sm::make_derive("concurrent_misses_same_key", sm::description("total number of operation with misses same key"), _stats.concurrent_misses_same_key),
         sm::make_derive("partition_merges", sm::description("total number of partitions merged"), _stats.partition_merges),
+        sm::make_gauge("pending_version_merges", sm::description("number of partition versions waiting to be merged in the background"),
+            [this] { return _garbage.pending_version_merges() + _memtable_cleaner.pending_version_merges(); }),
         sm::make_derive("partition_evictions", sm::description("total number of evicted partitions"), _stats.partition_evictions),
         sm::make_derive("partition_removals", sm::description("total number of invalidated partitions"), _stats.partition_removals),
         sm::make_derive("mispopulations", sm::description("number of entries not inserted by reads"), _stats.mispopulations),
+        sm::make_gauge("compressed_tier_bytes", sm::description("memory used by the compressed tier of the cache"),
+            [this] { return _compressed_tier.memory_used(); }),
+        sm::make_derive("compressed_tier_insertions", sm::description("number of partitions copied into the compressed tier of the cache"),
+            [this] { return _compressed_tier.get_stats().insertions; }),
+        sm::make_derive("compressed_tier_hits", sm::description("number of partitions missed by the cache and moved back into it from its compressed tier"),
+            [this] { return _compressed_tier.get_stats().hits; }),
+        sm::make_derive("compressed_tier_evictions", sm::description("number of partitions evicted from the compressed tier of the cache"),
+            [this] { return _compressed_tier.get_stats().evictions; }),
+        sm::make_derive("admission_rejections", sm::description("number of partitions read by range scans and not inserted because they were accessed less often than the evicted ones"), _stats.admission_rejections),
         sm::make_gauge("partitions", sm::description("total number of cached partitions"), _stats.partitions),
         sm::make_gauge("rows", sm::description("total number of cached rows"), _stats.rows),
         sm::make_derive("reads", sm::description("number of started reads"), _stats.reads),
@@ -147,32 +270,64 @@ void cache_tracker::clear() {
     with_allocator(_region.allocator(), [this] {
         _garbage.clear();
         _memtable_cleaner.clear();
+        while (!_probation_lru.empty()) {
+            _probation_lru.back().on_evicted(*this);
+        }
         while (!_lru.empty()) {
             _lru.back().on_evicted(*this);
         }
     });
+    _compressed_tier.clear();
     _stats.partition_removals += partitions_before;
     _stats.row_removals += rows_before;
     allocator().invalidate_references();
 }
 
-void cache_tracker::touch(rows_entry& e) {
-    if (e._lru_link.is_linked()) { // last dummy may not be linked if evicted.
-        _lru.erase(_lru.iterator_to(e));
+void cache_tracker::touch(rows_entry& e, lru_segment segment) {
+    // last dummy may not be linked if evicted.
+    bool linked = e._lru_link.is_linked();
+    e._lru_link.unlink();
+    if (linked && e._flags._probationary && segment == lru_segment::probationary) {
+        _probation_lru.push_front(e);
+    } else {
+        e._flags._probationary = false;
+        _lru.push_front(e);
     }
-    _lru.push_front(e);
 }
 
-void cache_tracker::insert(cache_entry& entry) {
-    insert(entry.partition());
+void cache_tracker::insert(cache_entry& entry, lru_segment segment) {
+    insert(entry.partition(), segment);
     ++_stats.partition_insertions;
     ++_stats.partitions;
+    account_partitions(*entry.schema(), 1);
     // partition_range_cursor depends on this to detect invalidation of _end
     _region.allocator().invalidate_references();
 }
 
-void cache_tracker::on_partition_erase() {
+void cache_tracker::account_partitions(const schema& s, int64_t delta) {
+    auto it = _table_partitions.try_emplace(s.id(), 0).first;
+    it->second += delta;
+    if (!it->second) {
+        _table_partitions.erase(it);
+    }
+}
+
+uint64_t cache_tracker::table_partitions(const schema& s) const noexcept {
+    auto it = _table_partitions.find(s.id());
+    return it == _table_partitions.end() ? 0 : it->second;
+}
+
+bool cache_tracker::over_quota(const schema& s) const noexcept {
+    if (!_table_quota_fraction) {
+        return false;
+    }
+    auto partitions = table_partitions(s);
+    return partitions < _stats.partitions && partitions > _stats.partitions * _table_quota_fraction;
+}
+
+void cache_tracker::on_partition_erase(const schema& s) {
     --_stats.partitions;
+    account_partitions(s, -1);
     ++_stats.partition_removals;
     allocator().invalidate_references();
 }
@@ -185,17 +340,47 @@ void cache_tracker::on_partition_merge() {
     ++_stats.partition_merges;
 }
 
-void cache_tracker::on_partition_hit() {
+void cache_tracker::record_access(const dht::decorated_key& dk) noexcept {
+    if (_sketch.increment(dht::token_ordinal(dk.token()))) {
+        _victim_frequency /= 2;
+    }
+}
+
+unsigned cache_tracker::estimate_frequency(const dht::decorated_key& dk) const noexcept {
+    return _sketch.estimate(dht::token_ordinal(dk.token()));
+}
+
+lru_segment cache_tracker::segment_for(const schema& s, const dht::decorated_key& dk, bool range_query) const noexcept {
+    if (over_quota(s) || (range_query && estimate_frequency(dk) < main_segment_min_frequency)) {
+        return lru_segment::probationary;
+    }
+    return lru_segment::main;
+}
+
+bool cache_tracker::admit(const dht::decorated_key& dk) const noexcept {
+    return estimate_frequency(dk) > _victim_frequency;
+}
+
+void cache_tracker::on_partition_hit(const dht::decorated_key& dk) {
     ++_stats.partition_hits;
+    record_access(dk);
 }
 
-void cache_tracker::on_partition_miss() {
+void cache_tracker::on_partition_miss(const dht::decorated_key& dk) {
     ++_stats.partition_misses;
+    record_access(dk);
 }
 
-void cache_tracker::on_partition_eviction() {
+void cache_tracker::on_partition_eviction(const schema& s, const dht::decorated_key& dk) {
     --_stats.partitions;
+    account_partitions(s, -1);
     ++_stats.partition_evictions;
+    // There is nothing to make room for once the cache is empty.
+    _victim_frequency = _lru.empty() && _probation_lru.empty() ? 0 : estimate_frequency(dk);
+}
+
+void cache_tracker::on_admission_rejection() {
+    ++_stats.admission_rejections;
 }
 
 void cache_tracker::on_row_eviction() {
@@ -377,11 +562,13 @@ class single_partition_populating_reader final : public flat_mutation_reader::im
                             dht::decorated_key dk = _read_context->range().start()->value().as_decorated_key();
                             _cache.do_find_or_create_entry(dk, nullptr, [&] (auto i) {
                                 mutation_partition mp(_cache._schema);
-                                cache_entry* entry = current_allocator().construct<cache_entry>(
-                                    _cache._schema, std::move(dk), std::move(mp));
-                                _cache._tracker.insert(*entry);
+                                auto entry = alloc_strategy_unique_ptr<cache_entry>(current_allocator().construct<cache_entry>(
+                                    _cache._schema, std::move(dk), std::move(mp)));
                                 entry->set_continuous(i->continuous());
-                                return _cache._partitions.insert_before(i, *entry);
+                                auto segment = _cache._tracker.segment_for(*_cache._schema, entry->key(), false);
+                                auto it = _cache._partitions.insert_before(i, *entry);
+                                _cache._tracker.insert(*entry.release(), segment);
+                                return it;
                             }, [&] (auto i) {
                                 _cache._tracker.on_miss_already_populated();
                             });
@@ -393,7 +580,9 @@ class single_partition_populating_reader final : public flat_mutation_reader::im
                 _end_of_stream = true;
             } else if (phase == _cache.phase_of(_read_context->range().start()->value())) {
                 _reader = _cache._read_section(_cache._tracker.region(), [&] {
-                    cache_entry& e = _cache.find_or_create(mfopt->as_partition_start().key(), mfopt->as_partition_start().partition_tombstone(), phase);
+                    auto& key = mfopt->as_partition_start().key();
+                    cache_entry& e = _cache.find_or_create(key, mfopt->as_partition_start().partition_tombstone(), phase, nullptr,
+                                                           _cache._tracker.segment_for(*_cache._schema, key, false));
                     return e.read(_cache, *_read_context, phase);
                 });
             } else {
@@ -455,12 +644,12 @@ void cache_tracker::clear_continuity(cache_entry& ce) {
     ce.set_continuous(false);
 }
 
-void row_cache::on_partition_hit() {
-    _tracker.on_partition_hit();
+void row_cache::on_partition_hit(const dht::decorated_key& dk) {
+    _tracker.on_partition_hit(dk);
 }
 
-void row_cache::on_partition_miss() {
-    _tracker.on_partition_miss();
+void row_cache::on_partition_miss(const dht::decorated_key& dk) {
+    _tracker.on_partition_miss(dk);
 }
 
 void row_cache::on_row_hit() {
@@ -531,25 +720,28 @@ class range_populating_reader {
                     this->handle_end_of_stream();
                     return make_ready_future<flat_mutation_reader_opt, mutation_fragment_opt>(std::nullopt, std::nullopt);
                 }
-                _cache.on_partition_miss();
                 const partition_start& ps = mfopt->as_partition_start();
                 const dht::decorated_key& key = ps.key();
-                if (_reader.creation_phase() == _cache.phase_of(key)) {
+                _cache.on_partition_miss(key);
+                if (_reader.creation_phase() != _cache.phase_of(key)) {
+                    _cache._tracker.on_mispopulate();
+                } else if (!_cache._tracker.admit(key)) {
+                    _cache._tracker.on_admission_rejection();
+                } else {
                     return _cache._read_section(_cache._tracker.region(), [&] {
                         cache_entry& e = _cache.find_or_create(key,
                                                                ps.partition_tombstone(),
                                                                _reader.creation_phase(),
-                                                               this->can_set_continuity() ? &*_last_key : nullptr);
+                                                               this->can_set_continuity() ? &*_last_key : nullptr,
+                                                               _cache._tracker.segment_for(*_cache._schema, key, true));
                         _last_key = row_cache::previous_entry_pointer(key);
                         return make_ready_future<flat_mutation_reader_opt, mutation_fragment_opt>(
                             e.read(_cache, _read_context, _reader.creation_phase()), std::nullopt);
                     });
-                } else {
-                    _cache._tracker.on_mispopulate();
-                    _last_key = row_cache::previous_entry_pointer(key);
-                    return make_ready_future<flat_mutation_reader_opt, mutation_fragment_opt>(
-                        read_directly_from_underlying(_read_context), std::move(mfopt));
                 }
+                _last_key = row_cache::previous_entry_pointer(key);
+                return make_ready_future<flat_mutation_reader_opt, mutation_fragment_opt>(
+                    read_directly_from_underlying(_read_context), std::move(mfopt));
             }
         });
     }
@@ -582,7 +774,7 @@ class scanning_and_populating_reader final : public flat_mutation_reader::impl {
 private:
     flat_mutation_reader read_from_entry(cache_entry& ce) {
         _cache.upgrade_entry(ce);
-        _cache.on_partition_hit();
+        _cache.on_partition_hit(ce.key());
         return ce.read(_cache, *_read_context);
     }
 
@@ -739,11 +931,13 @@ row_cache::make_reader(schema_ptr s,
                        const io_priority_class& pc,
                        tracing::trace_state_ptr trace_state,
                        streamed_mutation::forwarding fwd,
-                       mutation_reader::forwarding fwd_mr)
+                       mutation_reader::forwarding fwd_mr,
+                       reader_permit permit)
 {
-    auto ctx = make_lw_shared<read_context>(*this, s, range, slice, pc, trace_state, fwd_mr);
+    auto ctx = make_lw_shared<read_context>(*this, s, range, slice, pc, trace_state, fwd_mr, std::move(permit));
 
     if (!ctx->is_range_query() && !fwd_mr) {
+        promote_from_compressed_tier(ctx->key());
         auto mr = _read_section(_tracker.region(), [&] {
             return with_linearized_managed_bytes([&] {
                 cache_entry::compare cmp(_schema);
@@ -752,12 +946,12 @@ row_cache::make_reader(schema_ptr s,
                 if (i != _partitions.end() && !cmp(pos, i->position())) {
                     cache_entry& e = *i;
                     upgrade_entry(e);
-                    on_partition_hit();
+                    on_partition_hit(e.key());
                     return e.read(*this, *ctx);
                 } else if (i->continuous()) {
                     return make_empty_flat_reader(std::move(s));
                 } else {
-                    on_partition_miss();
+                    on_partition_miss(ctx->key());
                     return make_flat_mutation_reader<single_partition_populating_reader>(*this, std::move(ctx));
                 }
             });
@@ -780,10 +974,11 @@ row_cache::make_reader(schema_ptr s,
 
 
 row_cache::~row_cache() {
+    _tracker.compressed_tier().invalidate(*_schema);
     with_allocator(_tracker.allocator(), [this] {
         _partitions.clear_and_dispose([this, deleter = current_deleter<cache_entry>()] (auto&& p) mutable {
             if (!p->is_dummy_entry()) {
-                _tracker.on_partition_erase();
+                _tracker.on_partition_erase(*p->schema());
             }
             p->evict(_tracker);
             deleter(p);
@@ -792,9 +987,10 @@ row_cache::~row_cache() {
 }
 
 void row_cache::clear_now() noexcept {
+    _tracker.compressed_tier().invalidate(*_schema);
     with_allocator(_tracker.allocator(), [this] {
         auto it = _partitions.erase_and_dispose(_partitions.begin(), partitions_end(), [this, deleter = current_deleter<cache_entry>()] (auto&& p) mutable {
-            _tracker.on_partition_erase();
+            _tracker.on_partition_erase(*p->schema());
             p->evict(_tracker);
             deleter(p);
         });
@@ -836,11 +1032,14 @@ cache_entry& row_cache::do_find_or_create_entry(const dht::decorated_key& key,
     });
 }
 
-cache_entry& row_cache::find_or_create(const dht::decorated_key& key, tombstone t, row_cache::phase_type phase, const previous_entry_pointer* previous) {
+cache_entry& row_cache::find_or_create(const dht::decorated_key& key, tombstone t, row_cache::phase_type phase, const previous_entry_pointer* previous,
+                                       lru_segment segment) {
     return do_find_or_create_entry(key, previous, [&] (auto i) { // create
-        auto entry = current_allocator().construct<cache_entry>(cache_entry::incomplete_tag{}, _schema, key, t);
-        _tracker.insert(*entry);
-        return _partitions.insert_before(i, *entry);
+        auto entry = alloc_strategy_unique_ptr<cache_entry>(
+            current_allocator().construct<cache_entry>(cache_entry::incomplete_tag{}, _schema, key, t));
+        auto it = _partitions.insert_before(i, *entry);
+        _tracker.insert(*entry.release(), segment);
+        return it;
     }, [&] (auto i) { // visit
         _tracker.on_miss_already_populated();
         cache_entry& e = *i;
@@ -849,14 +1048,33 @@ cache_entry& row_cache::find_or_create(const dht::decorated_key& key, tombstone
     });
 }
 
+void row_cache::promote_from_compressed_tier(const dht::decorated_key& dk) {
+    auto& tier = _tracker.compressed_tier();
+    if (!tier.contains(*_schema, dk)) {
+        return;
+    }
+    auto cached = _read_section(_tracker.region(), [&] {
+        return with_linearized_managed_bytes([&] {
+            auto i = _partitions.lower_bound(dk, cache_entry::compare(_schema));
+            return i != _partitions.end() && i->key().equal(*_schema, dk);
+        });
+    });
+    if (cached) {
+        return;
+    }
+    if (auto m = tier.take(_schema, dk)) {
+        populate(*m);
+    }
+}
+
 void row_cache::populate(const mutation& m, const previous_entry_pointer* previous) {
   _populate_section(_tracker.region(), [&] {
     do_find_or_create_entry(m.decorated_key(), previous, [&] (auto i) {
-        cache_entry* entry = current_allocator().construct<cache_entry>(
-                m.schema(), m.decorated_key(), m.partition());
-        _tracker.insert(*entry);
+        auto entry = alloc_strategy_unique_ptr<cache_entry>(current_allocator().construct<cache_entry>(
+                m.schema(), m.decorated_key(), m.partition()));
         entry->set_continuous(i->continuous());
         i = _partitions.insert_before(i, *entry);
+        _tracker.insert(*entry.release());
         upgrade_entry(*i);
         return i;
     }, [&] (auto i) {
@@ -901,6 +1119,7 @@ void row_cache::invalidate_sync(memtable& m) noexcept {
                 deleter(entry);
             });
         });
+        m._partition_count = 0;
         if (blow_cache) {
             // We failed to invalidate the key, presumably due to with_linearized_managed_bytes()
             // running out of memory.  Recover using clear_now(), which doesn't throw.
@@ -920,10 +1139,21 @@ row_cache::phase_type row_cache::phase_of(dht::ring_position_view pos) {
 template <typename Updater>
 future<> row_cache::do_update(external_updater eu, memtable& m, Updater updater) {
   return do_update(std::move(eu), [this, &m, updater = std::move(updater)] {
+    // Buffered writes live in the region but outside the partitions, which
+    // is all the update moves.
+    assert(!m.has_pending_writes());
     real_dirty_memory_accounter real_dirty_acc(m, _tracker);
     m.on_detach_from_region_group();
     _tracker.region().merge(m); // Now all data in memtable belongs to cache
     _tracker.memtable_cleaner().merge(m._cleaner);
+    if (_tracker.compressed_tier().has_entries(*_schema)) {
+        // Compressed copies of partitions the memtable writes to are stale now.
+        with_linearized_managed_bytes([&] {
+            for (auto&& e : m.partitions) {
+                _tracker.compressed_tier().invalidate(*_schema, e.key());
+            }
+        });
+    }
     STAP_PROBE(scylla, row_cache_update_start);
     auto cleanup = defer([&m, this] {
         invalidate_sync(m);
@@ -973,6 +1203,7 @@ future<> row_cache::do_update(external_updater eu, memtable& m, Updater updater)
                                 auto i = m.partitions.begin();
                                 memtable_entry& mem_e = *i;
                                 m.partitions.erase(i);
+                                --m._partition_count;
                                 mem_e.partition().evict(_tracker.memtable_cleaner());
                                 current_allocator().destroy(&mem_e);
                             });
@@ -1019,12 +1250,13 @@ future<> row_cache::update(external_updater eu, memtable& m) {
                    || with_allocator(standard_allocator(), [&] { return is_present(mem_e.key()); })
                       == partition_presence_checker_result::definitely_doesnt_exist) {
             // Partition is absent in underlying. First, insert a neutral partition entry.
-            cache_entry* entry = current_allocator().construct<cache_entry>(cache_entry::evictable_tag(),
+            auto new_entry = alloc_strategy_unique_ptr<cache_entry>(current_allocator().construct<cache_entry>(cache_entry::evictable_tag(),
                 _schema, dht::decorated_key(mem_e.key()),
-                partition_entry::make_evictable(*_schema, mutation_partition(_schema)));
-            entry->set_continuous(cache_i->continuous());
+                partition_entry::make_evictable(*_schema, mutation_partition(_schema))));
+            new_entry->set_continuous(cache_i->continuous());
+            _partitions.insert_before(cache_i, *new_entry);
+            cache_entry* entry = new_entry.release();
             _tracker.insert(*entry);
-            _partitions.insert_before(cache_i, *entry);
             mem_e.upgrade_schema(_schema, _tracker.memtable_cleaner());
             return entry->partition().apply_to_incomplete(*_schema, std::move(mem_e.partition()), _tracker.memtable_cleaner(),
                 alloc, _tracker.region(), _tracker, _underlying_phase, acc);
@@ -1088,13 +1320,14 @@ void row_cache::unlink_from_lru(const dht::decorated_key& dk) {
 }
 
 void row_cache::invalidate_locked(const dht::decorated_key& dk) {
+    _tracker.compressed_tier().invalidate(*_schema, dk);
     auto pos = _partitions.lower_bound(dk, cache_entry::compare(_schema));
     if (pos == partitions_end() || !pos->key().equal(*_schema, dk)) {
         _tracker.clear_continuity(*pos);
     } else {
         auto it = _partitions.erase_and_dispose(pos,
             [this, &dk, deleter = current_deleter<cache_entry>()](auto&& p) mutable {
-                _tracker.on_partition_erase();
+                _tracker.on_partition_erase(*p->schema());
                 p->evict(_tracker);
                 deleter(p);
             });
@@ -1133,7 +1366,7 @@ future<> row_cache::invalidate(external_updater eu, dht::partition_range_vector&
                                 auto deleter = current_deleter<cache_entry>();
                                 while (it != end) {
                                     it = _partitions.erase_and_dispose(it, [&] (cache_entry* p) mutable {
-                                        _tracker.on_partition_erase();
+                                        _tracker.on_partition_erase(*p->schema());
                                         p->evict(_tracker);
                                         deleter(p);
                                     });
@@ -1166,19 +1399,64 @@ future<> row_cache::invalidate(external_updater eu, dht::partition_range_vector&
     });
 }
 
+std::vector<dht::decorated_key> row_cache::hottest_keys(size_t n) {
+    struct candidate {
+        unsigned frequency;
+        dht::decorated_key key;
+    };
+    // A min-heap, so that the coldest candidate is replaced first.
+    auto hotter = [] (const candidate& a, const candidate& b) {
+        return a.frequency > b.frequency;
+    };
+    std::vector<candidate> heap;
+    std::optional<dht::decorated_key> last;
+    bool done = !n;
+    while (!done) {
+        with_linearized_managed_bytes([&] {
+            logalloc::reclaim_lock _(_tracker.region());
+            auto it = last ? _partitions.upper_bound(*last, cache_entry::compare(_schema)) : _partitions.begin();
+            for (; !it->is_dummy_entry(); ++it) {
+                auto frequency = _tracker.estimate_frequency(it->key());
+                if (heap.size() < n) {
+                    heap.push_back(candidate{frequency, it->key()});
+                    std::push_heap(heap.begin(), heap.end(), hotter);
+                } else if (frequency > heap.front().frequency) {
+                    std::pop_heap(heap.begin(), heap.end(), hotter);
+                    heap.back() = candidate{frequency, it->key()};
+                    std::push_heap(heap.begin(), heap.end(), hotter);
+                }
+                if (need_preempt()) {
+                    last = it->key();
+                    return;
+                }
+            }
+            done = true;
+        });
+        seastar::thread::maybe_yield();
+    }
+    std::sort_heap(heap.begin(), heap.end(), hotter);
+    std::vector<dht::decorated_key> keys;
+    keys.reserve(heap.size());
+    for (auto&& c : heap) {
+        keys.push_back(std::move(c.key));
+    }
+    return keys;
+}
+
 void row_cache::evict() {
     while (_tracker.region().evict_some() == memory::reclaiming_result::reclaimed_something) {}
 }
 
 void row_cache::invalidate_unwrapped(const dht::partition_range& range) {
     logalloc::reclaim_lock _(_tracker.region());
+    _tracker.compressed_tier().invalidate(*_schema, range);
 
     auto cmp = cache_entry::compare(_schema);
     auto begin = _partitions.lower_bound(dht::ring_position_view::for_range_start(range), cmp);
     auto end = _partitions.lower_bound(dht::ring_position_view::for_range_end(range), cmp);
     with_allocator(_tracker.allocator(), [this, begin, end] {
         auto it = _partitions.erase_and_dispose(begin, end, [this, deleter = current_deleter<cache_entry>()] (auto&& p) mutable {
-            _tracker.on_partition_erase();
+            _tracker.on_partition_erase(*p->schema());
             p->evict(_tracker);
             deleter(p);
         });
@@ -1190,14 +1468,14 @@ void row_cache::invalidate_unwrapped(const dht::partition_range& range) {
 row_cache::row_cache(schema_ptr s, snapshot_source src, cache_tracker& tracker, is_continuous cont)
     : _tracker(tracker)
     , _schema(std::move(s))
-    , _partitions(cache_entry::compare(_schema))
     , _underlying(src())
     , _snapshot_source(std::move(src))
 {
     with_allocator(_tracker.allocator(), [this, cont] {
-        cache_entry* entry = current_allocator().construct<cache_entry>(cache_entry::dummy_entry_tag());
-        _partitions.insert_before(_partitions.end(), *entry);
+        auto entry = alloc_strategy_unique_ptr<cache_entry>(current_allocator().construct<cache_entry>(cache_entry::dummy_entry_tag()));
         entry->set_continuous(bool(cont));
+        _partitions.insert_before(_partitions.end(), *entry);
+        entry.release();
     });
 }
 
@@ -1206,13 +1484,8 @@ cache_entry::cache_entry(cache_entry&& o) noexcept
     , _key(std::move(o._key))
     , _pe(std::move(o._pe))
     , _flags(o._flags)
-    , _cache_link()
+    , _cache_link(std::move(o._cache_link))
 {
-    {
-        using container_type = row_cache::partitions_type;
-        container_type::node_algorithms::replace_node(o._cache_link.this_ptr(), _cache_link.this_ptr());
-        container_type::node_algorithms::init(o._cache_link.this_ptr());
-    }
 }
 
 cache_entry::~cache_entry() {
@@ -1227,11 +1500,11 @@ void row_cache::set_schema(schema_ptr new_schema) noexcept {
 }
 
 void cache_entry::on_evicted(cache_tracker& tracker) noexcept {
-    auto it = row_cache::partitions_type::s_iterator_to(*this);
+    auto it = row_cache::partitions_type::iterator_to(*this);
     std::next(it)->set_continuous(false);
     evict(tracker);
+    tracker.on_partition_eviction(*_schema, _key);
     current_deleter<cache_entry>()(this);
-    tracker.on_partition_eviction();
 }
 
 void rows_entry::on_evicted(cache_tracker& tracker) noexcept {
@@ -1313,7 +1586,14 @@ future<> row_cache::do_update(row_cache::external_updater eu, row_cache::interna
         return get_units(_update_sem, 1);
     }).then([this, eu = std::move(eu), iu = std::move(iu)] (auto permit) mutable {
         auto pos = dht::ring_position::min();
-        eu();
+        // Keep demotion from racing with the update and copying stale partitions.
+        _tracker.compressed_tier().pause_insertions(*_schema);
+        try {
+            eu();
+        } catch (...) {
+            _tracker.compressed_tier().resume_insertions(*_schema);
+            throw;
+        }
         [&] () noexcept {
             _prev_snapshot_pos = std::move(pos);
             _prev_snapshot = std::exchange(_underlying, _snapshot_source());
@@ -1322,6 +1602,7 @@ future<> row_cache::do_update(row_cache::external_updater eu, row_cache::interna
         return futurize_invoke([&iu] {
             return iu();
         }).then_wrapped([this, permit = std::move(permit)] (auto f) {
+            _tracker.compressed_tier().resume_insertions(*_schema);
             _prev_snapshot_pos = {};
             _prev_snapshot = {};
             if (f.failed()) {
@@ -21,12 +21,14 @@
 
 #pragma once
 
+#include <unordered_map>
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/set.hpp>
 #include <boost/intrusive/parent_from_member.hpp>
 
 #include <seastar/core/memory.hh>
 #include <seastar/core/thread.hh>
+#include <seastar/core/timer.hh>
 #include <seastar/util/noncopyable_function.hh>
 
 #include "mutation_reader.hh"
@@ -40,6 +42,9 @@
 #include <seastar/core/metrics_registration.hh>
 #include "flat_mutation_reader.hh"
 #include "mutation_cleaner.hh"
+#include "utils/intrusive_btree.hh"
+#include "utils/frequency_sketch.hh"
+#include "compressed_partition_cache.hh"
 
 namespace bi = boost::intrusive;
 
@@ -61,10 +66,10 @@ class lsa_manager;
 //
 // TODO: Make memtables use this format too.
 class cache_entry {
-    // We need auto_unlink<> option on the _cache_link because when entry is
-    // evicted from cache via LRU we don't have a reference to the container
-    // and don't want to store it with each entry.
-    using cache_link_type = bi::set_member_hook<bi::link_mode<bi::auto_unlink>>;
+    // The hook unlinks the entry when destroyed, which we need because when
+    // entry is evicted from cache via LRU we don't have a reference to the
+    // container and don't want to store it with each entry.
+    using cache_link_type = intrusive_b::keyed_member_hook;
 
     schema_ptr _schema;
     dht::decorated_key _key;
@@ -180,10 +185,44 @@ class cache_entry {
         }
     };
 
+    // Inline key of the entries in row_cache::partitions_type, so that
+    // lookups compare tokens without dereferencing the entries.
+    struct token_of {
+        int64_t operator()(const cache_entry& e) const noexcept {
+            return dht::token_ordinal(e.position().token());
+        }
+        int64_t operator()(const dht::decorated_key& k) const noexcept {
+            return dht::token_ordinal(k.token());
+        }
+        int64_t operator()(dht::ring_position_view k) const noexcept {
+            return dht::token_ordinal(k.token());
+        }
+    };
+
     friend std::ostream& operator<<(std::ostream&, cache_entry&);
 };
 
 // Tracks accesses and performs eviction of cache entries.
+//
+// The LRU is split into two segments. Rows populated by range scans of
+// partitions which were not accessed recently go to the probationary
+// segment, which is evicted before the main one, so that a large scan
+// churns through its own data instead of the working set of other reads.
+// Rows are promoted to the main segment when accessed by a read which
+// would link them there.
+//
+// Accesses to partitions are also recorded in a frequency sketch
+// (TinyLFU), which is the admission policy for partitions missed by range
+// scans: they are populated only if they are estimated to be accessed
+// more often than the partition evicted last.
+//
+// Tables may be given a soft quota, a fraction of the cached partitions.
+// Rows of a table exceeding its quota are linked into the probationary
+// segment, so that the table is evicted from before the others.
+//
+// With a compressed tier configured, complete partitions at the cold end
+// of the LRU are periodically moved into it while the cache is evicting,
+// see compressed_partition_cache.
 class cache_tracker final {
 public:
     using lru_type = bi::list<rows_entry,
@@ -222,6 +261,7 @@ class cache_tracker final {
         uint64_t reads_with_misses;
         uint64_t reads_done;
         uint64_t pinned_dirty_memory_overload;
+        uint64_t admission_rejections;
 
         uint64_t active_reads() const {
             return reads - reads_done;
@@ -232,28 +272,63 @@ class cache_tracker final {
     seastar::metrics::metric_groups _metrics;
     logalloc::region _region;
     lru_type _lru;
+    lru_type _probation_lru;
+    utils::frequency_sketch _sketch;
+    // Estimated frequency of the partition evicted last.
+    unsigned _victim_frequency = 0;
+    // Number of cached partitions of each table.
+    std::unordered_map<utils::UUID, uint64_t> _table_partitions;
+    double _table_quota_fraction = 0;
+    bool _compact_on_population = false;
     mutation_cleaner _garbage;
     mutation_cleaner _memtable_cleaner;
+    compressed_partition_cache _compressed_tier;
+    timer<lowres_clock> _demotion_timer;
+    uint64_t _partition_evictions_at_last_demotion = 0;
 private:
     void setup_metrics();
+    void record_access(const dht::decorated_key&) noexcept;
+    void account_partitions(const schema&, int64_t delta);
 public:
     cache_tracker(mutation_application_stats&);
     cache_tracker();
     ~cache_tracker();
     void clear();
-    void touch(rows_entry&);
-    void insert(cache_entry&);
-    void insert(partition_entry&) noexcept;
-    void insert(partition_version&) noexcept;
-    void insert(rows_entry&) noexcept;
+    // Moves the row to the front of the LRU. A reader linking rows into the
+    // main segment promotes probationary rows, otherwise the row stays
+    // in its segment.
+    void touch(rows_entry&, lru_segment = lru_segment::main);
+    void insert(cache_entry&, lru_segment = lru_segment::main);
+    void insert(partition_entry&, lru_segment = lru_segment::main) noexcept;
+    void insert(partition_version&, lru_segment = lru_segment::main) noexcept;
+    void insert(rows_entry&, lru_segment = lru_segment::main) noexcept;
+    // The segment into which a read populating the partition should link rows.
+    lru_segment segment_for(const schema&, const dht::decorated_key&, bool range_query) const noexcept;
+    // Returns true iff a partition missed by a range scan should be populated.
+    bool admit(const dht::decorated_key&) const noexcept;
+    // Estimated number of recent accesses to the partition.
+    unsigned estimate_frequency(const dht::decorated_key&) const noexcept;
+    // Sets the fraction of cached partitions above which a table is
+    // considered over its quota. Zero disables quotas.
+    void set_table_quota_fraction(double fraction) { _table_quota_fraction = fraction; }
+    // Returns true iff the table holds more than its share of the cache
+    // while other tables are cached too.
+    bool over_quota(const schema&) const noexcept;
+    // Whether rows populated from the underlying source are compacted
+    // (without purging tombstones) before they are inserted.
+    void set_compact_on_population(bool enabled) { _compact_on_population = enabled; }
+    bool compact_on_population() const noexcept { return _compact_on_population; }
+    // Number of cached partitions of the table.
+    uint64_t table_partitions(const schema&) const noexcept;
     void on_remove(rows_entry&) noexcept;
     void unlink(rows_entry&) noexcept;
     void clear_continuity(cache_entry& ce);
-    void on_partition_erase();
+    void on_partition_erase(const schema&);
     void on_partition_merge();
-    void on_partition_hit();
-    void on_partition_miss();
-    void on_partition_eviction();
+    void on_partition_hit(const dht::decorated_key&);
+    void on_partition_miss(const dht::decorated_key&);
+    void on_partition_eviction(const schema&, const dht::decorated_key&);
+    void on_admission_rejection();
     void on_row_eviction();
     void on_row_hit();
     void on_row_miss();
@@ -271,6 +346,14 @@ class cache_tracker final {
     uint64_t partitions() const { return _stats.partitions; }
     const stats& get_stats() const { return _stats; }
     void set_compaction_scheduling_group(seastar::scheduling_group);
+    // Sets the memory limit of the compressed tier. Zero disables it.
+    void set_compressed_tier_size(size_t bytes);
+    // Evicts from the cold end of the LRU, moving up to max_partitions
+    // complete partitions into the compressed tier. Runs periodically
+    // while the cache is evicting.
+    void demote_cold_partitions(size_t max_partitions) noexcept;
+    compressed_partition_cache& compressed_tier() { return _compressed_tier; }
+    const compressed_partition_cache& compressed_tier() const { return _compressed_tier; }
 };
 
 inline
@@ -280,23 +363,28 @@ void cache_tracker::on_remove(rows_entry& row) noexcept {
 }
 
 inline
-void cache_tracker::insert(rows_entry& entry) noexcept {
+void cache_tracker::insert(rows_entry& entry, lru_segment segment) noexcept {
     ++_stats.row_insertions;
     ++_stats.rows;
-    _lru.push_front(entry);
+    entry._flags._probationary = segment == lru_segment::probationary;
+    if (entry._flags._probationary) {
+        _probation_lru.push_front(entry);
+    } else {
+        _lru.push_front(entry);
+    }
 }
 
 inline
-void cache_tracker::insert(partition_version& pv) noexcept {
+void cache_tracker::insert(partition_version& pv, lru_segment segment) noexcept {
     for (rows_entry& row : pv.partition().clustered_rows()) {
-        insert(row);
+        insert(row, segment);
     }
 }
 
 inline
-void cache_tracker::insert(partition_entry& pe) noexcept {
+void cache_tracker::insert(partition_entry& pe, lru_segment segment) noexcept {
     for (partition_version& pv : pe.versions_from_oldest()) {
-        insert(pv);
+        insert(pv, segment);
     }
 }
 
@@ -315,10 +403,7 @@ void cache_tracker::insert(partition_entry& pe) noexcept {
 class row_cache final {
 public:
     using phase_type = utils::phased_barrier::phase_type;
-    using partitions_type = bi::set<cache_entry,
-        bi::member_hook<cache_entry, cache_entry::cache_link_type, &cache_entry::_cache_link>,
-        bi::constant_time_size<false>, // we need this to have bi::auto_unlink on hooks
-        bi::compare<cache_entry::compare>>;
+    using partitions_type = intrusive_b::keyed_tree<cache_entry, &cache_entry::_cache_link, cache_entry::token_of>;
     friend class cache::autoupdating_underlying_reader;
     friend class single_partition_populating_reader;
     friend class cache_entry;
@@ -390,8 +475,8 @@ class row_cache final {
     logalloc::allocating_section _read_section;
     flat_mutation_reader create_underlying_reader(cache::read_context&, mutation_source&, const dht::partition_range&);
     flat_mutation_reader make_scanning_reader(const dht::partition_range&, lw_shared_ptr<cache::read_context>);
-    void on_partition_hit();
-    void on_partition_miss();
+    void on_partition_hit(const dht::decorated_key&);
+    void on_partition_miss(const dht::decorated_key&);
     void on_row_hit();
     void on_row_miss();
     void on_static_row_insert();
@@ -399,6 +484,9 @@ class row_cache final {
     void upgrade_entry(cache_entry&);
     void invalidate_locked(const dht::decorated_key&);
     void invalidate_unwrapped(const dht::partition_range&);
+    // Moves the partition from the compressed tier into the cache, if it's
+    // there and not cached already.
+    void promote_from_compressed_tier(const dht::decorated_key&);
     void clear_now() noexcept;
 
     struct previous_entry_pointer {
@@ -427,7 +515,8 @@ class row_cache final {
     // The entry which is returned will have the tombstone applied to it.
     //
     // Must be run under reclaim lock
-    cache_entry& find_or_create(const dht::decorated_key& key, tombstone t, row_cache::phase_type phase, const previous_entry_pointer* previous = nullptr);
+    cache_entry& find_or_create(const dht::decorated_key& key, tombstone t, row_cache::phase_type phase, const previous_entry_pointer* previous = nullptr,
+                                lru_segment segment = lru_segment::main);
 
     partitions_type::iterator partitions_end() {
         return std::prev(_partitions.end());
@@ -490,13 +579,16 @@ class row_cache final {
     // User needs to ensure that the row_cache object stays alive
     // as long as the reader is used.
     // The range must not wrap around.
+    // The permit, if any, is passed to the readers of the underlying source
+    // created on misses.
     flat_mutation_reader make_reader(schema_ptr,
                                      const dht::partition_range&,
                                      const query::partition_slice&,
                                      const io_priority_class& = default_priority_class(),
                                      tracing::trace_state_ptr trace_state = nullptr,
                                      streamed_mutation::forwarding fwd = streamed_mutation::forwarding::no,
-                                     mutation_reader::forwarding fwd_mr = mutation_reader::forwarding::no);
+                                     mutation_reader::forwarding fwd_mr = mutation_reader::forwarding::no,
+                                     reader_permit permit = no_reader_permit());
 
     flat_mutation_reader make_reader(schema_ptr s, const dht::partition_range& range = query::full_partition_range) {
         auto& full_slice = s->full_slice();
@@ -550,6 +642,11 @@ class row_cache final {
     future<> invalidate(external_updater, const dht::partition_range& = query::full_partition_range);
     future<> invalidate(external_updater, dht::partition_range_vector&&);
 
+    // Returns the keys of up to n cached partitions which were accessed most
+    // often recently, the hottest first.
+    // Must be called in a seastar thread.
+    std::vector<dht::decorated_key> hottest_keys(size_t n);
+
     // Evicts entries from cache.
     //
     // Note that this does not synchronize with the underlying source,
@@ -558,7 +655,7 @@ class row_cache final {
     void evict();
 
     size_t partitions() const {
-        return _partitions.size();
+        return _partitions.calculate_size();
     }
     const cache_tracker& get_cache_tracker() const {
         return _tracker;
@@ -34,12 +34,14 @@
 #include <boost/range/algorithm.hpp>
 #include <boost/algorithm/cxx11/any_of.hpp>
 #include "view_info.hh"
+#include "clustering_position_encoder.hh"
 #include "partition_slice_builder.hh"
 #include "database.hh"
 #include "service/storage_service.hh"
 #include "dht/i_partitioner.hh"
 #include "dht/token-sharding.hh"
 #include "cdc/cdc_extension.hh"
+#include "db/per_partition_rate_limit_extension.hh"
 
 constexpr int32_t schema::NAME_LENGTH;
 
@@ -244,6 +246,11 @@ const std::vector<column_definition>& v3_columns::all_columns() const {
 void schema::rebuild() {
     _partition_key_type = make_lw_shared<compound_type<>>(get_column_types(partition_key_columns()));
     _clustering_key_type = make_lw_shared<compound_prefix>(get_column_types(clustering_key_columns()));
+    if (_clustering_key_type->types().empty()) {
+        _clustering_position_encoder = nullptr;
+    } else {
+        _clustering_position_encoder = ::clustering_position_encoder::make(_clustering_key_type->types());
+    }
     _clustering_key_size = column_offset(column_kind::static_column) - column_offset(column_kind::clustering_key);
     _regular_column_count = _raw._columns.size() - column_offset(column_kind::regular_column);
     _static_column_count = column_offset(column_kind::regular_column) - column_offset(column_kind::static_column);
@@ -1174,6 +1181,16 @@ const cdc::options& schema::cdc_options() const {
     return default_cdc_options;
 }
 
+const db::per_partition_rate_limit_options& schema::per_partition_rate_limit_options() const {
+    static const db::per_partition_rate_limit_options default_options;
+    const auto& schema_extensions = _raw._extensions;
+
+    if (auto it = schema_extensions.find(db::per_partition_rate_limit_extension::NAME); it != schema_extensions.end()) {
+        return dynamic_pointer_cast<db::per_partition_rate_limit_extension>(it->second)->get_options();
+    }
+    return default_options;
+}
+
 schema_ptr schema_builder::build(compact_storage cp) {
     return with(cp).build();
 }
@@ -43,6 +43,7 @@
 #include "caching_options.hh"
 #include "column_computation.hh"
 #include "cdc/cdc_options.hh"
+#include "db/per_partition_rate_limit_options.hh"
 
 namespace dht {
 
@@ -173,14 +174,18 @@ inline cf_type sstring_to_cf_type(sstring name) {
 }
 
 struct speculative_retry {
+    // MIN speculates after the lower of a percentile of the latency (the
+    // value) and a fixed time in milliseconds (the cap).
     enum class type {
-        NONE, CUSTOM, PERCENTILE, ALWAYS
+        NONE, CUSTOM, PERCENTILE, ALWAYS, MIN
     };
 private:
     type _t;
     double _v;
+    double _cap_ms = 0;
 public:
     speculative_retry(type t, double v) : _t(t), _v(v) {}
+    speculative_retry(type t, double v, double cap_ms) : _t(t), _v(v), _cap_ms(cap_ms) {}
 
     sstring to_sstring() const {
         if (_t == type::NONE) {
@@ -191,6 +196,8 @@ struct speculative_retry {
             return format("{:.2f}ms", _v);
         } else if (_t == type::PERCENTILE) {
             return format("{:.1f}PERCENTILE", 100 * _v);
+        } else if (_t == type::MIN) {
+            return format("MIN({:.1f}PERCENTILE,{:.2f}ms)", 100 * _v, _cap_ms);
         } else {
             throw std::invalid_argument(format("unknown type: {:d}\n", uint8_t(_t)));
         }
@@ -211,6 +218,25 @@ struct speculative_retry {
 
         type t;
         double v = 0;
+        sstring min_prefix("MIN(");
+        if (str.size() > min_prefix.size() && str.compare(0, min_prefix.size(), min_prefix) == 0 && str.back() == ')') {
+            // MIN(<percentile>,<time>), in either order.
+            str.erase(std::remove(str.begin(), str.end(), ' '), str.end());
+            auto args = str.substr(min_prefix.size(), str.size() - min_prefix.size() - 1);
+            auto comma = args.find(',');
+            if (comma == sstring::npos) {
+                throw std::invalid_argument(format("cannot convert {} to speculative_retry\n", str));
+            }
+            auto first = from_sstring(args.substr(0, comma));
+            auto second = from_sstring(args.substr(comma + 1));
+            if (first.get_type() == type::CUSTOM) {
+                std::swap(first, second);
+            }
+            if (first.get_type() != type::PERCENTILE || second.get_type() != type::CUSTOM) {
+                throw std::invalid_argument(format("cannot convert {} to speculative_retry: MIN requires a percentile and a time\n", str));
+            }
+            return speculative_retry(type::MIN, first.get_value(), second.get_value());
+        }
         if (str == "NONE") {
             t = type::NONE;
         } else if (str == "ALWAYS") {
@@ -232,8 +258,11 @@ struct speculative_retry {
     double get_value() const {
         return _v;
     }
+    double get_cap_ms() const {
+        return _cap_ms;
+    }
     bool operator==(const speculative_retry& other) const {
-        return _t == other._t && _v == other._v;
+        return _t == other._t && _v == other._v && _cap_ms == other._cap_ms;
     }
     bool operator!=(const speculative_retry& other) const {
         return !(*this == other);
@@ -517,6 +546,7 @@ bool operator==(const raw_view_info&, const raw_view_info&);
 std::ostream& operator<<(std::ostream& os, const raw_view_info& view);
 
 class view_info;
+class clustering_position_encoder;
 
 // Represents a column set which is compactible with Cassandra 3.x.
 //
@@ -656,6 +686,7 @@ class schema final : public enable_lw_shared_from_this<schema> {
     std::unordered_map<bytes, const column_definition*> _columns_by_name;
     lw_shared_ptr<compound_type<allow_prefixes::no>> _partition_key_type;
     lw_shared_ptr<compound_type<allow_prefixes::yes>> _clustering_key_type;
+    std::unique_ptr<const ::clustering_position_encoder> _clustering_position_encoder;
     column_mapping _column_mapping;
     shared_ptr<query::partition_slice> _full_slice;
     column_count_type _clustering_key_size;
@@ -810,6 +841,8 @@ class schema final : public enable_lw_shared_from_this<schema> {
 
     const cdc::options& cdc_options() const;
 
+    const db::per_partition_rate_limit_options& per_partition_rate_limit_options() const;
+
     const ::speculative_retry& speculative_retry() const {
         return _raw._speculative_retry;
     }
@@ -903,6 +936,11 @@ class schema final : public enable_lw_shared_from_this<schema> {
     const lw_shared_ptr<compound_type<allow_prefixes::yes>>& clustering_key_prefix_type() const {
         return _clustering_key_type;
     }
+    // Byte-comparable encoder of clustering positions, or nullptr if some
+    // of the clustering columns have no byte-comparable encoding.
+    const ::clustering_position_encoder* clustering_position_encoder() const {
+        return _clustering_position_encoder.get();
+    }
     const data_type& regular_column_name_type() const {
         return _raw._regular_column_name_type;
     }
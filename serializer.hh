@@ -238,6 +238,11 @@ inline void serialize(Output& out, const std::reference_wrapper<T> v) {
     serializer<T>::write(out, v.get());
 }
 
+template<typename T, typename Output>
+inline void serialize(Output& out, const std::reference_wrapper<const T> v) {
+    serializer<T>::write(out, v.get());
+}
+
 template<typename T, typename Input>
 inline auto deserialize(Input& in, boost::type<T> t) {
     return serializer<T>::read(in);
@@ -286,6 +291,99 @@ void serialize(Output& out, const unknown_variant_type& v);
 template<typename Input>
 unknown_variant_type deserialize(Input& in, boost::type<unknown_variant_type>);
 
+/// A lazily deserialized vector of IDL-serialised elements
+///
+/// Views of IDL types return their vector members as vector_deserializer,
+/// which deserializes the elements one at a time as they are iterated instead
+/// of collecting them into a std::vector. Like the views themselves, it
+/// remains valid as long as the underlying IDL-serialised buffer is alive.
+template<typename T>
+class vector_deserializer {
+public:
+    using value_type = T;
+    using reference = decltype(deserialize(std::declval<utils::input_stream&>(), boost::type<T>()));
+private:
+    // The serialized elements, without the element count.
+    utils::input_stream _in;
+    size_t _size;
+public:
+    class iterator {
+        utils::input_stream _in;
+        size_t _idx;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = typename vector_deserializer::reference;
+
+        iterator(utils::input_stream in, size_t idx) : _in(std::move(in)), _idx(idx) { }
+
+        reference operator*() const {
+            return seastar::with_serialized_stream(_in, [] (auto& v) -> reference {
+                auto in = v;
+                return deserialize(in, boost::type<T>());
+            });
+        }
+        iterator& operator++() {
+            seastar::with_serialized_stream(_in, [] (auto& v) {
+                skip(v, boost::type<T>());
+            });
+            ++_idx;
+            return *this;
+        }
+        iterator operator++(int) {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const iterator& o) const { return _idx == o._idx; }
+        bool operator!=(const iterator& o) const { return _idx != o._idx; }
+    };
+    using const_iterator = iterator;
+
+    vector_deserializer(utils::input_stream in, size_t size) : _in(std::move(in)), _size(size) { }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    iterator begin() const { return iterator(_in, 0); }
+    // Iterators compare by position only, so the end iterator needs no stream.
+    iterator end() const { return iterator(_in, _size); }
+
+    reference front() const { return *begin(); }
+    // Linear in the number of elements.
+    reference back() const { return *std::next(begin(), _size - 1); }
+    reference operator[](size_t i) const { return *std::next(begin(), i); }
+
+    operator std::vector<T>() const {
+        std::vector<T> v;
+        v.reserve(_size);
+        for (auto&& e : *this) {
+            v.emplace_back(e);
+        }
+        return v;
+    }
+};
+
+/// An IDL-serialised object kept in its serialised form
+///
+/// Deserializing an owning type allocates each of its members and elements.
+/// A receiver that only walks the object can instead keep a copy of its
+/// serialised form, which takes about one allocation per fragment of the
+/// input, and read it through View, e.g. a view or a vector_deserializer of
+/// views. frozen_view is serialised exactly like the object it holds, so the
+/// sender may keep serialising the owning type.
+template<typename View>
+class frozen_view {
+    bytes_ostream _bytes;
+public:
+    explicit frozen_view(bytes_ostream bytes) : _bytes(std::move(bytes)) { }
+
+    const bytes_ostream& representation() const { return _bytes; }
+    // Valid as long as this frozen_view is alive.
+    View view() const;
+};
+
 template <typename T>
 struct normalize {
     using type = T;
@@ -290,6 +290,55 @@ struct serializer<utils::small_vector<T, N>>
     : idl::serializers::internal::vector_serializer<utils::small_vector<T, N>>
 { };
 
+template<typename T>
+struct serializer<vector_deserializer<T>> {
+    template<typename Input>
+    static vector_deserializer<T> read(Input& in) {
+        return seastar::with_serialized_stream(in, [] (auto& in) -> vector_deserializer<T> {
+            auto sz = deserialize(in, boost::type<uint32_t>());
+            auto start = in;
+            skip_array<T>(in, sz);
+            return vector_deserializer<T>(start.read_substream(start.size() - in.size()), sz);
+        });
+    }
+    template<typename Output>
+    static void write(Output& out, const vector_deserializer<T>& v) {
+        safe_serialize_as_uint32(out, v.size());
+        for (auto&& e : v) {
+            serialize(out, e);
+        }
+    }
+    template<typename Input>
+    static void skip(Input& in) {
+        auto sz = deserialize(in, boost::type<uint32_t>());
+        skip_array<T>(in, sz);
+    }
+};
+
+template<typename View>
+struct serializer<frozen_view<View>> {
+    template<typename Input>
+    static frozen_view<View> read(Input& in) {
+        return seastar::with_serialized_stream(in, [] (auto& in) -> frozen_view<View> {
+            auto start = in;
+            ser::skip(in, boost::type<View>());
+            bytes_ostream bytes;
+            start.read_substream(start.size() - in.size()).copy_to(bytes);
+            return frozen_view<View>(std::move(bytes));
+        });
+    }
+    template<typename Output>
+    static void write(Output& out, const frozen_view<View>& v) {
+        for (bytes_view frag : v.representation().fragments()) {
+            out.write(reinterpret_cast<const char*>(frag.begin()), frag.size());
+        }
+    }
+    template<typename Input>
+    static void skip(Input& in) {
+        ser::skip(in, boost::type<View>());
+    }
+};
+
 template<typename T, typename Ratio>
 struct serializer<std::chrono::duration<T, Ratio>> {
     template<typename Input>
@@ -437,6 +486,11 @@ class deserialized_bytes_proxy {
     deserialized_bytes_proxy(deserialized_bytes_proxy<OtherStream> proxy)
         : _stream(std::move(proxy._stream)) { }
 
+    // The serialised bytes, for reading IDL objects they hold in place.
+    const Stream& stream() const {
+        return _stream;
+    }
+
     auto view() const {
       if constexpr (std::is_same_v<Stream, simple_input_stream>) {
         return bytes_view(reinterpret_cast<const int8_t*>(_stream.begin()), _stream.size());
@@ -670,6 +724,12 @@ utils::input_stream as_input_stream(const bytes_ostream& b) {
     return utils::input_stream::fragmented(b.fragments().begin(), b.size());
 }
 
+template<typename View>
+View frozen_view<View>::view() const {
+    auto in = as_input_stream(_bytes);
+    return deserialize(in, boost::type<View>());
+}
+
 template<typename Output, typename ...T>
 void serialize(Output& out, const boost::variant<T...>& v) {}
 
@@ -86,7 +86,7 @@ class client_state {
 private:
     client_state(const client_state* cs, seastar::sharded<auth::service>* auth_service)
             : _keyspace(cs->_keyspace),  _user(cs->_user), _auth_state(cs->_auth_state),
-              _is_internal(cs->_is_internal), _is_thrift(cs->_is_thrift), _remote_address(cs->_remote_address),
+              _is_internal(cs->_is_internal), _is_thrift(cs->_is_thrift), _use_metadata_id(cs->_use_metadata_id), _remote_address(cs->_remote_address),
               _auth_service(auth_service ? &auth_service->local() : nullptr) {}
     friend client_state_for_another_shard;
 private:
@@ -121,6 +121,8 @@ class client_state {
     // that should have an ability to modify system keyspace.
     bool _is_internal;
     bool _is_thrift;
+    // Set when the CQL client negotiated the SCYLLA_USE_METADATA_ID extension.
+    bool _use_metadata_id = false;
 
     // The biggest timestamp that was returned by getTimestamp/assigned to a query
     static thread_local api::timestamp_type _last_timestamp_micros;
@@ -185,6 +187,14 @@ class client_state {
         return _is_internal;
     }
 
+    bool use_metadata_id() const {
+        return _use_metadata_id;
+    }
+
+    void set_use_metadata_id() {
+        _use_metadata_id = true;
+    }
+
     /**
      * @return a ClientState object for internal C* calls (not limited by any kind of auth).
      */
@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/irange.hpp>
+#include <seastar/core/thread.hh>
+
+#include "service/forward_service.hh"
+#include "service/storage_proxy.hh"
+#include "service/pager/query_pagers.hh"
+#include "service/pager/query_pager.hh"
+#include "service/query_state.hh"
+#include "service/client_state.hh"
+#include "cql3/selection/selection.hh"
+#include "cql3/result_set.hh"
+#include "cql3/query_options.hh"
+#include "cql3/stats.hh"
+#include "cql3/functions/functions.hh"
+#include "cql3/functions/aggregate_fcts.hh"
+#include "db/marshal/type_parser.hh"
+#include "message/messaging_service.hh"
+#include "gms/gossiper.hh"
+#include "locator/snitch_base.hh"
+#include "utils/fb_utilities.hh"
+#include "timeout_config.hh"
+#include "database.hh"
+#include "log.hh"
+
+namespace service {
+
+static logging::logger flogger("forward_service");
+
+// The ranges sent to a node are split into this many groups, each read by
+// its own pager.
+static constexpr size_t forward_request_concurrency = 8;
+
+// The pagers of forward requests never filter, so their statistics would
+// stay empty anyway.
+static thread_local cql3::cql_stats forward_stats;
+
+using aggregate_functions = std::vector<shared_ptr<cql3::functions::aggregate_function>>;
+
+static const dht::token& end_token(const dht::partition_range& r) {
+    static const dht::token max_token = dht::maximum_token();
+    return r.end() ? r.end()->value().token() : max_token;
+}
+
+// Returns the function of a call, or null for a plain column.
+static shared_ptr<cql3::functions::aggregate_function> resolve_aggregate(const query::aggregate_call& call) {
+    using namespace cql3::functions;
+    if (call.function_name.empty()) {
+        if (call.arguments.size() != 1) {
+            throw std::runtime_error(format("plain column in forward request has {} arguments", call.arguments.size()));
+        }
+        return nullptr;
+    }
+    auto name = function_name(call.function_keyspace, call.function_name);
+    auto arg_types = boost::copy_range<std::vector<data_type>>(call.argument_types | boost::adaptors::transformed([] (const sstring& type) {
+        return db::marshal::type_parser::parse(type);
+    }));
+    auto fun = functions::find(name, arg_types);
+    if (!fun && arg_types.size() == 1
+            && (arg_types[0]->is_collection() || arg_types[0]->is_tuple() || arg_types[0]->is_user_type())) {
+        // min() and max() of compound types are created on demand, see functions::get().
+        if (name == function_name::native_function("min")) {
+            fun = aggregate_fcts::make_min_dynamic_function(arg_types[0]);
+        } else if (name == function_name::native_function("max")) {
+            fun = aggregate_fcts::make_max_dynamic_function(arg_types[0]);
+        }
+    }
+    auto agg = dynamic_pointer_cast<aggregate_function>(fun);
+    if (!agg || !agg->is_reducible() || arg_types.size() != call.arguments.size()) {
+        throw std::runtime_error(format("{} is not a reducible aggregate function", name));
+    }
+    return agg;
+}
+
+static aggregate_functions resolve_aggregates(const query::forward_request& req) {
+    return boost::copy_range<aggregate_functions>(req.calls | boost::adaptors::transformed(resolve_aggregate));
+}
+
+// User defined aggregates run in a thread, like in
+// result_set_builder::with_thread_if_needed().
+template <typename Func>
+static auto with_thread_if_needed(const aggregate_functions& functions, Func&& func) {
+    if (boost::algorithm::any_of(functions, [] (const auto& f) { return f && f->requires_thread(); })) {
+        return seastar::async(std::move(func));
+    }
+    return futurize_invoke(std::move(func));
+}
+
+namespace {
+
+// The calls of a request over the rows of one group. A plain column yields
+// its first value, like simple_selector does.
+class group_aggregates {
+    std::vector<std::unique_ptr<cql3::functions::aggregate_function::aggregate>> _aggregates;
+    std::vector<bytes_opt> _values;
+    std::vector<bytes_opt> _args;
+    cql_serialization_format _sf;
+    bool _empty = true;
+public:
+    group_aggregates(const aggregate_functions& functions, cql_serialization_format sf)
+        : _values(functions.size())
+        , _sf(sf)
+    {
+        _aggregates.reserve(functions.size());
+        for (auto& f : functions) {
+            _aggregates.push_back(f ? f->new_aggregate() : nullptr);
+            if (_aggregates.back()) {
+                _aggregates.back()->reset();
+            }
+        }
+    }
+
+    void add_row(const query::forward_request& req, const std::vector<bytes_opt>& row) {
+        for (size_t i = 0; i < _aggregates.size(); ++i) {
+            auto& arguments = req.calls[i].arguments;
+            if (!_aggregates[i]) {
+                if (_empty) {
+                    _values[i] = row.at(arguments.front());
+                }
+                continue;
+            }
+            _args.resize(arguments.size());
+            auto& constants = req.calls[i].constants;
+            for (size_t j = 0; j < arguments.size(); ++j) {
+                _args[j] = j < constants.size() && constants[j] ? constants[j] : row.at(arguments[j]);
+            }
+            _aggregates[i]->add_input(_sf, _args);
+        }
+        _empty = false;
+    }
+
+    void merge(const std::vector<bytes_opt>& states) {
+        if (states.size() != _aggregates.size()) {
+            throw std::runtime_error(format("partial aggregates have {} states, expected {}", states.size(), _aggregates.size()));
+        }
+        for (size_t i = 0; i < _aggregates.size(); ++i) {
+            if (!_aggregates[i]) {
+                if (_empty) {
+                    _values[i] = states[i];
+                }
+                continue;
+            }
+            _aggregates[i]->merge_state(_sf, states[i]);
+        }
+        _empty = false;
+    }
+
+    std::vector<bytes_opt> get_states() {
+        std::vector<bytes_opt> ret;
+        ret.reserve(_aggregates.size());
+        for (size_t i = 0; i < _aggregates.size(); ++i) {
+            ret.push_back(_aggregates[i] ? _aggregates[i]->get_state(_sf) : std::move(_values[i]));
+        }
+        return ret;
+    }
+
+    std::vector<bytes_opt> compute() {
+        std::vector<bytes_opt> ret;
+        ret.reserve(_aggregates.size());
+        for (size_t i = 0; i < _aggregates.size(); ++i) {
+            ret.push_back(_aggregates[i] ? _aggregates[i]->compute(_sf) : std::move(_values[i]));
+        }
+        return ret;
+    }
+};
+
+// Splits rows, or the groups of partial results, into groups of consecutive
+// entries with equal GROUP BY cells, like result_set_builder does. One
+// instance sees all pages of a pager, so a group cut by a page boundary
+// carries on with the next page; the same goes for the partial results of
+// one group coming from several pagers or replicas, once they are adjacent.
+class grouped_aggregates {
+    const query::forward_request& _req;
+    const aggregate_functions& _functions;
+    std::optional<group_aggregates> _current;
+    std::vector<bytes_opt> _key;
+    query::forward_result _result;
+
+    void close_group() {
+        if (_current) {
+            _result.groups.push_back(query::partial_aggregates{std::move(_key), _current->get_states()});
+            _current.reset();
+        }
+    }
+
+    group_aggregates& group(std::vector<bytes_opt> key) {
+        if (_current && key != _key) {
+            close_group();
+        }
+        if (!_current) {
+            _current.emplace(_functions, _req.cmd.slice.cql_format());
+            _key = std::move(key);
+        }
+        return *_current;
+    }
+public:
+    grouped_aggregates(const query::forward_request& req, const aggregate_functions& functions)
+        : _req(req)
+        , _functions(functions)
+    { }
+
+    void add_row(const std::vector<bytes_opt>& row) {
+        auto key = boost::copy_range<std::vector<bytes_opt>>(_req.group_by | boost::adaptors::transformed([&row] (uint32_t i) {
+            return row.at(i);
+        }));
+        group(std::move(key)).add_row(_req, row);
+    }
+
+    void merge(query::partial_aggregates partial) {
+        group(std::move(partial.key)).merge(partial.states);
+    }
+
+    query::forward_result finish() && {
+        close_group();
+        return std::move(_result);
+    }
+};
+
+}
+
+// Merges the partial results of disjoint parts of the same request. With
+// GROUP BY, the groups are ordered by the partition key, which the first
+// cells of their keys hold; the groups of a partition all come from the
+// same result, in order, and keep it. The stable sort keeps any partials
+// of one group adjacent, so they are merged into one group.
+static query::forward_result merge_forward_results(const schema& s, const query::forward_request& req,
+        const aggregate_functions& functions, std::vector<query::forward_result> results) {
+    std::vector<query::partial_aggregates> groups;
+    for (auto& r : results) {
+        std::move(r.groups.begin(), r.groups.end(), std::back_inserter(groups));
+    }
+    if (!req.group_by.empty() && results.size() > 1) {
+        std::vector<std::pair<dht::decorated_key, size_t>> keys;
+        keys.reserve(groups.size());
+        for (size_t i = 0; i < groups.size(); ++i) {
+            auto& key = groups[i].key;
+            std::vector<bytes> components;
+            components.reserve(s.partition_key_size());
+            for (size_t j = 0; j < s.partition_key_size(); ++j) {
+                components.push_back(key.at(j).value());
+            }
+            keys.emplace_back(dht::decorate_key(s, partition_key::from_exploded(s, components)), i);
+        }
+        std::stable_sort(keys.begin(), keys.end(), [&s] (const auto& a, const auto& b) {
+            return a.first.less_compare(s, b.first);
+        });
+        groups = boost::copy_range<std::vector<query::partial_aggregates>>(keys | boost::adaptors::transformed([&groups] (const auto& k) {
+            return std::move(groups[k.second]);
+        }));
+    }
+    grouped_aggregates merged(req, functions);
+    for (auto& g : groups) {
+        merged.merge(std::move(g));
+    }
+    return std::move(merged).finish();
+}
+
+future<query::forward_result> execute_forward_request(storage_proxy& proxy, schema_ptr schema,
+        const query::forward_request& req, db::timeout_clock::time_point timeout, tracing::trace_state_ptr trace_state) {
+    std::vector<const column_definition*> columns;
+    columns.reserve(req.columns.size());
+    for (auto& name : req.columns) {
+        auto def = schema->get_column_definition(to_bytes(name));
+        if (!def) {
+            throw std::runtime_error(format("forward request for {}.{} reads unknown column {}", schema->ks_name(), schema->cf_name(), name));
+        }
+        columns.push_back(def);
+    }
+    auto selection = cql3::selection::selection::for_columns(schema, std::move(columns));
+    auto slices = std::min(req.ranges.size(), forward_request_concurrency);
+    return do_with(service::query_state(service::client_state::for_internal_calls(), std::move(trace_state), empty_service_permit()),
+            cql3::query_options(req.cl, infinite_timeout_config, std::vector<cql3::raw_value>{}),
+            resolve_aggregates(req), std::vector<query::forward_result>(slices),
+            [&req, schema, selection, timeout, slices] (service::query_state& state, cql3::query_options& options,
+                    aggregate_functions& functions, std::vector<query::forward_result>& results) {
+        return parallel_for_each(boost::irange(size_t(0), slices), [&, schema, selection, timeout, slices] (size_t i) {
+            auto begin = req.ranges.begin() + i * req.ranges.size() / slices;
+            auto end = req.ranges.begin() + (i + 1) * req.ranges.size() / slices;
+            auto p = pager::query_pagers::pager(schema, selection, state, options,
+                    make_lw_shared<query::read_command>(req.cmd), dht::partition_range_vector(begin, end), forward_stats);
+            return do_with(grouped_aggregates(req, functions), [&req, &functions, &results, p, timeout, i] (grouped_aggregates& groups) {
+                return do_until([p] { return p->is_exhausted(); }, [&req, &functions, &groups, p, timeout] {
+                    return p->fetch_page(req.page_size, req.cmd.timestamp, timeout).then([&functions, &groups] (std::unique_ptr<cql3::result_set> rs) {
+                        return with_thread_if_needed(functions, [&groups, rs = std::move(rs)] {
+                            for (auto& row : rs->rows()) {
+                                groups.add_row(row);
+                            }
+                        });
+                    });
+                }).then([&groups, &results, i] {
+                    results[i] = std::move(groups).finish();
+                });
+            });
+        }).then([&req, &functions, &results, schema] {
+            return with_thread_if_needed(functions, [&req, &functions, &results, schema] {
+                return merge_forward_results(*schema, req, functions, std::move(results));
+            });
+        });
+    });
+}
+
+future<std::vector<std::vector<bytes_opt>>> dispatch_forward_request(storage_proxy& proxy, schema_ptr schema,
+        query::forward_request req, db::timeout_clock::time_point timeout, tracing::trace_state_ptr trace_state) {
+    auto& ks = proxy.get_db().local().find_keyspace(schema->ks_name());
+    auto& rs = ks.get_replication_strategy();
+    auto local = rs.get_type() == locator::replication_strategy_type::local;
+    query_ranges_to_vnodes_generator ranges_to_vnodes(proxy.get_token_metadata(), schema, std::move(req.ranges), local);
+    req.ranges = {};
+
+    // Each vnode goes to one of its live replicas, preferring the replicas
+    // in this datacenter, then those with the fewest vnodes so far, then
+    // this node. Without a live replica, this node reads the vnode and
+    // fails the way any read at the consistency level would.
+    auto me = utils::fb_utilities::get_broadcast_address();
+    auto& snitch = locator::i_endpoint_snitch::get_local_snitch_ptr();
+    auto my_dc = snitch->get_datacenter(me);
+    std::vector<gms::inet_address> endpoints;
+    std::unordered_map<gms::inet_address, dht::partition_range_vector> ranges;
+    auto assigned = [&ranges] (gms::inet_address ep) {
+        auto it = ranges.find(ep);
+        return it == ranges.end() ? 0 : it->second.size();
+    };
+    while (!ranges_to_vnodes.empty()) {
+        for (auto& vnode : ranges_to_vnodes(1024)) {
+            auto target = me;
+            if (!local) {
+                std::optional<std::tuple<bool, size_t, bool>> best;
+                for (auto& ep : rs.get_natural_endpoints(end_token(vnode))) {
+                    if (!gms::get_local_gossiper().is_alive(ep)) {
+                        continue;
+                    }
+                    auto rank = std::make_tuple(snitch->get_datacenter(ep) != my_dc, assigned(ep), ep != me);
+                    if (!best || rank < *best) {
+                        best = rank;
+                        target = ep;
+                    }
+                }
+            }
+            auto& target_ranges = ranges[target];
+            if (target_ranges.empty()) {
+                endpoints.push_back(target);
+            }
+            target_ranges.push_back(std::move(vnode));
+        }
+    }
+
+    // Resolved before sending, so that a request the replicas can't run
+    // fails here.
+    auto functions = resolve_aggregates(req);
+    return do_with(std::move(req), std::move(functions), std::move(ranges), std::move(endpoints), std::vector<query::forward_result>(),
+            [&proxy, schema, timeout, trace_state = std::move(trace_state)] (query::forward_request& req, aggregate_functions& functions,
+                    std::unordered_map<gms::inet_address, dht::partition_range_vector>& ranges, std::vector<gms::inet_address>& endpoints,
+                    std::vector<query::forward_result>& results) {
+        results.resize(endpoints.size());
+        return parallel_for_each(boost::irange(size_t(0), endpoints.size()), [&, schema, timeout, trace_state] (size_t i) {
+            auto ep = endpoints[i];
+            auto sub = make_lw_shared<query::forward_request>(req);
+            sub->ranges = std::move(ranges[ep]);
+            auto execute_locally = [&proxy, &results, schema, sub, timeout, trace_state, i] {
+                return execute_forward_request(proxy, schema, *sub, timeout, trace_state).then([&results, sub, i] (query::forward_result r) {
+                    results[i] = std::move(r);
+                });
+            };
+            if (ep == utils::fb_utilities::get_broadcast_address()) {
+                return execute_locally();
+            }
+            tracing::trace(trace_state, "Sending forward request for {} ranges to /{}", sub->ranges.size(), ep);
+            return netw::get_local_messaging_service().send_forward_request(netw::msg_addr{ep, 0}, timeout, *sub).then_wrapped(
+                    [&results, ep, timeout, trace_state, execute_locally = std::move(execute_locally), sub, i] (future<query::forward_result> f) {
+                try {
+                    results[i] = f.get0();
+                    return make_ready_future<>();
+                } catch (...) {
+                    if (db::timeout_clock::now() >= timeout) {
+                        throw;
+                    }
+                    flogger.warn("Forward request to {} failed, aggregating its ranges locally: {}", ep, std::current_exception());
+                    tracing::trace(trace_state, "Forward request to /{} failed, aggregating its ranges locally", ep);
+                    return execute_locally();
+                }
+            });
+        }).then([&req, &functions, &results, schema] {
+            return with_thread_if_needed(functions, [&req, &functions, &results, schema] {
+                auto merged = merge_forward_results(*schema, req, functions, std::move(results));
+                return boost::copy_range<std::vector<std::vector<bytes_opt>>>(merged.groups | boost::adaptors::transformed([&] (const query::partial_aggregates& g) {
+                    group_aggregates aggregates(functions, req.cmd.slice.cql_format());
+                    aggregates.merge(g.states);
+                    return aggregates.compute();
+                }));
+            });
+        });
+    });
+}
+
+}
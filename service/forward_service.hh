@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "query-request.hh"
+#include "db/timeout_clock.hh"
+#include "tracing/trace_state.hh"
+
+namespace service {
+
+class storage_proxy;
+
+// Replica-side partial aggregation.
+//
+// The coordinator of an aggregate query splits its token ranges at vnode
+// boundaries and sends each vnode to one of its live replicas in a
+// FORWARD_REQUEST. The replica reads its vnodes as a coordinator, at the
+// consistency level of the query, which with ONE or LOCAL_ONE means from
+// its own shards, and returns the states of the aggregates of each group
+// rather than the rows. The coordinator merges the states and computes the
+// final values.
+
+// Computes the partial aggregates of a request on this node. The request
+// must stay alive until the returned future resolves.
+future<query::forward_result> execute_forward_request(storage_proxy& proxy, schema_ptr schema,
+        const query::forward_request& req, db::timeout_clock::time_point timeout, tracing::trace_state_ptr trace_state);
+
+// Distributes the request over the replicas of its ranges and returns the
+// final values of its calls for each group, in ring order. Without GROUP BY
+// there is at most one group, and none when no rows were read. The ranges
+// of a replica which fails the request are computed on this node.
+future<std::vector<std::vector<bytes_opt>>> dispatch_forward_request(storage_proxy& proxy, schema_ptr schema,
+        query::forward_request req, db::timeout_clock::time_point timeout, tracing::trace_state_ptr trace_state);
+
+}
@@ -75,6 +75,7 @@ future<> migration_manager::stop()
     if (!_cluster_upgraded) {
         _wait_cluster_upgraded.broken();
     }
+    _gossip_schema_pulls.broken();
 
   return uninit_messaging_service().then([this] {
     return parallel_for_each(_schema_pulls.begin(), _schema_pulls.end(), [] (auto&& e) {
@@ -101,6 +102,7 @@ void migration_manager::init_messaging_service()
         _feature_listeners.push_back(_feat.cluster_supports_digest_insensitive_to_expiry().when_enabled(update_schema));
         _feature_listeners.push_back(_feat.cluster_supports_cdc().when_enabled(update_schema));
         _feature_listeners.push_back(_feat.cluster_supports_per_table_partitioners().when_enabled(update_schema));
+        _feature_listeners.push_back(_feat.cluster_supports_parallelized_aggregation().when_enabled(update_schema));
     }
     _feature_listeners.push_back(_feat.cluster_supports_schema_tables_v3().when_enabled([this] {
         _cluster_upgraded = true;
@@ -247,7 +249,7 @@ future<> migration_manager::maybe_schedule_schema_pull(const utils::UUID& their_
     if (db.get_version() == database::empty_version || runtime::get_uptime() < migration_delay) {
         // If we think we may be bootstrapping or have recently started, submit MigrationTask immediately
         mlogger.debug("Submitting migration task for {}", endpoint);
-        return submit_migration_task(endpoint);
+        return submit_coalesced_migration_task(endpoint);
     }
 
     return with_gate(_background_tasks, [this, &db, endpoint] {
@@ -272,7 +274,7 @@ future<> migration_manager::maybe_schedule_schema_pull(const utils::UUID& their_
                 return make_ready_future<>();
             }
             mlogger.debug("submitting migration task for {}", endpoint);
-            return submit_migration_task(endpoint);
+            return submit_coalesced_migration_task(endpoint);
         });
     }).finally([me = shared_from_this()] {});
 }
@@ -282,6 +284,19 @@ future<> migration_manager::submit_migration_task(const gms::inet_address& endpo
     return service::migration_task::run_may_throw(endpoint, can_ignore_down_node);
 }
 
+future<> migration_manager::submit_coalesced_migration_task(const gms::inet_address& endpoint)
+{
+    return with_semaphore(_gossip_schema_pulls, 1, [this, endpoint] {
+        auto& db = get_local_storage_proxy().get_db().local();
+        const auto* value = gms::get_local_gossiper().get_application_state_ptr(endpoint, gms::application_state::SCHEMA);
+        if (value && db.get_version() == utils::UUID{value->value}) {
+            mlogger.debug("Not pulling schema from {}, versions match after an earlier pull", endpoint);
+            return make_ready_future<>();
+        }
+        return submit_migration_task(endpoint);
+    });
+}
+
 future<> migration_manager::do_merge_schema_from(netw::messaging_service::msg_addr id)
 {
     auto& ms = netw::get_local_messaging_service();
@@ -741,14 +756,22 @@ future<> migration_manager::announce_function_drop(
     return include_keyspace_and_announce(*keyspace.metadata(), std::move(mutations), announce_locally);
 }
 
-#if 0
-public static void announceNewAggregate(UDAggregate udf, boolean announceLocally)
-{
-    mlogger.info(String.format("Create aggregate function '%s'", udf.name()));
-    KSMetaData ksm = Schema.instance.getKSMetaData(udf.name().keyspace);
-    announce(LegacySchemaTables.makeCreateAggregateMutation(ksm, udf, FBUtilities.timestampMicros()), announceLocally);
+future<> migration_manager::announce_new_aggregate(shared_ptr<cql3::functions::user_aggregate> aggregate, bool announce_locally) {
+    auto& db = get_local_storage_proxy().get_db().local();
+    auto&& keyspace = db.find_keyspace(aggregate->name().keyspace);
+    auto mutations = db::schema_tables::make_create_aggregate_mutations(_feat.cluster_schema_features(), aggregate, api::new_timestamp());
+    return include_keyspace_and_announce(*keyspace.metadata(), std::move(mutations), announce_locally);
+}
+
+future<> migration_manager::announce_aggregate_drop(
+        shared_ptr<cql3::functions::user_aggregate> aggregate, bool announce_locally) {
+    auto& db = get_local_storage_proxy().get_db().local();
+    auto&& keyspace = db.find_keyspace(aggregate->name().keyspace);
+    auto mutations = db::schema_tables::make_drop_aggregate_mutations(_feat.cluster_schema_features(), aggregate, api::new_timestamp());
+    return include_keyspace_and_announce(*keyspace.metadata(), std::move(mutations), announce_locally);
 }
 
+#if 0
 public static void announceKeyspaceUpdate(KSMetaData ksm) throws ConfigurationException
 {
     announceKeyspaceUpdate(ksm, false);
@@ -930,15 +953,6 @@ future<> migration_manager::announce_view_drop(const sstring& ks_name,
     }
 }
 
-#if 0
-public static void announceAggregateDrop(UDAggregate udf, boolean announceLocally)
-{
-    mlogger.info(String.format("Drop aggregate function overload '%s' args '%s'", udf.name(), udf.argTypes()));
-    KSMetaData ksm = Schema.instance.getKSMetaData(udf.name().keyspace);
-    announce(LegacySchemaTables.makeDropAggregateMutation(ksm, udf, FBUtilities.timestampMicros()), announceLocally);
-}
-#endif
-
 /**
  * actively announce a new version to active hosts via rpc
  * @param schema The schema mutation to be applied
@@ -72,6 +72,9 @@ class migration_manager : public seastar::async_sharded_service<migration_manage
     seastar::abort_source _as;
     bool _cluster_upgraded = false;
     seastar::condition_variable _wait_cluster_upgraded;
+    // Serializes pulls triggered by gossip, so that a node which learns about
+    // a new schema version from many peers pulls it only once.
+    seastar::semaphore _gossip_schema_pulls{1};
 public:
     migration_manager(migration_notifier&, gms::feature_service&);
 
@@ -84,6 +87,10 @@ class migration_manager : public seastar::async_sharded_service<migration_manage
 
     future<> submit_migration_task(const gms::inet_address& endpoint, bool can_ignore_down_node = true);
 
+    // Like submit_migration_task(), but skips the pull if the schema version
+    // the endpoint gossips is ours by the time the pull would start.
+    future<> submit_coalesced_migration_task(const gms::inet_address& endpoint);
+
     // Makes sure that this node knows about all schema changes known by "nodes" that were made prior to this call.
     future<> sync_schema(const database& db, const std::vector<gms::inet_address>& nodes);
 
@@ -130,6 +137,10 @@ class migration_manager : public seastar::async_sharded_service<migration_manage
 
     future<> announce_function_drop(shared_ptr<cql3::functions::user_function> func, bool announce_locally);
 
+    future<> announce_new_aggregate(shared_ptr<cql3::functions::user_aggregate> aggregate, bool announce_locally);
+
+    future<> announce_aggregate_drop(shared_ptr<cql3::functions::user_aggregate> aggregate, bool announce_locally);
+
     future<> announce_type_update(user_type updated_type, bool announce_locally = false);
 
     future<> announce_keyspace_drop(const sstring& ks_name, bool announce_locally = false);
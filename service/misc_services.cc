@@ -174,7 +174,13 @@ future<lowres_clock::duration> cache_hitrate_calculator::recalculate_hitrates()
         return boost::copy_range<std::unordered_map<utils::UUID, stat>>(db.get_column_families() | boost::adaptors::filtered(non_system_filter) |
                 boost::adaptors::transformed([]  (const std::pair<utils::UUID, lw_shared_ptr<column_family>>& cf) {
             auto& stats = cf.second->get_row_cache().stats();
-            return std::make_pair(cf.first, stat{float(stats.reads_with_no_misses.rate().rates[0]), float(stats.reads_with_misses.rate().rates[0])});
+            auto hits = float(stats.reads_with_no_misses.rate().rates[0]);
+            auto misses = float(stats.reads_with_misses.rate().rates[0]);
+            if (cf.second->cache_warming_up()) {
+                // Don't attract reads before the saved partitions are back in cache.
+                return std::make_pair(cf.first, stat{0, hits + misses});
+            }
+            return std::make_pair(cf.first, stat{hits, misses});
         }));
     };
 
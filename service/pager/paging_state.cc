@@ -62,14 +62,16 @@ service::pager::paging_state::paging_state(partition_key pk,
         utils::UUID query_uuid,
         replicas_per_token_range last_replicas,
         std::optional<db::read_repair_decision> query_read_repair_decision,
-        uint32_t rows_fetched_for_last_partition)
+        uint32_t rows_fetched_for_last_partition,
+        uint32_t average_row_size)
     : _partition_key(std::move(pk))
     , _clustering_key(std::move(ck))
     , _remaining(rem)
     , _query_uuid(query_uuid)
     , _last_replicas(std::move(last_replicas))
     , _query_read_repair_decision(query_read_repair_decision)
-    , _rows_fetched_for_last_partition(rows_fetched_for_last_partition) {
+    , _rows_fetched_for_last_partition(rows_fetched_for_last_partition)
+    , _average_row_size(average_row_size) {
 }
 
 lw_shared_ptr<service::pager::paging_state> service::pager::paging_state::deserialize(
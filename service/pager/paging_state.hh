@@ -65,6 +65,7 @@ class paging_state final {
     replicas_per_token_range _last_replicas;
     std::optional<db::read_repair_decision> _query_read_repair_decision;
     uint32_t _rows_fetched_for_last_partition;
+    uint32_t _average_row_size;
 
 public:
     paging_state(partition_key pk,
@@ -73,7 +74,8 @@ class paging_state final {
             utils::UUID reader_recall_uuid,
             replicas_per_token_range last_replicas,
             std::optional<db::read_repair_decision> query_read_repair_decision,
-            uint32_t rows_fetched_for_last_partition);
+            uint32_t rows_fetched_for_last_partition,
+            uint32_t average_row_size = 0);
 
     void set_partition_key(partition_key pk) {
         _partition_key = std::move(pk);
@@ -111,6 +113,15 @@ class paging_state final {
         return _rows_fetched_for_last_partition;
     }
 
+    /**
+     * Estimated size of the rows of the query, in bytes, as measured on the
+     * pages fetched so far. Used to size the pages of queries whose pages
+     * are limited in bytes. Zero if unknown.
+     */
+    uint32_t get_average_row_size() const {
+        return _average_row_size;
+    }
+
     /**
      * query_uuid is a unique key under which the replicas saved the
      * readers used to serve the last page. These saved readers may be
@@ -90,6 +90,8 @@ class query_pager {
     paging_state::replicas_per_token_range _last_replicas;
     std::optional<db::read_repair_decision> _query_read_repair_decision;
     uint32_t _rows_fetched_for_last_partition = 0;
+    // Moving average of the size of the rows fetched so far, in bytes.
+    uint32_t _average_row_size = 0;
 public:
     query_pager(schema_ptr s, shared_ptr<const cql3::selection::selection> selection,
                 service::query_state& state,
@@ -155,6 +157,8 @@ class query_pager {
                       const foreign_ptr<lw_shared_ptr<query::result>>& results,
                       uint32_t page_size, gc_clock::time_point now);
 
+    void update_average_row_size(const query::result& results, uint32_t row_count);
+
     virtual uint32_t max_rows_to_fetch(uint32_t page_size) {
         return std::min(_max, page_size);
     }
@@ -93,6 +93,7 @@ static bool has_clustering_keys(const schema& s, const query::read_command& cmd)
             _last_replicas = state->get_last_replicas();
             _query_read_repair_decision = state->get_query_read_repair_decision();
             _rows_fetched_for_last_partition = state->get_rows_fetched_for_last_partition();
+            _average_row_size = state->get_average_row_size();
         } else {
             _cmd->query_uuid = utils::make_random_uuid();
             _cmd->is_first_page = true;
@@ -171,6 +172,15 @@ static bool has_clustering_keys(const schema& s, const query::read_command& cmd)
 
         auto max_rows = max_rows_to_fetch(page_size);
 
+        // In the byte-budget mode, ask for as many rows as are expected to fit
+        // in the budget, and have the replicas cut the page short if they don't.
+        if (auto page_size_in_bytes = get_local_storage_proxy().get_db().local().get_config().page_size_in_bytes()) {
+            _cmd->max_result_size = page_size_in_bytes;
+            if (_average_row_size) {
+                max_rows = std::clamp<uint64_t>(page_size_in_bytes / _average_row_size, 1, max_rows);
+            }
+        }
+
         // We always need PK so we can determine where to start next.
         _cmd->slice.options.set<query::partition_slice::option::send_partition_key>();
         // don't add empty bytes (cks) unless we have to
@@ -181,8 +191,8 @@ static bool has_clustering_keys(const schema& s, const query::read_command& cmd)
         _cmd->row_limit = max_rows;
         maybe_adjust_per_partition_limit(page_size);
 
-        qlogger.debug("Fetching {}, page size={}, max_rows={}",
-                _cmd->cf_id, page_size, max_rows
+        qlogger.debug("Fetching {}, page size={}, max_rows={}, average row size={}",
+                _cmd->cf_id, page_size, max_rows, _average_row_size
                 );
 
         auto ranges = _ranges;
@@ -333,7 +343,8 @@ class query_pager::query_result_visitor : public Base {
 
             row_count = v.total_rows - v.dropped_rows;
             _max = _max - row_count;
-            _exhausted = (v.total_rows < page_size && !results->is_short_read() && v.dropped_rows == 0) || _max == 0;
+            _exhausted = (v.total_rows < _cmd->row_limit && !results->is_short_read() && v.dropped_rows == 0) || _max == 0;
+            update_average_row_size(*results, v.total_rows);
             // If per partition limit is defined, we need to accumulate rows fetched for last partition key if the key matches
             if (_cmd->slice.partition_row_limit() < query::max_rows) {
                 if (_last_pkey && v.last_pkey && _last_pkey->equal(*_schema, *v.last_pkey)) {
@@ -347,7 +358,8 @@ class query_pager::query_result_visitor : public Base {
         } else {
             row_count = results->row_count() ? *results->row_count() : std::get<1>(view.count_partitions_and_rows());
             _max = _max - row_count;
-            _exhausted = (row_count < page_size && !results->is_short_read()) || _max == 0;
+            _exhausted = (row_count < _cmd->row_limit && !results->is_short_read()) || _max == 0;
+            update_average_row_size(*results, row_count);
 
             if (!_exhausted || row_count > 0) {
                 if (_last_pkey) {
@@ -369,8 +381,16 @@ class query_pager::query_result_visitor : public Base {
         }
     }
 
+    void query_pager::update_average_row_size(const query::result& results, uint32_t row_count) {
+        if (!row_count) {
+            return;
+        }
+        auto row_size = uint32_t(std::min<uint64_t>(std::max<uint64_t>(1, results.buf().size() / row_count), std::numeric_limits<uint32_t>::max()));
+        _average_row_size = _average_row_size ? uint32_t((uint64_t(_average_row_size) * 3 + row_size) / 4) : row_size;
+    }
+
     lw_shared_ptr<const paging_state> query_pager::state() const {
-        return make_lw_shared<paging_state>(_last_pkey.value_or(partition_key::make_empty()), _last_ckey, _exhausted ? 0 : _max, _cmd->query_uuid, _last_replicas, _query_read_repair_decision, _rows_fetched_for_last_partition);
+        return make_lw_shared<paging_state>(_last_pkey.value_or(partition_key::make_empty()), _last_ckey, _exhausted ? 0 : _max, _cmd->query_uuid, _last_replicas, _query_read_repair_decision, _rows_fetched_for_last_partition, _average_row_size);
     }
 
 }
@@ -30,11 +30,194 @@
 
 #include "service/storage_service.hh"
 
+#include <boost/intrusive/list.hpp>
+#include <seastar/core/lowres_clock.hh>
+
 namespace service::paxos {
 
+// The cached state of a key mirrors its row in system.paxos: each write is
+// applied the way the table reconciles it, by comparing the timestamps of
+// the ballots (all paxos writes use their ballot as timestamp).
+//
+// Every write of system.paxos goes through the cache under the key lock,
+// so a cached state can not miss a write. A state is not kept longer than
+// max_age, and states whose oldest ballot is close to the expiry of the
+// paxos table entries are not cached.
+class paxos_state::state_cache {
+    static constexpr size_t max_memory = 8 << 20;
+    static constexpr auto max_age = std::chrono::minutes(10);
+    // The TTL of system.paxos is at least 3 hours.
+    static constexpr auto max_ballot_age = std::chrono::minutes(90);
+
+    struct entry {
+        dht::token token;
+        utils::UUID table_id;
+        partition_key key;
+        utils::UUID promised;
+        std::optional<proposal> accepted;
+        // The last write of accepted, which may have erased it.
+        int64_t accepted_timestamp;
+        std::optional<proposal> commit;
+        lowres_clock::time_point loaded_at;
+        size_t memory = 0;
+        boost::intrusive::list_member_hook<> lru_link;
+
+        void update_memory() {
+            memory = sizeof(entry) + key.external_memory_usage()
+                    + (accepted ? accepted->update.representation().size() : 0)
+                    + (commit ? commit->update.representation().size() : 0);
+        }
+    };
+    using lru_type = boost::intrusive::list<entry,
+        boost::intrusive::member_hook<entry, boost::intrusive::list_member_hook<>, &entry::lru_link>,
+        boost::intrusive::constant_time_size<false>>;
+
+    std::unordered_multimap<dht::token, std::unique_ptr<entry>> _entries;
+    lru_type _lru;
+    size_t _memory = 0;
+private:
+    static int64_t timestamp(const utils::UUID& ballot) {
+        return utils::UUID_gen::micros_timestamp(ballot);
+    }
+
+    decltype(_entries)::iterator find(const schema& s, const dht::token& token, partition_key_view key) {
+        auto [begin, end] = _entries.equal_range(token);
+        for (auto it = begin; it != end; ++it) {
+            if (it->second->table_id == s.id() && it->second->key.equal(s, key)) {
+                return it;
+            }
+        }
+        return _entries.end();
+    }
+
+    void erase(decltype(_entries)::iterator it) {
+        _memory -= it->second->memory;
+        _lru.erase(_lru.iterator_to(*it->second));
+        _entries.erase(it);
+    }
+
+    void erase(entry& e) {
+        auto [begin, end] = _entries.equal_range(e.token);
+        for (auto it = begin; it != end; ++it) {
+            if (it->second.get() == &e) {
+                erase(it);
+                return;
+            }
+        }
+    }
+
+    // Applies a write of the key's state, if the state is cached.
+    template <typename Func>
+    void update(const schema& s, partition_key_view key, Func&& func) {
+        auto it = find(s, dht::get_token(s, key), key);
+        if (it == _entries.end()) {
+            return;
+        }
+        auto& e = *it->second;
+        _memory -= e.memory;
+        func(e);
+        e.update_memory();
+        _memory += e.memory;
+    }
+public:
+    ~state_cache() {
+        _lru.clear();
+    }
+
+    std::optional<paxos_state> get(const schema& s, const partition_key& key) {
+        auto it = find(s, dht::get_token(s, key), key);
+        if (it == _entries.end()) {
+            return std::nullopt;
+        }
+        auto& e = *it->second;
+        if (lowres_clock::now() - e.loaded_at > max_age) {
+            erase(it);
+            return std::nullopt;
+        }
+        _lru.erase(_lru.iterator_to(e));
+        _lru.push_front(e);
+        return paxos_state(e.promised, e.accepted, e.commit);
+    }
+
+    void put(const schema& s, const partition_key& key, const paxos_state& state) {
+        auto oldest = std::numeric_limits<int64_t>::max();
+        // A key which was never promised has the minimal ballot, which doesn't expire.
+        if (state._promised_ballot != utils::UUID_gen::min_time_UUID(0)) {
+            oldest = timestamp(state._promised_ballot);
+        }
+        if (state._accepted_proposal) {
+            oldest = std::min(oldest, timestamp(state._accepted_proposal->ballot));
+        }
+        if (state._most_recent_commit) {
+            oldest = std::min(oldest, timestamp(state._most_recent_commit->ballot));
+        }
+        auto now = std::chrono::duration_cast<std::chrono::microseconds>(db_clock::now().time_since_epoch()).count();
+        if (now - std::min(oldest, now) > std::chrono::duration_cast<std::chrono::microseconds>(max_ballot_age).count()) {
+            return;
+        }
+        auto token = dht::get_token(s, key);
+        auto it = find(s, token, key);
+        if (it != _entries.end()) {
+            erase(it);
+        }
+        auto e = std::make_unique<entry>(entry{token, s.id(), key, state._promised_ballot, state._accepted_proposal,
+                state._accepted_proposal ? timestamp(state._accepted_proposal->ballot) : std::numeric_limits<int64_t>::min(),
+                state._most_recent_commit, lowres_clock::now()});
+        e->update_memory();
+        if (e->memory > max_memory / 16) {
+            return;
+        }
+        _memory += e->memory;
+        _lru.push_front(*e);
+        _entries.emplace(token, std::move(e));
+        while (_memory > max_memory) {
+            erase(_lru.back());
+        }
+    }
+
+    void promised(const schema& s, partition_key_view key, const utils::UUID& ballot) {
+        update(s, key, [&] (entry& e) {
+            if (timestamp(ballot) >= timestamp(e.promised)) {
+                e.promised = ballot;
+            }
+        });
+    }
+
+    void accepted(const schema& s, const proposal& p) {
+        update(s, p.update.key(), [&] (entry& e) {
+            // On a tie, the erasure of the proposal by a decision wins.
+            if (timestamp(p.ballot) > e.accepted_timestamp || (timestamp(p.ballot) == e.accepted_timestamp && e.accepted)) {
+                e.accepted = p;
+                e.accepted_timestamp = timestamp(p.ballot);
+            }
+        });
+    }
+
+    void committed(const schema& s, const proposal& decision) {
+        update(s, decision.update.key(), [&] (entry& e) {
+            // Saving a decision erases the accepted proposal.
+            if (timestamp(decision.ballot) >= e.accepted_timestamp) {
+                e.accepted.reset();
+                e.accepted_timestamp = timestamp(decision.ballot);
+            }
+            if (!e.commit || timestamp(decision.ballot) >= timestamp(e.commit->ballot)) {
+                e.commit = decision;
+            }
+        });
+    }
+
+    void invalidate(const schema& s, partition_key_view key) {
+        auto it = find(s, dht::get_token(s, key), key);
+        if (it != _entries.end()) {
+            erase(it);
+        }
+    }
+};
+
 logging::logger paxos_state::logger("paxos");
 thread_local paxos_state::key_lock_map paxos_state::_paxos_table_lock;
 thread_local paxos_state::key_lock_map paxos_state::_coordinator_lock;
+thread_local paxos_state::state_cache paxos_state::_state_cache;
 
 paxos_state::key_lock_map::semaphore& paxos_state::key_lock_map::get_semaphore_for_key(const dht::token& key) {
     return _locks.try_emplace(key, 1).first->second;
@@ -47,6 +230,46 @@ void paxos_state::key_lock_map::release_semaphore_for_key(const dht::token& key)
     }
 }
 
+future<paxos_state> paxos_state::load(const partition_key& key, schema_ptr s, gc_clock::time_point now, clock_type::time_point timeout) {
+    auto& stats = get_local_storage_proxy().get_stats();
+    if (auto state = _state_cache.get(*s, key)) {
+        ++stats.cas_replica_state_cache_hits;
+        return make_ready_future<paxos_state>(std::move(*state));
+    }
+    ++stats.cas_replica_state_cache_misses;
+    return db::system_keyspace::load_paxos_state(key, s, now, timeout).then([key, s] (paxos_state state) {
+        _state_cache.put(*s, key, state);
+        return state;
+    });
+}
+
+// The cached state is updated before the write, which is safe since both
+// happen under the key lock. A failed write may still have reached the
+// table, so its key is dropped from the cache.
+future<> paxos_state::save_promise(schema_ptr s, const partition_key& key, const utils::UUID& ballot, clock_type::time_point timeout) {
+    _state_cache.promised(*s, key, ballot);
+    return db::system_keyspace::save_paxos_promise(*s, key, ballot, timeout).handle_exception([s, key] (std::exception_ptr eptr) {
+        _state_cache.invalidate(*s, key);
+        return make_exception_future<>(std::move(eptr));
+    });
+}
+
+future<> paxos_state::save_proposal(schema_ptr s, const proposal& proposal, clock_type::time_point timeout) {
+    _state_cache.accepted(*s, proposal);
+    return db::system_keyspace::save_paxos_proposal(*s, proposal, timeout).handle_exception([s, key = partition_key(proposal.update.key())] (std::exception_ptr eptr) {
+        _state_cache.invalidate(*s, key);
+        return make_exception_future<>(std::move(eptr));
+    });
+}
+
+future<> paxos_state::save_decision(schema_ptr s, const proposal& decision, clock_type::time_point timeout) {
+    _state_cache.committed(*s, decision);
+    return db::system_keyspace::save_paxos_decision(*s, decision, timeout).handle_exception([s, key = partition_key(decision.update.key())] (std::exception_ptr eptr) {
+        _state_cache.invalidate(*s, key);
+        return make_exception_future<>(std::move(eptr));
+    });
+}
+
 future<prepare_response> paxos_state::prepare(tracing::trace_state_ptr tr_state, schema_ptr schema,
         const query::read_command& cmd, const partition_key& key, utils::UUID ballot,
         bool only_digest, query::digest_algorithm da, clock_type::time_point timeout) {
@@ -60,7 +283,7 @@ future<prepare_response> paxos_state::prepare(tracing::trace_state_ptr tr_state,
         // amount of re-submit will fix this (because the node on which the commit has expired will have a
         // tombstone that hides any re-submit). See CASSANDRA-12043 for details.
         auto now_in_sec = utils::UUID_gen::unix_timestamp_in_sec(ballot);
-        auto f = db::system_keyspace::load_paxos_state(key, schema, gc_clock::time_point(now_in_sec), timeout);
+        auto f = load(key, schema, gc_clock::time_point(now_in_sec), timeout);
         return f.then([&cmd, token = std::move(token), &key, ballot, tr_state, schema, only_digest, da, timeout] (paxos_state state) {
             // If received ballot is newer that the one we already accepted it has to be accepted as well,
             // but we will return the previously accepted proposal so that the new coordinator will use it instead of
@@ -68,7 +291,7 @@ future<prepare_response> paxos_state::prepare(tracing::trace_state_ptr tr_state,
             if (ballot.timestamp() > state._promised_ballot.timestamp()) {
                 logger.debug("Promising ballot {}", ballot);
                 tracing::trace(tr_state, "Promising ballot {}", ballot);
-                auto f1 = futurize_invoke(db::system_keyspace::save_paxos_promise, *schema, std::ref(key), ballot, timeout);
+                auto f1 = futurize_invoke(save_promise, schema, std::ref(key), ballot, timeout);
                 auto f2 = futurize_invoke([&] {
                     return do_with(dht::partition_range_vector({dht::partition_range::make_singular({token, key})}),
                             [tr_state, schema, &cmd, only_digest, da, timeout] (const dht::partition_range_vector& prv) {
@@ -122,15 +345,14 @@ future<bool> paxos_state::accept(tracing::trace_state_ptr tr_state, schema_ptr s
     lc.start();
     return with_locked_key(token, timeout, [proposal = std::move(proposal), schema, tr_state, timeout] () mutable {
         auto now_in_sec = utils::UUID_gen::unix_timestamp_in_sec(proposal.ballot);
-        auto f = db::system_keyspace::load_paxos_state(proposal.update.decorated_key(*schema).key(), schema,
-                gc_clock::time_point(now_in_sec), timeout);
+        auto f = load(proposal.update.decorated_key(*schema).key(), schema, gc_clock::time_point(now_in_sec), timeout);
         return f.then([proposal = std::move(proposal), tr_state, schema, timeout] (paxos_state state) {
             // Accept the proposal if we promised to accept it or the proposal is newer than the one we promised.
             // Otherwise the proposal was cutoff by another Paxos proposer and has to be rejected.
             if (proposal.ballot == state._promised_ballot || proposal.ballot.timestamp() > state._promised_ballot.timestamp()) {
                 logger.debug("Accepting proposal {}", proposal);
                 tracing::trace(tr_state, "Accepting proposal {}", proposal);
-                return db::system_keyspace::save_paxos_proposal(*schema, proposal, timeout).then([] {
+                return save_proposal(schema, proposal, timeout).then([] {
                         return true;
                 });
             } else {
@@ -177,9 +399,12 @@ future<> paxos_state::learn(schema_ptr schema, proposal decision, clock_type::ti
             tracing::trace(tr_state, "Not committing decision {} as ballot timestamp predates last truncation time", decision);
         }
         return f.then([&decision, schema, timeout] {
-            // We don't need to lock the partition key if there is no gap between loading paxos
-            // state and saving it, and here we're just blindly updating.
-            return db::system_keyspace::save_paxos_decision(*schema, decision, timeout);
+            // We don't need to lock the partition key for the table itself, since here we're just
+            // blindly updating, but the cached state has to be updated in the same order as the table.
+            auto token = dht::get_token(*schema, decision.update.key());
+            return with_locked_key(token, timeout, [&decision, schema, timeout] {
+                return save_decision(schema, decision, timeout);
+            });
         });
     }).finally([schema, lc] () mutable {
         auto& stats = get_local_storage_proxy().get_db().local().find_column_family(schema).get_stats();
@@ -194,7 +419,10 @@ future<> paxos_state::prune(schema_ptr schema, const partition_key& key, utils::
         tracing::trace_state_ptr tr_state) {
     logger.debug("Delete paxos state for ballot {}", ballot);
     tracing::trace(tr_state, "Delete paxos state for ballot {}", ballot);
-    return db::system_keyspace::delete_paxos_decision(*schema, key, ballot, timeout);
+    return with_locked_key(dht::get_token(*schema, key), timeout, [schema, key, ballot, timeout] {
+        _state_cache.invalidate(*schema, key);
+        return db::system_keyspace::delete_paxos_decision(*schema, key, ballot, timeout);
+    });
 }
 
 } // end of namespace "service::paxos"
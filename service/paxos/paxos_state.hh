@@ -44,6 +44,7 @@
 #include "log.hh"
 #include "digest_algorithm.hh"
 #include "db/timeout_clock.hh"
+#include "gc_clock.hh"
 #include <unordered_map>
 #include "utils/UUID_gen.hh"
 #include "service/paxos/prepare_response.hh"
@@ -94,6 +95,18 @@ class paxos_state {
         return _paxos_table_lock.with_locked_key(key, timeout, std::move(func));
     }
 
+    // Recently used states, kept in memory so that the rounds of a key
+    // don't have to read them back from system.paxos.
+    class state_cache;
+    static thread_local state_cache _state_cache;
+
+    // Reads and writes of system.paxos, going through the cache.
+    // Must be called under with_locked_key().
+    static future<paxos_state> load(const partition_key& key, schema_ptr s, gc_clock::time_point now, clock_type::time_point timeout);
+    static future<> save_promise(schema_ptr s, const partition_key& key, const utils::UUID& ballot, clock_type::time_point timeout);
+    static future<> save_proposal(schema_ptr s, const proposal& proposal, clock_type::time_point timeout);
+    static future<> save_decision(schema_ptr s, const proposal& decision, clock_type::time_point timeout);
+
     utils::UUID _promised_ballot = utils::UUID_gen::min_time_UUID(0);
     std::optional<proposal> _accepted_proposal;
     std::optional<proposal> _most_recent_commit;
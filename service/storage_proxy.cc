@@ -52,6 +52,7 @@
 #include "gms/failure_detector.hh"
 #include "gms/gossiper.hh"
 #include "storage_service.hh"
+#include "forward_service.hh"
 #include <seastar/core/future-util.hh>
 #include "db/read_repair_decision.hh"
 #include "db/config.hh"
@@ -61,6 +62,7 @@
 #include "exceptions/exceptions.hh"
 #include <boost/range/algorithm_ext/push_back.hpp>
 #include <boost/iterator/counting_iterator.hpp>
+#include <boost/range/irange.hpp>
 #include <boost/range/adaptors.hpp>
 #include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/algorithm/cxx11/none_of.hpp>
@@ -77,6 +79,7 @@
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/intrusive/list.hpp>
 #include "utils/latency.hh"
+#include "utils/latency_sampler.hh"
 #include "schema.hh"
 #include "schema_registry.hh"
 #include "utils/joinpoint.hh"
@@ -165,6 +168,10 @@ class mutation_holder {
             storage_proxy::response_id_type response_id, storage_proxy::clock_type::time_point timeout,
             tracing::trace_state_ptr tr_state) = 0;
     virtual bool is_shared() = 0;
+    // The mutation sent to all replicas with MUTATION, if there is one.
+    virtual lw_shared_ptr<const frozen_mutation> shared_frozen_mutation() const {
+        return {};
+    }
     size_t size() const {
         return _size;
     }
@@ -216,7 +223,7 @@ class per_destination_mutation : public mutation_holder {
         auto m = _mutations[ep];
         if (m) {
             tracing::trace(tr_state, "Sending a mutation to /{}", ep);
-            return ms.send_mutation(netw::messaging_service::msg_addr{ep, 0}, timeout, *m,
+            return ms.send_mutation(ms.addr_for_token(ep, _token), timeout, *m,
                                     std::move(forward), utils::fb_utilities::get_broadcast_address(), this_shard_id(),
                                     response_id, tracing::make_trace_info(tr_state));
         }
@@ -263,13 +270,16 @@ class shared_mutation : public mutation_holder {
             tracing::trace_state_ptr tr_state) override {
         tracing::trace(tr_state, "Sending a mutation to /{}", ep);
         auto& ms = netw::get_local_messaging_service();
-        return ms.send_mutation(netw::messaging_service::msg_addr{ep, 0}, timeout, *_mutation,
+        return ms.send_mutation(ms.addr_for_token(ep, _mutation->decorated_key(*_schema).token()), timeout, *_mutation,
                 std::move(forward), utils::fb_utilities::get_broadcast_address(), this_shard_id(),
                 response_id, tracing::make_trace_info(tr_state));
     }
     virtual bool is_shared() override {
         return true;
     }
+    virtual lw_shared_ptr<const frozen_mutation> shared_frozen_mutation() const override {
+        return _mutation;
+    }
     virtual void release_mutation() override {
         _mutation.release();
     }
@@ -297,6 +307,10 @@ class hint_mutation : public shared_mutation {
                 std::move(forward), utils::fb_utilities::get_broadcast_address(), this_shard_id(),
                 response_id, tracing::make_trace_info(tr_state));
     }
+    virtual lw_shared_ptr<const frozen_mutation> shared_frozen_mutation() const override {
+        // Hints are sent with HINT_MUTATION.
+        return {};
+    }
 };
 
 class cas_mutation : public mutation_holder {
@@ -355,6 +369,7 @@ class abstract_write_response_handler : public seastar::enable_shared_from_this<
     size_t _cl_acks = 0;
     bool _cl_achieved = false;
     bool _throttled = false;
+    bool _rate_limited = false; // the local replica rejected the write, see on_rate_limited()
     enum class error : uint8_t {
         NONE,
         TIMEOUT,
@@ -400,7 +415,9 @@ class abstract_write_response_handler : public seastar::enable_shared_from_this<
                 _proxy->unthrottle();
             }
         } else {
-            if (_error == error::TIMEOUT) {
+            if (_rate_limited && _error != error::NONE) {
+                _ready.set_exception(exceptions::rate_limit_exception(get_schema()->ks_name(), get_schema()->cf_name(), "write"));
+            } else if (_error == error::TIMEOUT) {
                 _ready.set_exception(mutation_write_timeout_exception(get_schema()->ks_name(), get_schema()->cf_name(), _cl, _cl_acks, _total_block_for, _type));
             } else if (_error == error::FAILURE) {
                 _ready.set_exception(mutation_write_failure_exception(get_schema()->ks_name(), get_schema()->cf_name(), _cl, _cl_acks, _failed, _total_block_for, _type));
@@ -451,6 +468,11 @@ class abstract_write_response_handler : public seastar::enable_shared_from_this<
         }
         return false;
     }
+    // The partition is over its write rate limit on the local replica. If the
+    // write fails, the client is told so rather than getting a generic failure.
+    void on_rate_limited() {
+        _rate_limited = true;
+    }
     void on_timeout() {
         if (_cl_achieved) {
             slogger.trace("Write is not acknowledged by {} replicas after achieving CL", get_targets());
@@ -601,6 +623,9 @@ class abstract_write_response_handler : public seastar::enable_shared_from_this<
     bool read_repair_write() {
         return !_mutation_holder->is_shared();
     }
+    lw_shared_ptr<const frozen_mutation> get_shared_mutation() const {
+        return _mutation_holder->shared_frozen_mutation();
+    }
     const tracing::trace_state_ptr& get_trace_state() const {
         return _trace_state;
     }
@@ -1476,6 +1501,26 @@ void storage_proxy_stats::write_stats::register_stats() {
                     sm::description("number of CQL read requests which arrived to a non-replica and had to be forwarded to a replica"),
                     {storage_proxy_stats::current_scheduling_group_label()}),
 
+            sm::make_total_operations("grouped_partition_reads", grouped_partition_reads,
+                    sm::description("number of partitions of multi-partition CL=ONE reads sent to a replica in a single request with other partitions"),
+                    {storage_proxy_stats::current_scheduling_group_label()}),
+
+            sm::make_total_operations("local_replica_reads", local_replica_reads,
+                    sm::description("number of single-partition CL=ONE reads served by the coordinator shard without a read executor"),
+                    {storage_proxy_stats::current_scheduling_group_label()}),
+
+            sm::make_total_operations("local_replica_read_fallbacks", local_replica_read_fallbacks,
+                    sm::description("number of local replica reads which failed and were retried with a read executor"),
+                    {storage_proxy_stats::current_scheduling_group_label()}),
+
+            sm::make_total_operations("local_replica_writes", local_replica_writes,
+                    sm::description("number of single-partition CL=ONE writes applied by the coordinator shard, the sole replica, without a write handler"),
+                    {storage_proxy_stats::current_scheduling_group_label()}),
+
+            sm::make_total_operations("local_replica_write_fallbacks", local_replica_write_fallbacks,
+                    sm::description("number of local replica writes which failed and were retried with a write handler"),
+                    {storage_proxy_stats::current_scheduling_group_label()}),
+
         });
 }
 
@@ -1512,6 +1557,14 @@ void storage_proxy_stats::stats::register_stats() {
                 {storage_proxy_stats::current_scheduling_group_label()},
                 [this]{ return estimated_read.get_histogram(16, 20);}),
 
+        sm::make_total_operations("sent_mutation_batches", sent_mutation_batches,
+                sm::description("number of messages carrying several mutations to the same replica"),
+                {storage_proxy_stats::current_scheduling_group_label()}),
+
+        sm::make_total_operations("coalesced_writes", coalesced_writes,
+                sm::description("number of replica writes delayed to be sent along with other writes to the same replica"),
+                {storage_proxy_stats::current_scheduling_group_label()}),
+
         sm::make_queue_length("foreground_reads", foreground_reads,
                 sm::description("number of currently pending foreground read requests"),
                 {storage_proxy_stats::current_scheduling_group_label()}),
@@ -1536,6 +1589,22 @@ void storage_proxy_stats::stats::register_stats() {
                        sm::description("number of background read repairs"),
                        {storage_proxy_stats::current_scheduling_group_label()}),
 
+        sm::make_total_operations("deferred_read_repairs_queued", deferred_read_repairs_queued,
+                       sm::description("number of partitions queued to be repaired in the background after the read returned"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
+
+        sm::make_total_operations("deferred_read_repairs_applied", deferred_read_repairs_applied,
+                       sm::description("number of partitions repaired in the background after the read returned"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
+
+        sm::make_total_operations("deferred_read_repairs_failed", deferred_read_repairs_failed,
+                       sm::description("number of partitions whose background repair write failed"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
+
+        sm::make_total_operations("deferred_read_repairs_dropped", deferred_read_repairs_dropped,
+                       sm::description("number of partitions not repaired because the queue of background read repairs was full"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
+
         sm::make_total_operations("read_timeouts", read_timeouts._count,
                        sm::description("number of read request failed due to a timeout"),
                        {storage_proxy_stats::current_scheduling_group_label()}),
@@ -1560,6 +1629,10 @@ void storage_proxy_stats::stats::register_stats() {
                        sm::description("number of speculative data read requests that were sent"),
                        {storage_proxy_stats::current_scheduling_group_label()}),
 
+        sm::make_total_operations("speculative_reads_throttled", speculative_reads_throttled,
+                       sm::description("number of speculative read requests that were not sent because the table exhausted its speculative_retry_budget"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
+
         sm::make_histogram("cas_read_latency", sm::description("Transactional read latency histogram"),
                 {storage_proxy_stats::current_scheduling_group_label()},
                 [this]{ return estimated_cas_read.get_histogram(16, 20);}),
@@ -1627,10 +1700,18 @@ void storage_proxy_stats::stats::register_stats() {
                        sm::description("number of counter updates received by this node acting as an update leader"),
                        {storage_proxy_stats::current_scheduling_group_label()}),
 
+        sm::make_total_operations("coalesced_counter_updates", coalesced_counter_updates,
+                       sm::description("number of counter updates merged by this node acting as an update leader into another update to the same partition"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
+
         sm::make_total_operations("received_mutations", received_mutations,
                        sm::description("number of mutations received by a replica Node"),
                        {storage_proxy_stats::current_scheduling_group_label()}),
 
+        sm::make_total_operations("received_mutation_batches", received_mutation_batches,
+                       sm::description("number of messages carrying several mutations received by a replica Node"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
+
         sm::make_total_operations("forwarded_mutations", forwarded_mutations,
                        sm::description("number of mutations forwarded to other replica Nodes"),
                        {storage_proxy_stats::current_scheduling_group_label()}),
@@ -1655,9 +1736,21 @@ void storage_proxy_stats::stats::register_stats() {
                        sm::description("number of operations that crossed a shard boundary"),
                        {storage_proxy_stats::current_scheduling_group_label()}),
 
+        sm::make_total_operations("single_shard_range_reads", replica_single_shard_range_reads,
+                       sm::description("number of range reads served by a single shard, because the range was owned by it"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
+
         sm::make_total_operations("cas_dropped_prune", cas_replica_dropped_prune,
                        sm::description("how many times a coordinator did not perfom prune after cas"),
                        {storage_proxy_stats::current_scheduling_group_label()}),
+
+        sm::make_total_operations("cas_state_cache_hits", cas_replica_state_cache_hits,
+                       sm::description("number of paxos state lookups served from memory"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
+
+        sm::make_total_operations("cas_state_cache_misses", cas_replica_state_cache_misses,
+                       sm::description("number of paxos state lookups which had to read the paxos table"),
+                       {storage_proxy_stats::current_scheduling_group_label()}),
     });
 }
 
@@ -1733,10 +1826,15 @@ storage_proxy::storage_proxy(distributed<database>& db, storage_proxy::config cf
     , _mutate_stage{"storage_proxy_mutate", &storage_proxy::do_mutate}
     , _max_view_update_backlog(max_view_update_backlog)
     , _view_update_handlers_list(std::make_unique<view_update_handlers_list>()) {
+    _write_coalescing_timer.set_callback([this] { flush_coalesced_writes(); });
+    _counter_update_coalescing_timer.set_callback([this] { flush_coalesced_counter_updates(); });
+    _deferred_read_repair_timer.set_callback([this] { send_deferred_read_repairs(); });
     namespace sm = seastar::metrics;
     _metrics.add_group(storage_proxy_stats::COORDINATOR_STATS_CATEGORY, {
         sm::make_queue_length("current_throttled_writes", [this] { return _throttled_writes.size(); },
                        sm::description("number of currently throttled write requests")),
+        sm::make_queue_length("deferred_read_repair_queue_length", [this] { return _deferred_read_repairs.size(); },
+                       sm::description("number of partitions waiting to be repaired in the background after their read returned")),
     });
 
     if (cfg.hinted_handoff_enabled) {
@@ -1792,6 +1890,56 @@ storage_proxy::mutate_locally(std::vector<mutation> mutations, clock_type::time_
     });
 }
 
+future<std::vector<std::exception_ptr>>
+storage_proxy::mutate_locally(const std::vector<schema_ptr>& schemas, const std::vector<frozen_mutation>& mutations, clock_type::time_point timeout) {
+    std::vector<std::vector<size_t>> per_shard(smp::count);
+    for (size_t i = 0; i < mutations.size(); ++i) {
+        per_shard[_db.local().shard_of(mutations[i])].push_back(i);
+    }
+    return do_with(std::move(per_shard), std::vector<std::exception_ptr>(mutations.size()),
+            [this, &schemas, &mutations, timeout] (std::vector<std::vector<size_t>>& per_shard, std::vector<std::exception_ptr>& errors) {
+        return parallel_for_each(boost::irange(0u, smp::count), [this, &schemas, &mutations, timeout, &per_shard, &errors] (unsigned shard) {
+            auto& indexes = per_shard[shard];
+            if (indexes.empty()) {
+                return make_ready_future<>();
+            }
+            get_stats().replica_cross_shard_ops += shard != this_shard_id();
+            std::vector<global_schema_ptr> gss;
+            gss.reserve(indexes.size());
+            for (auto i : indexes) {
+                gss.emplace_back(schemas[i]);
+            }
+            return _db.invoke_on(shard, {_write_smp_service_group, timeout}, [&indexes, &mutations, gss = std::move(gss), timeout] (database& db) {
+                return do_with(std::vector<std::exception_ptr>(indexes.size()), [&db, &indexes, &mutations, &gss, timeout] (std::vector<std::exception_ptr>& errors) {
+                    return parallel_for_each(boost::irange<size_t>(0, indexes.size()), [&db, &indexes, &mutations, &gss, &errors, timeout] (size_t j) {
+                        return futurize_invoke([&] {
+                            return db.apply(gss[j], mutations[indexes[j]], db::commitlog::force_sync::no, timeout);
+                        }).handle_exception([&errors, j] (std::exception_ptr eptr) {
+                            errors[j] = std::move(eptr);
+                        });
+                    }).then([&errors] {
+                        return std::move(errors);
+                    });
+                });
+            }).then_wrapped([&indexes, &errors] (future<std::vector<std::exception_ptr>> f) {
+                if (f.failed()) {
+                    auto eptr = f.get_exception();
+                    for (auto i : indexes) {
+                        errors[i] = eptr;
+                    }
+                    return;
+                }
+                auto shard_errors = f.get0();
+                for (size_t j = 0; j < indexes.size(); ++j) {
+                    errors[indexes[j]] = std::move(shard_errors[j]);
+                }
+            });
+        }).then([&errors] {
+            return std::move(errors);
+        });
+    });
+}
+
 future<>
 storage_proxy::mutate_hint(const schema_ptr& s, const frozen_mutation& m, clock_type::time_point timeout) {
     auto shard = _db.local().shard_of(m);
@@ -1821,12 +1969,84 @@ storage_proxy::mutate_counter_on_leader_and_replicate(const schema_ptr& s, froze
     return _db.invoke_on(shard, {_write_smp_service_group, timeout}, [gs = global_schema_ptr(s), fm = std::move(fm), cl, timeout, gt = tracing::global_trace_state_ptr(std::move(trace_state)), permit = std::move(permit), local] (database& db) {
         auto trace_state = gt.get();
         auto p = local ? std::move(permit) : /* FIXME: either obtain a real permit on this shard or hold original one across shard */ empty_service_permit();
+        auto& sp = service::get_local_storage_proxy();
+        if (sp.should_coalesce_counter_update(*gs.get())) {
+            return sp.coalesce_counter_update(fm.unfreeze(gs.get()), cl, timeout, std::move(trace_state)).finally([p = std::move(p)] { });
+        }
         return db.apply_counter_update(gs, fm, timeout, trace_state).then([cl, timeout, trace_state, p = std::move(p)] (mutation m) mutable {
             return service::get_local_storage_proxy().replicate_counter_from_leader(std::move(m), cl, std::move(trace_state), timeout, std::move(p));
         });
     });
 }
 
+bool storage_proxy::should_coalesce_counter_update(const schema& s) const {
+    auto& cfg = _db.local().get_config();
+    if (!cfg.counter_update_coalescing_window_in_us()) {
+        return false;
+    }
+    return boost::algorithm::any_of(cfg.counter_update_coalescing_tables(), [&s] (const sstring& name) {
+        return name.size() == s.ks_name().size() + 1 + s.cf_name().size()
+                && name.find(s.ks_name()) == 0 && name[s.ks_name().size()] == '.'
+                && name.compare(s.ks_name().size() + 1, sstring::npos, s.cf_name()) == 0;
+    });
+}
+
+// Above this many updates to a partition, the coalesced updates are applied
+// without waiting for the window to close.
+static constexpr size_t max_coalesced_counter_updates = 1024;
+
+future<> storage_proxy::coalesce_counter_update(mutation m, db::consistency_level cl, clock_type::time_point timeout, tracing::trace_state_ptr trace_state) {
+    auto key = coalesced_counter_update_key(m.schema()->id(), m.token(), to_bytes(m.key().representation()), cl);
+    auto& u = _coalesced_counter_updates[key];
+    if (!u.m) {
+        u.m = std::move(m);
+        u.timeout = timeout;
+        u.trace_state = std::move(trace_state);
+    } else {
+        // Deltas of counter updates add up when mutations are merged.
+        m.upgrade(u.m->schema());
+        u.m->apply(std::move(m));
+        // The merged update carries a single timeout, so use the earliest one.
+        u.timeout = std::min(u.timeout, timeout);
+        tracing::trace(trace_state, "Counter update coalesced with {} others", u.count);
+        ++get_stats().coalesced_counter_updates;
+    }
+    ++u.count;
+    auto f = u.done->get_shared_future();
+    if (u.count >= max_coalesced_counter_updates) {
+        auto nh = _coalesced_counter_updates.extract(key);
+        apply_coalesced_counter_update(cl, std::move(nh.mapped()));
+    } else if (!_counter_update_coalescing_timer.armed()) {
+        _counter_update_coalescing_timer.arm(std::chrono::microseconds(_db.local().get_config().counter_update_coalescing_window_in_us()));
+    }
+    return f;
+}
+
+void storage_proxy::apply_coalesced_counter_update(db::consistency_level cl, coalesced_counter_update u) {
+    auto s = u.m->schema();
+    auto fm = make_lw_shared<frozen_mutation>(freeze(*u.m));
+    auto timeout = u.timeout;
+    (void)futurize_invoke([this, s, fm, timeout, trace_state = u.trace_state] {
+        return _db.local().apply_counter_update(s, *fm, timeout, trace_state);
+    }).then([this, p = shared_from_this(), cl, timeout, trace_state = u.trace_state, fm] (mutation m) {
+        return replicate_counter_from_leader(std::move(m), cl, std::move(trace_state), timeout, empty_service_permit());
+    }).then_wrapped([done = std::move(u.done)] (future<> f) {
+        if (f.failed()) {
+            done->set_exception(f.get_exception());
+        } else {
+            done->set_value();
+        }
+    });
+}
+
+void storage_proxy::flush_coalesced_counter_updates() {
+    _counter_update_coalescing_timer.cancel();
+    auto updates = std::exchange(_coalesced_counter_updates, {});
+    for (auto& [key, u] : updates) {
+        apply_coalesced_counter_update(std::get<db::consistency_level>(key), std::move(u));
+    }
+}
+
 future<>
 storage_proxy::mutate_streaming_mutation(const schema_ptr& s, utils::UUID plan_id, const frozen_mutation& m, bool fragmented) {
     auto shard = _db.local().shard_of(m);
@@ -2001,7 +2221,14 @@ future<std::vector<storage_proxy::unique_response_handler>> storage_proxy::mutat
 
 future<> storage_proxy::mutate_begin(std::vector<unique_response_handler> ids, db::consistency_level cl,
                                      std::optional<clock_type::time_point> timeout_opt) {
-    return parallel_for_each(ids, [this, cl, timeout_opt] (unique_response_handler& protected_response) {
+    // Mutations of a batch going to the same replica are sent together, once
+    // all of them have been handed to send_to_live_endpoints() below.
+    std::optional<replica_batches> batches;
+    if (ids.size() > 1 && _features.cluster_supports_mutation_batches()) {
+        batches.emplace();
+    }
+    auto timeout = timeout_opt.value_or(clock_type::now() + std::chrono::milliseconds(_db.local().get_config().write_request_timeout_in_ms()));
+    auto f = parallel_for_each(ids, [this, cl, timeout, batches = batches ? &*batches : nullptr] (unique_response_handler& protected_response) {
         auto response_id = protected_response.id;
         // This function, mutate_begin(), is called after a preemption point
         // so it's possible that other code besides our caller just ran. In
@@ -2026,12 +2253,15 @@ future<> storage_proxy::mutate_begin(std::vector<unique_response_handler> ids, d
         // frozen_mutation copy, or manage handler live time differently.
         hint_to_dead_endpoints(response_id, cl);
 
-        auto timeout = timeout_opt.value_or(clock_type::now() + std::chrono::milliseconds(_db.local().get_config().write_request_timeout_in_ms()));
         // call before send_to_live_endpoints() for the same reason as above
         auto f = response_wait(response_id, timeout);
-        send_to_live_endpoints(protected_response.release(), timeout); // response is now running and it will either complete or timeout
+        send_to_live_endpoints(protected_response.release(), timeout, batches); // response is now running and it will either complete or timeout
         return f;
     });
+    if (batches) {
+        send_replica_batches(std::move(*batches), timeout);
+    }
+    return f;
 }
 
 // this function should be called with a future that holds result of mutation attempt (usually
@@ -2041,6 +2271,7 @@ future<> storage_proxy::mutate_end(future<> mutate_result, utils::latency_counte
     stats.write.mark(lc.stop().latency());
     if (lc.is_start()) {
         stats.estimated_write.add(lc.latency(), stats.write.hist.count);
+        stats.decaying_write.add(std::chrono::duration_cast<std::chrono::microseconds>(lc.latency()));
     }
     try {
         mutate_result.get();
@@ -2233,6 +2464,9 @@ future<> storage_proxy::mutate(std::vector<mutation> mutations, db::consistency_
 }
 
 future<> storage_proxy::do_mutate(std::vector<mutation> mutations, db::consistency_level cl, clock_type::time_point timeout, tracing::trace_state_ptr tr_state, service_permit permit, bool raw_counters, lw_shared_ptr<cdc::operation_result_tracker> cdc_tracker) {
+    if (mutations.size() == 1 && !cdc_tracker && is_sole_local_replica_write(mutations.front(), cl)) {
+        return mutate_sole_local_replica(std::move(mutations.front()), cl, timeout, std::move(tr_state), std::move(permit));
+    }
     auto mid = raw_counters ? mutations.begin() : boost::range::partition(mutations, [] (auto&& m) {
         return m.schema()->is_counter();
     });
@@ -2242,6 +2476,44 @@ future<> storage_proxy::do_mutate(std::vector<mutation> mutations, db::consisten
     );
 }
 
+bool storage_proxy::is_sole_local_replica_write(const mutation& m, db::consistency_level cl) {
+    if ((cl != db::consistency_level::ONE && cl != db::consistency_level::LOCAL_ONE) || m.schema()->is_counter()) {
+        return false;
+    }
+    auto& db = _db.local();
+    if (db.shard_of(m) != this_shard_id()) {
+        return false;
+    }
+    // Writes to tables with views may have to be throttled by the view
+    // update backlog, which is the business of the write response handler.
+    if (!db.find_column_family(m.schema()).views().empty()) {
+        return false;
+    }
+    auto& ks_name = m.schema()->ks_name();
+    auto eps = db.find_keyspace(ks_name).get_replication_strategy().get_natural_endpoints(m.token());
+    return eps.size() == 1 && fbu::is_me(eps.front()) && _token_metadata.pending_endpoints_for(m.token(), ks_name).empty();
+}
+
+future<> storage_proxy::mutate_sole_local_replica(mutation m, db::consistency_level cl, clock_type::time_point timeout,
+        tracing::trace_state_ptr tr_state, service_permit permit) {
+    utils::latency_counter lc;
+    lc.start();
+    get_stats().local_replica_writes++;
+    tracing::trace(tr_state, "Applying the mutation on the local replica, the only one");
+    auto s = m.schema();
+    auto fm = make_lw_shared<frozen_mutation>(freeze(m));
+    return futurize_invoke([this, s = std::move(s), fm, timeout] {
+        return _db.local().apply(s, *fm, db::commitlog::force_sync::no, timeout);
+    }).then_wrapped([this, p = shared_from_this(), lc, fm, m = std::move(m), cl, timeout, tr_state = std::move(tr_state), permit = std::move(permit)] (future<> f) mutable {
+        if (f.failed()) {
+            slogger.debug("Local replica write failed, retrying with a write handler: {}", f.get_exception());
+            get_stats().local_replica_write_fallbacks++;
+            return mutate_internal(std::array<mutation, 1>{std::move(m)}, cl, false, std::move(tr_state), std::move(permit), timeout);
+        }
+        return mutate_end(std::move(f), lc, get_stats(), std::move(tr_state));
+    });
+}
+
 future<> storage_proxy::replicate_counter_from_leader(mutation m, db::consistency_level cl, tracing::trace_state_ptr tr_state,
                                                       clock_type::time_point timeout, service_permit permit) {
     // FIXME: do not send the mutation to itself, it has already been applied (it is not incorrect to do so, though)
@@ -2273,11 +2545,13 @@ storage_proxy::mutate_internal(Range mutations, db::consistency_level cl, bool c
     utils::latency_counter lc;
     lc.start();
 
-    return mutate_prepare(mutations, cl, type, tr_state, std::move(permit)).then([this, cl, timeout_opt, tracker = std::move(cdc_tracker)] (std::vector<storage_proxy::unique_response_handler> ids) {
-        register_cdc_operation_result_tracker(ids, tracker);
-        return mutate_begin(std::move(ids), cl, timeout_opt);
-    }).then_wrapped([this, p = shared_from_this(), lc, tr_state] (future<> f) mutable {
-        return p->mutate_end(std::move(f), lc, get_stats(), std::move(tr_state));
+    return utils::sample_latency(utils::latency_stage::coordinator_write, [&] {
+        return mutate_prepare(mutations, cl, type, tr_state, std::move(permit)).then([this, cl, timeout_opt, tracker = std::move(cdc_tracker)] (std::vector<storage_proxy::unique_response_handler> ids) {
+            register_cdc_operation_result_tracker(ids, tracker);
+            return mutate_begin(std::move(ids), cl, timeout_opt);
+        }).then_wrapped([this, p = shared_from_this(), lc, tr_state] (future<> f) mutable {
+            return p->mutate_end(std::move(f), lc, get_stats(), std::move(tr_state));
+        });
     });
 }
 
@@ -2430,6 +2704,18 @@ future<> storage_proxy::send_to_endpoint(
         db::write_type type,
         write_stats& stats,
         allow_hints allow_hints) {
+    std::vector<std::unique_ptr<mutation_holder>> ms;
+    ms.push_back(std::move(m));
+    return send_to_endpoint(std::move(ms), std::move(target), std::move(pending_endpoints), type, stats, allow_hints);
+}
+
+future<> storage_proxy::send_to_endpoint(
+        std::vector<std::unique_ptr<mutation_holder>> ms,
+        gms::inet_address target,
+        std::vector<gms::inet_address> pending_endpoints,
+        db::write_type type,
+        write_stats& stats,
+        allow_hints allow_hints) {
     utils::latency_counter lc;
     lc.start();
 
@@ -2440,7 +2726,7 @@ future<> storage_proxy::send_to_endpoint(
         // and to apply backpressure.
         timeout = clock_type::now() + 5min;
     }
-    return mutate_prepare(std::array{std::move(m)}, cl, type, /* does view building should hold a real permit */ empty_service_permit(),
+    return mutate_prepare(std::move(ms), cl, type, /* does view building should hold a real permit */ empty_service_permit(),
             [this, target = std::array{target}, pending_endpoints = std::move(pending_endpoints), &stats] (
                 std::unique_ptr<mutation_holder>& m,
                 db::consistency_level cl,
@@ -2505,6 +2791,27 @@ future<> storage_proxy::send_to_endpoint(
             allow_hints);
 }
 
+future<> storage_proxy::send_to_endpoint(
+        std::vector<frozen_mutation_and_schema> fms,
+        gms::inet_address target,
+        std::vector<gms::inet_address> pending_endpoints,
+        db::write_type type,
+        write_stats& stats,
+        allow_hints allow_hints) {
+    std::vector<std::unique_ptr<mutation_holder>> ms;
+    ms.reserve(fms.size());
+    for (auto& fm_a_s : fms) {
+        ms.push_back(std::make_unique<shared_mutation>(std::move(fm_a_s)));
+    }
+    return send_to_endpoint(
+            std::move(ms),
+            std::move(target),
+            std::move(pending_endpoints),
+            type,
+            stats,
+            allow_hints);
+}
+
 future<> storage_proxy::send_hint_to_endpoint(frozen_mutation_and_schema fm_a_s, gms::inet_address target) {
     if (!_features.cluster_supports_hinted_handoff_separate_connection()) {
         return send_to_endpoint(
@@ -2525,6 +2832,26 @@ future<> storage_proxy::send_hint_to_endpoint(frozen_mutation_and_schema fm_a_s,
             allow_hints::no);
 }
 
+future<> storage_proxy::send_hints_to_endpoint(std::vector<frozen_mutation_and_schema> fms, gms::inet_address target) {
+    const bool separate_connection = _features.cluster_supports_hinted_handoff_separate_connection();
+    std::vector<std::unique_ptr<mutation_holder>> ms;
+    ms.reserve(fms.size());
+    for (auto& fm_a_s : fms) {
+        if (separate_connection) {
+            ms.push_back(std::make_unique<hint_mutation>(std::move(fm_a_s)));
+        } else {
+            ms.push_back(std::make_unique<shared_mutation>(std::move(fm_a_s)));
+        }
+    }
+    return send_to_endpoint(
+            std::move(ms),
+            std::move(target),
+            { },
+            db::write_type::SIMPLE,
+            get_stats(),
+            allow_hints::no);
+}
+
 future<> storage_proxy::send_hint_to_all_replicas(frozen_mutation_and_schema fm_a_s) {
     const auto timeout = db::timeout_clock::now() + 1h;
     if (!_features.cluster_supports_hinted_handoff_separate_connection()) {
@@ -2551,7 +2878,7 @@ future<> storage_proxy::send_hint_to_all_replicas(frozen_mutation_and_schema fm_
  * @throws OverloadedException if the hints cannot be written/enqueued
  */
  // returned future is ready when sent is complete, not when mutation is executed on all (or any) targets!
-void storage_proxy::send_to_live_endpoints(storage_proxy::response_id_type response_id, clock_type::time_point timeout)
+void storage_proxy::send_to_live_endpoints(storage_proxy::response_id_type response_id, clock_type::time_point timeout, replica_batches* batches)
 {
     // extra-datacenter replicas, grouped by dc
     std::unordered_map<sstring, std::vector<gms::inet_address>> dc_groups;
@@ -2575,6 +2902,7 @@ void storage_proxy::send_to_live_endpoints(storage_proxy::response_id_type respo
 
     auto all = boost::range::join(local, dc_groups);
     auto my_address = utils::fb_utilities::get_broadcast_address();
+    auto coalesce = !batches && write_coalescing_window().count() && _features.cluster_supports_mutation_batches();
 
     // lambda for applying mutation locally
     auto lmutate = [handler_ptr, response_id, this, my_address, timeout] () mutable {
@@ -2620,6 +2948,14 @@ void storage_proxy::send_to_live_endpoints(storage_proxy::response_id_type respo
 
             if (coordinator == my_address) {
                 f = futurize_invoke(lmutate);
+            } else if ((batches || coalesce) && forward.empty() && handler.get_shared_mutation()) {
+                // Sent by send_mutation_batch(), which handles failures.
+                if (batches) {
+                    (*batches)[coordinator].push_back(response_id);
+                } else {
+                    coalesce_write(coordinator, response_id, timeout);
+                }
+                continue;
             } else {
                 f = futurize_invoke(rmutate, coordinator, std::move(forward));
             }
@@ -2628,7 +2964,6 @@ void storage_proxy::send_to_live_endpoints(storage_proxy::response_id_type respo
         // Waited on indirectly.
         (void)f.handle_exception([response_id, forward_size, coordinator, handler_ptr, p = shared_from_this(), &stats] (std::exception_ptr eptr) {
             ++stats.writes_errors.get_ep_stat(coordinator);
-            p->got_failure_response(response_id, coordinator, forward_size + 1, std::nullopt);
             try {
                 std::rethrow_exception(eptr);
             } catch(rpc::closed_error&) {
@@ -2638,13 +2973,115 @@ void storage_proxy::send_to_live_endpoints(storage_proxy::response_id_type respo
             } catch(timed_out_error&) {
                 // from lmutate(). Ignore so that logs are not flooded
                 // database total_writes_timedout counter was incremented.
+            } catch(exceptions::rate_limit_exception&) {
+                // from lmutate(), database total_writes_rate_limited counter was incremented.
+                handler_ptr->on_rate_limited();
             } catch(...) {
                 slogger.error("exception during mutation write to {}: {}", coordinator, std::current_exception());
             }
+            p->got_failure_response(response_id, coordinator, forward_size + 1, std::nullopt);
         });
     }
 }
 
+void storage_proxy::send_replica_batches(replica_batches batches, clock_type::time_point timeout) {
+    for (auto& [ep, ids] : batches) {
+        send_mutation_batch(ep, std::move(ids), timeout);
+    }
+}
+
+void storage_proxy::send_mutation_batch(gms::inet_address ep, std::vector<response_id_type> ids, clock_type::time_point timeout) {
+    auto& ms = netw::get_local_messaging_service();
+    auto my_address = utils::fb_utilities::get_broadcast_address();
+    std::vector<::shared_ptr<abstract_write_response_handler>> handlers;
+    std::vector<std::reference_wrapper<const frozen_mutation>> fms;
+    handlers.reserve(ids.size());
+    fms.reserve(ids.size());
+    size_t msize = 0;
+    tracing::trace_state_ptr tr_state;
+    // Coalesced writes may have been cancelled, e.g. by on_down(), while
+    // waiting to be sent.
+    auto live = boost::remove_if(ids, [this] (response_id_type id) {
+        return _response_handlers.find(id) == _response_handlers.end();
+    });
+    ids.erase(live, ids.end());
+    if (ids.empty()) {
+        return;
+    }
+    for (auto id : ids) {
+        auto& h = get_write_response_handler(id);
+        // The handler keeps the mutation alive until the message is sent.
+        fms.push_back(std::cref(*h->get_shared_mutation()));
+        msize += h->get_mutation_size();
+        if (!tr_state) {
+            tr_state = h->get_trace_state();
+        }
+        handlers.push_back(h);
+    }
+    _global_stats.queued_write_bytes += msize;
+    ++get_stats().sent_mutation_batches;
+    tracing::trace(tr_state, "Sending {} mutations to /{}", fms.size(), ep);
+
+    auto f = futurize_invoke([&] {
+        return ms.send_mutations(netw::messaging_service::msg_addr{ep, 0}, timeout, fms, my_address, this_shard_id(),
+                ids, tracing::make_trace_info(tr_state));
+    });
+    // Waited on indirectly.
+    (void)f.then_wrapped([this, p = shared_from_this(), ep, ids = std::move(ids), handlers = std::move(handlers), msize] (future<> f) {
+        _global_stats.queued_write_bytes -= msize;
+        unthrottle();
+        if (!f.failed()) {
+            return;
+        }
+        auto eptr = f.get_exception();
+        for (size_t i = 0; i < ids.size(); ++i) {
+            ++handlers[i]->stats().writes_errors.get_ep_stat(ep);
+            got_failure_response(ids[i], ep, 1, std::nullopt);
+        }
+        try {
+            std::rethrow_exception(eptr);
+        } catch(rpc::closed_error&) {
+            // ignore, disconnect will be logged by gossiper
+        } catch(seastar::gate_closed_exception&) {
+            // may happen during shutdown, ignore it
+        } catch(...) {
+            slogger.error("exception during mutation batch write to {}: {}", ep, std::current_exception());
+        }
+    });
+}
+
+std::chrono::microseconds storage_proxy::write_coalescing_window() const {
+    return std::chrono::microseconds(_db.local().get_config().write_coalescing_window_in_us());
+}
+
+// Above this many writes for a replica, the coalesced writes are sent
+// without waiting for the window to close.
+static constexpr size_t max_coalesced_writes = 128;
+
+void storage_proxy::coalesce_write(gms::inet_address ep, response_id_type id, clock_type::time_point timeout) {
+    auto& w = _coalesced_writes[ep];
+    // The message carries a single timeout, so use the earliest one.
+    w.timeout = w.ids.empty() ? timeout : std::min(w.timeout, timeout);
+    w.ids.push_back(id);
+    ++get_stats().coalesced_writes;
+    if (w.ids.size() >= max_coalesced_writes) {
+        auto ids = std::move(w.ids);
+        auto t = w.timeout;
+        _coalesced_writes.erase(ep);
+        send_mutation_batch(ep, std::move(ids), t);
+    } else if (!_write_coalescing_timer.armed()) {
+        _write_coalescing_timer.arm(write_coalescing_window());
+    }
+}
+
+void storage_proxy::flush_coalesced_writes() {
+    _write_coalescing_timer.cancel();
+    auto writes = std::exchange(_coalesced_writes, {});
+    for (auto& [ep, w] : writes) {
+        send_mutation_batch(ep, std::move(w.ids), w.timeout);
+    }
+}
+
 // returns number of hints stored
 template<typename Range>
 size_t storage_proxy::hint_to_dead_endpoints(std::unique_ptr<mutation_holder>& mh, const Range& targets, db::write_type type, tracing::trace_state_ptr tr_state) noexcept
@@ -2667,6 +3104,83 @@ future<> storage_proxy::schedule_repair(std::unordered_map<dht::token, std::unor
     return mutate_internal(diffs | boost::adaptors::map_values, cl, false, std::move(trace_state), std::move(permit));
 }
 
+// Above this many partitions waiting for deferred read repair, the repairs of
+// further reads are dropped.
+static constexpr size_t max_deferred_read_repairs = 10000;
+// Deferred read repairs are sent in batches at this interval.
+static constexpr auto deferred_read_repair_interval = std::chrono::milliseconds(100);
+
+bool storage_proxy::should_defer_read_repair(db::consistency_level cl) const {
+    // Reads at these levels don't promise that a following read sees what they
+    // returned, so they needn't wait for the replicas they read from to agree.
+    return _db.local().get_config().deferred_read_repair()
+            && (cl == db::consistency_level::ONE || cl == db::consistency_level::LOCAL_ONE || cl == db::consistency_level::LOCAL_QUORUM);
+}
+
+void storage_proxy::defer_read_repair(std::unordered_map<dht::token, std::unordered_map<gms::inet_address, std::optional<mutation>>> diffs) {
+    for (auto& [token, diff] : diffs) {
+        auto it = boost::find_if(diff, [] (auto& ep_m) { return bool(ep_m.second); });
+        if (it == diff.end()) {
+            continue;
+        }
+        auto& m0 = *it->second;
+        auto key = deferred_read_repair_key(m0.schema()->id(), token, to_bytes(m0.key().representation()));
+        auto queued = _deferred_read_repairs.find(key);
+        if (queued == _deferred_read_repairs.end()) {
+            if (_deferred_read_repairs.size() >= max_deferred_read_repairs) {
+                ++get_stats().deferred_read_repairs_dropped;
+                continue;
+            }
+            _deferred_read_repairs.emplace(std::move(key), std::move(diff));
+            ++get_stats().deferred_read_repairs_queued;
+            continue;
+        }
+        // Another read found the same partition out of date, merge what both
+        // found missing on each replica.
+        for (auto& [ep, m] : diff) {
+            auto& dst = queued->second[ep];
+            if (!m) {
+                continue;
+            }
+            if (!dst) {
+                dst = std::move(m);
+            } else {
+                m->upgrade(dst->schema());
+                dst->apply(std::move(*m));
+            }
+        }
+    }
+    if (!_deferred_read_repairs.empty() && !_deferred_read_repair_timer.armed()) {
+        _deferred_read_repair_timer.arm(deferred_read_repair_interval);
+    }
+}
+
+void storage_proxy::send_deferred_read_repairs() {
+    auto per_interval = std::chrono::duration_cast<std::chrono::duration<double>>(deferred_read_repair_interval).count();
+    auto batch_size = std::max<size_t>(1, _db.local().get_config().deferred_read_repair_rate() * per_interval);
+    std::vector<std::unordered_map<gms::inet_address, std::optional<mutation>>> batch;
+    while (!_deferred_read_repairs.empty() && batch.size() < batch_size) {
+        auto nh = _deferred_read_repairs.extract(_deferred_read_repairs.begin());
+        batch.push_back(std::move(nh.mapped()));
+    }
+    if (!_deferred_read_repairs.empty()) {
+        _deferred_read_repair_timer.arm(deferred_read_repair_interval);
+    }
+    auto count = batch.size();
+    // The writes only need to reach one replica to be useful, the others get
+    // hints like any write they miss.
+    (void)futurize_invoke([this, batch = std::move(batch)] () mutable {
+        return mutate_internal(std::move(batch), db::consistency_level::ONE, false, nullptr, empty_service_permit());
+    }).then_wrapped([this, p = shared_from_this(), count] (future<> f) {
+        if (f.failed()) {
+            slogger.debug("Deferred read repair failed: {}", f.get_exception());
+            get_stats().deferred_read_repairs_failed += count;
+        } else {
+            get_stats().deferred_read_repairs_applied += count;
+        }
+    });
+}
+
 class abstract_read_resolver {
 protected:
     db::consistency_level _cl;
@@ -2713,6 +3227,13 @@ class abstract_read_resolver {
         } catch (rpc::timeout_error&) {
             // do not report timeouts, the whole operation will timeout and be reported
             return; // also do not report timeout as replica failure for the same reason
+        } catch (exceptions::rate_limit_exception&) {
+            // The local replica rejected the read, the others see the same
+            // traffic for the partition so don't wait for them.
+            if (!_request_failed) {
+                fail_request(eptr);
+            }
+            return;
         } catch(...) {
             slogger.error("Exception when communicating with {}: {}", ep, eptr);
         }
@@ -3359,13 +3880,22 @@ class abstract_read_executor : public enable_shared_from_this<abstract_read_exec
         } else {
             auto& ms = netw::get_local_messaging_service();
             tracing::trace(_trace_state, "read_mutation_data: sending a message to /{}", ep);
-            return ms.send_read_mutation_data(netw::messaging_service::msg_addr{ep, 0}, timeout, *cmd, _partition_range).then([this, ep](rpc::tuple<reconcilable_result, rpc::optional<cache_temperature>> result_and_hit_rate) {
+            return ms.send_read_mutation_data(ms.addr_for_token(ep, start_token(_partition_range)), timeout, *cmd, _partition_range).then([this, ep](rpc::tuple<reconcilable_result, rpc::optional<cache_temperature>> result_and_hit_rate) {
                 auto&& [result, hit_rate] = result_and_hit_rate;
                 tracing::trace(_trace_state, "read_mutation_data: got response from /{}", ep);
                 return make_ready_future<rpc::tuple<foreign_ptr<lw_shared_ptr<reconcilable_result>>, cache_temperature>>(rpc::tuple(make_foreign(::make_lw_shared<reconcilable_result>(std::move(result))), hit_rate.value_or(cache_temperature::invalid())));
             });
         }
     }
+    // Accounts the request to the replica's read score (see replica_read_scores).
+    template <typename Func>
+    futurize_t<std::invoke_result_t<Func>> score_replica_read(gms::inet_address ep, Func&& func) {
+        _proxy->_replica_read_scores.on_read_start(ep);
+        auto start = replica_read_scores::clock_type::now();
+        return futurize_invoke(std::forward<Func>(func)).finally([p = _proxy, ep, start] {
+            p->_replica_read_scores.on_read_end(ep, replica_read_scores::clock_type::now() - start);
+        });
+    }
     future<rpc::tuple<foreign_ptr<lw_shared_ptr<query::result>>, cache_temperature>> make_data_request(gms::inet_address ep, clock_type::time_point timeout, bool want_digest) {
         ++_proxy->get_stats().data_read_attempts.get_ep_stat(ep);
         auto opts = want_digest
@@ -3377,7 +3907,7 @@ class abstract_read_executor : public enable_shared_from_this<abstract_read_exec
         } else {
             auto& ms = netw::get_local_messaging_service();
             tracing::trace(_trace_state, "read_data: sending a message to /{}", ep);
-            return ms.send_read_data(netw::messaging_service::msg_addr{ep, 0}, timeout, *_cmd, _partition_range, opts.digest_algo).then([this, ep](rpc::tuple<query::result, rpc::optional<cache_temperature>> result_hit_rate) {
+            return ms.send_read_data(ms.addr_for_token(ep, start_token(_partition_range)), timeout, *_cmd, _partition_range, opts.digest_algo).then([this, ep](rpc::tuple<query::result, rpc::optional<cache_temperature>> result_hit_rate) {
                 auto&& [result, hit_rate] = result_hit_rate;
                 tracing::trace(_trace_state, "read_data: got response from /{}", ep);
                 return make_ready_future<rpc::tuple<foreign_ptr<lw_shared_ptr<query::result>>, cache_temperature>>(rpc::tuple(make_foreign(::make_lw_shared<query::result>(std::move(result))), hit_rate.value_or(cache_temperature::invalid())));
@@ -3393,7 +3923,7 @@ class abstract_read_executor : public enable_shared_from_this<abstract_read_exec
         } else {
             auto& ms = netw::get_local_messaging_service();
             tracing::trace(_trace_state, "read_digest: sending a message to /{}", ep);
-            return ms.send_read_digest(netw::messaging_service::msg_addr{ep, 0}, timeout, *_cmd,
+            return ms.send_read_digest(ms.addr_for_token(ep, start_token(_partition_range)), timeout, *_cmd,
                         _partition_range, digest_algorithm(*_proxy)).then([this, ep] (
                     rpc::tuple<query::result_digest, rpc::optional<api::timestamp_type>, rpc::optional<cache_temperature>> digest_timestamp_hit_rate) {
                 auto&& [d, t, hit_rate] = digest_timestamp_hit_rate;
@@ -3419,7 +3949,7 @@ class abstract_read_executor : public enable_shared_from_this<abstract_read_exec
     }
     future<> make_data_requests(digest_resolver_ptr resolver, targets_iterator begin, targets_iterator end, clock_type::time_point timeout, bool want_digest) {
         return parallel_for_each(begin, end, [this, resolver = std::move(resolver), timeout, want_digest] (gms::inet_address ep) {
-            return make_data_request(ep, timeout, want_digest).then_wrapped([this, resolver, ep] (future<rpc::tuple<foreign_ptr<lw_shared_ptr<query::result>>, cache_temperature>> f) {
+            return score_replica_read(ep, [&] { return make_data_request(ep, timeout, want_digest); }).then_wrapped([this, resolver, ep] (future<rpc::tuple<foreign_ptr<lw_shared_ptr<query::result>>, cache_temperature>> f) {
                 try {
                     auto v = f.get0();
                     _cf->set_hit_rate(ep, std::get<1>(v));
@@ -3435,7 +3965,7 @@ class abstract_read_executor : public enable_shared_from_this<abstract_read_exec
     }
     future<> make_digest_requests(digest_resolver_ptr resolver, targets_iterator begin, targets_iterator end, clock_type::time_point timeout) {
         return parallel_for_each(begin, end, [this, resolver = std::move(resolver), timeout] (gms::inet_address ep) {
-            return make_digest_request(ep, timeout).then_wrapped([this, resolver, ep] (future<rpc::tuple<query::result_digest, api::timestamp_type, cache_temperature>> f) {
+            return score_replica_read(ep, [&] { return make_digest_request(ep, timeout); }).then_wrapped([this, resolver, ep] (future<rpc::tuple<query::result_digest, api::timestamp_type, cache_temperature>> f) {
                 try {
                     auto v = f.get0();
                     _cf->set_hit_rate(ep, std::get<2>(v));
@@ -3493,6 +4023,13 @@ class abstract_read_executor : public enable_shared_from_this<abstract_read_exec
                     // wait for write to complete before returning result to prevent multiple concurrent read requests to
                     // trigger repair multiple times and to prevent quorum read to return an old value, even after a quorum
                     // another read had returned a newer value (but the newer value had not yet been sent to the other replicas)
+                    if (_proxy->should_defer_read_repair(_cl)) {
+                        tracing::trace(_trace_state, "Deferring read repair");
+                        _proxy->defer_read_repair(data_resolver->get_diffs_for_repair());
+                        _result_promise.set_value(std::move(result));
+                        on_read_resolved();
+                        return;
+                    }
                     // Waited on indirectly.
                     (void)_proxy->schedule_repair(data_resolver->get_diffs_for_repair(), _cl, _trace_state, _permit).then([this, result = std::move(result)] () mutable {
                         _result_promise.set_value(std::move(result));
@@ -3653,6 +4190,10 @@ class speculating_read_executor : public abstract_read_executor {
     virtual future<> make_requests(digest_resolver_ptr resolver, storage_proxy::clock_type::time_point timeout) {
         _speculate_timer.set_callback([this, resolver, timeout] {
             if (!resolver->is_completed()) { // at the time the callback runs request may be completed already
+                if (!_cf->try_consume_speculative_retry()) {
+                    _proxy->get_stats().speculative_reads_throttled++;
+                    return;
+                }
                 resolver->add_wait_targets(1); // we send one more request so wait for it too
                 // FIXME: consider disabling for CL=*ONE
                 auto send_request = [&] (bool has_data) {
@@ -3668,10 +4209,23 @@ class speculating_read_executor : public abstract_read_executor {
                 (void)send_request(resolver->has_data()).finally([exec = shared_from_this()]{});
             }
         });
+        auto& cfg = _proxy->get_db().local().get_config();
+        _cf->earn_speculative_retry(cfg.speculative_retry_budget());
         auto& sr = _schema->speculative_retry();
-        auto t = (sr.get_type() == speculative_retry::type::PERCENTILE) ?
-            std::min(_cf->get_coordinator_read_latency_percentile(sr.get_value()), std::chrono::milliseconds(_proxy->get_db().local().get_config().read_request_timeout_in_ms()/2)) :
-            std::chrono::milliseconds(unsigned(sr.get_value()));
+        auto cap = std::chrono::microseconds(std::chrono::milliseconds(cfg.read_request_timeout_in_ms() / 2));
+        std::chrono::microseconds t;
+        switch (sr.get_type()) {
+        case speculative_retry::type::PERCENTILE:
+            t = std::min(_cf->get_coordinator_read_latency_percentile(sr.get_value()).value_or(cap), cap);
+            break;
+        case speculative_retry::type::MIN:
+            cap = std::min(cap, std::chrono::microseconds(int64_t(sr.get_cap_ms() * 1000)));
+            t = std::min(_cf->get_coordinator_read_latency_percentile(sr.get_value()).value_or(cap), cap);
+            break;
+        default:
+            t = std::chrono::microseconds(int64_t(sr.get_value() * 1000));
+            break;
+        }
         _speculate_timer.arm(t);
 
         // if CL + RR result in covering all replicas, getReadExecutor forces AlwaysSpeculating.  So we know
@@ -3746,6 +4300,12 @@ ::shared_ptr<abstract_read_executor> storage_proxy::get_read_executor(lw_shared_
     // orders the list by proximity to the local endpoint.
     is_read_non_local |= !all_replicas.empty() && all_replicas.front() != utils::fb_utilities::get_broadcast_address();
 
+    // With CL=ALL every replica is read anyway.
+    const auto& cfg = _db.local().get_config();
+    if (cl != db::consistency_level::ALL && cfg.latency_read_balancing()) {
+        _replica_read_scores.sort(all_replicas, 1 + cfg.dynamic_snitch_badness_threshold());
+    }
+
     auto cf = _db.local().find_column_family(schema).shared_from_this();
     std::vector<gms::inet_address> target_replicas = db::filter_for_query(cl, ks, all_replicas, preferred_endpoints, repair_decision,
             retry_type == speculative_retry::type::NONE ? nullptr : &extra_replica,
@@ -3811,13 +4371,16 @@ storage_proxy::query_result_local_digest(schema_ptr s, lw_shared_ptr<query::read
 future<rpc::tuple<foreign_ptr<lw_shared_ptr<query::result>>, cache_temperature>>
 storage_proxy::query_result_local(schema_ptr s, lw_shared_ptr<query::read_command> cmd, const dht::partition_range& pr, query::result_options opts,
                                   tracing::trace_state_ptr trace_state, storage_proxy::clock_type::time_point timeout, uint64_t max_size) {
+    max_size = std::min(max_size, cmd->max_result_size);
     cmd->slice.options.set_if<query::partition_slice::option::with_digest>(opts.request != query::result_request::only_result);
-    if (pr.is_singular()) {
-        unsigned shard = dht::shard_of(*s, pr.start()->value().token());
+    // Ranges owned by a single shard, like those of a shard-aware scan, don't need the multishard reader.
+    if (auto shard_opt = dht::single_shard_of(*s, pr)) {
+        unsigned shard = *shard_opt;
         get_stats().replica_cross_shard_ops += shard != this_shard_id();
+        get_stats().replica_single_shard_range_reads += !pr.is_singular();
         return _db.invoke_on(shard, _read_smp_service_group, [max_size, gs = global_schema_ptr(s), prv = dht::partition_range_vector({pr}) /* FIXME: pr is copied */, cmd, opts, timeout, gt = tracing::global_trace_state_ptr(std::move(trace_state))] (database& db) mutable {
             auto trace_state = gt.get();
-            tracing::trace(trace_state, "Start querying the token range that starts with {}", seastar::value_of([&prv] { return prv.begin()->start()->value().token(); }));
+            tracing::trace(trace_state, "Start querying the range {}", seastar::value_of([&prv] { return prv.front(); }));
             return db.query(gs, *cmd, opts, prv, trace_state, max_size, timeout).then([trace_state](auto&& f, cache_temperature ht) {
                 tracing::trace(trace_state, "Querying is done");
                 return make_ready_future<rpc::tuple<foreign_ptr<lw_shared_ptr<query::result>>, cache_temperature>>(rpc::tuple(make_foreign(std::move(f)), ht));
@@ -3833,6 +4396,112 @@ storage_proxy::query_result_local(schema_ptr s, lw_shared_ptr<query::read_comman
     }
 }
 
+future<rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature>>
+storage_proxy::query_partitions_locally(schema_ptr s, lw_shared_ptr<query::read_command> cmd, const dht::partition_range_vector& ranges,
+                                        tracing::trace_state_ptr trace_state, storage_proxy::clock_type::time_point timeout, uint64_t max_size) {
+    max_size = std::min(max_size, cmd->max_result_size);
+    struct shard_reads {
+        std::vector<size_t> indices;
+        dht::partition_range_vector ranges;
+    };
+    auto reads_per_shard = make_lw_shared<std::unordered_map<unsigned, shard_reads>>();
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        auto& reads = (*reads_per_shard)[dht::shard_of(*s, ranges[i].start()->value().token())];
+        reads.indices.push_back(i);
+        reads.ranges.push_back(ranges[i]);
+    }
+    auto results = make_lw_shared<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>>(ranges.size());
+    auto hit_rate = make_lw_shared<cache_temperature>(cache_temperature::invalid());
+    return parallel_for_each(*reads_per_shard, [this, s, cmd, max_size, timeout, trace_state, results, hit_rate] (auto& shard_and_reads) {
+        auto shard = shard_and_reads.first;
+        auto& reads = shard_and_reads.second;
+        get_stats().replica_cross_shard_ops += shard != this_shard_id();
+        return _db.invoke_on(shard, _read_smp_service_group, [max_size, gs = global_schema_ptr(s), cmd, ranges = std::move(reads.ranges), timeout,
+                gt = tracing::global_trace_state_ptr(trace_state)] (database& db) mutable {
+            auto trace_state = gt.get();
+            tracing::trace(trace_state, "Start querying {} partitions", ranges.size());
+            return do_with(std::move(ranges), [&db, s = gs.get(), cmd, max_size, timeout, trace_state] (dht::partition_range_vector& ranges) {
+                return db.query_partitions(s, *cmd, ranges, trace_state, max_size, timeout).then([trace_state] (std::vector<lw_shared_ptr<query::result>> shard_results, cache_temperature ht) {
+                    tracing::trace(trace_state, "Querying is done");
+                    auto foreign_results = boost::copy_range<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>>(shard_results
+                            | boost::adaptors::transformed([] (lw_shared_ptr<query::result>& r) { return make_foreign(std::move(r)); }));
+                    return make_ready_future<rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature>>(rpc::tuple(std::move(foreign_results), ht));
+                });
+            });
+        }).then([&reads, results, hit_rate] (rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature> results_and_hit_rate) {
+            auto&& [shard_results, ht] = results_and_hit_rate;
+            *hit_rate = ht;
+            for (size_t i = 0; i < shard_results.size(); ++i) {
+                (*results)[reads.indices[i]] = std::move(shard_results[i]);
+            }
+        });
+    }).then([reads_per_shard, results, hit_rate] {
+        // Each shard read a prefix of its own partitions. A partition it
+        // didn't read follows one which either was short or reached a limit
+        // with fewer rows than all partitions before it, so nothing from
+        // that point on would make it to the merged result.
+        std::vector<foreign_ptr<lw_shared_ptr<query::result>>> prefix;
+        prefix.reserve(results->size());
+        for (auto& r : *results) {
+            if (!r) {
+                break;
+            }
+            auto is_short_read = r->is_short_read();
+            prefix.push_back(std::move(r));
+            if (is_short_read) {
+                break;
+            }
+        }
+        return make_ready_future<rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature>>(rpc::tuple(std::move(prefix), *hit_rate));
+    });
+}
+
+future<rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature>>
+storage_proxy::query_partitions_on_replica(gms::inet_address ep, schema_ptr s, lw_shared_ptr<query::read_command> cmd, const dht::partition_range_vector& ranges,
+                                           tracing::trace_state_ptr trace_state, storage_proxy::clock_type::time_point timeout) {
+    ++get_stats().data_read_attempts.get_ep_stat(ep);
+    if (fbu::is_me(ep)) {
+        tracing::trace(trace_state, "read_data_partitions: querying {} partitions locally", ranges.size());
+        return query_partitions_locally(std::move(s), std::move(cmd), ranges, std::move(trace_state), timeout);
+    }
+    auto& ms = netw::get_local_messaging_service();
+    tracing::trace(trace_state, "read_data_partitions: sending a message for {} partitions to /{}", ranges.size(), ep);
+    return ms.send_read_data_partitions(ms.addr_for_token(ep, ranges.front().start()->value().token()), timeout, *cmd, ranges).then(
+            [trace_state = std::move(trace_state), ep] (rpc::tuple<std::vector<query::result>, cache_temperature> results_and_hit_rate) {
+        auto&& [results, hit_rate] = results_and_hit_rate;
+        tracing::trace(trace_state, "read_data_partitions: got response from /{}", ep);
+        auto foreign_results = boost::copy_range<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>>(results
+                | boost::adaptors::transformed([] (query::result& r) { return make_foreign(make_lw_shared<query::result>(std::move(r))); }));
+        return make_ready_future<rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature>>(rpc::tuple(std::move(foreign_results), hit_rate));
+    });
+}
+
+bool storage_proxy::is_local_replica(keyspace& ks, const dht::token& token) const {
+    auto eps = ks.get_replication_strategy().get_natural_endpoints(token);
+    return boost::algorithm::any_of(eps, [] (gms::inet_address ep) { return fbu::is_me(ep); });
+}
+
+future<foreign_ptr<lw_shared_ptr<query::result>>>
+storage_proxy::query_local_replica(schema_ptr s, lw_shared_ptr<query::read_command> cmd, const dht::partition_range& pr,
+                                   storage_proxy::clock_type::time_point timeout) {
+    utils::latency_counter lc;
+    lc.start();
+    auto cf = _db.local().find_column_family(s).shared_from_this();
+    return query_result_local(s, cmd, pr, query::result_options::only_result(), nullptr, timeout).then_wrapped(
+            [p = shared_from_this(), lc, cf = std::move(cf)] (future<rpc::tuple<foreign_ptr<lw_shared_ptr<query::result>>, cache_temperature>> f) mutable {
+        if (lc.is_start()) {
+            cf->add_coordinator_read_latency(lc.stop().latency());
+        }
+        if (f.failed()) {
+            auto eptr = f.get_exception();
+            p->handle_read_error(eptr, false);
+            return make_exception_future<foreign_ptr<lw_shared_ptr<query::result>>>(eptr);
+        }
+        auto&& [result, ht] = f.get0();
+        return make_ready_future<foreign_ptr<lw_shared_ptr<query::result>>>(std::move(result));
+    });
+}
+
 void storage_proxy::handle_read_error(std::exception_ptr eptr, bool range) {
     try {
         std::rethrow_exception(eptr);
@@ -3852,72 +4521,218 @@ future<storage_proxy::coordinator_query_result>
 storage_proxy::query_singular(lw_shared_ptr<query::read_command> cmd,
         dht::partition_range_vector&& partition_ranges,
         db::consistency_level cl,
-        storage_proxy::coordinator_query_options query_options) {
-    std::vector<std::pair<::shared_ptr<abstract_read_executor>, dht::token_range>> exec;
-    exec.reserve(partition_ranges.size());
+        storage_proxy::coordinator_query_options query_options,
+        bool allow_local_replica_read) {
+    struct singular_read {
+        size_t index;
+        ::shared_ptr<abstract_read_executor> executor;
+        dht::token_range token_range;
+    };
+    auto exec = make_lw_shared<std::vector<singular_read>>();
+    exec->reserve(partition_ranges.size());
+    // Reads sent to a replica together, without read executors, see below.
+    struct grouped_reads {
+        std::vector<size_t> indices;
+        dht::partition_range_vector ranges;
+    };
+    auto grouped_reads_per_replica = make_lw_shared<std::unordered_map<gms::inet_address, grouped_reads>>();
 
     schema_ptr schema = local_schema_registry().get(cmd->schema_version);
 
     db::read_repair_decision repair_decision = query_options.read_repair_decision
         ? *query_options.read_repair_decision : new_read_repair_decision(*schema);
 
+    // A read of several partitions at CL=ONE, like an IN query, has no
+    // digests to compare and no read repair to coordinate. Its keys are
+    // grouped by the replica a read executor would read them from, and each
+    // replica gets a single READ_DATA_PARTITIONS request for all of its keys,
+    // which each of its shards reads under a single admission. As the
+    // request is made for many keys at once, they aren't sped up by
+    // speculative retries. Keys which are alone in their group, and those of
+    // replicas which may not know the verb yet, go through read executors.
+    const bool group_reads = partition_ranges.size() > 1
+            && (cl == db::consistency_level::ONE || cl == db::consistency_level::LOCAL_ONE)
+            && repair_decision == db::read_repair_decision::NONE;
+    auto& ks = _db.local().find_keyspace(schema->ks_name());
+
+    // A read of a single partition at CL=ONE which this very shard
+    // replicates is served straight from the local database: there is no
+    // replica to pick, no digest to compare and no cross-shard hop. Should
+    // it fail, it is retried through a read executor, which copes with and
+    // reports errors the usual way.
+    if (allow_local_replica_read && partition_ranges.size() == 1 && partition_ranges.front().is_singular()
+            && (cl == db::consistency_level::ONE || cl == db::consistency_level::LOCAL_ONE)
+            && repair_decision == db::read_repair_decision::NONE) {
+        auto& token = partition_ranges.front().start()->value().token();
+        auto token_range = dht::token_range::make_singular(token);
+        auto it = query_options.preferred_replicas.find(token_range);
+        const auto replicas = it == query_options.preferred_replicas.end()
+            ? std::vector<gms::inet_address>{} : replica_ids_to_endpoints(_token_metadata, it->second);
+        if (dht::shard_of(*schema, token) == this_shard_id() && is_local_replica(ks, token)
+                && (replicas.empty() || boost::algorithm::any_of(replicas, [] (gms::inet_address ep) { return fbu::is_me(ep); }))) {
+            get_stats().local_replica_reads++;
+            tracing::trace(query_options.trace_state, "Querying the local replica");
+            utils::latency_counter lc;
+            lc.start();
+            auto cf = _db.local().find_column_family(schema).shared_from_this();
+            auto timeout = query_options.timeout(*this);
+            return do_with(dht::partition_range_vector({partition_ranges.front()}),
+                    [this, schema, cmd, timeout, trace_state = query_options.trace_state] (dht::partition_range_vector& prv) {
+                return _db.local().query(schema, *cmd, query::result_options::only_result(), prv, trace_state, cmd->max_result_size, timeout);
+            }).then_wrapped([this, p = shared_from_this(), lc, cf = std::move(cf), cmd, partition_ranges = std::move(partition_ranges), cl,
+                    query_options = std::move(query_options), token_range = std::move(token_range)] (future<lw_shared_ptr<query::result>, cache_temperature> f) mutable {
+                if (f.failed()) {
+                    slogger.debug("Local replica read failed, retrying with a read executor: {}", f.get_exception());
+                    get_stats().local_replica_read_fallbacks++;
+                    return query_singular(std::move(cmd), std::move(partition_ranges), cl, std::move(query_options), false);
+                }
+                if (lc.is_start()) {
+                    cf->add_coordinator_read_latency(lc.stop().latency());
+                }
+                auto&& [result, ht] = f.get();
+                replicas_per_token_range used_replicas;
+                used_replicas.emplace(std::move(token_range), endpoints_to_replica_ids(_token_metadata, {utils::fb_utilities::get_broadcast_address()}));
+                return make_ready_future<coordinator_query_result>(coordinator_query_result(make_foreign(std::move(result)),
+                        std::move(used_replicas), db::read_repair_decision::NONE));
+            });
+        }
+    }
+
     // Update reads_coordinator_outside_replica_set once per request,
     // not once per partition.
     bool is_read_non_local = false;
 
-    for (auto&& pr: partition_ranges) {
+    for (size_t i = 0; i < partition_ranges.size(); ++i) {
+        auto& pr = partition_ranges[i];
         if (!pr.is_singular()) {
             throw std::runtime_error("mixed singular and non singular range are not supported");
         }
 
-        auto token_range = dht::token_range::make_singular(pr.start()->value().token());
+        auto& token = pr.start()->value().token();
+        auto token_range = dht::token_range::make_singular(token);
         auto it = query_options.preferred_replicas.find(token_range);
         const auto replicas = it == query_options.preferred_replicas.end()
             ? std::vector<gms::inet_address>{} : replica_ids_to_endpoints(_token_metadata, it->second);
 
+        if (group_reads) {
+            // Pick the replica as get_read_executor() does.
+            auto all_replicas = get_live_sorted_endpoints(ks, token);
+            is_read_non_local |= !all_replicas.empty() && all_replicas.front() != utils::fb_utilities::get_broadcast_address();
+            const auto& cfg = _db.local().get_config();
+            if (cfg.latency_read_balancing()) {
+                _replica_read_scores.sort(all_replicas, 1 + cfg.dynamic_snitch_badness_threshold());
+            }
+            auto targets = db::filter_for_query(cl, ks, all_replicas, replicas, repair_decision, nullptr,
+                    cfg.cache_hit_rate_read_balancing() ? &_db.local().find_column_family(schema) : nullptr);
+            if (!targets.empty() && (fbu::is_me(targets.front()) || _features.cluster_supports_grouped_partition_reads())) {
+                auto& reads = (*grouped_reads_per_replica)[targets.front()];
+                reads.indices.push_back(i);
+                reads.ranges.push_back(std::move(pr));
+                continue;
+            }
+        }
+
         auto read_executor = get_read_executor(cmd, schema, std::move(pr), cl, repair_decision,
                                                query_options.trace_state, replicas, is_read_non_local,
                                                query_options.permit);
 
-        exec.emplace_back(read_executor, std::move(token_range));
+        exec->push_back({i, std::move(read_executor), std::move(token_range)});
+    }
+    for (auto it = grouped_reads_per_replica->begin(); it != grouped_reads_per_replica->end();) {
+        auto& [ep, reads] = *it;
+        if (reads.ranges.size() > 1) {
+            ++it;
+            continue;
+        }
+        auto token_range = dht::token_range::make_singular(reads.ranges.front().start()->value().token());
+        auto read_executor = get_read_executor(cmd, schema, std::move(reads.ranges.front()), cl, repair_decision,
+                                               query_options.trace_state, {ep}, is_read_non_local,
+                                               query_options.permit);
+        exec->push_back({reads.indices.front(), std::move(read_executor), std::move(token_range)});
+        it = grouped_reads_per_replica->erase(it);
     }
     if (is_read_non_local) {
         get_stats().reads_coordinator_outside_replica_set++;
     }
 
-    query::result_merger merger(cmd->row_limit, cmd->partition_limit);
-    merger.reserve(exec.size());
-
+    auto results = make_lw_shared<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>>(partition_ranges.size());
     auto used_replicas = make_lw_shared<replicas_per_token_range>();
+    auto timeout = query_options.timeout(*this);
 
-    auto f = ::map_reduce(exec.begin(), exec.end(), [p = shared_from_this(), timeout = query_options.timeout(*this), used_replicas] (
-                std::pair<::shared_ptr<abstract_read_executor>, dht::token_range>& executor_and_token_range) {
-        auto& [rex, token_range] = executor_and_token_range;
+    auto remote = parallel_for_each(*exec, [p = shared_from_this(), timeout, used_replicas, results] (singular_read& read) {
         utils::latency_counter lc;
         lc.start();
-        return rex->execute(timeout).then_wrapped([p = std::move(p), lc, rex, used_replicas, token_range = std::move(token_range)] (
-                    future<foreign_ptr<lw_shared_ptr<query::result>>> f) mutable {
-            if (!f.failed()) {
-                used_replicas->emplace(std::move(token_range), endpoints_to_replica_ids(p->_token_metadata, rex->used_targets()));
-            }
+        auto rex = read.executor;
+        return rex->execute(timeout).then([p, lc, rex, used_replicas, results, &read] (foreign_ptr<lw_shared_ptr<query::result>> r) mutable {
+            used_replicas->emplace(std::move(read.token_range), endpoints_to_replica_ids(p->_token_metadata, rex->used_targets()));
             if (lc.is_start()) {
                 rex->get_cf()->add_coordinator_read_latency(lc.stop().latency());
             }
-            return std::move(f);
+            (*results)[read.index] = std::move(r);
         });
-    }, std::move(merger));
+    });
+
+    auto grouped = parallel_for_each(*grouped_reads_per_replica, [this, cmd, schema, cl, timeout, used_replicas, results, trace_state = query_options.trace_state] (auto& replica_and_reads) {
+        auto ep = replica_and_reads.first;
+        auto& reads = replica_and_reads.second;
+        get_stats().grouped_partition_reads += reads.ranges.size();
+        auto ids = endpoints_to_replica_ids(_token_metadata, {ep});
+        for (auto& pr : reads.ranges) {
+            used_replicas->emplace(dht::token_range::make_singular(pr.start()->value().token()), ids);
+        }
+        utils::latency_counter lc;
+        lc.start();
+        auto cf = _db.local().find_column_family(schema).shared_from_this();
+        return query_partitions_on_replica(ep, schema, cmd, reads.ranges, trace_state, timeout).then_wrapped([this, &reads, lc, cf, schema, cl, results, ep] (
+                future<rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature>> f) mutable {
+            try {
+                auto&& [replica_results, hit_rate] = f.get0();
+                ++get_stats().data_read_completed.get_ep_stat(ep);
+                cf->set_hit_rate(ep, hit_rate);
+                if (lc.is_start()) {
+                    cf->add_coordinator_read_latency(lc.stop().latency());
+                }
+                for (size_t i = 0; i < replica_results.size(); ++i) {
+                    (*results)[reads.indices[i]] = std::move(replica_results[i]);
+                }
+            } catch (rpc::timeout_error&) {
+                ++get_stats().data_read_errors.get_ep_stat(ep);
+                throw read_timeout_exception(schema->ks_name(), schema->cf_name(), cl, 0, 1, false);
+            } catch (seastar::timed_out_error&) {
+                ++get_stats().data_read_errors.get_ep_stat(ep);
+                throw read_timeout_exception(schema->ks_name(), schema->cf_name(), cl, 0, 1, false);
+            } catch (...) {
+                ++get_stats().data_read_errors.get_ep_stat(ep);
+                throw;
+            }
+        });
+    });
 
-    return f.then_wrapped([exec = std::move(exec),
+    return when_all_succeed(std::move(remote), std::move(grouped)).then_wrapped([exec, results, cmd,
             p = shared_from_this(),
             used_replicas,
-            repair_decision] (future<foreign_ptr<lw_shared_ptr<query::result>>> f) {
+            grouped_reads_per_replica,
+            repair_decision,
+            permit = query_options.permit] (future<> f) {
         if (f.failed()) {
             auto eptr = f.get_exception();
-            // hold onto exec until read is complete
+            // hold onto exec and the grouped reads until read is complete
             p->handle_read_error(eptr, false);
             return make_exception_future<storage_proxy::coordinator_query_result>(eptr);
         }
-        return make_ready_future<coordinator_query_result>(coordinator_query_result(std::move(f.get0()), std::move(*used_replicas), repair_decision));
+        // Merge in the order of the keys, so a short read cuts the
+        // result where it would have if the keys were read one by one.
+        // Keys a replica didn't read come after the point where the
+        // merged result is cut anyway, see query_partitions_locally().
+        query::result_merger merger(cmd->row_limit, cmd->partition_limit);
+        merger.reserve(results->size());
+        for (auto& r : *results) {
+            if (!r) {
+                break;
+            }
+            merger(std::move(r));
+        }
+        return make_ready_future<coordinator_query_result>(coordinator_query_result(merger.get(), std::move(*used_replicas), repair_decision));
     });
 }
 
@@ -3927,7 +4742,7 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
         lw_shared_ptr<query::read_command> cmd,
         db::consistency_level cl,
         query_ranges_to_vnodes_generator&& ranges_to_vnodes,
-        int concurrency_factor,
+        range_scan_concurrency concurrency,
         tracing::trace_state_ptr trace_state,
         uint32_t remaining_row_count,
         uint32_t remaining_partition_count,
@@ -3940,25 +4755,39 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
     auto& cf= _db.local().find_column_family(schema);
     auto pcf = _db.local().get_config().cache_hit_rate_read_balancing() ? &cf : nullptr;
     std::unordered_map<abstract_read_executor*, std::vector<dht::token_range>> ranges_per_exec;
+    std::unordered_map<abstract_read_executor*, std::vector<gms::inet_address>> targets_per_exec;
+    // Reads assigned to each replica by this round, not yet reflected in _range_scan_load.
+    std::unordered_map<gms::inet_address, unsigned> round_load;
 
     const auto preferred_replicas_for_range = [this, &preferred_replicas] (const dht::partition_range& r) {
-        auto it = preferred_replicas.find(r.transform(std::mem_fn(&dht::ring_position::token)));
+        auto token_range = r.transform(std::mem_fn(&dht::ring_position::token));
+        auto it = preferred_replicas.find(token_range);
+        if (it == preferred_replicas.end()) {
+            // The range the previous page stopped in is trimmed to start
+            // after its last key, so it doesn't match the vnode range the
+            // replicas were recorded for. Stick to the same replicas anyway,
+            // they have the reader of the previous page cached.
+            it = std::find_if(preferred_replicas.begin(), preferred_replicas.end(), [&] (const replicas_per_token_range::value_type& e) {
+                return e.first.contains(token_range, dht::token_comparator());
+            });
+        }
         return it == preferred_replicas.end() ? std::vector<gms::inet_address>{} : replica_ids_to_endpoints(_token_metadata, it->second);
     };
     const auto to_token_range = [] (const dht::partition_range& r) { return r.transform(std::mem_fn(&dht::ring_position::token)); };
 
-    dht::partition_range_vector ranges = ranges_to_vnodes(concurrency_factor);
-    dht::partition_range_vector::iterator i = ranges.begin();
+    const auto live_endpoints_for_range = [this, &ks, &round_load] (const dht::partition_range& r) {
+        auto endpoints = get_live_sorted_endpoints(ks, end_token(r));
+        sort_by_range_scan_load(endpoints, round_load);
+        return endpoints;
+    };
 
-    // query_ranges_to_vnodes_generator can return less results than requested. If the number of results
-    // is small enough or there are a lot of results - concurrentcy_factor which is increased by shifting left can
-    // eventualy zero out resulting in an infinite recursion. This line makes sure that concurrency factor is never
-    // get stuck on 0 and never increased too much if the number of results remains small.
-    concurrency_factor = std::max(size_t(1), ranges.size());
+    dht::partition_range_vector ranges = ranges_to_vnodes(concurrency.factor());
+    dht::partition_range_vector::iterator i = ranges.begin();
+    const size_t round_ranges = ranges.size();
 
     while (i != ranges.end()) {
         dht::partition_range& range = *i;
-        std::vector<gms::inet_address> live_endpoints = get_live_sorted_endpoints(ks, end_token(range));
+        std::vector<gms::inet_address> live_endpoints = live_endpoints_for_range(range);
         std::vector<gms::inet_address> merged_preferred_replicas = preferred_replicas_for_range(*i);
         std::vector<gms::inet_address> filtered_endpoints = filter_for_query(cl, ks, live_endpoints, merged_preferred_replicas, pcf);
         std::vector<dht::token_range> merged_ranges{to_token_range(range)};
@@ -3971,7 +4800,7 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
         {
             const auto current_range_preferred_replicas = preferred_replicas_for_range(*i);
             dht::partition_range& next_range = *i;
-            std::vector<gms::inet_address> next_endpoints = get_live_sorted_endpoints(ks, end_token(next_range));
+            std::vector<gms::inet_address> next_endpoints = live_endpoints_for_range(next_range);
             std::vector<gms::inet_address> next_filtered_endpoints = filter_for_query(cl, ks, next_endpoints, current_range_preferred_replicas, pcf);
 
             // Origin has this to say here:
@@ -4036,15 +4865,26 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
             throw;
         }
 
-        exec.push_back(::make_shared<range_slice_read_executor>(schema, cf.shared_from_this(), p, cmd, std::move(range), cl, std::move(filtered_endpoints), trace_state, permit));
+        for (auto& ep : filtered_endpoints) {
+            ++round_load[ep];
+        }
+        exec.push_back(::make_shared<range_slice_read_executor>(schema, cf.shared_from_this(), p, cmd, std::move(range), cl, filtered_endpoints, trace_state, permit));
         ranges_per_exec.emplace(exec.back().get(), std::move(merged_ranges));
+        targets_per_exec.emplace(exec.back().get(), std::move(filtered_endpoints));
     }
 
     query::result_merger merger(cmd->row_limit, cmd->partition_limit);
     merger.reserve(exec.size());
 
-    auto f = ::map_reduce(exec.begin(), exec.end(), [timeout] (::shared_ptr<abstract_read_executor>& rex) {
-        return rex->execute(timeout);
+    const auto round_start = range_scan_concurrency::clock_type::now();
+    auto f = ::map_reduce(exec.begin(), exec.end(), [p, timeout, &targets_per_exec] (::shared_ptr<abstract_read_executor>& rex) {
+        auto targets = std::move(targets_per_exec[rex.get()]);
+        p->account_range_scan_start(targets);
+        auto start = range_scan_concurrency::clock_type::now();
+        return rex->execute(timeout).finally([p, targets = std::move(targets), start] {
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(range_scan_concurrency::clock_type::now() - start);
+            p->account_range_scan_end(targets, latency);
+        });
     }, std::move(merger));
 
     return f.then([p,
@@ -4053,7 +4893,9 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
             ranges_to_vnodes = std::move(ranges_to_vnodes),
             cl,
             cmd,
-            concurrency_factor,
+            concurrency,
+            round_start,
+            round_ranges,
             timeout,
             remaining_row_count,
             remaining_partition_count,
@@ -4064,6 +4906,8 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
         result->ensure_counts();
         remaining_row_count -= result->row_count().value();
         remaining_partition_count -= result->partition_count().value();
+        concurrency.update(range_scan_concurrency::clock_type::now() - round_start, round_ranges,
+                result->buf().size(), result->row_count().value(), remaining_row_count);
         results.emplace_back(std::move(result));
         if (ranges_to_vnodes.empty() || !remaining_row_count || !remaining_partition_count) {
             auto used_replicas = replicas_per_token_range();
@@ -4083,7 +4927,7 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
             cmd->row_limit = remaining_row_count;
             cmd->partition_limit = remaining_partition_count;
             return p->query_partition_key_range_concurrent(timeout, std::move(results), cmd, cl, std::move(ranges_to_vnodes),
-                    concurrency_factor * 2, std::move(trace_state), remaining_row_count, remaining_partition_count, std::move(preferred_replicas), std::move(permit));
+                    concurrency, std::move(trace_state), remaining_row_count, remaining_partition_count, std::move(preferred_replicas), std::move(permit));
         }
     }).handle_exception([p] (std::exception_ptr eptr) {
         p->handle_read_error(eptr, true);
@@ -4103,13 +4947,11 @@ storage_proxy::query_partition_key_range(lw_shared_ptr<query::read_command> cmd,
     // expensive in clusters with vnodes)
     query_ranges_to_vnodes_generator ranges_to_vnodes(_token_metadata, schema, std::move(partition_ranges), ks.get_replication_strategy().get_type() == locator::replication_strategy_type::local);
 
-    int result_rows_per_range = 0;
-    int concurrency_factor = 1;
+    range_scan_concurrency concurrency(_db.local().get_config().range_scan_memory_budget());
 
     std::vector<foreign_ptr<lw_shared_ptr<query::result>>> results;
 
-    slogger.debug("Estimated result rows per range: {}; requested rows: {}, concurrent range requests: {}",
-            result_rows_per_range, cmd->row_limit, concurrency_factor);
+    slogger.debug("Requested rows: {}, concurrent range requests: {}", cmd->row_limit, concurrency.factor());
 
     // The call to `query_partition_key_range_concurrent()` below
     // updates `cmd` directly when processing the results. Under
@@ -4129,7 +4971,7 @@ storage_proxy::query_partition_key_range(lw_shared_ptr<query::read_command> cmd,
             cmd,
             cl,
             std::move(ranges_to_vnodes),
-            concurrency_factor,
+            concurrency,
             std::move(query_options.trace_state),
             cmd->row_limit,
             cmd->partition_limit,
@@ -4175,7 +5017,9 @@ storage_proxy::query(schema_ptr s,
         });
     }
 
-    return do_query(s, cmd, std::move(partition_ranges), cl, std::move(query_options));
+    return utils::sample_latency(utils::latency_stage::coordinator_read, [&] {
+        return do_query(s, cmd, std::move(partition_ranges), cl, std::move(query_options));
+    });
 }
 
 future<storage_proxy::coordinator_query_result>
@@ -4211,6 +5055,7 @@ storage_proxy::do_query(schema_ptr s,
                     p->get_stats().read.mark(lc.stop().latency());
                     if (lc.is_start()) {
                         p->get_stats().estimated_read.add(lc.latency(), p->get_stats().read.hist.count);
+                        p->get_stats().decaying_read.add(std::chrono::duration_cast<std::chrono::microseconds>(lc.latency()));
                     }
                 });
             } catch (const no_such_column_family&) {
@@ -4504,6 +5349,104 @@ std::vector<gms::inet_address> storage_proxy::get_live_sorted_endpoints(keyspace
     return eps;
 }
 
+void range_scan_concurrency::update(clock_type::duration latency, size_t ranges, uint64_t result_bytes, uint64_t result_rows, uint64_t remaining_rows) {
+    _min_latency = std::min(_min_latency, latency);
+    if (latency > _min_latency * latency_tolerance) {
+        _factor = std::max(1, _factor / 2);
+        _slow_start = false;
+    } else if (_slow_start) {
+        _factor *= 2;
+    } else {
+        _factor += 1;
+    }
+    ranges = std::max(size_t(1), ranges);
+    if (auto bytes_per_range = result_bytes / ranges) {
+        _factor = std::min<uint64_t>(_factor, std::max<uint64_t>(1, _memory_budget / bytes_per_range));
+    }
+    if (result_rows) {
+        // The number of ranges expected to be needed to fill the remaining rows.
+        auto needed = (remaining_rows * ranges + result_rows - 1) / result_rows;
+        _factor = std::min<uint64_t>(_factor, std::max<uint64_t>(1, needed));
+    }
+    _factor = std::min(_factor, max_factor);
+}
+
+void replica_read_scores::on_read_end(gms::inet_address ep, clock_type::duration latency) {
+    auto now = clock_type::now();
+    auto& r = _replicas[ep];
+    --r.in_flight;
+    auto us = std::chrono::duration<double, std::micro>(latency).count();
+    r.latency_us = r.updated == clock_type::time_point() ? us : decayed_latency(r, now) * 0.75 + us * 0.25;
+    r.updated = now;
+}
+
+double replica_read_scores::decayed_latency(const replica& r, clock_type::time_point now) {
+    auto idle = std::chrono::duration<double>(now - r.updated) / std::chrono::duration<double>(idle_half_life);
+    return r.latency_us * std::exp2(-idle);
+}
+
+double replica_read_scores::score(gms::inet_address ep, clock_type::time_point now) const {
+    auto it = _replicas.find(ep);
+    if (it == _replicas.end()) {
+        return 0;
+    }
+    return decayed_latency(it->second, now) * (it->second.in_flight + 1);
+}
+
+void replica_read_scores::sort(std::vector<gms::inet_address>& endpoints, double hysteresis) const {
+    auto now = clock_type::now();
+    auto scored = boost::copy_range<std::vector<std::pair<gms::inet_address, double>>>(endpoints
+            | boost::adaptors::transformed([&] (gms::inet_address ep) { return std::make_pair(ep, score(ep, now)); }));
+    auto group_begin = scored.begin();
+    while (group_begin != scored.end()) {
+        auto local = db::is_local(group_begin->first);
+        auto group_end = std::find_if(group_begin, scored.end(), [local] (auto& s) { return db::is_local(s.first) != local; });
+        for (auto i = group_begin; i != group_end; ++i) {
+            auto best = std::min_element(i, group_end, [] (auto& a, auto& b) { return a.second < b.second; });
+            if (best->second * hysteresis < i->second) {
+                std::rotate(i, best, best + 1);
+            }
+        }
+        group_begin = group_end;
+    }
+    boost::copy(scored | boost::adaptors::map_keys, endpoints.begin());
+}
+
+void storage_proxy::sort_by_range_scan_load(std::vector<gms::inet_address>& endpoints,
+        const std::unordered_map<gms::inet_address, unsigned>& round_load) const {
+    // Keep replicas of the local datacenter first, as get_live_sorted_endpoints() does,
+    // and order replicas of the same proximity by their expected response time.
+    auto cost = [this, &round_load] (const gms::inet_address& ep) {
+        uint64_t in_flight = 0;
+        uint64_t latency = 0;
+        if (auto it = _range_scan_load.find(ep); it != _range_scan_load.end()) {
+            in_flight = it->second.in_flight;
+            latency = it->second.latency.count();
+        }
+        if (auto it = round_load.find(ep); it != round_load.end()) {
+            in_flight += it->second;
+        }
+        return std::make_pair(!db::is_local(ep), (in_flight + 1) * (latency + 1));
+    };
+    std::stable_sort(endpoints.begin(), endpoints.end(), [&cost] (const gms::inet_address& a, const gms::inet_address& b) {
+        return cost(a) < cost(b);
+    });
+}
+
+void storage_proxy::account_range_scan_start(const std::vector<gms::inet_address>& endpoints) {
+    for (auto& ep : endpoints) {
+        ++_range_scan_load[ep].in_flight;
+    }
+}
+
+void storage_proxy::account_range_scan_end(const std::vector<gms::inet_address>& endpoints, std::chrono::microseconds latency) {
+    for (auto& ep : endpoints) {
+        auto& load = _range_scan_load[ep];
+        --load.in_flight;
+        load.latency = load.latency.count() ? (load.latency * 7 + latency) / 8 : latency;
+    }
+}
+
 std::vector<gms::inet_address> storage_proxy::intersection(const std::vector<gms::inet_address>& l1, const std::vector<gms::inet_address>& l2) {
     std::vector<gms::inet_address> inter;
     inter.reserve(l1.size());
@@ -4736,6 +5679,12 @@ void storage_proxy::init_messaging_service() {
                         // ignore timeouts so that logs are not flooded.
                         // database total_writes_timedout counter was incremented.
                         l = seastar::log_level::debug;
+                    } catch (replica_overloaded_exception&) {
+                        // database total_writes_shed counter was incremented.
+                        l = seastar::log_level::debug;
+                    } catch (exceptions::rate_limit_exception&) {
+                        // database total_writes_rate_limited counter was incremented.
+                        l = seastar::log_level::debug;
                     } catch (...) {
                         // ignore
                     }
@@ -4745,7 +5694,10 @@ void storage_proxy::init_messaging_service() {
                 parallel_for_each(forward.begin(), forward.end(), [reply_to, shard, response_id, &m, &p, trace_state_ptr,
                                   timeout, &errors, forward_fn = std::move(forward_fn)] (gms::inet_address forward) {
                     tracing::trace(trace_state_ptr, "Forwarding a mutation to /{}", forward);
-                    return forward_fn(netw::messaging_service::msg_addr{forward, 0}, timeout, m, reply_to, shard, response_id,
+                    // With shard-aware connections the mutation arrived on the shard owning
+                    // it, which is its owner on the forwarded-to replica too when the two
+                    // nodes are sharded alike.
+                    return forward_fn(netw::messaging_service::msg_addr{forward, this_shard_id()}, timeout, m, reply_to, shard, response_id,
                                       tracing::make_trace_info(trace_state_ptr))
                             .then_wrapped([&p, &errors] (future<> f) {
                         if (f.failed()) {
@@ -4802,6 +5754,91 @@ void storage_proxy::init_messaging_service() {
     ms.register_mutation(receive_mutation_handler);
     ms.register_hint_mutation(receive_mutation_handler);
 
+    ms.register_mutations([] (const rpc::client_info& cinfo, rpc::opt_time_point t, std::vector<frozen_mutation> fms,
+            gms::inet_address reply_to, unsigned shard, std::vector<storage_proxy::response_id_type> response_ids,
+            std::optional<tracing::trace_info> trace_info) {
+        tracing::trace_state_ptr trace_state_ptr;
+        auto src_addr = netw::messaging_service::get_source(cinfo);
+
+        if (trace_info) {
+            tracing::trace_info& tr_info = *trace_info;
+            trace_state_ptr = tracing::tracing::get_local_tracing_instance().create_session(tr_info);
+            tracing::begin(trace_state_ptr);
+            tracing::trace(trace_state_ptr, "Message with {} mutations received from /{}", fms.size(), src_addr.addr);
+        }
+
+        auto p = get_local_shared_storage_proxy();
+        storage_proxy::clock_type::time_point timeout;
+        if (!t) {
+            auto timeout_in_ms = p->_db.local().get_config().write_request_timeout_in_ms();
+            timeout = clock_type::now() + std::chrono::milliseconds(timeout_in_ms);
+        } else {
+            timeout = *t;
+        }
+        ++p->get_stats().received_mutation_batches;
+        p->get_stats().received_mutations += fms.size();
+
+        return do_with(std::move(fms), std::move(response_ids), std::vector<schema_ptr>(), std::vector<std::exception_ptr>(), std::move(p),
+                [reply_to, shard, timeout, trace_state_ptr] (std::vector<frozen_mutation>& fms, std::vector<storage_proxy::response_id_type>& response_ids,
+                        std::vector<schema_ptr>& schemas, std::vector<std::exception_ptr>& errors, shared_ptr<storage_proxy>& p) {
+            schemas.resize(fms.size());
+            // FIXME: get_schema_for_write() doesn't timeout
+            return parallel_for_each(boost::irange<size_t>(0, fms.size()), [&fms, &schemas, reply_to, shard] (size_t i) {
+                return get_schema_for_write(fms[i].schema_version(), netw::messaging_service::msg_addr{reply_to, shard}).then([&schemas, i] (schema_ptr s) {
+                    schemas[i] = std::move(s);
+                });
+            }).then([&fms, &schemas, &p, timeout] {
+                return p->mutate_locally(schemas, fms, timeout);
+            }).then_wrapped([&fms, &errors] (future<std::vector<std::exception_ptr>> f) {
+                if (f.failed()) {
+                    errors.assign(fms.size(), f.get_exception());
+                } else {
+                    errors = f.get0();
+                }
+            }).then([&response_ids, &errors, &p, reply_to, shard, trace_state_ptr] {
+                // Each mutation is completed separately, as if it came with its own MUTATION.
+                auto& ms = netw::get_local_messaging_service();
+                tracing::trace(trace_state_ptr, "Sending mutation_done for {} mutations to /{}",
+                        boost::count_if(errors, [] (const std::exception_ptr& e) { return !e; }), reply_to);
+                return parallel_for_each(boost::irange<size_t>(0, response_ids.size()), [&ms, &response_ids, &errors, &p, reply_to, shard] (size_t i) {
+                    auto addr = netw::messaging_service::msg_addr{reply_to, shard};
+                    if (!errors[i]) {
+                        return ms.send_mutation_done(addr, shard, response_ids[i], p->get_view_update_backlog()).then_wrapped([] (future<> f) {
+                            f.ignore_ready_future();
+                        });
+                    }
+                    seastar::log_level l = seastar::log_level::warn;
+                    try {
+                        std::rethrow_exception(errors[i]);
+                    } catch (timed_out_error&) {
+                        // ignore timeouts so that logs are not flooded.
+                        // database total_writes_timedout counter was incremented.
+                        l = seastar::log_level::debug;
+                    } catch (replica_overloaded_exception&) {
+                        // database total_writes_shed counter was incremented.
+                        l = seastar::log_level::debug;
+                    } catch (exceptions::rate_limit_exception&) {
+                        // database total_writes_rate_limited counter was incremented.
+                        l = seastar::log_level::debug;
+                    } catch (...) {
+                        // ignore
+                    }
+                    slogger.log(l, "Failed to apply mutation from {}#{}: {}", reply_to, shard, errors[i]);
+                    if (!p->features().cluster_supports_write_failure_reply()) {
+                        return make_ready_future<>();
+                    }
+                    return ms.send_mutation_failed(addr, shard, response_ids[i], 1, p->get_view_update_backlog()).then_wrapped([] (future<> f) {
+                        f.ignore_ready_future();
+                    });
+                });
+            }).then_wrapped([trace_state_ptr] (future<> f) {
+                f.ignore_ready_future();
+                tracing::trace(trace_state_ptr, "Mutation handling is done");
+                return netw::messaging_service::no_wait();
+            });
+        });
+    });
+
     ms.register_paxos_learn([] (const rpc::client_info& cinfo, rpc::opt_time_point t, paxos::proposal decision,
             std::vector<gms::inet_address> forward, gms::inet_address reply_to, unsigned shard,
             storage_proxy::response_id_type response_id, std::optional<tracing::trace_info> trace_info) {
@@ -4867,6 +5904,35 @@ void storage_proxy::init_messaging_service() {
             });
         });
     });
+    ms.register_read_data_partitions([] (const rpc::client_info& cinfo, rpc::opt_time_point t, query::read_command cmd, dht::partition_range_vector ranges) {
+        tracing::trace_state_ptr trace_state_ptr;
+        auto src_addr = netw::messaging_service::get_source(cinfo);
+        if (cmd.trace_info) {
+            trace_state_ptr = tracing::tracing::get_local_tracing_instance().create_session(*cmd.trace_info);
+            tracing::begin(trace_state_ptr);
+            tracing::trace(trace_state_ptr, "read_data_partitions: message received from /{}", src_addr.addr);
+        }
+        auto max_size = cinfo.retrieve_auxiliary<uint64_t>("max_result_size");
+        return do_with(std::move(ranges), get_local_shared_storage_proxy(), std::move(trace_state_ptr), [cmd = make_lw_shared<query::read_command>(std::move(cmd)), src_addr = std::move(src_addr), max_size, t] (dht::partition_range_vector& ranges, shared_ptr<storage_proxy>& p, tracing::trace_state_ptr& trace_state_ptr) mutable {
+            p->get_stats().replica_data_reads++;
+            auto src_ip = src_addr.addr;
+            return get_schema_for_read(cmd->schema_version, std::move(src_addr)).then([cmd, &ranges, &p, &trace_state_ptr, max_size, t] (schema_ptr s) {
+                auto timeout = t ? *t : db::no_timeout;
+                return p->query_partitions_locally(std::move(s), cmd, ranges, trace_state_ptr, timeout, max_size);
+            }).then([] (rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature> results_and_hit_rate) {
+                auto&& [results, hit_rate] = results_and_hit_rate;
+                // The results live on the shards which read them.
+                std::vector<query::result> local_results;
+                local_results.reserve(results.size());
+                for (auto& r : results) {
+                    local_results.emplace_back(bytes_ostream(r->buf()), r->is_short_read(), r->row_count(), r->partition_count());
+                }
+                return make_ready_future<rpc::tuple<std::vector<query::result>, cache_temperature>>(rpc::tuple(std::move(local_results), hit_rate));
+            }).finally([&trace_state_ptr, src_ip] () mutable {
+                tracing::trace(trace_state_ptr, "read_data_partitions handling is done, sending a response to /{}", src_ip);
+            });
+        });
+    });
     ms.register_read_mutation_data([] (const rpc::client_info& cinfo, rpc::opt_time_point t, query::read_command cmd, ::compat::wrapping_partition_range pr) {
         tracing::trace_state_ptr trace_state_ptr;
         auto src_addr = netw::messaging_service::get_source(cinfo);
@@ -5037,22 +6103,45 @@ void storage_proxy::init_messaging_service() {
             });
         });
     });
+
+    ms.register_forward_request([] (const rpc::client_info& cinfo, rpc::opt_time_point t, query::forward_request req) {
+        tracing::trace_state_ptr trace_state_ptr;
+        auto src_addr = netw::messaging_service::get_source(cinfo);
+        if (req.cmd.trace_info) {
+            trace_state_ptr = tracing::tracing::get_local_tracing_instance().create_session(*req.cmd.trace_info);
+            tracing::begin(trace_state_ptr);
+            tracing::trace(trace_state_ptr, "forward_request: message received from /{}", src_addr.addr);
+        }
+        auto timeout = t ? *t : db::no_timeout;
+        return do_with(std::move(req), get_local_shared_storage_proxy(), std::move(trace_state_ptr),
+                [src_addr = std::move(src_addr), timeout] (query::forward_request& req, shared_ptr<storage_proxy>& p, tracing::trace_state_ptr& trace_state_ptr) mutable {
+            auto src_ip = src_addr.addr;
+            return get_schema_for_read(req.cmd.schema_version, std::move(src_addr)).then([&req, &p, &trace_state_ptr, timeout] (schema_ptr s) {
+                return execute_forward_request(*p, std::move(s), req, timeout, trace_state_ptr);
+            }).finally([&trace_state_ptr, src_ip] () mutable {
+                tracing::trace(trace_state_ptr, "forward_request handling is done, sending a response to /{}", src_ip);
+            });
+        });
+    });
 }
 
 future<> storage_proxy::uninit_messaging_service() {
     auto& ms = netw::get_local_messaging_service();
     return when_all_succeed(
         ms.unregister_mutation(),
+        ms.unregister_mutations(),
         ms.unregister_mutation_done(),
         ms.unregister_mutation_failed(),
         ms.unregister_read_data(),
+        ms.unregister_read_data_partitions(),
         ms.unregister_read_mutation_data(),
         ms.unregister_read_digest(),
         ms.unregister_truncate(),
         ms.unregister_paxos_prepare(),
         ms.unregister_paxos_accept(),
         ms.unregister_paxos_learn(),
-        ms.unregister_paxos_prune()
+        ms.unregister_paxos_prune(),
+        ms.unregister_forward_request()
     );
 }
 
@@ -5060,9 +6149,11 @@ future<rpc::tuple<foreign_ptr<lw_shared_ptr<reconcilable_result>>, cache_tempera
 storage_proxy::query_mutations_locally(schema_ptr s, lw_shared_ptr<query::read_command> cmd, const dht::partition_range& pr,
                                        storage_proxy::clock_type::time_point timeout,
                                        tracing::trace_state_ptr trace_state, uint64_t max_size) {
-    if (pr.is_singular()) {
-        unsigned shard = dht::shard_of(*s, pr.start()->value().token());
+    max_size = std::min(max_size, cmd->max_result_size);
+    if (auto shard_opt = dht::single_shard_of(*s, pr)) {
+        unsigned shard = *shard_opt;
         get_stats().replica_cross_shard_ops += shard != this_shard_id();
+        get_stats().replica_single_shard_range_reads += !pr.is_singular();
         return _db.invoke_on(shard, _read_smp_service_group, [max_size, cmd, &pr, gs=global_schema_ptr(s), timeout, gt = tracing::global_trace_state_ptr(std::move(trace_state))] (database& db) mutable {
           return db.get_result_memory_limiter().new_mutation_read(max_size).then([&] (query::result_memory_accounter ma) {
             return db.query_mutations(gs, *cmd, pr, std::move(ma), gt, timeout).then([] (reconcilable_result&& result, cache_temperature ht) {
@@ -5093,6 +6184,7 @@ storage_proxy::query_nonsingular_mutations_locally(schema_ptr s,
                                                    tracing::trace_state_ptr trace_state,
                                                    uint64_t max_size,
                                                    storage_proxy::clock_type::time_point timeout) {
+    max_size = std::min(max_size, cmd->max_result_size);
     return do_with(cmd, std::move(prs), [=, s = std::move(s), trace_state = std::move(trace_state)] (lw_shared_ptr<query::read_command>& cmd,
                 const dht::partition_range_vector& prs) mutable {
         return query_mutations_on_all_shards(_db, std::move(s), *cmd, prs, std::move(trace_state), max_size, timeout).then([] (std::tuple<foreign_ptr<lw_shared_ptr<reconcilable_result>>, cache_temperature> t) {
@@ -5146,6 +6238,10 @@ future<> storage_proxy::drain_on_shutdown() {
 
 future<>
 storage_proxy::stop() {
+    flush_coalesced_writes();
+    flush_coalesced_counter_updates();
+    _deferred_read_repair_timer.cancel();
+    _deferred_read_repairs.clear();
     // FIXME: hints manager should be stopped here but it seems like this function is never called
     return uninit_messaging_service();
 }
@@ -48,6 +48,8 @@
 #include <seastar/core/distributed.hh>
 #include <seastar/core/execution_stage.hh>
 #include <seastar/core/scheduling_specific.hh>
+#include <seastar/core/timer.hh>
+#include <seastar/core/shared_future.hh>
 #include "db/consistency_level_type.hh"
 #include "db/read_repair_decision.hh"
 #include "db/write_type.hh"
@@ -59,6 +61,7 @@
 #include "tracing/trace_state.hh"
 #include <seastar/core/metrics.hh>
 #include "frozen_mutation.hh"
+#include "mutation.hh"
 #include "storage_proxy_stats.hh"
 #include "cache_temperature.hh"
 #include "mutation_query.hh"
@@ -107,6 +110,63 @@ struct query_partition_key_range_concurrent_result {
     replicas_per_token_range replicas;
 };
 
+// Adapts the number of vnode ranges a range scan reads in parallel.
+//
+// The concurrency grows exponentially until a round of reads takes more than
+// latency_tolerance times the fastest round of the scan, at which point it is
+// halved and grows additively from there on (AIMD). It is also capped so that
+// the replies expected from a round fit within the memory budget and don't
+// carry many more rows than the scan still needs.
+class range_scan_concurrency {
+public:
+    using clock_type = std::chrono::steady_clock;
+    static constexpr unsigned latency_tolerance = 2;
+    static constexpr int max_factor = 256;
+private:
+    int _factor = 1;
+    bool _slow_start = true;
+    clock_type::duration _min_latency = clock_type::duration::max();
+    uint64_t _memory_budget;
+public:
+    explicit range_scan_concurrency(uint64_t memory_budget) : _memory_budget(memory_budget) { }
+    int factor() const { return _factor; }
+    // Adjusts the concurrency after a round which read `ranges` vnode ranges.
+    void update(clock_type::duration latency, size_t ranges, uint64_t result_bytes, uint64_t result_rows, uint64_t remaining_rows);
+};
+
+// Scores replicas by how fast they have been answering the single-partition
+// reads coordinated by this shard, to steer reads away from a slow replica.
+//
+// The score of a replica is an exponentially decayed average of its read
+// latency, scaled by its reads in flight. While a replica gets no reads its
+// average also decays towards zero, so that a replica which was avoided is
+// tried again after a while. A replica only overtakes a higher ranked one
+// when its score is better by more than the given hysteresis factor, so that
+// close scores don't reorder replicas from read to read and move all reads
+// onto whichever replica happened to be the fastest last.
+class replica_read_scores {
+public:
+    using clock_type = std::chrono::steady_clock;
+    static constexpr clock_type::duration idle_half_life = std::chrono::seconds(1);
+private:
+    struct replica {
+        unsigned in_flight = 0;
+        double latency_us = 0;
+        clock_type::time_point updated;
+    };
+    std::unordered_map<gms::inet_address, replica> _replicas;
+    static double decayed_latency(const replica& r, clock_type::time_point now);
+public:
+    void on_read_start(gms::inet_address ep) {
+        ++_replicas[ep].in_flight;
+    }
+    void on_read_end(gms::inet_address ep, clock_type::duration latency);
+    double score(gms::inet_address ep, clock_type::time_point now) const;
+    // Orders replicas of the same locality by score, keeping the local
+    // datacenter's replicas where get_live_sorted_endpoints() put them.
+    void sort(std::vector<gms::inet_address>& endpoints, double hysteresis) const;
+};
+
 struct view_update_backlog_timestamped {
     db::view::update_backlog backlog;
     api::timestamp_type ts;
@@ -290,6 +350,41 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
             lw_shared_ptr<cdc::operation_result_tracker>> _mutate_stage;
     db::view::node_update_backlog& _max_view_update_backlog;
     std::unordered_map<gms::inet_address, view_update_backlog_timestamped> _view_update_backlogs;
+    // Load of the replicas as seen by the range scans coordinated by this shard,
+    // used to route each vnode range to the least loaded replica.
+    struct range_scan_replica_load {
+        unsigned in_flight = 0;
+        // Moving average of the latency of the range reads sent to the replica.
+        std::chrono::microseconds latency{0};
+    };
+    std::unordered_map<gms::inet_address, range_scan_replica_load> _range_scan_load;
+    replica_read_scores _replica_read_scores;
+    // Writes waiting for the coalescing window to close, by replica (see
+    // write_coalescing_window_in_us).
+    struct coalesced_writes {
+        std::vector<response_id_type> ids;
+        clock_type::time_point timeout;
+    };
+    std::unordered_map<gms::inet_address, coalesced_writes> _coalesced_writes;
+    timer<> _write_coalescing_timer;
+    // Counter updates to a partition waiting, on its leader shard, for the
+    // coalescing window to close, so that their deltas are applied and
+    // replicated as a single update (see counter_update_coalescing_window_in_us).
+    struct coalesced_counter_update {
+        std::optional<mutation> m;
+        clock_type::time_point timeout;
+        tracing::trace_state_ptr trace_state;
+        size_t count = 0;
+        lw_shared_ptr<shared_promise<>> done = make_lw_shared<shared_promise<>>();
+    };
+    using coalesced_counter_update_key = std::tuple<utils::UUID, dht::token, bytes, db::consistency_level>;
+    std::map<coalesced_counter_update_key, coalesced_counter_update> _coalesced_counter_updates;
+    timer<> _counter_update_coalescing_timer;
+    // Read repair writes waiting to be sent in the background, merged by
+    // partition (see deferred_read_repair).
+    using deferred_read_repair_key = std::tuple<utils::UUID, dht::token, bytes>;
+    std::map<deferred_read_repair_key, std::unordered_map<gms::inet_address, std::optional<mutation>>> _deferred_read_repairs;
+    timer<> _deferred_read_repair_timer;
 
     //NOTICE(sarna): This opaque pointer is here just to avoid moving write handler class definitions from .cc to .hh. It's slow path.
     class view_update_handlers_list;
@@ -302,7 +397,8 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
     future<coordinator_query_result> query_singular(lw_shared_ptr<query::read_command> cmd,
             dht::partition_range_vector&& partition_ranges,
             db::consistency_level cl,
-            coordinator_query_options optional_params);
+            coordinator_query_options optional_params,
+            bool allow_local_replica_read = true);
     response_id_type register_response_handler(shared_ptr<abstract_write_response_handler>&& h);
     void remove_response_handler(response_id_type id);
     void remove_response_handler_entry(response_handlers_map::iterator entry);
@@ -323,7 +419,15 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
     response_id_type create_write_response_handler(const std::tuple<paxos::proposal, schema_ptr, dht::token, std::unordered_set<gms::inet_address>>& meta,
             db::consistency_level cl, db::write_type type, tracing::trace_state_ptr tr_state, service_permit permit);
     void register_cdc_operation_result_tracker(const std::vector<storage_proxy::unique_response_handler>& ids, lw_shared_ptr<cdc::operation_result_tracker> tracker);
-    void send_to_live_endpoints(response_id_type response_id, clock_type::time_point timeout);
+    // Writes to each replica, collected by send_to_live_endpoints() so that the
+    // mutations of a batch are sent to a replica in a single MUTATIONS message.
+    using replica_batches = std::unordered_map<gms::inet_address, std::vector<response_id_type>>;
+    void send_to_live_endpoints(response_id_type response_id, clock_type::time_point timeout, replica_batches* batches = nullptr);
+    void send_replica_batches(replica_batches batches, clock_type::time_point timeout);
+    void send_mutation_batch(gms::inet_address ep, std::vector<response_id_type> ids, clock_type::time_point timeout);
+    std::chrono::microseconds write_coalescing_window() const;
+    void coalesce_write(gms::inet_address ep, response_id_type id, clock_type::time_point timeout);
+    void flush_coalesced_writes();
     template<typename Range>
     size_t hint_to_dead_endpoints(std::unique_ptr<mutation_holder>& mh, const Range& targets, db::write_type type, tracing::trace_state_ptr tr_state) noexcept;
     void hint_to_dead_endpoints(response_id_type, db::consistency_level);
@@ -349,6 +453,24 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
                                                                            tracing::trace_state_ptr trace_state,
                                                                            clock_type::time_point timeout,
                                                                            uint64_t max_size = query::result_memory_limiter::maximum_result_size);
+    // Reads each of the partitions, given as singular ranges, into a result of
+    // its own. The partitions of each shard are read under a single admission,
+    // see database::query_partitions(). Returns the results of a prefix of the
+    // partitions, in the given order: it ends where a limit was reached or
+    // after a short read.
+    future<rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature>> query_partitions_locally(schema_ptr,
+            lw_shared_ptr<query::read_command> cmd,
+            const dht::partition_range_vector& ranges,
+            tracing::trace_state_ptr trace_state,
+            clock_type::time_point timeout,
+            uint64_t max_size = query::result_memory_limiter::maximum_result_size);
+    // Like query_partitions_locally(), on the given replica.
+    future<rpc::tuple<std::vector<foreign_ptr<lw_shared_ptr<query::result>>>, cache_temperature>> query_partitions_on_replica(gms::inet_address ep,
+            schema_ptr,
+            lw_shared_ptr<query::read_command> cmd,
+            const dht::partition_range_vector& ranges,
+            tracing::trace_state_ptr trace_state,
+            clock_type::time_point timeout);
     future<rpc::tuple<query::result_digest, api::timestamp_type, cache_temperature>> query_result_local_digest(schema_ptr, lw_shared_ptr<query::read_command> cmd, const dht::partition_range& pr,
                                                                                                    tracing::trace_state_ptr trace_state,
                                                                                                    clock_type::time_point timeout,
@@ -359,12 +481,16 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
             db::consistency_level cl,
             coordinator_query_options optional_params);
     static std::vector<gms::inet_address> intersection(const std::vector<gms::inet_address>& l1, const std::vector<gms::inet_address>& l2);
+    void sort_by_range_scan_load(std::vector<gms::inet_address>& endpoints,
+            const std::unordered_map<gms::inet_address, unsigned>& round_load) const;
+    void account_range_scan_start(const std::vector<gms::inet_address>& endpoints);
+    void account_range_scan_end(const std::vector<gms::inet_address>& endpoints, std::chrono::microseconds latency);
     future<query_partition_key_range_concurrent_result> query_partition_key_range_concurrent(clock_type::time_point timeout,
             std::vector<foreign_ptr<lw_shared_ptr<query::result>>>&& results,
             lw_shared_ptr<query::read_command> cmd,
             db::consistency_level cl,
             query_ranges_to_vnodes_generator&& ranges_to_vnodes,
-            int concurrency_factor,
+            range_scan_concurrency concurrency,
             tracing::trace_state_ptr trace_state,
             uint32_t remaining_row_count,
             uint32_t remaining_partition_count,
@@ -388,6 +514,9 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
     future<> mutate_begin(std::vector<unique_response_handler> ids, db::consistency_level cl, std::optional<clock_type::time_point> timeout_opt = { });
     future<> mutate_end(future<> mutate_result, utils::latency_counter, write_stats& stats, tracing::trace_state_ptr trace_state);
     future<> schedule_repair(std::unordered_map<dht::token, std::unordered_map<gms::inet_address, std::optional<mutation>>> diffs, db::consistency_level cl, tracing::trace_state_ptr trace_state, service_permit permit);
+    bool should_defer_read_repair(db::consistency_level cl) const;
+    void defer_read_repair(std::unordered_map<dht::token, std::unordered_map<gms::inet_address, std::optional<mutation>>> diffs);
+    void send_deferred_read_repairs();
     bool need_throttle_writes() const;
     void unthrottle();
     void handle_read_error(std::exception_ptr eptr, bool range);
@@ -401,10 +530,21 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
                                        tracing::trace_state_ptr trace_state, service_permit permit);
     future<> mutate_counter_on_leader_and_replicate(const schema_ptr& s, frozen_mutation m, db::consistency_level cl, clock_type::time_point timeout,
                                                     tracing::trace_state_ptr trace_state, service_permit permit);
+    bool should_coalesce_counter_update(const schema& s) const;
+    // Resolves once the update, merged with the others to the same partition
+    // collected within the coalescing window, is applied and replicated.
+    future<> coalesce_counter_update(mutation m, db::consistency_level cl, clock_type::time_point timeout, tracing::trace_state_ptr trace_state);
+    void apply_coalesced_counter_update(db::consistency_level cl, coalesced_counter_update u);
+    void flush_coalesced_counter_updates();
 
     gms::inet_address find_leader_for_counter_update(const mutation& m, db::consistency_level cl);
 
     future<> do_mutate(std::vector<mutation> mutations, db::consistency_level cl, clock_type::time_point timeout, tracing::trace_state_ptr tr_state, service_permit permit, bool, lw_shared_ptr<cdc::operation_result_tracker> cdc_tracker);
+    // Whether m is a CL=ONE write whose only replica is this node, on this
+    // shard, so it can be applied without a write response handler.
+    bool is_sole_local_replica_write(const mutation& m, db::consistency_level cl);
+    future<> mutate_sole_local_replica(mutation m, db::consistency_level cl, clock_type::time_point timeout,
+            tracing::trace_state_ptr tr_state, service_permit permit);
 
     future<> send_to_endpoint(
             std::unique_ptr<mutation_holder> m,
@@ -413,6 +553,13 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
             db::write_type type,
             write_stats& stats,
             allow_hints allow_hints = allow_hints::yes);
+    future<> send_to_endpoint(
+            std::vector<std::unique_ptr<mutation_holder>> ms,
+            gms::inet_address target,
+            std::vector<gms::inet_address> pending_endpoints,
+            db::write_type type,
+            write_stats& stats,
+            allow_hints allow_hints = allow_hints::yes);
 
     db::view::update_backlog get_view_update_backlog() const;
 
@@ -462,6 +609,11 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
     // Applies mutations on this node.
     // Resolves with timed_out_error when timeout is reached.
     future<> mutate_locally(std::vector<mutation> mutation, clock_type::time_point timeout = clock_type::time_point::max());
+    // Applies mutations on this node, with a single cross-shard call for the
+    // mutations owned by each shard. Resolves with the error of each mutation,
+    // null for the ones that were applied.
+    future<std::vector<std::exception_ptr>> mutate_locally(const std::vector<schema_ptr>& schemas, const std::vector<frozen_mutation>& mutations,
+            clock_type::time_point timeout);
 
     future<> mutate_hint(const schema_ptr&, const frozen_mutation& m, clock_type::time_point timeout = clock_type::time_point::max());
     future<> mutate_streaming_mutation(const schema_ptr&, utils::UUID plan_id, const frozen_mutation& m, bool fragmented);
@@ -507,12 +659,19 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
     // send_to_live_endpoints() - another take on the same original function.
     future<> send_to_endpoint(frozen_mutation_and_schema fm_a_s, gms::inet_address target, std::vector<gms::inet_address> pending_endpoints, db::write_type type, write_stats& stats, allow_hints allow_hints = allow_hints::yes);
     future<> send_to_endpoint(frozen_mutation_and_schema fm_a_s, gms::inet_address target, std::vector<gms::inet_address> pending_endpoints, db::write_type type, allow_hints allow_hints = allow_hints::yes);
+    // Send several mutations to one specific remote target, starting all of their writes together,
+    // so that they can travel in a single message. The returned future fails if any of the writes failed.
+    future<> send_to_endpoint(std::vector<frozen_mutation_and_schema> fms, gms::inet_address target, std::vector<gms::inet_address> pending_endpoints, db::write_type type, write_stats& stats, allow_hints allow_hints = allow_hints::yes);
 
     // Send a mutation to a specific remote target as a hint.
     // Unlike regular mutations during write operations, hints are sent on the streaming connection
     // and use different RPC verb.
     future<> send_hint_to_endpoint(frozen_mutation_and_schema fm_a_s, gms::inet_address target);
 
+    // Send several hints to a specific remote target, starting all of their writes together.
+    // The returned future fails if any of the hints failed to be written.
+    future<> send_hints_to_endpoint(std::vector<frozen_mutation_and_schema> fms, gms::inet_address target);
+
     /**
      * Performs the truncate operatoin, which effectively deletes all data from
      * the column family cfname
@@ -541,6 +700,18 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
         db::consistency_level cl,
         coordinator_query_options optional_params);
 
+    // Whether this node is a natural replica of the token in keyspace ks.
+    bool is_local_replica(keyspace& ks, const dht::token& token) const;
+
+    // Reads a single partition straight from the shard of this node which
+    // owns it, without going through the read executors of query(). Only
+    // valid for CL=ONE and CL=LOCAL_ONE reads of a partition for which
+    // is_local_replica() holds.
+    future<foreign_ptr<lw_shared_ptr<query::result>>> query_local_replica(schema_ptr,
+        lw_shared_ptr<query::read_command> cmd,
+        const dht::partition_range& pr,
+        clock_type::time_point timeout);
+
     future<rpc::tuple<foreign_ptr<lw_shared_ptr<reconcilable_result>>, cache_temperature>> query_mutations_locally(
         schema_ptr, lw_shared_ptr<query::read_command> cmd, const dht::partition_range&,
         clock_type::time_point timeout,
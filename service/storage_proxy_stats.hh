@@ -23,6 +23,7 @@
 
 #include "gms/inet_address.hh"
 #include "utils/estimated_histogram.hh"
+#include "utils/decaying_histogram.hh"
 #include "utils/histogram.hh"
 #include <seastar/core/metrics.hh>
 
@@ -91,6 +92,7 @@ struct write_stats {
 
     utils::timed_rate_moving_average_and_histogram write;
     utils::estimated_histogram estimated_write;
+    utils::decaying_latency_histogram decaying_write;
 
     utils::timed_rate_moving_average cas_write_unavailables;
     utils::timed_rate_moving_average cas_write_timeouts;
@@ -107,6 +109,16 @@ struct write_stats {
     // A CQL read query arrived to a non-replica node and was
     // forwarded by a coordinator to a replica
     uint64_t reads_coordinator_outside_replica_set = 0;
+    // Partitions of multi-partition reads sent to their replica together
+    // with other partitions, in a single request
+    uint64_t grouped_partition_reads = 0;
+    // Single-partition CL=ONE requests served by the shard which replicates
+    // the partition, without a read executor or a write response handler,
+    // and those of them which failed and were retried the general way
+    uint64_t local_replica_reads = 0;
+    uint64_t local_replica_read_fallbacks = 0;
+    uint64_t local_replica_writes = 0;
+    uint64_t local_replica_write_fallbacks = 0;
     uint64_t background_writes = 0; // client no longer waits for the write
     uint64_t throttled_writes = 0; // total number of writes ever delayed due to throttling
     uint64_t throttled_base_writes = 0; // current number of base writes delayed due to view update backlog
@@ -120,6 +132,9 @@ struct write_stats {
     uint64_t cas_prune = 0;
     uint64_t cas_coordinator_dropped_prune = 0;
     uint64_t cas_replica_dropped_prune = 0;
+    // lookups of the paxos state of a key in the replica's cache, saving a read of system.paxos
+    uint64_t cas_replica_state_cache_hits = 0;
+    uint64_t cas_replica_state_cache_misses = 0;
 
 
     std::chrono::microseconds last_mv_flow_control_delay; // delay added for MV flow control in the last request
@@ -148,13 +163,30 @@ struct stats : public write_stats {
     uint64_t read_repair_attempts = 0;
     uint64_t read_repair_repaired_blocking = 0;
     uint64_t read_repair_repaired_background = 0;
+    // Partitions of read repairs queued to be written in the background, and
+    // how many of these writes succeeded, failed, or were dropped for the
+    // queue being full (see deferred_read_repair).
+    uint64_t deferred_read_repairs_queued = 0;
+    uint64_t deferred_read_repairs_applied = 0;
+    uint64_t deferred_read_repairs_failed = 0;
+    uint64_t deferred_read_repairs_dropped = 0;
     uint64_t global_read_repairs_canceled_due_to_concurrent_write = 0;
 
     // number of mutations received as a coordinator
     uint64_t received_mutations = 0;
 
+    // number of MUTATIONS messages sent as a coordinator and received as a replica
+    uint64_t sent_mutation_batches = 0;
+    uint64_t received_mutation_batches = 0;
+
+    // number of replica writes delayed by write coalescing
+    uint64_t coalesced_writes = 0;
+
     // number of counter updates received as a leader
     uint64_t received_counter_updates = 0;
+    // number of counter updates merged into another update to the same
+    // partition by counter update coalescing
+    uint64_t coalesced_counter_updates = 0;
 
     // number of forwarded mutations
     uint64_t forwarded_mutations = 0;
@@ -166,10 +198,13 @@ struct stats : public write_stats {
     uint64_t replica_mutation_data_reads = 0;
 
     uint64_t replica_cross_shard_ops = 0;
+    // Range reads served by a single shard, without the multishard reader.
+    uint64_t replica_single_shard_range_reads = 0;
 
     utils::timed_rate_moving_average_and_histogram read;
     utils::timed_rate_moving_average_and_histogram range;
     utils::estimated_histogram estimated_read;
+    utils::decaying_latency_histogram decaying_read;
     utils::estimated_histogram estimated_range;
 
     utils::timed_rate_moving_average_and_histogram cas_read;
@@ -180,6 +215,7 @@ struct stats : public write_stats {
     uint64_t read_retries = 0; // read is retried with new limit
     uint64_t speculative_digest_reads = 0;
     uint64_t speculative_data_reads = 0;
+    uint64_t speculative_reads_throttled = 0;
 
     uint64_t cas_read_unfinished_commit = 0;
 
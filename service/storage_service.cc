@@ -82,6 +82,7 @@
 #include "cdc/generation.hh"
 #include "repair/repair.hh"
 #include "service/priority_manager.hh"
+#include "db/snapshot_backup.hh"
 
 using token = dht::token;
 using UUID = utils::UUID;
@@ -115,6 +116,7 @@ storage_service::storage_service(abort_source& abort_source, distributed<databas
         , _mnotifier(mn)
         , _service_memory_total(config.available_memory / 10)
         , _service_memory_limiter(_service_memory_total)
+        , _service_levels(config.service_levels)
         , _for_testing(for_testing)
         , _token_metadata(tm)
         , _mc_feature_listener(*this, _feature_listeners_sem, sstables::sstable_version_types::mc)
@@ -2199,6 +2201,47 @@ future<int64_t> storage_service::true_snapshots_size() {
     });
 }
 
+future<uint64_t> storage_service::backup_snapshot(sstring tag, std::vector<sstring> keyspace_names, sstring destination) {
+    if (tag.empty()) {
+        throw std::runtime_error("You must supply a snapshot name.");
+    }
+    if (destination.empty()) {
+        throw std::runtime_error("You must supply a backup destination.");
+    }
+
+    if (keyspace_names.size() == 0) {
+        boost::copy(_db.local().get_keyspaces() | boost::adaptors::map_keys, std::back_inserter(keyspace_names));
+    };
+
+    return run_snapshot_list_operation([this, tag = std::move(tag), keyspace_names = std::move(keyspace_names), destination = std::move(destination)] {
+        return _db.map_reduce(adder<uint64_t>(), [tag, keyspace_names, destination] (database& db) {
+            return with_scheduling_group(db.get_backup_scheduling_group(), [&db, tag, keyspace_names, destination] {
+                // Each table is copied by one shard, which splits the node-wide limit with the others.
+                std::vector<lw_shared_ptr<table>> tables;
+                for (auto& ks_name : keyspace_names) {
+                    for (auto& pair : db.find_keyspace(ks_name).metadata()->cf_meta_data()) {
+                        if (std::hash<utils::UUID>()(pair.second->id()) % smp::count == this_shard_id()) {
+                            tables.push_back(db.find_column_family(pair.second).shared_from_this());
+                        }
+                    }
+                }
+                auto limiter = make_lw_shared<db::bandwidth_limiter>([&cfg = db.get_config()] {
+                    return uint64_t(cfg.snapshot_backup_throughput_mb_per_sec()) * (1 << 20) / smp::count;
+                });
+                return do_with(std::move(tables), uint64_t(0), [tag, destination, limiter] (auto& tables, uint64_t& total) {
+                    return do_for_each(tables, [tag, destination, limiter, &total] (lw_shared_ptr<table>& t) {
+                        return db::backup_snapshot(*t, tag, destination, *limiter).then([&total] (uint64_t copied) {
+                            total += copied;
+                        });
+                    }).then([&total] {
+                        return total;
+                    });
+                });
+            });
+        });
+    });
+}
+
 static std::atomic<bool> isolated = { false };
 
 future<> storage_service::start_rpc_server() {
@@ -2274,10 +2317,18 @@ future<> storage_service::start_native_transport() {
             cql_transport::cql_server_config cql_server_config;
             cql_server_config.timeout_config = make_timeout_config(cfg);
             cql_server_config.max_request_size = ss._service_memory_total;
+            cql_server_config.service_levels = ss._service_levels;
             cql_server_config.get_service_memory_limiter_semaphore = [ss = std::ref(get_storage_service())] () -> semaphore& { return ss.get().local()._service_memory_limiter; };
             cql_server_config.allow_shard_aware_drivers = cfg.enable_shard_aware_drivers();
             cql_server_config.sharding_ignore_msb = cfg.murmur3_partitioner_ignore_msb_bits();
             cql_server_config.partitioner_name = cfg.partitioner();
+            if (cfg.native_shard_aware_transport_port() != 0) {
+                cql_server_config.shard_aware_transport_port = cfg.native_shard_aware_transport_port();
+            }
+            if (ceo.at("enabled") == "true" && cfg.native_transport_port_ssl.is_set() && cfg.native_transport_port_ssl() != cfg.native_transport_port()
+                    && cfg.native_shard_aware_transport_port_ssl() != 0) {
+                cql_server_config.shard_aware_transport_port_ssl = cfg.native_shard_aware_transport_port_ssl();
+            }
             smp_service_group_config cql_server_smp_service_group_config;
             cql_server_smp_service_group_config.max_nonlocal_requests = 5000;
             cql_server_config.bounce_request_smp_service_group = create_smp_service_group(cql_server_smp_service_group_config).get0();
@@ -2286,9 +2337,13 @@ future<> storage_service::start_native_transport() {
             struct listen_cfg {
                 socket_address addr;
                 std::shared_ptr<seastar::tls::credentials_builder> cred;
+                bool is_shard_aware = false;
             };
 
             std::vector<listen_cfg> configs({ { socket_address{ip, cfg.native_transport_port()} }});
+            if (cfg.native_shard_aware_transport_port() != 0) {
+                configs.push_back(listen_cfg{ socket_address{ip, cfg.native_shard_aware_transport_port()}, {}, true });
+            }
 
             // main should have made sure values are clean and neatish
             if (ceo.at("enabled") == "true") {
@@ -2313,16 +2368,22 @@ future<> storage_service::start_native_transport() {
                 slogger.info("Enabling encrypted CQL connections between client and server");
 
                 if (cfg.native_transport_port_ssl.is_set() && cfg.native_transport_port_ssl() != cfg.native_transport_port()) {
-                    configs.emplace_back(listen_cfg{{ip, cfg.native_transport_port_ssl()}, std::move(cred)});
+                    configs.emplace_back(listen_cfg{{ip, cfg.native_transport_port_ssl()}, cred});
+                    if (cfg.native_shard_aware_transport_port_ssl() != 0) {
+                        configs.emplace_back(listen_cfg{{ip, cfg.native_shard_aware_transport_port_ssl()}, std::move(cred), true});
+                    }
                 } else {
-                    configs.back().cred = std::move(cred);
+                    // Without a separate TLS port all ports are encrypted, the shard-aware one included.
+                    for (auto& c : configs) {
+                        c.cred = cred;
+                    }
                 }
             }
 
             parallel_for_each(configs, [cserver, keepalive](const listen_cfg & cfg) {
-                return cserver->invoke_on_all(&cql_transport::cql_server::listen, cfg.addr, cfg.cred, keepalive).then([cfg] {
-                    slogger.info("Starting listening for CQL clients on {} ({})"
-                            , cfg.addr, cfg.cred ? "encrypted" : "unencrypted"
+                return cserver->invoke_on_all(&cql_transport::cql_server::listen, cfg.addr, cfg.cred, cfg.is_shard_aware, keepalive).then([cfg] {
+                    slogger.info("Starting listening for CQL clients on {} ({}, {})"
+                            , cfg.addr, cfg.cred ? "encrypted" : "unencrypted", cfg.is_shard_aware ? "shard-aware" : "non-shard-aware"
                     );
                 });
             }).get();
@@ -2516,6 +2577,11 @@ future<> storage_service::removenode(sstring host_id_string) {
 
 // Runs inside seastar::async context
 void storage_service::flush_column_families() {
+    // Client servers and messaging are stopped by now, so there are no writes
+    // for the flushes to make room for, only the time to drain matters.
+    _db.invoke_on_all([] (database& db) {
+        db.expedite_flushes();
+    }).get();
     service::get_storage_service().invoke_on_all([] (auto& ss) {
         auto& local_db = ss.db().local();
         auto non_system_cfs = local_db.get_column_families() | boost::adaptors::filtered([] (auto& uuid_and_cf) {
@@ -2567,13 +2633,17 @@ future<> storage_service::drain() {
             ss.set_mode(mode::DRAINING, "shutting down messaging_service", false);
             ss.do_stop_ms().get();
 
-            // Interrupt on going compaction and shutdown to prevent further compaction
-            ss.db().invoke_on_all([] (auto& db) {
+            // Interrupt on going compaction and shutdown to prevent further compaction.
+            // The outputs of interrupted compactions are discarded, so flushing doesn't
+            // need to wait for them to stop, and gets the I/O bandwidth they release.
+            auto stop_compactions = ss.db().invoke_on_all([] (auto& db) {
                 return db.get_compaction_manager().stop();
-            }).get();
+            });
 
             ss.set_mode(mode::DRAINING, "flushing column families", false);
-            ss.flush_column_families();
+            when_all_succeed(std::move(stop_compactions), seastar::async([&ss] {
+                ss.flush_column_families();
+            })).get();
 
             db::get_batchlog_manager().invoke_on_all([] (auto& bm) {
                 return bm.stop();
@@ -3024,6 +3094,21 @@ future<> storage_service::load_new_sstables(sstring ks_name, sstring cf_name) {
     });
 }
 
+future<> storage_service::load_and_stream_new_sstables(sstring ks_name, sstring cf_name) {
+    if (_loading_new_sstables) {
+        throw std::runtime_error("Already loading SSTables. Try again later");
+    } else {
+        _loading_new_sstables = true;
+    }
+
+    slogger.info("Loading new SSTables for {}.{} and streaming them to their replicas...", ks_name, cf_name);
+    return distributed_loader::load_and_stream(_db, ks_name, cf_name).then([ks_name, cf_name] {
+        slogger.info("Done loading and streaming new SSTables for {}.{}", ks_name, cf_name);
+    }).finally([this] {
+        _loading_new_sstables = false;
+    });
+}
+
 void storage_service::shutdown_client_servers() {
     do_stop_rpc_server().get();
     do_stop_native_transport().get();
@@ -40,6 +40,7 @@
 #pragma once
 
 #include "auth/service.hh"
+#include "auth/service_level.hh"
 #include "gms/i_endpoint_state_change_subscriber.hh"
 #include "service/endpoint_lifecycle_subscriber.hh"
 #include "locator/token_metadata.hh"
@@ -122,6 +123,8 @@ class feature_enabled_listener : public gms::feature::listener {
 
 struct storage_service_config {
     size_t available_memory;
+    // Must outlive the storage service; shared by all shards.
+    const auth::service_level_controller* service_levels = nullptr;
 };
 
 /**
@@ -170,6 +173,7 @@ class storage_service : public service::migration_listener, public gms::i_endpoi
     seastar::metrics::metric_groups _metrics;
     size_t _service_memory_total;
     semaphore _service_memory_limiter;
+    const auth::service_level_controller* _service_levels;
     using client_shutdown_hook = noncopyable_function<void()>;
     std::vector<std::pair<std::string, client_shutdown_hook>> _client_shutdown_hooks;
 
@@ -744,6 +748,18 @@ class storage_service : public service::migration_listener, public gms::i_endpoi
 
     future<int64_t> true_snapshots_size();
 
+    /**
+     * Copies the snapshot with the given tag of the given keyspaces to the
+     * destination directory, skipping the sstables copied by earlier backups,
+     * see db::backup_snapshot(). The tables are spread over the shards, and
+     * copied in the backup scheduling group, throttled to
+     * snapshot_backup_throughput_mb_per_sec.
+     *
+     * @param keyspace_names the keyspaces to back up; empty means "all."
+     * @return the number of bytes copied
+     */
+    future<uint64_t> backup_snapshot(sstring tag, std::vector<sstring> keyspace_names, sstring destination);
+
     /**
      * Get all ranges an endpoint is responsible for (by keyspace)
      * Replication strategy's get_ranges() guarantees that no wrap-around range is returned.
@@ -889,6 +905,17 @@ class storage_service : public service::migration_listener, public gms::i_endpoi
      */
     future<> load_new_sstables(sstring ks_name, sstring cf_name);
 
+    /**
+     * Streams the content of the SSTables found in the upload directory of the given
+     * column family to the current replicas of each partition, so that a backup can
+     * be restored regardless of the token ownership it was taken with. The SSTables
+     * are removed once streamed.
+     *
+     * Like load_new_sstables(), this can't be called in parallel with itself or with
+     * load_new_sstables().
+     */
+    future<> load_and_stream_new_sstables(sstring ks_name, sstring cf_name);
+
     template <typename Func>
     auto run_with_api_lock(sstring operation, Func&& func) {
         return get_storage_service().invoke_on(0, [operation = std::move(operation),
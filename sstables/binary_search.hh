@@ -58,7 +58,8 @@ int binary_search(const dht::i_partitioner& partitioner, const T& entries, const
         // creation by keeping only a key view, and then manually carrying out
         // both parts of the comparison ourselves.
         mid = low + ((high - low) >> 1);
-        key_view mid_key = entries[mid].get_key();
+        auto&& mid_entry = entries[mid];
+        key_view mid_key = mid_entry.get_key();
         auto mid_token = partitioner.get_token(mid_key);
 
         if (token == mid_token) {
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+
+#include <boost/algorithm/cxx11/any_of.hpp>
+#include <seastar/core/byteorder.hh>
+
+#include "sstables/clustering_ranges.hh"
+#include "sstables/writer.hh"
+#include "sstables/exceptions.hh"
+
+namespace sstables {
+namespace clustering_ranges {
+
+void partition_info::add_clustered(const schema& s, position_in_partition_view start, position_in_partition_view end) {
+    position_in_partition::less_compare less(s);
+    if (!first) {
+        first = position_in_partition(start);
+    }
+    if (!last || less(*last, end)) {
+        last = position_in_partition(end);
+    }
+    flags |= has_clustered;
+}
+
+bool partition_info::excludes(const schema& s, const query::clustering_row_ranges& ranges) const {
+    if (flags & (has_partition_tombstone | has_static_row)) {
+        return false;
+    }
+    if (!(flags & has_clustered)) {
+        return true;
+    }
+    return !boost::algorithm::any_of(ranges, [&] (const query::clustering_range& r) {
+        return position_range::from_range(r).overlaps(s, *first, *last);
+    });
+}
+
+writer::writer(file_writer& out)
+    : _out(out)
+{ }
+
+void writer::write_position(const position_in_partition& pos) {
+    auto prefix = pos.has_key() ? pos.key().representation() : bytes_view();
+    auto p = _buf.size();
+    _buf.resize(p + sizeof(int8_t) + sizeof(uint16_t) + prefix.size());
+    write_be<int8_t>(_buf.data() + p, int8_t(pos.get_bound_weight()));
+    write_be<uint16_t>(_buf.data() + p + sizeof(int8_t), prefix.size());
+    std::copy(prefix.begin(), prefix.end(), _buf.data() + p + sizeof(int8_t) + sizeof(uint16_t));
+}
+
+void writer::add(uint64_t data_position, const partition_info& info) {
+    if (_partitions++ % sample_interval == 0) {
+        _samples.emplace_back(data_position, _out.offset());
+    }
+    _buf.resize(sizeof(uint64_t) + sizeof(uint8_t));
+    write_be<uint64_t>(_buf.data(), data_position);
+    write_be<uint8_t>(_buf.data() + sizeof(uint64_t), info.flags);
+    if (info.flags & partition_info::has_clustered) {
+        write_position(*info.first);
+        write_position(*info.last);
+    }
+    _out.write(_buf.data(), _buf.size());
+}
+
+void writer::finish() {
+    auto samples_offset = _out.offset();
+    std::array<char, 2 * sizeof(uint64_t)> sample;
+    for (auto& [data_position, offset] : _samples) {
+        write_be<uint64_t>(sample.data(), data_position);
+        write_be<uint64_t>(sample.data() + sizeof(uint64_t), offset);
+        _out.write(sample.data(), sample.size());
+    }
+    std::array<char, footer_size> footer;
+    write_be<uint64_t>(footer.data(), samples_offset);
+    write_be<uint64_t>(footer.data() + sizeof(uint64_t), _samples.size());
+    write_be<uint64_t>(footer.data() + 2 * sizeof(uint64_t), footer_magic);
+    _out.write(footer.data(), footer.size());
+}
+
+future<summary> read_summary(file f, uint64_t file_size, const io_priority_class& pc) {
+    if (file_size < footer_size) {
+        return make_exception_future<summary>(malformed_sstable_exception(format("ClusteringRanges too small: {:d} bytes", file_size)));
+    }
+    return f.dma_read_exactly<char>(file_size - footer_size, footer_size, pc).then([f, file_size, &pc] (temporary_buffer<char> footer) mutable {
+        auto samples_offset = read_be<uint64_t>(footer.get());
+        auto samples = read_be<uint64_t>(footer.get() + sizeof(uint64_t));
+        if (read_be<uint64_t>(footer.get() + 2 * sizeof(uint64_t)) != footer_magic
+                || samples_offset + samples * 2 * sizeof(uint64_t) + footer_size != file_size) {
+            throw malformed_sstable_exception("Invalid ClusteringRanges footer");
+        }
+        if (!samples) {
+            return make_ready_future<summary>();
+        }
+        return f.dma_read_exactly<char>(samples_offset, samples * 2 * sizeof(uint64_t), pc).then([samples_offset, samples] (temporary_buffer<char> buf) {
+            summary s;
+            s.records_end = samples_offset;
+            s.data_positions.reserve(samples);
+            s.offsets.reserve(samples);
+            for (uint64_t i = 0; i < samples; ++i) {
+                auto p = buf.get() + i * 2 * sizeof(uint64_t);
+                s.data_positions.push_back(read_be<uint64_t>(p));
+                s.offsets.push_back(read_be<uint64_t>(p + sizeof(uint64_t)));
+            }
+            return s;
+        });
+    });
+}
+
+namespace {
+
+class record_parser {
+    const char* _p;
+    const char* _end;
+private:
+    void check(size_t n) const {
+        if (size_t(_end - _p) < n) {
+            throw malformed_sstable_exception("Truncated ClusteringRanges record");
+        }
+    }
+public:
+    record_parser(const temporary_buffer<char>& buf) : _p(buf.begin()), _end(buf.end()) { }
+    bool at_end() const {
+        return _p == _end;
+    }
+    template <typename T>
+    T read() {
+        check(sizeof(T));
+        auto v = read_be<T>(_p);
+        _p += sizeof(T);
+        return v;
+    }
+    position_in_partition read_position() {
+        auto weight = bound_weight(read<int8_t>());
+        auto len = read<uint16_t>();
+        check(len);
+        auto prefix = clustering_key_prefix::from_bytes(bytes_view(reinterpret_cast<const int8_t*>(_p), len));
+        _p += len;
+        return position_in_partition(partition_region::clustered, weight, std::move(prefix));
+    }
+};
+
+}
+
+future<std::optional<partition_info>> lookup(file f, const summary& s, uint64_t data_position, const io_priority_class& pc) {
+    auto it = std::upper_bound(s.data_positions.begin(), s.data_positions.end(), data_position);
+    if (it == s.data_positions.begin()) {
+        return make_ready_future<std::optional<partition_info>>();
+    }
+    auto i = std::distance(s.data_positions.begin(), it) - 1;
+    auto start = s.offsets[i];
+    auto end = size_t(i + 1) < s.offsets.size() ? s.offsets[i + 1] : s.records_end;
+    return f.dma_read_exactly<char>(start, end - start, pc).then([data_position] (temporary_buffer<char> buf) {
+        record_parser parser(buf);
+        while (!parser.at_end()) {
+            partition_info info;
+            auto position = parser.read<uint64_t>();
+            info.flags = parser.read<uint8_t>();
+            if (info.flags & partition_info::has_clustered) {
+                info.first = parser.read_position();
+                info.last = parser.read_position();
+            }
+            if (position == data_position) {
+                return std::optional<partition_info>(std::move(info));
+            }
+            if (position > data_position) {
+                break;
+            }
+        }
+        return std::optional<partition_info>();
+    });
+}
+
+}
+}
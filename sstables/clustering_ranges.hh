@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <seastar/core/file.hh>
+#include <seastar/core/future.hh>
+
+#include "seastarx.hh"
+#include "position_in_partition.hh"
+#include "query-request.hh"
+#include "utils/chunked_vector.hh"
+
+namespace sstables {
+
+class file_writer;
+
+// The ClusteringRanges component records, for every partition of an sstable,
+// which clustering positions the partition's rows and range tombstones span
+// in that sstable. A single-partition read whose slice lies entirely outside
+// that span can then produce the (empty) partition without reading Data.db,
+// which is the common case for time-series tables whose partitions are spread
+// over many sstables by time window.
+//
+// Records are written in data file order (all integers big-endian):
+//
+//   uint64_t data_position      (of the partition in Data.db)
+//   uint8_t  flags
+//   position first, last        (only if flags has has_clustered)
+//
+// where a position is an int8_t bound weight, a uint16_t length and the
+// serialized clustering prefix. Every sample_interval-th record is sampled
+// and the samples, (data_position, record offset) pairs, follow the records.
+// The file ends with a footer: the offset of the samples, their number and
+// a magic number.
+namespace clustering_ranges {
+
+constexpr uint64_t footer_magic = 0x5343594c434b5247; // "SCYLCKRG"
+constexpr size_t footer_size = 3 * sizeof(uint64_t);
+constexpr size_t sample_interval = 64;
+
+// What a partition holds in a single sstable, as far as slicing goes.
+struct partition_info {
+    static constexpr uint8_t has_partition_tombstone = 1;
+    static constexpr uint8_t has_static_row = 2;
+    static constexpr uint8_t has_clustered = 4;
+
+    uint8_t flags = 0;
+    // Start of the first and end of the last clustered fragment.
+    std::optional<position_in_partition> first;
+    std::optional<position_in_partition> last;
+
+    void add_clustered(const schema& s, position_in_partition_view start, position_in_partition_view end);
+    // Whether reading ranges from this partition yields just an empty
+    // partition, i.e. no tombstone, no static row and no clustered
+    // fragment within ranges.
+    bool excludes(const schema& s, const query::clustering_row_ranges& ranges) const;
+};
+
+// Writes the component. Must be called in a seastar thread.
+class writer {
+    file_writer& _out;
+    std::vector<std::pair<uint64_t, uint64_t>> _samples;
+    uint64_t _partitions = 0;
+    std::vector<char> _buf;
+private:
+    void write_position(const position_in_partition& pos);
+public:
+    explicit writer(file_writer& out);
+    // Partitions must be added in data file order.
+    void add(uint64_t data_position, const partition_info& info);
+    void finish();
+};
+
+// The samples of a component, kept in memory to locate records.
+struct summary {
+    utils::chunked_vector<uint64_t> data_positions;
+    utils::chunked_vector<uint64_t> offsets;
+    uint64_t records_end = 0;
+};
+
+future<summary> read_summary(file f, uint64_t file_size, const io_priority_class& pc);
+
+// Returns the record of the partition which starts at data_position in
+// Data.db, or std::nullopt if the component has none.
+future<std::optional<partition_info>> lookup(file f, const summary& s, uint64_t data_position, const io_priority_class& pc);
+
+}
+
+}
@@ -377,6 +377,19 @@ class resharding_backlog_tracker final : public compaction_backlog_tracker::impl
     }
 };
 
+// In the adaptive compression mode, chooses the chunk length of the output
+// sstables after the median size of the sstable reads of the table,
+// so that point reads decompress little more than they need while scans get
+// the better ratio of large chunks.
+static std::optional<compression_parameters> output_compression(const column_family& cf, const schema& s) {
+    auto& cp = s.get_compressor_params();
+    if (!cp.is_auto_chunk_length()) {
+        return std::nullopt;
+    }
+    auto read_size = cf.get_stats().estimated_sstable_read_size.percentile(0.5);
+    return cp.with_chunk_length(compression_parameters::auto_chunk_length(read_size));
+}
+
 class compaction {
 protected:
     column_family& _cf;
@@ -393,6 +406,8 @@ class compaction {
     uint64_t _estimated_partitions = 0;
     std::vector<unsigned long> _ancestors;
     db::replay_position _rp;
+    // Output is marked as repaired only if all of the input was repaired.
+    uint64_t _repaired_at;
     encoding_stats_collector _stats_collector;
     utils::observable<> _on_new_sstable_sealed;
     bool _contains_multi_fragment_runs = false;
@@ -406,8 +421,10 @@ class compaction {
         , _sstable_level(sstable_level)
     {
         _info->cf = &cf;
+        _repaired_at = _sstables.empty() ? 0 : std::numeric_limits<uint64_t>::max();
         for (auto& sst : _sstables) {
             _stats_collector.update(sst->get_encoding_stats_for_compaction());
+            _repaired_at = std::min(_repaired_at, sst->get_repaired_at());
         }
         std::unordered_set<utils::UUID> ssts_run_ids;
         _contains_multi_fragment_runs = std::any_of(_sstables.begin(), _sstables.end(), [&ssts_run_ids] (shared_sstable& sst) {
@@ -426,6 +443,7 @@ class compaction {
         _new_unused_sstables.push_back(sst);
         sst->get_metadata_collector().set_replay_position(_rp);
         sst->get_metadata_collector().sstable_level(_sstable_level);
+        sst->get_metadata_collector().set_repaired_at(_repaired_at);
         for (auto ancestor : _ancestors) {
             sst->add_ancestor(ancestor);
         }
@@ -477,7 +495,7 @@ class compaction {
     flat_mutation_reader setup() {
         auto ssts = make_lw_shared<sstables::sstable_set>(_cf.get_compaction_strategy().make_sstable_set(_schema));
         sstring formatted_msg = "[";
-        auto fully_expired = get_fully_expired_sstables(_cf, _sstables, gc_clock::now() - _schema->gc_grace_seconds());
+        auto fully_expired = get_fully_expired_sstables(_cf, _sstables, _cf.get_compaction_strategy().expired_sstables_gc_before(*_schema));
 
         for (auto& sst : _sstables) {
             // Compacted sstable keeps track of its ancestors.
@@ -558,6 +576,16 @@ class compaction {
         };
     }
 
+    // Unless tombstones are purged based on repair history, gc_before is the same for all partitions.
+    std::function<gc_clock::time_point(const dht::decorated_key&)> gc_before_func(gc_clock::time_point compaction_time) const {
+        if (!_cf.get_compaction_strategy().repair_based_tombstone_gc()) {
+            return {};
+        }
+        return [&cf = _cf, compaction_time] (const dht::decorated_key& dk) {
+            return cf.get_gc_before(dk.token(), compaction_time);
+        };
+    }
+
     virtual flat_mutation_reader::filter make_partition_filter() const {
         return [] (const dht::decorated_key&) {
             return true;
@@ -665,6 +693,7 @@ void garbage_collected_sstable_writer::maybe_create_new_sstable_writer() {
         _active_write_monitors.emplace_back(_sst, _c->_cf, _c->maximum_timestamp(), _c->_sstable_level);
         sstable_writer_config cfg = _c->_cf.get_sstables_manager().configure_writer();
         cfg.run_identifier = _run_identifier;
+        cfg.compression = output_compression(_c->_cf, *_c->schema());
         cfg.monitor = &_active_write_monitors.back();
         _writer.emplace(_sst->get_writer(*_c->schema(), _c->partitions_per_sstable(), cfg, _c->get_encoding_stats(), priority));
     }
@@ -701,8 +730,11 @@ class regular_compaction : public compaction {
     mutable compaction_read_monitor_generator _monitor_generator;
     std::deque<compaction_write_monitor> _active_write_monitors = {};
     utils::UUID _run_identifier;
+    // Range of the input which is compacted, all of it unless this compaction
+    // is one of the sub-range compactions of a split job.
+    dht::partition_range _range;
 public:
-    regular_compaction(column_family& cf, compaction_descriptor descriptor)
+    regular_compaction(column_family& cf, compaction_descriptor descriptor, std::optional<dht::partition_range> subrange = {})
         : compaction(cf, std::move(descriptor.creator), std::move(descriptor.sstables), descriptor.max_sstable_bytes, descriptor.level)
         , _replacer(std::move(descriptor.replacer))
         , _compacting_for_max_purgeable_func(std::unordered_set<shared_sstable>(_sstables.begin(), _sstables.end()))
@@ -711,15 +743,21 @@ class regular_compaction : public compaction {
         , _weight_registration(std::move(descriptor.weight_registration))
         , _monitor_generator(_cf.get_compaction_manager(), _cf)
         , _run_identifier(descriptor.run_identifier)
+        , _range(subrange ? std::move(*subrange) : query::full_partition_range)
     {
         _info->run_identifier = _run_identifier;
+        if (subrange) {
+            // The input sstables are shared with the other sub-range compactions,
+            // so only the job as a whole removes them from the backlog tracker.
+            _info->stop_tracking();
+        }
     }
 
     flat_mutation_reader make_sstable_reader() const override {
         return ::make_local_shard_sstable_reader(_schema,
                 no_reader_permit(),
                 _compacting,
-                query::full_partition_range,
+                _range,
                 _schema->full_slice(),
                 service::get_local_compaction_priority(),
                 tracing::trace_state_ptr(),
@@ -769,6 +807,7 @@ class regular_compaction : public compaction {
             sstable_writer_config cfg = _cf.get_sstables_manager().configure_writer();
             cfg.max_sstable_size = _max_sstable_size;
             cfg.monitor = &_active_write_monitors.back();
+            cfg.compression = output_compression(_cf, *_schema);
             cfg.run_identifier = _run_identifier;
             _writer.emplace(_sst->get_writer(*_schema, partitions_per_sstable(), cfg, get_encoding_stats(), priority));
         }
@@ -1139,6 +1178,98 @@ flat_mutation_reader make_scrubbing_reader(flat_mutation_reader rd, bool skip_co
     return make_flat_mutation_reader<scrub_compaction::reader>(std::move(rd), skip_corrupted);
 }
 
+// Splits the input into data which belongs to the repaired ranges, written to
+// sstables marked as repaired, and the rest, written to unrepaired sstables.
+class anticompaction final : public compaction {
+    replacer_fn _replacer;
+    compaction_options::anticompaction _options;
+    mutable compaction_read_monitor_generator _monitor_generator;
+    utils::UUID _run_identifier;
+    // Indexed by whether the output is repaired.
+    std::array<std::pair<shared_sstable, std::optional<sstable_writer>>, 2> _output_sstables;
+    bool _current_repaired = false;
+public:
+    anticompaction(column_family& cf, compaction_descriptor descriptor, compaction_options::anticompaction options)
+        : compaction(cf, std::move(descriptor.creator), std::move(descriptor.sstables), descriptor.max_sstable_bytes, descriptor.level)
+        , _replacer(std::move(descriptor.replacer))
+        , _options(std::move(options))
+        , _monitor_generator(_cf.get_compaction_manager(), _cf)
+        , _run_identifier(descriptor.run_identifier)
+    {
+        _info->type = compaction_type::Anticompaction;
+        _info->run_identifier = _run_identifier;
+    }
+
+    flat_mutation_reader make_sstable_reader() const override {
+        return ::make_local_shard_sstable_reader(_schema,
+                no_reader_permit(),
+                _compacting,
+                query::full_partition_range,
+                _schema->full_slice(),
+                service::get_local_compaction_priority(),
+                tracing::trace_state_ptr(),
+                ::streamed_mutation::forwarding::no,
+                ::mutation_reader::forwarding::no,
+                _monitor_generator);
+    }
+
+    void report_start(const sstring& formatted_msg) const override {
+        clogger.info("Anticompacting {}", formatted_msg);
+    }
+
+    void report_finish(const sstring& formatted_msg, std::chrono::time_point<db_clock> ended_at) const override {
+        clogger.info("Anticompacted {}", formatted_msg);
+    }
+
+    void backlog_tracker_adjust_charges() override {
+        _monitor_generator.remove_sstables(_info->tracking);
+    }
+
+    flat_mutation_reader::filter make_partition_filter() const override {
+        return [&s = *_schema] (const dht::decorated_key& dk) {
+            return dht::shard_of(s, dk.token()) == this_shard_id();
+        };
+    }
+
+    shared_sstable create_new_sstable() const override {
+        return _sstable_creator(this_shard_id());
+    }
+
+    sstable_writer* select_sstable_writer(const dht::decorated_key& dk) override {
+        _current_repaired = boost::algorithm::any_of(_options.repaired_ranges, [&dk] (const dht::token_range& r) {
+            return r.contains(dk.token(), dht::token_comparator());
+        });
+        auto& [sst, writer] = _output_sstables[_current_repaired];
+        if (!writer) {
+            sst = _sstable_creator(this_shard_id());
+            setup_new_sstable(sst);
+            sst->get_metadata_collector().set_repaired_at(_current_repaired ? _options.repaired_at : 0);
+
+            sstable_writer_config cfg = _cf.get_sstables_manager().configure_writer();
+            cfg.max_sstable_size = _max_sstable_size;
+            cfg.compression = output_compression(_cf, *_schema);
+            cfg.run_identifier = _run_identifier;
+            auto&& priority = service::get_local_compaction_priority();
+            writer.emplace(sst->get_writer(*_schema, partitions_per_sstable(), cfg, get_encoding_stats(), priority));
+        }
+        return &*writer;
+    }
+
+    void stop_sstable_writer() override {
+        auto& [sst, writer] = _output_sstables[_current_repaired];
+        finish_new_sstable(writer, sst);
+    }
+
+    void finish_sstable_writer() override {
+        for (auto& [sst, writer] : _output_sstables) {
+            if (writer) {
+                finish_new_sstable(writer, sst);
+            }
+        }
+        _replacer(get_compaction_completion_desc(std::move(_sstables), std::move(_new_unused_sstables)));
+    }
+};
+
 class resharding_compaction final : public compaction {
     std::vector<std::pair<shared_sstable, std::optional<sstable_writer>>> _output_sstables;
     shard_id _shard; // shard of current sstable writer
@@ -1235,6 +1366,7 @@ class resharding_compaction final : public compaction {
 
             sstable_writer_config cfg = _cf.get_sstables_manager().configure_writer();
             cfg.max_sstable_size = _max_sstable_size;
+            cfg.compression = output_compression(_cf, *_schema);
             // sstables generated for a given shard will share the same run identifier.
             cfg.run_identifier = _run_identifiers.at(_shard);
             auto&& priority = service::get_local_compaction_priority();
@@ -1265,11 +1397,13 @@ GCC6_CONCEPT(
 )
 future<compaction_info> compaction::run(std::unique_ptr<compaction> c, GCConsumer gc_consumer) {
     return seastar::async([c = std::move(c), gc_consumer = std::move(gc_consumer)] () mutable {
-        auto reader = c->setup();
+        auto activity = c->_cf.make_activity(utils::activity_type::compaction);
+        auto reader = make_activity_tagging_reader(c->setup(), activity);
 
         auto cr = c->get_compacting_sstable_writer();
-        auto cfc = make_stable_flattened_mutations_consumer<compact_for_compaction<compacting_sstable_writer, GCConsumer>>(
-                    *c->schema(), gc_clock::now(), c->max_purgeable_func(), std::move(cr), std::move(gc_consumer));
+        auto compaction_time = gc_clock::now();
+        auto cfc = activity_tagging_consumer(make_stable_flattened_mutations_consumer<compact_for_compaction<compacting_sstable_writer, GCConsumer>>(
+                    *c->schema(), compaction_time, c->max_purgeable_func(), std::move(cr), std::move(gc_consumer), c->gc_before_func(compaction_time)), activity);
 
         auto start_time = db_clock::now();
         try {
@@ -1290,7 +1424,7 @@ future<compaction_info> compaction::run(std::unique_ptr<compaction> c, GCConsume
 
 compaction_type compaction_options::type() const {
     // Maps options_variant indexes to the corresponding compaction_type member.
-    static const compaction_type index_to_type[] = {compaction_type::Compaction, compaction_type::Cleanup, compaction_type::Upgrade, compaction_type::Scrub, compaction_type::Reshard};
+    static const compaction_type index_to_type[] = {compaction_type::Compaction, compaction_type::Cleanup, compaction_type::Upgrade, compaction_type::Scrub, compaction_type::Reshard, compaction_type::Anticompaction};
     return index_to_type[_options.index()];
 }
 
@@ -1314,17 +1448,116 @@ static std::unique_ptr<compaction> make_compaction(column_family& cf, sstables::
         std::unique_ptr<compaction> operator()(compaction_options::scrub scrub_options) {
             return std::make_unique<scrub_compaction>(cf, std::move(descriptor), scrub_options);
         }
+        std::unique_ptr<compaction> operator()(compaction_options::anticompaction anticompaction_options) {
+            return std::make_unique<anticompaction>(cf, std::move(descriptor), std::move(anticompaction_options));
+        }
     } visitor_factory{cf, std::move(descriptor)};
 
     return descriptor.options.visit(visitor_factory);
 }
 
+static unsigned subranges_for_compaction(const compaction_descriptor& descriptor) {
+    if (descriptor.max_parallel_subranges <= 1 || descriptor.options.type() != compaction_type::Compaction) {
+        return 1;
+    }
+    // Compaction of multi-fragment runs releases exhausted input fragments
+    // early, which relies on the output being written in a single pass.
+    std::unordered_set<utils::UUID> run_ids;
+    for (auto& sst : descriptor.sstables) {
+        if (!run_ids.insert(sst->run_identifier()).second) {
+            return 1;
+        }
+    }
+    uint64_t data_size = 0;
+    for (auto& sst : descriptor.sstables) {
+        data_size += sst->data_size();
+    }
+    // Every sub-range compaction reads the index of all input sstables, so
+    // splitting small jobs costs more than the parallelism gains.
+    auto subranges = data_size / std::max(descriptor.min_subrange_bytes, uint64_t(1));
+    return std::clamp(subranges, uint64_t(1), uint64_t(descriptor.max_parallel_subranges));
+}
+
+// Splits the token ring into n contiguous ranges of equal width.
+static dht::partition_range_vector split_token_ring(unsigned n) {
+    dht::partition_range_vector ranges;
+    ranges.reserve(n);
+    auto width = std::numeric_limits<uint64_t>::max() / n;
+    std::optional<dht::token_range::bound> start;
+    for (unsigned i = 1; i < n; i++) {
+        auto end = dht::token::from_int64(int64_t(uint64_t(std::numeric_limits<int64_t>::min()) + i * width));
+        ranges.push_back(dht::to_partition_range(dht::token_range(start, dht::token_range::bound(end, true))));
+        start = dht::token_range::bound(end, false);
+    }
+    ranges.push_back(dht::to_partition_range(dht::token_range(start, std::nullopt)));
+    return ranges;
+}
+
+// Compacts the input as n concurrent compactions, each of them restricted to
+// a disjoint token sub-range and writing its own fragments of the output run.
+// Input sstables are replaced only once all sub-range compactions are done.
+static future<compaction_info>
+compact_sstables_in_subranges(sstables::compaction_descriptor descriptor, column_family& cf, unsigned n) {
+    struct split_compaction {
+        sstables::compaction_descriptor descriptor;
+        std::vector<compaction_info> infos;
+        std::vector<shared_sstable> outputs;
+    };
+    clogger.debug("Splitting compaction of {} sstables of {}.{} into {} sub-ranges", descriptor.sstables.size(),
+            cf.schema()->ks_name(), cf.schema()->cf_name(), n);
+    return do_with(split_compaction{std::move(descriptor)}, split_token_ring(n), [&cf] (split_compaction& job, dht::partition_range_vector& ranges) {
+        job.infos.resize(ranges.size());
+        return parallel_for_each(boost::irange(size_t(0), ranges.size()), [&cf, &job, &ranges] (size_t i) {
+            auto desc = sstables::compaction_descriptor(job.descriptor.sstables, job.descriptor.level,
+                    job.descriptor.max_sstable_bytes, job.descriptor.run_identifier);
+            desc.creator = job.descriptor.creator;
+            desc.replacer = [&job] (compaction_completion_desc completion) {
+                std::move(completion.output_sstables.begin(), completion.output_sstables.end(), std::back_inserter(job.outputs));
+            };
+            auto c = std::make_unique<regular_compaction>(cf, std::move(desc), std::move(ranges[i]));
+            return compaction::run(std::move(c)).then([&job, i] (compaction_info info) {
+                job.infos[i] = std::move(info);
+            });
+        }).then_wrapped([&cf, &job] (future<> f) {
+            if (f.failed()) {
+                // Outputs of the sub-range compactions which succeeded were
+                // never added to the table.
+                for (auto& sst : job.outputs) {
+                    sst->mark_for_deletion();
+                }
+                return make_exception_future<compaction_info>(f.get_exception());
+            }
+            if (job.descriptor.weight_registration) {
+                cf.get_compaction_manager().on_compaction_complete(*job.descriptor.weight_registration);
+            }
+            auto info = std::move(job.infos.front());
+            for (auto it = std::next(job.infos.begin()); it != job.infos.end(); ++it) {
+                info.end_size += it->end_size;
+                info.total_keys_written += it->total_keys_written;
+                info.ended_at = std::max(info.ended_at, it->ended_at);
+                info.tracking &= it->tracking;
+            }
+            info.new_sstables = job.outputs;
+            if (info.tracking) {
+                for (auto& sst : job.descriptor.sstables) {
+                    cf.get_compaction_strategy().get_backlog_tracker().remove_sstable(sst);
+                }
+            }
+            job.descriptor.replacer(compaction_completion_desc{job.descriptor.sstables, std::move(job.outputs)});
+            return make_ready_future<compaction_info>(std::move(info));
+        });
+    });
+}
+
 future<compaction_info>
 compact_sstables(sstables::compaction_descriptor descriptor, column_family& cf) {
     if (descriptor.sstables.empty()) {
         throw std::runtime_error(format("Called {} compaction with empty set on behalf of {}.{}", compaction_name(descriptor.options.type()),
                 cf.schema()->ks_name(), cf.schema()->cf_name()));
     }
+    if (auto n = subranges_for_compaction(descriptor); n > 1) {
+        return compact_sstables_in_subranges(std::move(descriptor), cf, n);
+    }
     auto c = make_compaction(cf, std::move(descriptor));
     if (c->contains_multi_fragment_runs()) {
         auto gc_writer = c->make_garbage_collected_sstable_writer();
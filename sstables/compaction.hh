@@ -50,9 +50,15 @@ namespace sstables {
         };
         struct reshard {
         };
+        struct anticompaction {
+            // Data in these ranges is written to sstables marked as repaired,
+            // the rest to unrepaired ones.
+            dht::token_range_vector repaired_ranges;
+            uint64_t repaired_at;
+        };
 
     private:
-        using options_variant = std::variant<regular, cleanup, upgrade, scrub, reshard>;
+        using options_variant = std::variant<regular, cleanup, upgrade, scrub, reshard, anticompaction>;
 
     private:
         options_variant _options;
@@ -82,6 +88,10 @@ namespace sstables {
             return compaction_options(scrub{skip_corrupted});
         }
 
+        static compaction_options make_anticompaction(dht::token_range_vector repaired_ranges, uint64_t repaired_at) {
+            return compaction_options(anticompaction{std::move(repaired_ranges), repaired_at});
+        }
+
         template <typename... Visitor>
         auto visit(Visitor&&... visitor) const {
             return std::visit(std::forward<Visitor>(visitor)..., _options);
@@ -118,6 +128,12 @@ namespace sstables {
         // The options passed down to the compaction code.
         // This also selects the kind of compaction to do.
         compaction_options options = compaction_options::make_regular();
+        // Upper bound on the number of disjoint token sub-ranges a large regular compaction
+        // is split into. The sub-ranges are compacted concurrently, each into its own
+        // fragments of the output run.
+        unsigned max_parallel_subranges = 1;
+        // Minimum amount of input data given to each of those sub-ranges.
+        uint64_t min_subrange_bytes = default_min_subrange_bytes;
 
         creator_fn creator;
         replacer_fn replacer;
@@ -126,6 +142,7 @@ namespace sstables {
 
         static constexpr int default_level = 0;
         static constexpr uint64_t default_max_sstable_bytes = std::numeric_limits<uint64_t>::max();
+        static constexpr uint64_t default_min_subrange_bytes = uint64_t(1) << 30;
 
         explicit compaction_descriptor(std::vector<sstables::shared_sstable> sstables, int level = default_level,
                                        uint64_t max_sstable_bytes = default_max_sstable_bytes,
@@ -154,6 +171,7 @@ namespace sstables {
         Index_build = 4,
         Reshard = 5,
         Upgrade = 6,
+        Anticompaction = 7,
     };
 
     static inline sstring compaction_name(compaction_type type) {
@@ -172,6 +190,8 @@ namespace sstables {
             return "RESHARD";
         case compaction_type::Upgrade:
             return "UPGRADE";
+        case compaction_type::Anticompaction:
+            return "ANTICOMPACTION";
         default:
             throw std::runtime_error("Invalid Compaction Type");
         }
@@ -30,6 +30,9 @@
 #include "exceptions.hh"
 #include <cmath>
 #include <boost/range/algorithm/count_if.hpp>
+#include <boost/range/algorithm/stable_sort.hpp>
+#include <boost/range/algorithm/remove_if.hpp>
+#include <boost/range/adaptor/map.hpp>
 
 static logging::logger cmlog("compaction_manager");
 using namespace std::chrono_literals;
@@ -144,6 +147,23 @@ static inline int calculate_weight(const std::vector<sstables::shared_sstable>&
     return calculate_weight(get_total_size(sstables));
 }
 
+// The sstables that reads of the table are expected to stop reading per second, per byte compacted.
+// A read that touched several of the compacted sstables touches a single one afterwards, so jobs of
+// heavily read tables with a high read amplification are worth the most. The shard's postponed jobs
+// are resubmitted by decreasing value, to let the most valuable ones take the weights freed first.
+static double compaction_value(const column_family& cf, const std::vector<sstables::shared_sstable>& sstables) {
+    auto& stats = cf.get_stats();
+    auto reads_per_second = stats.reads.met.rate().rates[0];
+    auto sstables_per_read = std::min(double(stats.estimated_sstable_per_read.mean()), double(sstables.size()));
+    return reads_per_second * std::max(sstables_per_read - 1, 0.0) / (get_total_size(sstables) + 1);
+}
+
+// The sstables read per second by reads of the table beyond the first one.
+static double read_amplification_cost(const column_family& cf) {
+    auto& stats = cf.get_stats();
+    return stats.reads.met.rate().rates[0] * std::max(double(stats.estimated_sstable_per_read.mean()) - 1, 0.0);
+}
+
 int compaction_manager::trim_to_compact(column_family* cf, sstables::compaction_descriptor& descriptor) {
     int weight = calculate_weight(descriptor.sstables);
     // NOTE: a compaction job with level > 0 cannot be trimmed because leveled
@@ -225,6 +245,11 @@ std::vector<sstables::shared_sstable> compaction_manager::get_candidates(const c
         if (!cs.can_compact_partial_runs() && partial_run_identifiers.count(sst->run_identifier())) {
             continue;
         }
+        // Compacting an sstable whose data file doesn't match its digest
+        // would rewrite the corruption into new sstables.
+        if (sst->quarantined()) {
+            continue;
+        }
         candidates.push_back(sst);
     }
     return candidates;
@@ -357,7 +382,8 @@ future<> compaction_manager::task_stop(lw_shared_ptr<compaction_manager::task> t
     });
 }
 
-compaction_manager::compaction_manager(seastar::scheduling_group sg, const ::io_priority_class& iop, size_t available_memory)
+compaction_manager::compaction_manager(seastar::scheduling_group sg, const ::io_priority_class& iop, size_t available_memory,
+        std::function<std::optional<float>()> latency_pressure)
     : _compaction_controller(sg, iop, 250ms, [this, available_memory] () -> float {
         auto b = backlog() / available_memory;
         // This means we are using an unimplemented strategy
@@ -368,7 +394,7 @@ compaction_manager::compaction_manager(seastar::scheduling_group sg, const ::io_
             return compaction_controller::normalization_factor;
         }
         return b;
-    })
+    }, std::move(latency_pressure))
     , _backlog_manager(_compaction_controller)
     , _scheduling_group(_compaction_controller.sg())
     , _available_memory(available_memory)
@@ -399,6 +425,8 @@ void compaction_manager::register_metrics() {
                        sm::description("Holds the number of currently active compactions.")),
         sm::make_gauge("pending_compactions", [this] { return _stats.pending_tasks; },
                        sm::description("Holds the number of compaction tasks waiting for an opportunity to run.")),
+        sm::make_gauge("latency_scale", [this] { return _compaction_controller.latency_scale(); },
+                       sm::description("Holds the factor by which the compaction shares derived from the backlog are scaled to keep foreground latencies under their targets.")),
     });
 }
 
@@ -411,8 +439,13 @@ void compaction_manager::start() {
 
 std::function<void()> compaction_manager::compaction_submission_callback() {
     return [this] () mutable {
-        for (auto& e: _compaction_locks) {
-            submit(e.first);
+        auto cfs = boost::copy_range<std::vector<column_family*>>(_compaction_locks | boost::adaptors::map_keys);
+        // Tables whose reads suffer the most from overlapping sstables get to pick their jobs first.
+        boost::stable_sort(cfs, [] (column_family* a, column_family* b) {
+            return read_amplification_cost(*a) > read_amplification_cost(*b);
+        });
+        for (auto cf : cfs) {
+            submit(cf);
         }
     };
 }
@@ -425,9 +458,12 @@ void compaction_manager::postponed_compactions_reevaluation() {
                 return stop_iteration::yes;
             }
             auto postponed = std::move(_postponed);
+            boost::stable_sort(postponed, [] (const postponed_compaction& a, const postponed_compaction& b) {
+                return a.value > b.value;
+            });
             try {
-                for (auto& cf : postponed) {
-                    submit(cf);
+                for (auto& p : postponed) {
+                    submit(p.cf);
                 }
             } catch (...) {
                 _postponed = std::move(postponed);
@@ -441,8 +477,8 @@ void compaction_manager::reevaluate_postponed_compactions() {
     _postponed_reevaluation.signal();
 }
 
-void compaction_manager::postpone_compaction_for_column_family(column_family* cf) {
-    _postponed.push_back(cf);
+void compaction_manager::postpone_compaction_for_column_family(column_family* cf, double value) {
+    _postponed.push_back({cf, value});
 }
 
 future<> compaction_manager::stop() {
@@ -538,9 +574,10 @@ void compaction_manager::submit(column_family* cf) {
             }
             if (!can_register_weight(&cf, weight)) {
                 _stats.pending_tasks--;
-                cmlog.debug("Refused compaction job ({} sstable(s)) of weight {} for {}.{}, postponing it...",
-                    descriptor.sstables.size(), weight, cf.schema()->ks_name(), cf.schema()->cf_name());
-                postpone_compaction_for_column_family(&cf);
+                auto value = compaction_value(cf, descriptor.sstables);
+                cmlog.debug("Refused compaction job ({} sstable(s)) of weight {} and value {} for {}.{}, postponing it...",
+                    descriptor.sstables.size(), weight, value, cf.schema()->ks_name(), cf.schema()->cf_name());
+                postpone_compaction_for_column_family(&cf, value);
                 return make_ready_future<stop_iteration>(stop_iteration::yes);
             }
             auto compacting = make_lw_shared<compacting_sstable_registration>(this, descriptor.sstables);
@@ -722,6 +759,20 @@ future<> compaction_manager::perform_sstable_scrub(column_family* cf, bool skip_
     });
 }
 
+future<> compaction_manager::perform_anticompaction(column_family* cf, dht::token_range_vector repaired_ranges, uint64_t repaired_at,
+        std::unordered_set<int64_t> generations) {
+    auto options = sstables::compaction_options::make_anticompaction(std::move(repaired_ranges), repaired_at);
+    return rewrite_sstables(cf, std::move(options), [generations = std::move(generations)] (const table& table) {
+        auto sstables = std::vector<sstables::shared_sstable>{};
+        const auto candidates = table.candidates_for_compaction();
+        // Skip sstables which a compaction replaced or marked as repaired in the meantime.
+        std::copy_if(candidates.begin(), candidates.end(), std::back_inserter(sstables), [&generations] (const sstables::shared_sstable& sst) {
+            return generations.count(sst->generation()) && !sst->is_repaired();
+        });
+        return sstables;
+    });
+}
+
 future<> compaction_manager::remove(column_family* cf) {
     // FIXME: better way to iterate through compaction info for a given column family,
     // although this path isn't performance sensitive.
@@ -740,7 +791,7 @@ future<> compaction_manager::remove(column_family* cf) {
             task->stopping = true;
         }
     }
-    _postponed.erase(boost::remove(_postponed, cf), _postponed.end());
+    _postponed.erase(boost::remove_if(_postponed, [cf] (const postponed_compaction& p) { return p.cf == cf; }), _postponed.end());
 
     // Wait for the termination of an ongoing compaction on cf, if any.
     return do_for_each(*tasks_to_stop, [this, cf] (auto& task) {
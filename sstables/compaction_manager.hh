@@ -81,8 +81,13 @@ class compaction_manager {
 
     future<> _waiting_reevalution = make_ready_future<>();
     condition_variable _postponed_reevaluation;
+    struct postponed_compaction {
+        column_family* cf;
+        // The value of the refused job, see compaction_value().
+        double value;
+    };
     // column families that wait for compaction but had its submission postponed due to ongoing compaction.
-    std::vector<column_family*> _postponed;
+    std::vector<postponed_compaction> _postponed;
     // tracks taken weights of ongoing compactions, only one compaction per weight is allowed.
     // weight is value assigned to a compaction job that is log base N of total size of all input sstables.
     std::unordered_set<int> _weight_tracker;
@@ -138,8 +143,8 @@ class compaction_manager {
     void postponed_compactions_reevaluation();
     void reevaluate_postponed_compactions();
     // Postpone compaction for a column family that couldn't be executed due to ongoing
-    // similar-sized compaction.
-    void postpone_compaction_for_column_family(column_family* cf);
+    // similar-sized compaction. Postponed compactions are resubmitted by decreasing value.
+    void postpone_compaction_for_column_family(column_family* cf, double value);
 
     compaction_controller _compaction_controller;
     compaction_backlog_manager _backlog_manager;
@@ -150,7 +155,9 @@ class compaction_manager {
 
     future<> rewrite_sstables(column_family* cf, sstables::compaction_options options, get_candidates_func);
 public:
-    compaction_manager(seastar::scheduling_group sg, const ::io_priority_class& iop, size_t available_memory);
+    // latency_pressure is the second feedback input of the compaction controller, see compaction_controller.
+    compaction_manager(seastar::scheduling_group sg, const ::io_priority_class& iop, size_t available_memory,
+            std::function<std::optional<float>()> latency_pressure = {});
     compaction_manager(seastar::scheduling_group sg, const ::io_priority_class& iop, size_t available_memory, uint64_t shares);
     compaction_manager();
     ~compaction_manager();
@@ -183,6 +190,12 @@ class compaction_manager {
     // Submit a column family to be scrubbed and wait for its termination.
     future<> perform_sstable_scrub(column_family* cf, bool skip_corrupted);
 
+    // Split the unrepaired sstables with the given generations into data in
+    // repaired_ranges, marked as repaired at repaired_at, and the rest. Wait
+    // for its termination.
+    future<> perform_anticompaction(column_family* cf, dht::token_range_vector repaired_ranges, uint64_t repaired_at,
+            std::unordered_set<int64_t> generations);
+
     // Submit a column family for major compaction.
     future<> submit_major_compaction(column_family* cf);
 
@@ -52,10 +52,12 @@
 #include <boost/range/adaptors.hpp>
 #include <boost/icl/interval_map.hpp>
 #include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/algorithm/cxx11/all_of.hpp>
 #include "size_tiered_compaction_strategy.hh"
 #include "date_tiered_compaction_strategy.hh"
 #include "leveled_compaction_strategy.hh"
 #include "time_window_compaction_strategy.hh"
+#include "incremental_compaction_strategy.hh"
 #include "sstables/compaction_backlog_manager.hh"
 #include "sstables/size_tiered_backlog_tracker.hh"
 #include "mutation_source_metadata.hh"
@@ -462,6 +464,76 @@ bool compaction_strategy_impl::worth_dropping_tombstones(const shared_sstable& s
     return sst->estimate_droppable_tombstone_ratio(gc_before) >= _tombstone_threshold;
 }
 
+double compaction_strategy_impl::droppable_tombstone_ratio(column_family& cf, const shared_sstable& sst, gc_clock::time_point gc_before) {
+    auto ratio = sst->estimate_droppable_tombstone_ratio(gc_before);
+    auto keys = sst->get_estimated_key_count();
+    if (_unchecked_tombstone_compaction || ratio == 0 || !keys) {
+        return ratio;
+    }
+    auto& first = sst->get_first_decorated_key().token();
+    auto& last = sst->get_last_decorated_key().token();
+    auto range = dht::token_range::make(first, last);
+    auto max_timestamp = sst->get_stats_metadata().max_timestamp;
+    uint64_t shadowed_keys = 0;
+    for (auto& other : *cf.get_sstables()) {
+        // Tombstones can only shadow data older than themselves.
+        if (other == sst || other->get_stats_metadata().min_timestamp > max_timestamp) {
+            continue;
+        }
+        if (other->get_last_decorated_key().token() < first || last < other->get_first_decorated_key().token()) {
+            continue;
+        }
+        shadowed_keys += other->estimated_keys_for_range(range);
+    }
+    return ratio * (1 - std::min(1.0, double(shadowed_keys) / keys));
+}
+
+compaction_descriptor compaction_strategy_impl::get_tombstone_compaction_job(column_family& cf, std::vector<sstables::shared_sstable> candidates) {
+    auto now = gc_clock::now();
+    shared_sstable picked;
+    double picked_ratio = 0;
+    for (auto& sst : candidates) {
+        auto gc_before = cf.get_gc_before(dht::token_range::make(sst->get_first_decorated_key().token(), sst->get_last_decorated_key().token()), now);
+        if (!worth_dropping_tombstones(sst, gc_before)) {
+            continue;
+        }
+        auto ratio = droppable_tombstone_ratio(cf, sst, gc_before);
+        if (ratio < _tombstone_threshold) {
+            continue;
+        }
+        // On ties, prefer older sstables, whose tombstones are less likely to shadow data elsewhere.
+        if (!picked || ratio > picked_ratio
+                || (ratio == picked_ratio && sst->get_stats_metadata().min_timestamp < picked->get_stats_metadata().min_timestamp)) {
+            picked = sst;
+            picked_ratio = ratio;
+        }
+    }
+    if (!picked) {
+        return compaction_descriptor();
+    }
+    clogger.debug("Compacting {} alone, with an estimated droppable tombstone ratio of {}", picked->get_filename(), picked_ratio);
+    // Keep the level, as the output can't overlap with sstables other than the ones the input overlaps with.
+    auto level = picked->get_sstable_level();
+    return compaction_descriptor({ std::move(picked) }, level);
+}
+
+gc_clock::time_point compaction_strategy_impl::expired_sstables_gc_before(const schema& s) const {
+    auto now = gc_clock::now();
+    return _uniform_ttl ? now : now - s.gc_grace_seconds();
+}
+
+compaction_descriptor compaction_strategy_impl::get_expired_sstables_job(column_family& cf, const std::vector<shared_sstable>& candidates) {
+    if (!_uniform_ttl) {
+        return compaction_descriptor();
+    }
+    auto expired = get_fully_expired_sstables(cf, candidates, expired_sstables_gc_before(*cf.schema()));
+    if (expired.empty()) {
+        return compaction_descriptor();
+    }
+    clogger.debug("Dropping {} fully expired sstables of {}.{}", expired.size(), cf.schema()->ks_name(), cf.schema()->cf_name());
+    return compaction_descriptor(std::vector<shared_sstable>(expired.begin(), expired.end()));
+}
+
 std::vector<resharding_descriptor>
 compaction_strategy_impl::get_resharding_jobs(column_family& cf, std::vector<sstables::shared_sstable> candidates) {
     std::vector<resharding_descriptor> jobs;
@@ -715,6 +787,59 @@ struct null_backlog_tracker final : public compaction_backlog_tracker::impl {
     virtual void remove_sstable(sstables::shared_sstable sst)  override { }
 };
 
+// Adds the data which tombstone compactions are expected to purge to the backlog of a strategy.
+// Sstables being compacted and sstables too young for a tombstone compaction don't contribute.
+//
+// Droppable ratios depend on the current time, so they are estimated every time the backlog is
+// computed. That isn't discounted by overlapping sstables, which would be too expensive here.
+class tombstone_compaction_backlog_tracker final : public compaction_backlog_tracker::impl {
+    std::unique_ptr<compaction_backlog_tracker::impl> _strategy_backlog;
+    float _tombstone_threshold;
+    db_clock::duration _tombstone_compaction_interval;
+    std::unordered_set<shared_sstable> _sstables;
+public:
+    tombstone_compaction_backlog_tracker(std::unique_ptr<compaction_backlog_tracker::impl> strategy_backlog, float tombstone_threshold,
+            db_clock::duration tombstone_compaction_interval)
+        : _strategy_backlog(std::move(strategy_backlog))
+        , _tombstone_threshold(tombstone_threshold)
+        , _tombstone_compaction_interval(tombstone_compaction_interval)
+    {}
+
+    virtual double backlog(const compaction_backlog_tracker::ongoing_writes& ow, const compaction_backlog_tracker::ongoing_compactions& oc) const override {
+        auto b = _strategy_backlog->backlog(ow, oc);
+        auto now = gc_clock::now();
+        auto written_before = db_clock::now() - _tombstone_compaction_interval;
+        for (auto& sst : _sstables) {
+            if (oc.count(sst) || sst->data_file_write_time() > written_before) {
+                continue;
+            }
+            auto ratio = sst->estimate_droppable_tombstone_ratio(now - sst->get_schema()->gc_grace_seconds());
+            if (ratio >= _tombstone_threshold) {
+                b += sst->data_size() * ratio;
+            }
+        }
+        return b;
+    }
+
+    virtual void add_sstable(sstables::shared_sstable sst) override {
+        _sstables.insert(sst);
+        _strategy_backlog->add_sstable(std::move(sst));
+    }
+
+    virtual void remove_sstable(sstables::shared_sstable sst) override {
+        _sstables.erase(sst);
+        _strategy_backlog->remove_sstable(std::move(sst));
+    }
+};
+
+std::unique_ptr<compaction_backlog_tracker::impl>
+compaction_strategy_impl::with_tombstone_compaction_backlog(std::unique_ptr<compaction_backlog_tracker::impl> strategy_backlog, bool enabled) const {
+    if (!enabled || _disable_tombstone_compaction) {
+        return strategy_backlog;
+    }
+    return std::make_unique<tombstone_compaction_backlog_tracker>(std::move(strategy_backlog), _tombstone_threshold, _tombstone_compaction_interval);
+}
+
 // Just so that if we have more than one CF with NullStrategy, we don't create a lot
 // of objects to iterate over for no reason
 // Still thread local because of make_unique. But this will disappear soon
@@ -750,7 +875,7 @@ leveled_compaction_strategy::leveled_compaction_strategy(const std::map<sstring,
         : compaction_strategy_impl(options)
         , _max_sstable_size_in_mb(calculate_max_sstable_size_in_mb(compaction_strategy_impl::get_value(options, SSTABLE_SIZE_OPTION)))
         , _stcs_options(options)
-        , _backlog_tracker(std::make_unique<leveled_compaction_backlog_tracker>(_max_sstable_size_in_mb))
+        , _backlog_tracker(with_tombstone_compaction_backlog(std::make_unique<leveled_compaction_backlog_tracker>(_max_sstable_size_in_mb)))
 {
     _compaction_counter.resize(leveled_manifest::MAX_LEVELS);
 }
@@ -774,7 +899,8 @@ time_window_compaction_strategy::time_window_compaction_strategy(const std::map<
     : compaction_strategy_impl(options)
     , _options(options)
     , _stcs_options(options)
-    , _backlog_tracker(std::make_unique<time_window_backlog_tracker>(_options))
+    , _backlog_tracker(with_tombstone_compaction_backlog(std::make_unique<time_window_backlog_tracker>(_options),
+            options.count(TOMBSTONE_COMPACTION_INTERVAL_OPTION) || options.count(TOMBSTONE_THRESHOLD_OPTION)))
 {
     if (!options.count(TOMBSTONE_COMPACTION_INTERVAL_OPTION) && !options.count(TOMBSTONE_THRESHOLD_OPTION)) {
         _disable_tombstone_compaction = true;
@@ -827,6 +953,14 @@ class classify_by_timestamp {
 
 } // anonymous namespace
 
+// Windows older than the newest one are done receiving writes, their
+// compaction output is only read by queries for old data.
+bool time_window_compaction_strategy::is_cold_output(const compaction_descriptor& descriptor) const {
+    return !descriptor.sstables.empty() && boost::algorithm::all_of(descriptor.sstables, [this] (const shared_sstable& sst) {
+        return get_window_for(_options, sst->get_stats_metadata().max_timestamp) < _highest_window_seen;
+    });
+}
+
 reader_consumer time_window_compaction_strategy::make_interposer_consumer(const mutation_source_metadata& ms_meta, reader_consumer end_consumer) {
     if (ms_meta.min_timestamp && ms_meta.max_timestamp
             && get_window_for(_options, *ms_meta.min_timestamp) == get_window_for(_options, *ms_meta.max_timestamp)) {
@@ -988,32 +1122,18 @@ compaction_descriptor date_tiered_compaction_strategy::get_sstables_for_compacti
         date_tiered_manifest::logger.debug("datetiered: Compacting {} out of {} sstables", sstables.size(), candidates.size());
         return sstables::compaction_descriptor(std::move(sstables));
     }
-
-    // filter out sstables which droppable tombstone ratio isn't greater than the defined threshold.
-    auto e = boost::range::remove_if(candidates, [this, &gc_before] (const sstables::shared_sstable& sst) -> bool {
-        return !worth_dropping_tombstones(sst, gc_before);
-    });
-    candidates.erase(e, candidates.end());
-    if (candidates.empty()) {
-        return sstables::compaction_descriptor();
-    }
-    // find oldest sstable which is worth dropping tombstones because they are more unlikely to
-    // shadow data from other sstables, and it also tends to be relatively big.
-    auto it = std::min_element(candidates.begin(), candidates.end(), [] (auto& i, auto& j) {
-        return i->get_stats_metadata().min_timestamp < j->get_stats_metadata().min_timestamp;
-    });
-    return sstables::compaction_descriptor({ *it });
+    return sstables::compaction_descriptor();
 }
 
 size_tiered_compaction_strategy::size_tiered_compaction_strategy(const std::map<sstring, sstring>& options)
     : compaction_strategy_impl(options)
     , _options(options)
-    , _backlog_tracker(std::make_unique<size_tiered_backlog_tracker>())
+    , _backlog_tracker(with_tombstone_compaction_backlog(std::make_unique<size_tiered_backlog_tracker>()))
 {}
 
 size_tiered_compaction_strategy::size_tiered_compaction_strategy(const size_tiered_compaction_strategy_options& options)
     : _options(options)
-    , _backlog_tracker(std::make_unique<size_tiered_backlog_tracker>())
+    , _backlog_tracker(with_tombstone_compaction_backlog(std::make_unique<size_tiered_backlog_tracker>()))
 {}
 
 compaction_strategy::compaction_strategy(::shared_ptr<compaction_strategy_impl> impl)
@@ -1029,7 +1149,25 @@ compaction_strategy_type compaction_strategy::type() const {
 }
 
 compaction_descriptor compaction_strategy::get_sstables_for_compaction(column_family& cfs, std::vector<sstables::shared_sstable> candidates) {
-    return _compaction_strategy_impl->get_sstables_for_compaction(cfs, std::move(candidates));
+    auto repaired = std::partition(candidates.begin(), candidates.end(), [] (const shared_sstable& sst) { return !sst->is_repaired(); });
+    if (repaired != candidates.begin() && repaired != candidates.end()) {
+        std::vector<shared_sstable> repaired_candidates(repaired, candidates.end());
+        candidates.erase(repaired, candidates.end());
+        auto descriptor = get_sstables_for_compaction(cfs, std::move(candidates));
+        if (!descriptor.sstables.empty()) {
+            return descriptor;
+        }
+        return get_sstables_for_compaction(cfs, std::move(repaired_candidates));
+    }
+    auto expired = _compaction_strategy_impl->get_expired_sstables_job(cfs, candidates);
+    if (!expired.sstables.empty()) {
+        return expired;
+    }
+    auto descriptor = _compaction_strategy_impl->get_sstables_for_compaction(cfs, candidates);
+    if (descriptor.sstables.empty()) {
+        return _compaction_strategy_impl->get_tombstone_compaction_job(cfs, std::move(candidates));
+    }
+    return descriptor;
 }
 
 compaction_descriptor compaction_strategy::get_major_compaction_job(column_family& cf, std::vector<sstables::shared_sstable> candidates) {
@@ -1056,6 +1194,14 @@ bool compaction_strategy::use_clustering_key_filter() const {
     return _compaction_strategy_impl->use_clustering_key_filter();
 }
 
+gc_clock::time_point compaction_strategy::expired_sstables_gc_before(const schema& s) const {
+    return _compaction_strategy_impl->expired_sstables_gc_before(s);
+}
+
+bool compaction_strategy::repair_based_tombstone_gc() const {
+    return _compaction_strategy_impl->repair_based_tombstone_gc();
+}
+
 sstable_set
 compaction_strategy::make_sstable_set(schema_ptr schema) const {
     return sstable_set(
@@ -1076,6 +1222,10 @@ reader_consumer compaction_strategy::make_interposer_consumer(const mutation_sou
     return _compaction_strategy_impl->make_interposer_consumer(ms_meta, std::move(end_consumer));
 }
 
+bool compaction_strategy::is_cold_output(const compaction_descriptor& descriptor) const {
+    return _compaction_strategy_impl->is_cold_output(descriptor);
+}
+
 compaction_strategy make_compaction_strategy(compaction_strategy_type strategy, const std::map<sstring, sstring>& options) {
     ::shared_ptr<compaction_strategy_impl> impl;
 
@@ -1095,6 +1245,9 @@ compaction_strategy make_compaction_strategy(compaction_strategy_type strategy,
     case compaction_strategy_type::time_window:
         impl = make_shared<time_window_compaction_strategy>(time_window_compaction_strategy(options));
         break;
+    case compaction_strategy_type::incremental:
+        impl = make_shared<incremental_compaction_strategy>(incremental_compaction_strategy(options));
+        break;
     default:
         throw std::runtime_error("strategy not supported");
     }
@@ -42,11 +42,25 @@ class compaction_strategy_impl {
 protected:
     const sstring TOMBSTONE_THRESHOLD_OPTION = "tombstone_threshold";
     const sstring TOMBSTONE_COMPACTION_INTERVAL_OPTION = "tombstone_compaction_interval";
+    const sstring UNCHECKED_TOMBSTONE_COMPACTION_OPTION = "unchecked_tombstone_compaction";
+    const sstring UNIFORM_TTL_OPTION = "uniform_ttl";
+    const sstring TOMBSTONE_GC_OPTION = "tombstone_gc";
 
     bool _use_clustering_key_filter = false;
     bool _disable_tombstone_compaction = false;
     float _tombstone_threshold = DEFAULT_TOMBSTONE_THRESHOLD;
     db_clock::duration _tombstone_compaction_interval = DEFAULT_TOMBSTONE_COMPACTION_INTERVAL();
+    // If set, the droppable tombstone ratio of a sstable isn't discounted by the
+    // data of overlapping sstables, which may be shadowed by its tombstones.
+    bool _unchecked_tombstone_compaction = false;
+    // Set by users whose writes to the table all carry the same TTL, and
+    // which don't delete data. Data expires in write order then, so an
+    // sstable can be dropped as soon as all of it expired, gc_grace_seconds
+    // notwithstanding, if it doesn't shadow older data.
+    bool _uniform_ttl = false;
+    // Set with tombstone_gc = repair. Tombstones are purged once the last repair of their
+    // token range started after they were written, rather than after gc_grace_seconds.
+    bool _repair_based_tombstone_gc = false;
 public:
     static std::optional<sstring> get_value(const std::map<sstring, sstring>& options, const sstring& name) {
         auto it = options.find(name);
@@ -67,6 +81,18 @@ class compaction_strategy_impl {
         auto interval = property_definitions::to_long(TOMBSTONE_COMPACTION_INTERVAL_OPTION, tmp_value, DEFAULT_TOMBSTONE_COMPACTION_INTERVAL().count());
         _tombstone_compaction_interval = db_clock::duration(std::chrono::seconds(interval));
 
+        tmp_value = get_value(options, UNCHECKED_TOMBSTONE_COMPACTION_OPTION);
+        _unchecked_tombstone_compaction = property_definitions::to_boolean(UNCHECKED_TOMBSTONE_COMPACTION_OPTION, tmp_value, false);
+
+        tmp_value = get_value(options, UNIFORM_TTL_OPTION);
+        _uniform_ttl = property_definitions::to_boolean(UNIFORM_TTL_OPTION, tmp_value, false);
+
+        tmp_value = get_value(options, TOMBSTONE_GC_OPTION);
+        if (tmp_value && *tmp_value != "timeout" && *tmp_value != "repair") {
+            throw exceptions::configuration_exception(format("{} must be either timeout or repair, got {}", TOMBSTONE_GC_OPTION, *tmp_value));
+        }
+        _repair_based_tombstone_gc = tmp_value && *tmp_value == "repair";
+
         // FIXME: validate options.
     }
 public:
@@ -94,10 +120,47 @@ class compaction_strategy_impl {
     // droppable tombstone histogram and gc_before.
     bool worth_dropping_tombstones(const shared_sstable& sst, gc_clock::time_point gc_before);
 
+    // Estimates the ratio of data of a sstable that a compaction of that sstable alone would purge.
+    // Unless unchecked_tombstone_compaction is set, the droppable tombstone ratio is discounted by
+    // the fraction of keys shared with older overlapping sstables, as tombstones covering data in
+    // sstables that aren't compacted can't be purged.
+    double droppable_tombstone_ratio(column_family& cf, const shared_sstable& sst, gc_clock::time_point gc_before);
+
+    // Picks a single sstable worth a tombstone compaction, used when the strategy has nothing
+    // to compact. The sstable with the highest droppable tombstone ratio is rewritten alone,
+    // at its current level.
+    virtual compaction_descriptor get_tombstone_compaction_job(column_family& cf, std::vector<shared_sstable> candidates);
+
+    bool uniform_ttl() const {
+        return _uniform_ttl;
+    }
+
+    bool repair_based_tombstone_gc() const {
+        return _repair_based_tombstone_gc;
+    }
+
+    // The deletion time before which sstables are considered fully expired.
+    gc_clock::time_point expired_sstables_gc_before(const schema& s) const;
+
+    // With uniform_ttl, picks all candidates which are fully expired, for any strategy. Since compaction
+    // doesn't read fully expired sstables, they are deleted without being rewritten.
+    compaction_descriptor get_expired_sstables_job(column_family& cf, const std::vector<shared_sstable>& candidates);
+
     virtual compaction_backlog_tracker& get_backlog_tracker() = 0;
+protected:
+    // Adds the data that tombstone compactions are expected to purge to the backlog of a strategy,
+    // unless tombstone compactions are disabled. Strategies which disable them in their constructor's
+    // body tell so with enabled.
+    std::unique_ptr<compaction_backlog_tracker::impl> with_tombstone_compaction_backlog(std::unique_ptr<compaction_backlog_tracker::impl> strategy_backlog,
+            bool enabled = true) const;
+public:
 
     virtual uint64_t adjust_partition_estimate(const mutation_source_metadata& ms_meta, uint64_t partition_estimate);
 
     virtual reader_consumer make_interposer_consumer(const mutation_source_metadata& ms_meta, reader_consumer end_consumer);
+
+    virtual bool is_cold_output(const compaction_descriptor& descriptor) const {
+        return false;
+    }
 };
 }
@@ -39,6 +39,8 @@ enum class component_type {
     TemporaryTOC,
     TemporaryStatistics,
     Scylla,
+    ClusteringRanges,
+    TrieIndex,
     Unknown,
 };
 
@@ -27,6 +27,8 @@
 #include <seastar/core/bitops.hh>
 #include <seastar/core/byteorder.hh>
 #include <seastar/core/fstream.hh>
+#include <seastar/core/future-util.hh>
+#include <seastar/core/semaphore.hh>
 
 #include "../compress.hh"
 #include "compress.hh"
@@ -315,6 +317,12 @@ void compression::set_compressor(compressor_ptr c) {
     }
 }
 
+void compression::add_options(const std::map<sstring, sstring>& opts) {
+    for (auto& [k, v] : opts) {
+        options.elements.push_back({bytes(k.begin(), k.end()), bytes(v.begin(), v.end())});
+    }
+}
+
 void compression::update(uint64_t compressed_file_length) {
     _compressed_file_length = compressed_file_length;
 }
@@ -343,7 +351,15 @@ compression::locate(uint64_t position, const compression::segmented_offsets::acc
 
 }
 
-template <typename ChecksumType>
+// For SSTables 2.x (formats 'ka' and 'la'), the full checksum is a combination of checksums of compressed chunks.
+// For SSTables 3.x (format 'mc'), however, it is supposed to contain the full checksum of the file written so
+// the per-chunk checksums also count.
+enum class compressed_checksum_mode {
+    checksum_chunks_only,
+    checksum_all,
+};
+
+template <typename ChecksumType, compressed_checksum_mode mode>
 GCC6_CONCEPT(
     requires ChecksumUtils<ChecksumType>
 )
@@ -356,12 +372,31 @@ class compressed_file_data_source_impl : public data_source_impl {
     uint64_t _pos;
     uint64_t _beg_pos;
     uint64_t _end_pos;
+    uint64_t _chunks_per_read;
+    sstables::full_checksum_handler _on_full_checksum;
+    // Whether the chunks read so far are the beginning of the file, in order.
+    bool _computing_full_checksum;
+    uint32_t _full_checksum;
+private:
+    void update_full_checksum(const char* chunk, size_t compressed_len, uint32_t chunk_checksum) {
+        // Mirrors compressed_file_data_sink_impl::compress_chunk().
+        _full_checksum = checksum_combine_or_feed<ChecksumType>(_full_checksum, chunk_checksum, chunk, compressed_len);
+        if constexpr (mode == compressed_checksum_mode::checksum_all) {
+            _full_checksum = ChecksumType::checksum(_full_checksum, chunk + compressed_len, 4);
+        }
+    }
 public:
     compressed_file_data_source_impl(file f, sstables::compression* cm,
-                uint64_t pos, size_t len, file_input_stream_options options)
+                uint64_t pos, size_t len, file_input_stream_options options, compressor_ptr p,
+                sstables::full_checksum_handler on_full_checksum)
             : _compression_metadata(cm)
             , _offsets(_compression_metadata->offsets.get_accessor())
-            , _compression(*cm)
+            , _compression(p ? sstables::local_compression(std::move(p)) : sstables::local_compression(*cm))
+            , _chunks_per_read(std::max<uint64_t>(1, options.buffer_size / cm->uncompressed_chunk_length()))
+            , _on_full_checksum(std::move(on_full_checksum))
+            , _computing_full_checksum(bool(_on_full_checksum) && pos == 0 && len >= cm->uncompressed_file_length()
+                    && cm->uncompressed_file_length() > 0)
+            , _full_checksum(ChecksumType::init_checksum())
     {
         _beg_pos = pos;
         if (pos > _compression_metadata->uncompressed_file_length()) {
@@ -399,33 +434,66 @@ class compressed_file_data_source_impl : public data_source_impl {
         if (_pos != _beg_pos && addr.offset != 0) {
             throw std::runtime_error("compressed reader out of sync");
         }
-        return _input_stream->read_exactly(addr.chunk_len).
-            then([this, addr](temporary_buffer<char> buf) {
-                // The last 4 bytes of the chunk are the adler32/crc32 checksum
-                // of the rest of the (compressed) chunk.
-                auto compressed_len = addr.chunk_len - 4;
-                // FIXME: Do not always calculate checksum - Cassandra has a
-                // probability (defaulting to 1.0, but still...)
-                auto checksum = read_be<uint32_t>(buf.get() + compressed_len);
-                if (checksum != ChecksumType::checksum(buf.get(), compressed_len)) {
-                    throw std::runtime_error("compressed chunk failed checksum");
+        // Uncompress as many chunks as fit in the stream's buffer at once,
+        // rather than one per call. With small chunks this saves a read and
+        // a continuation per chunk during scans, while the underlying stream's
+        // read-ahead keeps the following reads in flight.
+        auto ucl = _compression_metadata->uncompressed_chunk_length();
+        auto first_chunk = _pos / ucl;
+        auto last_chunk = std::min(first_chunk + _chunks_per_read - 1, (_end_pos - 1) / ucl);
+        auto last = _compression_metadata->locate(last_chunk * ucl, _offsets);
+        auto read_len = last.chunk_start + last.chunk_len - addr.chunk_start;
+        return _input_stream->read_exactly(read_len).
+            then([this, addr, first_chunk, last_chunk, ucl, read_len](temporary_buffer<char> buf) {
+                if (buf.size() != read_len) {
+                    throw std::runtime_error("compressed reader hit premature end-of-file");
+                }
+                // We know that each chunk uncompresses to exactly chunk_length
+                // bytes, except the last chunk of the file which may be shorter.
+                temporary_buffer<char> out((last_chunk - first_chunk + 1) * ucl);
+                size_t in_pos = 0;
+                size_t out_pos = 0;
+                for (auto chunk = first_chunk; chunk <= last_chunk; ++chunk) {
+                    auto chunk_len = chunk == first_chunk ? addr.chunk_len
+                            : _compression_metadata->locate(chunk * ucl, _offsets).chunk_len;
+                    auto in = buf.get() + in_pos;
+                    // The last 4 bytes of the chunk are the adler32/crc32 checksum
+                    // of the rest of the (compressed) chunk.
+                    auto compressed_len = chunk_len - 4;
+                    // FIXME: Do not always calculate checksum - Cassandra has a
+                    // probability (defaulting to 1.0, but still...)
+                    auto checksum = read_be<uint32_t>(in + compressed_len);
+                    if (checksum != ChecksumType::checksum(in, compressed_len)) {
+                        throw std::runtime_error("compressed chunk failed checksum");
+                    }
+                    if (_computing_full_checksum) {
+                        update_full_checksum(in, compressed_len, checksum);
+                    }
+
+                    // The compressed data is the whole chunk, minus the last 4
+                    // bytes (which contain the checksum verified above).
+                    auto len = _compression.uncompress(in, compressed_len, out.get_write() + out_pos, ucl);
+                    if (chunk != last_chunk && len != ucl) {
+                        throw std::runtime_error("compressed reader out of sync");
+                    }
+                    in_pos += chunk_len;
+                    out_pos += len;
                 }
 
-                // We know that the uncompressed data will take exactly
-                // chunk_length bytes (or less, if reading the last chunk).
-                temporary_buffer<char> out(
-                        _compression_metadata->uncompressed_chunk_length());
-                // The compressed data is the whole chunk, minus the last 4
-                // bytes (which contain the checksum verified above).
-
-                auto len = _compression.uncompress(buf.get(), compressed_len, out.get_write(), out.size());
-
-                out.trim(len);
+                out.trim(out_pos);
                 out.trim_front(addr.offset);
                 _pos += out.size();
-                _underlying_pos += addr.chunk_len;
-
-                return out;
+                _underlying_pos += read_len;
+
+                // Consumers don't necessarily ask for more after the last
+                // byte, so don't wait for get() to report end-of-file.
+                if (_computing_full_checksum && _pos >= _end_pos) {
+                    _computing_full_checksum = false;
+                    return _on_full_checksum(_full_checksum).then([out = std::move(out)] () mutable {
+                        return std::move(out);
+                    });
+                }
+                return make_ready_future<temporary_buffer<char>>(std::move(out));
         });
     }
 
@@ -437,6 +505,7 @@ class compressed_file_data_source_impl : public data_source_impl {
     }
 
     virtual future<temporary_buffer<char>> skip(uint64_t n) override {
+        _computing_full_checksum &= n == 0;
         _pos += n;
         assert(_pos <= _end_pos);
         if (_pos == _end_pos) {
@@ -452,42 +521,43 @@ class compressed_file_data_source_impl : public data_source_impl {
     }
 };
 
-template <typename ChecksumType>
+template <typename ChecksumType, compressed_checksum_mode mode>
 GCC6_CONCEPT(
     requires ChecksumUtils<ChecksumType>
 )
 class compressed_file_data_source : public data_source {
 public:
     compressed_file_data_source(file f, sstables::compression* cm,
-            uint64_t offset, size_t len, file_input_stream_options options)
-        : data_source(std::make_unique<compressed_file_data_source_impl<ChecksumType>>(
-                std::move(f), cm, offset, len, std::move(options)))
+            uint64_t offset, size_t len, file_input_stream_options options, compressor_ptr p,
+            sstables::full_checksum_handler on_full_checksum)
+        : data_source(std::make_unique<compressed_file_data_source_impl<ChecksumType, mode>>(
+                std::move(f), cm, offset, len, std::move(options), std::move(p), std::move(on_full_checksum)))
         {}
 };
 
-template <typename ChecksumType>
+template <typename ChecksumType, compressed_checksum_mode mode>
 GCC6_CONCEPT(
     requires ChecksumUtils<ChecksumType>
 )
 inline input_stream<char> make_compressed_file_input_stream(
         file f, sstables::compression *cm, uint64_t offset, size_t len,
-        file_input_stream_options options)
+        file_input_stream_options options, compressor_ptr p, sstables::full_checksum_handler on_full_checksum)
 {
-    return input_stream<char>(compressed_file_data_source<ChecksumType>(
-            std::move(f), cm, offset, len, std::move(options)));
+    return input_stream<char>(compressed_file_data_source<ChecksumType, mode>(
+            std::move(f), cm, offset, len, std::move(options), std::move(p), std::move(on_full_checksum)));
 }
 
-// For SSTables 2.x (formats 'ka' and 'la'), the full checksum is a combination of checksums of compressed chunks.
-// For SSTables 3.x (format 'mc'), however, it is supposed to contain the full checksum of the file written so
-// the per-chunk checksums also count.
-enum class compressed_checksum_mode {
-    checksum_chunks_only,
-    checksum_all,
-};
+// Amount of uncompressed data compressed at once by compressed_file_data_sink_impl.
+static constexpr size_t compression_batch_size = 256 * 1024;
 
 // compressed_file_data_sink_impl works as a filter for a file output stream,
 // where the buffer flushed will be compressed and its checksum computed, then
 // the result passed to a regular output stream.
+//
+// Chunks are compressed in batches of compression_batch_size. The write of a
+// batch is left in flight while put() accepts and compresses the next one, so
+// compression doesn't wait for the disk; at most one compressed batch is
+// pending at any time.
 template <typename ChecksumType, compressed_checksum_mode mode>
 GCC6_CONCEPT(
     requires ChecksumUtils<ChecksumType>
@@ -499,26 +569,134 @@ class compressed_file_data_sink_impl : public data_sink_impl {
     sstables::local_compression _compression;
     size_t _pos = 0;
     uint32_t _full_checksum;
+    // Chunks held back until the compressor has seen enough data to train
+    // a dictionary, see compressor::dictionary_sample_size(), or, in the
+    // adaptive mode, to choose the compressor.
+    std::vector<temporary_buffer<char>> _samples;
+    size_t _sampled = 0;
+    size_t _sample_size;
+    // The memory held for the dictionary samples and their training.
+    std::optional<semaphore_units<>> _sample_memory;
+    bool _choose_compressor;
+    // Chunks waiting to be compressed.
+    std::vector<temporary_buffer<char>> _batch;
+    size_t _batch_chunks;
+    // Write of the last compressed batch.
+    future<> _pending_write = make_ready_future<>();
+private:
+    future<> flush_samples() {
+        if (_choose_compressor) {
+            _choose_compressor = false;
+            if (!_samples.empty()) {
+                auto c = compression_parameters::choose_compressor(_samples);
+                _compression_metadata->set_compressor(c);
+                _compression = sstables::local_compression(*_compression_metadata);
+            }
+        } else if (_sampled >= _sample_size) {
+            auto opts = _compression.compressor()->train(_samples);
+            if (!opts.empty()) {
+                _compression_metadata->add_options(opts);
+                _compression = sstables::local_compression(*_compression_metadata);
+            }
+        }
+        // If the data is too small to train on, it is compressed without a dictionary.
+        _sample_size = 0;
+        _sampled = 0;
+        return do_with(std::move(_samples), [this] (std::vector<temporary_buffer<char>>& samples) {
+            return do_for_each(samples, [this] (temporary_buffer<char>& buf) {
+                return add_chunk(std::move(buf));
+            });
+        }).finally([this] {
+            _sample_memory.reset();
+        });
+    }
+    future<> add_chunk(temporary_buffer<char> buf) {
+        _batch.push_back(std::move(buf));
+        if (_batch.size() < _batch_chunks) {
+            return make_ready_future<>();
+        }
+        return flush_batch();
+    }
+    // Compresses the batch and queues its write after the previous one.
+    // Resolves once the previous batch has been handed to the output stream.
+    future<> flush_batch() {
+        if (_batch.empty()) {
+            return make_ready_future<>();
+        }
+        size_t max_len = 0;
+        for (auto& buf : _batch) {
+            // account space for checksum that goes after compressed data.
+            max_len += _compression.compress_max_size(buf.size()) + 4;
+        }
+        temporary_buffer<char> compressed(max_len);
+        size_t len = 0;
+        try {
+            for (auto& buf : _batch) {
+                len += compress_chunk(buf, compressed.get_write() + len, max_len - len);
+            }
+        } catch (...) {
+            return make_exception_future<>(std::current_exception());
+        }
+        _batch.clear();
+        compressed.trim(len);
+
+        promise<> accepted;
+        auto f = accepted.get_future();
+        _pending_write = _pending_write.then_wrapped([this, compressed = std::move(compressed), accepted = std::move(accepted)] (future<> prev) mutable {
+            if (prev.failed()) {
+                auto ep = prev.get_exception();
+                accepted.set_exception(ep);
+                return make_exception_future<>(std::move(ep));
+            }
+            accepted.set_value();
+            auto f = _out.write(compressed.get(), compressed.size());
+            return f.then([compressed = std::move(compressed)] {});
+        });
+        return f;
+    }
 public:
-    compressed_file_data_sink_impl(file f, sstables::compression* cm, sstables::local_compression lc, file_output_stream_options options)
+    compressed_file_data_sink_impl(file f, sstables::compression* cm, sstables::local_compression lc, file_output_stream_options options,
+            bool choose_compressor, semaphore* writer_memory)
             : _out(make_file_output_stream(std::move(f), options))
             , _compression_metadata(cm)
             , _offsets(_compression_metadata->offsets.get_writer())
             , _compression(lc)
             , _full_checksum(ChecksumType::init_checksum())
-    {}
+            , _sample_size(choose_compressor ? compression_batch_size : _compression ? _compression.compressor()->dictionary_sample_size() : 0)
+            , _choose_compressor(choose_compressor)
+            , _batch_chunks(std::max<size_t>(1, compression_batch_size / _compression_metadata->uncompressed_chunk_length()))
+    {
+        _batch.reserve(_batch_chunks);
+        if (!_choose_compressor && _sample_size && writer_memory) {
+            // Without the memory, the sstable is compressed without a dictionary.
+            _sample_memory = try_get_units(*writer_memory, _sample_size + _compression.compressor()->dictionary_training_memory());
+            if (!_sample_memory) {
+                _sample_size = 0;
+            }
+        }
+    }
 
     future<> put(net::packet data) { abort(); }
     virtual future<> put(temporary_buffer<char> buf) override {
-        auto output_len = _compression.compress_max_size(buf.size());
-
-        // account space for checksum that goes after compressed data.
-        temporary_buffer<char> compressed(output_len + 4);
+        if (_sample_size) {
+            _sampled += buf.size();
+            _samples.push_back(std::move(buf));
+            if (_sampled < _sample_size) {
+                return make_ready_future<>();
+            }
+            return flush_samples();
+        }
+        return add_chunk(std::move(buf));
+    }
+    // Compresses a chunk followed by its checksum into out, which has room
+    // for out_len bytes, and returns the number of bytes used.
+    size_t compress_chunk(const temporary_buffer<char>& buf, char* out, size_t out_len) {
+        auto output_len = out_len - 4;
 
         // compress flushed data.
-        auto len = _compression.compress(buf.get(), buf.size(), compressed.get_write(), output_len);
+        auto len = _compression.compress(buf.get(), buf.size(), out, output_len);
         if (len > output_len) {
-            return make_exception_future(std::runtime_error("possible overflow during compression"));
+            throw std::runtime_error("possible overflow during compression");
         }
 
         // total length of the uncompressed data.
@@ -530,11 +708,11 @@ class compressed_file_data_sink_impl : public data_sink_impl {
         _compression_metadata->set_compressed_file_length(_pos);
 
         // compute 32-bit checksum for compressed data.
-        uint32_t per_chunk_checksum = ChecksumType::checksum(compressed.get(), len);
-        _full_checksum = checksum_combine_or_feed<ChecksumType>(_full_checksum, per_chunk_checksum, compressed.get(), len);
+        uint32_t per_chunk_checksum = ChecksumType::checksum(out, len);
+        _full_checksum = checksum_combine_or_feed<ChecksumType>(_full_checksum, per_chunk_checksum, out, len);
 
         // write checksum into buffer after compressed data.
-        write_be<uint32_t>(compressed.get_write() + len, per_chunk_checksum);
+        write_be<uint32_t>(out + len, per_chunk_checksum);
 
         if constexpr (mode == compressed_checksum_mode::checksum_all) {
             uint32_t be_per_chunk_checksum = cpu_to_be(per_chunk_checksum);
@@ -544,13 +722,17 @@ class compressed_file_data_sink_impl : public data_sink_impl {
 
         _compression_metadata->set_full_checksum(_full_checksum);
 
-        compressed.trim(len + 4);
-
-        auto f = _out.write(compressed.get(), compressed.size());
-        return f.then([compressed = std::move(compressed)] {});
+        return len + 4;
     }
     virtual future<> close() override {
-        return _out.close();
+        auto f = _sample_size ? flush_samples() : make_ready_future<>();
+        return f.then([this] {
+            return flush_batch();
+        }).then([this] {
+            return std::move(_pending_write);
+        }).then([this] {
+            return _out.close();
+        });
     }
 };
 
@@ -560,9 +742,10 @@ GCC6_CONCEPT(
 )
 class compressed_file_data_sink : public data_sink {
 public:
-    compressed_file_data_sink(file f, sstables::compression* cm, sstables::local_compression lc, file_output_stream_options options)
+    compressed_file_data_sink(file f, sstables::compression* cm, sstables::local_compression lc, file_output_stream_options options,
+            bool choose_compressor, semaphore* writer_memory)
         : data_sink(std::make_unique<compressed_file_data_sink_impl<ChecksumType, mode>>(
-                std::move(f), cm, std::move(lc), options)) {}
+                std::move(f), cm, std::move(lc), options, choose_compressor, writer_memory)) {}
 };
 
 template <typename ChecksumType, compressed_checksum_mode mode>
@@ -571,7 +754,8 @@ GCC6_CONCEPT(
 )
 inline output_stream<char> make_compressed_file_output_stream(file f, file_output_stream_options options,
          sstables::compression* cm,
-         const compression_parameters& cp) {
+         const compression_parameters& cp,
+         semaphore* writer_memory) {
     // buffer of output stream is set to chunk length, because flush must
     // happen every time a chunk was filled up.
 
@@ -584,35 +768,40 @@ inline output_stream<char> make_compressed_file_output_stream(file f, file_outpu
     cm->options.elements.push_back({"crc_check_chance", "1.0"});
 
     auto outer_buffer_size = cm->uncompressed_chunk_length();
-    return output_stream<char>(compressed_file_data_sink<ChecksumType, mode>(std::move(f), cm, p, options), outer_buffer_size, true);
+    return output_stream<char>(compressed_file_data_sink<ChecksumType, mode>(std::move(f), cm, p, options, cp.is_auto(), writer_memory),
+            outer_buffer_size, true);
 }
 
 input_stream<char> sstables::make_compressed_file_k_l_format_input_stream(file f,
         sstables::compression* cm, uint64_t offset, size_t len,
-        class file_input_stream_options options)
+        class file_input_stream_options options, compressor_ptr p, full_checksum_handler on_full_checksum)
 {
-    return make_compressed_file_input_stream<adler32_utils>(std::move(f), cm, offset, len, std::move(options));
+    return make_compressed_file_input_stream<adler32_utils, compressed_checksum_mode::checksum_chunks_only>(std::move(f), cm, offset, len,
+            std::move(options), std::move(p), std::move(on_full_checksum));
 }
 
 output_stream<char> sstables::make_compressed_file_k_l_format_output_stream(file f,
         file_output_stream_options options,
         sstables::compression* cm,
-        const compression_parameters& cp) {
+        const compression_parameters& cp,
+        semaphore* writer_memory) {
     return make_compressed_file_output_stream<adler32_utils, compressed_checksum_mode::checksum_chunks_only>(
-            std::move(f), std::move(options), cm, cp);
+            std::move(f), std::move(options), cm, cp, writer_memory);
 }
 
 input_stream<char> sstables::make_compressed_file_m_format_input_stream(file f,
         sstables::compression *cm, uint64_t offset, size_t len,
-        class file_input_stream_options options) {
-    return make_compressed_file_input_stream<crc32_utils>(std::move(f), cm, offset, len, std::move(options));
+        class file_input_stream_options options, compressor_ptr p, full_checksum_handler on_full_checksum) {
+    return make_compressed_file_input_stream<crc32_utils, compressed_checksum_mode::checksum_all>(std::move(f), cm, offset, len,
+            std::move(options), std::move(p), std::move(on_full_checksum));
 }
 
 output_stream<char> sstables::make_compressed_file_m_format_output_stream(file f,
         file_output_stream_options options,
         sstables::compression* cm,
-        const compression_parameters& cp) {
+        const compression_parameters& cp,
+        semaphore* writer_memory) {
     return make_compressed_file_output_stream<crc32_utils, compressed_checksum_mode::checksum_all>(
-            std::move(f), std::move(options), cm, cp);
+            std::move(f), std::move(options), cm, cp, writer_memory);
 }
 
@@ -54,6 +54,8 @@
 #include <seastar/core/reactor.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/fstream.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/util/noncopyable_function.hh>
 
 #include "types.hh"
 #include "sstables/types.hh"
@@ -310,6 +312,8 @@ struct compression {
 public:
     // Set the compressor algorithm, please check the definition of enum compressor.
     void set_compressor(compressor_ptr c);
+    // Appends compressor specific options, e.g. a trained dictionary.
+    void add_options(const std::map<sstring, sstring>& opts);
     // After changing _compression, update() must be called to update
     // additional variables depending on it.    
     void update(uint64_t compressed_file_length);
@@ -370,28 +374,45 @@ struct compression {
 // for API query only. Free function just to distinguish it from an accessor in compression
 compressor_ptr get_sstable_compressor(const compression&);
 
+// Receives the full checksum of a data file, as stored in its Digest
+// component, computed by a stream which read the whole file.
+using full_checksum_handler = noncopyable_function<future<> (uint32_t)>;
+
 // Note: compression_metadata is passed by reference; The caller is
 // responsible for keeping the compression_metadata alive as long as there
 // are open streams on it. This should happen naturally on a higher level -
 // as long as we have *sstables* work in progress, we need to keep the whole
 // sstable alive, and the compression metadata is only a part of it.
+//
+// If a compressor is given, it must have been created from cm and it is used
+// instead of creating a new one for the stream. That lets streams share the
+// compressor's state, e.g. a dictionary which is costly to set up.
+//
+// If on_full_checksum is given and the stream covers the whole file, the full
+// checksum is computed from the chunks as they are read and passed to
+// on_full_checksum when the end of the file is reached, before the stream
+// reports end-of-file. Nothing is computed once the stream skips.
 input_stream<char> make_compressed_file_k_l_format_input_stream(file f,
                 sstables::compression* cm, uint64_t offset, size_t len,
-                class file_input_stream_options options);
+                class file_input_stream_options options, compressor_ptr p = {},
+                full_checksum_handler on_full_checksum = {});
 
 output_stream<char> make_compressed_file_k_l_format_output_stream(file f,
                 file_output_stream_options options,
                 sstables::compression* cm,
-                const compression_parameters& cp);
+                const compression_parameters& cp,
+                semaphore* writer_memory = nullptr);
 
 input_stream<char> make_compressed_file_m_format_input_stream(file f,
                 sstables::compression* cm, uint64_t offset, size_t len,
-                class file_input_stream_options options);
+                class file_input_stream_options options, compressor_ptr p = {},
+                full_checksum_handler on_full_checksum = {});
 
 output_stream<char> make_compressed_file_m_format_output_stream(file f,
                 file_output_stream_options options,
                 sstables::compression* cm,
-                const compression_parameters& cp);
+                const compression_parameters& cp,
+                semaphore* writer_memory = nullptr);
 
 }
 
@@ -99,6 +99,9 @@ class continuous_data_consumer {
         uint16_t uint16;
         uint8_t  uint8;
     } _read_int;
+    // state for the READING_*_VINT_WITH_LEN prestates
+    char _read_vint[max_vint_length];
+    uint8_t _vint_len;
     // state for READING_BYTES prestate
     temporary_buffer<char> _read_bytes;
     temporary_buffer<char>* _read_bytes_where; // which temporary_buffer to set, _key or _val?
@@ -112,6 +115,25 @@ class continuous_data_consumer {
         _prestate = next_state;
         return read_status::waiting;
     }
+    // A vint crossing buffers is at most max_vint_length bytes long, so it is
+    // collected in _read_vint rather than in an allocated buffer.
+    inline void read_partial_vint(temporary_buffer<char>& data, vint_size_type len) {
+        _vint_len = len;
+        std::copy(data.begin(), data.end(), _read_vint);
+        _pos = data.size();
+        data.trim(0);
+    }
+    // Returns true if the vint started by read_partial_vint() is now complete.
+    bool process_vint(temporary_buffer<char>& data) {
+        const auto n = std::min(size_t(_vint_len - _pos), data.size());
+        std::copy_n(data.begin(), n, _read_vint + _pos);
+        data.trim_front(n);
+        _pos += n;
+        return _pos == _vint_len;
+    }
+    bytes_view partial_vint() const {
+        return bytes_view(reinterpret_cast<const bytes::value_type*>(_read_vint), _vint_len);
+    }
     template <typename VintType, prestate ReadingVint, prestate ReadingVintWithLen, typename T>
     inline read_status read_vint(temporary_buffer<char>& data, T& dest) {
         static_assert(std::is_same_v<T, typename VintType::value_type>, "Destination type mismatch");
@@ -126,10 +148,7 @@ class continuous_data_consumer {
                 data.trim_front(len);
                 return read_status::ready;
             } else {
-                _read_bytes = make_tracked_temporary_buffer(temporary_buffer<char>(len), _permit);
-                std::copy(data.begin(), data.end(), _read_bytes.get_write());
-                _pos = data.size();
-                data.trim(0);
+                read_partial_vint(data, len);
                 _prestate = ReadingVintWithLen;
                 return read_status::waiting;
             }
@@ -138,13 +157,8 @@ class continuous_data_consumer {
     template <typename VintType, typename T>
     inline void read_vint_with_len(temporary_buffer<char>& data, T& dest) {
         static_assert(std::is_same_v<T, typename VintType::value_type>, "Destination type mismatch");
-        const auto n = std::min(_read_bytes.size() - _pos, data.size());
-        std::copy_n(data.begin(), n, _read_bytes.get_write() + _pos);
-        data.trim_front(n);
-        _pos += n;
-        if (_pos == _read_bytes.size()) {
-            dest = VintType::deserialize(
-                    bytes_view(reinterpret_cast<bytes::value_type*>(_read_bytes.get_write()), _read_bytes.size()));
+        if (process_vint(data)) {
+            dest = VintType::deserialize(partial_vint());
             _prestate = prestate::NONE;
         }
     };
@@ -247,10 +261,7 @@ class continuous_data_consumer {
                 data.trim_front(len);
                 return read_bytes(data, static_cast<uint32_t>(_u64), where);
             } else {
-                _read_bytes = make_tracked_temporary_buffer(temporary_buffer<char>(len), _permit);
-                std::copy(data.begin(), data.end(), _read_bytes.get_write());
-                _pos = data.size();
-                data.trim(0);
+                read_partial_vint(data, len);
                 _read_bytes_where = &where;
                 _prestate = prestate::READING_UNSIGNED_VINT_LENGTH_BYTES_WITH_LEN;
                 return read_status::waiting;
@@ -308,13 +319,8 @@ class continuous_data_consumer {
             read_vint_with_len<signed_vint>(data, _i64);
             break;
         case prestate::READING_UNSIGNED_VINT_LENGTH_BYTES_WITH_LEN: {
-            const auto n = std::min(_read_bytes.size() - _pos, data.size());
-            std::copy_n(data.begin(), n, _read_bytes.get_write() + _pos);
-            data.trim_front(n);
-            _pos += n;
-            if (_pos == _read_bytes.size()) {
-                _u64 = unsigned_vint::deserialize(
-                        bytes_view(reinterpret_cast<bytes::value_type*>(_read_bytes.get_write()), _read_bytes.size()));
+            if (process_vint(data)) {
+                _u64 = unsigned_vint::deserialize(partial_vint());
                 if (read_bytes(data, _u64, *_read_bytes_where) == read_status::ready) {
                     _prestate = prestate::NONE;
                 }
@@ -38,11 +38,11 @@ class reader_position_tracker;
 
 template <typename DataConsumeRowsContext>
 data_consume_context<DataConsumeRowsContext>
-data_consume_rows(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, sstable::disk_read_range, uint64_t);
+data_consume_rows(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, sstable::disk_read_range, uint64_t, const sstable::read_ahead_hint&);
 
 template <typename DataConsumeRowsContext>
 data_consume_context<DataConsumeRowsContext>
-data_consume_single_partition(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, sstable::disk_read_range);
+data_consume_single_partition(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, sstable::disk_read_range, const sstable::read_ahead_hint&);
 
 template <typename DataConsumeRowsContext>
 data_consume_context<DataConsumeRowsContext>
@@ -79,9 +79,9 @@ class data_consume_context {
 
     friend class sstable;
     friend data_consume_context<DataConsumeRowsContext>
-    data_consume_rows<DataConsumeRowsContext>(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, sstable::disk_read_range, uint64_t);
+    data_consume_rows<DataConsumeRowsContext>(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, sstable::disk_read_range, uint64_t, const sstable::read_ahead_hint&);
     friend data_consume_context<DataConsumeRowsContext>
-    data_consume_single_partition<DataConsumeRowsContext>(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, sstable::disk_read_range);
+    data_consume_single_partition<DataConsumeRowsContext>(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, sstable::disk_read_range, const sstable::read_ahead_hint&);
     friend data_consume_context<DataConsumeRowsContext>
     data_consume_rows<DataConsumeRowsContext>(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&);
 
@@ -172,22 +172,25 @@ using data_consume_context_opt = optimized_optional<data_consume_context<DataCon
 // read beyond end in anticipation of a small skip via fast_foward_to.
 // The amount of this excessive read is controlled by read ahead
 // hueristics which learn from the usefulness of previous read aheads.
+// The size of the buffers and number of read-ahead buffers follow hint.
 template <typename DataConsumeRowsContext>
-inline data_consume_context<DataConsumeRowsContext> data_consume_rows(const schema& s, shared_sstable sst, typename DataConsumeRowsContext::consumer& consumer, sstable::disk_read_range toread, uint64_t last_end) {
+inline data_consume_context<DataConsumeRowsContext> data_consume_rows(const schema& s, shared_sstable sst, typename DataConsumeRowsContext::consumer& consumer, sstable::disk_read_range toread, uint64_t last_end,
+        const sstable::read_ahead_hint& hint) {
     // Although we were only asked to read until toread.end, we'll not limit
     // the underlying file input stream to this end, but rather to last_end.
     // This potentially enables read-ahead beyond end, until last_end, which
     // can be beneficial if the user wants to fast_forward_to() on the
     // returned context, and may make small skips.
     auto input = sst->data_stream(toread.start, last_end - toread.start, consumer.io_priority(),
-            consumer.permit(), consumer.trace_state(), sst->_partition_range_history);
+            consumer.permit(), consumer.trace_state(), sst->_partition_range_history, hint);
     return {s, std::move(sst), consumer, std::move(input), toread.start, toread.end - toread.start };
 }
 
 template <typename DataConsumeRowsContext>
-inline data_consume_context<DataConsumeRowsContext> data_consume_single_partition(const schema& s, shared_sstable sst, typename DataConsumeRowsContext::consumer& consumer, sstable::disk_read_range toread) {
+inline data_consume_context<DataConsumeRowsContext> data_consume_single_partition(const schema& s, shared_sstable sst, typename DataConsumeRowsContext::consumer& consumer, sstable::disk_read_range toread,
+        const sstable::read_ahead_hint& hint) {
     auto input = sst->data_stream(toread.start, toread.end - toread.start, consumer.io_priority(),
-            consumer.permit(), consumer.trace_state(), sst->_single_partition_history);
+            consumer.permit(), consumer.trace_state(), sst->_single_partition_history, hint);
     return {s, std::move(sst), consumer, std::move(input), toread.start, toread.end - toread.start };
 }
 
@@ -195,7 +198,8 @@ inline data_consume_context<DataConsumeRowsContext> data_consume_single_partitio
 template <typename DataConsumeRowsContext>
 inline data_consume_context<DataConsumeRowsContext> data_consume_rows(const schema& s, shared_sstable sst, typename DataConsumeRowsContext::consumer& consumer) {
         auto data_size = sst->data_size();
-        return data_consume_rows<DataConsumeRowsContext>(s, std::move(sst), consumer, {0, data_size}, data_size);
+        return data_consume_rows<DataConsumeRowsContext>(s, std::move(sst), consumer, {0, data_size}, data_size,
+                {sstable::read_ahead_hint::access::sequential, data_size});
 }
 
 }
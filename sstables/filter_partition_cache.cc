@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sstables/filter_partition_cache.hh"
+
+namespace sstables {
+
+thread_local filter_partition_cache::stats filter_partition_cache::_shard_stats;
+
+filter_partition_cache::filter_partition_cache(size_t max_bytes)
+    : _max_bytes(max_bytes)
+{ }
+
+filter_partition_cache::~filter_partition_cache() {
+    clear();
+}
+
+void filter_partition_cache::erase(filter_partitions& partitions, filter_partitions::iterator it) noexcept {
+    auto size = it->second.nr_words * sizeof(uint64_t);
+    _bytes -= size;
+    _shard_stats.bytes -= size;
+    partitions.erase(it);
+}
+
+void filter_partition_cache::evict() noexcept {
+    while (_bytes > _max_bytes && !_lru.empty()) {
+        auto& p = _lru.back();
+        auto filters_it = _filters.find(p.filter);
+        auto& partitions = filters_it->second;
+        erase(partitions, partitions.find(p.idx));
+        if (partitions.empty()) {
+            _filters.erase(filters_it);
+        }
+        ++_shard_stats.evictions;
+    }
+}
+
+const uint64_t* filter_partition_cache::find(filter_id id, uint64_t idx) {
+    auto filters_it = _filters.find(id);
+    if (filters_it != _filters.end()) {
+        auto it = filters_it->second.find(idx);
+        if (it != filters_it->second.end()) {
+            auto& p = it->second;
+            p.lru_link.unlink();
+            _lru.push_front(p);
+            ++_shard_stats.hits;
+            return p.words.get();
+        }
+    }
+    ++_shard_stats.misses;
+    return nullptr;
+}
+
+void filter_partition_cache::populate(filter_id id, uint64_t idx, std::unique_ptr<uint64_t[]> words, size_t nr_words) {
+    auto size = nr_words * sizeof(uint64_t);
+    if (size > _max_bytes) {
+        return;
+    }
+    auto& partitions = _filters[id];
+    auto [it, inserted] = partitions.emplace(idx, partition{id, idx, std::move(words), nr_words});
+    if (!inserted) {
+        return;
+    }
+    _lru.push_front(it->second);
+    _bytes += size;
+    _shard_stats.bytes += size;
+    ++_shard_stats.populations;
+    evict();
+}
+
+void filter_partition_cache::invalidate(filter_id id) noexcept {
+    auto filters_it = _filters.find(id);
+    if (filters_it == _filters.end()) {
+        return;
+    }
+    auto& partitions = filters_it->second;
+    while (!partitions.empty()) {
+        erase(partitions, partitions.begin());
+    }
+    _filters.erase(filters_it);
+}
+
+void filter_partition_cache::clear() noexcept {
+    while (!_filters.empty()) {
+        invalidate(_filters.begin()->first);
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include <boost/intrusive/list.hpp>
+
+namespace sstables {
+
+// Shard-wide cache of Bloom filter partitions.
+//
+// Large split-block Bloom filters are not kept resident (see
+// partitioned_filter). Their partitions are loaded on demand into this
+// cache, which evicts the least recently used partitions once its memory
+// exceeds the configured limit.
+class filter_partition_cache {
+public:
+    // Identifies the filter of a sstable, never reused.
+    using filter_id = uint64_t;
+
+    static thread_local struct stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t populations = 0;
+        uint64_t evictions = 0;
+        uint64_t bytes = 0;
+    } _shard_stats;
+private:
+    using lru_link_type = boost::intrusive::list_member_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+    struct partition {
+        filter_id filter;
+        uint64_t idx;
+        std::unique_ptr<uint64_t[]> words;
+        size_t nr_words;
+        lru_link_type lru_link;
+    };
+    using lru_type = boost::intrusive::list<partition,
+        boost::intrusive::member_hook<partition, lru_link_type, &partition::lru_link>,
+        boost::intrusive::constant_time_size<false>>;
+    using filter_partitions = std::map<uint64_t, partition>;
+
+    std::unordered_map<filter_id, filter_partitions> _filters;
+    lru_type _lru;
+    size_t _max_bytes;
+    size_t _bytes = 0;
+    filter_id _next_filter_id = 0;
+private:
+    void erase(filter_partitions& partitions, filter_partitions::iterator it) noexcept;
+    void evict() noexcept;
+public:
+    explicit filter_partition_cache(size_t max_bytes);
+    ~filter_partition_cache();
+    filter_partition_cache(const filter_partition_cache&) = delete;
+
+    filter_id new_filter_id() {
+        return _next_filter_id++;
+    }
+
+    void set_max_bytes(size_t max_bytes) {
+        _max_bytes = max_bytes;
+        evict();
+    }
+    size_t max_bytes() const {
+        return _max_bytes;
+    }
+
+    // Returns the words of a cached partition, which stay valid until the
+    // next call to populate(), or nullptr if it isn't cached.
+    const uint64_t* find(filter_id id, uint64_t idx);
+
+    void populate(filter_id id, uint64_t idx, std::unique_ptr<uint64_t[]> words, size_t nr_words);
+
+    // Drops all partitions of a filter.
+    void invalidate(filter_id id) noexcept;
+
+    void clear() noexcept;
+
+    static const stats& shard_stats() { return _shard_stats; }
+};
+
+}
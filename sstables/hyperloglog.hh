@@ -102,6 +102,21 @@ static inline size_t write_unsigned_var_int(unsigned int value, uint8_t* to) {
     return size;
 }
 
+static inline unsigned int read_unsigned_var_int(const uint8_t*& from, const uint8_t* end) {
+    unsigned int value = 0;
+    for (unsigned shift = 0; shift < 32; shift += 7) {
+        if (from == end) {
+            throw std::invalid_argument("truncated unsigned var int");
+        }
+        uint8_t b = *from++;
+        value |= unsigned(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return value;
+        }
+    }
+    throw std::invalid_argument("unsigned var int is too long");
+}
+
 /** @class HyperLogLog
  *  @brief Implement of 'HyperLogLog' estimate cardinality algorithm
  */
@@ -141,11 +156,35 @@ class HyperLogLog {
         alphaMM_ = alpha * m_ * m_;
     }
 
+    /**
+     * Restores an estimator from the buffer returned by get_bytes(), e.g. the
+     * cardinality data of the compaction metadata.
+     *
+     * @exception std::invalid_argument the buffer isn't in the format written by get_bytes().
+     */
     static HyperLogLog from_bytes(temporary_buffer<uint8_t> bytes) {
-        // FIXME: implement class that creates a HyperLogLog from an array of bytes.
-        // This will useful if we need to work with the cardinality data from the
-        // compaction metadata.
-        abort();
+        static constexpr int version = 2;
+
+        const uint8_t* from = bytes.get();
+        const uint8_t* end = from + bytes.size();
+        if (bytes.size() < sizeof(int) || read_be<int32_t>(reinterpret_cast<const char*>(from)) != -version) {
+            throw std::invalid_argument("unsupported cardinality data version");
+        }
+        from += sizeof(int);
+
+        auto b = read_unsigned_var_int(from, end);
+        // sparse set precision, unused since the sparse format isn't supported
+        read_unsigned_var_int(from, end);
+        if (read_unsigned_var_int(from, end) != 0) {
+            throw std::invalid_argument("only the NORMAL cardinality data type is supported");
+        }
+        auto size = read_unsigned_var_int(from, end);
+        if (b < 4 || 16 < b || size != (1u << b) || size_t(end - from) != size) {
+            throw std::invalid_argument("malformed cardinality data");
+        }
+        HyperLogLog hll(b);
+        std::copy_n(from, size, hll.M_.begin());
+        return hll;
     }
 
     /**
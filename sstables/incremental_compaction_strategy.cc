@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "incremental_compaction_strategy.hh"
+#include "sstables/size_tiered_backlog_tracker.hh"
+#include <boost/range/adaptor/map.hpp>
+#include <boost/range/adaptor/reversed.hpp>
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/algorithm.hpp>
+#include <boost/range/numeric.hpp>
+
+namespace sstables {
+
+incremental_compaction_strategy::incremental_compaction_strategy(const std::map<sstring, sstring>& options)
+    : compaction_strategy_impl(options)
+    , _options(options)
+    , _backlog_tracker(with_tombstone_compaction_backlog(std::make_unique<size_tiered_backlog_tracker>()))
+{
+    using namespace cql3::statements;
+
+    auto tmp_value = compaction_strategy_impl::get_value(options, SSTABLE_SIZE_OPTION);
+    auto size_in_mb = property_definitions::to_long(SSTABLE_SIZE_OPTION, tmp_value, DEFAULT_MAX_SSTABLE_SIZE_IN_MB);
+    if (size_in_mb <= 0) {
+        throw exceptions::configuration_exception(format("{} must be greater than 0, got {}", SSTABLE_SIZE_OPTION, size_in_mb));
+    }
+    _fragment_size = uint64_t(size_in_mb) * 1024 * 1024;
+}
+
+std::vector<sstable_run>
+incremental_compaction_strategy::make_runs(const std::vector<shared_sstable>& sstables) {
+    std::unordered_map<utils::UUID, sstable_run> runs;
+    for (auto& sst : sstables) {
+        runs[sst->run_identifier()].insert(sst);
+    }
+    return boost::copy_range<std::vector<sstable_run>>(runs | boost::adaptors::map_values);
+}
+
+std::vector<shared_sstable>
+incremental_compaction_strategy::runs_to_sstables(std::vector<sstable_run> runs) {
+    std::vector<shared_sstable> sstables;
+    for (auto& run : runs) {
+        sstables.insert(sstables.end(), run.all().begin(), run.all().end());
+    }
+    return sstables;
+}
+
+std::vector<std::vector<sstable_run>>
+incremental_compaction_strategy::get_buckets(const std::vector<sstable_run>& runs) const {
+    // runs sorted by size, as sstables are by size_tiered_compaction_strategy.
+    auto sorted_runs = boost::copy_range<std::vector<std::pair<sstable_run, uint64_t>>>(runs
+            | boost::adaptors::transformed([] (const sstable_run& run) {
+        return std::make_pair(run, run.data_size());
+    }));
+    boost::sort(sorted_runs, [] (auto& i, auto& j) {
+        return i.second < j.second;
+    });
+
+    std::map<uint64_t, std::vector<sstable_run>> buckets;
+    for (auto& [run, size] : sorted_runs) {
+        bool found = false;
+        // group in the same bucket if it's w/in 50% of the average for this bucket,
+        // or this run and the bucket are all considered "small" (less than `min_sstable_size`)
+        for (auto it = buckets.begin(); it != buckets.end(); it++) {
+            uint64_t old_average_size = it->first;
+
+            if ((size > (old_average_size * _options.bucket_low) && size < (old_average_size * _options.bucket_high)) ||
+                    (size < _options.min_sstable_size && old_average_size < _options.min_sstable_size)) {
+                auto bucket = std::move(it->second);
+                uint64_t total_size = bucket.size() * old_average_size;
+                uint64_t new_average_size = (total_size + size) / (bucket.size() + 1);
+
+                bucket.push_back(std::move(run));
+                buckets.erase(it);
+                buckets.insert({ new_average_size, std::move(bucket) });
+
+                found = true;
+                break;
+            }
+        }
+
+        // no similar bucket found; put it in a new one
+        if (!found) {
+            buckets.insert({ size, std::vector<sstable_run>{std::move(run)} });
+        }
+    }
+
+    return boost::copy_range<std::vector<std::vector<sstable_run>>>(buckets | boost::adaptors::map_values);
+}
+
+std::vector<sstable_run>
+incremental_compaction_strategy::most_interesting_bucket(std::vector<std::vector<sstable_run>> buckets,
+        size_t min_threshold, size_t max_threshold) const {
+    std::vector<sstable_run>* smallest = nullptr;
+    uint64_t smallest_size = std::numeric_limits<uint64_t>::max();
+
+    for (auto& bucket : buckets) {
+        bucket.resize(std::min(bucket.size(), max_threshold));
+        if (bucket.size() < min_threshold) {
+            continue;
+        }
+        auto size = boost::accumulate(bucket | boost::adaptors::transformed(std::mem_fn(&sstable_run::data_size)), uint64_t(0));
+        // Compact the smallest runs first, as size-tiered does.
+        auto avg = size / bucket.size();
+        if (avg < smallest_size) {
+            smallest = &bucket;
+            smallest_size = avg;
+        }
+    }
+    return smallest ? std::move(*smallest) : std::vector<sstable_run>();
+}
+
+compaction_descriptor incremental_compaction_strategy::make_descriptor(std::vector<shared_sstable> sstables) const {
+    return compaction_descriptor(std::move(sstables), compaction_descriptor::default_level, _fragment_size);
+}
+
+compaction_descriptor
+incremental_compaction_strategy::get_sstables_for_compaction(column_family& cfs, std::vector<sstables::shared_sstable> candidates) {
+    // make local copies so they can't be changed out from under us mid-method
+    size_t min_threshold = cfs.min_compaction_threshold();
+    size_t max_threshold = cfs.schema()->max_compaction_threshold();
+
+    auto buckets = get_buckets(make_runs(candidates));
+
+    auto most_interesting = most_interesting_bucket(buckets, min_threshold, max_threshold);
+    if (!most_interesting.empty()) {
+        return make_descriptor(runs_to_sstables(std::move(most_interesting)));
+    }
+
+    // If we are not enforcing min_threshold explicitly, try any pair of runs in the same tier.
+    if (!cfs.compaction_enforce_min_threshold()) {
+        most_interesting = most_interesting_bucket(buckets, 2, max_threshold);
+        if (!most_interesting.empty()) {
+            return make_descriptor(runs_to_sstables(std::move(most_interesting)));
+        }
+    }
+
+    // If there is no run to compact in standard way, compaction_strategy falls back to a tombstone
+    // compaction of a single fragment.
+    return sstables::compaction_descriptor();
+}
+
+compaction_descriptor
+incremental_compaction_strategy::get_major_compaction_job(column_family& cf, std::vector<sstables::shared_sstable> candidates) {
+    return make_descriptor(std::move(candidates));
+}
+
+int64_t incremental_compaction_strategy::estimated_pending_compactions(column_family& cf) const {
+    size_t min_threshold = cf.min_compaction_threshold();
+    size_t max_threshold = cf.schema()->max_compaction_threshold();
+    int64_t n = 0;
+
+    auto sstables = boost::copy_range<std::vector<shared_sstable>>(*cf.get_sstables());
+    for (auto& bucket : get_buckets(make_runs(sstables))) {
+        if (bucket.size() >= min_threshold) {
+            n += std::ceil(double(bucket.size()) / max_threshold);
+        }
+    }
+    return n;
+}
+
+}
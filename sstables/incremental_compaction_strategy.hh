@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "compaction_strategy_impl.hh"
+#include "size_tiered_compaction_strategy.hh"
+#include "sstable_set.hh"
+
+namespace sstables {
+
+// Size-tiered compaction working on sstable runs rather than on sstables.
+//
+// Compaction output is split into fragments of at most sstable_size_in_mb,
+// all belonging to the same run, and tiers are made of runs of similar size.
+// Since the fragments of a run don't overlap, compaction releases an input
+// fragment as soon as the output has gone past its last key, instead of
+// holding all input until the output is sealed (see compaction.cc). The
+// temporary space overhead of a compaction is thus bounded by a few
+// fragments, rather than by the size of its input as with size-tiered.
+class incremental_compaction_strategy : public compaction_strategy_impl {
+    static constexpr uint64_t DEFAULT_MAX_SSTABLE_SIZE_IN_MB = 1000;
+    const sstring SSTABLE_SIZE_OPTION = "sstable_size_in_mb";
+
+    size_tiered_compaction_strategy_options _options;
+    uint64_t _fragment_size;
+    compaction_backlog_tracker _backlog_tracker;
+
+    static std::vector<sstable_run> make_runs(const std::vector<shared_sstable>& sstables);
+    static std::vector<shared_sstable> runs_to_sstables(std::vector<sstable_run> runs);
+
+    // Group runs of similar size into buckets.
+    std::vector<std::vector<sstable_run>> get_buckets(const std::vector<sstable_run>& runs) const;
+
+    // Maybe return a bucket of runs to compact
+    std::vector<sstable_run>
+    most_interesting_bucket(std::vector<std::vector<sstable_run>> buckets, size_t min_threshold, size_t max_threshold) const;
+
+    compaction_descriptor make_descriptor(std::vector<shared_sstable> sstables) const;
+public:
+    incremental_compaction_strategy(const std::map<sstring, sstring>& options);
+
+    virtual compaction_descriptor get_sstables_for_compaction(column_family& cfs, std::vector<sstables::shared_sstable> candidates) override;
+
+    virtual compaction_descriptor get_major_compaction_job(column_family& cf, std::vector<sstables::shared_sstable> candidates) override;
+
+    virtual int64_t estimated_pending_compactions(column_family& cf) const override;
+
+    virtual compaction_strategy_type type() const override {
+        return compaction_strategy_type::incremental;
+    }
+
+    virtual compaction_backlog_tracker& get_backlog_tracker() override {
+        return _backlog_tracker;
+    }
+};
+
+}
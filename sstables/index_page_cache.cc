@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <seastar/core/align.hh>
+
+#include "sstables/index_page_cache.hh"
+
+namespace sstables {
+
+thread_local index_page_cache::stats index_page_cache::_shard_stats;
+
+index_page_cache::index_page_cache() {
+    _region.make_evictable([this] {
+        if (_lru.empty()) {
+            return memory::reclaiming_result::reclaimed_nothing;
+        }
+        auto& p = _lru.back();
+        auto files_it = _files.find(p.file);
+        auto& pages = files_it->second;
+        erase(pages, pages.find(p.idx));
+        if (pages.empty()) {
+            _files.erase(files_it);
+        }
+        ++_shard_stats.page_evictions;
+        return memory::reclaiming_result::reclaimed_something;
+    });
+}
+
+index_page_cache::~index_page_cache() {
+    clear();
+}
+
+void index_page_cache::erase(file_pages& pages, file_pages::iterator it) noexcept {
+    _shard_stats.bytes -= it->second.data.size();
+    with_allocator(_region.allocator(), [&] {
+        pages.erase(it);
+    });
+}
+
+bool index_page_cache::read(file_id id, uint64_t pos, temporary_buffer<uint8_t>& buf) {
+    auto files_it = _files.find(id);
+    if (files_it == _files.end()) {
+        _shard_stats.page_misses += align_up(buf.size(), page_size) / page_size;
+        return false;
+    }
+    auto& pages = files_it->second;
+    // Check all pages first, so that a miss doesn't touch any page.
+    auto first = pages.find(pos / page_size);
+    auto it = first;
+    for (uint64_t offset = 0; offset < buf.size(); offset += page_size, ++it) {
+        if (it == pages.end() || it->first != (pos + offset) / page_size || it->second.data.size() < std::min(page_size, buf.size() - offset)) {
+            _shard_stats.page_misses += align_up(buf.size(), page_size) / page_size;
+            return false;
+        }
+    }
+    it = first;
+    for (uint64_t offset = 0; offset < buf.size(); offset += page_size, ++it) {
+        auto& p = it->second;
+        with_linearized_managed_bytes([&] {
+            bytes_view data = p.data;
+            std::copy_n(data.begin(), std::min(page_size, buf.size() - offset), buf.get_write() + offset);
+        });
+        p.lru_link.unlink();
+        _lru.push_front(p);
+        ++_shard_stats.page_hits;
+    }
+    return true;
+}
+
+void index_page_cache::populate(file_id id, uint64_t pos, const temporary_buffer<uint8_t>& buf, uint64_t file_size) {
+    try {
+        _as(_region, [&] {
+            with_allocator(_region.allocator(), [&] {
+                auto& pages = _files[id];
+                for (uint64_t offset = 0; offset < buf.size(); offset += page_size) {
+                    auto size = std::min(page_size, buf.size() - offset);
+                    if (size < page_size && pos + offset + size != file_size) {
+                        break;
+                    }
+                    auto idx = (pos + offset) / page_size;
+                    if (pages.count(idx)) {
+                        continue;
+                    }
+                    auto data = bytes_view(reinterpret_cast<const bytes::value_type*>(buf.get() + offset), size);
+                    auto& p = pages.emplace(idx, page{id, idx, managed_bytes(data)}).first->second;
+                    _lru.push_front(p);
+                    _shard_stats.bytes += size;
+                    ++_shard_stats.page_populations;
+                }
+            });
+        });
+    } catch (const std::bad_alloc&) {
+        // The cache is best-effort, the read is served from buf anyway.
+    }
+}
+
+void index_page_cache::invalidate(file_id id) noexcept {
+    auto files_it = _files.find(id);
+    if (files_it == _files.end()) {
+        return;
+    }
+    for (auto& [idx, p] : files_it->second) {
+        _shard_stats.bytes -= p.data.size();
+    }
+    with_allocator(_region.allocator(), [&] {
+        _files.erase(files_it);
+    });
+}
+
+void index_page_cache::clear() noexcept {
+    while (!_files.empty()) {
+        invalidate(_files.begin()->first);
+    }
+}
+
+class cached_index_file_impl : public file_impl {
+    file _file;
+    index_page_cache& _cache;
+    index_page_cache::file_id _id;
+    uint64_t _file_size;
+public:
+    cached_index_file_impl(file f, index_page_cache& cache, index_page_cache::file_id id, uint64_t file_size)
+        : _file(std::move(f))
+        , _cache(cache)
+        , _id(id)
+        , _file_size(file_size)
+    { }
+
+    virtual future<size_t> write_dma(uint64_t pos, const void* buffer, size_t len, const io_priority_class& pc) override {
+        return get_file_impl(_file)->write_dma(pos, buffer, len, pc);
+    }
+
+    virtual future<size_t> write_dma(uint64_t pos, std::vector<iovec> iov, const io_priority_class& pc) override {
+        return get_file_impl(_file)->write_dma(pos, std::move(iov), pc);
+    }
+
+    virtual future<size_t> read_dma(uint64_t pos, void* buffer, size_t len, const io_priority_class& pc) override {
+        return get_file_impl(_file)->read_dma(pos, buffer, len, pc);
+    }
+
+    virtual future<size_t> read_dma(uint64_t pos, std::vector<iovec> iov, const io_priority_class& pc) override {
+        return get_file_impl(_file)->read_dma(pos, std::move(iov), pc);
+    }
+
+    virtual future<> flush(void) override {
+        return get_file_impl(_file)->flush();
+    }
+
+    virtual future<struct stat> stat(void) override {
+        return get_file_impl(_file)->stat();
+    }
+
+    virtual future<> truncate(uint64_t length) override {
+        return get_file_impl(_file)->truncate(length);
+    }
+
+    virtual future<> discard(uint64_t offset, uint64_t length) override {
+        return get_file_impl(_file)->discard(offset, length);
+    }
+
+    virtual future<> allocate(uint64_t position, uint64_t length) override {
+        return get_file_impl(_file)->allocate(position, length);
+    }
+
+    virtual future<uint64_t> size(void) override {
+        return get_file_impl(_file)->size();
+    }
+
+    virtual future<> close() override {
+        return get_file_impl(_file)->close();
+    }
+
+    virtual std::unique_ptr<seastar::file_handle_impl> dup() override {
+        return get_file_impl(_file)->dup();
+    }
+
+    virtual subscription<directory_entry> list_directory(std::function<future<> (directory_entry de)> next) override {
+        return get_file_impl(_file)->list_directory(next);
+    }
+
+    virtual future<temporary_buffer<uint8_t>> dma_read_bulk(uint64_t offset, size_t range_size, const io_priority_class& pc) override {
+        if (offset >= _file_size) {
+            return make_ready_future<temporary_buffer<uint8_t>>();
+        }
+        range_size = std::min<uint64_t>(range_size, _file_size - offset);
+        auto start = align_down(offset, uint64_t(index_page_cache::page_size));
+        auto end = std::min(align_up(offset + range_size, uint64_t(index_page_cache::page_size)), _file_size);
+        temporary_buffer<uint8_t> buf(end - start);
+        if (_cache.read(_id, start, buf)) {
+            buf.trim_front(offset - start);
+            buf.trim(range_size);
+            return make_ready_future<temporary_buffer<uint8_t>>(std::move(buf));
+        }
+        // If the sstable goes away while the read is in progress, the pages are
+        // populated for a file id which is never used again and are eventually evicted.
+        return get_file_impl(_file)->dma_read_bulk(start, end - start, pc).then(
+                [this, start, offset, range_size] (temporary_buffer<uint8_t> buf) {
+            _cache.populate(_id, start, buf, _file_size);
+            if (buf.size() <= offset - start) {
+                return temporary_buffer<uint8_t>();
+            }
+            buf.trim_front(offset - start);
+            buf.trim(std::min<size_t>(range_size, buf.size()));
+            return buf;
+        });
+    }
+};
+
+file make_cached_index_file(file f, index_page_cache& cache, index_page_cache::file_id id, uint64_t file_size) {
+    return file(make_shared<cached_index_file_impl>(std::move(f), cache, id, file_size));
+}
+
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <unordered_map>
+
+#include <boost/intrusive/list.hpp>
+#include <seastar/core/file.hh>
+
+#include "seastarx.hh"
+#include "utils/logalloc.hh"
+#include "utils/managed_bytes.hh"
+
+namespace sstables {
+
+// Shard-wide cache of Index.db pages.
+//
+// Index files are read through a file wrapper (see make_cached_index_file())
+// which serves reads from page-aligned buffers kept in an evictable LSA region,
+// so the cache gives memory back under pressure just like the row cache does.
+// Both partition index pages and promoted index blocks are read through that
+// file, so repeated point reads of the same partitions don't go to disk for the
+// index once it is cached. ClusteringRanges records are cached the same way.
+//
+// Pages are cached in their on-disk form and are parsed by every read.
+class index_page_cache {
+public:
+    static constexpr size_t page_size = 4096;
+    // Identifies the index file of a sstable, never reused.
+    using file_id = uint64_t;
+
+    static thread_local struct stats {
+        uint64_t page_hits = 0;
+        uint64_t page_misses = 0;
+        uint64_t page_populations = 0;
+        uint64_t page_evictions = 0;
+        uint64_t bytes = 0;
+    } _shard_stats;
+private:
+    using lru_link_type = boost::intrusive::list_member_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+    struct page {
+        file_id file;
+        uint64_t idx;
+        // Allocated in _region.
+        managed_bytes data;
+        lru_link_type lru_link;
+    };
+    using lru_type = boost::intrusive::list<page,
+        boost::intrusive::member_hook<page, lru_link_type, &page::lru_link>,
+        boost::intrusive::constant_time_size<false>>;
+    using file_pages = std::map<uint64_t, page>;
+
+    logalloc::region _region;
+    logalloc::allocating_section _as;
+    std::unordered_map<file_id, file_pages> _files;
+    lru_type _lru;
+    file_id _next_file_id = 0;
+private:
+    void erase(file_pages& pages, file_pages::iterator it) noexcept;
+public:
+    index_page_cache();
+    ~index_page_cache();
+    index_page_cache(const index_page_cache&) = delete;
+
+    file_id new_file_id() {
+        return _next_file_id++;
+    }
+
+    // Copies the cached pages covering [pos, pos + buf.size()) into buf.
+    // pos must be page-aligned. Returns false, leaving buf in an unspecified
+    // state, if any of those pages isn't cached.
+    bool read(file_id id, uint64_t pos, temporary_buffer<uint8_t>& buf);
+
+    // Caches the pages held by buf, which starts at the page-aligned pos.
+    // A trailing partial page is only cached if it ends at file_size.
+    void populate(file_id id, uint64_t pos, const temporary_buffer<uint8_t>& buf, uint64_t file_size);
+
+    // Drops all pages of a file.
+    void invalidate(file_id id) noexcept;
+
+    void clear() noexcept;
+
+    const logalloc::region& region() const { return _region; }
+
+    static const stats& shard_stats() { return _shard_stats; }
+};
+
+// Wraps an index file so that reads are served from, and populate, the cache.
+file make_cached_index_file(file f, index_page_cache& cache, index_page_cache::file_id id, uint64_t file_size);
+
+}
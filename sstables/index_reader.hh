@@ -304,7 +304,7 @@ class index_reader {
         index_consume_entry_context<index_consumer> _context;
 
         static file get_file(sstable& sst, reader_permit permit, tracing::trace_state_ptr trace_state) {
-            auto f = make_tracked_file(sst._index_file, std::move(permit));
+            auto f = make_tracked_file(sst.cached_index_file(), std::move(permit));
             if (!trace_state) {
                 return f;
             }
@@ -380,7 +380,7 @@ class index_reader {
         }
         auto loader = [this] (uint64_t summary_idx) -> future<index_list> {
             auto& summary = _sstable->get_summary();
-            uint64_t position = summary.entries[summary_idx].position;
+            uint64_t position = summary.entries.position(summary_idx);
             uint64_t quantity = downsampling::get_effective_index_interval_after_index(summary_idx, summary.header.sampling_level,
                 summary.header.min_index_interval);
 
@@ -388,7 +388,7 @@ class index_reader {
             if (summary_idx + 1 >= summary.header.size) {
                 end = _sstable->index_size();
             } else {
-                end = summary.entries[summary_idx + 1].position;
+                end = summary.entries.position(summary_idx + 1);
             }
 
             return do_with(std::make_unique<reader>(_sstable, _permit, _pc, _trace_state, position, end, quantity), [this, summary_idx] (auto& entries_reader) {
@@ -509,8 +509,7 @@ class index_reader {
         }
 
         auto& summary = _sstable->get_summary();
-        bound.previous_summary_idx = std::distance(std::begin(summary.entries),
-            std::lower_bound(summary.entries.begin() + bound.previous_summary_idx, summary.entries.end(), pos, index_comparator(*_sstable->_schema)));
+        bound.previous_summary_idx = summary.entries.lower_bound(*_sstable->_schema, pos, bound.previous_summary_idx);
 
         if (bound.previous_summary_idx == 0) {
             sstlog.trace("index {}: first entry", this);
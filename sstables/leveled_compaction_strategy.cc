@@ -21,6 +21,9 @@
 
 #include "leveled_compaction_strategy.hh"
 #include <algorithm>
+#include <boost/algorithm/cxx11/none_of.hpp>
+#include <boost/range/algorithm/remove_if.hpp>
+#include <boost/range/adaptor/transformed.hpp>
 
 namespace sstables {
 
@@ -34,36 +37,40 @@ compaction_descriptor leveled_compaction_strategy::get_sstables_for_compaction(c
     if (!_last_compacted_keys) {
         generate_last_compacted_keys(manifest);
     }
+    manifest.set_ongoing_compactions(prune_ongoing_compactions(cfs, candidates));
     auto candidate = manifest.get_compaction_candidates(*_last_compacted_keys, _compaction_counter);
 
     if (!candidate.sstables.empty()) {
         leveled_manifest::logger.debug("leveled: Compacting {} out of {} sstables", candidate.sstables.size(), cfs.get_sstables()->size());
+        _ongoing_compactions.push_back({candidate.sstables, leveled_manifest::footprint_of(candidate.sstables, candidate.level)});
         return candidate;
     }
 
-    // if there is no sstable to compact in standard way, try compacting based on droppable tombstone ratio
-    // unlike stcs, lcs can look for sstable with highest droppable tombstone ratio, so as not to choose
-    // a sstable which droppable data shadow data in older sstable, by starting from highest levels which
-    // theoretically contain oldest non-overlapping data.
-    auto gc_before = gc_clock::now() - cfs.schema()->gc_grace_seconds();
-    for (auto level = int(manifest.get_level_count()); level >= 0; level--) {
-        auto& sstables = manifest.get_level(level);
-        // filter out sstables which droppable tombstone ratio isn't greater than the defined threshold.
-        auto e = boost::range::remove_if(sstables, [this, &gc_before] (const sstables::shared_sstable& sst) -> bool {
-            return !worth_dropping_tombstones(sst, gc_before);
-        });
-        sstables.erase(e, sstables.end());
-        if (sstables.empty()) {
-            continue;
-        }
-        auto& sst = *std::max_element(sstables.begin(), sstables.end(), [&] (auto& i, auto& j) {
-            return i->estimate_droppable_tombstone_ratio(gc_before) < j->estimate_droppable_tombstone_ratio(gc_before);
-        });
-        return sstables::compaction_descriptor({ sst }, sst->get_sstable_level());
-    }
+    // If there is no sstable to compact in standard way, compaction_strategy falls back to a tombstone
+    // compaction, which keeps the level of the sstable it picks.
     return {};
 }
 
+std::vector<leveled_manifest::compaction_footprint>
+leveled_compaction_strategy::prune_ongoing_compactions(column_family& cf, const std::vector<shared_sstable>& candidates) {
+    // A compaction is over once its sstables are either back among the candidates, because it failed
+    // or was never started, or removed from the table, because it completed. Sstables exhausted by
+    // incremental compaction are removed early, so a single remaining one keeps the compaction alive.
+    auto candidate_set = boost::copy_range<std::unordered_set<shared_sstable>>(candidates);
+    auto all = cf.get_sstables();
+    auto e = boost::range::remove_if(_ongoing_compactions, [&] (const ongoing_compaction& c) {
+        return boost::algorithm::any_of(c.sstables, [&] (const shared_sstable& sst) { return candidate_set.count(sst); })
+            || boost::algorithm::none_of(c.sstables, [&] (const shared_sstable& sst) { return all->count(sst); });
+    });
+    _ongoing_compactions.erase(e, _ongoing_compactions.end());
+    return boost::copy_range<std::vector<leveled_manifest::compaction_footprint>>(_ongoing_compactions
+            | boost::adaptors::transformed(std::mem_fn(&ongoing_compaction::footprint)));
+}
+
+bool leveled_compaction_strategy::is_cold_output(const compaction_descriptor& descriptor) const {
+    return descriptor.level > 1;
+}
+
 compaction_descriptor leveled_compaction_strategy::get_major_compaction_job(column_family& cf, std::vector<sstables::shared_sstable> candidates) {
     if (candidates.empty()) {
         return compaction_descriptor();
@@ -34,7 +34,17 @@ class leveled_compaction_strategy : public compaction_strategy_impl {
     std::vector<int> _compaction_counter;
     size_tiered_compaction_strategy_options _stcs_options;
     compaction_backlog_tracker _backlog_tracker;
+    // Compactions handed out by get_sstables_for_compaction() which may still be running.
+    struct ongoing_compaction {
+        std::vector<shared_sstable> sstables;
+        leveled_manifest::compaction_footprint footprint;
+    };
+    std::vector<ongoing_compaction> _ongoing_compactions;
     int32_t calculate_max_sstable_size_in_mb(std::optional<sstring> option_value) const;
+    // Forgets the compactions which are no longer running and returns the footprints
+    // of the remaining ones.
+    std::vector<leveled_manifest::compaction_footprint> prune_ongoing_compactions(column_family& cf,
+            const std::vector<shared_sstable>& candidates);
 public:
     leveled_compaction_strategy(const std::map<sstring, sstring>& options);
     virtual compaction_descriptor get_sstables_for_compaction(column_family& cfs, std::vector<sstables::shared_sstable> candidates) override;
@@ -51,10 +61,6 @@ class leveled_compaction_strategy : public compaction_strategy_impl {
 
     virtual int64_t estimated_pending_compactions(column_family& cf) const override;
 
-    virtual bool parallel_compaction() const override {
-        return false;
-    }
-
     virtual compaction_strategy_type type() const {
         return compaction_strategy_type::leveled;
     }
@@ -63,6 +69,9 @@ class leveled_compaction_strategy : public compaction_strategy_impl {
     virtual compaction_backlog_tracker& get_backlog_tracker() override {
         return _backlog_tracker;
     }
+
+    // Levels past L1 hold most of the data and are rewritten the least often.
+    virtual bool is_cold_output(const compaction_descriptor& descriptor) const override;
 };
 
 }
@@ -46,7 +46,9 @@
 #include "size_tiered_compaction_strategy.hh"
 #include "range.hh"
 #include "log.hh"
+#include <bitset>
 #include <boost/range/algorithm/partial_sort.hpp>
+#include <boost/algorithm/cxx11/any_of.hpp>
 
 class leveled_manifest {
     table& _table;
@@ -81,7 +83,24 @@ class leveled_manifest {
     // Lowest score (score is about how much data a level contains vs its ideal amount) for a
     // level to be considered worth compacting.
     static constexpr float TARGET_SCORE = 1.001f;
+
+    // Token range and levels above L0 read or written by a compaction.
+    // Compactions whose footprints share a level and overlap in token range
+    // cannot run concurrently, as their outputs could overlap in that level.
+    // L0 is left out since its sstables may overlap anyway.
+    struct compaction_footprint {
+        dht::token first;
+        dht::token last;
+        std::bitset<MAX_LEVELS> levels;
+
+        bool conflicts_with(const compaction_footprint& o) const {
+            return (levels & o.levels).any() && first <= o.last && o.first <= last;
+        }
+    };
 private:
+    // Footprints of the compactions in progress, see set_ongoing_compactions().
+    std::vector<compaction_footprint> _ongoing_compactions;
+
     leveled_manifest(column_family& cfs, int max_sstable_size_in_MB, const sstables::size_tiered_compaction_strategy_options& stcs_options)
         : _table(cfs)
         , _schema(cfs.schema())
@@ -113,6 +132,40 @@ class leveled_manifest {
         return manifest;
     }
 
+    static compaction_footprint footprint_of(const std::vector<sstables::shared_sstable>& sstables, int target_level) {
+        assert(!sstables.empty());
+        compaction_footprint f{sstables.front()->get_first_decorated_key()._token, sstables.front()->get_last_decorated_key()._token, {}};
+        for (auto& sst : sstables) {
+            f.first = std::min(f.first, sst->get_first_decorated_key()._token);
+            f.last = std::max(f.last, sst->get_last_decorated_key()._token);
+            if (auto level = sst->get_sstable_level()) {
+                f.levels.set(level);
+            }
+        }
+        if (target_level) {
+            f.levels.set(target_level);
+        }
+        return f;
+    }
+
+    // Makes the candidate selection skip compactions which conflict with the
+    // given compactions in progress, whose sstables are expected to be absent
+    // from the manifest. This allows compactions of different levels, and of
+    // disjoint token ranges of a level, to run in parallel.
+    void set_ongoing_compactions(std::vector<compaction_footprint> ongoing) {
+        _ongoing_compactions = std::move(ongoing);
+    }
+
+    bool conflicts_with_ongoing_compactions(const std::vector<sstables::shared_sstable>& sstables, int target_level) const {
+        if (_ongoing_compactions.empty() || sstables.empty()) {
+            return false;
+        }
+        auto f = footprint_of(sstables, target_level);
+        return boost::algorithm::any_of(_ongoing_compactions, [&f] (const compaction_footprint& o) {
+            return f.conflicts_with(o);
+        });
+    }
+
     // Return first set of overlapping sstables for a given level.
     // Assumes _generations[level] is already sorted by first key.
     std::vector<sstables::shared_sstable> overlapping_sstables(int level) const {
@@ -170,7 +223,11 @@ class leveled_manifest {
             int next_level = get_next_level(info.candidates, info.can_promote);
 
             if (info.can_promote) {
-                info.candidates = get_overlapping_starved_sstables(next_level, std::move(info.candidates), compaction_counter);
+                auto with_starved = get_overlapping_starved_sstables(next_level, std::vector<sstables::shared_sstable>(info.candidates), compaction_counter);
+                // The starved sstable may widen the footprint of the compaction, leave it out if that causes a conflict.
+                if (!conflicts_with_ongoing_compactions(with_starved, next_level)) {
+                    info.candidates = std::move(with_starved);
+                }
             }
             return sstables::compaction_descriptor(std::move(info.candidates), next_level, _max_sstable_size_in_bytes);
         } else {
@@ -428,6 +485,17 @@ class leveled_manifest {
             auto l1overlapping = overlapping(*_schema, candidates, get_level(1));
             candidates.insert(candidates.end(), l1overlapping.begin(), l1overlapping.end());
             can_promote = true;
+            if (conflicts_with_ongoing_compactions(candidates, get_next_level(candidates))) {
+                // Another compaction is writing to the L1 range we would promote to. Size-tier L0 meanwhile
+                // if it has fallen far enough behind, which can proceed in parallel as it stays in L0.
+                logger.debug("L0 promotion conflicts with ongoing compactions");
+                candidates.clear();
+                can_promote = false;
+                if (get_level_size(0) > MAX_COMPACTING_L0) {
+                    candidates = sstables::size_tiered_compaction_strategy::most_interesting_bucket(get_level(0),
+                        _table.min_compaction_threshold(), _schema->max_compaction_threshold(), _stcs_options);
+                }
+            }
         } else {
             // do STCS in L0 when max_sstable_size is high compared to size of new sstables, so we'll
             // avoid quadratic behavior until L0 is worth promoting.
@@ -472,6 +540,9 @@ class leveled_manifest {
         // invariant to be restored.
         auto overlapping_current_level = overlapping_sstables(level);
         if (!overlapping_current_level.empty()) {
+            if (conflicts_with_ongoing_compactions(overlapping_current_level, level)) {
+                return { {}, false };
+            }
             logger.info("Leveled compaction strategy is restoring invariant of level {} by compacting {} sstables on behalf of {}.{}",
                 level, overlapping_current_level.size(), s.ks_name(), s.cf_name());
             return { overlapping_current_level, false };
@@ -479,11 +550,18 @@ class leveled_manifest {
 
         int start = sstable_index_based_on_last_compacted_key(sstables, level, s, last_compacted_keys);
 
-        auto pos = start % sstables.size();
-        auto candidates = overlapping(*_schema, sstables.at(pos), get_level(level + 1));
-        candidates.push_back(sstables.at(pos));
-
-        return { candidates, true };
+        // Starting from where the previous compaction left off, pick the first sstable
+        // whose compaction into the next level doesn't conflict with ongoing ones.
+        for (size_t i = 0; i < sstables.size(); i++) {
+            auto pos = (start + i) % sstables.size();
+            auto candidates = overlapping(*_schema, sstables.at(pos), get_level(level + 1));
+            candidates.push_back(sstables.at(pos));
+            if (!conflicts_with_ongoing_compactions(candidates, level + 1)) {
+                return { candidates, true };
+            }
+        }
+        logger.debug("All L{} candidates conflict with ongoing compactions", level);
+        return { {}, true };
     }
 
     /**
@@ -19,6 +19,8 @@
  * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <array>
+
 #include "vint-serialization.hh"
 #include "sstables/types.hh"
 #include "sstables/m_format_read_helpers.hh"
@@ -39,13 +41,17 @@ inline future<T> read_vint_impl(random_access_reader& in) {
     return in.read_exactly(1).then([&in] (auto&& buf) {
         check_buf_size(buf, 1);
         vint_size_type len = vint_type::serialized_size_from_first_byte(*buf.begin());
-        temporary_buffer<char> bytes(len);
-        std::copy_n(buf.begin(), 1, bytes.get_write());
-        return in.read_exactly(len - 1).then([len, bytes = std::move(bytes)] (temporary_buffer<char> buf) mutable {
+        if (len == 1) {
+            return make_ready_future<T>(vint_type::deserialize(
+                bytes_view(reinterpret_cast<const bytes::value_type*>(buf.get()), 1)));
+        }
+        std::array<char, max_vint_length> bytes;
+        bytes[0] = *buf.begin();
+        return in.read_exactly(len - 1).then([len, bytes] (temporary_buffer<char> buf) mutable {
             check_buf_size(buf, len - 1);
-            std::copy_n(buf.begin(), len - 1, bytes.get_write() + 1);
+            std::copy_n(buf.begin(), len - 1, bytes.begin() + 1);
             return vint_type::deserialize(
-                bytes_view(reinterpret_cast<bytes::value_type*>(bytes.get_write()), len));
+                bytes_view(reinterpret_cast<const bytes::value_type*>(bytes.data()), len));
         });
     });
 }
@@ -30,6 +30,10 @@
 #include "db/config.hh"
 #include "atomic_cell.hh"
 #include "utils/exceptions.hh"
+#include "utils/bloom_filter.hh"
+#include "utils/xor_filter.hh"
+#include "sstables/clustering_ranges.hh"
+#include "sstables/trie_index.hh"
 
 #include <functional>
 #include <boost/iterator/iterator_facade.hpp>
@@ -535,6 +539,13 @@ class writer : public sstable_writer::writer_impl {
     bool _compression_enabled = false;
     std::unique_ptr<file_writer> _data_writer;
     std::unique_ptr<file_writer> _index_writer;
+    // Writes ClusteringRanges, for schemas with clustering columns.
+    std::unique_ptr<file_writer> _clustering_ranges_file_writer;
+    std::optional<clustering_ranges::writer> _clustering_ranges_writer;
+    clustering_ranges::partition_info _partition_clustering;
+    // Writes TrieIndex, if enabled by the configuration.
+    std::unique_ptr<file_writer> _trie_index_file_writer;
+    std::unique_ptr<trie::index_writer> _trie_index_writer;
     bool _tombstone_written = false;
     bool _static_row_written = false;
     // The length of partition header (partition key, partition deletion and static row, if present)
@@ -731,8 +742,36 @@ class writer : public sstable_writer::writer_impl {
     void flush_tmp_bufs() {
         flush_tmp_bufs(*_data_writer);
     }
-public:
 
+    // Xor filters buffer a hash per partition until the sstable is sealed,
+    // so they are only used when that buffer is reasonably small. The bound
+    // applies to the partitions actually written, not to the estimate.
+    static constexpr uint64_t max_xor_filter_partitions = 8 << 20;
+    // Memory for the xor filter is reserved in steps of this many partitions.
+    static constexpr uint64_t xor_filter_reservation_partitions = 64 << 10;
+
+    // Set while the filter is an xor filter: the Bloom filter the sstable
+    // gets instead if the xor filter exceeds its bounds. The xor filter only
+    // keeps half of each key hash, so the keys are added to both filters.
+    utils::filter_ptr _fallback_filter;
+    uint64_t _xor_filter_partitions = 0;
+    uint64_t _xor_filter_reserved_partitions = 0;
+    // Writer memory held while the filter is an xor filter, for both the
+    // xor filter and the fallback Bloom filter.
+    std::optional<semaphore_units<>> _xor_filter_memory;
+
+    utils::filter_format fallback_filter_format() const {
+        if (_cfg.split_block_bloom_filter) {
+            return utils::filter_format::split_block_format;
+        }
+        return utils::filter_format::m_format;
+    }
+
+    bool reserve_writer_memory(size_t bytes);
+    bool reserve_xor_filter_memory(uint64_t partitions);
+    void fall_back_from_xor_filter(const char* reason);
+    void add_to_filter(bytes_view key);
+public:
     writer(sstable& sst, const schema& s, uint64_t estimated_partitions,
         const sstable_writer_config& cfg, encoding_stats enc_stats,
         const io_priority_class& pc, shard_id shard = this_shard_id())
@@ -746,6 +785,12 @@ class writer : public sstable_writer::writer_impl {
         , _write_regular_as_static(cfg.correctly_serialize_static_compact_in_mc && s.is_static_compact_table())
     {
         _sst.generate_toc(_schema.get_compressor_params().get_compressor(), _schema.bloom_filter_fp_chance());
+        if (_schema.clustering_key_size()) {
+            _sst._recognized_components.insert(component_type::ClusteringRanges);
+        }
+        if (_cfg.trie_index) {
+            _sst._recognized_components.insert(component_type::TrieIndex);
+        }
         _sst.write_toc(_pc);
         _sst.create_data().get();
         _compression_enabled = !_sst.has_component(component_type::CRC);
@@ -753,7 +798,17 @@ class writer : public sstable_writer::writer_impl {
         _sst._shards = { shard };
 
         _cfg.monitor->on_write_started(_data_writer->offset_tracker());
-        _sst._components->filter = utils::i_filter::get_filter(estimated_partitions, _schema.bloom_filter_fp_chance(), utils::filter_format::m_format);
+        auto fp_chance = _schema.bloom_filter_fp_chance();
+        _sst._components->filter = utils::i_filter::get_filter(estimated_partitions, fp_chance, fallback_filter_format());
+        // The Bloom filter is allocated up front, so it is reserved whole.
+        if (_cfg.xor_filter && estimated_partitions <= max_xor_filter_partitions
+                && reserve_writer_memory(_sst._components->filter->memory_size())
+                && reserve_xor_filter_memory(std::min(estimated_partitions, xor_filter_reservation_partitions))) {
+            _fallback_filter = std::exchange(_sst._components->filter,
+                    utils::i_filter::get_filter(estimated_partitions, fp_chance, utils::filter_format::xor_format));
+        } else {
+            _xor_filter_memory.reset();
+        }
         _pi_write_m.desired_block_size = cfg.promoted_index_block_size;
         _sst._correctly_serialize_non_compound_range_tombstones = _cfg.correctly_serialize_non_compound_range_tombstones;
         _index_sampling_state.summary_byte_cost = _cfg.summary_byte_cost;
@@ -783,6 +838,8 @@ writer::~writer() {
     };
     close_writer(_index_writer);
     close_writer(_data_writer);
+    close_writer(_clustering_ranges_file_writer);
+    close_writer(_trie_index_file_writer);
 }
 
 void writer::maybe_set_pi_first_clustering(const writer::clustering_info& info) {
@@ -839,9 +896,22 @@ void writer::init_file_writers() {
                 std::move(_sst._data_file),
                 options,
                 &_sst._components->compression,
-                _schema.get_compressor_params()));
+                _cfg.compression ? *_cfg.compression : _schema.get_compressor_params(),
+                _cfg.writer_memory));
     }
     _index_writer = std::make_unique<file_writer>(std::move(_sst._index_file), options);
+    if (_sst.has_component(component_type::ClusteringRanges)) {
+        auto oflags = open_flags::wo | open_flags::create | open_flags::exclusive;
+        auto f = _sst.new_sstable_component_file(_sst._write_error_handler, component_type::ClusteringRanges, oflags).get0();
+        _clustering_ranges_file_writer = std::make_unique<file_writer>(std::move(f), options);
+        _clustering_ranges_writer.emplace(*_clustering_ranges_file_writer);
+    }
+    if (_sst.has_component(component_type::TrieIndex)) {
+        auto oflags = open_flags::wo | open_flags::create | open_flags::exclusive;
+        auto f = _sst.new_sstable_component_file(_sst._write_error_handler, component_type::TrieIndex, oflags).get0();
+        _trie_index_file_writer = std::make_unique<file_writer>(std::move(f), options);
+        _trie_index_writer = std::make_unique<trie::index_writer>(*_trie_index_file_writer);
+    }
 }
 
 std::unique_ptr<file_writer> writer::close_writer(std::unique_ptr<file_writer>& w) {
@@ -932,6 +1002,55 @@ void writer::drain_tombstones(std::optional<position_in_partition_view> pos) {
     }
 }
 
+bool writer::reserve_writer_memory(size_t bytes) {
+    if (!_cfg.writer_memory) {
+        return true;
+    }
+    auto units = try_get_units(*_cfg.writer_memory, bytes);
+    if (!units) {
+        return false;
+    }
+    if (_xor_filter_memory) {
+        _xor_filter_memory->adopt(std::move(*units));
+    } else {
+        _xor_filter_memory = std::move(units);
+    }
+    return true;
+}
+
+// Reserves the memory an xor filter needs for the given number of
+// partitions, including what build() allocates when the sstable is sealed.
+bool writer::reserve_xor_filter_memory(uint64_t partitions) {
+    auto needed = utils::filter::xor_filter::peak_memory(partitions) - utils::filter::xor_filter::peak_memory(_xor_filter_reserved_partitions);
+    if (!reserve_writer_memory(needed)) {
+        return false;
+    }
+    _xor_filter_reserved_partitions = partitions;
+    return true;
+}
+
+void writer::fall_back_from_xor_filter(const char* reason) {
+    slogger.debug("Writing a Bloom filter instead of an xor filter for {} after {} partitions: {}", _sst.get_filename(), _xor_filter_partitions, reason);
+    _sst._components->filter = std::move(_fallback_filter);
+    _xor_filter_memory.reset();
+}
+
+void writer::add_to_filter(bytes_view key) {
+    _sst._components->filter->add(key);
+    if (!_fallback_filter) {
+        return;
+    }
+    _fallback_filter->add(key);
+    if (++_xor_filter_partitions <= _xor_filter_reserved_partitions) {
+        return;
+    }
+    if (_xor_filter_partitions > max_xor_filter_partitions) {
+        fall_back_from_xor_filter("too many partitions");
+    } else if (!reserve_xor_filter_memory(std::min(_xor_filter_reserved_partitions + xor_filter_reservation_partitions, max_xor_filter_partitions))) {
+        fall_back_from_xor_filter("writer memory exhausted");
+    }
+}
+
 void writer::consume_new_partition(const dht::decorated_key& dk) {
     _c_stats.start_offset = _data_writer->offset();
     _prev_row_start = _data_writer->offset();
@@ -939,7 +1058,10 @@ void writer::consume_new_partition(const dht::decorated_key& dk) {
     _partition_key = key::from_partition_key(_schema, dk.key());
     maybe_add_summary_entry(dk.token(), bytes_view(*_partition_key));
 
-    _sst._components->filter->add(bytes_view(*_partition_key));
+    add_to_filter(bytes_view(*_partition_key));
+    if (_trie_index_writer) {
+        _trie_index_writer->add(dk.token(), _c_stats.start_offset);
+    }
     _sst.get_metadata_collector().add_key(bytes_view(*_partition_key));
 
     auto p_key = disk_string_view<uint16_t>();
@@ -965,6 +1087,7 @@ void writer::consume_new_partition(const dht::decorated_key& dk) {
 
     _tombstone_written = false;
     _static_row_written = false;
+    _partition_clustering = {};
 }
 
 void writer::consume(tombstone t) {
@@ -976,6 +1099,9 @@ void writer::consume(tombstone t) {
 
     _pi_write_m.tomb = t;
     _tombstone_written = true;
+    if (t) {
+        _partition_clustering.flags |= clustering_ranges::partition_info::has_partition_tombstone;
+    }
 }
 
 void writer::write_cell(bytes_ostream& writer, const clustering_key_prefix* clustering_key, atomic_cell_view cell,
@@ -1210,6 +1336,9 @@ void writer::write_static_row(const row& static_row, column_kind kind) {
 
 stop_iteration writer::consume(static_row&& sr) {
     ensure_tombstone_is_written();
+    if (!sr.empty()) {
+        _partition_clustering.flags |= clustering_ranges::partition_info::has_static_row;
+    }
     write_static_row(sr.cells(), column_kind::static_column);
     return stop_iteration::no;
 }
@@ -1267,8 +1396,10 @@ stop_iteration writer::consume(clustering_row&& cr) {
     if (_write_regular_as_static) {
         ensure_tombstone_is_written();
         write_static_row(cr.cells(), column_kind::regular_column);
+        _partition_clustering.flags |= clustering_ranges::partition_info::has_static_row;
         return stop_iteration::no;
     }
+    _partition_clustering.add_clustered(_schema, cr.position(), cr.position());
     drain_tombstones(position_in_partition_view::after_key(cr.key()));
     write_clustered(cr);
     return stop_iteration::no;
@@ -1348,6 +1479,7 @@ void writer::consume(rt_marker&& marker) {
 }
 
 stop_iteration writer::consume(range_tombstone&& rt) {
+    _partition_clustering.add_clustered(_schema, rt.position(), rt.end_position());
     drain_tombstones(rt.position());
     _range_tombstones.apply(std::move(rt));
     return stop_iteration::no;
@@ -1370,6 +1502,9 @@ stop_iteration writer::consume_end_of_partition() {
     _sst.get_large_data_handler().maybe_record_large_partitions(_sst, *_partition_key, _c_stats.partition_size).get();
     _sst.get_large_data_handler().maybe_log_too_many_rows(_sst, *_partition_key, _c_stats.rows_count);
 
+    if (_clustering_ranges_writer) {
+        _clustering_ranges_writer->add(_c_stats.start_offset, _partition_clustering);
+    }
 
     // update is about merging column_stats with the data being stored by collector.
     _sst.get_metadata_collector().update(std::move(_c_stats));
@@ -1397,6 +1532,14 @@ void writer::consume_end_of_stream() {
     }
 
     close_writer(_index_writer);
+    if (_clustering_ranges_writer) {
+        _clustering_ranges_writer->finish();
+        close_writer(_clustering_ranges_file_writer);
+    }
+    if (_trie_index_writer) {
+        _trie_index_writer->finish();
+        close_writer(_trie_index_file_writer);
+    }
     _sst.set_first_and_last_keys();
 
     _sst._components->statistics.contents[metadata_type::Serialization] = std::make_unique<serialization_header>(std::move(_sst_schema.header));
@@ -1405,7 +1548,10 @@ void writer::consume_end_of_stream() {
         _sst._schema, _sst.get_first_decorated_key(), _sst.get_last_decorated_key(), _enc_stats);
     close_data_writer();
     _sst.write_summary(_pc);
+    // The xor filter is complete, and build() is accounted for by its reservation.
+    _fallback_filter = {};
     _sst.write_filter(_pc);
+    _xor_filter_memory.reset();
     _sst.write_statistics(_pc);
     _sst.write_compression(_pc);
     auto features = sstable_enabled_features::all();
@@ -1415,6 +1561,12 @@ void writer::consume_end_of_stream() {
     if (!_cfg.correctly_serialize_static_compact_in_mc) {
         features.disable(sstable_feature::CorrectStaticCompact);
     }
+    if (!dynamic_cast<utils::filter::split_block_bloom_filter*>(_sst._components->filter.get())) {
+        features.disable(sstable_feature::SplitBlockBloomFilter);
+    }
+    if (!dynamic_cast<utils::filter::xor_filter*>(_sst._components->filter.get())) {
+        features.disable(sstable_feature::XorFilter);
+    }
     run_identifier identifier{_run_identifier};
     _sst.write_scylla_metadata(_pc, _shard, std::move(features), std::move(identifier));
     _cfg.monitor->on_write_completed();
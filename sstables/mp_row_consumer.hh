@@ -1247,6 +1247,15 @@ class mp_row_consumer_m : public consumer_m {
         return proceed::yes;
     }
 
+    virtual bool is_column_value_needed(const column_translation::column_info& column_info, bool is_static) const override {
+        if (!_slice.options.contains(query::partition_slice::option::skip_unselected_cells)
+                || !column_info.id || column_info.schema_mismatch) {
+            return true;
+        }
+        auto& columns = is_static ? _slice.static_columns : _slice.regular_columns;
+        return std::find(columns.begin(), columns.end(), *column_info.id) != columns.end();
+    }
+
     virtual proceed consume_complex_column_start(const sstables::column_translation::column_info& column_info,
                                                  tombstone tomb) override {
         sstlog.trace("mp_row_consumer_m {}: consume_complex_column_start({}, {})", this, column_info.id, tomb);
@@ -32,6 +32,7 @@
 #include "index_reader.hh"
 #include "counters.hh"
 #include "utils/data_input.hh"
+#include "utils/latency_sampler.hh"
 #include "clustering_ranges_walker.hh"
 #include "binary_search.hh"
 #include "../dht/i_partitioner.hh"
@@ -42,11 +43,11 @@ namespace sstables {
 
 template
 data_consume_context<data_consume_rows_context>
-data_consume_rows<data_consume_rows_context>(const schema& s, shared_sstable, data_consume_rows_context::consumer&, sstable::disk_read_range, uint64_t);
+data_consume_rows<data_consume_rows_context>(const schema& s, shared_sstable, data_consume_rows_context::consumer&, sstable::disk_read_range, uint64_t, const sstable::read_ahead_hint&);
 
 template
 data_consume_context<data_consume_rows_context>
-data_consume_single_partition<data_consume_rows_context>(const schema& s, shared_sstable, data_consume_rows_context::consumer&, sstable::disk_read_range);
+data_consume_single_partition<data_consume_rows_context>(const schema& s, shared_sstable, data_consume_rows_context::consumer&, sstable::disk_read_range, const sstable::read_ahead_hint&);
 
 template
 data_consume_context<data_consume_rows_context>
@@ -54,11 +55,11 @@ data_consume_rows<data_consume_rows_context>(const schema& s, shared_sstable, da
 
 template
 data_consume_context<data_consume_rows_context_m>
-data_consume_rows<data_consume_rows_context_m>(const schema& s, shared_sstable, data_consume_rows_context_m::consumer&, sstable::disk_read_range, uint64_t);
+data_consume_rows<data_consume_rows_context_m>(const schema& s, shared_sstable, data_consume_rows_context_m::consumer&, sstable::disk_read_range, uint64_t, const sstable::read_ahead_hint&);
 
 template
 data_consume_context<data_consume_rows_context_m>
-data_consume_single_partition<data_consume_rows_context_m>(const schema& s, shared_sstable, data_consume_rows_context_m::consumer&, sstable::disk_read_range);
+data_consume_single_partition<data_consume_rows_context_m>(const schema& s, shared_sstable, data_consume_rows_context_m::consumer&, sstable::disk_read_range, const sstable::read_ahead_hint&);
 
 template
 data_consume_context<data_consume_rows_context_m>
@@ -134,6 +135,9 @@ class sstable_mutation_reader : public mp_row_consumer_reader {
     std::unique_ptr<index_reader> _index_reader;
     // We avoid unnecessary lookup for single partition reads thanks to this flag
     bool _single_partition_read = false;
+    // Set when ClusteringRanges shows the slice selects nothing from the
+    // partition, which is then produced without reading the data file.
+    bool _partition_excluded = false;
     std::function<future<> ()> _initialize;
     streamed_mutation::forwarding _fwd;
     read_monitor& _monitor;
@@ -173,7 +177,9 @@ class sstable_mutation_reader : public mp_row_consumer_reader {
                 sstable::disk_read_range drr{begin, *end};
                 auto last_end = fwd_mr ? _sst->data_size() : drr.end;
                 _read_enabled = bool(drr);
-                _context = data_consume_rows<DataConsumeRowsContext>(*_schema, _sst, _consumer, std::move(drr), last_end);
+                auto hint = sstable::read_ahead_hint{sstable::read_ahead_hint::access::sequential, drr.end - drr.start,
+                        slice.options.contains(query::partition_slice::option::bypass_cache)};
+                _context = data_consume_rows<DataConsumeRowsContext>(*_schema, _sst, _consumer, std::move(drr), last_end, hint);
                 _monitor.on_read_started(_context->reader_position());
                 _index_in_current_partition = true;
                 _will_likely_slice = will_likely_slice(slice);
@@ -195,9 +201,15 @@ class sstable_mutation_reader : public mp_row_consumer_reader {
         , _consumer(this, _schema, std::move(permit), slice, pc, std::move(trace_state), fwd, _sst)
         , _single_partition_read(true)
         , _initialize([this, key = std::move(key), &pc, &slice, fwd_mr] () mutable {
-            position_in_partition_view pos = get_slice_upper_bound(*_schema, slice, key);
-            auto f = get_index_reader().advance_lower_and_check_if_present(key, pos);
-            return f.then([this, &slice, &pc, key] (bool present) mutable {
+            return _sst->trie_index_excludes(key.token(), pc).then([this, &slice, &pc, key] (bool excluded) mutable {
+              if (excluded) {
+                _sst->get_filter_tracker().add_false_positive();
+                _sst->get_stats().on_trie_index_partition_skip();
+                return make_ready_future<>();
+              }
+              position_in_partition_view pos = get_slice_upper_bound(*_schema, slice, key);
+              auto f = get_index_reader().advance_lower_and_check_if_present(key, pos);
+              return f.then([this, &slice, &pc, key] (bool present) mutable {
                 if (!present) {
                     _sst->get_filter_tracker().add_false_positive();
                     return make_ready_future<>();
@@ -208,12 +220,25 @@ class sstable_mutation_reader : public mp_row_consumer_reader {
                 auto [start, end] = _index_reader->data_file_positions();
                 assert(end);
                 _read_enabled = (start != *end);
+                _will_likely_slice = will_likely_slice(slice);
+                // Slicing reads skip within the partition, only whole
+                // partition reads consume it in order.
+                auto hint = sstable::read_ahead_hint{
+                        _will_likely_slice ? sstable::read_ahead_hint::access::point : sstable::read_ahead_hint::access::sequential,
+                        *end - start, slice.options.contains(query::partition_slice::option::bypass_cache)};
                 _context = data_consume_single_partition<DataConsumeRowsContext>(*_schema, _sst, _consumer,
-                        { start, *end });
+                        { start, *end }, hint);
                 _monitor.on_read_started(_context->reader_position());
-                _will_likely_slice = will_likely_slice(slice);
                 _index_in_current_partition = true;
-                return make_ready_future<>();
+                // With forwarding, other ranges may be read later on.
+                if (!_read_enabled || _fwd || !_will_likely_slice) {
+                    return make_ready_future<>();
+                }
+                auto& ranges = slice.row_ranges(*_schema, *key.key());
+                return _sst->partition_excludes_ranges(*_schema, start, ranges, pc).then([this] (bool excluded) {
+                    _partition_excluded = excluded;
+                });
+              });
             });
         })
         , _fwd(fwd)
@@ -295,6 +320,18 @@ class sstable_mutation_reader : public mp_row_consumer_reader {
             return make_ready_future<>();
         }
 
+        if (_partition_excluded) {
+            sstlog.trace("reader {}: slice excluded by clustering ranges", this);
+            _partition_excluded = false;
+            _read_enabled = false;
+            _sst->get_stats().on_clustering_ranges_partition_skip();
+            auto pk = _index_reader->partition_key().to_partition_key(*_schema);
+            on_next_partition(dht::decorate_key(*_schema, std::move(pk)), tombstone());
+            push_mutation_fragment(mutation_fragment(partition_end()));
+            _partition_finished = true;
+            return make_ready_future<>();
+        }
+
         if (!_consumer.is_mutation_end()) {
             // FIXME: give more details from _context
             throw malformed_sstable_exception("consumer not at partition boundary", _sst->get_filename());
@@ -413,13 +450,15 @@ class sstable_mutation_reader : public mp_row_consumer_reader {
             return make_ready_future<>();
         }
         if (!is_initialized()) {
-            return _initialize().then([this, timeout] {
-                if (!is_initialized()) {
-                    _end_of_stream = true;
-                    return make_ready_future<>();
-                } else {
-                    return fill_buffer(timeout);
-                }
+            return utils::sample_latency(utils::latency_stage::sstable_first_read, [this, timeout] {
+                return _initialize().then([this, timeout] {
+                    if (!is_initialized()) {
+                        _end_of_stream = true;
+                        return make_ready_future<>();
+                    } else {
+                        return fill_buffer(timeout);
+                    }
+                });
             });
         }
         return do_until([this] { return is_end_of_stream() || is_buffer_full(); }, [this] {
@@ -479,15 +518,26 @@ void mp_row_consumer_reader::on_next_partition(dht::decorated_key key, tombstone
     _sst->get_stats().on_partition_read();
 }
 
+// Drops the partitions of the shards which released the sstable, see
+// sstable::load_released_owners().
+static flat_mutation_reader skip_released_partitions(shared_sstable sst, flat_mutation_reader rd) {
+    if (!sst->has_released_owners()) {
+        return rd;
+    }
+    return make_filtering_reader(std::move(rd), [sst = std::move(sst)] (const dht::decorated_key& dk) {
+        return !sst->is_released(dk.token());
+    });
+}
+
 flat_mutation_reader sstable::read_rows_flat(schema_ptr schema, reader_permit permit, const io_priority_class& pc,
         streamed_mutation::forwarding fwd) {
     get_stats().on_sstable_partition_read();
     if (_version == version_types::mc) {
-        return make_flat_mutation_reader<sstable_mutation_reader<data_consume_rows_context_m, mp_row_consumer_m>>(
-            shared_from_this(), std::move(schema), std::move(permit), pc, tracing::trace_state_ptr(), fwd, default_read_monitor());
+        return skip_released_partitions(shared_from_this(), make_flat_mutation_reader<sstable_mutation_reader<data_consume_rows_context_m, mp_row_consumer_m>>(
+            shared_from_this(), std::move(schema), std::move(permit), pc, tracing::trace_state_ptr(), fwd, default_read_monitor()));
     }
-    return make_flat_mutation_reader<sstable_mutation_reader<>>(shared_from_this(), std::move(schema), std::move(permit), pc,
-            tracing::trace_state_ptr(), fwd, default_read_monitor());
+    return skip_released_partitions(shared_from_this(), make_flat_mutation_reader<sstable_mutation_reader<>>(shared_from_this(), std::move(schema), std::move(permit), pc,
+            tracing::trace_state_ptr(), fwd, default_read_monitor()));
 }
 
 flat_mutation_reader
@@ -502,12 +552,12 @@ sstables::sstable::read_row_flat(schema_ptr schema,
 {
     get_stats().on_single_partition_read();
     if (_version == version_types::mc) {
-        return make_flat_mutation_reader<sstable_mutation_reader<data_consume_rows_context_m, mp_row_consumer_m>>(
+        return skip_released_partitions(shared_from_this(), make_flat_mutation_reader<sstable_mutation_reader<data_consume_rows_context_m, mp_row_consumer_m>>(
             shared_from_this(), std::move(schema), std::move(permit), std::move(key), slice, pc,
-            std::move(trace_state), fwd, mutation_reader::forwarding::no, mon);
+            std::move(trace_state), fwd, mutation_reader::forwarding::no, mon));
     }
-    return make_flat_mutation_reader<sstable_mutation_reader<>>(shared_from_this(), std::move(schema), std::move(permit), std::move(key), slice, pc,
-            std::move(trace_state), fwd, mutation_reader::forwarding::no, mon);
+    return skip_released_partitions(shared_from_this(), make_flat_mutation_reader<sstable_mutation_reader<>>(shared_from_this(), std::move(schema), std::move(permit), std::move(key), slice, pc,
+            std::move(trace_state), fwd, mutation_reader::forwarding::no, mon));
 }
 
 flat_mutation_reader
@@ -522,11 +572,11 @@ sstable::read_range_rows_flat(schema_ptr schema,
                          read_monitor& mon) {
     get_stats().on_range_partition_read();
     if (_version == version_types::mc) {
-        return make_flat_mutation_reader<sstable_mutation_reader<data_consume_rows_context_m, mp_row_consumer_m>>(
-            shared_from_this(), std::move(schema), std::move(permit), range, slice, pc, std::move(trace_state), fwd, fwd_mr, mon);
+        return skip_released_partitions(shared_from_this(), make_flat_mutation_reader<sstable_mutation_reader<data_consume_rows_context_m, mp_row_consumer_m>>(
+            shared_from_this(), std::move(schema), std::move(permit), range, slice, pc, std::move(trace_state), fwd, fwd_mr, mon));
     }
-    return make_flat_mutation_reader<sstable_mutation_reader<>>(
-        shared_from_this(), std::move(schema), std::move(permit), range, slice, pc, std::move(trace_state), fwd, fwd_mr, mon);
+    return skip_released_partitions(shared_from_this(), make_flat_mutation_reader<sstable_mutation_reader<>>(
+        shared_from_this(), std::move(schema), std::move(permit), range, slice, pc, std::move(trace_state), fwd, fwd_mr, mon));
 }
 
 }
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <seastar/core/byteorder.hh>
+
+#include "sstables/partitioned_filter.hh"
+#include "sstables/sstables.hh"
+#include "sstables/exceptions.hh"
+#include "utils/bloom_filter.hh"
+
+namespace sstables {
+
+using utils::filter::split_block_bloom_filter;
+
+partitioned_filter::partitioned_filter(file f, uint64_t words, filter_partition_cache& cache)
+    : _state(make_lw_shared<state>(std::move(f), cache))
+    , _words(words)
+    , _blocks(words / split_block_bloom_filter::words_per_block)
+{ }
+
+partitioned_filter::~partitioned_filter() {
+    auto st = _state;
+    st->closed = true;
+    st->cache.invalidate(st->id);
+    // Registered as background job.
+    (void)st->gate.close().then([st] {
+        return st->f.close();
+    }).handle_exception([st, op = background_jobs().start()] (auto ep) {
+        sstlog.warn("sstable close filter file failed: {}", ep);
+    });
+}
+
+future<> partitioned_filter::load_partition(uint64_t idx) {
+    auto st = _state;
+    if (st->closed || !st->loading.insert(idx).second) {
+        return make_ready_future<>();
+    }
+    auto first_word = idx * words_per_partition;
+    auto nr_words = std::min(words_per_partition, _words - first_word);
+    return with_gate(st->gate, [st, idx, first_word, nr_words] {
+        auto pos = words_offset + first_word * sizeof(uint64_t);
+        return st->f.dma_read_exactly<char>(pos, nr_words * sizeof(uint64_t)).then([st, idx, nr_words] (temporary_buffer<char> buf) {
+            auto words = std::make_unique<uint64_t[]>(nr_words);
+            for (uint64_t i = 0; i < nr_words; ++i) {
+                words[i] = read_be<uint64_t>(buf.get() + i * sizeof(uint64_t));
+            }
+            if (!st->closed) {
+                st->cache.populate(st->id, idx, std::move(words), nr_words);
+            }
+        });
+    }).finally([st, idx] {
+        st->loading.erase(idx);
+    });
+}
+
+void partitioned_filter::add(const bytes_view& key) {
+    throw std::logic_error("partitioned_filter is read-only");
+}
+
+bool partitioned_filter::is_present(const bytes_view& key) {
+    return is_present(utils::make_hashed_key(key));
+}
+
+bool partitioned_filter::is_present(utils::hashed_key key) {
+    auto block = split_block_bloom_filter::block_of(key, _blocks);
+    auto first_word = block * split_block_bloom_filter::words_per_block;
+    auto idx = first_word / words_per_partition;
+    if (auto words = _state->cache.find(_state->id, idx)) {
+        return split_block_bloom_filter::block_contains(words + first_word % words_per_partition, key);
+    }
+    // Registered as background job.
+    (void)load_partition(idx).handle_exception([op = background_jobs().start()] (auto ep) {
+        sstlog.warn("failed to load filter partition: {}", ep);
+    });
+    return true;
+}
+
+size_t partitioned_filter::memory_size() {
+    return sizeof(*this) + sizeof(state);
+}
+
+future<utils::filter_ptr> make_partitioned_filter(file f, filter_partition_cache& cache) {
+    return f.size().then([f, &cache] (uint64_t size) mutable {
+        return f.dma_read_exactly<char>(0, partitioned_filter::words_offset).then([f, size, &cache] (temporary_buffer<char> header) mutable {
+            auto words = read_be<uint32_t>(header.get() + sizeof(uint32_t));
+            if (!words || words % split_block_bloom_filter::words_per_block
+                    || size != partitioned_filter::words_offset + uint64_t(words) * sizeof(uint64_t)) {
+                throw malformed_sstable_exception(format("Invalid split-block filter: {:d} words in a {:d} bytes file", words, size));
+            }
+            return utils::filter_ptr(std::make_unique<partitioned_filter>(std::move(f), words, cache));
+        });
+    }).handle_exception([f] (std::exception_ptr ep) mutable {
+        return f.close().then_wrapped([ep] (future<> close_f) {
+            close_f.ignore_ready_future();
+            return make_exception_future<utils::filter_ptr>(ep);
+        });
+    });
+}
+
+}
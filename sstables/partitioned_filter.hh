@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <unordered_set>
+
+#include <seastar/core/file.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/shared_ptr.hh>
+
+#include "seastarx.hh"
+#include "utils/i_filter.hh"
+#include "sstables/filter_partition_cache.hh"
+
+namespace sstables {
+
+// A split-block Bloom filter whose bitmap stays on disk.
+//
+// Filter.db holds the number of hashes, the number of 64-bit words of the
+// bitmap and the words themselves, big-endian. A key only touches the block
+// it maps to, and consecutive blocks cover consecutive token ranges, so the
+// bitmap is split into fixed-size partitions, each covering a token range,
+// which are read on demand into a filter_partition_cache. Partitions have a
+// fixed size, so the directory locating them in the file is the number of
+// words alone and is all that stays resident.
+//
+// is_present() can't wait for I/O. A probe which falls into a partition that
+// isn't cached starts loading it in the background and reports the key as
+// possibly present, which costs an index lookup but is never wrong.
+class partitioned_filter final : public utils::i_filter {
+public:
+    static constexpr size_t partition_size = 64 << 10;
+    static constexpr uint64_t words_offset = 2 * sizeof(uint32_t);
+    static constexpr uint64_t words_per_partition = partition_size / sizeof(uint64_t);
+private:
+    struct state {
+        file f;
+        filter_partition_cache& cache;
+        filter_partition_cache::filter_id id;
+        std::unordered_set<uint64_t> loading;
+        seastar::gate gate;
+        bool closed = false;
+
+        state(file f, filter_partition_cache& cache)
+            : f(std::move(f)), cache(cache), id(cache.new_filter_id()) { }
+    };
+    lw_shared_ptr<state> _state;
+    uint64_t _words;
+    uint64_t _blocks;
+public:
+    // f is closed when the filter is destroyed.
+    partitioned_filter(file f, uint64_t words, filter_partition_cache& cache);
+    ~partitioned_filter();
+
+    uint64_t partitions() const {
+        return (_words + words_per_partition - 1) / words_per_partition;
+    }
+
+    // Reads a partition into the cache, unless it is being loaded already.
+    future<> load_partition(uint64_t idx);
+
+    virtual void add(const bytes_view& key) override;
+    virtual bool is_present(const bytes_view& key) override;
+    virtual bool is_present(utils::hashed_key key) override;
+    virtual void clear() override { }
+    virtual void close() override { }
+    virtual size_t memory_size() override;
+};
+
+// Reads the header of a split-block filter from Filter.db and returns a
+// partitioned_filter for it.
+future<utils::filter_ptr> make_partitioned_filter(file f, filter_partition_cache& cache);
+
+}
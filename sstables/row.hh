@@ -45,6 +45,7 @@
 #include "tombstone.hh"
 #include "m_format_read_helpers.hh"
 
+#include <array>
 #include <variant>
 
 // sstables::data_consume_row feeds the contents of a single row into a
@@ -206,6 +207,13 @@ class consumer_m {
     virtual proceed consume_counter_column(const sstables::column_translation::column_info& column_info,
                                            bytes_view value, api::timestamp_type timestamp) = 0;
 
+    // Returns false if the values of the given simple, non-counter column
+    // are not needed. The parser then skips them and passes empty values to
+    // consume_column(), so the cells still carry their liveness.
+    virtual bool is_column_value_needed(const sstables::column_translation::column_info& column_info, bool is_static) const {
+        return true;
+    }
+
     virtual proceed consume_range_tombstone(const std::vector<temporary_buffer<char>>& ecp,
                                             bound_kind kind,
                                             tombstone tomb) = 0;
@@ -610,6 +618,7 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
         COLUMN_TTL_2,
         COLUMN_CELL_PATH,
         COLUMN_VALUE,
+        COLUMN_VALUE_SKIP,
         COLUMN_END,
         RANGE_TOMBSTONE_MARKER,
         RANGE_TOMBSTONE_KIND,
@@ -651,6 +660,9 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
 
         // Represents the subset of _all_columns present in current row
         boost::dynamic_bitset<uint64_t> _columns_selector; // size() == _columns.size()
+
+        // The subset of _all_columns whose values are skipped
+        boost::dynamic_bitset<uint64_t> _skipped_values;
     };
 
     row_schema _regular_row;
@@ -693,9 +705,16 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
         _row = &rs;
         _row->_columns = _row->_all_columns;
     }
-    void setup_columns(row_schema& rs, const std::vector<column_translation::column_info>& columns) {
+    void setup_columns(row_schema& rs, const std::vector<column_translation::column_info>& columns, bool is_static) {
         rs._all_columns = boost::make_iterator_range(columns);
         rs._columns_selector = boost::dynamic_bitset<uint64_t>(columns.size());
+        rs._skipped_values = boost::dynamic_bitset<uint64_t>(columns.size());
+        for (size_t i = 0; i < columns.size(); ++i) {
+            auto& c = columns[i];
+            if (!c.is_collection && !c.is_counter && !_consumer.is_column_value_needed(c, is_static)) {
+                rs._skipped_values.set(i);
+            }
+        }
     }
     void skip_absent_columns() {
         size_t pos = _row->_columns_selector.find_first();
@@ -712,8 +731,61 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
                                                                                   : next_pos - current_pos;
         _row->_columns.advance_begin(jump_to_next);
     }
+    // Decodes the timestamp, local deletion time and ttl of a cell in one
+    // batch. Returns false, consuming nothing, if the buffer doesn't hold all
+    // of them; they are then read one by one.
+    bool read_cell_header(temporary_buffer<char>& data) {
+        const bool has_timestamp = !_column_flags.use_row_timestamp();
+        const bool has_expiry = !_column_flags.use_row_ttl() && (_column_flags.is_deleted() || _column_flags.is_expiring());
+        const bool has_ttl = !_column_flags.use_row_ttl() && _column_flags.is_expiring();
+        const size_t count = size_t(has_timestamp) + size_t(has_expiry) + size_t(has_ttl);
+        if (count < 2) {
+            return false;
+        }
+        std::array<uint64_t, 3> values;
+        auto r = unsigned_vint::deserialize_batch(
+                bytes_view(reinterpret_cast<const bytes::value_type*>(data.get()), data.size()), values.data(), count);
+        if (r.values != count) {
+            return false;
+        }
+        data.trim_front(r.bytes);
+        auto value = values.begin();
+        _column_timestamp = has_timestamp ? parse_timestamp(_header, *value++) : _liveness.timestamp();
+        if (has_expiry) {
+            _column_local_deletion_time = parse_expiry(_header, *value++);
+        } else if (_column_flags.use_row_ttl()) {
+            _column_local_deletion_time = _liveness.local_deletion_time();
+        } else {
+            _column_local_deletion_time = gc_clock::time_point::max();
+        }
+        if (has_ttl) {
+            _column_ttl = parse_ttl(_header, *value++);
+        } else if (_column_flags.use_row_ttl()) {
+            _column_ttl = _liveness.ttl();
+        } else {
+            _column_ttl = gc_clock::duration::zero();
+        }
+        return true;
+    }
+    // Flips the selector bits of as many listed columns as the buffer holds,
+    // decoding their indices in batches. Returns false if it holds none.
+    bool read_missing_columns(temporary_buffer<char>& data) {
+        std::array<uint64_t, 16> indices;
+        auto r = unsigned_vint::deserialize_batch(
+                bytes_view(reinterpret_cast<const bytes::value_type*>(data.get()), data.size()),
+                indices.data(), std::min<uint64_t>(_missing_columns_to_read, indices.size()));
+        data.trim_front(r.bytes);
+        _missing_columns_to_read -= r.values;
+        for (size_t i = 0; i < r.values; ++i) {
+            _row->_columns_selector.flip(indices[i]);
+        }
+        return r.values != 0;
+    }
     bool is_column_simple() const { return !_row->_columns.front().is_collection; }
     bool is_column_counter() const { return _row->_columns.front().is_counter; }
+    bool is_column_value_skipped() const {
+        return _row->_skipped_values.test(_row->_columns_selector.size() - _row->_columns.size());
+    }
     const column_translation::column_info& get_column_info() const {
         return _row->_columns.front();
     }
@@ -1058,6 +1130,10 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
         case state::COLUMN_FLAGS:
             _column_flags = column_flags_m(_u8);
 
+            if (read_cell_header(data)) {
+                _state = state::COLUMN_VALUE;
+                goto column_cell_path_label;
+            }
             if (_column_flags.use_row_timestamp()) {
                 _column_timestamp = _liveness.timestamp();
                 _state = state::COLUMN_DELETION_TIME;
@@ -1120,6 +1196,18 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
                 _state = state::COLUMN_END;
                 goto column_end_label;
             }
+            if (is_column_value_skipped()) {
+                _column_value = temporary_buffer<char>(0);
+                if (auto len = get_column_value_length()) {
+                    _u64 = *len;
+                    goto column_value_skip_label;
+                }
+                if (read_unsigned_vint(data) != read_status::ready) {
+                    _state = state::COLUMN_VALUE_SKIP;
+                    break;
+                }
+                goto column_value_skip_label;
+            }
             read_status status = read_status::waiting;
             if (auto len = get_column_value_length()) {
                 status = read_bytes(data, *len, _column_value);
@@ -1130,6 +1218,16 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
                 _state = state::COLUMN_END;
                 break;
             }
+            goto column_end_label;
+        }
+        case state::COLUMN_VALUE_SKIP:
+        column_value_skip_label:
+        {
+            _state = state::COLUMN_END;
+            auto result = skip(data, static_cast<uint32_t>(_u64));
+            if (result != consumer_m::proceed::yes) {
+                return result;
+            }
         }
         case state::COLUMN_END:
         column_end_label:
@@ -1193,6 +1291,9 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
                 skip_absent_columns();
                 goto column_label;
             }
+            if (read_missing_columns(data)) {
+                goto row_body_missing_columns_read_columns_label;
+            }
             --_missing_columns_to_read;
             if (read_unsigned_vint(data) != read_status::ready) {
                 _state = state::ROW_BODY_MISSING_COLUMNS_READ_COLUMNS_2;
@@ -1351,8 +1452,8 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
         , _column_translation(sst->get_column_translation(s, _header))
         , _has_shadowable_tombstones(sst->has_shadowable_tombstones())
     {
-        setup_columns(_regular_row, _column_translation.regular_columns());
-        setup_columns(_static_row, _column_translation.static_columns());
+        setup_columns(_regular_row, _column_translation.regular_columns(), false);
+        setup_columns(_static_row, _column_translation.static_columns(), true);
     }
 
     void verify_end_state() {
@@ -137,7 +137,6 @@ size_tiered_compaction_strategy::get_sstables_for_compaction(column_family& cfs,
     // make local copies so they can't be changed out from under us mid-method
     int min_threshold = cfs.min_compaction_threshold();
     int max_threshold = cfs.schema()->max_compaction_threshold();
-    auto gc_before = gc_clock::now() - cfs.schema()->gc_grace_seconds();
 
     // TODO: Add support to filter cold sstables (for reference: SizeTieredCompactionStrategy::filterColdSSTables).
 
@@ -154,25 +153,7 @@ size_tiered_compaction_strategy::get_sstables_for_compaction(column_family& cfs,
         return sstables::compaction_descriptor(std::move(most_interesting));
     }
 
-    // if there is no sstable to compact in standard way, try compacting single sstable whose droppable tombstone
-    // ratio is greater than threshold.
-    // prefer oldest sstables from biggest size tiers because they will be easier to satisfy conditions for
-    // tombstone purge, i.e. less likely to shadow even older data.
-    for (auto&& sstables : buckets | boost::adaptors::reversed) {
-        // filter out sstables which droppable tombstone ratio isn't greater than the defined threshold.
-        auto e = boost::range::remove_if(sstables, [this, &gc_before] (const sstables::shared_sstable& sst) -> bool {
-            return !worth_dropping_tombstones(sst, gc_before);
-        });
-        sstables.erase(e, sstables.end());
-        if (sstables.empty()) {
-            continue;
-        }
-        // find oldest sstable from current tier
-        auto it = std::min_element(sstables.begin(), sstables.end(), [] (auto& i, auto& j) {
-            return i->get_stats_metadata().min_timestamp < j->get_stats_metadata().min_timestamp;
-        });
-        return sstables::compaction_descriptor({ *it });
-    }
+    // If there is no sstable to compact in standard way, compaction_strategy falls back to a tombstone compaction.
     return sstables::compaction_descriptor();
 }
 
@@ -23,6 +23,8 @@
 #include <vector>
 #include <typeinfo>
 #include <limits>
+#include <atomic>
+#include <algorithm>
 #include <seastar/core/future.hh>
 #include <seastar/core/future-util.hh>
 #include <seastar/core/sstring.hh>
@@ -33,6 +35,7 @@
 #include <seastar/core/thread.hh>
 #include <seastar/core/shared_future.hh>
 #include <seastar/core/byteorder.hh>
+#include <seastar/core/align.hh>
 #include <iterator>
 
 #include "dht/sharder.hh"
@@ -51,6 +54,7 @@
 #include "range.hh"
 #include "downsampling.hh"
 #include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/range/adaptor/map.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/range/algorithm_ext/insert.hpp>
@@ -63,6 +67,7 @@
 #include "counters.hh"
 #include "binary_search.hh"
 #include "utils/bloom_filter.hh"
+#include "utils/xor_filter.hh"
 #include "utils/memory_data_sink.hh"
 
 #include "checked-file-impl.hh"
@@ -74,6 +79,10 @@
 #include "db/config.hh"
 #include "sstables/random_access_reader.hh"
 #include "sstables/sstables_manager.hh"
+#include "sstables/index_page_cache.hh"
+#include "sstables/partitioned_filter.hh"
+#include "sstables/trie_index.hh"
+#include "lister.hh"
 #include "utils/UUID_gen.hh"
 #include "database.hh"
 #include <boost/algorithm/string/predicate.hpp>
@@ -569,14 +578,12 @@ future<> parse(const schema& schema, sstable_version_types v, random_access_read
                         check_buf_size(buf, entrysize);
 
                         auto keysize = entrysize - 8;
-                        auto key_data = s.add_summary_data(bytes_view(reinterpret_cast<const int8_t*>(buf.get()), keysize));
-                        buf.trim_front(keysize);
+                        auto key_data = bytes_view(reinterpret_cast<const int8_t*>(buf.get()), keysize);
 
                         // position is little-endian encoded
-                        auto position = seastar::read_le<uint64_t>(buf.get());
+                        auto position = seastar::read_le<uint64_t>(buf.get() + keysize);
                         auto token = schema.get_partitioner().get_token(key_view(key_data));
-                        s.add_summary_data(token.data());
-                        s.entries.push_back({ token, key_data, position });
+                        s.entries.push_back(token, key_data, position);
                         return make_ready_future<>();
                     });
                 });
@@ -592,7 +599,7 @@ inline void write(sstable_version_types v, file_writer& out, const summary_entry
     // FIXME: summary entry is supposedly written in memory order, but that
     // would prevent portability of summary file between machines of different
     // endianness. We can treat it as little endian to preserve portability.
-    write(v, out, entry.key);
+    write(v, out, bytes_view(entry.key));
     auto p = seastar::cpu_to_le<uint64_t>(entry.position);
     out.write(reinterpret_cast<const char*>(&p), sizeof(p));
 }
@@ -608,17 +615,19 @@ inline void write(sstable_version_types v, file_writer& out, const summary& s) {
         auto p = seastar::cpu_to_le(e);
         out.write(reinterpret_cast<const char*>(&p), sizeof(p));
     }
-    write(v, out, s.entries);
+    for (auto& e : s.entries) {
+        write(v, out, e);
+    }
     write(v, out, s.first_key, s.last_key);
 }
 
-future<summary_entry&> sstable::read_summary_entry(size_t i) {
+future<summary_entry> sstable::read_summary_entry(size_t i) {
     // The last one is the boundary marker
     if (i >= (_components->summary.entries.size())) {
         throw std::out_of_range(format("Invalid Summary index: {:d}", i));
     }
 
-    return make_ready_future<summary_entry&>(_components->summary.entries[i]);
+    return make_ready_future<summary_entry>(_components->summary.entries[i]);
 }
 
 future<> parse(const schema& s, sstable_version_types v, random_access_reader& in, deletion_time& d) {
@@ -1032,6 +1041,40 @@ void sstable::write_digest(uint32_t full_checksum) {
     w.close();
 }
 
+future<uint32_t> sstable::read_digest() {
+    auto file_path = filename(component_type::Digest);
+    sstlog.debug("Reading Digest file {} ", file_path);
+
+    return new_sstable_component_file(_read_error_handler, component_type::Digest, open_flags::ro).then([file_path] (file f) {
+        auto bufptr = allocate_aligned_buffer<char>(4096, 4096);
+        auto fut = f.dma_read(0, bufptr.get(), 4096);
+        return std::move(fut).then([bufptr = std::move(bufptr), file_path] (size_t size) {
+            std::string_view digest(bufptr.get(), size);
+            try {
+                return boost::lexical_cast<uint32_t>(boost::trim_copy(std::string(digest)));
+            } catch (boost::bad_lexical_cast&) {
+                throw malformed_sstable_exception(format("Invalid digest: {}", digest), file_path);
+            }
+        }).finally([f] () mutable {
+            return f.close();
+        });
+    });
+}
+
+future<> sstable::verify_full_checksum(uint32_t full_checksum) {
+    return read_digest().then([this, full_checksum] (uint32_t digest) {
+        _stats.on_digest_verification();
+        if (digest == full_checksum) {
+            return;
+        }
+        _stats.on_digest_mismatch();
+        _quarantined = true;
+        auto msg = format("Data file checksum {:d} doesn't match digest {:d}, quarantining the sstable", full_checksum, digest);
+        sstlog.error("{}: {}", get_filename(), msg);
+        throw malformed_sstable_exception(msg, get_filename());
+    });
+}
+
 thread_local std::array<std::vector<int>, downsampling::BASE_SAMPLING_LEVEL> downsampling::_sample_pattern_cache;
 thread_local std::array<std::vector<int>, downsampling::BASE_SAMPLING_LEVEL> downsampling::_original_index_cache;
 
@@ -1380,21 +1423,94 @@ future<> sstable::create_data() {
     });
 }
 
+// Stands in for the filter of a sstable loaded with a deferred filter, until
+// the real one is read in the background. Shareable components are read by
+// other shards, so the filter is published with an atomic flag.
+class deferred_filter final : public utils::i_filter {
+public:
+    struct state {
+        utils::filter_ptr filter;
+        std::atomic<bool> loaded = {false};
+    };
+private:
+    lw_shared_ptr<state> _state = make_lw_shared<state>();
+    bool loaded() const {
+        return _state->loaded.load(std::memory_order_acquire);
+    }
+public:
+    lw_shared_ptr<state> get_state() const {
+        return _state;
+    }
+    virtual void add(const bytes_view& key) override {
+        throw std::logic_error("deferred_filter is read-only");
+    }
+    virtual bool is_present(const bytes_view& key) override {
+        return !loaded() || _state->filter->is_present(key);
+    }
+    virtual bool is_present(utils::hashed_key key) override {
+        return !loaded() || _state->filter->is_present(key);
+    }
+    virtual void clear() override { }
+    virtual void close() override { }
+    virtual size_t memory_size() override {
+        return loaded() ? _state->filter->memory_size() : 0;
+    }
+};
+
 future<> sstable::read_filter(const io_priority_class& pc) {
     if (!has_component(component_type::Filter)) {
         _components->filter = std::make_unique<utils::filter::always_present_filter>();
         return make_ready_future<>();
     }
 
-    return seastar::async([this, &pc] () mutable {
+    return load_filter(pc, features().is_enabled(sstable_feature::XorFilter), features().is_enabled(sstable_feature::SplitBlockBloomFilter)).then([this] (utils::filter_ptr filter) {
+        _components->filter = std::move(filter);
+    });
+}
+
+// Doesn't use the components, so that it can run after
+// load_shared_components() moved them away.
+future<utils::filter_ptr> sstable::load_filter(const io_priority_class& pc, bool xor_filter, bool split_block_filter) {
+    return seastar::async([this, &pc, xor_filter, split_block_filter] () mutable -> utils::filter_ptr {
+        auto cache = _manager.get_filter_partition_cache();
+        if (cache && split_block_filter) {
+            auto f = new_sstable_component_file(_read_error_handler, component_type::Filter, open_flags::ro).get0();
+            if (f.size().get0() > partitioned_filter::words_offset + partitioned_filter::partition_size) {
+                return make_partitioned_filter(std::move(f), *cache).get0();
+            }
+            f.close().get();
+        }
         sstables::filter filter;
         read_simple<component_type::Filter>(filter, pc).get();
+        if (xor_filter) {
+            return utils::filter::create_xor_filter(filter.hashes, std::move(filter.buckets.elements));
+        }
         auto nr_bits = filter.buckets.elements.size() * std::numeric_limits<typename decltype(filter.buckets.elements)::value_type>::digits;
         large_bitset bs(nr_bits, std::move(filter.buckets.elements));
         utils::filter_format format = (_version == sstable_version_types::mc)
                                       ? utils::filter_format::m_format
                                       : utils::filter_format::k_l_format;
-        _components->filter = utils::filter::create_filter(filter.hashes, std::move(bs), format);
+        if (split_block_filter) {
+            format = utils::filter_format::split_block_format;
+        }
+        return utils::filter::create_filter(filter.hashes, std::move(bs), format);
+    });
+}
+
+void sstable::load_filter_in_background(const io_priority_class& pc) {
+    auto deferred = std::make_unique<deferred_filter>();
+    auto state = deferred->get_state();
+    _components->filter = std::move(deferred);
+    auto xor_filter = features().is_enabled(sstable_feature::XorFilter);
+    auto split_block_filter = features().is_enabled(sstable_feature::SplitBlockBloomFilter);
+    // Registered as background job.
+    (void)with_semaphore(_manager.deferred_filter_load_sem(), 1, [sst = shared_from_this(), state, &pc, xor_filter, split_block_filter] {
+        return sst->load_filter(pc, xor_filter, split_block_filter).then([state] (utils::filter_ptr filter) {
+            state->filter = std::move(filter);
+            state->loaded.store(true, std::memory_order_release);
+        });
+    }).handle_exception([name = get_filename(), op = background_jobs().start()] (auto ep) {
+        sstlog.warn("Failed to load the filter of {}, all keys will be considered present: {}", name, ep);
     });
 }
 
@@ -1403,7 +1519,14 @@ void sstable::write_filter(const io_priority_class& pc) {
         return;
     }
 
-    auto f = static_cast<utils::filter::murmur3_bloom_filter *>(_components->filter.get());
+    if (auto xf = dynamic_cast<utils::filter::xor_filter*>(_components->filter.get())) {
+        // The key set is complete now, so the static filter can be built.
+        xf->build();
+        write_simple<component_type::Filter>(sstables::filter_ref(xf->fingerprint_bits(), xf->words()), pc);
+        return;
+    }
+
+    auto f = static_cast<utils::filter::bloom_filter *>(_components->filter.get());
 
     auto&& bs = f->bits();
     auto filter_ref = sstables::filter_ref(f->num_hashes(), bs.get_storage());
@@ -1412,17 +1535,21 @@ void sstable::write_filter(const io_priority_class& pc) {
 
 // This interface is only used during tests, snapshot loading and early initialization.
 // No need to set tunable priorities for it.
-future<> sstable::load(const io_priority_class& pc) {
-    return read_toc().then([this, &pc] {
+future<> sstable::load(const io_priority_class& pc, bool defer_filter) {
+    return read_toc().then([this, &pc, defer_filter] {
         // read scylla-meta after toc. Might need it to parse
         // rest (hint extensions)
-        return read_scylla_metadata(pc).then([this, &pc] {
+        return read_scylla_metadata(pc).then([this, &pc, defer_filter] {
             // Read statistics ahead of others - if summary is missing
             // we'll attempt to re-generate it and we need statistics for that
-            return read_statistics(pc).then([this, &pc] {
+            return read_statistics(pc).then([this, &pc, defer_filter] {
+                auto filter_deferred = defer_filter && has_component(component_type::Filter);
+                if (filter_deferred) {
+                    load_filter_in_background(pc);
+                }
                 return seastar::when_all_succeed(
                         read_compression(pc),
-                        read_filter(pc),
+                        filter_deferred ? make_ready_future<>() : read_filter(pc),
                         read_summary(pc)).then([this] {
                             validate_min_max_metadata();
                             validate_max_local_deletion_time();
@@ -1440,6 +1567,7 @@ future<> sstable::load(sstables::foreign_sstable_open_info info) {
         _data_file = make_checked_file(_read_error_handler, info.data.to_file());
         _index_file = make_checked_file(_read_error_handler, info.index.to_file());
         _shards = std::move(info.owners);
+        _released = std::move(info.released);
         validate_min_max_metadata();
         validate_max_local_deletion_time();
         validate_partitioner();
@@ -1449,14 +1577,131 @@ future<> sstable::load(sstables::foreign_sstable_open_info info) {
 
 future<sstable_open_info> sstable::load_shared_components() {
     auto info = sstable_open_info{make_lw_shared<shareable_components>(std::move(*_components)),
-        std::move(_shards), std::move(_data_file), std::move(_index_file)};
+        std::move(_shards), std::move(_data_file), std::move(_index_file), _released};
     return make_ready_future<sstable_open_info>(std::move(info));
 }
 
+// A release log lists the shared sstables a shard released, one
+// "<shard> <shard count> <sharding ignore msb> <TOC basename>" line per sstable.
+struct released_sstable {
+    shard_id shard;
+    unsigned shard_count;
+    unsigned sharding_ignore_msb;
+    sstring toc;
+};
+
+// Must be called from a seastar thread.
+static void write_release_log(const sstring& sstdir, const std::vector<released_sstable>& released) {
+    sstring released_dir = sstdir + "/" + sstable::released_dir_basename();
+    sstring release_log = format("{}/sstables-{}.log", released_dir, utils::make_random_uuid());
+    sstring tmp_release_log = release_log + ".tmp";
+    sstlog.trace("Writing {}", tmp_release_log);
+    touch_directory(released_dir).get();
+    auto oflags = open_flags::wo | open_flags::create | open_flags::exclusive;
+    auto f = open_file_dma(tmp_release_log, oflags).get0();
+    file_output_stream_options options;
+    options.buffer_size = 4096;
+    auto w = file_writer(std::move(f), options);
+    for (const auto& r : released) {
+        auto line = format("{} {} {} {}\n", r.shard, r.shard_count, r.sharding_ignore_msb, r.toc);
+        w.write(line.c_str(), line.size());
+    }
+    w.flush();
+    w.close();
+
+    // Once flushed and closed, the temporary log file can be renamed.
+    rename_file(tmp_release_log, release_log).get();
+    // Guarantee that the log, and the released/ directory holding it, reached the disk.
+    for (auto& dir : {released_dir, sstdir}) {
+        auto dir_f = open_directory(dir).get0();
+        dir_f.flush().get();
+        dir_f.close().get();
+    }
+    sstlog.debug("{} written successfully.", release_log);
+}
+
+// Returns the contents of the release logs in sstdir, and optionally the
+// files found in the released/ directory. Must be called from a seastar thread.
+static std::vector<released_sstable> read_release_logs(const sstring& sstdir, std::vector<sstring>* files = nullptr) {
+    sstring released_dir = sstdir + "/" + sstable::released_dir_basename();
+    std::vector<released_sstable> released;
+    if (!file_exists(released_dir).get0()) {
+        return released;
+    }
+    std::vector<sstring> logs;
+    lister::scan_dir(released_dir, { directory_entry_type::regular }, [&logs, files] (fs::path dir, directory_entry de) {
+        auto path = dir / de.name;
+        if (files) {
+            files->push_back(path.native());
+        }
+        // Temporary logs are of releases which did not complete.
+        if (path.extension() == ".log") {
+            logs.push_back(path.native());
+        }
+        return make_ready_future<>();
+    }).get();
+    for (auto& log : logs) {
+        auto f = open_file_dma(log, open_flags::ro).get0();
+        auto size = f.size().get0();
+        auto in = make_file_input_stream(f);
+        auto text = in.read_exactly(size).get0();
+        in.close().get();
+        f.close().get();
+
+        sstring all(text.begin(), text.end());
+        std::vector<sstring> lines;
+        boost::split(lines, all, boost::is_any_of("\n"), boost::token_compress_on);
+        for (auto& line : lines) {
+            if (line.empty()) {
+                continue;
+            }
+            std::vector<sstring> fields;
+            boost::split(fields, line, boost::is_any_of(" "));
+            if (fields.size() != 4) {
+                throw malformed_sstable_exception(format("Invalid line in release log {}: {}", log, line));
+            }
+            released.push_back(released_sstable{shard_id(std::stoul(fields[0])), unsigned(std::stoul(fields[1])),
+                    unsigned(std::stoul(fields[2])), std::move(fields[3])});
+        }
+    }
+    return released;
+}
+
+future<> sstable::load_released_owners() {
+    return seastar::async([this] {
+        auto toc = component_basename(component_type::TOC);
+        const auto& sharder = _schema->get_sharder();
+        for (auto& r : read_release_logs(_dir)) {
+            if (r.toc != toc) {
+                continue;
+            }
+            dht::sharder released_sharder(r.shard_count, r.sharding_ignore_msb);
+            if (released_sharder == sharder) {
+                _shards.erase(std::remove(_shards.begin(), _shards.end(), r.shard), _shards.end());
+            } else {
+                sstlog.info("Shared sstable {} was released by shard {} of {} (ignore msb {}), skipping its partitions",
+                        get_filename(), r.shard, r.shard_count, r.sharding_ignore_msb);
+            }
+            auto it = std::find_if(_released.begin(), _released.end(), [&] (const released_shards& rs) { return rs.sharder == released_sharder; });
+            if (it == _released.end()) {
+                _released.push_back(released_shards{std::move(released_sharder), {}});
+                it = std::prev(_released.end());
+            }
+            it->shards.push_back(r.shard);
+        }
+    });
+}
+
+bool sstable::is_released(const dht::token& t) const {
+    return std::any_of(_released.begin(), _released.end(), [&t] (const released_shards& rs) {
+        return std::find(rs.shards.begin(), rs.shards.end(), rs.sharder.shard_of(t)) != rs.shards.end();
+    });
+}
+
 future<foreign_sstable_open_info> sstable::get_open_info() & {
     return _components.copy().then([this] (auto c) mutable {
         return foreign_sstable_open_info{std::move(c), this->get_shards_for_this_sstable(), _data_file.dup(), _index_file.dup(),
-            _generation, _version, _format};
+            _generation, _version, _format, _released};
     });
 }
 
@@ -1972,9 +2217,7 @@ void maybe_add_summary_entry(summary& s, const dht::token& token, bytes_view key
     if (data_offset >= state.next_data_offset_to_write_summary) {
         auto entry_size = 8 + 2 + key.size();  // offset + key_size.size + key.size
         state.next_data_offset_to_write_summary += state.summary_byte_cost * entry_size;
-        s.add_summary_data(token.data());
-        auto key_data = s.add_summary_data(key);
-        s.entries.push_back({ token, key_data, index_offset });
+        s.entries.push_back(token, key, index_offset);
     }
 }
 
@@ -2279,7 +2522,8 @@ void sstable_writer_k_l::prepare_file_writer()
         _writer = std::make_unique<adler32_checksummed_file_writer>(std::move(_sst._data_file), std::move(options));
     } else {
         _writer = std::make_unique<file_writer>(make_compressed_file_k_l_format_output_stream(
-                std::move(_sst._data_file), std::move(options), &_sst._components->compression, _schema.get_compressor_params()));
+                std::move(_sst._data_file), std::move(options), &_sst._components->compression,
+                _cfg.compression ? *_cfg.compression : _schema.get_compressor_params(), _cfg.writer_memory));
     }
 }
 
@@ -2347,6 +2591,8 @@ void sstable_writer_k_l::consume_end_of_stream()
     if (!_correctly_serialize_non_compound_range_tombstones) {
         features.disable(sstable_feature::NonCompoundRangeTombstones);
     }
+    features.disable(sstable_feature::SplitBlockBloomFilter);
+    features.disable(sstable_feature::XorFilter);
     run_identifier identifier{_run_identifier};
     _sst.write_scylla_metadata(_pc, _shard, std::move(features), std::move(identifier));
 
@@ -2465,7 +2711,7 @@ future<> sstable::write_components(
         auto wr = get_writer(*schema, estimated_partitions, cfg, stats, pc);
         auto validator = mutation_fragment_stream_validating_filter(format("sstable writer {}", get_filename()), *schema,
                 cfg.validate_keys);
-        mr.consume_in_thread(std::move(wr), std::move(validator), db::no_timeout);
+        mr.consume_in_thread(activity_tagging_consumer(std::move(wr), cfg.activity), std::move(validator), db::no_timeout);
     }).finally([this] {
         assert_large_data_handler_is_running();
     });
@@ -2671,6 +2917,22 @@ future<> sstable::create_links(const sstring& dir, int64_t generation) const {
     });
 }
 
+future<> sstable::create_snapshot_links(const sstring& dir) const {
+    return parallel_for_each(all_components(), [this, &dir] (auto p) {
+        auto src = sstable::filename(_dir, _schema->ks_name(), _schema->cf_name(), _version, _generation, _format, p.second);
+        auto dst = sstable::filename(dir, _schema->ks_name(), _schema->cf_name(), _version, _generation, _format, p.second);
+        return this->sstable_write_io_check(::link_file, std::move(src), std::move(dst)).then_wrapped([] (future<> f) {
+            try {
+                f.get();
+            } catch (std::system_error& e) {
+                if (e.code() != std::error_code(EEXIST, std::system_category())) {
+                    throw;
+                }
+            }
+        });
+    });
+}
+
 future<> sstable::set_generation(int64_t new_generation) {
     return create_links(_dir, new_generation).then([this] {
         return remove_file(filename(component_type::TOC)).then([this] {
@@ -2713,11 +2975,69 @@ future<> sstable::move_to_new_dir(sstring new_dir, int64_t new_generation, bool
     });
 }
 
+static future<> copy_file_contents(sstring src, sstring dst, const io_priority_class& pc) {
+    return open_file_dma(src, open_flags::ro).then([dst = std::move(dst)] (file in) {
+        return open_file_dma(dst, open_flags::wo | open_flags::create | open_flags::exclusive).then([in = std::move(in)] (file out) mutable {
+            return std::make_pair(std::move(in), std::move(out));
+        });
+    }).then([&pc] (std::pair<file, file> files) {
+        auto [in, out] = std::move(files);
+        file_input_stream_options in_opts;
+        in_opts.io_priority_class = pc;
+        file_output_stream_options out_opts;
+        out_opts.io_priority_class = pc;
+        return do_with(make_file_input_stream(std::move(in), 0, in_opts), make_file_output_stream(std::move(out), out_opts),
+                [] (input_stream<char>& in, output_stream<char>& out) {
+            return repeat([&in, &out] {
+                return in.read().then([&out] (temporary_buffer<char> buf) {
+                    if (buf.empty()) {
+                        return make_ready_future<stop_iteration>(stop_iteration::yes);
+                    }
+                    return out.write(buf.get(), buf.size()).then([] {
+                        return stop_iteration::no;
+                    });
+                });
+            }).then([&out] {
+                return out.flush();
+            }).finally([&in, &out] {
+                return when_all(in.close(), out.close()).discard_result();
+            });
+        });
+    });
+}
+
+future<> sstable::copy_to_dir(sstring dir, int64_t generation, const io_priority_class& pc) const {
+    // Like create_links(), the copy of the TOC goes in as TemporaryTOC first
+    // and is renamed to TOC once all the other components are durable.
+    auto filename_in = [this, dir, generation] (const auto& c) {
+        return sstable::filename(dir, _schema->ks_name(), _schema->cf_name(), _version, generation, _format, c);
+    };
+    return sstable_write_io_check(copy_file_contents, filename(component_type::TOC), filename_in(component_type::TemporaryTOC), pc).then([this, dir] {
+        return sstable_write_io_check(sync_directory, dir);
+    }).then([this, filename_in, &pc] {
+        return parallel_for_each(all_components(), [this, filename_in, &pc] (auto p) {
+            if (p.first == component_type::TOC) {
+                return make_ready_future<>();
+            }
+            auto src = sstable::filename(_dir, _schema->ks_name(), _schema->cf_name(), _version, _generation, _format, p.second);
+            return this->sstable_write_io_check(copy_file_contents, std::move(src), filename_in(p.second), pc);
+        });
+    }).then([this, dir] {
+        return sstable_write_io_check(sync_directory, dir);
+    }).then([this, filename_in] {
+        return sstable_write_io_check([&] {
+            return engine().rename_file(filename_in(component_type::TemporaryTOC), filename_in(component_type::TOC));
+        });
+    }).then([this, dir] {
+        return sstable_write_io_check(sync_directory, dir);
+    });
+}
+
 entry_descriptor entry_descriptor::make_descriptor(sstring sstdir, sstring fname) {
     static std::regex la_mc("(la|mc)-(\\d+)-(\\w+)-(.*)");
     static std::regex ka("(\\w+)-(\\w+)-ka-(\\d+)-(.*)");
 
-    static std::regex dir(".*/([^/]*)/([^/]+)-[\\da-fA-F]+(?:/staging|/upload|/snapshots/[^/]+)?/?");
+    static std::regex dir(".*/([^/]*)/([^/]+)-[\\da-fA-F]+(?:/staging|/upload|/cold|(?:/cold)?/snapshots/[^/]+)?/?");
 
     std::smatch match;
 
@@ -2781,12 +3101,77 @@ component_type sstable::component_from_sstring(version_types v, sstring &s) {
     }
 }
 
+// Computes the full checksum of an uncompressed data file read from its
+// beginning, the counterpart of compressed streams' full_checksum_handler.
+template <typename ChecksumType>
+class full_checksum_data_source_impl : public data_source_impl {
+    data_source _src;
+    full_checksum_handler _on_full_checksum;
+    uint64_t _remaining;
+    uint32_t _full_checksum = ChecksumType::init_checksum();
+    bool _computing_full_checksum = true;
+public:
+    full_checksum_data_source_impl(data_source src, uint64_t file_size, full_checksum_handler on_full_checksum)
+        : _src(std::move(src))
+        , _on_full_checksum(std::move(on_full_checksum))
+        , _remaining(file_size)
+    { }
+    virtual future<temporary_buffer<char>> get() override {
+        return _src.get().then([this] (temporary_buffer<char> buf) {
+            if (!_computing_full_checksum) {
+                return make_ready_future<temporary_buffer<char>>(std::move(buf));
+            }
+            _full_checksum = ChecksumType::checksum(_full_checksum, buf.get(), buf.size());
+            _remaining -= std::min<uint64_t>(_remaining, buf.size());
+            // Consumers don't necessarily ask for more after the last byte.
+            if (_remaining && !buf.empty()) {
+                return make_ready_future<temporary_buffer<char>>(std::move(buf));
+            }
+            _computing_full_checksum = false;
+            return _on_full_checksum(_full_checksum).then([buf = std::move(buf)] () mutable {
+                return std::move(buf);
+            });
+        });
+    }
+    virtual future<temporary_buffer<char>> skip(uint64_t n) override {
+        _computing_full_checksum &= n == 0;
+        return _src.skip(n);
+    }
+    virtual future<> close() override {
+        return _src.close();
+    }
+};
+
+// Reads use at least one buffer of this size...
+static constexpr size_t min_read_ahead_buffer_size = 4096;
+// ...and at most this many read-ahead buffers, or max_read_ahead when
+// bypassing the cache.
+static constexpr unsigned default_read_ahead = 4;
+static constexpr unsigned max_read_ahead = 8;
+
+sstable::read_ahead_params sstable::read_ahead_for(const read_ahead_hint& hint, size_t max_buffer_size) {
+    auto buffer_size = std::clamp<size_t>(align_up<uint64_t>(hint.expected_bytes, min_read_ahead_buffer_size),
+            std::min(min_read_ahead_buffer_size, max_buffer_size), max_buffer_size);
+    auto buffers = (hint.expected_bytes + buffer_size - 1) / buffer_size;
+    if (hint.pattern == read_ahead_hint::access::point) {
+        // Most of what is read ahead of a skip is discarded, so keep a
+        // single buffer in flight when the range doesn't fit in one.
+        return {buffer_size, buffers > 1 ? 1u : 0u};
+    }
+    // Sequential reads may continue past the estimate, e.g. after a fast
+    // forward, so they always read ahead.
+    auto limit = hint.bypasses_cache ? max_read_ahead : default_read_ahead;
+    return {buffer_size, unsigned(std::clamp<uint64_t>(buffers, 2, limit + 1) - 1)};
+}
+
 input_stream<char> sstable::data_stream(uint64_t pos, size_t len, const io_priority_class& pc,
-        reader_permit permit, tracing::trace_state_ptr trace_state, lw_shared_ptr<file_input_stream_history> history) {
+        reader_permit permit, tracing::trace_state_ptr trace_state, lw_shared_ptr<file_input_stream_history> history,
+        const read_ahead_hint& hint) {
+    auto params = read_ahead_for(hint, sstable_buffer_size);
     file_input_stream_options options;
-    options.buffer_size = sstable_buffer_size;
+    options.buffer_size = params.buffer_size;
     options.io_priority_class = pc;
-    options.read_ahead = 4;
+    options.read_ahead = params.read_ahead;
     options.dynamic_adjustments = std::move(history);
 
     file f = make_tracked_file(_data_file, std::move(permit));
@@ -2794,14 +3179,42 @@ input_stream<char> sstable::data_stream(uint64_t pos, size_t len, const io_prior
         f = tracing::make_traced_file(std::move(f), std::move(trace_state), format("{}:", get_filename()));
     }
 
+    // Reads going through the whole data file, which is what compaction
+    // does, verify Digest as a side effect, without an extra scan. The 'ka'
+    // Digest may be a SHA-1 written by Cassandra, so it is not verified.
+    full_checksum_handler on_full_checksum;
+    if (pos == 0 && len >= data_size() && _version != sstable_version_types::ka && has_component(component_type::Digest)
+            && _manager.config().enable_sstable_digest_verification()) {
+        on_full_checksum = [sst = shared_from_this()] (uint32_t full_checksum) {
+            return sst->verify_full_checksum(full_checksum);
+        };
+    }
+
     input_stream<char> stream;
     if (_components->compression) {
+        // The components may be shared with other shards, so the compressor
+        // is cached in this shard's sstable object rather than with them.
+        if (!_compressor) {
+            _compressor = get_sstable_compressor(_components->compression);
+        }
         if (_version == sstable_version_types::mc) {
              return make_compressed_file_m_format_input_stream(f, &_components->compression,
-                pos, len, std::move(options));
+                pos, len, std::move(options), _compressor, std::move(on_full_checksum));
         } else {
             return make_compressed_file_k_l_format_input_stream(f, &_components->compression,
-                pos, len, std::move(options));
+                pos, len, std::move(options), _compressor, std::move(on_full_checksum));
+        }
+    }
+
+    if (on_full_checksum) {
+        auto src = make_file_data_source(f, pos, len, std::move(options));
+        auto size = data_size();
+        if (_version == sstable_version_types::mc) {
+            return input_stream<char>(data_source(std::make_unique<full_checksum_data_source_impl<crc32_utils>>(
+                    std::move(src), size, std::move(on_full_checksum))));
+        } else {
+            return input_stream<char>(data_source(std::make_unique<full_checksum_data_source_impl<adler32_utils>>(
+                    std::move(src), size, std::move(on_full_checksum))));
         }
     }
 
@@ -2809,7 +3222,8 @@ input_stream<char> sstable::data_stream(uint64_t pos, size_t len, const io_prior
 }
 
 future<temporary_buffer<char>> sstable::data_read(uint64_t pos, size_t len, const io_priority_class& pc) {
-    return do_with(data_stream(pos, len, pc, no_reader_permit(), tracing::trace_state_ptr(), {}), [len] (auto& stream) {
+    auto hint = read_ahead_hint{read_ahead_hint::access::sequential, len};
+    return do_with(data_stream(pos, len, pc, no_reader_permit(), tracing::trace_state_ptr(), {}, hint), [len] (auto& stream) {
         return stream.read_exactly(len).finally([&stream] {
             return stream.close();
         });
@@ -2912,13 +3326,181 @@ future<> sstable::mutate_sstable_level(uint32_t new_level) {
     });
 }
 
+future<> sstable::mutate_repaired_at(uint64_t repaired_at) {
+    if (!has_component(component_type::Statistics)) {
+        return make_ready_future<>();
+    }
+
+    auto entry = _components->statistics.contents.find(metadata_type::Stats);
+    if (entry == _components->statistics.contents.end()) {
+        return make_ready_future<>();
+    }
+
+    auto& p = entry->second;
+    if (!p) {
+        throw std::runtime_error("Statistics is malformed");
+    }
+    stats_metadata& s = *static_cast<stats_metadata *>(p.get());
+    if (s.repaired_at == repaired_at) {
+        return make_ready_future<>();
+    }
+
+    sstlog.debug("set repaired_at of {} from {} to {}", get_filename(), s.repaired_at, repaired_at);
+    s.repaired_at = repaired_at;
+    return seastar::async([this] {
+        rewrite_statistics(default_priority_class());
+    });
+}
+
 int sstable::compare_by_max_timestamp(const sstable& other) const {
     auto ts1 = get_stats_metadata().max_timestamp;
     auto ts2 = other.get_stats_metadata().max_timestamp;
     return (ts1 > ts2 ? 1 : (ts1 == ts2 ? 0 : -1));
 }
 
+file sstable::cached_index_file() {
+    auto cache = _manager.get_index_page_cache();
+    if (!cache) {
+        return _index_file;
+    }
+    if (!_index_cache_id) {
+        _index_cache_id = cache->new_file_id();
+    }
+    return make_cached_index_file(_index_file, *cache, *_index_cache_id, index_size());
+}
+
+future<> sstable::open_clustering_ranges() {
+    if (!_clustering_ranges_opened) {
+        auto f = open_file(component_type::ClusteringRanges, open_flags::ro).then([this] (file f) {
+            _clustering_ranges_file = f;
+            return f.size().then([f] (uint64_t size) mutable {
+                return clustering_ranges::read_summary(std::move(f), size, default_priority_class());
+            });
+        }).then_wrapped([this] (future<clustering_ranges::summary> f) {
+            try {
+                _clustering_ranges_summary = f.get0();
+            } catch (...) {
+                // Reads won't skip partitions of this sstable.
+                sstlog.warn("Failed to read {}: {}", filename(component_type::ClusteringRanges), std::current_exception());
+            }
+        });
+        _clustering_ranges_opened.emplace(std::move(f));
+    }
+    return _clustering_ranges_opened->get_future();
+}
+
+future<bool> sstable::partition_excludes_ranges(const schema& s, uint64_t data_position,
+        const query::clustering_row_ranges& ranges, const io_priority_class& pc) {
+    if (!has_component(component_type::ClusteringRanges)) {
+        return make_ready_future<bool>(false);
+    }
+    return open_clustering_ranges().then([this, &s, data_position, &ranges, &pc] {
+        if (_clustering_ranges_summary.data_positions.empty()) {
+            return make_ready_future<bool>(false);
+        }
+        // Records are cached like index pages, only lookups read them.
+        file f = _clustering_ranges_file;
+        if (auto cache = _manager.get_index_page_cache()) {
+            if (!_clustering_ranges_cache_id) {
+                _clustering_ranges_cache_id = cache->new_file_id();
+            }
+            f = make_cached_index_file(std::move(f), *cache, *_clustering_ranges_cache_id, _clustering_ranges_summary.records_end);
+        }
+        return clustering_ranges::lookup(std::move(f), _clustering_ranges_summary, data_position, pc).then_wrapped(
+                [this, &s, &ranges] (future<std::optional<clustering_ranges::partition_info>> f) {
+            try {
+                auto info = f.get0();
+                return info && info->excludes(s, ranges);
+            } catch (...) {
+                sstlog.warn("Failed to read {}: {}", filename(component_type::ClusteringRanges), std::current_exception());
+                return false;
+            }
+        });
+    });
+}
+
+future<> sstable::open_trie_index() {
+    if (!_trie_index_opened) {
+        auto f = open_file(component_type::TrieIndex, open_flags::ro).then([this] (file f) {
+            return f.size().then([this, f] (uint64_t size) mutable {
+                _trie_index_file = f;
+                // One reader serves all lookups, pages other than the root
+                // one are cached like index pages.
+                if (auto cache = _manager.get_index_page_cache()) {
+                    _trie_index_cache_id = cache->new_file_id();
+                    f = make_cached_index_file(std::move(f), *cache, *_trie_index_cache_id, size);
+                }
+                auto reader = std::make_unique<trie::index_reader>(std::move(f), size, default_priority_class());
+                return reader->open().then([this, reader = std::move(reader)] () mutable {
+                    _trie_index_reader = std::move(reader);
+                });
+            });
+        }).handle_exception([this] (std::exception_ptr ep) {
+            // Reads won't consult the trie of this sstable.
+            sstlog.warn("Failed to open {}: {}", filename(component_type::TrieIndex), ep);
+        });
+        _trie_index_opened.emplace(std::move(f));
+    }
+    return _trie_index_opened->get_future();
+}
+
+// The trie costs a lookup of its own, which only pays off when the filter
+// often lets absent partitions through. It is consulted while at least one
+// in this many filter positives of the sstable turned out false.
+static constexpr uint64_t trie_index_false_positive_ratio = 8;
+
+future<bool> sstable::trie_index_excludes(dht::token t, const io_priority_class& pc) {
+    if (!has_component(component_type::TrieIndex)) {
+        return make_ready_future<bool>(false);
+    }
+    if (_filter_tracker.false_positive * trie_index_false_positive_ratio < _filter_tracker.true_positive) {
+        // The filter already answered, the partition is most likely present.
+        return make_ready_future<bool>(false);
+    }
+    return open_trie_index().then([this, t, &pc] {
+        if (!_trie_index_reader) {
+            return make_ready_future<bool>(false);
+        }
+        return _trie_index_reader->lower_bound(t, pc).then_wrapped([this, t] (future<std::optional<trie::index_entry>> f) {
+            try {
+                auto e = f.get0();
+                return !e || e->token != dht::token::to_int64(t);
+            } catch (...) {
+                sstlog.warn("Failed to read {}: {}", filename(component_type::TrieIndex), std::current_exception());
+                return false;
+            }
+        });
+    });
+}
+
 sstable::~sstable() {
+    if (_index_cache_id) {
+        if (auto cache = _manager.get_index_page_cache()) {
+            cache->invalidate(*_index_cache_id);
+        }
+    }
+    if (_clustering_ranges_cache_id) {
+        if (auto cache = _manager.get_index_page_cache()) {
+            cache->invalidate(*_clustering_ranges_cache_id);
+        }
+    }
+    if (_trie_index_cache_id) {
+        if (auto cache = _manager.get_index_page_cache()) {
+            cache->invalidate(*_trie_index_cache_id);
+        }
+    }
+    if (_trie_index_file) {
+        // Registered as background job.
+        (void)_trie_index_file.close().handle_exception([save = _trie_index_file, op = background_jobs().start()] (auto ep) {
+            sstlog.warn("sstable close trie index file failed: {}", ep);
+        });
+    }
+    if (_clustering_ranges_file) {
+        // Registered as background job.
+        (void)_clustering_ranges_file.close().handle_exception([save = _clustering_ranges_file, op = background_jobs().start()] (auto ep) {
+            sstlog.warn("sstable close clustering ranges file failed: {}", ep);
+        });
+    }
     if (_index_file) {
         // Registered as background job.
         (void)_index_file.close().handle_exception([save = _index_file, op = background_jobs().start()] (auto ep) {
@@ -3120,7 +3702,6 @@ std::optional<std::pair<uint64_t, uint64_t>> sstable::get_sample_indexes_for_ran
 std::optional<std::pair<uint64_t, uint64_t>> sstable::get_index_pages_for_range(const dht::token_range& range) {
     const auto& entries = _components->summary.entries;
     auto entries_size = entries.size();
-    index_comparator cmp(*_schema);
     dht::ring_position_comparator rp_cmp(*_schema);
     uint64_t left = 0;
     if (range.start()) {
@@ -3136,8 +3717,7 @@ std::optional<std::pair<uint64_t, uint64_t>> sstable::get_index_pages_for_range(
             return std::nullopt;
         }
 
-        left = std::distance(std::begin(entries),
-            std::lower_bound(entries.begin(), entries.end(), pos, cmp));
+        left = entries.lower_bound(*_schema, pos);
 
         if (left) {
             --left;
@@ -3149,8 +3729,7 @@ std::optional<std::pair<uint64_t, uint64_t>> sstable::get_index_pages_for_range(
                                       ? dht::ring_position_view::ending_at(range.end()->value())
                                       : dht::ring_position_view::starting_at(range.end()->value());
 
-        right = std::distance(std::begin(entries),
-            std::lower_bound(entries.begin(), entries.end(), pos, cmp));
+        right = entries.lower_bound(*_schema, pos);
         if (right == 0) {
             // The first key is strictly greater than right.
             return std::nullopt;
@@ -3346,6 +3925,73 @@ delete_atomically(std::vector<shared_sstable> ssts) {
     });
 }
 
+// Owners of shared sstables which haven't released them yet, by TOC file name.
+// The owners which released them before a restart are not loaded again (see
+// sstable::load_released_owners()), so they are not waited for.
+// Only used on shard 0.
+static thread_local std::unordered_map<sstring, std::unordered_set<shard_id>> shared_sstable_owners;
+
+future<> release_shared_sstables(std::vector<shared_sstable> ssts) {
+    if (ssts.empty()) {
+        return make_ready_future<>();
+    }
+    return seastar::async([ssts = std::move(ssts)] {
+        auto& sstdir = ssts.front()->get_dir();
+        std::vector<released_sstable> released;
+        for (const auto& sst : ssts) {
+            // All sstables are assumed to be in the same column_family, hence
+            // sharing their base directory.
+            assert(sst->get_dir() == sstdir);
+            const auto& sharder = sst->get_schema()->get_sharder();
+            released.push_back(released_sstable{this_shard_id(), sharder.shard_count(), sharder.sharding_ignore_msb(), sst->component_basename(component_type::TOC)});
+        }
+        // A single log makes the release of all the sstables atomic, since
+        // some of them may hold the tombstones shadowing the data of others.
+        write_release_log(sstdir, released);
+
+        parallel_for_each(ssts, [] (shared_sstable sst) {
+            auto& owners = sst->get_shards_for_this_sstable();
+            return smp::submit_to(0, [toc = sst->toc_filename(), owners = std::unordered_set<shard_id>(owners.begin(), owners.end()), shard = this_shard_id()] () mutable {
+                auto it = shared_sstable_owners.try_emplace(std::move(toc), std::move(owners)).first;
+                it->second.erase(shard);
+                if (!it->second.empty()) {
+                    return false;
+                }
+                shared_sstable_owners.erase(it);
+                return true;
+            }).then([sst] (bool last) {
+                if (!last) {
+                    sstlog.debug("Released shared sstable {} on shard {}", sst->get_filename(), this_shard_id());
+                    return make_ready_future<>();
+                }
+                return delete_atomically({sst});
+            });
+        }).get();
+    });
+}
+
+future<> consolidate_release_logs(sstring sstdir) {
+    return seastar::async([sstdir = std::move(sstdir)] {
+        std::vector<sstring> files;
+        auto released = read_release_logs(sstdir, &files);
+        if (files.empty()) {
+            return;
+        }
+        // Entries of deleted sstables are dropped, so they don't apply to a
+        // later sstable of the same generation.
+        auto e = std::remove_if(released.begin(), released.end(), [&sstdir] (const released_sstable& r) {
+            return !file_exists(sstdir + "/" + r.toc).get0();
+        });
+        released.erase(e, released.end());
+        if (!released.empty()) {
+            write_release_log(sstdir, released);
+        }
+        for (auto& f : files) {
+            remove_file(f).get();
+        }
+    });
+}
+
 // FIXME: Go through maybe_delete_large_partitions_entry on recovery
 // since this is an indication we crashed in the middle of delete_atomically
 future<> replay_pending_delete_log(sstring pending_delete_log) {
@@ -3389,6 +4035,26 @@ future<> init_metrics() {
             sm::description("Index page requests which initiated a read from disk")),
         sm::make_derive("index_page_blocks", [] { return shared_index_lists::shard_stats().blocks; },
             sm::description("Index page requests which needed to wait due to page not being loaded yet")),
+        sm::make_derive("index_cache_page_hits", [] { return index_page_cache::shard_stats().page_hits; },
+            sm::description("Index file pages served from the index page cache")),
+        sm::make_derive("index_cache_page_misses", [] { return index_page_cache::shard_stats().page_misses; },
+            sm::description("Index file reads which weren't fully served from the index page cache")),
+        sm::make_derive("index_cache_page_populations", [] { return index_page_cache::shard_stats().page_populations; },
+            sm::description("Index file pages inserted into the index page cache")),
+        sm::make_derive("index_cache_page_evictions", [] { return index_page_cache::shard_stats().page_evictions; },
+            sm::description("Index file pages evicted from the index page cache")),
+        sm::make_gauge("index_cache_bytes", [] { return index_page_cache::shard_stats().bytes; },
+            sm::description("Bytes of index file pages held by the index page cache")),
+        sm::make_derive("filter_partition_cache_hits", [] { return filter_partition_cache::shard_stats().hits; },
+            sm::description("Bloom filter probes served by a cached filter partition")),
+        sm::make_derive("filter_partition_cache_misses", [] { return filter_partition_cache::shard_stats().misses; },
+            sm::description("Bloom filter probes which fell into a filter partition that wasn't cached")),
+        sm::make_derive("filter_partition_cache_populations", [] { return filter_partition_cache::shard_stats().populations; },
+            sm::description("Bloom filter partitions loaded into the filter partition cache")),
+        sm::make_derive("filter_partition_cache_evictions", [] { return filter_partition_cache::shard_stats().evictions; },
+            sm::description("Bloom filter partitions evicted from the filter partition cache")),
+        sm::make_gauge("filter_partition_cache_bytes", [] { return filter_partition_cache::shard_stats().bytes; },
+            sm::description("Bytes of Bloom filter partitions held by the filter partition cache")),
 
         sm::make_derive("partition_writes", [] { return sstables_stats::get_shard_stats().partition_writes; },
             sm::description("Number of partitions written")),
@@ -3421,6 +4087,17 @@ future<> init_metrics() {
             sm::description("Was local deletion time capped at maximum allowed value in Statistics")),
         sm::make_counter("capped_tombstone_deletion_time", [] { return sstables_stats::get_shard_stats().capped_tombstone_deletion_time; },
             sm::description("Was partition tombstone deletion time capped at maximum allowed value")),
+        sm::make_derive("clustering_ranges_partition_skips", [] { return sstables_stats::get_shard_stats().clustering_ranges_partition_skips; },
+            sm::description("Number of single partition reads which didn't read the data file since ClusteringRanges showed the slice selects nothing")),
+        sm::make_derive("trie_index_partition_skips", [] { return sstables_stats::get_shard_stats().trie_index_partition_skips; },
+            sm::description("Number of single partition reads which didn't read the index since TrieIndex showed the partition is absent")),
+        sm::make_derive("digest_verifications", [] { return sstables_stats::get_shard_stats().digest_verifications; },
+            sm::description("Number of data file full checksums verified against Digest by reads going through the whole file")),
+        sm::make_derive("digest_mismatches", [] { return sstables_stats::get_shard_stats().digest_mismatches; },
+            sm::description("Number of data files found not to match their Digest, the sstables were quarantined")),
+
+        sm::make_gauge("xor_filter_memory_saved", [] { return utils::filter::xor_filter::shard_memory_saved(); },
+            sm::description("Memory saved by xor filters when compared to Bloom filters with the same false positive rate, in bytes")),
     });
   });
 }
@@ -3488,6 +4165,8 @@ std::ostream& operator<<(std::ostream& out, const sstables::component_type& comp
     case ct::TemporaryTOC: out << "TemporaryTOC"; break;
     case ct::TemporaryStatistics: out << "TemporaryStatistics"; break;
     case ct::Scylla: out << "Scylla"; break;
+    case ct::ClusteringRanges: out << "ClusteringRanges"; break;
+    case ct::TrieIndex: out << "TrieIndex"; break;
     case ct::Unknown: out << "Unknown"; break;
     }
     return out;
@@ -30,6 +30,7 @@
 #include <seastar/core/sstring.hh>
 #include <seastar/core/enum.hh>
 #include <seastar/core/shared_ptr.hh>
+#include <seastar/core/semaphore.hh>
 #include <seastar/core/distributed.hh>
 #include <unordered_set>
 #include <unordered_map>
@@ -61,8 +62,10 @@
 #include "stats.hh"
 #include "utils/observable.hh"
 #include "sstables/shareable_components.hh"
+#include "sstables/clustering_ranges.hh"
 
 #include <seastar/util/optimized_optional.hh>
+#include <seastar/core/shared_future.hh>
 #include <boost/intrusive/list.hpp>
 
 class sstable_assertions;
@@ -75,6 +78,10 @@ namespace mc {
 class writer;
 }
 
+namespace trie {
+class index_reader;
+}
+
 namespace fs = std::filesystem;
 
 extern logging::logger sstlog;
@@ -85,6 +92,13 @@ struct foreign_sstable_open_info;
 struct sstable_open_info;
 class sstables_manager;
 
+// Shards which released a shared sstable (see release_shared_sstables()),
+// with the sharding the node ran when they did.
+struct released_shards {
+    dht::sharder sharder;
+    std::vector<shard_id> shards;
+};
+
 GCC6_CONCEPT(
 template<typename T>
 concept bool ConsumeRowsContext() {
@@ -121,8 +135,20 @@ struct sstable_writer_config {
     write_monitor* monitor = &default_write_monitor();
     bool correctly_serialize_non_compound_range_tombstones;
     bool correctly_serialize_static_compact_in_mc;
+    bool split_block_bloom_filter = false;
+    bool xor_filter = false;
+    // Write a TrieIndex component, see sstables/trie_index.hh.
+    bool trie_index = false;
     utils::UUID run_identifier = utils::make_random_uuid();
     size_t summary_byte_cost;
+    // Reactor stalls while writing are attributed to this activity.
+    utils::activity activity;
+    // Overrides the compression parameters of the schema, e.g. with the
+    // chunk length compaction chose for the adaptive mode.
+    std::optional<compression_parameters> compression;
+    // Where the memory the writer holds on top of its output buffers is taken
+    // from, see sstables_manager. Not limited if null.
+    semaphore* writer_memory = nullptr;
 
 private:
     explicit sstable_writer_config() {}
@@ -173,6 +199,29 @@ class sstable : public enable_lw_shared_from_this<sstable> {
         }
     };
 
+    // Describes how a read is expected to access the data file, so that the
+    // buffers and read-ahead of its stream can be sized, see read_ahead_for().
+    struct read_ahead_hint {
+        enum class access {
+            // Reads a small part of the range, e.g. a slice of a partition,
+            // skipping the rest.
+            point,
+            // Consumes the range in order, e.g. whole partitions or a scan.
+            sequential,
+        };
+        access pattern = access::sequential;
+        // Estimate of the bytes the read will consume, from the index.
+        uint64_t expected_bytes = 0;
+        // Reads bypassing the cache are one-off scans, for which the deepest
+        // read-ahead is worth its memory.
+        bool bypasses_cache = false;
+    };
+    struct read_ahead_params {
+        size_t buffer_size;
+        unsigned read_ahead;
+    };
+    static read_ahead_params read_ahead_for(const read_ahead_hint& hint, size_t max_buffer_size);
+
     static component_type component_from_sstring(version_types version, sstring& s);
     static version_types version_from_sstring(sstring& s);
     static format_types format_from_sstring(sstring& s);
@@ -194,12 +243,18 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // load all components from disk
     // this variant will be useful for testing purposes and also when loading
     // a new sstable from scratch for sharing its components.
-    future<> load(const io_priority_class& pc = default_priority_class());
+    // With defer_filter, the sstable is usable before its filter is read: the
+    // filter is read in the background and considers every key present until
+    // then.
+    future<> load(const io_priority_class& pc = default_priority_class(), bool defer_filter = false);
     future<> open_data();
     future<> update_info_for_opened_data();
 
     future<> set_generation(int64_t generation);
     future<> move_to_new_dir(sstring new_dir, int64_t generation, bool do_sync_dirs = true);
+    // Writes a copy of this sstable to dir under the given generation. Unlike
+    // create_links(), dir may be on a different filesystem.
+    future<> copy_to_dir(sstring dir, int64_t generation, const io_priority_class& pc) const;
 
     int64_t generation() const {
         return _generation;
@@ -322,6 +377,17 @@ class sstable : public enable_lw_shared_from_this<sstable> {
         _shared = false;
     }
 
+    // Returns true iff some of the shards owning this shared sstable already
+    // released it (see release_shared_sstables()). Reads of the sstable skip
+    // the partitions of those shards.
+    bool has_released_owners() const {
+        return !_released.empty();
+    }
+
+    // Returns true iff the partition of the token belongs to a shard which
+    // released this sstable.
+    bool is_released(const dht::token& t) const;
+
     // Returns uncompressed size of data component.
     uint64_t data_size() const;
     // Returns on-disk size of data component.
@@ -330,6 +396,17 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     uint64_t index_size() const {
         return _index_file_size;
     }
+    // The index file, read through the index page cache if it's enabled.
+    file cached_index_file();
+    // Whether reading ranges from the partition which starts at data_position
+    // in the data file yields just an empty partition, according to the
+    // ClusteringRanges component. The partition can then be produced without
+    // reading the data file. False if the sstable has no such component.
+    future<bool> partition_excludes_ranges(const schema& s, uint64_t data_position,
+            const query::clustering_row_ranges& ranges, const io_priority_class& pc);
+    // Whether no partition of this sstable has the given token, according to
+    // the TrieIndex component. False if the sstable has no such component.
+    future<bool> trie_index_excludes(dht::token t, const io_priority_class& pc);
     uint64_t filter_size() const {
         return _filter_file_size;
     }
@@ -346,6 +423,10 @@ class sstable : public enable_lw_shared_from_this<sstable> {
         return _version;
     }
 
+    format_types get_format() const {
+        return _format;
+    }
+
     // Returns the total bytes of all components.
     uint64_t bytes_on_disk() const;
 
@@ -409,6 +490,11 @@ class sstable : public enable_lw_shared_from_this<sstable> {
         return dirpath.filename().string() == pending_delete_dir_basename().c_str();
     }
 
+    // Holds the logs of the shared sstables released by some of their owners.
+    static sstring released_dir_basename() {
+        return "released";
+    }
+
     const sstring& get_dir() const {
         return _dir;
     }
@@ -431,6 +517,14 @@ class sstable : public enable_lw_shared_from_this<sstable> {
         return create_links(dir, _generation);
     }
 
+    // Links all the components into dir at once, for a snapshot. Unlike
+    // create_links(), neither orders the links nor syncs dir: a snapshot is
+    // only complete once its manifest has been written, after the caller
+    // synced the directory once for all the sstables linked into it.
+    // Components already linked into dir, e.g. by another shard sharing the
+    // sstable, are left alone.
+    future<> create_snapshot_links(const sstring& dir) const;
+
     // Delete the sstable by unlinking all sstable files
     future<> unlink();
 
@@ -477,13 +571,30 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     foreign_ptr<lw_shared_ptr<shareable_components>> _components = make_foreign(make_lw_shared<shareable_components>());
     column_translation _column_translation;
     bool _shared = true;  // across shards; safe default
+    std::vector<released_shards> _released;
     bool _open = false;
     // NOTE: _collector and _c_stats are used to generation of statistics file
     // when writing a new sstable.
     metadata_collector _collector;
     column_stats _c_stats;
     file _index_file;
+    // Identifies the index file in the index page cache, assigned on first cached read.
+    std::optional<uint64_t> _index_cache_id;
     file _data_file;
+    // Compressor shared by the data streams of this shard, see data_stream().
+    compressor_ptr _compressor;
+    // Set when a read found the data file not to match Digest.
+    bool _quarantined = false;
+    // ClusteringRanges is opened on first use, see partition_excludes_ranges().
+    std::optional<shared_future<>> _clustering_ranges_opened;
+    file _clustering_ranges_file;
+    clustering_ranges::summary _clustering_ranges_summary;
+    std::optional<uint64_t> _clustering_ranges_cache_id;
+    // TrieIndex is opened on first use, see trie_index_excludes().
+    std::optional<shared_future<>> _trie_index_opened;
+    file _trie_index_file;
+    std::optional<uint64_t> _trie_index_cache_id;
+    std::unique_ptr<trie::index_reader> _trie_index_reader;
     uint64_t _data_file_size;
     uint64_t _index_file_size;
     uint64_t _filter_file_size = 0;
@@ -570,6 +681,12 @@ class sstable : public enable_lw_shared_from_this<sstable> {
 
     void write_crc(const checksum& c);
     void write_digest(uint32_t full_checksum);
+    future<uint32_t> read_digest();
+    future<> open_clustering_ranges();
+    future<> open_trie_index();
+    // Checks the full checksum computed by a data stream which read the
+    // whole data file against Digest, quarantining the sstable on mismatch.
+    future<> verify_full_checksum(uint32_t full_checksum);
 
     future<file> rename_new_sstable_component_file(sstring from_file, sstring to_file, file fd);
     future<file> new_sstable_component_file(const io_error_handler& error_handler, component_type f, open_flags flags, file_open_options options = {});
@@ -588,6 +705,8 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     void write_scylla_metadata(const io_priority_class& pc, shard_id shard, sstable_enabled_features features, run_identifier identifier);
 
     future<> read_filter(const io_priority_class& pc);
+    future<utils::filter_ptr> load_filter(const io_priority_class& pc, bool xor_filter, bool split_block_filter);
+    void load_filter_in_background(const io_priority_class& pc);
 
     void write_filter(const io_priority_class& pc);
 
@@ -636,7 +755,8 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // about the buffer size to read, and where exactly to stop reading
     // (even when a large buffer size is used).
     input_stream<char> data_stream(uint64_t pos, size_t len, const io_priority_class& pc,
-            reader_permit permit, tracing::trace_state_ptr trace_state, lw_shared_ptr<file_input_stream_history> history);
+            reader_permit permit, tracing::trace_state_ptr trace_state, lw_shared_ptr<file_input_stream_history> history,
+            const read_ahead_hint& hint);
 
     // Read exactly the specific byte range from the data file (after
     // uncompression, if the file is compressed). This can be used to read
@@ -646,7 +766,7 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // for iteration through all the rows.
     future<temporary_buffer<char>> data_read(uint64_t pos, size_t len, const io_priority_class& pc);
 
-    future<summary_entry&> read_summary_entry(size_t i);
+    future<summary_entry> read_summary_entry(size_t i);
 
     // FIXME: pending on Bloom filter implementation
     bool filter_has_key(const schema& s, const dht::decorated_key& dk) { return filter_has_key(key::from_partition_key(s, dk._key)); }
@@ -720,6 +840,13 @@ class sstable : public enable_lw_shared_from_this<sstable> {
         return _run_identifier;
     }
 
+    // Whether a read found the data file not to match its Digest. A
+    // quarantined sstable is still readable, but is no longer selected
+    // for compaction, so that the corruption isn't spread to new sstables.
+    bool quarantined() const {
+        return _quarantined;
+    }
+
     bool has_correct_max_deletion_time() const {
         return (_version == sstable_version_types::mc) || has_scylla_component();
     }
@@ -810,6 +937,17 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // This will change sstable level only in memory.
     void set_sstable_level(uint32_t);
 
+    // Time, in milliseconds since the epoch, of the start of the incremental
+    // repair which found all of the sstable's data consistent across replicas,
+    // or 0 if it wasn't repaired.
+    uint64_t get_repaired_at() const {
+        return get_stats_metadata().repaired_at;
+    }
+
+    bool is_repaired() const {
+        return get_repaired_at() != 0;
+    }
+
     double get_compression_ratio() const;
 
     const sstables::compression& get_compression() const {
@@ -818,6 +956,9 @@ class sstable : public enable_lw_shared_from_this<sstable> {
 
     future<> mutate_sstable_level(uint32_t);
 
+    // Rewrites the Statistics component with the given repaired_at.
+    future<> mutate_repaired_at(uint64_t);
+
     const summary& get_summary() const {
         return _components->summary;
     }
@@ -835,6 +976,15 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // returns all info needed for a sstable to be shared with other shards.
     future<sstable_open_info> load_shared_components();
 
+    // Reads the releases of this shared sstable, dropping the shards which
+    // released it from its owners, so they don't load it again. Must be
+    // called after load(), before load_shared_components().
+    //
+    // A release made while the node ran a different shard count is kept
+    // too: the partitions of the released shard are then owned by other
+    // shards, which must not read them either.
+    future<> load_released_owners();
+
     sstables_stats& get_stats() {
         return _stats;
     }
@@ -852,10 +1002,10 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     friend class index_reader;
     template <typename DataConsumeRowsContext>
     friend data_consume_context<DataConsumeRowsContext>
-    data_consume_rows(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, disk_read_range, uint64_t);
+    data_consume_rows(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, disk_read_range, uint64_t, const read_ahead_hint&);
     template <typename DataConsumeRowsContext>
     friend data_consume_context<DataConsumeRowsContext>
-    data_consume_single_partition(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, disk_read_range);
+    data_consume_single_partition(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, disk_read_range, const read_ahead_hint&);
     template <typename DataConsumeRowsContext>
     friend data_consume_context<DataConsumeRowsContext>
     data_consume_rows(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&);
@@ -903,6 +1053,22 @@ future<> await_background_jobs_on_all_shards();
 future<> delete_atomically(std::vector<shared_sstable> ssts);
 future<> replay_pending_delete_log(sstring log_file);
 
+// Releases the references of the current shard to sstables shared by several
+// shards, once the shard no longer needs their data (e.g. it compacted its part
+// of them away). The last owner to release an sstable deletes it with
+// delete_atomically().
+//
+// The release is persisted in a log in the released/ directory before any
+// sstable is deleted: after a restart the shard must not load the sstables
+// again, since the sstables it wrote instead may have purged the tombstones
+// shadowing their data. So the caller must delete the other sstables the data
+// was compacted from only after the returned future resolves.
+future<> release_shared_sstables(std::vector<shared_sstable> ssts);
+
+// Merges the release logs of the sstables in sstdir into one, dropping the
+// entries of sstables which are gone.
+future<> consolidate_release_logs(sstring sstdir);
+
 struct index_sampling_state {
     static constexpr size_t default_summary_byte_cost = 2000;
 
@@ -946,6 +1112,7 @@ struct foreign_sstable_open_info {
     uint64_t generation;
     sstable::version_types version;
     sstable::format_types format;
+    std::vector<released_shards> released;
 };
 
 // can only be used locally
@@ -954,6 +1121,7 @@ struct sstable_open_info {
     std::vector<shard_id> owners;
     file data;
     file index;
+    std::vector<released_shards> released;
 };
 
 future<> init_metrics();
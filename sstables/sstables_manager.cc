@@ -19,6 +19,8 @@
  * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <seastar/core/memory.hh>
+
 #include "log.hh"
 #include "sstables/sstables_manager.hh"
 #include "sstables/sstables.hh"
@@ -33,7 +35,8 @@ logging::logger smlogger("sstables_manager");
 
 sstables_manager::sstables_manager(
     db::large_data_handler& large_data_handler, const db::config& dbcfg, gms::feature_service& feat)
-    : _large_data_handler(large_data_handler), _db_config(dbcfg), _features(feat) {
+    : _large_data_handler(large_data_handler), _db_config(dbcfg), _features(feat)
+    , _writer_memory_sem(memory::stats().total_memory() * writer_memory_percent / 100) {
 }
 
 shared_sstable sstables_manager::make_sstable(schema_ptr schema,
@@ -53,6 +56,10 @@ sstable_writer_config sstables_manager::configure_writer() const {
     cfg.promoted_index_block_size = _db_config.column_index_size_in_kb() * 1024;
     cfg.validate_keys = _db_config.enable_sstable_key_validation();
     cfg.summary_byte_cost = summary_byte_cost(_db_config.sstable_summary_ratio());
+    cfg.split_block_bloom_filter = _db_config.enable_sstables_split_block_bloom_filter();
+    cfg.xor_filter = _db_config.enable_sstables_xor_filter();
+    cfg.trie_index = _db_config.enable_sstables_trie_index();
+    cfg.writer_memory = &_writer_memory_sem;
 
     cfg.correctly_serialize_non_compound_range_tombstones =
             _features.cluster_supports_reading_correctly_serialized_range_tombstones();
@@ -24,6 +24,7 @@
 
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/sharded.hh>
+#include <seastar/core/semaphore.hh>
 
 #include "utils/disk-error-handler.hh"
 #include "gc_clock.hh"
@@ -49,12 +50,28 @@ using shareable_components_ptr = lw_shared_ptr<shareable_components>;
 
 static constexpr size_t default_sstable_buffer_size = 128 * 1024;
 
+class index_page_cache;
+class filter_partition_cache;
+
 class sstables_manager {
     db::large_data_handler& _large_data_handler;
     const db::config& _db_config;
     gms::feature_service& _features;
+    index_page_cache* _index_page_cache = nullptr;
+    filter_partition_cache* _filter_partition_cache = nullptr;
+    // Limits the filters read in the background after sstables are loaded
+    // with a deferred filter.
+    semaphore _deferred_filter_load_sem{max_concurrent_deferred_filter_loads};
+    // Memory writers hold on top of their output buffers, like compression
+    // dictionary samples and xor filter hashes. Writers which can't get it
+    // fall back to alternatives which need less memory.
+    mutable semaphore _writer_memory_sem;
 
 public:
+    static constexpr size_t max_concurrent_deferred_filter_loads = 4;
+    // Fraction of the shard's memory, in percent, given to _writer_memory_sem.
+    static constexpr size_t writer_memory_percent = 5;
+
     explicit sstables_manager(db::large_data_handler& large_data_handler, const db::config& dbcfg, gms::feature_service& feat);
 
     // Constructs a shared sstable
@@ -70,6 +87,29 @@ class sstables_manager {
     sstable_writer_config configure_writer() const;
     const db::config& config() const { return _db_config; }
 
+    // Index files of sstables are read through the cache, if set and enabled by
+    // the configuration. The cache must outlive all sstables of this manager.
+    void set_index_page_cache(index_page_cache* cache) {
+        _index_page_cache = cache;
+    }
+    index_page_cache* get_index_page_cache() const {
+        return _db_config.enable_index_cache() ? _index_page_cache : nullptr;
+    }
+
+    // Large split-block Bloom filters are loaded on demand through the cache,
+    // if set and enabled by the configuration, instead of being kept
+    // resident. The cache must outlive all sstables of this manager.
+    void set_filter_partition_cache(filter_partition_cache* cache) {
+        _filter_partition_cache = cache;
+    }
+    filter_partition_cache* get_filter_partition_cache() const {
+        return _db_config.enable_partitioned_bloom_filters() ? _filter_partition_cache : nullptr;
+    }
+
+    semaphore& deferred_filter_load_sem() {
+        return _deferred_filter_load_sem;
+    }
+
     sstables::sstable::version_types get_highest_supported_format() const;
 
 private:
@@ -42,6 +42,10 @@ class sstables_stats {
         uint64_t row_reads = 0;
         uint64_t capped_local_deletion_time = 0;
         uint64_t capped_tombstone_deletion_time = 0;
+        uint64_t digest_verifications = 0;
+        uint64_t digest_mismatches = 0;
+        uint64_t clustering_ranges_partition_skips = 0;
+        uint64_t trie_index_partition_skips = 0;
     } _shard_stats;
 
     stats& _stats = _shard_stats;
@@ -110,6 +114,22 @@ class sstables_stats {
     inline void on_capped_tombstone_deletion_time() {
         ++_stats.capped_tombstone_deletion_time;
     }
+
+    inline void on_digest_verification() {
+        ++_stats.digest_verifications;
+    }
+
+    inline void on_digest_mismatch() {
+        ++_stats.digest_mismatches;
+    }
+
+    inline void on_clustering_ranges_partition_skip() {
+        ++_stats.clustering_ranges_partition_skips;
+    }
+
+    inline void on_trie_index_partition_skip() {
+        ++_stats.trie_index_partition_skips;
+    }
 };
 
 }
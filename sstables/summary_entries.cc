@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+#include "sstables/summary_entries.hh"
+
+namespace sstables {
+
+static constexpr size_t entry_header_size = 2 * sizeof(uint16_t);
+static constexpr uint32_t min_buffer_size = 1 << 10;
+
+summary_entries::~summary_entries() = default;
+
+void summary_entries::clear() {
+    _tokens.clear();
+    _positions.clear();
+    _restarts.clear();
+    _buffers.clear();
+    _buffer_pos = 0;
+    _last_key = {};
+}
+
+void summary_entries::push_back(const dht::token& token, bytes_view key, uint64_t position) {
+    assert(key.size() <= std::numeric_limits<uint16_t>::max());
+    auto idx = size();
+    bool restart = idx % restart_interval == 0;
+    size_t shared = 0;
+    if (!restart) {
+        auto n = std::min(key.size(), _last_key.size());
+        shared = std::mismatch(key.begin(), key.begin() + n, _last_key.begin()).first - key.begin();
+    }
+    auto needed = entry_header_size + key.size() - shared;
+    if (_buffers.empty() || _buffer_pos + needed > _buffers.back().size) {
+        // Keys never span buffers, so every buffer starts with a restart point.
+        auto size = _buffers.empty() ? min_buffer_size : std::min(_buffers.back().size << 1, uint32_t(max_buffer_size));
+        size = std::max(size, uint32_t(entry_header_size + key.size()));
+        _buffers.push_back(buffer{size, std::make_unique<bytes::value_type[]>(size)});
+        _buffer_pos = 0;
+        restart = true;
+        shared = 0;
+        needed = entry_header_size + key.size();
+    }
+    if (restart) {
+        _restarts.push_back(restart_point{uint32_t(idx), uint32_t(_buffers.size() - 1), _buffer_pos});
+    }
+
+    auto out = _buffers.back().data.get() + _buffer_pos;
+    uint16_t shared_length = shared;
+    uint16_t suffix_length = key.size() - shared;
+    std::memcpy(out, &shared_length, sizeof(shared_length));
+    std::memcpy(out + sizeof(shared_length), &suffix_length, sizeof(suffix_length));
+    std::copy_n(key.begin() + shared, suffix_length, out + entry_header_size);
+    _buffer_pos += needed;
+
+    _tokens.push_back(dht::token::to_int64(token));
+    _positions.push_back(position);
+    _last_key = to_bytes(key);
+}
+
+size_t summary_entries::restart_of(size_t idx) const {
+    auto it = std::upper_bound(_restarts.begin(), _restarts.end(), idx, [] (size_t idx, const restart_point& r) {
+        return idx < r.entry;
+    });
+    return std::distance(_restarts.begin(), it) - 1;
+}
+
+bytes_view summary_entries::restart_key(size_t restart) const {
+    auto& r = _restarts[restart];
+    auto p = _buffers[r.buffer].data.get() + r.offset;
+    uint16_t suffix_length;
+    std::memcpy(&suffix_length, p + sizeof(uint16_t), sizeof(suffix_length));
+    return bytes_view(p + entry_header_size, suffix_length);
+}
+
+summary_entries::cursor::cursor(const summary_entries& entries, size_t restart)
+    : _entries(&entries)
+    , _idx(entries._restarts[restart].entry)
+    , _restart(restart)
+{
+    auto& r = entries._restarts[restart];
+    _next = entries._buffers[r.buffer].data.get() + r.offset;
+    decode();
+}
+
+void summary_entries::cursor::decode() {
+    uint16_t shared_length;
+    uint16_t suffix_length;
+    std::memcpy(&shared_length, _next, sizeof(shared_length));
+    std::memcpy(&suffix_length, _next + sizeof(shared_length), sizeof(suffix_length));
+    _key.resize(shared_length);
+    _key.insert(_key.end(), _next + entry_header_size, _next + entry_header_size + suffix_length);
+    _next += entry_header_size + suffix_length;
+}
+
+void summary_entries::cursor::next() {
+    if (++_idx == _entries->size()) {
+        return;
+    }
+    auto& restarts = _entries->_restarts;
+    if (_restart + 1 < restarts.size() && restarts[_restart + 1].entry == _idx) {
+        auto& r = restarts[++_restart];
+        _next = _entries->_buffers[r.buffer].data.get() + r.offset;
+    }
+    decode();
+}
+
+summary_entry summary_entries::operator[](size_t idx) const {
+    cursor c(*this, restart_of(idx));
+    while (c.index() < idx) {
+        c.next();
+    }
+    return summary_entry{token(idx), to_bytes(c.key()), position(idx)};
+}
+
+size_t summary_entries::lower_bound(const schema& s, dht::ring_position_view rp, size_t from) const {
+    // Tokens are not compressed, so narrow the search down to the entries
+    // sharing the token of rp before decoding any key.
+    const auto& t = rp.token();
+    size_t lo = from;
+    size_t hi = size();
+    while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        if (token(mid) < t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    auto first = lo;
+    hi = size();
+    while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        if (t < token(mid)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    auto last = lo;
+    if (first == last) {
+        return first;
+    }
+
+    dht::ring_position_comparator cmp(s);
+    auto entry_token = token(first);
+    auto less = [&] (bytes_view key) {
+        return cmp(decorated_key_view(entry_token, key_view(key)), rp) < 0;
+    };
+    // Find the last restart point in [first, last) which is smaller than rp
+    // and scan forward from it.
+    auto r = restart_of(first);
+    auto r_last = restart_of(last - 1);
+    while (r < r_last) {
+        auto mid = r + (r_last - r + 1) / 2;
+        if (less(restart_key(mid))) {
+            r = mid;
+        } else {
+            r_last = mid - 1;
+        }
+    }
+    cursor c(*this, r);
+    while (c.index() < first) {
+        c.next();
+    }
+    while (c.index() < last && less(c.key())) {
+        c.next();
+    }
+    return c.index();
+}
+
+summary_entries::const_iterator summary_entries::begin() const {
+    return const_iterator(*this, 0);
+}
+
+summary_entries::const_iterator summary_entries::end() const {
+    return const_iterator(*this, size());
+}
+
+size_t summary_entries::memory_footprint() const {
+    auto sz = _tokens.memory_size() + _positions.memory_size() + _restarts.memory_size() + _last_key.size();
+    for (auto& b : _buffers) {
+        sz += b.size;
+    }
+    return sz;
+}
+
+bool summary_entries::operator==(const summary_entries& x) const {
+    return size() == x.size() && std::equal(begin(), end(), x.begin());
+}
+
+summary_entries::const_iterator::const_iterator(const summary_entries& entries, size_t idx)
+    : _entries(&entries)
+    , _idx(idx)
+{
+    if (_idx < entries.size()) {
+        _cursor.emplace(entries, entries.restart_of(_idx));
+        while (_cursor->index() < _idx) {
+            _cursor->next();
+        }
+        load();
+    }
+}
+
+void summary_entries::const_iterator::load() {
+    _current = summary_entry{_entries->token(_idx), to_bytes(_cursor->key()), _entries->position(_idx)};
+}
+
+summary_entries::const_iterator& summary_entries::const_iterator::operator++() {
+    _cursor->next();
+    if (++_idx < _entries->size()) {
+        load();
+    }
+    return *this;
+}
+
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "bytes.hh"
+#include "sstables/key.hh"
+#include "utils/chunked_vector.hh"
+
+namespace sstables {
+
+class summary_entry {
+public:
+    dht::token token;
+    bytes key;
+    uint64_t position;
+
+    key_view get_key() const {
+        return key_view{key};
+    }
+
+    decorated_key_view get_decorated_key() const {
+        return decorated_key_view(token, get_key());
+    }
+
+    bool operator==(const summary_entry& x) const {
+        return position ==  x.position && key == x.key;
+    }
+};
+
+// In-memory representation of the summary entries.
+//
+// Tokens and index positions are kept in flat arrays, while the keys are
+// prefix-compressed: every key stores only the suffix which differs from the
+// previous key. Every restart_interval-th key, and the first key of every
+// buffer, is stored in full and recorded as a restart point, so decoding any
+// key never reads more than restart_interval entries. Lookups compare tokens
+// first and only decode keys of the entries sharing the looked up token,
+// binary searching over the restart points.
+//
+// Key layout in the buffers (native endian):
+//
+//   uint16_t shared_prefix_length
+//   uint16_t suffix_length
+//   int8_t   suffix[suffix_length]
+class summary_entries {
+public:
+    static constexpr size_t restart_interval = 16;
+    static constexpr size_t max_buffer_size = 128 << 10;
+private:
+    struct restart_point {
+        uint32_t entry;
+        uint32_t buffer;
+        uint32_t offset;
+    };
+    struct buffer {
+        uint32_t size;
+        std::unique_ptr<bytes::value_type[]> data;
+    };
+    class cursor;
+
+    utils::chunked_vector<int64_t> _tokens;
+    utils::chunked_vector<uint64_t> _positions;
+    utils::chunked_vector<restart_point> _restarts;
+    std::vector<buffer> _buffers;
+    uint32_t _buffer_pos = 0;
+    // The last key added, used to compute the shared prefix of the next one.
+    bytes _last_key;
+private:
+    size_t restart_of(size_t idx) const;
+    bytes_view restart_key(size_t restart) const;
+public:
+    class const_iterator;
+
+    summary_entries() = default;
+    summary_entries(summary_entries&&) noexcept = default;
+    summary_entries& operator=(summary_entries&&) noexcept = default;
+    ~summary_entries();
+
+    size_t size() const {
+        return _tokens.size();
+    }
+    bool empty() const {
+        return _tokens.empty();
+    }
+    void reserve(size_t n) {
+        _tokens.reserve(n);
+        _positions.reserve(n);
+    }
+    void clear();
+
+    // Keys must be added in ring order.
+    void push_back(const dht::token& token, bytes_view key, uint64_t position);
+
+    dht::token token(size_t idx) const {
+        return dht::token(dht::token::kind::key, _tokens[idx]);
+    }
+    uint64_t position(size_t idx) const {
+        return _positions[idx];
+    }
+    // Decodes the entry at idx.
+    summary_entry operator[](size_t idx) const;
+
+    // Returns the index of the first entry, not before from, which is not
+    // smaller than rp, or size() if there is no such entry.
+    size_t lower_bound(const schema& s, dht::ring_position_view rp, size_t from = 0) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    size_t memory_footprint() const;
+
+    bool operator==(const summary_entries& x) const;
+};
+
+// Walks the entries sequentially, decoding every key once.
+class summary_entries::cursor {
+    const summary_entries* _entries;
+    size_t _idx;
+    size_t _restart;
+    const bytes::value_type* _next;
+    std::vector<bytes::value_type> _key;
+private:
+    void decode();
+public:
+    // Positioned at the first entry of the given restart point.
+    cursor(const summary_entries& entries, size_t restart);
+    size_t index() const {
+        return _idx;
+    }
+    bool at_end() const {
+        return _idx == _entries->size();
+    }
+    bytes_view key() const {
+        return bytes_view(_key.data(), _key.size());
+    }
+    void next();
+};
+
+class summary_entries::const_iterator {
+    const summary_entries* _entries;
+    std::optional<cursor> _cursor;
+    summary_entry _current;
+    size_t _idx;
+private:
+    void load();
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = summary_entry;
+    using difference_type = ssize_t;
+    using pointer = const summary_entry*;
+    using reference = const summary_entry&;
+
+    const_iterator(const summary_entries& entries, size_t idx);
+    // The reference is valid until the iterator is advanced.
+    const summary_entry& operator*() const {
+        return _current;
+    }
+    const summary_entry* operator->() const {
+        return &_current;
+    }
+    const_iterator& operator++();
+    bool operator==(const const_iterator& x) const {
+        return _idx == x._idx;
+    }
+    bool operator!=(const const_iterator& x) const {
+        return !(*this == x);
+    }
+};
+
+}
@@ -139,7 +139,7 @@ class time_window_compaction_strategy : public compaction_strategy_impl {
     time_window_compaction_strategy_options _options;
     int64_t _estimated_remaining_tasks = 0;
     db_clock::time_point _last_expired_check;
-    timestamp_type _highest_window_seen;
+    timestamp_type _highest_window_seen = std::numeric_limits<timestamp_type>::min();
     size_tiered_compaction_strategy_options _stcs_options;
     compaction_backlog_tracker _backlog_tracker;
 public:
@@ -173,7 +173,8 @@ class time_window_compaction_strategy : public compaction_strategy_impl {
             candidates.erase(boost::remove_if(candidates, is_expired), candidates.end());
         }
 
-        auto compaction_candidates = get_next_non_expired_sstables(cf, std::move(candidates), gc_before);
+        // If there is nothing to compact in standard way, compaction_strategy falls back to a tombstone compaction.
+        auto compaction_candidates = get_compaction_candidates(cf, std::move(candidates));
         if (!expired.empty()) {
             compaction_candidates.insert(compaction_candidates.end(), expired.begin(), expired.end());
         }
@@ -192,29 +193,6 @@ class time_window_compaction_strategy : public compaction_strategy_impl {
         };
     }
 
-    std::vector<shared_sstable>
-    get_next_non_expired_sstables(column_family& cf, std::vector<shared_sstable> non_expiring_sstables, gc_clock::time_point gc_before) {
-        auto most_interesting = get_compaction_candidates(cf, non_expiring_sstables);
-
-        if (!most_interesting.empty()) {
-            return most_interesting;
-        }
-
-        // if there is no sstable to compact in standard way, try compacting single sstable whose droppable tombstone
-        // ratio is greater than threshold.
-        auto e = boost::range::remove_if(non_expiring_sstables, [this, &gc_before] (const shared_sstable& sst) -> bool {
-            return !worth_dropping_tombstones(sst, gc_before);
-        });
-        non_expiring_sstables.erase(e, non_expiring_sstables.end());
-        if (non_expiring_sstables.empty()) {
-            return {};
-        }
-        auto it = boost::min_element(non_expiring_sstables, [] (auto& i, auto& j) {
-            return i->get_stats_metadata().min_timestamp < j->get_stats_metadata().min_timestamp;
-        });
-        return { *it };
-    }
-
     std::vector<shared_sstable> get_compaction_candidates(column_family& cf, std::vector<shared_sstable> candidate_sstables) {
         auto p = get_buckets(std::move(candidate_sstables), _options);
         // Update the highest window seen, if necessary
@@ -341,6 +319,8 @@ class time_window_compaction_strategy : public compaction_strategy_impl {
     virtual uint64_t adjust_partition_estimate(const mutation_source_metadata& ms_meta, uint64_t partition_estimate) override;
 
     virtual reader_consumer make_interposer_consumer(const mutation_source_metadata& ms_meta, reader_consumer end_consumer) override;
+
+    virtual bool is_cold_output(const compaction_descriptor& descriptor) const override;
 };
 
 }
@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <seastar/core/byteorder.hh>
+#include <seastar/core/future-util.hh>
+
+#include "sstables/trie_index.hh"
+#include "sstables/writer.hh"
+#include "sstables/exceptions.hh"
+
+namespace sstables {
+namespace trie {
+
+token_key encode_token(int64_t token) {
+    token_key key;
+    write_be<uint64_t>(reinterpret_cast<char*>(key.data()), static_cast<uint64_t>(token) ^ (uint64_t(1) << 63));
+    return key;
+}
+
+static size_t common_prefix_length(const token_key& a, const token_key& b) {
+    return std::mismatch(a.begin(), a.end(), b.begin()).first - a.begin();
+}
+
+static constexpr size_t payload_size = sizeof(int64_t) + sizeof(uint64_t);
+static constexpr size_t child_entry_size = sizeof(uint8_t) + sizeof(uint64_t);
+static constexpr size_t node_header_size = sizeof(uint8_t) + sizeof(uint16_t);
+static constexpr uint8_t has_payload_flag = 0x1;
+
+struct index_writer::node {
+    struct child {
+        uint8_t transition;
+        // Engaged as long as the child sub-trie was not written out yet.
+        std::unique_ptr<node> pending;
+        uint64_t offset = 0;
+        // Serialized size of the pending sub-trie, 0 once written.
+        size_t subtree_size = 0;
+    };
+
+    uint8_t transition;
+    std::optional<index_entry> payload;
+    std::vector<child> children;
+
+    explicit node(uint8_t t) : transition(t) { }
+
+    size_t node_size() const {
+        return node_header_size + (payload ? payload_size : 0) + children.size() * child_entry_size;
+    }
+
+    size_t subtree_size() const {
+        size_t size = node_size();
+        for (auto& c : children) {
+            size += c.subtree_size;
+        }
+        return size;
+    }
+};
+
+index_writer::index_writer(file_writer& out)
+    : _out(out)
+{
+    _stack.push_back(std::make_unique<node>(0));
+}
+
+index_writer::~index_writer() = default;
+
+uint64_t index_writer::position() const {
+    return _out.offset();
+}
+
+void index_writer::pad_to_page() {
+    static const std::array<char, page_size> zeros{};
+    auto in_page = position() % page_size;
+    if (in_page) {
+        _out.write(zeros.data(), page_size - in_page);
+    }
+}
+
+void index_writer::write_node(node& n) {
+    std::array<char, node_header_size + payload_size + 256 * child_entry_size> buf;
+    char* p = buf.data();
+    *p++ = n.payload ? has_payload_flag : 0;
+    if (n.payload) {
+        write_be<int64_t>(p, n.payload->token);
+        p += sizeof(int64_t);
+        write_be<uint64_t>(p, n.payload->position);
+        p += sizeof(uint64_t);
+    }
+    write_be<uint16_t>(p, n.children.size());
+    p += sizeof(uint16_t);
+    for (auto& c : n.children) {
+        *p++ = c.transition;
+    }
+    for (auto& c : n.children) {
+        write_be<uint64_t>(p, c.offset);
+        p += sizeof(uint64_t);
+    }
+    _out.write(buf.data(), p - buf.data());
+}
+
+uint64_t index_writer::write_subtree(node& n) {
+    auto size = n.subtree_size();
+    if (size <= page_size && position() % page_size + size > page_size) {
+        pad_to_page();
+    }
+    for (auto& c : n.children) {
+        if (c.pending) {
+            c.offset = write_subtree(*c.pending);
+            c.pending.reset();
+            c.subtree_size = 0;
+        }
+    }
+    auto pos = position();
+    write_node(n);
+    return pos;
+}
+
+// Detaches the deepest node of the current path and hands it over to its
+// parent. Sub-tries that no longer fit in a page are written out, their
+// children are then packed page-by-page.
+void index_writer::complete_top() {
+    auto n = std::move(_stack.back());
+    _stack.pop_back();
+    auto size = n->subtree_size();
+    if (size > page_size) {
+        for (auto& c : n->children) {
+            if (c.pending) {
+                c.offset = write_subtree(*c.pending);
+                c.pending.reset();
+                c.subtree_size = 0;
+            }
+        }
+        size = n->node_size();
+    }
+    auto transition = n->transition;
+    _stack.back()->children.push_back(node::child{transition, std::move(n), 0, size});
+}
+
+void index_writer::insert(const token_key& key, size_t prefix_len, const index_entry& e) {
+    size_t depth = 0;
+    while (depth + 1 < _stack.size() && depth < prefix_len && _stack[depth + 1]->transition == key[depth]) {
+        ++depth;
+    }
+    while (_stack.size() > depth + 1) {
+        complete_top();
+    }
+    for (size_t i = depth; i < prefix_len; ++i) {
+        _stack.push_back(std::make_unique<node>(key[i]));
+    }
+    _stack.back()->payload = e;
+    ++_entries;
+}
+
+void index_writer::add(dht::token t, uint64_t position) {
+    auto token = dht::token::to_int64(t);
+    if (_pending && _pending->token == token) {
+        return;
+    }
+    auto key = encode_token(token);
+    if (_pending) {
+        // The stored prefix must tell the pending key apart from both its
+        // predecessor and its successor.
+        auto lcp = common_prefix_length(*_pending_key, key);
+        insert(*_pending_key, std::min(token_key_size, std::max(_prev_lcp, lcp) + 1), *_pending);
+        _prev_lcp = lcp;
+    }
+    _pending = index_entry{token, position};
+    _pending_key = key;
+}
+
+uint64_t index_writer::finish() {
+    if (_pending) {
+        insert(*_pending_key, std::min(token_key_size, _prev_lcp + 1), *_pending);
+        _pending.reset();
+    }
+    while (_stack.size() > 1) {
+        complete_top();
+    }
+    auto& root = *_stack.front();
+    if (root.subtree_size() > page_size) {
+        for (auto& c : root.children) {
+            if (c.pending) {
+                c.offset = write_subtree(*c.pending);
+                c.pending.reset();
+                c.subtree_size = 0;
+            }
+        }
+    }
+    auto root_offset = write_subtree(root);
+
+    // The footer occupies the tail of the last page, so that the file size
+    // is always a multiple of the page size.
+    static const std::array<char, page_size> zeros{};
+    auto in_page = position() % page_size;
+    if (in_page + footer_size > page_size) {
+        pad_to_page();
+        in_page = 0;
+    }
+    _out.write(zeros.data(), page_size - footer_size - in_page);
+    std::array<char, footer_size> footer;
+    write_be<uint64_t>(footer.data(), root_offset);
+    write_be<uint64_t>(footer.data() + sizeof(uint64_t), _entries);
+    write_be<uint64_t>(footer.data() + 2 * sizeof(uint64_t), footer_magic);
+    _out.write(footer.data(), footer.size());
+    _stack.clear();
+    return _entries;
+}
+
+struct index_reader::node_view {
+    std::optional<index_entry> payload;
+    std::vector<uint8_t> transitions;
+    std::vector<uint64_t> children;
+};
+
+index_reader::index_reader(file f, uint64_t file_size, const io_priority_class& pc)
+    : _file(std::move(f))
+    , _file_size(file_size)
+    , _pc(pc)
+{ }
+
+future<temporary_buffer<char>> index_reader::read_page(uint64_t page, const io_priority_class& pc) {
+    if (_root_page && page == _root / page_size) {
+        return make_ready_future<temporary_buffer<char>>(_root_page.share());
+    }
+    if ((page + 1) * page_size > _file_size) {
+        return make_exception_future<temporary_buffer<char>>(
+                malformed_sstable_exception(format("trie index page {} out of file bounds ({} bytes)", page, _file_size)));
+    }
+    return _file.dma_read_exactly<char>(page * page_size, page_size, pc);
+}
+
+future<index_reader::node_view> index_reader::read_node(uint64_t pos, const io_priority_class& pc) {
+    return read_page(pos / page_size, pc).then([pos] (temporary_buffer<char> page) {
+        auto in_page = pos % page_size;
+        const char* p = page.get() + in_page;
+        const char* end = page.get() + page.size();
+        auto check = [&] (size_t n) {
+            if (size_t(end - p) < n) {
+                throw malformed_sstable_exception(format("trie index node at {} crosses a page boundary", pos));
+            }
+        };
+        node_view n;
+        check(node_header_size);
+        auto flags = uint8_t(*p++);
+        if (flags & has_payload_flag) {
+            check(payload_size);
+            auto token = read_be<int64_t>(p);
+            auto position = read_be<uint64_t>(p + sizeof(int64_t));
+            n.payload = index_entry{token, position};
+            p += payload_size;
+        }
+        auto count = read_be<uint16_t>(p);
+        p += sizeof(uint16_t);
+        check(count * child_entry_size);
+        n.transitions.reserve(count);
+        n.children.reserve(count);
+        for (unsigned i = 0; i < count; ++i) {
+            n.transitions.push_back(uint8_t(*p++));
+        }
+        for (unsigned i = 0; i < count; ++i) {
+            n.children.push_back(read_be<uint64_t>(p));
+            p += sizeof(uint64_t);
+        }
+        return n;
+    });
+}
+
+future<> index_reader::open() {
+    if (_file_size < page_size || _file_size % page_size) {
+        return make_exception_future<>(malformed_sstable_exception(format("trie index has invalid size {}", _file_size)));
+    }
+    return read_page(_file_size / page_size - 1, _pc).then([this] (temporary_buffer<char> page) {
+        const char* footer = page.get() + page_size - footer_size;
+        if (read_be<uint64_t>(footer + 2 * sizeof(uint64_t)) != footer_magic) {
+            throw malformed_sstable_exception("trie index footer has a wrong magic number");
+        }
+        _root = read_be<uint64_t>(footer);
+        _entries = read_be<uint64_t>(footer + sizeof(uint64_t));
+        if (!_entries) {
+            return make_ready_future<>();
+        }
+        // Every lookup starts at the root, keep its page.
+        if (_root / page_size == _file_size / page_size - 1) {
+            _root_page = std::move(page);
+            return make_ready_future<>();
+        }
+        return read_page(_root / page_size, _pc).then([this] (temporary_buffer<char> root_page) {
+            _root_page = std::move(root_page);
+        });
+    });
+}
+
+future<std::optional<index_entry>> index_reader::leftmost(std::optional<uint64_t> pos, const io_priority_class& pc) {
+    if (!pos) {
+        return make_ready_future<std::optional<index_entry>>();
+    }
+    return do_with(*pos, std::optional<index_entry>(), [this, &pc] (uint64_t& pos, std::optional<index_entry>& result) {
+        return repeat([this, &pc, &pos, &result] {
+            return read_node(pos, pc).then([&pos, &result] (node_view n) {
+                if (n.payload) {
+                    result = n.payload;
+                    return stop_iteration::yes;
+                }
+                if (n.children.empty()) {
+                    throw malformed_sstable_exception(format("trie index node at {} is an empty inner node", pos));
+                }
+                pos = n.children.front();
+                return stop_iteration::no;
+            });
+        }).then([&result] {
+            return result;
+        });
+    });
+}
+
+future<std::optional<index_entry>> index_reader::lower_bound(dht::token t) {
+    return lower_bound(t, _pc);
+}
+
+future<std::optional<index_entry>> index_reader::lower_bound(dht::token t, const io_priority_class& pc) {
+    if (!_entries || t.is_maximum()) {
+        return make_ready_future<std::optional<index_entry>>();
+    }
+    if (t.is_minimum()) {
+        return leftmost(_root, pc);
+    }
+    struct walk_state {
+        int64_t token;
+        token_key key;
+        size_t depth = 0;
+        uint64_t pos;
+        // Root of the nearest sub-trie holding keys greater than the ones
+        // under pos.
+        std::optional<uint64_t> successor;
+        std::optional<uint64_t> continue_from;
+        std::optional<index_entry> result;
+    };
+    auto token = dht::token::to_int64(t);
+    return do_with(walk_state{token, encode_token(token), 0, _root}, [this, &pc] (walk_state& st) {
+        return repeat([this, &pc, &st] {
+            return read_node(st.pos, pc).then([&st] (node_view n) {
+                if (n.payload) {
+                    if (n.payload->token >= st.token) {
+                        st.result = n.payload;
+                    } else {
+                        st.continue_from = st.successor;
+                    }
+                    return stop_iteration::yes;
+                }
+                if (st.depth == token_key_size) {
+                    throw malformed_sstable_exception(format("trie index path at {} is longer than a token", st.pos));
+                }
+                auto it = std::lower_bound(n.transitions.begin(), n.transitions.end(), st.key[st.depth]);
+                auto idx = it - n.transitions.begin();
+                if (it == n.transitions.end()) {
+                    st.continue_from = st.successor;
+                    return stop_iteration::yes;
+                }
+                if (*it != st.key[st.depth]) {
+                    st.continue_from = n.children[idx];
+                    return stop_iteration::yes;
+                }
+                if (size_t(idx + 1) < n.children.size()) {
+                    st.successor = n.children[idx + 1];
+                }
+                st.pos = n.children[idx];
+                ++st.depth;
+                return stop_iteration::no;
+            });
+        }).then([this, &pc, &st] {
+            if (st.result) {
+                return make_ready_future<std::optional<index_entry>>(st.result);
+            }
+            return leftmost(st.continue_from, pc);
+        });
+    });
+}
+
+}
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <vector>
+#include <memory>
+
+#include <seastar/core/file.hh>
+#include <seastar/core/future.hh>
+#include <seastar/core/temporary_buffer.hh>
+
+#include "seastarx.hh"
+#include "dht/token.hh"
+
+namespace sstables {
+
+class file_writer;
+
+// On-disk, page-aware trie mapping partition tokens to Data.db positions.
+//
+// The trie is keyed by the byte-comparable encoding of the token (the
+// big-endian representation of the token with the sign bit flipped), and
+// only the shortest prefix which distinguishes a token from its neighbours
+// is stored. Leaves carry the full token and the Data.db position of the
+// first partition with that token, so lookups never need to consult the
+// data file to resolve an inexact prefix match.
+//
+// Nodes are serialized in post-order. The writer keeps every sub-trie which
+// fits in a page in memory until its parent is complete and pads the output
+// so that such a sub-trie never straddles a page boundary. A lookup thus
+// touches the page(s) holding the top of the trie plus a single page for the
+// bottom part, which removes the need for a resident summary.
+//
+// Node layout (all integers big-endian):
+//
+//   uint8_t  flags                  (bit 0: has payload)
+//   int64_t  token                  (only if has payload)
+//   uint64_t position               (only if has payload)
+//   uint16_t child_count
+//   uint8_t  transitions[child_count]   (sorted)
+//   uint64_t children[child_count]      (absolute offsets of child nodes)
+//
+// The file ends with a footer holding the root offset, the number of
+// entries and a magic number, placed in the last page.
+namespace trie {
+
+constexpr size_t page_size = 4096;
+constexpr uint64_t footer_magic = 0x5343594c54524945; // "SCYLTRIE"
+constexpr size_t footer_size = 3 * sizeof(uint64_t);
+constexpr size_t token_key_size = sizeof(int64_t);
+
+using token_key = std::array<uint8_t, token_key_size>;
+
+// Encodes a token so that the lexicographical order of the encoding
+// matches the order of tokens.
+token_key encode_token(int64_t token);
+
+struct index_entry {
+    int64_t token;
+    uint64_t position;
+};
+
+// Builds the trie from entries added in token order.
+// Must be called in a seastar thread.
+class index_writer {
+    struct node;
+    file_writer& _out;
+    // Nodes on the path to the most recently inserted key, _stack[i] is at depth i.
+    std::vector<std::unique_ptr<node>> _stack;
+    std::optional<index_entry> _pending;
+    std::optional<token_key> _pending_key;
+    size_t _prev_lcp = 0;
+    uint64_t _entries = 0;
+private:
+    uint64_t position() const;
+    void pad_to_page();
+    void insert(const token_key& key, size_t prefix_len, const index_entry& e);
+    void complete_top();
+    uint64_t write_subtree(node& n);
+    void write_node(node& n);
+public:
+    explicit index_writer(file_writer& out);
+    ~index_writer();
+    // Tokens must be added in non-decreasing order. Only the first
+    // position of every distinct token is recorded.
+    void add(dht::token t, uint64_t position);
+    // Flushes the trie and writes the footer. Returns the number of
+    // distinct tokens recorded.
+    uint64_t finish();
+};
+
+// Looks up tokens in a trie written by index_writer. Only the page holding
+// the root is kept by the reader, other pages are read through the file on
+// every lookup, so a long-lived reader should be given a cached file.
+class index_reader {
+    struct node_view;
+    file _file;
+    uint64_t _file_size;
+    const io_priority_class& _pc;
+    uint64_t _root = 0;
+    uint64_t _entries = 0;
+    temporary_buffer<char> _root_page;
+private:
+    future<temporary_buffer<char>> read_page(uint64_t page, const io_priority_class& pc);
+    future<node_view> read_node(uint64_t pos, const io_priority_class& pc);
+    future<std::optional<index_entry>> leftmost(std::optional<uint64_t> pos, const io_priority_class& pc);
+public:
+    // pc is used by open() and by lookups which don't pass their own.
+    index_reader(file f, uint64_t file_size, const io_priority_class& pc);
+    // Reads the footer, must be called (and waited for) before any lookup.
+    future<> open();
+    uint64_t entries() const { return _entries; }
+    // Returns the first entry whose token is not smaller than t, or
+    // std::nullopt if all indexed tokens are smaller than t.
+    future<std::optional<index_entry>> lower_bound(dht::token t);
+    future<std::optional<index_entry>> lower_bound(dht::token t, const io_priority_class& pc);
+};
+
+}
+
+}
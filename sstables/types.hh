@@ -31,6 +31,7 @@
 #include "utils/estimated_histogram.hh"
 #include "column_name_helper.hh"
 #include "sstables/key.hh"
+#include "sstables/summary_entries.hh"
 #include "db/commitlog/replay_position.hh"
 #include "version.hh"
 #include <vector>
@@ -127,25 +128,6 @@ inline std::ostream& operator<<(std::ostream& o, indexable_element e) {
     return o;
 }
 
-class summary_entry {
-public:
-    dht::token token;
-    bytes_view key;
-    uint64_t position;
-
-    key_view get_key() const {
-        return key_view{key};
-    }
-
-    decorated_key_view get_decorated_key() const {
-        return decorated_key_view(token, get_key());
-    }
-
-    bool operator==(const summary_entry& x) const {
-        return position ==  x.position && key == x.key;
-    }
-};
-
 // Note: Sampling level is present in versions ka and higher. We ATM only support ka,
 // so it's always there. But we need to make this conditional if we ever want to support
 // other formats.
@@ -171,7 +153,7 @@ struct summary_ka {
     // not the file. The memory stream effectively begins after the header,
     // so every position here has to be added of sizeof(header).
     utils::chunked_vector<uint32_t> positions;   // can be large, so use a deque instead of a vector
-    utils::chunked_vector<summary_entry> entries;
+    summary_entries entries;
 
     disk_string<uint32_t> first_key;
     disk_string<uint32_t> last_key;
@@ -191,49 +173,14 @@ struct summary_ka {
      * Similar to origin off heap size
      */
     uint64_t memory_footprint() const {
-        auto sz = sizeof(summary_entry) * entries.size() + sizeof(uint32_t) * positions.size() + sizeof(*this);
+        auto sz = entries.memory_footprint() + sizeof(uint32_t) * positions.size() + sizeof(*this);
         sz += first_key.value.size() + last_key.value.size();
-        for (auto& sd : _summary_data) {
-            sz += sd.size();
-        }
         return sz;
     }
 
     explicit operator bool() const {
         return entries.size();
     }
-
-    bytes_view add_summary_data(bytes_view data) {
-        if (_summary_data.empty() || (_summary_index_pos + data.size() > _buffer_size)) {
-            _buffer_size = std::min(_buffer_size << 1, 128u << 10);
-            // Keys are 64kB max, so it might be one key may not fit in a buffer
-            _buffer_size = std::max(_buffer_size, unsigned(data.size()));
-            _summary_data.emplace_back(_buffer_size);
-            _summary_index_pos = 0;
-        }
-
-        auto ret = _summary_data.back().store_at(_summary_index_pos, data);
-        _summary_index_pos += data.size();
-        return ret;
-    }
-private:
-    class summary_data_memory {
-        unsigned _size;
-        std::unique_ptr<bytes::value_type[]> _data;
-    public:
-        summary_data_memory(unsigned size) : _size(size), _data(std::make_unique<bytes::value_type[]>(size)) {}
-        bytes_view store_at(unsigned pos, bytes_view src) {
-            auto addr = _data.get() + pos;
-            std::copy_n(src.data(), src.size(), addr);
-            return bytes_view(addr, src.size());
-        }
-        unsigned size() const {
-            return _size;
-        }
-    };
-    unsigned _buffer_size = 1 << 10;
-    std::vector<summary_data_memory> _summary_data = {};
-    unsigned _summary_index_pos = 0;
 };
 using summary = summary_ka;
 
@@ -459,7 +406,9 @@ enum sstable_feature : uint8_t {
     ShadowableTombstones = 2, // See #3885
     CorrectStaticCompact = 3, // See #4139
     CorrectEmptyCounters = 4, // See #4363
-    End = 5,
+    SplitBlockBloomFilter = 5, // Filter.db holds a split-block Bloom filter
+    XorFilter = 6, // Filter.db holds an xor filter
+    End = 7,
 };
 
 // Scylla-specific features enabled for a particular sstable.
@@ -52,6 +52,13 @@ inline seastar::sstring to_string(sstable_version_types format) {
     throw std::runtime_error("Wrong sstable format");
 }
 
+inline seastar::sstring to_string(sstable_format_types format) {
+    switch (format) {
+        case sstable_format_types::big: return "big";
+    }
+    throw std::runtime_error("Wrong sstable format");
+}
+
 inline bool is_latest_supported(sstable_version_types format) {
     return format == sstable_version_types::mc;
 }
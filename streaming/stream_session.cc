@@ -68,6 +68,10 @@
 #include "../db/view/view_update_generator.hh"
 #include "mutation_source_metadata.hh"
 #include "streaming/stream_mutation_fragments_cmd.hh"
+#include "streaming/stream_sstable_files_cmd.hh"
+#include "sstables/remove.hh"
+#include "distributed_loader.hh"
+#include <seastar/core/fstream.hh>
 
 namespace streaming {
 
@@ -103,6 +107,127 @@ static auto get_session(utils::UUID plan_id, gms::inet_address from, const char*
     return coordinator->get_or_create_session(from);
 }
 
+// Adoption of received sstables goes through distributed_loader, which
+// doesn't support concurrent loads into the same table, so they are
+// serialized on shard 0.
+static thread_local semaphore file_streaming_load_sem{1};
+
+// Writes the component files of a sstable streamed with STREAM_SSTABLE_FILES
+// under a new generation of this shard and loads the sstable, resharding it
+// if it's owned by several shards.
+//
+// The TOC is sent first and is written as a temporary TOC, which is renamed
+// once all components are durable, so that an interrupted transfer is cleaned
+// up like an interrupted sstable write.
+static future<> receive_sstable_files(distributed<database>& db, distributed<db::view::view_update_generator>& view_update_generator,
+        utils::UUID plan_id, netw::messaging_service::msg_addr from, lw_shared_ptr<table> cf,
+        sstables::sstable_version_types version, sstables::sstable_format_types sst_format, bool use_view_update_path,
+        rpc::source<sstring, bytes, stream_sstable_files_cmd> source) {
+    return seastar::async([&db, &view_update_generator, plan_id, from, cf = std::move(cf), version, sst_format, use_view_update_path, source] () mutable {
+        auto op = cf->stream_in_progress();
+        auto s = cf->schema();
+        auto dir = use_view_update_path ? cf->dir() + "/staging" : cf->dir();
+        auto gen = cf->calculate_generation_for_new_table();
+        const auto& toc_name = sstables::sstable_version_constants::get_component_map(version).at(sstables::component_type::TOC);
+        auto filename = [&] (sstables::component_type c) {
+            return sstables::sstable::filename(dir, s->ks_name(), s->cf_name(), version, gen, sst_format, c);
+        };
+
+        file_output_stream_options options;
+        options.io_priority_class = service::get_local_streaming_write_priority();
+        std::optional<output_stream<char>> out;
+        auto close_current = [&out] {
+            if (out) {
+                auto o = std::exchange(out, std::nullopt);
+                o->flush().finally([&o] { return o->close(); }).get();
+            }
+        };
+
+        sstring current;
+        bool got_toc = false;
+        bool got_end_of_stream = false;
+        try {
+            while (auto opt = source().get0()) {
+                auto& [component, data, cmd] = *opt;
+                if (cmd == stream_sstable_files_cmd::error) {
+                    throw std::runtime_error("Sender failed");
+                } else if (cmd == stream_sstable_files_cmd::end_of_stream) {
+                    got_end_of_stream = true;
+                    break;
+                } else if (cmd != stream_sstable_files_cmd::file_data) {
+                    throw std::runtime_error("Sender sent wrong cmd");
+                }
+                if (component != current) {
+                    close_current();
+                    if (component.empty() || component.find('/') != sstring::npos) {
+                        throw std::runtime_error(format("Invalid sstable component name {}", component));
+                    }
+                    sstring path;
+                    if (component == toc_name) {
+                        got_toc = true;
+                        path = filename(sstables::component_type::TemporaryTOC);
+                    } else if (!got_toc) {
+                        throw std::runtime_error("Sender did not send the TOC first");
+                    } else {
+                        path = sstables::sstable::filename(dir, s->ks_name(), s->cf_name(), version, gen, sst_format, component);
+                    }
+                    auto f = open_file_dma(path, open_flags::wo | open_flags::create | open_flags::exclusive).get0();
+                    out.emplace(make_file_output_stream(std::move(f), options));
+                    current = component;
+                }
+                out->write(reinterpret_cast<const char*>(data.data()), data.size()).get();
+                get_local_stream_manager().update_progress(plan_id, from.addr, progress_info::direction::IN, data.size());
+            }
+            if (!got_end_of_stream) {
+                throw std::runtime_error("Sender did not send end_of_stream");
+            }
+            close_current();
+            if (!got_toc) {
+                throw std::runtime_error("Sender did not send the TOC");
+            }
+            sync_directory(dir).get();
+            rename_file(filename(sstables::component_type::TemporaryTOC), filename(sstables::component_type::TOC)).get();
+            sync_directory(dir).get();
+        } catch (...) {
+            auto ep = std::current_exception();
+            try {
+                close_current();
+            } catch (...) {
+                // The transfer failed already.
+            }
+            if (got_toc) {
+                sstables::sstable::remove_sstable_with_temp_toc(s->ks_name(), s->cf_name(), dir, gen, version, sst_format).handle_exception([plan_id] (std::exception_ptr ep) {
+                    sslog.warn("[Stream #{}] Failed to remove partially received sstable: {}", plan_id, ep);
+                }).get();
+            }
+            std::rethrow_exception(ep);
+        }
+
+        try {
+            // Levels are only meaningful on the sender.
+            auto sst = cf->make_sstable(dir, gen, version, sst_format);
+            sst->load().get();
+            sst->mutate_sstable_level(0).get();
+            sst = {};
+
+            auto desc = sstables::entry_descriptor(dir, s->ks_name(), s->cf_name(), gen, version, sst_format, sstables::component_type::TOC);
+            smp::submit_to(0, [&db, &view_update_generator, desc = std::move(desc)] () mutable {
+                return with_semaphore(file_streaming_load_sem, 1, [&db, &view_update_generator, desc = std::move(desc)] () mutable {
+                    auto ks = desc.ks;
+                    auto cf = desc.cf;
+                    return distributed_loader::load_new_sstables(db, view_update_generator, std::move(ks), std::move(cf), {std::move(desc)});
+                });
+            }).get();
+        } catch (...) {
+            auto ep = std::current_exception();
+            sstables::remove_by_toc_name(filename(sstables::component_type::TOC)).handle_exception([plan_id] (std::exception_ptr ep) {
+                sslog.warn("[Stream #{}] Failed to remove received sstable: {}", plan_id, ep);
+            }).get();
+            std::rethrow_exception(ep);
+        }
+    });
+}
+
 void stream_session::init_messaging_service_handler() {
     ms().register_prepare_message([] (const rpc::client_info& cinfo, prepare_message msg, UUID plan_id, sstring description, rpc::optional<stream_reason> reason_opt) {
         const auto& src_cpu_id = cinfo.retrieve_auxiliary<uint32_t>("src_cpu_id");
@@ -175,43 +300,73 @@ void stream_session::init_messaging_service_handler() {
         return with_scheduling_group(service::get_local_storage_service().db().local().get_streaming_scheduling_group(), [from, estimated_partitions, plan_id, schema_id, &cf, source, reason] () mutable {
                 return service::get_schema_for_write(schema_id, from).then([from, estimated_partitions, plan_id, schema_id, &cf, source, reason] (schema_ptr s) mutable {
                     auto sink = ms().make_sink_for_stream_mutation_fragments(source);
+                    // Fragments are unfrozen in batches, so that the tokens of the
+                    // partitions they start are computed together.
                     struct stream_mutation_fragments_cmd_status {
                         bool got_cmd = false;
                         bool got_end_of_stream = false;
+                        bool done = false;
+                        std::vector<frozen_mutation_fragment> frozen;
+                        size_t frozen_size = 0;
+                        circular_buffer<mutation_fragment> unfrozen;
                     };
+                    static constexpr size_t max_frozen_fragments = 128;
+                    static constexpr size_t max_frozen_size = 128 * 1024;
                     auto cmd_status = make_lw_shared<stream_mutation_fragments_cmd_status>();
                     auto get_next_mutation_fragment = [source, plan_id, from, s, cmd_status] () mutable {
-                        return source().then([plan_id, from, s, cmd_status] (std::optional<std::tuple<frozen_mutation_fragment, rpc::optional<stream_mutation_fragments_cmd>>> opt) mutable {
-                            if (opt) {
-                                auto cmd = std::get<1>(*opt);
-                                if (cmd) {
-                                    cmd_status->got_cmd = true;
-                                    switch (*cmd) {
-                                    case stream_mutation_fragments_cmd::mutation_fragment_data:
-                                        break;
-                                    case stream_mutation_fragments_cmd::error:
-                                        return make_exception_future<mutation_fragment_opt>(std::runtime_error("Sender failed"));
-                                    case stream_mutation_fragments_cmd::end_of_stream:
-                                        cmd_status->got_end_of_stream = true;
-                                        return make_ready_future<mutation_fragment_opt>();
-                                    default:
-                                        return make_exception_future<mutation_fragment_opt>(std::runtime_error("Sender sent wrong cmd"));
+                        auto pop_mutation_fragment = [cmd_status] {
+                            if (cmd_status->unfrozen.empty()) {
+                                return mutation_fragment_opt();
+                            }
+                            auto mf = std::move(cmd_status->unfrozen.front());
+                            cmd_status->unfrozen.pop_front();
+                            return mutation_fragment_opt(std::move(mf));
+                        };
+                        if (!cmd_status->unfrozen.empty() || cmd_status->done) {
+                            return make_ready_future<mutation_fragment_opt>(pop_mutation_fragment());
+                        }
+                        return repeat([source, cmd_status] () mutable {
+                            return source().then([cmd_status] (std::optional<std::tuple<frozen_mutation_fragment, rpc::optional<stream_mutation_fragments_cmd>>> opt) mutable {
+                                if (opt) {
+                                    auto cmd = std::get<1>(*opt);
+                                    if (cmd) {
+                                        cmd_status->got_cmd = true;
+                                        switch (*cmd) {
+                                        case stream_mutation_fragments_cmd::mutation_fragment_data:
+                                            break;
+                                        case stream_mutation_fragments_cmd::error:
+                                            return make_exception_future<stop_iteration>(std::runtime_error("Sender failed"));
+                                        case stream_mutation_fragments_cmd::end_of_stream:
+                                            cmd_status->got_end_of_stream = true;
+                                            cmd_status->done = true;
+                                            return make_ready_future<stop_iteration>(stop_iteration::yes);
+                                        default:
+                                            return make_exception_future<stop_iteration>(std::runtime_error("Sender sent wrong cmd"));
+                                        }
                                     }
+                                    cmd_status->frozen_size += std::get<0>(*opt).representation().size();
+                                    cmd_status->frozen.push_back(std::move(std::get<0>(*opt)));
+                                    return make_ready_future<stop_iteration>(stop_iteration(cmd_status->frozen.size() >= max_frozen_fragments
+                                            || cmd_status->frozen_size >= max_frozen_size));
+                                } else {
+                                    // If the sender has sent stream_mutation_fragments_cmd it means it is
+                                    // a node that understands the new protocol. It must send end_of_stream
+                                    // before close the stream.
+                                    if (cmd_status->got_cmd && !cmd_status->got_end_of_stream) {
+                                        return make_exception_future<stop_iteration>(std::runtime_error("Sender did not sent end_of_stream"));
+                                    }
+                                    cmd_status->done = true;
+                                    return make_ready_future<stop_iteration>(stop_iteration::yes);
                                 }
-                                frozen_mutation_fragment& fmf = std::get<0>(*opt);
-                                auto sz = fmf.representation().size();
-                                auto mf = fmf.unfreeze(*s);
-                                streaming::get_local_stream_manager().update_progress(plan_id, from.addr, progress_info::direction::IN, sz);
-                                return make_ready_future<mutation_fragment_opt>(std::move(mf));
-                            } else {
-                                // If the sender has sent stream_mutation_fragments_cmd it means it is
-                                // a node that understands the new protocol. It must send end_of_stream
-                                // before close the stream.
-                                if (cmd_status->got_cmd && !cmd_status->got_end_of_stream) {
-                                    return make_exception_future<mutation_fragment_opt>(std::runtime_error("Sender did not sent end_of_stream"));
-                                }
-                                return make_ready_future<mutation_fragment_opt>();
+                            });
+                        }).then([plan_id, from, s, cmd_status, pop_mutation_fragment] () mutable {
+                            for (auto& mf : unfreeze(*s, cmd_status->frozen)) {
+                                cmd_status->unfrozen.push_back(std::move(mf));
                             }
+                            streaming::get_local_stream_manager().update_progress(plan_id, from.addr, progress_info::direction::IN, cmd_status->frozen_size);
+                            cmd_status->frozen.clear();
+                            cmd_status->frozen_size = 0;
+                            return pop_mutation_fragment();
                         });
                     };
                     //FIXME: discarded future.
@@ -272,6 +427,60 @@ void stream_session::init_messaging_service_handler() {
                 });
         });
     });
+    ms().register_stream_sstable_files([] (const rpc::client_info& cinfo, UUID plan_id, UUID schema_id, UUID cf_id, stream_reason reason, sstring version_str, sstring format_str, rpc::source<sstring, bytes, stream_sstable_files_cmd> source) {
+        auto from = netw::messaging_service::get_source(cinfo);
+        sslog.trace("Got stream_sstable_files from {} reason {}", from, int(reason));
+        auto& db = _db->local();
+        if (!_sys_dist_ks->local_is_initialized() || !_view_update_generator->local_is_initialized()) {
+            return make_exception_future<rpc::sink<int32_t>>(std::runtime_error(format("Node {} is not fully initialized for streaming, try again later",
+                    utils::fb_utilities::get_broadcast_address())));
+        }
+        if (!db.get_config().enable_sstable_file_streaming()) {
+            return make_exception_future<rpc::sink<int32_t>>(std::runtime_error("sstable file streaming is disabled"));
+        }
+        auto cf = db.find_column_family(cf_id).shared_from_this();
+        // The sstable must be readable with the local schema as it is.
+        if (cf->schema()->version() != schema_id) {
+            return make_exception_future<rpc::sink<int32_t>>(std::runtime_error(format("Schema version mismatch for {}.{}: local {}, remote {}",
+                    cf->schema()->ks_name(), cf->schema()->cf_name(), cf->schema()->version(), schema_id)));
+        }
+        sstables::sstable_version_types sst_version;
+        sstables::sstable_format_types sst_format;
+        try {
+            sst_version = sstables::from_string(version_str);
+            sst_format = sstables::sstable::format_from_sstring(format_str);
+        } catch (...) {
+            return make_exception_future<rpc::sink<int32_t>>(std::current_exception());
+        }
+        if (sstables::is_later(sst_version, cf->get_sstables_manager().get_highest_supported_format())) {
+            return make_exception_future<rpc::sink<int32_t>>(std::runtime_error(format("Unsupported sstable version {}", version_str)));
+        }
+        return with_scheduling_group(db.get_streaming_scheduling_group(), [from, plan_id, cf = std::move(cf), sst_version, sst_format, reason, source] () mutable {
+            return db::view::check_needs_view_update_path(_sys_dist_ks->local(), *cf, reason).then([from, plan_id, cf = std::move(cf), sst_version, sst_format, source] (bool use_view_update_path) mutable {
+                auto sink = ms().make_sink_for_stream_sstable_files(source);
+                auto s = cf->schema();
+                //FIXME: discarded future.
+                (void)receive_sstable_files(*_db, *_view_update_generator, plan_id, from, std::move(cf), sst_version, sst_format, use_view_update_path, std::move(source)).then_wrapped(
+                        [s, plan_id, from, sink] (future<> f) mutable {
+                    int32_t status = 0;
+                    if (f.failed()) {
+                        sslog.error("[Stream #{}] Failed to handle STREAM_SSTABLE_FILES for ks={}, cf={}, peer={}: {}",
+                                plan_id, s->ks_name(), s->cf_name(), from.addr, f.get_exception());
+                        status = -1;
+                    } else {
+                        sslog.debug("[Stream #{}] Received sstable files for ks={}, cf={} from {}", plan_id, s->ks_name(), s->cf_name(), from.addr);
+                    }
+                    return sink(status).finally([sink] () mutable {
+                        return sink.close();
+                    });
+                }).handle_exception([s, plan_id, from] (std::exception_ptr ep) {
+                    sslog.error("[Stream #{}] Failed to handle STREAM_SSTABLE_FILES (respond phase) for ks={}, cf={}, peer={}: {}",
+                            plan_id, s->ks_name(), s->cf_name(), from.addr, ep);
+                });
+                return make_ready_future<rpc::sink<int32_t>>(sink);
+            });
+        });
+    });
     ms().register_stream_mutation_done([] (const rpc::client_info& cinfo, UUID plan_id, dht::token_range_vector ranges, UUID cf_id, unsigned dst_cpu_id) {
         const auto& from = cinfo.retrieve_auxiliary<gms::inet_address>("baddr");
         return smp::submit_to(dst_cpu_id, [ranges = std::move(ranges), plan_id, cf_id, from] () mutable {
@@ -43,6 +43,7 @@
 #include "streaming/stream_manager.hh"
 #include "streaming/stream_reason.hh"
 #include "streaming/stream_mutation_fragments_cmd.hh"
+#include "streaming/stream_sstable_files_cmd.hh"
 #include "mutation_reader.hh"
 #include "frozen_mutation.hh"
 #include "mutation.hh"
@@ -57,6 +58,8 @@
 #include <boost/icl/interval_set.hpp>
 #include "sstables/sstables.hh"
 #include "database.hh"
+#include <seastar/core/fstream.hh>
+#include <boost/algorithm/cxx11/any_of.hpp>
 
 namespace streaming {
 
@@ -86,7 +89,8 @@ struct send_info {
     flat_mutation_reader reader;
     send_info(database& db_, utils::UUID plan_id_, utils::UUID cf_id_,
               dht::token_range_vector ranges_, netw::messaging_service::msg_addr id_,
-              uint32_t dst_cpu_id_, stream_reason reason_)
+              uint32_t dst_cpu_id_, stream_reason reason_,
+              std::unordered_set<sstables::shared_sstable> streamed_sstables = {})
         : db(db_)
         , plan_id(plan_id_)
         , cf_id(cf_id_)
@@ -96,7 +100,7 @@ struct send_info {
         , cf(db.find_column_family(cf_id))
         , ranges(std::move(ranges_))
         , prs(dht::to_partition_ranges(ranges))
-        , reader(cf.make_streaming_reader(cf.schema(), prs)) {
+        , reader(cf.make_streaming_reader(cf.schema(), prs, std::move(streamed_sstables))) {
     }
     future<bool> has_relevant_range_on_this_shard() {
         return do_with(false, ranges.begin(), [this] (bool& found_relevant_range, dht::token_range_vector::iterator& ranges_it) {
@@ -238,6 +242,152 @@ future<> send_mutation_fragments(lw_shared_ptr<send_info> si) {
  });
 }
 
+// Nodes gaining a range for these reasons get all of its data, so whole
+// sstables contained in the range can be handed over as they are.
+static bool file_streaming_allowed(database& db, stream_reason reason) {
+    if (!db.get_config().enable_sstable_file_streaming() || !db.features().cluster_supports_stream_sstable_files()) {
+        return false;
+    }
+    switch (reason) {
+    case stream_reason::bootstrap:
+    case stream_reason::decommission:
+    case stream_reason::removenode:
+    case stream_reason::rebuild:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Returns the sstables of this shard whose token range is contained in one of ranges.
+// Shared sstables are left out as other shards would stream them too.
+static std::vector<sstables::shared_sstable> sstables_for_file_streaming(const column_family& cf, const dht::token_range_vector& ranges) {
+    std::vector<sstables::shared_sstable> ret;
+    for (auto& sst : *cf.get_sstables()) {
+        if (sst->is_shared()) {
+            continue;
+        }
+        auto sst_range = dht::token_range::make(sst->get_first_decorated_key().token(), sst->get_last_decorated_key().token());
+        if (boost::algorithm::any_of(ranges, [&] (const dht::token_range& r) { return r.contains(sst_range, dht::token_comparator()); })) {
+            ret.push_back(sst);
+        }
+    }
+    return ret;
+}
+
+static constexpr size_t file_streaming_chunk_size = 128 * 1024;
+
+// Streams the component files of sst, TOC first. Resolves to false if the
+// peer rejected them, in which case their content has to be streamed as
+// mutation fragments.
+static future<bool> send_sstable_files(column_family& cf, utils::UUID plan_id, netw::messaging_service::msg_addr id, stream_reason reason, sstables::shared_sstable sst) {
+    return seastar::async([&cf, plan_id, id, reason, sst = std::move(sst)] {
+        using sink_type = rpc::sink<sstring, bytes, stream_sstable_files_cmd>;
+        auto s = cf.schema();
+        std::optional<std::tuple<sink_type, rpc::source<int32_t>>> sink_and_source;
+        try {
+            sink_and_source = netw::get_local_messaging_service().make_sink_and_source_for_stream_sstable_files(s->version(), plan_id, s->id(), reason,
+                    sstables::to_string(sst->get_version()), sstables::to_string(sst->get_format()), id).get();
+        } catch (...) {
+            sslog.info("[Stream #{}] Peer {} did not accept the files of {}, streaming its content instead: {}",
+                    plan_id, id.addr, sst->get_filename(), std::current_exception());
+            return false;
+        }
+        auto& sink = std::get<0>(*sink_and_source);
+        auto& source = std::get<1>(*sink_and_source);
+
+        bool got_error_from_peer = false;
+        auto source_op = repeat([&source, &got_error_from_peer, plan_id, id] () mutable {
+            return source().then([&got_error_from_peer, plan_id, id] (std::optional<std::tuple<int32_t>> status_opt) {
+                if (status_opt) {
+                    auto status = std::get<0>(*status_opt);
+                    got_error_from_peer = status == -1;
+                    sslog.debug("[Stream #{}] Got status code from peer={}, status={}", plan_id, id.addr, status);
+                    return stop_iteration::no;
+                }
+                return stop_iteration::yes;
+            });
+        });
+
+        auto components = sst->all_components();
+        std::stable_partition(components.begin(), components.end(), [] (auto& c) { return c.first == sstables::component_type::TOC; });
+        try {
+            for (auto& [type, name] : components) {
+                if (type == sstables::component_type::TemporaryTOC) {
+                    continue;
+                }
+                auto path = sstables::sstable::filename(sst->get_dir(), s->ks_name(), s->cf_name(), sst->get_version(), sst->generation(), sst->get_format(), name);
+                auto f = open_file_dma(path, open_flags::ro).get0();
+                file_input_stream_options options;
+                options.buffer_size = file_streaming_chunk_size;
+                options.read_ahead = 2;
+                options.io_priority_class = service::get_local_streaming_read_priority();
+                auto in = make_file_input_stream(std::move(f), 0, std::move(options));
+                std::exception_ptr ep;
+                try {
+                    while (!got_error_from_peer) {
+                        auto buf = in.read().get0();
+                        if (buf.empty()) {
+                            break;
+                        }
+                        auto size = buf.size();
+                        sink(name, bytes(reinterpret_cast<const bytes::value_type*>(buf.get()), size), stream_sstable_files_cmd::file_data).get();
+                        get_local_stream_manager().update_progress(plan_id, id.addr, progress_info::direction::OUT, size);
+                    }
+                } catch (...) {
+                    ep = std::current_exception();
+                }
+                in.close().get();
+                if (ep) {
+                    std::rethrow_exception(ep);
+                }
+            }
+            sink(sstring(), bytes(), stream_sstable_files_cmd::end_of_stream).get();
+        } catch (...) {
+            auto ep = std::current_exception();
+            // Notify the receiver the sender has failed
+            sink(sstring(), bytes(), stream_sstable_files_cmd::error).finally([&sink] {
+                return sink.close();
+            }).handle_exception([] (std::exception_ptr) { }).get();
+            source_op.handle_exception([] (std::exception_ptr) { }).get();
+            std::rethrow_exception(ep);
+        }
+        sink.close().get();
+        source_op.get();
+        if (got_error_from_peer) {
+            throw std::runtime_error(format("Peer failed to process sstable files peer={}, plan_id={}, cf_id={}", id.addr, plan_id, s->id()));
+        }
+        sslog.debug("[Stream #{}] Sent files of {} to {}", plan_id, sst->get_filename(), id.addr);
+        return true;
+    });
+}
+
+// Streams whole sstables contained in the ranges as files, returns the sstables
+// which were sent this way.
+static future<std::unordered_set<sstables::shared_sstable>> send_sstables_as_files(database& db, utils::UUID plan_id, utils::UUID cf_id,
+        const dht::token_range_vector& ranges, netw::messaging_service::msg_addr id, stream_reason reason) {
+    if (!file_streaming_allowed(db, reason) || !db.column_family_exists(cf_id)) {
+        return make_ready_future<std::unordered_set<sstables::shared_sstable>>();
+    }
+    auto& cf = db.find_column_family(cf_id);
+    auto candidates = sstables_for_file_streaming(cf, ranges);
+    if (candidates.empty()) {
+        return make_ready_future<std::unordered_set<sstables::shared_sstable>>();
+    }
+    sslog.info("[Stream #{}] Start sending files of {} sstables for ks={}, cf={}", plan_id, candidates.size(), cf.schema()->ks_name(), cf.schema()->cf_name());
+    return do_with(std::move(candidates), std::unordered_set<sstables::shared_sstable>(), [&cf, plan_id, id, reason] (auto& candidates, auto& sent) {
+        return do_for_each(candidates, [&cf, &sent, plan_id, id, reason] (const sstables::shared_sstable& sst) {
+            return send_sstable_files(cf, plan_id, id, reason, sst).then([&sent, sst] (bool accepted) {
+                if (accepted) {
+                    sent.insert(sst);
+                }
+            });
+        }).then([&sent] {
+            return std::move(sent);
+        });
+    });
+}
+
 future<> stream_transfer_task::execute() {
     auto plan_id = session->plan_id();
     auto cf_id = this->cf_id;
@@ -247,7 +397,8 @@ future<> stream_transfer_task::execute() {
     sort_and_merge_ranges();
     auto reason = session->get_reason();
     return session->get_db().invoke_on_all([plan_id, cf_id, id, dst_cpu_id, ranges=this->_ranges, reason] (database& db) {
-        auto si = make_lw_shared<send_info>(db, plan_id, cf_id, std::move(ranges), id, dst_cpu_id, reason);
+      return send_sstables_as_files(db, plan_id, cf_id, ranges, id, reason).then([&db, plan_id, cf_id, id, dst_cpu_id, ranges, reason] (std::unordered_set<sstables::shared_sstable> sent) mutable {
+        auto si = make_lw_shared<send_info>(db, plan_id, cf_id, std::move(ranges), id, dst_cpu_id, reason, std::move(sent));
         return si->has_relevant_range_on_this_shard().then([si, plan_id, cf_id] (bool has_relevant_range_on_this_shard) {
             if (!has_relevant_range_on_this_shard) {
                 sslog.debug("[Stream #{}] stream_transfer_task: cf_id={}: ignore ranges on shard={}",
@@ -260,6 +411,7 @@ future<> stream_transfer_task::execute() {
                 return send_mutations(std::move(si));
             }
         });
+      });
     }).then([this, plan_id, cf_id, id] {
         sslog.debug("[Stream #{}] SEND STREAM_MUTATION_DONE to {}, cf_id={}", plan_id, id, cf_id);
         return session->ms().send_stream_mutation_done(id, plan_id, _ranges,
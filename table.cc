@@ -35,11 +35,14 @@
 #include "service/storage_service.hh"
 #include "db/data_listeners.hh"
 #include "memtable-sstable.hh"
+#include "mutation_source_metadata.hh"
 #include "sstables/compaction_manager.hh"
 #include "db/system_keyspace.hh"
 #include "db/query_context.hh"
 #include "query-result-writer.hh"
+#include "query_result_merger.hh"
 #include "db/view/view.hh"
+#include "partition_range_compat.hh"
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/range/adaptor/transformed.hpp>
@@ -49,6 +52,8 @@ static logging::logger tlogger("table");
 static seastar::metrics::label column_family_label("cf");
 static seastar::metrics::label keyspace_label("ks");
 
+// The least amount of memtable data worth a flush sub-range of its own.
+static constexpr uint64_t memtable_flush_min_subrange_size = 128 << 20;
 
 using namespace std::chrono_literals;
 
@@ -134,12 +139,18 @@ contains_rows(const sstables::sstable& sst, const schema_ptr& schema, const ck_f
 // of a range for each clustering component.
 static std::vector<sstables::shared_sstable>
 filter_sstable_for_reader(std::vector<sstables::shared_sstable>&& sstables, column_family& cf, const schema_ptr& schema,
-        const dht::partition_range& pr, const sstables::key& key, const query::partition_slice& slice) {
+        const dht::partition_range& pr, const sstables::key& key, const query::partition_slice& slice, sstable_read_stats& read_stats) {
     const dht::ring_position& pr_key = pr.start()->value();
     auto sstable_has_not_key = [&, cmp = dht::ring_position_comparator(*schema)] (const sstables::shared_sstable& sst) {
-        return cmp(pr_key, sst->get_first_decorated_key()) < 0 ||
-               cmp(pr_key, sst->get_last_decorated_key()) > 0 ||
-               !sst->filter_has_key(key);
+        if (cmp(pr_key, sst->get_first_decorated_key()) < 0 || cmp(pr_key, sst->get_last_decorated_key()) > 0) {
+            return true;
+        }
+        ++read_stats.sstables_selected;
+        if (!sst->filter_has_key(key)) {
+            ++read_stats.sstables_filtered_by_bloom_filter;
+            return true;
+        }
+        return false;
     };
     sstables.erase(boost::remove_if(sstables, sstable_has_not_key), sstables.end());
 
@@ -166,6 +177,7 @@ filter_sstable_for_reader(std::vector<sstables::shared_sstable>&& sstables, colu
     }
     auto ranges = ranges_for_clustering_key_filter(schema, ck_filtering_all_ranges);
     if (ranges.empty()) {
+        read_stats.sstables_filtered_by_clustering_filter += sstables.size();
         return {};
     }
 
@@ -185,6 +197,7 @@ filter_sstable_for_reader(std::vector<sstables::shared_sstable>&& sstables, colu
     };
     auto skipped = std::partition(sstables.begin(), sstables.end(), sstable_has_clustering_key);
     auto actually_skipped = std::partition(skipped, sstables.end(), sstable_has_relevant_tombstone);
+    read_stats.sstables_filtered_by_clustering_filter += std::distance(actually_skipped, sstables.end());
     sstables.erase(actually_skipped, sstables.end());
     stats->surviving_sstables_after_clustering_filter += sstables.size();
 
@@ -286,8 +299,10 @@ create_single_key_sstable_reader(column_family* cf,
                                  mutation_reader::forwarding fwd_mr)
 {
     auto key = sstables::key::from_partition_key(*schema, *pr.start()->value().key());
+    sstable_read_stats untracked_read_stats;
+    auto& read_stats = permit.read_stats() ? *permit.read_stats() : untracked_read_stats;
     auto readers = boost::copy_range<std::vector<flat_mutation_reader>>(
-        filter_sstable_for_reader(sstables->select(pr), *cf, schema, pr, key, slice)
+        filter_sstable_for_reader(sstables->select(pr), *cf, schema, pr, key, slice, read_stats)
         | boost::adaptors::transformed([&] (const sstables::shared_sstable& sstable) {
             tracing::trace(trace_state, "Reading key {} from sstable {}", pr, seastar::value_of([&sstable] { return sstable->get_filename(); }));
             return sstable->read_row_flat(schema, permit, pr.start()->value(), slice, pc, trace_state, fwd);
@@ -296,6 +311,7 @@ create_single_key_sstable_reader(column_family* cf,
     if (readers.empty()) {
         return make_empty_flat_reader(schema);
     }
+    read_stats.sstables_read += readers.size();
     sstable_histogram.add(readers.size());
     return make_combined_reader(schema, std::move(readers), fwd, fwd_mr);
 }
@@ -313,6 +329,10 @@ flat_mutation_reader make_range_sstable_reader(schema_ptr s,
 {
     auto reader_factory_fn = [s, permit, &slice, &pc, trace_state, fwd, fwd_mr, &monitor_generator]
             (sstables::shared_sstable& sst, const dht::partition_range& pr) mutable {
+        if (auto* read_stats = permit.read_stats()) {
+            ++read_stats->sstables_selected;
+            ++read_stats->sstables_read;
+        }
         return sst->read_range_rows_flat(s, permit, pr, slice, pc, trace_state, fwd, fwd_mr, monitor_generator(sst));
     };
     return make_combined_reader(s, std::make_unique<incremental_reader_selector>(s,
@@ -324,6 +344,65 @@ flat_mutation_reader make_range_sstable_reader(schema_ptr s,
             fwd_mr);
 }
 
+// Reports the read amplification accumulated in the permit of an sstable
+// read, see sstable_read_stats: to tracing once the read reaches the end of
+// the stream, and to the per-table histograms when it is destroyed.
+class sstable_read_accounting_reader final : public delegating_reader<flat_mutation_reader> {
+    reader_permit _permit;
+    table_stats& _stats;
+    tracing::trace_state_ptr _trace_state;
+    bool _traced = false;
+    // Memory footprint of the fragments read, i.e. the logical size of the read.
+    uint64_t _read_size = 0;
+public:
+    sstable_read_accounting_reader(flat_mutation_reader rd, reader_permit permit, table_stats& stats, tracing::trace_state_ptr trace_state)
+        : delegating_reader(std::move(rd))
+        , _permit(std::move(permit))
+        , _stats(stats)
+        , _trace_state(std::move(trace_state)) {
+    }
+    ~sstable_read_accounting_reader() {
+        auto& rs = *_permit.read_stats();
+        if (rs.sstables_selected) {
+            _stats.estimated_sstables_filtered_by_bloom_filter_per_read.add(rs.sstables_filtered_by_bloom_filter);
+            _stats.estimated_sstables_filtered_by_clustering_filter_per_read.add(rs.sstables_filtered_by_clustering_filter);
+            _stats.estimated_sstable_bytes_per_read.add(rs.bytes_read);
+            _stats.estimated_sstable_read_size.add(_read_size);
+        }
+    }
+    virtual future<> fill_buffer(db::timeout_clock::time_point timeout) override {
+        auto buffered = flat_mutation_reader::impl::buffer_size();
+        return delegating_reader::fill_buffer(timeout).then([this, buffered] {
+            _read_size += flat_mutation_reader::impl::buffer_size() - buffered;
+            if (is_end_of_stream() && !std::exchange(_traced, true)) {
+                auto& rs = *_permit.read_stats();
+                tracing::trace(_trace_state, "Read {} of {} sstables ({} filtered by Bloom filter, {} by clustering filter), {} bytes in {} requests",
+                        rs.sstables_read, rs.sstables_selected, rs.sstables_filtered_by_bloom_filter, rs.sstables_filtered_by_clustering_filter,
+                        rs.bytes_read, rs.read_requests);
+            }
+        });
+    }
+};
+
+static flat_mutation_reader make_sstable_read_accounting_reader(flat_mutation_reader rd, reader_permit permit, table_stats& stats,
+        tracing::trace_state_ptr trace_state) {
+    if (!permit) {
+        return rd;
+    }
+    return make_flat_mutation_reader<sstable_read_accounting_reader>(std::move(rd), std::move(permit), stats, std::move(trace_state));
+}
+
+reader_concurrency_semaphore* table::read_concurrency_semaphore_for(scheduling_group sg) const {
+    if (_config.scheduling_group_semaphores) {
+        for (auto& sgs : *_config.scheduling_group_semaphores) {
+            if (sgs.sg == sg) {
+                return sgs.semaphore.get();
+            }
+        }
+    }
+    return _config.read_concurrency_semaphore;
+}
+
 flat_mutation_reader
 table::make_sstable_reader(schema_ptr s,
                                    lw_shared_ptr<sstables::sstable_set> sstables,
@@ -332,10 +411,11 @@ table::make_sstable_reader(schema_ptr s,
                                    const io_priority_class& pc,
                                    tracing::trace_state_ptr trace_state,
                                    streamed_mutation::forwarding fwd,
-                                   mutation_reader::forwarding fwd_mr) const {
+                                   mutation_reader::forwarding fwd_mr,
+                                   reader_permit permit) const {
     auto* semaphore = service::get_local_streaming_read_priority().id() == pc.id()
         ? _config.streaming_read_concurrency_semaphore
-        : _config.read_concurrency_semaphore;
+        : read_concurrency_semaphore_for(current_scheduling_group());
 
     // CAVEAT: if make_sstable_reader() is called on a single partition
     // we want to optimize and read exactly this partition. As a
@@ -367,11 +447,12 @@ table::make_sstable_reader(schema_ptr s,
                     tracing::trace_state_ptr trace_state,
                     streamed_mutation::forwarding fwd,
                     mutation_reader::forwarding fwd_mr) {
-                return create_single_key_sstable_reader(const_cast<column_family*>(this), std::move(s), std::move(permit), std::move(sstables),
-                        _stats.estimated_sstable_per_read, pr, slice, pc, std::move(trace_state), fwd, fwd_mr);
+                auto rd = create_single_key_sstable_reader(const_cast<column_family*>(this), s, permit, std::move(sstables),
+                        _stats.estimated_sstable_per_read, pr, slice, pc, trace_state, fwd, fwd_mr);
+                return make_sstable_read_accounting_reader(std::move(rd), std::move(permit), _stats, std::move(trace_state));
             });
         } else {
-            return mutation_source([semaphore, sstables=std::move(sstables)] (
+            return mutation_source([semaphore, this, sstables=std::move(sstables)] (
                     schema_ptr s,
                     reader_permit permit,
                     const dht::partition_range& pr,
@@ -380,13 +461,16 @@ table::make_sstable_reader(schema_ptr s,
                     tracing::trace_state_ptr trace_state,
                     streamed_mutation::forwarding fwd,
                     mutation_reader::forwarding fwd_mr) {
-                return make_local_shard_sstable_reader(std::move(s), std::move(permit), std::move(sstables), pr, slice, pc,
-                        std::move(trace_state), fwd, fwd_mr);
+                auto rd = make_local_shard_sstable_reader(std::move(s), permit, std::move(sstables), pr, slice, pc,
+                        trace_state, fwd, fwd_mr);
+                return make_sstable_read_accounting_reader(std::move(rd), std::move(permit), _stats, std::move(trace_state));
             });
         }
     }();
 
-    if (semaphore) {
+    if (permit) {
+        return ms.make_reader(std::move(s), std::move(permit), pr, slice, pc, std::move(trace_state), fwd, fwd_mr);
+    } else if (semaphore) {
         return make_restricted_flat_reader(*semaphore, std::move(ms), std::move(s), pr, slice, pc, std::move(trace_state), fwd, fwd_mr);
     } else {
         return ms.make_reader(std::move(s), no_reader_permit(), pr, slice, pc, std::move(trace_state), fwd, fwd_mr);
@@ -436,9 +520,10 @@ table::make_reader(schema_ptr s,
                            const io_priority_class& pc,
                            tracing::trace_state_ptr trace_state,
                            streamed_mutation::forwarding fwd,
-                           mutation_reader::forwarding fwd_mr) const {
+                           mutation_reader::forwarding fwd_mr,
+                           reader_permit permit) const {
     if (_virtual_reader) {
-        return (*_virtual_reader).make_reader(s, no_reader_permit(), range, slice, pc, trace_state, fwd, fwd_mr);
+        return (*_virtual_reader).make_reader(s, std::move(permit), range, slice, pc, trace_state, fwd, fwd_mr);
     }
 
     std::vector<flat_mutation_reader> readers;
@@ -469,12 +554,13 @@ table::make_reader(schema_ptr s,
     }
 
     if (_config.enable_cache && !slice.options.contains(query::partition_slice::option::bypass_cache)) {
-        readers.emplace_back(_cache.make_reader(s, range, slice, pc, std::move(trace_state), fwd, fwd_mr));
+        readers.emplace_back(_cache.make_reader(s, range, slice, pc, std::move(trace_state), fwd, fwd_mr, std::move(permit)));
     } else {
-        readers.emplace_back(make_sstable_reader(s, _sstables, range, slice, pc, std::move(trace_state), fwd, fwd_mr));
+        readers.emplace_back(make_sstable_reader(s, _sstables, range, slice, pc, std::move(trace_state), fwd, fwd_mr, std::move(permit)));
     }
 
-    auto comb_reader = make_combined_reader(s, std::move(readers), fwd, fwd_mr);
+    auto comb_reader = make_activity_tagging_reader(make_combined_reader(s, std::move(readers), fwd, fwd_mr),
+            make_activity(utils::activity_type::read));
     if (_config.data_listeners && !_config.data_listeners->empty()) {
         return _config.data_listeners->on_read(s, range, slice, std::move(comb_reader));
     } else {
@@ -512,6 +598,38 @@ table::make_streaming_reader(schema_ptr s,
     return make_flat_multi_range_reader(s, std::move(source), ranges, slice, pc, nullptr, mutation_reader::forwarding::no);
 }
 
+flat_mutation_reader
+table::make_streaming_reader(schema_ptr s,
+                           const dht::partition_range_vector& ranges,
+                           std::unordered_set<sstables::shared_sstable> excluded) const {
+    if (excluded.empty()) {
+        return make_streaming_reader(std::move(s), ranges);
+    }
+    auto& slice = s->full_slice();
+    auto& pc = service::get_local_streaming_read_priority();
+
+    auto source = mutation_source([this, excluded = std::move(excluded)] (schema_ptr s, reader_permit, const dht::partition_range& range, const query::partition_slice& slice,
+                                      const io_priority_class& pc, tracing::trace_state_ptr trace_state, streamed_mutation::forwarding fwd, mutation_reader::forwarding fwd_mr) {
+        // Filter the current set rather than a snapshot taken at creation
+        // of the reader, so that sstables flushed in the meantime are read.
+        auto sstables = make_lw_shared(_compaction_strategy.make_sstable_set(_schema));
+        for (auto& sst : *_sstables->all()) {
+            if (!excluded.count(sst)) {
+                sstables->insert(sst);
+            }
+        }
+        std::vector<flat_mutation_reader> readers;
+        readers.reserve(_memtables->size() + 1);
+        for (auto&& mt : *_memtables) {
+            readers.emplace_back(mt->make_flat_reader(s, range, slice, pc, trace_state, fwd, fwd_mr));
+        }
+        readers.emplace_back(make_sstable_reader(s, std::move(sstables), range, slice, pc, std::move(trace_state), fwd, fwd_mr));
+        return make_combined_reader(s, std::move(readers), fwd, fwd_mr);
+    });
+
+    return make_flat_multi_range_reader(s, std::move(source), ranges, slice, pc, nullptr, mutation_reader::forwarding::no);
+}
+
 flat_mutation_reader table::make_streaming_reader(schema_ptr schema, const dht::partition_range& range,
         const query::partition_slice& slice, mutation_reader::forwarding fwd_mr) const {
     const auto& pc = service::get_local_streaming_read_priority();
@@ -527,6 +645,27 @@ flat_mutation_reader table::make_streaming_reader(schema_ptr schema, const dht::
     return make_combined_reader(std::move(schema), std::move(readers), fwd, fwd_mr);
 }
 
+flat_mutation_reader table::make_unrepaired_streaming_reader(schema_ptr schema, const dht::partition_range& range,
+        const query::partition_slice& slice, mutation_reader::forwarding fwd_mr) const {
+    const auto& pc = service::get_local_streaming_read_priority();
+    auto trace_state = tracing::trace_state_ptr();
+    const auto fwd = streamed_mutation::forwarding::no;
+
+    auto sstables = make_lw_shared(_compaction_strategy.make_sstable_set(_schema));
+    for (auto& sst : *_sstables->all()) {
+        if (!sst->is_repaired()) {
+            sstables->insert(sst);
+        }
+    }
+    std::vector<flat_mutation_reader> readers;
+    readers.reserve(_memtables->size() + 1);
+    for (auto&& mt : *_memtables) {
+        readers.emplace_back(mt->make_flat_reader(schema, range, slice, pc, trace_state, fwd, fwd_mr));
+    }
+    readers.emplace_back(make_sstable_reader(schema, std::move(sstables), range, slice, pc, std::move(trace_state), fwd, fwd_mr));
+    return make_combined_reader(std::move(schema), std::move(readers), fwd, fwd_mr);
+}
+
 future<std::vector<locked_cell>> table::lock_counter_cells(const mutation& m, db::timeout_clock::time_point timeout) {
     assert(m.schema() == _counter_cell_locks->schema());
     return _counter_cell_locks->lock_cells(m.decorated_key(), partition_cells_range(m.partition()), timeout);
@@ -584,6 +723,10 @@ flat_mutation_reader make_local_shard_sstable_reader(schema_ptr s,
 {
     auto reader_factory_fn = [s, permit, &slice, &pc, trace_state, fwd, fwd_mr, &monitor_generator]
             (sstables::shared_sstable& sst, const dht::partition_range& pr) mutable {
+        if (auto* read_stats = permit.read_stats()) {
+            ++read_stats->sstables_selected;
+            ++read_stats->sstables_read;
+        }
         flat_mutation_reader reader = sst->read_range_rows_flat(s, permit, pr, slice, pc,
                 trace_state, fwd, fwd_mr, monitor_generator(sst));
         if (sst->is_shared()) {
@@ -649,7 +792,7 @@ table::open_sstable(sstables::foreign_sstable_open_info info, sstring dir, int64
 
 void table::load_sstable(sstables::shared_sstable& sst, bool reset_level) {
     auto& shards = sst->get_shards_for_this_sstable();
-    if (belongs_to_other_shard(shards)) {
+    if (belongs_to_other_shard(shards) && shards.size() > _config.shared_sstable_reshard_threshold) {
         // If we're here, this sstable is shared by this and other
         // shard(s). Shared sstables cannot be deleted until all
         // shards compacted them, so to reduce disk space usage we
@@ -658,6 +801,11 @@ void table::load_sstable(sstables::shared_sstable& sst, bool reset_level) {
         // the sstables belonging to this CF, because we need all of
         // them to know which tombstones we can drop, and what
         // generation number is free.
+        //
+        // Sstables shared by few shards are not worth a rewrite of
+        // their own, each owner compacts its part away instead. Reads
+        // of the sstable, resharding's included, skip the data of the
+        // owners which did (see sstable::load_released_owners()).
         _sstables_need_rewrite.emplace(sst->generation(), sst);
     }
     if (reset_level) {
@@ -681,9 +829,9 @@ void table::update_stats_for_new_sstable(uint64_t disk_space_used_by_sstable, co
 }
 
 inline void table::add_sstable_to_backlog_tracker(compaction_backlog_tracker& tracker, sstables::shared_sstable sstable) {
-    // Don't add sstables that belong to more than one shard to the table's backlog tracker
-    // given that such sstables are supposed to be tracked only by resharding's own tracker.
-    if (!sstable->is_shared()) {
+    // Don't add sstables that need resharding to the table's backlog tracker given that
+    // such sstables are supposed to be tracked only by resharding's own tracker.
+    if (!_sstables_need_rewrite.count(sstable->generation())) {
         tracker.add_sstable(sstable);
     }
 }
@@ -693,6 +841,7 @@ void table::add_sstable(sstables::shared_sstable sstable, const std::vector<unsi
     auto new_sstables = make_lw_shared(*_sstables);
     new_sstables->insert(sstable);
     _sstables = std::move(new_sstables);
+    add_sstable_to_size_estimates(sstable);
     update_stats_for_new_sstable(sstable->bytes_on_disk(), shards_for_the_sstable);
     if (sstable->requires_view_building()) {
         _sstables_staging.emplace(sstable->generation(), sstable);
@@ -712,11 +861,15 @@ table::add_sstable_and_update_cache(sstables::shared_sstable sst) {
 }
 
 future<>
-table::update_cache(lw_shared_ptr<memtable> m, sstables::shared_sstable sst) {
-    auto adder = [this, m, sst] {
-        auto newtab_ms = sst->as_mutation_source();
-        add_sstable(sst, {this_shard_id()});
-        m->mark_flushed(std::move(newtab_ms));
+table::update_cache(lw_shared_ptr<memtable> m, std::vector<sstables::shared_sstable> ssts) {
+    auto adder = [this, m, ssts = std::move(ssts)] {
+        auto sources = boost::copy_range<std::vector<mutation_source>>(ssts
+                | boost::adaptors::transformed(std::mem_fn(&sstables::sstable::as_mutation_source)));
+        auto newtabs_ms = sources.size() == 1 ? std::move(sources.front()) : make_combined_mutation_source(std::move(sources));
+        for (auto& sst : ssts) {
+            add_sstable(sst, {this_shard_id()});
+        }
+        m->mark_flushed(std::move(newtabs_ms));
         try_trigger_compaction();
     };
     if (_config.enable_cache) {
@@ -812,12 +965,6 @@ table::seal_active_streaming_memtable_immediate(flush_permit&& permit) {
     auto guard = _streaming_flush_phaser.start();
     return with_gate(_streaming_flush_gate, [this, old, permit = std::move(permit)] () mutable {
         return with_lock(_sstables_lock.for_read(), [this, old, permit = std::move(permit)] () mutable {
-            auto newtab = make_sstable();
-
-            newtab->set_unshared();
-
-            tlogger.debug("Flushing to {}", newtab->get_filename());
-
             // This is somewhat similar to the main memtable flush, but with important differences.
             //
             // The first difference, is that we don't keep aggregate collectd statistics about this one.
@@ -827,19 +974,22 @@ table::seal_active_streaming_memtable_immediate(flush_permit&& permit) {
             // Lastly, we don't have any commitlog RP to update, and we don't need to deal manipulate the
             // memtable list, since this memtable was not available for reading up until this point.
             auto fp = permit.release_sstable_write_permit();
-            database_sstable_write_monitor monitor(std::move(fp), newtab, _compaction_manager, _compaction_strategy, old->get_max_timestamp());
-            return do_with(std::move(monitor), [this, newtab, old, permit = std::move(permit)] (auto& monitor) mutable {
+            return do_with(std::vector<monitored_sstable>(), [this, old, fp = std::move(fp), permit = std::move(permit)] (auto& newtabs) mutable {
                 auto&& priority = service::get_local_streaming_write_priority();
                 sstables::sstable_writer_config cfg = get_sstables_manager().configure_writer();
                 cfg.backup = incremental_backups_enabled();
-                return write_memtable_to_sstable(*old, newtab, monitor, cfg, priority).then([this, newtab, old] {
-                    return newtab->open_data();
-                }).then([this, old, newtab] () {
-                    return with_scheduling_group(_config.memtable_to_cache_scheduling_group, [this, newtab, old] {
-                      auto adder = [this, newtab] {
-                          add_sstable(newtab, {this_shard_id()});
+                return write_memtable_to_sstables(*old, newtabs, std::move(fp), cfg, priority).then([&newtabs] {
+                    return parallel_for_each(newtabs, [] (monitored_sstable& m) {
+                        return m.sstable->open_data();
+                    });
+                }).then([this, old, &newtabs] () {
+                    return with_scheduling_group(_config.memtable_to_cache_scheduling_group, [this, old, &newtabs] {
+                      auto adder = [this, &newtabs] {
+                          for (auto& m : newtabs) {
+                              add_sstable(m.sstable, {this_shard_id()});
+                              tlogger.debug("Flushing to {} done", m.sstable->get_filename());
+                          }
                           try_trigger_compaction();
-                          tlogger.debug("Flushing to {} done", newtab->get_filename());
                       };
                       if (_config.enable_cache) {
                         return _cache.update_invalidating(adder, *old);
@@ -848,9 +998,11 @@ table::seal_active_streaming_memtable_immediate(flush_permit&& permit) {
                         return old->clear_gently();
                       }
                     });
-                }).handle_exception([old, permit = std::move(permit), &monitor, newtab] (auto ep) {
-                    monitor.write_failed();
-                    newtab->mark_for_deletion();
+                }).handle_exception([old, permit = std::move(permit), &newtabs] (auto ep) {
+                    for (auto& m : newtabs) {
+                        m.monitor->write_failed();
+                        m.sstable->mark_for_deletion();
+                    }
                     tlogger.error("failed to write streamed sstable: {}", ep);
                     return make_exception_future<>(ep);
                 });
@@ -873,24 +1025,22 @@ future<> table::seal_active_streaming_memtable_big(streaming_memtable_big& smb,
     return with_gate(_streaming_flush_gate, [this, old, &smb, permit = std::move(permit)] () mutable {
         return with_gate(smb.flush_in_progress, [this, old, &smb, permit = std::move(permit)] () mutable {
             return with_lock(_sstables_lock.for_read(), [this, old, &smb, permit = std::move(permit)] () mutable {
-                auto newtab = make_sstable();
-
-                newtab->set_unshared();
-
                 auto fp = permit.release_sstable_write_permit();
-                auto monitor = std::make_unique<database_sstable_write_monitor>(std::move(fp), newtab, _compaction_manager, _compaction_strategy, old->get_max_timestamp());
                 auto&& priority = service::get_local_streaming_write_priority();
                 sstables::sstable_writer_config cfg = get_sstables_manager().configure_writer();
                 cfg.backup = incremental_backups_enabled();
                 cfg.leave_unsealed = true;
-                auto fut = write_memtable_to_sstable(*old, newtab, *monitor, cfg, priority);
-                return fut.then_wrapped([this, newtab, old, &smb, permit = std::move(permit), monitor = std::move(monitor)] (future<> f) mutable {
+                auto newtabs = std::make_unique<std::vector<monitored_sstable>>();
+                auto fut = write_memtable_to_sstables(*old, *newtabs, std::move(fp), cfg, priority);
+                return fut.then_wrapped([this, old, &smb, permit = std::move(permit), newtabs = std::move(newtabs)] (future<> f) mutable {
                     if (!f.failed()) {
-                        smb.sstables.push_back(monitored_sstable{std::move(monitor), newtab});
+                        std::move(newtabs->begin(), newtabs->end(), std::back_inserter(smb.sstables));
                         return make_ready_future<>();
                     } else {
-                        monitor->write_failed();
-                        newtab->mark_for_deletion();
+                        for (auto& m : *newtabs) {
+                            m.monitor->write_failed();
+                            m.sstable->mark_for_deletion();
+                        }
                         auto ep = f.get_exception();
                         tlogger.error("failed to write streamed sstable: {}", ep);
                         return make_exception_future<>(ep);
@@ -958,13 +1108,50 @@ table::seal_active_memtable(flush_permit&& permit) {
     // FIXME: provide back-pressure to upper layers
 }
 
+future<>
+table::write_memtable_to_sstables(memtable& mt, std::vector<monitored_sstable>& ssts, sstable_write_permit&& permit,
+        sstables::sstable_writer_config cfg, const io_priority_class& pc) {
+    mt.apply_pending();
+    auto metadata = mutation_source_metadata{mt.get_encoding_stats().min_timestamp, mt.get_max_timestamp()};
+    // Large memtables are split into token sub-ranges written concurrently.
+    // All sstables share the run identifier of cfg, so the sub-ranges form
+    // a single run.
+    auto subranges = std::min<uint64_t>(_config.memtable_flush_max_parallel_subranges(),
+            mt.occupancy().used_space() / memtable_flush_min_subrange_size);
+    auto ranges = mt.split_for_flush(subranges);
+    if (ranges.size() > 1) {
+        tlogger.debug("Flushing memtable of {}.{} in {} sub-ranges", _schema->ks_name(), _schema->cf_name(), ranges.size());
+    }
+    auto estimated_partitions = _compaction_strategy.adjust_partition_estimate(metadata, mt.partition_count() / ranges.size());
+    cfg.replay_position = mt.replay_position();
+    return do_with(std::move(ranges), std::move(permit), std::move(cfg),
+            [this, &mt, &ssts, &pc, metadata, estimated_partitions] (auto& ranges, sstable_write_permit& permit, auto& cfg) {
+      return parallel_for_each(ranges, [this, &mt, &ssts, &pc, &permit, &cfg, metadata, estimated_partitions] (const dht::partition_range& range) {
+        auto consumer = _compaction_strategy.make_interposer_consumer(metadata,
+                [this, &mt, &ssts, &permit, &cfg, &pc, estimated_partitions] (flat_mutation_reader reader) mutable {
+            auto newtab = make_sstable();
+            newtab->set_unshared();
+            tlogger.debug("Flushing to {}", newtab->get_filename());
+            // The permit is released once the first sstable is written, which is
+            // enough to let the next flush start while this one completes.
+            auto monitor = std::make_unique<database_sstable_write_monitor>(std::exchange(permit, sstable_write_permit::unconditional()),
+                    newtab, _compaction_manager, _compaction_strategy, mt.get_max_timestamp());
+            auto writer_cfg = cfg;
+            writer_cfg.monitor = monitor.get();
+            writer_cfg.activity = make_activity(utils::activity_type::flush);
+            ssts.push_back(monitored_sstable{std::move(monitor), newtab});
+            auto s = reader.schema();
+            return newtab->write_components(std::move(reader), std::max(uint64_t(1), estimated_partitions), std::move(s), writer_cfg, mt.get_encoding_stats(), pc);
+        });
+        return consumer(make_activity_tagging_reader(mt.make_flush_reader(mt.schema(), range, pc),
+                make_activity(utils::activity_type::flush)));
+      });
+    });
+}
+
 future<stop_iteration>
 table::try_flush_memtable_to_sstable(lw_shared_ptr<memtable> old, sstable_write_permit&& permit) {
   return with_scheduling_group(_config.memtable_scheduling_group, [this, old = std::move(old), permit = std::move(permit)] () mutable {
-    auto newtab = make_sstable();
-
-    newtab->set_unshared();
-    tlogger.debug("Flushing to {}", newtab->get_filename());
     // Note that due to our sharded architecture, it is possible that
     // in the face of a value change some shards will backup sstables
     // while others won't.
@@ -976,32 +1163,40 @@ table::try_flush_memtable_to_sstable(lw_shared_ptr<memtable> old, sstable_write_
     //
     // The code as is guarantees that we'll never partially backup a
     // single sstable, so that is enough of a guarantee.
-    database_sstable_write_monitor monitor(std::move(permit), newtab, _compaction_manager, _compaction_strategy, old->get_max_timestamp());
-    return do_with(std::move(monitor), [this, old, newtab] (auto& monitor) {
+    return do_with(std::vector<monitored_sstable>(), [this, old, permit = std::move(permit)] (auto& newtabs) mutable {
         auto&& priority = service::get_local_memtable_flush_priority();
         sstables::sstable_writer_config cfg = get_sstables_manager().configure_writer();
         cfg.backup = incremental_backups_enabled();
-        auto f = write_memtable_to_sstable(*old, newtab, monitor, cfg, priority);
+        // Writes buffered by the append-only ingest mode are inserted before the
+        // flush splits the memtable and takes its statistics.
+        auto f = old->apply_pending_gently().then([this, old, &newtabs, permit = std::move(permit), cfg, &priority] () mutable {
+            return write_memtable_to_sstables(*old, newtabs, std::move(permit), cfg, priority);
+        });
         // Switch back to default scheduling group for post-flush actions, to avoid them being staved by the memtable flush
         // controller. Cache update does not affect the input of the memtable cpu controller, so it can be subject to
         // priority inversion.
-        return with_scheduling_group(default_scheduling_group(), [this, &monitor, old = std::move(old), newtab = std::move(newtab), f = std::move(f)] () mutable {
-            return f.then([this, newtab, old, &monitor] {
-                return newtab->open_data().then([this, old, newtab] () {
-                    tlogger.debug("Flushing to {} done", newtab->get_filename());
-                    return with_scheduling_group(_config.memtable_to_cache_scheduling_group, [this, old, newtab] {
-                        return update_cache(old, newtab);
+        return with_scheduling_group(default_scheduling_group(), [this, &newtabs, old = std::move(old), f = std::move(f)] () mutable {
+            return f.then([this, old, &newtabs] {
+                return parallel_for_each(newtabs, [] (monitored_sstable& m) {
+                    return m.sstable->open_data();
+                }).then([this, old, &newtabs] () {
+                    tlogger.debug("Flushing memtable of {}.{} to {} sstable(s) done", _schema->ks_name(), _schema->cf_name(), newtabs.size());
+                    return with_scheduling_group(_config.memtable_to_cache_scheduling_group, [this, old, &newtabs] {
+                        return update_cache(old, boost::copy_range<std::vector<sstables::shared_sstable>>(newtabs
+                                | boost::adaptors::transformed(std::mem_fn(&monitored_sstable::sstable))));
                     });
-                }).then([this, old, newtab] () noexcept {
+                }).then([this, old] () noexcept {
                     _memtables->erase(old);
-                    tlogger.debug("Memtable for {} replaced", newtab->get_filename());
+                    tlogger.debug("Memtable of {}.{} replaced", _schema->ks_name(), _schema->cf_name());
                     return stop_iteration::yes;
                 });
-            }).handle_exception([this, old, newtab, &monitor] (auto e) {
-                monitor.write_failed();
-                newtab->mark_for_deletion();
+            }).handle_exception([this, old, &newtabs] (auto e) {
+                tlogger.error("failed to flush memtable of {}.{}: {}", _schema->ks_name(), _schema->cf_name(), e);
+                for (auto& m : newtabs) {
+                    m.monitor->write_failed();
+                    m.sstable->mark_for_deletion();
+                }
                 _config.cf_stats->failed_memtables_flushes_count++;
-                tlogger.error("failed to write sstable {}: {}", newtab->get_filename(), e);
                 // If we failed this write we will try the write again and that will create a new flush reader
                 // that will decrease dirty memory again. So we need to reset the accounting.
                 old->revert_flushed_memory();
@@ -1126,6 +1321,20 @@ void table::set_metrics() {
         add_row_lock_metrics(_row_locker_stats.exclusive_partition, "exclusive_partition");
         add_row_lock_metrics(_row_locker_stats.shared_partition, "shared_partition");
 
+        // Reactor stalls attributed to this table, see utils/activity.hh
+        if (utils::stall_attribution_enabled()) {
+            static const ms::label activity_label("activity");
+            for (size_t type = 1; type < utils::activity_type_count; ++type) {
+                auto activity = activity_label(sstring(utils::to_string(utils::activity_type(type))));
+                _metrics.add_group("column_family", {
+                    ms::make_counter("reactor_stalls", [this, type] { return _stats.stalls.reports[type]; },
+                            ms::description("Number of times work on this table ran without yielding for longer than the stall threshold"))(cf)(ks)(activity),
+                    ms::make_counter("reactor_stall_time_ms", [this, type] { return _stats.stalls.stall_time_ms[type]; },
+                            ms::description("Time work on this table ran for without yielding, counting only runs longer than the stall threshold"))(cf)(ks)(activity),
+                });
+            }
+        }
+
         // View metrics are created only for base tables, so there's no point in adding them to views (which cannot act as base tables for other views)
         if (!_schema->is_view()) {
             _view_stats.register_stats();
@@ -1138,6 +1347,10 @@ void table::set_metrics() {
                     ms::make_histogram("cas_prepare_latency", ms::description("CAS prepare round latency histogram"), [this] {return _stats.estimated_cas_prepare.get_histogram(std::chrono::microseconds(100));})(cf)(ks),
                     ms::make_histogram("cas_propose_latency", ms::description("CAS propose round latency histogram"), [this] {return _stats.estimated_cas_propose.get_histogram(std::chrono::microseconds(100));})(cf)(ks),
                     ms::make_histogram("cas_commit_latency", ms::description("CAS commit round latency histogram"), [this] {return _stats.estimated_cas_commit.get_histogram(std::chrono::microseconds(100));})(cf)(ks),
+                    ms::make_histogram("sstables_per_read", ms::description("Histogram of the number of sstables read by single partition reads"), [this] {return _stats.estimated_sstable_per_read.get_histogram(1, 10);})(cf)(ks),
+                    ms::make_histogram("sstables_filtered_by_bloom_filter_per_read", ms::description("Histogram of the number of sstables skipped by reads thanks to their Bloom filter"), [this] {return _stats.estimated_sstables_filtered_by_bloom_filter_per_read.get_histogram(1, 10);})(cf)(ks),
+                    ms::make_histogram("sstables_filtered_by_clustering_filter_per_read", ms::description("Histogram of the number of sstables skipped by reads thanks to their clustering ranges"), [this] {return _stats.estimated_sstables_filtered_by_clustering_filter_per_read.get_histogram(1, 10);})(cf)(ks),
+                    ms::make_histogram("sstable_bytes_per_read", ms::description("Histogram of the number of bytes read from sstable data and index files by reads"), [this] {return _stats.estimated_sstable_bytes_per_read.get_histogram(1024, 15);})(cf)(ks),
                     ms::make_gauge("cache_hit_rate", ms::description("Cache hit rate"), [this] {return float(_global_cache_hit_rate);})(cf)(ks)
             });
         }
@@ -1176,6 +1389,7 @@ table::rebuild_sstable_list(const std::vector<sstables::shared_sstable>& new_sst
         }
     }
     _sstables = make_lw_shared(std::move(new_sstable_list));
+    drop_size_estimates();
 }
 
 // Note: must run in a seastar thread
@@ -1192,10 +1406,12 @@ table::on_compaction_completion(sstables::compaction_completion_desc& desc) {
     // if the deletion fails (note deletion of shared sstables can take
     // unbounded time, because all shards must agree on the deletion).
 
-    // make sure all old sstables belong *ONLY* to current shard before we proceed to their deletion.
+    // make sure all old sstables belong to current shard before we proceed to their deletion.
+    // Shared sstables kept out of resharding (see load_sstable()) are compacted separately by
+    // each owner, which only reads its own part of them.
     for (auto& sst : desc.input_sstables) {
-        auto shards = sst->get_shards_for_this_sstable();
-        if (shards.size() > 1) {
+        auto& shards = sst->get_shards_for_this_sstable();
+        if (shards.size() > 1 && _sstables_need_rewrite.count(sst->generation())) {
             throw std::runtime_error(format("A regular compaction for {}.{} INCORRECTLY used shared sstable {}. Only resharding work with those!",
                 _schema->ks_name(), _schema->cf_name(), sst->toc_filename()));
         }
@@ -1223,8 +1439,23 @@ table::on_compaction_completion(sstables::compaction_completion_desc& desc) {
     rebuild_statistics();
 
     auto f = seastar::with_gate(_sstable_deletion_gate, [this, sstables_to_remove = desc.input_sstables] {
-       return with_semaphore(_sstable_deletion_sem, 1, [sstables_to_remove = std::move(sstables_to_remove)] {
-           return sstables::delete_atomically(std::move(sstables_to_remove));
+       return with_semaphore(_sstable_deletion_sem, 1, [sstables_to_remove = std::move(sstables_to_remove)] () mutable {
+           // Shared sstables are deleted by the last of their owners to compact them.
+           std::vector<sstables::shared_sstable> shared_sstables;
+           auto e = boost::range::remove_if(sstables_to_remove, [&] (const sstables::shared_sstable& sst) {
+               if (sst->is_shared()) {
+                   shared_sstables.push_back(sst);
+                   return true;
+               }
+               return false;
+           });
+           sstables_to_remove.erase(e, sstables_to_remove.end());
+           // The releases are persisted first: once the other inputs are gone, the
+           // tombstones they held no longer shadow the data of this shard left in
+           // the shared sstables.
+           return sstables::release_shared_sstables(std::move(shared_sstables)).then([sstables_to_remove = std::move(sstables_to_remove)] () mutable {
+               return sstables::delete_atomically(std::move(sstables_to_remove));
+           });
        });
     });
 
@@ -1294,8 +1525,20 @@ table::compact_sstables(sstables::compaction_descriptor descriptor) {
     }
 
     return with_lock(_sstables_lock.for_read(), [this, descriptor = std::move(descriptor)] () mutable {
-        descriptor.creator = [this] (shard_id dummy) {
-                auto sst = make_sstable();
+        descriptor.max_parallel_subranges = compaction_max_parallel_subranges();
+        auto datadir = _config.datadir;
+        if (!_config.slow_datadirs.empty() && _compaction_strategy.is_cold_output(descriptor)) {
+            datadir = _config.slow_datadirs[_next_slow_datadir++ % _config.slow_datadirs.size()];
+        }
+        // Offloaded data stays in cold_dir() when it's compacted on its own.
+        // Inputs from dir() hold recent writes, which would make the output hot.
+        if (boost::algorithm::all_of(descriptor.sstables, [cold_dir = cold_dir()] (const sstables::shared_sstable& sst) {
+            return sst->get_dir() == cold_dir;
+        })) {
+            datadir = cold_dir();
+        }
+        descriptor.creator = [this, datadir = std::move(datadir)] (shard_id dummy) {
+                auto sst = make_sstable(datadir);
                 sst->set_unshared();
                 return sst;
         };
@@ -1466,6 +1709,97 @@ std::vector<sstables::shared_sstable> table::select_sstables(const dht::partitio
     return _sstables->select(range);
 }
 
+static bool sstable_overlaps(const sstables::shared_sstable& sst, const dht::token_range& r) {
+    auto sst_range = dht::token_range::make(sst->get_first_decorated_key().token(), sst->get_last_decorated_key().token());
+    return r.overlaps(sst_range, dht::token_comparator());
+}
+
+static std::optional<hll::HyperLogLog> sstable_cardinality(const sstables::sstable& sst) {
+    try {
+        auto& data = sst.get_compaction_metadata().cardinality.elements;
+        temporary_buffer<uint8_t> bytes(data.size());
+        std::copy(data.begin(), data.end(), bytes.get_write());
+        return hll::HyperLogLog::from_bytes(std::move(bytes));
+    } catch (...) {
+        // No compaction metadata, or a sketch in a format we can't read.
+        return std::nullopt;
+    }
+}
+
+void table::sstables_cardinality::add(const sstables::sstable& sst) {
+    if (!usable) {
+        return;
+    }
+    auto c = sstable_cardinality(sst);
+    if (!c || (merged && merged->registerSize() != c->registerSize())) {
+        usable = false;
+        return;
+    }
+    sum += c->estimate();
+    if (merged) {
+        merged->merge(*c);
+    } else {
+        merged = std::move(c);
+    }
+}
+
+double table::sstables_cardinality::distinct_ratio() const {
+    if (!usable || !merged || sum <= 0) {
+        return 1;
+    }
+    return std::min(1.0, merged->estimate() / sum);
+}
+
+void table::drop_size_estimates() noexcept {
+    _size_estimates.clear();
+    _sstables_cardinality.reset();
+}
+
+void table::add_sstable_to_size_estimates(const sstables::shared_sstable& sst) {
+    if (_sstables_cardinality) {
+        _sstables_cardinality->add(*sst);
+    }
+    for (auto& [bounds, e] : _size_estimates) {
+        bool overlapping = false;
+        for (auto& r : e.ranges) {
+            if (sstable_overlaps(sst, r)) {
+                e.partitions_count += sst->estimated_keys_for_range(r);
+                overlapping = true;
+            }
+        }
+        if (overlapping) {
+            e.partition_size.merge(sst->get_stats_metadata().estimated_partition_size);
+        }
+    }
+}
+
+std::pair<int64_t, int64_t> table::estimate_partitions(const dht::token& start, const dht::token& end) const {
+    auto it = _size_estimates.find(std::make_pair(start, end));
+    if (it == _size_estimates.end()) {
+        range_size_estimate e;
+        ::compat::unwrap_into(
+            wrapping_range<dht::token>({{ start, false }}, {{ end }}),
+            dht::token_comparator(),
+            [&] (auto&& rng) { e.ranges.push_back(std::move(rng)); });
+        for (auto& r : e.ranges) {
+            for (auto& sst : _sstables->select(dht::to_partition_range(r))) {
+                e.partitions_count += sst->estimated_keys_for_range(r);
+                e.partition_size.merge(sst->get_stats_metadata().estimated_partition_size);
+            }
+        }
+        it = _size_estimates.emplace(std::make_pair(start, end), std::move(e)).first;
+    }
+    if (!_sstables_cardinality) {
+        _sstables_cardinality.emplace();
+        for (auto& sst : *_sstables->all()) {
+            _sstables_cardinality->add(*sst);
+        }
+    }
+    auto& e = it->second;
+    auto count = std::llround(e.partitions_count * _sstables_cardinality->distinct_ratio());
+    return {count, count > 0 ? e.partition_size.mean() : 0};
+}
+
 std::vector<sstables::shared_sstable> table::candidates_for_compaction() const {
     return boost::copy_range<std::vector<sstables::shared_sstable>>(*get_sstables()
             | boost::adaptors::filtered([this] (auto& sst) {
@@ -1520,7 +1854,11 @@ table::make_memtable_list() {
         return seal_active_memtable(std::move(permit));
     };
     auto get_schema = [this] { return schema(); };
-    return make_lw_shared<memtable_list>(std::move(seal), std::move(get_schema), _config.dirty_memory_manager, _stats, _config.memory_compaction_scheduling_group);
+    auto list = make_lw_shared<memtable_list>(std::move(seal), std::move(get_schema), _config.dirty_memory_manager, _stats, _config.memory_compaction_scheduling_group);
+    if (_config.append_only_ingest) {
+        list->set_append_only_ingest(true);
+    }
+    return list;
 }
 
 lw_shared_ptr<memtable_list>
@@ -1563,6 +1901,7 @@ table::table(schema_ptr schema, config config, db::commitlog* cl, compaction_man
     if (!_config.enable_disk_writes) {
         tlogger.warn("Writes disabled, column family no durable.");
     }
+    _stats.stalls.name = format("{}.{}", _schema->ks_name(), _schema->cf_name());
     set_metrics();
 }
 
@@ -1589,14 +1928,14 @@ table::sstables_as_snapshot_source() {
     return snapshot_source([this] () {
         auto sst_set = _sstables;
         return mutation_source([this, sst_set] (schema_ptr s,
-                reader_permit,
+                reader_permit permit,
                 const dht::partition_range& r,
                 const query::partition_slice& slice,
                 const io_priority_class& pc,
                 tracing::trace_state_ptr trace_state,
                 streamed_mutation::forwarding fwd,
                 mutation_reader::forwarding fwd_mr) {
-            return make_sstable_reader(std::move(s), sst_set, r, slice, pc, std::move(trace_state), fwd, fwd_mr);
+            return make_sstable_reader(std::move(s), sst_set, r, slice, pc, std::move(trace_state), fwd, fwd_mr, std::move(permit));
         }, [this, sst_set] {
             return make_partition_presence_checker(sst_set);
         });
@@ -1719,26 +2058,28 @@ future<> table::snapshot(sstring name) {
         auto tables = boost::copy_range<std::vector<sstables::shared_sstable>>(*_sstables->all());
         return do_with(std::move(tables), [this, name](std::vector<sstables::shared_sstable> & tables) {
             auto jsondir = _config.datadir + "/snapshots/" + name;
-            return io_check([jsondir] { return recursive_touch_directory(jsondir); }).then([this, name, jsondir, &tables] {
-                return parallel_for_each(tables, [name](sstables::shared_sstable sstable) {
-                    auto dir = sstable->get_dir() + "/snapshots/" + name;
-                    return io_check([dir] { return recursive_touch_directory(dir); }).then([sstable, dir] {
-                        return sstable->create_links(dir).then_wrapped([] (future<> f) {
-                            // If the SSTables are shared, one of the CPUs will fail here.
-                            // That is completely fine, though. We only need one link.
-                            try {
-                                f.get();
-                            } catch (std::system_error& e) {
-                                if (e.code() != std::error_code(EEXIST, std::system_category())) {
-                                    throw;
-                                }
-                            }
-                            return make_ready_future<>();
-                        });
+            // Sstables usually share a handful of directories, so touch and sync each
+            // snapshot directory once instead of once per sstable.
+            std::set<sstring> dirs{jsondir};
+            for (auto& sst : tables) {
+                dirs.insert(sst->get_dir() + "/snapshots/" + name);
+            }
+            return do_with(std::move(dirs), [name, &tables] (std::set<sstring>& dirs) {
+                return parallel_for_each(dirs, [] (const sstring& dir) {
+                    return io_check([&dir] { return recursive_touch_directory(dir); });
+                }).then([name, &tables] {
+                    return parallel_for_each(tables, [name] (sstables::shared_sstable sstable) {
+                        // If the SSTables are shared, every CPU links them; the
+                        // links tolerate EEXIST since we only need one of them.
+                        // Links stay in the sstable's directory, so offloaded
+                        // sstables are linked on cold storage, into cold/snapshots.
+                        return sstable->create_snapshot_links(sstable->get_dir() + "/snapshots/" + name);
+                    });
+                }).then([&dirs] {
+                    return parallel_for_each(dirs, [] (const sstring& dir) {
+                        return io_check(sync_directory, dir);
                     });
                 });
-            }).then([jsondir, &tables] {
-                return io_check(sync_directory, std::move(jsondir));
             }).finally([this, &tables, jsondir] {
                 auto shard = std::hash<sstring>()(jsondir) % smp::count;
                 std::unordered_set<sstring> table_names;
@@ -1802,7 +2143,10 @@ future<bool> table::snapshot_exists(sstring tag) {
 future<std::unordered_map<sstring, table::snapshot_details>> table::get_snapshot_details() {
     return seastar::async([this] {
         std::unordered_map<sstring, snapshot_details> all_snapshots;
-        for (auto& datadir : _config.all_datadirs) {
+        // Offloaded sstables are linked into cold/snapshots, next to them.
+        auto datadirs = _config.all_datadirs;
+        datadirs.push_back(cold_dir());
+        for (auto& datadir : datadirs) {
             fs::path snapshots_dir = fs::path(datadir) / "snapshots";
             auto file_exists = io_check([&snapshots_dir] { return engine().file_exists(snapshots_dir.native()); }).get0();
             if (!file_exists) {
@@ -1963,6 +2307,7 @@ future<db::replay_position> table::discard_sstables(db_clock::time_point truncat
                 }
 
                 cf._sstables = std::move(pruned);
+                cf.drop_size_estimates();
             }
         };
         auto p = make_lw_shared<pruner>(*this);
@@ -2309,6 +2654,7 @@ void table::do_apply(db::rp_handle&& h, Args&&... args) {
     db::replay_position rp = h;
     check_valid_rp(rp);
     try {
+        utils::activity_scope activity(make_activity(utils::activity_type::write));
         _memtables->active_memtable().apply(std::forward<Args>(args)..., std::move(h));
         _highest_rp = std::max(_highest_rp, rp);
     } catch (...) {
@@ -2318,6 +2664,8 @@ void table::do_apply(db::rp_handle&& h, Args&&... args) {
     _stats.writes.mark(lc);
     if (lc.is_start()) {
         _stats.estimated_write.add(lc.latency(), _stats.writes.hist.count);
+        _stats.decaying_write.add(std::chrono::duration_cast<std::chrono::microseconds>(lc.latency()));
+        _config.cf_stats->decaying_write.add(std::chrono::duration_cast<std::chrono::microseconds>(lc.latency()));
     }
 }
 
@@ -2336,6 +2684,7 @@ write_memtable_to_sstable(memtable& mt, sstables::shared_sstable sst,
                           sstables::write_monitor& monitor,
                           sstables::sstable_writer_config& cfg,
                           const io_priority_class& pc) {
+    mt.apply_pending();
     cfg.replay_position = mt.replay_position();
     cfg.monitor = &monitor;
     return sst->write_components(mt.make_flush_reader(mt.schema(), pc), mt.partition_count(),
@@ -2355,9 +2704,11 @@ struct query_state {
                          const query::read_command& cmd,
                          query::result_options opts,
                          const dht::partition_range_vector& ranges,
+                         bool skip_unselected_cells,
                          query::result_memory_accounter memory_accounter = { })
             : schema(std::move(s))
             , cmd(cmd)
+            , read_slice(skip_unselected_cells ? std::make_optional(cmd.slice) : std::nullopt)
             , builder(cmd.slice, opts, std::move(memory_accounter))
             , limit(cmd.row_limit)
             , partition_limit(cmd.partition_limit)
@@ -2366,6 +2717,9 @@ struct query_state {
     }
     schema_ptr schema;
     const query::read_command& cmd;
+    // cmd.slice with skip_unselected_cells, when the rows are read from
+    // sstables directly.
+    std::optional<query::partition_slice> read_slice;
     query::result::builder builder;
     uint32_t limit;
     uint32_t partition_limit;
@@ -2381,6 +2735,9 @@ struct query_state {
     bool done() const {
         return !remaining_rows() || !remaining_partitions() || current_partition_range == range_end || builder.is_short_read();
     }
+    const query::partition_slice& slice() const {
+        return read_slice ? *read_slice : cmd.slice;
+    }
 };
 
 future<lw_shared_ptr<query::result>>
@@ -2399,11 +2756,17 @@ table::query(schema_ptr s,
              ? memory_limiter.new_digest_read(max_size) : memory_limiter.new_data_read(max_size);
     return f.then([this, lc, s = std::move(s), &cmd, opts, &partition_ranges,
             trace_state = std::move(trace_state), timeout, cache_ctx = std::move(cache_ctx)] (query::result_memory_accounter accounter) mutable {
-        auto qs_ptr = std::make_unique<query_state>(std::move(s), cmd, opts, partition_ranges, std::move(accounter));
+        // Only the selected columns make it to the result, but rows read
+        // through the cache must be complete to be cached.
+        auto skip_unselected_cells = !_config.enable_cache || cmd.slice.options.contains(query::partition_slice::option::bypass_cache);
+        auto qs_ptr = std::make_unique<query_state>(std::move(s), cmd, opts, partition_ranges, skip_unselected_cells, std::move(accounter));
         auto& qs = *qs_ptr;
+        if (qs.read_slice) {
+            qs.read_slice->options.set(query::partition_slice::option::skip_unselected_cells);
+        }
         return do_until(std::bind(&query_state::done, &qs), [this, &qs, trace_state = std::move(trace_state), timeout, cache_ctx = std::move(cache_ctx)] {
             auto&& range = *qs.current_partition_range++;
-            return data_query(qs.schema, as_mutation_source(), range, qs.cmd.slice, qs.remaining_rows(),
+            return data_query(qs.schema, as_mutation_source(), range, qs.slice(), qs.remaining_rows(),
                               qs.remaining_partitions(), qs.cmd.timestamp, qs.builder, timeout, _config.max_memory_for_unlimited_query, trace_state, cache_ctx);
         }).then([qs_ptr = std::move(qs_ptr), &qs] {
             return make_ready_future<lw_shared_ptr<query::result>>(
@@ -2412,8 +2775,92 @@ table::query(schema_ptr s,
             _stats.reads.mark(lc);
             if (lc.is_start()) {
                 _stats.estimated_read.add(lc.latency(), _stats.reads.hist.count);
+                _stats.decaying_read.add(std::chrono::duration_cast<std::chrono::microseconds>(lc.latency()));
+                _config.cf_stats->decaying_read.add(std::chrono::duration_cast<std::chrono::microseconds>(lc.latency()));
+            }
+        });
+    });
+}
+
+// The admission cost of a reader, as charged by make_restricted_flat_reader().
+static constexpr ssize_t partitions_query_admission_cost = 16 * 1024;
+
+struct partitions_query_state : public query_state {
+    // Makes the readers of all partitions, under the query's permit.
+    mutation_source source;
+    // Where the result of each partition read so far ends.
+    std::vector<query::result_part_end> ends;
+
+    partitions_query_state(mutation_source source,
+                           schema_ptr s,
+                           const query::read_command& cmd,
+                           const dht::partition_range_vector& ranges,
+                           bool skip_unselected_cells,
+                           query::result_memory_accounter memory_accounter)
+            : query_state(std::move(s), cmd, query::result_options::only_result(), ranges, skip_unselected_cells, std::move(memory_accounter))
+            , source(std::move(source)) {
+        ends.reserve(ranges.size());
+    }
+};
+
+future<std::vector<lw_shared_ptr<query::result>>>
+table::query_partitions(schema_ptr s,
+        const query::read_command& cmd,
+        const dht::partition_range_vector& partition_ranges,
+        tracing::trace_state_ptr trace_state,
+        query::result_memory_limiter& memory_limiter,
+        uint64_t max_size,
+        db::timeout_clock::time_point timeout) {
+    utils::latency_counter lc;
+    _stats.reads.set_latency(lc);
+    auto* semaphore = read_concurrency_semaphore_for(current_scheduling_group());
+    auto admitted = semaphore
+            ? semaphore->wait_admission(partitions_query_admission_cost, timeout)
+            : make_ready_future<reader_permit>(no_reader_permit());
+    return admitted.then([this, lc, s = std::move(s), &cmd, &partition_ranges, trace_state = std::move(trace_state), &memory_limiter, max_size, timeout] (
+            reader_permit permit) mutable {
+      return memory_limiter.new_data_read(max_size).then([this, lc, s = std::move(s), &cmd, &partition_ranges, trace_state = std::move(trace_state), timeout,
+            permit = std::move(permit)] (query::result_memory_accounter accounter) mutable {
+        auto skip_unselected_cells = !_config.enable_cache || cmd.slice.options.contains(query::partition_slice::option::bypass_cache);
+        auto qs_ptr = std::make_unique<partitions_query_state>(as_admitted_mutation_source(std::move(permit)), std::move(s), cmd, partition_ranges,
+                skip_unselected_cells, std::move(accounter));
+        auto& qs = *qs_ptr;
+        if (qs.read_slice) {
+            qs.read_slice->options.set(query::partition_slice::option::skip_unselected_cells);
+        }
+        // The partitions are read one after the other, so that the limits
+        // cut them in the given order.
+        return do_until(std::bind(&query_state::done, &qs), [this, &qs, trace_state = std::move(trace_state), timeout] {
+            auto&& range = *qs.current_partition_range++;
+            return data_query(qs.schema, qs.source, range, qs.slice(), qs.remaining_rows(),
+                              qs.remaining_partitions(), qs.cmd.timestamp, qs.builder, timeout, _config.max_memory_for_unlimited_query, trace_state).then([&qs] {
+                qs.ends.push_back({qs.builder.partition_count(), qs.builder.row_count()});
+            });
+        }).then([qs_ptr = std::move(qs_ptr), &qs] {
+            return query::split_result(qs.builder.build(), qs.ends);
+        }).finally([lc, this]() mutable {
+            _stats.reads.mark(lc);
+            if (lc.is_start()) {
+                _stats.estimated_read.add(lc.latency(), _stats.reads.hist.count);
+                _stats.decaying_read.add(std::chrono::duration_cast<std::chrono::microseconds>(lc.latency()));
+                _config.cf_stats->decaying_read.add(std::chrono::duration_cast<std::chrono::microseconds>(lc.latency()));
             }
         });
+      });
+    });
+}
+
+mutation_source
+table::as_admitted_mutation_source(reader_permit permit) const {
+    return mutation_source([this, permit = std::move(permit)] (schema_ptr s,
+                                   reader_permit,
+                                   const dht::partition_range& range,
+                                   const query::partition_slice& slice,
+                                   const io_priority_class& pc,
+                                   tracing::trace_state_ptr trace_state,
+                                   streamed_mutation::forwarding fwd,
+                                   mutation_reader::forwarding fwd_mr) {
+        return this->make_reader(std::move(s), range, slice, pc, std::move(trace_state), fwd, fwd_mr, permit);
     });
 }
 
@@ -2432,15 +2879,15 @@ table::as_mutation_source() const {
 }
 
 void table::add_coordinator_read_latency(utils::estimated_histogram::duration latency) {
-    _stats.estimated_coordinator_read.add(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    _stats.coordinator_read_latency.add(std::chrono::duration_cast<std::chrono::microseconds>(latency));
 }
 
-std::chrono::milliseconds table::get_coordinator_read_latency_percentile(double percentile) {
-    if (_cached_percentile != percentile || lowres_clock::now() - _percentile_cache_timestamp > 1s) {
-        _percentile_cache_timestamp = lowres_clock::now();
+std::optional<std::chrono::microseconds> table::get_coordinator_read_latency_percentile(double percentile) {
+    auto now = lowres_clock::now();
+    if (_cached_percentile != percentile || now - _percentile_cache_timestamp > 100ms) {
+        _percentile_cache_timestamp = now;
         _cached_percentile = percentile;
-        _percentile_cache_value = std::max(_stats.estimated_coordinator_read.percentile(percentile) / 1000, int64_t(1)) * 1ms;
-        _stats.estimated_coordinator_read *= 0.9; // decay values a little to give new data points more weight
+        _percentile_cache_value = _stats.coordinator_read_latency.percentile(percentile, now);
     }
     return _percentile_cache_value;
 }
@@ -2458,8 +2905,8 @@ table::run_with_compaction_disabled(std::function<future<> ()> func) {
 }
 
 flat_mutation_reader
-table::make_reader_excluding_sstable(schema_ptr s,
-        sstables::shared_sstable sst,
+table::make_reader_excluding_sstables(schema_ptr s,
+        std::vector<sstables::shared_sstable> excluded_sstables,
         const dht::partition_range& range,
         const query::partition_slice& slice,
         const io_priority_class& pc,
@@ -2474,7 +2921,9 @@ table::make_reader_excluding_sstable(schema_ptr s,
     }
 
     auto effective_sstables = ::make_lw_shared<sstables::sstable_set>(*_sstables);
-    effective_sstables->erase(sst);
+    for (auto& sst : excluded_sstables) {
+        effective_sstables->erase(sst);
+    }
 
     readers.emplace_back(make_sstable_reader(s, std::move(effective_sstables), range, slice, pc, std::move(trace_state), fwd, fwd_mr));
     return make_combined_reader(s, std::move(readers), fwd, fwd_mr);
@@ -2505,6 +2954,103 @@ future<> table::move_sstables_from_staging(std::vector<sstables::shared_sstable>
     });
 }
 
+future<size_t> table::offload_cold_sstables(api::timestamp_type max_timestamp) {
+    return run_with_compaction_disabled([this, max_timestamp] {
+        return seastar::async([this, max_timestamp] {
+            auto cold_dir = this->cold_dir();
+            std::vector<sstables::shared_sstable> candidates;
+            for (auto&& sst : *_sstables->all()) {
+                if (sst->get_stats_metadata().max_timestamp < max_timestamp && sst->get_dir() != cold_dir
+                        && !sst->is_shared() && !sst->requires_view_building()) {
+                    candidates.push_back(sst);
+                }
+            }
+            if (candidates.empty()) {
+                return size_t(0);
+            }
+            io_check([&] { return touch_directory(cold_dir); }).get();
+            auto& pc = service::get_local_compaction_priority();
+            for (auto&& sst : candidates) {
+                auto generation = calculate_generation_for_new_table();
+                sst->copy_to_dir(cold_dir, generation, pc).get();
+                auto cold = make_sstable(cold_dir, generation, sst->get_version(), sst->get_format());
+                cold->load(pc).get();
+                tlogger.info("Offloaded sstable {} to {}", sst->get_filename(), cold->get_filename());
+
+                // The copy holds the same data, so the cache needs no invalidation.
+                // The original is deleted along the path of compacted sstables.
+                sstables::compaction_completion_desc desc;
+                desc.input_sstables = {sst};
+                desc.output_sstables = {cold};
+                _compaction_strategy.get_backlog_tracker().remove_sstable(sst);
+                _compaction_strategy.get_backlog_tracker().add_sstable(cold);
+                on_compaction_completion(desc);
+            }
+            return candidates.size();
+        });
+    });
+}
+
+future<> table::mark_sstables_repaired(std::unordered_set<int64_t> generations, dht::token_range_vector ranges, uint64_t repaired_at) {
+    std::vector<sstables::shared_sstable> contained;
+    std::unordered_set<int64_t> overlapping;
+    for (auto&& sst : *_sstables->all()) {
+        if (sst->is_repaired() || !generations.count(sst->generation())) {
+            continue;
+        }
+        auto sst_range = dht::token_range::make(sst->get_first_decorated_key().token(), sst->get_last_decorated_key().token());
+        // Whatever is left of the sstable's range isn't repaired.
+        dht::token_range_vector unrepaired{sst_range};
+        for (auto& r : ranges) {
+            dht::token_range_vector rest;
+            for (auto& u : unrepaired) {
+                auto diff = u.subtract(r, dht::token_comparator());
+                std::move(diff.begin(), diff.end(), std::back_inserter(rest));
+            }
+            unrepaired = std::move(rest);
+        }
+        if (unrepaired.empty()) {
+            contained.push_back(sst);
+        } else if (boost::algorithm::any_of(ranges, [&] (const dht::token_range& r) { return r.overlaps(sst_range, dht::token_comparator()); })) {
+            overlapping.insert(sst->generation());
+        }
+    }
+    tlogger.info("Marking {} sstables of {}.{} as repaired, anticompacting {}", contained.size(),
+            _schema->ks_name(), _schema->cf_name(), overlapping.size());
+    return parallel_for_each(contained, [repaired_at] (const sstables::shared_sstable& sst) {
+        return sst->mutate_repaired_at(repaired_at);
+    }).then([this, overlapping = std::move(overlapping), ranges = std::move(ranges), repaired_at] () mutable {
+        if (overlapping.empty()) {
+            return make_ready_future<>();
+        }
+        return _compaction_manager.perform_anticompaction(this, std::move(ranges), repaired_at, std::move(overlapping));
+    });
+}
+
+void table::record_repair(const dht::token_range_vector& ranges, gc_clock::time_point repair_time) {
+    for (auto& range : ranges) {
+        _repair_history.record(range, repair_time);
+    }
+}
+
+gc_clock::time_point table::get_gc_before(const dht::token& t, gc_clock::time_point compaction_time) const {
+    if (_compaction_strategy.repair_based_tombstone_gc()) {
+        if (auto repaired_at = _repair_history.repaired_at(t)) {
+            return *repaired_at - tombstone_gc_propagation_delay();
+        }
+    }
+    return saturating_subtract(compaction_time, _schema->gc_grace_seconds());
+}
+
+gc_clock::time_point table::get_gc_before(const dht::token_range& range, gc_clock::time_point compaction_time) const {
+    if (_compaction_strategy.repair_based_tombstone_gc()) {
+        if (auto repaired_at = _repair_history.repaired_at(range)) {
+            return *repaired_at - tombstone_gc_propagation_delay();
+        }
+    }
+    return saturating_subtract(compaction_time, _schema->gc_grace_seconds());
+}
+
 /**
  * Given an update for the base table, calculates the set of potentially affected views,
  * generates the relevant updates, and sends them to the paired view replicas.
@@ -2576,13 +3122,13 @@ future<row_locker::lock_holder> table::push_view_replica_updates(const schema_pt
     return do_push_view_replica_updates(s, std::move(m), timeout, as_mutation_source(), service::get_local_sstable_query_read_priority());
 }
 
-future<row_locker::lock_holder> table::stream_view_replica_updates(const schema_ptr& s, mutation&& m, db::timeout_clock::time_point timeout, sstables::shared_sstable excluded_sstable) const {
-    return do_push_view_replica_updates(s, std::move(m), timeout, as_mutation_source_excluding(std::move(excluded_sstable)), service::get_local_streaming_write_priority());
+future<row_locker::lock_holder> table::stream_view_replica_updates(const schema_ptr& s, mutation&& m, db::timeout_clock::time_point timeout, std::vector<sstables::shared_sstable> excluded_sstables) const {
+    return do_push_view_replica_updates(s, std::move(m), timeout, as_mutation_source_excluding(std::move(excluded_sstables)), service::get_local_streaming_write_priority());
 }
 
 mutation_source
-table::as_mutation_source_excluding(sstables::shared_sstable sst) const {
-    return mutation_source([this, sst = std::move(sst)] (schema_ptr s,
+table::as_mutation_source_excluding(std::vector<sstables::shared_sstable> excluded_sstables) const {
+    return mutation_source([this, excluded_sstables = std::move(excluded_sstables)] (schema_ptr s,
                                    reader_permit,
                                    const dht::partition_range& range,
                                    const query::partition_slice& slice,
@@ -2590,7 +3136,7 @@ table::as_mutation_source_excluding(sstables::shared_sstable sst) const {
                                    tracing::trace_state_ptr trace_state,
                                    streamed_mutation::forwarding fwd,
                                    mutation_reader::forwarding fwd_mr) {
-        return this->make_reader_excluding_sstable(std::move(s), std::move(sst), range, slice, pc, std::move(trace_state), fwd, fwd_mr);
+        return this->make_reader_excluding_sstables(std::move(s), excluded_sstables, range, slice, pc, std::move(trace_state), fwd, fwd_mr);
     });
 }
 
@@ -2599,7 +3145,7 @@ stop_iteration db::view::view_updating_consumer::consume_end_of_partition() {
         return stop_iteration::yes;
     }
     try {
-        auto lock_holder = _table->stream_view_replica_updates(_schema, std::move(*_m), db::no_timeout, _excluded_sstable).get();
+        auto lock_holder = _table->stream_view_replica_updates(_schema, std::move(*_m), db::no_timeout, _excluded_sstables).get();
     } catch (...) {
         tlogger.warn("Failed to push replica updates for table {}.{}: {}", _schema->ks_name(), _schema->cf_name(), std::current_exception());
     }
@@ -115,6 +115,31 @@ SEASTAR_TEST_CASE(test_aggregate_sum) {
     });
 }
 
+SEASTAR_TEST_CASE(test_aggregate_sum_and_avg_of_wide_values) {
+    return do_with_cql_env_thread([&] (auto& e) {
+        e.execute_cql("CREATE TABLE wide (pk int primary key, v varint, d decimal)").get();
+        // The varint sum overflows 128 bits, and one varint doesn't fit in them to begin with.
+        // The decimals have different scales, the last one too large to rescale the sum to in 128 bits.
+        e.execute_cql("INSERT INTO wide (pk, v, d) VALUES (1, 170141183460469231731687303715884105727, 1.5)").get();
+        e.execute_cql("INSERT INTO wide (pk, v, d) VALUES (2, 170141183460469231731687303715884105727, 0.25)").get();
+        e.execute_cql("INSERT INTO wide (pk, v, d) VALUES (3, -5, -3)").get();
+        e.execute_cql("INSERT INTO wide (pk, v, d) VALUES (4, 123456789012345678901234567890123456789012, 100)").get();
+        e.execute_cql("INSERT INTO wide (pk, v, d) VALUES (5, 7, 0.0000000000000000000000000000000000000001)").get();
+
+        auto msg = e.execute_cql("SELECT sum(v), avg(v), sum(d), avg(d) FROM wide").get0();
+        assert_that(msg).is_rows().with_size(1).with_row({{varint_type->from_string("123797071379266617364697942497555225000468")},
+                                                          {varint_type->from_string("24759414275853323472939588499511045000093")},
+                                                          {decimal_type->from_string("98.7500000000000000000000000000000000000001")},
+                                                          {decimal_type->from_string("19.7500000000000000000000000000000000000000")}});
+
+        msg = e.execute_cql("SELECT sum(v), avg(v), sum(d), avg(d) FROM wide WHERE pk IN (1, 3)").get0();
+        assert_that(msg).is_rows().with_size(1).with_row({{varint_type->from_string("170141183460469231731687303715884105722")},
+                                                          {varint_type->from_string("85070591730234615865843651857942052861")},
+                                                          {decimal_type->from_string("-1.5")},
+                                                          {decimal_type->from_string("-0.8")}});
+    });
+}
+
 SEASTAR_TEST_CASE(test_aggregate_max) {
     return do_with_cql_env_thread([&] (auto& e) {
         create_table(e);
@@ -259,3 +284,60 @@ SEASTAR_TEST_CASE(test_reverse_type_aggregation) {
         }
     });
 }
+
+SEASTAR_TEST_CASE(test_aggregate_approx) {
+    return do_with_cql_env_thread([&] (auto& e) {
+        create_table(e);
+
+        auto msg = e.execute_cql("SELECT approx_count_distinct(a), approx_count_distinct(bo), approx_count_distinct(t) FROM test").get0();
+        assert_that(msg).is_rows().with_size(1).with_row({{long_type->decompose(int64_t(2))},
+                                                          {long_type->decompose(int64_t(2))},
+                                                          {long_type->decompose(int64_t(2))}});
+
+        e.execute_cql("CREATE TABLE big (p int, c int, v int, primary key (p, c))").get();
+        const int n = 1000;
+        for (int i = 0; i < n; ++i) {
+            e.execute_cql(format("INSERT INTO big (p, c, v) VALUES ({}, 0, {})", i % 10, i)).get();
+        }
+
+        auto get_value = [&] (sstring query, data_type type) {
+            auto msg = e.execute_cql(query).get0();
+            auto rows = dynamic_pointer_cast<cql_transport::messages::result_message::rows>(msg);
+            BOOST_REQUIRE(rows);
+            auto& rs = rows->rs().result_set().rows();
+            BOOST_REQUIRE_EQUAL(rs.size(), 1);
+            return type->deserialize(*rs[0][0]);
+        };
+
+        auto distinct = value_cast<int64_t>(get_value("SELECT approx_count_distinct(v) FROM big", long_type));
+        BOOST_REQUIRE_LE(std::abs(distinct - n), n / 50);
+        distinct = value_cast<int64_t>(get_value("SELECT approx_count_distinct(p) FROM big", long_type));
+        BOOST_REQUIRE_EQUAL(distinct, 10);
+
+        auto median = value_cast<double>(get_value("SELECT approx_percentile(v, 0.5) FROM big", double_type));
+        BOOST_REQUIRE_LE(std::abs(median - (n - 1) / 2.0), n / 100.0);
+        auto p99 = value_cast<double>(get_value("SELECT approx_percentile(v, 0.99) FROM big", double_type));
+        BOOST_REQUIRE_LE(std::abs(p99 - 0.99 * (n - 1)), n / 200.0);
+
+        BOOST_REQUIRE_THROW(e.execute_cql("SELECT approx_percentile(v, 1.5) FROM big").get(), exceptions::invalid_request_exception);
+
+        // The percentile takes the type of the parameter, integer literals included.
+        auto max = value_cast<double>(get_value("SELECT approx_percentile(v, 1) FROM big", double_type));
+        BOOST_REQUIRE_EQUAL(max, n - 1);
+        BOOST_REQUIRE_THROW(e.execute_cql("SELECT 1 FROM big").get(), exceptions::invalid_request_exception);
+
+        // Each partition is aggregated by a single replica, so the sketches
+        // merged on the coordinator must give the estimates of a sequential
+        // scan, which LIMIT forces.
+        auto rows_of = [] (shared_ptr<cql_transport::messages::result_message> msg) {
+            auto rows = dynamic_pointer_cast<cql_transport::messages::result_message::rows>(msg);
+            BOOST_REQUIRE(rows);
+            const auto& rs = rows->rs().result_set().rows();
+            return std::vector<std::vector<bytes_opt>>(rs.begin(), rs.end());
+        };
+        auto grouped = "SELECT p, approx_count_distinct(v), approx_percentile(v, 0.5) FROM big GROUP BY p";
+        auto replicas = rows_of(e.execute_cql(grouped).get0());
+        BOOST_REQUIRE_EQUAL(replicas.size(), 10);
+        BOOST_REQUIRE(replicas == rows_of(e.execute_cql(format("{} LIMIT 1000", grouped)).get0()));
+    });
+}
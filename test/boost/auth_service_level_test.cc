@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/thread_test_case.hh>
+
+#include "auth/service_level.hh"
+
+SEASTAR_THREAD_TEST_CASE(test_parse_service_levels) {
+    auto levels = auth::service_level_controller::parse_levels({{"oltp", "1000"}, {"analytics", "100"}});
+    BOOST_REQUIRE_EQUAL(levels.size(), 2);
+    BOOST_REQUIRE_EQUAL(levels[0].first, "analytics");
+    BOOST_REQUIRE_EQUAL(levels[0].second, 100);
+    BOOST_REQUIRE_EQUAL(levels[1].first, "oltp");
+    BOOST_REQUIRE_EQUAL(levels[1].second, 1000);
+
+    BOOST_REQUIRE_THROW(auth::service_level_controller::parse_levels({{"oltp", "0"}}), std::invalid_argument);
+    BOOST_REQUIRE_THROW(auth::service_level_controller::parse_levels({{"oltp", "1001"}}), std::invalid_argument);
+    BOOST_REQUIRE_THROW(auth::service_level_controller::parse_levels({{"oltp", "many"}}), std::invalid_argument);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_service_level_scheduling_group_for_role) {
+    auto default_sg = seastar::create_scheduling_group("sl_test_default", 1000).get0();
+    auto analytics_sg = seastar::create_scheduling_group("sl_test_analytics", 100).get0();
+    std::vector<auth::service_level> levels = {{"analytics", 100, analytics_sg}};
+
+    auth::service_level_controller slc(levels, {{"etl", "analytics"}}, default_sg);
+    BOOST_REQUIRE(slc.scheduling_group_for(auth::authenticated_user("etl")) == analytics_sg);
+    BOOST_REQUIRE(slc.scheduling_group_for(auth::authenticated_user("web")) == default_sg);
+    BOOST_REQUIRE(slc.scheduling_group_for(auth::authenticated_user()) == default_sg);
+    BOOST_REQUIRE(slc.scheduling_group_for(std::nullopt) == default_sg);
+
+    BOOST_REQUIRE_THROW(auth::service_level_controller(levels, {{"etl", "batch"}}, default_sg), std::invalid_argument);
+}
@@ -31,6 +31,7 @@
 #include <seastar/core/thread.hh>
 
 #include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
 #include "test/lib/cql_test_env.hh"
 #include "test/lib/cql_assertions.hh"
 
@@ -166,3 +167,33 @@ SEASTAR_TEST_CASE(test_password_authenticator_operations) {
         });
     }, cfg);
 }
+
+SEASTAR_THREAD_TEST_CASE(test_password_authenticator_credentials_cache) {
+    auto cfg = make_shared<db::config>();
+    cfg->authenticator(auth::password_authenticator_name());
+    cfg->credentials_validity_in_ms(60000);
+
+    do_with_cql_env_thread([](cql_test_env& env) {
+        static const sstring username("cached");
+
+        auth::role_config config;
+        config.can_login = true;
+        auth::authentication_options options;
+        options.password = "first";
+        auth::create_role(env.local_auth_service(), username, config, options).get();
+
+        // The second login is served from the cache, a wrong password is not.
+        authenticate(env, username, "first").get();
+        authenticate(env, username, "first").get();
+        require_throws<exceptions::authentication_exception>(authenticate(env, username, "second")).get();
+
+        // A new password replaces the cached one right away.
+        options.password = "second";
+        auth::alter_role(env.local_auth_service(), username, auth::role_config_update{}, options).get();
+        require_throws<exceptions::authentication_exception>(authenticate(env, username, "first")).get();
+        authenticate(env, username, "second").get();
+
+        auth::drop_role(env.local_auth_service(), username).get();
+        require_throws<exceptions::authentication_exception>(authenticate(env, username, "second")).get();
+    }, cfg).get();
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include "utils/bloom_filter.hh"
+#include "utils/xor_filter.hh"
+#include "utils/iblt.hh"
+#include "utils/serialization.hh"
+
+static bytes make_key(int64_t i) {
+    bytes b(bytes::initialized_later(), sizeof(i));
+    auto p = b.begin();
+    write<int64_t>(p, i);
+    return b;
+}
+
+static void check_filter(utils::i_filter& f, int64_t n, double fp_chance) {
+    for (int64_t i = 0; i < n; ++i) {
+        BOOST_REQUIRE(f.is_present(make_key(i)));
+        BOOST_REQUIRE(f.is_present(utils::make_hashed_key(make_key(i))));
+    }
+    int64_t false_positives = 0;
+    for (int64_t i = n; i < 2 * n; ++i) {
+        false_positives += f.is_present(make_key(i));
+    }
+    BOOST_TEST_MESSAGE(format("false positive rate: {:f}, requested: {:f}", double(false_positives) / n, fp_chance));
+    // Allow some slack for the variance of a small sample.
+    BOOST_REQUIRE_LE(double(false_positives) / n, fp_chance * 1.5);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_split_block_bloom_filter) {
+    for (auto fp_chance : {0.1, 0.01, 0.001}) {
+        const int64_t n = 100000;
+        auto f = utils::i_filter::get_filter(n, fp_chance, utils::filter_format::split_block_format);
+        for (int64_t i = 0; i < n; ++i) {
+            f->add(make_key(i));
+        }
+        check_filter(*f, n, fp_chance);
+
+        // Simulate a round-trip through Filter.db.
+        auto& bf = static_cast<utils::filter::bloom_filter&>(*f);
+        auto& storage = bf.bits().get_storage();
+        utils::chunked_vector<uint64_t> copy(storage.begin(), storage.end());
+        large_bitset bs(bf.bits().size(), std::move(copy));
+        auto loaded = utils::filter::create_filter(bf.num_hashes(), std::move(bs), utils::filter_format::split_block_format);
+        check_filter(*loaded, n, fp_chance);
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_split_block_bloom_filter_tiny) {
+    auto f = utils::i_filter::get_filter(0, 0.01, utils::filter_format::split_block_format);
+    BOOST_REQUIRE_EQUAL(static_cast<utils::filter::bloom_filter&>(*f).bits().size(), utils::filter::split_block_bloom_filter::bits_per_block);
+    f->add(make_key(7));
+    BOOST_REQUIRE(f->is_present(make_key(7)));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_xor_filter) {
+    for (auto fp_chance : {0.1, 0.01, 0.001}) {
+        for (int64_t n : {1, 10, 100000}) {
+            auto f = utils::i_filter::get_filter(n, fp_chance, utils::filter_format::xor_format);
+            auto& xf = static_cast<utils::filter::xor_filter&>(*f);
+            for (int64_t i = 0; i < n; ++i) {
+                f->add(make_key(i));
+            }
+            xf.build();
+            BOOST_REQUIRE(xf.built());
+            if (n >= 1000) {
+                check_filter(*f, n, fp_chance);
+            }
+
+            // Simulate a round-trip through Filter.db.
+            utils::chunked_vector<uint64_t> copy(xf.words().begin(), xf.words().end());
+            auto loaded = utils::filter::create_xor_filter(xf.fingerprint_bits(), std::move(copy));
+            for (int64_t i = 0; i < n; ++i) {
+                BOOST_REQUIRE(loaded->is_present(make_key(i)));
+            }
+        }
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_xor_filter_empty) {
+    auto f = utils::i_filter::get_filter(0, 0.01, utils::filter_format::xor_format);
+    auto& xf = static_cast<utils::filter::xor_filter&>(*f);
+    xf.build();
+    BOOST_REQUIRE(!f->is_present(make_key(7)));
+    BOOST_REQUIRE_THROW(utils::filter::create_xor_filter(8, utils::chunked_vector<uint64_t>{}), std::invalid_argument);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_xor_filter_duplicate_keys) {
+    auto f = utils::i_filter::get_filter(100, 0.01, utils::filter_format::xor_format);
+    for (int64_t i = 0; i < 100; ++i) {
+        f->add(make_key(i % 10));
+    }
+    static_cast<utils::filter::xor_filter&>(*f).build();
+    for (int64_t i = 0; i < 10; ++i) {
+        BOOST_REQUIRE(f->is_present(make_key(i)));
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_iblt_set_difference) {
+    for (size_t d : {0, 1, 10, 1000}) {
+        // Both sets share 10000 keys; each has d / 2 keys of its own.
+        utils::iblt a(utils::iblt::cells_for(d), 42);
+        utils::iblt b(utils::iblt::cells_for(d), 42);
+        for (uint64_t i = 0; i < 10000; ++i) {
+            a.insert(i);
+            b.insert(i);
+        }
+        std::set<uint64_t> only_a, only_b;
+        for (uint64_t i = 0; i < d / 2; ++i) {
+            a.insert(100000 + i);
+            only_a.insert(100000 + i);
+            b.insert(200000 + i);
+            only_b.insert(200000 + i);
+        }
+        a.subtract(b);
+        auto diff = a.decode();
+        BOOST_REQUIRE(diff);
+        BOOST_REQUIRE(std::set<uint64_t>(diff->added.begin(), diff->added.end()) == only_a);
+        BOOST_REQUIRE(std::set<uint64_t>(diff->removed.begin(), diff->removed.end()) == only_b);
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_iblt_too_large_difference) {
+    utils::iblt a(utils::iblt::cells_for(10), 7);
+    utils::iblt b(utils::iblt::cells_for(10), 7);
+    for (uint64_t i = 0; i < 1000; ++i) {
+        a.insert(i);
+    }
+    a.subtract(b);
+    BOOST_REQUIRE(!a.decode());
+
+    utils::iblt c(a.cells().size(), 8);
+    BOOST_REQUIRE_THROW(a.subtract(c), std::invalid_argument);
+    BOOST_REQUIRE_THROW(utils::iblt(7, std::vector<utils::iblt::cell>(4)), std::invalid_argument);
+
+    utils::iblt e(12, 7);
+    e.insert(5);
+    e.erase(5);
+    auto diff = e.decode();
+    BOOST_REQUIRE(diff && diff->added.empty() && diff->removed.empty());
+}
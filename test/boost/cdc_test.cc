@@ -25,12 +25,15 @@
 
 #include "cdc/log.hh"
 #include "cdc/cdc_extension.hh"
+#include "cdc/shard_changes.hh"
+#include "cdc/split.hh"
 #include "db/config.hh"
 #include "schema_builder.hh"
 #include "test/lib/cql_assertions.hh"
 #include "test/lib/cql_test_env.hh"
 #include "test/lib/exception_utils.hh"
 #include "test/lib/log.hh"
+#include "cql3/result_set.hh"
 #include "transport/messages/result_message.hh"
 
 #include "types.hh"
@@ -134,6 +137,32 @@ SEASTAR_THREAD_TEST_CASE(test_find_mutation_timestamp) {
     }, mk_cdc_test_config()).get();
 }
 
+SEASTAR_THREAD_TEST_CASE(test_single_changes_are_not_split) {
+    do_with_cql_env_thread([] (cql_test_env& e) {
+        cquery_nofail(e, "CREATE TABLE ks.t (pk int, ck int, vstatic int static, vint int, vmap map<int, int>, primary key (pk, ck))");
+        auto schema = e.local_db().find_schema("ks", "t");
+
+        auto check_stmt = [&] (const sstring& query, bool split) {
+            auto muts = e.get_modification_mutations(query).get0();
+            BOOST_REQUIRE(!muts.empty());
+            for (auto& m: muts) {
+                BOOST_REQUIRE_EQUAL(cdc::should_split(m, *schema), split);
+            }
+        };
+
+        check_stmt("INSERT INTO ks.t (pk, ck, vint) VALUES (0, 0, 0)", false);
+        check_stmt("UPDATE ks.t SET vint = 0 WHERE pk = 0 AND ck = 0", false);
+        check_stmt("UPDATE ks.t SET vmap[0] = 0 WHERE pk = 0 AND ck = 0", false);
+        check_stmt("UPDATE ks.t SET vstatic = 0 WHERE pk = 0", false);
+        check_stmt("DELETE FROM ks.t WHERE pk = 0 AND ck = 0", false);
+        check_stmt("DELETE FROM ks.t WHERE pk = 0 AND ck > 0", false);
+        check_stmt("DELETE FROM ks.t WHERE pk = 0", false);
+        // The collection tombstone and the new cells have different timestamps
+        check_stmt("UPDATE ks.t SET vmap = {0:0} WHERE pk = 0 AND ck = 0", true);
+        check_stmt("UPDATE ks.t SET vstatic = 0, vint = 0 WHERE pk = 0 AND ck = 0", true);
+    }, mk_cdc_test_config()).get();
+}
+
 SEASTAR_THREAD_TEST_CASE(test_generate_timeuuid) {
     auto seed = std::random_device{}();
     testlog.info("test_generate_timeuuid seed: {}", seed);
@@ -1565,3 +1594,44 @@ SEASTAR_THREAD_TEST_CASE(test_batch_with_row_delete) {
         }
     }, mk_cdc_test_config()).get();
 }
+
+SEASTAR_THREAD_TEST_CASE(test_read_shard_changes) {
+    do_with_cql_env_thread([] (cql_test_env& e) {
+        cquery_nofail(e, "CREATE TABLE ks.t (pk int, ck int, v int, PRIMARY KEY (pk, ck)) WITH cdc = {'enabled':'true', 'preimage':'true'}");
+        for (int i = 0; i < 20; ++i) {
+            cquery_nofail(e, format("INSERT INTO ks.t (pk, ck, v) VALUES ({}, 0, {})", i % 7, i));
+        }
+        auto log_rows = to_bytes(*dynamic_pointer_cast<cql_transport::messages::result_message::rows>(
+                e.execute_cql(format("SELECT * FROM ks.{}", cdc::log_name("t"))).get0()));
+
+        size_t rows_read = 0;
+        for (unsigned shard = 0; shard < smp::count; ++shard) {
+            std::optional<utils::UUID> after;
+            while (true) {
+                auto [rows, last_time] = e.db().invoke_on(shard, [after] (database& db) {
+                    return cdc::read_shard_changes(db, db.find_schema("ks", cdc::log_name("t")), after, std::nullopt, 3).then([] (cdc::shard_changes page) {
+                        std::vector<utils::UUID> times;
+                        for (auto& row : page.rows->rows()) {
+                            // The time is the second column, after the stream ID.
+                            times.push_back(utils::UUID_gen::get_UUID(*row[1]));
+                        }
+                        return std::make_pair(std::move(times), page.last_time);
+                    });
+                }).get0();
+                if (rows.empty()) {
+                    BOOST_REQUIRE(!last_time);
+                    break;
+                }
+                // A change with a preimage has two rows, which are never split.
+                BOOST_REQUIRE_LE(rows.size(), 4);
+                BOOST_REQUIRE(std::is_sorted(rows.begin(), rows.end(), [] (const utils::UUID& a, const utils::UUID& b) {
+                    return timeuuid_type->compare(timeuuid_type->decompose(a), timeuuid_type->decompose(b)) < 0;
+                }));
+                BOOST_REQUIRE(last_time && *last_time == rows.back());
+                rows_read += rows.size();
+                after = last_time;
+            }
+        }
+        BOOST_REQUIRE_EQUAL(rows_read, log_rows.size());
+    }, mk_cdc_test_config()).get();
+}
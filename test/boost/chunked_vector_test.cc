@@ -23,6 +23,7 @@
 
 #include <boost/test/included/unit_test.hpp>
 #include <deque>
+#include <set>
 #include <random>
 #include "utils/chunked_vector.hh"
 
@@ -176,3 +177,31 @@ BOOST_AUTO_TEST_CASE(tests_constructor_exception_safety) {
         BOOST_REQUIRE(checker.ok());
     }
 }
+
+BOOST_AUTO_TEST_CASE(test_full_chunks_are_reused) {
+    // Chunks of a size no other test uses, holding 125 elements.
+    using vector = utils::chunked_vector<uint64_t, 1000>;
+    std::set<const uint64_t*> chunks;
+    {
+        vector c;
+        c.reserve(3 * 125);
+        for (auto i : boost::irange<uint64_t>(0, 3 * 125)) {
+            c.push_back(i);
+        }
+        for (size_t i = 0; i < c.size(); i += 125) {
+            chunks.insert(&c[i]);
+        }
+    }
+    vector c;
+    c.reserve(2 * 125);
+    for (auto i : boost::irange<uint64_t>(0, 2 * 125)) {
+        c.push_back(i + 1);
+    }
+    BOOST_REQUIRE(chunks.count(&c[0]));
+    BOOST_REQUIRE(chunks.count(&c[125]));
+    for (auto i : boost::irange<uint64_t>(0, 2 * 125)) {
+        BOOST_REQUIRE_EQUAL(c[i], i + 1);
+    }
+    c.clear();
+    BOOST_REQUIRE(c.empty());
+}
@@ -22,6 +22,7 @@
 
 #include <boost/test/unit_test.hpp>
 #include <boost/range/adaptor/map.hpp>
+#include <boost/range/irange.hpp>
 
 #include <stdlib.h>
 #include <iostream>
@@ -35,6 +36,7 @@
 #include <seastar/core/scollectd_api.hh>
 #include <seastar/core/file.hh>
 #include <seastar/core/reactor.hh>
+#include <seastar/core/thread.hh>
 #include <seastar/util/noncopyable_function.hh>
 #include "utils/UUID_gen.hh"
 #include "test/lib/tmpdir.hh"
@@ -102,6 +104,31 @@ SEASTAR_TEST_CASE(test_commitlog_written_to_disk_batch){
         });
 }
 
+// check that concurrent writes are acknowledged by group commits
+SEASTAR_TEST_CASE(test_commitlog_batch_group_commit){
+    commitlog::config cfg;
+    cfg.mode = commitlog::sync_mode::BATCH;
+    cfg.commitlog_sync_batch_window_in_ms = 10;
+    return cl_test(cfg, [](commitlog& log) {
+        return do_with(std::vector<replay_position>(), [&log] (std::vector<replay_position>& rps) {
+            return parallel_for_each(boost::irange(0, 100), [&log, &rps] (int) {
+                sstring tmp = "hej bubba cow";
+                return log.add_mutation(utils::UUID_gen::get_time_UUID(), tmp.size(), db::commitlog::force_sync::no, [tmp](db::commitlog::output& dst) {
+                    dst.write(tmp.data(), tmp.size());
+                }).then([&log, &rps](replay_position rp) {
+                    BOOST_REQUIRE_NE(rp, db::replay_position());
+                    BOOST_REQUIRE(log.get_flush_count() > 0);
+                    rps.push_back(rp);
+                });
+            }).then([&log, &rps] {
+                std::sort(rps.begin(), rps.end());
+                BOOST_REQUIRE(std::adjacent_find(rps.begin(), rps.end()) == rps.end());
+                BOOST_REQUIRE_LE(log.get_flush_count(), rps.size());
+            });
+        });
+    });
+}
+
 // check that an entry marked as sync is immediately flushed to a storage
 SEASTAR_TEST_CASE(test_commitlog_written_to_disk_sync){
     commitlog::config cfg;
@@ -409,6 +436,38 @@ SEASTAR_TEST_CASE(test_commitlog_reader){
         });
 }
 
+SEASTAR_TEST_CASE(test_commitlog_compressed_entries){
+    commitlog::config cfg;
+    cfg.entry_compressor = compressor::lz4;
+    return cl_test(cfg, [](commitlog& log) {
+        return seastar::async([&log] {
+            auto uuid = utils::UUID_gen::get_time_UUID();
+            std::vector<sstring> written;
+            for (int i = 0; i < 10; ++i) {
+                // Compressible entries, and one too small to be compressed.
+                written.push_back(i == 5 ? sstring("hej bubba cow") : format("{:d}{}", i, sstring(4096, 'x')));
+                auto& tmp = written.back();
+                log.add_mutation(uuid, tmp.size(), db::commitlog::force_sync::no, [&tmp](db::commitlog::output& dst) {
+                    dst.write(tmp.data(), tmp.size());
+                }).get();
+            }
+            log.sync_all_segments().get();
+
+            std::vector<sstring> read;
+            for (auto& seg : log.get_active_segment_names()) {
+                db::commitlog::read_log_file(seg, db::commitlog::descriptor::FILENAME_PREFIX, service::get_local_commitlog_priority(), [&read](db::commitlog::buffer_and_replay_position buf_rp) {
+                    auto&& [buf, rp] = buf_rp;
+                    auto linearization_buffer = bytes_ostream();
+                    auto in = buf.get_istream();
+                    read.push_back(sstring(to_sstring_view(in.read_bytes_view(buf.size_bytes(), linearization_buffer))));
+                    return make_ready_future<>();
+                }).get();
+            }
+            BOOST_REQUIRE(read == written);
+        });
+    });
+}
+
 static future<> corrupt_segment(sstring seg, uint64_t off, uint32_t value) {
     return open_file_dma(seg, open_flags::rw).then([off, value](file f) {
         size_t size = align_up<size_t>(off, 4096);
@@ -377,3 +377,75 @@ BOOST_AUTO_TEST_CASE(test_composite_validity) {
     BOOST_REQUIRE_EQUAL(is_valid({'\x00', '\x01', 'a'}), false);
     BOOST_REQUIRE_EQUAL(is_valid({'\x00', '\x02', 'a'}), false);
 }
+
+namespace {
+
+// A FragmentRange which splits a buffer into fragments of the given sizes.
+class split_buffer {
+    std::vector<bytes_view> _fragments;
+    size_t _size;
+public:
+    using fragment_type = bytes_view;
+    using iterator = std::vector<bytes_view>::const_iterator;
+    using const_iterator = iterator;
+
+    split_buffer(bytes_view b, size_t fragment_size) : _size(b.size()) {
+        while (!b.empty()) {
+            auto n = std::min(fragment_size, b.size());
+            _fragments.push_back(b.substr(0, n));
+            b.remove_prefix(n);
+        }
+    }
+
+    const_iterator begin() const { return _fragments.begin(); }
+    const_iterator end() const { return _fragments.end(); }
+
+    size_t size_bytes() const { return _size; }
+    bool empty() const { return !_size; }
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(test_fragmented_compare_unsigned) {
+    auto values = to_bytes_vec({"", "a", "ab", "abc", "abd", "b", "abcdefghij", "abcdefghik"});
+    for (auto&& v1 : values) {
+        for (auto&& v2 : values) {
+            auto expected = compare_unsigned(bytes_view(v1), bytes_view(v2));
+            for (size_t s1 : {1, 2, 3, 100}) {
+                for (size_t s2 : {1, 2, 3, 100}) {
+                    auto c = compare_unsigned(split_buffer(v1, s1), split_buffer(v2, s2));
+                    BOOST_REQUIRE_EQUAL(c < 0, expected < 0);
+                    BOOST_REQUIRE_EQUAL(c > 0, expected > 0);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_fragmented_compound_compare) {
+    compound_type<allow_prefixes::yes> t({utf8_type, int32_type, bytes_type});
+
+    std::vector<bytes> packed = {
+        t.serialize_value(std::vector<bytes>{}),
+        t.serialize_value({to_bytes("a")}),
+        t.serialize_value({to_bytes("a"), int32_type->decompose(-1)}),
+        t.serialize_value({to_bytes("a"), int32_type->decompose(1)}),
+        t.serialize_value({to_bytes("a"), int32_type->decompose(1), to_bytes("xyz")}),
+        t.serialize_value({to_bytes("a"), int32_type->decompose(1), to_bytes("xz")}),
+        t.serialize_value({to_bytes("ab"), int32_type->decompose(-7)}),
+        t.serialize_value({to_bytes("b")}),
+    };
+    for (auto&& p1 : packed) {
+        for (auto&& p2 : packed) {
+            auto expected = t.compare(p1, p2);
+            for (size_t s1 : {1, 2, 3, 5, 100}) {
+                for (size_t s2 : {1, 2, 3, 5, 100}) {
+                    auto c = t.compare(split_buffer(p1, s1), split_buffer(p2, s2));
+                    BOOST_REQUIRE_EQUAL(c < 0, expected < 0);
+                    BOOST_REQUIRE_EQUAL(c > 0, expected > 0);
+                    BOOST_REQUIRE_EQUAL(t.equal(split_buffer(p1, s1), split_buffer(p2, s2)), expected == 0);
+                }
+            }
+        }
+    }
+}
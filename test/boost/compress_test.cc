@@ -22,8 +22,10 @@
 #define BOOST_TEST_MODULE core
 
 #include <boost/test/unit_test.hpp>
+#include <zlib.h>
 
 #include "sstables/compress.hh"
+#include "message/rpc_zstd_compressor.hh"
 
 BOOST_AUTO_TEST_CASE(segmented_offsets_basic_functionality) {
     sstables::compression::segmented_offsets offsets;
@@ -156,3 +158,186 @@ BOOST_AUTO_TEST_CASE(segmented_offsets_corner_cases) {
     BOOST_REQUIRE(accessor.at(4079) == 4079);
     BOOST_REQUIRE(accessor.at(4080) == 4080);
 }
+
+BOOST_AUTO_TEST_CASE(zstd_dictionary) {
+    std::map<sstring, sstring> options{
+        {compression_parameters::SSTABLE_COMPRESSION, "ZstdCompressor"},
+        {compression_parameters::CHUNK_LENGTH_KB, "4"},
+        {"dictionary_size_kb", "8"},
+    };
+    auto c = compressor::create(options);
+    auto sample_size = c->dictionary_sample_size();
+    BOOST_REQUIRE_EQUAL(sample_size, 8 * 1024 * 64);
+    BOOST_REQUIRE_GT(c->dictionary_training_memory(), sample_size);
+
+    // Large dictionaries train on a bounded sample, as training isn't preemptible.
+    auto large_options = options;
+    large_options["dictionary_size_kb"] = "63";
+    BOOST_REQUIRE_EQUAL(compressor::create(large_options)->dictionary_sample_size(), 1 << 20);
+
+    // Small chunks of similar records, which compress poorly on their own.
+    std::vector<temporary_buffer<char>> chunks;
+    size_t sampled = 0;
+    for (int record = 0; sampled < sample_size; ) {
+        sstring chunk;
+        while (chunk.size() < 4096 - 128) {
+            chunk += format("{{\"id\": {:d}, \"name\": \"user-{:d}\", \"email\": \"user-{:d}@example.com\", \"active\": {}}}\n",
+                    record, record * 7, record * 13, record % 3 == 0);
+            ++record;
+        }
+        sampled += chunk.size();
+        chunks.emplace_back(chunk.data(), chunk.size());
+    }
+
+    auto dictionary_options = c->train(chunks);
+    BOOST_REQUIRE_EQUAL(dictionary_options.size(), 1);
+    options.insert(dictionary_options.begin(), dictionary_options.end());
+    auto dc = compressor::create(options);
+    BOOST_REQUIRE_EQUAL(dc->dictionary_sample_size(), 0);
+
+    size_t plain_size = 0;
+    size_t dictionary_size = 0;
+    for (auto& chunk : chunks) {
+        std::vector<char> compressed(c->compress_max_size(chunk.size()));
+        plain_size += c->compress(chunk.get(), chunk.size(), compressed.data(), compressed.size());
+
+        std::vector<char> dcompressed(dc->compress_max_size(chunk.size()));
+        auto len = dc->compress(chunk.get(), chunk.size(), dcompressed.data(), dcompressed.size());
+        dictionary_size += len;
+
+        std::vector<char> uncompressed(chunk.size());
+        BOOST_REQUIRE_EQUAL(dc->uncompress(dcompressed.data(), len, uncompressed.data(), uncompressed.size()), chunk.size());
+        BOOST_REQUIRE(std::equal(uncompressed.begin(), uncompressed.end(), chunk.get()));
+    }
+    BOOST_TEST_MESSAGE(format("compressed without dictionary: {:d}, with dictionary: {:d}", plain_size, dictionary_size));
+    BOOST_REQUIRE_LT(dictionary_size, plain_size);
+}
+
+// DeflateCompressor streams must stay readable by, and able to read, zlib,
+// which is what Cassandra's DeflateCompressor produces.
+BOOST_AUTO_TEST_CASE(deflate_compatible_with_zlib) {
+    auto& c = compressor::deflate;
+    for (size_t size : {size_t(0), size_t(100), size_t(65536)}) {
+        std::vector<char> input;
+        for (size_t i = 0; input.size() < size; ++i) {
+            auto line = format("row {:d} of partition {:d}\n", i, i % 13);
+            input.insert(input.end(), line.begin(), line.end());
+        }
+        input.resize(size);
+
+        std::vector<char> compressed(c->compress_max_size(size));
+        auto len = c->compress(input.data(), size, compressed.data(), compressed.size());
+        std::vector<char> output(size);
+        uLongf output_len = size;
+        BOOST_REQUIRE_EQUAL(::uncompress(reinterpret_cast<Bytef*>(output.data()), &output_len,
+                reinterpret_cast<const Bytef*>(compressed.data()), len), Z_OK);
+        BOOST_REQUIRE_EQUAL(output_len, size);
+        BOOST_REQUIRE(output == input);
+
+        uLongf zlib_len = compressBound(size);
+        std::vector<char> zlib_compressed(zlib_len);
+        BOOST_REQUIRE_EQUAL(::compress(reinterpret_cast<Bytef*>(zlib_compressed.data()), &zlib_len,
+                reinterpret_cast<const Bytef*>(input.data()), size), Z_OK);
+        std::fill(output.begin(), output.end(), 0);
+        BOOST_REQUIRE_EQUAL(c->uncompress(zlib_compressed.data(), zlib_len, output.data(), output.size()), size);
+        BOOST_REQUIRE(output == input);
+    }
+
+    char garbage[] = "not a deflate stream";
+    char output[100];
+    BOOST_REQUIRE_THROW(c->uncompress(garbage, sizeof(garbage), output, sizeof(output)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(auto_compression_parameters) {
+    compression_parameters cp({{compression_parameters::SSTABLE_COMPRESSION, compression_parameters::AUTO}});
+    BOOST_REQUIRE(cp.is_auto());
+    BOOST_REQUIRE(cp.is_auto_chunk_length());
+    BOOST_REQUIRE(compression_parameters(cp.get_options()) == cp);
+
+    auto fixed = cp.with_chunk_length(16 * 1024);
+    BOOST_REQUIRE(fixed.is_auto());
+    BOOST_REQUIRE(!fixed.is_auto_chunk_length());
+    BOOST_REQUIRE_EQUAL(fixed.chunk_length(), 16 * 1024);
+
+    BOOST_REQUIRE_EQUAL(compression_parameters::auto_chunk_length(0), compression_parameters::AUTO_MIN_CHUNK_LENGTH);
+    BOOST_REQUIRE_EQUAL(compression_parameters::auto_chunk_length(5000), 8 * 1024);
+    BOOST_REQUIRE_EQUAL(compression_parameters::auto_chunk_length(16 * 1024), 16 * 1024);
+    BOOST_REQUIRE_EQUAL(compression_parameters::auto_chunk_length(10 << 20), compression_parameters::AUTO_MAX_CHUNK_LENGTH);
+
+    // Incompressible data compresses equally badly with all candidates,
+    // so the cheapest one is chosen.
+    std::vector<temporary_buffer<char>> samples;
+    uint32_t x = 12345;
+    for (int chunk = 0; chunk < 4; ++chunk) {
+        temporary_buffer<char> buf(4096);
+        for (size_t i = 0; i < buf.size(); ++i) {
+            x = x * 1103515245 + 12345;
+            buf.get_write()[i] = char(x >> 24);
+        }
+        samples.push_back(std::move(buf));
+    }
+    BOOST_REQUIRE(compression_parameters::choose_compressor(samples) == compressor::lz4);
+}
+
+static std::vector<char> linearize(std::variant<std::vector<temporary_buffer<char>>, temporary_buffer<char>>& bufs) {
+    std::vector<char> ret;
+    if (auto* single = std::get_if<temporary_buffer<char>>(&bufs)) {
+        ret.insert(ret.end(), single->begin(), single->end());
+    } else {
+        for (auto& b : std::get<std::vector<temporary_buffer<char>>>(bufs)) {
+            ret.insert(ret.end(), b.begin(), b.end());
+        }
+    }
+    return ret;
+}
+
+BOOST_AUTO_TEST_CASE(rpc_zstd_round_trip) {
+    netw::rpc_zstd_compressor::factory factory;
+    BOOST_REQUIRE(!factory.negotiate("LZ4", true));
+    auto c = factory.negotiate(factory.supported(), false);
+    BOOST_REQUIRE(c);
+    const size_t head_space = 4;
+
+    for (size_t size : {size_t(0), size_t(100), size_t(1000000)}) {
+        std::vector<char> input;
+        for (size_t i = 0; input.size() < size; ++i) {
+            auto line = format("mutation {:d} of keyspace ks, table t{:d}\n", i, i % 7);
+            input.insert(input.end(), line.begin(), line.end());
+        }
+        input.resize(size);
+
+        // Fragment the input at odd offsets, as the rpc layer may.
+        std::vector<temporary_buffer<char>> fragments;
+        for (size_t pos = 0; pos < input.size(); pos += 77777) {
+            auto n = std::min<size_t>(77777, input.size() - pos);
+            fragments.emplace_back(input.data() + pos, n);
+        }
+        seastar::rpc::snd_buf data;
+        data.size = input.size();
+        data.bufs = std::move(fragments);
+
+        auto compressed = c->compress(head_space, std::move(data));
+        auto wire = linearize(compressed.bufs);
+        BOOST_REQUIRE_EQUAL(wire.size(), compressed.size);
+        if (size > 0) {
+            BOOST_REQUIRE_LT(compressed.size, size);
+        }
+
+        // Deliver it in small, unaligned fragments.
+        std::vector<temporary_buffer<char>> received;
+        for (size_t pos = head_space; pos < wire.size(); pos += 3001) {
+            auto n = std::min<size_t>(3001, wire.size() - pos);
+            received.emplace_back(wire.data() + pos, n);
+        }
+        seastar::rpc::rcv_buf rcv;
+        rcv.size = wire.size() - head_space;
+        rcv.bufs = std::move(received);
+        auto decompressed = c->decompress(std::move(rcv));
+        BOOST_REQUIRE_EQUAL(decompressed.size, size);
+        auto output = linearize(decompressed.bufs);
+        BOOST_REQUIRE(output == input);
+    }
+
+    seastar::rpc::rcv_buf truncated(temporary_buffer<char>(2));
+    BOOST_REQUIRE_THROW(c->decompress(std::move(truncated)), std::runtime_error);
+}
@@ -33,6 +33,7 @@
 #include "keys.hh"
 #include "mutation.hh"
 #include "frozen_mutation.hh"
+#include "db/counter_cache.hh"
 
 void verify_shard_order(counter_cell_view ccv) {
     if (ccv.shards().begin() == ccv.shards().end()) {
@@ -471,6 +472,75 @@ SEASTAR_TEST_CASE(test_transfer_updates_to_shards) {
     });
 }
 
+SEASTAR_TEST_CASE(test_counter_cache) {
+    return seastar::async([] {
+        storage_service_for_tests ssft;
+
+        auto s = get_schema();
+
+        auto pk = partition_key::from_single_value(*s, int32_type->decompose(0));
+        auto ck = clustering_key::from_single_value(*s, int32_type->decompose(0));
+        auto& col = *s->get_column_definition(utf8_type->decompose(sstring("c1")));
+        auto& scol = *s->get_column_definition(utf8_type->decompose(sstring("s1")));
+
+        auto make_update = [&] (int64_t c, int64_t sc) {
+            mutation m(s, pk);
+            m.set_clustered_cell(ck, col, atomic_cell::make_live_counter_update(api::new_timestamp(), c));
+            m.set_static_cell(scol, atomic_cell::make_live_counter_update(api::new_timestamp(), sc));
+            return m;
+        };
+
+        db::counter_cache cache(1024 * 1024);
+
+        auto m1 = make_update(5, 4);
+        BOOST_REQUIRE(!cache.get_local_shards(m1));
+        BOOST_REQUIRE_EQUAL(cache.get_stats().misses, 1);
+        transform_counter_updates_to_shards(m1, nullptr, 0);
+        cache.populate(m1);
+
+        // The cached shards must produce the same update as the full state.
+        auto m2 = make_update(9, 8);
+        auto state = cache.get_local_shards(m2);
+        BOOST_REQUIRE(state);
+        BOOST_REQUIRE_EQUAL(cache.get_stats().hits, 1);
+        auto expected = m2;
+        transform_counter_updates_to_shards(expected, &m1, 0);
+        transform_counter_updates_to_shards(m2, &*state, 0);
+        BOOST_REQUIRE_EQUAL(m2, expected);
+        counter_cell_view::with_linearized(get_counter_cell(m2), [&] (counter_cell_view ccv) {
+            BOOST_REQUIRE_EQUAL(ccv.total_value(), 14);
+        });
+        cache.populate(m2);
+
+        // A cell which is not cached makes the whole update miss.
+        auto m3 = make_update(1, 1);
+        auto ck2 = clustering_key::from_single_value(*s, int32_type->decompose(1));
+        m3.set_clustered_cell(ck2, col, atomic_cell::make_live_counter_update(api::new_timestamp(), 1));
+        BOOST_REQUIRE(!cache.get_local_shards(m3));
+
+        // Writes which don't delete anything keep the partition cached...
+        cache.on_write(*s, freeze(m2));
+        BOOST_REQUIRE(cache.get_local_shards(make_update(1, 1)));
+
+        // ...deletions invalidate it.
+        mutation del(s, pk);
+        del.partition().apply(tombstone(api::new_timestamp(), gc_clock::now()));
+        cache.on_write(*s, freeze(del));
+        BOOST_REQUIRE_EQUAL(cache.get_stats().invalidations, 1);
+        BOOST_REQUIRE(!cache.get_local_shards(make_update(1, 1)));
+
+        cache.populate(m2);
+        cache.invalidate(s->id());
+        BOOST_REQUIRE(!cache.get_local_shards(make_update(1, 1)));
+        BOOST_REQUIRE_EQUAL(cache.get_stats().bytes, 0);
+
+        // A disabled cache never caches anything.
+        cache.set_max_bytes(0);
+        cache.populate(m2);
+        BOOST_REQUIRE(!cache.get_local_shards(make_update(1, 1)));
+    });
+}
+
 SEASTAR_TEST_CASE(test_sanitize_corrupted_cells) {
     return seastar::async([] {
         std::random_device rd;
@@ -50,6 +50,7 @@
 #include "json.hh"
 #include "schema_builder.hh"
 #include "service/migration_manager.hh"
+#include "service/pager/paging_state.hh"
 #include <regex>
 
 using namespace std::literals::chrono_literals;
@@ -1650,6 +1651,13 @@ SEASTAR_TEST_CASE(test_table_compression) {
         e.execute_cql("create table tb6 (foo text PRIMARY KEY, bar text);").get();
         e.require_table_exists("ks", "tb6").get();
         BOOST_REQUIRE(e.local_db().find_schema("ks", "tb6")->get_compressor_params().get_compressor() == compressor::lz4);
+
+        e.execute_cql("create table tb7 (foo text PRIMARY KEY, bar text) with compression = { 'sstable_compression' : 'auto' };").get();
+        e.require_table_exists("ks", "tb7").get();
+        auto& auto_params = e.local_db().find_schema("ks", "tb7")->get_compressor_params();
+        BOOST_REQUIRE(auto_params.is_auto());
+        BOOST_REQUIRE(auto_params.is_auto_chunk_length());
+        BOOST_REQUIRE_EQUAL(auto_params.get_options().at(compression_parameters::SSTABLE_COMPRESSION), compression_parameters::AUTO);
     });
 }
 
@@ -4414,3 +4422,190 @@ SEASTAR_TEST_CASE(test_range_deletions_for_specific_column) {
                 exceptions::invalid_request_exception);
     });
 }
+
+SEASTAR_TEST_CASE(test_parallelized_aggregates) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        cquery_nofail(e, "create table t (p int, c int, v int, primary key(p, c))");
+        int32_t sum = 0;
+        for (int p = 0; p < 100; ++p) {
+            for (int c = 0; c < 5; ++c) {
+                cquery_nofail(e, format("insert into t (p, c, v) values ({}, {}, {})", p, c, p * 5 + c));
+                sum += p * 5 + c;
+            }
+        }
+
+        auto& stats = e.local_qp().get_cql_stats();
+        auto parallelized = stats.select_parallelized_aggregates;
+        require_rows(e, "select count(*) from t", {{L(500)}});
+        require_rows(e, "select count(*), min(v), max(v), sum(v) from t", {{L(500), I(0), I(499), I(sum)}});
+        BOOST_REQUIRE_GT(stats.select_parallelized_aggregates, parallelized);
+
+        // Grouping by partition is parallelized unless a limit applies to
+        // the groups, and returns the groups in the same order either way.
+        parallelized = stats.select_parallelized_aggregates;
+        auto grouped = e.execute_cql("select p, count(*), sum(v) from t group by p").get0();
+        BOOST_REQUIRE_GT(stats.select_parallelized_aggregates, parallelized);
+        parallelized = stats.select_parallelized_aggregates;
+        auto grouped_rows = [] (shared_ptr<cql_transport::messages::result_message> msg) {
+            auto rows = dynamic_pointer_cast<cql_transport::messages::result_message::rows>(msg);
+            BOOST_REQUIRE(rows);
+            const auto& rs = rows->rs().result_set().rows();
+            return std::vector<std::vector<bytes_opt>>(rs.begin(), rs.end());
+        };
+        auto sequential = e.execute_cql("select p, count(*), sum(v) from t group by p limit 1000").get0();
+        BOOST_REQUIRE_EQUAL(stats.select_parallelized_aggregates, parallelized);
+        BOOST_REQUIRE_EQUAL(grouped_rows(grouped).size(), 100);
+        BOOST_REQUIRE(grouped_rows(grouped) == grouped_rows(sequential));
+        cquery_nofail(e, "create table empty (p int, c int, v int, primary key(p, c))");
+        BOOST_REQUIRE_EQUAL(grouped_rows(e.execute_cql("select p, count(*) from empty group by p").get0()).size(),
+                grouped_rows(e.execute_cql("select p, count(*) from empty group by p limit 10").get0()).size());
+        parallelized = stats.select_parallelized_aggregates;
+
+        // Mixing aggregates with simple selections and single partitions
+        // keep using the sequential path.
+        require_rows(e, "select p, count(*) from t where p = 7", {{I(7), L(5)}});
+        require_rows(e, "select count(*) from t where p in (1, 2)", {{L(10)}});
+        cquery_nofail(e, "select c, count(*) from t");
+        BOOST_REQUIRE_EQUAL(stats.select_parallelized_aggregates, parallelized);
+    });
+}
+
+SEASTAR_TEST_CASE(test_aggregates_computed_on_replicas) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        BOOST_REQUIRE(e.local_db().features().cluster_supports_parallelized_aggregation());
+        cquery_nofail(e, "create table t (p int, c int, v int, d double, n varint, primary key(p, c))");
+        for (int p = 0; p < 50; ++p) {
+            for (int c = 0; c < 3; ++c) {
+                auto v = p * 4 + c;
+                cquery_nofail(e, format("insert into t (p, c, v, d, n) values ({}, {}, {}, {}, {})", p, c, v, v / 2.0, v));
+            }
+            cquery_nofail(e, format("insert into t (p, c) values ({}, 3)", p));
+        }
+
+        // The states of the aggregates of the many vnodes of the node are
+        // merged, including those of vnodes without rows.
+        auto& stats = e.local_qp().get_cql_stats();
+        auto parallelized = stats.select_parallelized_aggregates;
+        require_rows(e, "select count(*), count(v), sum(v), avg(v), min(v), max(v), sum(n), avg(d) from t",
+                {{L(200), L(150), I(14850), I(99), I(0), I(198), varint_type->decompose(utils::multiprecision_int(14850)),
+                double_type->decompose(49.5)}});
+        BOOST_REQUIRE_GT(stats.select_parallelized_aggregates, parallelized);
+
+        auto rows_of = [] (shared_ptr<cql_transport::messages::result_message> msg) {
+            auto rows = dynamic_pointer_cast<cql_transport::messages::result_message::rows>(msg);
+            BOOST_REQUIRE(rows);
+            const auto& rs = rows->rs().result_set().rows();
+            return std::vector<std::vector<bytes_opt>>(rs.begin(), rs.end());
+        };
+        // A limit keeps GROUP BY on the coordinator, which must agree.
+        for (auto query : {"select p, count(v), sum(v), max(d) from t group by p",
+                "select p, c, count(*), min(v) from t group by p, c"}) {
+            parallelized = stats.select_parallelized_aggregates;
+            auto replicas = rows_of(e.execute_cql(query).get0());
+            BOOST_REQUIRE_GT(stats.select_parallelized_aggregates, parallelized);
+            auto coordinator = rows_of(e.execute_cql(format("{} limit 100000", query)).get0());
+            BOOST_REQUIRE(!replicas.empty());
+            BOOST_REQUIRE(replicas == coordinator);
+        }
+
+        // Replicas page through their ranges, so with small pages most
+        // groups start in one page and end in a later one. Their rows must
+        // still be aggregated into a single row per group.
+        for (int32_t page_size : {1, 3}) {
+            for (auto query : {"select p, count(*), sum(v) from t group by p",
+                    "select p, c, count(v) from t group by p, c"}) {
+                auto qo = std::make_unique<cql3::query_options>(db::consistency_level::ONE, infinite_timeout_config,
+                        std::vector<cql3::raw_value>{}, cql3::query_options::specific_options{page_size, nullptr, {}, api::new_timestamp()});
+                parallelized = stats.select_parallelized_aggregates;
+                auto replicas = rows_of(e.execute_cql(query, std::move(qo)).get0());
+                BOOST_REQUIRE_GT(stats.select_parallelized_aggregates, parallelized);
+                BOOST_REQUIRE(replicas == rows_of(e.execute_cql(format("{} limit 100000", query)).get0()));
+            }
+        }
+
+        cquery_nofail(e, "create table empty (p int, c int, v int, primary key(p, c))");
+        require_rows(e, "select count(*), max(v) from empty", {{L(0), std::nullopt}});
+        BOOST_REQUIRE(rows_of(e.execute_cql("select p, count(*) from empty group by p").get0())
+                == rows_of(e.execute_cql("select p, count(*) from empty group by p limit 10").get0()));
+    });
+}
+
+SEASTAR_TEST_CASE(test_paging_with_page_size_in_bytes) {
+    auto cfg = make_shared<db::config>();
+    cfg->page_size_in_bytes(20000);
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE t (pk int, ck int, v blob, PRIMARY KEY (pk, ck));").get();
+        const int rows = 20;
+        const auto value = bytes(4096, int8_t(7));
+        auto insert = e.prepare("INSERT INTO t (pk, ck, v) VALUES (0, ?, ?);").get0();
+        for (int ck = 0; ck < rows; ++ck) {
+            e.execute_prepared(insert, {cql3::raw_value::make_value(int32_type->decompose(ck)), cql3::raw_value::make_value(value)}).get();
+        }
+
+        lw_shared_ptr<service::pager::paging_state> paging_state;
+        int fetched = 0;
+        int pages = 0;
+        do {
+            auto qo = std::make_unique<cql3::query_options>(db::consistency_level::LOCAL_ONE, infinite_timeout_config, std::vector<cql3::raw_value>{},
+                    cql3::query_options::specific_options{100, paging_state, {}, api::new_timestamp()});
+            auto msg = e.execute_cql("SELECT * FROM t WHERE pk = 0;", std::move(qo)).get0();
+            auto rs = dynamic_pointer_cast<cql_transport::messages::result_message::rows>(msg);
+            auto page_rows = int(rs->rs().result_set().size());
+            // Pages are cut well before reaching the page size in rows.
+            BOOST_REQUIRE_LE(page_rows, 6);
+            fetched += page_rows;
+            ++pages;
+            auto state = rs->rs().get_metadata().paging_state();
+            paging_state = state ? make_lw_shared<service::pager::paging_state>(*state) : nullptr;
+            if (paging_state && page_rows) {
+                BOOST_REQUIRE_GT(paging_state->get_average_row_size(), 4096);
+            }
+        } while (paging_state && paging_state->get_remaining());
+        BOOST_REQUIRE_EQUAL(fetched, rows);
+        BOOST_REQUIRE_GE(pages, 4);
+    }, cql_test_config(cfg));
+}
+
+SEASTAR_TEST_CASE(test_result_metadata_id) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE t (p int PRIMARY KEY, a int, b text)").get();
+        auto metadata_id_of = [&] (sstring query) {
+            auto msg = e.execute_cql(query).get0();
+            auto rows = dynamic_pointer_cast<cql_transport::messages::result_message::rows>(msg);
+            BOOST_REQUIRE(rows);
+            return rows->rs().get_metadata().metadata_id();
+        };
+        auto id = metadata_id_of("SELECT p, a FROM t");
+        BOOST_REQUIRE_EQUAL(id, metadata_id_of("SELECT p, a FROM t WHERE p = 1"));
+        BOOST_REQUIRE_NE(id, metadata_id_of("SELECT a, p FROM t"));
+        BOOST_REQUIRE_NE(id, metadata_id_of("SELECT p, b FROM t"));
+
+        auto star_id = metadata_id_of("SELECT * FROM t");
+        e.execute_cql("ALTER TABLE t ADD c int").get();
+        BOOST_REQUIRE_NE(star_id, metadata_id_of("SELECT * FROM t"));
+    });
+}
+
+SEASTAR_TEST_CASE(test_unprepared_statement_cache) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE t (p int PRIMARY KEY, v int)").get();
+        auto execute = [&] (sstring query, std::vector<cql3::raw_value> values) {
+            auto qo = std::make_unique<cql3::query_options>(db::consistency_level::ONE, infinite_timeout_config, std::move(values),
+                    cql3::query_options::specific_options::DEFAULT);
+            return e.execute_cql(query, std::move(qo)).get0();
+        };
+        auto value = [] (int v) {
+            return cql3::raw_value::make_value(int32_type->decompose(v));
+        };
+        for (int i = 0; i < 3; ++i) {
+            execute("INSERT INTO t (p, v) VALUES (?, ?)", {value(i), value(i * 10)});
+        }
+        for (int i = 0; i < 3; ++i) {
+            assert_that(execute("SELECT * FROM t WHERE p = ?", {value(i)})).is_rows().with_rows({{int32_type->decompose(i), int32_type->decompose(i * 10)}});
+        }
+
+        // The cached SELECT * must not outlive the columns it selects.
+        e.execute_cql("ALTER TABLE t ADD w int").get();
+        assert_that(execute("SELECT * FROM t WHERE p = ?", {value(1)})).is_rows().with_rows({{int32_type->decompose(1), int32_type->decompose(10), {}}});
+    });
+}
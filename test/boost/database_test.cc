@@ -27,6 +27,7 @@
 
 #include "test/lib/cql_test_env.hh"
 #include "test/lib/result_set_assertions.hh"
+#include "test/lib/cql_assertions.hh"
 
 #include "database.hh"
 #include "partition_slice_builder.hh"
@@ -35,10 +36,15 @@
 #include "schema_registry.hh"
 #include "service/migration_manager.hh"
 #include "sstables/sstables.hh"
+#include "sstables/time_window_compaction_strategy.hh"
 #include "db/config.hh"
 #include "db/commitlog/commitlog_replayer.hh"
 #include "test/lib/tmpdir.hh"
 #include "db/data_listeners.hh"
+#include "db/bulk_ingest.hh"
+#include "db/snapshot_backup.hh"
+#include "db/per_partition_rate_limit_extension.hh"
+#include "db/extensions.hh"
 
 using namespace std::chrono_literals;
 
@@ -126,6 +132,49 @@ SEASTAR_TEST_CASE(test_querying_with_limits) {
     });
 }
 
+SEASTAR_TEST_CASE(test_query_partitions) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table ks.cf (k text, v int, primary key (k));").get();
+        auto& db = e.local_db();
+        auto s = db.find_schema("ks", "cf");
+        dht::partition_range_vector pranges;
+        for (int32_t i = 1; i <= 6; ++i) {
+            auto pkey = partition_key::from_single_value(*s, to_bytes(format("key{:d}", i)));
+            if (i != 4) {
+                mutation m(s, pkey);
+                m.set_clustered_cell(clustering_key_prefix::make_empty(), "v", i, 1);
+                db.apply(s, freeze(m), db::commitlog::force_sync::no, db::no_timeout).get();
+            }
+            pranges.emplace_back(dht::partition_range::make_singular(dht::decorate_key(*s, std::move(pkey))));
+        }
+        // The results follow the order of the ranges, not the ring order.
+        std::reverse(pranges.begin(), pranges.end());
+
+        auto max_size = std::numeric_limits<size_t>::max();
+        auto query = [&] (const query::read_command& cmd) {
+            auto results = std::get<0>(db.query_partitions(s, cmd, pranges, nullptr, max_size, db::no_timeout).get());
+            std::vector<std::vector<int32_t>> values;
+            for (auto& r : results) {
+                auto& vs = values.emplace_back();
+                for (auto& row : query::result_set::from_raw_result(s, cmd.slice, *r).rows()) {
+                    vs.push_back(row.get_nonnull<int32_t>("v"));
+                }
+            }
+            return values;
+        };
+
+        auto cmd = query::read_command(s->id(), s->version(), partition_slice_builder(*s).build(), query::max_rows);
+        BOOST_REQUIRE(query(cmd) == (std::vector<std::vector<int32_t>>{{6}, {5}, {}, {3}, {2}, {1}}));
+
+        // Limits apply to all partitions together, in the given order.
+        cmd = query::read_command(s->id(), s->version(), partition_slice_builder(*s).build(), 3);
+        BOOST_REQUIRE(query(cmd) == (std::vector<std::vector<int32_t>>{{6}, {5}, {}, {3}}));
+        cmd = query::read_command(s->id(), s->version(), partition_slice_builder(*s).build(),
+                query::max_rows, gc_clock::now(), std::nullopt, 2);
+        BOOST_REQUIRE(query(cmd) == (std::vector<std::vector<int32_t>>{{6}, {5}}));
+    });
+}
+
 SEASTAR_THREAD_TEST_CASE(test_database_with_data_in_sstables_is_a_mutation_source) {
     do_with_cql_env([] (cql_test_env& e) {
         run_mutation_source_tests([&] (schema_ptr s, const std::vector<mutation>& partitions) -> mutation_source {
@@ -454,6 +503,49 @@ SEASTAR_TEST_CASE(clear_nonexistent_snapshot) {
     });
 }
 
+static uint64_t backup_snapshot(cql_test_env& e, sstring tag, sstring destination) {
+    uint64_t copied = 0;
+    for (unsigned shard = 0; shard < smp::count; ++shard) {
+        copied += e.db().invoke_on(shard, [tag, destination] (database& db) {
+            auto limiter = make_lw_shared<db::bandwidth_limiter>([] { return uint64_t(0); });
+            return db::backup_snapshot(db.find_column_family("ks", "cf"), tag, destination, *limiter).finally([limiter] { });
+        }).get0();
+    }
+    return copied;
+}
+
+SEASTAR_TEST_CASE(snapshot_backup_is_incremental) {
+    return do_with_some_data([] (cql_test_env& e) {
+        tmpdir backup;
+        take_snapshot(e).get();
+        auto& cf = e.local_db().find_column_family("ks", "cf");
+        auto table_dir = backup.path() / "ks" / fs::path(cf.dir()).filename();
+
+        auto copied = backup_snapshot(e, "test", backup.path().native());
+        BOOST_REQUIRE_GT(copied, 0);
+        BOOST_REQUIRE(fs::exists(table_dir / "snapshots" / "test" / "manifest.json"));
+        lister::scan_dir(fs::path(cf.dir()) / "snapshots" / "test", { directory_entry_type::regular }, [&table_dir] (fs::path dir, directory_entry de) {
+            if (de.name != "manifest.json" && de.name != "schema.cql") {
+                BOOST_REQUIRE_EQUAL(fs::file_size(table_dir / de.name), fs::file_size(dir / de.name));
+            }
+            return make_ready_future<>();
+        }).get();
+
+        // Nothing but the manifest and the schema needs copying again.
+        BOOST_REQUIRE_LT(backup_snapshot(e, "test", backup.path().native()), copied);
+
+        e.execute_cql("insert into cf (p1, c1, c2, r1) values ('key2', 1, 2, 3);").get();
+        e.db().invoke_on_all([] (database& db) {
+            return db.find_column_family("ks", "cf").snapshot("test2");
+        }).get();
+        BOOST_REQUIRE_GT(backup_snapshot(e, "test2", backup.path().native()), 0);
+        BOOST_REQUIRE(fs::exists(table_dir / "snapshots" / "test2" / "manifest.json"));
+
+        BOOST_REQUIRE_EQUAL(backup_snapshot(e, "nonexistent", backup.path().native()), 0);
+        return make_ready_future<>();
+    });
+}
+
 
 // toppartitions_query caused a lw_shared_ptr to cross shards when moving results, #5104
 SEASTAR_TEST_CASE(toppartitions_cross_shard_schema_ptr) {
@@ -470,3 +562,256 @@ SEASTAR_TEST_CASE(toppartitions_cross_shard_schema_ptr) {
         tq.gather().get();
     });
 }
+
+// A memtable holding writes from several time windows must be flushed into
+// one sstable per window when the table uses TWCS.
+SEASTAR_TEST_CASE(test_time_window_memtable_flush_is_segregated) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE ks.twcs (k int, c int, v int, PRIMARY KEY (k, c)) WITH compaction = "
+                "{'class': 'TimeWindowCompactionStrategy', 'compaction_window_unit': 'HOURS', 'compaction_window_size': '1'}").get();
+        const api::timestamp_type hour = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::hours(1)).count();
+        auto now = api::new_timestamp();
+        // Insert the windows out of order, as late-arriving writes would.
+        for (int window : {1, 0, 2}) {
+            for (int c = 0; c < 10; ++c) {
+                e.execute_cql(format("INSERT INTO ks.twcs (k, c, v) VALUES (0, {:d}, 0) USING TIMESTAMP {:d}", c, now - window * hour)).get();
+            }
+        }
+
+        // Returns the number of sstables and the number of those spanning several windows.
+        using counts = std::pair<size_t, size_t>;
+        auto res = e.db().map_reduce0([] (database& db) {
+            auto& cf = db.find_column_family("ks", "twcs");
+            return cf.flush().then([&cf] {
+                counts c{0, 0};
+                for (auto& sst : *cf.get_sstables()) {
+                    auto& stats = sst->get_stats_metadata();
+                    auto window = [] (api::timestamp_type ts) {
+                        return sstables::time_window_compaction_strategy::get_window_lower_bound(std::chrono::hours(1), ts);
+                    };
+                    c.first++;
+                    c.second += window(stats.min_timestamp) != window(stats.max_timestamp);
+                }
+                return c;
+            });
+        }, counts{0, 0}, [] (counts a, counts b) {
+            return counts{a.first + b.first, a.second + b.second};
+        }).get0();
+        BOOST_REQUIRE_EQUAL(res.first, 3);
+        BOOST_REQUIRE_EQUAL(res.second, 0);
+
+        auto msg = e.execute_cql("SELECT * FROM ks.twcs").get0();
+        assert_that(msg).is_rows().with_size(30);
+    });
+}
+
+// Single partition reads account the sstables they select, skip and read,
+// and the bytes they read from them, in the table statistics.
+SEASTAR_TEST_CASE(test_sstable_read_amplification_stats) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE ks.amp (pk int, ck int, v int, PRIMARY KEY (pk, ck))").get();
+        // Two sstables with interleaved keys, so both overlap any key.
+        for (int parity : {0, 1}) {
+            for (int pk = parity; pk < 200; pk += 2) {
+                e.execute_cql(format("INSERT INTO ks.amp (pk, ck, v) VALUES ({}, 0, 0)", pk)).get();
+            }
+            e.db().invoke_on_all([] (database& db) {
+                return db.find_column_family("ks", "amp").flush();
+            }).get();
+        }
+
+        e.execute_cql("SELECT * FROM ks.amp WHERE pk = 100 BYPASS CACHE").get();
+
+        auto stats = e.db().map_reduce0([] (database& db) {
+            auto& s = db.find_column_family("ks", "amp").get_stats();
+            return std::make_tuple(s.estimated_sstable_bytes_per_read.count(), int64_t(s.estimated_sstable_bytes_per_read._sample_sum),
+                    s.estimated_sstables_filtered_by_bloom_filter_per_read.count());
+        }, std::make_tuple(int64_t(0), int64_t(0), int64_t(0)), [] (auto a, auto b) {
+            return std::make_tuple(std::get<0>(a) + std::get<0>(b), std::get<1>(a) + std::get<1>(b), std::get<2>(a) + std::get<2>(b));
+        }).get0();
+        BOOST_REQUIRE_EQUAL(std::get<0>(stats), 1);
+        BOOST_REQUIRE_GT(std::get<1>(stats), 0);
+        BOOST_REQUIRE_EQUAL(std::get<2>(stats), 1);
+    });
+}
+
+SEASTAR_TEST_CASE(test_bulk_ingest_writes_sstables_directly) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE ks.bulk (pk int, ck int, v int, PRIMARY KEY (pk, ck))").get();
+        auto s = e.local_db().find_schema("ks", "bulk");
+
+        // A small buffer, so that several runs are spilled.
+        db::bulk_ingester ingester(e.db(), s, 4096);
+        const int partitions = 100;
+        // Unsorted input, with each partition split across two mutations.
+        for (int half : {1, 0}) {
+            for (int pk = partitions - 1; pk >= 0; --pk) {
+                mutation m(s, partition_key::from_single_value(*s, int32_type->decompose(pk)));
+                for (int ck = half; ck < 4; ck += 2) {
+                    m.set_clustered_cell(clustering_key::from_single_value(*s, int32_type->decompose(ck)), "v", data_value(pk + ck), 1);
+                }
+                ingester.add(std::move(m)).get();
+            }
+        }
+        ingester.flush().get();
+        BOOST_REQUIRE_EQUAL(ingester.buffered_bytes(), 0);
+
+        auto sstables = e.db().map_reduce0([] (database& db) {
+            auto& cf = db.find_column_family("ks", "bulk");
+            BOOST_REQUIRE(cf.active_memtable().empty());
+            return cf.get_sstables()->size();
+        }, size_t(0), std::plus<size_t>()).get0();
+        BOOST_REQUIRE_GT(sstables, 0);
+
+        auto msg = e.execute_cql("SELECT count(*) FROM ks.bulk").get0();
+        assert_that(msg).is_rows().with_rows({{long_type->decompose(int64_t(partitions * 4))}});
+        msg = e.execute_cql("SELECT v FROM ks.bulk WHERE pk = 7").get0();
+        assert_that(msg).is_rows().with_rows({
+            {int32_type->decompose(7)}, {int32_type->decompose(8)}, {int32_type->decompose(9)}, {int32_type->decompose(10)}});
+
+        e.execute_cql("CREATE TABLE ks.bulk_counters (pk int PRIMARY KEY, c counter)").get();
+        BOOST_REQUIRE_THROW(db::bulk_ingester(e.db(), e.local_db().find_schema("ks", "bulk_counters")), std::invalid_argument);
+    });
+}
+
+SEASTAR_TEST_CASE(test_expedited_flushes) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        const int tables = 10;
+        for (int t = 0; t < tables; ++t) {
+            e.execute_cql(format("CREATE TABLE ks.drain{} (pk int PRIMARY KEY, v int)", t)).get();
+            for (int pk = 0; pk < 10; ++pk) {
+                e.execute_cql(format("INSERT INTO ks.drain{} (pk, v) VALUES ({}, {})", t, pk, pk)).get();
+            }
+        }
+
+        e.db().invoke_on_all([] (database& db) {
+            db.expedite_flushes();
+            // Idempotent.
+            db.expedite_flushes();
+            return db.flush_all_memtables();
+        }).get();
+
+        for (int t = 0; t < tables; ++t) {
+            auto sstables = e.db().map_reduce0([t] (database& db) {
+                auto& cf = db.find_column_family("ks", format("drain{}", t));
+                BOOST_REQUIRE(cf.active_memtable().empty());
+                return cf.get_sstables()->size();
+            }, size_t(0), std::plus<size_t>()).get0();
+            BOOST_REQUIRE_GT(sstables, 0);
+        }
+        auto msg = e.execute_cql("SELECT v FROM ks.drain3 WHERE pk = 7").get0();
+        assert_that(msg).is_rows().with_rows({{int32_type->decompose(7)}});
+    });
+}
+
+SEASTAR_TEST_CASE(test_offload_cold_sstables) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE ks.tiered (pk int, ck int, v int, PRIMARY KEY (pk, ck))").get();
+        auto flush = [&] {
+            e.db().invoke_on_all([] (database& db) {
+                return db.find_column_family("ks", "tiered").flush();
+            }).get();
+        };
+        for (int pk = 0; pk < 10; ++pk) {
+            e.execute_cql(format("INSERT INTO ks.tiered (pk, ck, v) VALUES ({}, 0, {}) USING TIMESTAMP 1000", pk, pk)).get();
+        }
+        flush();
+        for (int pk = 0; pk < 10; ++pk) {
+            e.execute_cql(format("INSERT INTO ks.tiered (pk, ck, v) VALUES ({}, 1, {}) USING TIMESTAMP 3000", pk, pk)).get();
+        }
+        flush();
+
+        auto moved = e.db().map_reduce0([] (database& db) {
+            return db.find_column_family("ks", "tiered").offload_cold_sstables(2000);
+        }, size_t(0), std::plus<size_t>()).get0();
+        BOOST_REQUIRE_GT(moved, 0);
+
+        e.db().invoke_on_all([] (database& db) {
+            auto& cf = db.find_column_family("ks", "tiered");
+            for (auto&& sst : *cf.get_sstables()) {
+                auto is_cold = sst->get_stats_metadata().max_timestamp < 2000;
+                BOOST_REQUIRE_EQUAL(sst->get_dir() == cf.cold_dir(), is_cold);
+            }
+            // Already offloaded sstables aren't moved again.
+            return cf.offload_cold_sstables(2000).then([] (size_t moved) {
+                BOOST_REQUIRE_EQUAL(moved, 0);
+            });
+        }).get();
+
+        auto msg = e.execute_cql("SELECT count(*) FROM ks.tiered BYPASS CACHE").get0();
+        assert_that(msg).is_rows().with_rows({{long_type->decompose(int64_t(20))}});
+
+        // Snapshots link offloaded sstables on the cold storage.
+        e.db().invoke_on_all([] (database& db) {
+            return db.find_column_family("ks", "tiered").snapshot("offloaded");
+        }).get();
+        e.db().invoke_on_all([] (database& db) {
+            auto& cf = db.find_column_family("ks", "tiered");
+            for (auto&& sst : *cf.get_sstables()) {
+                auto link = fs::path(sst->get_dir().c_str()) / "snapshots" / "offloaded" / fs::path(sst->toc_filename().c_str()).filename();
+                BOOST_REQUIRE(file_exists(link.native()).get0());
+            }
+        }).get();
+        auto details = e.local_db().find_column_family("ks", "tiered").get_snapshot_details().get0();
+        BOOST_REQUIRE(details.count("offloaded"));
+        e.local_db().clear_snapshot("offloaded", {"ks"}, "tiered").get();
+        e.db().invoke_on_all([] (database& db) {
+            auto& cf = db.find_column_family("ks", "tiered");
+            return file_exists(cf.cold_dir() + "/snapshots/offloaded").then([] (bool exists) {
+                BOOST_REQUIRE(!exists);
+            });
+        }).get();
+
+        // Compacting only offloaded sstables keeps the output cold.
+        e.db().invoke_on_all([] (database& db) {
+            auto& cf = db.find_column_family("ks", "tiered");
+            return cf.offload_cold_sstables(api::max_timestamp).then([&cf] (size_t) {
+                return cf.compact_all_sstables();
+            }).then([&cf] {
+                for (auto&& sst : *cf.get_sstables()) {
+                    BOOST_REQUIRE_EQUAL(sst->get_dir(), cf.cold_dir());
+                }
+            });
+        }).get();
+        msg = e.execute_cql("SELECT count(*) FROM ks.tiered BYPASS CACHE").get0();
+        assert_that(msg).is_rows().with_rows({{long_type->decompose(int64_t(20))}});
+    });
+}
+
+SEASTAR_THREAD_TEST_CASE(test_per_partition_rate_limit) {
+    auto ext = std::make_shared<db::extensions>();
+    ext->add_schema_extension<db::per_partition_rate_limit_extension>(db::per_partition_rate_limit_extension::NAME);
+    auto cfg = ::make_shared<db::config>(std::move(ext));
+    do_with_cql_env_thread([] (cql_test_env& e) {
+        BOOST_REQUIRE_THROW(e.execute_cql("CREATE TABLE ks.bad (pk int PRIMARY KEY) WITH per_partition_rate_limit = {'max_writes_per_second': -1}").get(),
+                exceptions::configuration_exception);
+        e.execute_cql("CREATE TABLE ks.limited (pk int PRIMARY KEY, v int) "
+                "WITH per_partition_rate_limit = {'max_reads_per_second': 10, 'max_writes_per_second': 10}").get();
+        e.execute_cql("CREATE TABLE ks.unlimited (pk int PRIMARY KEY, v int)").get();
+        auto& opts = e.local_db().find_schema("ks", "limited")->per_partition_rate_limit_options();
+        BOOST_REQUIRE(opts.max_reads_per_second() == 10u);
+        BOOST_REQUIRE(opts.max_writes_per_second() == 10u);
+
+        // Even if a window starts in the middle, one of the windows sees at
+        // least half of the operations, way over the limit.
+        auto count_rejected = [&] (sstring query) {
+            unsigned rejected = 0;
+            for (int i = 0; i < 100; ++i) {
+                try {
+                    e.execute_cql(query).get();
+                } catch (exceptions::rate_limit_exception&) {
+                    ++rejected;
+                }
+            }
+            return rejected;
+        };
+        BOOST_REQUIRE_GT(count_rejected("INSERT INTO ks.limited (pk, v) VALUES (1, 1)"), 0);
+        BOOST_REQUIRE_GT(count_rejected("SELECT * FROM ks.limited WHERE pk = 1"), 0);
+        BOOST_REQUIRE_EQUAL(count_rejected("INSERT INTO ks.unlimited (pk, v) VALUES (1, 1)"), 0);
+        BOOST_REQUIRE_EQUAL(count_rejected("SELECT * FROM ks.unlimited WHERE pk = 1"), 0);
+
+        // Other partitions of the limited table are not affected.
+        e.execute_cql("INSERT INTO ks.limited (pk, v) VALUES (2, 2)").get();
+        e.execute_cql("SELECT * FROM ks.limited WHERE pk = 2").get();
+    }, cql_test_config(std::move(cfg))).get();
+}
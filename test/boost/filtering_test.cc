@@ -1176,3 +1176,39 @@ SEASTAR_TEST_CASE(test_filtering) {
 
     });
 }
+
+SEASTAR_TEST_CASE(test_filtering_compiled_predicates) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE t (p int, c text, s text, v int, PRIMARY KEY (p, c))").get();
+        e.require_table_exists("ks", "t").get();
+        e.execute_cql("INSERT INTO t (p, c, s, v) VALUES (1, 'a', 'abc', -5)").get();
+        e.execute_cql("INSERT INTO t (p, c, s, v) VALUES (1, 'b', 'abd', 0)").get();
+        e.execute_cql("INSERT INTO t (p, c, s, v) VALUES (2, 'a', 'b', 7)").get();
+        e.execute_cql("INSERT INTO t (p, c, v) VALUES (2, 'c', 300)").get();
+
+        // Byte-comparable slice, with both bounds.
+        auto msg = e.execute_cql("SELECT p, c FROM t WHERE s > 'abc' AND s <= 'b' ALLOW FILTERING").get0();
+        assert_that(msg).is_rows().with_rows_ignore_order({
+            { int32_type->decompose(1), utf8_type->decompose(sstring("b")) },
+            { int32_type->decompose(2), utf8_type->decompose(sstring("a")) },
+        });
+
+        // Slice of a type which isn't byte-comparable: the sign matters.
+        msg = e.execute_cql("SELECT p, c FROM t WHERE v < 1 ALLOW FILTERING").get0();
+        assert_that(msg).is_rows().with_rows_ignore_order({
+            { int32_type->decompose(1), utf8_type->decompose(sstring("a")) },
+            { int32_type->decompose(1), utf8_type->decompose(sstring("b")) },
+        });
+
+        msg = e.execute_cql("SELECT p, c FROM t WHERE s IN ('b', 'abd', 'zzz') ALLOW FILTERING").get0();
+        assert_that(msg).is_rows().with_rows_ignore_order({
+            { int32_type->decompose(1), utf8_type->decompose(sstring("b")) },
+            { int32_type->decompose(2), utf8_type->decompose(sstring("a")) },
+        });
+
+        msg = e.execute_cql("SELECT p, c FROM t WHERE c = 'a' AND v = 7 ALLOW FILTERING").get0();
+        assert_that(msg).is_rows().with_rows({
+            { int32_type->decompose(2), utf8_type->decompose(sstring("a")) },
+        });
+    });
+}
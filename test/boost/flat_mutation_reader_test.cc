@@ -23,6 +23,7 @@
 #include <seastar/core/thread.hh>
 #include <seastar/testing/test_case.hh>
 #include <seastar/testing/thread_test_case.hh>
+#include <seastar/util/defer.hh>
 
 #include "mutation.hh"
 #include "mutation_fragment.hh"
@@ -394,6 +395,59 @@ SEASTAR_THREAD_TEST_CASE(test_flat_mutation_reader_move_buffer_content_to) {
         .is_equal_to(mut_orig);
 }
 
+SEASTAR_THREAD_TEST_CASE(test_consume_batches_pausable) {
+    simple_schema s;
+    std::vector<mutation> muts;
+    for (int i = 0; i < 4; ++i) {
+        auto m = mutation(s.schema(), s.make_pkey(i));
+        for (int j = 0; j < 20; ++j) {
+            m.apply(s.make_row(s.make_ckey(j), "a_16_byte_value_"));
+        }
+        muts.push_back(std::move(m));
+    }
+    std::sort(muts.begin(), muts.end(), mutation_decorated_key_less_comparator());
+
+    // The consumer gets whole buffers, and the fragments it leaves in the
+    // batch are the next ones read from the stream.
+    auto reader = flat_mutation_reader_from_mutations(muts, dht::partition_range::make_open_ended_both_sides());
+    reader.set_max_buffer_size(100);
+    std::vector<mutation_fragment> fragments;
+    size_t batches = 0;
+    reader.consume_batches_pausable([&] (circular_buffer<mutation_fragment>& batch) {
+        BOOST_REQUIRE(!batch.empty());
+        ++batches;
+        fragments.push_back(std::move(batch.front()));
+        batch.pop_front();
+        return stop_iteration(fragments.size() == 10);
+    }, db::no_timeout).get();
+    BOOST_REQUIRE_EQUAL(fragments.size(), 10);
+    BOOST_REQUIRE_GT(batches, 0);
+    while (auto mf = reader(db::no_timeout).get0()) {
+        fragments.push_back(std::move(*mf));
+    }
+    auto rebuilt = make_flat_mutation_reader_from_fragments(s.schema(), std::deque<mutation_fragment>(
+            std::make_move_iterator(fragments.begin()), std::make_move_iterator(fragments.end())));
+    for (auto& m : muts) {
+        assert_that(read_mutation_from_flat_mutation_reader(rebuilt, db::no_timeout).get0()).has_mutation().is_equal_to(m);
+    }
+
+    // Readers built on batches, like the transforming and the filtering
+    // readers, preserve the stream.
+    struct identity {
+        mutation_fragment operator()(mutation_fragment&& mf) { return std::move(mf); }
+        schema_ptr operator()(schema_ptr s) { return s; }
+    };
+    auto filtered = make_filtering_reader(transform(flat_mutation_reader_from_mutations(muts, dht::partition_range::make_open_ended_both_sides()),
+            identity{}), [&] (const dht::decorated_key& dk) {
+        return !dk.equal(*s.schema(), muts[1].decorated_key());
+    });
+    filtered.set_max_buffer_size(100);
+    for (auto i : {0, 2, 3}) {
+        assert_that(read_mutation_from_flat_mutation_reader(filtered, db::no_timeout).get0()).has_mutation().is_equal_to(muts[i]);
+    }
+    BOOST_REQUIRE(!read_mutation_from_flat_mutation_reader(filtered, db::no_timeout).get0());
+}
+
 SEASTAR_TEST_CASE(test_multi_range_reader) {
     return seastar::async([] {
         simple_schema s;
@@ -834,3 +888,143 @@ SEASTAR_THREAD_TEST_CASE(test_reverse_reader_memory_limit) {
     test_with_partition(true);
     test_with_partition(false);
 }
+
+SEASTAR_THREAD_TEST_CASE(test_reverse_reader_keeps_only_last_live_rows) {
+    simple_schema schema;
+
+    auto mut = schema.new_mutation("pk1");
+    const int rows = 1000;
+    for (int i = 0; i < rows; ++i) {
+        schema.add_row(mut, schema.make_ckey(i), sstring(10 * 1024, '0'));
+    }
+    // The last rows are deleted, so more rows are needed to find live ones.
+    schema.delete_range(mut, query::clustering_range::make(
+            {schema.make_ckey(rows - 5), true}, {schema.make_ckey(rows - 1), true}));
+
+    struct collecting_consumer {
+        std::vector<clustering_key> keys;
+        void consume_new_partition(const dht::decorated_key&) { }
+        void consume(tombstone) { }
+        stop_iteration consume(static_row&&) { return stop_iteration::no; }
+        stop_iteration consume(clustering_row&& cr) {
+            keys.push_back(cr.key());
+            return stop_iteration::no;
+        }
+        stop_iteration consume(range_tombstone&&) { return stop_iteration::no; }
+        stop_iteration consume_end_of_partition() { return stop_iteration::no; }
+        std::vector<clustering_key> consume_end_of_stream() { return std::move(keys); }
+    };
+
+    // The whole partition doesn't fit in the memory limit, the rows from
+    // the 10th live row from the end do: 10 live rows and 5 deleted ones.
+    auto reader = flat_mutation_reader_from_mutations({mut});
+    auto reverse_reader = make_reversing_reader(reader, size_t(1) << 20, 10);
+    auto keys = reverse_reader.consume(collecting_consumer{}, db::no_timeout).get0();
+
+    BOOST_REQUIRE_EQUAL(keys.size(), 15);
+    clustering_key::equality eq(*schema.schema());
+    for (int i = 0; i < 15; ++i) {
+        BOOST_REQUIRE(eq(keys[i], schema.make_ckey(rows - 1 - i)));
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_activity_tagging) {
+    utils::enable_stall_attribution(std::chrono::milliseconds(std::numeric_limits<int>::max()));
+    auto disable = defer([] { utils::enable_stall_attribution(std::chrono::milliseconds(0)); });
+    simple_schema schema;
+    utils::stall_stats stats;
+    const auto activity = utils::activity{utils::activity_type::compaction, &stats};
+
+    auto mut = schema.new_mutation("pk1");
+    schema.add_row(mut, schema.make_ckey(0), "v");
+
+    // Records the activity its fill_buffer() runs under.
+    class recording_reader : public flat_mutation_reader::impl {
+        flat_mutation_reader _underlying;
+        std::vector<utils::activity_type>& _seen;
+    public:
+        recording_reader(flat_mutation_reader r, std::vector<utils::activity_type>& seen)
+            : impl(r.schema()), _underlying(std::move(r)), _seen(seen) { }
+        virtual future<> fill_buffer(db::timeout_clock::time_point timeout) override {
+            _seen.push_back(utils::current_activity.type);
+            return _underlying.fill_buffer(timeout).then([this] {
+                _end_of_stream = _underlying.is_end_of_stream();
+                _underlying.move_buffer_content_to(*this);
+            });
+        }
+        virtual void next_partition() override { throw std::bad_function_call(); }
+        virtual future<> fast_forward_to(const dht::partition_range&, db::timeout_clock::time_point) override { throw std::bad_function_call(); }
+        virtual future<> fast_forward_to(position_range, db::timeout_clock::time_point) override { throw std::bad_function_call(); }
+    };
+
+    struct recording_consumer {
+        std::vector<utils::activity_type> seen;
+        void consume_new_partition(const dht::decorated_key&) { seen.push_back(utils::current_activity.type); }
+        void consume(tombstone) { }
+        stop_iteration consume(static_row&&) { return stop_iteration::no; }
+        stop_iteration consume(clustering_row&&) {
+            seen.push_back(utils::current_activity.type);
+            return stop_iteration::no;
+        }
+        stop_iteration consume(range_tombstone&&) { return stop_iteration::no; }
+        stop_iteration consume_end_of_partition() { return stop_iteration::no; }
+        std::vector<utils::activity_type> consume_end_of_stream() { return std::move(seen); }
+    };
+
+    std::vector<utils::activity_type> seen_by_reader;
+    {
+        utils::activity_scope outer(utils::activity_type::read, stats);
+        auto reader = make_activity_tagging_reader(
+                make_flat_mutation_reader<recording_reader>(flat_mutation_reader_from_mutations({mut}), seen_by_reader), activity);
+        auto seen_by_consumer = reader.consume_in_thread(activity_tagging_consumer(recording_consumer{}, activity), db::no_timeout);
+        BOOST_REQUIRE(!seen_by_consumer.empty());
+        for (auto type : seen_by_consumer) {
+            BOOST_REQUIRE(type == utils::activity_type::compaction);
+        }
+        BOOST_REQUIRE(utils::current_activity.type == utils::activity_type::read);
+    }
+    BOOST_REQUIRE(!seen_by_reader.empty());
+    for (auto type : seen_by_reader) {
+        BOOST_REQUIRE(type == utils::activity_type::compaction);
+    }
+    BOOST_REQUIRE(utils::current_activity.type == utils::activity_type::none);
+    BOOST_REQUIRE(!utils::current_activity.stats);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_stall_attribution_measures_scopes) {
+    using namespace std::chrono_literals;
+    utils::stall_stats stats;
+    auto spin = [] (std::chrono::steady_clock::duration d) {
+        auto end = std::chrono::steady_clock::now() + d;
+        while (std::chrono::steady_clock::now() < end) { }
+    };
+
+    // Nothing is measured while disabled.
+    {
+        utils::activity_scope scope(utils::activity_type::read, stats);
+        spin(2ms);
+    }
+    BOOST_REQUIRE_EQUAL(stats.reports[size_t(utils::activity_type::read)], 0);
+
+    utils::enable_stall_attribution(50ms);
+    auto disable = defer([] { utils::enable_stall_attribution(std::chrono::milliseconds(0)); });
+
+    // The time of a nested scope is counted only for its own activity.
+    {
+        utils::activity_scope outer(utils::activity_type::compaction, stats);
+        {
+            utils::activity_scope inner(utils::activity_type::read, stats);
+            spin(60ms);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(stats.reports[size_t(utils::activity_type::read)], 1);
+    BOOST_REQUIRE_GE(stats.stall_time_ms[size_t(utils::activity_type::read)], 60);
+    BOOST_REQUIRE_EQUAL(stats.reports[size_t(utils::activity_type::compaction)], 0);
+
+    // Scopes shorter than the threshold aren't counted.
+    {
+        utils::activity_scope scope(utils::activity_type::flush, stats);
+        spin(1ms);
+    }
+    BOOST_REQUIRE_EQUAL(stats.reports[size_t(utils::activity_type::flush)], 0);
+}
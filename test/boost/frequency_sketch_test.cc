@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE core
+
+#include <boost/test/unit_test.hpp>
+#include <random>
+
+#include "utils/frequency_sketch.hh"
+
+BOOST_AUTO_TEST_CASE(test_width_is_rounded_up) {
+    BOOST_REQUIRE_EQUAL(utils::frequency_sketch(0).width(), 16);
+    BOOST_REQUIRE_EQUAL(utils::frequency_sketch(100).width(), 128);
+    BOOST_REQUIRE_EQUAL(utils::frequency_sketch(1024).width(), 1024);
+}
+
+BOOST_AUTO_TEST_CASE(test_estimates_do_not_undercount) {
+    utils::frequency_sketch sketch(1024);
+    std::mt19937_64 rnd(7);
+    std::vector<uint64_t> keys;
+    for (int i = 0; i < 300; ++i) {
+        keys.push_back(rnd());
+    }
+    for (unsigned i = 0; i < keys.size(); ++i) {
+        for (unsigned j = 0; j < i % 8; ++j) {
+            BOOST_REQUIRE(!sketch.increment(keys[i]));
+        }
+    }
+    for (unsigned i = 0; i < keys.size(); ++i) {
+        BOOST_REQUIRE_GE(sketch.estimate(keys[i]), i % 8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_counters_saturate) {
+    utils::frequency_sketch sketch(1024);
+    for (int i = 0; i < 100; ++i) {
+        sketch.increment(42);
+    }
+    BOOST_REQUIRE_EQUAL(sketch.estimate(42), utils::frequency_sketch::max_frequency);
+    sketch.clear();
+    BOOST_REQUIRE_EQUAL(sketch.estimate(42), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_aging) {
+    utils::frequency_sketch sketch(64);
+    for (int i = 0; i < 8; ++i) {
+        sketch.increment(42);
+    }
+    BOOST_REQUIRE_EQUAL(sketch.estimate(42), 8);
+
+    // Fill the sample with distinct keys until the counters are halved.
+    uint64_t key = 1000;
+    uint64_t additions = 8;
+    while (!sketch.increment(key++)) {
+        ++additions;
+        BOOST_REQUIRE_LE(additions, sketch.sample_size());
+    }
+    BOOST_REQUIRE_LE(sketch.estimate(42), 4 + utils::frequency_sketch::max_frequency / 2);
+    BOOST_REQUIRE_GE(sketch.estimate(42), 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_hot_keys_stand_out) {
+    utils::frequency_sketch sketch(65536);
+    std::mt19937_64 rnd(13);
+    std::vector<uint64_t> hot;
+    for (int i = 0; i < 100; ++i) {
+        hot.push_back(rnd());
+    }
+    // A scan over many keys interleaved with repeated accesses to a few.
+    for (int i = 0; i < 20000; ++i) {
+        sketch.increment(rnd());
+        if (i % 20 == 0) {
+            sketch.increment(hot[(i / 20) % hot.size()]);
+        }
+    }
+    unsigned cold_above_one = 0;
+    for (int i = 0; i < 1000; ++i) {
+        cold_above_one += sketch.estimate(rnd()) > 1;
+    }
+    for (auto h : hot) {
+        BOOST_REQUIRE_GE(sketch.estimate(h), 10);
+    }
+    BOOST_REQUIRE_LE(cold_above_one, 10);
+}
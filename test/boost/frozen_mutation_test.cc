@@ -122,6 +122,34 @@ SEASTAR_THREAD_TEST_CASE(test_frozen_mutation_fragment) {
     });
 }
 
+SEASTAR_THREAD_TEST_CASE(test_unfreezing_many_mutation_fragments) {
+    storage_service_for_tests ssft;
+    for_each_mutation_pair([] (const mutation& m1, const mutation& m2, are_equal) {
+        if (m1.schema()->version() != m2.schema()->version()) {
+            return;
+        }
+        auto& s = *m1.schema();
+        std::vector<mutation_fragment> mfs;
+        auto rd = flat_mutation_reader_from_mutations({ m1, m2 });
+        rd.consume_pausable([&] (mutation_fragment mf) {
+            mfs.emplace_back(std::move(mf));
+            return stop_iteration::no;
+        }, db::no_timeout).get();
+
+        std::vector<frozen_mutation_fragment> fmfs;
+        for (auto&& mf : mfs) {
+            fmfs.push_back(freeze(s, mf));
+        }
+        auto refrozen_mfs = unfreeze(s, fmfs);
+        BOOST_REQUIRE_EQUAL(refrozen_mfs.size(), mfs.size());
+        for (size_t i = 0; i < mfs.size(); ++i) {
+            if (!mfs[i].equal(s, refrozen_mfs[i])) {
+                BOOST_FAIL("Expected " << mutation_fragment::printer(s, mfs[i]) << " got " << mutation_fragment::printer(s, refrozen_mfs[i]));
+            }
+        }
+    });
+}
+
 SEASTAR_TEST_CASE(test_deserialization_using_wrong_schema_throws) {
     return seastar::async([] {
         storage_service_for_tests ssft;
@@ -26,6 +26,8 @@
 #include "seastarx.hh"
 #include <seastar/testing/test_case.hh>
 #include "utils/hash.hh"
+#include "xx_hasher.hh"
+#include "test/lib/make_random_string.hh"
 
 SEASTAR_TEST_CASE(test_pair_hash){
     auto hash_compare = [](auto p) {
@@ -72,3 +74,21 @@ SEASTAR_TEST_CASE(test_tuple_hash){
 
     return make_ready_future<>();
 }
+
+SEASTAR_TEST_CASE(test_buffered_xx_hasher) {
+    auto data = make_random_string(64 * 1024);
+    for (size_t max_update : {1, 8, 100, 256, 300, 5000}) {
+        xx_hasher h1(17);
+        buffered_xx_hasher h2(17);
+        size_t pos = 0;
+        for (size_t i = 0; pos < data.size(); ++i) {
+            auto len = std::min((i * 7919) % (max_update + 1), data.size() - pos);
+            h1.update(data.data() + pos, len);
+            h2.update(data.data() + pos, len);
+            pos += len;
+        }
+        BOOST_CHECK_EQUAL(h1.finalize_uint64(), h2.finalize_uint64());
+    }
+    BOOST_CHECK_EQUAL(xx_hasher(3).finalize_uint64(), buffered_xx_hasher(3).finalize_uint64());
+    return make_ready_future<>();
+}
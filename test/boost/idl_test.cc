@@ -233,6 +233,60 @@ BOOST_AUTO_TEST_CASE(test_vector)
     for (size_t i = 0; i < second_view.size(); i++) {
         BOOST_REQUIRE_EQUAL(vec2[i], second_view[i]);
     }
+
+    // Vector members of views are deserialized lazily.
+    BOOST_REQUIRE_EQUAL(vec1.front().foo, first_view.front().foo());
+    BOOST_REQUIRE_EQUAL(vec1.back().bar, first_view.back().bar());
+    size_t idx = 0;
+    for (auto&& fv : first_view) {
+        BOOST_REQUIRE_EQUAL(vec1[idx++].foo, fv.foo());
+    }
+    BOOST_REQUIRE_EQUAL(idx, vec1.size());
+    BOOST_REQUIRE_EQUAL(vec2, std::vector<simple_compound>(second_view));
+}
+
+BOOST_AUTO_TEST_CASE(test_frozen_view)
+{
+    std::vector<simple_compound> vec1 = {
+        { 1, 2 },
+        { 3, 4 },
+    };
+    std::vector<simple_compound> vec2 = {
+        { 5, 6 },
+    };
+    vectors_of_compounds voc = { vec1, wrapped_vector { vec2 } };
+
+    bytes_ostream buf;
+    ser::serialize(buf, voc);
+    ser::serialize(buf, uint32_t(42));
+
+    // An owning type can be received in its serialized form and read
+    // through its view; the rest of the stream is left alone.
+    auto in = ser::as_input_stream(buf);
+    using frozen_voc = ser::frozen_view<ser::writable_vectors_of_compounds_view>;
+    auto frozen = ser::deserialize(in, boost::type<frozen_voc>());
+    BOOST_REQUIRE_EQUAL(ser::deserialize(in, boost::type<uint32_t>()), 42);
+    BOOST_REQUIRE_EQUAL(frozen.representation().size(), ser::get_sizeof(voc));
+
+    auto view = frozen.view();
+    BOOST_REQUIRE_EQUAL(view.first().size(), vec1.size());
+    size_t idx = 0;
+    for (auto&& fv : view.first()) {
+        BOOST_REQUIRE_EQUAL(vec1[idx].foo, fv.foo());
+        BOOST_REQUIRE_EQUAL(vec1[idx++].bar, fv.bar());
+    }
+    BOOST_REQUIRE_EQUAL(vec2, std::vector<simple_compound>(view.second().vector()));
+
+    // It serializes back to the object it was read from.
+    bytes_ostream expected;
+    ser::serialize(expected, voc);
+    bytes_ostream reserialized;
+    ser::serialize(reserialized, frozen);
+    BOOST_REQUIRE_EQUAL(reserialized.linearize(), expected.linearize());
+    auto in2 = ser::as_input_stream(reserialized);
+    auto deser_voc = ser::deserialize(in2, boost::type<vectors_of_compounds>());
+    BOOST_REQUIRE_EQUAL(voc.first, deser_voc.first);
+    BOOST_REQUIRE_EQUAL(voc.second, deser_voc.second);
 }
 
 BOOST_AUTO_TEST_CASE(test_variant)
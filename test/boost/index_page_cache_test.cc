@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/core/align.hh>
+
+#include "sstables/index_page_cache.hh"
+#include "test/lib/tmpdir.hh"
+
+using namespace sstables;
+
+static constexpr size_t page_size = index_page_cache::page_size;
+// Three full pages and a partial one.
+static constexpr size_t file_size = 3 * page_size + 100;
+
+static uint8_t byte_at(uint64_t pos) {
+    return uint8_t(pos * 7 + pos / page_size);
+}
+
+static file write_file(const sstring& path) {
+    auto f = open_file_dma(path, open_flags::create | open_flags::rw | open_flags::truncate).get0();
+    auto size = align_up(file_size, page_size);
+    auto buf = temporary_buffer<uint8_t>::aligned(f.memory_dma_alignment(), size);
+    for (uint64_t i = 0; i < size; ++i) {
+        buf.get_write()[i] = byte_at(i);
+    }
+    f.dma_write(0, buf.get(), size).get();
+    f.truncate(file_size).get();
+    f.flush().get();
+    return f;
+}
+
+static void check_read(file& f, uint64_t pos, size_t len) {
+    auto buf = f.dma_read_bulk<uint8_t>(pos, len).get0();
+    auto expected = std::min<uint64_t>(len, pos < file_size ? file_size - pos : 0);
+    BOOST_REQUIRE_EQUAL(buf.size(), expected);
+    for (uint64_t i = 0; i < buf.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(buf[i], byte_at(pos + i));
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_index_page_cache_hits) {
+    tmpdir tmp;
+    auto raw = write_file((tmp.path() / "Index.db").string());
+    index_page_cache cache;
+    auto id = cache.new_file_id();
+    auto f = make_cached_index_file(raw, cache, id, file_size);
+    auto& stats = index_page_cache::shard_stats();
+
+    auto hits = stats.page_hits;
+    auto misses = stats.page_misses;
+    check_read(f, 10, 2 * page_size);
+    BOOST_REQUIRE_EQUAL(stats.page_hits, hits);
+    BOOST_REQUIRE_GT(stats.page_misses, misses);
+
+    // Pages 0-2 are now cached.
+    hits = stats.page_hits;
+    check_read(f, 100, page_size);
+    check_read(f, 2 * page_size + 5, 10);
+    BOOST_REQUIRE_EQUAL(stats.page_hits, hits + 3);
+
+    // The partial last page is cached too, and reads past the end are trimmed.
+    check_read(f, 3 * page_size + 50, page_size);
+    hits = stats.page_hits;
+    check_read(f, 3 * page_size, page_size);
+    check_read(f, file_size, 10);
+    BOOST_REQUIRE_EQUAL(stats.page_hits, hits + 1);
+
+    cache.invalidate(id);
+    BOOST_REQUIRE_EQUAL(cache.region().occupancy().used_space(), 0);
+    hits = stats.page_hits;
+    check_read(f, 0, page_size);
+    BOOST_REQUIRE_EQUAL(stats.page_hits, hits);
+    raw.close().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_index_page_cache_eviction) {
+    tmpdir tmp;
+    auto raw = write_file((tmp.path() / "Index.db").string());
+    index_page_cache cache;
+    auto f = make_cached_index_file(raw, cache, cache.new_file_id(), file_size);
+    auto& stats = index_page_cache::shard_stats();
+
+    check_read(f, 0, file_size);
+    BOOST_REQUIRE_GE(stats.bytes, file_size);
+
+    auto evictions = stats.page_evictions;
+    logalloc::shard_tracker().reclaim(std::numeric_limits<size_t>::max() / 2);
+    BOOST_REQUIRE_GT(stats.page_evictions, evictions);
+
+    // Evicted pages are read from disk again.
+    check_read(f, 0, file_size);
+    check_read(f, page_size - 1, 2);
+    raw.close().get();
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+#include <set>
+#include <vector>
+
+#include "utils/intrusive_btree.hh"
+#include "utils/logalloc.hh"
+#include "test/lib/random_utils.hh"
+
+struct test_element {
+    int value;
+    intrusive_b::member_hook hook;
+
+    explicit test_element(int v) : value(v) { }
+    test_element(test_element&& o) noexcept : value(o.value), hook(std::move(o.hook)) { }
+
+    struct less {
+        bool operator()(const test_element& a, const test_element& b) const { return a.value < b.value; }
+        bool operator()(const test_element& a, int b) const { return a.value < b; }
+        bool operator()(int a, const test_element& b) const { return a < b.value; }
+    };
+};
+
+using test_tree = intrusive_b::tree<test_element, &test_element::hook>;
+
+struct keyed_test_element {
+    int value;
+    intrusive_b::keyed_member_hook hook;
+
+    explicit keyed_test_element(int v) : value(v) { }
+    keyed_test_element(keyed_test_element&& o) noexcept : value(o.value), hook(std::move(o.hook)) { }
+
+    struct less {
+        bool operator()(const keyed_test_element& a, const keyed_test_element& b) const { return a.value < b.value; }
+        bool operator()(const keyed_test_element& a, int b) const { return a.value < b; }
+        bool operator()(int a, const keyed_test_element& b) const { return a < b.value; }
+    };
+
+    // Coarse, so that lookups often have to compare the elements.
+    struct key_of {
+        int64_t operator()(const keyed_test_element& e) const { return e.value >> 2; }
+        int64_t operator()(int v) const { return v >> 2; }
+    };
+};
+
+using keyed_test_tree = intrusive_b::keyed_tree<keyed_test_element, &keyed_test_element::hook, keyed_test_element::key_of>;
+
+template <typename Tree>
+static void verify(const Tree& t, const std::set<int>& expected) {
+    BOOST_REQUIRE_EQUAL(t.empty(), expected.empty());
+    BOOST_REQUIRE_EQUAL(t.calculate_size(), expected.size());
+    auto it = t.begin();
+    for (auto v : expected) {
+        BOOST_REQUIRE(it != t.end());
+        BOOST_REQUIRE_EQUAL(it->value, v);
+        ++it;
+    }
+    BOOST_REQUIRE(it == t.end());
+    auto rit = t.rbegin();
+    for (auto i = expected.rbegin(); i != expected.rend(); ++i) {
+        BOOST_REQUIRE(rit != t.rend());
+        BOOST_REQUIRE_EQUAL(rit->value, *i);
+        ++rit;
+    }
+    BOOST_REQUIRE(rit == t.rend());
+}
+
+template <typename Tree>
+static void verify_lookups(const Tree& t, const std::set<int>& expected, int max_value) {
+    using less = typename Tree::value_type::less;
+    for (int i = 0; i < 100; ++i) {
+        auto v = tests::random::get_int(-1, max_value + 1);
+        auto lb = t.lower_bound(v, less());
+        auto expected_lb = expected.lower_bound(v);
+        BOOST_REQUIRE_EQUAL(lb == t.end(), expected_lb == expected.end());
+        if (lb != t.end()) {
+            BOOST_REQUIRE_EQUAL(lb->value, *expected_lb);
+        }
+        auto ub = t.upper_bound(v, less());
+        auto expected_ub = expected.upper_bound(v);
+        BOOST_REQUIRE_EQUAL(ub == t.end(), expected_ub == expected.end());
+        if (ub != t.end()) {
+            BOOST_REQUIRE_EQUAL(ub->value, *expected_ub);
+        }
+        auto f = t.find(v, less());
+        BOOST_REQUIRE_EQUAL(f != t.end(), expected.count(v) == 1);
+    }
+}
+
+template <typename Tree>
+static void test_random_operations_on() {
+    using element = typename Tree::value_type;
+    using less = typename element::less;
+    logalloc::region reg;
+    with_allocator(reg.allocator(), [&] {
+        auto del = current_deleter<element>();
+        for (auto max_value : {50, 5000}) {
+            Tree t;
+            std::set<int> expected;
+            for (int op = 0; op < 20000; ++op) {
+                auto v = tests::random::get_int(0, max_value);
+                auto kind = tests::random::get_int(0, 9);
+                if (kind < 5) {
+                    auto e = current_allocator().construct<element>(v);
+                    auto hint = t.lower_bound(v + tests::random::get_int(-1, 1), less());
+                    auto res = t.insert_check(hint, *e, less());
+                    BOOST_REQUIRE_EQUAL(res.second, expected.count(v) == 0);
+                    BOOST_REQUIRE_EQUAL(res.first->value, v);
+                    if (!res.second) {
+                        del(e);
+                    }
+                    expected.insert(v);
+                } else if (kind < 9) {
+                    auto it = t.find(v, less());
+                    if (it != t.end()) {
+                        auto next = t.erase_and_dispose(it, del);
+                        auto expected_next = expected.upper_bound(v);
+                        BOOST_REQUIRE_EQUAL(next == t.end(), expected_next == expected.end());
+                        if (next != t.end()) {
+                            BOOST_REQUIRE_EQUAL(next->value, *expected_next);
+                        }
+                    }
+                    expected.erase(v);
+                } else {
+                    // Destroying a linked element removes it from the tree.
+                    auto it = t.find(v, less());
+                    if (it != t.end()) {
+                        del(&*it);
+                    }
+                    expected.erase(v);
+                }
+                if (op % 1000 == 0) {
+                    verify(t, expected);
+                    verify_lookups(t, expected, max_value);
+                    reg.full_compaction();
+                    verify(t, expected);
+                    verify_lookups(t, expected, max_value);
+                }
+            }
+
+            Tree moved(std::move(t));
+            BOOST_REQUIRE(t.empty());
+            reg.full_compaction();
+            verify(moved, expected);
+            moved.clear_and_dispose(del);
+        }
+    });
+}
+
+SEASTAR_THREAD_TEST_CASE(test_random_operations) {
+    test_random_operations_on<test_tree>();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_random_operations_with_inline_keys) {
+    test_random_operations_on<keyed_test_tree>();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_iterators_are_stable) {
+    auto del = current_deleter<test_element>();
+    test_tree t;
+    std::vector<test_tree::iterator> its;
+    for (int i = 0; i < 3000; i += 2) {
+        its.push_back(t.insert_before(t.end(), *current_allocator().construct<test_element>(i)));
+    }
+    for (int i = 1; i < 3000; i += 4) {
+        t.insert(t.end(), *current_allocator().construct<test_element>(i), test_element::less());
+    }
+    for (int i = 5; i < 3000; i += 8) {
+        t.erase_and_dispose(t.find(i, test_element::less()), del);
+    }
+    std::set<int> expected;
+    for (auto& e : t) {
+        expected.insert(e.value);
+    }
+    for (auto it : its) {
+        auto next = std::next(it);
+        auto expected_next = expected.upper_bound(it->value);
+        BOOST_REQUIRE_EQUAL(next == t.end(), expected_next == expected.end());
+        if (next != t.end()) {
+            BOOST_REQUIRE_EQUAL(next->value, *expected_next);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(std::prev(t.end())->value, *expected.rbegin());
+    t.clear_and_dispose(del);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_appending_keeps_nodes_dense) {
+    auto del = current_deleter<test_element>();
+    std::vector<int> values;
+    for (int i = 0; i < 3000; ++i) {
+        values.push_back(i);
+    }
+    test_tree appended;
+    for (auto v : values) {
+        appended.insert_before(appended.end(), *current_allocator().construct<test_element>(v));
+    }
+    std::shuffle(values.begin(), values.end(), tests::random::gen());
+    test_tree shuffled;
+    for (auto v : values) {
+        shuffled.insert(shuffled.end(), *current_allocator().construct<test_element>(v), test_element::less());
+    }
+    BOOST_REQUIRE_LT(appended.external_memory_usage(), shuffled.external_memory_usage());
+    appended.clear_and_dispose(del);
+    shuffled.clear_and_dispose(del);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_clone) {
+    auto del = current_deleter<test_element>();
+    test_tree t;
+    std::set<int> expected;
+    for (int i = 0; i < 1000; ++i) {
+        auto v = tests::random::get_int(0, 10000);
+        auto e = current_allocator().construct<test_element>(v);
+        if (!t.insert_check(t.end(), *e, test_element::less()).second) {
+            del(e);
+        }
+        expected.insert(v);
+    }
+
+    test_tree copy;
+    copy.clone_from(t, [] (const test_element& e) { return current_allocator().construct<test_element>(e.value); }, del);
+    verify(copy, expected);
+    BOOST_REQUIRE_EQUAL(copy.external_memory_usage(), t.external_memory_usage());
+
+    size_t cloned = 0;
+    test_tree failed;
+    BOOST_REQUIRE_THROW(failed.clone_from(t, [&] (const test_element& e) {
+        if (++cloned == expected.size() / 2) {
+            throw std::bad_alloc();
+        }
+        return current_allocator().construct<test_element>(e.value);
+    }, del), std::bad_alloc);
+    BOOST_REQUIRE(failed.empty());
+
+    copy.clear_and_dispose(del);
+    t.clear_and_dispose(del);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_moving_between_trees) {
+    auto del = current_deleter<test_element>();
+    test_tree src;
+    for (int i = 0; i < 100; ++i) {
+        src.insert_before(src.end(), *current_allocator().construct<test_element>(i));
+    }
+    test_tree dst;
+    auto it = src.begin();
+    while (it != src.end()) {
+        auto& e = *it++;
+        dst.insert_before(dst.end(), e);
+    }
+    BOOST_REQUIRE(src.empty());
+    BOOST_REQUIRE_EQUAL(dst.calculate_size(), 100);
+
+    test_tree single;
+    auto& e = *dst.begin();
+    single.insert_before(single.end(), e);
+    BOOST_REQUIRE(test_tree::is_only_member(e));
+    BOOST_REQUIRE_EQUAL(&test_tree::container_of_only_member(e), &single);
+    BOOST_REQUIRE(!test_tree::is_only_member(*dst.begin()));
+
+    single.clear_and_dispose(del);
+    dst.clear_and_dispose(del);
+}
@@ -653,3 +653,22 @@ SEASTAR_TEST_CASE(test_unpack_decimal){
         assert_that(msg).is_rows().with_rows({{int32_type->decompose(1), lt_val}});
     });
 }
+
+SEASTAR_TEST_CASE(test_select_json_escaping) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE t (id int PRIMARY KEY, \"Text\" text, m map<uuid, frozen<list<text>>>)").get();
+        e.execute_cql("INSERT INTO t (id, \"Text\", m) VALUES (1, 'a\"b\\c\ntab\t\x01', "
+                "{ 7a5b6c8d-1e2f-4a3b-9c4d-5e6f7a8b9c0d : ['x', 'y\"'] })").get();
+
+        auto msg = e.execute_cql("SELECT JSON * FROM t WHERE id = 1").get0();
+        assert_that(msg).is_rows().with_rows({
+            {
+                utf8_type->decompose(
+                    "{\"id\": 1, "
+                    "\"\\\"Text\\\"\": \"a\\\"b\\\\c\\ntab\\t\\u0001\", "
+                    "\"m\": {\"7a5b6c8d-1e2f-4a3b-9c4d-5e6f7a8b9c0d\": [\"x\", \"y\\\"\"]}}"
+                )
+            }
+        });
+    });
+}
@@ -27,6 +27,8 @@
 #include "schema.hh"
 #include "schema_builder.hh"
 #include "types.hh"
+#include "clustering_position_encoder.hh"
+#include "utils/UUID_gen.hh"
 
 #include "idl/keys.dist.hh"
 #include "serializer_impl.hh"
@@ -189,3 +191,60 @@ BOOST_AUTO_TEST_CASE(test_from_nodetool_style_string) {
     auto key4 = partition_key::from_nodetool_style_string(s2, "value1:value2");
     BOOST_REQUIRE(key3.equal(*s1, key4));
 }
+
+BOOST_AUTO_TEST_CASE(test_clustering_position_encoding_order) {
+    auto s = schema_builder("ks", "cf")
+        .with_column("pk", bytes_type, column_kind::partition_key)
+        .with_column("c1", int32_type, column_kind::clustering_key)
+        .with_column("c2", reversed_type_impl::get_instance(utf8_type), column_kind::clustering_key)
+        .with_column("c3", timeuuid_type, column_kind::clustering_key)
+        .with_column("v", bytes_type)
+        .build();
+    auto encoder = s->clustering_position_encoder();
+    BOOST_REQUIRE(encoder);
+
+    std::vector<bytes> c1s = {bytes(), int32_type->decompose(int32_t(-5)), int32_type->decompose(int32_t(0)), int32_type->decompose(int32_t(3))};
+    std::vector<bytes> c2s = {bytes(), utf8_type->decompose(sstring("a")), utf8_type->decompose(sstring("a\0b", 3)), utf8_type->decompose(sstring("ab"))};
+    std::vector<bytes> c3s = {timeuuid_type->decompose(utils::UUID_gen::get_time_UUID()), timeuuid_type->decompose(utils::UUID_gen::min_time_UUID(1)),
+            timeuuid_type->decompose(utils::UUID_gen::max_time_UUID(1))};
+
+    std::vector<clustering_key_prefix> keys;
+    keys.push_back(clustering_key_prefix::make_empty());
+    for (auto&& c1 : c1s) {
+        keys.push_back(clustering_key_prefix::from_exploded(*s, {c1}));
+        for (auto&& c2 : c2s) {
+            keys.push_back(clustering_key_prefix::from_exploded(*s, {c1, c2}));
+            for (auto&& c3 : c3s) {
+                keys.push_back(clustering_key_prefix::from_exploded(*s, {c1, c2, c3}));
+            }
+        }
+    }
+    std::vector<position_in_partition_view> positions;
+    for (auto&& k : keys) {
+        for (auto w : {bound_weight::before_all_prefixed, bound_weight::equal, bound_weight::after_all_prefixed}) {
+            positions.emplace_back(k, w);
+        }
+    }
+
+    auto encode = [&] (position_in_partition_view p) {
+        clustering_position_encoder::buffer buf;
+        BOOST_REQUIRE(encoder->encode(p, buf));
+        return bytes(buf.data(), buf.size());
+    };
+    position_in_partition::tri_compare cmp(*s);
+    for (auto&& a : positions) {
+        auto ea = encode(a);
+        for (auto&& b : positions) {
+            auto expected = cmp(a, b);
+            auto c = compare_unsigned(ea, encode(b));
+            BOOST_REQUIRE_EQUAL(c < 0, expected < 0);
+            BOOST_REQUIRE_EQUAL(c > 0, expected > 0);
+        }
+    }
+
+    auto unencodable = schema_builder("ks", "cf2")
+        .with_column("pk", bytes_type, column_kind::partition_key)
+        .with_column("c1", decimal_type, column_kind::clustering_key)
+        .build();
+    BOOST_REQUIRE(!unencodable->clustering_position_encoder());
+}
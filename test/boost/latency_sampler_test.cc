@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+#include <seastar/core/sleep.hh>
+
+#include "utils/latency_sampler.hh"
+
+using namespace std::chrono_literals;
+
+SEASTAR_THREAD_TEST_CASE(test_latency_sampler_period) {
+    utils::latency_sampler sampler;
+    BOOST_REQUIRE(!sampler.should_sample(utils::latency_stage::request));
+
+    sampler.set_sample_period(3);
+    unsigned sampled = 0;
+    for (int i = 0; i < 30; ++i) {
+        sampled += sampler.should_sample(utils::latency_stage::request);
+    }
+    BOOST_REQUIRE_EQUAL(sampled, 10);
+    // Stages are counted independently.
+    BOOST_REQUIRE(sampler.should_sample(utils::latency_stage::replica_read));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_latency_sampler_recent) {
+    utils::latency_sampler sampler;
+    for (uint32_t i = 0; i < utils::latency_sampler::recent_samples + 10; ++i) {
+        sampler.record(utils::latency_stage::read_admission, std::chrono::microseconds(i));
+    }
+    auto recent = sampler.recent(utils::latency_stage::read_admission);
+    BOOST_REQUIRE_EQUAL(recent.size(), utils::latency_sampler::recent_samples);
+    BOOST_REQUIRE_EQUAL(recent.front(), 10);
+    BOOST_REQUIRE_EQUAL(recent.back(), utils::latency_sampler::recent_samples + 9);
+    BOOST_REQUIRE_EQUAL(sampler.histogram(utils::latency_stage::read_admission)._count, utils::latency_sampler::recent_samples + 10);
+    BOOST_REQUIRE(sampler.recent(utils::latency_stage::request).empty());
+}
+
+SEASTAR_THREAD_TEST_CASE(test_sample_latency) {
+    auto& sampler = utils::local_latency_sampler();
+    sampler.set_sample_period(1);
+    utils::sample_latency(utils::latency_stage::replica_write, [] {
+        return seastar::sleep(1ms);
+    }).get();
+    auto recent = sampler.recent(utils::latency_stage::replica_write);
+    BOOST_REQUIRE_EQUAL(recent.size(), 1);
+    BOOST_REQUIRE_GE(recent.front(), 1000);
+    sampler.set_sample_period(0);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_latency_stage_names) {
+    for (size_t i = 0; i < utils::latency_stage_count; ++i) {
+        auto stage = utils::latency_stage(i);
+        BOOST_REQUIRE(utils::latency_stage_from_string(to_string(stage)) == stage);
+    }
+    BOOST_REQUIRE(!utils::latency_stage_from_string("nonexistent"));
+}
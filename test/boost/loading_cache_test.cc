@@ -20,6 +20,7 @@
  */
 
 #include <boost/test/unit_test.hpp>
+#include <boost/range/irange.hpp>
 #include "utils/loading_shared_values.hh"
 #include "utils/loading_cache.hh"
 #include <seastar/core/aligned_buffer.hh>
@@ -38,6 +39,7 @@
 #include "test/lib/tmpdir.hh"
 #include "test/lib/log.hh"
 
+#include <atomic>
 #include <vector>
 #include <numeric>
 #include <random>
@@ -353,3 +355,81 @@ SEASTAR_TEST_CASE(test_loading_cache_reload_during_eviction) {
         BOOST_REQUIRE_EQUAL(loading_cache.size(), 1);
     });
 }
+
+SEASTAR_TEST_CASE(test_loading_cache_refresh_ahead) {
+    return seastar::async([] {
+        using namespace std::chrono;
+        load_count = 0;
+        // The timer only reloads entries older than the refresh period, which here exceeds the expiry period,
+        // so the second load can only come from the read.
+        utils::loading_cache<int, sstring, utils::loading_cache_reload_enabled::yes> loading_cache(num_loaders, 1s, 10s, testlog, loader);
+        auto stop_cache_reload = seastar::defer([&loading_cache] { loading_cache.stop().get(); });
+        prepare().get();
+        loading_cache.get_ptr(0).discard_result().get();
+        BOOST_REQUIRE_EQUAL(load_count, 1);
+        sleep(600ms).get();
+        loading_cache.get_ptr(0).discard_result().get();
+        BOOST_REQUIRE(eventually_true([&] { return load_count == 2; }));
+        BOOST_REQUIRE(loading_cache.find(0) != loading_cache.end());
+    });
+}
+
+SEASTAR_TEST_CASE(test_loading_cache_reload_concurrency) {
+    return seastar::async([] {
+        using namespace std::chrono;
+        using cache_type = utils::loading_cache<int, sstring, utils::loading_cache_reload_enabled::yes>;
+        constexpr int keys = 100;
+        int loads = 0;
+        size_t in_flight = 0;
+        size_t max_in_flight = 0;
+        cache_type loading_cache(keys, 1s, 10ms, testlog, [&] (const int& k) {
+            ++loads;
+            max_in_flight = std::max(max_in_flight, ++in_flight);
+            return sleep(5ms).then([&, k] {
+                --in_flight;
+                return make_ready_future<sstring>(format("{}", k));
+            });
+        });
+        auto stop_cache_reload = seastar::defer([&loading_cache] { loading_cache.stop().get(); });
+
+        for (int i = 0; i < keys; ++i) {
+            loading_cache.get_ptr(i).discard_result().get();
+        }
+        BOOST_REQUIRE(eventually_true([&] { return loads >= 2 * keys; }));
+        BOOST_REQUIRE_LE(max_in_flight, cache_type::max_concurrent_reloads);
+        BOOST_REQUIRE_EQUAL(loading_cache.size(), keys);
+    });
+}
+
+SEASTAR_TEST_CASE(test_shard_owned_loading_cache) {
+    return seastar::async([] {
+        using namespace std::chrono;
+        using cache_type = utils::shard_owned_loading_cache<int, sstring>;
+        constexpr int keys = 100;
+        static std::atomic<int> loads;
+        loads = 0;
+        sharded<cache_type> caches;
+        caches.start(keys, 1h, 1h, std::ref(testlog), [] (const int& k) {
+            ++loads;
+            return make_ready_future<sstring>(format("{}", k));
+        }, cache_type::local_instance_fn([&caches] () -> cache_type& {
+            return caches.local();
+        })).get();
+        auto stop_caches = seastar::defer([&caches] { caches.stop().get(); });
+
+        // Every shard reads every key, but each key is loaded once per node.
+        auto matching = caches.map_reduce0([keys] (cache_type& cache) {
+            return do_with(size_t(0), [&cache, keys] (size_t& matching) {
+                return parallel_for_each(boost::irange(0, keys), [&cache, &matching] (int k) {
+                    return cache.get(k).then([k, &matching] (sstring v) {
+                        matching += v == format("{}", k);
+                    });
+                }).then([&cache, &matching] {
+                    return cache.size() == keys ? matching : 0;
+                });
+            });
+        }, size_t(0), std::plus<size_t>()).get0();
+        BOOST_REQUIRE_EQUAL(matching, size_t(keys) * smp::count);
+        BOOST_REQUIRE_EQUAL(loads.load(), keys);
+    });
+}
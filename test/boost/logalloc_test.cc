@@ -1366,3 +1366,40 @@ SEASTAR_THREAD_TEST_CASE(test_can_reclaim_contiguous_memory_with_mixed_allocatio
     }
 }
 #endif
+
+#ifndef SEASTAR_DEFAULT_ALLOCATOR
+SEASTAR_THREAD_TEST_CASE(test_background_reclaim_compacts_sparse_regions) {
+    prime_segment_pool(memory::stats().total_memory(), memory::min_free_memory()).get();
+
+    region r;
+    std::vector<managed_bytes> objs;
+    auto clean_up = defer([&] {
+        with_allocator(r.allocator(), [&] {
+            objs.clear();
+        });
+    });
+
+    auto total_memory = memory::stats().total_memory();
+    with_allocator(r.allocator(), [&] {
+        while (r.occupancy().total_space() < total_memory / 2) {
+            objs.emplace_back(managed_bytes(managed_bytes::initialized_later(), 1024));
+        }
+        // Leave every segment half-empty.
+        for (size_t i = 0; i < objs.size(); i += 2) {
+            objs[i] = managed_bytes();
+        }
+    });
+    auto before = r.occupancy().total_space();
+    testlog.info("region occupancy before: {}", r.occupancy());
+
+    logalloc::shard_tracker().start_background_reclaim(default_scheduling_group(), total_memory * 5 / 8);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (r.occupancy().total_space() > before * 3 / 4 && std::chrono::steady_clock::now() < deadline) {
+        seastar::sleep(std::chrono::milliseconds(10)).get();
+    }
+    logalloc::shard_tracker().stop_background_reclaim().get();
+    testlog.info("region occupancy after: {}", r.occupancy());
+
+    BOOST_REQUIRE_LE(r.occupancy().total_space(), before * 3 / 4);
+}
+#endif
@@ -176,6 +176,42 @@ SEASTAR_TEST_CASE(test_memtable_flush_reader) {
     });
 }
 
+SEASTAR_TEST_CASE(test_memtable_flush_reader_of_split_ranges) {
+    return seastar::async([] {
+        random_mutation_generator gen(random_mutation_generator::generate_counters::no);
+        table_stats tbl_stats;
+        dirty_memory_manager mgr;
+        const auto muts = gen(32);
+        const auto now = gc_clock::now();
+        auto mt = make_lw_shared<memtable>(gen.schema(), mgr, tbl_stats);
+        for (auto& m : muts) {
+            mt->apply(m);
+        }
+
+        BOOST_REQUIRE_EQUAL(mt->split_for_flush(1).size(), 1);
+        auto ranges = mt->split_for_flush(4);
+        BOOST_REQUIRE_EQUAL(ranges.size(), 4);
+
+        // All sub-ranges are flushed concurrently, so open every reader
+        // before consuming any of them.
+        std::vector<flat_mutation_reader> readers;
+        for (auto& r : ranges) {
+            readers.push_back(mt->make_flush_reader(gen.schema(), r, default_priority_class()));
+        }
+        auto next = muts.begin();
+        for (auto& rd : readers) {
+            while (auto mo = read_mutation_from_flat_mutation_reader(rd, db::no_timeout).get0()) {
+                BOOST_REQUIRE(next != muts.end());
+                auto expected = *next++;
+                expected.partition().compact_for_compaction(*expected.schema(), always_gc, now);
+                mo->partition().compact_for_compaction(*mo->schema(), always_gc, now);
+                assert_that(*mo).is_equal_to(expected);
+            }
+        }
+        BOOST_REQUIRE(next == muts.end());
+    });
+}
+
 SEASTAR_TEST_CASE(test_adding_a_column_during_reading_doesnt_affect_read_result) {
     return seastar::async([] {
         auto common_builder = schema_builder("ks", "cf")
@@ -635,3 +671,62 @@ SEASTAR_THREAD_TEST_CASE(test_collecting_encoding_stats) {
     BOOST_CHECK_EQUAL(stats.min_timestamp, -10);
     BOOST_CHECK(stats.min_ttl == md2_ttl);
 }
+
+SEASTAR_TEST_CASE(test_append_only_memtable_conforms_to_mutation_source) {
+    return seastar::async([] {
+        run_mutation_source_tests([](schema_ptr s, const std::vector<mutation>& partitions) {
+            auto mt = make_lw_shared<memtable>(s);
+            mt->set_append_only_ingest(true);
+
+            for (auto&& m : partitions) {
+                mt->apply(freeze(m), s);
+            }
+
+            return mt->as_data_source();
+        });
+    });
+}
+
+SEASTAR_THREAD_TEST_CASE(test_append_only_ingest) {
+    schema_ptr s = schema_builder("ks", "cf")
+            .with_column("pk", bytes_type, column_kind::partition_key)
+            .with_column("ck", int32_type, column_kind::clustering_key)
+            .with_column("v", int32_type, column_kind::regular_column)
+            .build();
+
+    dirty_memory_manager mgr;
+    table_stats tbl_stats;
+    auto mt = make_lw_shared<memtable>(s, mgr, tbl_stats);
+    mt->set_append_only_ingest(true);
+
+    // Enough writes for several sorted runs, and for merges started by the writes.
+    std::vector<mutation> ring = make_ring(s, 3000);
+    std::vector<mutation> expected = ring;
+    for (int i = 0; i < 100000; ++i) {
+        auto p = tests::random::get_int<size_t>(0, ring.size() - 1);
+        auto m = ring[p];
+        m.set_clustered_cell(clustering_key::from_single_value(*s, int32_type->decompose(i)), "v", data_value(i), next_timestamp());
+        mt->apply(freeze(m), s);
+        expected[p].apply(m);
+    }
+    BOOST_REQUIRE(!mt->empty());
+
+    auto rd = assert_that(mt->make_flush_reader(s, default_priority_class()));
+    BOOST_REQUIRE(!mt->has_pending_writes());
+    for (auto&& m : expected) {
+        rd.produces(m);
+    }
+    rd.produces_end_of_stream();
+
+    // Writes buffered after a read are merged into the existing partitions.
+    auto m = ring[0];
+    m.set_clustered_cell(clustering_key::from_single_value(*s, int32_type->decompose(-1)), "v", data_value(-1), next_timestamp());
+    mt->apply(freeze(m), s);
+    expected[0].apply(m);
+    BOOST_REQUIRE(mt->has_pending_writes());
+    mt->apply_pending_gently().get();
+    BOOST_REQUIRE(!mt->has_pending_writes());
+    assert_that(mt->make_flat_reader(s, dht::partition_range::make_singular(expected[0].decorated_key())))
+        .produces(expected[0])
+        .produces_end_of_stream();
+}
@@ -26,6 +26,9 @@
 #include "utils/murmur_hash.hh"
 #include "bytes.hh"
 #include <seastar/core/print.hh>
+#include <algorithm>
+#include <random>
+#include <vector>
 
 static const bytes full_sequence("012345678901234567890123456789012345678901234567890123456789");
 
@@ -122,3 +125,50 @@ BOOST_AUTO_TEST_CASE(test_hash_output) {
         }
     }
 }
+
+BOOST_AUTO_TEST_CASE(test_batch_hash_output) {
+    // Mix prefixes of different lengths in the same group of keys.
+    std::vector<bytes_view> keys;
+    std::vector<size_t> lengths;
+    for (size_t i = 0; i < full_sequence.size(); ++i) {
+        for (size_t len : {i, full_sequence.size() - 1 - i, i / 2}) {
+            keys.push_back(bytes_view(full_sequence.begin(), len));
+            lengths.push_back(len);
+        }
+    }
+
+    for (size_t n : {size_t(0), size_t(3), size_t(5), keys.size()}) {
+        std::vector<bytes_view> batch(keys.begin(), keys.begin() + n);
+        std::vector<std::array<uint64_t, 2>> results;
+        utils::murmur_hash::hash3_x64_128(batch, seed, results);
+        BOOST_REQUIRE_EQUAL(results.size(), n);
+        for (size_t i = 0; i < n; ++i) {
+            BOOST_REQUIRE(results[i] == prefix_hashes[lengths[i]]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_hash_matches_single) {
+    // Bytes above 0x7f are sign extended in the tail, so use all values.
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<size_t> length(0, 70);
+
+    for (size_t n : {size_t(7), size_t(8), size_t(12), size_t(13), size_t(64)}) {
+        std::vector<bytes> storage;
+        for (size_t i = 0; i < n; ++i) {
+            bytes b(bytes::initialized_later(), length(rng));
+            std::generate(b.begin(), b.end(), [&] { return int8_t(byte(rng)); });
+            storage.push_back(std::move(b));
+        }
+        std::vector<bytes_view> keys(storage.begin(), storage.end());
+        std::vector<std::array<uint64_t, 2>> results;
+        utils::murmur_hash::hash3_x64_128(keys, seed, results);
+        BOOST_REQUIRE_EQUAL(results.size(), n);
+        for (size_t i = 0; i < n; ++i) {
+            std::array<uint64_t, 2> expected;
+            utils::murmur_hash::hash3_x64_128(keys[i], seed, expected);
+            BOOST_REQUIRE(results[i] == expected);
+        }
+    }
+}
@@ -558,3 +558,70 @@ SEASTAR_THREAD_TEST_CASE(test_result_size_calculation) {
     BOOST_REQUIRE_EQUAL(digest_only_builder.memory_accounter().used_memory(), result_and_digest_builder.memory_accounter().used_memory());
 }
 
+
+SEASTAR_THREAD_TEST_CASE(test_data_query_filters) {
+    storage_service_for_tests ssft;
+    auto s = make_schema();
+    auto& v1 = *s->get_column_definition("v1");
+    auto& s1 = *s->get_column_definition("s1");
+
+    mutation m1(s, partition_key::from_single_value(*s, "key1"));
+    m1.set_static_cell("s1", data_value(bytes("S1")), 1);
+    m1.set_clustered_cell(clustering_key::from_single_value(*s, bytes("A")), "v1", data_value(bytes("x")), 1);
+    m1.set_clustered_cell(clustering_key::from_single_value(*s, bytes("B")), "v1", data_value(bytes("y")), 1);
+    m1.set_clustered_cell(clustering_key::from_single_value(*s, bytes("C")), "v1", data_value(bytes("x")), 1);
+    mutation m2(s, partition_key::from_single_value(*s, "key2"));
+    m2.set_static_cell("s1", data_value(bytes("S2")), 1);
+    m2.set_clustered_cell(clustering_key::from_single_value(*s, bytes("A")), "v1", data_value(bytes("x")), 1);
+    mutation m3(s, partition_key::from_single_value(*s, "key3"));
+    m3.set_static_cell("s1", data_value(bytes("S3")), 1);
+    auto src = make_source({m1, m2, m3});
+
+    auto query = [&] (query::column_filters filters, uint32_t row_limit = query::max_rows) {
+        auto slice = make_full_slice(*s);
+        slice.set_filters(std::move(filters));
+        query::result_memory_limiter l(std::numeric_limits<ssize_t>::max());
+        query::result::builder builder(slice, query::result_options::only_result(), l.new_data_read(query::result_memory_limiter::maximum_result_size).get0());
+        data_query(s, src, query::full_partition_range, slice, row_limit, query::max_partitions,
+                gc_clock::now(), builder, db::no_timeout, max_memory_for_reverse_query).get();
+        return query::result_set::from_raw_result(s, slice, builder.build());
+    };
+    auto any_value = nonwrapping_range<bytes>::make_open_ended_both_sides();
+
+    assert_that(query({{false, v1.id, {bytes("x")}, any_value}}))
+        .has_size(3)
+        .has(a_row()
+            .with_column("pk", data_value(bytes("key1")))
+            .with_column("ck", data_value(bytes("A")))
+            .with_column("s1", data_value(bytes("S1"))))
+        .has(a_row()
+            .with_column("pk", data_value(bytes("key1")))
+            .with_column("ck", data_value(bytes("C"))))
+        .has(a_row()
+            .with_column("pk", data_value(bytes("key2")))
+            .with_column("ck", data_value(bytes("A")))
+            .with_column("s1", data_value(bytes("S2"))));
+
+    // Rows which don't match aren't counted towards the limit.
+    assert_that(query({{false, v1.id, {bytes("x")}, any_value}}, 2))
+        .has_size(2);
+
+    assert_that(query({{false, v1.id, {}, nonwrapping_range<bytes>::make_starting_with({bytes("y"), true})}}))
+        .has_only(a_row()
+            .with_column("pk", data_value(bytes("key1")))
+            .with_column("ck", data_value(bytes("B"))));
+
+    // A static filter applies to all rows of the partition, and to its static
+    // row when there are no clustering rows.
+    assert_that(query({{true, s1.id, {bytes("S2"), bytes("S3")}, any_value}}))
+        .has_size(2)
+        .has(a_row()
+            .with_column("pk", data_value(bytes("key2")))
+            .with_column("ck", data_value(bytes("A"))))
+        .has(a_row()
+            .with_column("pk", data_value(bytes("key3")))
+            .with_column("s1", data_value(bytes("S3"))));
+
+    assert_that(query({{true, s1.id, {bytes("S3")}, any_value}, {false, v1.id, {bytes("x")}, any_value}}))
+        .is_empty();
+}
@@ -1325,6 +1325,45 @@ SEASTAR_TEST_CASE(restricted_reader_create_reader) {
     });
 }
 
+SEASTAR_THREAD_TEST_CASE(test_inactive_reads_evicted_largest_first) {
+    class sized_inactive_read : public reader_concurrency_semaphore::inactive_read {
+        size_t _size;
+        std::vector<size_t>& _evicted;
+    public:
+        sized_inactive_read(size_t size, std::vector<size_t>& evicted) : _size(size), _evicted(evicted) { }
+        virtual void evict() override {
+            _evicted.push_back(_size);
+        }
+        virtual size_t memory_usage() const noexcept override {
+            return _size;
+        }
+    };
+
+    reader_concurrency_semaphore semaphore(100, 4 * new_reader_base_cost, get_name());
+    std::vector<size_t> evicted;
+    auto h1 = semaphore.register_inactive_read(std::make_unique<sized_inactive_read>(100, evicted));
+    auto h2 = semaphore.register_inactive_read(std::make_unique<sized_inactive_read>(1000, evicted));
+    auto h3 = semaphore.register_inactive_read(std::make_unique<sized_inactive_read>(10, evicted));
+
+    BOOST_REQUIRE_EQUAL(semaphore.evict_inactive_reads_for_memory(500), 1000);
+    BOOST_REQUIRE_EQUAL(semaphore.evict_inactive_reads_for_memory(101), 110);
+    BOOST_REQUIRE(evicted == std::vector<size_t>({1000, 100, 10}));
+    BOOST_REQUIRE_EQUAL(semaphore.get_inactive_read_stats().memory_based_evictions, 3);
+    BOOST_REQUIRE_EQUAL(semaphore.get_inactive_read_stats().population, 0);
+    BOOST_REQUIRE_EQUAL(semaphore.evict_inactive_reads_for_memory(1), 0);
+
+    // Only short on memory: the largest read goes first.
+    evicted.clear();
+    auto permit = semaphore.consume_resources(reader_concurrency_semaphore::resources(0, 4 * new_reader_base_cost));
+    h1 = semaphore.register_inactive_read(std::make_unique<sized_inactive_read>(100, evicted));
+    h2 = semaphore.register_inactive_read(std::make_unique<sized_inactive_read>(1000, evicted));
+    auto fut = semaphore.wait_admission(new_reader_base_cost, db::no_timeout);
+    BOOST_REQUIRE(evicted == std::vector<size_t>({1000, 100}));
+    BOOST_REQUIRE_EQUAL(semaphore.get_inactive_read_stats().permit_based_evictions, 2);
+    permit.release();
+    fut.get();
+}
+
 SEASTAR_TEST_CASE(test_restricted_reader_as_mutation_source) {
     return seastar::async([test_name = get_name()] {
         reader_concurrency_semaphore semaphore(100, 10 * new_reader_base_cost, test_name);
@@ -1041,6 +1041,28 @@ SEASTAR_TEST_CASE(test_apply_monotonically_is_monotonic) {
     return make_ready_future<>();
 }
 
+SEASTAR_THREAD_TEST_CASE(test_apply_monotonically_appending_rows) {
+    simple_schema table;
+    auto&& s = *table.schema();
+    mutation_application_stats app_stats;
+    auto pk = table.make_pkey(0);
+
+    mutation m(table.schema(), pk);
+    mutation expected(table.schema(), pk);
+    for (int i = 0; i < 10; ++i) {
+        // Each batch starts at the last row of the previous one, so both
+        // the append and the overlapping case are exercised.
+        mutation batch(table.schema(), pk);
+        for (int j = i * 3; j <= i * 3 + 3; ++j) {
+            table.add_row(batch, table.make_ckey(j), format("v{}", i));
+        }
+        expected.apply(batch);
+        m.partition().apply_monotonically(s, mutation_partition(s, batch.partition()), no_cache_tracker, app_stats);
+    }
+    assert_that(m).is_equal_to(expected);
+    BOOST_REQUIRE_EQUAL(m.partition().clustered_rows().calculate_size(), 31u);
+}
+
 SEASTAR_TEST_CASE(test_mutation_diff) {
     return seastar::async([] {
         mutation_application_stats app_stats;
@@ -2076,6 +2098,83 @@ SEASTAR_THREAD_TEST_CASE(test_row_size_is_immune_to_application_order) {
     BOOST_REQUIRE_EQUAL(size1, size2);
 }
 
+SEASTAR_THREAD_TEST_CASE(test_packed_rows) {
+    auto builder = schema_builder("ks", "cf")
+            .with_column("pk", int32_type, column_kind::partition_key)
+            .with_column("ck", int32_type, column_kind::clustering_key)
+            .with_column("text", utf8_type);
+    for (auto i = 0; i < 8; ++i) {
+        builder.with_column(to_bytes(format("v{}", i)), long_type);
+    }
+    auto s = builder.build();
+    auto kind = column_kind::regular_column;
+    auto& text = *s->get_column_definition("text");
+    auto col = [&] (int i) -> const column_definition& {
+        return *s->get_column_definition(to_bytes(format("v{}", i)));
+    };
+    // Cells get distinct timestamps when spread is non-zero.
+    auto make_row = [&] (api::timestamp_type ts, int spread = 0) {
+        row r;
+        for (auto i = 0; i < 8; ++i) {
+            r.apply(col(i), atomic_cell::make_live(*long_type, ts + i % 2 * spread, long_type->decompose(int64_t(i))));
+        }
+        return r;
+    };
+
+    for (auto ts : {api::timestamp_type(1), api::timestamp_type(api::missing_timestamp)})
+    for (auto spread : {0, 1}) {
+        auto r = make_row(ts, spread);
+        auto packed = row(*s, kind, r);
+        BOOST_REQUIRE(packed.pack(*s, kind));
+        BOOST_REQUIRE(packed.is_packed());
+        BOOST_REQUIRE_LT(packed.external_memory_usage(*s, kind), r.external_memory_usage(*s, kind));
+        BOOST_REQUIRE(packed.equal(kind, *s, r, *s));
+        BOOST_REQUIRE(r.equal(kind, *s, packed, *s));
+        for (auto t : {tombstone(), tombstone(ts, gc_clock::now()), tombstone(ts + spread, gc_clock::now())}) {
+            BOOST_REQUIRE_EQUAL(packed.is_live(*s, kind, t), r.is_live(*s, kind, t));
+        }
+
+        auto copy = row(*s, kind, packed);
+        BOOST_REQUIRE(!copy.is_packed());
+        BOOST_REQUIRE(copy.equal(kind, *s, r, *s));
+
+        auto newer = make_row(ts + 10);
+        auto expected = row(*s, kind, r);
+        expected.apply(*s, kind, newer);
+        packed.apply(*s, kind, newer);
+        BOOST_REQUIRE(!packed.is_packed());
+        BOOST_REQUIRE(packed.equal(kind, *s, expected, *s));
+
+        BOOST_REQUIRE(packed.pack(*s, kind));
+        packed.unpack(*s, kind);
+        BOOST_REQUIRE(!packed.is_packed());
+        BOOST_REQUIRE(packed.equal(kind, *s, expected, *s));
+
+        auto moved_into = row();
+        BOOST_REQUIRE(copy.pack(*s, kind));
+        moved_into.apply_monotonically(*s, kind, std::move(copy));
+        BOOST_REQUIRE(moved_into.is_packed());
+        BOOST_REQUIRE(moved_into.equal(kind, *s, r, *s));
+    }
+
+    // Rows with cells which don't have a fixed size, are dead or expire stay as they are.
+    auto with_text = make_row(1);
+    with_text.apply(text, atomic_cell::make_live(*utf8_type, 1, utf8_type->decompose(data_value("text"))));
+    BOOST_REQUIRE(!with_text.pack(*s, kind));
+    auto with_dead = make_row(1);
+    with_dead.apply(col(0), atomic_cell::make_dead(5, gc_clock::now()));
+    BOOST_REQUIRE(!with_dead.pack(*s, kind));
+    auto with_expiring = make_row(1);
+    with_expiring.apply(col(0), atomic_cell::make_live(*long_type, 5, long_type->decompose(int64_t(0)), gc_clock::now() + 1h, 1h));
+    BOOST_REQUIRE(!with_expiring.pack(*s, kind));
+    BOOST_REQUIRE(!with_expiring.is_packed());
+
+    // Narrow rows aren't packed when that doesn't save memory.
+    row narrow;
+    narrow.apply(col(0), atomic_cell::make_live(*long_type, 1, long_type->decompose(int64_t(0))));
+    BOOST_REQUIRE(!narrow.pack(*s, kind));
+}
+
 SEASTAR_THREAD_TEST_CASE(test_schema_changes) {
     for_each_schema_change([] (schema_ptr base, const std::vector<mutation>& base_mutations,
                                schema_ptr changed, const std::vector<mutation>& changed_mutations) {
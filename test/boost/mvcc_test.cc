@@ -955,6 +955,57 @@ SEASTAR_TEST_CASE(test_versions_are_merged_when_snapshots_go_away) {
     });
 }
 
+SEASTAR_TEST_CASE(test_mergeable_version_count) {
+    return seastar::async([] {
+        logalloc::region r;
+        mutation_cleaner cleaner(r, nullptr, app_stats_for_tests);
+        with_allocator(r.allocator(), [&] {
+            random_mutation_generator gen(random_mutation_generator::generate_counters::no);
+            auto s = gen.schema();
+
+            mutation m1 = gen();
+            mutation m2 = gen();
+            mutation m3 = gen();
+
+            m1.partition().make_fully_continuous();
+            m2.partition().make_fully_continuous();
+            m3.partition().make_fully_continuous();
+
+            auto e = partition_entry(mutation_partition(*s, m1.partition()));
+            auto snap1 = e.read(r, cleaner, s, nullptr);
+            BOOST_REQUIRE_EQUAL(0, snap1->mergeable_version_count());
+
+            auto apply = [&] (const mutation& m) {
+                mutation_application_stats app_stats;
+                logalloc::reclaim_lock rl(r);
+                e.apply(*s, m.partition(), *s, app_stats);
+            };
+
+            apply(m2);
+            auto snap2 = e.read(r, cleaner, s, nullptr);
+            apply(m3);
+
+            // Merging stops at the first referenced version, which is
+            // the one of snap2 for snap1, and the latest one for snap2.
+            BOOST_REQUIRE_EQUAL(3, boost::size(e.versions()));
+            BOOST_REQUIRE_EQUAL(1, snap1->mergeable_version_count());
+            BOOST_REQUIRE_EQUAL(1, snap2->mergeable_version_count());
+
+            snap2 = {};
+            cleaner.drain().get();
+            BOOST_REQUIRE_EQUAL(2, boost::size(e.versions()));
+            BOOST_REQUIRE_EQUAL(1, snap1->mergeable_version_count());
+
+            snap1 = {};
+            cleaner.drain().get();
+
+            BOOST_REQUIRE_EQUAL(0, cleaner.pending_version_merges());
+            BOOST_REQUIRE_EQUAL(1, boost::size(e.versions()));
+            assert_that(s, e.squashed(*s)).is_equal_to((m1 + m2 + m3).partition());
+        });
+    });
+}
+
 // Reproducer of #4030
 SEASTAR_TEST_CASE(test_snapshot_merging_after_container_is_destroyed) {
     return seastar::async([] {
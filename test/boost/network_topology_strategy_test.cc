@@ -26,6 +26,7 @@
 #include "locator/network_topology_strategy.hh"
 #include <seastar/testing/test_case.hh>
 #include <seastar/core/sstring.hh>
+#include <seastar/core/thread.hh>
 #include "log.hh"
 #include <vector>
 #include <string>
@@ -597,6 +598,69 @@ SEASTAR_TEST_CASE(testCalculateEndpoints) {
     });
 }
 
+static void check_sorted_tokens(const token_metadata& tm) {
+    std::vector<token> expected;
+    for (auto& x : tm.get_token_to_endpoint()) {
+        expected.push_back(x.first);
+    }
+    std::sort(expected.begin(), expected.end());
+    BOOST_REQUIRE(tm.sorted_tokens() == expected);
+}
+
+SEASTAR_TEST_CASE(test_incremental_sorted_tokens_and_address_ranges) {
+    utils::fb_utilities::set_broadcast_address(gms::inet_address("localhost"));
+    utils::fb_utilities::set_broadcast_rpc_address(gms::inet_address("localhost"));
+
+    return i_endpoint_snitch::create_snitch("RackInferringSnitch").then([] {
+      return seastar::async([] {
+        std::vector<inet_address> nodes;
+        for (unsigned i = 1; i <= 12; ++i) {
+            nodes.push_back(inet_address(format("192.{:d}.{:d}.1", 100 + i % 2, 10 * (i % 3 + 1) + i)));
+        }
+        token_metadata tm;
+        for (auto& node : nodes) {
+            std::unordered_set<token> tokens;
+            while (tokens.size() < 16) {
+                tokens.insert(dht::token::get_random_token());
+            }
+            tm.update_normal_tokens(tokens, node);
+            check_sorted_tokens(tm);
+        }
+
+        // Clones share the sorted tokens, but changing either side
+        // mustn't affect the other.
+        auto clone = tm.clone_only_token_map();
+        clone.remove_endpoint(nodes[0]);
+        check_sorted_tokens(clone);
+        check_sorted_tokens(tm);
+        BOOST_REQUIRE_EQUAL(clone.sorted_tokens().size() + 16, tm.sorted_tokens().size());
+
+        // Replacing a node's tokens with a subset drops the others.
+        auto tokens = tm.get_tokens(nodes[1]);
+        tm.update_normal_tokens(std::unordered_set<token>(tokens.begin(), tokens.begin() + 8), nodes[1]);
+        check_sorted_tokens(tm);
+        BOOST_REQUIRE_EQUAL(tm.get_tokens(nodes[1]).size(), 8);
+
+        std::map<sstring, sstring> options = {{"100", "2"}, {"101", "2"}};
+        auto ars = abstract_replication_strategy::create_replication_strategy("test keyspace", "NetworkTopologyStrategy", tm, options);
+        auto all = ars->get_address_ranges(tm);
+        std::unordered_set<inet_address> some{nodes[2], nodes[5]};
+        auto ranges = ars->get_address_ranges(tm, some).get0();
+        size_t expected = 0;
+        for (auto& x : all) {
+            if (some.count(x.first)) {
+                ++expected;
+                auto r = ranges.equal_range(x.first);
+                BOOST_REQUIRE(std::any_of(r.first, r.second, [&] (auto& y) { return y.second == x.second; }));
+            }
+        }
+        BOOST_REQUIRE_EQUAL(ranges.size(), expected);
+      }).finally([] {
+        return i_endpoint_snitch::stop_snitch();
+      });
+    });
+}
+
 SEASTAR_TEST_CASE(test_invalid_dcs) {
     return do_with_cql_env_thread([] (auto& e) {
         for (auto& incorrect : std::vector<std::string>{"3\"", "", "!!!", "abcb", "!3", "-5", "0x123", "999999999999999999999999999999"}) {
@@ -19,6 +19,7 @@
  * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <set>
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <seastar/testing/thread_test_case.hh>
 
@@ -91,6 +92,36 @@ SEASTAR_THREAD_TEST_CASE(test_token_wraparound_2) {
     BOOST_REQUIRE_EQUAL(midpoint, token_from_long(0x7800'0000'0000'0000));
 }
 
+SEASTAR_THREAD_TEST_CASE(test_get_tokens_matches_get_token) {
+    auto single = schema_builder("ks", "cf")
+        .with_column("pk", bytes_type, column_kind::partition_key)
+        .with_column("v", int32_type)
+        .build();
+    auto compound = schema_builder("ks", "cf2")
+        .with_column("c1", int32_type, column_kind::partition_key)
+        .with_column("c2", bytes_type, column_kind::partition_key)
+        .with_column("v", int32_type)
+        .build();
+
+    dht::murmur3_partitioner partitioner;
+    std::vector<partition_key> single_keys;
+    std::vector<partition_key> compound_keys;
+    for (int i = 0; i < 37; ++i) {
+        auto value = bytes(bytes::initialized_later(), i * 3);
+        std::fill(value.begin(), value.end(), int8_t(i * 11));
+        single_keys.push_back(partition_key::from_single_value(*single, value));
+        compound_keys.push_back(partition_key::from_exploded(*compound, {int32_type->decompose(i), value}));
+    }
+    for (auto [s, keys] : {std::pair(single, &single_keys), std::pair(compound, &compound_keys)}) {
+        std::vector<partition_key_view> views(keys->begin(), keys->end());
+        auto tokens = partitioner.get_tokens(*s, views);
+        BOOST_REQUIRE_EQUAL(tokens.size(), views.size());
+        for (size_t i = 0; i < views.size(); ++i) {
+            BOOST_REQUIRE_EQUAL(tokens[i], partitioner.get_token(*s, views[i]));
+        }
+    }
+}
+
 SEASTAR_THREAD_TEST_CASE(test_ring_position_is_comparable_with_decorated_key) {
     auto s = schema_builder("ks", "cf")
         .with_column("pk", bytes_type, column_kind::partition_key)
@@ -392,6 +423,27 @@ SEASTAR_THREAD_TEST_CASE(test_split_range_single_shard) {
     return test_something_with_some_interesting_ranges_and_sharder(do_test_split_range_to_single_shard);
 }
 
+static
+void
+do_test_single_shard_of(const schema& s, const dht::partition_range& pr) {
+    auto sharder = dht::ring_position_range_sharder(s.get_sharder(), pr);
+    std::set<unsigned> shards;
+    while (auto x = sharder.next(s)) {
+        shards.insert(x->shard);
+    }
+    auto shard = dht::single_shard_of(s, pr);
+    if (shard) {
+        BOOST_REQUIRE_EQUAL(shards.size(), 1);
+        BOOST_REQUIRE_EQUAL(*shard, *shards.begin());
+    } else {
+        BOOST_REQUIRE(!pr.is_singular());
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_single_shard_of) {
+    return test_something_with_some_interesting_ranges_and_sharder(do_test_single_shard_of);
+}
+
 // tests for range_split() utility function in repair/range_split.hh
 static int test_split(int N, int K) {
     auto t1 = token_from_long(0x2000'0000'0000'0000);
@@ -336,6 +336,12 @@ class test_querier_cache {
         return *this;
     }
 
+    test_querier_cache& range_mismatch_misses() {
+        BOOST_REQUIRE_EQUAL(_cache.get_stats().misses, ++_expected_stats.misses);
+        BOOST_REQUIRE_EQUAL(_cache.get_stats().range_mismatch_misses, ++_expected_stats.range_mismatch_misses);
+        return *this;
+    }
+
     test_querier_cache& no_drops() {
         BOOST_REQUIRE_EQUAL(_cache.get_stats().drops, _expected_stats.drops);
         return *this;
@@ -346,6 +352,12 @@ class test_querier_cache {
         return *this;
     }
 
+    test_querier_cache& schema_version_drops() {
+        BOOST_REQUIRE_EQUAL(_cache.get_stats().drops, ++_expected_stats.drops);
+        BOOST_REQUIRE_EQUAL(_cache.get_stats().schema_version_drops, ++_expected_stats.schema_version_drops);
+        return *this;
+    }
+
     test_querier_cache& no_evictions() {
         BOOST_REQUIRE_EQUAL(_cache.get_stats().time_based_evictions, _expected_stats.time_based_evictions);
         BOOST_REQUIRE_EQUAL(_cache.get_stats().resource_based_evictions, _expected_stats.resource_based_evictions);
@@ -436,6 +448,16 @@ SEASTAR_THREAD_TEST_CASE(data_and_mutation_querier_can_coexist) {
  * Range matching tests
  */
 
+SEASTAR_THREAD_TEST_CASE(lookup_with_wrong_range_misses) {
+    test_querier_cache t;
+
+    const auto entry = t.produce_first_page_and_save_data_querier();
+    t.assert_cache_lookup_data_querier(entry.key, *t.get_schema(), t.make_partition_range({1, true}, {2, false}), entry.expected_slice)
+        .range_mismatch_misses()
+        .no_drops()
+        .no_evictions();
+}
+
 SEASTAR_THREAD_TEST_CASE(singular_range_lookup_with_stop_at_clustering_row) {
     test_querier_cache t;
 
@@ -534,7 +556,7 @@ SEASTAR_THREAD_TEST_CASE(lookup_with_different_schema_version_drops) {
     const auto entry = t.produce_first_page_and_save_data_querier();
     t.assert_cache_lookup_data_querier(entry.key, *new_schema, entry.expected_range, entry.expected_slice)
         .no_misses()
-        .drops()
+        .schema_version_drops()
         .no_evictions();
 }
 
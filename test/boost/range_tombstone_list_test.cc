@@ -476,6 +476,82 @@ BOOST_AUTO_TEST_CASE(test_add_random) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_apply_list_random) {
+    for (uint32_t i = 0; i < 1000; ++i) {
+        range_tombstone_list l1(*s);
+        range_tombstone_list l2(*s);
+        for (auto&& rt : make_random()) {
+            l1.apply(*s, rt);
+        }
+        for (auto&& rt : make_random()) {
+            l2.apply(*s, rt);
+        }
+
+        range_tombstone_list expected(l1);
+        for (auto&& rt : l2) {
+            expected.apply(*s, rt);
+        }
+
+        l1.apply_monotonically(*s, std::move(l2));
+        BOOST_REQUIRE(assert_valid(l1));
+        assert_that(*s, l1).is_equal_to(expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_apply_list_into_gaps) {
+    range_tombstone_list l1(*s);
+    l1.apply(*s, rtie(10, 20, 1));
+    l1.apply(*s, rtie(30, 40, 1));
+
+    range_tombstone_list l2(*s);
+    l2.apply(*s, rtie(0, 2, 1));
+    l2.apply(*s, rtie(3, 5, 2));
+    l2.apply(*s, rtie(20, 22, 2));
+    l2.apply(*s, rtie(25, 30, 1));
+    l2.apply(*s, rtie(50, 60, 3));
+
+    l1.apply_monotonically(*s, std::move(l2));
+
+    auto it = l1.begin();
+    assert_rt(rtie(0, 2, 1), *it++);
+    assert_rt(rtie(3, 5, 2), *it++);
+    assert_rt(rtie(10, 20, 1), *it++);
+    assert_rt(rtie(20, 22, 2), *it++);
+    assert_rt(rtie(25, 40, 1), *it++);
+    assert_rt(rtie(50, 60, 3), *it++);
+    BOOST_REQUIRE(it == l1.end());
+}
+
+BOOST_AUTO_TEST_CASE(test_erase_before) {
+    range_tombstone_list l(*s);
+    l.apply(*s, rtie(1, 3, 1));
+    l.apply(*s, rt(4, 6, 2));
+    l.apply(*s, rtie(8, 10, 1));
+
+    l.erase_before(*s, position_in_partition_view::before_all_clustered_rows());
+    BOOST_REQUIRE_EQUAL(std::distance(l.begin(), l.end()), 3);
+
+    l.erase_before(*s, position_in_partition_view::before_key(key({3})));
+    auto it = l.begin();
+    assert_rt(rt(4, 6, 2), *it++);
+    assert_rt(rtie(8, 10, 1), *it++);
+    BOOST_REQUIRE(it == l.end());
+
+    l.erase_before(*s, position_in_partition_view::for_key(key({6})));
+    it = l.begin();
+    assert_rt(rt(4, 6, 2), *it++);
+    assert_rt(rtie(8, 10, 1), *it++);
+    BOOST_REQUIRE(it == l.end());
+
+    l.erase_before(*s, position_in_partition_view::after_key(key({6})));
+    it = l.begin();
+    assert_rt(rtie(8, 10, 1), *it++);
+    BOOST_REQUIRE(it == l.end());
+
+    l.erase_before(*s, position_in_partition_view::after_all_clustered_rows());
+    BOOST_REQUIRE(l.empty());
+}
+
 BOOST_AUTO_TEST_CASE(test_non_sorted_addition_with_one_range_with_empty_end) {
     range_tombstone_list l(*s);
 
@@ -35,6 +35,7 @@
 #include "test/lib/simple_schema.hh"
 #include "row_cache.hh"
 #include <seastar/core/thread.hh>
+#include "db/cache_warmer.hh"
 #include "memtable.hh"
 #include "partition_slice_builder.hh"
 #include "test/lib/memtable_snapshot_source.hh"
@@ -1794,6 +1795,165 @@ SEASTAR_TEST_CASE(test_lru) {
     });
 }
 
+static std::vector<mutation> make_single_row_partitions(simple_schema& table, const std::vector<dht::decorated_key>& keys) {
+    std::vector<mutation> muts;
+    for (auto&& key : keys) {
+        mutation m(table.schema(), key);
+        table.add_row(m, table.make_ckey(0), "v");
+        muts.push_back(std::move(m));
+    }
+    return muts;
+}
+
+SEASTAR_TEST_CASE(test_range_scans_populate_probationary_segment) {
+    return seastar::async([] {
+        simple_schema table;
+        auto s = table.schema();
+        auto keys = table.make_pkeys(4);
+        auto muts = make_single_row_partitions(table, keys);
+        auto mt = make_lw_shared<memtable>(s);
+        for (auto&& m : muts) {
+            mt->apply(m);
+        }
+
+        cache_tracker tracker;
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+
+        verify_has(cache, muts[0]);
+
+        assert_that(cache.make_reader(s, dht::partition_range::make_starting_with({keys[1], true})))
+            .produces(muts[1])
+            .produces(muts[2])
+            .produces(muts[3])
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(tracker.partitions(), 4);
+
+        // keys[0] is the least recently used, but the partitions populated by the scan go first.
+        evict_one_partition(tracker);
+        BOOST_REQUIRE_EQUAL(tracker.partitions(), 3);
+        auto misses = tracker.get_stats().partition_misses;
+        verify_has(cache, muts[0]);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partition_misses, misses);
+    });
+}
+
+SEASTAR_TEST_CASE(test_range_scans_admit_partitions_more_popular_than_the_victim) {
+    return seastar::async([] {
+        simple_schema table;
+        auto s = table.schema();
+        auto keys = table.make_pkeys(3);
+        auto muts = make_single_row_partitions(table, keys);
+        auto mt = make_lw_shared<memtable>(s);
+        for (auto&& m : muts) {
+            mt->apply(m);
+        }
+
+        cache_tracker tracker;
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+
+        verify_has(cache, muts[1]);
+        for (int i = 0; i < 3; ++i) {
+            verify_has(cache, muts[0]);
+        }
+
+        evict_one_partition(tracker); // evicts keys[1], which was accessed once
+        BOOST_REQUIRE_EQUAL(tracker.partitions(), 1);
+
+        auto scan = [&] {
+            assert_that(cache.make_reader(s, dht::partition_range::make_starting_with({keys[2], true})))
+                .produces(muts[2])
+                .produces_end_of_stream();
+        };
+
+        auto rejections = tracker.get_stats().admission_rejections;
+        scan();
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().admission_rejections, rejections + 1);
+        BOOST_REQUIRE_EQUAL(tracker.partitions(), 1);
+
+        scan();
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().admission_rejections, rejections + 1);
+        BOOST_REQUIRE_EQUAL(tracker.partitions(), 2);
+    });
+}
+
+SEASTAR_TEST_CASE(test_tables_over_cache_quota_are_evicted_first) {
+    return seastar::async([] {
+        simple_schema table_a;
+        simple_schema table_b;
+        auto keys_a = table_a.make_pkeys(3);
+        auto muts_a = make_single_row_partitions(table_a, keys_a);
+        auto muts_b = make_single_row_partitions(table_b, table_b.make_pkeys(1));
+        auto mt_a = make_lw_shared<memtable>(table_a.schema());
+        for (auto&& m : muts_a) {
+            mt_a->apply(m);
+        }
+        auto mt_b = make_lw_shared<memtable>(table_b.schema());
+        mt_b->apply(muts_b[0]);
+
+        cache_tracker tracker;
+        tracker.set_table_quota_fraction(0.5);
+        row_cache cache_a(table_a.schema(), snapshot_source_from_snapshot(mt_a->as_data_source()), tracker);
+        row_cache cache_b(table_b.schema(), snapshot_source_from_snapshot(mt_b->as_data_source()), tracker);
+
+        verify_has(cache_b, muts_b[0]);
+        verify_has(cache_a, muts_a[0]);
+        verify_has(cache_a, muts_a[1]);
+        BOOST_REQUIRE(tracker.over_quota(*table_a.schema()));
+        BOOST_REQUIRE(!tracker.over_quota(*table_b.schema()));
+        verify_has(cache_a, muts_a[2]);
+        BOOST_REQUIRE_EQUAL(tracker.table_partitions(*table_a.schema()), 3);
+        BOOST_REQUIRE_EQUAL(tracker.table_partitions(*table_b.schema()), 1);
+
+        // The partition of table_b is the least recently used, but table_a went over its quota.
+        evict_one_partition(tracker);
+        BOOST_REQUIRE_EQUAL(tracker.table_partitions(*table_a.schema()), 2);
+        auto misses = tracker.get_stats().partition_misses;
+        verify_has(cache_b, muts_b[0]);
+        verify_has(cache_a, muts_a[0]);
+        verify_has(cache_a, muts_a[1]);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().partition_misses, misses);
+    });
+}
+
+SEASTAR_TEST_CASE(test_hottest_keys) {
+    return seastar::async([] {
+        simple_schema table;
+        auto s = table.schema();
+        auto keys = table.make_pkeys(4);
+        auto muts = make_single_row_partitions(table, keys);
+        auto mt = make_lw_shared<memtable>(s);
+        for (auto&& m : muts) {
+            mt->apply(m);
+        }
+
+        cache_tracker tracker;
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j <= i; ++j) {
+                verify_has(cache, muts[(i + 2) % 4]);
+            }
+        }
+
+        auto hottest = cache.hottest_keys(3);
+        BOOST_REQUIRE_EQUAL(hottest.size(), 3);
+        BOOST_REQUIRE(hottest[0].equal(*s, keys[1]));
+        BOOST_REQUIRE(hottest[1].equal(*s, keys[0]));
+        BOOST_REQUIRE(hottest[2].equal(*s, keys[3]));
+
+        BOOST_REQUIRE_EQUAL(cache.hottest_keys(10).size(), 4);
+
+        auto saved = db::deserialize_saved_keys(db::serialize_saved_keys(hottest));
+        BOOST_REQUIRE_EQUAL(saved.size(), 3);
+        for (unsigned i = 0; i < saved.size(); ++i) {
+            BOOST_REQUIRE(saved[i].equal(*s, hottest[i].key()));
+        }
+        auto corrupted = db::serialize_saved_keys(hottest);
+        corrupted[corrupted.size() / 2] ^= 1;
+        BOOST_REQUIRE_THROW(db::deserialize_saved_keys(corrupted), std::runtime_error);
+    });
+}
+
 SEASTAR_TEST_CASE(test_update_invalidating) {
     return seastar::async([] {
         simple_schema s;
@@ -1958,6 +2118,45 @@ SEASTAR_TEST_CASE(test_cache_populates_partition_tombstone) {
     });
 }
 
+SEASTAR_TEST_CASE(test_cache_population_drops_shadowed_data) {
+    return seastar::async([] {
+        simple_schema s;
+        auto pk = s.make_pkey(0);
+
+        mutation m(s.schema(), pk);
+        s.add_row(m, s.make_ckey(1), "v1");
+        s.add_row(m, s.make_ckey(3), "v3");
+        s.delete_range(m, query::clustering_range::make(s.make_ckey(0), s.make_ckey(2)));
+
+        auto mt = make_lw_shared<memtable>(s.schema());
+        mt->apply(m);
+
+        cache_tracker tracker;
+        tracker.set_compact_on_population(true);
+        row_cache cache(s.schema(), snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+
+        auto prange = dht::partition_range::make_singular(pk);
+        assert_that(cache.make_reader(s.schema(), prange))
+            .produces(m)
+            .produces_end_of_stream();
+
+        // The cached copy lost the shadowed cell, but reads the same.
+        auto rd = cache.make_reader(s.schema(), prange);
+        auto cached = read_mutation_from_flat_mutation_reader(rd, db::no_timeout).get0();
+        BOOST_REQUIRE(cached);
+        auto row = cached->partition().find_row(*s.schema(), s.make_ckey(1));
+        BOOST_REQUIRE(!row || row->empty());
+        BOOST_REQUIRE(cached->partition().find_row(*s.schema(), s.make_ckey(3)));
+        BOOST_REQUIRE(!cached->partition().row_tombstones().empty());
+
+        auto query_time = gc_clock::now();
+        auto expected = m;
+        expected.partition().compact_for_compaction(*s.schema(), always_gc, query_time);
+        cached->partition().compact_for_compaction(*s.schema(), always_gc, query_time);
+        assert_that(*cached).is_equal_to(expected);
+    });
+}
+
 // Tests the case of cache reader having to reconcile a range tombstone
 // from the underlying mutation source which overlaps with previously emitted
 // tombstones.
@@ -3628,3 +3827,90 @@ SEASTAR_TEST_CASE(test_reading_progress_with_small_buffer_and_invalidation) {
         assert_that(result).is_equal_to(m1);
     });
 }
+
+SEASTAR_TEST_CASE(test_compressed_tier) {
+    return seastar::async([] {
+        simple_schema s;
+        cache_tracker tracker;
+        tracker.set_compressed_tier_size(1024 * 1024);
+        auto& tier = tracker.compressed_tier();
+        memtable_snapshot_source underlying(s.schema());
+        row_cache cache(s.schema(), snapshot_source([&] { return underlying(); }), tracker);
+
+        auto pkeys = s.make_pkeys(3);
+        std::vector<mutation> muts;
+        for (auto&& pk : pkeys) {
+            auto m = s.new_mutation(pk);
+            s.add_row(m, s.make_ckey(1), "v1");
+            s.add_row(m, s.make_ckey(2), "v2");
+            muts.push_back(m);
+        }
+
+        tier.insert(s.schema(), muts[0].decorated_key(), muts[0].partition());
+        BOOST_REQUIRE(tier.contains(*s.schema(), muts[0].decorated_key()));
+        BOOST_REQUIRE(tier.has_entries(*s.schema()));
+        BOOST_REQUIRE_GT(tier.memory_used(), 0);
+
+        auto taken = tier.take(s.schema(), muts[0].decorated_key());
+        BOOST_REQUIRE(taken);
+        assert_that(*taken).is_equal_to(muts[0]);
+        BOOST_REQUIRE(!tier.contains(*s.schema(), muts[0].decorated_key()));
+        BOOST_REQUIRE(!tier.take(s.schema(), muts[0].decorated_key()));
+
+        for (auto&& m : muts) {
+            tier.insert(s.schema(), m.decorated_key(), m.partition());
+        }
+        tier.invalidate(*s.schema(), muts[1].decorated_key());
+        BOOST_REQUIRE(!tier.contains(*s.schema(), muts[1].decorated_key()));
+
+        // Insertions are dropped while an update is in progress.
+        tier.pause_insertions(*s.schema());
+        tier.insert(s.schema(), muts[1].decorated_key(), muts[1].partition());
+        BOOST_REQUIRE(!tier.contains(*s.schema(), muts[1].decorated_key()));
+        tier.resume_insertions(*s.schema());
+
+        // A single-partition read is served from the tier and moves the partition back into cache.
+        underlying.apply(muts[0]);
+        underlying.apply(muts[1]);
+        underlying.apply(muts[2]);
+        auto hits = tier.get_stats().hits;
+        assert_that(cache.make_reader(s.schema(), dht::partition_range::make_singular(muts[2].decorated_key())))
+            .produces(muts[2])
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(tier.get_stats().hits, hits + 1);
+        BOOST_REQUIRE(!tier.contains(*s.schema(), muts[2].decorated_key()));
+
+        // Writes to the partition drop its compressed copy.
+        tier.insert(s.schema(), muts[0].decorated_key(), muts[0].partition());
+        auto m2 = s.new_mutation(pkeys[0]);
+        s.add_row(m2, s.make_ckey(3), "v3");
+        apply(cache, underlying, m2);
+        BOOST_REQUIRE(!tier.contains(*s.schema(), muts[0].decorated_key()));
+        assert_that(cache.make_reader(s.schema(), dht::partition_range::make_singular(muts[0].decorated_key())))
+            .produces(muts[0] + m2)
+            .produces_end_of_stream();
+
+        cache.invalidate([] {}).get();
+        BOOST_REQUIRE(!tier.has_entries(*s.schema()));
+
+        // Demotion moves complete partitions out of the cache into the tier.
+        std::vector<mutation> unchanged{muts[1], muts[2]};
+        for (auto&& m : unchanged) {
+            cache.populate(m);
+        }
+        BOOST_REQUIRE_EQUAL(tracker.partitions(), unchanged.size());
+        while (tracker.partitions()) {
+            tracker.demote_cold_partitions(unchanged.size());
+            seastar::thread::yield();
+        }
+        for (auto&& m : unchanged) {
+            BOOST_REQUIRE(tier.contains(*s.schema(), m.decorated_key()));
+        }
+        for (auto&& m : unchanged) {
+            assert_that(cache.make_reader(s.schema(), dht::partition_range::make_singular(m.decorated_key())))
+                .produces(m)
+                .produces_end_of_stream();
+        }
+        BOOST_REQUIRE(!tier.has_entries(*s.schema()));
+    });
+}
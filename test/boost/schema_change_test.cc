@@ -533,6 +533,42 @@ SEASTAR_TEST_CASE(test_notifications) {
     });
 }
 
+SEASTAR_TEST_CASE(test_merge_of_keyspace_with_many_tables) {
+    return do_with_cql_env([](cql_test_env& e) {
+        return seastar::async([&] {
+            counting_migration_listener listener;
+            e.local_mnotifier().register_listener(&listener);
+            auto listener_lease = defer([&e, &listener] { e.local_mnotifier().unregister_listener(&listener).get(); });
+
+            e.execute_cql("create keyspace tests with replication = { 'class' : 'SimpleStrategy', 'replication_factor' : 1 };").get();
+            for (int i = 0; i < 10; ++i) {
+                e.execute_cql(format("create table tests.table{} (pk int primary key, v int);", i)).get();
+            }
+            e.execute_cql("create materialized view tests.view0 as select * from tests.table0 "
+                    "where v is not null and pk is not null primary key (v, pk);").get();
+            BOOST_REQUIRE_EQUAL(listener.create_column_family_count, 10);
+            BOOST_REQUIRE_EQUAL(listener.create_view_count, 1);
+
+            auto untouched = e.db().local().find_schema("tests", "table5")->version();
+            e.execute_cql("alter table tests.table1 add v2 int;").get();
+            BOOST_REQUIRE_EQUAL(listener.update_column_family_count, 1);
+            BOOST_REQUIRE_EQUAL(e.db().local().find_schema("tests", "table5")->version(), untouched);
+
+            e.execute_cql("alter table tests.table0 add v2 int;").get();
+            BOOST_REQUIRE_EQUAL(listener.update_column_family_count, 2);
+            BOOST_REQUIRE(e.db().local().find_schema("tests", "view0")->get_column_definition(to_bytes("v2")));
+
+            e.execute_cql("drop table tests.table9;").get();
+            BOOST_REQUIRE_EQUAL(listener.drop_column_family_count, 1);
+
+            e.execute_cql("drop keyspace tests;").get();
+            BOOST_REQUIRE_EQUAL(listener.drop_view_count, 1);
+            BOOST_REQUIRE_EQUAL(listener.drop_column_family_count, 10);
+            BOOST_REQUIRE_EQUAL(listener.drop_keyspace_count, 1);
+        });
+    });
+}
+
 SEASTAR_TEST_CASE(test_drop_user_type_in_use) {
     return do_with_cql_env_thread([](cql_test_env& e) {
         e.execute_cql("create type simple_type (user_number int);").get();
@@ -1241,3 +1241,123 @@ SEASTAR_TEST_CASE(test_filtering_indexed_column) {
         });
     });
 }
+
+SEASTAR_TEST_CASE(test_secondary_index_intersection) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table t (p int, c int, v1 int, v2 int, primary key(p, c))").get();
+        e.execute_cql("create index on t(v1)").get();
+        e.execute_cql("create index local_t_v2 on t((p),v2)").get();
+        e.execute_cql("create index on t(v2)").get();
+        for (int p = 0; p < 10; ++p) {
+            for (int c = 0; c < 10; ++c) {
+                e.execute_cql(format("insert into t (p,c,v1,v2) values ({},{},{},{})", p, c, c % 2, c % 3)).get();
+            }
+        }
+
+        auto& stats = e.local_qp().get_cql_stats();
+        eventually([&] {
+            auto pruned = stats.secondary_index_keys_pruned;
+            auto res = e.execute_cql("select p, c from t where v1 = 1 and v2 = 0 allow filtering").get0();
+            std::vector<std::vector<bytes_opt>> expected;
+            for (int p = 0; p < 10; ++p) {
+                for (int c : {3, 9}) {
+                    expected.push_back({int32_type->decompose(p), int32_type->decompose(c)});
+                }
+            }
+            assert_that(res).is_rows().with_rows_ignore_order(expected);
+            BOOST_REQUIRE_GT(stats.secondary_index_keys_pruned, pruned);
+        });
+
+        // With the base partition restricted, the local index is intersected
+        eventually([&] {
+            auto pruned = stats.secondary_index_keys_pruned;
+            auto res = e.execute_cql("select c from t where p = 4 and v1 = 0 and v2 = 2 allow filtering").get0();
+            assert_that(res).is_rows().with_rows_ignore_order({
+                {int32_type->decompose(2)},
+                {int32_type->decompose(8)},
+            });
+            BOOST_REQUIRE_GT(stats.secondary_index_keys_pruned, pruned);
+        });
+
+        // Paging must not lose rows of pages whose keys were pruned
+        eventually([&] {
+            auto qo = std::make_unique<cql3::query_options>(db::consistency_level::LOCAL_ONE, infinite_timeout_config, std::vector<cql3::raw_value>{},
+                    cql3::query_options::specific_options{3, nullptr, {}, api::new_timestamp()});
+            auto res = e.execute_cql("select p, c from t where v1 = 1 and v2 = 0 allow filtering", std::move(qo)).get0();
+            size_t rows = 0;
+            while (true) {
+                auto rows_msg = dynamic_pointer_cast<cql_transport::messages::result_message::rows>(res);
+                rows += rows_msg->rs().result_set().size();
+                if (!rows_msg->rs().get_metadata().flags().contains(cql3::metadata::flag::HAS_MORE_PAGES)) {
+                    break;
+                }
+                auto paging_state = make_lw_shared<service::pager::paging_state>(*rows_msg->rs().get_metadata().paging_state());
+                qo = std::make_unique<cql3::query_options>(db::consistency_level::LOCAL_ONE, infinite_timeout_config, std::vector<cql3::raw_value>{},
+                        cql3::query_options::specific_options{3, paging_state, {}, api::new_timestamp()});
+                res = e.execute_cql("select p, c from t where v1 = 1 and v2 = 0 allow filtering", std::move(qo)).get0();
+            }
+            BOOST_REQUIRE_EQUAL(rows, 20);
+        });
+    });
+}
+
+SEASTAR_TEST_CASE(test_covering_secondary_index) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table t (p int, c int, v int, a int, b int, primary key(p, c))").get();
+        e.execute_cql("create index on t(v) include (a)").get();
+        e.execute_cql("create index local_t_v on t((p),v) include (a, b)").get();
+        for (int p = 0; p < 3; ++p) {
+            for (int c = 0; c < 3; ++c) {
+                e.execute_cql(format("insert into t (p,c,v,a,b) values ({},{},{},{},{})", p, c, c, p * 10 + c, p * 100 + c)).get();
+            }
+        }
+
+        auto& stats = e.local_qp().get_cql_stats();
+        eventually([&] {
+            auto covered = stats.secondary_index_covered_reads;
+            auto res = e.execute_cql("select p, a from t where v = 1").get0();
+            assert_that(res).is_rows().with_rows_ignore_order({
+                {int32_type->decompose(0), int32_type->decompose(1)},
+                {int32_type->decompose(1), int32_type->decompose(11)},
+                {int32_type->decompose(2), int32_type->decompose(21)},
+            });
+            BOOST_REQUIRE_EQUAL(stats.secondary_index_covered_reads, covered + 1);
+        });
+
+        eventually([&] {
+            auto covered = stats.secondary_index_covered_reads;
+            auto res = e.execute_cql("select b from t where p = 2 and v = 2").get0();
+            assert_that(res).is_rows().with_rows({{int32_type->decompose(202)}});
+            BOOST_REQUIRE_EQUAL(stats.secondary_index_covered_reads, covered + 1);
+        });
+
+        // b is not included in the global index, so the base table is read
+        eventually([&] {
+            auto covered = stats.secondary_index_covered_reads;
+            auto res = e.execute_cql("select a, b from t where v = 0").get0();
+            assert_that(res).is_rows().with_rows_ignore_order({
+                {int32_type->decompose(0), int32_type->decompose(0)},
+                {int32_type->decompose(10), int32_type->decompose(100)},
+                {int32_type->decompose(20), int32_type->decompose(200)},
+            });
+            BOOST_REQUIRE_EQUAL(stats.secondary_index_covered_reads, covered);
+        });
+
+        // Updates of included columns reach the index view
+        e.execute_cql("update t set a = 42 where p = 1 and c = 1").get();
+        eventually([&] {
+            auto res = e.execute_cql("select a from t where v = 1 and p = 1").get0();
+            assert_that(res).is_rows().with_rows({{int32_type->decompose(42)}});
+        });
+
+        BOOST_REQUIRE_THROW(e.execute_cql("alter table t drop a").get(), exceptions::invalid_request_exception);
+        BOOST_REQUIRE_THROW(e.execute_cql("create index on t(b) include (c)").get(), exceptions::invalid_request_exception);
+        BOOST_REQUIRE_THROW(e.execute_cql("create index on t(b) include (b)").get(), exceptions::invalid_request_exception);
+        BOOST_REQUIRE_THROW(e.execute_cql("create index on t(b) include (a, a)").get(), exceptions::invalid_request_exception);
+        BOOST_REQUIRE_THROW(e.execute_cql("create index on t(b) include (x)").get(), exceptions::invalid_request_exception);
+
+        // INCLUDE is not a reserved keyword
+        e.execute_cql("create table t2 (p int primary key, include int)").get();
+        e.execute_cql("create index on t2(include)").get();
+    });
+}
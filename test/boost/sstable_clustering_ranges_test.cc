@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/seastar.hh>
+
+#include "sstables/clustering_ranges.hh"
+#include "sstables/sstables.hh"
+#include "sstables/writer.hh"
+#include "partition_slice_builder.hh"
+#include "test/lib/tmpdir.hh"
+#include "test/lib/simple_schema.hh"
+#include "test/lib/sstable_test_env.hh"
+#include "test/lib/sstable_utils.hh"
+#include "test/lib/test_services.hh"
+#include "test/lib/flat_mutation_reader_assertions.hh"
+
+using namespace sstables;
+
+SEASTAR_THREAD_TEST_CASE(test_clustering_ranges_lookup) {
+    simple_schema ss;
+    auto s = ss.schema();
+    tmpdir tmp;
+    auto path = (tmp.path() / "ClusteringRanges.db").string();
+
+    // Enough partitions to have several samples, every third one without rows.
+    const uint64_t n = 3 * clustering_ranges::sample_interval + 5;
+    std::vector<clustering_ranges::partition_info> infos;
+    {
+        auto f = open_file_dma(path, open_flags::create | open_flags::wo | open_flags::truncate).get0();
+        file_writer out(std::move(f), file_output_stream_options());
+        clustering_ranges::writer w(out);
+        for (uint64_t i = 0; i < n; ++i) {
+            clustering_ranges::partition_info info;
+            if (i % 3) {
+                info.add_clustered(*s, position_in_partition_view::for_key(ss.make_ckey(i)), position_in_partition_view::for_key(ss.make_ckey(i)));
+                info.add_clustered(*s, position_in_partition_view::for_key(ss.make_ckey(i + 10)), position_in_partition_view::for_key(ss.make_ckey(i + 10)));
+            }
+            w.add(i * 100, info);
+            infos.push_back(std::move(info));
+        }
+        w.finish();
+        out.close();
+    }
+
+    auto f = open_file_dma(path, open_flags::ro).get0();
+    auto summary = clustering_ranges::read_summary(f, f.size().get0(), default_priority_class()).get0();
+    BOOST_REQUIRE_EQUAL(summary.data_positions.size(), 4);
+    position_in_partition::equal_compare eq(*s);
+    for (uint64_t i = 0; i < n; ++i) {
+        auto info = clustering_ranges::lookup(f, summary, i * 100, default_priority_class()).get0();
+        BOOST_REQUIRE(info);
+        BOOST_REQUIRE_EQUAL(info->flags, infos[i].flags);
+        BOOST_REQUIRE_EQUAL(bool(info->first), bool(infos[i].first));
+        if (info->first) {
+            BOOST_REQUIRE(eq(*info->first, *infos[i].first));
+            BOOST_REQUIRE(eq(*info->last, *infos[i].last));
+        }
+        BOOST_REQUIRE(!clustering_ranges::lookup(f, summary, i * 100 + 1, default_priority_class()).get0());
+    }
+    f.close().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_clustering_ranges_excludes) {
+    simple_schema ss;
+    auto s = ss.schema();
+    clustering_ranges::partition_info info;
+    BOOST_REQUIRE(info.excludes(*s, {ss.make_ckey_range(1, 2)}));
+
+    info.add_clustered(*s, position_in_partition_view::for_key(ss.make_ckey(3)), position_in_partition_view::for_key(ss.make_ckey(3)));
+    auto rt = ss.make_range_tombstone(ss.make_ckey_range(5, 7));
+    info.add_clustered(*s, rt.position(), rt.end_position());
+    BOOST_REQUIRE(info.excludes(*s, {ss.make_ckey_range(1, 2)}));
+    BOOST_REQUIRE(info.excludes(*s, {ss.make_ckey_range(8, 9)}));
+    BOOST_REQUIRE(!info.excludes(*s, {ss.make_ckey_range(2, 3)}));
+    BOOST_REQUIRE(!info.excludes(*s, {ss.make_ckey_range(7, 9)}));
+    BOOST_REQUIRE(!info.excludes(*s, {ss.make_ckey_range(1, 2), ss.make_ckey_range(4, 4)}));
+    BOOST_REQUIRE(!info.excludes(*s, {query::clustering_range::make_open_ended_both_sides()}));
+
+    info.flags |= clustering_ranges::partition_info::has_static_row;
+    BOOST_REQUIRE(!info.excludes(*s, {ss.make_ckey_range(1, 2)}));
+}
+
+SEASTAR_TEST_CASE(test_clustering_ranges_skip_data_file) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        tmpdir tmp;
+        auto sst_gen = [&env, s, &tmp] () {
+            return env.make_sstable(s, tmp.path().string(), 1, sstable_version_types::mc, sstable_format_types::big);
+        };
+
+        std::vector<mutation> muts;
+        for (auto& pk : ss.make_pkeys(4)) {
+            mutation m(s, pk);
+            for (uint32_t ck = 0; ck < 10; ++ck) {
+                ss.add_row(m, ss.make_ckey(ck), "v");
+            }
+            muts.push_back(std::move(m));
+        }
+        ss.delete_range(muts[1], ss.make_ckey_range(20, 25));
+        ss.add_static_row(muts[2], "s");
+        muts[3].partition().apply(ss.new_tombstone());
+        auto sst = make_sstable_containing(sst_gen, muts);
+        BOOST_REQUIRE(sst->has_component(component_type::ClusteringRanges));
+
+        auto& stats = sstables_stats::get_shard_stats();
+        auto check = [&] (const mutation& m, query::clustering_range range, bool skipped) {
+            auto skips = stats.clustering_ranges_partition_skips;
+            auto slice = partition_slice_builder(*s).with_range(range).build();
+            assert_that(sst->read_row_flat(s, no_reader_permit(), m.decorated_key(), slice))
+                .produces(m, query::clustering_row_ranges{range})
+                .produces_end_of_stream();
+            BOOST_REQUIRE_EQUAL(stats.clustering_ranges_partition_skips, skips + skipped);
+        };
+        check(muts[0], ss.make_ckey_range(20, 30), true);
+        check(muts[0], ss.make_ckey_range(5, 30), false);
+        // Covered by the range tombstone.
+        check(muts[1], ss.make_ckey_range(20, 30), false);
+        check(muts[1], ss.make_ckey_range(26, 30), true);
+        // The static row or the partition tombstone has to be read.
+        check(muts[2], ss.make_ckey_range(20, 30), false);
+        check(muts[3], ss.make_ckey_range(20, 30), false);
+    });
+}
@@ -19,6 +19,7 @@
  * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <fstream>
 #include <seastar/core/sstring.hh>
 #include <seastar/core/future-util.hh>
 #include <seastar/core/align.hh>
@@ -59,14 +60,17 @@
 #include "mutation_compactor.hh"
 #include "service/priority_manager.hh"
 #include "db/config.hh"
+#include "utils/xor_filter.hh"
 
 #include <stdio.h>
 #include <ftw.h>
 #include <unistd.h>
 #include <boost/range/algorithm/find_if.hpp>
+#include <boost/range/algorithm/remove_if.hpp>
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <boost/algorithm/cxx11/is_sorted.hpp>
 #include <boost/icl/interval_map.hpp>
+#include <boost/range/adaptor/filtered.hpp>
 #include "test/lib/test_services.hh"
 #include "test/lib/cql_test_env.hh"
 
@@ -1976,6 +1980,113 @@ SEASTAR_TEST_CASE(leveled_04) {
     return make_ready_future<>();
 }
 
+SEASTAR_TEST_CASE(leveled_concurrent_compactions) {
+    test_env env;
+    column_family_for_tests cf;
+
+    auto key_and_token_pair = token_generation_for_current_shard(50);
+    auto key = [&] (int i) { return key_and_token_pair[i].first; };
+
+    auto max_sstable_size_in_mb = 1;
+    auto max_sstable_size_in_bytes = max_sstable_size_in_mb*1024*1024;
+    auto max_bytes_for_l1 = leveled_manifest::max_bytes_for_level(1, max_sstable_size_in_bytes);
+
+    // Level 1 is over its target size, level 2 isn't.
+    add_sstable_for_leveled_test(env, cf, /*gen*/1, /*data_size*/max_bytes_for_l1, /*level*/1, key(0), key(15));
+    add_sstable_for_leveled_test(env, cf, /*gen*/2, /*data_size*/max_bytes_for_l1, /*level*/1, key(16), key(32));
+    add_sstable_for_leveled_test(env, cf, /*gen*/3, /*data_size*/max_bytes_for_l1, /*level*/1, key(33), key(49));
+    add_sstable_for_leveled_test(env, cf, /*gen*/4, /*data_size*/max_sstable_size_in_bytes, /*level*/2, key(0), key(15));
+    add_sstable_for_leveled_test(env, cf, /*gen*/5, /*data_size*/max_sstable_size_in_bytes, /*level*/2, key(16), key(49));
+
+    sstables::size_tiered_compaction_strategy_options stcs_options;
+    std::vector<std::optional<dht::decorated_key>> last_compacted_keys(leveled_manifest::MAX_LEVELS);
+    std::vector<int> compaction_counter(leveled_manifest::MAX_LEVELS);
+    auto generations = [] (const std::vector<shared_sstable>& ssts) {
+        return boost::copy_range<std::set<int64_t>>(ssts | boost::adaptors::transformed(std::mem_fn(&sstable::generation)));
+    };
+
+    auto all = get_candidates_for_leveled_strategy(*cf);
+    {
+        auto manifest = leveled_manifest::create(*cf, all, max_sstable_size_in_mb, stcs_options);
+        auto candidate = manifest.get_compaction_candidates(last_compacted_keys, compaction_counter);
+        BOOST_REQUIRE_EQUAL(candidate.level, 2);
+        BOOST_REQUIRE(generations(candidate.sstables) == std::set<int64_t>({1, 4}));
+    }
+
+    // While sstable 4 is compacted into level 3, compacting sstable 1 into level 2 would
+    // write to the range being rewritten, so the next sstable of level 1 is picked instead.
+    {
+        auto ongoing = std::vector<shared_sstable>{get_sstable(cf, 4)};
+        auto candidates = boost::copy_range<std::vector<shared_sstable>>(all | boost::adaptors::filtered([] (const shared_sstable& sst) {
+            return sst->generation() != 4;
+        }));
+        auto manifest = leveled_manifest::create(*cf, candidates, max_sstable_size_in_mb, stcs_options);
+        manifest.set_ongoing_compactions({leveled_manifest::footprint_of(ongoing, 3)});
+        auto candidate = manifest.get_compaction_candidates(last_compacted_keys, compaction_counter);
+        BOOST_REQUIRE_EQUAL(candidate.level, 2);
+        BOOST_REQUIRE(generations(candidate.sstables) == std::set<int64_t>({2, 5}));
+    }
+
+    // A compaction covering the whole of levels 1 and 2 leaves nothing to run in parallel.
+    {
+        auto manifest = leveled_manifest::create(*cf, all, max_sstable_size_in_mb, stcs_options);
+        manifest.set_ongoing_compactions({leveled_manifest::footprint_of(all, 2)});
+        auto candidate = manifest.get_compaction_candidates(last_compacted_keys, compaction_counter);
+        BOOST_REQUIRE(candidate.sstables.empty());
+    }
+
+    return make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(leveled_concurrent_compactions_stcs_in_l0) {
+    test_env env;
+    column_family_for_tests cf;
+
+    auto key_and_token_pair = token_generation_for_current_shard(50);
+    auto min_key = key_and_token_pair[0].first;
+    auto max_key = key_and_token_pair[key_and_token_pair.size()-1].first;
+
+    auto max_sstable_size_in_mb = 1;
+    auto max_sstable_size_in_bytes = max_sstable_size_in_mb*1024*1024;
+    sstables::size_tiered_compaction_strategy_options stcs_options;
+    std::vector<std::optional<dht::decorated_key>> last_compacted_keys(leveled_manifest::MAX_LEVELS);
+    std::vector<int> compaction_counter(leveled_manifest::MAX_LEVELS);
+
+    // An L0 to L1 compaction of the whole token range is running.
+    auto ongoing = std::vector<shared_sstable>{sstable_for_overlapping_test(env, cf->schema(), 1000, min_key, max_key, 1)};
+    auto footprints = std::vector<leveled_manifest::compaction_footprint>{leveled_manifest::footprint_of(ongoing, 1)};
+
+    int64_t gen = 1;
+    for (; gen <= 4; gen++) {
+        add_sstable_for_leveled_test(env, cf, gen, max_sstable_size_in_bytes, /*level*/0, min_key, max_key);
+    }
+    {
+        // Promoting L0 would conflict, and L0 is not far enough behind to size-tier it.
+        auto candidates = get_candidates_for_leveled_strategy(*cf);
+        auto manifest = leveled_manifest::create(*cf, candidates, max_sstable_size_in_mb, stcs_options);
+        manifest.set_ongoing_compactions(footprints);
+        auto candidate = manifest.get_compaction_candidates(last_compacted_keys, compaction_counter);
+        BOOST_REQUIRE(candidate.sstables.empty());
+    }
+
+    for (; gen <= leveled_manifest::MAX_COMPACTING_L0 + 1; gen++) {
+        add_sstable_for_leveled_test(env, cf, gen, max_sstable_size_in_bytes, /*level*/0, min_key, max_key);
+    }
+    {
+        auto candidates = get_candidates_for_leveled_strategy(*cf);
+        auto manifest = leveled_manifest::create(*cf, candidates, max_sstable_size_in_mb, stcs_options);
+        manifest.set_ongoing_compactions(footprints);
+        auto candidate = manifest.get_compaction_candidates(last_compacted_keys, compaction_counter);
+        BOOST_REQUIRE(!candidate.sstables.empty());
+        BOOST_REQUIRE_EQUAL(candidate.level, 0);
+        for (auto& sst : candidate.sstables) {
+            BOOST_REQUIRE_EQUAL(sst->get_sstable_level(), 0);
+        }
+    }
+
+    return make_ready_future<>();
+}
+
 SEASTAR_TEST_CASE(leveled_05) {
     // NOTE: Generations from 48 to 51 are used here.
     return test_setup::do_with_tmp_directory([] (test_env& env, sstring tmpdir_path) {
@@ -2410,6 +2521,106 @@ SEASTAR_TEST_CASE(tombstone_purge_test) {
     });
 }
 
+SEASTAR_TEST_CASE(repair_based_tombstone_purge_test) {
+    BOOST_REQUIRE(smp::count == 1);
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+
+        // With the default gc_grace_seconds, a tombstone is purged only once the
+        // range holding it was repaired after it was written.
+        auto s = schema_builder("tests", "repair_based_tombstone_purge")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type)
+                .set_compaction_strategy_options({{"tombstone_gc", "repair"}})
+                .build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, la, big);
+        };
+
+        column_family_for_tests cf(s);
+        auto now = gc_clock::now();
+        auto delay = cf->tombstone_gc_propagation_delay();
+        BOOST_REQUIRE(delay > gc_clock::duration::zero());
+
+        auto alpha = partition_key::from_exploded(*s, {to_bytes("alpha")});
+        mutation m(s, alpha);
+        m.partition().apply(tombstone(api::new_timestamp(), now - delay - std::chrono::hours(1)));
+        auto token = m.decorated_key().token();
+
+        auto compact = [&] {
+            auto sst = make_sstable_containing(sst_gen, {m});
+            return compact_sstables(sstables::compaction_descriptor({ sst }), *cf, sst_gen).get0().new_sstables;
+        };
+
+        BOOST_REQUIRE(cf->get_gc_before(token, now) == now - s->gc_grace_seconds());
+        BOOST_REQUIRE_EQUAL(compact().size(), 1);
+
+        // A repair started before the deletion doesn't allow purging it.
+        auto range = dht::token_range::make(dht::minimum_token(), token);
+        cf->record_repair({range}, now - std::chrono::hours(2));
+        BOOST_REQUIRE(cf->get_gc_before(token, now) == now - std::chrono::hours(2) - delay);
+        BOOST_REQUIRE_EQUAL(compact().size(), 1);
+
+        cf->record_repair({range}, now);
+        BOOST_REQUIRE(cf->get_gc_before(token, now) == now - delay);
+        BOOST_REQUIRE(compact().empty());
+
+        // Tokens and ranges which weren't all repaired fall back to gc_grace_seconds.
+        auto after = dht::token::from_int64(dht::token::to_int64(token) + 1);
+        BOOST_REQUIRE(cf->get_gc_before(after, now) == now - s->gc_grace_seconds());
+        BOOST_REQUIRE(cf->get_gc_before(dht::token_range::make(token, after), now) == now - s->gc_grace_seconds());
+        cf->record_repair({dht::token_range::make_starting_with(dht::token_range::bound(after))}, now - std::chrono::hours(3));
+        BOOST_REQUIRE(cf->get_gc_before(dht::token_range::make(token, after), now) == now - std::chrono::hours(3) - delay);
+
+        BOOST_REQUIRE_THROW(sstables::make_compaction_strategy(sstables::compaction_strategy_type::size_tiered, {{"tombstone_gc", "never"}}),
+                exceptions::configuration_exception);
+    });
+}
+
+SEASTAR_TEST_CASE(repair_based_tombstone_purge_of_concurrent_deletion_test) {
+    BOOST_REQUIRE(smp::count == 1);
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+
+        auto s = schema_builder("tests", "repair_based_tombstone_purge_of_concurrent_deletion")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type)
+                .set_compaction_strategy_options({{"tombstone_gc", "repair"}})
+                .build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, la, big);
+        };
+
+        column_family_for_tests cf(s);
+        auto repair_time = gc_clock::now();
+        auto delay = cf->tombstone_gc_propagation_delay();
+
+        // The deletion was issued just before the repair started, but reached
+        // this replica only after the repair read it, so the repair didn't sync it.
+        auto alpha = partition_key::from_exploded(*s, {to_bytes("alpha")});
+        mutation m(s, alpha);
+        m.partition().apply(tombstone(api::new_timestamp(), repair_time - std::chrono::seconds(1)));
+        auto token = m.decorated_key().token();
+
+        auto compact = [&] {
+            auto sst = make_sstable_containing(sst_gen, {m});
+            return compact_sstables(sstables::compaction_descriptor({ sst }), *cf, sst_gen).get0().new_sstables;
+        };
+
+        cf->record_repair({dht::token_range::make_open_ended_both_sides()}, repair_time);
+        BOOST_REQUIRE_EQUAL(compact().size(), 1);
+
+        // A repair starting once the deletion had time to propagate covers it.
+        cf->record_repair({dht::token_range::make_open_ended_both_sides()}, repair_time + delay);
+        BOOST_REQUIRE(cf->get_gc_before(token, repair_time) == repair_time);
+        BOOST_REQUIRE(compact().empty());
+    });
+}
+
 SEASTAR_TEST_CASE(check_multi_schema) {
     // Schema used to write sstable:
     // CREATE TABLE multi_schema_test (
@@ -2940,6 +3151,69 @@ SEASTAR_TEST_CASE(get_fully_expired_sstables_test) {
     return make_ready_future<>();
 }
 
+SEASTAR_TEST_CASE(uniform_ttl_drops_expired_sstables_test) {
+    test_env env;
+    auto key_and_token_pair = token_generation_for_current_shard(4);
+    auto min_key = key_and_token_pair[0].first;
+    auto max_key = key_and_token_pair[key_and_token_pair.size()-1].first;
+
+    // Expired an hour ago, well within the default gc_grace_seconds.
+    auto expired_at = (gc_clock::now() - std::chrono::hours(1)).time_since_epoch().count();
+    auto live = std::numeric_limits<int32_t>::max();
+
+    column_family_for_tests cf;
+    auto sst1 = add_sstable_for_overlapping_test(env, cf, /*gen*/1, min_key, key_and_token_pair[1].first, build_stats(1, 10, expired_at));
+    auto sst2 = add_sstable_for_overlapping_test(env, cf, /*gen*/2, min_key, max_key, build_stats(12, 13, live));
+    // Expired too, but newer than live data, which it may shadow.
+    auto sst3 = add_sstable_for_overlapping_test(env, cf, /*gen*/3, key_and_token_pair[2].first, max_key, build_stats(15, 16, expired_at));
+    std::vector<sstables::shared_sstable> candidates = { sst1, sst2, sst3 };
+
+    for (auto type : {sstables::compaction_strategy_type::size_tiered, sstables::compaction_strategy_type::incremental}) {
+        auto cs = sstables::make_compaction_strategy(type, {});
+        BOOST_REQUIRE(cs.get_sstables_for_compaction(*cf, candidates).sstables.empty());
+
+        cs = sstables::make_compaction_strategy(type, {{"uniform_ttl", "true"}});
+        auto descriptor = cs.get_sstables_for_compaction(*cf, candidates);
+        BOOST_REQUIRE_EQUAL(descriptor.sstables.size(), 1);
+        BOOST_REQUIRE(descriptor.sstables.front() == sst1);
+    }
+
+    return make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(repaired_and_unrepaired_sstables_are_not_compacted_together) {
+    test_env env;
+    auto key_and_token_pair = token_generation_for_current_shard(2);
+    auto min_key = key_and_token_pair[0].first;
+    auto max_key = key_and_token_pair[1].first;
+
+    column_family_for_tests cf;
+    std::vector<sstables::shared_sstable> candidates;
+    for (auto gen = 1; gen <= 8; gen++) {
+        stats_metadata stats = {};
+        stats.repaired_at = gen % 2 ? 0 : 1000;
+        candidates.push_back(add_sstable_for_overlapping_test(env, cf, gen, min_key, max_key, stats));
+    }
+    BOOST_REQUIRE(!candidates[0]->is_repaired());
+    BOOST_REQUIRE(candidates[1]->is_repaired());
+    BOOST_REQUIRE_EQUAL(candidates[1]->get_repaired_at(), 1000);
+
+    auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::size_tiered, {});
+    auto descriptor = cs.get_sstables_for_compaction(*cf, candidates);
+    BOOST_REQUIRE_EQUAL(descriptor.sstables.size(), 4);
+    BOOST_REQUIRE(boost::algorithm::all_of(descriptor.sstables, [] (const shared_sstable& sst) { return !sst->is_repaired(); }));
+
+    // Once the unrepaired set is too small to compact, the repaired one is picked.
+    candidates.erase(boost::remove_if(candidates, [] (const shared_sstable& sst) {
+        return !sst->is_repaired() && sst->generation() > 1;
+    }), candidates.end());
+    descriptor = cs.get_sstables_for_compaction(*cf, candidates);
+    BOOST_REQUIRE_EQUAL(descriptor.sstables.size(), 4);
+    BOOST_REQUIRE(boost::algorithm::all_of(descriptor.sstables, [] (const shared_sstable& sst) { return sst->is_repaired(); }));
+
+    return make_ready_future<>();
+}
+
 SEASTAR_TEST_CASE(compaction_with_fully_expired_table) {
     return test_env::do_with_async([] (test_env& env) {
         storage_service_for_tests ssft;
@@ -3236,6 +3510,21 @@ SEASTAR_TEST_CASE(time_window_strategy_correctness_test) {
     });
 }
 
+SEASTAR_TEST_CASE(test_compaction_strategy_cold_output) {
+    auto lcs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::leveled, {});
+    BOOST_REQUIRE(!lcs.is_cold_output(sstables::compaction_descriptor({}, 0)));
+    BOOST_REQUIRE(!lcs.is_cold_output(sstables::compaction_descriptor({}, 1)));
+    BOOST_REQUIRE(lcs.is_cold_output(sstables::compaction_descriptor({}, 2)));
+
+    auto stcs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::size_tiered, {});
+    BOOST_REQUIRE(!stcs.is_cold_output(sstables::compaction_descriptor({}, 2)));
+
+    // No window was seen yet, so no window is known to be old.
+    auto twcs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::time_window, {});
+    BOOST_REQUIRE(!twcs.is_cold_output(sstables::compaction_descriptor({})));
+    return make_ready_future<>();
+}
+
 SEASTAR_TEST_CASE(test_promoted_index_read) {
     // create table promoted_index_read (
     //        pk int,
@@ -4129,6 +4418,28 @@ SEASTAR_TEST_CASE(sstable_expired_data_ratio) {
             auto descriptor = cs.get_sstables_for_compaction(*cf, { sst });
             BOOST_REQUIRE(descriptor.sstables.size() == 0);
         }
+        sstables::test(sst).set_data_file_write_time(db_clock::time_point::min());
+        // tombstone compaction is available to every strategy which doesn't disable it
+        {
+            auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::incremental, options);
+            auto descriptor = cs.get_sstables_for_compaction(*cf, { sst });
+            BOOST_REQUIRE(descriptor.sstables.size() == 1);
+            BOOST_REQUIRE(descriptor.sstables.front() == sst);
+        }
+        // an overlapping sstable holding older data for most of its keys makes most tombstones not purgeable
+        column_family_test(cf).add_sstable(info.new_sstables.front());
+        {
+            auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::size_tiered, options);
+            auto descriptor = cs.get_sstables_for_compaction(*cf, { sst });
+            BOOST_REQUIRE(descriptor.sstables.size() == 0);
+
+            auto unchecked_options = options;
+            unchecked_options.emplace("unchecked_tombstone_compaction", "true");
+            cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::size_tiered, unchecked_options);
+            descriptor = cs.get_sstables_for_compaction(*cf, { sst });
+            BOOST_REQUIRE(descriptor.sstables.size() == 1);
+            BOOST_REQUIRE(descriptor.sstables.front() == sst);
+        }
     });
 }
 
@@ -5626,3 +5937,332 @@ SEASTAR_TEST_CASE(incremental_compaction_data_resurrection_test) {
         BOOST_REQUIRE(is_partition_dead(alpha));
     });
 }
+
+SEASTAR_TEST_CASE(incremental_compaction_strategy_picks_runs) {
+    test_env env;
+    column_family_for_tests cf;
+
+    auto key_and_token_pair = token_generation_for_current_shard(8);
+    auto fragment_size = 1024*1024;
+    int64_t gen = 1;
+
+    // Four runs of two fragments each, which form a tier, and a much larger
+    // run made of a single fragment, which doesn't take part in it.
+    std::vector<shared_sstable> candidates;
+    std::vector<shared_sstable> tier;
+    for (auto run = 0; run < 4; run++) {
+        auto run_identifier = utils::make_random_uuid();
+        for (auto frag = 0; frag < 2; frag++) {
+            auto sst = sstable_for_overlapping_test(env, cf->schema(), gen++,
+                    key_and_token_pair[frag * 4].first, key_and_token_pair[frag * 4 + 3].first);
+            sstables::test(sst).set_data_file_size(fragment_size);
+            sstables::test(sst).set_run_identifier(run_identifier);
+            candidates.push_back(sst);
+            tier.push_back(sst);
+        }
+    }
+    auto big = sstable_for_overlapping_test(env, cf->schema(), gen++, key_and_token_pair[0].first, key_and_token_pair[7].first);
+    sstables::test(big).set_data_file_size(uint64_t(fragment_size) * 100);
+    candidates.push_back(big);
+
+    std::map<sstring, sstring> options;
+    options.emplace("sstable_size_in_mb", "1");
+    auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::incremental, options);
+    BOOST_REQUIRE_EQUAL(cs.name(), "IncrementalCompactionStrategy");
+
+    auto descriptor = cs.get_sstables_for_compaction(*cf, candidates);
+    // The whole tier is compacted, whole runs at a time, into fragments
+    // of the configured size.
+    BOOST_REQUIRE_EQUAL(descriptor.max_sstable_bytes, fragment_size);
+    BOOST_REQUIRE(std::is_permutation(descriptor.sstables.begin(), descriptor.sstables.end(), tier.begin(), tier.end()));
+
+    descriptor = cs.get_major_compaction_job(*cf, candidates);
+    BOOST_REQUIRE_EQUAL(descriptor.max_sstable_bytes, fragment_size);
+    BOOST_REQUIRE_EQUAL(descriptor.sstables.size(), candidates.size());
+
+    BOOST_REQUIRE_THROW(sstables::make_compaction_strategy(sstables::compaction_strategy_type::incremental, {{"sstable_size_in_mb", "0"}}),
+            exceptions::configuration_exception);
+
+    return make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(compaction_in_parallel_subranges_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        auto s = schema_builder("tests", "compaction_in_parallel_subranges_test")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type).build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, la, big);
+        };
+
+        auto tokens = token_generation_for_current_shard(64);
+        std::vector<mutation> muts;
+        for (auto& t : tokens) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes(t.first)}));
+            m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), api::new_timestamp());
+            muts.push_back(std::move(m));
+        }
+        // Two overlapping sstables, each holding every other key.
+        std::vector<mutation> even, odd;
+        for (size_t i = 0; i < muts.size(); i++) {
+            (i % 2 ? odd : even).push_back(muts[i]);
+        }
+        std::vector<shared_sstable> input = {make_sstable_containing(sst_gen, even), make_sstable_containing(sst_gen, odd)};
+
+        column_family_for_tests cf(s);
+        for (auto& sst : input) {
+            column_family_test(cf).add_sstable(sst);
+        }
+
+        auto desc = sstables::compaction_descriptor(input);
+        desc.max_parallel_subranges = 4;
+        desc.min_subrange_bytes = 1;
+        unsigned replacements = 0;
+        auto replacer = [&] (sstables::compaction_completion_desc completion) {
+            replacements++;
+            BOOST_REQUIRE(std::is_permutation(completion.input_sstables.begin(), completion.input_sstables.end(), input.begin(), input.end()));
+        };
+        auto output = compact_sstables(std::move(desc), *cf, sst_gen, replacer).get0().new_sstables;
+
+        // The input is replaced once, by a run made of one fragment per non-empty sub-range.
+        BOOST_REQUIRE_EQUAL(replacements, 1);
+        BOOST_REQUIRE_GT(output.size(), 1);
+        BOOST_REQUIRE_LE(output.size(), 4);
+        std::sort(output.begin(), output.end(), [&s] (const shared_sstable& a, const shared_sstable& b) {
+            return a->get_first_decorated_key().tri_compare(*s, b->get_first_decorated_key()) < 0;
+        });
+        for (size_t i = 1; i < output.size(); i++) {
+            BOOST_REQUIRE_EQUAL(output[i]->run_identifier(), output[0]->run_identifier());
+            BOOST_REQUIRE(output[i - 1]->get_last_decorated_key().tri_compare(*s, output[i]->get_first_decorated_key()) < 0);
+        }
+
+        std::vector<flat_mutation_reader> readers;
+        for (auto& sst : output) {
+            readers.push_back(sstable_reader(sst, s));
+        }
+        auto assertions = assert_that(make_combined_reader(s, std::move(readers)));
+        for (auto& m : muts) {
+            assertions.produces(m);
+        }
+        assertions.produces_end_of_stream();
+    });
+}
+
+SEASTAR_TEST_CASE(digest_verification_on_full_read_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        for (auto compressed : {false, true}) {
+            auto builder = schema_builder("tests", "digest_verification_on_full_read_test")
+                    .with_column("id", utf8_type, column_kind::partition_key)
+                    .with_column("value", int32_type);
+            if (!compressed) {
+                builder.set_compressor_params(compression_parameters::no_compression());
+            }
+            auto s = builder.build();
+
+            auto tmp = tmpdir();
+            auto sst_gen = [&env, s, &tmp] () {
+                return env.make_sstable(s, tmp.path().string(), 1, sstable_version_types::mc, big);
+            };
+            std::vector<mutation> muts;
+            for (auto& t : token_generation_for_current_shard(16)) {
+                mutation m(s, partition_key::from_exploded(*s, {to_bytes(t.first)}));
+                m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), api::new_timestamp());
+                muts.push_back(std::move(m));
+            }
+            auto sst = make_sstable_containing(sst_gen, muts);
+
+            auto& stats = sstables_stats::get_shard_stats();
+            auto verifications = stats.digest_verifications;
+            auto mismatches = stats.digest_mismatches;
+            auto assertions = assert_that(sstable_reader(sst, s));
+            for (auto& m : muts) {
+                assertions.produces(m);
+            }
+            assertions.produces_end_of_stream();
+            BOOST_REQUIRE_EQUAL(stats.digest_verifications, verifications + 1);
+            BOOST_REQUIRE_EQUAL(stats.digest_mismatches, mismatches);
+            BOOST_REQUIRE(!sst->quarantined());
+
+            // Make Digest disagree with the data file.
+            auto digest_path = sst->filename(component_type::Digest);
+            uint32_t digest;
+            std::ifstream(digest_path) >> digest;
+            std::ofstream(digest_path, std::ios::trunc) << (digest + 1);
+
+            auto corrupted = env.reusable_sst(s, tmp.path().string(), 1, sstable_version_types::mc).get0();
+            auto rd = sstable_reader(corrupted, s);
+            BOOST_REQUIRE_THROW(rd.consume_pausable([] (mutation_fragment) { return stop_iteration::no; }, db::no_timeout).get(),
+                    malformed_sstable_exception);
+            BOOST_REQUIRE_EQUAL(stats.digest_verifications, verifications + 2);
+            BOOST_REQUIRE_EQUAL(stats.digest_mismatches, mismatches + 1);
+            BOOST_REQUIRE(corrupted->quarantined());
+        }
+    });
+}
+
+SEASTAR_TEST_CASE(deferred_filter_loading_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp] () {
+            return env.make_sstable(s, tmp.path().string(), 1, sstable_version_types::mc, big);
+        };
+        std::vector<mutation> muts;
+        for (auto& dk : ss.make_pkeys(100)) {
+            mutation m(s, dk);
+            ss.add_row(m, ss.make_ckey(0), "v");
+            muts.push_back(std::move(m));
+        }
+        auto sst = make_sstable_containing(sst_gen, muts);
+
+        auto deferred = env.make_sstable(s, tmp.path().string(), 1, sstable_version_types::mc, big);
+        deferred->load(default_priority_class(), true).get();
+        // Whether or not the filter is loaded yet, no key may be filtered out.
+        for (auto& m : muts) {
+            BOOST_REQUIRE(deferred->filter_has_key(*s, m.key()));
+        }
+        assert_that(sstable_reader(deferred, s))
+            .produces(muts[0])
+            .produces(muts[1]);
+
+        await_background_jobs().get();
+        BOOST_REQUIRE_EQUAL(deferred->filter_memory_size(), sst->filter_memory_size());
+        for (uint32_t i = 0; i < 1000; ++i) {
+            auto key = ss.make_pkey(i + 1000).key();
+            BOOST_REQUIRE_EQUAL(deferred->filter_has_key(*s, key), sst->filter_has_key(*s, key));
+        }
+    });
+}
+
+SEASTAR_TEST_CASE(release_shared_sstable_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        auto tmp = tmpdir();
+        int64_t gen = 1;
+        auto sst_gen = [&env, s, &tmp, &gen] () {
+            return env.make_sstable(s, tmp.path().string(), gen++, sstable_version_types::mc, big);
+        };
+        mutation m(s, ss.make_pkey(0));
+        ss.add_row(m, ss.make_ckey(0), "v");
+
+        // The files are kept until every owner released the sstable.
+        auto shared = make_sstable_containing(sst_gen, {m});
+        sstables::test(shared).set_shards({this_shard_id(), this_shard_id() + 1});
+        release_shared_sstables({shared}).get();
+        BOOST_REQUIRE(file_exists(shared->toc_filename()).get0());
+
+        auto unshared = make_sstable_containing(sst_gen, {m});
+        sstables::test(unshared).set_shards({this_shard_id()});
+        release_shared_sstables({unshared}).get();
+        BOOST_REQUIRE(!file_exists(unshared->toc_filename()).get0());
+
+        // The release survives a restart, also after the release logs are
+        // consolidated.
+        auto check_reloaded = [&] {
+            auto reloaded = env.reusable_sst(s, tmp.path().string(), shared->generation(), sstable_version_types::mc).get0();
+            sstables::test(reloaded).set_shards({this_shard_id(), this_shard_id() + 1});
+            reloaded->load_released_owners().get();
+            BOOST_REQUIRE(reloaded->get_shards_for_this_sstable() == std::vector<unsigned>({this_shard_id() + 1}));
+            BOOST_REQUIRE(reloaded->has_released_owners());
+        };
+        check_reloaded();
+        consolidate_release_logs(tmp.path().string()).get();
+        check_reloaded();
+    });
+}
+
+SEASTAR_TEST_CASE(release_with_other_shard_count_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        auto tmp = tmpdir();
+        std::vector<mutation> partitions;
+        for (auto&& key : ss.make_pkeys(16)) {
+            mutation m(s, key);
+            ss.add_row(m, ss.make_ckey(0), "v");
+            partitions.push_back(std::move(m));
+        }
+        auto sst = make_sstable_containing([&] {
+            return env.make_sstable(s, tmp.path().string(), 1, sstable_version_types::mc, big);
+        }, partitions);
+
+        // Shard 0 released the sstable while the node ran one more shard.
+        dht::sharder released_sharder(smp::count + 1, 0);
+        fs::create_directories(tmp.path() / sstable::released_dir_basename());
+        std::ofstream(tmp.path() / sstable::released_dir_basename() / "sstables-test.log")
+                << format("0 {} 0 {}\n", smp::count + 1, sst->component_basename(component_type::TOC));
+
+        auto reloaded = env.reusable_sst(s, tmp.path().string(), 1, sstable_version_types::mc).get0();
+        auto owners = reloaded->get_shards_for_this_sstable();
+        reloaded->load_released_owners().get();
+        BOOST_REQUIRE(reloaded->get_shards_for_this_sstable() == owners);
+        BOOST_REQUIRE(reloaded->has_released_owners());
+
+        // The partitions of the released shard are not read.
+        auto rd = assert_that(reloaded->read_rows_flat(s, no_reader_permit()));
+        for (auto&& m : partitions) {
+            if (released_sharder.shard_of(m.token()) != 0) {
+                rd.produces(m);
+            }
+        }
+        rd.produces_end_of_stream();
+    });
+}
+
+SEASTAR_TEST_CASE(test_xor_filter_falls_back_to_bloom_filter) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema table;
+        std::vector<mutation> partitions;
+        for (auto&& key : table.make_pkeys(10)) {
+            auto m = mutation(table.schema(), key);
+            table.add_row(m, table.make_ckey(0), "v");
+            partitions.push_back(std::move(m));
+        }
+
+        auto write = [&] (semaphore& writer_memory) {
+            tmpdir dir;
+            sstable_writer_config cfg = test_sstables_manager.configure_writer();
+            cfg.xor_filter = true;
+            cfg.writer_memory = &writer_memory;
+            auto sst = make_sstable_easy(env, dir.path(), flat_mutation_reader_from_mutations(partitions), cfg, sstable_version_types::mc);
+            for (auto&& m : partitions) {
+                BOOST_REQUIRE(sst->filter_has_key(*table.schema(), m.key()));
+            }
+            return sst->features().is_enabled(sstable_feature::XorFilter);
+        };
+
+        // The fallback Bloom filter is reserved along with the xor filter.
+        auto bloom_format = test_sstables_manager.configure_writer().split_block_bloom_filter
+                ? utils::filter_format::split_block_format : utils::filter_format::m_format;
+        ssize_t bloom_memory = utils::i_filter::get_filter(1, table.schema()->bloom_filter_fp_chance(), bloom_format)->memory_size();
+
+        ssize_t enough = bloom_memory + utils::filter::xor_filter::peak_memory(1 << 20);
+        semaphore enough_memory(enough);
+        BOOST_REQUIRE(write(enough_memory));
+        BOOST_REQUIRE_EQUAL(enough_memory.available_units(), enough);
+
+        // Not even the first reservation fits.
+        semaphore no_memory(0);
+        BOOST_REQUIRE(!write(no_memory));
+
+        // The xor filter fits, but not the fallback Bloom filter.
+        semaphore xor_only_memory(utils::filter::xor_filter::peak_memory(1));
+        BOOST_REQUIRE(!write(xor_only_memory));
+
+        // The first reservation fits, but growing it fails.
+        ssize_t little = bloom_memory + utils::filter::xor_filter::peak_memory(1);
+        semaphore little_memory(little);
+        BOOST_REQUIRE(!write(little_memory));
+        BOOST_REQUIRE_EQUAL(little_memory.available_units(), little);
+    });
+}
@@ -1710,3 +1710,62 @@ SEASTAR_TEST_CASE(test_static_compact_tables_are_read) {
         }
     });
 }
+
+SEASTAR_TEST_CASE(test_unselected_cell_values_are_skipped) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        auto s = schema_builder("ks", "test")
+            .with_column("pk", int32_type, column_kind::partition_key)
+            .with_column("ck", int32_type, column_kind::clustering_key)
+            .with_column("v1", int32_type)
+            .with_column("v2", utf8_type)
+            .with_column("v3", int32_type)
+            .build();
+        auto& v1 = *s->get_column_definition("v1");
+        auto& v2 = *s->get_column_definition("v2");
+        auto& v3 = *s->get_column_definition("v3");
+
+        auto pk = partition_key::from_exploded(*s, {int32_type->decompose(0)});
+        mutation m(s, pk);
+        auto ts = api::new_timestamp();
+        auto ck1 = clustering_key::from_exploded(*s, {int32_type->decompose(1)});
+        m.partition().clustered_row(*s, ck1).apply(row_marker(ts));
+        m.set_clustered_cell(ck1, v1, atomic_cell::make_live(*int32_type, ts, int32_type->decompose(1)));
+        m.set_clustered_cell(ck1, v2, atomic_cell::make_live(*utf8_type, ts, utf8_type->decompose(sstring(1000, 'x'))));
+        m.set_clustered_cell(ck1, v3, atomic_cell::make_live(*int32_type, ts, int32_type->decompose(3)));
+        // A row kept alive only by an unselected cell.
+        auto ck2 = clustering_key::from_exploded(*s, {int32_type->decompose(2)});
+        m.set_clustered_cell(ck2, v2, atomic_cell::make_live(*utf8_type, ts, utf8_type->decompose(sstring("y"))));
+
+        tmpdir dir;
+        auto ms = make_sstable_mutation_source(env, s, dir.path().string(), {m}, test_sstables_manager.configure_writer(),
+                sstable_version_types::mc);
+
+        auto slice = partition_slice_builder(*s).with_no_regular_columns().with_regular_column("v1").build();
+        // Without the option all cells are read.
+        assert_that(ms.make_reader(s, no_reader_permit(), query::full_partition_range, slice))
+            .produces(m)
+            .produces_end_of_stream();
+
+        slice.options.set(query::partition_slice::option::skip_unselected_cells);
+        auto r = ms.make_reader(s, no_reader_permit(), query::full_partition_range, slice);
+        auto actual = read_mutation_from_flat_mutation_reader(r, db::no_timeout).get0();
+        BOOST_REQUIRE(actual);
+        auto& rows = actual->partition().clustered_rows();
+        BOOST_REQUIRE_EQUAL(rows.calculate_size(), 2);
+
+        auto& r1 = rows.begin()->row();
+        auto c1 = r1.cells().find_cell(v1.id)->as_atomic_cell(v1);
+        BOOST_REQUIRE(int32_type->equal(c1.value().linearize(), int32_type->decompose(1)));
+        for (auto* cdef : {&v2, &v3}) {
+            auto c = r1.cells().find_cell(cdef->id)->as_atomic_cell(*cdef);
+            BOOST_REQUIRE(c.is_live());
+            BOOST_REQUIRE_EQUAL(c.timestamp(), ts);
+            BOOST_REQUIRE(c.value().linearize().empty());
+        }
+
+        auto& r2 = std::next(rows.begin())->row();
+        BOOST_REQUIRE(r2.is_live(*s));
+        BOOST_REQUIRE(r2.cells().find_cell(v2.id)->as_atomic_cell(v2).value().empty());
+    });
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+#include <seastar/core/byteorder.hh>
+#include <seastar/core/seastar.hh>
+
+#include "sstables/partitioned_filter.hh"
+#include "sstables/sstables.hh"
+#include "sstables/writer.hh"
+#include "utils/bloom_filter.hh"
+#include "utils/serialization.hh"
+#include "test/lib/tmpdir.hh"
+
+using namespace sstables;
+
+static bytes make_key(int64_t i) {
+    bytes b(bytes::initialized_later(), sizeof(i));
+    auto p = b.begin();
+    write<int64_t>(p, i);
+    return b;
+}
+
+// Writes the filter the way write_filter() lays out Filter.db.
+static void write_filter_file(const sstring& path, utils::filter::bloom_filter& f) {
+    auto& words = f.bits().get_storage();
+    auto fd = open_file_dma(path, open_flags::create | open_flags::wo | open_flags::truncate).get0();
+    file_writer out(std::move(fd), file_output_stream_options());
+    auto write_int = [&] (auto v) {
+        char buf[sizeof(v)];
+        write_be(buf, v);
+        out.write(buf, sizeof(v));
+    };
+    write_int(uint32_t(f.num_hashes()));
+    write_int(uint32_t(words.size()));
+    for (auto w : words) {
+        write_int(uint64_t(w));
+    }
+    out.close();
+}
+
+static std::unique_ptr<utils::filter::bloom_filter> make_filter(int64_t n) {
+    auto f = utils::filter::create_split_block_filter(n, 0.01);
+    for (int64_t i = 0; i < n; ++i) {
+        f->add(make_key(i));
+    }
+    return std::unique_ptr<utils::filter::bloom_filter>(static_cast<utils::filter::bloom_filter*>(f.release()));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_partitioned_filter_lookups) {
+    const int64_t n = 200000;
+    tmpdir tmp;
+    auto path = (tmp.path() / "Filter.db").string();
+    auto full = make_filter(n);
+    write_filter_file(path, *full);
+
+    filter_partition_cache cache(64 << 20);
+    auto& stats = filter_partition_cache::shard_stats();
+    auto populations = stats.populations;
+    auto pf = make_partitioned_filter(open_file_dma(path, open_flags::ro).get0(), cache).get0();
+    auto& p = static_cast<partitioned_filter&>(*pf);
+    BOOST_REQUIRE_GT(p.partitions(), 1);
+
+    // Nothing is resident yet, so every key may be present, and probes
+    // start loading partitions in the background.
+    for (int64_t i = n; i < n + 1000; ++i) {
+        BOOST_REQUIRE(pf->is_present(make_key(i)));
+    }
+    await_background_jobs().get();
+    BOOST_REQUIRE_EQUAL(stats.populations - populations, p.partitions());
+
+    for (int64_t i = 0; i < 2 * n; ++i) {
+        BOOST_REQUIRE_EQUAL(pf->is_present(make_key(i)), full->is_present(make_key(i)));
+    }
+    pf = {};
+    await_background_jobs().get();
+    BOOST_REQUIRE_EQUAL(stats.bytes, 0);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_partitioned_filter_eviction) {
+    const int64_t n = 200000;
+    tmpdir tmp;
+    auto path = (tmp.path() / "Filter.db").string();
+    auto full = make_filter(n);
+    write_filter_file(path, *full);
+
+    filter_partition_cache cache(2 * partitioned_filter::partition_size);
+    auto& stats = filter_partition_cache::shard_stats();
+    auto evictions = stats.evictions;
+    auto pf = make_partitioned_filter(open_file_dma(path, open_flags::ro).get0(), cache).get0();
+    auto& p = static_cast<partitioned_filter&>(*pf);
+    for (uint64_t i = 0; i < p.partitions(); ++i) {
+        p.load_partition(i).get();
+    }
+    BOOST_REQUIRE_LE(stats.bytes, cache.max_bytes());
+    BOOST_REQUIRE_EQUAL(stats.evictions - evictions, p.partitions() - 2);
+
+    // The filter never reports a member as absent, whatever is cached.
+    for (int64_t i = 0; i < n; ++i) {
+        BOOST_REQUIRE(pf->is_present(make_key(i)));
+    }
+    pf = {};
+    await_background_jobs().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_partitioned_filter_invalid_file) {
+    tmpdir tmp;
+    auto path = (tmp.path() / "Filter.db").string();
+    {
+        auto fd = open_file_dma(path, open_flags::create | open_flags::wo | open_flags::truncate).get0();
+        file_writer out(std::move(fd), file_output_stream_options());
+        char buf[12] = {};
+        write_be<uint32_t>(buf + 4, 8);
+        out.write(buf, sizeof(buf));
+        out.close();
+    }
+    filter_partition_cache cache(1 << 20);
+    BOOST_REQUIRE_THROW(make_partitioned_filter(open_file_dma(path, open_flags::ro).get0(), cache).get0(), malformed_sstable_exception);
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include "sstables/summary_entries.hh"
+#include "test/lib/simple_schema.hh"
+
+using namespace sstables;
+
+// Keys with a long common prefix, as with wide text partition keys.
+// Tokens are made to collide so that lookups have to compare keys.
+static std::vector<dht::decorated_key> make_keys(simple_schema& ss, int n, int tokens) {
+    std::vector<dht::decorated_key> keys;
+    for (int i = 0; i < n; ++i) {
+        auto dk = ss.make_pkey(format("user-activity-events/region-eu-west/customer-{:08d}", i));
+        keys.emplace_back(dht::token::from_int64(i % tokens), dk.key());
+    }
+    dht::ring_position_comparator cmp(*ss.schema());
+    std::sort(keys.begin(), keys.end(), [&] (const dht::decorated_key& a, const dht::decorated_key& b) {
+        return cmp(dht::ring_position_view(a), dht::ring_position_view(b)) < 0;
+    });
+    return keys;
+}
+
+static summary_entries make_entries(const schema& s, const std::vector<dht::decorated_key>& keys) {
+    summary_entries entries;
+    uint64_t position = 0;
+    for (auto& dk : keys) {
+        entries.push_back(dk.token(), key::from_partition_key(s, dk.key()).get_bytes(), position);
+        position += 100;
+    }
+    return entries;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_summary_entries_decode) {
+    simple_schema ss;
+    auto s = ss.schema();
+    for (int n : {0, 1, 15, 16, 17, 1000}) {
+        auto keys = make_keys(ss, n, 13);
+        auto entries = make_entries(*s, keys);
+        BOOST_REQUIRE_EQUAL(entries.size(), keys.size());
+
+        size_t idx = 0;
+        for (auto& e : entries) {
+            auto expected = key::from_partition_key(*s, keys[idx].key()).get_bytes();
+            BOOST_REQUIRE(e.key == expected);
+            BOOST_REQUIRE(e.token == keys[idx].token());
+            BOOST_REQUIRE_EQUAL(e.position, idx * 100);
+            BOOST_REQUIRE(entries[idx] == e);
+            ++idx;
+        }
+        BOOST_REQUIRE_EQUAL(idx, keys.size());
+        BOOST_REQUIRE(entries == make_entries(*s, keys));
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_summary_entries_lower_bound) {
+    simple_schema ss;
+    auto s = ss.schema();
+    dht::ring_position_comparator cmp(*s);
+    for (int tokens : {1, 7, 5000}) {
+        auto keys = make_keys(ss, 1000, tokens);
+        auto entries = make_entries(*s, keys);
+
+        auto check = [&] (dht::ring_position_view rp, size_t from) {
+            auto it = std::lower_bound(keys.begin() + from, keys.end(), rp, [&] (const dht::decorated_key& dk, dht::ring_position_view rp) {
+                return cmp(dht::ring_position_view(dk), rp) < 0;
+            });
+            BOOST_REQUIRE_EQUAL(entries.lower_bound(*s, rp, from), size_t(std::distance(keys.begin(), it)));
+        };
+        for (size_t i = 0; i < keys.size(); ++i) {
+            check(dht::ring_position_view(keys[i]), 0);
+            check(dht::ring_position_view(keys[i]), i / 2);
+            check(dht::ring_position_view(keys[i], dht::ring_position_view::after_key::yes), 0);
+            check(dht::ring_position_view::starting_at(keys[i].token()), 0);
+            check(dht::ring_position_view::ending_at(keys[i].token()), 0);
+        }
+        check(dht::ring_position_view::starting_at(dht::token::from_int64(-1)), 0);
+        check(dht::ring_position_view::ending_at(dht::token::from_int64(tokens)), 0);
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_summary_entries_memory) {
+    simple_schema ss;
+    auto s = ss.schema();
+    auto keys = make_keys(ss, 10000, 10000);
+    auto entries = make_entries(*s, keys);
+    // An uncompressed entry costs its key plus a token, a key view and a position.
+    size_t uncompressed = 0;
+    for (auto& dk : keys) {
+        uncompressed += key::from_partition_key(*s, dk.key()).get_bytes().size() + sizeof(dht::token) + sizeof(bytes_view) + sizeof(uint64_t);
+    }
+    BOOST_REQUIRE_LT(entries.memory_footprint(), uncompressed / 2);
+}
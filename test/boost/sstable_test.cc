@@ -417,7 +417,7 @@ class test_row_consumer : public row_consumer {
 SEASTAR_TEST_CASE(uncompressed_rows_read_one) {
     return test_using_reusable_sst(uncompressed_schema(), uncompressed_dir(), 1, [] (auto sstp) {
         return do_with(test_row_consumer(1418656871665302), [sstp] (auto& c) {
-            auto context = data_consume_rows<data_consume_rows_context>(*uncompressed_schema(), sstp, c, {0, 95}, 95);
+            auto context = data_consume_rows<data_consume_rows_context>(*uncompressed_schema(), sstp, c, {0, 95}, 95, {});
             auto fut = context.read();
             return fut.then([sstp, &c, context = std::move(context)] {
                 BOOST_REQUIRE(c.count_row_start == 1);
@@ -435,7 +435,7 @@ SEASTAR_TEST_CASE(compressed_rows_read_one) {
     auto s = make_lw_shared(schema({}, "ks", "cf", {}, {}, {}, {}, utf8_type));
     return test_using_reusable_sst(std::move(s), "test/resource/sstables/compressed", 1, [] (auto sstp) {
         return do_with(test_row_consumer(1418654707438005), [sstp] (auto& c) {
-            auto context = data_consume_rows<data_consume_rows_context>(*uncompressed_schema(), sstp, c, {0, 95}, 95);
+            auto context = data_consume_rows<data_consume_rows_context>(*uncompressed_schema(), sstp, c, {0, 95}, 95, {});
             auto fut = context.read();
             return fut.then([sstp, &c, context = std::move(context)] {
                 BOOST_REQUIRE(c.count_row_start == 1);
@@ -1303,3 +1303,35 @@ SEASTAR_TEST_CASE(test_skipping_in_compressed_stream) {
         expect_eof(in);
     });
 }
+
+SEASTAR_TEST_CASE(test_read_ahead_for) {
+    using access = sstable::read_ahead_hint::access;
+    constexpr size_t max_buffer = 128 * 1024;
+
+    // Point reads of small partitions read just the partition.
+    auto p = sstable::read_ahead_for({access::point, 1000}, max_buffer);
+    BOOST_REQUIRE_EQUAL(p.buffer_size, 4096);
+    BOOST_REQUIRE_EQUAL(p.read_ahead, 0);
+
+    // Point reads of large partitions keep a single buffer in flight.
+    p = sstable::read_ahead_for({access::point, 10 * max_buffer}, max_buffer);
+    BOOST_REQUIRE_EQUAL(p.buffer_size, max_buffer);
+    BOOST_REQUIRE_EQUAL(p.read_ahead, 1);
+
+    // Sequential reads always read ahead, more for larger ranges.
+    p = sstable::read_ahead_for({access::sequential, 0}, max_buffer);
+    BOOST_REQUIRE_EQUAL(p.buffer_size, 4096);
+    BOOST_REQUIRE_EQUAL(p.read_ahead, 1);
+    p = sstable::read_ahead_for({access::sequential, 3 * max_buffer}, max_buffer);
+    BOOST_REQUIRE_EQUAL(p.buffer_size, max_buffer);
+    BOOST_REQUIRE_EQUAL(p.read_ahead, 2);
+    p = sstable::read_ahead_for({access::sequential, 100 * max_buffer}, max_buffer);
+    BOOST_REQUIRE_EQUAL(p.read_ahead, 4);
+    p = sstable::read_ahead_for({access::sequential, 100 * max_buffer, true}, max_buffer);
+    BOOST_REQUIRE_EQUAL(p.read_ahead, 8);
+
+    // Small configured buffers are respected.
+    p = sstable::read_ahead_for({access::sequential, 100}, 1024);
+    BOOST_REQUIRE_EQUAL(p.buffer_size, 1024);
+    return make_ready_future<>();
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/seastar.hh>
+
+#include "sstables/trie_index.hh"
+#include "sstables/sstables.hh"
+#include "sstables/writer.hh"
+#include "test/lib/tmpdir.hh"
+#include "test/lib/random_utils.hh"
+#include "test/lib/simple_schema.hh"
+#include "test/lib/sstable_test_env.hh"
+#include "test/lib/test_services.hh"
+#include "test/lib/flat_mutation_reader_assertions.hh"
+
+using namespace sstables;
+
+static std::map<int64_t, uint64_t> write_trie(const sstring& path, std::vector<int64_t> tokens) {
+    std::sort(tokens.begin(), tokens.end());
+    auto f = open_file_dma(path, open_flags::create | open_flags::wo | open_flags::truncate).get0();
+    file_writer out(std::move(f), file_output_stream_options());
+    trie::index_writer w(out);
+    std::map<int64_t, uint64_t> expected;
+    uint64_t pos = 0;
+    for (auto t : tokens) {
+        w.add(dht::token::from_int64(t), pos);
+        expected.emplace(t, pos);
+        pos += 17;
+    }
+    BOOST_REQUIRE_EQUAL(w.finish(), expected.size());
+    out.close();
+    return expected;
+}
+
+static void check_lookups(const sstring& path, const std::map<int64_t, uint64_t>& expected, const std::vector<int64_t>& probes) {
+    auto f = open_file_dma(path, open_flags::ro).get0();
+    auto size = f.size().get0();
+    BOOST_REQUIRE_EQUAL(size % trie::page_size, 0);
+    trie::index_reader r(f, size, default_priority_class());
+    r.open().get();
+    BOOST_REQUIRE_EQUAL(r.entries(), expected.size());
+
+    for (auto p : probes) {
+        auto res = r.lower_bound(dht::token::from_int64(p)).get0();
+        auto it = expected.lower_bound(p);
+        if (it == expected.end()) {
+            BOOST_REQUIRE(!res);
+        } else {
+            BOOST_REQUIRE(res);
+            BOOST_REQUIRE_EQUAL(res->token, it->first);
+            BOOST_REQUIRE_EQUAL(res->position, it->second);
+        }
+    }
+
+    auto first = r.lower_bound(dht::minimum_token()).get0();
+    BOOST_REQUIRE_EQUAL(bool(first), !expected.empty());
+    if (first) {
+        BOOST_REQUIRE_EQUAL(first->token, expected.begin()->first);
+    }
+    BOOST_REQUIRE(!r.lower_bound(dht::maximum_token()).get0());
+    f.close().get();
+}
+
+SEASTAR_THREAD_TEST_CASE(test_trie_index_empty) {
+    tmpdir tmp;
+    auto path = (tmp.path() / "Partitions.db").string();
+    auto expected = write_trie(path, {});
+    check_lookups(path, expected, {0, 1, -1});
+}
+
+SEASTAR_THREAD_TEST_CASE(test_trie_index_duplicate_tokens) {
+    tmpdir tmp;
+    auto path = (tmp.path() / "Partitions.db").string();
+    auto expected = write_trie(path, {5, 5, 5, 7, 7, 100});
+    BOOST_REQUIRE_EQUAL(expected.size(), 3);
+    check_lookups(path, expected, {4, 5, 6, 7, 8, 99, 100, 101});
+}
+
+SEASTAR_THREAD_TEST_CASE(test_trie_index_random) {
+    auto& gen = tests::random::gen();
+    for (auto n : {1, 2, 10, 1000, 50000}) {
+        tmpdir tmp;
+        auto path = (tmp.path() / "Partitions.db").string();
+        std::vector<int64_t> tokens;
+        for (int i = 0; i < n; ++i) {
+            auto t = tests::random::get_int<int64_t>(std::numeric_limits<int64_t>::min() + 1, std::numeric_limits<int64_t>::max(), gen);
+            // Make some tokens share long prefixes.
+            tokens.push_back(i % 3 ? t : t >> 40);
+        }
+        auto expected = write_trie(path, tokens);
+
+        std::vector<int64_t> probes;
+        for (int i = 0; i < 1000; ++i) {
+            auto t = tokens[tests::random::get_int<size_t>(tokens.size() - 1, gen)];
+            probes.push_back(t - 1);
+            probes.push_back(t);
+            probes.push_back(t + 1);
+            probes.push_back(tests::random::get_int<int64_t>(std::numeric_limits<int64_t>::min() + 1, std::numeric_limits<int64_t>::max(), gen));
+        }
+        check_lookups(path, expected, probes);
+    }
+}
+
+SEASTAR_TEST_CASE(test_trie_index_skips_absent_partitions) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        tmpdir tmp;
+
+        // Only every other key is written.
+        auto keys = ss.make_pkeys(8);
+        std::vector<mutation> muts;
+        for (size_t i = 0; i < keys.size(); i += 2) {
+            mutation m(s, keys[i]);
+            ss.add_row(m, ss.make_ckey(0), "v");
+            muts.push_back(std::move(m));
+        }
+        auto cfg = test_sstables_manager.configure_writer();
+        cfg.trie_index = true;
+        auto sst = env.make_sstable(s, tmp.path().string(), 1, sstable_version_types::mc, sstable_format_types::big);
+        sst->write_components(flat_mutation_reader_from_mutations(muts), muts.size(), s, cfg, encoding_stats{}).get();
+        sst->load().get();
+        BOOST_REQUIRE(sst->has_component(component_type::TrieIndex));
+
+        auto& stats = sstables_stats::get_shard_stats();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto skips = stats.trie_index_partition_skips;
+            auto rd = assert_that(sst->read_row_flat(s, no_reader_permit(), keys[i]));
+            if (i % 2 == 0) {
+                rd.produces(muts[i / 2]);
+            }
+            rd.produces_end_of_stream();
+            BOOST_REQUIRE_EQUAL(stats.trie_index_partition_skips, skips + i % 2);
+        }
+    });
+}
+
+SEASTAR_TEST_CASE(test_trie_index_not_consulted_after_true_positives) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        tmpdir tmp;
+
+        auto keys = ss.make_pkeys(10);
+        std::vector<mutation> muts;
+        for (size_t i = 0; i < keys.size() - 1; ++i) {
+            mutation m(s, keys[i]);
+            ss.add_row(m, ss.make_ckey(0), "v");
+            muts.push_back(std::move(m));
+        }
+        auto cfg = test_sstables_manager.configure_writer();
+        cfg.trie_index = true;
+        auto sst = env.make_sstable(s, tmp.path().string(), 1, sstable_version_types::mc, sstable_format_types::big);
+        sst->write_components(flat_mutation_reader_from_mutations(muts), muts.size(), s, cfg, encoding_stats{}).get();
+        sst->load().get();
+
+        auto& stats = sstables_stats::get_shard_stats();
+        auto skips = stats.trie_index_partition_skips;
+        for (auto& m : muts) {
+            assert_that(sst->read_row_flat(s, no_reader_permit(), m.decorated_key()))
+                .produces(m)
+                .produces_end_of_stream();
+        }
+        // The filter answered right every time, so the absent key is looked up
+        // in the index only.
+        assert_that(sst->read_row_flat(s, no_reader_permit(), keys.back()))
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(stats.trie_index_partition_skips, skips);
+    });
+}
@@ -20,16 +20,22 @@
  */
 
 
+#include <boost/range/irange.hpp>
 #include <seastar/core/thread.hh>
 #include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
 #include "query-result-writer.hh"
 
 #include "test/lib/cql_test_env.hh"
+#include "test/lib/cql_assertions.hh"
 #include "test/lib/mutation_source_test.hh"
 #include "test/lib/result_set_assertions.hh"
 #include "service/storage_proxy.hh"
+#include "db/config.hh"
+#include "utils/decaying_histogram.hh"
 #include "partition_slice_builder.hh"
 #include "schema_builder.hh"
+#include "transport/messages/result_message.hh"
 
 // Returns random keys sorted in ring order.
 // The schema must have a single bytes_type partition key column.
@@ -112,3 +118,208 @@ SEASTAR_TEST_CASE(test_get_restricted_ranges) {
         });
     });
 }
+
+SEASTAR_THREAD_TEST_CASE(test_range_scan_concurrency) {
+    using namespace std::chrono_literals;
+    const uint64_t budget = 1 << 20;
+    service::range_scan_concurrency c(budget);
+    BOOST_REQUIRE_EQUAL(c.factor(), 1);
+
+    // Grows exponentially while the latency is stable.
+    c.update(10ms, 1, 100, 1, 1000);
+    BOOST_REQUIRE_EQUAL(c.factor(), 2);
+    c.update(10ms, 2, 200, 2, 1000);
+    BOOST_REQUIRE_EQUAL(c.factor(), 4);
+
+    // Backs off when the latency degrades, then grows additively.
+    c.update(50ms, 4, 400, 4, 1000);
+    BOOST_REQUIRE_EQUAL(c.factor(), 2);
+    c.update(10ms, 2, 200, 2, 1000);
+    BOOST_REQUIRE_EQUAL(c.factor(), 3);
+
+    // Capped by the memory budget.
+    c.update(10ms, 3, 3 * (budget / 2), 3, 1000);
+    BOOST_REQUIRE_EQUAL(c.factor(), 2);
+
+    // Capped by the number of rows still needed.
+    service::range_scan_concurrency rows(budget);
+    rows.update(10ms, 1, 100, 10, 100);
+    rows.update(10ms, 2, 100, 20, 80);
+    rows.update(10ms, 4, 100, 40, 40);
+    BOOST_REQUIRE_EQUAL(rows.factor(), 4);
+    rows.update(10ms, 4, 100, 40, 0);
+    BOOST_REQUIRE_EQUAL(rows.factor(), 1);
+}
+
+SEASTAR_TEST_CASE(test_replica_read_scores) {
+    // The environment provides the snitch, which places all nodes in the local datacenter.
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        using namespace std::chrono_literals;
+        const gms::inet_address a("127.0.0.1"), b("127.0.0.2"), c("127.0.0.3");
+        service::replica_read_scores scores;
+        auto read = [&] (gms::inet_address ep, std::chrono::microseconds latency) {
+            scores.on_read_start(ep);
+            scores.on_read_end(ep, latency);
+        };
+        auto sorted = [&] (double hysteresis) {
+            std::vector<gms::inet_address> eps{a, b, c};
+            scores.sort(eps, hysteresis);
+            return eps;
+        };
+
+        read(a, 1000us);
+        read(b, 700us);
+        read(c, 100us);
+        // Within the hysteresis only the clearly faster replica moves ahead.
+        BOOST_REQUIRE(sorted(2) == (std::vector<gms::inet_address>{c, a, b}));
+        BOOST_REQUIRE(sorted(1) == (std::vector<gms::inet_address>{c, b, a}));
+
+        // Reads in flight make a replica look slower.
+        for (int i = 0; i < 20; ++i) {
+            scores.on_read_start(c);
+        }
+        BOOST_REQUIRE(sorted(1).front() == b);
+    });
+}
+
+SEASTAR_THREAD_TEST_CASE(test_decaying_latency_histogram) {
+    using namespace std::chrono_literals;
+    utils::decaying_latency_histogram h;
+    auto now = utils::decaying_latency_histogram::clock::now();
+    BOOST_REQUIRE(!h.percentile(0.99, now));
+
+    for (int i = 1; i <= 1000; ++i) {
+        h.add(std::chrono::microseconds(i * 10), now);
+    }
+    auto p99 = h.percentile(0.99, now)->count();
+    // Accurate within one sub-bucket.
+    BOOST_REQUIRE_GE(p99, 9900);
+    BOOST_REQUIRE_LE(p99, 9900 + 9900 / utils::decaying_latency_histogram::sub_buckets);
+
+    // After the old samples decayed, new ones dominate.
+    now += 20 * utils::decaying_latency_histogram::decay_period;
+    for (int i = 0; i < 100; ++i) {
+        h.add(100us, now);
+    }
+    BOOST_REQUIRE_LE(h.percentile(0.8, now)->count(), 100 + 100 / utils::decaying_latency_histogram::sub_buckets);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_decaying_latency_histogram_merge) {
+    using namespace std::chrono_literals;
+    utils::decaying_latency_histogram a;
+    utils::decaying_latency_histogram b;
+    auto now = utils::decaying_latency_histogram::clock::now();
+    for (int i = 0; i < 100; ++i) {
+        a.add(100us, now);
+        b.add(10000us, now);
+    }
+    auto merged = utils::decaying_latency_histogram_merge(a, b);
+    BOOST_REQUIRE_EQUAL(merged.count(), 200);
+    BOOST_REQUIRE_LE(merged.percentile(0.4, now)->count(), 100 + 100 / utils::decaying_latency_histogram::sub_buckets);
+    BOOST_REQUIRE_GE(merged.percentile(0.6, now)->count(), 10000);
+
+    auto eh = merged.to_estimated_histogram(now);
+    BOOST_REQUIRE_EQUAL(eh.buckets.size(), eh.bucket_offsets.size() + 1);
+    BOOST_REQUIRE(std::is_sorted(eh.bucket_offsets.begin(), eh.bucket_offsets.end()));
+    BOOST_REQUIRE_EQUAL(eh._count, 200);
+    BOOST_REQUIRE_GE(eh.min(), 100 - 100 / utils::decaying_latency_histogram::sub_buckets);
+    BOOST_REQUIRE_LE(eh.max(), 10000 + 10000 / utils::decaying_latency_histogram::sub_buckets);
+
+    // A histogram which decayed since is merged with its samples decayed too.
+    now += 30 * utils::decaying_latency_histogram::decay_period;
+    utils::decaying_latency_histogram c;
+    c.add(100us, now);
+    c.percentile(0.5, now);
+    c += b;
+    BOOST_REQUIRE_LT(c.count(), 2);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_speculative_retry_min) {
+    auto sr = speculative_retry::from_sstring("min(99percentile, 50ms)");
+    BOOST_REQUIRE(sr.get_type() == speculative_retry::type::MIN);
+    BOOST_REQUIRE_EQUAL(sr.get_value(), 0.99);
+    BOOST_REQUIRE_EQUAL(sr.get_cap_ms(), 50);
+    BOOST_REQUIRE(speculative_retry::from_sstring(sr.to_sstring()) == sr);
+    BOOST_REQUIRE(speculative_retry::from_sstring("MIN(50ms,99PERCENTILE)") == sr);
+    BOOST_REQUIRE_THROW(speculative_retry::from_sstring("MIN(50ms,60ms)"), std::invalid_argument);
+}
+
+SEASTAR_TEST_CASE(test_multi_partition_read_grouped_by_replica) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table t (p int primary key, v int)").get();
+        for (int i = 0; i < 20; ++i) {
+            e.execute_cql(format("insert into t (p, v) values ({}, {})", i, i * 10)).get();
+        }
+
+        auto& stats = service::get_local_storage_proxy().get_stats();
+        auto grouped = stats.grouped_partition_reads;
+        auto values = [&] (sstring query) {
+            auto msg = e.execute_cql(query).get0();
+            auto rows = dynamic_pointer_cast<cql_transport::messages::result_message::rows>(msg);
+            BOOST_REQUIRE(rows);
+            std::vector<int32_t> vs;
+            for (auto& row : rows->rs().result_set().rows()) {
+                vs.push_back(value_cast<int32_t>(int32_type->deserialize(*row[0])));
+            }
+            return vs;
+        };
+
+        // The keys are read in one request to the replica, and one read per
+        // shard, but the rows still come back in the order of the keys, and
+        // limits cut the same rows.
+        BOOST_REQUIRE(values("select v from t where p in (7, 1, 15, 3, 100, 11)") == (std::vector<int32_t>{10, 30, 70, 110, 150}));
+        BOOST_REQUIRE_EQUAL(stats.grouped_partition_reads, grouped + 6);
+        BOOST_REQUIRE(values("select v from t where p in (7, 1, 15, 3, 11) limit 2") == (std::vector<int32_t>{10, 30}));
+    });
+}
+
+SEASTAR_TEST_CASE(test_single_partition_local_replica_fast_path) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table t (p int primary key, v int)").get();
+        auto& stats = service::get_local_storage_proxy().get_stats();
+        auto writes = stats.local_replica_writes;
+        auto reads = stats.local_replica_reads;
+
+        // The only node replicates every key, but only those owned by this
+        // shard take the fast path.
+        for (int i = 0; i < 20; ++i) {
+            e.execute_cql(format("insert into t (p, v) values ({}, {})", i, i * 10)).get();
+        }
+        BOOST_REQUIRE_GT(stats.local_replica_writes, writes);
+        for (int i = 0; i < 20; ++i) {
+            auto msg = e.execute_cql(format("select v from t where p = {}", i)).get0();
+            assert_that(msg).is_rows().with_rows({{int32_type->decompose(i * 10)}});
+        }
+        BOOST_REQUIRE_GT(stats.local_replica_reads, reads);
+        BOOST_REQUIRE_EQUAL(stats.local_replica_read_fallbacks, 0);
+        BOOST_REQUIRE_EQUAL(stats.local_replica_write_fallbacks, 0);
+    });
+}
+
+SEASTAR_TEST_CASE(test_counter_update_coalescing) {
+    auto cfg = make_shared<db::config>();
+    cfg->counter_update_coalescing_window_in_us(10000);
+    cfg->counter_update_coalescing_tables({"ks.c"});
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table c (p int primary key, v counter)").get();
+        auto coalesced = [] {
+            return service::get_storage_proxy().map_reduce0([] (service::storage_proxy& sp) {
+                return sp.get_stats().coalesced_counter_updates;
+            }, uint64_t(0), std::plus<uint64_t>()).get0();
+        };
+        auto before = coalesced();
+
+        // Concurrent increments of the same counter are merged on the leader,
+        // but every one of them is accounted for.
+        parallel_for_each(boost::irange(0, 50), [&e] (int) {
+            return e.execute_cql("update c set v = v + 2 where p = 0").discard_result();
+        }).get();
+        auto msg = e.execute_cql("select v from c where p = 0").get0();
+        assert_that(msg).is_rows().with_rows({{long_type->decompose(int64_t(100))}});
+        BOOST_REQUIRE_GT(coalesced(), before);
+
+        e.execute_cql("update c set v = v - 1 where p = 0").get();
+        msg = e.execute_cql("select v from c where p = 0").get0();
+        assert_that(msg).is_rows().with_rows({{long_type->decompose(int64_t(99))}});
+    }, cql_test_config(cfg));
+}
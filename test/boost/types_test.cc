@@ -729,6 +729,32 @@ BOOST_AUTO_TEST_CASE(test_create_reversed_type) {
     BOOST_REQUIRE(straight_comp == -reverse_comp);
 }
 
+BOOST_AUTO_TEST_CASE(test_compiled_tri_comparator) {
+    auto check = [] (data_type t, std::vector<data_value> values) {
+        for (data_type type : {t, data_type(reversed_type_impl::get_instance(t))}) {
+            auto cmp = type->compile_tri_comparator();
+            for (auto&& a : values) {
+                for (auto&& b : values) {
+                    auto v1 = *a.serialize();
+                    auto v2 = *b.serialize();
+                    auto expected = type->compare(v1, v2);
+                    auto c = cmp(v1, v2);
+                    BOOST_REQUIRE_EQUAL(c < 0, expected < 0);
+                    BOOST_REQUIRE_EQUAL(c > 0, expected > 0);
+                }
+            }
+        }
+    };
+    check(int32_type, {int32_t(-1), int32_t(0), int32_t(7)});
+    check(long_type, {int64_t(-1), int64_t(0), int64_t(1) << 40});
+    check(utf8_type, {sstring(""), sstring("a"), sstring("ab"), sstring("b")});
+    check(timeuuid_type, {timeuuid_native_type{utils::UUID_gen::get_time_UUID()}, timeuuid_native_type{utils::UUID_gen::get_time_UUID()}});
+    check(double_type, {-1.0, 0.0, 2.5, std::numeric_limits<double>::quiet_NaN()});
+    check(tuple_type_impl::get_instance({int32_type, utf8_type}),
+            {make_tuple_value(tuple_type_impl::get_instance({int32_type, utf8_type}), {int32_t(1), sstring("a")}),
+             make_tuple_value(tuple_type_impl::get_instance({int32_type, utf8_type}), {int32_t(1), sstring("b")})});
+}
+
 BOOST_AUTO_TEST_CASE(test_reversed_type_to_string) {
     auto ri = reversed_type_impl::get_instance(int32_type);
     auto v = ri->decompose(42);
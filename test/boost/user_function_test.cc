@@ -23,6 +23,7 @@
 #include <seastar/testing/thread_test_case.hh>
 #include "test/lib/cql_assertions.hh"
 #include "test/lib/cql_test_env.hh"
+#include "cql3/query_processor.hh"
 #include "types/list.hh"
 #include "transport/messages/result_message.hh"
 #include "types/map.hh"
@@ -1078,3 +1079,122 @@ SEASTAR_TEST_CASE(test_user_function_invalid_type) {
              });
    });
 }
+
+SEASTAR_TEST_CASE(test_user_aggregate) {
+    return with_udf_enabled([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE my_table (key int, ck int, val int, PRIMARY KEY (key, ck));").get();
+        for (int i = 1; i <= 3; ++i) {
+            e.execute_cql(format("INSERT INTO my_table (key, ck, val) VALUES (1, {:d}, {:d});", i, i)).get();
+        }
+        e.execute_cql("INSERT INTO my_table (key, ck) VALUES (2, 1);").get();
+
+        e.execute_cql("CREATE FUNCTION my_sum_state(acc int, val int) RETURNS NULL ON NULL INPUT RETURNS int LANGUAGE Lua AS 'return acc + val';").get();
+        e.execute_cql("CREATE FUNCTION my_count_state(acc int, val int) CALLED ON NULL INPUT RETURNS int LANGUAGE Lua AS 'if val == nil then return acc end return acc + 1';").get();
+        e.execute_cql("CREATE FUNCTION my_double(acc int) RETURNS NULL ON NULL INPUT RETURNS int LANGUAGE Lua AS 'return 2 * acc';").get();
+
+        auto fut = e.execute_cql("CREATE AGGREGATE my_sum(int) SFUNC my_missing_func STYPE int;");
+        BOOST_REQUIRE_EXCEPTION(fut.get(), ire, message_equals("State function ks.my_missing_func(int, int) doesn't exist"));
+        fut = e.execute_cql("CREATE AGGREGATE my_sum(int) SFUNC my_sum_state STYPE bigint;");
+        BOOST_REQUIRE_EXCEPTION(fut.get(), ire, message_contains("doesn't exist"));
+
+        auto msg = e.execute_cql("CREATE AGGREGATE my_sum(int) SFUNC my_sum_state STYPE int INITCOND 0;").get0();
+        auto change = get_schema_change(msg);
+        using sc = cql_transport::event::schema_change;
+        BOOST_REQUIRE(change->change == sc::change_type::CREATED);
+        BOOST_REQUIRE(change->target == sc::target_type::AGGREGATE);
+        e.execute_cql("CREATE AGGREGATE my_double_sum(int) SFUNC my_sum_state STYPE int FINALFUNC my_double INITCOND 0;").get();
+        e.execute_cql("CREATE AGGREGATE my_count(int) SFUNC my_count_state STYPE int INITCOND 0;").get();
+        e.execute_cql("CREATE AGGREGATE my_null_sum(int) SFUNC my_sum_state STYPE int;").get();
+
+        msg = e.execute_cql("SELECT my_sum(val), my_double_sum(val), my_count(val), my_null_sum(val) FROM my_table WHERE key = 1;").get0();
+        assert_that(msg).is_rows().with_rows({{serialized(6), serialized(12), serialized(3), {}}});
+
+        // A null input nulls the state of a RETURNS NULL ON NULL INPUT state function.
+        msg = e.execute_cql("SELECT my_sum(val), my_count(val) FROM my_table WHERE key = 2;").get0();
+        assert_that(msg).is_rows().with_rows({{{}, serialized(0)}});
+
+        msg = e.execute_cql("SELECT my_sum(val), my_double_sum(val) FROM my_table WHERE key = 3;").get0();
+        assert_that(msg).is_rows().with_rows({{serialized(0), serialized(0)}});
+
+        msg = e.execute_cql("SELECT * FROM system_schema.aggregates WHERE keyspace_name = 'ks' AND aggregate_name = 'my_double_sum';").get0();
+        auto str_list = list_type_impl::get_instance(utf8_type, false);
+        assert_that(msg).is_rows().with_rows({
+            {
+                serialized("ks"),
+                serialized("my_double_sum"),
+                make_list_value(str_list, {"int"}).serialize(),
+                serialized("my_double"),
+                serialized("0"),
+                serialized("int"),
+                serialized("my_sum_state"),
+                serialized("int"),
+            }
+        });
+
+        // Replacing a state function updates the aggregates using it.
+        e.execute_cql("CREATE OR REPLACE FUNCTION my_sum_state(acc int, val int) RETURNS NULL ON NULL INPUT RETURNS int LANGUAGE Lua AS 'return acc + 10 * val';").get();
+        msg = e.execute_cql("SELECT my_sum(val) FROM my_table WHERE key = 1;").get0();
+        assert_that(msg).is_rows().with_rows({{serialized(60)}});
+
+        fut = e.execute_cql("DROP FUNCTION my_double;");
+        BOOST_REQUIRE_EXCEPTION(fut.get(), ire, message_contains("is used by aggregate"));
+        fut = e.execute_cql("DROP AGGREGATE my_double;");
+        BOOST_REQUIRE_EXCEPTION(fut.get(), ire, message_contains("is not a user defined aggregate"));
+
+        msg = e.execute_cql("DROP AGGREGATE my_double_sum;").get0();
+        change = get_schema_change(msg);
+        BOOST_REQUIRE(change->change == sc::change_type::DROPPED);
+        BOOST_REQUIRE(change->target == sc::target_type::AGGREGATE);
+        e.execute_cql("DROP FUNCTION my_double;").get();
+        fut = e.execute_cql("SELECT my_double_sum(val) FROM my_table WHERE key = 1;");
+        BOOST_REQUIRE_EXCEPTION(fut.get(), ire, message_contains("Unknown function"));
+    });
+}
+
+SEASTAR_TEST_CASE(test_reducible_user_aggregate) {
+    return with_udf_enabled([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE my_table (key int, ck int, val int, PRIMARY KEY (key, ck));").get();
+        for (int key = 0; key < 20; ++key) {
+            for (int ck = 0; ck < 3; ++ck) {
+                e.execute_cql(format("INSERT INTO my_table (key, ck, val) VALUES ({:d}, {:d}, {:d});", key, ck, key + ck)).get();
+            }
+        }
+
+        e.execute_cql("CREATE FUNCTION my_sum_state(acc int, val int) RETURNS NULL ON NULL INPUT RETURNS int LANGUAGE Lua AS 'return acc + val';").get();
+        e.execute_cql("CREATE FUNCTION my_reduce(a int, b int) RETURNS NULL ON NULL INPUT RETURNS int LANGUAGE Lua AS 'return a + b';").get();
+        e.execute_cql("CREATE FUNCTION my_bad_reduce(a int, b int) RETURNS NULL ON NULL INPUT RETURNS bigint LANGUAGE Lua AS 'return a + b';").get();
+
+        auto fut = e.execute_cql("CREATE AGGREGATE my_sum(int) SFUNC my_sum_state STYPE int REDUCEFUNC my_missing_func INITCOND 0;");
+        BOOST_REQUIRE_EXCEPTION(fut.get(), ire, message_equals("Reduce function ks.my_missing_func(int, int) doesn't exist"));
+        fut = e.execute_cql("CREATE AGGREGATE my_sum(int) SFUNC my_sum_state STYPE int REDUCEFUNC my_bad_reduce INITCOND 0;");
+        BOOST_REQUIRE_EXCEPTION(fut.get(), ire, message_contains("must return int"));
+
+        e.execute_cql("CREATE AGGREGATE my_sum(int) SFUNC my_sum_state STYPE int REDUCEFUNC my_reduce INITCOND 0;").get();
+        e.execute_cql("CREATE AGGREGATE my_sequential_sum(int) SFUNC my_sum_state STYPE int INITCOND 0;").get();
+
+        // Only the reducible aggregate is computed by the replicas.
+        auto& stats = e.local_qp().get_cql_stats();
+        auto parallelized = stats.select_parallelized_aggregates;
+        auto msg = e.execute_cql("SELECT my_sum(val), count(*) FROM my_table;").get0();
+        assert_that(msg).is_rows().with_rows({{serialized(630), serialized(int64_t(60))}});
+        BOOST_REQUIRE_EQUAL(stats.select_parallelized_aggregates, parallelized + 1);
+        msg = e.execute_cql("SELECT my_sequential_sum(val) FROM my_table;").get0();
+        assert_that(msg).is_rows().with_rows({{serialized(630)}});
+        BOOST_REQUIRE_EQUAL(stats.select_parallelized_aggregates, parallelized + 1);
+
+        msg = e.execute_cql("SELECT reduce_func FROM system_schema.scylla_aggregates WHERE keyspace_name = 'ks' AND aggregate_name = 'my_sum';").get0();
+        assert_that(msg).is_rows().with_rows({{serialized("my_reduce")}});
+
+        fut = e.execute_cql("DROP FUNCTION my_reduce;");
+        BOOST_REQUIRE_EXCEPTION(fut.get(), ire, message_contains("is used by aggregate"));
+
+        // Replacing the aggregate without REDUCEFUNC makes it sequential again.
+        e.execute_cql("CREATE OR REPLACE AGGREGATE my_sum(int) SFUNC my_sum_state STYPE int INITCOND 0;").get();
+        msg = e.execute_cql("SELECT reduce_func FROM system_schema.scylla_aggregates WHERE keyspace_name = 'ks' AND aggregate_name = 'my_sum';").get0();
+        assert_that(msg).is_rows().is_empty();
+        msg = e.execute_cql("SELECT my_sum(val) FROM my_table;").get0();
+        assert_that(msg).is_rows().with_rows({{serialized(630)}});
+        BOOST_REQUIRE_EQUAL(stats.select_parallelized_aggregates, parallelized + 1);
+        e.execute_cql("DROP FUNCTION my_reduce;").get();
+    });
+}
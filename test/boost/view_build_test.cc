@@ -458,3 +458,45 @@ SEASTAR_TEST_CASE(test_view_update_generator) {
         });
     });
 }
+
+SEASTAR_TEST_CASE(test_view_update_generator_overlapping_staging_sstables) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table t (p text, c text, v text, primary key (p, c))").get();
+        e.execute_cql("create materialized view tv as select * from t "
+                "where p is not null and c is not null and v is not null primary key (v, p, c)").get();
+        e.execute_cql("insert into t (p, c, v) values ('a', 'c0', 'x') using timestamp 1234").get();
+
+        auto& view_update_generator = e.local_view_update_generator();
+        lw_shared_ptr<table> t = e.local_db().find_column_family("ks", "t").shared_from_this();
+        auto s = t->schema();
+        auto col = s->get_column_definition("v");
+        auto make_staging_sstable = [&] (sstring v, api::timestamp_type ts) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes("a")}));
+            auto& row = m.partition().clustered_row(*s, clustering_key::from_exploded(*s, {to_bytes("c0")}));
+            row.apply(row_marker(ts));
+            row.cells().apply(*col, atomic_cell::make_live(*col->type, ts, col->type->decompose(v)));
+            auto sst = t->make_streaming_staging_sstable();
+            sstables::sstable_writer_config sst_cfg = test_sstables_manager.configure_writer();
+            auto& pc = service::get_local_streaming_write_priority();
+            sst->write_components(flat_mutation_reader_from_mutations({m}), 1ul, s, sst_cfg, {}, pc).get();
+            sst->open_data().get();
+            t->add_sstable_and_update_cache(sst).get();
+            return sst;
+        };
+
+        // Both sstables update the same base row, the view must end up with the newest value only.
+        auto sst1 = make_staging_sstable("y", 2345);
+        auto sst2 = make_staging_sstable("z", 3456);
+        auto f1 = view_update_generator.register_staging_sstable(sst1, t);
+        auto f2 = view_update_generator.register_staging_sstable(sst2, t);
+        f1.get();
+        f2.get();
+
+        eventually([&] {
+            auto msg = e.execute_cql("SELECT v, p, c FROM tv").get0();
+            assert_that(msg).is_rows().with_rows({
+                {{utf8_type->decompose(sstring("z"))}, {utf8_type->decompose(sstring("a"))}, {utf8_type->decompose(sstring("c0"))}},
+            });
+        });
+    });
+}
@@ -27,9 +27,11 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <random>
+#include <vector>
 
 using namespace seastar;
 
@@ -150,3 +152,43 @@ BOOST_AUTO_TEST_CASE(sanity_signed_examples) {
 BOOST_AUTO_TEST_CASE(sanity_signed_sweep) {
     check_roundtrip_sweep<signed_vint>(100'000, random_engine());
 }
+
+BOOST_AUTO_TEST_CASE(batch_unsigned_matches_single) {
+    auto& rng = random_engine();
+    // Mostly single-byte values, with multi-byte ones breaking up the runs.
+    std::uniform_int_distribution<uint64_t> small(0, 127);
+    std::uniform_int_distribution<uint64_t> any;
+    std::bernoulli_distribution is_small(0.9);
+
+    std::vector<uint64_t> values(1000);
+    std::generate(values.begin(), values.end(), [&] { return is_small(rng) ? small(rng) : any(rng) >> (any(rng) % 64); });
+    // A long run of single-byte values.
+    std::fill_n(values.begin() + 100, 40, 7);
+
+    bytes serialized(bytes::initialized_later{}, values.size() * max_vint_length);
+    std::vector<size_t> ends;
+    auto dst = serialized.begin();
+    for (auto v : values) {
+        dst += unsigned_vint::serialize(v, dst);
+        ends.push_back(dst - serialized.begin());
+    }
+    const auto size = size_t(dst - serialized.begin());
+
+    std::vector<uint64_t> decoded(values.size());
+    for (size_t count : {size_t(0), size_t(1), size_t(3), size_t(16), size_t(17), values.size()}) {
+        auto r = unsigned_vint::deserialize_batch(bytes_view(serialized.data(), size), decoded.data(), count);
+        BOOST_REQUIRE_EQUAL(r.values, count);
+        BOOST_REQUIRE_EQUAL(r.bytes, count ? ends[count - 1] : 0);
+        BOOST_REQUIRE(std::equal(decoded.begin(), decoded.begin() + count, values.begin()));
+    }
+
+    // A vint cut off by the end of the input is not decoded.
+    for (size_t i = 0; i < 200; ++i) {
+        const auto cut = ends[i] - (ends[i] - (i ? ends[i - 1] : 0) > 1 ? 1 : 0);
+        auto r = unsigned_vint::deserialize_batch(bytes_view(serialized.data(), cut), decoded.data(), values.size());
+        const auto complete = cut == ends[i] ? i + 1 : i;
+        BOOST_REQUIRE_EQUAL(r.values, complete);
+        BOOST_REQUIRE_EQUAL(r.bytes, complete ? ends[complete - 1] : 0);
+        BOOST_REQUIRE(std::equal(decoded.begin(), decoded.begin() + complete, values.begin()));
+    }
+}
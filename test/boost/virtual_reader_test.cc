@@ -34,6 +34,7 @@
 
 #include "index/secondary_index_manager.hh"
 #include "db/size_estimates_virtual_reader.hh"
+#include "db/config.hh"
 #include "db/system_keyspace.hh"
 #include "db/view/view_builder.hh"
 #include <seastar/core/future-util.hh>
@@ -185,6 +186,57 @@ SEASTAR_TEST_CASE(test_query_size_estimates_virtual_table) {
     });
 }
 
+SEASTAR_TEST_CASE(test_size_estimates_follow_sstable_set) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table cf (pk int PRIMARY KEY, v int);").discard_result().get();
+        auto& cf = e.local_db().find_column_family("ks", "cf");
+        auto ranges = db::size_estimates::test_get_local_ranges(e.local_db()).get0();
+        auto total_partitions = [&] {
+            int64_t count = 0;
+            for (auto& r : ranges) {
+                auto start = dht::token::from_sstring(utf8_type->to_string(r.start));
+                auto end = dht::token::from_sstring(utf8_type->to_string(r.end));
+                count += cf.estimate_partitions(start, end).first;
+            }
+            return count;
+        };
+
+        BOOST_REQUIRE_EQUAL(total_partitions(), 0);
+
+        for (int i = 0; i < 10; ++i) {
+            e.execute_cql(format("insert into cf (pk, v) values ({:d}, 1);", i)).discard_result().get();
+        }
+        cf.flush().get();
+        auto first = total_partitions();
+        BOOST_REQUIRE_GT(first, 0);
+
+        // The cached estimates are updated in place when an sstable is added.
+        for (int i = 10; i < 20; ++i) {
+            e.execute_cql(format("insert into cf (pk, v) values ({:d}, 1);", i)).discard_result().get();
+        }
+        cf.flush().get();
+        BOOST_REQUIRE_GT(total_partitions(), first);
+
+        e.execute_cql("truncate cf;").discard_result().get();
+        BOOST_REQUIRE_EQUAL(total_partitions(), 0);
+
+        // Partitions present in several sstables are counted once, thanks to
+        // the cardinality sketches of the sstables.
+        auto write_sstable = [&] {
+            for (int i = 0; i < 10; ++i) {
+                e.execute_cql(format("insert into cf (pk, v) values ({:d}, 1);", i)).discard_result().get();
+            }
+            cf.flush().get();
+        };
+        write_sstable();
+        auto distinct = total_partitions();
+        BOOST_REQUIRE_GT(distinct, 0);
+        write_sstable();
+        BOOST_REQUIRE_EQUAL(cf.sstables_count(), 2);
+        BOOST_REQUIRE_EQUAL(total_partitions(), distinct);
+    });
+}
+
 SEASTAR_TEST_CASE(test_query_view_built_progress_virtual_table) {
     return do_with_cql_env_thread([] (cql_test_env& e) {
         auto rand = [] { return dht::token::get_random_token(); };
@@ -259,3 +311,53 @@ SEASTAR_TEST_CASE(test_query_built_indexes_virtual_table) {
         assert_that(rs).is_rows().with_size(0);
     });
 }
+
+SEASTAR_TEST_CASE(test_query_token_shards_virtual_table) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        auto msg = e.execute_cql("select shard, range_start, range_end from system.token_shards").get0();
+        auto& rows = dynamic_cast<cql_transport::messages::result_message::rows&>(*msg).rs().result_set().rows();
+        BOOST_REQUIRE(!rows.empty());
+        auto s = e.local_db().find_schema("system", "token_shards");
+        for (auto& row : rows) {
+            auto shard = value_cast<int32_t>(int32_type->deserialize(*row[0]));
+            auto start = value_cast<int64_t>(long_type->deserialize(*row[1]));
+            auto end = value_cast<int64_t>(long_type->deserialize(*row[2]));
+            BOOST_REQUIRE_LT(start, end);
+            // Both ends of the (start, end] range are owned by the shard.
+            BOOST_REQUIRE_EQUAL(dht::shard_of(*s, dht::token::from_int64(start + 1)), unsigned(shard));
+            BOOST_REQUIRE_EQUAL(dht::shard_of(*s, dht::token::from_int64(end)), unsigned(shard));
+        }
+
+        auto rs = e.execute_cql("select * from system.token_shards where shard = 0").get0();
+        assert_that(rs).is_rows().with_size(boost::count_if(rows, [] (auto& row) {
+            return value_cast<int32_t>(int32_type->deserialize(*row[0])) == 0;
+        }));
+    });
+}
+
+SEASTAR_TEST_CASE(test_query_top_partitions_virtual_table) {
+    auto db_cfg = make_shared<db::config>();
+    db_cfg->toppartitions_sampling_ratio.set(1);
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("create table ks.cf (p text, v int, primary key (p))").get();
+        for (int i = 0; i < 3; ++i) {
+            e.execute_cql("insert into ks.cf (p, v) values ('hot', 1)").get();
+        }
+        e.execute_cql("insert into ks.cf (p, v) values ('cold', 1)").get();
+        e.execute_cql("select * from ks.cf where p = 'hot'").get();
+
+        auto msg = e.execute_cql("select rank, partition_key, count, error from system.top_partitions "
+                "where keyspace_name = 'ks' and table_name = 'cf' and ranking = 'writes'").get0();
+        auto& rows = dynamic_cast<cql_transport::messages::result_message::rows&>(*msg).rs().result_set().rows();
+        BOOST_REQUIRE_EQUAL(rows.size(), 2);
+        BOOST_REQUIRE_EQUAL(value_cast<int32_t>(int32_type->deserialize(*rows[0][0])), 1);
+        BOOST_REQUIRE_EQUAL(value_cast<int64_t>(long_type->deserialize(*rows[0][2])), 3);
+        BOOST_REQUIRE_EQUAL(value_cast<int64_t>(long_type->deserialize(*rows[0][3])), 0);
+        BOOST_REQUIRE_EQUAL(value_cast<int64_t>(long_type->deserialize(*rows[1][2])), 1);
+        BOOST_REQUIRE_NE(value_cast<sstring>(utf8_type->deserialize(*rows[0][1])), value_cast<sstring>(utf8_type->deserialize(*rows[1][1])));
+
+        auto rs = e.execute_cql("select count from system.top_partitions "
+                "where keyspace_name = 'ks' and table_name = 'cf' and ranking = 'reads'").get0();
+        assert_that(rs).is_rows().with_rows({{long_type->decompose(int64_t(1))}});
+    }, db_cfg);
+}
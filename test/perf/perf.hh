@@ -24,11 +24,21 @@
 #include <seastar/core/print.hh>
 #include <seastar/core/future-util.hh>
 #include <seastar/core/distributed.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/memory.hh>
+#include <seastar/core/smp.hh>
 #include "seastarx.hh"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iosfwd>
+#include <vector>
 #include <boost/range/irange.hpp>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 template <typename Func>
 static
@@ -126,3 +136,228 @@ std::vector<double> time_parallel(Func func, unsigned concurrency_per_core, int
     }
     return results;
 }
+
+// A latency histogram with HDR-style buckets: values, in microseconds, are
+// bucketed by their power of two, and each power of two is split into
+// sub_buckets linear buckets, so percentiles are accurate to within
+// 1/sub_buckets of their value.
+class latency_histogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 7;
+    static constexpr unsigned sub_buckets = 1 << sub_bucket_bits;
+    // Values of 2^(max_exponent + 1) microseconds (about 2 hours) and more
+    // fall into the last bucket.
+    static constexpr unsigned max_exponent = 32;
+    static constexpr size_t bucket_count = sub_buckets * (max_exponent - sub_bucket_bits + 2);
+private:
+    std::vector<uint64_t> _buckets = std::vector<uint64_t>(bucket_count);
+    uint64_t _count = 0;
+    uint64_t _max = 0;
+private:
+    static size_t bucket_of(uint64_t us) {
+        if (us < sub_buckets) {
+            return us;
+        }
+        unsigned exponent = 63 - __builtin_clzll(us);
+        if (exponent > max_exponent) {
+            return bucket_count - 1;
+        }
+        auto shift = exponent - sub_bucket_bits;
+        return sub_buckets * (shift + 1) + ((us >> shift) - sub_buckets);
+    }
+
+    // The greatest value falling into the bucket.
+    static uint64_t upper_bound_of(size_t bucket) {
+        if (bucket < sub_buckets) {
+            return bucket;
+        }
+        auto shift = bucket / sub_buckets - 1;
+        auto sub = bucket % sub_buckets;
+        return ((sub_buckets + sub + 1) << shift) - 1;
+    }
+public:
+    template <typename Rep, typename Period>
+    void add(std::chrono::duration<Rep, Period> latency) {
+        auto us = uint64_t(std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count(), 0));
+        ++_buckets[bucket_of(us)];
+        ++_count;
+        _max = std::max(_max, us);
+    }
+
+    latency_histogram& operator+=(const latency_histogram& o) {
+        for (size_t i = 0; i < bucket_count; ++i) {
+            _buckets[i] += o._buckets[i];
+        }
+        _count += o._count;
+        _max = std::max(_max, o._max);
+        return *this;
+    }
+
+    uint64_t count() const {
+        return _count;
+    }
+
+    std::chrono::microseconds max() const {
+        return std::chrono::microseconds(_max);
+    }
+
+    // Returns the given percentile (0 to 1) of the latencies.
+    std::chrono::microseconds percentile(double p) const {
+        auto target = uint64_t(std::ceil(p * _count));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            seen += _buckets[i];
+            if (seen >= target && seen) {
+                return std::chrono::microseconds(std::min(upper_bound_of(i), _max));
+            }
+        }
+        return max();
+    }
+};
+
+// Like executor, but starts the action at a fixed rate, regardless of how
+// long earlier invocations take (open loop), with at most max_in_flight of
+// them outstanding. The action receives the time it was meant to start at,
+// so that latencies measured from it include the time spent waiting to be
+// started and aren't hidden by a slow system (coordinated omission).
+template <typename Func>
+class rate_executor {
+public:
+    using clock = std::chrono::steady_clock;
+private:
+    const Func _func;
+    const lowres_clock::time_point _end_at;
+    const clock::duration _interval;
+    const unsigned _max_in_flight;
+    semaphore _in_flight;
+    uint64_t _count = 0;
+    std::exception_ptr _ex;
+public:
+    rate_executor(unsigned max_in_flight, Func func, lowres_clock::time_point end_at, double ops_per_second)
+            : _func(std::move(func))
+            , _end_at(end_at)
+            , _interval(std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1 / ops_per_second)))
+            , _max_in_flight(max_in_flight)
+            , _in_flight(max_in_flight)
+    { }
+
+    // Returns the number of invocations of @func
+    future<uint64_t> run() {
+        return do_with(clock::now(), [this] (clock::time_point& next) {
+            return do_until([this] {
+                return lowres_clock::now() >= _end_at;
+            }, [this, &next] {
+                auto start = next;
+                next += _interval;
+                return get_units(_in_flight, 1).then([this, start, &next] (auto units) {
+                    ++_count;
+                    // Waited for below, through _in_flight.
+                    (void)futurize_invoke(_func, start).then_wrapped([this, units = std::move(units)] (future<> f) {
+                        if (f.failed()) {
+                            _ex = f.get_exception();
+                        }
+                    });
+                    auto now = clock::now();
+                    return next > now ? sleep(next - now) : make_ready_future<>();
+                });
+            });
+        }).then([this] {
+            return get_units(_in_flight, _max_in_flight);
+        }).then([this] (auto units) {
+            if (_ex) {
+                return make_exception_future<uint64_t>(_ex);
+            }
+            return make_ready_future<uint64_t>(_count);
+        });
+    }
+
+    future<> stop() {
+        return make_ready_future<>();
+    }
+};
+
+/**
+ * Like time_parallel(), but runs the action at a fixed rate on every core
+ * (see rate_executor). The action is called with the time it was meant to
+ * start at.
+ *
+ * Returns a vector of throughputs achieved in each iteration.
+ */
+template <typename Func>
+static
+std::vector<double> time_parallel_at_rate(Func func, double ops_per_second_per_core, unsigned max_in_flight_per_core, int iterations = 5) {
+    using clk = std::chrono::steady_clock;
+    std::vector<double> results;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = clk::now();
+        auto end_at = lowres_clock::now() + std::chrono::seconds(1);
+        distributed<rate_executor<Func>> exec;
+        exec.start(max_in_flight_per_core, func, std::move(end_at), ops_per_second_per_core).get();
+        auto total = exec.map_reduce(adder<uint64_t>(), [] (auto& oc) { return oc.run(); }).get0();
+        auto end = clk::now();
+        auto duration = std::chrono::duration<double>(end - start).count();
+        auto result = static_cast<double>(total) / duration;
+        std::cout << format("{:.2f}", result) << " tps\n";
+        results.emplace_back(result);
+        exec.stop().get();
+    }
+    return results;
+}
+
+// Counts the instructions retired by the calling thread in user space.
+// Reads 0 if hardware counters aren't available (e.g. in a VM, or because
+// of kernel.perf_event_paranoid).
+class instructions_counter {
+    int _fd;
+public:
+    instructions_counter() {
+        struct ::perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        _fd = ::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    instructions_counter(const instructions_counter&) = delete;
+    ~instructions_counter() {
+        if (_fd >= 0) {
+            ::close(_fd);
+        }
+    }
+    bool available() const {
+        return _fd >= 0;
+    }
+    uint64_t read() const {
+        uint64_t value = 0;
+        if (_fd < 0 || ::read(_fd, &value, sizeof(value)) != sizeof(value)) {
+            return 0;
+        }
+        return value;
+    }
+};
+
+// Instructions and memory allocations of all shards, so that a benchmark
+// can report them per operation.
+struct perf_counters {
+    uint64_t instructions = 0;
+    uint64_t allocations = 0;
+
+    perf_counters operator-(const perf_counters& o) const {
+        return {instructions - o.instructions, allocations - o.allocations};
+    }
+};
+
+inline perf_counters read_local_perf_counters() {
+    static thread_local instructions_counter instructions;
+    return {instructions.read(), memory::stats().mallocs()};
+}
+
+inline future<perf_counters> read_perf_counters() {
+    auto shards = boost::irange(0u, smp::count);
+    return map_reduce(shards.begin(), shards.end(), [] (unsigned shard) {
+        return smp::submit_to(shard, [] { return read_local_perf_counters(); });
+    }, perf_counters{}, [] (perf_counters total, perf_counters c) {
+        return perf_counters{total.instructions + c.instructions, total.allocations + c.allocations};
+    });
+}
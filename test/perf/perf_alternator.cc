@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Runs Alternator requests through alternator::executor in-process, the way
+// alternator::server would after receiving them, without the network and
+// HTTP layers. Requests are parsed from JSON and responses are serialized,
+// so their cost is included. Reports throughput and, per operation,
+// instructions retired and memory allocations.
+
+#include <random>
+
+#include <boost/range/irange.hpp>
+#include "test/lib/cql_test_env.hh"
+#include "test/perf/perf.hh"
+#include <seastar/core/app-template.hh>
+#include <seastar/core/iostream.hh>
+#include <seastar/testing/test_runner.hh>
+#include "alternator/executor.hh"
+#include "alternator/rjson.hh"
+#include "service/migration_manager.hh"
+#include "service/storage_proxy.hh"
+#include "utils/overloaded_functor.hh"
+#include <seastar/util/defer.hh>
+
+static const sstring table_name = "perf";
+
+struct test_config {
+    enum class operation { put_item, get_item, query, batch_write_item };
+    operation op;
+    unsigned partitions;
+    unsigned rows_per_partition;
+    unsigned attributes;
+    unsigned attribute_size;
+    unsigned batch_size;
+    unsigned concurrency;
+    unsigned duration_in_seconds;
+};
+
+static const std::unordered_map<sstring, test_config::operation> operations = {
+    {"PutItem", test_config::operation::put_item},
+    {"GetItem", test_config::operation::get_item},
+    {"Query", test_config::operation::query},
+    {"BatchWriteItem", test_config::operation::batch_write_item},
+};
+
+// Discards everything written to it, standing in for the HTTP connection.
+class null_data_sink_impl : public data_sink_impl {
+public:
+    virtual future<> put(net::packet) override {
+        return make_ready_future<>();
+    }
+    virtual future<> flush() override {
+        return make_ready_future<>();
+    }
+    virtual future<> close() override {
+        return make_ready_future<>();
+    }
+};
+
+class request_generator {
+    const test_config& _cfg;
+    sstring _value;
+public:
+    explicit request_generator(const test_config& cfg)
+        : _cfg(cfg)
+        , _value(_cfg.attribute_size, 'x')
+    { }
+
+    static sstring key(unsigned p, unsigned c) {
+        return format("\"p\": {{\"S\": \"key{}\"}}, \"c\": {{\"N\": \"{}\"}}", p, c);
+    }
+
+    sstring item(unsigned p, unsigned c) const {
+        sstring item = key(p, c);
+        for (unsigned i = 0; i < _cfg.attributes; ++i) {
+            item += format(", \"a{}\": {{\"S\": \"{}\"}}", i, _value);
+        }
+        return "{" + item + "}";
+    }
+
+    sstring put_item(unsigned p, unsigned c) const {
+        return format("{{\"TableName\": \"{}\", \"Item\": {}}}", table_name, item(p, c));
+    }
+
+    sstring get_item(unsigned p, unsigned c) const {
+        return format("{{\"TableName\": \"{}\", \"Key\": {{{}}}}}", table_name, key(p, c));
+    }
+
+    sstring query(unsigned p) const {
+        return format("{{\"TableName\": \"{}\", \"KeyConditionExpression\": \"p = :p\", "
+                "\"ExpressionAttributeValues\": {{\":p\": {{\"S\": \"key{}\"}}}}}}", table_name, p);
+    }
+
+    sstring batch_write_item(unsigned p, unsigned first_c, unsigned count) const {
+        sstring puts;
+        for (unsigned i = 0; i < count; ++i) {
+            puts += format("{}{{\"PutRequest\": {{\"Item\": {}}}}}", i ? ", " : "", item(p, (first_c + i) % _cfg.rows_per_partition));
+        }
+        return format("{{\"RequestItems\": {{\"{}\": [{}]}}}}", table_name, puts);
+    }
+};
+
+using executor_method = future<alternator::executor::request_return_type> (alternator::executor::*)(
+        alternator::executor::client_state&, tracing::trace_state_ptr, service_permit, rjson::value);
+
+static future<> execute(sharded<alternator::executor>& executor, executor_method method, sstring request) {
+    return do_with(std::make_unique<alternator::executor::client_state>(alternator::executor::client_state::internal_tag()),
+            [&executor, method, request = std::move(request)] (std::unique_ptr<alternator::executor::client_state>& client_state) {
+        return (executor.local().*method)(*client_state, tracing::trace_state_ptr(), empty_service_permit(), rjson::parse(request));
+    }).then([] (alternator::executor::request_return_type ret) {
+        // The body writer refers to the response, which must outlive it.
+        return do_with(std::move(ret), [] (alternator::executor::request_return_type& ret) {
+            return std::visit(overloaded_functor {
+                [] (const json::json_return_type& r) {
+                    if (!r._body_writer) {
+                        return make_ready_future<>();
+                    }
+                    return r._body_writer(output_stream<char>(data_sink(std::make_unique<null_data_sink_impl>())));
+                },
+                [] (const alternator::api_error& e) {
+                    return make_exception_future<>(std::runtime_error(format("{}: {}", e._type, e._msg)));
+                }
+            }, ret);
+        });
+    });
+}
+
+static void create_table(sharded<alternator::executor>& executor) {
+    execute(executor, &alternator::executor::create_table, format("{{\"TableName\": \"{}\", "
+            "\"BillingMode\": \"PAY_PER_REQUEST\", "
+            "\"KeySchema\": [{{\"AttributeName\": \"p\", \"KeyType\": \"HASH\"}}, {{\"AttributeName\": \"c\", \"KeyType\": \"RANGE\"}}], "
+            "\"AttributeDefinitions\": [{{\"AttributeName\": \"p\", \"AttributeType\": \"S\"}}, {{\"AttributeName\": \"c\", \"AttributeType\": \"N\"}}]}}",
+            table_name)).get();
+}
+
+static void populate(sharded<alternator::executor>& executor, const test_config& cfg) {
+    std::cout << "Populating " << cfg.partitions * cfg.rows_per_partition << " items...\n";
+    request_generator gen(cfg);
+    for (unsigned p = 0; p < cfg.partitions; ++p) {
+        for (unsigned c = 0; c < cfg.rows_per_partition; c += 25) {
+            execute(executor, &alternator::executor::batch_write_item, gen.batch_write_item(p, c, std::min(25u, cfg.rows_per_partition - c))).get();
+        }
+    }
+}
+
+static std::vector<double> do_test(sharded<alternator::executor>& executor, const test_config& cfg) {
+    create_table(executor);
+    if (cfg.op != test_config::operation::put_item && cfg.op != test_config::operation::batch_write_item) {
+        populate(executor, cfg);
+    }
+
+    auto op = [&executor, &cfg, gen = request_generator(cfg)] () -> future<> {
+        auto& rng = seastar::testing::local_random_engine;
+        auto p = rng() % cfg.partitions;
+        auto c = rng() % cfg.rows_per_partition;
+        switch (cfg.op) {
+        case test_config::operation::put_item:
+            return execute(executor, &alternator::executor::put_item, gen.put_item(p, c));
+        case test_config::operation::get_item:
+            return execute(executor, &alternator::executor::get_item, gen.get_item(p, c));
+        case test_config::operation::query:
+            return execute(executor, &alternator::executor::query, gen.query(p));
+        case test_config::operation::batch_write_item:
+            return execute(executor, &alternator::executor::batch_write_item, gen.batch_write_item(p, c, cfg.batch_size));
+        }
+        abort();
+    };
+
+    // Runs one iteration at a time, so that the counters can be read
+    // between them.
+    std::vector<double> results;
+    auto counters = read_perf_counters().get0();
+    for (unsigned i = 0; i < cfg.duration_in_seconds; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        auto tps = time_parallel(op, cfg.concurrency, 1)[0];
+        auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto now = read_perf_counters().get0();
+        auto diff = now - counters;
+        counters = now;
+        auto ops = std::max(1.0, tps * duration);
+        std::cout << format("  {:.0f} instructions/op, {:.1f} allocations/op\n", diff.instructions / ops, diff.allocations / ops);
+        results.push_back(tps);
+    }
+    return results;
+}
+
+int main(int argc, char** argv) {
+    namespace bpo = boost::program_options;
+    app_template app;
+    app.add_options()
+        ("random-seed", bpo::value<unsigned>(), "Random number generator seed")
+        ("operation", bpo::value<sstring>()->default_value("GetItem"), "one of: PutItem, GetItem, Query, BatchWriteItem")
+        ("partitions", bpo::value<unsigned>()->default_value(10000), "number of partitions")
+        ("rows-per-partition", bpo::value<unsigned>()->default_value(1), "number of items per partition, read by Query")
+        ("attributes", bpo::value<unsigned>()->default_value(5), "number of non-key attributes of an item")
+        ("attribute-size", bpo::value<unsigned>()->default_value(64), "size of each attribute, in bytes")
+        ("batch-size", bpo::value<unsigned>()->default_value(25), "items per BatchWriteItem request")
+        ("duration", bpo::value<unsigned>()->default_value(5), "test duration in seconds")
+        ("concurrency", bpo::value<unsigned>()->default_value(100), "workers per core")
+        ;
+
+    return app.run(argc, argv, [&app] {
+        auto conf_seed = app.configuration()["random-seed"];
+        auto seed = conf_seed.empty() ? std::random_device()() : conf_seed.as<unsigned>();
+        std::cout << "random-seed=" << seed << '\n';
+        smp::invoke_on_all([seed] {
+            seastar::testing::local_random_engine.seed(seed + this_shard_id());
+        }).get();
+
+        return do_with_cql_env_thread([&app] (cql_test_env& env) {
+            test_config cfg;
+            auto op_name = app.configuration()["operation"].as<sstring>();
+            auto op = operations.find(op_name);
+            if (op == operations.end()) {
+                throw std::invalid_argument(format("unknown operation: {}", op_name));
+            }
+            cfg.op = op->second;
+            cfg.partitions = std::max(1u, app.configuration()["partitions"].as<unsigned>());
+            cfg.rows_per_partition = std::max(1u, app.configuration()["rows-per-partition"].as<unsigned>());
+            cfg.attributes = app.configuration()["attributes"].as<unsigned>();
+            cfg.attribute_size = app.configuration()["attribute-size"].as<unsigned>();
+            cfg.batch_size = std::clamp(app.configuration()["batch-size"].as<unsigned>(), 1u, 25u);
+            cfg.concurrency = app.configuration()["concurrency"].as<unsigned>();
+            cfg.duration_in_seconds = app.configuration()["duration"].as<unsigned>();
+
+            if (!read_local_perf_counters().instructions) {
+                std::cout << "Hardware instruction counters are not available, instructions/op will read 0\n";
+            }
+
+            sharded<alternator::executor> executor;
+            executor.start(std::ref(service::get_storage_proxy()), std::ref(service::get_migration_manager()), default_smp_service_group()).get();
+            auto stop_executor = defer([&executor] { executor.stop().get(); });
+            executor.invoke_on_all(&alternator::executor::start).get();
+
+            auto results = do_test(executor, cfg);
+
+            std::sort(results.begin(), results.end());
+            auto median = results[results.size() / 2];
+            auto min = results[0];
+            auto max = results[results.size() - 1];
+            for (auto& r : results) {
+                r = abs(r - median);
+            }
+            std::sort(results.begin(), results.end());
+            auto mad = results[results.size() / 2];
+            std::cout << format("\nmedian {:.2f}\nmedian absolute deviation: {:.2f}\nmaximum: {:.2f}\nminimum: {:.2f}\n", median, mad, max, min);
+        });
+    });
+}
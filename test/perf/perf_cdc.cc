@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "seastar/include/seastar/testing/perf_tests.hh"
+
+#include "test/lib/simple_schema.hh"
+
+#include "cdc/split.hh"
+#include "mutation.hh"
+
+namespace tests {
+
+class cdc_changes {
+    mutable simple_schema _schema;
+    mutation _insert;
+    mutation _partition_delete;
+    mutation _multi_timestamp;
+public:
+    cdc_changes()
+        : _insert(_schema.new_mutation("pk"))
+        , _partition_delete(_schema.new_mutation("pk"))
+        , _multi_timestamp(_schema.new_mutation("pk"))
+    {
+        auto ck = _schema.make_ckey(0);
+        auto ts = _schema.add_row(_insert, ck, "value");
+        _insert.partition().clustered_row(*_schema.schema(), ck).apply(row_marker(ts));
+
+        _partition_delete.partition().apply(tombstone(_schema.new_timestamp(), gc_clock::now()));
+
+        for (uint32_t i = 0; i < 4; ++i) {
+            _schema.add_row(_multi_timestamp, _schema.make_ckey(i), "value");
+        }
+    }
+
+    schema_ptr schema() const { return _schema.schema(); }
+
+    const mutation& insert() const { return _insert; }
+    const mutation& partition_delete() const { return _partition_delete; }
+    const mutation& multi_timestamp() const { return _multi_timestamp; }
+};
+
+PERF_TEST_F(cdc_changes, should_split_insert) {
+    perf_tests::do_not_optimize(cdc::should_split(insert(), *schema()));
+}
+
+PERF_TEST_F(cdc_changes, should_split_partition_delete) {
+    perf_tests::do_not_optimize(cdc::should_split(partition_delete(), *schema()));
+}
+
+PERF_TEST_F(cdc_changes, should_split_multi_timestamp) {
+    perf_tests::do_not_optimize(cdc::should_split(multi_timestamp(), *schema()));
+}
+
+PERF_TEST_F(cdc_changes, for_each_change_multi_timestamp) {
+    size_t changes = 0;
+    cdc::for_each_change(multi_timestamp(), schema(), [&] (mutation m, api::timestamp_type, bytes, int&) {
+        perf_tests::do_not_optimize(m);
+        ++changes;
+    });
+    return changes;
+}
+
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <json/json.h>
+#include <random>
+
+#include <seastar/core/app-template.hh>
+#include <seastar/core/distributed.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/testing/test_runner.hh>
+#include <seastar/util/defer.hh>
+
+#include "db/commitlog/commitlog.hh"
+#include "test/lib/tmpdir.hh"
+#include "test/perf/perf.hh"
+#include "utils/UUID_gen.hh"
+
+struct test_config {
+    size_t entry_size;
+    unsigned concurrency;
+    unsigned duration_in_seconds;
+    db::commitlog::sync_mode mode;
+    db::commitlog::force_sync sync;
+    bool reuse_segments;
+    bool use_o_dsync;
+    uint64_t segment_size_in_mb;
+    uint64_t total_space_in_mb;
+    uint64_t sync_period_in_ms;
+};
+
+std::ostream& operator<<(std::ostream& os, const test_config& cfg) {
+    return os << "{entry_size=" << cfg.entry_size
+           << ", concurrency=" << cfg.concurrency
+           << ", mode=" << (cfg.mode == db::commitlog::sync_mode::BATCH ? "batch" : "periodic")
+           << ", sync=" << (cfg.sync ? "yes" : "no")
+           << ", reuse_segments=" << (cfg.reuse_segments ? "yes" : "no")
+           << ", o_dsync=" << (cfg.use_o_dsync ? "yes" : "no")
+           << ", segment_size_in_mb=" << cfg.segment_size_in_mb
+           << "}";
+}
+
+// The commitlog of a shard, with the latencies of the entries added to it.
+class commitlog_shard {
+    std::optional<db::commitlog> _log;
+    const utils::UUID _id = utils::UUID_gen::get_time_UUID();
+    const sstring _location;
+    const test_config& _cfg;
+    bytes _payload;
+    latency_histogram _latencies;
+public:
+    commitlog_shard(sstring location, const test_config& cfg)
+            : _location(std::move(location))
+            , _cfg(cfg)
+            , _payload(bytes::initialized_later(), cfg.entry_size) {
+        std::generate(_payload.begin(), _payload.end(), [] { return int8_t(seastar::testing::local_random_engine()); });
+    }
+
+    future<> start() {
+        db::commitlog::config cl_cfg;
+        cl_cfg.commit_log_location = _location;
+        cl_cfg.metrics_category_name = "commitlog";
+        cl_cfg.mode = cfg.mode;
+        cl_cfg.reuse_segments = cfg.reuse_segments;
+        cl_cfg.use_o_dsync = cfg.use_o_dsync;
+        cl_cfg.commitlog_segment_size_in_mb = cfg.segment_size_in_mb;
+        cl_cfg.commitlog_total_space_in_mb = cfg.total_space_in_mb;
+        cl_cfg.commitlog_sync_period_in_ms = cfg.sync_period_in_ms;
+        return db::commitlog::create_commitlog(std::move(cl_cfg)).then([this] (db::commitlog log) {
+            _log.emplace(std::move(log));
+        });
+    }
+
+    // Adds an entry and drops its handle right away, so that segments can be
+    // recycled or deleted as soon as they are written.
+    future<> add_entry() {
+        auto start = std::chrono::steady_clock::now();
+        return _log->add_mutation(_id, _payload.size(), _cfg.sync, [this] (db::commitlog::output& out) {
+            out.write(reinterpret_cast<const char*>(_payload.data()), _payload.size());
+        }).then([this, start] (db::rp_handle) {
+            _latencies.add(std::chrono::steady_clock::now() - start);
+        });
+    }
+
+    struct stats {
+        latency_histogram latencies;
+        uint64_t bytes_written = 0;
+        uint64_t flushes = 0;
+        uint64_t segments_created = 0;
+
+        stats& operator+=(const stats& o) {
+            latencies += o.latencies;
+            bytes_written += o.bytes_written;
+            flushes += o.flushes;
+            segments_created += o.segments_created;
+            return *this;
+        }
+    };
+
+    stats get_stats() const {
+        return stats{_latencies, _log->get_bytes_written(), _log->get_flush_count(), _log->get_num_segments_created()};
+    }
+
+    future<> stop() {
+        if (!_log) {
+            return make_ready_future<>();
+        }
+        return _log->shutdown().then([this] {
+            return _log->clear();
+        });
+    }
+};
+
+struct test_results : commitlog_shard::stats {
+    std::vector<double> throughput;
+};
+
+static test_results do_test(const sstring& location, const test_config& cfg) {
+    std::cout << "Running test with config: " << cfg << std::endl;
+    distributed<commitlog_shard> shards;
+    shards.start(location, std::cref(cfg)).get();
+    auto stop = defer([&shards] { shards.stop().get(); });
+    shards.invoke_on_all(&commitlog_shard::start).get();
+
+    test_results res;
+    res.throughput = time_parallel([&shards] {
+        return shards.local().add_entry();
+    }, cfg.concurrency, cfg.duration_in_seconds);
+    for (unsigned shard = 0; shard < smp::count; ++shard) {
+        res += shards.invoke_on(shard, &commitlog_shard::get_stats).get0();
+    }
+    return res;
+}
+
+static void write_json_result(std::string result_file, const test_config& cfg, const test_results& res, double median, double mad) {
+    Json::Value results;
+
+    Json::Value params;
+    params["entry_size"] = Json::UInt64(cfg.entry_size);
+    params["concurrency"] = cfg.concurrency;
+    params["cpus"] = smp::count;
+    params["duration"] = cfg.duration_in_seconds;
+    params["mode"] = cfg.mode == db::commitlog::sync_mode::BATCH ? "batch" : "periodic";
+    params["sync"] = bool(cfg.sync);
+    params["reuse_segments"] = cfg.reuse_segments;
+    params["o_dsync"] = cfg.use_o_dsync;
+    params["segment_size_in_mb"] = Json::UInt64(cfg.segment_size_in_mb);
+    results["parameters"] = std::move(params);
+
+    Json::Value stats;
+    stats["median ops"] = median;
+    stats["mad ops"] = mad;
+    stats["median MB/s"] = median * cfg.entry_size / (1 << 20);
+    for (auto p : {50, 90, 99}) {
+        stats[format("p{} latency us", p)] = Json::Int64(res.latencies.percentile(p / 100.0).count());
+    }
+    stats["p99.9 latency us"] = Json::Int64(res.latencies.percentile(0.999).count());
+    stats["max latency us"] = Json::Int64(res.latencies.max().count());
+    stats["bytes written"] = Json::UInt64(res.bytes_written);
+    stats["flushes"] = Json::UInt64(res.flushes);
+    stats["segments created"] = Json::UInt64(res.segments_created);
+    results["stats"] = std::move(stats);
+
+    auto out = std::ofstream(result_file);
+    out << results;
+}
+
+int main(int argc, char** argv) {
+    namespace bpo = boost::program_options;
+    app_template app;
+    app.add_options()
+        ("random-seed", bpo::value<unsigned>(), "Random number generator seed")
+        ("entry-size", bpo::value<size_t>()->default_value(1024), "size of the entries in bytes")
+        ("concurrency", bpo::value<unsigned>()->default_value(100), "writers per core")
+        ("duration", bpo::value<unsigned>()->default_value(5), "test duration in seconds")
+        ("batch", "sync the commitlog in BATCH mode instead of PERIODIC")
+        ("sync", "force a sync of every entry")
+        ("sync-period", bpo::value<uint64_t>()->default_value(10000), "sync period of the PERIODIC mode in milliseconds")
+        ("no-reuse-segments", "delete written segments instead of recycling them")
+        ("o-dsync", "open segments with O_DSYNC")
+        ("segment-size", bpo::value<uint64_t>()->default_value(32), "segment size in MB")
+        ("total-space", bpo::value<uint64_t>()->default_value(1024), "total commitlog space of the node in MB")
+        ("directory", bpo::value<sstring>(), "directory for the segments, a temporary one by default")
+        ("json-result", bpo::value<std::string>(), "name of the json result file")
+        ;
+
+    return app.run(argc, argv, [&app] {
+        auto conf_seed = app.configuration()["random-seed"];
+        auto seed = conf_seed.empty() ? std::random_device()() : conf_seed.as<unsigned>();
+        std::cout << "random-seed=" << seed << '\n';
+        return smp::invoke_on_all([seed] {
+            seastar::testing::local_random_engine.seed(seed + this_shard_id());
+        }).then([&app] {
+          return seastar::async([&app] {
+            auto& opts = app.configuration();
+            auto cfg = test_config();
+            cfg.entry_size = opts["entry-size"].as<size_t>();
+            cfg.concurrency = opts["concurrency"].as<unsigned>();
+            cfg.duration_in_seconds = opts["duration"].as<unsigned>();
+            cfg.mode = opts.count("batch") ? db::commitlog::sync_mode::BATCH : db::commitlog::sync_mode::PERIODIC;
+            cfg.sync = db::commitlog::force_sync(bool(opts.count("sync")));
+            cfg.sync_period_in_ms = opts["sync-period"].as<uint64_t>();
+            cfg.reuse_segments = !opts.count("no-reuse-segments");
+            cfg.use_o_dsync = opts.count("o-dsync");
+            cfg.segment_size_in_mb = opts["segment-size"].as<uint64_t>();
+            cfg.total_space_in_mb = opts["total-space"].as<uint64_t>();
+
+            std::optional<tmpdir> tmp;
+            sstring location;
+            if (opts.count("directory")) {
+                location = opts["directory"].as<sstring>();
+            } else {
+                tmp.emplace();
+                location = tmp->path().string();
+            }
+
+            auto res = do_test(location, cfg);
+
+            auto results = res.throughput;
+            std::sort(results.begin(), results.end());
+            auto median = results[results.size() / 2];
+            for (auto& r : results) {
+                r = std::abs(r - median);
+            }
+            std::sort(results.begin(), results.end());
+            auto mad = results[results.size() / 2];
+            std::cout << format("\nmedian {:.2f} ops/s ({:.2f} MB/s)\nmedian absolute deviation: {:.2f}\n",
+                    median, median * cfg.entry_size / (1 << 20), mad);
+            std::cout << format("latency (us): p50 {} p90 {} p99 {} p99.9 {} max {}\n",
+                    res.latencies.percentile(0.5).count(), res.latencies.percentile(0.9).count(),
+                    res.latencies.percentile(0.99).count(), res.latencies.percentile(0.999).count(),
+                    res.latencies.max().count());
+            std::cout << format("bytes written: {}\nflushes: {}\nsegments created: {}\n",
+                    res.bytes_written, res.flushes, res.segments_created);
+
+            if (opts.count("json-result")) {
+                write_json_result(opts["json-result"].as<std::string>(), cfg, res, median, mad);
+            }
+          });
+        });
+    });
+}
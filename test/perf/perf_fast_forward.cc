@@ -146,6 +146,11 @@ class dataset {
     const std::string& create_table_statement() const { return _create_table_statement; }
 
     virtual generator_fn make_generator(schema_ptr, const table_config&) = 0;
+
+    // When engaged, population flushes the memtable after every that many
+    // mutations and leaves the resulting sstables uncompacted, so that reads
+    // have to merge them. Otherwise everything is compacted into one sstable.
+    virtual std::optional<int> mutations_per_sstable(const table_config&) { return std::nullopt; }
 };
 
 // Adapts a function which accepts DataSet& as its argument to a dataset_acceptor
@@ -872,6 +877,23 @@ static test_result test_slicing_using_restrictions(column_family& cf, int_range
     return test_reading_all(rd);
 }
 
+// Reads rows of the range in reverse clustering order, keeping at most
+// limit of them, the same way the querier serves ORDER BY ck DESC LIMIT.
+static test_result test_reversed_slicing_using_restrictions(column_family& cf, int_range row_range,
+        uint64_t limit = std::numeric_limits<uint64_t>::max()) {
+    auto slice = partition_slice_builder(*cf.schema())
+        .with_range(std::move(row_range).transform([&] (int i) -> clustering_key {
+            return clustering_key::from_singular(*cf.schema(), i);
+        }))
+        .reversed()
+        .build();
+    auto pr = dht::partition_range::make_singular(make_pkey(*cf.schema(), 0));
+    auto rd = cf.make_reader(cf.schema(), pr, slice, default_priority_class(), nullptr,
+                             streamed_mutation::forwarding::no, mutation_reader::forwarding::no);
+    auto reversing_rd = make_reversing_reader(rd, std::numeric_limits<size_t>::max(), limit, gc_clock::now());
+    return test_reading_all(reversing_rd);
+}
+
 static test_result slice_rows_single_key(column_family& cf, int offset = 0, int n_read = 1) {
     auto pr = dht::partition_range::make_singular(make_pkey(*cf.schema(), 0));
     auto rd = cf.make_reader(cf.schema(), pr, cf.schema()->full_slice(), default_priority_class(), nullptr, streamed_mutation::forwarding::yes, mutation_reader::forwarding::no);
@@ -962,6 +984,86 @@ class large_part_ds1 : public simple_large_part_ds {
     }
 };
 
+// Like large_part_ds1, but the rows are interleaved between sstables, so
+// that every sstable spans the whole partition and all of them have to be
+// merged by any read.
+class large_part_many_sstables_ds : public simple_large_part_ds {
+    static constexpr int n_sstables = 16;
+public:
+    large_part_many_sstables_ds() : simple_large_part_ds("large-part-many-sstables",
+        format("One large partition with many small rows, spread over {:d} overlapping sstables", n_sstables)) {}
+
+    int n_rows(const table_config& cfg) override {
+        return *mutations_per_sstable(cfg) * n_sstables;
+    }
+
+    std::optional<int> mutations_per_sstable(const table_config& cfg) override {
+        return std::max(cfg.n_rows / n_sstables, 1);
+    }
+
+    generator_fn make_generator(schema_ptr s, const table_config& cfg) override {
+        auto value = serialized(make_blob(cfg.value_size));
+        auto& value_cdef = *s->get_column_definition("value");
+        auto pk = partition_key::from_single_value(*s, serialized(0));
+        // The i-th sstable gets rows i, i + n_sstables, i + 2 * n_sstables, ...
+        return [this, s, i = 0, n_ck = n_rows(cfg), &value_cdef, value, pk] () mutable -> std::optional<mutation> {
+            if (i == n_ck) {
+                return std::nullopt;
+            }
+            auto per_sstable = n_ck / n_sstables;
+            auto ck = i % per_sstable * n_sstables + i / per_sstable;
+            auto ts = api::new_timestamp();
+            mutation m(s, pk);
+            auto& row = m.partition().clustered_row(*s, make_ck(*s, ck));
+            row.cells().apply(value_cdef, atomic_cell::make_live(*value_cdef.type, ts, value));
+            ++i;
+            return m;
+        };
+    }
+};
+
+// A dataset with one large partition in which every row is covered by
+// several overlapping range tombstones, all older than the rows they cover.
+// Partition key: pk int [0]
+// Clusterint key: ck int [0 .. n_rows() - 1]
+class large_part_range_tombstones_ds : public dataset {
+public:
+    static constexpr int tombstones_per_row = 16;
+
+    large_part_range_tombstones_ds() : dataset("large-part-range-tombstones",
+        format("One large partition with many small rows, each covered by {:d} overlapping range tombstones", tombstones_per_row),
+        "create table {} (pk int, ck int, value blob, primary key (pk, ck))") {}
+
+    int n_rows(const table_config& cfg) {
+        return cfg.n_rows;
+    }
+
+    generator_fn make_generator(schema_ptr s, const table_config& cfg) override {
+        auto value = serialized(make_blob(cfg.value_size));
+        auto& value_cdef = *s->get_column_definition("value");
+        auto pk = partition_key::from_single_value(*s, serialized(0));
+        auto base_ts = api::new_timestamp();
+        // Row ck is written at base_ts + 2 * ck + 1 and deletes [ck, ck + tombstones_per_row)
+        // at base_ts + 2 * ck, which is older than all rows in that range. Distinct
+        // timestamps keep the tombstones from being merged together.
+        return [s, ck = 0, n_ck = n_rows(cfg), &value_cdef, value, pk, base_ts] () mutable -> std::optional<mutation> {
+            if (ck == n_ck) {
+                return std::nullopt;
+            }
+            auto ts = base_ts + 2 * ck;
+            mutation m(s, pk);
+            m.partition().apply_delete(*s, range_tombstone(
+                clustering_key::from_singular(*s, ck), bound_kind::incl_start,
+                clustering_key::from_singular(*s, ck + tombstones_per_row), bound_kind::excl_end,
+                tombstone(ts, gc_clock::now())));
+            auto& row = m.partition().clustered_row(*s, clustering_key::from_singular(*s, ck));
+            row.cells().apply(value_cdef, atomic_cell::make_live(*value_cdef.type, ts + 1, value));
+            ++ck;
+            return m;
+        };
+    }
+};
+
 class small_part_ds1 : public multipart_ds, public dataset {
 public:
     small_part_ds1() : dataset("small-part", "Many small partitions with no clustering key",
@@ -1496,6 +1598,72 @@ void test_large_partition_forwarding(column_family& cf, clustered_ds& ds) {
   });
 }
 
+static sstring format_limit(uint64_t limit) {
+    return limit == std::numeric_limits<uint64_t>::max() ? sstring("-") : to_sstring(limit);
+}
+
+void test_large_partition_slicing_reversed(column_family& cf, clustered_ds& ds) {
+    auto n_rows = ds.n_rows(cfg);
+    int_range live_range = int_range({0}, {n_rows - 1});
+    constexpr auto no_limit = std::numeric_limits<uint64_t>::max();
+
+    output_mgr->set_test_param_names({{"range", "{:<14}"}, {"limit", "{:<7}"}}, test_result::stats_names());
+    auto test = [&] (int_range range, uint64_t limit) {
+      run_test_case([&] {
+        auto r = test_reversed_slicing_using_restrictions(cf, range, limit);
+        r.set_params(to_sstrings(format("{}", range), format_limit(limit)));
+        check_fragment_count(r, std::min<uint64_t>(cardinality(intersection(range, live_range)), limit));
+        return r;
+      });
+    };
+
+    // The latest rows of the partition, as read by the first page of a
+    // descending query.
+    test(live_range, 1);
+    test(live_range, 32);
+    test(live_range, 256);
+    test(live_range, 4096);
+    test(live_range, no_limit);
+
+    test(int_range::make({n_rows / 2}, {n_rows / 2}), no_limit);
+    test(int_range::make({n_rows / 2}, {n_rows / 2 + 31}), no_limit);
+    test(int_range::make({n_rows / 2}, {n_rows / 2 + 4095}), no_limit);
+    test(int_range::make({0}, {n_rows / 2}), 32);
+}
+
+void test_large_partition_range_tombstones(column_family& cf, large_part_range_tombstones_ds& ds) {
+    auto n_rows = ds.n_rows(cfg);
+    constexpr auto no_limit = std::numeric_limits<uint64_t>::max();
+
+    // The number of range tombstone fragments depends on how the sstable
+    // writer split them, so fragment counts are not checked here.
+    output_mgr->set_test_param_names({{"order", "{:<8}"}, {"range", "{:<14}"}, {"limit", "{:<7}"}}, test_result::stats_names());
+    auto test_forward = [&] (int_range range) {
+      run_test_case([&] {
+        auto r = test_slicing_using_restrictions(cf, range);
+        r.set_params(to_sstrings("asc", format("{}", range), format_limit(no_limit)));
+        return r;
+      });
+    };
+    auto test_reversed = [&] (int_range range, uint64_t limit) {
+      run_test_case([&] {
+        auto r = test_reversed_slicing_using_restrictions(cf, range, limit);
+        r.set_params(to_sstrings("desc", format("{}", range), format_limit(limit)));
+        return r;
+      });
+    };
+
+    auto all = int_range::make({0}, {n_rows - 1});
+    auto middle = int_range::make({n_rows / 2}, {n_rows / 2 + 4095});
+
+    test_forward(all);
+    test_reversed(all, no_limit);
+    test_reversed(all, 32);
+    test_forward(middle);
+    test_reversed(middle, no_limit);
+    test_reversed(middle, 32);
+}
+
 void test_small_partition_skips(column_family& cf2, multipart_ds& ds) {
     auto n_parts = ds.n_partitions(cfg);
 
@@ -1589,6 +1757,8 @@ auto make_datasets() {
     };
     add(std::make_unique<small_part_ds1>());
     add(std::make_unique<large_part_ds1>());
+    add(std::make_unique<large_part_many_sstables_ds>());
+    add(std::make_unique<large_part_range_tombstones_ds>());
     return dsets;
 }
 
@@ -1618,6 +1788,13 @@ void populate(const std::vector<dataset*>& datasets, cql_test_env& env, const ta
         env.execute_cql(format("{} WITH compression = {{ 'sstable_compression': '{}' }};",
             ds.create_table_statement(), cfg.compressor)).get();
 
+        auto per_sstable = ds.mutations_per_sstable(cfg);
+        if (per_sstable) {
+            // Keep the sstables from being compacted together when the table is loaded.
+            env.execute_cql(format("alter table ks.{} with compaction = {{ 'class': 'NullCompactionStrategy' }};",
+                ds.table_name())).get();
+        }
+
         column_family& cf = find_table(db, ds);
         auto s = cf.schema();
         size_t fragments = 0;
@@ -1631,7 +1808,8 @@ void populate(const std::vector<dataset*>& datasets, cql_test_env& env, const ta
                 while (auto mopt = gen()) {
                     ++fragments;
                     cf.active_memtable().apply(*mopt);
-                    if (cf.active_memtable().region().occupancy().used_space() > flush_threshold) {
+                    if (cf.active_memtable().region().occupancy().used_space() > flush_threshold
+                            || (per_sstable && fragments == size_t(*per_sstable))) {
                         metrics_snapshot before;
                         cf.flush().get();
                         auto r = test_result(std::move(before), std::exchange(fragments, 0));
@@ -1652,6 +1830,11 @@ void populate(const std::vector<dataset*>& datasets, cql_test_env& env, const ta
             });
         }).get();
 
+        if (per_sstable) {
+            std::cout << "leaving " << cf.sstables_count() << " sstables uncompacted\n";
+            continue;
+        }
+
         std::cout << "compacting...\n";
         cf.compact_all_sstables().get();
     }
@@ -1708,6 +1891,20 @@ static std::initializer_list<test_group> test_groups = {
         test_group::type::large_partition,
         make_test_fn(test_large_partition_forwarding),
     },
+    {
+        "large-partition-slicing-reversed",
+        "Testing reversed slicing of large partition, with and without a row limit",
+        test_group::requires_cache::no,
+        test_group::type::large_partition,
+        make_test_fn(test_large_partition_slicing_reversed),
+    },
+    {
+        "large-partition-range-tombstones",
+        "Testing forward and reversed slicing of large partition with many range tombstones",
+        test_group::requires_cache::no,
+        test_group::type::large_partition,
+        make_test_fn(test_large_partition_range_tombstones),
+    },
     {
         "small-partition-skips",
         "Testing scanning small partitions with skips.\n" \
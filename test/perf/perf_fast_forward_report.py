@@ -22,20 +22,43 @@
 
 import argparse
 import json
-import matplotlib.pyplot as plt
 
 cmdline_parser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter)
-cmdline_parser.add_argument('results', nargs=1, help='JSON file with full perf_fast_forward results')
+cmdline_parser.add_argument('results', nargs='+', help='JSON files with perf_fast_forward results')
 cmdline_parser.add_argument('-o', '--output', help='name of the output file')
 cmdline_parser.add_argument('--histogram', action='store_true', help='plot a histogram of the frag/s results')
 cmdline_parser.add_argument('--histogram-bins-count', default=50, help='number of histogram bins')
 cmdline_parser.add_argument('--histogram-stats', default='frag/s', help='comma-separated list of result statistic to prepare histograms of')
+cmdline_parser.add_argument('--summary', action='store_true', help='print a table of the given summary results, one query per line')
+cmdline_parser.add_argument('--summary-stats', default='frag/s,aio,(KiB),idx miss,cpu',
+                            help='comma-separated list of result statistics to show in the summary')
 
 args = cmdline_parser.parse_args()
 
 results = json.loads(open(args.results[0]).read())
 
-if args.histogram:
+if args.summary:
+    summary_stats = args.summary_stats.split(',')
+    rows = []
+    for filename in args.results:
+        result = json.loads(open(filename).read())
+        properties = result['test_group_properties']
+        parameters = result['results']['parameters']
+        stats = result['results']['stats']
+        if isinstance(stats, list):
+            print('Skipping {}: not a summary result'.format(filename))
+            continue
+        params = ' '.join('{}={}'.format(k, v) for k, v in sorted(parameters.items())
+                          if ',' not in k and k != 'test_run_count')
+        rows.append([properties['name'], properties['dataset'], params] +
+                    [str(stats.get(stat, '')) for stat in summary_stats])
+    header = ['test group', 'dataset', 'parameters'] + summary_stats
+    widths = [max(len(row[i]) for row in rows + [header]) for i in range(len(header))]
+    for row in [header] + rows:
+        print('  '.join(value.ljust(width) for value, width in zip(row, widths)))
+elif args.histogram:
+    import matplotlib.pyplot as plt
+
     histogram_stats = args.histogram_stats.split(',')
 
     stats = results['results']['stats']
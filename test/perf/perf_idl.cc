@@ -25,6 +25,16 @@
 #include "test/lib/simple_schema.hh"
 
 #include "frozen_mutation.hh"
+#include "query-result-reader.hh"
+#include "repair/repair.hh"
+#include "idl/token.dist.hh"
+#include "idl/ring_position.dist.hh"
+#include "idl/frozen_mutation.dist.hh"
+#include "idl/partition_checksum.dist.hh"
+#include "idl/token.dist.impl.hh"
+#include "idl/ring_position.dist.impl.hh"
+#include "idl/frozen_mutation.dist.impl.hh"
+#include "idl/partition_checksum.dist.impl.hh"
 
 namespace tests {
 
@@ -68,4 +78,97 @@ PERF_TEST_F(frozen_mutation, apply_one_small_row)
     perf_tests::do_not_optimize(m);
 }
 
+
+class query_result {
+public:
+    static constexpr size_t rows = 100;
+    static constexpr size_t cells_per_row = 4;
+private:
+    bytes_ostream _serialized;
+public:
+    query_result() {
+        auto value = bytes(bytes::initialized_later(), 8);
+        std::fill(value.begin(), value.end(), 'v');
+        auto partitions = ser::writer_of_query_result<bytes_ostream>(_serialized).start_partitions();
+        auto rows_wr = partitions.add().skip_key()
+                .start_static_row().start_cells().end_cells().end_static_row()
+                .start_rows();
+        for (size_t i = 0; i < rows; ++i) {
+            auto cells_wr = rows_wr.add().skip_key().start_cells().start_cells();
+            for (size_t j = 0; j < cells_per_row; ++j) {
+                cells_wr.add().write().skip_timestamp().skip_expiry().write_value(value).skip_ttl().end_qr_cell();
+            }
+            std::move(cells_wr).end_cells().end_cells().end_qr_clustered_row();
+        }
+        std::move(rows_wr).end_rows().end_qr_partition();
+        std::move(partitions).end_partitions().end_query_result();
+    }
+
+    const bytes_ostream& serialized() const { return _serialized; }
+};
+
+PERF_TEST_F(query_result, read_rows)
+{
+    auto in = ser::as_input_stream(serialized());
+    auto v = ser::deserialize(in, boost::type<ser::query_result_view>());
+    for (auto&& p : v.partitions()) {
+        for (auto&& r : p.rows()) {
+            auto it = query::result_row_view(r.cells()).iterator();
+            for (size_t i = 0; i < cells_per_row; ++i) {
+                perf_tests::do_not_optimize(it.next_atomic_cell());
+            }
+        }
+    }
+    return rows;
+}
+
+class repair_rows {
+public:
+    static constexpr size_t partitions = 10;
+    static constexpr size_t rows_per_partition = 10;
+private:
+    simple_schema _schema;
+    bytes_ostream _serialized;
+public:
+    repair_rows() {
+        repair_rows_on_wire rows;
+        for (size_t i = 0; i < partitions; ++i) {
+            std::list<frozen_mutation_fragment> mfs;
+            for (size_t j = 0; j < rows_per_partition; ++j) {
+                mfs.push_back(freeze(*_schema.schema(), _schema.make_row(_schema.make_ckey(j), "value")));
+            }
+            rows.push_back(partition_key_and_mutation_fragments(_schema.make_pkey(i).key(), std::move(mfs)));
+        }
+        ser::serialize(_serialized, rows);
+    }
+
+    const bytes_ostream& serialized() const { return _serialized; }
+};
+
+PERF_TEST_F(repair_rows, deserialize_rows)
+{
+    auto in = ser::as_input_stream(serialized());
+    auto rows = ser::deserialize(in, boost::type<repair_rows_on_wire>());
+    for (auto& p : rows) {
+        perf_tests::do_not_optimize(p.get_key());
+        for (auto& mf : p.get_mutation_fragments()) {
+            perf_tests::do_not_optimize(mf.representation().size());
+        }
+    }
+    return partitions * rows_per_partition;
+}
+
+PERF_TEST_F(repair_rows, read_frozen_rows)
+{
+    auto in = ser::as_input_stream(serialized());
+    auto frozen = ser::deserialize(in, boost::type<frozen_repair_rows_on_wire>());
+    for (auto&& p : frozen.view()) {
+        perf_tests::do_not_optimize(p.key());
+        for (auto&& mf : p.mutation_fragments()) {
+            perf_tests::do_not_optimize(mf.stream().size());
+        }
+    }
+    return partitions * rows_per_partition;
+}
+
 }
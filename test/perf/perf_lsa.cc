@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Churns LSA regions with a mix of object sizes and reports how the
+// allocator keeps up: occupancy, time spent reclaiming (compacting and
+// evicting) per allocation, and allocation latency including the worst
+// stall. Runs on a single shard.
+//
+// The segment size is a build-time constant; to compare segment sizes,
+// build with -DSCYLLA_LSA_SEGMENT_SIZE_SHIFT=<n>.
+
+#include <seastar/core/app-template.hh>
+#include <seastar/core/thread.hh>
+#include <seastar/core/memory.hh>
+
+#include "utils/managed_bytes.hh"
+#include "utils/logalloc.hh"
+#include "utils/estimated_histogram.hh"
+#include "seastarx.hh"
+
+#include <boost/range/adaptor/transformed.hpp>
+#include <deque>
+#include <random>
+#include <unordered_map>
+
+using clk = std::chrono::steady_clock;
+
+struct size_class {
+    double weight;
+    size_t min_size;
+    size_t max_size;
+};
+
+static const std::unordered_map<sstring, std::vector<size_class>> size_distributions = {
+    // Roughly what the row cache holds: mostly cells and small rows, some
+    // larger rows and blobs, rare values larger than the LSA object limit.
+    {"cache", {{0.70, 16, 256}, {0.25, 256, 4096}, {0.045, 4096, 16384}, {0.005, 16384, 131072}}},
+    {"small", {{1.0, 16, 128}}},
+    {"large", {{1.0, 1024, 65536}}},
+    {"bimodal", {{0.9, 16, 64}, {0.1, 8192, 16384}}},
+};
+
+class size_chooser {
+    std::vector<size_class> _classes;
+    std::discrete_distribution<size_t> _class_dist;
+public:
+    explicit size_chooser(std::vector<size_class> classes)
+        : _classes(std::move(classes))
+        , _class_dist(boost::copy_range<std::vector<double>>(_classes | boost::adaptors::transformed([] (auto& c) { return c.weight; })))
+    { }
+
+    template <typename RandomEngine>
+    size_t operator()(RandomEngine& rng) {
+        auto& c = _classes[_class_dist(rng)];
+        return std::uniform_int_distribution<size_t>(c.min_size, c.max_size)(rng);
+    }
+};
+
+struct churned_region {
+    logalloc::region region;
+    // Oldest objects first, so that eviction is FIFO.
+    std::deque<managed_bytes> objects;
+};
+
+struct churn_stats {
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    uint64_t evictions = 0;
+    uint64_t evicted_bytes = 0;
+    clk::duration eviction_time{};
+    clk::duration worst_latency{};
+    // Since the last report
+    clk::duration max_latency{};
+    utils::estimated_histogram latencies;
+};
+
+static double to_ns(clk::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count();
+}
+
+static uint64_t to_us(clk::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+int main(int argc, char** argv) {
+    namespace bpo = boost::program_options;
+    app_template app;
+    app.add_options()
+        ("duration", bpo::value<unsigned>()->default_value(30), "duration of the test [s]")
+        ("regions", bpo::value<unsigned>()->default_value(8), "number of regions")
+        ("evictable-regions", bpo::value<unsigned>()->default_value(4), "number of regions which can be evicted from")
+        ("live-fraction", bpo::value<double>()->default_value(0.7), "fraction of memory the benchmark keeps live;"
+                " above the space left by fragmentation, evictable regions are evicted from")
+        ("size-distribution", bpo::value<sstring>()->default_value("cache"), "object sizes, one of: cache, small, large, bimodal")
+        ("background-reclaim", bpo::value<double>()->default_value(0), "if non-zero, the fraction of memory the background reclaimer keeps free")
+        ("report-interval", bpo::value<unsigned>()->default_value(1), "interval between reports [s]")
+        ;
+
+    return app.run(argc, argv, [&app] {
+        return seastar::async([&app] {
+            auto& cfg = app.configuration();
+            auto duration = std::chrono::seconds(cfg["duration"].as<unsigned>());
+            auto nr_regions = std::max(1u, cfg["regions"].as<unsigned>());
+            auto nr_evictable = std::min(nr_regions, cfg["evictable-regions"].as<unsigned>());
+            auto report_interval = std::chrono::seconds(cfg["report-interval"].as<unsigned>());
+            auto dist_name = cfg["size-distribution"].as<sstring>();
+            auto dist = size_distributions.find(dist_name);
+            if (dist == size_distributions.end()) {
+                throw std::invalid_argument(format("Unknown size distribution: {}", dist_name));
+            }
+            size_chooser choose_size(dist->second);
+
+            auto total_memory = memory::stats().total_memory();
+            auto live_target = size_t(total_memory * cfg["live-fraction"].as<double>());
+            logalloc::prime_segment_pool(total_memory, memory::min_free_memory()).get();
+            auto background_reclaim = cfg["background-reclaim"].as<double>();
+            if (background_reclaim) {
+                logalloc::shard_tracker().start_background_reclaim(default_scheduling_group(), size_t(total_memory * background_reclaim));
+            }
+
+            std::cout << format("segment size: {} KiB, memory: {} MiB, live target: {} MiB, size distribution: {}, regions: {} ({} evictable)\n",
+                    logalloc::segment_size >> 10, total_memory >> 20, live_target >> 20, dist_name, nr_regions, nr_evictable);
+
+            std::default_random_engine rng(std::random_device{}());
+            churn_stats stats;
+            size_t live_bytes = 0;
+            std::vector<std::unique_ptr<churned_region>> regions;
+
+            for (unsigned i = 0; i < nr_regions; ++i) {
+                regions.push_back(std::make_unique<churned_region>());
+                auto& cr = *regions.back();
+                if (i < nr_evictable) {
+                    // The deque is only modified with reclaiming of its
+                    // region disabled, so this may run at any other time.
+                    cr.region.make_evictable([&cr, &stats, &live_bytes] {
+                        return with_allocator(cr.region.allocator(), [&] {
+                            if (cr.objects.empty()) {
+                                return memory::reclaiming_result::reclaimed_nothing;
+                            }
+                            auto start = clk::now();
+                            auto size = cr.objects.front().size();
+                            cr.objects.pop_front();
+                            live_bytes -= size;
+                            stats.evictions++;
+                            stats.evicted_bytes += size;
+                            stats.eviction_time += clk::now() - start;
+                            return memory::reclaiming_result::reclaimed_something;
+                        });
+                    });
+                }
+            }
+
+            std::uniform_int_distribution<unsigned> region_dist(0, nr_regions - 1);
+
+            auto free_random_object = [&] {
+                auto& cr = *regions[region_dist(rng)];
+                if (cr.objects.empty()) {
+                    return;
+                }
+                logalloc::reclaim_lock rl(cr.region);
+                with_allocator(cr.region.allocator(), [&] {
+                    auto i = std::uniform_int_distribution<size_t>(0, cr.objects.size() - 1)(rng);
+                    std::swap(cr.objects[i], cr.objects.back());
+                    live_bytes -= cr.objects.back().size();
+                    cr.objects.pop_back();
+                });
+            };
+
+            auto allocate_object = [&] {
+                auto& cr = *regions[region_dist(rng)];
+                auto size = choose_size(rng);
+                auto start = clk::now();
+                auto obj = with_allocator(cr.region.allocator(), [&] {
+                    return managed_bytes(managed_bytes::initialized_later(), size);
+                });
+                auto latency = clk::now() - start;
+                {
+                    logalloc::reclaim_lock rl(cr.region);
+                    cr.objects.push_back(std::move(obj));
+                }
+                live_bytes += size;
+                stats.allocations++;
+                stats.allocated_bytes += size;
+                stats.latencies.add(to_us(latency));
+                stats.max_latency = std::max(stats.max_latency, latency);
+                stats.worst_latency = std::max(stats.worst_latency, latency);
+            };
+
+            struct snapshot {
+                clk::time_point time;
+                churn_stats stats;
+                clk::duration foreground_reclaim_time;
+                clk::duration background_reclaim_time;
+                uint64_t memory_compacted;
+            };
+            auto take_snapshot = [&] {
+                return snapshot{clk::now(), stats, logalloc::foreground_reclaim_time(), logalloc::background_reclaim_time(), logalloc::memory_compacted()};
+            };
+
+            // Time spent reclaiming in the foreground, per allocation, split
+            // into eviction (measured by the evictors) and the rest, which is
+            // mostly compaction.
+            auto print_reclaim = [] (const snapshot& from, const snapshot& to) {
+                auto allocations = std::max<uint64_t>(1, to.stats.allocations - from.stats.allocations);
+                auto reclaim = to.foreground_reclaim_time - from.foreground_reclaim_time;
+                auto eviction = to.stats.eviction_time - from.stats.eviction_time;
+                return format("reclaim/alloc: {:.1f} ns (compaction: {:.1f} ns, eviction: {:.1f} ns), background reclaim: {:.3f} s, compacted: {} MiB, evicted: {} MiB",
+                        to_ns(reclaim) / allocations, to_ns(reclaim - std::min(reclaim, eviction)) / allocations, to_ns(eviction) / allocations,
+                        std::chrono::duration<double>(to.background_reclaim_time - from.background_reclaim_time).count(),
+                        (to.memory_compacted - from.memory_compacted) >> 20,
+                        (to.stats.evicted_bytes - from.stats.evicted_bytes) >> 20);
+            };
+
+            auto print_latencies = [] (const utils::estimated_histogram& hist, clk::duration max) {
+                return format("alloc latency 50%: {} us, 99%: {} us, 99.9%: {} us, max: {} us",
+                        hist.percentile(0.5), hist.percentile(0.99), hist.percentile(0.999), to_us(max));
+            };
+
+            auto start = take_snapshot();
+            auto last = start;
+            while (clk::now() - start.time < duration) {
+                for (unsigned i = 0; i < 1000; ++i) {
+                    while (live_bytes > live_target) {
+                        free_random_object();
+                    }
+                    allocate_object();
+                }
+                if (clk::now() - last.time >= report_interval) {
+                    auto now = take_snapshot();
+                    auto occupancy = logalloc::shard_tracker().region_occupancy();
+                    std::cout << format("{:.0f}s: allocs/s: {:.0f}, LSA: {}/{} MiB ({:.1f}% used), live: {} MiB, std free: {} MiB\n",
+                            std::chrono::duration<double>(now.time - start.time).count(),
+                            (now.stats.allocations - last.stats.allocations) / std::chrono::duration<double>(now.time - last.time).count(),
+                            occupancy.used_space() >> 20, occupancy.total_space() >> 20, occupancy.used_fraction() * 100,
+                            live_bytes >> 20, memory::stats().free_memory() >> 20);
+                    std::cout << "  " << print_reclaim(last, now) << "\n";
+                    std::cout << "  " << print_latencies(stats.latencies, stats.max_latency) << "\n";
+                    stats.latencies.clear();
+                    stats.max_latency = {};
+                    last = std::move(now);
+                }
+                thread::maybe_yield();
+            }
+
+            auto end = take_snapshot();
+            std::cout << format("total: {} allocations ({} MiB), {} evictions, worst stall: {} us\n",
+                    end.stats.allocations, end.stats.allocated_bytes >> 20, end.stats.evictions, to_us(end.stats.worst_latency));
+            std::cout << "  " << print_reclaim(start, end) << "\n";
+
+            if (background_reclaim) {
+                logalloc::shard_tracker().stop_background_reclaim().get();
+            }
+            for (auto& cr : regions) {
+                with_allocator(cr->region.allocator(), [&] {
+                    cr->objects.clear();
+                });
+            }
+        });
+    });
+}
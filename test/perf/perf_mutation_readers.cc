@@ -309,4 +309,26 @@ PERF_TEST_F(memtable, many_partitions_many_rows)
     return consume_all(multi_row_mt().make_flat_reader(schema(), multi_partition_range(25)));
 }
 
+namespace {
+
+struct identity_transform {
+    mutation_fragment operator()(mutation_fragment&& mf) { return std::move(mf); }
+    schema_ptr operator()(schema_ptr s) { return s; }
+};
+
+}
+
+// Stacks of adapters, which pass on whole buffers of fragments.
+PERF_TEST_F(memtable, many_partitions_many_rows_filtered)
+{
+    return consume_all(make_filtering_reader(multi_row_mt().make_flat_reader(schema(), multi_partition_range(25)),
+            [] (const dht::decorated_key&) { return true; }));
+}
+
+PERF_TEST_F(memtable, many_partitions_many_rows_transformed)
+{
+    return consume_all(transform(transform(multi_row_mt().make_flat_reader(schema(), multi_partition_range(25)),
+            identity_transform{}), identity_transform{}));
+}
+
 }
@@ -0,0 +1,423 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Measures the data path of row-level repair and of streaming between two
+// nodes simulated in one process, each holding its copy of a generated
+// dataset in a memtable. The second copy diverges from the first at a
+// configurable rate.
+//
+// Both nodes run on the same shard and exchange data by function calls
+// instead of RPC, so each step costs what it costs on a real node, minus
+// the network: reading, hashing and freezing rows on the sending side,
+// reconciling row hashes, unfreezing and applying rows on the receiving
+// side (to a memtable rather than to sstables). The RPC messages a real
+// repair or stream would send are counted along the way.
+
+#include <seastar/core/app-template.hh>
+#include <seastar/core/thread.hh>
+
+#include <boost/range/adaptor/map.hpp>
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/numeric.hpp>
+#include <array>
+#include <random>
+#include <time.h>
+#include <unordered_set>
+
+#include "test/lib/simple_schema.hh"
+#include "memtable.hh"
+#include "frozen_mutation.hh"
+#include "repair/fragment_hasher.hh"
+#include "xx_hasher.hh"
+#include "utils/iblt.hh"
+#include "seastarx.hh"
+
+using clk = std::chrono::steady_clock;
+
+static std::chrono::nanoseconds thread_cpu_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+struct test_config {
+    unsigned partitions;
+    unsigned rows_per_partition;
+    unsigned value_size;
+    double divergence;
+    unsigned partitions_per_round;
+    bool use_iblt;
+};
+
+// RPC calls, by verb, and the bytes of their payloads.
+class rpc_counters {
+    std::map<sstring, std::pair<uint64_t, uint64_t>> _verbs;
+public:
+    void add(const sstring& verb, uint64_t bytes) {
+        auto& v = _verbs[verb];
+        v.first++;
+        v.second += bytes;
+    }
+    uint64_t bytes() const {
+        return boost::accumulate(_verbs | boost::adaptors::map_values | boost::adaptors::transformed([] (auto& v) { return v.second; }), uint64_t(0));
+    }
+    void print() const {
+        for (auto& [verb, v] : _verbs) {
+            std::cout << format("  {}: {} messages, {} bytes\n", verb, v.first, v.second);
+        }
+    }
+};
+
+struct node {
+    lw_shared_ptr<memtable> mt;
+};
+
+// A row as row-level repair keeps it in its buffers.
+struct repair_row {
+    const dht::decorated_key* dk;
+    uint64_t hash;
+    frozen_mutation_fragment fmf;
+};
+
+class two_node_test {
+    const test_config& _cfg;
+    simple_schema _ss;
+    schema_ptr _s;
+    std::default_random_engine _rng;
+    // All partition keys, in ring order.
+    std::vector<dht::decorated_key> _keys;
+    node _a;
+    node _b;
+    rpc_counters _rpc;
+    uint64_t _rows_read = 0;
+    uint64_t _bytes_read = 0;
+    uint64_t _rows_sent = 0;
+    uint64_t _bytes_sent = 0;
+    // Sketches are sized for this many differences, following the
+    // differences found in earlier rounds. See send_iblt_rpc_stream in
+    // repair/row_level.cc.
+    size_t _expected_difference = 16;
+    static constexpr uint64_t seed = 0x1234;
+private:
+    sstring random_value() {
+        sstring v = uninitialized_string(_cfg.value_size);
+        std::uniform_int_distribution<char> dist('a', 'z');
+        for (auto& c : v) {
+            c = dist(_rng);
+        }
+        return v;
+    }
+
+    static uint64_t key_hash(const schema& s, const dht::decorated_key& dk) {
+        buffered_xx_hasher h(seed);
+        feed_hash(h, dk.key(), s);
+        return h.finalize_uint64();
+    }
+
+    static uint64_t row_hash(const schema& s, uint64_t key_hash, const mutation_fragment& mf) {
+        buffered_xx_hasher h(seed);
+        fragment_hasher<buffered_xx_hasher> fh(s, h);
+        fh.hash(mf);
+        feed_hash(h, key_hash);
+        return h.finalize_uint64();
+    }
+
+    // Reads, hashes and freezes the rows of the given partitions, like
+    // repair_reader and repair_meta::read_rows_from_disk().
+    std::vector<repair_row> read_rows(node& n, size_t first, size_t last) {
+        auto range = dht::partition_range::make({_keys[first]}, {_keys[last]});
+        auto reader = n.mt->make_flat_reader(_s, range);
+        std::vector<repair_row> rows;
+        const dht::decorated_key* dk = nullptr;
+        uint64_t dk_hash = 0;
+        while (auto mf = reader(db::no_timeout).get0()) {
+            if (mf->is_partition_start()) {
+                auto& key = mf->as_partition_start().key();
+                dk = &*std::lower_bound(_keys.begin() + first, _keys.begin() + last + 1, key, dht::decorated_key::less_comparator(_s));
+                dk_hash = key_hash(*_s, *dk);
+                if (!mf->as_partition_start().partition_tombstone()) {
+                    continue;
+                }
+            } else if (mf->is_end_of_partition()) {
+                continue;
+            }
+            auto fmf = freeze(*_s, *mf);
+            _rows_read++;
+            _bytes_read += fmf.representation().size();
+            rows.push_back(repair_row{dk, row_hash(*_s, dk_hash, *mf), std::move(fmf)});
+            thread::maybe_yield();
+        }
+        return rows;
+    }
+
+    // Applies received rows, which are in ring order, partition by partition.
+    void apply_rows(node& n, const std::vector<repair_row*>& rows) {
+        std::optional<mutation> m;
+        for (auto r : rows) {
+            if (!m || !m->decorated_key().equal(*_s, *r->dk)) {
+                if (m) {
+                    n.mt->apply(*m);
+                }
+                m.emplace(_s, *r->dk);
+            }
+            m->apply(r->fmf.unfreeze(*_s));
+        }
+        if (m) {
+            n.mt->apply(*m);
+        }
+    }
+
+    static uint64_t size_of(const std::vector<repair_row*>& rows) {
+        return boost::accumulate(rows | boost::adaptors::transformed([] (auto r) { return r->fmf.representation().size(); }), uint64_t(0));
+    }
+
+    static std::unordered_set<uint64_t> hashes_of(const std::vector<repair_row>& rows) {
+        return boost::copy_range<std::unordered_set<uint64_t>>(rows | boost::adaptors::transformed([] (auto& r) { return r.hash; }));
+    }
+
+    // Finds the hashes of the follower, using a sketch if configured to,
+    // and falling back to the full list of hashes.
+    std::unordered_set<uint64_t> get_follower_hashes(const std::unordered_set<uint64_t>& master, const std::unordered_set<uint64_t>& follower) {
+        if (_cfg.use_iblt) {
+            auto cells = utils::iblt::cells_for(_expected_difference);
+            if (cells * sizeof(utils::iblt::cell) < follower.size() * sizeof(uint64_t)) {
+                utils::iblt mine(cells, seed);
+                utils::iblt theirs(cells, seed);
+                for (auto h : master) {
+                    mine.insert(h);
+                }
+                for (auto h : follower) {
+                    theirs.insert(h);
+                }
+                _rpc.add("REPAIR_GET_ROW_HASH_SKETCH", theirs.cells().size() * sizeof(utils::iblt::cell));
+                theirs.subtract(mine);
+                if (auto diff = theirs.decode()) {
+                    _expected_difference = std::max<size_t>(16, 2 * (diff->added.size() + diff->removed.size()));
+                    auto result = master;
+                    for (auto h : diff->removed) {
+                        result.erase(h);
+                    }
+                    result.insert(diff->added.begin(), diff->added.end());
+                    return result;
+                }
+                _expected_difference *= 4;
+            }
+        }
+        _rpc.add("REPAIR_GET_FULL_ROW_HASHES", follower.size() * sizeof(uint64_t));
+        return follower;
+    }
+
+    void repair_round(size_t first, size_t last) {
+        auto master_rows = read_rows(_a, first, last);
+        auto follower_rows = read_rows(_b, first, last);
+        auto master = hashes_of(master_rows);
+        auto follower = hashes_of(follower_rows);
+
+        auto combined = [] (const std::unordered_set<uint64_t>& hashes) {
+            return boost::accumulate(hashes, uint64_t(0), std::bit_xor<uint64_t>());
+        };
+        _rpc.add("REPAIR_GET_COMBINED_ROW_HASH", sizeof(uint64_t));
+        if (combined(master) == combined(follower)) {
+            return;
+        }
+
+        auto peer = get_follower_hashes(master, follower);
+        std::vector<repair_row*> to_follower;
+        for (auto& r : master_rows) {
+            if (!peer.count(r.hash)) {
+                to_follower.push_back(&r);
+            }
+        }
+        std::vector<repair_row*> to_master;
+        for (auto& r : follower_rows) {
+            if (!master.count(r.hash)) {
+                to_master.push_back(&r);
+            }
+        }
+        if (!to_master.empty()) {
+            _rpc.add("REPAIR_GET_ROW_DIFF", to_master.size() * sizeof(uint64_t) + size_of(to_master));
+            apply_rows(_a, to_master);
+        }
+        if (!to_follower.empty()) {
+            _rpc.add("REPAIR_PUT_ROW_DIFF", size_of(to_follower));
+            apply_rows(_b, to_follower);
+        }
+        _rows_sent += to_master.size() + to_follower.size();
+        _bytes_sent += size_of(to_master) + size_of(to_follower);
+    }
+
+    uint64_t combined_hash(node& n) {
+        uint64_t hash = 0;
+        for (auto& r : read_rows(n, 0, _keys.size() - 1)) {
+            hash ^= r.hash;
+        }
+        return hash;
+    }
+public:
+    two_node_test(const test_config& cfg, unsigned random_seed)
+        : _cfg(cfg)
+        , _s(_ss.schema())
+        , _rng(random_seed)
+        , _a{make_lw_shared<memtable>(_s)}
+        , _b{make_lw_shared<memtable>(_s)}
+    {
+        _keys = _ss.make_pkeys(_cfg.partitions);
+        std::sort(_keys.begin(), _keys.end(), dht::decorated_key::less_comparator(_s));
+    }
+
+    // Fills a and, unless only a is to be filled, b. Every diverging row is
+    // either missing from one of the nodes or has a newer value in b.
+    void populate(bool populate_b) {
+        std::uniform_real_distribution<double> dist(0, 1);
+        for (auto& dk : _keys) {
+            mutation ma(_s, dk);
+            mutation mb(_s, dk);
+            for (unsigned i = 0; i < _cfg.rows_per_partition; ++i) {
+                auto ck = _ss.make_ckey(i);
+                if (!populate_b) {
+                    _ss.add_row(ma, ck, random_value());
+                    continue;
+                }
+                enum { same, missing_from_a, missing_from_b, newer_in_b } kind = same;
+                if (dist(_rng) < _cfg.divergence) {
+                    kind = std::array{missing_from_a, missing_from_b, newer_in_b}[std::uniform_int_distribution<int>(0, 2)(_rng)];
+                }
+                auto ts = _ss.new_timestamp();
+                if (kind != missing_from_a) {
+                    _ss.add_row(ma, ck, random_value(), ts);
+                }
+                if (kind != missing_from_b) {
+                    _ss.add_row(mb, ck, random_value(), kind == newer_in_b ? ts + 1 : ts);
+                }
+            }
+            _a.mt->apply(ma);
+            if (populate_b) {
+                _b.mt->apply(mb);
+            }
+            thread::maybe_yield();
+        }
+    }
+
+    void repair() {
+        for (size_t first = 0; first < _keys.size(); first += _cfg.partitions_per_round) {
+            repair_round(first, std::min(_keys.size(), first + _cfg.partitions_per_round) - 1);
+        }
+    }
+
+    // Sends all data of a to b, like stream_transfer_task's
+    // send_mutation_fragments(): every fragment is frozen and sent as one
+    // message of the STREAM_MUTATION_FRAGMENTS rpc stream.
+    void stream() {
+        auto reader = _a.mt->make_flat_reader(_s);
+        std::optional<mutation> m;
+        while (auto mf = reader(db::no_timeout).get0()) {
+            auto fmf = freeze(*_s, *mf);
+            auto size = fmf.representation().size();
+            _rpc.add("STREAM_MUTATION_FRAGMENTS", size);
+            _bytes_read += size;
+            _bytes_sent += size;
+            // The receiver
+            auto received = fmf.unfreeze(*_s);
+            if (received.is_partition_start()) {
+                m.emplace(_s, received.as_partition_start().key());
+                m->partition().apply(received.as_partition_start().partition_tombstone());
+            } else if (received.is_end_of_partition()) {
+                _b.mt->apply(*m);
+                m.reset();
+            } else {
+                _rows_read++;
+                _rows_sent++;
+                m->apply(received);
+            }
+            thread::maybe_yield();
+        }
+    }
+
+    bool converged() {
+        return combined_hash(_a) == combined_hash(_b);
+    }
+
+    void report(clk::duration wall, std::chrono::nanoseconds cpu) const {
+        auto seconds = std::chrono::duration<double>(wall).count();
+        auto cpu_seconds = std::chrono::duration<double>(cpu).count();
+        auto mb = double(1 << 20);
+        auto gb = double(1 << 30);
+        std::cout << format("time: {:.3f} s, cpu: {:.3f} s\n", seconds, cpu_seconds);
+        std::cout << format("read: {} rows, {:.1f} MB ({:.1f} MB/s, {:.0f} rows/s), {:.2f} cpu s/GB\n",
+                _rows_read, _bytes_read / mb, _bytes_read / mb / seconds, _rows_read / seconds, cpu_seconds / (_bytes_read / gb));
+        std::cout << format("sent: {} rows, {:.1f} MB\n", _rows_sent, _bytes_sent / mb);
+        std::cout << format("rpc: {:.1f} MB\n", _rpc.bytes() / mb);
+        _rpc.print();
+    }
+};
+
+int main(int argc, char** argv) {
+    namespace bpo = boost::program_options;
+    app_template app;
+    app.add_options()
+        ("mode", bpo::value<sstring>()->default_value("repair"), "repair or stream")
+        ("random-seed", bpo::value<unsigned>(), "random number generator seed")
+        ("partitions", bpo::value<unsigned>()->default_value(1000), "number of partitions")
+        ("rows-per-partition", bpo::value<unsigned>()->default_value(100), "number of rows per partition")
+        ("value-size", bpo::value<unsigned>()->default_value(100), "size of the value of a row, in bytes")
+        ("divergence", bpo::value<double>()->default_value(0.01), "fraction of rows which differ between the nodes (repair mode)")
+        ("partitions-per-round", bpo::value<unsigned>()->default_value(100),
+                "number of partitions reconciled at a time, standing for the row buffer of row-level repair (repair mode)")
+        ("iblt", "reconcile row hashes with sketches rather than full hash lists (repair mode)")
+        ;
+
+    return app.run(argc, argv, [&app] {
+        return seastar::async([&app] {
+            auto& opts = app.configuration();
+            auto mode = opts["mode"].as<sstring>();
+            if (mode != "repair" && mode != "stream") {
+                throw std::invalid_argument(format("unknown mode: {}", mode));
+            }
+            auto seed = opts.count("random-seed") ? opts["random-seed"].as<unsigned>() : std::random_device()();
+            std::cout << "random-seed=" << seed << '\n';
+
+            test_config cfg;
+            cfg.partitions = std::max(1u, opts["partitions"].as<unsigned>());
+            cfg.rows_per_partition = opts["rows-per-partition"].as<unsigned>();
+            cfg.value_size = opts["value-size"].as<unsigned>();
+            cfg.divergence = opts["divergence"].as<double>();
+            cfg.partitions_per_round = std::max(1u, opts["partitions-per-round"].as<unsigned>());
+            cfg.use_iblt = opts.count("iblt");
+
+            two_node_test t(cfg, seed);
+            std::cout << "Populating...\n";
+            t.populate(mode == "repair");
+
+            auto start = clk::now();
+            auto cpu_start = thread_cpu_time();
+            if (mode == "repair") {
+                t.repair();
+            } else {
+                t.stream();
+            }
+            auto cpu = thread_cpu_time() - cpu_start;
+            auto wall = clk::now() - start;
+            t.report(wall, cpu);
+            std::cout << "converged: " << (t.converged() ? "yes" : "no") << "\n";
+        });
+    });
+}
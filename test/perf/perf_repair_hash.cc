@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "seastar/include/seastar/testing/perf_tests.hh"
+
+#include "test/lib/simple_schema.hh"
+
+#include "repair/fragment_hasher.hh"
+#include "xx_hasher.hh"
+
+namespace tests {
+
+class repair_hash {
+    simple_schema _schema;
+    std::vector<mutation_fragment> _rows;
+public:
+    static constexpr size_t rows = 1000;
+
+    repair_hash() {
+        _rows.reserve(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            _rows.push_back(_schema.make_row(_schema.make_ckey(i), format("value{:d}", i)));
+        }
+    }
+
+    template <typename H>
+    uint64_t hash_rows() {
+        uint64_t sum = 0;
+        for (auto& mf : _rows) {
+            H h(0x1234);
+            fragment_hasher<H> fh(*_schema.schema(), h);
+            fh.hash(mf);
+            sum += h.finalize_uint64();
+        }
+        return sum;
+    }
+};
+
+PERF_TEST_F(repair_hash, xx_hasher)
+{
+    perf_tests::do_not_optimize(hash_rows<xx_hasher>());
+}
+
+PERF_TEST_F(repair_hash, buffered_xx_hasher)
+{
+    perf_tests::do_not_optimize(hash_rows<buffered_xx_hasher>());
+}
+
+}
@@ -21,6 +21,7 @@
 
 #include <boost/algorithm/string/split.hpp>
 #include <json/json.h>
+#include <random>
 
 #include <boost/range/irange.hpp>
 #include "test/lib/cql_test_env.hh"
@@ -60,7 +61,8 @@ static void execute_counter_update_for_key(cql_test_env& env, const bytes& key)
 };
 
 struct test_config {
-    enum class run_mode { read, write, del };
+    enum class run_mode { read, write, del, mixed };
+    enum class key_distribution { uniform, zipfian, latest };
 
     run_mode mode;
     unsigned partitions;
@@ -69,6 +71,11 @@ struct test_config {
     unsigned duration_in_seconds;
     bool counters;
     unsigned operations_per_shard = 0;
+    // Percentage of reads in the mixed mode.
+    unsigned read_percentage = 50;
+    key_distribution distribution = key_distribution::uniform;
+    // Operations per second per shard, or 0 to run as fast as possible.
+    unsigned rate = 0;
 };
 
 std::ostream& operator<<(std::ostream& os, const test_config::run_mode& m) {
@@ -76,19 +83,153 @@ std::ostream& operator<<(std::ostream& os, const test_config::run_mode& m) {
         case test_config::run_mode::write: return os << "write";
         case test_config::run_mode::read: return os << "read";
         case test_config::run_mode::del: return os << "delete";
+        case test_config::run_mode::mixed: return os << "mixed";
+    }
+    abort();
+}
+
+std::ostream& operator<<(std::ostream& os, const test_config::key_distribution& d) {
+    switch (d) {
+        case test_config::key_distribution::uniform: return os << "uniform";
+        case test_config::key_distribution::zipfian: return os << "zipfian";
+        case test_config::key_distribution::latest: return os << "latest";
     }
     abort();
 }
 
 std::ostream& operator<<(std::ostream& os, const test_config& cfg) {
-    return os << "{partitions=" << cfg.partitions
-           << ", concurrency=" << cfg.concurrency
-           << ", mode=" << cfg.mode
+    os << "{partitions=" << cfg.partitions
+       << ", concurrency=" << cfg.concurrency
+       << ", mode=" << cfg.mode;
+    if (cfg.mode == test_config::run_mode::mixed) {
+        os << ", read_percentage=" << cfg.read_percentage;
+    }
+    return os << ", key_distribution=" << cfg.distribution
+           << ", rate=" << cfg.rate
            << ", query_single_key=" << (cfg.query_single_key ? "yes" : "no")
            << ", counters=" << (cfg.counters ? "yes" : "no")
            << "}";
 }
 
+using op_clock = std::chrono::steady_clock;
+
+// Latencies of the operations of this shard.
+static thread_local latency_histogram read_latencies;
+static thread_local latency_histogram write_latencies;
+
+static latency_histogram gather_latencies(latency_histogram& (*local)()) {
+    latency_histogram res;
+    for (unsigned shard = 0; shard < smp::count; ++shard) {
+        res += smp::submit_to(shard, [local] { return local(); }).get0();
+    }
+    return res;
+}
+
+// Draws values in [0, n) following a Zipfian distribution, with the method of
+// Gray et al., "Quickly Generating Billion-Record Synthetic Databases".
+class zipfian_generator {
+    static constexpr double theta = 0.99;
+    uint64_t _n;
+    double _zetan;
+    double _alpha;
+    double _eta;
+private:
+    static double zeta(uint64_t n) {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; ++i) {
+            sum += 1 / std::pow(double(i), theta);
+        }
+        return sum;
+    }
+public:
+    explicit zipfian_generator(uint64_t n)
+        : _n(n)
+        , _zetan(zeta(n))
+        , _alpha(1 / (1 - theta))
+        , _eta((1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta(2) / _zetan)) {
+    }
+    uint64_t operator()(double u) const {
+        auto uz = u * _zetan;
+        if (uz < 1) {
+            return 0;
+        }
+        if (uz < 1 + std::pow(0.5, theta)) {
+            return std::min<uint64_t>(1, _n - 1);
+        }
+        return std::min<uint64_t>(_n * std::pow(_eta * u - _eta + 1, _alpha), _n - 1);
+    }
+};
+
+// Chooses the partitions of the operations. With the latest distribution,
+// writes go to partitions in sequence and reads prefer recently written ones.
+class key_chooser {
+    const test_config& _cfg;
+    std::shared_ptr<const zipfian_generator> _zipf;
+    static thread_local uint64_t _last_written;
+private:
+    double uniform() const {
+        return std::uniform_real_distribution<double>(0, 1)(seastar::testing::local_random_engine);
+    }
+public:
+    explicit key_chooser(const test_config& cfg)
+        : _cfg(cfg)
+        , _zipf(cfg.distribution == test_config::key_distribution::uniform ? nullptr
+                : std::make_shared<const zipfian_generator>(cfg.partitions)) {
+    }
+    uint64_t read_key() const {
+        if (_cfg.query_single_key) {
+            return 0;
+        }
+        switch (_cfg.distribution) {
+        case test_config::key_distribution::uniform:
+            return seastar::testing::local_random_engine() % _cfg.partitions;
+        case test_config::key_distribution::zipfian:
+            return (*_zipf)(uniform());
+        case test_config::key_distribution::latest:
+            return (_last_written + _cfg.partitions - (*_zipf)(uniform())) % _cfg.partitions;
+        }
+        abort();
+    }
+    uint64_t write_key() const {
+        if (!_cfg.query_single_key && _cfg.distribution == test_config::key_distribution::latest) {
+            _last_written = (_last_written + 1) % _cfg.partitions;
+            return _last_written;
+        }
+        return read_key();
+    }
+};
+
+thread_local uint64_t key_chooser::_last_written = 0;
+
+// Runs op, which is given the time it was meant to start at, either as fast as
+// possible or at the configured rate, and records its latency in latencies.
+template <typename Func>
+static std::vector<double> run_operations(test_config& cfg, Func op) {
+    if (cfg.rate) {
+        return time_parallel_at_rate(std::move(op), cfg.rate, cfg.concurrency, cfg.duration_in_seconds);
+    }
+    return time_parallel([op = std::move(op)] {
+        return op(op_clock::now());
+    }, cfg.concurrency, cfg.duration_in_seconds, cfg.operations_per_shard);
+}
+
+template <typename Func>
+static auto timed(latency_histogram& (*latencies)(), Func func) {
+    return [latencies, func = std::move(func)] (op_clock::time_point start) {
+        return func().then([latencies, start] {
+            latencies().add(op_clock::now() - start);
+        });
+    };
+}
+
+static latency_histogram& local_read_latencies() {
+    return read_latencies;
+}
+
+static latency_histogram& local_write_latencies() {
+    return write_latencies;
+}
+
 static void create_partitions(cql_test_env& env, test_config& cfg) {
     std::cout << "Creating " << cfg.partitions << " partitions..." << std::endl;
     for (unsigned sequence = 0; sequence < cfg.partitions; ++sequence) {
@@ -100,50 +241,67 @@ static void create_partitions(cql_test_env& env, test_config& cfg) {
     }
 }
 
+static const sstring read_query = "select \"C0\", \"C1\", \"C2\", \"C3\", \"C4\" from cf where \"KEY\" = ?";
+
+static const sstring write_query = "UPDATE cf SET "
+        "\"C0\" = 0x8f75da6b3dcec90c8a404fb9a5f6b0621e62d39c69ba5758e5f41b78311fbb26cc7a,"
+        "\"C1\" = 0xa8761a2127160003033a8f4f3d1069b7833ebe24ef56b3beee728c2b686ca516fa51,"
+        "\"C2\" = 0x583449ce81bfebc2e1a695eb59aad5fcc74d6d7311fc6197b10693e1a161ca2e1c64,"
+        "\"C3\" = 0x62bcb1dbc0ff953abc703bcb63ea954f437064c0c45366799658bd6b91d0f92908d7,"
+        "\"C4\" = 0x222fcbe31ffa1e689540e1499b87fa3f9c781065fccd10e4772b4c7039c2efd0fb27 "
+        "WHERE \"KEY\" = ?;";
+
+static const sstring counter_update_query = "UPDATE cf SET "
+        "\"C0\" = \"C0\" + 1,"
+        "\"C1\" = \"C1\" + 2,"
+        "\"C2\" = \"C2\" + 3,"
+        "\"C3\" = \"C3\" + 4,"
+        "\"C4\" = \"C4\" + 5 "
+        "WHERE \"KEY\" = ?;";
+
+static auto execute_for_key(cql_test_env& env, cql3::prepared_cache_key_type id, uint64_t key) {
+    return env.execute_prepared(id, {{cql3::raw_value::make_value(make_key(key))}}).discard_result();
+}
+
 static std::vector<double> test_read(cql_test_env& env, test_config& cfg) {
     create_partitions(env, cfg);
-    auto id = env.prepare("select \"C0\", \"C1\", \"C2\", \"C3\", \"C4\" from cf where \"KEY\" = ?").get0();
-    return time_parallel([&env, &cfg, id] {
-            bytes key = make_key(cfg.query_single_key ? 0 : std::rand() % cfg.partitions);
-            return env.execute_prepared(id, {{cql3::raw_value::make_value(std::move(key))}}).discard_result();
-        }, cfg.concurrency, cfg.duration_in_seconds, cfg.operations_per_shard);
+    auto id = env.prepare(read_query).get0();
+    return run_operations(cfg, timed(local_read_latencies, [&env, keys = key_chooser(cfg), id] {
+        return execute_for_key(env, id, keys.read_key());
+    }));
 }
 
 static std::vector<double> test_write(cql_test_env& env, test_config& cfg) {
-    auto id = env.prepare("UPDATE cf SET "
-                           "\"C0\" = 0x8f75da6b3dcec90c8a404fb9a5f6b0621e62d39c69ba5758e5f41b78311fbb26cc7a,"
-                           "\"C1\" = 0xa8761a2127160003033a8f4f3d1069b7833ebe24ef56b3beee728c2b686ca516fa51,"
-                           "\"C2\" = 0x583449ce81bfebc2e1a695eb59aad5fcc74d6d7311fc6197b10693e1a161ca2e1c64,"
-                           "\"C3\" = 0x62bcb1dbc0ff953abc703bcb63ea954f437064c0c45366799658bd6b91d0f92908d7,"
-                           "\"C4\" = 0x222fcbe31ffa1e689540e1499b87fa3f9c781065fccd10e4772b4c7039c2efd0fb27 "
-                           "WHERE \"KEY\" = ?;").get0();
-    return time_parallel([&env, &cfg, id] {
-            bytes key = make_key(cfg.query_single_key ? 0 : std::rand() % cfg.partitions);
-            return env.execute_prepared(id, {{cql3::raw_value::make_value(std::move(key))}}).discard_result();
-        }, cfg.concurrency, cfg.duration_in_seconds, cfg.operations_per_shard);
+    auto id = env.prepare(cfg.counters ? counter_update_query : write_query).get0();
+    return run_operations(cfg, timed(local_write_latencies, [&env, keys = key_chooser(cfg), id] {
+        return execute_for_key(env, id, keys.write_key());
+    }));
 }
 
 static std::vector<double> test_delete(cql_test_env& env, test_config& cfg) {
     create_partitions(env, cfg);
     auto id = env.prepare("DELETE \"C0\", \"C1\", \"C2\", \"C3\", \"C4\" FROM cf WHERE \"KEY\" = ?").get0();
-    return time_parallel([&env, &cfg, id] {
-            bytes key = make_key(cfg.query_single_key ? 0 : std::rand() % cfg.partitions);
-            return env.execute_prepared(id, {{cql3::raw_value::make_value(std::move(key))}}).discard_result();
-        }, cfg.concurrency, cfg.duration_in_seconds, cfg.operations_per_shard);
+    return run_operations(cfg, timed(local_write_latencies, [&env, keys = key_chooser(cfg), id] {
+        return execute_for_key(env, id, keys.write_key());
+    }));
 }
 
-static std::vector<double> test_counter_update(cql_test_env& env, test_config& cfg) {
-    auto id = env.prepare("UPDATE cf SET "
-                           "\"C0\" = \"C0\" + 1,"
-                           "\"C1\" = \"C1\" + 2,"
-                           "\"C2\" = \"C2\" + 3,"
-                           "\"C3\" = \"C3\" + 4,"
-                           "\"C4\" = \"C4\" + 5 "
-                           "WHERE \"KEY\" = ?;").get0();
-    return time_parallel([&env, &cfg, id] {
-            bytes key = make_key(cfg.query_single_key ? 0 : std::rand() % cfg.partitions);
-            return env.execute_prepared(id, {{cql3::raw_value::make_value(std::move(key))}}).discard_result();
-        }, cfg.concurrency, cfg.duration_in_seconds, cfg.operations_per_shard);
+static std::vector<double> test_mixed(cql_test_env& env, test_config& cfg) {
+    create_partitions(env, cfg);
+    auto read_id = env.prepare(read_query).get0();
+    auto write_id = env.prepare(cfg.counters ? counter_update_query : write_query).get0();
+    auto read = timed(local_read_latencies, [&env, keys = key_chooser(cfg), read_id] {
+        return execute_for_key(env, read_id, keys.read_key());
+    });
+    auto write = timed(local_write_latencies, [&env, keys = key_chooser(cfg), write_id] {
+        return execute_for_key(env, write_id, keys.write_key());
+    });
+    return run_operations(cfg, [&cfg, read = std::move(read), write = std::move(write)] (op_clock::time_point start) {
+        if (seastar::testing::local_random_engine() % 100 < cfg.read_percentage) {
+            return read(start);
+        }
+        return write(start);
+    });
 }
 
 static schema_ptr make_counter_schema(std::string_view ks_name) {
@@ -175,18 +333,37 @@ static std::vector<double> do_test(cql_test_env& env, test_config& cfg) {
     case test_config::run_mode::read:
         return test_read(env, cfg);
     case test_config::run_mode::write:
-        if (cfg.counters) {
-            return test_counter_update(env, cfg);
-        } else {
-            return test_write(env, cfg);
-        }
+        return test_write(env, cfg);
     case test_config::run_mode::del:
         return test_delete(env, cfg);
+    case test_config::run_mode::mixed:
+        return test_mixed(env, cfg);
     };
     abort();
 }
 
-void write_json_result(std::string result_file, const test_config& cfg, double median, double mad, double max, double min) {
+static void add_latency_stats(Json::Value& stats, const std::string& op, const latency_histogram& latencies) {
+    if (!latencies.count()) {
+        return;
+    }
+    for (auto p : {50, 90, 99}) {
+        stats[format("{} p{} latency us", op, p)] = Json::Int64(latencies.percentile(p / 100.0).count());
+    }
+    stats[format("{} p99.9 latency us", op)] = Json::Int64(latencies.percentile(0.999).count());
+    stats[format("{} max latency us", op)] = Json::Int64(latencies.max().count());
+}
+
+static void print_latency_stats(const std::string& op, const latency_histogram& latencies) {
+    if (!latencies.count()) {
+        return;
+    }
+    std::cout << format("{} latency (us): p50 {} p90 {} p99 {} p99.9 {} max {}\n", op,
+            latencies.percentile(0.5).count(), latencies.percentile(0.9).count(), latencies.percentile(0.99).count(),
+            latencies.percentile(0.999).count(), latencies.max().count());
+}
+
+void write_json_result(std::string result_file, const test_config& cfg, double median, double mad, double max, double min,
+        const latency_histogram& reads, const latency_histogram& writes) {
     Json::Value results;
 
     Json::Value params;
@@ -194,6 +371,11 @@ void write_json_result(std::string result_file, const test_config& cfg, double m
     params["partitions"] = cfg.partitions;
     params["cpus"] = smp::count;
     params["duration"] = cfg.duration_in_seconds;
+    params["rate"] = cfg.rate;
+    params["key_distribution"] = format("{}", cfg.distribution);
+    if (cfg.mode == test_config::run_mode::mixed) {
+        params["read_percentage"] = cfg.read_percentage;
+    }
     params["concurrency,partitions,cpus,duration"] = fmt::format("{},{},{},{}", cfg.concurrency, cfg.partitions, smp::count, cfg.duration_in_seconds);
     results["parameters"] = std::move(params);
 
@@ -202,6 +384,8 @@ void write_json_result(std::string result_file, const test_config& cfg, double m
     stats["mad tps"] = mad;
     stats["max tps"] = max;
     stats["min tps"] = min;
+    add_latency_stats(stats, "read", reads);
+    add_latency_stats(stats, "write", writes);
     results["stats"] = std::move(stats);
 
     std::string test_type;
@@ -209,6 +393,7 @@ void write_json_result(std::string result_file, const test_config& cfg, double m
     case test_config::run_mode::read: test_type = "read"; break;
     case test_config::run_mode::write: test_type = "write"; break;
     case test_config::run_mode::del: test_type = "delete"; break;
+    case test_config::run_mode::mixed: test_type = "mixed"; break;
     }
     if (cfg.counters) {
         test_type += "_counters";
@@ -253,6 +438,10 @@ int main(int argc, char** argv) {
         ("concurrency", bpo::value<unsigned>()->default_value(100), "workers per core")
         ("operations-per-shard", bpo::value<unsigned>(), "run this many operations per shard (overrides duration)")
         ("counters", "test counters")
+        ("mixed", bpo::value<unsigned>(), "test a mix of reads and writes, with the given percentage of reads")
+        ("key-distribution", bpo::value<std::string>()->default_value("uniform"), "distribution of the accessed partitions: uniform, zipfian or latest")
+        ("rate", bpo::value<unsigned>(), "start operations at this fixed rate per shard instead of as fast as possible, "
+                "measuring latencies from the intended start times; concurrency then limits the operations in flight")
         ("json-result", bpo::value<std::string>(), "name of the json result file")
         ;
 
@@ -273,13 +462,29 @@ int main(int argc, char** argv) {
             cfg.concurrency = app.configuration()["concurrency"].as<unsigned>();
             cfg.query_single_key = app.configuration().count("query-single-key");
             cfg.counters = app.configuration().count("counters");
-            if (app.configuration().count("write")) {
+            if (app.configuration().count("mixed")) {
+                cfg.mode = test_config::run_mode::mixed;
+                cfg.read_percentage = std::min(app.configuration()["mixed"].as<unsigned>(), 100u);
+            } else if (app.configuration().count("write")) {
                 cfg.mode = test_config::run_mode::write;
             } else if (app.configuration().count("delete")) {
                 cfg.mode = test_config::run_mode::del;
             } else {
                 cfg.mode = test_config::run_mode::read;
             };
+            auto distribution = app.configuration()["key-distribution"].as<std::string>();
+            if (distribution == "uniform") {
+                cfg.distribution = test_config::key_distribution::uniform;
+            } else if (distribution == "zipfian") {
+                cfg.distribution = test_config::key_distribution::zipfian;
+            } else if (distribution == "latest") {
+                cfg.distribution = test_config::key_distribution::latest;
+            } else {
+                throw std::invalid_argument(format("unknown key distribution: {}", distribution));
+            }
+            if (app.configuration().count("rate")) {
+                cfg.rate = app.configuration()["rate"].as<unsigned>();
+            }
             if (app.configuration().count("operations-per-shard")) {
                 cfg.operations_per_shard = app.configuration()["operations-per-shard"].as<unsigned>();
             }
@@ -296,8 +501,13 @@ int main(int argc, char** argv) {
             auto mad = results[results.size() / 2];
             std::cout << format("\nmedian {:.2f}\nmedian absolute deviation: {:.2f}\nmaximum: {:.2f}\nminimum: {:.2f}\n", median, mad, max, min);
 
+            auto reads = gather_latencies(local_read_latencies);
+            auto writes = gather_latencies(local_write_latencies);
+            print_latency_stats("read", reads);
+            print_latency_stats("write", writes);
+
             if (app.configuration().count("json-result")) {
-                write_json_result(app.configuration()["json-result"].as<std::string>(), cfg, median, mad, max, min);
+                write_json_result(app.configuration()["json-result"].as<std::string>(), cfg, median, mad, max, min, reads, writes);
             }
           });
     });
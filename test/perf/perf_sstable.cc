@@ -66,12 +66,51 @@ future<> test_sequential_read(distributed<perf_sstable_test_env>& dt) {
     return time_runs(iterations, parallelism, dt, &perf_sstable_test_env::read_sequential_partitions);
 }
 
+// Options making each strategy act on the time-compressed workload of
+// simulate_compaction_strategy() the way it would on a real one.
+static std::map<sstring, sstring> simulation_options(compaction_strategy_type type) {
+    switch (type) {
+    case compaction_strategy_type::leveled:
+        // Keep the sstables small enough to fill a few levels.
+        return {{"sstable_size_in_mb", "1"}};
+    case compaction_strategy_type::time_window:
+        return {{"compaction_window_unit", "HOURS"}, {"compaction_window_size", "1"}};
+    case compaction_strategy_type::date_tiered:
+        return {{"base_time_seconds", "3600"}, {"max_sstable_age_days", "365"}};
+    default:
+        return {};
+    }
+}
+
+future<> test_compaction_strategies(distributed<perf_sstable_test_env>& dt, std::vector<compaction_strategy_type> types) {
+    return seastar::async([&dt, types = std::move(types)] {
+        storage_service_for_tests ssft;
+        for (auto type : types) {
+            auto r = dt.invoke_on(0, [type] (perf_sstable_test_env& t) {
+                return t.simulate_compaction_strategy(type, simulation_options(type));
+            }).get0();
+            std::cout << compaction_strategy::name(type) << ":\n";
+            std::cout << format("  write amplification: {:.2f} ({} compactions, {} bytes flushed, {} bytes compacted)\n",
+                    double(r.flushed_bytes + r.compaction_bytes_written) / std::max<uint64_t>(1, r.flushed_bytes),
+                    r.compactions, r.flushed_bytes, r.compaction_bytes_written);
+            std::cout << format("  compaction cpu: {:.3f} s\n", std::chrono::duration<double>(r.compaction_cpu).count());
+            std::cout << "  step     sstables  sstables/read  space amplification\n";
+            for (auto& sample : r.samples) {
+                auto logical = r.bytes_per_live_key * sample.live_keys;
+                std::cout << format("  {:<8d} {:<9d} {:<14.2f} {:.2f}\n", sample.step, sample.sstables, sample.sstables_per_read,
+                        logical > 0 ? sample.live_bytes / logical : 0.0);
+            }
+        }
+    });
+}
+
 enum class test_modes {
     sequential_read,
     index_read,
     write,
     index_write,
     compaction,
+    compaction_strategies,
 };
 
 static std::unordered_map<sstring, test_modes> test_mode = {
@@ -80,6 +119,7 @@ static std::unordered_map<sstring, test_modes> test_mode = {
     {"write", test_modes::write },
     {"index_write", test_modes::index_write },
     {"compaction", test_modes::compaction },
+    {"compaction_strategies", test_modes::compaction_strategies },
 };
 
 int main(int argc, char** argv) {
@@ -94,7 +134,18 @@ int main(int argc, char** argv) {
         ("num_columns", bpo::value<unsigned>()->default_value(5), "number of columns per row")
         ("column_size", bpo::value<unsigned>()->default_value(64), "size in bytes for each column")
         ("sstables", bpo::value<unsigned>()->default_value(1), "number of sstables (valid only for compaction mode)")
-        ("mode", bpo::value<sstring>()->default_value("index_write"), "one of: sequential_read, index_read, write, compaction, index_write (default)")
+        ("strategies", bpo::value<std::vector<sstring>>()->default_value({"SizeTieredCompactionStrategy", "LeveledCompactionStrategy",
+                "TimeWindowCompactionStrategy", "DateTieredCompactionStrategy"}, "STCS, LCS, TWCS, DTCS"), "strategies to compare (compaction_strategies mode)")
+        ("sim_keys", bpo::value<unsigned>()->default_value(100000), "number of distinct keys (compaction_strategies mode)")
+        ("sim_steps", bpo::value<unsigned>()->default_value(500), "number of flushes (compaction_strategies mode)")
+        ("sim_ops_per_step", bpo::value<unsigned>()->default_value(2000), "operations between flushes (compaction_strategies mode)")
+        ("sim_step_duration", bpo::value<unsigned>()->default_value(60), "simulated seconds between flushes (compaction_strategies mode)")
+        ("sim_samples", bpo::value<unsigned>()->default_value(10), "number of space amplification samples (compaction_strategies mode)")
+        ("sim_overwrite_ratio", bpo::value<double>()->default_value(0.5), "fraction of writes overwriting an existing key (compaction_strategies mode)")
+        ("sim_delete_ratio", bpo::value<double>()->default_value(0.05), "fraction of operations deleting a key (compaction_strategies mode)")
+        ("sim_ttl_ratio", bpo::value<double>()->default_value(0.1), "fraction of writes with a TTL (compaction_strategies mode)")
+        ("sim_ttl", bpo::value<unsigned>()->default_value(6 * 3600), "TTL in simulated seconds (compaction_strategies mode)")
+        ("mode", bpo::value<sstring>()->default_value("index_write"), "one of: sequential_read, index_read, write, compaction, compaction_strategies, index_write (default)")
         ("testdir", bpo::value<sstring>()->default_value("/var/lib/scylla/perf-tests"), "directory in which to store the sstables");
 
     return app.run_deprecated(argc, argv, [&app] {
@@ -107,6 +158,19 @@ int main(int argc, char** argv) {
         cfg.key_size = app.configuration()["key_size"].as<unsigned>();
         cfg.buffer_size = app.configuration()["buffer_size"].as<unsigned>() << 10;
         cfg.sstables = app.configuration()["sstables"].as<unsigned>();
+        cfg.sim_keys = app.configuration()["sim_keys"].as<unsigned>();
+        cfg.sim_steps = app.configuration()["sim_steps"].as<unsigned>();
+        cfg.sim_ops_per_step = app.configuration()["sim_ops_per_step"].as<unsigned>();
+        cfg.sim_step_duration = std::chrono::seconds(app.configuration()["sim_step_duration"].as<unsigned>());
+        cfg.sim_samples = app.configuration()["sim_samples"].as<unsigned>();
+        cfg.sim_overwrite_ratio = app.configuration()["sim_overwrite_ratio"].as<double>();
+        cfg.sim_delete_ratio = app.configuration()["sim_delete_ratio"].as<double>();
+        cfg.sim_ttl_ratio = app.configuration()["sim_ttl_ratio"].as<double>();
+        cfg.sim_ttl = std::chrono::seconds(app.configuration()["sim_ttl"].as<unsigned>());
+        std::vector<compaction_strategy_type> strategies;
+        for (auto& name : app.configuration()["strategies"].as<std::vector<sstring>>()) {
+            strategies.push_back(compaction_strategy::type(name));
+        }
         sstring dir = app.configuration()["testdir"].as<sstring>();
         cfg.dir = dir;
         auto mode = test_mode[app.configuration()["mode"].as<sstring>()];
@@ -131,12 +195,13 @@ int main(int argc, char** argv) {
                         throw;
                     }
                 });
-            } else if ((mode == test_modes::index_write) || (mode == test_modes::write) || (mode == test_modes::compaction)) {
+            } else if ((mode == test_modes::index_write) || (mode == test_modes::write) || (mode == test_modes::compaction)
+                    || (mode == test_modes::compaction_strategies)) {
                 return test_setup::create_empty_test_dir(dir);
             } else {
                 throw std::invalid_argument("Invalid mode");
             }
-        }).then([test, mode] {
+        }).then([test, mode, strategies = std::move(strategies)] () mutable {
             if (mode == test_modes::index_read) {
                 return test_index_read(*test).then([test] {});
             } else if (mode == test_modes::sequential_read) {
@@ -145,6 +210,8 @@ int main(int argc, char** argv) {
                 return test_write(*test).then([test] {});
             } else if (mode == test_modes::compaction) {
                 return test_compaction(*test).then([test] {});
+            } else if (mode == test_modes::compaction_strategies) {
+                return test_compaction_strategies(*test, std::move(strategies)).then([test] {});
             } else {
                 throw std::invalid_argument("Invalid mode");
             }
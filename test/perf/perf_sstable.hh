@@ -29,6 +29,9 @@
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics.hpp>
 #include <boost/range/irange.hpp>
+#include <boost/range/algorithm/count_if.hpp>
+#include <unordered_map>
+#include <time.h>
 
 using namespace sstables;
 
@@ -44,6 +47,34 @@ class perf_sstable_test_env {
         unsigned sstables;
         size_t buffer_size;
         sstring dir;
+        // Only used by simulate_compaction_strategy()
+        unsigned sim_keys = 100000;
+        unsigned sim_steps = 500;
+        unsigned sim_ops_per_step = 2000;
+        unsigned sim_samples = 10;
+        double sim_overwrite_ratio = 0.5;
+        double sim_ttl_ratio = 0.1;
+        double sim_delete_ratio = 0.05;
+        gc_clock::duration sim_ttl = std::chrono::hours(6);
+        gc_clock::duration sim_step_duration = std::chrono::minutes(1);
+    };
+
+    struct space_amplification_sample {
+        unsigned step;
+        uint64_t live_bytes;
+        unsigned live_keys;
+        unsigned sstables;
+        double sstables_per_read;
+    };
+
+    struct strategy_report {
+        uint64_t flushed_bytes = 0;
+        uint64_t compaction_bytes_written = 0;
+        unsigned compactions = 0;
+        std::chrono::nanoseconds compaction_cpu{0};
+        std::vector<space_amplification_sample> samples;
+        // Size of one live key, as seen after a final major compaction
+        double bytes_per_live_key = 0;
     };
 
 private:
@@ -191,6 +222,179 @@ class perf_sstable_test_env {
         });
     }
 
+    static std::chrono::nanoseconds thread_cpu_time() {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    }
+
+    static uint64_t live_bytes(const column_family& cf) {
+        uint64_t bytes = 0;
+        for (auto& sst : *cf.get_sstables()) {
+            bytes += sst->bytes_on_disk();
+        }
+        return bytes;
+    }
+
+    // Replays a time-compressed workload of inserts, overwrites, TTLed writes
+    // and partition deletions into a table using the given compaction
+    // strategy. Each step applies sim_ops_per_step operations, flushes the
+    // memtable and runs every compaction the strategy asks for, the way the
+    // compaction manager would. Steps advance the clock of the mutations by
+    // sim_step_duration and the last step ends at the real now, so no data is
+    // written in the future. TTL expiration and time windows are evaluated
+    // against gc_clock::now(), so every step sees the whole run as the past.
+    //
+    // Compactions run synchronously in this fiber, so the CPU time of the
+    // reactor thread spent in them is their CPU cost.
+    future<strategy_report> simulate_compaction_strategy(compaction_strategy_type type, std::map<sstring, sstring> options) {
+        return seastar::async([this, type, options = std::move(options)] {
+            auto sim_dir = dir() + "/" + compaction_strategy::name(type);
+            test_setup::create_empty_test_dir(dir()).get();
+            test_setup::create_empty_test_dir(sim_dir).get();
+
+            // Tombstones and expired cells become purgeable as soon as they
+            // are compacted together with the data they shadow.
+            auto schema = schema_builder(s)
+                    .set_compaction_strategy(type)
+                    .set_compaction_strategy_options(std::move(options))
+                    .set_gc_grace_seconds(0)
+                    .build();
+
+            column_family::config cfg = column_family_test_config();
+            cfg.datadir = sim_dir;
+            cfg.enable_commitlog = false;
+            cfg.enable_incremental_backups = false;
+            cache_tracker tracker;
+            cell_locker_stats cl_stats;
+            // Never started: compactions triggered by flushes are no-ops,
+            // the loop below runs them instead.
+            auto cm = make_lw_shared<compaction_manager>();
+            auto cf = make_lw_shared<column_family>(schema, cfg, column_family::no_commitlog(), *cm, cl_stats, tracker);
+            cf->mark_ready_for_writes();
+
+            std::vector<dht::decorated_key> keys;
+            for (auto& k : make_local_keys(_cfg.sim_keys, schema, _cfg.key_size)) {
+                keys.push_back(dht::decorate_key(*schema, partition_key::from_deeply_exploded(*schema, { k })));
+            }
+            // Key index -> expiration of its data; keys which were never
+            // written or were deleted are absent.
+            std::unordered_map<unsigned, gc_clock::time_point> live;
+            unsigned next_fresh = 0;
+
+            const auto sim_end = gc_clock::now();
+            const auto sim_start = sim_end - _cfg.sim_step_duration * _cfg.sim_steps;
+            std::uniform_real_distribution<double> op_dist(0, 1);
+            std::uniform_int_distribution<unsigned> key_dist;
+
+            strategy_report report;
+
+            auto pick_written = [&] {
+                return key_dist(_generator) % next_fresh;
+            };
+
+            auto apply_op = [&] (gc_clock::time_point now) {
+                auto ts = api::timestamp_type(std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count());
+                auto r = op_dist(_generator);
+                if (next_fresh && r < _cfg.sim_delete_ratio) {
+                    auto i = pick_written();
+                    mutation m(schema, keys[i].key());
+                    m.partition().apply(tombstone(ts, now));
+                    cf->apply(std::move(m));
+                    live.erase(i);
+                    return;
+                }
+                unsigned i;
+                if (next_fresh && (r < _cfg.sim_delete_ratio + _cfg.sim_overwrite_ratio || next_fresh == keys.size())) {
+                    i = pick_written();
+                } else {
+                    i = next_fresh++;
+                }
+                bool ttl = op_dist(_generator) < _cfg.sim_ttl_ratio;
+                mutation m(schema, keys[i].key());
+                for (auto& cdef : schema->regular_columns()) {
+                    auto value = utf8_type->decompose(random_column());
+                    auto cell = ttl ? atomic_cell::make_live(*utf8_type, ts, value, now + _cfg.sim_ttl, _cfg.sim_ttl)
+                                    : atomic_cell::make_live(*utf8_type, ts, value);
+                    m.set_clustered_cell(clustering_key::make_empty(), cdef, std::move(cell));
+                }
+                cf->apply(std::move(m));
+                live[i] = ttl ? now + _cfg.sim_ttl : gc_clock::time_point::max();
+            };
+
+            // Some strategies keep proposing the same sstable when it has
+            // droppable data which can't be purged; don't loop on it.
+            static constexpr unsigned max_compactions_per_step = 100;
+            auto run_compactions = [&] {
+                for (unsigned n = 0; n < max_compactions_per_step; ++n) {
+                    auto desc = cf->get_compaction_strategy().get_sstables_for_compaction(*cf, cf->candidates_for_compaction());
+                    if (desc.sstables.empty()) {
+                        return;
+                    }
+                    uint64_t input_bytes = 0;
+                    for (auto& sst : desc.sstables) {
+                        input_bytes += sst->bytes_on_disk();
+                    }
+                    auto before = live_bytes(*cf);
+                    auto cpu_start = thread_cpu_time();
+                    cf->compact_sstables(std::move(desc)).get();
+                    report.compaction_cpu += thread_cpu_time() - cpu_start;
+                    report.compaction_bytes_written += live_bytes(*cf) + input_bytes - before;
+                    report.compactions++;
+                }
+            };
+
+            // A read touches every sstable whose key range contains the key
+            // and whose filter can't rule it out.
+            static constexpr unsigned reads_per_sample = 1000;
+            auto sstables_per_read = [&] {
+                if (!next_fresh) {
+                    return 0.0;
+                }
+                auto ssts = cf->get_sstables();
+                uint64_t touched = 0;
+                for (unsigned n = 0; n < reads_per_sample; ++n) {
+                    auto& dk = keys[pick_written()];
+                    for (auto& sst : *ssts) {
+                        touched += dk.tri_compare(*schema, sst->get_first_decorated_key()) >= 0
+                                && dk.tri_compare(*schema, sst->get_last_decorated_key()) <= 0
+                                && sst->filter_has_key(*schema, dk.key());
+                    }
+                }
+                return double(touched) / reads_per_sample;
+            };
+
+            auto live_keys = [&] (gc_clock::time_point now) {
+                return unsigned(boost::count_if(live, [now] (auto& e) { return e.second > now; }));
+            };
+
+            auto sample_every = std::max(1u, _cfg.sim_steps / std::max(1u, _cfg.sim_samples));
+            for (unsigned step = 0; step < _cfg.sim_steps; ++step) {
+                auto step_start = sim_start + _cfg.sim_step_duration * step;
+                for (unsigned op = 0; op < _cfg.sim_ops_per_step; ++op) {
+                    apply_op(step_start + _cfg.sim_step_duration * op / _cfg.sim_ops_per_step);
+                }
+                auto before = live_bytes(*cf);
+                cf->flush().get();
+                report.flushed_bytes += live_bytes(*cf) - before;
+                run_compactions();
+                if ((step + 1) % sample_every == 0 || step + 1 == _cfg.sim_steps) {
+                    auto step_end = step_start + _cfg.sim_step_duration;
+                    report.samples.push_back({step + 1, live_bytes(*cf), live_keys(step_end), unsigned(cf->sstables_count()), sstables_per_read()});
+                }
+            }
+
+            auto all = boost::copy_range<std::vector<shared_sstable>>(*cf->get_sstables());
+            if (!all.empty()) {
+                cf->compact_sstables(sstables::compaction_descriptor(std::move(all))).get();
+            }
+            report.bytes_per_live_key = double(live_bytes(*cf)) / std::max(1u, live_keys(gc_clock::now()));
+
+            cf->stop().get();
+            return report;
+        });
+    }
+
     future<double> read_all_indexes(int idx) {
         return do_with(test(_sst[0]), [] (auto& sst) {
             const auto start = perf_sstable_test_env::now();
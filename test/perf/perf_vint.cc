@@ -23,6 +23,8 @@
 #include "seastar/include/seastar/testing/perf_tests.hh"
 #include <seastar/testing/test_runner.hh>
 
+#include <array>
+#include <limits>
 #include <random>
 
 #include "vint-serialization.hh"
@@ -33,13 +35,13 @@ class vint {
 private:
     std::vector<uint64_t> _integers;
     bytes _serialized;
-public:
-    vint()
+protected:
+    explicit vint(uint64_t max)
         : _integers(count)
         , _serialized(bytes::initialized_later{}, count * max_vint_length)
     {
         auto eng = seastar::testing::local_random_engine;
-        auto dist = std::uniform_int_distribution<uint64_t>{};
+        auto dist = std::uniform_int_distribution<uint64_t>{0, max};
         std::generate_n(_integers.begin(), count, [&] { return dist(eng); });
 
         auto dst = _serialized.data();
@@ -48,9 +50,24 @@ class vint {
             dst += len;
         }
     }
+public:
+    vint() : vint(std::numeric_limits<uint64_t>::max()) { }
 
     const std::vector<uint64_t>& integers() const { return _integers; }
-    bytes_view serialized() const { return bytes_view(_serialized.data()); }
+    bytes_view serialized() const { return bytes_view(_serialized); }
+};
+
+// Lengths and deltas in sstables are mostly small, so most of their vints
+// are one or two bytes long.
+class small_vint : public vint {
+public:
+    small_vint() : vint(1 << 14) { }
+};
+
+// Flags-sized values, which come in runs in cell headers and column lists.
+class single_byte_vint : public vint {
+public:
+    single_byte_vint() : vint(127) { }
 };
 
 PERF_TEST_F(vint, serialize) {
@@ -72,3 +89,43 @@ PERF_TEST_F(vint, deserialize) {
     }
     return count;
 }
+
+PERF_TEST_F(small_vint, deserialize) {
+    auto src = serialized();
+    for (auto i = 0u; i < count; i++) {
+        auto len = unsigned_vint::serialized_size_from_first_byte(src.front());
+        perf_tests::do_not_optimize(unsigned_vint::deserialize(src));
+        src.remove_prefix(len);
+    }
+    return count;
+}
+
+template <typename Vint>
+static size_t deserialize_batch(const Vint& v) {
+    std::array<uint64_t, Vint::count> output;
+    perf_tests::do_not_optimize(unsigned_vint::deserialize_batch(v.serialized(), output.data(), output.size()));
+    perf_tests::do_not_optimize(output);
+    return Vint::count;
+}
+
+PERF_TEST_F(vint, deserialize_batch) {
+    return deserialize_batch(*this);
+}
+
+PERF_TEST_F(small_vint, deserialize_batch) {
+    return deserialize_batch(*this);
+}
+
+PERF_TEST_F(single_byte_vint, deserialize) {
+    auto src = serialized();
+    for (auto i = 0u; i < count; i++) {
+        auto len = unsigned_vint::serialized_size_from_first_byte(src.front());
+        perf_tests::do_not_optimize(unsigned_vint::deserialize(src));
+        src.remove_prefix(len);
+    }
+    return count;
+}
+
+PERF_TEST_F(single_byte_vint, deserialize_batch) {
+    return deserialize_batch(*this);
+}
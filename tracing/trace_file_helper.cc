@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/algorithm/string/replace.hpp>
+#include <seastar/core/align.hh>
+#include <seastar/core/metrics.hh>
+#include <seastar/core/seastar.hh>
+#include "tracing/trace_file_helper.hh"
+#include "tracing/tracing_backend_registry.hh"
+#include "log.hh"
+
+namespace tracing {
+
+static logging::logger tflogger("trace_file_helper");
+
+// A record spans a single line of the file.
+static sstring escape_newlines(const sstring& s) {
+    auto ret = s;
+    boost::replace_all(ret, "\n", "\\n");
+    return ret;
+}
+
+static int64_t millis_since_epoch(i_tracing_backend_helper::wall_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+}
+
+static int64_t micros(elapsed_clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+trace_file_helper::trace_file_helper(tracing& tr, config cfg)
+        : i_tracing_backend_helper(tr)
+        , _cfg(std::move(cfg)) {
+    namespace sm = seastar::metrics;
+
+    _metrics.add_group("tracing_file_helper", {
+        sm::make_derive("tracing_errors", [this] { return _stats.tracing_errors; },
+                        sm::description("Counts a number of errors during writing to the tracing file. "
+                                        "One error may cause one or more tracing records to be lost.")),
+
+        sm::make_derive("wrap_arounds", [this] { return _stats.wrap_arounds; },
+                        sm::description("Counts a number of times the writing of the tracing file wrapped around to its beginning, "
+                                        "overwriting the oldest records.")),
+    });
+}
+
+sstring trace_file_helper::file_path() const {
+    return format("{}/{}/traces.log", _cfg.directory, this_shard_id());
+}
+
+future<> trace_file_helper::start() {
+    return open_file_dma(file_path(), open_flags::rw | open_flags::create).then([this] (file f) {
+        _file = std::move(f);
+        _alignment = _file.disk_write_dma_alignment();
+        _file_size = align_down<uint64_t>(_cfg.file_size, _alignment);
+        if (!_file_size) {
+            throw std::invalid_argument(format("tracing file size {:d} is smaller than the write alignment of {}", _cfg.file_size, file_path()));
+        }
+        return _file.truncate(_file_size);
+    }).then([this] {
+        tflogger.info("Writing tracing records to {}", file_path());
+    });
+}
+
+future<> trace_file_helper::stop() {
+    return _pending_writes.close().then([this] {
+        if (!_file) {
+            return make_ready_future<>();
+        }
+        return _file.flush().finally([this] {
+            return _file.close();
+        });
+    });
+}
+
+void trace_file_helper::format_records(const one_session_records& records, const std::deque<event_record>& events, bool session_record_is_ready, sstring& out) const {
+    for (const event_record& e : events) {
+        out += format("event session_id={} event_time={:d} elapsed_us={:d} parent_id={} span_id={} thread={} activity=\"{}\"\n",
+                records.session_id, millis_since_epoch(e.event_time_point), micros(e.elapsed), records.parent_id, records.my_span_id,
+                _local_tracing.get_thread_name(), escape_newlines(e.message));
+    }
+    if (session_record_is_ready) {
+        const session_record& r = records.session_rec;
+        sstring parameters;
+        for (auto& [name, value] : r.parameters) {
+            parameters += format("{}{}=\"{}\"", parameters.empty() ? "" : ",", name, escape_newlines(value));
+        }
+        out += format("session session_id={} command={} client={} username={} started_at={:d} duration_us={:d} request_size={:d} response_size={:d} "
+                "slow_query={} request=\"{}\" parameters={{{}}}\n",
+                records.session_id, type_to_string(r.command), r.client, r.username, millis_since_epoch(r.started_at), micros(r.elapsed),
+                r.request_size, r.response_size, records.do_log_slow_query, escape_newlines(r.request), parameters);
+    }
+}
+
+void trace_file_helper::write_records_bulk(records_bulk& bulk) {
+    tflogger.trace("Writing {} sessions", bulk.size());
+    uint64_t num_records = 0;
+    sstring block = format("# block {:d} {:d}\n", _next_block++, millis_since_epoch(wall_clock::now()));
+    for (auto& records : bulk) {
+        num_records += records->size();
+        // Uses the same snapshot of the session as the other backends: its
+        // record is written only after all its events records.
+        bool session_record_is_ready = records->session_rec.ready();
+        auto events = std::move(records->events_recs);
+        records->events_recs.clear();
+        records->data_consumed();
+        format_records(*records, events, session_record_is_ready, block);
+    }
+
+    // Future is waited on indirectly in `stop()` (via `_pending_writes`).
+    (void)with_gate(_pending_writes, [this, block = std::move(block), num_records] () mutable {
+        return write_block(std::move(block)).finally([this, num_records] { _local_tracing.write_complete(num_records); });
+    }).handle_exception([this] (auto ep) {
+        ++_stats.tracing_errors;
+        tflogger.warn("Failed to write tracing records to {}: {}", file_path(), ep);
+    });
+}
+
+future<> trace_file_helper::write_block(sstring block) {
+    // Pad the block with blank lines up to the write alignment, and only keep
+    // the beginning of blocks which don't fit in the file.
+    auto size = std::min<uint64_t>(align_up<uint64_t>(block.size(), _alignment), _file_size);
+    auto buf = temporary_buffer<char>::aligned(_alignment, size);
+    auto copied = std::min<size_t>(block.size(), size);
+    std::copy_n(block.begin(), copied, buf.get_write());
+    std::fill(buf.get_write() + copied, buf.get_write() + size, '\n');
+
+    if (_pos + size > _file_size) {
+        _pos = 0;
+        ++_stats.wrap_arounds;
+    }
+    auto pos = _pos;
+    _pos += size;
+    auto p = buf.get();
+    return _file.dma_write(pos, p, size).then([this, buf = std::move(buf), size] (size_t written) {
+        if (written != size) {
+            throw std::runtime_error(format("short write to {}: {:d} out of {:d} bytes", file_path(), written, size));
+        }
+    });
+}
+
+std::unique_ptr<backend_session_state_base> trace_file_helper::allocate_session_state() const {
+    return std::make_unique<backend_session_state_base>();
+}
+
+void register_tracing_file_backend(backend_registry& tbr, sstring directory, uint64_t file_size) {
+    tbr.register_backend<trace_file_helper>("trace_file_helper", trace_file_helper::config{std::move(directory), file_size});
+}
+
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <seastar/core/file.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics_registration.hh>
+#include "tracing/tracing.hh"
+
+namespace tracing {
+
+/**
+ * A tracing backend which writes the records to a local file, without going
+ * through the storage proxy.
+ *
+ * Each shard has its own file of a fixed size, used as a ring buffer: every
+ * write_records_bulk() call appends a block of text lines, one per record,
+ * and wraps around to the beginning of the file when the block doesn't fit
+ * at its end. Each block starts with a "# block <sequence> <time>" line, so
+ * that the newest records can be found after a wrap around.
+ */
+class trace_file_helper final : public i_tracing_backend_helper {
+public:
+    struct config {
+        // Each shard's file is in the <directory>/<shard id> directory.
+        sstring directory;
+        uint64_t file_size;
+    };
+
+private:
+    config _cfg;
+    file _file;
+    size_t _alignment = 4096;
+    uint64_t _file_size = 0;
+    uint64_t _pos = 0;
+    uint64_t _next_block = 0;
+    seastar::gate _pending_writes;
+
+    struct stats {
+        uint64_t tracing_errors = 0;
+        uint64_t wrap_arounds = 0;
+    } _stats;
+
+    seastar::metrics::metric_groups _metrics;
+
+public:
+    trace_file_helper(tracing& tr, config cfg);
+    virtual ~trace_file_helper() {}
+
+    virtual future<> start() override;
+    virtual future<> stop() override;
+
+    virtual void write_records_bulk(records_bulk& bulk) override;
+    virtual std::unique_ptr<backend_session_state_base> allocate_session_state() const override;
+
+    sstring file_path() const;
+
+private:
+    /**
+     * Append the text lines of the session record, if it's finished, and of
+     * the given events records of a session to @param out.
+     */
+    void format_records(const one_session_records& records, const std::deque<event_record>& events, bool session_record_is_ready, sstring& out) const;
+
+    /**
+     * Write a block of records at the current position of the ring buffer.
+     */
+    future<> write_block(sstring block);
+};
+
+}
@@ -38,6 +38,8 @@
  * You should have received a copy of the GNU General Public License
  * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/numeric.hpp>
 #include <seastar/core/metrics.hh>
 #include "types.hh"
 #include "tracing/trace_keyspace_helper.hh"
@@ -47,6 +49,8 @@
 #include "cql3/query_processor.hh"
 #include "cql3/cql_config.hh"
 #include "types/set.hh"
+#include "service/storage_proxy.hh"
+#include "service_permit.hh"
 
 namespace tracing {
 
@@ -210,11 +214,31 @@ future<> trace_keyspace_helper::start() {
     return table_helper::setup_keyspace(KEYSPACE_NAME, "2", _dummy_query_state, { &_sessions, &_sessions_time_idx, &_events, &_slow_query_log, &_slow_query_log_time_idx });
 }
 
-void trace_keyspace_helper::write_one_session_records(lw_shared_ptr<one_session_records> records) {
+void trace_keyspace_helper::write_records_bulk(records_bulk& bulk) {
+    tlogger.trace("Writing {} sessions", bulk.size());
+    uint64_t num_records = 0;
+    std::vector<session_write> sessions;
+    sessions.reserve(bulk.size());
+    for (auto& records : bulk) {
+        num_records += records->size();
+
+        // Check if a session's record is ready before handling events' records.
+        //
+        // New event's records and a session's record may become ready while a
+        // mutation with the current events' records is being written. We don't want
+        // to allow the situation when a session's record is written before the last
+        // event record from the same session.
+        bool session_record_is_ready = records->session_rec.ready();
+        sessions.push_back(session_write{records, std::move(records->events_recs), session_record_is_ready});
+        records->events_recs.clear();
+
+        // From this point on - all new data will have to be handled in the next write event
+        records->data_consumed();
+    }
+
     // Future is waited on indirectly in `stop()` (via `_pending_writes`).
-    (void)with_gate(_pending_writes, [this, records = std::move(records)] {
-        auto num_records = records->size();
-        return this->flush_one_session_mutations(std::move(records)).finally([this, num_records] { _local_tracing.write_complete(num_records); });
+    (void)with_gate(_pending_writes, [this, sessions = std::move(sessions), num_records] () mutable {
+        return this->flush_sessions_mutations(std::move(sessions)).finally([this, num_records] { _local_tracing.write_complete(num_records); });
     }).handle_exception([this] (auto ep) {
         try {
             ++_stats.tracing_errors;
@@ -233,14 +257,7 @@ void trace_keyspace_helper::write_one_session_records(lw_shared_ptr<one_session_
     }).discard_result();
 }
 
-void trace_keyspace_helper::write_records_bulk(records_bulk& bulk) {
-    tlogger.trace("Writing {} sessions", bulk.size());
-    std::for_each(bulk.begin(), bulk.end(), [this] (records_bulk::value_type& one_session_records_ptr) {
-        write_one_session_records(std::move(one_session_records_ptr));
-    });
-}
-
-cql3::query_options trace_keyspace_helper::make_session_mutation_data(const one_session_records& session_records) {
+std::vector<cql3::raw_value> trace_keyspace_helper::make_session_mutation_data(const one_session_records& session_records) {
     const session_record& record = session_records.session_rec;
     auto millis_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(record.started_at.time_since_epoch()).count();
     std::vector<std::pair<data_value, data_value>> parameters_values_vector;
@@ -262,11 +279,10 @@ cql3::query_options trace_keyspace_helper::make_session_mutation_data(const one_
         cql3::raw_value::make_value(int32_type->decompose((int32_t)(session_records.ttl.count())))
     };
 
-    return cql3::query_options(cql3::default_cql_config,
-            db::consistency_level::ANY, tracing_db_timeout_config, std::nullopt, std::move(values), false, cql3::query_options::specific_options::DEFAULT, cql_serialization_format::latest());
+    return values;
 }
 
-cql3::query_options trace_keyspace_helper::make_session_time_idx_mutation_data(const one_session_records& session_records) {
+std::vector<cql3::raw_value> trace_keyspace_helper::make_session_time_idx_mutation_data(const one_session_records& session_records) {
     auto started_at_duration = session_records.session_rec.started_at.time_since_epoch();
     // timestamp in minutes when the query began
     auto minutes_in_millis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration_cast<std::chrono::minutes>(started_at_duration)).count();
@@ -280,11 +296,10 @@ cql3::query_options trace_keyspace_helper::make_session_time_idx_mutation_data(c
         cql3::raw_value::make_value(int32_type->decompose(int32_t(session_records.ttl.count())))
     };
 
-    return cql3::query_options(cql3::default_cql_config,
-            db::consistency_level::ANY, tracing_db_timeout_config, std::nullopt, std::move(values), false, cql3::query_options::specific_options::DEFAULT, cql_serialization_format::latest());
+    return values;
 }
 
-cql3::query_options trace_keyspace_helper::make_slow_query_mutation_data(const one_session_records& session_records, const utils::UUID& start_time_id) {
+std::vector<cql3::raw_value> trace_keyspace_helper::make_slow_query_mutation_data(const one_session_records& session_records, const utils::UUID& start_time_id) {
     const session_record& record = session_records.session_rec;
     auto millis_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(record.started_at.time_since_epoch()).count();
 
@@ -321,11 +336,10 @@ cql3::query_options trace_keyspace_helper::make_slow_query_mutation_data(const o
         cql3::raw_value::make_value(int32_type->decompose((int32_t)(record.slow_query_record_ttl.count())))
     });
 
-    return cql3::query_options(cql3::default_cql_config,
-            db::consistency_level::ANY, tracing_db_timeout_config, std::nullopt, std::move(values), false, cql3::query_options::specific_options::DEFAULT, cql_serialization_format::latest());
+    return values;
 }
 
-cql3::query_options trace_keyspace_helper::make_slow_query_time_idx_mutation_data(const one_session_records& session_records, const utils::UUID& start_time_id) {
+std::vector<cql3::raw_value> trace_keyspace_helper::make_slow_query_time_idx_mutation_data(const one_session_records& session_records, const utils::UUID& start_time_id) {
     auto started_at_duration = session_records.session_rec.started_at.time_since_epoch();
     // timestamp in minutes when the query began
     auto minutes_in_millis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration_cast<std::chrono::minutes>(started_at_duration)).count();
@@ -342,8 +356,7 @@ cql3::query_options trace_keyspace_helper::make_slow_query_time_idx_mutation_dat
         cql3::raw_value::make_value(int32_type->decompose(int32_t(session_records.session_rec.slow_query_record_ttl.count())))
     });
 
-    return cql3::query_options(cql3::default_cql_config,
-            db::consistency_level::ANY, tracing_db_timeout_config, std::nullopt, std::move(values), false, cql3::query_options::specific_options::DEFAULT, cql_serialization_format::latest());
+    return values;
 }
 
 std::vector<cql3::raw_value> trace_keyspace_helper::make_event_mutation_data(one_session_records& session_records, const event_record& record) {
@@ -364,79 +377,121 @@ std::vector<cql3::raw_value> trace_keyspace_helper::make_event_mutation_data(one
     return values;
 }
 
-future<> trace_keyspace_helper::apply_events_mutation(lw_shared_ptr<one_session_records> records, std::deque<event_record>& events_records) {
-    if (events_records.empty()) {
+future<> trace_keyspace_helper::apply_rows(std::vector<row_insert> rows) {
+    using mutation_set_type = std::unordered_set<mutation, mutation_hash_by_key, mutation_equals_by_key>;
+    auto& proxy = service::get_storage_proxy().local();
+    auto timeout = db::timeout_clock::now() + tracing_db_timeout_config.write_timeout;
+    auto timestamp = api::new_timestamp();
+    return do_with(std::move(rows), mutation_set_type(), [this, &proxy, timeout, timestamp] (std::vector<row_insert>& rows, mutation_set_type& mutations) {
+        return do_for_each(rows, [this, &proxy, timeout, timestamp, &mutations] (row_insert& row) {
+            return do_with(cql3::query_options(cql3::default_cql_config, db::consistency_level::ANY, tracing_db_timeout_config, std::nullopt, std::move(row.values), false, cql3::query_options::specific_options::DEFAULT, cql_serialization_format::latest()),
+                    [this, &proxy, timeout, timestamp, &mutations, &row] (cql3::query_options& options) {
+                return row.statement->get_mutations(proxy, options, timeout, false, timestamp, _dummy_query_state).then([&mutations] (std::vector<mutation> more) {
+                    for (auto&& m : more) {
+                        auto pos = mutations.find(m);
+                        if (pos == mutations.end()) {
+                            mutations.emplace(std::move(m));
+                        } else {
+                            const_cast<mutation&>(*pos).apply(std::move(m)); // Won't change key
+                        }
+                    }
+                });
+            });
+        }).then([&proxy, timeout, &mutations] {
+            std::vector<mutation> ms;
+            ms.reserve(mutations.size());
+            for (auto&& m : mutations) {
+                ms.push_back(std::move(m));
+            }
+            // Bypasses the batch size limits of CQL batches, which are meant for clients.
+            return proxy.mutate(std::move(ms), db::consistency_level::ANY, timeout, nullptr, empty_service_permit());
+        });
+    });
+}
+
+future<> trace_keyspace_helper::apply_events_mutations(std::vector<session_write>& sessions) {
+    size_t events_count = boost::accumulate(sessions | boost::adaptors::transformed([] (const session_write& w) { return w.events.size(); }), size_t(0));
+    if (!events_count) {
         return now();
     }
 
-    return _events.cache_table_info(_dummy_query_state).then([this, records, &events_records] {
-        tlogger.trace("{}: storing {} events records: parent_id {} span_id {}", records->session_id, events_records.size(), records->parent_id, records->my_span_id);
-
-        std::vector<cql3::statements::batch_statement::single_statement> modifications(events_records.size(), cql3::statements::batch_statement::single_statement(_events.insert_stmt(), false));
-        std::vector<std::vector<cql3::raw_value>> values;
-        auto& qp = cql3::get_local_query_processor();
+    return _events.cache_table_info(_dummy_query_state).then([this, &sessions, events_count] {
+        tlogger.trace("Storing {} events records of {} sessions", events_count, sessions.size());
 
-        values.reserve(events_records.size());
-        std::for_each(events_records.begin(), events_records.end(), [&values, all_records = records, this] (event_record& one_event_record) { values.emplace_back(make_event_mutation_data(*all_records, one_event_record)); });
-
-        return do_with(
-            cql3::query_options::make_batch_options(cql3::query_options(cql3::default_cql_config, db::consistency_level::ANY, tracing_db_timeout_config, std::nullopt, std::vector<cql3::raw_value>{}, false, cql3::query_options::specific_options::DEFAULT, cql_serialization_format::latest()), std::move(values)),
-            cql3::statements::batch_statement(cql3::statements::batch_statement::type::UNLOGGED, std::move(modifications), cql3::attributes::none(), qp.get_cql_stats()),
-            [this] (auto& batch_options, auto& batch) {
-                return batch.execute(service::get_storage_proxy().local(), _dummy_query_state, batch_options).then([] (shared_ptr<cql_transport::messages::result_message> res) { return now(); });
+        std::vector<row_insert> rows;
+        rows.reserve(events_count);
+        for (session_write& w : sessions) {
+            for (event_record& one_event_record : w.events) {
+                rows.push_back(row_insert{_events.insert_stmt(), make_event_mutation_data(*w.records, one_event_record)});
             }
-        );
+        }
+
+        return apply_rows(std::move(rows));
     });
 }
 
-future<> trace_keyspace_helper::flush_one_session_mutations(lw_shared_ptr<one_session_records> records) {
-    // grab events records available so far
-    return do_with(std::move(records->events_recs), [this, records] (std::deque<event_record>& events_records) {
-        records->events_recs.clear();
+future<> trace_keyspace_helper::apply_sessions_mutations(std::vector<session_write>& sessions) {
+    bool any_session_record = false;
+    bool any_slow_query = false;
+    for (const session_write& w : sessions) {
+        any_session_record |= w.session_record_is_ready;
+        any_slow_query |= w.session_record_is_ready && w.records->do_log_slow_query;
+    }
+    if (!any_session_record) {
+        return now();
+    }
 
-        // Check if a session's record is ready before handling events' records.
-        //
-        // New event's records and a session's record may become ready while a
-        // mutation with the current events' records is being written. We don't want
-        // to allow the situation when a session's record is written before the last
-        // event record from the same session.
-        bool session_record_is_ready = records->session_rec.ready();
+    std::vector<table_helper*> tables{&_sessions, &_sessions_time_idx};
+    if (any_slow_query) {
+        tables.push_back(&_slow_query_log);
+        tables.push_back(&_slow_query_log_time_idx);
+    }
 
-        // From this point on - all new data will have to be handled in the next write event
-        records->data_consumed();
+    return do_with(std::move(tables), [this, &sessions] (std::vector<table_helper*>& tables) {
+        return parallel_for_each(tables, [this] (table_helper* t) {
+            return t->cache_table_info(_dummy_query_state);
+        }).then([this, &sessions] {
+            std::vector<row_insert> rows;
+            for (session_write& w : sessions) {
+                if (!w.session_record_is_ready) {
+                    continue;
+                }
+                auto& records = *w.records;
+                tlogger.trace("{}: storing a session record", records.session_id);
+                rows.push_back(row_insert{_sessions.insert_stmt(), make_session_mutation_data(records)});
+                rows.push_back(row_insert{_sessions_time_idx.insert_stmt(), make_session_time_idx_mutation_data(records)});
+                if (records.do_log_slow_query) {
+                    auto start_time_id = utils::UUID_gen::get_time_UUID(table_helper::make_monotonic_UUID_tp(_slow_query_last_nanos, records.session_rec.started_at));
+                    rows.push_back(row_insert{_slow_query_log.insert_stmt(), make_slow_query_mutation_data(records, start_time_id)});
+                    rows.push_back(row_insert{_slow_query_log_time_idx.insert_stmt(), make_slow_query_time_idx_mutation_data(records, start_time_id)});
+                }
+            }
 
-        // We want to serialize the creation of events mutations in order to ensure
-        // that mutations for events that were created first are going to be
-        // created first too.
-        auto backend_state_ptr = static_cast<trace_keyspace_backend_sesssion_state*>(records->backend_state_ptr.get());
-        semaphore& write_sem = backend_state_ptr->write_sem;
-        return with_semaphore(write_sem, 1, [this, records, session_record_is_ready, &events_records] {
-            return apply_events_mutation(records, events_records).then([this, session_record_is_ready, records] {
-                if (session_record_is_ready) {
-
-                    // if session is finished - store a session and a session time index entries
-                    tlogger.trace("{}: going to store a session event", records->session_id);
-                    return _sessions.insert(_dummy_query_state, make_session_mutation_data, std::ref(*records)).then([this, records] {
-                        tlogger.trace("{}: going to store a {} entry", records->session_id, _sessions_time_idx.name());
-                        return _sessions_time_idx.insert(_dummy_query_state, make_session_time_idx_mutation_data, std::ref(*records));
-                    }).then([this, records] {
-                        if (!records->do_log_slow_query) {
-                            return now();
-                        }
+            return apply_rows(std::move(rows));
+        });
+    });
+}
 
-                        // if slow query log is requested - store a slow query log and a slow query log time index entries
-                        auto start_time_id = utils::UUID_gen::get_time_UUID(table_helper::make_monotonic_UUID_tp(_slow_query_last_nanos, records->session_rec.started_at));
-                        tlogger.trace("{}: going to store a slow query event", records->session_id);
-                        return _slow_query_log.insert(_dummy_query_state, make_slow_query_mutation_data, std::ref(*records), start_time_id).then([this, records, start_time_id] {
-                            tlogger.trace("{}: going to store a {} entry", records->session_id, _slow_query_log_time_idx.name());
-                            return _slow_query_log_time_idx.insert(_dummy_query_state, make_slow_query_time_idx_mutation_data, std::ref(*records), start_time_id);
-                        });
-                    });
-                } else {
-                    return now();
-                }
-            });
-        }).finally([records] {});
+future<> trace_keyspace_helper::flush_sessions_mutations(std::vector<session_write> sessions) {
+    // We want to serialize the writes of each session in order to ensure that
+    // mutations for events that were created first are going to be created
+    // first too. All the waits are queued right away, so bulks get the
+    // semaphores of their sessions in the order they were flushed.
+    std::vector<future<semaphore_units<>>> units;
+    units.reserve(sessions.size());
+    for (session_write& w : sessions) {
+        auto backend_state_ptr = static_cast<trace_keyspace_backend_sesssion_state*>(w.records->backend_state_ptr.get());
+        units.push_back(get_units(backend_state_ptr->write_sem, 1));
+    }
+
+    return do_with(std::move(sessions), [this, units = std::move(units)] (std::vector<session_write>& sessions) mutable {
+        return when_all_succeed(units.begin(), units.end()).then([this, &sessions] (std::vector<semaphore_units<>> units) {
+            // Sessions' records are written after all the events of this bulk,
+            // so a session's record never becomes visible before its events.
+            return apply_events_mutations(sessions).then([this, &sessions] {
+                return apply_sessions_mutations(sessions);
+            }).finally([units = std::move(units)] {});
+        });
     });
 }
 
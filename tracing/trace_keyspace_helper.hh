@@ -46,6 +46,7 @@
 #include <seastar/core/metrics_registration.hh>
 #include "tracing/tracing.hh"
 #include "table_helper.hh"
+#include "cql3/statements/modification_statement.hh"
 
 namespace tracing {
 
@@ -100,57 +101,81 @@ class trace_keyspace_helper final : public i_tracing_backend_helper {
 
 private:
     /**
-     * Write records of a single tracing session
-     *
-     * @param records records to write
+     * The records of a single tracing session taken for writing by one
+     * write_records_bulk() call.
      */
-    void write_one_session_records(lw_shared_ptr<one_session_records> records);
+    struct session_write {
+        lw_shared_ptr<one_session_records> records;
+        std::deque<event_record> events;
+        bool session_record_is_ready;
+    };
 
     /**
-     * Flush mutations of one particular tracing session. First "events"
-     * mutations and then, when they are complete, a "sessions" mutation.
-     *
-     * @note This function guaranties that it'll handle exactly the same number
-     * of records @param records had when the function was invoked.
+     * A row to insert with one of the tables' INSERT statements.
+     */
+    struct row_insert {
+        shared_ptr<cql3::statements::modification_statement> statement;
+        std::vector<cql3::raw_value> values;
+    };
+
+    /**
+     * Flush mutations of a bulk of tracing sessions. First "events" mutations
+     * of all sessions and then, when they are complete, the "sessions"
+     * mutations of the finished sessions.
      *
-     * @param records records describing the session's records
+     * @param sessions the records of each session to write
      *
      * @return A future that resolves when applying of above mutations is
      *         complete.
      */
-    future<> flush_one_session_mutations(lw_shared_ptr<one_session_records> records);
+    future<> flush_sessions_mutations(std::vector<session_write> sessions);
+
+    /**
+     * Apply events records mutations of all given sessions as a single batch.
+     *
+     * @param sessions the records of each session to write
+     *
+     * @return a future that resolves when the mutations have been written.
+     */
+    future<> apply_events_mutations(std::vector<session_write>& sessions);
 
     /**
-     * Apply events records mutations.
+     * Apply the session records of the finished sessions, their time index
+     * entries and, if requested, the slow query log entries as a single batch.
+     *
+     * @param sessions the records of each session to write
      *
-     * @param records all session records
-     * @param events_records events recods to apply
-     * @param start_point a time point when this tracing session data writing has started
+     * @return a future that resolves when the mutations have been written.
+     */
+    future<> apply_sessions_mutations(std::vector<session_write>& sessions);
+
+    /**
+     * Write the given rows with CL=ANY, with the mutations of each partition
+     * merged, and sent together in a single storage_proxy::mutate() call.
      *
-     * @return a future that resolves when the mutation has been written.
+     * @param rows rows to insert
      *
-     * @note A caller must ensure that @param events_records is alive till the
-     * returned future resolves.
+     * @return a future that resolves when the mutations have been written.
      */
-    future<> apply_events_mutation(lw_shared_ptr<one_session_records> records, std::deque<event_record>& events_records);
+    future<> apply_rows(std::vector<row_insert> rows);
 
     /**
      * Create a mutation data for a new session record
      *
      * @param all_records_handle handle to access an object with all records of this session
      *
-     * @return the relevant cql3::query_options object with the mutation data
+     * @return a vector with the mutation data
      */
-    static cql3::query_options make_session_mutation_data(const one_session_records& all_records_handle);
+    static std::vector<cql3::raw_value> make_session_mutation_data(const one_session_records& all_records_handle);
 
     /**
      * Create a mutation data for a new session_idx record
      *
      * @param all_records_handle handle to access an object with all records of this session
      *
-     * @return the relevant cql3::query_options object with the mutation data
+     * @return a vector with the mutation data
      */
-    static cql3::query_options make_session_time_idx_mutation_data(const one_session_records& all_records_handle);
+    static std::vector<cql3::raw_value> make_session_time_idx_mutation_data(const one_session_records& all_records_handle);
 
     /**
      * Create mutation for a new slow_query_log record
@@ -158,9 +183,9 @@ class trace_keyspace_helper final : public i_tracing_backend_helper {
      * @param all_records_handle handle to access an object with all records of this session
      * @param start_time_id time UUID generated from the query start time
      *
-     * @return the relevant mutation
+     * @return a vector with the mutation data
      */
-    static cql3::query_options make_slow_query_mutation_data(const one_session_records& all_records_handle, const utils::UUID& start_time_id);
+    static std::vector<cql3::raw_value> make_slow_query_mutation_data(const one_session_records& all_records_handle, const utils::UUID& start_time_id);
 
     /**
      * Create mutation for a new slow_query_log_time_idx record
@@ -168,9 +193,9 @@ class trace_keyspace_helper final : public i_tracing_backend_helper {
      * @param all_records_handle handle to access an object with all records of this session
      * @param start_time_id time UUID generated from the query start time
      *
-     * @return the relevant mutation
+     * @return a vector with the mutation data
      */
-    static cql3::query_options make_slow_query_time_idx_mutation_data(const one_session_records& all_records_handle, const utils::UUID& start_time_id);
+    static std::vector<cql3::raw_value> make_slow_query_time_idx_mutation_data(const one_session_records& all_records_handle, const utils::UUID& start_time_id);
 
     /**
      * Create a mutation data for a new trace point record
@@ -24,6 +24,7 @@
 #include <seastar/core/sstring.hh>
 #include <functional>
 #include <memory>
+#include <cstdint>
 #include <exception>
 #include "seastarx.hh"
 
@@ -49,17 +50,19 @@ class backend_registry {
     backend_registry();
     ~backend_registry();
     std::unique_ptr<i_tracing_backend_helper> create_backend(const sstring& name, tracing& t) const; // may throw no_such_tracing_backend
-    template <typename Backend>
-    void register_backend(sstring name);
+    // The backend is constructed with the tracing instance followed by copies of @args.
+    template <typename Backend, typename... Args>
+    void register_backend(sstring name, Args... args);
 };
 
-template <typename Backend>
-void backend_registry::register_backend(sstring name) {
-    return register_backend_creator(name, [] (tracing& t) {
-        return std::make_unique<Backend>(t);
+template <typename Backend, typename... Args>
+void backend_registry::register_backend(sstring name, Args... args) {
+    return register_backend_creator(name, [args...] (tracing& t) {
+        return std::make_unique<Backend>(t, args...);
     });
 }
 
 void register_tracing_keyspace_backend(backend_registry&);
+void register_tracing_file_backend(backend_registry&, sstring directory, uint64_t file_size);
 
 }
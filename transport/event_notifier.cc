@@ -21,6 +21,8 @@
 
 #include "transport/server.hh"
 #include <seastar/core/gate.hh>
+#include <algorithm>
+#include <map>
 #include "service/migration_listener.hh"
 #include "service/storage_service.hh"
 #include "transport/response.hh"
@@ -29,7 +31,14 @@ namespace cql_transport {
 
 static logging::logger elogger("event_notifier");
 
-cql_server::event_notifier::event_notifier(service::migration_notifier& mn) : _mnotifier(mn)
+// Migrations and schema pulls change many schema elements at once, possibly
+// several times. Their events are collected for this long, so that repeated
+// ones are sent once, and each batch is written to each connection together.
+static constexpr auto schema_change_coalescing_window = std::chrono::milliseconds(10);
+
+cql_server::event_notifier::event_notifier(service::migration_notifier& mn)
+    : _mnotifier(mn)
+    , _schema_change_timer([this] { send_schema_changes(); })
 {
     _mnotifier.register_listener(this);
     service::get_local_storage_service().register_subscriber(this);
@@ -43,10 +52,59 @@ cql_server::event_notifier::~event_notifier()
 
 future<> cql_server::event_notifier::stop() {
     return _mnotifier.unregister_listener(this).then([this]{
+        _schema_change_timer.cancel();
+        _pending_schema_changes.clear();
         _stopped = true;
     });
 }
 
+// Serializes the event once for each value of key_of(connection), which must
+// determine its body, and writes the shared buffer to all the listeners.
+template <typename KeyOf, typename MakeEvent>
+void cql_server::event_notifier::send_event(const std::set<cql_server::connection*>& listeners, KeyOf key_of, MakeEvent make_event)
+{
+    std::map<std::invoke_result_t<KeyOf, const cql_server::connection&>, lw_shared_ptr<cql_server::response>> events;
+    for (auto&& conn : listeners) {
+        if (conn->_pending_requests_gate.is_closed()) {
+            continue;
+        }
+        auto& event = events[key_of(*conn)];
+        if (!event) {
+            event = make_lw_shared<cql_server::response>(std::move(*make_event(*conn)));
+        }
+        conn->write_event(event);
+    }
+}
+
+void cql_server::event_notifier::on_schema_change(event::schema_change change)
+{
+    // An event repeating the latest one of the same element is redundant, and
+    // so is an update of an element whose creation is still pending: clients
+    // react to the creation after the update is applied.
+    auto it = std::find_if(_pending_schema_changes.rbegin(), _pending_schema_changes.rend(), [&change] (const event::schema_change& c) {
+        return c.target == change.target && c.keyspace == change.keyspace && c.arguments == change.arguments;
+    });
+    if (it != _pending_schema_changes.rend() && (it->change == change.change
+            || (change.change == event::schema_change::change_type::UPDATED && it->change == event::schema_change::change_type::CREATED))) {
+        return;
+    }
+    _pending_schema_changes.push_back(std::move(change));
+    if (!_schema_change_timer.armed()) {
+        _schema_change_timer.arm(schema_change_coalescing_window);
+    }
+}
+
+void cql_server::event_notifier::send_schema_changes()
+{
+    auto changes = std::exchange(_pending_schema_changes, {});
+    for (auto& change : changes) {
+        // The body depends on the protocol version of the connection.
+        send_event(_schema_change_listeners, [] (const cql_server::connection& conn) { return conn._version; }, [&change] (const cql_server::connection& conn) {
+            return conn.make_schema_change_event(change);
+        });
+    }
+}
+
 void cql_server::event_notifier::register_event(event::event_type et, cql_server::connection* conn)
 {
     switch (et) {
@@ -71,46 +129,31 @@ void cql_server::event_notifier::unregister_connection(cql_server::connection* c
 
 void cql_server::event_notifier::on_create_keyspace(const sstring& ks_name)
 {
-    for (auto&& conn : _schema_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_schema_change_event(event::schema_change{
-                event::schema_change::change_type::CREATED,
-                event::schema_change::target_type::KEYSPACE,
-                ks_name
-            }));
-        };
-    }
+    on_schema_change(event::schema_change{
+        event::schema_change::change_type::CREATED,
+        event::schema_change::target_type::KEYSPACE,
+        ks_name
+    });
 }
 
 void cql_server::event_notifier::on_create_column_family(const sstring& ks_name, const sstring& cf_name)
 {
-    for (auto&& conn : _schema_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_schema_change_event(event::schema_change{
-                event::schema_change::change_type::CREATED,
-                event::schema_change::target_type::TABLE,
-                ks_name,
-                cf_name
-            }));
-        };
-    }
+    on_schema_change(event::schema_change{
+        event::schema_change::change_type::CREATED,
+        event::schema_change::target_type::TABLE,
+        ks_name,
+        cf_name
+    });
 }
 
 void cql_server::event_notifier::on_create_user_type(const sstring& ks_name, const sstring& type_name)
 {
-    for (auto&& conn : _schema_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_schema_change_event(event::schema_change{
-                event::schema_change::change_type::CREATED,
-                event::schema_change::target_type::TYPE,
-                ks_name,
-                type_name
-            }));
-        };
-    }
+    on_schema_change(event::schema_change{
+        event::schema_change::change_type::CREATED,
+        event::schema_change::target_type::TYPE,
+        ks_name,
+        type_name
+    });
 }
 
 void cql_server::event_notifier::on_create_view(const sstring& ks_name, const sstring& view_name)
@@ -130,46 +173,31 @@ void cql_server::event_notifier::on_create_aggregate(const sstring& ks_name, con
 
 void cql_server::event_notifier::on_update_keyspace(const sstring& ks_name)
 {
-    for (auto&& conn : _schema_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_schema_change_event(event::schema_change{
-                event::schema_change::change_type::UPDATED,
-                event::schema_change::target_type::KEYSPACE,
-                ks_name
-            }));
-        };
-    }
+    on_schema_change(event::schema_change{
+        event::schema_change::change_type::UPDATED,
+        event::schema_change::target_type::KEYSPACE,
+        ks_name
+    });
 }
 
 void cql_server::event_notifier::on_update_column_family(const sstring& ks_name, const sstring& cf_name, bool columns_changed)
 {
-    for (auto&& conn : _schema_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_schema_change_event(event::schema_change{
-                event::schema_change::change_type::UPDATED,
-                event::schema_change::target_type::TABLE,
-                ks_name,
-                cf_name
-            }));
-        };
-    }
+    on_schema_change(event::schema_change{
+        event::schema_change::change_type::UPDATED,
+        event::schema_change::target_type::TABLE,
+        ks_name,
+        cf_name
+    });
 }
 
 void cql_server::event_notifier::on_update_user_type(const sstring& ks_name, const sstring& type_name)
 {
-    for (auto&& conn : _schema_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_schema_change_event(event::schema_change{
-                event::schema_change::change_type::UPDATED,
-                event::schema_change::target_type::TYPE,
-                ks_name,
-                type_name
-            }));
-        };
-    }
+    on_schema_change(event::schema_change{
+        event::schema_change::change_type::UPDATED,
+        event::schema_change::target_type::TYPE,
+        ks_name,
+        type_name
+    });
 }
 
 void cql_server::event_notifier::on_update_view(const sstring& ks_name, const sstring& view_name, bool columns_changed)
@@ -189,46 +217,31 @@ void cql_server::event_notifier::on_update_aggregate(const sstring& ks_name, con
 
 void cql_server::event_notifier::on_drop_keyspace(const sstring& ks_name)
 {
-    for (auto&& conn : _schema_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_schema_change_event(event::schema_change{
-                event::schema_change::change_type::DROPPED,
-                event::schema_change::target_type::KEYSPACE,
-                ks_name
-            }));
-        };
-    }
+    on_schema_change(event::schema_change{
+        event::schema_change::change_type::DROPPED,
+        event::schema_change::target_type::KEYSPACE,
+        ks_name
+    });
 }
 
 void cql_server::event_notifier::on_drop_column_family(const sstring& ks_name, const sstring& cf_name)
 {
-    for (auto&& conn : _schema_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_schema_change_event(event::schema_change{
-                event::schema_change::change_type::DROPPED,
-                event::schema_change::target_type::TABLE,
-                ks_name,
-                cf_name
-            }));
-        };
-    }
+    on_schema_change(event::schema_change{
+        event::schema_change::change_type::DROPPED,
+        event::schema_change::target_type::TABLE,
+        ks_name,
+        cf_name
+    });
 }
 
 void cql_server::event_notifier::on_drop_user_type(const sstring& ks_name, const sstring& type_name)
 {
-    for (auto&& conn : _schema_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_schema_change_event(event::schema_change{
-                event::schema_change::change_type::DROPPED,
-                event::schema_change::target_type::TYPE,
-                ks_name,
-                type_name
-            }));
-        };
-    }
+    on_schema_change(event::schema_change{
+        event::schema_change::change_type::DROPPED,
+        event::schema_change::target_type::TYPE,
+        ks_name,
+        type_name
+    });
 }
 
 void cql_server::event_notifier::on_drop_view(const sstring& ks_name, const sstring& view_name)
@@ -248,22 +261,17 @@ void cql_server::event_notifier::on_drop_aggregate(const sstring& ks_name, const
 
 void cql_server::event_notifier::on_join_cluster(const gms::inet_address& endpoint)
 {
-    for (auto&& conn : _topology_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_topology_change_event(event::topology_change::new_node(endpoint, conn->_server_addr.port())));
-        };
-    }
+    // The body depends on the port the connection was accepted on.
+    send_event(_topology_change_listeners, [] (const cql_server::connection& conn) { return conn._server_addr.port(); }, [&endpoint] (const cql_server::connection& conn) {
+        return conn.make_topology_change_event(event::topology_change::new_node(endpoint, conn._server_addr.port()));
+    });
 }
 
 void cql_server::event_notifier::on_leave_cluster(const gms::inet_address& endpoint)
 {
-    for (auto&& conn : _topology_change_listeners) {
-        using namespace cql_transport;
-        if (!conn->_pending_requests_gate.is_closed()) {
-            conn->write_response(conn->make_topology_change_event(event::topology_change::removed_node(endpoint, conn->_server_addr.port())));
-        };
-    }
+    send_event(_topology_change_listeners, [] (const cql_server::connection& conn) { return conn._server_addr.port(); }, [&endpoint] (const cql_server::connection& conn) {
+        return conn.make_topology_change_event(event::topology_change::removed_node(endpoint, conn._server_addr.port()));
+    });
 }
 
 void cql_server::event_notifier::on_up(const gms::inet_address& endpoint)
@@ -271,12 +279,9 @@ void cql_server::event_notifier::on_up(const gms::inet_address& endpoint)
     bool was_up = _last_status_change.count(endpoint) && _last_status_change.at(endpoint) == event::status_change::status_type::UP;
     _last_status_change[endpoint] = event::status_change::status_type::UP;
     if (!was_up) {
-        for (auto&& conn : _status_change_listeners) {
-            using namespace cql_transport;
-            if (!conn->_pending_requests_gate.is_closed()) {
-                conn->write_response(conn->make_status_change_event(event::status_change::node_up(endpoint, conn->_server_addr.port())));
-            };
-        }
+            send_event(_status_change_listeners, [] (const cql_server::connection& conn) { return conn._server_addr.port(); }, [&endpoint] (const cql_server::connection& conn) {
+            return conn.make_status_change_event(event::status_change::node_up(endpoint, conn._server_addr.port()));
+        });
     }
 }
 
@@ -285,12 +290,9 @@ void cql_server::event_notifier::on_down(const gms::inet_address& endpoint)
     bool was_down = _last_status_change.count(endpoint) && _last_status_change.at(endpoint) == event::status_change::status_type::DOWN;
     _last_status_change[endpoint] = event::status_change::status_type::DOWN;
     if (!was_down) {
-        for (auto&& conn : _status_change_listeners) {
-            using namespace cql_transport;
-            if (!conn->_pending_requests_gate.is_closed()) {
-                conn->write_response(conn->make_status_change_event(event::status_change::node_down(endpoint, conn->_server_addr.port())));
-            };
-        }
+            send_event(_status_change_listeners, [] (const cql_server::connection& conn) { return conn._server_addr.port(); }, [&endpoint] (const cql_server::connection& conn) {
+            return conn.make_status_change_event(event::status_change::node_down(endpoint, conn._server_addr.port()));
+        });
     }
 }
 
@@ -88,7 +88,9 @@ class response {
     void write_string_multimap(std::multimap<sstring, sstring> string_map);
     void write_value(bytes_opt value);
     void write_value(std::optional<query::result_bytes_view> value);
-    void write(const cql3::metadata& m, bool skip = false);
+    // When new_metadata_id is given, the METADATA_CHANGED flag is set and the
+    // identifier precedes the column specifications.
+    void write(const cql3::metadata& m, bool skip = false, const bytes* new_metadata_id = nullptr);
     void write(const cql3::prepared_metadata& m, uint8_t version);
 
     // Make a non-owning scattered_message of the response. Remains valid as long
@@ -105,6 +107,7 @@ class response {
     void compress(cql_compression compression);
     void compress_lz4();
     void compress_snappy();
+    void compress_zstd();
 
     template <typename CqlFrameHeaderType>
     sstring make_frame_one(uint8_t version, size_t length) {
@@ -51,6 +51,7 @@
 #include "service/client_state.hh"
 #include "exceptions/exceptions.hh"
 #include "connection_notifier.hh"
+#include "utils/latency_sampler.hh"
 
 #include "auth/authenticator.hh"
 
@@ -59,6 +60,7 @@
 
 #include <snappy-c.h>
 #include <lz4.h>
+#include "zstd/lib/zstd.h"
 
 #include "response.hh"
 #include "request.hh"
@@ -177,6 +179,12 @@ cql_server::cql_server(distributed<cql3::query_processor>& qp, auth::service& au
                         sm::description(
                             seastar::format("Holds an incrementing counter with the requests that ever blocked due to reaching the memory quota limit ({}B). "
                                             "The first derivative of this value shows how often we block due to memory exhaustion in the \"CQL transport\" component.", _max_request_size))),
+        sm::make_derive("response_writes", _response_writes,
+                        sm::description("Counts the writes of responses to client connections. Each write carries at least one response.")),
+
+        sm::make_derive("responses_coalesced", _responses_coalesced,
+                        sm::description("Counts responses which were written together with an earlier response of the same connection, saving a write and a flush.")),
+
        sm::make_gauge("requests_memory_available", [this] { return _memory_available.current(); },
                         sm::description(
                             seastar::format("Holds the amount of available memory for admitting new requests (max is {}B)."
@@ -209,9 +217,14 @@ future<> cql_server::stop() {
 }
 
 future<>
-cql_server::listen(socket_address addr, std::shared_ptr<seastar::tls::credentials_builder> creds, bool keepalive) {
+cql_server::listen(socket_address addr, std::shared_ptr<seastar::tls::credentials_builder> creds, bool is_shard_aware, bool keepalive) {
     listen_options lo;
     lo.reuse_address = true;
+    if (is_shard_aware) {
+        // Route each connection to the shard given by its source port, so
+        // that drivers can choose the shard they connect to.
+        lo.lba = server_socket::load_balancing_algorithm::port;
+    }
     server_socket ss;
     try {
         ss = creds
@@ -576,6 +589,7 @@ future<> cql_server::connection::process_request() {
         }
 
         auto& f = *maybe_frame;
+        utils::sampled_latency_timer latency_timer(utils::latency_stage::request);
         tracing_request_type tracing_requested = tracing_request_type::not_requested;
         if (f.flags & cql_frame_flags::tracing) {
             // If tracing is requested for a specific CQL command - flush
@@ -599,8 +613,8 @@ future<> cql_server::connection::process_request() {
             ++_server._requests_blocked_memory;
         }
 
-        return fut.then([this, length = f.length, flags = f.flags, op, stream, tracing_requested] (semaphore_units<> mem_permit) {
-          return this->read_and_decompress_frame(length, flags).then([this, op, stream, tracing_requested, mem_permit = make_service_permit(std::move(mem_permit))] (fragmented_temporary_buffer buf) mutable {
+        return fut.then([this, length = f.length, flags = f.flags, op, stream, tracing_requested, latency_timer = std::move(latency_timer)] (semaphore_units<> mem_permit) mutable {
+          return this->read_and_decompress_frame(length, flags).then([this, op, stream, tracing_requested, mem_permit = make_service_permit(std::move(mem_permit)), latency_timer = std::move(latency_timer)] (fragmented_temporary_buffer buf) mutable {
 
             ++_server._requests_served;
             ++_server._requests_serving;
@@ -610,10 +624,15 @@ future<> cql_server::connection::process_request() {
             // Replacing the immediately-invoked lambda below with just its body costs 5-10 usec extra per invocation.
             // Cause not understood.
             auto istream = buf.get_istream();
-            (void)_process_request_stage(this, istream, op, stream, seastar::ref(_client_state), tracing_requested, mem_permit)
-                    .then_wrapped([this, buf = std::move(buf), mem_permit, leave = std::move(leave)] (future<foreign_ptr<std::unique_ptr<cql_server::response>>> response_f) mutable {
+            auto sg = _server._config.service_levels
+                    ? _server._config.service_levels->scheduling_group_for(_client_state.user())
+                    : current_scheduling_group();
+            (void)with_scheduling_group(sg, [this, istream, op, stream, tracing_requested, mem_permit] () mutable {
+                return _process_request_stage(this, istream, op, stream, seastar::ref(_client_state), tracing_requested, mem_permit);
+            }).then_wrapped([this, buf = std::move(buf), mem_permit, leave = std::move(leave), latency_timer = std::move(latency_timer)] (future<foreign_ptr<std::unique_ptr<cql_server::response>>> response_f) mutable {
                 try {
                     write_response(std::move(response_f.get0()), std::move(mem_permit), _compression);
+                    latency_timer.stop();
                     _ready_to_respond = _ready_to_respond.finally([leave = std::move(leave)] {});
                 } catch (...) {
                     clogger.error("request processing failed: {}", std::current_exception());
@@ -651,6 +670,110 @@ void on_compression_buffer_use() {
 
 }
 
+namespace zstd_contexts {
+
+// Level 3 is zstd's default, trading some speed for a much better ratio than lz4.
+static constexpr int compression_level = 3;
+
+struct cctx_deleter {
+    void operator()(ZSTD_CCtx* ctx) const { ZSTD_freeCCtx(ctx); }
+};
+
+struct dctx_deleter {
+    void operator()(ZSTD_DCtx* ctx) const { ZSTD_freeDCtx(ctx); }
+};
+
+// Streaming contexts, shared by all connections of the shard. Frames are
+// always (de)compressed in one go, without preemption, so a context is never
+// used by two frames at once.
+static thread_local std::unique_ptr<ZSTD_CCtx, cctx_deleter> cctx;
+static thread_local std::unique_ptr<ZSTD_DCtx, dctx_deleter> dctx;
+
+static ZSTD_CCtx* get_cctx() {
+    if (!cctx) {
+        cctx.reset(ZSTD_createCCtx());
+        if (!cctx) {
+            throw std::bad_alloc();
+        }
+        ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, compression_level);
+    }
+    return cctx.get();
+}
+
+static ZSTD_DCtx* get_dctx() {
+    if (!dctx) {
+        dctx.reset(ZSTD_createDCtx());
+        if (!dctx) {
+            throw std::bad_alloc();
+        }
+    }
+    return dctx.get();
+}
+
+}
+
+// Decompresses a zstd frame fragment by fragment, straight into the fragments
+// of the result, so that neither side has to be linearized.
+static fragmented_temporary_buffer zstd_decompress_frame(const fragmented_temporary_buffer& buf, size_t max_size) {
+    auto dctx = zstd_contexts::get_dctx();
+    ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+    std::vector<temporary_buffer<char>> fragments;
+    size_t size = 0;
+    ZSTD_outBuffer out{nullptr, 0, 0};
+    size_t ret = 1;
+    auto next_fragment = [&] {
+        if (size >= max_size) {
+            throw std::runtime_error(format("CQL frame zstd uncompressed size exceeds {:d} bytes", max_size));
+        }
+        fragments.emplace_back(std::min(fragmented_temporary_buffer::default_fragment_size, max_size - size));
+        out = ZSTD_outBuffer{fragments.back().get_write(), fragments.back().size(), 0};
+    };
+    auto flush_fragment = [&] {
+        size += out.pos;
+        fragments.back().trim(out.pos);
+    };
+    for (bytes_view frag : fragmented_temporary_buffer::view(buf)) {
+        ZSTD_inBuffer in{frag.data(), frag.size(), 0};
+        while (in.pos < in.size) {
+            if (out.pos == out.size) {
+                if (!fragments.empty()) {
+                    flush_fragment();
+                }
+                next_fragment();
+            }
+            ret = ZSTD_decompressStream(dctx, &out, &in);
+            if (ZSTD_isError(ret)) {
+                throw std::runtime_error(format("CQL frame zstd uncompression failure: {}", ZSTD_getErrorName(ret)));
+            }
+        }
+    }
+    // Drain the data still buffered by the context.
+    while (ret != 0) {
+        if (out.pos == out.size) {
+            if (!fragments.empty()) {
+                flush_fragment();
+            }
+            next_fragment();
+        }
+        auto pos = out.pos;
+        ZSTD_inBuffer in{nullptr, 0, 0};
+        ret = ZSTD_decompressStream(dctx, &out, &in);
+        if (ZSTD_isError(ret)) {
+            throw std::runtime_error(format("CQL frame zstd uncompression failure: {}", ZSTD_getErrorName(ret)));
+        }
+        if (ret != 0 && out.pos == pos && out.pos < out.size) {
+            throw std::runtime_error("Truncated zstd CQL frame");
+        }
+    }
+    if (!fragments.empty()) {
+        flush_fragment();
+        if (fragments.back().empty()) {
+            fragments.pop_back();
+        }
+    }
+    return fragmented_temporary_buffer(std::move(fragments), size);
+}
+
 future<fragmented_temporary_buffer> cql_server::connection::read_and_decompress_frame(size_t length, uint8_t flags)
 {
     using namespace compression_buffers;
@@ -695,6 +818,10 @@ future<fragmented_temporary_buffer> cql_server::connection::read_and_decompress_
                 on_compression_buffer_use();
                 return uncomp;
             });
+        } else if (_compression == cql_compression::zstd) {
+            return _buffer_reader.read_exactly(_read_buf, length).then([this] (fragmented_temporary_buffer buf) {
+                return zstd_decompress_frame(buf, _server._max_request_size);
+            });
         } else {
             throw exceptions::protocol_exception(format("Unknown compression algorithm"));
         }
@@ -705,6 +832,9 @@ future<fragmented_temporary_buffer> cql_server::connection::read_and_decompress_
 future<std::unique_ptr<cql_server::response>> cql_server::connection::process_startup(uint16_t stream, request_reader in, service::client_state& client_state,
         tracing::trace_state_ptr trace_state) {
     auto options = in.read_string_map();
+    if (options.count("SCYLLA_USE_METADATA_ID")) {
+        client_state.set_use_metadata_id();
+    }
     auto compression_opt = options.find("COMPRESSION");
     if (compression_opt != options.end()) {
          auto compression = compression_opt->second;
@@ -713,6 +843,8 @@ future<std::unique_ptr<cql_server::response>> cql_server::connection::process_st
              _compression = cql_compression::lz4;
          } else if (compression == "snappy") {
              _compression = cql_compression::snappy;
+         } else if (compression == "zstd") {
+             _compression = cql_compression::zstd;
          } else {
              throw exceptions::protocol_exception(format("Unknown compression algorithm: {}", compression));
          }
@@ -753,7 +885,8 @@ cql_server::connection::init_cql_serialization_format() {
 
 std::unique_ptr<cql_server::response>
 make_result(int16_t stream, messages::result_message& msg, const tracing::trace_state_ptr& tr_state,
-        cql_protocol_version_type version, bool skip_metadata = false);
+        cql_protocol_version_type version, bool skip_metadata = false,
+        bool use_metadata_id = false, std::optional<bytes> request_metadata_id = std::nullopt);
 
 template<typename Process>
 future<foreign_ptr<std::unique_ptr<cql_server::response>>>
@@ -854,7 +987,7 @@ future<std::unique_ptr<cql_server::response>> cql_server::connection::process_pr
             tracing::trace(trace_state, "Done preparing on a local shard - preparing a result. ID is [{}]", seastar::value_of([&msg] {
                 return messages::result_message::prepared::cql::get_id(msg);
             }));
-            return make_result(stream, *msg, trace_state, _version);
+            return make_result(stream, *msg, trace_state, _version, false, client_state.use_metadata_id());
         });
     });
 }
@@ -880,6 +1013,13 @@ process_execute_internal(service::client_state& client_state, distributed<cql3::
         throw exceptions::prepared_query_not_found_exception(id);
     }
 
+    // With SCYLLA_USE_METADATA_ID, the client sends the identifier of the
+    // result metadata it has, so that it is only sent again when it changed.
+    std::optional<bytes> request_metadata_id;
+    if (client_state.use_metadata_id()) {
+        request_metadata_id = in.read_short_bytes();
+    }
+
     auto q_state = std::make_unique<cql_query_state>(client_state, trace_state, std::move(permit));
     auto& query_state = q_state->query_state;
     if (version == 1) {
@@ -923,12 +1063,13 @@ process_execute_internal(service::client_state& client_state, distributed<cql3::
 
     tracing::trace(trace_state, "Processing a statement");
     return qp.local().execute_prepared(std::move(prepared), std::move(cache_key), query_state, options, needs_authorization)
-            .then([trace_state = query_state.get_trace_state(), skip_metadata, q_state = std::move(q_state), stream, version] (auto msg) {
+            .then([trace_state = query_state.get_trace_state(), skip_metadata, request_metadata_id = std::move(request_metadata_id), q_state = std::move(q_state), stream, version] (auto msg) mutable {
         if (msg->move_to_shard()) {
             return std::variant<foreign_ptr<std::unique_ptr<cql_server::response>>, unsigned>(*msg->move_to_shard());
         } else {
             tracing::trace(q_state->query_state.get_trace_state(), "Done processing - preparing a result");
-            return std::variant<foreign_ptr<std::unique_ptr<cql_server::response>>, unsigned>(make_foreign(make_result(stream, *msg, q_state->query_state.get_trace_state(), version, skip_metadata)));
+            return std::variant<foreign_ptr<std::unique_ptr<cql_server::response>>, unsigned>(make_foreign(make_result(stream, *msg, q_state->query_state.get_trace_state(), version, skip_metadata,
+                    true, std::move(request_metadata_id))));
         }
     });
 }
@@ -1195,12 +1336,20 @@ std::unique_ptr<cql_server::response> cql_server::connection::make_supported(int
     opts.insert({"CQL_VERSION", cql3::query_processor::CQL_VERSION});
     opts.insert({"COMPRESSION", "lz4"});
     opts.insert({"COMPRESSION", "snappy"});
+    opts.insert({"COMPRESSION", "zstd"});
+    opts.insert({"SCYLLA_USE_METADATA_ID", ""});
     if (_server._config.allow_shard_aware_drivers) {
         opts.insert({"SCYLLA_SHARD", format("{:d}", this_shard_id())});
         opts.insert({"SCYLLA_NR_SHARDS", format("{:d}", smp::count)});
         opts.insert({"SCYLLA_SHARDING_ALGORITHM", dht::cpu_sharding_algorithm_name()});
         opts.insert({"SCYLLA_SHARDING_IGNORE_MSB", format("{:d}", _server._config.sharding_ignore_msb)});
         opts.insert({"SCYLLA_PARTITIONER", _server._config.partitioner_name});
+        if (_server._config.shard_aware_transport_port) {
+            opts.insert({"SCYLLA_SHARD_AWARE_PORT", format("{:d}", *_server._config.shard_aware_transport_port)});
+        }
+        if (_server._config.shard_aware_transport_port_ssl) {
+            opts.insert({"SCYLLA_SHARD_AWARE_PORT_SSL", format("{:d}", *_server._config.shard_aware_transport_port_ssl)});
+        }
     }
     auto response = std::make_unique<cql_server::response>(stream, cql_binary_opcode::SUPPORTED, tr_state);
     response->write_string_multimap(opts);
@@ -1212,11 +1361,15 @@ class cql_server::fmt_visitor : public messages::result_message::visitor_base {
     uint8_t _version;
     cql_server::response& _response;
     bool _skip_metadata;
+    bool _use_metadata_id;
+    std::optional<bytes> _request_metadata_id;
 public:
-    fmt_visitor(uint8_t version, cql_server::response& response, bool skip_metadata)
+    fmt_visitor(uint8_t version, cql_server::response& response, bool skip_metadata, bool use_metadata_id, std::optional<bytes> request_metadata_id)
         : _version{version}
         , _response{response}
         , _skip_metadata{skip_metadata}
+        , _use_metadata_id{use_metadata_id}
+        , _request_metadata_id{std::move(request_metadata_id)}
     { }
 
     virtual void visit(const messages::result_message::void_message&) override {
@@ -1231,6 +1384,9 @@ class cql_server::fmt_visitor : public messages::result_message::visitor_base {
     virtual void visit(const messages::result_message::prepared::cql& m) override {
         _response.write_int(0x0004);
         _response.write_short_bytes(m.get_id());
+        if (_use_metadata_id) {
+            _response.write_short_bytes(m.result_metadata()->metadata_id());
+        }
         _response.write(*m.metadata(), _version);
         if (_version > 1) {
             _response.write(*m.result_metadata());
@@ -1254,7 +1410,17 @@ class cql_server::fmt_visitor : public messages::result_message::visitor_base {
     virtual void visit(const messages::result_message::rows& m) override {
         _response.write_int(0x0002);
         auto& rs = m.rs();
-        _response.write(rs.get_metadata(), _skip_metadata);
+        if (_request_metadata_id) {
+            // The client's metadata decides, regardless of SKIP_METADATA.
+            auto& metadata_id = rs.get_metadata().metadata_id();
+            if (metadata_id == *_request_metadata_id) {
+                _response.write(rs.get_metadata(), true);
+            } else {
+                _response.write(rs.get_metadata(), false, &metadata_id);
+            }
+        } else {
+            _response.write(rs.get_metadata(), _skip_metadata);
+        }
         auto row_count_plhldr = _response.write_int_placeholder();
 
         class visitor {
@@ -1282,13 +1448,13 @@ class cql_server::fmt_visitor : public messages::result_message::visitor_base {
 
 std::unique_ptr<cql_server::response>
 make_result(int16_t stream, messages::result_message& msg, const tracing::trace_state_ptr& tr_state,
-        cql_protocol_version_type version, bool skip_metadata) {
+        cql_protocol_version_type version, bool skip_metadata, bool use_metadata_id, std::optional<bytes> request_metadata_id) {
     auto response = std::make_unique<cql_server::response>(stream, cql_binary_opcode::RESULT, tr_state);
     if (__builtin_expect(!msg.warnings().empty() && version > 3, false)) {
         response->set_frame_flag(cql_frame_flags::warning);
         response->write_string_list(msg.warnings());
     }
-    cql_server::fmt_visitor fmt{version, *response, skip_metadata};
+    cql_server::fmt_visitor fmt{version, *response, skip_metadata, use_metadata_id, std::move(request_metadata_id)};
     msg.accept(fmt);
     return response;
 }
@@ -1322,17 +1488,66 @@ cql_server::connection::make_schema_change_event(const event::schema_change& eve
     return response;
 }
 
+// Responses are not written one by one: they are queued, and all responses
+// queued by the time the previous write completes (or, on an idle connection,
+// by the end of the current task queue pass) go out in a single
+// scatter-gather write and flush.
 void cql_server::connection::write_response(foreign_ptr<std::unique_ptr<cql_server::response>>&& response, service_permit permit, cql_compression compression)
 {
-    _ready_to_respond = _ready_to_respond.then([this, compression, response = std::move(response), permit = std::move(permit)] () mutable {
-        auto message = response->make_message(_version, compression);
-        message.on_delete([response = std::move(response)] { });
-        return _write_buf.write(std::move(message)).then([this] {
-            return _write_buf.flush();
-        });
+    _pending_responses.push_back(pending_response{std::move(response), std::move(permit), compression});
+    schedule_response_write();
+}
+
+void cql_server::connection::write_event(lw_shared_ptr<cql_server::response> event)
+{
+    _pending_responses.push_back(pending_response{nullptr, empty_service_permit(), cql_compression::none, std::move(event)});
+    schedule_response_write();
+}
+
+void cql_server::connection::schedule_response_write()
+{
+    if (_response_write_scheduled) {
+        return;
+    }
+    _response_write_scheduled = true;
+    bool idle = _ready_to_respond.available();
+    _ready_to_respond = _ready_to_respond.then_wrapped([this, idle] (future<> f) {
+        if (f.failed()) {
+            // Writing failed, the connection is going away.
+            _response_write_scheduled = false;
+            _pending_responses.clear();
+            return f;
+        }
+        // Let the responses becoming ready in this poll join the batch.
+        return idle ? later() : make_ready_future<>();
+    }).then([this] {
+        return write_pending_responses();
     });
 }
 
+future<> cql_server::connection::write_pending_responses() {
+    _response_write_scheduled = false;
+    auto responses = std::exchange(_pending_responses, {});
+    net::packet p;
+    for (auto& r : responses) {
+        if (r.event) {
+            // Uncompressed, so making the message leaves the shared body alone.
+            auto message = r.event->make_message(_version, cql_compression::none);
+            message.on_delete([event = std::move(r.event)] { });
+            p.append(std::move(message).release());
+            continue;
+        }
+        auto message = r.response->make_message(_version, r.compression);
+        message.on_delete([response = std::move(r.response)] { });
+        p.append(std::move(message).release());
+    }
+    ++_server._response_writes;
+    _server._responses_coalesced += responses.size() - 1;
+    return _write_buf.write(std::move(p)).then([this] {
+        return _write_buf.flush();
+    }).finally([responses = std::move(responses)] { });
+}
+
 scattered_message<char> cql_server::response::make_message(uint8_t version, cql_compression compression) {
     if (compression != cql_compression::none) {
         compress(compression);
@@ -1355,6 +1570,9 @@ void cql_server::response::compress(cql_compression compression)
     case cql_compression::snappy:
         compress_snappy();
         break;
+    case cql_compression::zstd:
+        compress_zstd();
+        break;
     default:
         throw std::invalid_argument("Invalid CQL compression algorithm");
     }
@@ -1406,6 +1624,38 @@ void cql_server::response::compress_snappy()
     on_compression_buffer_use();
 }
 
+// Compresses the body fragment by fragment, directly into the chunks of the
+// new body, which stays fragmented.
+void cql_server::response::compress_zstd()
+{
+    auto cctx = zstd_contexts::get_cctx();
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+    // Record the uncompressed size in the frame header.
+    ZSTD_CCtx_setPledgedSrcSize(cctx, _body.size());
+    auto chunk_size = std::min<size_t>(ZSTD_compressBound(_body.size()), bytes_ostream::max_chunk_size());
+    bytes_ostream compressed;
+    auto compress_chunk = [&] (ZSTD_inBuffer& in, ZSTD_EndDirective mode) {
+        auto ptr = compressed.write_place_holder(chunk_size);
+        ZSTD_outBuffer out{ptr, chunk_size, 0};
+        auto ret = ZSTD_compressStream2(cctx, &out, &in, mode);
+        if (ZSTD_isError(ret)) {
+            throw std::runtime_error(format("CQL frame zstd compression failure: {}", ZSTD_getErrorName(ret)));
+        }
+        compressed.remove_suffix(chunk_size - out.pos);
+        return ret;
+    };
+    for (bytes_view frag : _body.fragments()) {
+        ZSTD_inBuffer in{frag.data(), frag.size(), 0};
+        while (in.pos < in.size) {
+            compress_chunk(in, ZSTD_e_continue);
+        }
+    }
+    ZSTD_inBuffer in{nullptr, 0, 0};
+    while (compress_chunk(in, ZSTD_e_end) != 0) {
+    }
+    _body = std::move(compressed);
+}
+
 void cql_server::response::serialize(const event::schema_change& event, uint8_t version)
 {
     if (version >= 3) {
@@ -1717,7 +1967,7 @@ thread_local const type_codec::type_id_to_type_type type_codec::type_id_to_type
     (type_id::TIME      , time_type)
     (type_id::INET      , inet_addr_type);
 
-void cql_server::response::write(const cql3::metadata& m, bool no_metadata) {
+void cql_server::response::write(const cql3::metadata& m, bool no_metadata, const bytes* new_metadata_id) {
     auto flags = m.flags();
     bool global_tables_spec = m.flags().contains<cql3::metadata::flag::GLOBAL_TABLES_SPEC>();
     bool has_more_pages = m.flags().contains<cql3::metadata::flag::HAS_MORE_PAGES>();
@@ -1725,6 +1975,9 @@ void cql_server::response::write(const cql3::metadata& m, bool no_metadata) {
     if (no_metadata) {
         flags.set<cql3::metadata::flag::NO_METADATA>();
     }
+    if (new_metadata_id) {
+        flags.set<cql3::metadata::flag::METADATA_CHANGED>();
+    }
 
     write_int(flags.mask());
     write_int(m.column_count());
@@ -1733,6 +1986,10 @@ void cql_server::response::write(const cql3::metadata& m, bool no_metadata) {
         write_value(m.paging_state()->serialize());
     }
 
+    if (new_metadata_id) {
+        write_short_bytes(*new_metadata_id);
+    }
+
     if (no_metadata) {
         return;
     }
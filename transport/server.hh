@@ -29,6 +29,7 @@
 #include "cql3/query_processor.hh"
 #include "cql3/values.hh"
 #include "auth/authenticator.hh"
+#include "auth/service_level.hh"
 #include <seastar/core/distributed.hh>
 #include "timeout_config.hh"
 #include <seastar/core/semaphore.hh>
@@ -58,6 +59,7 @@ enum class cql_compression {
     none,
     lz4,
     snappy,
+    zstd,
 };
 
 enum cql_frame_flags {
@@ -108,7 +110,13 @@ struct cql_server_config {
     sstring partitioner_name;
     unsigned sharding_ignore_msb;
     bool allow_shard_aware_drivers = true;
+    // Ports advertised to shard-aware drivers, on which the shard of a
+    // connection is its source port modulo the number of shards.
+    std::optional<uint16_t> shard_aware_transport_port;
+    std::optional<uint16_t> shard_aware_transport_port_ssl;
     smp_service_group bounce_request_smp_service_group = default_smp_service_group();
+    // Selects the scheduling group of a request from the role of its connection.
+    const auth::service_level_controller* service_levels = nullptr;
 };
 
 class cql_server : public seastar::peering_sharded_service<cql_server> {
@@ -130,12 +138,14 @@ class cql_server : public seastar::peering_sharded_service<cql_server> {
     uint64_t _requests_served = 0;
     uint64_t _requests_serving = 0;
     uint64_t _requests_blocked_memory = 0;
+    uint64_t _response_writes = 0;
+    uint64_t _responses_coalesced = 0;
     auth::service& _auth_service;
 public:
     cql_server(distributed<cql3::query_processor>& qp, auth::service&,
             service::migration_notifier& mn,
             cql_server_config config);
-    future<> listen(socket_address addr, std::shared_ptr<seastar::tls::credentials_builder> = {}, bool keepalive = false);
+    future<> listen(socket_address addr, std::shared_ptr<seastar::tls::credentials_builder> = {}, bool is_shard_aware = false, bool keepalive = false);
     future<> do_accepts(int which, bool keepalive, socket_address server_addr);
     future<> stop();
 public:
@@ -144,7 +154,8 @@ class cql_server : public seastar::peering_sharded_service<cql_server> {
     class fmt_visitor;
     friend class connection;
     friend std::unique_ptr<cql_server::response> make_result(int16_t stream, messages::result_message& msg,
-            const tracing::trace_state_ptr& tr_state, cql_protocol_version_type version, bool skip_metadata);
+            const tracing::trace_state_ptr& tr_state, cql_protocol_version_type version, bool skip_metadata,
+            bool use_metadata_id, std::optional<bytes> request_metadata_id);
     class connection : public boost::intrusive::list_base_hook<> {
         cql_server& _server;
         socket_address _server_addr;
@@ -154,6 +165,16 @@ class cql_server : public seastar::peering_sharded_service<cql_server> {
         fragmented_temporary_buffer::reader _buffer_reader;
         seastar::gate _pending_requests_gate;
         future<> _ready_to_respond = make_ready_future<>();
+        struct pending_response {
+            foreign_ptr<std::unique_ptr<cql_server::response>> response;
+            service_permit permit;
+            cql_compression compression;
+            // An event serialized once for many connections, see write_event(). Written instead of response.
+            lw_shared_ptr<cql_server::response> event = {};
+        };
+        // Responses waiting to be written together by the next write_pending_responses().
+        std::vector<pending_response> _pending_responses;
+        bool _response_write_scheduled = false;
         cql_protocol_version_type _version = 0;
         cql_compression _compression = cql_compression::none;
         cql_serialization_format _cql_serialization_format = cql_serialization_format::latest();
@@ -231,6 +252,10 @@ class cql_server : public seastar::peering_sharded_service<cql_server> {
                 service_permit permit, tracing::trace_state_ptr trace_state, Process process_fn);
 
         void write_response(foreign_ptr<std::unique_ptr<cql_server::response>>&& response, service_permit permit = empty_service_permit(), cql_compression compression = cql_compression::none);
+        // Writes an uncompressed event whose buffer may be shared with other connections of the shard.
+        void write_event(lw_shared_ptr<cql_server::response> event);
+        void schedule_response_write();
+        future<> write_pending_responses();
 
         void init_cql_serialization_format();
 
@@ -266,7 +291,15 @@ class cql_server::event_notifier : public service::migration_listener,
     std::set<cql_server::connection*> _schema_change_listeners;
     std::unordered_map<gms::inet_address, event::status_change::status_type> _last_status_change;
     service::migration_notifier& _mnotifier;
+    // Schema change events waiting to be sent together, see on_schema_change().
+    std::vector<event::schema_change> _pending_schema_changes;
+    timer<> _schema_change_timer;
     bool _stopped = false;
+private:
+    template <typename KeyOf, typename MakeEvent>
+    void send_event(const std::set<cql_server::connection*>& listeners, KeyOf key_of, MakeEvent make_event);
+    void on_schema_change(event::schema_change change);
+    void send_schema_changes();
 public:
     future<> stop();
     event_notifier(service::migration_notifier& mn);
@@ -780,6 +780,22 @@ struct is_byte_order_equal_visitor {
 
 bool abstract_type::is_byte_order_equal() const { return visit(*this, is_byte_order_equal_visitor{}); }
 
+// Must agree with compare_visitor, which compares values of these types
+// with compare_unsigned().
+bool abstract_type::is_byte_order_comparable() const {
+    switch (_kind) {
+    case kind::ascii:
+    case kind::utf8:
+    case kind::bytes:
+    case kind::date:
+    case kind::duration:
+    case kind::inet:
+        return true;
+    default:
+        return false;
+    }
+}
+
 static bool
 check_compatibility(const tuple_type_impl &t, const abstract_type& previous, bool (abstract_type::*predicate)(const abstract_type&) const);
 
@@ -2048,6 +2064,34 @@ int32_t abstract_type::compare(bytes_view v1, bytes_view v2) const {
     }
 }
 
+namespace {
+template <typename Type, bool Reversed>
+int32_t compare_as(const abstract_type& t, bytes_view v1, bytes_view v2) {
+    try {
+        auto& type = static_cast<const Type&>(t);
+        return Reversed ? compare_visitor{v2, v1}(type) : compare_visitor{v1, v2}(type);
+    } catch (const marshal_exception& e) {
+        on_types_internal_error(e.what());
+    }
+}
+
+template <bool Reversed>
+compiled_tri_comparator compile_tri_comparator_for(const abstract_type& t) {
+    return visit(t, [] (const auto& type) {
+        using type_t = std::decay_t<decltype(type)>;
+        if constexpr (std::is_same_v<type_t, reversed_type_impl>) {
+            return compile_tri_comparator_for<!Reversed>(*type.underlying_type());
+        } else {
+            return compiled_tri_comparator(type, &compare_as<type_t, Reversed>);
+        }
+    });
+}
+}
+
+compiled_tri_comparator abstract_type::compile_tri_comparator() const {
+    return compile_tri_comparator_for<false>(*this);
+}
+
 bool abstract_type::equal(bytes_view v1, bytes_view v2) const {
     return ::visit(*this, [&](const auto& t) {
         if (is_byte_order_equal_visitor{}(t)) {
@@ -449,6 +449,7 @@ inline bytes serialized(T v) {
 
 class serialized_compare;
 class serialized_tri_compare;
+class compiled_tri_comparator;
 class user_type_impl;
 
 // Unsafe to access across shards unless otherwise noted.
@@ -500,10 +501,19 @@ class abstract_type : public enable_shared_from_this<abstract_type> {
     // returns a callable that can be called with two byte_views, and calls this->less() on them.
     serialized_compare as_less_comparator() const ;
     serialized_tri_compare as_tri_comparator() const ;
+    // Returns a comparator equivalent to compare(), with the dispatch on the
+    // type resolved in advance. The type must outlive the comparator.
+    compiled_tri_comparator compile_tri_comparator() const;
     static data_type parse_type(const sstring& name);
     size_t hash(bytes_view v) const;
     bool equal(bytes_view v1, bytes_view v2) const;
     int32_t compare(bytes_view v1, bytes_view v2) const;
+    // Compares possibly fragmented values. Values of types for which
+    // is_byte_order_comparable() holds are compared fragment by fragment,
+    // other values are linearized first.
+    template<typename FragmentedBuffer1, typename FragmentedBuffer2,
+             typename = std::enable_if_t<is_fragment_range_v<FragmentedBuffer1> && is_fragment_range_v<FragmentedBuffer2>>>
+    int32_t compare(const FragmentedBuffer1& v1, const FragmentedBuffer2& v2) const;
     data_value deserialize(bytes_view v) const;
     data_value deserialize_value(bytes_view v) const {
         return deserialize(v);
@@ -557,6 +567,11 @@ class abstract_type : public enable_shared_from_this<abstract_type> {
      * When returns false, nothing can be inferred.
      */
     bool is_byte_order_equal() const;
+    /**
+     * When returns true then values are ordered the same way as their byte
+     * representations compared by compare_unsigned().
+     */
+    bool is_byte_order_comparable() const;
     sstring get_string(const bytes& b) const;
     sstring to_string(bytes_view bv) const {
         return to_string_impl(deserialize(bv));
@@ -845,6 +860,11 @@ class serialized_tri_compare {
     int operator()(const bytes_view& v1, const bytes_view& v2) const {
         return _type->compare(v1, v2);
     }
+    template<typename FragmentedBuffer1, typename FragmentedBuffer2,
+             typename = std::enable_if_t<is_fragment_range_v<FragmentedBuffer1> && is_fragment_range_v<FragmentedBuffer2>>>
+    int operator()(const FragmentedBuffer1& v1, const FragmentedBuffer2& v2) const {
+        return _type->compare(v1, v2);
+    }
 };
 
 inline
@@ -853,8 +873,45 @@ abstract_type::as_tri_comparator() const {
     return serialized_tri_compare(shared_from_this());
 }
 
+// A trichotomic comparator of serialized values of a single type.
+//
+// Unlike abstract_type::compare(), which dispatches on the kind of the type
+// (and, for reversed types, on the kind of the underlying type too) on every
+// call, the comparator is bound to the comparison function of the concrete
+// type when it is created by abstract_type::compile_tri_comparator(). Key
+// comparators which compare many values of the same types use it to avoid
+// repeating the dispatch.
+class compiled_tri_comparator {
+public:
+    using compare_fn = int32_t (*)(const abstract_type&, bytes_view, bytes_view);
+private:
+    const abstract_type* _type;
+    compare_fn _compare;
+public:
+    compiled_tri_comparator(const abstract_type& type, compare_fn compare) noexcept
+        : _type(&type), _compare(compare) { }
+    int32_t operator()(bytes_view v1, bytes_view v2) const {
+        return _compare(*_type, v1, v2);
+    }
+};
+
 using key_compare = serialized_compare;
 
+template<typename FragmentedBuffer1, typename FragmentedBuffer2, typename>
+int32_t abstract_type::compare(const FragmentedBuffer1& v1, const FragmentedBuffer2& v2) const {
+    if (is_byte_order_comparable()) {
+        return compare_unsigned(v1, v2);
+    }
+    if (is_reversed() && underlying_type()->is_byte_order_comparable()) {
+        return compare_unsigned(v2, v1);
+    }
+    return with_linearized(v1, [&] (bytes_view bv1) {
+        return with_linearized(v2, [&] (bytes_view bv2) {
+            return compare(bv1, bv2);
+        });
+    });
+}
+
 // Remember to update type_codec in transport/server.cc and cql3/cql3_type.cc
 extern thread_local const shared_ptr<const abstract_type> byte_type;
 extern thread_local const shared_ptr<const abstract_type> short_type;
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "utils/activity.hh"
+#include "log.hh"
+
+namespace utils {
+
+static logging::logger stall_logger("stall_attribution");
+
+thread_local activity current_activity;
+thread_local std::chrono::steady_clock::duration stall_attribution_threshold{0};
+
+// Time spent in completed scopes nested in the innermost running scope.
+static thread_local std::chrono::steady_clock::duration nested_scopes_time{0};
+
+static constexpr std::array<std::string_view, activity_type_count> activity_type_names = {
+    "none",
+    "read",
+    "write",
+    "compaction",
+    "flush",
+    "repair",
+    "view_build",
+};
+
+std::string_view to_string(activity_type type) {
+    return activity_type_names[size_t(type)];
+}
+
+void activity_scope::start() noexcept {
+    _measured = true;
+    _enclosing_nested = std::exchange(nested_scopes_time, std::chrono::steady_clock::duration::zero());
+    _start = std::chrono::steady_clock::now();
+}
+
+void activity_scope::stop() noexcept {
+    auto elapsed = std::chrono::steady_clock::now() - _start;
+    auto own = elapsed - nested_scopes_time;
+    nested_scopes_time = _enclosing_nested + elapsed;
+    auto a = current_activity;
+    if (own < stall_attribution_threshold || !a.stats) {
+        return;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(own).count();
+    a.stats->reports[size_t(a.type)]++;
+    a.stats->stall_time_ms[size_t(a.type)] += ms;
+    try {
+        stall_logger.warn("Ran for {} ms without yielding during {} of {}", ms, to_string(a.type), a.stats->name);
+    } catch (...) {
+        // Losing the report is better than failing the work it is about.
+    }
+}
+
+void enable_stall_attribution(std::chrono::milliseconds threshold) {
+    stall_attribution_threshold = threshold;
+}
+
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+#include <seastar/core/sstring.hh>
+
+#include "seastarx.hh"
+
+namespace utils {
+
+enum class activity_type : uint8_t {
+    none,
+    read,
+    write,
+    compaction,
+    flush,
+    repair,
+    view_build,
+};
+
+constexpr size_t activity_type_count = size_t(activity_type::view_build) + 1;
+
+std::string_view to_string(activity_type);
+
+// Stalls which happened while this shard was working on a given table, by
+// the type of the activity.
+struct stall_stats {
+    // Printed in stall reports, usually "keyspace.table".
+    sstring name;
+    // Activity scopes which ran without yielding for longer than the stall
+    // threshold.
+    std::array<uint64_t, activity_type_count> reports{};
+    // The time those scopes ran for, excluding nested scopes.
+    std::array<uint64_t, activity_type_count> stall_time_ms{};
+};
+
+struct activity {
+    activity_type type = activity_type::none;
+    stall_stats* stats = nullptr;
+};
+
+// What this shard is currently working on, for attributing reactor stalls.
+//
+// Set with activity_scope around synchronous processing, never across a
+// continuation boundary, so that work running while the tagged operation
+// waits for I/O is not attributed to it.
+extern thread_local activity current_activity;
+
+// Zero unless enable_stall_attribution() was called on this shard.
+extern thread_local std::chrono::steady_clock::duration stall_attribution_threshold;
+
+inline bool stall_attribution_enabled() noexcept {
+    return stall_attribution_threshold.count() != 0;
+}
+
+class activity_scope {
+    activity _previous;
+    bool _measured = false;
+    std::chrono::steady_clock::time_point _start;
+    // Time spent in completed scopes nested in the enclosing scope, when
+    // this one started.
+    std::chrono::steady_clock::duration _enclosing_nested;
+
+    void start() noexcept;
+    void stop() noexcept;
+public:
+    explicit activity_scope(activity a) noexcept : _previous(current_activity) {
+        current_activity = a;
+        if (stall_attribution_enabled()) {
+            start();
+        }
+    }
+    activity_scope(activity_type type, stall_stats& stats) noexcept : activity_scope(activity{type, &stats}) { }
+    activity_scope(const activity_scope&) = delete;
+    activity_scope& operator=(const activity_scope&) = delete;
+    ~activity_scope() {
+        if (_measured) {
+            stop();
+        }
+        current_activity = _previous;
+    }
+};
+
+// Makes the activity scopes of this shard measure how long they run. A scope
+// running for threshold or longer, not counting its nested scopes, is logged
+// along with its activity, e.g. "during compaction of ks.cf", and counted in
+// the stall_stats of the activity. threshold should be the stall detector
+// threshold (--blocked-reactor-notify-ms), so these reports complement, and
+// can be matched with, the stall detector's own. Must be called before any
+// table is created.
+void enable_stall_attribution(std::chrono::milliseconds threshold);
+
+}
@@ -41,6 +41,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+
 #include "exceptions/exceptions.hh"
 
 namespace utils {
@@ -153,6 +156,63 @@ namespace bloom_calculations {
         }
         return std::min(probs.size() - 1, size_t(v));
     }
+
+    /**
+     * Returns the number of bits per element a split-block Bloom filter (8
+     * bits set per key, all within one 256-bit block) needs in order to
+     * provide the given false positive rate.
+     *
+     * This uses the approximation from the Parquet split-block filter
+     * specification, which ignores the (small) load imbalance between
+     * blocks.
+     */
+    inline double split_block_bits_per_element(double max_false_pos_prob) {
+        if (max_false_pos_prob <= 0.0 || max_false_pos_prob >= 1.0) {
+            throw exceptions::unsupported_operation_exception(format("Unable to satisfy {:f} with a split-block filter", max_false_pos_prob));
+        }
+        return -8.0 / std::log(1.0 - std::pow(max_false_pos_prob, 1.0 / 8));
+    }
+
+    int constexpr xor_max_fingerprint_bits = 32;
+
+    /**
+     * Returns the fingerprint width an xor filter needs in order to provide
+     * the given false positive rate, which is 2^-bits.
+     */
+    inline unsigned xor_fingerprint_bits(double max_false_pos_prob) {
+        if (max_false_pos_prob <= 0.0 || max_false_pos_prob >= 1.0) {
+            throw exceptions::unsupported_operation_exception(format("Unable to satisfy {:f} with an xor filter", max_false_pos_prob));
+        }
+        auto bits = std::ceil(-std::log2(max_false_pos_prob));
+        return std::clamp<unsigned>(bits, 1, xor_max_fingerprint_bits);
+    }
+
+    /**
+     * Returns the number of slots of an xor filter holding num_elements keys.
+     * The 1.23 factor is the smallest one for which building the filter
+     * succeeds with high probability, see "Xor Filters: Faster and Smaller
+     * Than Bloom and Cuckoo Filters" by Graf and Lemire.
+     */
+    inline uint64_t xor_capacity(uint64_t num_elements) {
+        auto capacity = uint64_t(std::ceil(1.23 * num_elements)) + 32;
+        // Each of the three segments gets the same number of slots.
+        return (capacity + 2) / 3 * 3;
+    }
+
+    /**
+     * Returns the size in bytes of the Bloom filter which would provide the
+     * given false positive rate for num_elements keys, or 0 if no such filter
+     * can be built.
+     */
+    inline uint64_t bloom_filter_size(int64_t num_elements, double max_false_pos_prob) {
+        try {
+            auto spec = compute_bloom_spec(max_buckets_per_element(num_elements), max_false_pos_prob);
+            auto bits = num_elements * spec.buckets_per_element + EXCESS;
+            return (bits + 63) / 64 * 8;
+        } catch (const exceptions::unsupported_operation_exception&) {
+            return 0;
+        }
+    }
 }
 
 }
@@ -50,6 +50,10 @@
 #include <cstdlib>
 #include "bloom_filter.hh"
 
+#if defined(__x86_64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <immintrin.h>
+#endif
+
 namespace utils {
 namespace filter {
 
@@ -89,7 +93,97 @@ bool bloom_filter::is_present(const bytes_view& key) {
     return is_present(make_hashed_key(key));
 }
 
+// Multipliers used to derive the bit set in each lane of a block, taken from
+// the Parquet split-block Bloom filter specification.
+static constexpr std::array<uint32_t, split_block_bloom_filter::lanes_per_block> split_block_salt = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+static inline uint32_t split_block_key(hashed_key key) {
+    return static_cast<uint32_t>(key.hash()[1]);
+}
+
+static inline uint32_t split_block_lane_bit(uint32_t key, int lane) {
+    return (key * split_block_salt[lane]) >> 27;
+}
+
+split_block_bloom_filter::split_block_bloom_filter(bitmap&& bs)
+    : bloom_filter(lanes_per_block, std::move(bs), filter_format::split_block_format)
+    , _blocks(bits().size() / bits_per_block)
+{
+    if (!_blocks || bits().size() % bits_per_block) {
+        throw std::invalid_argument(format("Invalid split-block filter size: {:d} bits", bits().size()));
+    }
+}
+
+uint64_t split_block_bloom_filter::block_of(hashed_key key, uint64_t blocks) {
+    // Maps the hash uniformly onto [0, blocks) without a division.
+    return (static_cast<unsigned __int128>(key.hash()[0]) * blocks) >> 64;
+}
+
+void split_block_bloom_filter::add(const bytes_view& key) {
+    auto hk = make_hashed_key(key);
+    auto base = block_of(hk, _blocks) * bits_per_block;
+    auto k = split_block_key(hk);
+    for (int lane = 0; lane < lanes_per_block; ++lane) {
+        bits().set(base + lane * 32 + split_block_lane_bit(k, lane));
+    }
+}
+
+bool split_block_bloom_filter::is_present(const bytes_view& key) {
+    return is_present(make_hashed_key(key));
+}
+
+// Lane i of a block lives in bits [32 * (i % 2), 32 * (i % 2) + 32) of its
+// (i / 2)-th 64-bit word, so on little-endian hosts the block can be loaded
+// directly as eight consecutive 32-bit integers.
+bool split_block_bloom_filter::is_present(hashed_key key) {
+    auto& words = bits().get_storage();
+    // A block never crosses chunked_vector fragments, whose size is a
+    // multiple of the block size.
+    return block_contains(&words[block_of(key, _blocks) * words_per_block], key);
+}
+
+bool split_block_bloom_filter::block_contains(const uint64_t* words, hashed_key key) {
+    auto k = split_block_key(key);
+#if defined(__x86_64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && defined(__AVX2__)
+    auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+    auto salt = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(split_block_salt.data()));
+    auto shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(k), salt), 27);
+    auto mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+    return _mm256_testc_si256(block, mask);
+#elif defined(__x86_64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && defined(__SSE4_1__)
+    // SSE has no per-lane variable shift, so 1 << x is computed by building
+    // the float 2^x and truncating it. For x == 31 the conversion overflows
+    // into 0x80000000, which happens to be the expected bit pattern.
+    auto key_lanes = _mm_set1_epi32(k);
+    auto make_mask = [&] (const uint32_t* salt) {
+        auto shifts = _mm_srli_epi32(_mm_mullo_epi32(key_lanes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(salt))), 27);
+        auto exponent = _mm_add_epi32(_mm_slli_epi32(shifts, 23), _mm_set1_epi32(127 << 23));
+        return _mm_cvttps_epi32(_mm_castsi128_ps(exponent));
+    };
+    auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+    auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2));
+    return _mm_testc_si128(lo, make_mask(split_block_salt.data()))
+            && _mm_testc_si128(hi, make_mask(split_block_salt.data() + 4));
+#else
+    // Also used on powerpc and aarch64, where the loop below is simple
+    // enough for the compiler to vectorize.
+    uint64_t missing = 0;
+    for (int lane = 0; lane < lanes_per_block; ++lane) {
+        auto word = words[lane / 2];
+        auto bit = (lane % 2) * 32 + split_block_lane_bit(k, lane);
+        missing |= ~(word >> bit) & 1;
+    }
+    return !missing;
+#endif
+}
+
 filter_ptr create_filter(int hash, large_bitset&& bitset, filter_format format) {
+    if (format == filter_format::split_block_format) {
+        return std::make_unique<split_block_bloom_filter>(std::move(bitset));
+    }
     return std::make_unique<murmur3_bloom_filter>(hash, std::move(bitset), format);
 }
 
@@ -99,5 +193,12 @@ filter_ptr create_filter(int hash, int64_t num_elements, int buckets_per, filter
     large_bitset bitset(num_bits);
     return std::make_unique<murmur3_bloom_filter>(hash, std::move(bitset), format);
 }
+
+filter_ptr create_split_block_filter(int64_t num_elements, double max_false_pos_probability) {
+    auto bits_per_element = bloom_calculations::split_block_bits_per_element(max_false_pos_probability);
+    auto num_blocks = std::max<int64_t>(1, std::ceil(std::max<int64_t>(num_elements, 1) * bits_per_element / split_block_bloom_filter::bits_per_block));
+    large_bitset bitset(num_blocks * split_block_bloom_filter::bits_per_block);
+    return std::make_unique<split_block_bloom_filter>(std::move(bitset));
+}
 }
 }
@@ -93,6 +93,40 @@ struct murmur3_bloom_filter: public bloom_filter {
     {}
 };
 
+// A split-block (register-blocked) Bloom filter.
+//
+// The bitmap is split into 256-bit blocks made of eight 32-bit lanes. A key
+// selects a single block and sets one bit in each of its lanes, so a probe
+// touches one cache line instead of up to num_hashes() random ones, and can
+// be checked with a couple of SIMD instructions. The bitmap is kept in a
+// large_bitset, so it is serialized to Filter.db like the classic filter;
+// which of the two layouts an sstable uses is recorded in its scylla
+// metadata.
+class split_block_bloom_filter : public bloom_filter {
+public:
+    static constexpr int bits_per_block = 256;
+    static constexpr int lanes_per_block = 8;
+    static constexpr int words_per_block = bits_per_block / 64;
+private:
+    uint64_t _blocks;
+public:
+    explicit split_block_bloom_filter(bitmap&& bs);
+
+    // Returns the block a key maps to in a filter made of the given number
+    // of blocks. The mapping is monotonic in the first half of the key's
+    // hash, so consecutive blocks cover consecutive murmur3 token ranges.
+    static uint64_t block_of(hashed_key key, uint64_t blocks);
+    // Checks whether all bits of key are set in a block, given as its
+    // words_per_block words in host order.
+    static bool block_contains(const uint64_t* block, hashed_key key);
+
+    virtual void add(const bytes_view& key) override;
+
+    virtual bool is_present(const bytes_view& key) override;
+
+    virtual bool is_present(hashed_key key) override;
+};
+
 struct always_present_filter: public i_filter {
 
     virtual bool is_present(const bytes_view& key) override {
@@ -116,5 +150,6 @@ struct always_present_filter: public i_filter {
 
 filter_ptr create_filter(int hash, large_bitset&& bitset, filter_format format);
 filter_ptr create_filter(int hash, int64_t num_elements, int buckets_per, filter_format format);
+filter_ptr create_split_block_filter(int64_t num_elements, double max_false_pos_probability);
 }
 }
@@ -31,6 +31,7 @@
 #include <boost/range/algorithm/equal.hpp>
 #include <boost/algorithm/clamp.hpp>
 #include <boost/version.hpp>
+#include <array>
 #include <memory>
 #include <type_traits>
 #include <iterator>
@@ -44,6 +45,52 @@ struct chunked_vector_free_deleter {
     void operator()(void* x) const { ::free(x); }
 };
 
+// Keeps a few recently freed full-size chunks of this shard, so that large
+// vectors which are built and destroyed repeatedly (query results, repair
+// row buffers) don't allocate and free their chunks every time. The cache
+// is small, so the memory it holds back from the rest of the system is
+// bounded.
+class chunked_vector_chunk_cache {
+    static constexpr size_t max_chunks = 8;
+    struct entry {
+        size_t size;
+        void* ptr;
+    };
+    std::array<entry, max_chunks> _entries;
+    size_t _nr_entries = 0;
+public:
+    chunked_vector_chunk_cache() = default;
+    chunked_vector_chunk_cache(const chunked_vector_chunk_cache&) = delete;
+    ~chunked_vector_chunk_cache() {
+        for (size_t i = 0; i != _nr_entries; ++i) {
+            ::free(_entries[i].ptr);
+        }
+    }
+    // Returns a cached chunk of the given size in bytes, or nullptr.
+    void* get(size_t size) noexcept {
+        for (size_t i = 0; i != _nr_entries; ++i) {
+            if (_entries[i].size == size) {
+                auto ptr = _entries[i].ptr;
+                _entries[i] = _entries[--_nr_entries];
+                return ptr;
+            }
+        }
+        return nullptr;
+    }
+    // Takes ownership of the chunk if there is room for it.
+    bool put(size_t size, void* ptr) noexcept {
+        if (_nr_entries == max_chunks) {
+            return false;
+        }
+        _entries[_nr_entries++] = entry{size, ptr};
+        return true;
+    }
+    static chunked_vector_chunk_cache& local() noexcept {
+        static thread_local chunked_vector_chunk_cache cache;
+        return cache;
+    }
+};
+
 template <typename T, size_t max_contiguous_allocation = 128*1024>
 class chunked_vector {
     static_assert(std::is_nothrow_move_constructible<T>::value, "T must be nothrow move constructible");
@@ -64,6 +111,11 @@ class chunked_vector {
     void do_reserve_for_push_back();
     void make_room(size_t n);
     chunk_ptr new_chunk(size_t n);
+    // Frees the chunk, or caches it if it has the full capacity.
+    static void release_chunk(chunk_ptr& chunk, size_t capacity) noexcept;
+    size_t chunk_capacity(size_t chunk_index) const {
+        return std::min(max_chunk_capacity(), _capacity - chunk_index * max_chunk_capacity());
+    }
     T* addr(size_t i) const {
         return &_chunks[i / max_chunk_capacity()][i % max_chunk_capacity()];
     }
@@ -328,11 +380,19 @@ chunked_vector<T, max_contiguous_allocation>::~chunked_vector() {
             addr(i)->~T();
         }
     }
+    for (size_t i = 0; i != _chunks.size(); ++i) {
+        release_chunk(_chunks[i], chunk_capacity(i));
+    }
 }
 
 template <typename T, size_t max_contiguous_allocation>
 typename chunked_vector<T, max_contiguous_allocation>::chunk_ptr
 chunked_vector<T, max_contiguous_allocation>::new_chunk(size_t n) {
+    if (n == max_chunk_capacity()) {
+        if (auto p = chunked_vector_chunk_cache::local().get(n * sizeof(T))) {
+            return chunk_ptr(reinterpret_cast<T*>(p));
+        }
+    }
     auto p = malloc(n * sizeof(T));
     if (!p) {
         throw std::bad_alloc();
@@ -340,6 +400,16 @@ chunked_vector<T, max_contiguous_allocation>::new_chunk(size_t n) {
     return chunk_ptr(reinterpret_cast<T*>(p));
 }
 
+template <typename T, size_t max_contiguous_allocation>
+void
+chunked_vector<T, max_contiguous_allocation>::release_chunk(chunk_ptr& chunk, size_t capacity) noexcept {
+    if (capacity == max_chunk_capacity() && chunked_vector_chunk_cache::local().put(capacity * sizeof(T), chunk.get())) {
+        chunk.release();
+    } else {
+        chunk.reset();
+    }
+}
+
 template <typename T, size_t max_contiguous_allocation>
 void
 chunked_vector<T, max_contiguous_allocation>::migrate(T* begin, T* end, T* result) {
@@ -418,6 +488,7 @@ chunked_vector<T, max_contiguous_allocation>::shrink_to_fit() {
         return;
     }
     while (!_chunks.empty() && _size <= (_chunks.size() - 1) * max_chunk_capacity()) {
+        release_chunk(_chunks.back(), chunk_capacity(_chunks.size() - 1));
         _chunks.pop_back();
         _capacity = _chunks.size() * max_chunk_capacity();
     }
@@ -428,6 +499,7 @@ chunked_vector<T, max_contiguous_allocation>::shrink_to_fit() {
         // FIXME: realloc? maybe not worth the complication; only works for PODs
         auto new_last_chunk = new_chunk(new_last_chunk_capacity);
         migrate(addr((_chunks.size() - 1) * max_chunk_capacity()), addr(_size), new_last_chunk.get());
+        release_chunk(_chunks.back(), chunk_capacity(_chunks.size() - 1));
         _chunks.back() = std::move(new_last_chunk);
         _capacity = _size;
     }
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include <seastar/core/lowres_clock.hh>
+
+#include "seastarx.hh"
+#include "utils/estimated_histogram.hh"
+
+namespace utils {
+
+// A latency histogram with HDR-style buckets whose counts decay over time.
+//
+// Values, in microseconds, are bucketed by their power of two, and each power
+// of two is split into sub_buckets linear buckets, so a percentile is
+// accurate to within 1/sub_buckets of its value over the whole range (the
+// buckets of estimated_histogram grow by 20% each). Every decay_period the
+// counts are multiplied by decay_factor, lazily on the next access, so
+// percentiles follow a change of latency within a few periods regardless of
+// the rate of samples.
+class decaying_latency_histogram {
+public:
+    using clock = lowres_clock;
+    static constexpr unsigned sub_bucket_bits = 4;
+    static constexpr unsigned sub_buckets = 1 << sub_bucket_bits;
+    // Values of 2^(max_exponent + 1) microseconds (about 9 minutes) and more
+    // fall into the last bucket.
+    static constexpr unsigned max_exponent = 28;
+    static constexpr size_t bucket_count = sub_buckets * (max_exponent - sub_bucket_bits + 2);
+    static constexpr std::chrono::milliseconds decay_period{1000};
+    static constexpr float decay_factor = 0.8;
+private:
+    std::array<float, bucket_count> _buckets{};
+    float _count = 0;
+    clock::time_point _last_decay = clock::now();
+private:
+    static size_t bucket_of(uint64_t us) noexcept {
+        if (us < sub_buckets) {
+            return us;
+        }
+        unsigned exponent = 63 - __builtin_clzll(us);
+        if (exponent > max_exponent) {
+            return bucket_count - 1;
+        }
+        auto shift = exponent - sub_bucket_bits;
+        return sub_buckets * (shift + 1) + ((us >> shift) - sub_buckets);
+    }
+
+    // The greatest value falling into the bucket.
+    static uint64_t upper_bound_of(size_t bucket) noexcept {
+        if (bucket < sub_buckets) {
+            return bucket;
+        }
+        auto shift = bucket / sub_buckets - 1;
+        auto sub = bucket % sub_buckets;
+        return ((sub_buckets + sub + 1) << shift) - 1;
+    }
+
+    // The factor by which the counts have to be multiplied to decay them to
+    // the given point in time, and the number of whole periods it covers.
+    std::pair<float, unsigned> decay_to(clock::time_point now) const noexcept {
+        if (now <= _last_decay) {
+            return {1, 0};
+        }
+        unsigned periods = (now - _last_decay) / decay_period;
+        float factor = 1;
+        for (auto p = periods; p && factor; --p) {
+            factor *= decay_factor;
+        }
+        return {factor, periods};
+    }
+
+    void maybe_decay(clock::time_point now) noexcept {
+        auto [factor, periods] = decay_to(now);
+        if (!periods) {
+            return;
+        }
+        _last_decay += periods * decay_period;
+        for (auto& b : _buckets) {
+            b *= factor;
+        }
+        _count *= factor;
+    }
+public:
+    void add(std::chrono::microseconds latency, clock::time_point now = clock::now()) noexcept {
+        maybe_decay(now);
+        _buckets[bucket_of(std::max<int64_t>(latency.count(), 0))] += 1;
+        _count += 1;
+    }
+
+    // The weight of the samples, each decayed since it was added.
+    float count() const noexcept {
+        return _count;
+    }
+
+    // Returns the given percentile (0 to 1) of the latencies, or nothing if
+    // there are no samples.
+    std::optional<std::chrono::microseconds> percentile(double p, clock::time_point now = clock::now()) noexcept {
+        maybe_decay(now);
+        if (_count < 1) {
+            return std::nullopt;
+        }
+        auto target = p * _count;
+        float seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            seen += _buckets[i];
+            if (seen >= target) {
+                return std::chrono::microseconds(upper_bound_of(i));
+            }
+        }
+        return std::chrono::microseconds(upper_bound_of(bucket_count - 1));
+    }
+
+    // Merges the samples of another histogram, e.g. of another shard. The
+    // samples of the histogram which decayed less recently are decayed to
+    // the other's point in time first.
+    decaying_latency_histogram& operator+=(const decaying_latency_histogram& o) noexcept {
+        maybe_decay(o._last_decay);
+        auto factor = o.decay_to(_last_decay).first;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            _buckets[i] += o._buckets[i] * factor;
+        }
+        _count += o._count * factor;
+        return *this;
+    }
+
+    // Converts the decayed samples to an estimated_histogram, with the bucket
+    // offsets of this histogram, for the REST API. The last bucket of both
+    // holds the values exceeding the greatest offset.
+    estimated_histogram to_estimated_histogram(clock::time_point now = clock::now()) const {
+        auto factor = decay_to(now).first;
+        estimated_histogram res(0);
+        res.bucket_offsets.resize(bucket_count - 1);
+        res.buckets.resize(bucket_count);
+        for (size_t i = 0; i < bucket_count; ++i) {
+            if (i + 1 < bucket_count) {
+                res.bucket_offsets[i] = upper_bound_of(i);
+            }
+            auto n = int64_t(std::llround(_buckets[i] * factor));
+            res.buckets[i] = n;
+            res._count += n;
+            res._sample_sum += n * int64_t(upper_bound_of(i));
+        }
+        return res;
+    }
+};
+
+inline decaying_latency_histogram decaying_latency_histogram_merge(decaying_latency_histogram a, const decaying_latency_histogram& b) {
+    a += b;
+    return a;
+}
+
+}
@@ -93,6 +93,10 @@ future<> directories::init(db::config& cfg, bool hinted_handoff_enabled) {
         add_sharded(cfg.hints_directory(), paths);
     }
     add_sharded(cfg.view_hints_directory(), paths);
+    add_sharded(cfg.saved_caches_directory(), paths);
+    if (cfg.tracing_backend() == "trace_file_helper") {
+        add_sharded(cfg.tracing_file_directory(), paths);
+    }
 
     supervisor::notify("creating and verifying directories");
     return parallel_for_each(paths, [this, &cfg] (fs::path path) {
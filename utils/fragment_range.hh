@@ -164,3 +164,159 @@ decltype(auto) with_linearized(const FragmentedBuffer& buffer, Function&& fn)
     }
     return fn(bv);
 }
+
+/// Compares two fragmented buffers as sequences of unsigned bytes
+///
+/// Orders the buffers the same way as compare_unsigned(bytes_view, bytes_view)
+/// orders their linearized forms, but walks the fragments of both buffers in
+/// step and never copies them. The fragment boundaries of the two buffers
+/// don't need to be aligned.
+template<typename FragmentedBuffer1, typename FragmentedBuffer2,
+         typename = std::enable_if_t<is_fragment_range_v<FragmentedBuffer1> && is_fragment_range_v<FragmentedBuffer2>>>
+GCC6_CONCEPT(requires FragmentRange<FragmentedBuffer1> && FragmentRange<FragmentedBuffer2>)
+int compare_unsigned(const FragmentedBuffer1& b1, const FragmentedBuffer2& b2) {
+    auto it1 = b1.begin();
+    auto end1 = b1.end();
+    auto it2 = b2.begin();
+    auto end2 = b2.end();
+    bytes_view v1;
+    bytes_view v2;
+    while (true) {
+        while (v1.empty() && it1 != end1) {
+            v1 = *it1++;
+        }
+        while (v2.empty() && it2 != end2) {
+            v2 = *it2++;
+        }
+        if (v1.empty() || v2.empty()) {
+            return int(!v1.empty()) - int(!v2.empty());
+        }
+        auto n = std::min(v1.size(), v2.size());
+        if (auto r = memcmp(v1.data(), v2.data(), n)) {
+            return r;
+        }
+        v1.remove_prefix(n);
+        v2.remove_prefix(n);
+    }
+}
+
+/// A contiguous part of a fragment range
+///
+/// Refers to `size` bytes of a fragment range, starting `offset` bytes into
+/// the fragment pointed to by `first`. The underlying range must outlive the
+/// subrange.
+template<typename Iterator>
+class fragment_subrange {
+    Iterator _first;
+    size_t _offset;
+    size_t _size;
+public:
+    using fragment_type = bytes_view;
+
+    class iterator {
+        Iterator _it;
+        bytes_view _current;
+        size_t _left;
+    private:
+        void clip() {
+            _current = _current.substr(0, std::min(_current.size(), _left));
+        }
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = bytes_view;
+        using pointer = const bytes_view*;
+        using reference = const bytes_view&;
+        using difference_type = std::ptrdiff_t;
+
+        iterator(Iterator it, size_t offset, size_t size) : _it(it), _left(size) {
+            if (_left) {
+                _current = bytes_view(*_it).substr(offset);
+                clip();
+            }
+        }
+
+        const bytes_view& operator*() const { return _current; }
+        const bytes_view* operator->() const { return &_current; }
+
+        iterator& operator++() {
+            _left -= _current.size();
+            _current = bytes_view();
+            if (_left) {
+                _current = bytes_view(*++_it);
+                clip();
+            }
+            return *this;
+        }
+        iterator operator++(int) {
+            auto it = *this;
+            operator++();
+            return it;
+        }
+
+        bool operator==(const iterator& other) const {
+            return _left == other._left;
+        }
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+    };
+    using const_iterator = iterator;
+
+    fragment_subrange(Iterator first, size_t offset, size_t size)
+        : _first(first), _offset(offset), _size(size) { }
+
+    iterator begin() const { return iterator(_first, _offset, _size); }
+    iterator end() const { return iterator(_first, 0, 0); }
+
+    size_t size_bytes() const { return _size; }
+    bool empty() const { return !_size; }
+};
+
+/// Sequential reader of a fragment range
+///
+/// Consumes a fragment range from the front, handing out the consumed parts
+/// as fragment_subranges, so that values which straddle fragment boundaries
+/// can be parsed without linearizing the range.
+template<typename FragmentedBuffer>
+GCC6_CONCEPT(requires FragmentRange<FragmentedBuffer>)
+class fragment_range_cursor {
+    using fragment_iterator = typename FragmentedBuffer::const_iterator;
+    fragment_iterator _it;
+    // The unconsumed part of *_it.
+    bytes_view _current;
+    size_t _left;
+private:
+    void skip_empty() {
+        while (_current.empty() && _left) {
+            _current = *++_it;
+        }
+    }
+public:
+    using subrange = fragment_subrange<fragment_iterator>;
+
+    explicit fragment_range_cursor(const FragmentedBuffer& buffer)
+        : _it(buffer.begin()), _left(buffer.size_bytes()) {
+        if (_left) {
+            _current = *_it;
+            skip_empty();
+        }
+    }
+
+    size_t size_bytes() const { return _left; }
+    bool empty() const { return !_left; }
+
+    /// Returns the next n bytes and moves past them.
+    ///
+    /// \note n must not exceed size_bytes().
+    subrange read(size_t n) {
+        auto sub = subrange(_it, _current.data() - bytes_view(*_it).data(), n);
+        _left -= n;
+        while (n > _current.size()) {
+            n -= _current.size();
+            _current = *++_it;
+        }
+        _current.remove_prefix(n);
+        skip_empty();
+        return sub;
+    }
+};
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+
+#include "utils/frequency_sketch.hh"
+
+namespace utils {
+
+// Seeds for the hash of each row, so that keys colliding in one row are
+// unlikely to collide in the others.
+static constexpr std::array<uint64_t, frequency_sketch::depth> row_seeds = {
+    0x97cb3127e9d3d4a5ULL,
+    0xc2b2ae3d27d4eb4fULL,
+    0x165667b19e3779f9ULL,
+    0x9e3779b97f4a7c15ULL,
+};
+
+// The number of accesses per counter in a row after which the sketch ages.
+static constexpr uint64_t sample_factor = 10;
+
+static inline uint64_t mix(uint64_t h) {
+    // Finalizer of murmur3.
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Rows are a power of two counters long, and at least a word.
+static size_t round_up_width(size_t width) {
+    size_t w = 16;
+    while (w < width) {
+        w <<= 1;
+    }
+    return w;
+}
+
+frequency_sketch::frequency_sketch(size_t width)
+    : _counters(depth * round_up_width(width) / counters_per_word)
+    , _width_mask(round_up_width(width) - 1)
+    , _sample_size(sample_factor * round_up_width(width))
+{ }
+
+uint64_t frequency_sketch::index_of(uint64_t hash, unsigned row) const noexcept {
+    return row * width() + (mix(hash + row_seeds[row]) & _width_mask);
+}
+
+bool frequency_sketch::increment(uint64_t hash) noexcept {
+    bool added = false;
+    for (unsigned row = 0; row < depth; ++row) {
+        auto i = index_of(hash, row);
+        auto& word = _counters[i / counters_per_word];
+        auto shift = (i % counters_per_word) * 4;
+        if (((word >> shift) & 0xf) != max_frequency) {
+            word += uint64_t(1) << shift;
+            added = true;
+        }
+    }
+    // Saturated keys don't count, otherwise a few very hot keys would make
+    // the sketch age too often to tell apart the moderately popular ones.
+    if (added && ++_additions == _sample_size) {
+        age();
+        return true;
+    }
+    return false;
+}
+
+unsigned frequency_sketch::estimate(uint64_t hash) const noexcept {
+    unsigned result = max_frequency;
+    for (unsigned row = 0; row < depth; ++row) {
+        auto i = index_of(hash, row);
+        auto counter = (_counters[i / counters_per_word] >> ((i % counters_per_word) * 4)) & 0xf;
+        result = std::min(result, unsigned(counter));
+    }
+    return result;
+}
+
+void frequency_sketch::age() noexcept {
+    for (auto& word : _counters) {
+        word = (word >> 1) & 0x7777777777777777ULL;
+    }
+    _additions /= 2;
+}
+
+void frequency_sketch::clear() noexcept {
+    std::fill(_counters.begin(), _counters.end(), 0);
+    _additions = 0;
+}
+
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace utils {
+
+// Estimates how often keys were accessed recently, in a fixed amount of
+// memory. This is the frequency sketch of TinyLFU (Einziger, Friedman and
+// Manes, 2017), used to decide whether a new entry is worth admitting to a
+// cache at the expense of the entry it would evict.
+//
+// The sketch is a count-min sketch with depth rows of 4-bit saturating
+// counters, so an estimate never undercounts the accesses recorded since
+// the last aging, but may overcount due to collisions. Once sample_size()
+// accesses were recorded all counters are halved, which makes the estimates
+// follow changes in popularity.
+//
+// Keys are given as 64-bit hashes.
+class frequency_sketch {
+public:
+    static constexpr unsigned depth = 4;
+    static constexpr unsigned max_frequency = 15;
+private:
+    static constexpr unsigned counters_per_word = 16;
+    std::vector<uint64_t> _counters;
+    uint64_t _width_mask;
+    uint64_t _sample_size;
+    uint64_t _additions = 0;
+private:
+    uint64_t index_of(uint64_t hash, unsigned row) const noexcept;
+    void age() noexcept;
+public:
+    // Creates a sketch with at least width counters per row.
+    explicit frequency_sketch(size_t width);
+
+    size_t width() const noexcept { return _width_mask + 1; }
+    uint64_t sample_size() const noexcept { return _sample_size; }
+
+    // Records an access to the key.
+    // Returns true iff the counters were halved as a result.
+    bool increment(uint64_t hash) noexcept;
+
+    // Returns the estimated number of accesses to the key, at most max_frequency.
+    unsigned estimate(uint64_t hash) const noexcept;
+
+    void clear() noexcept;
+};
+
+}
@@ -51,6 +51,10 @@ using filter_ptr = std::unique_ptr<i_filter>;
 enum class filter_format {
     k_l_format,
     m_format,
+    // Split-block Bloom filter, see utils::filter::split_block_bloom_filter.
+    split_block_format,
+    // Static xor filter, see utils::filter::xor_filter.
+    xor_format,
 };
 
 class hashed_key {
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <seastar/core/print.hh>
+
+#include "utils/iblt.hh"
+
+namespace utils {
+
+// IBLTs with three hash functions decode reliably while the table has at
+// least 1.23 cells per key of the difference (the same threshold as the
+// peeling of xor filters); small tables need more slack.
+static constexpr double cells_per_key = 1.5;
+static constexpr size_t extra_cells = 60;
+
+static inline uint64_t mix(uint64_t h) {
+    // Finalizer of murmur3.
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+iblt::iblt(size_t cells, uint64_t seed)
+    : _seed(seed)
+    , _cells((std::max(cells, size_t(hash_count)) + hash_count - 1) / hash_count * hash_count)
+{ }
+
+iblt::iblt(uint64_t seed, std::vector<cell> cells)
+    : _seed(seed)
+    , _cells(std::move(cells))
+{
+    if (_cells.empty() || _cells.size() % hash_count) {
+        throw std::invalid_argument(seastar::format("Invalid IBLT size {:d}", _cells.size()));
+    }
+}
+
+size_t iblt::cells_for(size_t expected_difference) {
+    return size_t(expected_difference * cells_per_key) + extra_cells;
+}
+
+uint64_t iblt::check_hash(uint64_t key) const {
+    return mix(key ^ mix(_seed ^ 0x9e3779b97f4a7c15ULL));
+}
+
+size_t iblt::index(uint64_t key, unsigned i) const {
+    auto part = _cells.size() / hash_count;
+    auto h = mix(key + _seed + i * 0x9e3779b97f4a7c15ULL);
+    return i * part + ((h >> 32) * part >> 32);
+}
+
+void iblt::update(uint64_t key, int32_t count) {
+    auto h = check_hash(key);
+    for (unsigned i = 0; i < hash_count; ++i) {
+        auto& c = _cells[index(key, i)];
+        c.count += count;
+        c.key_sum ^= key;
+        c.hash_sum ^= h;
+    }
+}
+
+bool iblt::is_pure(const cell& c) const {
+    return (c.count == 1 || c.count == -1) && c.hash_sum == check_hash(c.key_sum);
+}
+
+void iblt::subtract(const iblt& other) {
+    if (_seed != other._seed || _cells.size() != other._cells.size()) {
+        throw std::invalid_argument(seastar::format("Can't subtract IBLTs of {:d} and {:d} cells, or with different seeds",
+                _cells.size(), other._cells.size()));
+    }
+    for (size_t i = 0; i < _cells.size(); ++i) {
+        _cells[i].count -= other._cells[i].count;
+        _cells[i].key_sum ^= other._cells[i].key_sum;
+        _cells[i].hash_sum ^= other._cells[i].hash_sum;
+    }
+}
+
+std::optional<iblt::difference> iblt::decode() const {
+    iblt t = *this;
+    difference diff;
+    std::vector<size_t> pure;
+    for (size_t i = 0; i < t._cells.size(); ++i) {
+        if (t.is_pure(t._cells[i])) {
+            pure.push_back(i);
+        }
+    }
+    while (!pure.empty()) {
+        auto i = pure.back();
+        pure.pop_back();
+        auto& c = t._cells[i];
+        if (!t.is_pure(c)) {
+            continue;
+        }
+        auto key = c.key_sum;
+        auto count = c.count;
+        (count > 0 ? diff.added : diff.removed).push_back(key);
+        t.update(key, -count);
+        for (unsigned j = 0; j < hash_count; ++j) {
+            auto idx = t.index(key, j);
+            if (t.is_pure(t._cells[idx])) {
+                pure.push_back(idx);
+            }
+        }
+    }
+    for (auto& c : t._cells) {
+        if (c.count || c.key_sum || c.hash_sum) {
+            return std::nullopt;
+        }
+    }
+    return diff;
+}
+
+}
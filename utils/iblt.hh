@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace utils {
+
+// An invertible Bloom lookup table (Goodrich and Mitzenmacher, 2011) of
+// 64-bit keys, used to reconcile two sets without transferring either.
+//
+// Every key is added to hash_count cells, one in each part of the table.
+// Subtracting the table of one set from the table, with the same size and
+// seed, of another leaves only the keys of their symmetric difference,
+// which decode() lists as long as the difference is small compared to the
+// table: cells_for(d) cells decode a difference of d keys with high
+// probability.
+class iblt {
+public:
+    static constexpr unsigned hash_count = 3;
+
+    struct cell {
+        int32_t count = 0;
+        uint64_t key_sum = 0;
+        uint64_t hash_sum = 0;
+    };
+
+    struct difference {
+        // Keys only in the subtracted-from table.
+        std::vector<uint64_t> added;
+        // Keys only in the subtracted table.
+        std::vector<uint64_t> removed;
+    };
+private:
+    uint64_t _seed;
+    std::vector<cell> _cells;
+private:
+    uint64_t check_hash(uint64_t key) const;
+    size_t index(uint64_t key, unsigned i) const;
+    void update(uint64_t key, int32_t count);
+    bool is_pure(const cell& c) const;
+public:
+    // The number of cells is rounded up to a multiple of hash_count.
+    iblt(size_t cells, uint64_t seed);
+    // Creates a table from its cells, as returned by cells().
+    iblt(uint64_t seed, std::vector<cell> cells);
+
+    static size_t cells_for(size_t expected_difference);
+
+    uint64_t seed() const { return _seed; }
+    const std::vector<cell>& cells() const { return _cells; }
+
+    void insert(uint64_t key) { update(key, 1); }
+    void erase(uint64_t key) { update(key, -1); }
+
+    // Throws std::invalid_argument if the tables have a different size or seed.
+    void subtract(const iblt& other);
+
+    // Lists the keys left in the table, or returns std::nullopt if they
+    // are too many to be decoded.
+    std::optional<difference> decode() const;
+};
+
+}
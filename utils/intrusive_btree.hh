@@ -0,0 +1,1084 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <boost/intrusive/parent_from_member.hpp>
+
+#include "utils/allocation_strategy.hh"
+
+// An intrusive B+tree with an external comparator.
+//
+// It is a drop-in replacement for intrusive_set_external_comparator with
+// better cache locality: the elements are kept in leaves holding up to
+// node_capacity pointers to them, so a lookup touches one node per level
+// instead of one element per level, and an element carries a single back
+// pointer to its leaf instead of three tree pointers. Inner nodes hold, as
+// separators, pointers to the first element of every child but the first.
+//
+// Iterators point at elements, not at slots in nodes, so they remain valid
+// across insertions and removals of other elements, like in a binary tree.
+//
+// Nodes are allocated with current_allocator() and can be moved by LSA. They
+// must be allocated and freed in the same allocation context as the
+// elements, which is the case when the elements are allocated with LSA too.
+//
+// Insertion may throw std::bad_alloc, in which case the tree is not
+// modified. Removal never fails and never allocates.
+//
+// keyed_tree additionally keeps, in every slot, an integer key provided by
+// the KeyOf function object, which is a coarse projection of the order:
+// less(a, b) implies KeyOf()(a) <= KeyOf()(b). Lookups compare the integers
+// first and look at the elements only on ties, so that descending the tree
+// doesn't miss the cache on every element visited.
+namespace intrusive_b {
+
+constexpr size_t node_capacity = 16;
+// Rows are usually inserted in key order, so a full node which is the last
+// one on its level is split unevenly, leaving the left node almost full.
+// Non-root nodes are required to hold only a quarter of the capacity so
+// that such nodes, and the ones left behind by evictions, don't need to be
+// merged eagerly.
+constexpr size_t node_min_keys = node_capacity / 4;
+constexpr size_t max_height = 32;
+
+template <typename Key> class basic_member_hook;
+template <typename Key> class node;
+template <typename Key> class leaf_node;
+template <typename Key> class inner_node;
+template <typename Key> class tree_base;
+
+// An element of a node and, unless Key is void, a copy of its key.
+template <typename Key>
+struct slot {
+    basic_member_hook<Key>* hook;
+    Key key;
+};
+
+template <>
+struct slot<void> {
+    basic_member_hook<void>* hook;
+};
+
+template <typename Key>
+class basic_member_hook {
+    friend class intrusive_b::node<Key>;
+    friend class leaf_node<Key>;
+    friend class tree_base<Key>;
+    leaf_node<Key>* _node = nullptr;
+public:
+    basic_member_hook() = default;
+    basic_member_hook(const basic_member_hook&) = delete;
+    basic_member_hook(basic_member_hook&& o) noexcept;
+    ~basic_member_hook() {
+        if (is_linked()) {
+            unlink();
+        }
+    }
+    bool is_linked() const noexcept { return _node; }
+    // Removes the element from its tree.
+    void unlink() noexcept;
+};
+
+using member_hook = basic_member_hook<void>;
+using keyed_member_hook = basic_member_hook<int64_t>;
+
+template <typename Key>
+class node {
+public:
+    using slot_type = slot<Key>;
+    static constexpr uint8_t leaf_flag = 1;
+    static constexpr uint8_t root_flag = 2;
+    union {
+        inner_node<Key>* _parent;
+        // Valid only for the root.
+        tree_base<Key>* _tree;
+    };
+    uint16_t _num_keys = 0;
+    uint8_t _flags;
+    std::array<slot_type, node_capacity> _keys;
+protected:
+    explicit node(uint8_t flags) noexcept : _parent(nullptr), _flags(flags) { }
+    node(node&& o) noexcept;
+    ~node() = default;
+public:
+    bool is_leaf() const noexcept { return _flags & leaf_flag; }
+    bool is_root() const noexcept { return _flags & root_flag; }
+    inner_node<Key>* parent() const noexcept { return is_root() ? nullptr : _parent; }
+    void set_parent(inner_node<Key>* p) noexcept {
+        _flags &= ~root_flag;
+        _parent = p;
+    }
+    void set_tree(tree_base<Key>* t) noexcept {
+        _flags |= root_flag;
+        _tree = t;
+    }
+};
+
+template <typename Key>
+class leaf_node final : public node<Key> {
+public:
+    leaf_node* _prev = nullptr;
+    leaf_node* _next = nullptr;
+
+    leaf_node() noexcept : node<Key>(node<Key>::leaf_flag) { }
+    leaf_node(leaf_node&& o) noexcept;
+    size_t index_of(const basic_member_hook<Key>* h) const noexcept {
+        size_t i = 0;
+        while (this->_keys[i].hook != h) {
+            ++i;
+        }
+        return i;
+    }
+};
+
+template <typename Key>
+class inner_node final : public node<Key> {
+public:
+    std::array<node<Key>*, node_capacity + 1> _children;
+
+    inner_node() noexcept : node<Key>(0) { }
+    inner_node(inner_node&& o) noexcept;
+    size_t index_of(const node<Key>* n) const noexcept {
+        size_t i = 0;
+        while (_children[i] != n) {
+            ++i;
+        }
+        return i;
+    }
+};
+
+// The structural part of the tree, independent of the element type.
+template <typename Key>
+class tree_base {
+    friend class intrusive_b::node<Key>;
+    friend class basic_member_hook<Key>;
+public:
+    using member_hook = basic_member_hook<Key>;
+    using node = intrusive_b::node<Key>;
+    using leaf_node = intrusive_b::leaf_node<Key>;
+    using inner_node = intrusive_b::inner_node<Key>;
+    using slot_type = slot<Key>;
+protected:
+    node* _root = nullptr;
+private:
+    // Nodes allocated up front so that an insertion can't fail half-way.
+    struct spare_nodes {
+        leaf_node* leaf = nullptr;
+        std::array<inner_node*, max_height> inner;
+        size_t inner_count = 0;
+
+        spare_nodes() = default;
+        spare_nodes(const spare_nodes&) = delete;
+        ~spare_nodes() {
+            if (leaf) {
+                current_allocator().destroy(leaf);
+            }
+            while (inner_count) {
+                current_allocator().destroy(inner[--inner_count]);
+            }
+        }
+        leaf_node* take_leaf() noexcept {
+            return std::exchange(leaf, nullptr);
+        }
+        inner_node* take_inner() noexcept {
+            assert(inner_count);
+            return inner[--inner_count];
+        }
+    };
+public:
+    static leaf_node* leftmost_leaf(node* n) noexcept {
+        while (!n->is_leaf()) {
+            n = static_cast<inner_node*>(n)->_children[0];
+        }
+        return static_cast<leaf_node*>(n);
+    }
+    static leaf_node* rightmost_leaf(node* n) noexcept {
+        while (!n->is_leaf()) {
+            auto in = static_cast<inner_node*>(n);
+            n = in->_children[in->_num_keys];
+        }
+        return static_cast<leaf_node*>(n);
+    }
+    static tree_base* tree_of(const node* n) noexcept {
+        while (!n->is_root()) {
+            n = n->_parent;
+        }
+        return n->_tree;
+    }
+    static tree_base* tree_of(const member_hook* h) noexcept {
+        return tree_of(h->_node);
+    }
+    static bool is_only_member(const member_hook* h) noexcept {
+        return h->_node->is_root() && h->_node->_num_keys == 1;
+    }
+    member_hook* first() const noexcept {
+        return _root ? leftmost_leaf(_root)->_keys[0].hook : nullptr;
+    }
+    member_hook* last() const noexcept {
+        if (!_root) {
+            return nullptr;
+        }
+        auto l = rightmost_leaf(_root);
+        return l->_keys[l->_num_keys - 1].hook;
+    }
+    static member_hook* next(const member_hook* h) noexcept {
+        auto l = h->_node;
+        auto i = l->index_of(h) + 1;
+        if (i < l->_num_keys) {
+            return l->_keys[i].hook;
+        }
+        return l->_next ? l->_next->_keys[0].hook : nullptr;
+    }
+    static member_hook* prev(const member_hook* h) noexcept {
+        auto l = h->_node;
+        auto i = l->index_of(h);
+        if (i) {
+            return l->_keys[i - 1].hook;
+        }
+        return l->_prev ? l->_prev->_keys[l->_prev->_num_keys - 1].hook : nullptr;
+    }
+protected:
+
+    // Updates the separator referring to the first element of the leaf,
+    // which is held by the closest ancestor of which the leaf isn't in the
+    // leftmost subtree.
+    static void fix_separator(leaf_node* l) noexcept {
+        node* n = l;
+        while (auto p = n->parent()) {
+            auto c = p->index_of(n);
+            if (c) {
+                p->_keys[c - 1] = l->_keys[0];
+                return;
+            }
+            n = p;
+        }
+    }
+
+    // Inserts the element of s right before pos, or at the end if pos is
+    // nullptr. If the element is linked into another tree, it is moved from
+    // there once all allocations have succeeded.
+    void insert_before(member_hook* pos, slot_type s) {
+        auto h = s.hook;
+        if (!_root) {
+            auto l = current_allocator().construct<leaf_node>();
+            if (h->is_linked()) {
+                h->unlink();
+            }
+            l->set_tree(this);
+            l->_keys[0] = s;
+            l->_num_keys = 1;
+            h->_node = l;
+            _root = l;
+            return;
+        }
+        leaf_node* leaf;
+        size_t idx;
+        if (pos) {
+            leaf = pos->_node;
+            idx = leaf->index_of(pos);
+        } else {
+            leaf = rightmost_leaf(_root);
+            idx = leaf->_num_keys;
+        }
+
+        spare_nodes spares;
+        node* n = leaf;
+        while (n && n->_num_keys == node_capacity) {
+            if (n == leaf) {
+                spares.leaf = current_allocator().construct<leaf_node>();
+            } else {
+                spares.inner[spares.inner_count++] = current_allocator().construct<inner_node>();
+            }
+            n = n->parent();
+            if (!n) {
+                // The root is split, a new one is needed.
+                spares.inner[spares.inner_count++] = current_allocator().construct<inner_node>();
+            }
+        }
+
+        if (h->is_linked()) {
+            h->unlink();
+        }
+        insert_into_leaf(leaf, idx, s, spares);
+    }
+
+    static void insert_into_leaf(leaf_node* leaf, size_t idx, slot_type s, spare_nodes& spares) noexcept {
+        auto h = s.hook;
+        auto n = leaf->_num_keys;
+        if (n < node_capacity) {
+            std::move_backward(leaf->_keys.begin() + idx, leaf->_keys.begin() + n, leaf->_keys.begin() + n + 1);
+            leaf->_keys[idx] = s;
+            leaf->_num_keys = n + 1;
+            h->_node = leaf;
+            if (idx == 0) {
+                fix_separator(leaf);
+            }
+            return;
+        }
+
+        std::array<slot_type, node_capacity + 1> keys;
+        std::copy(leaf->_keys.begin(), leaf->_keys.begin() + idx, keys.begin());
+        keys[idx] = s;
+        std::copy(leaf->_keys.begin() + idx, leaf->_keys.end(), keys.begin() + idx + 1);
+
+        bool append = idx == node_capacity && !leaf->_next;
+        size_t left_keys = append ? node_capacity + 1 - node_min_keys : (node_capacity + 1) / 2;
+
+        auto right = spares.take_leaf();
+        std::copy(keys.begin(), keys.begin() + left_keys, leaf->_keys.begin());
+        leaf->_num_keys = left_keys;
+        std::copy(keys.begin() + left_keys, keys.end(), right->_keys.begin());
+        right->_num_keys = node_capacity + 1 - left_keys;
+        h->_node = leaf;
+        for (size_t i = 0; i < right->_num_keys; ++i) {
+            right->_keys[i].hook->_node = right;
+        }
+
+        right->_prev = leaf;
+        right->_next = leaf->_next;
+        if (leaf->_next) {
+            leaf->_next->_prev = right;
+        }
+        leaf->_next = right;
+
+        insert_child(leaf, right, right->_keys[0], spares, append);
+        if (idx == 0) {
+            fix_separator(leaf);
+        }
+    }
+
+    // Inserts right, whose first element is sep, into the parent of left,
+    // right after left.
+    static void insert_child(node* left, node* right, slot_type sep, spare_nodes& spares, bool append) noexcept {
+        auto p = left->parent();
+        if (!p) {
+            p = spares.take_inner();
+            auto t = left->_tree;
+            p->set_tree(t);
+            t->_root = p;
+            p->_children[0] = left;
+            left->set_parent(p);
+        }
+        auto c = p->index_of(left);
+        auto n = p->_num_keys;
+        if (n < node_capacity) {
+            std::move_backward(p->_keys.begin() + c, p->_keys.begin() + n, p->_keys.begin() + n + 1);
+            std::move_backward(p->_children.begin() + c + 1, p->_children.begin() + n + 1, p->_children.begin() + n + 2);
+            p->_keys[c] = sep;
+            p->_children[c + 1] = right;
+            p->_num_keys = n + 1;
+            right->set_parent(p);
+            return;
+        }
+
+        std::array<slot_type, node_capacity + 1> keys;
+        std::array<node*, node_capacity + 2> children;
+        std::copy(p->_keys.begin(), p->_keys.begin() + c, keys.begin());
+        keys[c] = sep;
+        std::copy(p->_keys.begin() + c, p->_keys.end(), keys.begin() + c + 1);
+        std::copy(p->_children.begin(), p->_children.begin() + c + 1, children.begin());
+        children[c + 1] = right;
+        std::copy(p->_children.begin() + c + 1, p->_children.end(), children.begin() + c + 2);
+
+        // keys[m] moves up to the parent.
+        size_t m = append ? node_capacity - node_min_keys : node_capacity / 2;
+
+        auto q = spares.take_inner();
+        std::copy(keys.begin(), keys.begin() + m, p->_keys.begin());
+        std::copy(children.begin(), children.begin() + m + 1, p->_children.begin());
+        p->_num_keys = m;
+        std::copy(keys.begin() + m + 1, keys.end(), q->_keys.begin());
+        std::copy(children.begin() + m + 1, children.end(), q->_children.begin());
+        q->_num_keys = node_capacity - m;
+        right->set_parent(p);
+        for (size_t i = 0; i <= q->_num_keys; ++i) {
+            q->_children[i]->set_parent(q);
+        }
+
+        insert_child(p, q, keys[m], spares, append);
+    }
+
+    static void erase(member_hook* h) noexcept {
+        auto leaf = h->_node;
+        auto i = leaf->index_of(h);
+        std::move(leaf->_keys.begin() + i + 1, leaf->_keys.begin() + leaf->_num_keys, leaf->_keys.begin() + i);
+        --leaf->_num_keys;
+        h->_node = nullptr;
+
+        if (leaf->is_root()) {
+            if (!leaf->_num_keys) {
+                leaf->_tree->_root = nullptr;
+                current_allocator().destroy(leaf);
+            }
+            return;
+        }
+        if (i == 0) {
+            fix_separator(leaf);
+        }
+        if (leaf->_num_keys < node_min_keys) {
+            rebalance_leaf(leaf);
+        }
+    }
+
+    static void rebalance_leaf(leaf_node* l) noexcept {
+        auto p = l->_parent;
+        auto c = p->index_of(l);
+        if (c) {
+            auto s = static_cast<leaf_node*>(p->_children[c - 1]);
+            if (s->_num_keys > node_min_keys) {
+                std::move_backward(l->_keys.begin(), l->_keys.begin() + l->_num_keys, l->_keys.begin() + l->_num_keys + 1);
+                l->_keys[0] = s->_keys[--s->_num_keys];
+                l->_keys[0].hook->_node = l;
+                ++l->_num_keys;
+                p->_keys[c - 1] = l->_keys[0];
+                return;
+            }
+        }
+        if (c < p->_num_keys) {
+            auto r = static_cast<leaf_node*>(p->_children[c + 1]);
+            if (r->_num_keys > node_min_keys) {
+                l->_keys[l->_num_keys] = r->_keys[0];
+                l->_keys[l->_num_keys].hook->_node = l;
+                ++l->_num_keys;
+                std::move(r->_keys.begin() + 1, r->_keys.begin() + r->_num_keys, r->_keys.begin());
+                --r->_num_keys;
+                p->_keys[c] = r->_keys[0];
+                return;
+            }
+        }
+        if (c) {
+            merge_leaves(static_cast<leaf_node*>(p->_children[c - 1]), l, p, c - 1);
+        } else {
+            merge_leaves(l, static_cast<leaf_node*>(p->_children[c + 1]), p, c);
+        }
+    }
+
+    // Moves all elements of b, which is the child of p at k + 1, to a.
+    static void merge_leaves(leaf_node* a, leaf_node* b, inner_node* p, size_t k) noexcept {
+        for (size_t i = 0; i < b->_num_keys; ++i) {
+            a->_keys[a->_num_keys + i] = b->_keys[i];
+            b->_keys[i].hook->_node = a;
+        }
+        a->_num_keys += b->_num_keys;
+        a->_next = b->_next;
+        if (b->_next) {
+            b->_next->_prev = a;
+        }
+        remove_child(p, k);
+        current_allocator().destroy(b);
+        after_remove_child(p);
+    }
+
+    // Removes the separator at k and the child at k + 1.
+    static void remove_child(inner_node* p, size_t k) noexcept {
+        std::move(p->_keys.begin() + k + 1, p->_keys.begin() + p->_num_keys, p->_keys.begin() + k);
+        std::move(p->_children.begin() + k + 2, p->_children.begin() + p->_num_keys + 1, p->_children.begin() + k + 1);
+        --p->_num_keys;
+    }
+
+    static void after_remove_child(inner_node* n) noexcept {
+        if (n->is_root()) {
+            if (!n->_num_keys) {
+                auto t = n->_tree;
+                auto child = n->_children[0];
+                child->set_tree(t);
+                t->_root = child;
+                current_allocator().destroy(n);
+            }
+            return;
+        }
+        if (n->_num_keys < node_min_keys) {
+            rebalance_inner(n);
+        }
+    }
+
+    static void rebalance_inner(inner_node* n) noexcept {
+        auto p = n->_parent;
+        auto c = p->index_of(n);
+        if (c) {
+            auto s = static_cast<inner_node*>(p->_children[c - 1]);
+            if (s->_num_keys > node_min_keys) {
+                std::move_backward(n->_keys.begin(), n->_keys.begin() + n->_num_keys, n->_keys.begin() + n->_num_keys + 1);
+                std::move_backward(n->_children.begin(), n->_children.begin() + n->_num_keys + 1, n->_children.begin() + n->_num_keys + 2);
+                n->_keys[0] = p->_keys[c - 1];
+                n->_children[0] = s->_children[s->_num_keys];
+                n->_children[0]->set_parent(n);
+                ++n->_num_keys;
+                p->_keys[c - 1] = s->_keys[--s->_num_keys];
+                return;
+            }
+        }
+        if (c < p->_num_keys) {
+            auto r = static_cast<inner_node*>(p->_children[c + 1]);
+            if (r->_num_keys > node_min_keys) {
+                n->_keys[n->_num_keys] = p->_keys[c];
+                n->_children[n->_num_keys + 1] = r->_children[0];
+                r->_children[0]->set_parent(n);
+                ++n->_num_keys;
+                p->_keys[c] = r->_keys[0];
+                std::move(r->_keys.begin() + 1, r->_keys.begin() + r->_num_keys, r->_keys.begin());
+                std::move(r->_children.begin() + 1, r->_children.begin() + r->_num_keys + 1, r->_children.begin());
+                --r->_num_keys;
+                return;
+            }
+        }
+        if (c) {
+            merge_inner(static_cast<inner_node*>(p->_children[c - 1]), n, p, c - 1);
+        } else {
+            merge_inner(n, static_cast<inner_node*>(p->_children[c + 1]), p, c);
+        }
+    }
+
+    // Moves all children of b, which is the child of p at k + 1, to a.
+    static void merge_inner(inner_node* a, inner_node* b, inner_node* p, size_t k) noexcept {
+        a->_keys[a->_num_keys] = p->_keys[k];
+        for (size_t i = 0; i < b->_num_keys; ++i) {
+            a->_keys[a->_num_keys + 1 + i] = b->_keys[i];
+        }
+        for (size_t i = 0; i <= b->_num_keys; ++i) {
+            a->_children[a->_num_keys + 1 + i] = b->_children[i];
+            b->_children[i]->set_parent(a);
+        }
+        a->_num_keys += 1 + b->_num_keys;
+        remove_child(p, k);
+        current_allocator().destroy(b);
+        after_remove_child(p);
+    }
+
+    // Unlinks all elements of the subtree, passing them to the disposer,
+    // and frees its nodes.
+    template <typename Disposer>
+    static void dispose_subtree(node* n, Disposer& disposer) noexcept {
+        if (n->is_leaf()) {
+            auto l = static_cast<leaf_node*>(n);
+            for (size_t i = 0; i < l->_num_keys; ++i) {
+                auto h = l->_keys[i].hook;
+                h->_node = nullptr;
+                disposer(h);
+            }
+            current_allocator().destroy(l);
+        } else {
+            auto in = static_cast<inner_node*>(n);
+            for (size_t i = 0; i <= in->_num_keys; ++i) {
+                dispose_subtree(in->_children[i], disposer);
+            }
+            current_allocator().destroy(in);
+        }
+    }
+
+    // Copies the subtree, cloning the elements with cloner, which returns
+    // the hook of the clone. last_leaf is the most recently copied leaf.
+    // On failure, the partial copy is disposed of and nothing is linked to
+    // last_leaf.
+    template <typename Cloner, typename Disposer>
+    static node* clone_subtree(const node* src, leaf_node*& last_leaf, Cloner& cloner, Disposer& disposer) {
+        if (src->is_leaf()) {
+            auto s = static_cast<const leaf_node*>(src);
+            auto l = current_allocator().construct<leaf_node>();
+            try {
+                for (size_t i = 0; i < s->_num_keys; ++i) {
+                    auto h = cloner(s->_keys[i].hook);
+                    h->_node = l;
+                    l->_keys[i] = s->_keys[i];
+                    l->_keys[i].hook = h;
+                    l->_num_keys = i + 1;
+                }
+            } catch (...) {
+                dispose_subtree(l, disposer);
+                throw;
+            }
+            l->_prev = last_leaf;
+            if (last_leaf) {
+                last_leaf->_next = l;
+            }
+            last_leaf = l;
+            return l;
+        }
+        auto s = static_cast<const inner_node*>(src);
+        auto in = current_allocator().construct<inner_node>();
+        size_t cloned = 0;
+        auto prev_last_leaf = last_leaf;
+        try {
+            for (; cloned <= s->_num_keys; ++cloned) {
+                auto child = clone_subtree(s->_children[cloned], last_leaf, cloner, disposer);
+                child->set_parent(in);
+                in->_children[cloned] = child;
+                if (cloned) {
+                    in->_keys[cloned - 1] = leftmost_leaf(child)->_keys[0];
+                }
+            }
+        } catch (...) {
+            for (size_t i = 0; i < cloned; ++i) {
+                dispose_subtree(in->_children[i], disposer);
+            }
+            current_allocator().destroy(in);
+            last_leaf = prev_last_leaf;
+            if (last_leaf) {
+                last_leaf->_next = nullptr;
+            }
+            throw;
+        }
+        in->_num_keys = s->_num_keys;
+        return in;
+    }
+
+    static size_t subtree_memory_usage(const node* n) noexcept {
+        if (n->is_leaf()) {
+            return sizeof(leaf_node);
+        }
+        auto in = static_cast<const inner_node*>(n);
+        size_t size = sizeof(inner_node);
+        for (size_t i = 0; i <= in->_num_keys; ++i) {
+            size += subtree_memory_usage(in->_children[i]);
+        }
+        return size;
+    }
+public:
+    tree_base() = default;
+    tree_base(tree_base&& o) noexcept : _root(std::exchange(o._root, nullptr)) {
+        if (_root) {
+            _root->set_tree(this);
+        }
+    }
+    tree_base(const tree_base&) = delete;
+    ~tree_base() {
+        if (_root) {
+            auto unlink_only = [] (member_hook*) noexcept { };
+            dispose_subtree(_root, unlink_only);
+        }
+    }
+};
+
+template <typename Key>
+inline node<Key>::node(node&& o) noexcept
+    : _parent(o._parent)
+    , _num_keys(o._num_keys)
+    , _flags(o._flags)
+    , _keys(o._keys)
+{
+    if (is_root()) {
+        _tree = o._tree;
+        _tree->_root = this;
+    } else {
+        _parent->_children[_parent->index_of(&o)] = this;
+    }
+}
+
+template <typename Key>
+inline leaf_node<Key>::leaf_node(leaf_node&& o) noexcept
+    : node<Key>(std::move(o))
+    , _prev(o._prev)
+    , _next(o._next)
+{
+    if (_prev) {
+        _prev->_next = this;
+    }
+    if (_next) {
+        _next->_prev = this;
+    }
+    for (size_t i = 0; i < this->_num_keys; ++i) {
+        this->_keys[i].hook->_node = this;
+    }
+}
+
+template <typename Key>
+inline inner_node<Key>::inner_node(inner_node&& o) noexcept
+    : node<Key>(std::move(o))
+    , _children(o._children)
+{
+    for (size_t i = 0; i <= this->_num_keys; ++i) {
+        _children[i]->_parent = this;
+    }
+}
+
+template <typename Key>
+inline basic_member_hook<Key>::basic_member_hook(basic_member_hook&& o) noexcept
+    : _node(std::exchange(o._node, nullptr))
+{
+    if (_node) {
+        auto i = _node->index_of(&o);
+        _node->_keys[i].hook = this;
+        if (i == 0) {
+            tree_base<Key>::fix_separator(_node);
+        }
+    }
+}
+
+template <typename Key>
+inline void basic_member_hook<Key>::unlink() noexcept {
+    tree_base<Key>::erase(this);
+}
+
+template<typename Elem, typename Key, basic_member_hook<Key> Elem::* PtrToMember, typename KeyOf>
+class basic_tree final : public tree_base<Key> {
+    using base = tree_base<Key>;
+    using member_hook = typename base::member_hook;
+    using node = typename base::node;
+    using leaf_node = typename base::leaf_node;
+    using inner_node = typename base::inner_node;
+    using slot_type = typename base::slot_type;
+    using base::_root;
+    // The inline key of a lookup key, unused when Key is void.
+    using inline_key = std::conditional_t<std::is_void_v<Key>, std::nullptr_t, Key>;
+
+    static Elem* to_value(member_hook* h) noexcept {
+        return boost::intrusive::get_parent_from_member(h, PtrToMember);
+    }
+    static member_hook* to_hook(Elem& e) noexcept {
+        return &(e.*PtrToMember);
+    }
+    template <typename K>
+    static inline_key inline_key_of(const K& key) noexcept {
+        if constexpr (std::is_void_v<Key>) {
+            return nullptr;
+        } else {
+            return KeyOf()(key);
+        }
+    }
+    static slot_type make_slot(Elem& e) noexcept {
+        if constexpr (std::is_void_v<Key>) {
+            return slot_type{to_hook(e)};
+        } else {
+            return slot_type{to_hook(e), KeyOf()(e)};
+        }
+    }
+    // Returns true iff the element of s is less than key, whose inline key is k.
+    template <typename K, typename Less>
+    static bool slot_less(const slot_type& s, const K& key, inline_key k, Less& less) {
+        if constexpr (!std::is_void_v<Key>) {
+            if (s.key != k) {
+                return s.key < k;
+            }
+        }
+        return less(*to_value(s.hook), key);
+    }
+    // Returns true iff key, whose inline key is k, is less than the element of s.
+    template <typename K, typename Less>
+    static bool key_less(const K& key, inline_key k, const slot_type& s, Less& less) {
+        if constexpr (!std::is_void_v<Key>) {
+            if (k != s.key) {
+                return k < s.key;
+            }
+        }
+        return less(key, *to_value(s.hook));
+    }
+
+    template <bool Const>
+    class iterator_base {
+        friend class basic_tree;
+        template <bool> friend class iterator_base;
+        member_hook* _hook = nullptr;
+        // Set for end iterators, so that they can be decremented.
+        const base* _tree = nullptr;
+
+        iterator_base(member_hook* h, const base* t) noexcept : _hook(h), _tree(t) { }
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Elem;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const Elem*, Elem*>;
+        using reference = std::conditional_t<Const, const Elem&, Elem&>;
+
+        iterator_base() = default;
+        template <bool OtherConst, typename = std::enable_if_t<Const || !OtherConst>>
+        iterator_base(const iterator_base<OtherConst>& o) noexcept : _hook(o._hook), _tree(o._tree) { }
+
+        reference operator*() const noexcept { return *to_value(_hook); }
+        pointer operator->() const noexcept { return to_value(_hook); }
+
+        iterator_base& operator++() noexcept {
+            auto n = base::next(_hook);
+            if (!n) {
+                _tree = base::tree_of(_hook);
+            }
+            _hook = n;
+            return *this;
+        }
+        iterator_base operator++(int) noexcept {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+        iterator_base& operator--() noexcept {
+            _hook = _hook ? base::prev(_hook) : _tree->last();
+            return *this;
+        }
+        iterator_base operator--(int) noexcept {
+            auto it = *this;
+            --*this;
+            return it;
+        }
+        template <bool OtherConst>
+        bool operator==(const iterator_base<OtherConst>& o) const noexcept { return _hook == o._hook; }
+        template <bool OtherConst>
+        bool operator!=(const iterator_base<OtherConst>& o) const noexcept { return _hook != o._hook; }
+
+        iterator_base<false> unconst() const noexcept { return iterator_base<false>(_hook, _tree); }
+    };
+public:
+    using value_type = Elem;
+    using iterator = iterator_base<false>;
+    using const_iterator = iterator_base<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+private:
+    // Returns the slot of the first element not less than key, or nullptr.
+    template <typename K, typename Less>
+    const slot_type* lower_bound_slot(const K& key, Less& less) const {
+        if (!_root) {
+            return nullptr;
+        }
+        auto k = inline_key_of(key);
+        const node* n = _root;
+        while (!n->is_leaf()) {
+            auto in = static_cast<const inner_node*>(n);
+            size_t lo = 0, hi = in->_num_keys;
+            while (lo < hi) {
+                auto mid = (lo + hi) / 2;
+                if (slot_less(in->_keys[mid], key, k, less)) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            n = in->_children[lo];
+        }
+        auto l = static_cast<const leaf_node*>(n);
+        size_t lo = 0, hi = l->_num_keys;
+        while (lo < hi) {
+            auto mid = (lo + hi) / 2;
+            if (slot_less(l->_keys[mid], key, k, less)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo < l->_num_keys) {
+            return &l->_keys[lo];
+        }
+        return l->_next ? &l->_next->_keys[0] : nullptr;
+    }
+    // Returns the slot of the first element greater than key, or nullptr.
+    template <typename K, typename Less>
+    const slot_type* upper_bound_slot(const K& key, Less& less) const {
+        if (!_root) {
+            return nullptr;
+        }
+        auto k = inline_key_of(key);
+        const node* n = _root;
+        while (!n->is_leaf()) {
+            auto in = static_cast<const inner_node*>(n);
+            size_t lo = 0, hi = in->_num_keys;
+            while (lo < hi) {
+                auto mid = (lo + hi) / 2;
+                if (!key_less(key, k, in->_keys[mid], less)) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            n = in->_children[lo];
+        }
+        auto l = static_cast<const leaf_node*>(n);
+        size_t lo = 0, hi = l->_num_keys;
+        while (lo < hi) {
+            auto mid = (lo + hi) / 2;
+            if (!key_less(key, k, l->_keys[mid], less)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo < l->_num_keys) {
+            return &l->_keys[lo];
+        }
+        return l->_next ? &l->_next->_keys[0] : nullptr;
+    }
+    static member_hook* hook_of(const slot_type* s) noexcept {
+        return s ? s->hook : nullptr;
+    }
+public:
+    basic_tree() = default;
+    basic_tree(basic_tree&&) noexcept = default;
+
+    static iterator iterator_to(Elem& e) noexcept { return iterator(to_hook(e), nullptr); }
+    static const_iterator iterator_to(const Elem& e) noexcept { return const_iterator(to_hook(const_cast<Elem&>(e)), nullptr); }
+    // Returns true if and only if e is the only member of its tree.
+    static bool is_only_member(Elem& e) noexcept {
+        return base::is_only_member(to_hook(e));
+    }
+    // Returns container of e, assuming is_only_member(e).
+    static basic_tree& container_of_only_member(Elem& e) noexcept {
+        return static_cast<basic_tree&>(*base::tree_of(to_hook(e)));
+    }
+    // Returns container of e, in O(tree height).
+    static basic_tree& container_of(Elem& e) noexcept {
+        return static_cast<basic_tree&>(*base::tree_of(to_hook(e)));
+    }
+
+    iterator begin() noexcept { return iterator(this->first(), this); }
+    const_iterator begin() const noexcept { return const_iterator(this->first(), this); }
+    iterator end() noexcept { return iterator(nullptr, this); }
+    const_iterator end() const noexcept { return const_iterator(nullptr, this); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+    bool empty() const noexcept { return !_root; }
+
+    // WARNING: this method has O(N) time complexity, use with care
+    size_t calculate_size() const noexcept {
+        size_t size = 0;
+        for (auto l = _root ? base::leftmost_leaf(_root) : nullptr; l; l = l->_next) {
+            size += l->_num_keys;
+        }
+        return size;
+    }
+
+    // Memory occupied by the nodes, not including the elements.
+    size_t external_memory_usage() const noexcept {
+        return _root ? base::subtree_memory_usage(_root) : 0;
+    }
+
+    template <class Disposer>
+    void clear_and_dispose(Disposer disposer) noexcept {
+        if (_root) {
+            auto d = [&disposer] (member_hook* h) noexcept { disposer(to_value(h)); };
+            base::dispose_subtree(std::exchange(_root, nullptr), d);
+        }
+    }
+    iterator erase(const_iterator i) noexcept {
+        auto ret = std::next(i);
+        base::erase(i._hook);
+        return ret.unconst();
+    }
+    iterator erase(const_iterator b, const_iterator e) noexcept {
+        while (b != e) {
+            erase(b++);
+        }
+        return b.unconst();
+    }
+    template <class Disposer>
+    iterator erase_and_dispose(const_iterator i, Disposer disposer) noexcept {
+        auto e = to_value(i._hook);
+        auto ret = erase(i);
+        disposer(e);
+        return ret;
+    }
+    template <class Disposer>
+    iterator erase_and_dispose(const_iterator b, const_iterator e, Disposer disposer) noexcept {
+        while (b != e) {
+            erase_and_dispose(b++, disposer);
+        }
+        return b.unconst();
+    }
+    // Replaces the contents with clones of the elements of src. Keeps the
+    // shape of src, so the copy uses as much memory for nodes as src does.
+    template <class Cloner, class Disposer>
+    void clone_from(const basic_tree& src, Cloner cloner, Disposer disposer) {
+        clear_and_dispose(disposer);
+        if (!src.empty()) {
+            auto c = [&cloner] (member_hook* h) { return to_hook(*cloner(*to_value(h))); };
+            auto d = [&disposer] (member_hook* h) noexcept { disposer(to_value(h)); };
+            leaf_node* last_leaf = nullptr;
+            _root = base::clone_subtree(src._root, last_leaf, c, d);
+            _root->set_tree(this);
+        }
+    }
+    // Inserts value right before pos without comparing.
+    // Strong exception guarantee. value may be linked into another tree,
+    // in which case it is moved from there once the insertion can no
+    // longer fail.
+    iterator insert_before(const_iterator pos, Elem& value) {
+        auto s = make_slot(value);
+        base::insert_before(pos._hook, s);
+        return iterator(s.hook, this);
+    }
+    template <class KeyType, class KeyTypeKeyCompare>
+    iterator upper_bound(const KeyType& key, KeyTypeKeyCompare comp) {
+        return iterator(hook_of(upper_bound_slot(key, comp)), this);
+    }
+    template <class KeyType, class KeyTypeKeyCompare>
+    const_iterator upper_bound(const KeyType& key, KeyTypeKeyCompare comp) const {
+        return const_iterator(hook_of(upper_bound_slot(key, comp)), this);
+    }
+    template <class KeyType, class KeyTypeKeyCompare>
+    iterator lower_bound(const KeyType& key, KeyTypeKeyCompare comp) {
+        return iterator(hook_of(lower_bound_slot(key, comp)), this);
+    }
+    template <class KeyType, class KeyTypeKeyCompare>
+    const_iterator lower_bound(const KeyType& key, KeyTypeKeyCompare comp) const {
+        return const_iterator(hook_of(lower_bound_slot(key, comp)), this);
+    }
+    template <class KeyType, class KeyTypeKeyCompare>
+    iterator find(const KeyType& key, KeyTypeKeyCompare comp) {
+        return const_cast<const basic_tree&>(*this).find(key, comp).unconst();
+    }
+    template <class KeyType, class KeyTypeKeyCompare>
+    const_iterator find(const KeyType& key, KeyTypeKeyCompare comp) const {
+        auto s = lower_bound_slot(key, comp);
+        if (s && key_less(key, inline_key_of(key), *s, comp)) {
+            s = nullptr;
+        }
+        return const_iterator(hook_of(s), this);
+    }
+    template <class ElemCompare>
+    iterator insert(const_iterator hint, Elem& value, ElemCompare cmp) {
+        return insert_check(hint, value, std::move(cmp)).first;
+    }
+    // Inserts value unless an equal element is present, in which case
+    // returns that element. hint is the position before which value is
+    // expected to be inserted, it is verified and ignored if wrong.
+    template <class ElemCompare>
+    std::pair<iterator, bool> insert_check(const_iterator hint, Elem& value, ElemCompare cmp) {
+        auto prev_hook = hint._hook ? base::prev(hint._hook) : this->last();
+        if ((!hint._hook || cmp(value, *to_value(hint._hook))) && (!prev_hook || cmp(*to_value(prev_hook), value))) {
+            return {insert_before(hint, value), true};
+        }
+        auto s = lower_bound_slot(value, cmp);
+        if (s && !key_less(value, inline_key_of(value), *s, cmp)) {
+            return {iterator(s->hook, this), false};
+        }
+        return {insert_before(const_iterator(hook_of(s), this), value), true};
+    }
+};
+
+template <typename Elem, member_hook Elem::* PtrToMember>
+using tree = basic_tree<Elem, void, PtrToMember, void>;
+
+// KeyOf is a default-constructible function object returning the int64_t
+// key of elements and of all the key types used in lookups.
+template <typename Elem, keyed_member_hook Elem::* PtrToMember, typename KeyOf>
+using keyed_tree = basic_tree<Elem, int64_t, PtrToMember, KeyOf>;
+
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <seastar/core/metrics.hh>
+
+#include "utils/latency_sampler.hh"
+
+namespace utils {
+
+static constexpr std::array<std::string_view, latency_stage_count> latency_stage_names = {
+    "request",
+    "coordinator_read",
+    "coordinator_write",
+    "read_admission",
+    "sstable_first_read",
+    "replica_read",
+    "replica_write",
+};
+
+std::string_view to_string(latency_stage stage) {
+    return latency_stage_names[size_t(stage)];
+}
+
+std::optional<latency_stage> latency_stage_from_string(std::string_view name) {
+    for (size_t i = 0; i < latency_stage_count; ++i) {
+        if (latency_stage_names[i] == name) {
+            return latency_stage(i);
+        }
+    }
+    return std::nullopt;
+}
+
+void latency_sampler::set_sample_period(unsigned sample_period) {
+    _sample_period = sample_period;
+    _countdown.fill(0);
+}
+
+void latency_sampler::register_metrics() {
+    namespace sm = seastar::metrics;
+
+    auto stage_label = sm::label("stage");
+    std::vector<sm::metric_definition> defs;
+    for (size_t i = 0; i < latency_stage_count; ++i) {
+        auto stage = stage_label(sstring(latency_stage_names[i]));
+        defs.push_back(sm::make_histogram("latency", [this, i] { return _histograms[i].get_histogram(std::chrono::microseconds(10), 20); },
+                sm::description("Histogram of the sampled latencies of the stage, in microseconds"), {stage}));
+        defs.push_back(sm::make_derive("samples", [this, i] { return _samples[i]; },
+                sm::description("Number of latency samples taken of the stage"), {stage}));
+    }
+    _metrics.add_group("latency_breakdown", defs);
+}
+
+void latency_sampler::record(latency_stage stage, clock::duration latency) noexcept {
+    auto i = size_t(stage);
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    _histograms[i].add(us);
+    _recent[i][_samples[i] % recent_samples] = std::min<int64_t>(us, std::numeric_limits<uint32_t>::max());
+    ++_samples[i];
+}
+
+std::vector<uint32_t> latency_sampler::recent(latency_stage stage) const {
+    auto i = size_t(stage);
+    auto n = std::min<uint64_t>(_samples[i], recent_samples);
+    std::vector<uint32_t> res;
+    res.reserve(n);
+    for (auto s = _samples[i] - n; s != _samples[i]; ++s) {
+        res.push_back(_recent[i][s % recent_samples]);
+    }
+    return res;
+}
+
+latency_sampler& local_latency_sampler() {
+    static thread_local latency_sampler sampler;
+    return sampler;
+}
+
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <seastar/core/future.hh>
+#include <seastar/core/metrics_registration.hh>
+
+#include "utils/estimated_histogram.hh"
+#include "seastarx.hh"
+
+namespace utils {
+
+// The fixed points of a request's life at which the latency sampler
+// measures. Each stage is measured on the shard where it runs.
+enum class latency_stage : uint8_t {
+    request,            // transport: frame received -> response queued
+    coordinator_read,   // storage_proxy: read dispatched -> result
+    coordinator_write,  // storage_proxy: write dispatched -> acknowledged
+    read_admission,     // reader_concurrency_semaphore: permit requested -> admitted
+    sstable_first_read, // sstable reader: first fill, index lookup and first data read
+    replica_read,       // database: local read executed
+    replica_write,      // database: local write applied
+};
+
+constexpr size_t latency_stage_count = 7;
+
+std::string_view to_string(latency_stage);
+std::optional<latency_stage> latency_stage_from_string(std::string_view);
+
+// Records, per shard, the latency of one in every sample_period executions
+// of each stage into a histogram and a ring buffer of recent samples.
+//
+// Unlike tracing, nothing is written anywhere, and the unsampled executions
+// only pay for decrementing a counter, so the sampler can be left on to get a
+// continuous breakdown of where request time goes. The stages are sampled
+// independently and samples of different stages are not correlated.
+class latency_sampler {
+public:
+    using clock = std::chrono::steady_clock;
+    static constexpr size_t recent_samples = 256;
+private:
+    unsigned _sample_period = 0;
+    std::array<unsigned, latency_stage_count> _countdown{};
+    std::array<estimated_histogram, latency_stage_count> _histograms;
+    std::array<std::array<uint32_t, recent_samples>, latency_stage_count> _recent{};
+    std::array<uint64_t, latency_stage_count> _samples{};
+    seastar::metrics::metric_groups _metrics;
+public:
+    // Samples one in every sample_period executions of each stage.
+    // Zero disables sampling.
+    void set_sample_period(unsigned sample_period);
+
+    void register_metrics();
+
+    bool should_sample(latency_stage stage) noexcept {
+        if (!_sample_period) {
+            return false;
+        }
+        auto& countdown = _countdown[size_t(stage)];
+        if (countdown) {
+            --countdown;
+            return false;
+        }
+        countdown = _sample_period - 1;
+        return true;
+    }
+
+    void record(latency_stage stage, clock::duration latency) noexcept;
+
+    const estimated_histogram& histogram(latency_stage stage) const {
+        return _histograms[size_t(stage)];
+    }
+
+    // The most recent samples of the stage in microseconds, oldest first.
+    std::vector<uint32_t> recent(latency_stage stage) const;
+};
+
+latency_sampler& local_latency_sampler();
+
+// Measures the time until stop() if this execution of the stage is sampled.
+class sampled_latency_timer {
+    latency_stage _stage;
+    std::optional<latency_sampler::clock::time_point> _start;
+public:
+    explicit sampled_latency_timer(latency_stage stage) noexcept : _stage(stage) {
+        if (local_latency_sampler().should_sample(stage)) {
+            _start = latency_sampler::clock::now();
+        }
+    }
+    sampled_latency_timer(sampled_latency_timer&& o) noexcept : _stage(o._stage), _start(std::exchange(o._start, std::nullopt)) { }
+    sampled_latency_timer& operator=(sampled_latency_timer&& o) noexcept {
+        _stage = o._stage;
+        _start = std::exchange(o._start, std::nullopt);
+        return *this;
+    }
+
+    void stop() noexcept {
+        if (_start) {
+            local_latency_sampler().record(_stage, latency_sampler::clock::now() - *_start);
+            _start.reset();
+        }
+    }
+};
+
+// Invokes func, recording the time until its future resolves if this
+// execution of the stage is sampled.
+template <typename Func>
+futurize_t<std::invoke_result_t<Func>> sample_latency(latency_stage stage, Func&& func) {
+    if (!local_latency_sampler().should_sample(stage)) {
+        return futurize_invoke(std::forward<Func>(func));
+    }
+    auto start = latency_sampler::clock::now();
+    return futurize_invoke(std::forward<Func>(func)).finally([stage, start] {
+        local_latency_sampler().record(stage, latency_sampler::clock::now() - start);
+    });
+}
+
+}
@@ -33,6 +33,10 @@
 #include <seastar/core/reactor.hh>
 #include <seastar/core/timer.hh>
 #include <seastar/core/gate.hh>
+#include <seastar/core/semaphore.hh>
+#include <seastar/core/smp.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/shared_ptr.hh>
 
 #include "exceptions/exceptions.hh"
 #include "utils/loading_shared_values.hh"
@@ -60,6 +64,7 @@ class timestamped_val {
     loading_cache_clock_type::time_point _last_read;
     lru_entry* _lru_entry_ptr = nullptr; /// MRU item is at the front, LRU - at the back
     size_t _size = 0;
+    bool _reloading = false;
 
 public:
     timestamped_val(value_type val)
@@ -104,6 +109,15 @@ class timestamped_val {
         return _lru_entry_ptr;
     }
 
+    /// True while a background reload of the value is in progress.
+    bool reloading() const noexcept {
+        return _reloading;
+    }
+
+    void set_reloading(bool reloading) noexcept {
+        _reloading = reloading;
+    }
+
     lru_entry* lru_entry_ptr() const noexcept {
         return _lru_entry_ptr;
     }
@@ -205,6 +219,14 @@ class timestamped_val<Tp, Key, EntrySize, Hash, EqualPred, LoadingSharedValuesSt
 
 enum class loading_cache_reload_enabled { no, yes };
 
+/// Returns the shard owning the loads of the given key, for caches whose shards share loaded values: the owner
+/// loads the value from the backing store and the other shards load it from the owner's cache, so that the backing
+/// store is queried once per node rather than once per shard.
+template <typename Key, typename Hash = std::hash<Key>>
+inline unsigned loading_cache_owner_shard(const Key& k, const Hash& hash = Hash()) {
+    return hash(k) % smp::count;
+}
+
 /// \brief Loading cache is a cache that loads the value into the cache using the given asynchronous callback.
 ///
 /// Each cached value if reloading is enabled (\tparam ReloadEnabled == loading_cache_reload_enabled::yes) is reloaded after
@@ -235,6 +257,13 @@ enum class loading_cache_reload_enabled { no, yes };
 /// it's going to be "loaded" in the context of get_XXX(key). As long as the value is cached get_XXX(key) is going to return the
 /// cached value immediately and reload it in the background every "refresh" time period as described above.
 ///
+/// Reading a value that is due for a reload also starts the reload right away in the background, without waiting for
+/// the timer, while the current value is returned. This keeps frequently read values from aging out when the timer
+/// reloads are late.
+///
+/// At most max_concurrent_reloads background reloads run at a time, so that reloading many entries at once, e.g. on
+/// a timer tick, doesn't flood the backing store. Reloads waiting for their turn are not started again by reads.
+///
 /// \tparam Key type of the cache key
 /// \tparam Tp type of the cached value
 /// \tparam ReloadEnabled if loading_cache_reload_enabled::yes allow reloading the values otherwise don't reload
@@ -272,6 +301,7 @@ class loading_cache {
     using value_ptr = typename ts_value_type::value_ptr;
 
     class entry_is_too_big : public std::exception {};
+    static constexpr size_t max_concurrent_reloads = 16;
     using iterator = boost::transform_iterator<value_extractor_fn, list_iterator>;
 
 private:
@@ -356,6 +386,9 @@ class loading_cache {
                 return make_ready_future<value_ptr>(std::move(vp));
             }
 
+            if constexpr (ReloadEnabled == loading_cache_reload_enabled::yes) {
+                maybe_refresh_ahead(ts_val_ptr);
+            }
             return make_ready_future<value_ptr>(std::move(ts_val_ptr));
         });
     }
@@ -492,6 +525,25 @@ class loading_cache {
         Alloc().deallocate(val, 1);
     }
 
+    // Reads are served from the current value while it is reloaded, as long
+    // as it is less than _expiry old. Start the reload early enough for it
+    // to complete before that.
+    loading_cache_clock_type::duration refresh_ahead_period() const {
+        return std::min(_refresh, _expiry / 2);
+    }
+
+    void maybe_refresh_ahead(const timestamped_val_ptr& ts_value_ptr) {
+        if (ts_value_ptr->reloading() || _timer_reads_gate.is_closed()
+                || ts_value_ptr->loaded() + refresh_ahead_period() >= loading_cache_clock_type::now()) {
+            return;
+        }
+        _logger.trace("{}: reloading the value ahead of the timer", loading_values_type::to_key(ts_value_ptr));
+        // Future is waited on indirectly in `stop()` (via `_timer_reads_gate`).
+        (void)with_gate(_timer_reads_gate, [this, ts_value_ptr] () mutable {
+            return reload(std::move(ts_value_ptr));
+        });
+    }
+
     future<> reload(timestamped_val_ptr ts_value_ptr) {
         const Key& key = loading_values_type::to_key(ts_value_ptr);
 
@@ -502,7 +554,16 @@ class loading_cache {
             return make_ready_future<>();
         }
 
-        return _load(key).then_wrapped([this, ts_value_ptr = std::move(ts_value_ptr), &key] (auto&& f) mutable {
+        // Reloads started by reads and by the timer may overlap.
+        if (ts_value_ptr->reloading()) {
+            return make_ready_future<>();
+        }
+        ts_value_ptr->set_reloading(true);
+
+        return with_semaphore(_reload_concurrency, 1, [this, &key] {
+            return futurize_invoke(_load, key);
+        }).then_wrapped([this, ts_value_ptr = std::move(ts_value_ptr), &key] (auto&& f) mutable {
+            ts_value_ptr->set_reloading(false);
             // if the entry has been evicted by now - simply end here
             if (!ts_value_ptr->lru_entry_ptr()) {
                 _logger.trace("{}: entry was dropped during the reload", key);
@@ -612,8 +673,123 @@ class loading_cache {
     std::function<future<Tp>(const Key&)> _load;
     timer<loading_cache_clock_type> _timer;
     seastar::gate _timer_reads_gate;
+    seastar::semaphore _reload_concurrency{max_concurrent_reloads};
     value_extractor_fn _value_extractor_fn;
 };
 
-}
+/// \brief A node-wide loading cache in which a single shard loads and keeps the value of each key.
+///
+/// Every shard has an instance of shard_owned_loading_cache. The value of a key is loaded only by the owner shard of
+/// the key, chosen by loading_cache_owner_shard(), which keeps the only copy of the value. The other shards cache a
+/// foreign_ptr to the owner's value, which they load from the owner's cache instead of the backing store. This way the
+/// backing store is queried once per node rather than once per shard, and each value is stored once per node.
+///
+/// The owner reloads its values from the backing store like loading_cache does, within the same concurrency limit,
+/// and the other shards reload theirs from the owner. A value read on a shard other than the owner may therefore be
+/// up to two refresh periods old.
+///
+/// If caching is disabled each shard calls the "loader" itself, since there is no cached value to share.
+///
+/// \tparam Key type of the cache key
+/// \tparam Tp type of the cached value
+/// \tparam EntrySize predicate to calculate the entry size
+/// \tparam Hash hash function, also used to choose the owner shard of a key
+/// \tparam EqualPred equality predicate
+/// \tparam LoadingSharedValuesStats statistics incrementing class (see utils::loading_shared_values)
+template<typename Key,
+         typename Tp,
+         typename EntrySize = simple_entry_size<Tp>,
+         typename Hash = std::hash<Key>,
+         typename EqualPred = std::equal_to<Key>,
+         typename LoadingSharedValuesStats = utils::do_nothing_loading_shared_values_stats>
+class shard_owned_loading_cache {
+public:
+    using key_type = Key;
+    using value_type = Tp;
+    /// The value owned by the shard which loaded it, only read on the other shards.
+    using shared_value_ptr = foreign_ptr<lw_shared_ptr<const Tp>>;
+    /// Returns the instance of the cache on the shard it is called on.
+    using local_instance_fn = std::function<shard_owned_loading_cache&()>;
+
+private:
+    struct shared_value_size {
+        size_t operator()(const shared_value_ptr& v) {
+            return EntrySize()(*v);
+        }
+    };
+
+    using cache_type = loading_cache<Key, shared_value_ptr, loading_cache_reload_enabled::yes, shared_value_size, Hash, EqualPred, LoadingSharedValuesStats>;
+
+    std::function<future<Tp>(const Key&)> _load;
+    local_instance_fn _local_instance;
+    bool _caching_enabled;
+    // Loads from other shards, both the ones sent and the ones served.
+    seastar::gate _peer_loads_gate;
+    cache_type _cache;
 
+public:
+    template<typename Func>
+    shard_owned_loading_cache(size_t max_size, std::chrono::milliseconds expiry, std::chrono::milliseconds refresh, logging::logger& logger,
+            Func&& load, local_instance_fn local_instance)
+        : _load(std::forward<Func>(load))
+        , _local_instance(std::move(local_instance))
+        , _caching_enabled(expiry != std::chrono::milliseconds(0))
+        , _cache(max_size, expiry, refresh, logger, [this] (const Key& k) { return load_shared(k); })
+    {
+        static_assert(std::is_same<future<value_type>, std::result_of_t<Func(const key_type&)>>::value, "Bad Func signature");
+    }
+
+    future<Tp> get(const Key& k) {
+        if (!_caching_enabled) {
+            return futurize_invoke(_load, k);
+        }
+        return _cache.get_ptr(k).then([] (typename cache_type::value_ptr v) {
+            return make_ready_future<Tp>(**v);
+        });
+    }
+
+    future<> stop() {
+        return _peer_loads_gate.close().then([this] {
+            return _cache.stop();
+        });
+    }
+
+    void remove(const Key& k) {
+        _cache.remove(k);
+    }
+
+    size_t size() const {
+        return _cache.size();
+    }
+
+    size_t memory_footprint() const {
+        return _cache.memory_footprint();
+    }
+
+private:
+    future<shared_value_ptr> load_shared(const Key& k) {
+        const auto owner = loading_cache_owner_shard(k, Hash());
+        if (owner == this_shard_id()) {
+            return futurize_invoke(_load, k).then([] (Tp val) {
+                return make_foreign(make_lw_shared<const Tp>(std::move(val)));
+            });
+        }
+        return with_gate(_peer_loads_gate, [this, owner, &k] {
+            return smp::submit_to(owner, [this, k] {
+                return _local_instance().share(k);
+            });
+        });
+    }
+
+    // Called on the owner of the key by the other shards.
+    future<shared_value_ptr> share(const Key& k) {
+        return with_gate(_peer_loads_gate, [this, &k] {
+            return _cache.get_ptr(k).then([] (typename cache_type::value_ptr v) {
+                auto f = v->copy();
+                return f.finally([v = std::move(v)] { });
+            });
+        });
+    }
+};
+
+}
@@ -33,6 +33,8 @@
 #include <seastar/core/align.hh>
 #include <seastar/core/print.hh>
 #include <seastar/core/metrics.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/abort_source.hh>
 #include <seastar/util/alloc_failure_injector.hh>
 #include <seastar/util/backtrace.hh>
 
@@ -351,12 +353,27 @@ static thread_local tracker tracker_instance;
 
 using clock = std::chrono::steady_clock;
 
+// How often the background reclaimer checks free memory when idle.
+static constexpr auto background_reclaim_period = std::chrono::milliseconds(10);
+
 class tracker::impl {
+    struct reclaim_stats {
+        clock::duration foreground_reclaim_time{};
+        clock::duration background_reclaim_time{};
+        uint64_t background_reclaimed_memory = 0;
+    };
     std::vector<region::impl*> _regions;
     seastar::metrics::metric_groups _metrics;
     bool _reclaiming_enabled = true;
     size_t _reclamation_step = 1;
     bool _abort_on_bad_alloc = false;
+    reclaim_stats _reclaim_stats;
+    // Set while the background reclaimer runs a step, so that the time is
+    // accounted to it rather than to the foreground.
+    bool _in_background_reclaim = false;
+    size_t _background_reclaim_free_memory_goal = 0;
+    abort_source _background_reclaim_as;
+    std::optional<future<>> _background_reclaimer;
 private:
     // Prevents tracker's reclaimer from running while live. Reclaimer may be
     // invoked synchronously with allocator. This guard ensures that this
@@ -375,9 +392,21 @@ class tracker::impl {
         }
     };
     friend class tracker_reclaimer_lock;
+
+    size_t background_reclaim_shortfall() const;
+    bool background_reclaim_step();
+    future<> background_reclaim_loop();
 public:
     impl();
     ~impl();
+    const reclaim_stats& get_reclaim_stats() const {
+        return _reclaim_stats;
+    }
+    clock::duration& reclaim_time() {
+        return _in_background_reclaim ? _reclaim_stats.background_reclaim_time : _reclaim_stats.foreground_reclaim_time;
+    }
+    void start_background_reclaim(scheduling_group sg, size_t free_memory_goal);
+    future<> stop_background_reclaim();
     void register_region(region::impl*);
     void unregister_region(region::impl*) noexcept;
     size_t reclaim(size_t bytes);
@@ -422,6 +451,14 @@ reactor::idle_cpu_handler_result tracker::compact_on_idle(reactor::work_waiting_
     return _impl->compact_on_idle(check_for_work);
 }
 
+void tracker::start_background_reclaim(scheduling_group sg, size_t free_memory_goal) {
+    _impl->start_background_reclaim(sg, free_memory_goal);
+}
+
+future<> tracker::stop_background_reclaim() {
+    return _impl->stop_background_reclaim();
+}
+
 occupancy_stats tracker::region_occupancy() {
     return _impl->region_occupancy();
 }
@@ -1846,19 +1883,18 @@ static void reclaim_from_evictable(region::impl& r, size_t target_mem_in_use) {
 }
 
 struct reclaim_timer {
+    clock::duration& total;
     clock::time_point start;
     bool enabled;
-    reclaim_timer() {
-        if (timing_logger.is_enabled(logging::log_level::debug)) {
-            start = clock::now();
-            enabled = true;
-        } else {
-            enabled = false;
-        }
-    }
+    explicit reclaim_timer(clock::duration& total)
+        : total(total)
+        , start(clock::now())
+        , enabled(timing_logger.is_enabled(logging::log_level::debug))
+    { }
     ~reclaim_timer() {
+        auto duration = clock::now() - start;
+        total += duration;
         if (enabled) {
-            auto duration = clock::now() - start;
             timing_logger.debug("Reclamation cycle took {} us.",
                 std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(duration).count());
         }
@@ -1909,6 +1945,61 @@ reactor::idle_cpu_handler_result tracker::impl::compact_on_idle(reactor::work_wa
     return reactor::idle_cpu_handler_result::interrupted_by_higher_priority_task;
 }
 
+size_t tracker::impl::background_reclaim_shortfall() const {
+    // Free LSA segments are as good as free memory, reclaim() releases them first.
+    auto free = memory::stats().free_memory() + shard_segment_pool.unreserved_free_segments() * segment::size;
+    return _background_reclaim_free_memory_goal - std::min(_background_reclaim_free_memory_goal, free);
+}
+
+// Returns true if memory was reclaimed and more is still needed.
+bool tracker::impl::background_reclaim_step() {
+    if (!background_reclaim_shortfall()) {
+        return false;
+    }
+    _in_background_reclaim = true;
+    auto released = reclaim(_reclamation_step * segment::size);
+    _in_background_reclaim = false;
+    _reclaim_stats.background_reclaimed_memory += released;
+    return released && background_reclaim_shortfall();
+}
+
+future<> tracker::impl::background_reclaim_loop() {
+    return repeat([this] {
+        if (_background_reclaim_as.abort_requested()) {
+            return make_ready_future<stop_iteration>(stop_iteration::yes);
+        }
+        while (background_reclaim_step()) {
+            if (need_preempt()) {
+                return later().then([] {
+                    return stop_iteration::no;
+                });
+            }
+        }
+        return sleep_abortable(background_reclaim_period, _background_reclaim_as).then_wrapped([] (future<> f) {
+            f.ignore_ready_future();
+            return stop_iteration::no;
+        });
+    });
+}
+
+void tracker::impl::start_background_reclaim(scheduling_group sg, size_t free_memory_goal) {
+    assert(!_background_reclaimer);
+    _background_reclaim_free_memory_goal = free_memory_goal;
+    _background_reclaimer = with_scheduling_group(sg, [this] {
+        return background_reclaim_loop();
+    });
+}
+
+future<> tracker::impl::stop_background_reclaim() {
+    if (!_background_reclaimer) {
+        return make_ready_future<>();
+    }
+    _background_reclaim_as.request_abort();
+    auto f = std::move(*_background_reclaimer);
+    _background_reclaimer = std::nullopt;
+    return f;
+}
+
 size_t tracker::impl::reclaim(size_t memory_to_release) {
     // Reclamation steps:
     // 1. Try to release free segments from segment pool and emergency reserve.
@@ -1918,7 +2009,7 @@ size_t tracker::impl::reclaim(size_t memory_to_release) {
         return 0;
     }
     reclaiming_lock rl(*this);
-    reclaim_timer timing_guard;
+    reclaim_timer timing_guard(reclaim_time());
 
     size_t mem_released;
     {
@@ -1945,7 +2036,7 @@ size_t tracker::impl::compact_and_evict(size_t reserve_segments, size_t memory_t
         return 0;
     }
     reclaiming_lock rl(*this);
-    reclaim_timer timing_guard;
+    reclaim_timer timing_guard(reclaim_time());
     return compact_and_evict_locked(reserve_segments, memory_to_release);
 }
 
@@ -2129,6 +2220,19 @@ tracker::impl::impl() {
 
         sm::make_derive("memory_allocated", [this] { return shard_segment_pool.statistics().memory_allocated; },
                         sm::description("Counts number of bytes which were requested from LSA allocator.")),
+
+        sm::make_derive("foreground_reclaim_time_us", [this] {
+                            return std::chrono::duration_cast<std::chrono::microseconds>(_reclaim_stats.foreground_reclaim_time).count();
+                        },
+                        sm::description("Counts microseconds spent reclaiming memory on behalf of allocations.")),
+
+        sm::make_derive("background_reclaim_time_us", [this] {
+                            return std::chrono::duration_cast<std::chrono::microseconds>(_reclaim_stats.background_reclaim_time).count();
+                        },
+                        sm::description("Counts microseconds spent reclaiming memory in the background.")),
+
+        sm::make_derive("background_reclaimed_memory", [this] { return _reclaim_stats.background_reclaimed_memory; },
+                        sm::description("Counts number of bytes which were reclaimed in the background.")),
     });
 }
 
@@ -2337,6 +2441,14 @@ uint64_t memory_compacted() {
     return shard_segment_pool.statistics().memory_compacted;
 }
 
+std::chrono::steady_clock::duration foreground_reclaim_time() {
+    return shard_tracker().get_impl().get_reclaim_stats().foreground_reclaim_time;
+}
+
+std::chrono::steady_clock::duration background_reclaim_time() {
+    return shard_tracker().get_impl().get_reclaim_stats().background_reclaim_time;
+}
+
 }
 
 // Orders segments by free space, assuming all segments have the same size.
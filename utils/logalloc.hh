@@ -30,6 +30,7 @@
 #include <seastar/core/future-util.hh>
 #include <seastar/core/circular_buffer.hh>
 #include <seastar/core/expiring_fifo.hh>
+#include <seastar/core/scheduling.hh>
 #include "allocation_strategy.hh"
 #include <boost/heap/binomial_heap.hpp>
 #include "seastarx.hh"
@@ -42,7 +43,11 @@ class region;
 class region_impl;
 class allocating_section;
 
-constexpr int segment_size_shift = 17; // 128K; see #151, #152
+// Can be overridden at build time, e.g. to benchmark other segment sizes.
+#ifndef SCYLLA_LSA_SEGMENT_SIZE_SHIFT
+#define SCYLLA_LSA_SEGMENT_SIZE_SHIFT 17 // 128K; see #151, #152
+#endif
+constexpr int segment_size_shift = SCYLLA_LSA_SEGMENT_SIZE_SHIFT;
 constexpr size_t segment_size = 1 << segment_size_shift;
 constexpr size_t max_zone_segments = 256;
 
@@ -466,6 +471,16 @@ class tracker {
     // or there are no more segments to compact.
     reactor::idle_cpu_handler_result compact_on_idle(reactor::work_waiting_on_reactor);
 
+    // Starts reclaiming memory in the background, in the given scheduling group,
+    // whenever less than free_memory_goal bytes are free. Regions with the
+    // sparsest segments are compacted first, and data is evicted only when
+    // compaction is not enough, like in the foreground. Keeping memory free
+    // ahead of time spares allocations from having to reclaim synchronously.
+    void start_background_reclaim(seastar::scheduling_group sg, size_t free_memory_goal);
+
+    // Stops the background reclaimer started with start_background_reclaim().
+    future<> stop_background_reclaim();
+
     // Compacts as much as possible. Very expensive, mainly for testing.
     // Guarantees that every live object from reclaimable regions will be moved.
     // Invalidates references to objects in all compactible and evictable regions.
@@ -773,4 +788,9 @@ future<> prime_segment_pool(size_t available_memory, size_t min_free_memory);
 uint64_t memory_allocated();
 uint64_t memory_compacted();
 
+// Time spent by this shard reclaiming memory, synchronously with allocations
+// and in the background reclaimer respectively.
+std::chrono::steady_clock::duration foreground_reclaim_time();
+std::chrono::steady_clock::duration background_reclaim_time();
+
 }
@@ -26,6 +26,7 @@
 #include <memory>
 #include "bytes.hh"
 #include "utils/allocation_strategy.hh"
+#include "utils/fragment_range.hh"
 #include <seastar/core/unaligned.hh>
 #include <seastar/util/alloc_failure_injector.hh>
 #include <unordered_map>
@@ -345,6 +346,75 @@ class managed_bytes {
         return external() && _u.ptr->next;
     }
 
+    // A FragmentRange over the storage of a managed_bytes. Unlike the
+    // conversion to bytes_view, iterating over it never linearizes the value.
+    class fragment_range {
+        const managed_bytes* _mb;
+    public:
+        using fragment_type = bytes_view;
+
+        class iterator {
+            bytes_view _current;
+            const blob_storage* _next = nullptr;
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = bytes_view;
+            using pointer = const bytes_view*;
+            using reference = const bytes_view&;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            explicit iterator(const managed_bytes& mb) {
+                if (!mb.external()) {
+                    if (mb._u.small.size) {
+                        _current = bytes_view(mb._u.small.data, mb._u.small.size);
+                    }
+                } else {
+                    _current = bytes_view(mb._u.ptr->data, mb._u.ptr->frag_size);
+                    _next = mb._u.ptr->next;
+                }
+            }
+
+            const bytes_view& operator*() const { return _current; }
+            const bytes_view* operator->() const { return &_current; }
+
+            iterator& operator++() {
+                if (_next) {
+                    _current = bytes_view(_next->data, _next->frag_size);
+                    _next = _next->next;
+                } else {
+                    _current = bytes_view();
+                }
+                return *this;
+            }
+            iterator operator++(int) {
+                auto it = *this;
+                operator++();
+                return it;
+            }
+
+            bool operator==(const iterator& other) const {
+                return _current.data() == other._current.data();
+            }
+            bool operator!=(const iterator& other) const {
+                return !(*this == other);
+            }
+        };
+        using const_iterator = iterator;
+
+        explicit fragment_range(const managed_bytes& mb) : _mb(&mb) { }
+
+        iterator begin() const { return iterator(*_mb); }
+        iterator end() const { return iterator(); }
+
+        size_t size_bytes() const { return _mb->size(); }
+        bool empty() const { return _mb->empty(); }
+    };
+
+    fragment_range fragments() const {
+        return fragment_range(*this);
+    }
+
     operator bytes_mutable_view() {
         assert(!is_fragmented());
         return { data(), size() };
@@ -400,6 +470,12 @@ class managed_bytes {
         return read_linearize();
     }
 
+    // Returns the amount of external memory a managed_bytes of the given
+    // size would use, for sizes small enough not to be fragmented.
+    static size_t external_memory_usage_for(size_t size) noexcept {
+        return size > max_inline_size ? sizeof(blob_storage) + size : 0;
+    }
+
     // Returns the amount of external memory used.
     size_t external_memory_usage() const {
         if (external()) {
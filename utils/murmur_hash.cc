@@ -39,6 +39,13 @@
 
 #include "murmur_hash.hh"
 
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
 namespace utils {
 
 namespace murmur_hash {
@@ -170,32 +177,36 @@ static inline uint64_t getblock(bytes_view key, uint32_t index)
             | (uint64_t(p[7]) << 56);
 }
 
-void hash3_x64_128(bytes_view key, uint64_t seed, std::array<uint64_t,2> &result)
+static constexpr uint64_t hash3_c1 = 0x87c37b91114253d5L;
+static constexpr uint64_t hash3_c2 = 0x4cf5ad432745937fL;
+
+static inline void hash3_mix_block(uint64_t& h1, uint64_t& h2, uint64_t k1, uint64_t k2)
+{
+    k1 *= hash3_c1; k1 = rotl64(k1,31); k1 *= hash3_c2; h1 ^= k1;
+
+    h1 = rotl64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
+
+    k2 *= hash3_c2; k2  = rotl64(k2,33); k2 *= hash3_c1; h2 ^= k2;
+
+    h2 = rotl64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+}
+
+// Hashes the blocks of key starting at first_block, then its tail, into a
+// state which has already absorbed the preceding blocks.
+static void hash3_x64_128_finish(bytes_view key, uint32_t first_block, uint64_t h1, uint64_t h2, std::array<uint64_t,2> &result)
 {
     uint32_t length = key.size();
     const uint32_t nblocks = length >> 4; // Process as 128-bit blocks.
 
-    uint64_t h1 = seed;
-    uint64_t h2 = seed;
-
-    uint64_t c1 = 0x87c37b91114253d5L;
-    uint64_t c2 = 0x4cf5ad432745937fL;
+    uint64_t c1 = hash3_c1;
+    uint64_t c2 = hash3_c2;
 
     //----------
     // body
 
-    for(uint32_t i = 0; i < nblocks; i++)
+    for(uint32_t i = first_block; i < nblocks; i++)
     {
-        uint64_t k1 = getblock(key, i*2+0);
-        uint64_t k2 = getblock(key, i*2+1);
-
-        k1 *= c1; k1 = rotl64(k1,31); k1 *= c2; h1 ^= k1;
-
-        h1 = rotl64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
-
-        k2 *= c2; k2  = rotl64(k2,33); k2 *= c1; h2 ^= k2;
-
-        h2 = rotl64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+        hash3_mix_block(h1, h2, getblock(key, i*2+0), getblock(key, i*2+1));
     }
 
     //----------
@@ -246,5 +257,195 @@ void hash3_x64_128(bytes_view key, uint64_t seed, std::array<uint64_t,2> &result
     result[1] = h2;
 }
 
+void hash3_x64_128(bytes_view key, uint64_t seed, std::array<uint64_t,2> &result)
+{
+    hash3_x64_128_finish(key, 0, seed, seed, result);
+}
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+
+// Hashes eight keys in the 64-bit lanes of AVX-512 registers. Lane l holds
+// the state of keys[l]. AVX-512DQ has the 64-bit multiplies murmur3 needs;
+// AVX2 has to build them from 32-bit ones, which loses to scalar code.
+static constexpr size_t hash3_vector_lanes = 8;
+
+static inline __m512i hash3_mix_k1(__m512i h1, __m512i k1)
+{
+    k1 = _mm512_mullo_epi64(k1, _mm512_set1_epi64(hash3_c1));
+    k1 = _mm512_rol_epi64(k1, 31);
+    k1 = _mm512_mullo_epi64(k1, _mm512_set1_epi64(hash3_c2));
+    return _mm512_xor_si512(h1, k1);
+}
+
+static inline __m512i hash3_mix_k2(__m512i h2, __m512i k2)
+{
+    k2 = _mm512_mullo_epi64(k2, _mm512_set1_epi64(hash3_c2));
+    k2 = _mm512_rol_epi64(k2, 33);
+    k2 = _mm512_mullo_epi64(k2, _mm512_set1_epi64(hash3_c1));
+    return _mm512_xor_si512(h2, k2);
+}
+
+static inline __m512i hash3_times5_plus(__m512i h, uint64_t c)
+{
+    return _mm512_add_epi64(_mm512_add_epi64(_mm512_slli_epi64(h, 2), h), _mm512_set1_epi64(c));
+}
+
+static inline __m512i fmix(__m512i k)
+{
+    k = _mm512_xor_si512(k, _mm512_srli_epi64(k, 33));
+    k = _mm512_mullo_epi64(k, _mm512_set1_epi64(0xff51afd7ed558ccdL));
+    k = _mm512_xor_si512(k, _mm512_srli_epi64(k, 33));
+    k = _mm512_mullo_epi64(k, _mm512_set1_epi64(0xc4ceb9fe1a85ec53L));
+    k = _mm512_xor_si512(k, _mm512_srli_epi64(k, 33));
+    return k;
+}
+
+// Splits the 16-byte chunks of eight lanes into their first and second words.
+static inline void hash3_words(const __m128i* chunks, __m512i& k1, __m512i& k2)
+{
+    auto lo = _mm512_castsi128_si512(chunks[0]);
+    lo = _mm512_inserti64x2(lo, chunks[1], 1);
+    lo = _mm512_inserti64x2(lo, chunks[2], 2);
+    lo = _mm512_inserti64x2(lo, chunks[3], 3);
+    auto hi = _mm512_castsi128_si512(chunks[4]);
+    hi = _mm512_inserti64x2(hi, chunks[5], 1);
+    hi = _mm512_inserti64x2(hi, chunks[6], 2);
+    hi = _mm512_inserti64x2(hi, chunks[7], 3);
+    k1 = _mm512_permutex2var_epi64(lo, _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14), hi);
+    k2 = _mm512_permutex2var_epi64(lo, _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15), hi);
+}
+
+// The tail bytes are sign extended before they are xored into their word,
+// so each byte of a word is flipped once per negative byte below it.
+static inline __m512i hash3_sign_extend_tail(__m512i k)
+{
+    uint64_t p = _mm512_movepi8_mask(k);
+    p ^= (p << 1) & 0xfefefefefefefefe;
+    p ^= (p << 2) & 0xfcfcfcfcfcfcfcfc;
+    p ^= (p << 4) & 0xf0f0f0f0f0f0f0f0;
+    const uint64_t flipped = (p << 1) & 0xfefefefefefefefe;
+    return _mm512_xor_si512(k, _mm512_movm_epi8(flipped));
+}
+
+static void hash3_x64_128_lanes(const bytes_view* keys, uint64_t seed, std::array<uint64_t, 2>* results)
+{
+    uint32_t common_blocks = std::numeric_limits<uint32_t>::max();
+    for (size_t l = 0; l < hash3_vector_lanes; ++l) {
+        common_blocks = std::min(common_blocks, uint32_t(keys[l].size() >> 4));
+    }
+
+    auto h1 = _mm512_set1_epi64(seed);
+    auto h2 = _mm512_set1_epi64(seed);
+    __m128i chunks[hash3_vector_lanes];
+    __m512i k1;
+    __m512i k2;
+
+    //----------
+    // body
+
+    for (uint32_t b = 0; b < common_blocks; ++b) {
+        for (size_t l = 0; l < hash3_vector_lanes; ++l) {
+            chunks[l] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys[l].data() + b * 16));
+        }
+        hash3_words(chunks, k1, k2);
+
+        h1 = hash3_mix_k1(h1, k1);
+
+        h1 = _mm512_rol_epi64(h1, 27); h1 = _mm512_add_epi64(h1, h2); h1 = hash3_times5_plus(h1, 0x52dce729);
+
+        h2 = hash3_mix_k2(h2, k2);
+
+        h2 = _mm512_rol_epi64(h2, 31); h2 = _mm512_add_epi64(h2, h1); h2 = hash3_times5_plus(h2, 0x38495ab5);
+    }
+
+    // Keys longer than the shortest one mix their remaining blocks alone.
+    std::array<uint64_t, hash3_vector_lanes> s1;
+    std::array<uint64_t, hash3_vector_lanes> s2;
+    std::array<uint64_t, hash3_vector_lanes> length;
+    _mm512_storeu_si512(s1.data(), h1);
+    _mm512_storeu_si512(s2.data(), h2);
+    for (size_t l = 0; l < hash3_vector_lanes; ++l) {
+        const uint32_t nblocks = keys[l].size() >> 4;
+        for (uint32_t b = common_blocks; b < nblocks; ++b) {
+            hash3_mix_block(s1[l], s2[l], getblock(keys[l], b*2+0), getblock(keys[l], b*2+1));
+        }
+        // The masked load reads no byte past the end of the key.
+        const auto tail = keys[l].size() & 15;
+        chunks[l] = _mm_maskz_loadu_epi8(__mmask16((1u << tail) - 1), keys[l].data() + nblocks * 16);
+        length[l] = uint32_t(keys[l].size());
+    }
+    h1 = _mm512_loadu_si512(s1.data());
+    h2 = _mm512_loadu_si512(s2.data());
+
+    //----------
+    // tail
+
+    hash3_words(chunks, k1, k2);
+    // Mixing a zero word leaves the state as it is, so every lane mixes both
+    // words of its tail whatever its length.
+    h2 = hash3_mix_k2(h2, hash3_sign_extend_tail(k2));
+    h1 = hash3_mix_k1(h1, hash3_sign_extend_tail(k1));
+
+    //----------
+    // finalization
+
+    const auto len = _mm512_loadu_si512(length.data());
+    h1 = _mm512_xor_si512(h1, len); h2 = _mm512_xor_si512(h2, len);
+
+    h1 = _mm512_add_epi64(h1, h2);
+    h2 = _mm512_add_epi64(h2, h1);
+
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+
+    h1 = _mm512_add_epi64(h1, h2);
+    h2 = _mm512_add_epi64(h2, h1);
+
+    _mm512_storeu_si512(s1.data(), h1);
+    _mm512_storeu_si512(s2.data(), h2);
+    for (size_t l = 0; l < hash3_vector_lanes; ++l) {
+        results[l][0] = s1[l];
+        results[l][1] = s2[l];
+    }
+}
+
+#endif
+
+void hash3_x64_128(const std::vector<bytes_view>& keys, uint64_t seed, std::vector<std::array<uint64_t, 2>>& results)
+{
+    results.resize(keys.size());
+    size_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+    for (; i + hash3_vector_lanes <= keys.size(); i += hash3_vector_lanes) {
+        hash3_x64_128_lanes(keys.data() + i, seed, results.data() + i);
+    }
+#endif
+
+    // The hash of a single key is one long dependency chain of multiplies.
+    // Interleaving the blocks of several keys lets their chains overlap.
+    static constexpr size_t lanes = 4;
+
+    for (; i + lanes <= keys.size(); i += lanes) {
+        std::array<uint64_t, lanes> h1;
+        std::array<uint64_t, lanes> h2;
+        uint32_t common_blocks = std::numeric_limits<uint32_t>::max();
+        for (size_t l = 0; l < lanes; ++l) {
+            h1[l] = h2[l] = seed;
+            common_blocks = std::min(common_blocks, uint32_t(keys[i + l].size() >> 4));
+        }
+        for (uint32_t b = 0; b < common_blocks; ++b) {
+            for (size_t l = 0; l < lanes; ++l) {
+                hash3_mix_block(h1[l], h2[l], getblock(keys[i + l], b*2+0), getblock(keys[i + l], b*2+1));
+            }
+        }
+        for (size_t l = 0; l < lanes; ++l) {
+            hash3_x64_128_finish(keys[i + l], common_blocks, h1[l], h2[l], results[i + l]);
+        }
+    }
+    for (; i < keys.size(); ++i) {
+        hash3_x64_128(keys[i], seed, results[i]);
+    }
+}
+
 } // namespace murmur_hash
 } // namespace utils
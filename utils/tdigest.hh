@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace utils {
+
+/// A merging t-digest (Dunning, Ertl: "Computing Extremely Accurate Quantiles
+/// Using t-Digests") estimating quantiles of a stream of doubles in bounded
+/// memory. Centroids near the tails are kept small, so extreme quantiles are
+/// estimated more accurately than the median.
+///
+/// Digests built over disjoint parts of a stream can be merged into a digest
+/// of the whole stream.
+class tdigest {
+public:
+    struct centroid {
+        double mean;
+        double weight;
+    };
+private:
+    double _compression;
+    std::vector<centroid> _centroids;
+    std::vector<centroid> _buffer;
+    double _total_weight = 0;
+    double _min = std::numeric_limits<double>::infinity();
+    double _max = -std::numeric_limits<double>::infinity();
+public:
+    /// \param compression bounds the number of centroids to about
+    ///        \c compression / 2 after compaction.
+    explicit tdigest(double compression = 100) : _compression(compression) {
+        _buffer.reserve(buffer_size());
+    }
+
+    void add(double x, double weight = 1) {
+        if (std::isnan(x)) {
+            return;
+        }
+        _buffer.push_back({x, weight});
+        _total_weight += weight;
+        _min = std::min(_min, x);
+        _max = std::max(_max, x);
+        if (_buffer.size() >= buffer_size()) {
+            compress();
+        }
+    }
+
+    void merge(const tdigest& other) {
+        for (auto& cs : {std::cref(other._centroids), std::cref(other._buffer)}) {
+            _buffer.insert(_buffer.end(), cs.get().begin(), cs.get().end());
+        }
+        _total_weight += other._total_weight;
+        _min = std::min(_min, other._min);
+        _max = std::max(_max, other._max);
+        compress();
+    }
+
+    /// Merges a digest given by its centroids and extremes, e.g. one
+    /// restored from its serialized form.
+    void merge(const std::vector<centroid>& centroids, double min, double max) {
+        _buffer.insert(_buffer.end(), centroids.begin(), centroids.end());
+        for (auto& c : centroids) {
+            _total_weight += c.weight;
+        }
+        _min = std::min(_min, min);
+        _max = std::max(_max, max);
+        compress();
+    }
+
+    void clear() {
+        _centroids.clear();
+        _buffer.clear();
+        _total_weight = 0;
+        _min = std::numeric_limits<double>::infinity();
+        _max = -std::numeric_limits<double>::infinity();
+    }
+
+    double total_weight() const {
+        return _total_weight;
+    }
+
+    double min() const {
+        return _min;
+    }
+
+    double max() const {
+        return _max;
+    }
+
+    const std::vector<centroid>& centroids() {
+        compress();
+        return _centroids;
+    }
+
+    /// Estimates the value below which the fraction \c q of the weight lies.
+    /// Returns NaN for an empty digest.
+    double quantile(double q) {
+        compress();
+        if (_centroids.empty()) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        if (_centroids.size() == 1) {
+            return _centroids.front().mean;
+        }
+        auto index = std::clamp(q, 0.0, 1.0) * _total_weight;
+        auto first_center = _centroids.front().weight / 2;
+        if (index <= first_center) {
+            return _min + (_centroids.front().mean - _min) * (first_center > 0 ? index / first_center : 0);
+        }
+        auto center = first_center;
+        for (size_t i = 0; i + 1 < _centroids.size(); ++i) {
+            auto next_center = center + (_centroids[i].weight + _centroids[i + 1].weight) / 2;
+            if (index <= next_center) {
+                auto f = (index - center) / (next_center - center);
+                return _centroids[i].mean + (_centroids[i + 1].mean - _centroids[i].mean) * f;
+            }
+            center = next_center;
+        }
+        auto last_weight = _total_weight - center;
+        auto f = last_weight > 0 ? (index - center) / last_weight : 1;
+        return _centroids.back().mean + (_max - _centroids.back().mean) * std::min(f, 1.0);
+    }
+private:
+    size_t buffer_size() const {
+        return size_t(_compression) * 5;
+    }
+
+    // The k1 scale function, mapping a quantile to the index of the
+    // centroid covering it. A centroid may span at most one unit of k.
+    double k(double q) const {
+        return _compression / (2 * M_PI) * std::asin(2 * q - 1);
+    }
+
+    double q_limit(double q) const {
+        auto max_k = _compression / 4;
+        auto next_k = std::min(k(q) + 1, max_k);
+        return (std::sin(next_k * 2 * M_PI / _compression) + 1) / 2;
+    }
+
+    void compress() {
+        if (_buffer.empty()) {
+            return;
+        }
+        _buffer.insert(_buffer.end(), _centroids.begin(), _centroids.end());
+        std::sort(_buffer.begin(), _buffer.end(), [] (const centroid& a, const centroid& b) {
+            return a.mean < b.mean;
+        });
+        _centroids.clear();
+        double weight_so_far = 0;
+        double limit = q_limit(0);
+        for (auto& c : _buffer) {
+            if (!_centroids.empty()) {
+                auto& last = _centroids.back();
+                if ((weight_so_far + last.weight + c.weight) / _total_weight <= limit) {
+                    last.mean += (c.mean - last.mean) * c.weight / (last.weight + c.weight);
+                    last.weight += c.weight;
+                    continue;
+                }
+                weight_so_far += last.weight;
+                limit = q_limit(weight_so_far / _total_weight);
+            }
+            _centroids.push_back(c);
+        }
+        _buffer.clear();
+    }
+};
+
+}
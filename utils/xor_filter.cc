@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2020 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <seastar/core/thread.hh>
+#include <seastar/core/preempt.hh>
+
+#include "utils/xor_filter.hh"
+#include "utils/bloom_calculations.hh"
+#include "log.hh"
+
+namespace utils {
+namespace filter {
+
+static logging::logger xflogger("xor_filter");
+
+static thread_local uint64_t xor_filter_memory_saved = 0;
+
+// The number of seeds tried before the key hashes are checked for
+// duplicates, which make the construction fail regardless of the seed.
+static constexpr unsigned attempts_before_deduplication = 8;
+static constexpr unsigned max_attempts = 64;
+
+static inline uint64_t mix(uint64_t h) {
+    // Finalizer of murmur3.
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint64_t rotl(uint64_t x, unsigned n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+// Maps a 32-bit value uniformly onto [0, n) without a division.
+static inline uint64_t reduce(uint32_t x, uint64_t n) {
+    return (uint64_t(x) * n) >> 32;
+}
+
+static inline void maybe_yield() {
+    if (need_preempt()) {
+        seastar::thread::yield();
+    }
+}
+
+xor_filter::xor_filter(unsigned fingerprint_bits)
+    : _fingerprint_bits(fingerprint_bits)
+{ }
+
+xor_filter::xor_filter(unsigned fingerprint_bits, utils::chunked_vector<uint64_t> words)
+    : _fingerprint_bits(fingerprint_bits)
+    , _words(std::move(words))
+    , _built(true)
+{
+    if (_fingerprint_bits < 1 || _fingerprint_bits > bloom_calculations::xor_max_fingerprint_bits || _words.size() < header_words) {
+        throw std::invalid_argument(format("Invalid xor filter: {:d} fingerprint bits, {:d} words", _fingerprint_bits, _words.size()));
+    }
+    _seed = _words[0];
+    _segment_length = _words[1];
+    _keys = _words[2];
+    auto data_words = (3 * _segment_length * _fingerprint_bits + 63) / 64;
+    if (_words.size() != header_words + data_words) {
+        throw std::invalid_argument(format("Invalid xor filter: expected {:d} words, got {:d}", header_words + data_words, _words.size()));
+    }
+    account_memory_saved();
+}
+
+xor_filter::~xor_filter() {
+    xor_filter_memory_saved -= _memory_saved;
+}
+
+uint64_t xor_filter::shard_memory_saved() {
+    return xor_filter_memory_saved;
+}
+
+void xor_filter::account_memory_saved() {
+    auto bloom_size = bloom_calculations::bloom_filter_size(_keys, std::ldexp(1.0, -int(_fingerprint_bits)));
+    xor_filter_memory_saved -= _memory_saved;
+    _memory_saved = bloom_size > memory_size() ? bloom_size - memory_size() : 0;
+    xor_filter_memory_saved += _memory_saved;
+}
+
+xor_filter::slots xor_filter::slots_of(uint64_t key_hash) const {
+    auto h = mix(key_hash + _seed);
+    return slots{h, {
+        reduce(uint32_t(h), _segment_length),
+        _segment_length + reduce(uint32_t(rotl(h, 21)), _segment_length),
+        2 * _segment_length + reduce(uint32_t(rotl(h, 42)), _segment_length),
+    }};
+}
+
+uint64_t xor_filter::fingerprint(uint64_t hash) const {
+    return (hash ^ (hash >> 32)) & ((uint64_t(1) << _fingerprint_bits) - 1);
+}
+
+uint64_t xor_filter::get(uint64_t slot) const {
+    auto bit = slot * _fingerprint_bits;
+    auto word = header_words + bit / 64;
+    auto offset = bit % 64;
+    auto value = _words[word] >> offset;
+    if (offset + _fingerprint_bits > 64) {
+        value |= _words[word + 1] << (64 - offset);
+    }
+    return value & ((uint64_t(1) << _fingerprint_bits) - 1);
+}
+
+void xor_filter::apply_xor(uint64_t slot, uint64_t value) {
+    auto bit = slot * _fingerprint_bits;
+    auto word = header_words + bit / 64;
+    auto offset = bit % 64;
+    _words[word] ^= value << offset;
+    if (offset + _fingerprint_bits > 64) {
+        _words[word + 1] ^= value >> (64 - offset);
+    }
+}
+
+// Peels the hypergraph formed by the keys' slots: a slot referenced by a
+// single key determines that key's fingerprint, so the key is removed and
+// recorded along with that slot. Succeeds when all keys could be removed
+// this way.
+bool xor_filter::try_build(utils::chunked_vector<uint64_t>& peeled_slots, utils::chunked_vector<uint64_t>& peeled_keys) {
+    auto capacity = 3 * _segment_length;
+    utils::chunked_vector<uint32_t> counts;
+    utils::chunked_vector<uint64_t> xors;
+    counts.reserve(capacity);
+    xors.reserve(capacity);
+    for (uint64_t i = 0; i < capacity; ++i) {
+        counts.push_back(0);
+        xors.push_back(0);
+        maybe_yield();
+    }
+    for (auto h : _pending_hashes) {
+        for (auto slot : slots_of(h).slot) {
+            ++counts[slot];
+            xors[slot] ^= h;
+        }
+        maybe_yield();
+    }
+
+    utils::chunked_vector<uint64_t> queue;
+    for (uint64_t i = 0; i < capacity; ++i) {
+        if (counts[i] == 1) {
+            queue.push_back(i);
+        }
+        maybe_yield();
+    }
+
+    peeled_slots.clear();
+    peeled_keys.clear();
+    while (!queue.empty()) {
+        auto i = queue.back();
+        queue.pop_back();
+        if (counts[i] != 1) {
+            continue;
+        }
+        // The only key left in this slot.
+        auto h = xors[i];
+        peeled_slots.push_back(i);
+        peeled_keys.push_back(h);
+        for (auto slot : slots_of(h).slot) {
+            --counts[slot];
+            xors[slot] ^= h;
+            if (counts[slot] == 1) {
+                queue.push_back(slot);
+            }
+        }
+        maybe_yield();
+    }
+    return peeled_slots.size() == _keys;
+}
+
+void xor_filter::build() {
+    assert(seastar::thread::running_in_thread());
+    assert(!_built);
+
+    _keys = _pending_hashes.size();
+    utils::chunked_vector<uint64_t> peeled_slots;
+    utils::chunked_vector<uint64_t> peeled_keys;
+    for (unsigned attempt = 0; ; ++attempt) {
+        if (attempt == attempts_before_deduplication) {
+            // Duplicate hashes are extremely unlikely (the keys of an
+            // sstable are unique), so pay for sorting only when needed.
+            std::sort(_pending_hashes.begin(), _pending_hashes.end());
+            auto end = std::unique(_pending_hashes.begin(), _pending_hashes.end());
+            auto duplicates = _pending_hashes.end() - end;
+            for (auto i = 0; i < duplicates; ++i) {
+                _pending_hashes.pop_back();
+            }
+            xflogger.debug("Removed {:d} duplicate key hashes", duplicates);
+            _keys = _pending_hashes.size();
+        }
+        if (attempt == max_attempts) {
+            throw std::runtime_error(format("Failed to build xor filter for {:d} keys", _keys));
+        }
+        _seed = mix(attempt + 1);
+        _segment_length = bloom_calculations::xor_capacity(_keys) / 3;
+        if (try_build(peeled_slots, peeled_keys)) {
+            break;
+        }
+    }
+
+    auto data_words = (3 * _segment_length * _fingerprint_bits + 63) / 64;
+    _words.clear();
+    _words.reserve(header_words + data_words);
+    _words.push_back(_seed);
+    _words.push_back(_segment_length);
+    _words.push_back(_keys);
+    for (uint64_t i = 0; i < data_words; ++i) {
+        _words.push_back(0);
+        maybe_yield();
+    }
+
+    // Assign fingerprints in reverse peeling order. When a key is handled,
+    // its peeled slot is still zero and is not used by any key handled
+    // before, so setting it makes the xor of the key's slots match the
+    // fingerprint without breaking the keys already handled.
+    for (auto i = peeled_slots.size(); i-- > 0;) {
+        auto s = slots_of(peeled_keys[i]);
+        apply_xor(peeled_slots[i], fingerprint(s.hash) ^ get(s.slot[0]) ^ get(s.slot[1]) ^ get(s.slot[2]));
+        maybe_yield();
+    }
+
+    _pending_hashes = {};
+    _built = true;
+    account_memory_saved();
+}
+
+void xor_filter::add(const bytes_view& key) {
+    assert(!_built);
+    _pending_hashes.push_back(make_hashed_key(key).hash()[0]);
+}
+
+bool xor_filter::is_present(const bytes_view& key) {
+    return is_present(make_hashed_key(key));
+}
+
+bool xor_filter::is_present(hashed_key key) {
+    if (!_keys) {
+        return false;
+    }
+    auto s = slots_of(key.hash()[0]);
+    return fingerprint(s.hash) == (get(s.slot[0]) ^ get(s.slot[1]) ^ get(s.slot[2]));
+}
+
+void xor_filter::clear() {
+    _words.clear();
+    _pending_hashes.clear();
+    _keys = 0;
+    _built = false;
+    account_memory_saved();
+}
+
+size_t xor_filter::peak_memory(uint64_t keys) {
+    auto capacity = bloom_calculations::xor_capacity(keys);
+    // Pending hashes, peeled keys and peeled slots for every key; counts,
+    // xors and the peeling queue for every slot; then the table itself, with
+    // fingerprints of at most 32 bits.
+    return keys * 3 * sizeof(uint64_t) + capacity * (2 * sizeof(uint32_t) + 2 * sizeof(uint64_t));
+}
+
+size_t xor_filter::memory_size() {
+    return _words.memory_size() + _pending_hashes.memory_size();
+}
+
+filter_ptr create_xor_filter(double max_false_pos_probability) {
+    return std::make_unique<xor_filter>(bloom_calculations::xor_fingerprint_bits(max_false_pos_probability));
+}
+
+filter_ptr create_xor_filter(unsigned fingerprint_bits, utils::chunked_vector<uint64_t>&& words) {
+    return std::make_unique<xor_filter>(fingerprint_bits, std::move(words));
+}
+
+}
+}
@@ -48,6 +48,10 @@
 #include <limits>
 #include <type_traits>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 static_assert(-1 == ~0, "Not a twos-complement architecture");
 
 // Accounts for the case that all bits are zero.
@@ -87,10 +91,6 @@ int64_t signed_vint::deserialize(bytes_view v) {
     return decode_zigzag(un);
 }
 
-vint_size_type signed_vint::serialized_size_from_first_byte(bytes::value_type first_byte) {
-    return unsigned_vint::serialized_size_from_first_byte(first_byte);
-}
-
 // The number of additional bytes that we need to read.
 static vint_size_type count_extra_bytes(int8_t first_byte) {
     // Sign extension.
@@ -135,16 +135,11 @@ vint_size_type unsigned_vint::serialized_size(uint64_t value) noexcept {
     return vint_size_type(9) - vint_size_type((magnitude - 1) / 7);
 }
 
-uint64_t unsigned_vint::deserialize(bytes_view v) {
+uint64_t unsigned_vint::deserialize_multibyte(bytes_view v) {
     auto src = v.data();
     auto len = v.size();
     const int8_t first_byte = *src;
 
-    // No additional bytes, since the most significant bit is not set.
-    if (first_byte >= 0) {
-        return uint64_t(first_byte);
-    }
-
     const auto extra_bytes_size = count_extra_bytes(first_byte);
 
     // Extract the bits not used for counting bytes.
@@ -172,7 +167,69 @@ uint64_t unsigned_vint::deserialize(bytes_view v) {
     return result;
 }
 
-vint_size_type unsigned_vint::serialized_size_from_first_byte(bytes::value_type first_byte) {
-    int8_t first_byte_casted = first_byte;
-    return 1 + (first_byte_casted >= 0 ? 0 : count_extra_bytes(first_byte_casted));
+#if defined(__x86_64__)
+
+// Widens the 16 bytes of `chunk`, all below 0x80, to 64-bit values.
+static inline void widen_single_byte_values(__m128i chunk, uint64_t* out) noexcept {
+#if defined(__AVX2__)
+    auto dst = reinterpret_cast<__m256i*>(out);
+    _mm256_storeu_si256(dst + 0, _mm256_cvtepu8_epi64(chunk));
+    _mm256_storeu_si256(dst + 1, _mm256_cvtepu8_epi64(_mm_srli_si128(chunk, 4)));
+    _mm256_storeu_si256(dst + 2, _mm256_cvtepu8_epi64(_mm_srli_si128(chunk, 8)));
+    _mm256_storeu_si256(dst + 3, _mm256_cvtepu8_epi64(_mm_srli_si128(chunk, 12)));
+#else
+    const auto zero = _mm_setzero_si128();
+    auto dst = reinterpret_cast<__m128i*>(out);
+    const auto widen_words = [&] (__m128i words, __m128i* dst) {
+        const auto lo = _mm_unpacklo_epi16(words, zero);
+        const auto hi = _mm_unpackhi_epi16(words, zero);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi32(lo, zero));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi32(lo, zero));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi32(hi, zero));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi32(hi, zero));
+    };
+    widen_words(_mm_unpacklo_epi8(chunk, zero), dst);
+    widen_words(_mm_unpackhi_epi8(chunk, zero), dst + 4);
+#endif
+}
+
+#endif
+
+unsigned_vint::batch_result unsigned_vint::deserialize_batch(bytes_view v, uint64_t* out, size_t count) noexcept {
+    auto src = v.data();
+    const auto end = src + v.size();
+    size_t n = 0;
+
+    while (n < count && src != end) {
+#if defined(__x86_64__)
+        if (end - src >= 16) {
+            const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            // A set bit marks a byte which starts or continues a multi-byte vint.
+            const unsigned mask = _mm_movemask_epi8(chunk);
+            if (mask == 0 && count - n >= 16) {
+                widen_single_byte_values(chunk, out + n);
+                n += 16;
+                src += 16;
+                continue;
+            }
+            const auto singles = std::min(size_t(count_trailing_zeros(mask | 0x10000)), count - n);
+            for (size_t i = 0; i < singles; ++i) {
+                out[n + i] = uint8_t(src[i]);
+            }
+            n += singles;
+            src += singles;
+            if (n == count) {
+                break;
+            }
+        }
+#endif
+        const auto len = serialized_size_from_first_byte(*src);
+        if (size_t(end - src) < len) {
+            break;
+        }
+        out[n++] = deserialize(bytes_view(src, end - src));
+        src += len;
+    }
+
+    return batch_result{n, size_t(src - v.data())};
 }
@@ -40,9 +40,35 @@ struct unsigned_vint final {
 
     static vint_size_type serialize(value_type, bytes::iterator out);
 
-    static value_type deserialize(bytes_view v);
-
-    static vint_size_type serialized_size_from_first_byte(bytes::value_type first_byte);
+    // Most lengths and deltas stored in sstables fit in a single byte, so
+    // that case is decoded inline.
+    static value_type deserialize(bytes_view v) {
+        const int8_t first_byte = v[0];
+        if (__builtin_expect(first_byte >= 0, true)) {
+            return value_type(first_byte);
+        }
+        return deserialize_multibyte(v);
+    }
+
+    // The number of leading one bits of the first byte is the number of
+    // bytes following it.
+    static vint_size_type serialized_size_from_first_byte(bytes::value_type first_byte) noexcept {
+        // The bits below the first byte become ones and stop the count.
+        return 1 + __builtin_clz(~(uint32_t(uint8_t(first_byte)) << 24));
+    }
+
+    struct batch_result {
+        size_t values; // number of values decoded
+        size_t bytes; // number of bytes they took
+    };
+
+    // Decodes up to `count` consecutive vints from the front of `v` into
+    // `out`, stopping early at a vint that does not lie wholly within `v`.
+    // Runs of single-byte vints are found and widened 16 bytes at a time
+    // where SSE2/AVX2 is available.
+    static batch_result deserialize_batch(bytes_view v, value_type* out, size_t count) noexcept;
+private:
+    static value_type deserialize_multibyte(bytes_view v);
 };
 
 struct signed_vint final {
@@ -54,5 +80,7 @@ struct signed_vint final {
 
     static value_type deserialize(bytes_view v);
 
-    static vint_size_type serialized_size_from_first_byte(bytes::value_type first_byte);
+    static vint_size_type serialized_size_from_first_byte(bytes::value_type first_byte) noexcept {
+        return unsigned_vint::serialized_size_from_first_byte(first_byte);
+    }
 };
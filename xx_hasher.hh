@@ -30,6 +30,7 @@
 #pragma GCC diagnostic pop
 
 #include <array>
+#include <cstring>
 
 class xx_hasher {
     static constexpr size_t digest_size = 16;
@@ -67,3 +68,43 @@ class xx_hasher {
         serialize_int64(out, finalize_uint64());
     }
 };
+
+// Feeds the data to XXH64 in blocks, which is much cheaper than the many
+// tiny updates appending_hash makes for a row (every flag, timestamp and
+// length is a separate update). The digest is the same as the one of an
+// xx_hasher fed the same data.
+class buffered_xx_hasher {
+    static constexpr size_t buffer_size = 256;
+    xx_hasher _hasher;
+    size_t _size = 0;
+    std::array<char, buffer_size> _buffer;
+public:
+    explicit buffered_xx_hasher(uint64_t seed = 0) noexcept
+        : _hasher(seed) {
+    }
+
+    void update(const char* ptr, size_t length) {
+        if (_size + length > buffer_size) {
+            flush();
+            if (length > buffer_size) {
+                _hasher.update(ptr, length);
+                return;
+            }
+        }
+        std::memcpy(_buffer.data() + _size, ptr, length);
+        _size += length;
+    }
+
+    uint64_t finalize_uint64() {
+        flush();
+        return _hasher.finalize_uint64();
+    }
+
+private:
+    void flush() {
+        if (_size) {
+            _hasher.update(_buffer.data(), _size);
+            _size = 0;
+        }
+    }
+};
@@ -25,15 +25,43 @@
 // which are available only when the library is linked statically.
 #define ZSTD_STATIC_LINKING_ONLY
 #include "zstd/lib/zstd.h"
+#define ZDICT_STATIC_LINKING_ONLY
+#include "zstd/lib/dictBuilder/zdict.h"
 
 #include "compress.hh"
 #include "utils/class_registrator.hh"
 
 static const sstring COMPRESSION_LEVEL = "compression_level";
+// Size of the dictionary to train for each sstable. Dictionaries are
+// disabled if not set.
+static const sstring DICTIONARY_SIZE_KB = "dictionary_size_kb";
+// The trained dictionary. Only present in sstable compression metadata.
+static const sstring DICTIONARY = "dictionary";
 static const sstring COMPRESSOR_NAME = compressor::namespace_prefix + "ZstdCompressor";
 
+// Compression metadata options are limited to 64K.
+static constexpr int max_dictionary_size_kb = 63;
+// zstd recommends training on about 100 times the dictionary size, but
+// the samples are held in memory until training is done.
+static constexpr size_t dictionary_sample_ratio = 64;
+// Training runs on the reactor and isn't preemptible, and takes time
+// proportional to the size of the samples, so that size is bounded.
+static constexpr size_t max_dictionary_sample_size = 1 << 20;
+// log2 of the number of entries of the fastCover frequency tables. The default,
+// 20, is meant for samples of up to about 100M.
+static constexpr unsigned fastcover_f = 18;
+
+struct cdict_deleter {
+    void operator()(ZSTD_CDict* d) const { ZSTD_freeCDict(d); }
+};
+
+struct ddict_deleter {
+    void operator()(ZSTD_DDict* d) const { ZSTD_freeDDict(d); }
+};
+
 class zstd_processor : public compressor {
     int _compression_level = 3;
+    size_t _dictionary_size = 0;
 
     // Manages memory for the compression context.
     std::unique_ptr<char[], free_deleter> _cctx_raw;
@@ -44,6 +72,10 @@ class zstd_processor : public compressor {
     std::unique_ptr<char[], free_deleter> _dctx_raw;
     // Decompression context. Observer of _dctx_raw.
     ZSTD_DCtx* _dctx;
+
+    // Digested dictionary, if the sstable was compressed with one.
+    std::unique_ptr<ZSTD_CDict, cdict_deleter> _cdict;
+    std::unique_ptr<ZSTD_DDict, ddict_deleter> _ddict;
 public:
     zstd_processor(const opt_getter&);
 
@@ -55,6 +87,10 @@ class zstd_processor : public compressor {
 
     std::set<sstring> option_names() const override;
     std::map<sstring, sstring> options() const override;
+
+    size_t dictionary_sample_size() const override;
+    size_t dictionary_training_memory() const override;
+    std::map<sstring, sstring> train(const std::vector<temporary_buffer<char>>& samples) const override;
 };
 
 zstd_processor::zstd_processor(const opt_getter& opts)
@@ -76,6 +112,22 @@ zstd_processor::zstd_processor(const opt_getter& opts)
         }
     }
 
+    auto dictionary_size_kb = opts(DICTIONARY_SIZE_KB);
+    if (dictionary_size_kb) {
+        int size_kb;
+        try {
+            size_kb = std::stoi(*dictionary_size_kb);
+        } catch (const std::exception& e) {
+            throw exceptions::syntax_exception(
+                format("Invalid integer value {} for {}", *dictionary_size_kb, DICTIONARY_SIZE_KB));
+        }
+        if (size_kb < 0 || size_kb > max_dictionary_size_kb) {
+            throw exceptions::configuration_exception(
+                format("{} must be between 0 and {}, got {}", DICTIONARY_SIZE_KB, max_dictionary_size_kb, size_kb));
+        }
+        _dictionary_size = size_kb * 1024;
+    }
+
     auto chunk_len_kb = opts(compression_parameters::CHUNK_LENGTH_KB);
     if (!chunk_len_kb) {
         chunk_len_kb = opts(compression_parameters::CHUNK_LENGTH_KB_ERR);
@@ -85,8 +137,12 @@ zstd_processor::zstd_processor(const opt_getter& opts)
        ? std::stoi(*chunk_len_kb) * 1024
        : compression_parameters::DEFAULT_CHUNK_LENGTH;
 
+    auto dictionary = opts(DICTIONARY);
+
     // We assume that the uncompressed input length is always <= chunk_len.
-    auto cparams = ZSTD_getCParams(_compression_level, chunk_len, 0);
+    // The dictionary is digested with the same parameters, so that the
+    // compression context is large enough to use it.
+    auto cparams = ZSTD_getCParams(_compression_level, chunk_len, dictionary ? dictionary->size() : 0);
     auto cctx_size = ZSTD_estimateCCtxSize_usingCParams(cparams);
     // According to the ZSTD documentation, pointer to the context buffer must be 8-bytes aligned.
     _cctx_raw = allocate_aligned_buffer<char>(cctx_size, 8);
@@ -98,13 +154,24 @@ zstd_processor::zstd_processor(const opt_getter& opts)
     auto dctx_size = ZSTD_estimateDCtxSize();
     _dctx_raw = allocate_aligned_buffer<char>(dctx_size, 8);
     _dctx = ZSTD_initStaticDCtx(_dctx_raw.get(), dctx_size);
-    if (!_cctx) {
+    if (!_dctx) {
         throw std::runtime_error("Unable to initialize ZSTD decompression context");
     }
+
+    if (dictionary) {
+        _cdict.reset(ZSTD_createCDict_advanced(dictionary->data(), dictionary->size(),
+                ZSTD_dlm_byCopy, ZSTD_dct_auto, cparams, ZSTD_defaultCMem));
+        _ddict.reset(ZSTD_createDDict(dictionary->data(), dictionary->size()));
+        if (!_cdict || !_ddict) {
+            throw std::runtime_error("Unable to load ZSTD dictionary");
+        }
+    }
 }
 
 size_t zstd_processor::uncompress(const char* input, size_t input_len, char* output, size_t output_len) const {
-    auto ret = ZSTD_decompressDCtx(_dctx, output, output_len, input, input_len);
+    auto ret = _ddict
+            ? ZSTD_decompress_usingDDict(_dctx, output, output_len, input, input_len, _ddict.get())
+            : ZSTD_decompressDCtx(_dctx, output, output_len, input, input_len);
     if (ZSTD_isError(ret)) {
         throw std::runtime_error( format("ZSTD decompression failure: {}", ZSTD_getErrorName(ret)));
     }
@@ -113,7 +180,9 @@ size_t zstd_processor::uncompress(const char* input, size_t input_len, char* out
 
 
 size_t zstd_processor::compress(const char* input, size_t input_len, char* output, size_t output_len) const {
-    auto ret = ZSTD_compressCCtx(_cctx, output, output_len, input, input_len, _compression_level);
+    auto ret = _cdict
+            ? ZSTD_compress_usingCDict(_cctx, output, output_len, input, input_len, _cdict.get())
+            : ZSTD_compressCCtx(_cctx, output, output_len, input, input_len, _compression_level);
     if (ZSTD_isError(ret)) {
         throw std::runtime_error( format("ZSTD compression failure: {}", ZSTD_getErrorName(ret)));
     }
@@ -125,11 +194,56 @@ size_t zstd_processor::compress_max_size(size_t input_len) const {
 }
 
 std::set<sstring> zstd_processor::option_names() const {
-    return {COMPRESSION_LEVEL};
+    return {COMPRESSION_LEVEL, DICTIONARY_SIZE_KB};
 }
 
 std::map<sstring, sstring> zstd_processor::options() const {
-    return {{COMPRESSION_LEVEL, std::to_string(_compression_level)}};
+    std::map<sstring, sstring> opts{{COMPRESSION_LEVEL, std::to_string(_compression_level)}};
+    if (_dictionary_size) {
+        opts.emplace(DICTIONARY_SIZE_KB, std::to_string(_dictionary_size / 1024));
+    }
+    return opts;
+}
+
+size_t zstd_processor::dictionary_sample_size() const {
+    // A compressor which already has a dictionary is reading an sstable.
+    return _cdict ? 0 : std::min(_dictionary_size * dictionary_sample_ratio, max_dictionary_sample_size);
+}
+
+size_t zstd_processor::dictionary_training_memory() const {
+    // A copy of the samples, and the frequency tables of fastCover.
+    return dictionary_sample_size() + (size_t(1) << fastcover_f) * (sizeof(uint32_t) + sizeof(uint16_t));
+}
+
+std::map<sstring, sstring> zstd_processor::train(const std::vector<temporary_buffer<char>>& samples) const {
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    size_t total = 0;
+    for (auto& s : samples) {
+        sizes.push_back(s.size());
+        total += s.size();
+    }
+    auto buffer = std::make_unique<char[]>(total);
+    auto p = buffer.get();
+    for (auto& s : samples) {
+        p = std::copy_n(s.get(), s.size(), p);
+    }
+
+    // Fixed fastCover parameters rather than a parameter search, which
+    // would take too long as training is not preemptible.
+    ZDICT_fastCover_params_t params = {};
+    params.k = 200;
+    params.d = 8;
+    params.f = fastcover_f;
+    params.zParams.compressionLevel = _compression_level;
+    sstring dictionary(sstring::initialized_later(), _dictionary_size);
+    auto ret = ZDICT_trainFromBuffer_fastCover(dictionary.data(), dictionary.size(), buffer.get(),
+            sizes.data(), sizes.size(), params);
+    if (ZDICT_isError(ret)) {
+        return {};
+    }
+    dictionary.resize(ret);
+    return {{DICTIONARY, std::move(dictionary)}};
 }
 
 static const class_registrator<compressor_ptr, zstd_processor, const compressor::opt_getter&>